@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <dsp/types.h>
+#include <dsp/buffer/buffer.h>
+
+// Calls given to a benchmark before it is timed, so that the caches and the state of the block are warm
+#define BENCH_WARMUP_CALLS  3
+
+namespace bench {
+    struct Result {
+        std::string name;
+        double samplesPerSecond;
+
+        // Only for the decoders run over a recording, units being -1 otherwise
+        std::string unit;
+        int64_t units = -1;         // Decoded over one pass of the recording
+        double unitsPerSecond = 0.0;
+        double load = 0.0;          // Share of a core, helper threads included, to keep up with the recording
+        int64_t allocations = 0;    // Buffers allocated while decoding one pass
+    };
+
+    // Times the process() of blocks called directly on buffers in memory, without any stream or thread involved
+    class Bench {
+    public:
+        Bench(double minTime, const std::string& filter) {
+            this->minTime = minTime;
+            this->filter = filter;
+        }
+
+        // Compare the results against those of a previous run as they come
+        void setBaseline(const std::map<std::string, double>& baseline) {
+            this->baseline = baseline;
+        }
+
+        // Call process() until it has run for at least the minimum time, count being the samples it handles per call
+        template <class F>
+        void run(const std::string& name, int count, F process) {
+            if (!selected(name)) { return; }
+
+            for (int i = 0; i < BENCH_WARMUP_CALLS; i++) { process(); }
+
+            // Double the number of calls until the measure is long enough, the clock is only read between batches
+            int64_t calls = 1;
+            double elapsed = 0.0;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                for (int64_t i = 0; i < calls; i++) { process(); }
+                elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (elapsed >= minTime) { break; }
+                calls *= 2;
+            }
+
+            Result res;
+            res.name = name;
+            res.samplesPerSecond = (double)calls * (double)count / elapsed;
+            results.push_back(res);
+            print(res);
+        }
+
+        double getMinTime() { return minTime; }
+
+        // Whether a benchmark of the given name passes the filter
+        bool selected(const std::string& name) {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        // Add a result measured by the caller
+        void add(const Result& res) {
+            results.push_back(res);
+            print(res);
+        }
+
+        const std::vector<Result>& getResults() { return results; }
+
+        // Results slower than the baseline by more than the given fraction
+        std::vector<Result> regressions(double threshold) {
+            std::vector<Result> slower;
+            for (const auto& res : results) {
+                auto it = baseline.find(res.name);
+                if (it == baseline.end()) { continue; }
+                if (res.samplesPerSecond < it->second * (1.0 - threshold)) { slower.push_back(res); }
+            }
+            return slower;
+        }
+
+    private:
+        void print(const Result& res) {
+            auto it = baseline.find(res.name);
+            if (it == baseline.end()) {
+                printf("%-56s %10.2f MS/s\n", res.name.c_str(), res.samplesPerSecond / 1e6);
+            }
+            else {
+                double change = (res.samplesPerSecond / it->second - 1.0) * 100.0;
+                printf("%-56s %10.2f MS/s  (was %.2f, %+.1f%%)\n", res.name.c_str(), res.samplesPerSecond / 1e6, it->second / 1e6, change);
+            }
+            if (res.units >= 0) {
+                printf("    %lld %s (%.1f/s), %.3f%% of a core, %lld allocations\n", (long long)res.units, res.unit.c_str(),
+                       res.unitsPerSecond, 100.0 * res.load, (long long)res.allocations);
+            }
+            fflush(stdout);
+        }
+
+        double minTime;
+        std::string filter;
+        std::map<std::string, double> baseline;
+        std::vector<Result> results;
+    };
+
+    // Buffer of uniform noise between -1 and 1, which never lets the blocks take a shortcut on silence
+    template <class T>
+    T* noise(int count) {
+        T* buf = dsp::buffer::alloc<T>(count);
+        float* f = (float*)buf;
+        int len = (count * sizeof(T)) / sizeof(float);
+        for (int i = 0; i < len; i++) { f[i] = (2.0f * (float)rand() / (float)RAND_MAX) - 1.0f; }
+        return buf;
+    }
+
+    // Decoder from the output of its VFO to the decoded units, counted in units
+    class CorpusDecoder {
+    public:
+        virtual ~CorpusDecoder() {}
+        virtual void process(int count, dsp::complex_t* in) = 0;
+
+        // Called after the last buffer by the decoders running on their own threads
+        virtual void finish() {}
+
+        int64_t units = 0;
+    };
+
+    struct DecoderInfo {
+        const char* name;
+        const char* unit;
+        double samplerate;
+        double bandwidth;
+        CorpusDecoder* (*create)();
+    };
+
+    // Decoder of the given name with the samplerate and bandwidth of the VFO its module creates, NULL if unknown
+    const DecoderInfo* findDecoder(const std::string& name);
+
+    // Register the benchmarks of the block library
+    void filters(Bench& b, const std::vector<int>& sizes);
+    void multirate(Bench& b, const std::vector<int>& sizes);
+    void channel(Bench& b, const std::vector<int>& sizes);
+    void demod(Bench& b, const std::vector<int>& sizes);
+    void compression(Bench& b, const std::vector<int>& sizes);
+    void convert(Bench& b, const std::vector<int>& sizes);
+    void planar(Bench& b, const std::vector<int>& sizes);
+    void iir(Bench& b, const std::vector<int>& sizes);
+
+    // Buffers going through the double buffered stream and ring streams of a few depths between two threads, and
+    // through a chain of blocks with a thread each or on a dsp::Scheduler
+    void streams(Bench& b, const std::vector<int>& sizes);
+
+    // Compare the block parallel first order IIRs to sample by sample ones, returning the number that differ
+    int iirEquivalence();
+
+    // Benchmarks of whole decoders, with the share of a core each instance takes
+    void decoders(Bench& b, const std::vector<int>& sizes);
+
+    // Run the decoders over the recordings listed in a corpus file, the paths being relative to dir, or to the
+    // corpus file if empty. Returns the number of recordings that decoded fewer units than expected, -1 if the corpus
+    // couldn't be loaded
+    int corpus(Bench& b, const std::string& path, const std::string& dir);
+
+    // Run the IQ front end, its VFOs and the demodulators or decoders listed in a pipeline profile on a generated or
+    // recorded input, first as fast as it goes then paced at the samplerate of the profile. Returns -1 if the profile
+    // couldn't be loaded, 1 if the pipeline can't keep up with that samplerate
+    int pipeline(Bench& b, const std::string& path);
+}
@@ -0,0 +1,458 @@
+#include "bench.h"
+#include <math.h>
+#include <set>
+#include <dsp/filter/fir.h>
+#include <dsp/filter/decimating_fir.h>
+#include <dsp/multirate/power_decimator.h>
+#include <dsp/multirate/cic_decimator.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/channel/frequency_xlator.h>
+#include <dsp/correction/iq_correction.h>
+#include <dsp/correction/dc_blocker.h>
+#include <dsp/filter/deephasis.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/demod/fm.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/demod/psk.h>
+#include <dsp/demod/block_psk.h>
+#include <dsp/loop/agc.h>
+#include <dsp/loop/costas.h>
+#include <dsp/loop/block_costas.h>
+#include <dsp/clock_recovery/mm.h>
+#include <dsp/compression/sample_stream_compressor.h>
+#include <dsp/compression/sample_stream_decompressor.h>
+#include <dsp/convert/complex_to_real.h>
+#include <dsp/convert/real_to_complex.h>
+#include <dsp/convert/s16_to_complex.h>
+#include <dsp/planar/convert.h>
+#include <dsp/planar/rotator.h>
+#include <dsp/planar/fir.h>
+#include <dsp/planar/magnitude.h>
+#include <dsp/planar/quadrature.h>
+#include <dsp/taps/low_pass.h>
+#include <dsp/accelerate.h>
+#include <dsp/math/fast_log.h>
+
+namespace bench {
+    // Output buffers are allocated for the largest buffer size, resamplers never more than double the count
+    static int maxSize(const std::vector<int>& sizes) {
+        return *std::max_element(sizes.begin(), sizes.end());
+    }
+
+    static std::string sizeName(int size) {
+        return "/size=" + std::to_string(size);
+    }
+
+    // Taps of a low pass with exactly the given count, the values don't matter for the timing
+    static dsp::tap<float> firTaps(int count) {
+        dsp::tap<float> taps = dsp::taps::alloc<float>(count);
+        for (int i = 0; i < count; i++) { taps.taps[i] = 1.0f / (float)count; }
+        return taps;
+    }
+
+    void filters(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(max);
+        float* fin = noise<float>(max);
+        float* fout = dsp::buffer::alloc<float>(max);
+
+        for (int tapCount : { 15, 63, 255, 1023 }) {
+            dsp::tap<float> taps = firTaps(tapCount);
+            std::string t = "/taps=" + std::to_string(tapCount);
+            for (int size : sizes) {
+                dsp::filter::FIR<dsp::complex_t, float> cfir(NULL, taps);
+                b.run("fir/complex" + t + sizeName(size), size, [&]() { cfir.process(size, cin, cout); });
+
+                dsp::filter::FIR<float, float> ffir(NULL, taps);
+                b.run("fir/float" + t + sizeName(size), size, [&]() { ffir.process(size, fin, fout); });
+
+                for (int decim : { 4, 16 }) {
+                    dsp::filter::DecimatingFIR<dsp::complex_t, float> dfir(NULL, taps, decim);
+                    b.run("decimating_fir/complex/decim=" + std::to_string(decim) + t + sizeName(size), size, [&]() { dfir.process(size, cin, cout); });
+                }
+            }
+            dsp::taps::free(taps);
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+        dsp::buffer::free(fin);
+        dsp::buffer::free(fout);
+    }
+
+    void multirate(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(2 * max + 64);
+        dsp::complex_s16_t* sin = dsp::buffer::alloc<dsp::complex_s16_t>(max);
+        for (int i = 0; i < max; i++) { sin[i] = { (int16_t)(rand() % 65536 - 32768), (int16_t)(rand() % 65536 - 32768) }; }
+
+        for (int ratio : { 2, 8, 32, 128 }) {
+            std::string r = "/ratio=" + std::to_string(ratio);
+            for (int size : sizes) {
+                for (bool cic : { false, true }) {
+                    if (cic && ratio < 32) { continue; }
+                    std::string name = cic ? "power_decimator/cic" : "power_decimator/fir";
+                    dsp::multirate::PowerDecimator<dsp::complex_t> decim(NULL, ratio);
+                    decim.setCICAllowed(cic);
+                    b.run(name + r + sizeName(size), size, [&]() { decim.process(size, cin, cout); });
+                    b.run(name + "/s16" + r + sizeName(size), size, [&]() { decim.process(size, sin, cout, 32768.0f); });
+                }
+            }
+        }
+
+        // The distinct half-band stages of the power decimator, against the generic decimating filter with the same taps
+        std::vector<dsp::tap<float>> stages = dsp::multirate::decim::halfBandPlan(POWER_DECIMATOR_MAX_POWER, POWER_DECIMATOR_PASSBAND, POWER_DECIMATOR_ATTENUATION);
+        std::set<int> tapCounts;
+        for (auto& taps : stages) {
+            if (!tapCounts.insert(taps.size).second) { continue; }
+            std::string t = "/taps=" + std::to_string(taps.size);
+            for (int size : sizes) {
+                dsp::filter::HalfBandDecimator<dsp::complex_t> hb(NULL, taps);
+                b.run("half_band" + t + sizeName(size), size, [&]() { hb.process(size, cin, cout); });
+
+                dsp::filter::DecimatingFIR<dsp::complex_t, float> dfir(NULL, taps, 2);
+                b.run("decimating_fir/complex/decim=2" + t + sizeName(size), size, [&]() { dfir.process(size, cin, cout); });
+            }
+        }
+        for (auto& taps : stages) { dsp::taps::free(taps); }
+
+        for (int ratio : { 16, 64 }) {
+            for (int size : sizes) {
+                dsp::multirate::CICDecimator<dsp::complex_t> cic(NULL, ratio);
+                b.run("cic_decimator/ratio=" + std::to_string(ratio) + sizeName(size), size, [&]() { cic.process(size, cin, cout); });
+            }
+        }
+
+        // Rate changes found in the VFOs and the audio path
+        const std::pair<double, double> rates[] = {
+            { 48000.0, 44100.0 },
+            { 44100.0, 48000.0 },
+            { 250000.0, 48000.0 },
+            { 2400000.0, 200000.0 },
+            { 10000000.0, 12500.0 },
+            { 3200000.0, 48000.0 * M_PI }
+        };
+        for (const auto& [inRate, outRate] : rates) {
+            char r[64];
+            snprintf(r, sizeof(r), "/%.0f_to_%.0f", inRate, outRate);
+            for (int size : sizes) {
+                dsp::multirate::RationalResampler<dsp::complex_t> resamp(NULL, inRate, outRate);
+                b.run(std::string("rational_resampler") + r + sizeName(size), size, [&]() { resamp.process(size, cin, cout); });
+            }
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+        dsp::buffer::free(sin);
+    }
+
+    // Sample by sample versions of the first order IIRs, which the block parallel ones are checked and timed against
+    static void scalarDeemphasis(int count, const float* in, float* out, float alpha, float* state, int channels) {
+        for (int i = 0; i < count; i++) {
+            for (int c = 0; c < channels; c++) {
+                state[c] = (alpha * in[i * channels + c]) + ((1.0f - alpha) * state[c]);
+                out[i * channels + c] = state[c];
+            }
+        }
+    }
+
+    static void scalarDCBlocker(int count, const float* in, float* out, float rate, float* offset, int channels) {
+        for (int i = 0; i < count; i++) {
+            for (int c = 0; c < channels; c++) {
+                out[i * channels + c] = in[i * channels + c] - offset[c];
+                offset[c] += out[i * channels + c] * rate;
+            }
+        }
+    }
+
+    void iir(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::stereo_t* sin = noise<dsp::stereo_t>(max);
+        dsp::stereo_t* sout = dsp::buffer::alloc<dsp::stereo_t>(max);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(max);
+        float alpha = (1.0f / 48000.0f) / (50e-6f + (1.0f / 48000.0f));
+        float rate = 50.0f / 2400000.0f;
+
+        for (int size : sizes) {
+            dsp::filter::Deemphasis<dsp::stereo_t> deemp;
+            deemp.init(NULL, 50e-6, 48000.0);
+            b.run("deemphasis/stereo" + sizeName(size), size, [&]() { deemp.process(size, sin, sout); });
+
+            float state[2] = { 0.0f, 0.0f };
+            b.run("deemphasis/stereo/scalar" + sizeName(size), size, [&]() { scalarDeemphasis(size, (float*)sin, (float*)sout, alpha, state, 2); });
+
+            dsp::correction::DCBlocker<dsp::complex_t> dcBlock(NULL, rate);
+            b.run("dc_blocker/complex" + sizeName(size), size, [&]() { dcBlock.process(size, cin, cout); });
+
+            float offset[2] = { 0.0f, 0.0f };
+            b.run("dc_blocker/complex/scalar" + sizeName(size), size, [&]() { scalarDCBlocker(size, (float*)cin, (float*)cout, rate, offset, 2); });
+        }
+
+        dsp::buffer::free(sin);
+        dsp::buffer::free(sout);
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+    }
+
+    // Largest difference between the outputs of the block parallel IIRs and of the sample by sample ones, over
+    // buffers of every length up to a few groups so that all the remainders are gone through
+    template <class F, class R>
+    static double iirDifference(int channels, F blockParallel, R scalar) {
+        const int total = 1 << 16;
+        float* in = noise<float>(total * channels);
+        float* out = dsp::buffer::alloc<float>(total * channels);
+        float* ref = dsp::buffer::alloc<float>(total * channels);
+        for (int i = 0; i < total * channels; i++) { in[i] += 0.25f; }
+
+        scalar(total, in, ref);
+        for (int done = 0, len = 1; done < total; done += len, len = (len % 13) + 1) {
+            int count = std::min<int>(len, total - done);
+            blockParallel(count, &in[done * channels], &out[done * channels]);
+        }
+        double diff = 0.0;
+        for (int i = 0; i < total * channels; i++) { diff = std::max<double>(diff, fabs(out[i] - ref[i])); }
+
+        dsp::buffer::free(in);
+        dsp::buffer::free(out);
+        dsp::buffer::free(ref);
+        return diff;
+    }
+
+    int iirEquivalence() {
+        // Both only differ by the rounding of the sums, well under the resolution of the 16 bit samples they're fed
+        const double tolerance = 1e-5;
+        float alpha = (1.0f / 48000.0f) / (50e-6f + (1.0f / 48000.0f));
+        float rate = 50.0f / 2400000.0f;
+        int failures = 0;
+
+        auto check = [&](const char* name, double diff) {
+            printf("%-56s %10.2e max difference%s\n", name, diff, (diff > tolerance) ? ", MISMATCH" : "");
+            if (diff > tolerance) { failures++; }
+        };
+
+        dsp::filter::Deemphasis<float> deempMono;
+        deempMono.init(NULL, 50e-6, 48000.0);
+        float monoState = 0.0f;
+        check("equivalence/deemphasis/float", iirDifference(1,
+            [&](int n, float* in, float* out) { deempMono.process(n, in, out); },
+            [&](int n, float* in, float* out) { scalarDeemphasis(n, in, out, alpha, &monoState, 1); }));
+
+        dsp::filter::Deemphasis<dsp::stereo_t> deempStereo;
+        deempStereo.init(NULL, 50e-6, 48000.0);
+        float stereoState[2] = { 0.0f, 0.0f };
+        check("equivalence/deemphasis/stereo", iirDifference(2,
+            [&](int n, float* in, float* out) { deempStereo.process(n, (dsp::stereo_t*)in, (dsp::stereo_t*)out); },
+            [&](int n, float* in, float* out) { scalarDeemphasis(n, in, out, alpha, stereoState, 2); }));
+
+        dsp::correction::DCBlocker<float> dcMono(NULL, rate);
+        float monoOffset = 0.0f;
+        check("equivalence/dc_blocker/float", iirDifference(1,
+            [&](int n, float* in, float* out) { dcMono.process(n, in, out); },
+            [&](int n, float* in, float* out) { scalarDCBlocker(n, in, out, rate, &monoOffset, 1); }));
+
+        dsp::correction::DCBlocker<dsp::complex_t> dcComplex(NULL, rate);
+        float complexOffset[2] = { 0.0f, 0.0f };
+        check("equivalence/dc_blocker/complex", iirDifference(2,
+            [&](int n, float* in, float* out) { dcComplex.process(n, (dsp::complex_t*)in, (dsp::complex_t*)out); },
+            [&](int n, float* in, float* out) { scalarDCBlocker(n, in, out, rate, complexOffset, 2); }));
+
+        return failures;
+    }
+
+    void channel(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(max);
+
+        for (int size : sizes) {
+            dsp::channel::FrequencyXlator xlator(NULL, 123456.0, 2400000.0);
+            b.run("frequency_xlator" + sizeName(size), size, [&]() { xlator.process(size, cin, cout); });
+
+            dsp::correction::IQCorrection corr;
+            corr.configure(true, true, 50.0f / 2400000.0f);
+            b.run("iq_correction" + sizeName(size), size, [&]() { corr.process(size, cin, cout); });
+
+            dsp::loop::AGC<dsp::complex_t> agc(NULL, 1.0, 50.0 / 48000.0, 5.0 / 48000.0, 10e6, 10.0, INFINITY);
+            b.run("agc/complex" + sizeName(size), size, [&]() { agc.process(size, cin, cout); });
+
+            dsp::loop::AGC<dsp::complex_t> agcLook(NULL, 1.0, 50.0 / 48000.0, 5.0 / 48000.0, 10e6, 10.0, INFINITY, 240);
+            b.run("agc/complex/lookahead" + sizeName(size), size, [&]() { agcLook.process(size, cin, cout); });
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+    }
+
+    void demod(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* rds = dsp::buffer::alloc<dsp::complex_t>(max);
+        float* fin = noise<float>(max);
+        float* fout = dsp::buffer::alloc<float>(max);
+        dsp::stereo_t* sout = dsp::buffer::alloc<dsp::stereo_t>(max);
+
+        for (int size : sizes) {
+            dsp::demod::Quadrature quad(NULL, 75000.0, 250000.0);
+            b.run("quadrature" + sizeName(size), size, [&]() { quad.process(size, cin, fout); });
+
+            dsp::demod::FM<dsp::stereo_t> nfm;
+            nfm.init(NULL, 50000.0, 12500.0, true, true);
+            b.run("fm/nfm" + sizeName(size), size, [&]() { nfm.process(size, cin, sout); });
+
+            for (bool stereo : { false, true }) {
+                dsp::demod::BroadcastFM bfm(NULL, 75000.0, 250000.0, stereo, true, stereo);
+                int rdsCount;
+                b.run(std::string("broadcast_fm/") + (stereo ? "stereo_rds" : "mono") + sizeName(size), size, [&]() { bfm.process(size, cin, sout, rdsCount, rds); });
+            }
+
+            dsp::loop::Costas<4> costas(NULL, 0.001);
+            b.run("costas/order=4" + sizeName(size), size, [&]() { costas.process(size, cin, rds); });
+
+            for (int interval : { 8, 64 }) {
+                dsp::loop::BlockCostas<4> bcostas(NULL, 0.001, interval);
+                b.run("block_costas/order=4/interval=" + std::to_string(interval) + sizeName(size), size, [&]() { bcostas.process(size, cin, rds); });
+            }
+
+            // Clock recovery at 10 samples per symbol, 8 taps being the interpolator with a fast path
+            for (int interpTaps : { 8, 16 }) {
+                std::string t = "/interp_taps=" + std::to_string(interpTaps);
+                dsp::clock_recovery::MM<float> fmm(NULL, 10.0, 1e-6, 0.01, 0.01, 128, interpTaps);
+                b.run("mm/float" + t + sizeName(size), size, [&]() { fmm.process(size, fin, fout); });
+
+                dsp::clock_recovery::MM<dsp::complex_t> cmm(NULL, 10.0, 1e-6, 0.01, 0.01, 128, interpTaps);
+                b.run("mm/complex" + t + sizeName(size), size, [&]() { cmm.process(size, cin, rds); });
+            }
+
+            // Whole receivers at 4 samples per symbol, stage by stage over the block or chunk by chunk through all stages
+            dsp::demod::PSK<4> psk(NULL, 1e6, 4e6, 31, 0.6, 0.1, 0.005, 1e-6, 0.01);
+            b.run("psk/order=4" + sizeName(size), size, [&]() { psk.process(size, cin, rds); });
+
+            for (bool oqpsk : { false, true }) {
+                dsp::demod::BlockPSK<4> bpsk(NULL, 1e6, 4e6, 31, 0.6, 0.1, 0.005, 1e-6, 0.01, 0.01, oqpsk);
+                b.run(std::string("block_psk/") + (oqpsk ? "oqpsk" : "order=4") + sizeName(size), size, [&]() { bpsk.process(size, cin, rds); });
+            }
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(rds);
+        dsp::buffer::free(fin);
+        dsp::buffer::free(fout);
+        dsp::buffer::free(sout);
+    }
+
+    void compression(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(max);
+        uint8_t* packed = dsp::buffer::alloc<uint8_t>(max * sizeof(dsp::complex_t) + 1024);
+
+        const std::pair<dsp::compression::PCMType, const char*> types[] = {
+            { dsp::compression::PCM_TYPE_I8, "i8" },
+            { dsp::compression::PCM_TYPE_I16, "i16" },
+            { dsp::compression::PCM_TYPE_F32, "f32" },
+            { dsp::compression::PCM_TYPE_BFP8, "bfp8" }
+        };
+        for (const auto& [type, typeName] : types) {
+            for (int size : sizes) {
+                int bytes = 0;
+                b.run(std::string("compressor/") + typeName + sizeName(size), size, [&]() { bytes = dsp::compression::SampleStreamCompressor::process(size, type, cin, packed); });
+                bytes = dsp::compression::SampleStreamCompressor::process(size, type, cin, packed);
+                b.run(std::string("decompressor/") + typeName + sizeName(size), size, [&]() { dsp::compression::SampleStreamDecompressor::process(bytes, packed, cout); });
+            }
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+        dsp::buffer::free(packed);
+    }
+
+    void convert(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(max);
+        float* fin = noise<float>(max);
+        float* fout = dsp::buffer::alloc<float>(max);
+        int16_t* sin = dsp::buffer::alloc<int16_t>(2 * max);
+        for (int i = 0; i < 2 * max; i++) { sin[i] = (int16_t)(rand() % 65536 - 32768); }
+
+        for (int size : sizes) {
+            b.run("complex_to_real" + sizeName(size), size, [&]() { dsp::convert::ComplexToReal::process(size, cin, fout); });
+
+            dsp::convert::RealToComplex r2c(NULL);
+            b.run("real_to_complex" + sizeName(size), size, [&]() { r2c.process(size, fin, cout); });
+
+            b.run("s16_to_complex" + sizeName(size), size, [&]() { dsp::convert::S16ToComplex::process(size, sin, cout); });
+
+            // Conversion of the spectra to dB by the IQ front end
+            b.run("power_spectrum/exact" + sizeName(size), size, [&]() { dsp::accelerate::powerSpectrum(fout, cin, size, size); });
+            b.run("power_spectrum/fast" + sizeName(size), size, [&]() { dsp::math::fastPowerSpectrum(fout, cin, size, size); });
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+        dsp::buffer::free(fin);
+        dsp::buffer::free(fout);
+        dsp::buffer::free(sin);
+    }
+
+    void planar(Bench& b, const std::vector<int>& sizes) {
+        int max = maxSize(sizes);
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        dsp::complex_t* cout = dsp::buffer::alloc<dsp::complex_t>(max);
+        float* re = noise<float>(max);
+        float* im = noise<float>(max);
+        float* pre = dsp::buffer::alloc<float>(max);
+        float* pim = dsp::buffer::alloc<float>(max);
+        float* fout = dsp::buffer::alloc<float>(max);
+        dsp::tap<float> taps = firTaps(63);
+
+        // Each planar block next to the interleaved one it replaces, the chain showing what skipping the conversions in between saves
+        for (int size : sizes) {
+            b.run("planar/to_planar" + sizeName(size), size, [&]() { dsp::planar::ComplexToPlanar::process(size, cin, pre, pim); });
+            b.run("planar/to_complex" + sizeName(size), size, [&]() { dsp::planar::PlanarToComplex::process(size, re, im, cout); });
+
+            dsp::planar::Rotator rot(NULL, 123456.0, 2400000.0);
+            b.run("planar/rotator" + sizeName(size), size, [&]() { rot.process(size, re, im, pre, pim); });
+
+            dsp::planar::FIR fir(NULL, taps);
+            b.run("planar/fir/taps=63" + sizeName(size), size, [&]() { fir.process(size, re, im, pre, pim); });
+
+            b.run("planar/magnitude" + sizeName(size), size, [&]() { dsp::planar::Magnitude::process(size, re, im, fout); });
+            b.run("magnitude/complex" + sizeName(size), size, [&]() { volk_32fc_magnitude_32f(fout, (lv_32fc_t*)cin, size); });
+
+            dsp::planar::Quadrature quad(NULL, 75000.0, 250000.0);
+            b.run("planar/quadrature" + sizeName(size), size, [&]() { quad.process(size, re, im, fout); });
+
+            dsp::planar::Rotator crot(NULL, 123456.0, 2400000.0);
+            dsp::planar::FIR cfir(NULL, taps);
+            dsp::planar::Quadrature cquad(NULL, 75000.0, 250000.0);
+            b.run("planar/chain/xlate_fir_quadrature" + sizeName(size), size, [&]() {
+                dsp::planar::ComplexToPlanar::process(size, cin, pre, pim);
+                crot.process(size, pre, pim, pre, pim);
+                cfir.process(size, pre, pim, pre, pim);
+                cquad.process(size, pre, pim, fout);
+            });
+
+            dsp::channel::FrequencyXlator xlator(NULL, 123456.0, 2400000.0);
+            dsp::filter::FIR<dsp::complex_t, float> ifir(NULL, taps);
+            dsp::demod::Quadrature iquad(NULL, 75000.0, 250000.0);
+            b.run("interleaved/chain/xlate_fir_quadrature" + sizeName(size), size, [&]() {
+                xlator.process(size, cin, cout);
+                ifir.process(size, cout, cout);
+                iquad.process(size, cout, fout);
+            });
+        }
+
+        dsp::taps::free(taps);
+        dsp::buffer::free(cin);
+        dsp::buffer::free(cout);
+        dsp::buffer::free(re);
+        dsp::buffer::free(im);
+        dsp::buffer::free(pre);
+        dsp::buffer::free(pim);
+        dsp::buffer::free(fout);
+    }
+}
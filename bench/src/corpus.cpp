@@ -0,0 +1,335 @@
+#include "bench.h"
+#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <ctime>
+#include <json.hpp>
+#include <iq_reader.h>
+#include <dsp/channel/rx_vfo.h>
+#include <dsp/demod/fsk.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/digital/packed_bits.h>
+#include <dsp/taps/from_array.h>
+#include <dsp/sink/null_sink.h>
+#include <dsp/buffer/pool.h>
+#include <pocsag/pocsag.h>
+#include <flex/flex.h>
+#include <rds_demod.h>
+#include <rds.h>
+#include <meteor_demod.h>
+#include <ryfi/receiver.h>
+
+using nlohmann::json;
+
+// Samples handed to a decoder per call, about what its VFO outputs per buffer
+#define CORPUS_CHUNK_SIZE   16384
+
+namespace bench {
+    // Same DSP as the pager decoder module, without the energy detector so that the whole recording is decoded
+    class FSKCorpusDecoder : public CorpusDecoder {
+    public:
+        FSKCorpusDecoder(double baudrate) {
+            float shapeTaps[] = { 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f };
+            dsp::tap<float> shape = dsp::taps::fromArray<float>(10, shapeTaps);
+            fsk.init(NULL, baudrate, baudrate * 10.0, -4500.0, shape, 1e-4, 1.0, 0.05, true);
+            dsp::taps::free(shape);
+            soft = dsp::buffer::alloc<float>(CORPUS_CHUNK_SIZE);
+            bits = dsp::buffer::alloc<uint8_t>(CORPUS_CHUNK_SIZE);
+        }
+
+        ~FSKCorpusDecoder() {
+            dsp::buffer::free(soft);
+            dsp::buffer::free(bits);
+        }
+
+    protected:
+        dsp::demod::FSK fsk;
+        float* soft;
+        uint8_t* bits;
+    };
+
+    class POCSAGCorpusDecoder : public FSKCorpusDecoder {
+    public:
+        POCSAGCorpusDecoder() : FSKCorpusDecoder(2400.0) {
+            packer.init(NULL);
+            words = dsp::buffer::alloc<uint64_t>(packer.maxOutputCount(CORPUS_CHUNK_SIZE));
+            decoder.onMessage.bind([this](pocsag::Address addr, pocsag::MessageType type, const std::string& msg) { units++; });
+        }
+
+        ~POCSAGCorpusDecoder() {
+            dsp::buffer::free(words);
+        }
+
+        void process(int count, dsp::complex_t* in) {
+            int bitCount = fsk.process(count, in, soft, bits);
+            int wordCount = packer.process(bitCount, bits, words);
+            decoder.processPacked(words, wordCount);
+        }
+
+    private:
+        dsp::digital::BitPacker packer;
+        pocsag::Decoder decoder;
+        uint64_t* words;
+    };
+
+    class FLEXCorpusDecoder : public FSKCorpusDecoder {
+    public:
+        FLEXCorpusDecoder() : FSKCorpusDecoder(1600.0) {
+            decoder.onMessage.bind([this](flex::Address addr, flex::MessageType type, const std::string& msg) { units++; });
+        }
+
+        void process(int count, dsp::complex_t* in) {
+            int bitCount = fsk.process(count, in, soft, bits);
+            decoder.process(bits, bitCount);
+        }
+
+    private:
+        flex::Decoder decoder;
+    };
+
+    // Broadcast FM demodulator with its RDS output, as the WFM demodulator of the radio runs it
+    class RDSCorpusDecoder : public CorpusDecoder {
+    public:
+        RDSCorpusDecoder() {
+            fm.init(NULL, 75000.0, 250000.0, true, true, true);
+            rdsDemod.init(NULL, false);
+            audio = dsp::buffer::alloc<dsp::stereo_t>(CORPUS_CHUNK_SIZE);
+            rdsIn = dsp::buffer::alloc<dsp::complex_t>(CORPUS_CHUNK_SIZE);
+            rdsSoft = dsp::buffer::alloc<float>(CORPUS_CHUNK_SIZE);
+            rdsBits = dsp::buffer::alloc<uint8_t>(CORPUS_CHUNK_SIZE);
+        }
+
+        ~RDSCorpusDecoder() {
+            dsp::buffer::free(audio);
+            dsp::buffer::free(rdsIn);
+            dsp::buffer::free(rdsSoft);
+            dsp::buffer::free(rdsBits);
+        }
+
+        void process(int count, dsp::complex_t* in) {
+            int rdsCount = 0;
+            fm.process(count, in, audio, rdsCount, rdsIn);
+            int bitCount = rdsDemod.process(rdsCount, rdsIn, rdsSoft, rdsBits);
+            decoder.process(rdsBits, bitCount);
+            units = decoder.getGroupCount();
+        }
+
+    private:
+        dsp::demod::BroadcastFM fm;
+        RDSDemod rdsDemod;
+        rds::Decoder decoder;
+        dsp::stereo_t* audio;
+        dsp::complex_t* rdsIn;
+        float* rdsSoft;
+        uint8_t* rdsBits;
+    };
+
+    // The demodulator only, the symbols being what the module writes out
+    class MeteorCorpusDecoder : public CorpusDecoder {
+    public:
+        MeteorCorpusDecoder() {
+            demod.init(NULL, 72000.0, 150000.0, 33, 0.6, 0.1, 0.005, false, false, 1e-6, 0.01);
+            symbols = dsp::buffer::alloc<dsp::complex_t>(CORPUS_CHUNK_SIZE);
+        }
+
+        ~MeteorCorpusDecoder() {
+            dsp::buffer::free(symbols);
+        }
+
+        void process(int count, dsp::complex_t* in) {
+            units += demod.process(count, in, symbols);
+        }
+
+    private:
+        dsp::demod::Meteor demod;
+        dsp::complex_t* symbols;
+    };
+
+    // The receiver runs its blocks on their own threads, so it's fed through a stream. It's timed until the last
+    // buffer was taken in by the demodulator, the frames still in the later blocks at that point not being counted
+    class RyFiCorpusDecoder : public CorpusDecoder {
+    public:
+        RyFiCorpusDecoder() {
+            rx.init(&input, 500e3, 1000e3);
+            softSink.init(rx.softOut);
+            rx.onPacket.bind([this](ryfi::Packet pkt) { units++; });
+            softSink.start();
+            rx.start();
+        }
+
+        ~RyFiCorpusDecoder() {
+            rx.stop();
+            softSink.stop();
+        }
+
+        void process(int count, dsp::complex_t* in) {
+            memcpy(input.writeBuf, in, count * sizeof(dsp::complex_t));
+            input.swap(count);
+        }
+
+        void finish() {
+            while (!input.canWrite()) { std::this_thread::yield(); }
+        }
+
+    private:
+        dsp::stream<dsp::complex_t> input;
+        ryfi::Receiver rx;
+        dsp::sink::Null<dsp::complex_t> softSink;
+    };
+
+    // Samplerates and bandwidths of the VFOs the modules create
+    static const DecoderInfo DECODERS[] = {
+        { "pocsag", "messages", 24000.0, 12500.0, []() -> CorpusDecoder* { return new POCSAGCorpusDecoder(); } },
+        { "flex", "messages", 16000.0, 12500.0, []() -> CorpusDecoder* { return new FLEXCorpusDecoder(); } },
+        { "rds", "groups", 250000.0, 150000.0, []() -> CorpusDecoder* { return new RDSCorpusDecoder(); } },
+        { "meteor", "symbols", 150000.0, 150000.0, []() -> CorpusDecoder* { return new MeteorCorpusDecoder(); } },
+        { "ryfi", "packets", 1000e3, 600e3, []() -> CorpusDecoder* { return new RyFiCorpusDecoder(); } }
+    };
+
+    const DecoderInfo* findDecoder(const std::string& name) {
+        for (const auto& info : DECODERS) {
+            if (name == info.name) { return &info; }
+        }
+        return NULL;
+    }
+
+    static int64_t allocationCount() {
+        int64_t count = 0;
+        for (const auto& cls : dsp::buffer::pool::getStats()) { count += cls.hits + cls.misses; }
+        return count;
+    }
+
+    // CPU time of the process, all threads included
+    static double cpuTime() {
+        return (double)std::clock() / (double)CLOCKS_PER_SEC;
+    }
+
+    // Read the recording and bring the signal at the given offset to the samplerate of the decoder, as its VFO
+    // would. This isn't timed, only the decoder is
+    static std::vector<dsp::complex_t> loadRecording(const std::string& path, const json& entry, const DecoderInfo& info) {
+        SampleFormat rawFormat = SAMPLE_FORMAT_CI16;
+        if (entry.contains("format")) {
+            std::string name = entry["format"];
+            for (int i = 0; i < _SAMPLE_FORMAT_COUNT; i++) {
+                if (name == sampleFormatNames[i]) { rawFormat = (SampleFormat)i; }
+            }
+        }
+        double rawSamplerate = entry.value("samplerate", 0.0);
+        IQReader reader(path, rawFormat, rawSamplerate);
+        double samplerate = reader.getSampleRate();
+        if (samplerate <= 0.0) { throw std::runtime_error("Unknown samplerate"); }
+
+        int64_t frames = reader.getFrameCount();
+        if (entry.contains("duration")) {
+            frames = std::min<int64_t>(frames, (double)entry["duration"] * samplerate);
+        }
+
+        dsp::channel::RxVFO vfo(NULL, samplerate, info.samplerate, info.bandwidth, entry.value("offset", 0.0));
+        dsp::complex_t* raw = dsp::buffer::alloc<dsp::complex_t>(CORPUS_CHUNK_SIZE);
+        dsp::complex_t* out = dsp::buffer::alloc<dsp::complex_t>(vfo.outputBufferSize(CORPUS_CHUNK_SIZE));
+        std::vector<dsp::complex_t> samples;
+        samples.reserve((size_t)((double)frames * info.samplerate / samplerate) + CORPUS_CHUNK_SIZE);
+        for (int64_t i = 0; i < frames; i += CORPUS_CHUNK_SIZE) {
+            int n = std::min<int64_t>(frames - i, CORPUS_CHUNK_SIZE);
+            reader.convert(i, n, raw);
+            int outCount = vfo.process(n, raw, out);
+            samples.insert(samples.end(), out, out + outCount);
+        }
+        dsp::buffer::free(raw);
+        dsp::buffer::free(out);
+        return samples;
+    }
+
+    int corpus(Bench& b, const std::string& path, const std::string& dir) {
+        json data;
+        try {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                fprintf(stderr, "Could not open corpus '%s'\n", path.c_str());
+                return -1;
+            }
+            data = json::parse(file);
+        }
+        catch (const std::exception& e) {
+            fprintf(stderr, "Invalid corpus '%s': %s\n", path.c_str(), e.what());
+            return -1;
+        }
+        std::filesystem::path root = dir.empty() ? std::filesystem::path(path).parent_path() : std::filesystem::path(dir);
+
+        int failures = 0;
+        for (const auto& entry : data["recordings"]) {
+            std::string decoderName = entry["decoder"];
+            std::string fileName = entry["file"];
+            std::string name = "corpus/" + decoderName + "/" + entry.value("name", fileName);
+            if (!b.selected(name)) { continue; }
+
+            const DecoderInfo* info = findDecoder(decoderName);
+            if (!info) {
+                printf("%-56s unknown decoder '%s', skipped\n", name.c_str(), decoderName.c_str());
+                continue;
+            }
+
+            // Recordings missing from the corpus directory are skipped, the corpus being too large to ship
+            std::filesystem::path filePath = root / fileName;
+            if (!std::filesystem::exists(filePath)) {
+                printf("%-56s missing '%s', skipped\n", name.c_str(), filePath.string().c_str());
+                continue;
+            }
+
+            std::vector<dsp::complex_t> samples;
+            try {
+                samples = loadRecording(filePath.string(), entry, *info);
+            }
+            catch (const std::exception& e) {
+                printf("%-56s could not load '%s': %s, skipped\n", name.c_str(), filePath.string().c_str(), e.what());
+                continue;
+            }
+            if (samples.empty()) { continue; }
+
+            // Decode the whole recording with a new decoder each pass until the minimum time is reached, the units and
+            // allocations being those of the first pass, the later ones only averaging the time
+            int64_t units = 0;
+            int64_t allocations = 0;
+            int passes = 0;
+            double elapsed = 0.0;
+            double cpu = 0.0;
+            while (!passes || elapsed < b.getMinTime()) {
+                std::unique_ptr<CorpusDecoder> decoder(info->create());
+                int64_t allocStart = allocationCount();
+                double cpuStart = cpuTime();
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < samples.size(); i += CORPUS_CHUNK_SIZE) {
+                    int n = std::min<size_t>(samples.size() - i, CORPUS_CHUNK_SIZE);
+                    decoder->process(n, &samples[i]);
+                }
+                decoder->finish();
+                elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                cpu += cpuTime() - cpuStart;
+                if (!passes) {
+                    units = decoder->units;
+                    allocations = allocationCount() - allocStart;
+                }
+                passes++;
+            }
+
+            double duration = (double)samples.size() / info->samplerate;
+            Result res;
+            res.name = name;
+            res.samplesPerSecond = (double)passes * (double)samples.size() / elapsed;
+            res.unit = info->unit;
+            res.units = units;
+            res.unitsPerSecond = (double)passes * (double)units / elapsed;
+            res.load = cpu / ((double)passes * duration);
+            res.allocations = allocations;
+            b.add(res);
+
+            int64_t minUnits = entry.value("minUnits", (int64_t)0);
+            if (units < minUnits) {
+                printf("    expected at least %lld %s\n", (long long)minUnits, info->unit);
+                failures++;
+            }
+        }
+        return failures;
+    }
+}
@@ -0,0 +1,27 @@
+#include "bench.h"
+#include <vor_receiver.h>
+
+namespace bench {
+    // Prints the share of a core one instance needs at the samplerate it runs at, for the result just added
+    static void printLoad(Bench& b, size_t before, double sampleRate) {
+        if (b.getResults().size() == before) { return; }
+        printf("    %.3f%% of a core per instance at %.0f S/s\n", 100.0 * sampleRate / b.getResults().back().samplesPerSecond, sampleRate);
+    }
+
+    void decoders(Bench& b, const std::vector<int>& sizes) {
+        int max = *std::max_element(sizes.begin(), sizes.end());
+        dsp::complex_t* cin = noise<dsp::complex_t>(max);
+        float* fout = dsp::buffer::alloc<float>(max);
+
+        for (int size : sizes) {
+            // Whole receiver from the VFO output to the phase difference, as many run at once when tracking several VORs
+            vor::Receiver vor(NULL);
+            size_t before = b.getResults().size();
+            b.run("vor_receiver/size=" + std::to_string(size), size, [&]() { vor.process(cin, fout, size); });
+            printLoad(b, before, VOR_IN_SR);
+        }
+
+        dsp::buffer::free(cin);
+        dsp::buffer::free(fout);
+    }
+}
@@ -0,0 +1,172 @@
+#include "bench.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <string.h>
+#include <json.hpp>
+
+using nlohmann::json;
+
+// Minimum time each benchmark is run for, in seconds
+#define BENCH_DEFAULT_TIME  0.2
+
+static void usage(const char* name) {
+    printf("Usage: %s [options]\n", name);
+    printf("  --time <seconds>      Minimum run time of each benchmark (default %.1f)\n", BENCH_DEFAULT_TIME);
+    printf("  --sizes <a,b,...>     Buffer sizes in samples (default 256,4096,65536)\n");
+    printf("  --filter <text>       Only run the benchmarks whose name contains the text\n");
+    printf("  --json <file>         Save the results\n");
+    printf("  --baseline <file>     Compare to results saved with --json\n");
+    printf("  --threshold <percent> Slowdown against the baseline counted as a regression (default 5)\n");
+    printf("  --corpus <file>       Run the decoders over the recordings of a corpus instead of the block benchmarks\n");
+    printf("  --corpus-dir <dir>    Directory of the recordings (default: that of the corpus file)\n");
+    printf("  --pipeline <file>     Run the front end, VFOs and chains of a pipeline profile instead\n");
+}
+
+static std::vector<int> parseSizes(const std::string& str) {
+    std::vector<int> sizes;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int size = atoi(item.c_str());
+        if (size > 0) { sizes.push_back(size); }
+    }
+    return sizes;
+}
+
+int main(int argc, char* argv[]) {
+    double minTime = BENCH_DEFAULT_TIME;
+    std::vector<int> sizes = { 256, 4096, 65536 };
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 5.0;
+    std::string corpusPath;
+    std::string corpusDir;
+    std::string pipelinePath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--time" && hasValue) { minTime = atof(argv[++i]); }
+        else if (arg == "--sizes" && hasValue) { sizes = parseSizes(argv[++i]); }
+        else if (arg == "--filter" && hasValue) { filter = argv[++i]; }
+        else if (arg == "--json" && hasValue) { jsonPath = argv[++i]; }
+        else if (arg == "--baseline" && hasValue) { baselinePath = argv[++i]; }
+        else if (arg == "--threshold" && hasValue) { threshold = atof(argv[++i]); }
+        else if (arg == "--corpus" && hasValue) { corpusPath = argv[++i]; }
+        else if (arg == "--corpus-dir" && hasValue) { corpusDir = argv[++i]; }
+        else if (arg == "--pipeline" && hasValue) { pipelinePath = argv[++i]; }
+        else {
+            usage(argv[0]);
+            return (arg == "--help" || arg == "-h") ? 0 : -1;
+        }
+    }
+    if (sizes.empty() || minTime <= 0.0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    bench::Bench b(minTime, filter);
+
+    // Load the baseline
+    if (!baselinePath.empty()) {
+        std::ifstream file(baselinePath);
+        if (!file.is_open()) {
+            fprintf(stderr, "Could not open baseline '%s'\n", baselinePath.c_str());
+            return -1;
+        }
+        std::map<std::string, double> baseline;
+        try {
+            json data = json::parse(file);
+            for (const auto& res : data["results"]) {
+                baseline[res["name"]] = res["samplesPerSecond"];
+            }
+        }
+        catch (const std::exception& e) {
+            fprintf(stderr, "Invalid baseline '%s': %s\n", baselinePath.c_str(), e.what());
+            return -1;
+        }
+        b.setBaseline(baseline);
+    }
+
+    int corpusFailures = 0;
+    int mismatches = 0;
+    int pipelineBehind = 0;
+    if (!pipelinePath.empty()) {
+        pipelineBehind = bench::pipeline(b, pipelinePath);
+        if (pipelineBehind < 0) { return -1; }
+    }
+    else if (!corpusPath.empty()) {
+        corpusFailures = bench::corpus(b, corpusPath, corpusDir);
+        if (corpusFailures < 0) { return -1; }
+    }
+    else {
+        bench::filters(b, sizes);
+        bench::multirate(b, sizes);
+        bench::channel(b, sizes);
+        bench::demod(b, sizes);
+        bench::compression(b, sizes);
+        bench::convert(b, sizes);
+        bench::planar(b, sizes);
+        bench::iir(b, sizes);
+        bench::streams(b, sizes);
+        bench::decoders(b, sizes);
+        mismatches = bench::iirEquivalence();
+    }
+
+    // Save the results
+    if (!jsonPath.empty()) {
+        json data;
+        data["time"] = minTime;
+        data["threads"] = std::thread::hardware_concurrency();
+        data["results"] = json::array();
+        for (const auto& res : b.getResults()) {
+            json r = { { "name", res.name }, { "samplesPerSecond", res.samplesPerSecond } };
+            if (res.units >= 0) {
+                r["unit"] = res.unit;
+                r["units"] = res.units;
+                r["unitsPerSecond"] = res.unitsPerSecond;
+                r["load"] = res.load;
+                r["allocations"] = res.allocations;
+            }
+            data["results"].push_back(r);
+        }
+        std::ofstream file(jsonPath);
+        if (!file.is_open()) {
+            fprintf(stderr, "Could not write results to '%s'\n", jsonPath.c_str());
+            return -1;
+        }
+        file << data.dump(4);
+    }
+
+    // Report the regressions, the exit code tells scripts whether there were any
+    if (!baselinePath.empty()) {
+        auto slower = b.regressions(threshold / 100.0);
+        if (!slower.empty()) {
+            printf("\n%d benchmark(s) more than %.1f%% slower than the baseline:\n", (int)slower.size(), threshold);
+            for (const auto& res : slower) { printf("  %s\n", res.name.c_str()); }
+            return 1;
+        }
+    }
+
+    // Recordings that decoded less than expected are failures too
+    if (corpusFailures) {
+        printf("\n%d recording(s) decoded fewer units than expected\n", corpusFailures);
+        return 1;
+    }
+
+    // So is a pipeline that can't keep up with the samplerate of its profile
+    if (pipelineBehind) {
+        printf("\nThe pipeline can't sustain the samplerate of its profile\n");
+        return 1;
+    }
+
+    // So are optimized blocks that don't give the same output as the reference
+    if (mismatches) {
+        printf("\n%d block(s) differ from their reference\n", mismatches);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,526 @@
+#include "bench.h"
+#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <ctime>
+#include <json.hpp>
+#include <iq_reader.h>
+#include <signal_path/iq_frontend.h>
+#include <signal_path/spectrum_stats.h>
+#include <dsp/demod/fm.h>
+#include <dsp/demod/am.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/latency_probe.h>
+#include <dsp/profiler.h>
+#include <dsp/thread_role.h>
+
+using nlohmann::json;
+
+// Samples of generated noise looped as the input, large enough not to stay in cache
+#define PIPELINE_NOISE_SAMPLES      (1 << 22)
+
+// Most samples of a recording loaded in memory and looped as the input
+#define PIPELINE_MAX_RECORDING      (1 << 25)
+
+// Blocks handed to the front end per second of input, about what the sources do
+#define PIPELINE_BLOCKS_PER_SECOND  200
+
+// Samplerate the demodulators are resampled to, as the radio module does for the audio sinks
+#define PIPELINE_AUDIO_SAMPLERATE   48000.0
+
+// Fraction of the band the VFOs are spread over when the profile doesn't place them
+#define PIPELINE_VFO_SPAN           0.8
+
+namespace bench {
+    // Latencies of the buffers reaching the end of a chain, written by its sink and read once the phase is over
+    class LatencyLog {
+    public:
+        // Only keep buffers that entered the DSP from the given steady clock time on
+        void reset(double from) {
+            std::lock_guard<std::mutex> lck(mtx);
+            latencies.clear();
+            this->from = from;
+        }
+
+        void add(double arrival) {
+            if (arrival < from.load(std::memory_order_relaxed)) { return; }
+            double latency = dsp::steadyTime() - arrival;
+            std::lock_guard<std::mutex> lck(mtx);
+            latencies.push_back(latency);
+        }
+
+        std::vector<double> get() {
+            std::lock_guard<std::mutex> lck(mtx);
+            return latencies;
+        }
+
+    private:
+        std::mutex mtx;
+        std::vector<double> latencies;
+        std::atomic<double> from = 1e300;
+    };
+
+    // Last block of a chain, decoding the VFO output if given a decoder and logging the latency of each buffer
+    template <class T>
+    class LatencySink : public dsp::Sink<T> {
+        using base_type = dsp::Sink<T>;
+    public:
+        void init(dsp::stream<T>* in, LatencyLog* log, CorpusDecoder* decoder = NULL) {
+            _log = log;
+            _decoder = decoder;
+            base_type::init(in);
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            if constexpr (std::is_same_v<T, dsp::complex_t>) {
+                if (_decoder) { _decoder->process(count, base_type::_in->readBuf); }
+            }
+            _log->add(base_type::_in->readMeta.arrival);
+
+            base_type::_in->flush();
+            return count;
+        }
+
+    private:
+        LatencyLog* _log;
+        CorpusDecoder* _decoder;
+    };
+
+    // What comes after a VFO of the front end
+    class Chain {
+    public:
+        virtual ~Chain() {}
+        virtual void start() = 0;
+        virtual void stop() = 0;
+
+        // Units decoded, -1 for the demodulators
+        virtual int64_t units() { return -1; }
+
+        std::string type;
+        LatencyLog latency;
+    };
+
+    // Demodulator resampled to the rate of the audio sinks, as the radio module sets them up
+    template <class D>
+    class AudioChain : public Chain {
+    public:
+        // The demodulator must be initialized with the output of the VFO first
+        void init(const std::string& name, double samplerate) {
+            resamp.init(&demod.out, samplerate, PIPELINE_AUDIO_SAMPLERATE);
+            sink.init(&resamp.out, &latency);
+            demod.setProfileName("Demodulator " + name);
+            resamp.setProfileName("Resampler " + name);
+            sink.setProfileName("Sink " + name);
+            demod.setThreadRole(dsp::THREAD_ROLE_VFO);
+            resamp.setThreadRole(dsp::THREAD_ROLE_VFO);
+            sink.setThreadRole(dsp::THREAD_ROLE_VFO);
+        }
+
+        void start() {
+            demod.start();
+            resamp.start();
+            sink.start();
+        }
+
+        void stop() {
+            demod.stop();
+            resamp.stop();
+            sink.stop();
+        }
+
+        D demod;
+
+    private:
+        dsp::multirate::RationalResampler<dsp::stereo_t> resamp;
+        LatencySink<dsp::stereo_t> sink;
+    };
+
+    // One of the decoders of the corpus, run by the sink of the VFO
+    class DecoderChain : public Chain {
+    public:
+        DecoderChain(const std::string& name, dsp::stream<dsp::complex_t>* in, const DecoderInfo* info) {
+            decoder.reset(info->create());
+            sink.init(in, &latency, decoder.get());
+            sink.setProfileName("Decoder " + name);
+            sink.setThreadRole(dsp::THREAD_ROLE_VFO);
+        }
+
+        void start() { sink.start(); }
+
+        void stop() {
+            sink.stop();
+            decoder->finish();
+        }
+
+        int64_t units() { return decoder->units; }
+
+    private:
+        std::unique_ptr<CorpusDecoder> decoder;
+        LatencySink<dsp::complex_t> sink;
+    };
+
+    // Loops a buffer of samples into the front end, as fast as it takes them or at the samplerate
+    class Generator {
+    public:
+        Generator(const std::vector<dsp::complex_t>& samples, double samplerate) : samples(samples) {
+            _samplerate = samplerate;
+            blockSize = std::clamp<int>(samplerate / PIPELINE_BLOCKS_PER_SECOND, 1, STREAM_BUFFER_SIZE);
+        }
+
+        ~Generator() { stop(); }
+
+        void start(bool paced) {
+            sent = 0;
+            running = true;
+            workerThread = std::thread(&Generator::worker, this, paced);
+        }
+
+        // A blocked swap finishes once the front end takes the block
+        void stop() {
+            running = false;
+            if (workerThread.joinable()) { workerThread.join(); }
+        }
+
+        uint64_t getSent() { return sent; }
+
+        dsp::stream<dsp::complex_t> out;
+
+    private:
+        void worker(bool paced) {
+            dsp::applyThreadRole(dsp::THREAD_ROLE_SOURCE);
+            auto start = std::chrono::steady_clock::now();
+            uint64_t count = 0;
+            while (running) {
+                // A paced generator that fell behind catches up in a burst, like a source whose driver buffered
+                if (paced) {
+                    auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>((double)count / _samplerate));
+                    std::this_thread::sleep_until(due);
+                }
+
+                for (int i = 0; i < blockSize;) {
+                    int n = std::min<size_t>(blockSize - i, samples.size() - pos);
+                    memcpy(&out.writeBuf[i], &samples[pos], n * sizeof(dsp::complex_t));
+                    pos = (pos + n) % samples.size();
+                    i += n;
+                }
+                out.writeMeta.samplerate = _samplerate;
+                if (!out.swap(blockSize)) { break; }
+                count += blockSize;
+                sent = count;
+            }
+        }
+
+        const std::vector<dsp::complex_t>& samples;
+        double _samplerate;
+        int blockSize;
+        size_t pos = 0;
+        std::atomic<bool> running = false;
+        std::atomic<uint64_t> sent = 0;
+        std::thread workerThread;
+    };
+
+    struct DemodInfo {
+        const char* name;
+        double samplerate;
+        double bandwidth;
+    };
+
+    // IF samplerates and default bandwidths of the demodulators of the radio module
+    static const DemodInfo DEMODS[] = {
+        { "nfm", 50000.0, 12500.0 },
+        { "wfm", 250000.0, 150000.0 },
+        { "am", 15000.0, 10000.0 }
+    };
+
+    static const DemodInfo* findDemod(const std::string& name) {
+        for (const auto& info : DEMODS) {
+            if (name == info.name) { return &info; }
+        }
+        return NULL;
+    }
+
+    static Chain* createChain(const std::string& type, const std::string& name, dsp::channel::RxVFO* vfo, double samplerate, double bandwidth) {
+        if (type == "nfm") {
+            auto chain = new AudioChain<dsp::demod::FM<dsp::stereo_t>>;
+            chain->demod.init(&vfo->out, samplerate, bandwidth, true, false);
+            chain->init(name, samplerate);
+            return chain;
+        }
+        if (type == "wfm") {
+            auto chain = new AudioChain<dsp::demod::BroadcastFM>;
+            chain->demod.init(&vfo->out, bandwidth / 2.0, samplerate, true, true);
+            chain->init(name, samplerate);
+            return chain;
+        }
+        if (type == "am") {
+            auto chain = new AudioChain<dsp::demod::AM<dsp::stereo_t>>;
+            chain->demod.init(&vfo->out, dsp::demod::AM<dsp::stereo_t>::AGCMode::CARRIER, bandwidth, 50.0 / samplerate, 5.0 / samplerate, 100.0 / samplerate, samplerate);
+            chain->init(name, samplerate);
+            return chain;
+        }
+        return new DecoderChain(name, &vfo->out, findDecoder(type));
+    }
+
+    static std::vector<dsp::complex_t> loadInput(const std::string& path, const json& data, double& samplerate) {
+        SampleFormat rawFormat = SAMPLE_FORMAT_CI16;
+        if (data.contains("format")) {
+            std::string name = data["format"];
+            for (int i = 0; i < _SAMPLE_FORMAT_COUNT; i++) {
+                if (name == sampleFormatNames[i]) { rawFormat = (SampleFormat)i; }
+            }
+        }
+        IQReader reader(path, rawFormat, samplerate);
+        samplerate = reader.getSampleRate();
+        if (samplerate <= 0.0) { throw std::runtime_error("Unknown samplerate"); }
+
+        int64_t frames = std::min<int64_t>(reader.getFrameCount(), PIPELINE_MAX_RECORDING);
+        if (frames <= 0) { throw std::runtime_error("Empty recording"); }
+        std::vector<dsp::complex_t> samples(frames);
+        reader.convert(0, frames, samples.data());
+        return samples;
+    }
+
+    static double percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) { return 0.0; }
+        return sorted[(size_t)round(p * (double)(sorted.size() - 1))];
+    }
+
+    static float* acquireFFTBuffer(void* ctx) {
+        return ((std::vector<float>*)ctx)->data();
+    }
+
+    static void releaseFFTBuffer(void* ctx) {}
+
+    struct Phase {
+        double elapsed;
+        uint64_t samples;
+        double cpu;         // Cores used by the whole process
+        double roleCPU[dsp::_THREAD_ROLE_COUNT];
+        std::vector<dsp::profiler::Values> start;
+        std::vector<dsp::profiler::Values> end;
+    };
+
+    // Feed the front end for the given time, keeping the latencies of the buffers that entered it during that time
+    static Phase runPhase(Generator& gen, std::vector<std::unique_ptr<Chain>>& chains, double duration, bool paced) {
+        Phase phase;
+        double roleStart[dsp::_THREAD_ROLE_COUNT];
+        dsp::getThreadRoleCPUTimes(roleStart);
+        phase.start = dsp::profiler::getValues();
+        double cpuStart = (double)std::clock() / (double)CLOCKS_PER_SEC;
+        for (auto& chain : chains) { chain->latency.reset(dsp::steadyTime()); }
+
+        auto start = std::chrono::steady_clock::now();
+        gen.start(paced);
+        std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+        phase.samples = gen.getSent();
+        phase.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        gen.stop();
+
+        phase.cpu = ((double)std::clock() / (double)CLOCKS_PER_SEC - cpuStart) / phase.elapsed;
+        phase.end = dsp::profiler::getValues();
+        dsp::getThreadRoleCPUTimes(phase.roleCPU);
+        for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+            phase.roleCPU[i] = (phase.roleCPU[i] - roleStart[i]) / phase.elapsed;
+        }
+        return phase;
+    }
+
+    // Share of a core each profiled block was busy for, without its waits for input or for room in its outputs
+    static void printStages(const Phase& phase) {
+        std::map<std::string, const dsp::profiler::Values*> before;
+        for (const auto& v : phase.start) { before[v.name] = &v; }
+        for (const auto& v : phase.end) {
+            auto it = before.find(v.name);
+            uint64_t run = v.runTime, wait = v.readWait + v.swapWait;
+            if (it != before.end()) {
+                run -= it->second->runTime;
+                wait -= it->second->readWait + it->second->swapWait;
+            }
+            if (!run) { continue; }
+            double busy = (double)(run - std::min<uint64_t>(wait, run)) * 1e-9 / phase.elapsed;
+            printf("    %-52s %7.2f%% of a core\n", v.name.c_str(), 100.0 * busy);
+        }
+        for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+            if (phase.roleCPU[i] <= 0.0) { continue; }
+            printf("    %-52s %7.2f%% of a core\n", (std::string(dsp::threadRoleName((dsp::ThreadRole)i)) + " threads").c_str(), 100.0 * phase.roleCPU[i]);
+        }
+        printf("    %-52s %7.2f%% of a core\n", "Total", 100.0 * phase.cpu);
+    }
+
+    // Latency percentiles of each type of chain, from the sample entering the front end to it leaving the chain
+    static void printLatencies(std::vector<std::unique_ptr<Chain>>& chains) {
+        std::map<std::string, std::vector<double>> byType;
+        for (auto& chain : chains) {
+            auto lat = chain->latency.get();
+            auto& all = byType[chain->type];
+            all.insert(all.end(), lat.begin(), lat.end());
+        }
+        for (auto& [type, lat] : byType) {
+            std::sort(lat.begin(), lat.end());
+            if (lat.empty()) {
+                printf("    %-52s no buffer\n", type.c_str());
+                continue;
+            }
+            printf("    %-52s p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n", type.c_str(), percentile(lat, 0.5) * 1e3,
+                   percentile(lat, 0.9) * 1e3, percentile(lat, 0.99) * 1e3, lat.back() * 1e3);
+        }
+    }
+
+    int pipeline(Bench& b, const std::string& path) {
+        json data;
+        try {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                fprintf(stderr, "Could not open pipeline profile '%s'\n", path.c_str());
+                return -1;
+            }
+            data = json::parse(file);
+        }
+        catch (const std::exception& e) {
+            fprintf(stderr, "Invalid pipeline profile '%s': %s\n", path.c_str(), e.what());
+            return -1;
+        }
+
+        std::string name = "pipeline/" + data.value("name", std::filesystem::path(path).stem().string());
+        double samplerate = data.value("samplerate", 0.0);
+        int decimation = std::max<int>(data.value("decimation", 1), 1);
+        double duration = data.value("duration", 5.0);
+
+        // A recording sets the samplerate, otherwise noise keeps every block busy
+        std::vector<dsp::complex_t> samples;
+        if (data.contains("recording")) {
+            std::filesystem::path recPath = std::filesystem::path(path).parent_path() / data["recording"].get<std::string>();
+            try {
+                samples = loadInput(recPath.string(), data, samplerate);
+            }
+            catch (const std::exception& e) {
+                fprintf(stderr, "Could not load '%s': %s\n", recPath.string().c_str(), e.what());
+                return -1;
+            }
+        }
+        else {
+            dsp::complex_t* noise = bench::noise<dsp::complex_t>(PIPELINE_NOISE_SAMPLES);
+            samples.assign(noise, noise + PIPELINE_NOISE_SAMPLES);
+            dsp::buffer::free(noise);
+        }
+        if (samplerate <= 0.0) {
+            fprintf(stderr, "Pipeline profile '%s' has no samplerate\n", path.c_str());
+            return -1;
+        }
+
+        // List the chains before building anything so that a bad profile doesn't leave a half built pipeline
+        struct ChainEntry {
+            std::string type;
+            double samplerate;
+            double bandwidth;
+            bool placed;
+            double offset;
+        };
+        std::vector<ChainEntry> entries;
+        for (const auto& vfo : data["vfos"]) {
+            std::string type = vfo["type"];
+            const DemodInfo* demod = findDemod(type);
+            const DecoderInfo* decoder = findDecoder(type);
+            if (!demod && !decoder) {
+                fprintf(stderr, "Unknown chain type '%s'\n", type.c_str());
+                return -1;
+            }
+            double sr = demod ? demod->samplerate : decoder->samplerate;
+            double bw = vfo.value("bandwidth", demod ? demod->bandwidth : decoder->bandwidth);
+            int count = vfo.value("count", 1);
+            for (int i = 0; i < count; i++) {
+                // Placed VFOs are spaced by their bandwidth from the given offset
+                bool placed = vfo.contains("offset");
+                double offset = placed ? (double)vfo["offset"] + i * bw : 0.0;
+                entries.push_back({ type, sr, bw, placed, offset });
+            }
+        }
+
+        IQFrontEnd::FFTWindow window = IQFrontEnd::FFTWindow::NUTTALL;
+        std::string windowName = data.value("fftWindow", "nuttall");
+        if (windowName == "rectangular") { window = IQFrontEnd::FFTWindow::RECTANGULAR; }
+        else if (windowName == "blackman") { window = IQFrontEnd::FFTWindow::BLACKMAN; }
+        int fftSize = data.value("fftSize", 65536);
+        std::vector<float> fftBuf(fftSize);
+
+        bool profiling = dsp::profiler::isEnabled();
+        dsp::profiler::setEnabled(true);
+
+        Generator gen(samples, samplerate);
+        SpectrumStats stats;
+        IQFrontEnd frontEnd;
+        frontEnd.setSecondary(&stats);
+        frontEnd.init(&gen.out, samplerate, data.value("buffering", true), decimation, data.value("dcBlocking", false), fftSize,
+                      data.value("fftRate", 20.0), window, acquireFFTBuffer, releaseFFTBuffer, &fftBuf);
+        frontEnd.setFFTEnabled(data.value("fft", true));
+        frontEnd.setDecimationThreads(data.value("decimationThreads", 1));
+        frontEnd.setChannelizer(data.value("channelizer", 0));
+        frontEnd.setVFOGrouping(data.value("vfoGrouping", false));
+        frontEnd.setAutoDecimation(data.value("autoDecimation", false));
+
+        // VFOs that weren't placed are spread evenly over the band
+        double bandwidth = samplerate / decimation;
+        double span = bandwidth * PIPELINE_VFO_SPAN;
+        std::vector<std::unique_ptr<Chain>> chains;
+        std::vector<std::string> vfoNames;
+        for (int i = 0; i < entries.size(); i++) {
+            const auto& e = entries[i];
+            std::string vfoName = e.type + std::to_string(i);
+            double offset = e.placed ? e.offset : (-span / 2.0) + (span * (i + 0.5) / entries.size());
+            dsp::channel::RxVFO* vfo = frontEnd.addVFO(vfoName, e.samplerate, e.bandwidth, offset);
+            Chain* chain = createChain(e.type, vfoName, vfo, e.samplerate, e.bandwidth);
+            chain->type = e.type;
+            chain->start();
+            chains.emplace_back(chain);
+            vfoNames.push_back(vfoName);
+        }
+
+        printf("%s: %.2f MS/s / %d, %d chain(s)\n", name.c_str(), samplerate / 1e6, decimation, (int)chains.size());
+        frontEnd.start();
+
+        // As fast as the pipeline goes, without the input buffer so that the generator is held back instead of blocks
+        // being dropped. This is the highest input rate the pipeline sustains
+        frontEnd.setBuffering(false);
+        Phase fast = runPhase(gen, chains, duration, false);
+        double maxRate = (double)fast.samples / fast.elapsed;
+        printf("  Unpaced: %.2f MS/s sustained, %.2fx realtime\n", maxRate / 1e6, maxRate / samplerate);
+        printStages(fast);
+        printLatencies(chains);
+
+        // Paced at the samplerate with the buffering of the profile, the latencies being those the user would see
+        frontEnd.setBuffering(data.value("buffering", true));
+        uint64_t overflowStart = frontEnd.getInputBufferStats().overflows;
+        Phase paced = runPhase(gen, chains, duration, true);
+        uint64_t overflows = frontEnd.getInputBufferStats().overflows - overflowStart;
+        printf("  Paced at %.2f MS/s: %.2f MS/s fed, %llu block(s) dropped by the input buffer\n", samplerate / 1e6,
+               (double)paced.samples / paced.elapsed / 1e6, (unsigned long long)overflows);
+        printStages(paced);
+        printLatencies(chains);
+
+        for (auto& chain : chains) {
+            if (chain->units() >= 0) { printf("    %s decoded %lld unit(s)\n", chain->type.c_str(), (long long)chain->units()); }
+        }
+
+        gen.out.stopWriter();
+        frontEnd.stop();
+        for (auto& chain : chains) { chain->stop(); }
+        for (const auto& vfoName : vfoNames) { frontEnd.removeVFO(vfoName); }
+        chains.clear();
+        dsp::profiler::setEnabled(profiling);
+
+        Result res;
+        res.name = name;
+        res.samplesPerSecond = maxRate;
+        b.add(res);
+
+        return (maxRate < samplerate) ? 1 : 0;
+    }
+}
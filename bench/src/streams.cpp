@@ -0,0 +1,88 @@
+#include "bench.h"
+#include <thread>
+#include <atomic>
+#include <dsp/stream.h>
+#include <dsp/ring_stream.h>
+#include <dsp/scheduler.h>
+#include <dsp/channel/frequency_xlator.h>
+
+// Blocks in the chain run with a thread each or on a scheduler
+#define BENCH_SCHEDULER_CHAIN_LENGTH    8
+
+namespace bench {
+    // Buffers handed from a writer thread, that touches every sample, to what the timed read goes through
+    template <class S, class F>
+    static void transfer(Bench& b, const std::string& name, S& stream, int size, F read) {
+        std::thread writer([&]() {
+            float level = 0.0f;
+            while (true) {
+                for (int i = 0; i < size; i++) { stream.writeBuf[i] = { level, -level }; }
+                level += 1.0f;
+                if (!stream.swap(size)) { break; }
+            }
+        });
+
+        b.run(name, size, read);
+
+        stream.stopWriter();
+        writer.join();
+        stream.clearWriteStop();
+    }
+
+    // Read straight from the stream, touching every sample too
+    template <class S>
+    static void consume(Bench& b, const std::string& name, S& stream, int size) {
+        if (!b.selected(name)) { return; }
+        volatile float sum = 0.0f;
+        transfer(b, name, stream, size, [&]() {
+            int count = stream.read();
+            float acc = 0.0f;
+            for (int i = 0; i < count; i++) { acc += stream.readBuf[i].re; }
+            sum = sum + acc;
+            stream.flush();
+        });
+    }
+
+    // The same chain of blocks with a thread each, then on scheduler pools of a few sizes
+    static void scheduled(Bench& b, int size, int threads) {
+        std::string name = "scheduler/" + (threads ? "pool=" + std::to_string(threads) : std::string("threads")) +
+                           "/blocks=" + std::to_string(BENCH_SCHEDULER_CHAIN_LENGTH) + "/size=" + std::to_string(size);
+        if (!b.selected(name)) { return; }
+
+        dsp::stream<dsp::complex_t> input(size);
+        std::vector<dsp::channel::FrequencyXlator*> blocks;
+        for (int i = 0; i < BENCH_SCHEDULER_CHAIN_LENGTH; i++) {
+            blocks.push_back(new dsp::channel::FrequencyXlator(i ? &blocks.back()->out : &input, 1000.0 * (i + 1), 2400000.0));
+        }
+        dsp::Scheduler* sched = threads ? new dsp::Scheduler(threads) : NULL;
+        for (auto& blk : blocks) {
+            blk->setScheduler(sched);
+            blk->start();
+        }
+
+        dsp::stream<dsp::complex_t>& out = blocks.back()->out;
+        transfer(b, name, input, size, [&]() {
+            out.read();
+            out.flush();
+        });
+
+        for (auto& blk : blocks) { blk->stop(); }
+        for (auto& blk : blocks) { delete blk; }
+        delete sched;
+    }
+
+    void streams(Bench& b, const std::vector<int>& sizes) {
+        for (int size : sizes) {
+            dsp::stream<dsp::complex_t> dbl(size);
+            consume(b, "stream/double/size=" + std::to_string(size), dbl, size);
+
+            // The ring lets the writer fill the next buffers while the reader is still on the previous one
+            for (int depth : { 2, 4, 8 }) {
+                dsp::ring_stream<dsp::complex_t> ring(depth, size);
+                consume(b, "stream/ring/depth=" + std::to_string(depth) + "/size=" + std::to_string(size), ring, size);
+            }
+
+            for (int threads : { 0, 1, 2, 4 }) { scheduled(b, size, threads); }
+        }
+    }
+}
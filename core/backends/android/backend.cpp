@@ -15,6 +15,10 @@
 #include <gui/style.h>
 #include <gui/menus/theme.h>
 #include <filesystem>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 
 // Credit to the ImGui android OpenGL3 example for a lot of this code!
 
@@ -28,6 +32,7 @@ namespace backend {
     bool initialized = false;
     bool pauseRendering = false;
     bool exited = false;
+    std::atomic<int> maxFPS = 60;
 
     // Forward declaration
     int ShowSoftKeyboardInput();
@@ -36,7 +41,7 @@ namespace backend {
     void doPartialInit() {
         std::string root = (std::string)core::args["root"];
         backend::init();
-        style::loadFonts(root + "/res"); // TODO: Don't hardcode, use config
+        style::loadFonts(root + "/res", root); // TODO: Don't hardcode, use config
         icons::load(root + "/res");
         thememenu::applyTheme();
         ImGui::GetStyle().ScaleAllSizes(style::uiScale);
@@ -172,7 +177,19 @@ namespace backend {
     void getMouseScreenPos(double& x, double& y) { x = 0; y = 0; }
     void setMouseScreenPos(double x, double y) {}
 
+    void* getProcAddress(const char* name) {
+        return (void*)eglGetProcAddress(name);
+    }
+
+    // Android draws continuously while the app is shown, only the frame rate cap applies
+    void requestRedraw() {}
+
+    void setMaxFPS(int fps) {
+        maxFPS = std::max<int>(fps, 0);
+    }
+
     int renderLoop() {
+        auto lastFrame = std::chrono::steady_clock::now();
         while (true) {
             int out_events;
             struct android_poll_source* out_data;
@@ -209,6 +226,14 @@ namespace backend {
                 ShowSoftKeyboardInput();
                 WantTextInputLast = io.WantTextInput;
 
+                // Keep to the frame rate cap
+                int fps = maxFPS.load();
+                if (fps > 0) {
+                    auto nextFrame = lastFrame + std::chrono::microseconds(1000000 / fps);
+                    std::this_thread::sleep_until(nextFrame);
+                }
+                lastFrame = std::chrono::steady_clock::now();
+
                 // Render
                 beginFrame();
                 
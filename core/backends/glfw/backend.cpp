@@ -11,6 +11,15 @@
 #include <stb_image.h>
 #include <stb_image_resize.h>
 #include <gui/gui.h>
+#include <atomic>
+#include <algorithm>
+
+// Frame rates used when nothing asked for a redraw, and when the window is minimized or hidden
+#define RENDER_IDLE_FPS     4
+#define RENDER_HIDDEN_FPS   1
+
+// Time during which frames keep being drawn following an input, ImGui needs a few to settle hovering and animations
+#define RENDER_ACTIVE_TIME  0.5
 
 namespace backend {
     const char* OPENGL_VERSIONS_GLSL[] = {
@@ -49,10 +58,62 @@ namespace backend {
     GLFWwindow* window;
     GLFWmonitor* monitor;
 
+    std::atomic<bool> glfwReady = false;
+    std::atomic<bool> redrawRequested = true;
+    std::atomic<int> maxFPS = 60;
+    double lastActivity = 0.0;
+    GLFWcursorposfun prevCursorPosCallback = NULL;
+    GLFWmousebuttonfun prevMouseButtonCallback = NULL;
+    GLFWscrollfun prevScrollCallback = NULL;
+    GLFWkeyfun prevKeyCallback = NULL;
+    GLFWcharfun prevCharCallback = NULL;
+    GLFWwindowfocusfun prevWindowFocusCallback = NULL;
+    GLFWcursorenterfun prevCursorEnterCallback = NULL;
+
     static void glfw_error_callback(int error, const char* description) {
         flog::error("Glfw Error {0}: {1}", error, description);
     }
 
+    // Input callbacks, chained to the ones installed by ImGui, that mark the UI as active
+    static void cursor_pos_callback(GLFWwindow* window, double x, double y) {
+        lastActivity = glfwGetTime();
+        if (prevCursorPosCallback) { prevCursorPosCallback(window, x, y); }
+    }
+
+    static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+        lastActivity = glfwGetTime();
+        if (prevMouseButtonCallback) { prevMouseButtonCallback(window, button, action, mods); }
+    }
+
+    static void scroll_callback(GLFWwindow* window, double x, double y) {
+        lastActivity = glfwGetTime();
+        if (prevScrollCallback) { prevScrollCallback(window, x, y); }
+    }
+
+    static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+        lastActivity = glfwGetTime();
+        if (prevKeyCallback) { prevKeyCallback(window, key, scancode, action, mods); }
+    }
+
+    static void char_callback(GLFWwindow* window, unsigned int c) {
+        lastActivity = glfwGetTime();
+        if (prevCharCallback) { prevCharCallback(window, c); }
+    }
+
+    static void window_focus_callback(GLFWwindow* window, int focused) {
+        lastActivity = glfwGetTime();
+        if (prevWindowFocusCallback) { prevWindowFocusCallback(window, focused); }
+    }
+
+    static void cursor_enter_callback(GLFWwindow* window, int entered) {
+        lastActivity = glfwGetTime();
+        if (prevCursorEnterCallback) { prevCursorEnterCallback(window, entered); }
+    }
+
+    static void window_refresh_callback(GLFWwindow* window) {
+        redrawRequested = true;
+    }
+
     static void maximized_callback(GLFWwindow* window, int n) {
         if (n == GLFW_TRUE) {
             maximized = true;
@@ -177,6 +238,17 @@ namespace backend {
         // Setup Platform/Renderer bindings
         ImGui_ImplGlfw_InitForOpenGL(window, true);
 
+        // Track input to know when to redraw
+        prevCursorPosCallback = glfwSetCursorPosCallback(window, cursor_pos_callback);
+        prevMouseButtonCallback = glfwSetMouseButtonCallback(window, mouse_button_callback);
+        prevScrollCallback = glfwSetScrollCallback(window, scroll_callback);
+        prevKeyCallback = glfwSetKeyCallback(window, key_callback);
+        prevCharCallback = glfwSetCharCallback(window, char_callback);
+        prevWindowFocusCallback = glfwSetWindowFocusCallback(window, window_focus_callback);
+        prevCursorEnterCallback = glfwSetCursorEnterCallback(window, cursor_enter_callback);
+        glfwSetWindowRefreshCallback(window, window_refresh_callback);
+        glfwReady = true;
+
         if (!ImGui_ImplOpenGL3_Init(glsl_version)) {
             // If init fail, try to fall back on GLSL 1.2
             flog::warn("Could not init using OpenGL with normal GLSL version, falling back to GLSL 1.2");
@@ -232,9 +304,52 @@ namespace backend {
         ImGui_ImplGlfw_CursorPosCallback(window, x, y);
     }
 
+    void* getProcAddress(const char* name) {
+        return (void*)glfwGetProcAddress(name);
+    }
+
+    // Block until the next frame is due. Frames are drawn right after input or redraw requests, as fast as the cap
+    // allows, and at a low rate otherwise
+    void waitForFrame(double lastFrame) {
+        while (!glfwWindowShouldClose(window)) {
+            double now = glfwGetTime();
+            bool hidden = glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE);
+            int fps = maxFPS.load();
+            double minInterval = (fps > 0) ? 1.0 / (double)fps : 0.0;
+            double interval;
+            if (hidden) {
+                interval = std::max<double>(minInterval, 1.0 / RENDER_HIDDEN_FPS);
+            }
+            else if (redrawRequested.load() || now - lastActivity < RENDER_ACTIVE_TIME) {
+                interval = minInterval;
+            }
+            else {
+                interval = std::max<double>(minInterval, 1.0 / RENDER_IDLE_FPS);
+            }
+
+            double wait = lastFrame + interval - now;
+            if (wait <= 0.0) { return; }
+            glfwWaitEventsTimeout(wait);
+        }
+    }
+
+    void requestRedraw() {
+        if (redrawRequested.exchange(true) || !glfwReady) { return; }
+        glfwPostEmptyEvent();
+    }
+
+    void setMaxFPS(int fps) {
+        maxFPS = std::max<int>(fps, 0);
+        if (glfwReady) { glfwPostEmptyEvent(); }
+    }
+
     int renderLoop() {
         // Main loop
+        double lastFrame = 0.0;
         while (!glfwWindowShouldClose(window)) {
+            waitForFrame(lastFrame);
+            lastFrame = glfwGetTime();
+            redrawRequested = false;
             glfwPollEvents();
 
             beginFrame();
@@ -296,6 +411,7 @@ namespace backend {
 
     int end() {
         // Cleanup
+        glfwReady = false;
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
@@ -7,6 +7,14 @@ namespace backend {
     void render(bool vsync = true);
     void getMouseScreenPos(double& x, double& y);
     void setMouseScreenPos(double x, double y);
+    void* getProcAddress(const char* name);
     int renderLoop();
+
+    // Redraw the UI as soon as the frame rate cap allows, can be called from any thread. Without input or redraw
+    // requests, the UI is only redrawn at a low idle rate
+    void requestRedraw();
+
+    // Maximum number of frames per second, 0 for no limit other than vsync
+    void setMaxFPS(int fps);
     int end();
 }
\ No newline at end of file
@@ -14,11 +14,24 @@ void CommandArgsParser::defineAll() {
 #endif
 
         define('a', "addr", "Server mode address", "0.0.0.0");
+        define('\0', "clients", "Maximum number of clients in server mode", 8);
         define('h', "help", "Show help");
         define('p', "port", "Server mode port", 5259);
         define('r', "root", "Root directory, where all config files are stored", std::filesystem::absolute(root).string());
         define('s', "server", "Run in server mode");
+        define('\0', "headless", "Run all modules and the signal path without a window, see --http-port");
+        define('\0', "http-addr", "Headless mode HTTP control address", "127.0.0.1");
+        define('\0', "http-port", "Headless mode HTTP control port, 0 to disable it", 0);
+        define('\0', "metrics-addr", "Address the metrics are served on", "127.0.0.1");
+        define('\0', "metrics-port", "Port serving the Prometheus metrics at /metrics, 0 to disable it", 0);
         define('\0', "autostart", "Automatically start the SDR after loading");
+        define('\0', "offline", "Offline batch mode, play files as fast as possible and send audio to no sink");
+        define('\0', "trace", "Record a trace of the DSP from startup and save it to this file, see --trace-duration", "");
+        define('\0', "trace-duration", "Seconds after startup at which the trace is saved", 10);
+        define('\0', "log-file", "Also write the log to this file, rotated once it reaches --log-file-size", "");
+        define('\0', "log-file-size", "Size in MB at which the log file is rotated, the last 3 being kept", 10);
+        define('\0', "buffer-alloc", "Allocator of the DSP buffers: system, pool, or hugepages for a pool in 2MB huge pages", "system");
+        define('\0', "sync-log", "Write log messages from the thread logging them instead of a logger thread");
 }
 
 int CommandArgsParser::parse(int argc, char* argv[]) {
@@ -41,15 +41,32 @@ void ConfigManager::load(json def, bool lock) {
         conf = def;
         save(false);
     }
+    fullSnapshot = true;
     if (lock) { mtx.unlock(); }
 }
 
 void ConfigManager::save(bool lock) {
-    if (lock) { mtx.lock(); }
-    std::ofstream file(path.c_str());
-    file << conf.dump(4);
-    file.close();
-    if (lock) { mtx.unlock(); }
+    // Explicit saves copy the whole config, the caller may have modified it without releasing it as modified
+    if (lock) {
+        std::lock_guard<std::mutex> slck(saveMtx);
+        mtx.lock();
+        fullSnapshot = true;
+        updateSnapshot();
+        mtx.unlock();
+        writeFile(snapshot.dump(4));
+        return;
+    }
+
+    // The caller already holds the config, so a save in progress can't be waited for without inverting the lock
+    // order. The save is then left to the saver coming next, or to the autosave
+    if (!saveMtx.try_lock()) {
+        markChanged("");
+        return;
+    }
+    fullSnapshot = true;
+    updateSnapshot();
+    writeFile(snapshot.dump(4));
+    saveMtx.unlock();
 }
 
 void ConfigManager::enableAutoSave() {
@@ -75,27 +92,81 @@ void ConfigManager::acquire() {
 }
 
 void ConfigManager::release(bool modified) {
-    changed |= modified;
+    if (modified) { markChanged(""); }
     mtx.unlock();
 }
 
-void ConfigManager::autoSaveWorker() {
-    while (autoSaveEnabled) {
-        if (!mtx.try_lock()) {
-            flog::warn("ConfigManager locked, waiting...");
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            continue;
-        }
-        if (changed) {
-            changed = false;
-            save(false);
+void ConfigManager::release(bool modified, const std::string& section) {
+    if (modified) { markChanged(section); }
+    mtx.unlock();
+}
+
+void ConfigManager::markChanged(const std::string& section) {
+    auto now = std::chrono::steady_clock::now();
+    if (!changed) { firstChange = now; }
+    lastChange = now;
+    changed = true;
+    if (section.empty()) {
+        fullSnapshot = true;
+    }
+    else if (!fullSnapshot) {
+        dirtySections.insert(section);
+    }
+}
+
+void ConfigManager::updateSnapshot() {
+    if (fullSnapshot) {
+        snapshot = conf;
+    }
+    else {
+        for (const auto& section : dirtySections) {
+            if (conf.contains(section)) {
+                snapshot[section] = conf[section];
+            }
+            else {
+                snapshot.erase(section);
+            }
         }
-        mtx.unlock();
+    }
+    dirtySections.clear();
+    fullSnapshot = false;
+    changed = false;
+}
 
+void ConfigManager::writeFile(const std::string& data) {
+    // Write to a temporary file renamed over the config, so that a crash can't leave it truncated
+    std::string tmpPath = path + ".tmp";
+    std::ofstream file(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+    file << data;
+    file.close();
+    if (file.fail()) {
+        flog::error("Could not write config file '{0}'", tmpPath);
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) { flog::error("Could not replace config file '{0}': {1}", path, ec.message()); }
+}
+
+void ConfigManager::autoSaveWorker() {
+    while (true) {
         // Sleep but listen for wakeup call
+        bool terminate;
         {
             std::unique_lock<std::mutex> lock(termMtx);
-            termCond.wait_for(lock, std::chrono::milliseconds(1000), [this]() { return termFlag; });
+            termCond.wait_for(lock, std::chrono::milliseconds(CONFIG_SAVE_POLL), [this]() { return termFlag; });
+            terminate = termFlag;
         }
+
+        // Save once the changes have settled, and whatever is left when terminating
+        std::lock_guard<std::mutex> slck(saveMtx);
+        mtx.lock();
+        auto now = std::chrono::steady_clock::now();
+        bool due = changed && (terminate || now - lastChange >= std::chrono::milliseconds(CONFIG_SAVE_DEBOUNCE) ||
+                               now - firstChange >= std::chrono::milliseconds(CONFIG_SAVE_MAX_DELAY));
+        if (due) { updateSnapshot(); }
+        mtx.unlock();
+        if (due) { writeFile(snapshot.dump(4)); }
+        if (terminate) { break; }
     }
-}
\ No newline at end of file
+}
@@ -2,9 +2,17 @@
 #include <json.hpp>
 #include <thread>
 #include <string>
+#include <set>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
 
+// The config is saved once it hasn't changed for CONFIG_SAVE_DEBOUNCE, or at the latest CONFIG_SAVE_MAX_DELAY after
+// the first unsaved change, in milliseconds
+#define CONFIG_SAVE_DEBOUNCE    1000
+#define CONFIG_SAVE_MAX_DELAY   5000
+#define CONFIG_SAVE_POLL        200
+
 using nlohmann::json;
 
 class ConfigManager {
@@ -19,18 +27,35 @@ public:
     void acquire();
     void release(bool modified = false);
 
+    // Release after modifying only the given top-level key, only that section is then copied when saving
+    void release(bool modified, const std::string& section);
+
     json conf;
 
 private:
     void autoSaveWorker();
+    void markChanged(const std::string& section);
+    void updateSnapshot();
+    void writeFile(const std::string& data);
 
     std::string path = "";
-    volatile bool changed = false;
+    bool changed = false;
     volatile bool autoSaveEnabled = false;
     std::thread autoSaveThread;
     std::mutex mtx;
 
+    // Sections changed since the last save, all of them if fullSnapshot is set. Protected by mtx
+    std::set<std::string> dirtySections;
+    bool fullSnapshot = true;
+    std::chrono::steady_clock::time_point firstChange;
+    std::chrono::steady_clock::time_point lastChange;
+
+    // Copy of the config the file is written from, so that the serialization and write happen outside of mtx.
+    // Protected by saveMtx, which is always locked before mtx
+    json snapshot;
+    std::mutex saveMtx;
+
     std::mutex termMtx;
     std::condition_variable termCond;
     volatile bool termFlag = false;
-};
\ No newline at end of file
+};
@@ -1,4 +1,7 @@
 #include <server.h>
+#include <headless.h>
+#include <metrics.h>
+#include <session_snapshot.h>
 #include "imgui.h"
 #include <stdio.h>
 #include <gui/main_window.h>
@@ -19,6 +22,14 @@
 #include <stb_image_resize.h>
 #include <gui/gui.h>
 #include <signal_path/signal_path.h>
+#include <dsp/fft/plan.h>
+#include <dsp/profiler.h>
+#include <dsp/buffer/pool.h>
+#include <dsp/volk_profile.h>
+#include <dsp/kernels/kernels.h>
+#include <dsp/thread_role.h>
+#include <utils/power.h>
+#include <utils/startup_timer.h>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -39,6 +50,9 @@ namespace core {
     CommandArgsParser args;
 
     void setInputSampleRate(double samplerate) {
+        // Sources driven by another source report their samplerate to it instead
+        if (sigpath::sourceManager.captureSampleRate(samplerate)) { return; }
+
         // Forward this to the server
         if (args["server"].b()) { server::setInputSampleRate(samplerate); return; }
         
@@ -78,10 +92,40 @@ int sdrpp_main(int argc, char* argv[]) {
     }
 
     bool serverMode = (bool)core::args["server"];
+    bool headlessMode = (bool)core::args["headless"];
+
+    // Select the allocator of the DSP buffers before the signal path allocates most of them
+    dsp::buffer::pool::Mode poolMode;
+    if (dsp::buffer::pool::parseMode(((std::string)core::args["buffer-alloc"]).c_str(), poolMode)) {
+        dsp::buffer::pool::setMode(poolMode);
+    }
+    else {
+        flog::error("Unknown buffer allocator '{0}', using the system one", (std::string)core::args["buffer-alloc"]);
+    }
+
+    // Move the log output off the DSP and driver threads
+    if (!core::args["sync-log"].b()) { flog::setAsync(true); }
+    std::string logPath = (std::string)core::args["log-file"];
+    if (!logPath.empty()) {
+        size_t logSize = (size_t)std::max<int>((int)core::args["log-file-size"], 1) * 1000000;
+        if (!flog::setLogFile(logPath, logSize, 3)) { flog::error("Could not open log file {0}", logPath); }
+    }
+
+    // Trace the DSP from startup if requested, the trace is saved from a thread of its own so that it also works in server mode
+    std::string tracePath = (std::string)core::args["trace"];
+    if (!tracePath.empty()) {
+        int traceDuration = std::max<int>((int)core::args["trace-duration"], 1);
+        dsp::profiler::setTracing(true);
+        std::thread([tracePath, traceDuration]() {
+            std::this_thread::sleep_for(std::chrono::seconds(traceDuration));
+            dsp::profiler::saveTrace(tracePath);
+            dsp::profiler::setTracing(false);
+        }).detach();
+    }
 
 #ifdef _WIN32
-    // Free console if the user hasn't asked for a console and not in server mode
-    if (!core::args["con"].b() && !serverMode) { FreeConsole(); }
+    // Free console if the user hasn't asked for a console and not in server or headless mode
+    if (!core::args["con"].b() && !serverMode && !headlessMode) { FreeConsole(); }
 
     // Set error mode to avoid abnoxious popups
     SetErrorMode(SEM_NOOPENFILEERRORBOX | SEM_NOGPFAULTERRORBOX | SEM_FAILCRITICALERRORS);
@@ -103,6 +147,10 @@ int sdrpp_main(int argc, char* argv[]) {
         return -1;
     }
 
+    // Point VOLK to its profile before any kernel is dispatched
+    dsp::volk_profile::init(root);
+    flog::info("Using the {} DSP kernels", dsp::kernels::get().isa);
+
     // ======== DEFAULT CONFIG ========
     json defConfig;
     defConfig["bandColors"]["amateur"] = "#FF0000FF";
@@ -124,8 +172,16 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["fastFFT"] = false;
     defConfig["fftHeight"] = 300;
     defConfig["fftRate"] = 20;
+    defConfig["maxFPS"] = 60;
     defConfig["fftSize"] = 65536;
     defConfig["fftWindow"] = 2;
+    defConfig["fftZoomMode"] = 0;
+    defConfig["fftLineIntegration"] = 0;
+    defConfig["fftAveraging"] = false;
+    defConfig["fftOverlap"] = 50;
+    defConfig["fftFastLog"] = false;
+    defConfig["fftVisibleOnly"] = false;
+    defConfig["gpuFFT"] = false;
     defConfig["frequency"] = 100000000.0;
     defConfig["fullWaterfallUpdate"] = false;
     defConfig["max"] = 0.0;
@@ -247,8 +303,14 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["showWaterfall"] = true;
     defConfig["source"] = "";
     defConfig["decimation"] = 1;
+    defConfig["decimationThreads"] = 1;
+    defConfig["autoDecimation"] = false;
+    defConfig["vfoGrouping"] = false;
+    defConfig["vfoScheduler"] = false;
+    defConfig["asyncTuning"] = true;
     defConfig["iqCorrection"] = false;
     defConfig["invertIQ"] = false;
+    defConfig["channelizerChannels"] = 0;
 
     defConfig["streams"]["Radio"]["muted"] = false;
     defConfig["streams"]["Radio"]["sink"] = "Audio";
@@ -259,8 +321,29 @@ int sdrpp_main(int argc, char* argv[]) {
 
     defConfig["vfoOffsets"] = json::object();
 
+    defConfig["signalPaths"] = json::array();
+
     defConfig["vfoColors"]["Radio"] = "#FFFFFF";
 
+    defConfig["vfoSpectrumSize"] = 4096;
+
+    defConfig["sweepStart"] = 88000000.0;
+    defConfig["sweepStop"] = 108000000.0;
+    defConfig["sweepFFTSize"] = 4096;
+    defConfig["sweepSettleTime"] = 2.0;
+
+    // Scheduling policy of each kind of thread: priority (low, normal, high or realtime), CPUs and NUMA node
+    const char* defaultPriorities[dsp::_THREAD_ROLE_COUNT] = { "high", "high", "normal", "high", "normal", "low" };
+    for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+        json& role = defConfig["threadRoles"][dsp::threadRoleName((dsp::ThreadRole)i)];
+        role["priority"] = defaultPriorities[i];
+        role["cpus"] = json::array();
+        role["numaNode"] = -1;
+    }
+
+    // Thread placement and reductions on battery, see power::setProfile()
+    defConfig["powerProfile"] = "default";
+
 #ifdef __ANDROID__
     defConfig["lockMenuOrder"] = true;
 #else
@@ -282,6 +365,7 @@ int sdrpp_main(int argc, char* argv[]) {
 #endif
 
     // Load config
+    startup_timer::begin("Loading config");
     flog::info("Loading config");
     core::configManager.setPath(root + "/config.json");
     core::configManager.load(defConfig);
@@ -350,12 +434,45 @@ int sdrpp_main(int argc, char* argv[]) {
         core::configManager.conf["moduleInstances"][_name] = newMod;
     }
 
+    // Load the thread policies, before any DSP thread is started
+    for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+        dsp::ThreadRole role = (dsp::ThreadRole)i;
+        std::string name = dsp::threadRoleName(role);
+        if (!core::configManager.conf["threadRoles"].contains(name)) {
+            core::configManager.conf["threadRoles"][name] = defConfig["threadRoles"][name];
+        }
+        json& conf = core::configManager.conf["threadRoles"][name];
+        dsp::ThreadPolicy policy;
+        std::string prio = conf.value("priority", std::string("normal"));
+        if (prio == "low") { policy.priority = dsp::THREAD_PRIO_LOW; }
+        else if (prio == "high") { policy.priority = dsp::THREAD_PRIO_HIGH; }
+        else if (prio == "realtime") { policy.priority = dsp::THREAD_PRIO_REALTIME; }
+        if (conf.contains("cpus") && conf["cpus"].is_array()) {
+            for (auto& cpu : conf["cpus"]) {
+                if (cpu.is_number_integer()) { policy.cpus.push_back(cpu); }
+            }
+        }
+        policy.numaNode = conf.value("numaNode", -1);
+        dsp::setThreadPolicy(role, policy);
+    }
+    std::string powerProfile = core::configManager.conf["powerProfile"];
+    power::setProfile((powerProfile == power::profileName(power::PROFILE_POWER_AWARE)) ? power::PROFILE_POWER_AWARE : power::PROFILE_DEFAULT);
+
     // Load UI scaling
     style::uiScale = core::configManager.conf["uiScale"];
 
     core::configManager.release(true);
 
+    // Load the FFT plans measured by previous runs, and what the last clean shutdown saved of its session
+    dsp::fft::loadWisdom(root + "/fftw_wisdom.dat");
+    session_snapshot::restore(root + "/session.snapshot");
+
+    // Metrics are served in every mode
+    int metricsPort = (int)core::args["metrics-port"];
+    if (metricsPort > 0) { metrics::start((std::string)core::args["metrics-addr"], metricsPort); }
+
     if (serverMode) { return server::main(); }
+    if (headlessMode) { return headless::main(); }
 
     core::configManager.acquire();
     std::string resDir = core::configManager.conf["resourcesDirectory"];
@@ -370,30 +487,35 @@ int sdrpp_main(int argc, char* argv[]) {
     }
 
     // Initialize backend
+    startup_timer::begin("Initializing backend");
     int biRes = backend::init(resDir);
     if (biRes < 0) { return biRes; }
 
     // Initialize SmGui in normal mode
     SmGui::init(false);
 
-    if (!style::loadFonts(resDir)) { return -1; }
+    startup_timer::begin("Loading fonts");
+    if (!style::loadFonts(resDir, root)) { return -1; }
     thememenu::init(resDir);
     LoadingScreen::init();
 
     LoadingScreen::show("Loading icons");
+    startup_timer::begin("Loading icons");
     flog::info("Loading icons");
     if (!icons::load(resDir)) { return -1; }
 
-    LoadingScreen::show("Loading band plans");
+    // The band plans are parsed while the modules load, the band plan menu waiting for them
     flog::info("Loading band plans");
-    bandplan::loadFromDir(resDir + "/bandplans");
+    bandplan::loadFromDirAsync(resDir + "/bandplans");
 
     LoadingScreen::show("Loading band plan colors");
+    startup_timer::begin("Loading band plan colors");
     flog::info("Loading band plans color table");
     bandplan::loadColorTable(bandColors);
 
     gui::mainWindow.init();
 
+    startup_timer::finish();
     flog::info("Ready.");
 
     // Run render loop (TODO: CHECK RETURN VALUE)
@@ -401,6 +523,11 @@ int sdrpp_main(int argc, char* argv[]) {
 
     // On android, none of this shutdown should happen due to the way the UI works
 #ifndef __ANDROID__
+    metrics::stop();
+    sigpath::sweeper.stop();
+    sigpath::sourceManager.setAsyncTuning(false);
+    session_snapshot::save(root + "/session.snapshot");
+
     // Shut down all modules
     for (auto& [name, mod] : core::moduleManager.modules) {
         mod.end();
@@ -409,12 +536,16 @@ int sdrpp_main(int argc, char* argv[]) {
     // Terminate backend (TODO: CHECK RETURN VALUE)
     backend::end();
 
+    sigpath::destroyPaths();
     sigpath::iqFrontEnd.stop();
+    dsp::fft::stopWisdom();
+    dsp::volk_profile::stop();
 
     core::configManager.disableAutoSave();
     core::configManager.save();
 #endif
 
     flog::info("Exiting successfully");
+    flog::setAsync(false);
     return 0;
 }
@@ -0,0 +1,55 @@
+#pragma once
+#include <volk/volk.h>
+#include "types.h"
+
+#ifdef SDRPP_USE_ACCELERATE
+#include <Accelerate/Accelerate.h>
+#endif
+
+// Kernels that Apple's Accelerate framework runs faster than VOLK on Apple Silicon. When built with OPT_USE_ACCELERATE
+// they use vDSP, otherwise they are the VOLK kernels they replace. The interleaved complex buffers are given to vDSP
+// as split complex ones with a stride of two, which avoids converting them
+namespace dsp::accelerate {
+    inline void dotProd(float* out, const float* in, const float* taps, int count) {
+#ifdef SDRPP_USE_ACCELERATE
+        vDSP_dotpr(in, 1, taps, 1, out, count);
+#else
+        volk_32f_x2_dot_prod_32f(out, in, taps, count);
+#endif
+    }
+
+    // Complex samples with real taps, also used for stereo samples
+    inline void dotProd(complex_t* out, const complex_t* in, const float* taps, int count) {
+#ifdef SDRPP_USE_ACCELERATE
+        DSPSplitComplex a = { (float*)&in->re, (float*)&in->im };
+        DSPSplitComplex c = { &out->re, &out->im };
+        vDSP_zrdotpr(&a, 2, taps, 1, &c, count);
+#else
+        volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)out, (const lv_32fc_t*)in, taps, count);
+#endif
+    }
+
+    inline void dotProd(complex_t* out, const complex_t* in, const complex_t* taps, int count) {
+#ifdef SDRPP_USE_ACCELERATE
+        DSPSplitComplex a = { (float*)&in->re, (float*)&in->im };
+        DSPSplitComplex b = { (float*)&taps->re, (float*)&taps->im };
+        DSPSplitComplex c = { &out->re, &out->im };
+        vDSP_zdotpr(&a, 2, &b, 2, &c, count);
+#else
+        volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)out, (const lv_32fc_t*)in, (const lv_32fc_t*)taps, count);
+#endif
+    }
+
+    // Power in dB of the samples scaled down by norm, as volk_32fc_s32f_power_spectrum_32f computes it
+    inline void powerSpectrum(float* out, const complex_t* in, float norm, int count) {
+#ifdef SDRPP_USE_ACCELERATE
+        // Amplitudes clamped 200dB below full scale so that empty bins don't give -inf
+        float floor = norm * 1e-10f;
+        vDSP_vdist(&in->re, 2, &in->im, 2, out, 1, count);
+        vDSP_vthr(out, 1, &floor, out, 1, count);
+        vDSP_vdbcon(out, 1, &norm, out, 1, count, 1);
+#else
+        volk_32fc_s32f_power_spectrum_32f(out, (const lv_32fc_t*)in, norm, count);
+#endif
+    }
+}
@@ -3,7 +3,11 @@
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <typeinfo>
 #include "stream.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "thread_role.h"
 #include "types.h"
 
 namespace dsp {
@@ -18,17 +22,31 @@ namespace dsp {
     class block : public generic_block {
     public:
         virtual ~block() {
-            if (!_block_init) { return; }
-            stop();
-            _block_init = false;
+            // The worker uses the profile until it's joined
+            if (_block_init) {
+                stop();
+                _block_init = false;
+            }
+            if (profile) {
+                profiler::unregisterBlock(profile);
+                delete profile;
+            }
         }
 
+        // A hosted block is only flagged as running or not, the host being paused meanwhile so that it never
+        // processes the block while it changes state
         virtual void start() {
             assert(_block_init);
             std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
             if (running) {
                 return;
             }
+            if (host) {
+                host->tempStop();
+                running = true;
+                host->tempStart();
+                return;
+            }
             running = true;
             doStart();
         }
@@ -39,12 +57,25 @@ namespace dsp {
             if (!running) {
                 return;
             }
+            if (host) {
+                host->tempStop();
+                running = false;
+                host->tempStart();
+                return;
+            }
             doStop();
             running = false;
+
+            // A block stopped while stopped temporarily must not be started again by tempStart()
+            tempStopped = false;
         }
 
         void tempStart() {
             assert(_block_init);
+            if (host) {
+                host->tempStart();
+                return;
+            }
             if (!tempStopDepth || --tempStopDepth) { return; }
             if (tempStopped) {
                 doStart();
@@ -54,6 +85,10 @@ namespace dsp {
 
         void tempStop() {
             assert(_block_init);
+            if (host) {
+                host->tempStop();
+                return;
+            }
             if (tempStopDepth++) { return; }
             if (running && !tempStopped) {
                 doStop();
@@ -63,16 +98,123 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        // Have the block be processed by another block's thread (see chain). While hosted, the block doesn't run
+        // on its own and stopping it temporarily (eg. to change its parameters) pauses the host instead.
+        // A running block hands its processing over to the host or takes it back. The host must not be processing the
+        // block meanwhile
+        void setHost(block* host) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            bool active = running && !tempStopped;
+            if (active) { doStop(); }
+            this->host = host;
+            if (active) { doStart(); }
+        }
+
+        // Run the block as a task on a scheduler instead of its own thread, NULL to go back to a dedicated thread.
+        // Only suitable for blocks that read each input and swap each output at most once per run().
+        void setScheduler(Scheduler* sched) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            tempStop();
+            scheduler = sched;
+            tempStart();
+        }
+
+        // Count the time and samples of the block under the given name in the DSP performance statistics, which are
+        // only gathered while dsp::profiler is enabled. An empty name stops profiling the block
+        void setProfileName(const std::string& name) {
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            tempStop();
+            if (profile) {
+                profiler::unregisterBlock(profile);
+                delete profile;
+                profile = NULL;
+            }
+            if (!name.empty()) {
+                profile = new profiler::Counters;
+                profiler::registerBlock(name, profile);
+            }
+            tempStart();
+        }
+
+        // Run the worker thread of the block with the scheduling policy of the given role, see dsp::applyThreadRole().
+        // Blocks run by a scheduler use the policy of the scheduler's threads
+        void setThreadRole(ThreadRole role) {
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            tempStop();
+            threadRole = role;
+            tempStart();
+        }
+
     protected:
+        class BlockTask : public Scheduler::Task {
+        public:
+            BlockTask(block* blk) : blk(blk) {}
+
+            bool ready() {
+                for (auto& in : blk->inputs) {
+                    if (!in->canRead()) { return false; }
+                }
+                for (auto& out : blk->outputs) {
+                    if (!out->canWrite()) { return false; }
+                }
+                return true;
+            }
+
+            int execute() {
+                return blk->profiledRun();
+            }
+
+        private:
+            block* blk;
+        };
+
         void workerLoop() {
-            while (run() >= 0) {}
+            applyThreadRole(threadRole);
+            while (profiledRun() >= 0) {}
+        }
+
+        // Run with the waits and samples of the streams counted in the profile of the block, and traced if enabled
+        inline int profiledRun() {
+            profiler::Counters* prof = profile;
+            if (!prof) { return run(); }
+            bool counting = profiler::isEnabled();
+            bool tracing = profiler::isTracing();
+            if (!counting && !tracing) { return run(); }
+
+            if (counting) { profiler::current = prof; }
+            uint64_t start = profiler::now();
+            int ret = run();
+            if (counting) {
+                profiler::add(prof->runTime, profiler::now() - start);
+                profiler::add(prof->runs, 1);
+                profiler::current = NULL;
+            }
+            if (tracing) { profiler::trace(profiler::EVENT_RUN, prof->traceName, start, 0, ret); }
+            return ret;
         }
 
         virtual void doStart() {
-            workerThread = std::thread(&block::workerLoop, this);
+            if (host) { return; }
+            if (!scheduler) {
+                workerThread = std::thread(&block::workerLoop, this);
+                return;
+            }
+
+            // Get notified when inputs receive data or outputs get room
+            for (auto& in : inputs) {
+                in->setReadListener(&task);
+            }
+            for (auto& out : outputs) {
+                out->setWriteListener(&task);
+            }
+            scheduledOn = scheduler;
+            scheduledOn->attach(&task);
         }
 
         virtual void doStop() {
+            if (host) { return; }
             for (auto& in : inputs) {
                 in->stopReader();
             }
@@ -85,6 +227,18 @@ namespace dsp {
                 workerThread.join();
             }
 
+            // Remove the task from the scheduler, the listeners must be gone first so it can't be queued again
+            if (scheduledOn) {
+                for (auto& in : inputs) {
+                    in->setReadListener(NULL);
+                }
+                for (auto& out : outputs) {
+                    out->setWriteListener(NULL);
+                }
+                scheduledOn->detach(&task);
+                scheduledOn = NULL;
+            }
+
             for (auto& in : inputs) {
                 in->clearReadStop();
             }
@@ -109,8 +263,10 @@ namespace dsp {
             inputs.erase(std::remove(inputs.begin(), inputs.end(), inStream), inputs.end());
         }
 
+        // The buffers of the output are accounted under the type of the block from then on
         void registerOutput(untyped_stream* outStream) {
             outputs.push_back(outStream);
+            if (outStream) { outStream->setMemoryKind(buffer::pool::typeTag(typeid(*this))); }
         }
 
         void unregisterOutput(untyped_stream* outStream) {
@@ -121,6 +277,12 @@ namespace dsp {
 
         std::recursive_mutex ctrlMtx;
 
+        // Held by whatever processes the buffers of the block, its worker or its host, while it processes one but not
+        // while it waits for its input or outputs. Setters that must not stop the worker build the new state without
+        // it, only swap it in while holding it and free the old one afterwards, so the change lands between two
+        // buffers without restarting any thread
+        std::mutex paramMtx;
+
         std::vector<untyped_stream*> inputs;
         std::vector<untyped_stream*> outputs;
 
@@ -128,5 +290,13 @@ namespace dsp {
         bool tempStopped = false;
         int tempStopDepth = 0;
         std::thread workerThread;
+
+        block* host = NULL;
+        Scheduler* scheduler = NULL;
+        Scheduler* scheduledOn = NULL;
+        BlockTask task = BlockTask(this);
+
+        profiler::Counters* profile = NULL;
+        ThreadRole threadRole = THREAD_ROLE_NONE;
     };
 }
\ No newline at end of file
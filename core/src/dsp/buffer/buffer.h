@@ -1,11 +1,13 @@
 #pragma once
 #include <volk/volk.h>
 #include <string.h>
+#include "pool.h"
 
 namespace dsp::buffer {
+    // Aligned for volk, see pool.h for how the memory is obtained
     template<class T>
     inline T* alloc(int count) {
-        return (T*)volk_malloc(count * sizeof(T), volk_get_alignment());
+        return (T*)pool::alloc((size_t)count * sizeof(T));
     }
 
     template<class T>
@@ -14,6 +16,6 @@ namespace dsp::buffer {
     }
 
     inline void free(void* buffer) {
-        volk_free(buffer);
+        pool::free(buffer);
     }
 }
\ No newline at end of file
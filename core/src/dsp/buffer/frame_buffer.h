@@ -1,10 +1,32 @@
 #pragma once
+#include <atomic>
+#include <typeinfo>
 #include "../block.h"
-#define TEST_BUFFER_SIZE 32
 
-// IMPORTANT: THIS IS TRASH AND MUST BE REWRITTEN IN THE FUTURE
+// Default memory the queued blocks may take, about 130ms of complex samples at 60MS/s
+#define FRAME_BUFFER_DEFAULT_BUDGET     (64 * 1024 * 1024)
+
+// Most blocks queued at once, whatever their size
+#define FRAME_BUFFER_MAX_BLOCKS         256
+
+// Buffers given back by the output that are kept for reuse instead of being freed
+#define FRAME_BUFFER_SPARE_BUFFERS      4
 
 namespace dsp::buffer {
+    struct FrameBufferStats {
+        size_t fill = 0;            // Bytes taken by the queued blocks
+        size_t highWater = 0;       // Highest fill since the last reset
+        size_t budget = 0;
+        uint64_t overflows = 0;     // Blocks dropped because the budget or the ring was full
+    };
+
+    // Buffers the input of the DSP so that short stalls downstream don't hold up the source. The input thread
+    // queues each block and a worker thread outputs them, the two only sharing single producer single consumer rings
+    // through atomics. The memory taken by the queued blocks is bounded by a budget, blocks that don't fit are
+    // dropped and counted as overflows, the next block then being flagged as a discontinuity.
+    // When the input is a plain stream, blocks that fill most of its buffer are taken over by exchanging that buffer
+    // with a spare one instead of being copied, and are handed to the output the same way.
+    // In bypass mode, the input thread waits for each block to be taken by the worker instead of queuing ahead.
     template <class T>
     class SampleFrameBuffer : public block {
         using base_type = block;
@@ -16,16 +38,20 @@ namespace dsp::buffer {
         ~SampleFrameBuffer() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
-                buffer::free(buffers[i]);
+            for (uint64_t i = tail.load(); i < head.load(); i++) {
+                buffer::free(queue[i % FRAME_BUFFER_MAX_BLOCKS].data);
+            }
+            for (uint64_t i = spareTail.load(); i < spareHead.load(); i++) {
+                buffer::free(spares[i % FRAME_BUFFER_SPARE_BUFFERS].data);
             }
         }
 
         void init(stream<T>* in) {
             _in = in;
-
-            for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
-                buffers[i] = buffer::alloc<T>(STREAM_BUFFER_SIZE);
+            adoptable = isPlainStream(_in);
+            if (_in) {
+                out.setBufferSize(_in->getMaxBlockSize());
+                out.setMaxBlockSize(_in->getMaxBlockSize());
             }
 
             base_type::registerInput(in);
@@ -39,67 +65,185 @@ namespace dsp::buffer {
             base_type::tempStop();
             base_type::unregisterInput(_in);
             _in = in;
+            adoptable = isPlainStream(_in);
+            out.reserve(_in->getMaxBlockSize());
+            out.setMaxBlockSize(std::max<int>(out.getMaxBlockSize(), _in->getMaxBlockSize()));
             base_type::registerInput(_in);
             base_type::tempStart();
         }
 
+        // Maximum memory taken by the queued blocks, in bytes
+        void setBudget(size_t bytes) {
+            budget = bytes;
+        }
+
+        // Drop all queued blocks, can be called from any thread
         void flush() {
-            std::unique_lock lck(bufMtx);
-            readCur = writeCur;
+            flushTarget.store(head.load());
+        }
+
+        FrameBufferStats getStats() {
+            FrameBufferStats stats;
+            stats.fill = queuedBytes.load();
+            stats.highWater = highWater.load();
+            stats.budget = budget.load();
+            stats.overflows = overflows.load();
+            return stats;
+        }
+
+        void resetStats() {
+            highWater = queuedBytes.load();
+            overflows = 0;
         }
 
         int run() {
-            // Wait for data
             int count = _in->read();
             if (count < 0) { return -1; }
+            bool ok = push(count);
+            _in->flush();
+            return ok ? count : -1;
+        }
+
+        stream<T> out;
+
+        std::atomic<bool> bypass = false;
+
+    private:
+        struct Block {
+            T* data;
+            int capacity;
+            int count;
+            stream_meta meta;
+        };
 
-            if (bypass) {
-                memcpy(out.writeBuf, _in->readBuf, count * sizeof(T));
-                _in->flush();
-                if (!out.swap(count)) { return -1; }
-                return count;
+        // Exchanging buffers with a stream is only safe when it owns both of them
+        static bool isPlainStream(stream<T>* s) {
+            return s && typeid(*s) == typeid(stream<T>);
+        }
+
+        // Queue the block just read from the input, returns false when stopped
+        bool push(int count) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+
+            // Without buffering, wait for the worker to have taken everything queued so far
+            if (bypass.load() && tail.load() != h && !stopWorker.load()) {
+                std::unique_lock<std::mutex> lck(mtx);
+                writerWaiting.store(true);
+                cnd.wait(lck, [this, h]() { return (tail.load() == h) || stopWorker.load(); });
+                writerWaiting.store(false);
             }
+            if (stopWorker.load()) { return false; }
 
-            // Push it on the ring buffer
-            {
-                std::lock_guard<std::mutex> lck(bufMtx);
-                memcpy(buffers[writeCur], _in->readBuf, count * sizeof(T));
-                sizes[writeCur] = count;
-                writeCur++;
-                writeCur = ((writeCur) % TEST_BUFFER_SIZE);
+            // Take the buffer of the input over when the block fills most of it, otherwise copy to a buffer to size
+            int inCapacity = _in->getBufferSize();
+            bool adopt = adoptable && (count >= inCapacity / 2);
+            int capacity = adopt ? inCapacity : count;
+            size_t bytes = (size_t)capacity * sizeof(T);
+
+            // Drop the block if it doesn't fit
+            if (h - tail.load() >= FRAME_BUFFER_MAX_BLOCKS || queuedBytes.load() + bytes > budget.load()) {
+                overflows++;
+                dropped = true;
+                return true;
             }
-            cnd.notify_all();
-            _in->flush();
-            return count;
+
+            Block blk = takeSpare(capacity);
+            if (adopt) {
+                std::swap(blk.data, _in->readBuf);
+                blk.capacity = inCapacity;
+            }
+            else {
+                memcpy(blk.data, _in->readBuf, count * sizeof(T));
+            }
+            blk.count = count;
+            blk.meta = _in->readMeta;
+            if (dropped) {
+                blk.meta.discontinuity = true;
+                dropped = false;
+            }
+
+            // Publish it
+            size_t fill = (queuedBytes += (size_t)blk.capacity * sizeof(T));
+            if (fill > highWater.load()) { highWater.store(fill); }
+            queue[h % FRAME_BUFFER_MAX_BLOCKS] = blk;
+            head.store(h + 1);
+            if (readerWaiting.load()) {
+                { std::lock_guard<std::mutex> lck(mtx); }
+                cnd.notify_all();
+            }
+            return true;
         }
 
-        void worker() {
-            while (true) {
-                // Wait for data
-                std::unique_lock lck(bufMtx);
-                cnd.wait(lck, [this]() { return (((writeCur - readCur + TEST_BUFFER_SIZE) % TEST_BUFFER_SIZE) > 0) || stopWorker; });
-                if (stopWorker) { break; }
-
-                // Write one to output buffer and unlock in preparation to swap buffers
-                int count = sizes[readCur];
-                memcpy(out.writeBuf, buffers[readCur], count * sizeof(T));
-                readCur++;
-                readCur = ((readCur) % TEST_BUFFER_SIZE);
-                lck.unlock();
-
-                // Swap
-                if (!out.swap(count)) { break; }
+        // Get a buffer of at least the given capacity, reusing one given back by the worker if possible
+        Block takeSpare(int capacity) {
+            Block blk;
+            uint64_t t = spareTail.load(std::memory_order_relaxed);
+            if (t != spareHead.load()) {
+                blk = spares[t % FRAME_BUFFER_SPARE_BUFFERS];
+                spareTail.store(t + 1);
+                if (blk.capacity >= capacity) { return blk; }
+                buffer::free(blk.data);
             }
+            blk.data = buffer::alloc<T>(capacity);
+            blk.capacity = capacity;
+            return blk;
         }
 
-        stream<T> out;
+        // Give a buffer back to the input thread, called by the worker
+        void releaseSpare(const Block& blk) {
+            uint64_t h = spareHead.load(std::memory_order_relaxed);
+            if (h - spareTail.load() >= FRAME_BUFFER_SPARE_BUFFERS) {
+                buffer::free(blk.data);
+                return;
+            }
+            spares[h % FRAME_BUFFER_SPARE_BUFFERS] = blk;
+            spareHead.store(h + 1);
+        }
 
-        int writeCur = 0;
-        int readCur = 0;
+        void worker() {
+            applyThreadRole(base_type::threadRole);
+            while (true) {
+                // Wait for a block
+                uint64_t t = tail.load(std::memory_order_relaxed);
+                if (head.load() == t && !stopWorker.load()) {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    readerWaiting.store(true);
+                    cnd.wait(lck, [this, t]() { return (head.load() != t) || stopWorker.load(); });
+                    readerWaiting.store(false);
+                }
+                if (stopWorker.load()) { break; }
 
-        bool bypass = false;
+                // Blocks queued before a flush are dropped
+                Block blk = queue[t % FRAME_BUFFER_MAX_BLOCKS];
+                size_t bytes = (size_t)blk.capacity * sizeof(T);
+                bool flushed = (t < flushTarget.load());
+                if (!flushed) {
+                    // Hand the buffer over if it's large enough for the output, the one it replaces becoming a spare
+                    out.writeMeta = blk.meta;
+                    if (blk.capacity >= out.getBufferSize()) {
+                        int outCapacity = out.getBufferSize();
+                        std::swap(blk.data, out.writeBuf);
+                        blk.capacity = outCapacity;
+                    }
+                    else {
+                        out.reserve(blk.count);
+                        memcpy(out.writeBuf, blk.data, blk.count * sizeof(T));
+                    }
+                }
+                releaseSpare(blk);
+
+                // Release the slot
+                queuedBytes -= bytes;
+                tail.store(t + 1);
+                if (writerWaiting.load()) {
+                    { std::lock_guard<std::mutex> lck(mtx); }
+                    cnd.notify_all();
+                }
+
+                if (!flushed && !out.swap(blk.count)) { break; }
+            }
+        }
 
-    private:
         void doStart() {
             base_type::workerThread = std::thread(&SampleFrameBuffer<T>::workerLoop, this);
             readWorkerThread = std::thread(&SampleFrameBuffer<T>::worker, this);
@@ -108,7 +252,10 @@ namespace dsp::buffer {
         void doStop() {
             _in->stopReader();
             out.stopWriter();
-            stopWorker = true;
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                stopWorker = true;
+            }
             cnd.notify_all();
 
             if (base_type::workerThread.joinable()) { base_type::workerThread.join(); }
@@ -120,13 +267,31 @@ namespace dsp::buffer {
         }
 
         stream<T>* _in;
-
+        bool adoptable = false;
         std::thread readWorkerThread;
-        std::mutex bufMtx;
+
+        // Queued blocks, written by the input thread at head and read by the worker at tail
+        Block queue[FRAME_BUFFER_MAX_BLOCKS];
+        std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> tail = 0;
+        std::atomic<uint64_t> flushTarget = 0;
+
+        // Buffers given back by the worker at spareHead, taken by the input thread at spareTail
+        Block spares[FRAME_BUFFER_SPARE_BUFFERS];
+        std::atomic<uint64_t> spareHead = 0;
+        std::atomic<uint64_t> spareTail = 0;
+
+        // The lock is only taken to park a thread until the other one moves
+        std::mutex mtx;
         std::condition_variable cnd;
-        T* buffers[TEST_BUFFER_SIZE];
-        int sizes[TEST_BUFFER_SIZE];
+        std::atomic<bool> readerWaiting = false;
+        std::atomic<bool> writerWaiting = false;
+        std::atomic<bool> stopWorker = false;
 
-        bool stopWorker = false;
+        std::atomic<size_t> budget = FRAME_BUFFER_DEFAULT_BUDGET;
+        std::atomic<size_t> queuedBytes = 0;
+        std::atomic<size_t> highWater = 0;
+        std::atomic<uint64_t> overflows = 0;
+        bool dropped = false;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,100 @@
+#include "mirrored_buffer.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <atomic>
+#endif
+
+// Attempts at finding room for both views on Windows, another thread can take the address between reserving and mapping
+#define MIRRORED_BUFFER_MAP_ATTEMPTS    8
+
+namespace dsp::buffer {
+#ifdef _WIN32
+    void* mirroredAlloc(size_t& size) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        size_t gran = info.dwAllocationGranularity;
+        size = ((size + gran - 1) / gran) * gran;
+
+        HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+        if (!mapping) { return NULL; }
+
+        // Find a free range twice the size, then map both views over it
+        void* result = NULL;
+        for (int i = 0; i < MIRRORED_BUFFER_MAP_ATTEMPTS && !result; i++) {
+            uint8_t* addr = (uint8_t*)VirtualAlloc(NULL, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+            if (!addr) { break; }
+            VirtualFree(addr, 0, MEM_RELEASE);
+            void* first = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr);
+            void* second = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr + size);
+            if (first == addr && second == addr + size) {
+                result = addr;
+                break;
+            }
+            if (first) { UnmapViewOfFile(first); }
+            if (second) { UnmapViewOfFile(second); }
+        }
+
+        // The views keep the mapping alive
+        CloseHandle(mapping);
+        return result;
+    }
+
+    void mirroredFree(void* ptr, size_t size) {
+        UnmapViewOfFile((uint8_t*)ptr + size);
+        UnmapViewOfFile(ptr);
+    }
+#else
+    static int createSharedMemory(size_t size) {
+        int fd = -1;
+#if defined(__linux__) && !defined(__ANDROID__)
+        fd = memfd_create("sdrpp_mirrored_buffer", 0);
+#elif !defined(__ANDROID__)
+        // Named shared memory, unlinked right away so that it goes away with the mappings
+        static std::atomic<int> counter = 0;
+        char name[64];
+        snprintf(name, sizeof(name), "/sdrpp_mirror_%d_%d", (int)getpid(), counter++);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) { shm_unlink(name); }
+#endif
+        if (fd < 0) { return -1; }
+        if (ftruncate(fd, size) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void* mirroredAlloc(size_t& size) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size = ((size + page - 1) / page) * page;
+
+        int fd = createSharedMemory(size);
+        if (fd < 0) { return NULL; }
+
+        // Reserve twice the size, then map the memory over both halves
+        uint8_t* addr = (uint8_t*)mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            return NULL;
+        }
+        void* first = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        void* second = mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+        if (first != addr || second != addr + size) {
+            munmap(addr, 2 * size);
+            return NULL;
+        }
+        return addr;
+    }
+
+    void mirroredFree(void* ptr, size_t size) {
+        munmap(ptr, 2 * size);
+    }
+#endif
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <string.h>
+#include <algorithm>
+#include "buffer.h"
+
+namespace dsp::buffer {
+    // Map size bytes of memory twice in a row, so that what is written at an address also appears size bytes after it.
+    // size is rounded up to what the system can map. Returns NULL if the system doesn't support it
+    void* mirroredAlloc(size_t& size);
+    void mirroredFree(void* ptr, size_t size);
+
+    // Ring of samples whose end continues into its start, so that any run of up to size() samples from any position is
+    // contiguous and can be handed out as a pointer without copying it out of the ring. The memory is mapped twice by
+    // the system when possible, otherwise the ring is stored twice and writes go to both copies.
+    template <class T>
+    class MirroredBuffer {
+    public:
+        MirroredBuffer() {}
+
+        MirroredBuffer(int minSize) { init(minSize); }
+
+        ~MirroredBuffer() { free(); }
+
+        // Allocate a ring of at least minSize samples, cleared
+        void init(int minSize) {
+            free();
+            size_t bytes = (size_t)minSize * sizeof(T);
+            void* ptr = mirroredAlloc(bytes);
+            if (ptr && (bytes % sizeof(T)) == 0) {
+                buf = (T*)ptr;
+                mappedBytes = bytes;
+                _size = bytes / sizeof(T);
+                mirrored = true;
+            }
+            else {
+                if (ptr) { mirroredFree(ptr, bytes); }
+                _size = minSize;
+                buf = buffer::alloc<T>(2 * _size);
+                mirrored = false;
+            }
+            memset((void*)buf, 0, (size_t)_size * sizeof(T));
+            if (!mirrored) { memset((void*)&buf[_size], 0, (size_t)_size * sizeof(T)); }
+        }
+
+        void free() {
+            if (!buf) { return; }
+            if (mirrored) { mirroredFree(buf, mappedBytes); }
+            else { buffer::free(buf); }
+            buf = NULL;
+            _size = 0;
+        }
+
+        // Write count samples, at most size(), starting at position pos of the ring
+        inline void write(int pos, const T* data, int count) {
+            if (mirrored) {
+                memcpy(&buf[pos], data, count * sizeof(T));
+                return;
+            }
+            int first = std::min<int>(count, _size - pos);
+            memcpy(&buf[pos], data, first * sizeof(T));
+            memcpy(&buf[pos + _size], data, first * sizeof(T));
+            if (first < count) {
+                memcpy(buf, &data[first], (count - first) * sizeof(T));
+                memcpy(&buf[_size], &data[first], (count - first) * sizeof(T));
+            }
+        }
+
+        // Samples from position pos of the ring, contiguous for size() samples
+        inline T* at(int pos) { return &buf[pos]; }
+
+        inline int size() { return _size; }
+
+        // Whether the system maps the memory twice, instead of every sample being stored twice
+        bool isMirrored() { return mirrored; }
+
+    private:
+        T* buf = NULL;
+        int _size = 0;
+        size_t mappedBytes = 0;
+        bool mirrored = false;
+    };
+}
@@ -0,0 +1,375 @@
+#include "pool.h"
+#include <volk/volk.h>
+#include <utils/flog.h>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <map>
+#include <string.h>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#include <stdlib.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Smallest size class, in bytes
+#define DSP_POOL_MIN_CLASS_SIZE     64
+
+// Size classes per power of two
+#define DSP_POOL_CLASS_STEPS        4
+
+// Size classes, enough for buffers of up to 2^40 bytes
+#define DSP_POOL_CLASS_COUNT        (34 * DSP_POOL_CLASS_STEPS)
+
+// Total size of the freed buffers kept for reuse, above which they go back to the system
+#define DSP_POOL_MAX_CACHED_BYTES   (512ull << 20)
+
+// Size of a huge page, buffers at least this big are put in huge pages
+#define DSP_POOL_HUGE_PAGE_SIZE     (2ull << 20)
+
+namespace dsp::buffer::pool {
+    struct Block {
+        size_t requested;
+        int cls;            // -1 for buffers from MODE_SYSTEM
+        size_t mapBytes;    // Non zero for buffers mapped by the pool itself
+        bool hugePages;
+        Tag owner;
+        Tag kind;
+    };
+
+    struct Account {
+        size_t bytes = 0;
+        int64_t buffers = 0;
+    };
+
+    struct Class {
+        std::vector<void*> cached;
+        ClassStats stats = {};
+        bool used = false;
+    };
+
+    struct State {
+        std::mutex mtx;
+        std::atomic<Mode> mode = MODE_SYSTEM;
+        std::unordered_map<void*, Block> blocks;
+        Class classes[DSP_POOL_CLASS_COUNT];
+        ClassStats systemStats = {};
+        size_t cachedBytes = 0;
+        bool hugeWarned = false;
+
+        // Names of the tags and the memory accounted to each owner and kind
+        std::mutex tagMtx;
+        std::vector<std::string> tagNames = { "core", "buffers" };
+        std::unordered_map<std::string, Tag> tags = { { "core", 0 }, { "buffers", 1 } };
+        std::unordered_map<const std::type_info*, Tag> typeTags;
+        std::map<std::pair<Tag, Tag>, Account> accounts;
+    };
+
+    static thread_local Tag scopeOwner = 0;
+    static thread_local Tag scopeKind = 1;
+
+    // Never destroyed, buffers may still be freed by the destructors of other globals at exit
+    static State& state() {
+        static State* s = new State();
+        return *s;
+    }
+
+    static size_t classSize(int cls) {
+        size_t base = (size_t)DSP_POOL_MIN_CLASS_SIZE << (cls / DSP_POOL_CLASS_STEPS);
+        return base + (base / DSP_POOL_CLASS_STEPS) * (cls % DSP_POOL_CLASS_STEPS);
+    }
+
+    // Smallest class holding the given number of bytes
+    static int classOf(size_t bytes) {
+        if (bytes <= DSP_POOL_MIN_CLASS_SIZE) { return 0; }
+        int octave = 0;
+        while (((size_t)DSP_POOL_MIN_CLASS_SIZE << (octave + 1)) < bytes) { octave++; }
+        size_t base = (size_t)DSP_POOL_MIN_CLASS_SIZE << octave;
+        size_t step = base / DSP_POOL_CLASS_STEPS;
+        int cls = octave * DSP_POOL_CLASS_STEPS + (int)((bytes - base + step - 1) / step);
+        return std::min<int>(cls, DSP_POOL_CLASS_COUNT - 1);
+    }
+
+    // Allocate memory for a class from the system, mapped in huge pages when asked and possible
+    static void* systemAlloc(State& s, size_t size, bool huge, Block& block) {
+        block.mapBytes = 0;
+        block.hugePages = false;
+#ifdef __linux__
+        if (huge && size >= DSP_POOL_HUGE_PAGE_SIZE) {
+            size_t mapBytes = ((size + DSP_POOL_HUGE_PAGE_SIZE - 1) / DSP_POOL_HUGE_PAGE_SIZE) * DSP_POOL_HUGE_PAGE_SIZE;
+            void* ptr = mmap(NULL, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                block.mapBytes = mapBytes;
+                block.hugePages = true;
+                return ptr;
+            }
+
+            // No huge pages reserved, ask for transparent ones instead
+            if (!s.hugeWarned) {
+                flog::warn("[BufferPool] No huge pages available, see /proc/sys/vm/nr_hugepages. Using transparent huge pages instead");
+                s.hugeWarned = true;
+            }
+            ptr = mmap(NULL, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr != MAP_FAILED) {
+                madvise(ptr, mapBytes, MADV_HUGEPAGE);
+                block.mapBytes = mapBytes;
+                return ptr;
+            }
+        }
+#endif
+        return volk_malloc(size, volk_get_alignment());
+    }
+
+    // Memory held by a buffer
+    static size_t footprint(const Block& block) {
+        if (block.mapBytes) { return block.mapBytes; }
+        return (block.cls < 0) ? block.requested : classSize(block.cls);
+    }
+
+    static void account(State& s, const Block& block, int sign) {
+        Account& a = s.accounts[{ block.owner, block.kind }];
+        a.bytes += sign * (int64_t)footprint(block);
+        a.buffers += sign;
+    }
+
+    static void systemFree(void* ptr, const Block& block) {
+#ifdef __linux__
+        if (block.mapBytes) {
+            munmap(ptr, block.mapBytes);
+            return;
+        }
+#endif
+        volk_free(ptr);
+    }
+
+    void setMode(Mode mode) {
+#ifndef __linux__
+        if (mode == MODE_HUGEPAGES) {
+            flog::warn("[BufferPool] Huge pages are only supported on Linux, using a pool without them");
+            mode = MODE_POOLED;
+        }
+#endif
+        state().mode = mode;
+    }
+
+    Mode getMode() {
+        return state().mode;
+    }
+
+    bool parseMode(const char* name, Mode& mode) {
+        if (!strcmp(name, "system")) { mode = MODE_SYSTEM; }
+        else if (!strcmp(name, "pool")) { mode = MODE_POOLED; }
+        else if (!strcmp(name, "hugepages")) { mode = MODE_HUGEPAGES; }
+        else { return false; }
+        return true;
+    }
+
+    void* alloc(size_t bytes) {
+        State& s = state();
+        Mode mode = s.mode;
+        std::lock_guard<std::mutex> lck(s.mtx);
+
+        if (mode == MODE_SYSTEM) {
+            void* ptr = volk_malloc(bytes, volk_get_alignment());
+            if (!ptr) { return NULL; }
+            Block& block = s.blocks[ptr];
+            block = { bytes, -1, 0, false, scopeOwner, scopeKind };
+            account(s, block, 1);
+            s.systemStats.bytesInUse += bytes;
+            s.systemStats.inUse++;
+            s.systemStats.misses++;
+            return ptr;
+        }
+
+        int cls = classOf(bytes);
+        Class& c = s.classes[cls];
+        c.used = true;
+        void* ptr;
+        if (!c.cached.empty()) {
+            ptr = c.cached.back();
+            c.cached.pop_back();
+            c.stats.cached--;
+            c.stats.hits++;
+            s.cachedBytes -= classSize(cls);
+            Block& block = s.blocks[ptr];
+            block.requested = bytes;
+            block.owner = scopeOwner;
+            block.kind = scopeKind;
+            account(s, block, 1);
+        }
+        else {
+            Block block = { bytes, cls, 0, false, scopeOwner, scopeKind };
+            ptr = systemAlloc(s, classSize(cls), mode == MODE_HUGEPAGES, block);
+            if (!ptr) { return NULL; }
+            s.blocks[ptr] = block;
+            account(s, block, 1);
+            c.stats.misses++;
+            if (block.hugePages) { c.stats.hugePages++; }
+        }
+        c.stats.inUse++;
+        c.stats.bytesInUse += bytes;
+        return ptr;
+    }
+
+    void free(void* ptr) {
+        if (!ptr) { return; }
+        State& s = state();
+        std::lock_guard<std::mutex> lck(s.mtx);
+
+        // Memory the pool doesn't know of came from volk_malloc() directly
+        auto it = s.blocks.find(ptr);
+        if (it == s.blocks.end()) {
+            volk_free(ptr);
+            return;
+        }
+        Block& block = it->second;
+        account(s, block, -1);
+
+        if (block.cls < 0) {
+            s.systemStats.bytesInUse -= block.requested;
+            s.systemStats.inUse--;
+            volk_free(ptr);
+            s.blocks.erase(it);
+            return;
+        }
+
+        Class& c = s.classes[block.cls];
+        c.stats.inUse--;
+        c.stats.bytesInUse -= block.requested;
+
+        // Keep the buffer unless the pool is full or was turned off
+        size_t size = classSize(block.cls);
+        if (s.mode != MODE_SYSTEM && s.cachedBytes + size <= DSP_POOL_MAX_CACHED_BYTES) {
+            c.cached.push_back(ptr);
+            c.stats.cached++;
+            s.cachedBytes += size;
+            return;
+        }
+        if (block.hugePages) { c.stats.hugePages--; }
+        systemFree(ptr, block);
+        s.blocks.erase(it);
+    }
+
+    void trim() {
+        State& s = state();
+        std::lock_guard<std::mutex> lck(s.mtx);
+        for (auto& c : s.classes) {
+            for (void* ptr : c.cached) {
+                auto it = s.blocks.find(ptr);
+                if (it->second.hugePages) { c.stats.hugePages--; }
+                systemFree(ptr, it->second);
+                s.blocks.erase(it);
+            }
+            c.cached.clear();
+            c.stats.cached = 0;
+        }
+        s.cachedBytes = 0;
+    }
+
+    std::vector<ClassStats> getStats() {
+        State& s = state();
+        std::lock_guard<std::mutex> lck(s.mtx);
+        std::vector<ClassStats> stats;
+        if (s.systemStats.misses) { stats.push_back(s.systemStats); }
+        for (int i = 0; i < DSP_POOL_CLASS_COUNT; i++) {
+            if (!s.classes[i].used) { continue; }
+            ClassStats cs = s.classes[i].stats;
+            cs.size = classSize(i);
+            stats.push_back(cs);
+        }
+        return stats;
+    }
+}
+
+namespace dsp::buffer::pool {
+    Tag tag(const std::string& name) {
+        State& s = state();
+        std::lock_guard<std::mutex> lck(s.tagMtx);
+        auto it = s.tags.find(name);
+        if (it != s.tags.end()) { return it->second; }
+        Tag t = s.tagNames.size();
+        s.tagNames.push_back(name);
+        s.tags[name] = t;
+        return t;
+    }
+
+    Tag typeTag(const std::type_info& type) {
+        State& s = state();
+        {
+            std::lock_guard<std::mutex> lck(s.tagMtx);
+            auto it = s.typeTags.find(&type);
+            if (it != s.typeTags.end()) { return it->second; }
+        }
+        std::string name = type.name();
+#if defined(__GNUC__) || defined(__clang__)
+        int status;
+        char* demangled = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+        if (demangled) {
+            name = demangled;
+            ::free(demangled);
+        }
+#endif
+        Tag t = tag(name);
+        std::lock_guard<std::mutex> lck(s.tagMtx);
+        s.typeTags[&type] = t;
+        return t;
+    }
+
+    Scope::Scope(Tag owner, Tag kind) {
+        prevOwner = scopeOwner;
+        prevKind = scopeKind;
+        scopeOwner = owner;
+        if (kind >= 0) { scopeKind = kind; }
+    }
+
+    Scope::Scope(const std::string& owner) : Scope(tag(owner)) {}
+
+    Scope::~Scope() {
+        scopeOwner = prevOwner;
+        scopeKind = prevKind;
+    }
+
+    Tag currentOwner() {
+        return scopeOwner;
+    }
+
+    Tag currentKind() {
+        return scopeKind;
+    }
+
+    void setKind(void* ptr, Tag kind) {
+        if (!ptr) { return; }
+        State& s = state();
+        std::lock_guard<std::mutex> lck(s.mtx);
+        auto it = s.blocks.find(ptr);
+        if (it == s.blocks.end() || it->second.kind == kind) { return; }
+        account(s, it->second, -1);
+        it->second.kind = kind;
+        account(s, it->second, 1);
+    }
+
+    std::vector<Usage> getUsage() {
+        State& s = state();
+        std::vector<std::pair<std::pair<Tag, Tag>, Account>> accounts;
+        size_t cachedBytes;
+        int64_t cachedBuffers = 0;
+        {
+            std::lock_guard<std::mutex> lck(s.mtx);
+            for (const auto& [key, a] : s.accounts) {
+                if (a.buffers) { accounts.push_back({ key, a }); }
+            }
+            cachedBytes = s.cachedBytes;
+            for (const auto& c : s.classes) { cachedBuffers += c.cached.size(); }
+        }
+
+        std::lock_guard<std::mutex> lck(s.tagMtx);
+        std::vector<Usage> usage;
+        for (const auto& [key, a] : accounts) {
+            usage.push_back({ s.tagNames[key.first], s.tagNames[key.second], a.bytes, a.buffers });
+        }
+        if (cachedBuffers) { usage.push_back({ "core", "cached", cachedBytes, cachedBuffers }); }
+        return usage;
+    }
+}
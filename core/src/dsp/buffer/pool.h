@@ -0,0 +1,89 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <typeinfo>
+
+// Allocator behind buffer::alloc(). The buffers handed out are kept in a table telling how each was allocated, so they
+// can be freed whatever the mode was when they were allocated. In the pooled modes, sizes are rounded up to a size
+// class, four per power of two, and freed buffers are kept to be handed out again for the same class instead of
+// going back to the system, up to a total of DSP_POOL_MAX_CACHED_BYTES.
+namespace dsp::buffer::pool {
+    enum Mode {
+        // Every buffer comes from and goes back to the system, as volk_malloc() would
+        MODE_SYSTEM,
+
+        // Freed buffers are reused
+        MODE_POOLED,
+
+        // Like MODE_POOLED, with the buffers of 2MB and more in huge pages. Falls back to transparent huge pages when
+        // none are reserved, and to MODE_POOLED on systems other than Linux
+        MODE_HUGEPAGES
+    };
+
+    struct ClassStats {
+        size_t size;            // Bytes of a buffer of the class, 0 for buffers allocated with MODE_SYSTEM
+        size_t bytesInUse;      // Bytes requested by the buffers in use
+        int64_t inUse;          // Buffers allocated and not yet freed
+        int64_t cached;         // Freed buffers kept for reuse
+        int64_t hits;           // Allocations served by a cached buffer
+        int64_t misses;         // Allocations that went to the system
+        int64_t hugePages;      // Buffers of the class, in use or cached, backed by huge pages
+    };
+
+    // Only affects the buffers allocated from then on, should be called at startup
+    void setMode(Mode mode);
+    Mode getMode();
+
+    // Parse the name of a mode, "system", "pool" or "hugepages". Returns false if it's unknown
+    bool parseMode(const char* name, Mode& mode);
+
+    void* alloc(size_t bytes);
+    void free(void* ptr);
+
+    // Give the cached buffers back to the system
+    void trim();
+
+    // Statistics of the classes that are or were used, by increasing size
+    std::vector<ClassStats> getStats();
+
+    // Memory is also accounted by owner, the module instance or the part of the core that allocated it, and by kind,
+    // the type of the block for stream buffers and "buffers" for the rest. Allocations go to the owner and kind of
+    // the innermost Scope of the allocating thread, by default "core" and "buffers"
+    typedef int Tag;
+
+    // Tag of a name, the same name always giving the same tag
+    Tag tag(const std::string& name);
+
+    // Tag of the demangled name of a type
+    Tag typeTag(const std::type_info& type);
+
+    class Scope {
+    public:
+        // A kind of -1 keeps that of the enclosing scope
+        Scope(Tag owner, Tag kind = -1);
+        Scope(const std::string& owner);
+        ~Scope();
+
+    private:
+        Tag prevOwner;
+        Tag prevKind;
+    };
+
+    Tag currentOwner();
+    Tag currentKind();
+
+    // Change the kind a buffer is accounted under, its owner staying the same
+    void setKind(void* ptr, Tag kind);
+
+    struct Usage {
+        std::string owner;
+        std::string kind;
+        size_t bytes;           // Memory held, including the rounding of the size classes
+        int64_t buffers;
+    };
+
+    // Memory in use by owner and kind, the buffers cached by the pool being listed with the kind "cached"
+    std::vector<Usage> getUsage();
+}
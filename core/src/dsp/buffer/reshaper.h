@@ -1,11 +1,16 @@
 #pragma once
 #include "../block.h"
+#include "../shared_stream.h"
 #include "ring_buffer.h"
-
-// IMPORTANT: THIS IS TRASH AND MUST BE REWRITTEN IN THE FUTURE
+#include "mirrored_buffer.h"
 
 namespace dsp::buffer {
-    // NOTE: I'm not proud of this, it's BAD and just taken from the previous DSP, but it works...
+    // Cut the input into frames of keep samples, skip samples apart. A negative skip overlaps the frames. The input is
+    // written once into a mirrored ring and the frames are handed to the reader as pointers into it, so overlapped
+    // samples aren't copied again for each frame they are part of. The reader must flush a frame before the ring
+    // wraps around to it, until then the input keeps being written to the rest of the ring. Frames can be up to
+    // RING_BUF_SZ samples, those over half of it being filled only once the reader released the previous one. Each
+    // frame carries the metadata of its first sample.
     template <class T>
     class Reshaper : public block {
         using base_type = block;
@@ -14,8 +19,6 @@ namespace dsp::buffer {
 
         Reshaper(stream<T>* in, int keep, int skip) { init(in, keep, skip); }
 
-        // NOTE: For some reason, the base class destructor doesn't get called.... this is a temporary fix I guess
-        // I also don't check for _block_init for the exact sample reason, something's weird
         ~Reshaper() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
@@ -23,9 +26,8 @@ namespace dsp::buffer {
 
         void init(stream<T>* in, int keep, int skip) {
             _in = in;
-            _keep = keep;
-            _skip = skip;
-            ringBuf.init(keep * 2);
+            ring.init(RING_BUF_SZ);
+            configure(keep, skip);
             base_type::registerInput(_in);
             base_type::registerOutput(&out);
             base_type::_block_init = true;
@@ -45,8 +47,7 @@ namespace dsp::buffer {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            _keep = keep;
-            ringBuf.setMaxLatency(keep * 2);
+            configure(keep, _skip);
             base_type::tempStart();
         }
 
@@ -54,84 +55,116 @@ namespace dsp::buffer {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            _skip = skip;
+            configure(_keep, skip);
+            base_type::tempStart();
+        }
+
+        // Change both at once, restarting the worker only once
+        void setFrame(int keep, int skip) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            configure(keep, skip);
             base_type::tempStart();
         }
 
         int run() {
             int count = _in->read();
             if (count < 0) { return -1; }
-            ringBuf.write(_in->readBuf, count);
+
+            const T* data = _in->readBuf;
+            int i = 0;
+
+            // Samples lost before this buffer are also lost from the frame being filled
+            if (_in->readMeta.discontinuity && writePos > frameStart) { out.writeMeta.discontinuity = true; }
+
+            while (i < count) {
+                // Drop the samples between two frames
+                if (writePos < frameStart) {
+                    int n = (int)std::min<uint64_t>(count - i, frameStart - writePos);
+                    writePos += n;
+                    i += n;
+                    continue;
+                }
+
+                // The frame held by the reader must not be overwritten, wait for it to be done with it
+                uint64_t limit = (held ? heldStart : frameStart) + ring.size();
+                if (writePos >= limit) {
+                    if (!out.waitReleased()) { _in->flush(); return -1; }
+                    held = false;
+                    continue;
+                }
+
+                // A frame is described by the metadata of its first sample
+                if (writePos == frameStart) { out.writeMeta = metaAt(i); }
+
+                // Write up to the end of the current frame
+                int n = (int)std::min<uint64_t>(std::min<uint64_t>(count - i, limit - writePos), frameStart + _keep - writePos);
+                ring.write(writePos % ring.size(), &data[i], n);
+                writePos += n;
+                i += n;
+
+                // Hand the frame out once complete
+                if (writePos == frameStart + _keep) {
+                    if (held && !out.waitReleased()) { _in->flush(); return -1; }
+                    if (!out.publish(ring.at(frameStart % ring.size()), _keep)) { _in->flush(); return -1; }
+                    held = true;
+                    heldStart = frameStart;
+                    frameStart += _keep + _skip;
+                }
+            }
+
             _in->flush();
             return count;
         }
 
-        stream<T> out;
+        shared_stream<T> out;
 
     private:
+        void configure(int keep, int skip) {
+            assert(keep > 0 && keep <= ring.size());
+            _keep = keep;
+            _skip = std::max<int>(skip, 1 - keep);
+
+            // Start over with the next input sample, a frame still held by the reader stays protected
+            frameStart = writePos;
+        }
+
+        // Metadata of the input buffer being read, moved to one of its samples. The sample entered the DSP with its buffer
+        stream_meta metaAt(int offset) {
+            stream_meta meta = _in->readMeta;
+            if (!offset) { return meta; }
+            double arrival = meta.arrival;
+            meta.advance(offset);
+            meta.arrival = arrival;
+            return meta;
+        }
+
         void doStart() override {
             workThread = std::thread(&Reshaper<T>::loop, this);
-            bufferWorkerThread = std::thread(&Reshaper<T>::bufferWorker, this);
         }
 
         void loop() {
-            while (run() >= 0)
-                ;
+            while (run() >= 0);
         }
 
         void doStop() override {
             _in->stopReader();
-            ringBuf.stopReader();
             out.stopWriter();
-            ringBuf.stopWriter();
-
-            if (workThread.joinable()) {
-                workThread.join();
-            }
-            if (bufferWorkerThread.joinable()) {
-                bufferWorkerThread.join();
-            }
-
+            if (workThread.joinable()) { workThread.join(); }
             _in->clearReadStop();
-            ringBuf.clearReadStop();
             out.clearWriteStop();
-            ringBuf.clearWriteStop();
-        }
-
-        void bufferWorker() {
-            T* buf = new T[_keep];
-            bool delay = _skip < 0;
-
-            int readCount = std::min<int>(_keep + _skip, _keep);
-            int skip = std::max<int>(_skip, 0);
-            int delaySize = (-_skip) * sizeof(T);
-            int delayCount = (-_skip);
-
-            T* start = &buf[std::max<int>(-_skip, 0)];
-            T* delayStart = &buf[_keep + _skip];
-
-            while (true) {
-                if (delay) {
-                    memmove(buf, delayStart, delaySize);
-                    if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                        for (int i = 0; i < delayCount; i++) {
-                            buf[i].re /= 10.0f;
-                            buf[i].im /= 10.0f;
-                        }
-                    }
-                }
-                if (ringBuf.readAndSkip(start, readCount, skip) < 0) { break; };
-                memcpy(out.writeBuf, buf, _keep * sizeof(T));
-                if (!out.swap(_keep)) { break; }
-            }
-            delete[] buf;
         }
 
         stream<T>* _in;
-        int _outBlockSize;
-        RingBuffer<T> ringBuf;
-        std::thread bufferWorkerThread;
+        MirroredBuffer<T> ring;
         std::thread workThread;
         int _keep, _skip;
+
+        // Positions counted in samples since the start, the ring holding them modulo its size
+        uint64_t writePos = 0;
+        uint64_t frameStart = 0;
+        uint64_t heldStart = 0;
+        bool held = false;
     };
-}
\ No newline at end of file
+}
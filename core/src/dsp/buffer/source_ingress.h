@@ -0,0 +1,188 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include "buffer.h"
+#include "../stream.h"
+#include "../types.h"
+#include "../thread_role.h"
+
+// Default number of raw buffers in the pool, about 150ms of samples at typical transfer sizes
+#define SOURCE_INGRESS_DEFAULT_BUFFERS  32
+
+namespace dsp::buffer {
+    // Decouples a driver callback from the DSP. The callback only copies the raw transfer into a buffer of a
+    // preallocated pool with push(), and a conversion thread converts the queued buffers into the output stream.
+    // A downstream stall then only fills the pool instead of blocking the driver. When the pool is exhausted, the
+    // transfer is dropped and counted as an overflow
+    template <class T>
+    class SourceIngress {
+    public:
+        // Converts count raw values into complex samples and returns the number of samples written
+        typedef std::function<int(const T* in, int count, complex_t* out)> Converter;
+
+        SourceIngress() {}
+
+        SourceIngress(stream<complex_t>* out, Converter converter, int bufferSize, int bufferCount = SOURCE_INGRESS_DEFAULT_BUFFERS) {
+            init(out, converter, bufferSize, bufferCount);
+        }
+
+        ~SourceIngress() {
+            stop();
+            for (auto& buf : buffers) { buffer::free(buf); }
+        }
+
+        // bufferSize is the number of raw values of the largest transfer
+        void init(stream<complex_t>* out, Converter converter, int bufferSize, int bufferCount = SOURCE_INGRESS_DEFAULT_BUFFERS) {
+            // May be called again while stopped to resize the pool
+            for (auto& buf : buffers) { buffer::free(buf); }
+            _out = out;
+            _converter = converter;
+            _bufferSize = bufferSize;
+            buffers.resize(bufferCount);
+            sizes.resize(bufferCount);
+            arrivals.resize(bufferCount);
+            gaps.resize(bufferCount);
+            ready.resize(bufferCount);
+            freeList.reserve(bufferCount);
+            for (int i = 0; i < bufferCount; i++) {
+                buffers[i] = buffer::alloc<T>(bufferSize);
+            }
+            reset();
+        }
+
+        // Samplerate of the source, used to timestamp the first sample of each buffer from its arrival time
+        void setSamplerate(double samplerate) {
+            _samplerate = samplerate;
+        }
+
+        void start() {
+            if (running) { return; }
+            reset();
+            _out->writeMeta = stream_meta();
+            _out->writeMeta.samplerate = _samplerate;
+            stopWorker = false;
+            workerThread = std::thread(&SourceIngress::worker, this);
+            running = true;
+        }
+
+        void stop() {
+            if (!running) { return; }
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                stopWorker = true;
+            }
+            cnd.notify_all();
+            _out->stopWriter();
+            if (workerThread.joinable()) { workerThread.join(); }
+            _out->clearWriteStop();
+            running = false;
+        }
+
+        // Queue a raw transfer, called from the driver callback. Transfers larger than a buffer are split.
+        // Returns false if any of it was dropped because the pool was exhausted
+        bool push(const T* data, int count) {
+            applyThreadRole(THREAD_ROLE_SOURCE);
+            bool ok = true;
+            while (count > 0) {
+                int n = std::min<int>(count, _bufferSize);
+                {
+                    std::lock_guard<std::mutex> lck(mtx);
+                    if (freeList.empty()) {
+                        overflows++;
+                        gapPending = true;
+                        ok = false;
+                        break;
+                    }
+                    int id = freeList.back();
+                    freeList.pop_back();
+                    memcpy(buffers[id], data, n * sizeof(T));
+                    sizes[id] = n;
+                    arrivals[id] = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+                    gaps[id] = gapPending;
+                    gapPending = false;
+                    ready[(readyHead + readyCount) % ready.size()] = id;
+                    readyCount++;
+                }
+                cnd.notify_one();
+                data += n;
+                count -= n;
+            }
+            return ok;
+        }
+
+        // Number of transfers dropped since the last call to start()
+        uint64_t getOverflows() {
+            return overflows;
+        }
+
+        // Number of buffers waiting to be converted
+        int getQueued() {
+            std::lock_guard<std::mutex> lck(mtx);
+            return readyCount;
+        }
+
+    private:
+        void reset() {
+            std::lock_guard<std::mutex> lck(mtx);
+            freeList.clear();
+            for (int i = 0; i < (int)buffers.size(); i++) { freeList.push_back(i); }
+            readyHead = 0;
+            readyCount = 0;
+            overflows = 0;
+            gapPending = false;
+        }
+
+        void worker() {
+            applyThreadRole(THREAD_ROLE_SOURCE);
+            while (true) {
+                // Wait for a buffer
+                int id;
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    cnd.wait(lck, [=]() { return readyCount > 0 || stopWorker; });
+                    if (stopWorker) { return; }
+                    id = ready[readyHead];
+                    readyHead = (readyHead + 1) % ready.size();
+                    readyCount--;
+                }
+
+                // Convert it and give it back to the pool
+                int count = _converter(buffers[id], sizes[id], _out->writeBuf);
+                if (_samplerate > 0.0) { _out->writeMeta.timestamp = arrivals[id] - ((double)count / _samplerate); }
+                _out->writeMeta.discontinuity = gaps[id];
+                {
+                    std::lock_guard<std::mutex> lck(mtx);
+                    freeList.push_back(id);
+                }
+                if (count && !_out->swap(count)) { return; }
+            }
+        }
+
+        stream<complex_t>* _out = NULL;
+        Converter _converter;
+        int _bufferSize = 0;
+        double _samplerate = 0.0;
+
+        std::vector<T*> buffers;
+        std::vector<int> sizes;
+        std::vector<double> arrivals;
+        std::vector<uint8_t> gaps;
+        bool gapPending = false;
+        std::vector<int> freeList;
+        std::vector<int> ready;
+        int readyHead = 0;
+        int readyCount = 0;
+        std::atomic<uint64_t> overflows = 0;
+
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::thread workerThread;
+        bool stopWorker = false;
+        bool running = false;
+    };
+}
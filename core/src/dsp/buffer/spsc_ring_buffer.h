@@ -0,0 +1,179 @@
+#pragma once
+#include "buffer.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <string.h>
+#include <assert.h>
+
+// Capacity of the buffer, rounded up to a power of two, samples above the max latency are never used
+#define SPSC_RING_BUF_SZ    (1 << 20)
+
+// Longest a blocked writer sleeps before checking for room again, in case the reader's wakeup came before the wait
+#define SPSC_RING_BUF_WAKE_TIMEOUT_US   2000
+
+namespace dsp::buffer {
+    // Ring buffer between a single writer and a single reader running in a real-time callback. Reads never block and
+    // never take a lock: what's missing is filled with silence and counted as an underrun. The writer blocks while the
+    // buffer holds the max latency, the reader only waking it up without waiting on it
+    template <class T>
+    class SPSCRingBuffer {
+    public:
+        SPSCRingBuffer() {}
+
+        SPSCRingBuffer(int maxLatency) { init(maxLatency); }
+
+        ~SPSCRingBuffer() {
+            if (!_init) { return; }
+            buffer::free(_buffer);
+            _init = false;
+        }
+
+        void init(int maxLatency) {
+            size = 1;
+            while (size < SPSC_RING_BUF_SZ) { size <<= 1; }
+            mask = size - 1;
+            _buffer = buffer::alloc<T>(size);
+            buffer::clear(_buffer, size);
+            writeCount = 0;
+            readCount = 0;
+            underruns = 0;
+            _stopReader = false;
+            _stopWriter = false;
+            setMaxLatency(maxLatency);
+            _init = true;
+        }
+
+        // Wait-free, returns the number of samples taken from the buffer or -1 if the reader was stopped
+        int read(T* data, int len) {
+            assert(_init);
+            if (_stopReader) {
+                memset(data, 0, len * sizeof(T));
+                return -1;
+            }
+
+            int64_t r = readCount.load(std::memory_order_relaxed);
+            int64_t avail = writeCount.load(std::memory_order_acquire) - r;
+            int count = std::min<int64_t>(avail, len);
+            copyOut(data, r, count);
+            readCount.store(r + count, std::memory_order_release);
+
+            if (count < len) {
+                memset(&data[count], 0, (len - count) * sizeof(T));
+                underruns++;
+            }
+
+            // Waking the writer up doesn't take its lock, a wakeup it misses is made up for by its timeout
+            if (writerWaiting.load()) { writeCnd.notify_one(); }
+            return count;
+        }
+
+        // Blocks until everything was written, returns -1 if the writer was stopped
+        int write(const T* data, int len) {
+            assert(_init);
+            int written = 0;
+            while (written < len) {
+                int space = getWritable();
+                if (space <= 0) {
+                    std::unique_lock<std::mutex> lck(writeMtx);
+                    writerWaiting.store(true);
+                    while (!_stopWriter && (space = getWritable()) <= 0) {
+                        writeCnd.wait_for(lck, std::chrono::microseconds(SPSC_RING_BUF_WAKE_TIMEOUT_US));
+                    }
+                    writerWaiting.store(false);
+                }
+                if (_stopWriter) { return -1; }
+
+                int count = std::min<int>(space, len - written);
+                int64_t w = writeCount.load(std::memory_order_relaxed);
+                copyIn(&data[written], w, count);
+                writeCount.store(w + count, std::memory_order_release);
+                written += count;
+            }
+            return len;
+        }
+
+        int getReadable() {
+            assert(_init);
+            return writeCount.load(std::memory_order_acquire) - readCount.load(std::memory_order_acquire);
+        }
+
+        int getWritable() {
+            assert(_init);
+            return std::max<int>(maxLatency.load(std::memory_order_relaxed) - getReadable(), 0);
+        }
+
+        void stopReader() {
+            assert(_init);
+            _stopReader = true;
+        }
+
+        void stopWriter() {
+            assert(_init);
+            {
+                std::lock_guard<std::mutex> lck(writeMtx);
+                _stopWriter = true;
+            }
+            writeCnd.notify_all();
+        }
+
+        bool getReadStop() {
+            assert(_init);
+            return _stopReader;
+        }
+
+        bool getWriteStop() {
+            assert(_init);
+            return _stopWriter;
+        }
+
+        void clearReadStop() {
+            assert(_init);
+            _stopReader = false;
+        }
+
+        void clearWriteStop() {
+            assert(_init);
+            _stopWriter = false;
+        }
+
+        void setMaxLatency(int maxLatency) {
+            this->maxLatency = std::clamp<int>(maxLatency, 1, size);
+            writeCnd.notify_all();
+        }
+
+        // Number of reads that found fewer samples than asked for
+        uint64_t getUnderruns() { return underruns; }
+
+    private:
+        void copyIn(const T* data, int64_t pos, int count) {
+            int start = pos & mask;
+            int first = std::min<int>(count, size - start);
+            memcpy(&_buffer[start], data, first * sizeof(T));
+            memcpy(&_buffer[0], &data[first], (count - first) * sizeof(T));
+        }
+
+        void copyOut(T* data, int64_t pos, int count) {
+            int start = pos & mask;
+            int first = std::min<int>(count, size - start);
+            memcpy(data, &_buffer[start], first * sizeof(T));
+            memcpy(&data[first], &_buffer[0], (count - first) * sizeof(T));
+        }
+
+        bool _init = false;
+        T* _buffer;
+        int size = 0;
+        int mask = 0;
+        std::atomic<int64_t> writeCount = 0;
+        std::atomic<int64_t> readCount = 0;
+        std::atomic<int> maxLatency = 1;
+        std::atomic<uint64_t> underruns = 0;
+        std::atomic<bool> _stopReader = false;
+        std::atomic<bool> _stopWriter = false;
+        std::atomic<bool> writerWaiting = false;
+        std::mutex writeMtx;
+        std::condition_variable writeCnd;
+    };
+}
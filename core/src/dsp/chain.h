@@ -4,21 +4,141 @@
 #include "processor.h"
 
 namespace dsp {
+    // Runs several blocks back-to-back on its own thread, passing data between them through
+    // two scratch buffers instead of streams. Used by chain in fused mode.
+    template<class T>
+    class ChainRunner : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        ChainRunner() {}
+
+        ~ChainRunner() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(scratch[0]);
+            buffer::free(scratch[1]);
+        }
+
+        void init(stream<T>* in) {
+            scratch[0] = NULL;
+            scratch[1] = NULL;
+            scratchSize = 0;
+            base_type::init(in);
+        }
+
+        void setBlocks(const std::vector<Processor<T, T>*>& blocks) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            this->blocks = blocks;
+            base_type::tempStart();
+        }
+
+        int maxOutputCount(int inputCount) {
+            for (auto& blk : blocks) {
+                inputCount = blk->maxOutputCount(inputCount);
+            }
+            return inputCount;
+        }
+
+        // Every intermediate result goes through either the scratch buffers or the output buffer
+        int outputBufferSize(int inputCount) {
+            int size = inputCount;
+            for (auto& blk : blocks) {
+                size = std::max<int>(size, blk->outputBufferSize(inputCount));
+                inputCount = blk->maxOutputCount(inputCount);
+            }
+            return size;
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            if (blocks.empty()) {
+                memcpy(out, in, count * sizeof(T));
+                return count;
+            }
+
+            // Ping-pong between the scratch buffers, the last block writes directly to the output
+            const T* data = in;
+            int last = blocks.size() - 1;
+            for (int i = 0; i < last; i++) {
+                T* buf = scratch[i & 1];
+                count = blocks[i]->processFused(count, data, buf);
+                data = buf;
+            }
+            return blocks[last]->processFused(count, data, out);
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int bufSize = outputBufferSize(count);
+            base_type::out.reserve(bufSize);
+            if (bufSize > scratchSize) { growScratch(bufSize); }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            stream_meta meta = base_type::_in->readMeta;
+            for (auto& blk : blocks) { meta = blk->fusedMeta(meta); }
+            base_type::out.writeMeta = meta;
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        void growScratch(int size) {
+            for (auto& buf : scratch) {
+                buffer::free(buf);
+                buf = buffer::alloc<T>(size);
+            }
+            scratchSize = size;
+        }
+
+        std::vector<Processor<T, T>*> blocks;
+        T* scratch[2];
+        int scratchSize;
+    };
+
     template<class T>
     class chain {
     public:
         chain() {}
 
-        chain(stream<T>* in) { init(in); }
+        chain(stream<T>* in, bool fused = false) { init(in, fused); }
 
-        void init(stream<T>* in) {
+        // In fused mode, all enabled blocks are run one after the other on a single thread instead
+        // of each running on their own and passing data through streams. Every block must be fusable.
+        void init(stream<T>* in, bool fused = false) {
             _in = in;
             out = _in;
+            _fused = fused;
+            if (_fused) { runner.init(_in); }
+        }
+
+        // Profile the blocks of a fused chain together under the given name, see block::setProfileName()
+        void setProfileName(const std::string& name) {
+            if (_fused) { runner.setProfileName(name); }
+        }
+
+        // Scheduling policy of the thread running a fused chain, see block::setThreadRole()
+        void setThreadRole(ThreadRole role) {
+            if (_fused) { runner.setThreadRole(role); }
         }
 
         template<typename Func>
         void setInput(stream<T>* in, Func onOutputChange) {
             _in = in;
+            if (_fused) {
+                runner.setInput(_in);
+                if (runnerActive) { return; }
+                out = _in;
+                onOutputChange(out);
+                return;
+            }
             for (auto& ln : links) {
                 if (states[ln]) {
                     ln->setInput(_in);
@@ -35,6 +155,14 @@ namespace dsp {
                 throw std::runtime_error("[chain] Tried to add a block that is already part of the chain");
             }
 
+            // Blocks of a fused chain are run by the chain itself
+            if (_fused) {
+                if (!block->fusable()) {
+                    throw std::runtime_error("[chain] Tried to add a block that can't be fused to a fused chain");
+                }
+                block->setHost(&runner);
+            }
+
             // Add to the list
             links.push_back(block);
             states[block] = false;
@@ -56,6 +184,7 @@ namespace dsp {
             // Remove block from the list
             states.erase(block);
             links.erase(std::find(links.begin(), links.end(), block));
+            if (_fused) { block->setHost(NULL); }
         }
 
         template<typename Func>
@@ -68,6 +197,12 @@ namespace dsp {
             // If already enable, don't do anything
             if (states[block]) { return; }
 
+            if (_fused) {
+                states[block] = true;
+                updateRunner(onOutputChange);
+                return;
+            }
+
             // Gather blocks before and after the block to enable
             Processor<T, T>* before = blockBefore(block);
             Processor<T, T>* after = blockAfter(block);
@@ -99,6 +234,12 @@ namespace dsp {
             // If already disabled, don't do anything
             if (!states[block]) { return; }
 
+            if (_fused) {
+                states[block] = false;
+                updateRunner(onOutputChange);
+                return;
+            }
+
             // Stop disabled block
             block->stop();
             states[block] = false;
@@ -143,18 +284,28 @@ namespace dsp {
 
         void start() {
             if (running) { return; }
-            for (auto& ln : links) {
-                if (!states[ln]) { continue; }
-                ln->start();
+            if (_fused) {
+                if (runnerActive) { runner.start(); }
+            }
+            else {
+                for (auto& ln : links) {
+                    if (!states[ln]) { continue; }
+                    ln->start();
+                }
             }
             running = true;
         }
 
         void stop() {
             if (!running) { return; }
-            for (auto& ln : links) {
-                if (!states[ln]) { continue; }
-                ln->stop();
+            if (_fused) {
+                if (runnerActive) { runner.stop(); }
+            }
+            else {
+                for (auto& ln : links) {
+                    if (!states[ln]) { continue; }
+                    ln->stop();
+                }
             }
             running = false;
         }
@@ -162,6 +313,32 @@ namespace dsp {
         stream<T>* out;
 
     private:
+        template<typename Func>
+        void updateRunner(Func onOutputChange) {
+            // Gather the enabled blocks in order
+            std::vector<Processor<T, T>*> enabled;
+            for (auto& ln : links) {
+                if (states[ln]) { enabled.push_back(ln); }
+            }
+            runner.setBlocks(enabled);
+
+            // Bypass the runner entirely if no block is enabled. The reader of the output
+            // must be switched over before the runner starts reading and after it stopped.
+            bool active = !enabled.empty();
+            if (active == runnerActive) { return; }
+            runnerActive = active;
+            if (active) {
+                out = &runner.out;
+                onOutputChange(out);
+                if (running) { runner.start(); }
+            }
+            else {
+                if (running) { runner.stop(); }
+                out = _in;
+                onOutputChange(out);
+            }
+        }
+
         Processor<T, T>* blockBefore(Processor<T, T>* block) {
             // TODO: This is wrong and must be fixed when I get more time
             for (auto& ln : links) {
@@ -191,5 +368,9 @@ namespace dsp {
         std::vector<Processor<T, T>*> links;
         std::map<Processor<T, T>*, bool> states;
         bool running = false;
+
+        bool _fused = false;
+        ChainRunner<T> runner;
+        bool runnerActive = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,339 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include "../sink.h"
+#include "../fft/plan.h"
+#include "../shared_stream.h"
+#include "../taps/low_pass.h"
+
+namespace dsp::channel {
+    // Polyphase filter bank splitting a wideband stream into uniformly spaced subbands.
+    // The band is divided into a power of two number of channels spaced by samplerate/channels,
+    // each channel being output at twice its spacing so that a signal anywhere in the band fits
+    // entirely inside the nearest channel as long as it is narrower than getUsableBandwidth().
+    // Each bound output picks a channel, or -1 to get the full band. Only the channels that are
+    // actually used are extracted and nothing is computed when all outputs use the full band.
+    class Channelizer : public Sink<complex_t> {
+        using base_type = Sink<complex_t>;
+    public:
+        Channelizer() {}
+
+        Channelizer(stream<complex_t>* in, double samplerate, int channels) { init(in, samplerate, channels); }
+
+        ~Channelizer() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            destroy();
+        }
+
+        void init(stream<complex_t>* in, double samplerate, int channels) {
+            _samplerate = samplerate;
+            _channels = channels;
+            base_type::init(in);
+            generate();
+        }
+
+        void setSamplerate(double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _samplerate = samplerate;
+            destroy();
+            generate();
+            base_type::tempStart();
+        }
+
+        // Change the number of channels, all outputs are reset to the full band
+        void setChannels(int channels) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _channels = channels;
+            destroy();
+            generate();
+            for (auto& o : outputs) { o->channel = -1; }
+            base_type::tempStart();
+        }
+
+        void bindOutput(stream<complex_t>* out, int channel = -1) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream isn't already bound
+            if (findOutput(out) != outputs.end()) {
+                throw std::runtime_error("[Channelizer] Tried to bind stream to that is already bound");
+            }
+
+            base_type::tempStop();
+            auto o = std::make_unique<Output>();
+            o->out = out;
+            o->shared = dynamic_cast<shared_stream<complex_t>*>(out);
+            o->channel = channel;
+            outputs.push_back(std::move(o));
+            channelSnapshot.resize(outputs.size());
+            base_type::registerOutput(out);
+            base_type::tempStart();
+        }
+
+        void unbindOutput(stream<complex_t>* out) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream is bound
+            auto it = findOutput(out);
+            if (it == outputs.end()) {
+                throw std::runtime_error("[Channelizer] Tried to unbind stream to that isn't bound");
+            }
+
+            base_type::tempStop();
+            outputs.erase(it);
+            channelSnapshot.resize(outputs.size());
+            base_type::unregisterOutput(out);
+            base_type::tempStart();
+        }
+
+        // Select the channel sent to an output, -1 for the full band. Takes effect on the next block without interrupting the stream
+        void setOutputChannel(stream<complex_t>* out, int channel) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            auto it = findOutput(out);
+            if (it == outputs.end()) {
+                throw std::runtime_error("[Channelizer] Tried to select the channel of a stream that isn't bound");
+            }
+            (*it)->channel = (channel < _channels) ? channel : -1;
+        }
+
+        int getChannels() { return _channels; }
+
+        double getChannelSpacing() { return _samplerate / (double)_channels; }
+
+        double getChannelSamplerate() { return 2.0 * getChannelSpacing(); }
+
+        // Widest signal guaranteed to fit in the channel closest to its center
+        double getUsableBandwidth() { return 0.5 * getChannelSpacing(); }
+
+        // Channel closest to an offset from the center of the band
+        int channelFor(double offset) {
+            int ch = (int)round(offset / getChannelSpacing()) % _channels;
+            return (ch < 0) ? (ch + _channels) : ch;
+        }
+
+        // Offset of the center of a channel from the center of the band
+        double getChannelOffset(int channel) {
+            int ch = (channel >= _channels / 2) ? (channel - _channels) : channel;
+            return (double)ch * getChannelSpacing();
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Take a consistent view of the channel selection for this block
+            bool subbands = false;
+            for (int i = 0; i < outputs.size(); i++) {
+                channelSnapshot[i] = outputs[i]->channel;
+                subbands |= (channelSnapshot[i] >= 0);
+            }
+
+            // Extract the channels
+            int frames = 0;
+            if (subbands) {
+                frames = process(count, base_type::_in->readBuf);
+            }
+            else {
+                skip(count, base_type::_in->readBuf);
+            }
+
+            // Send the channels first and hand the input buffer to the full band outputs
+            for (int i = 0; i < outputs.size(); i++) {
+                Output* o = outputs[i].get();
+                int ch = channelSnapshot[i];
+                if (ch >= 0) {
+                    o->out->writeMeta = base_type::_in->readMeta.rescaled(getChannelSamplerate() / _samplerate);
+                    if (o->out->writeMeta.frequency != 0.0) { o->out->writeMeta.frequency += getChannelOffset(ch); }
+                    if (frames && !o->out->swap(frames)) {
+                        base_type::_in->flush();
+                        return -1;
+                    }
+                }
+                else if (o->shared) {
+                    o->shared->writeMeta = base_type::_in->readMeta;
+                    if (!o->shared->publish(base_type::_in->readBuf, count)) {
+                        base_type::_in->flush();
+                        return -1;
+                    }
+                }
+                else {
+                    o->out->reserve(count);
+                    memcpy(o->out->writeBuf, base_type::_in->readBuf, count * sizeof(complex_t));
+                    o->out->writeMeta = base_type::_in->readMeta;
+                    if (!o->out->swap(count)) {
+                        base_type::_in->flush();
+                        return -1;
+                    }
+                }
+            }
+
+            // The input buffer can only be recycled once every shared reader is done with it
+            for (int i = 0; i < outputs.size(); i++) {
+                Output* o = outputs[i].get();
+                if (channelSnapshot[i] >= 0 || !o->shared) { continue; }
+                if (!o->shared->waitReleased()) {
+                    base_type::_in->flush();
+                    return -1;
+                }
+            }
+
+            base_type::_in->flush();
+            return count;
+        }
+
+    protected:
+        struct Output {
+            stream<complex_t>* out;
+            shared_stream<complex_t>* shared;
+            std::atomic<int> channel;
+        };
+
+        std::vector<std::unique_ptr<Output>>::iterator findOutput(stream<complex_t>* out) {
+            return std::find_if(outputs.begin(), outputs.end(), [out](const std::unique_ptr<Output>& o) { return o->out == out; });
+        }
+
+        void generate() {
+            assert(_channels >= 2 && !(_channels & (_channels - 1)));
+            decimation = _channels / 2;
+
+            // The prototype filter passes 3/4 of the channel spacing on each side and stops before the images
+            // that would fold into the passband at the channel samplerate. It is padded to a multiple of the channel count
+            double spacing = getChannelSpacing();
+            tap<float> proto = taps::lowPass(spacing, spacing * 0.5, _samplerate);
+            tapCount = ((proto.size + _channels - 1) / _channels) * _channels;
+            ptaps = buffer::alloc<float>(tapCount * 2);
+            buffer::clear(ptaps, tapCount * 2);
+
+            // Store the taps reversed and duplicated for the real and imaginary part
+            for (int i = 0; i < proto.size; i++) {
+                ptaps[2 * (tapCount - 1 - i)] = proto.taps[i];
+                ptaps[2 * (tapCount - 1 - i) + 1] = proto.taps[i];
+            }
+            taps::free(proto);
+
+            // Allocate and clear the history, the buffer is grown later if larger blocks come through
+            bufCapacity = base_type::_in ? base_type::_in->getMaxBlockSize() : 0;
+            buffer = buffer::alloc<complex_t>(bufCapacity + tapCount);
+            bufStart = &buffer[tapCount - 1];
+            buffer::clear(buffer, tapCount - 1);
+            offset = 0;
+            phase = 0;
+
+            // Rotation applied to each channel to reference it to the absolute time
+            rotation = buffer::alloc<complex_t>(_channels);
+            for (int i = 0; i < _channels; i++) {
+                double a = -2.0 * DB_M_PI * (double)i / (double)_channels;
+                rotation[i] = { (float)cos(a), (float)sin(a) };
+            }
+
+            fftIn = (complex_t*)fftwf_malloc(_channels * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(_channels * sizeof(complex_t));
+            plan.create(_channels, (fftwf_complex*)fftIn, (fftwf_complex*)fftOut, FFTW_FORWARD);
+        }
+
+        void destroy() {
+            buffer::free(ptaps);
+            buffer::free(buffer);
+            buffer::free(rotation);
+            plan.destroy();
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+        }
+
+        void growBuffer(int count) {
+            // Reallocate the work buffer, keeping the history
+            complex_t* newBuf = buffer::alloc<complex_t>(count + tapCount);
+            memcpy(newBuf, buffer, (tapCount - 1) * sizeof(complex_t));
+            buffer::free(buffer);
+            buffer = newBuf;
+            bufStart = &buffer[tapCount - 1];
+            bufCapacity = count;
+        }
+
+        // Only keep the history up to date when no channel is needed
+        void skip(int count, const complex_t* in) {
+            int frames = (offset < count) ? ((count - offset + decimation - 1) / decimation) : 0;
+            phase = (phase + frames * decimation) % _channels;
+            offset += frames * decimation - count;
+
+            // The new history is the end of the old one followed by the input, only the part of it that is needed is copied
+            int hist = tapCount - 1;
+            if (count >= hist) {
+                memcpy(buffer, &in[count - hist], hist * sizeof(complex_t));
+                return;
+            }
+            memmove(buffer, &buffer[count], (hist - count) * sizeof(complex_t));
+            memcpy(&buffer[hist - count], in, count * sizeof(complex_t));
+        }
+
+        int process(int count, const complex_t* in) {
+            if (count > bufCapacity) { growBuffer(count); }
+            memcpy(bufStart, in, count * sizeof(complex_t));
+
+            // Make room in the outputs
+            int maxFrames = (count / decimation) + 1;
+            for (int i = 0; i < outputs.size(); i++) {
+                if (channelSnapshot[i] >= 0) { outputs[i]->out->reserve(maxFrames); }
+            }
+
+            int frames = 0;
+            float* fold = (float*)fftIn;
+            for (; offset < count; offset += decimation) {
+                // Weight the window by the prototype filter and fold it into one sample per channel
+                const float* x = (const float*)&buffer[offset];
+                int len = 2 * _channels;
+                memset(fold, 0, len * sizeof(float));
+                for (int j = 0; j < 2 * tapCount; j += len) {
+                    const float* xj = &x[j];
+                    const float* hj = &ptaps[j];
+                    for (int k = 0; k < len; k++) { fold[k] += xj[k] * hj[k]; }
+                }
+
+                // The FFT finishes the frequency shift of every channel at once
+                plan.execute();
+
+                // Correct for the position of the window and write the selected channels
+                for (int i = 0; i < outputs.size(); i++) {
+                    int ch = channelSnapshot[i];
+                    if (ch < 0) { continue; }
+                    outputs[i]->out->writeBuf[frames] = fftOut[ch] * rotation[(ch * phase) % _channels];
+                }
+                phase = (phase + decimation) % _channels;
+                frames++;
+            }
+            offset -= count;
+
+            // Move unused data
+            memmove(buffer, &buffer[count], (tapCount - 1) * sizeof(complex_t));
+
+            return frames;
+        }
+
+        double _samplerate;
+        int _channels;
+        int decimation;
+
+        float* ptaps = NULL;
+        int tapCount;
+        complex_t* buffer = NULL;
+        complex_t* bufStart;
+        int bufCapacity;
+        int offset;
+        int phase;
+
+        complex_t* rotation = NULL;
+        complex_t* fftIn = NULL;
+        complex_t* fftOut = NULL;
+        fft::Plan plan;
+
+        std::vector<std::unique_ptr<Output>> outputs;
+        std::vector<int> channelSnapshot;
+    };
+}
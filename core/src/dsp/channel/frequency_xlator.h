@@ -13,6 +13,7 @@ namespace dsp::channel {
         FrequencyXlator(stream<complex_t>* in, double offset, double samplerate) { init(in, offset, samplerate); }
 
         void init(stream<complex_t>* in, double offset) {
+            _offset = offset;
             phase = lv_cmake(1.0f, 0.0f);
             phaseDelta = lv_cmake(cos(offset), sin(offset));
             base_type::init(in);
@@ -25,6 +26,7 @@ namespace dsp::channel {
         void setOffset(double offset) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _offset = offset;
             phaseDelta = lv_cmake(cos(offset), sin(offset));
         }
 
@@ -49,11 +51,27 @@ namespace dsp::channel {
             return count;
         }
 
+        bool fusable() { return true; }
+        int processFused(int count, const complex_t* in, complex_t* out) { return process(count, in, out); }
+
+        // Moving the band up by the offset moves its center frequency down as much
+        stream_meta fusedMeta(const stream_meta& meta) {
+            stream_meta shifted = meta;
+            if (shifted.frequency != 0.0 && shifted.samplerate != 0.0) {
+                shifted.frequency -= _offset * shifted.samplerate / (2.0 * DB_M_PI);
+            }
+            return shifted;
+        }
+
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = fusedMeta(base_type::_in->readMeta);
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -61,6 +79,7 @@ namespace dsp::channel {
         }
 
     protected:
+        double _offset;
         lv_32fc_t phase;
         lv_32fc_t phaseDelta;
     };
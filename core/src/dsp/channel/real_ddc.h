@@ -0,0 +1,243 @@
+#pragma once
+#include "../processor.h"
+#include "../taps/half_band.h"
+#include "frequency_xlator.h"
+
+// Fraction of the output bandwidth kept free of aliases
+#define REAL_DDC_PASSBAND       0.9
+
+// Attenuation of what would alias into the passband, in dB
+#define REAL_DDC_ATTENUATION    90.0
+
+// Number of floats of output computed together, the accumulators staying in registers for the whole filter
+#define REAL_DDC_OUTPUT_BLOCK   32
+
+namespace dsp::channel {
+    // Digital down converter for real 16 bit samples, such as those of a direct sampling ADC. The band is shifted
+    // down by a quarter of the input samplerate and decimated by two with a half-band filter, giving complex
+    // samples at half the input samplerate that hold the whole first Nyquist zone. Mixing by a quarter of the
+    // samplerate only multiplies by 1, -j, -1 and j, so the even samples become the real part and the odd ones the
+    // imaginary part: the symmetric taps of the half-band filter only see the former and its center tap the latter.
+    // Each output then costs one real filter instead of translating and resampling complex samples that are half
+    // zeros. What remains of the offset is translated at the output samplerate, the result being centered on the
+    // offset like a VFO of the same bandwidth given the samples as complex ones with a zero imaginary part
+    class RealDDC : public Processor<int16_t, complex_t> {
+        using base_type = Processor<int16_t, complex_t>;
+    public:
+        RealDDC() {}
+
+        RealDDC(stream<int16_t>* in, double inSamplerate, double offset, float scale = 32768.0f) { init(in, inSamplerate, offset, scale); }
+
+        ~RealDDC() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(even);
+            buffer::free(odd);
+            buffer::free(coefs);
+        }
+
+        void init(stream<int16_t>* in, double inSamplerate, double offset, float scale = 32768.0f) {
+            _inSamplerate = inSamplerate;
+            _offset = offset;
+            _scale = scale;
+
+            // The filter only depends on the ratio of the samplerates
+            tap<float> taps = taps::halfBand(REAL_DDC_PASSBAND / 4.0, 1.0, REAL_DDC_ATTENUATION);
+            pairs = (taps.size + 1) / 4;
+            coefs = buffer::alloc<float>(pairs);
+            for (int j = 0; j < pairs; j++) { coefs[j] = taps.taps[2 * j]; }
+            center = taps.taps[taps.size / 2];
+            taps::free(taps);
+
+            grow(in ? in->getMaxBlockSize() : 0);
+            clearHistory();
+
+            xlator.init(NULL, residual(), _inSamplerate / 2.0);
+            base_type::init(in);
+        }
+
+        void setInSamplerate(double inSamplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _inSamplerate = inSamplerate;
+            xlator.setOffset(residual(), _inSamplerate / 2.0);
+        }
+
+        // Frequency of the input that ends up at the center of the output
+        void setOffset(double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _offset = offset;
+            xlator.setOffset(residual(), _inSamplerate / 2.0);
+        }
+
+        // Value of the integers that corresponds to 1.0
+        void setScale(float scale) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _scale = scale;
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            clearHistory();
+            xlator.reset();
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const int16_t* in, complex_t* out) {
+            split(count, in);
+            int outCount = filter(out);
+            if (residualNeeded) { xlator.process(outCount, out, out); }
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return (inputCount / 2) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // Offset still to be translated once the band was shifted by a quarter of the input samplerate
+        double residual() {
+            double res = _offset - (_inSamplerate / 4.0);
+            residualNeeded = (res != 0.0);
+            return -res;
+        }
+
+        // Mix by a quarter of the samplerate while splitting the input into its even and odd samples, the sign of
+        // both alternating every other pair
+        inline void split(int count, const int16_t* in) {
+            if (count > capacity) { grow(count); }
+            float scale = 1.0f / _scale;
+            int i = 0;
+            for (; i < count && phase; i++) { push(in[i], scale); }
+
+            // Whole groups of four samples, converted and mixed without any branch
+            int groups = (count - i) / 4;
+            float* ev = &even[evenCount];
+            float* od = &odd[oddCount];
+            const int16_t* x = &in[i];
+            for (int g = 0; g < groups; g++) {
+                ev[2 * g] = (float)x[4 * g] * scale;
+                od[2 * g] = -(float)x[4 * g + 1] * scale;
+                ev[2 * g + 1] = -(float)x[4 * g + 2] * scale;
+                od[2 * g + 1] = (float)x[4 * g + 3] * scale;
+            }
+            evenCount += 2 * groups;
+            oddCount += 2 * groups;
+            i += 4 * groups;
+
+            for (; i < count; i++) { push(in[i], scale); }
+        }
+
+        inline void push(int16_t sample, float scale) {
+            float v = (float)sample * scale;
+            switch (phase) {
+            case 0: even[evenCount++] = v; break;
+            case 1: odd[oddCount++] = -v; break;
+            case 2: even[evenCount++] = -v; break;
+            case 3: odd[oddCount++] = v; break;
+            }
+            phase = (phase + 1) & 3;
+        }
+
+        // Compute all the outputs the split samples allow
+        inline int filter(complex_t* out) {
+            // Each output needs 2 * pairs consecutive even samples and the odd one at the center
+            int hist = 2 * pairs - 1;
+            int outCount = std::max<int>(std::min<int>(evenCount - hist, oddCount - (pairs - 1)), 0);
+
+            const float* e = even;
+            const float* o = &odd[pairs - 1];
+            int k = 0;
+            for (; k + REAL_DDC_OUTPUT_BLOCK <= outCount; k += REAL_DDC_OUTPUT_BLOCK) {
+                compute<REAL_DDC_OUTPUT_BLOCK>(&out[k], &e[k], &o[k]);
+            }
+            for (; k < outCount; k++) {
+                compute<1>(&out[k], &e[k], &o[k]);
+            }
+
+            // Keep what the next outputs need
+            memmove(even, &even[outCount], (evenCount - outCount) * sizeof(float));
+            memmove(odd, &odd[outCount], (oddCount - outCount) * sizeof(float));
+            evenCount -= outCount;
+            oddCount -= outCount;
+
+            return outCount;
+        }
+
+        template <int N>
+        inline void compute(complex_t* y, const float* e, const float* o) {
+            float acc[N];
+            for (int l = 0; l < N; l++) { acc[l] = 0.0f; }
+            for (int j = 0; j < pairs; j++) {
+                const float* a = &e[j];
+                const float* b = &e[2 * pairs - 1 - j];
+                float c = coefs[j];
+                for (int l = 0; l < N; l++) { acc[l] += c * (a[l] + b[l]); }
+            }
+            for (int l = 0; l < N; l++) {
+                y[l].re = acc[l];
+                y[l].im = center * o[l];
+            }
+        }
+
+        void grow(int count) {
+            // Room for the history and the even or odd half of a block, the history being kept
+            int size = 2 * pairs + (count / 2) + 1;
+            float* newEven = buffer::alloc<float>(size);
+            float* newOdd = buffer::alloc<float>(size);
+            if (even) {
+                memcpy(newEven, even, std::min<int>(evenCount, size) * sizeof(float));
+                memcpy(newOdd, odd, std::min<int>(oddCount, size) * sizeof(float));
+                buffer::free(even);
+                buffer::free(odd);
+            }
+            even = newEven;
+            odd = newOdd;
+            capacity = count;
+        }
+
+        void clearHistory() {
+            // Same history of zeros as a FIR filter of the same length
+            evenCount = 2 * pairs - 1;
+            oddCount = 2 * pairs - 1;
+            phase = 0;
+            buffer::clear(even, evenCount);
+            buffer::clear(odd, oddCount);
+        }
+
+        double _inSamplerate;
+        double _offset;
+        float _scale;
+        bool residualNeeded = false;
+        FrequencyXlator xlator;
+
+        float* coefs = NULL;
+        float center = 0.0f;
+        int pairs = 0;
+
+        float* even = NULL;
+        float* odd = NULL;
+        int evenCount = 0;
+        int oddCount = 0;
+        int phase = 0;
+        int capacity = 0;
+    };
+}
@@ -1,6 +1,22 @@
 #pragma once
 #include "frequency_xlator.h"
+#include "channelizer.h"
+#include "../taps/cache.h"
 #include "../multirate/rational_resampler.h"
+#include "../fft/spectrum.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+// Number of samples translated at a time, small enough for them to still be in cache when the resampler reads them
+#define RX_VFO_CHUNK_SIZE   2048
+
+// Milliseconds between two updates of the filter when the bandwidth changes, the changes in between being merged
+#define RX_VFO_FILTER_UPDATE_INTERVAL   25
+
+// Milliseconds during which the output fades from the previous filter to the new one
+#define RX_VFO_FILTER_FADE              5
 
 namespace dsp::channel {
     class RxVFO : public Processor<complex_t, complex_t> {
@@ -12,8 +28,16 @@ namespace dsp::channel {
 
         ~RxVFO() {
             if (!base_type::_block_init) { return; }
+            {
+                std::lock_guard<std::mutex> lck(designMtx);
+                designStop = true;
+            }
+            designCond.notify_all();
+            if (designThread.joinable()) { designThread.join(); }
             base_type::stop();
-            taps::free(ftaps);
+            taps::cache::release(ftaps);
+            taps::cache::release(fadingTaps);
+            buffer::free(chunk);
         }
 
         void init(stream<complex_t>* in, double inSamplerate, double outSamplerate, double bandwidth, double offset) {
@@ -21,116 +45,331 @@ namespace dsp::channel {
             _outSamplerate = outSamplerate;
             _bandwidth = bandwidth;
             _offset = offset;
-            filterNeeded = (_bandwidth != _outSamplerate);
+            filterNeeded = filterEnabled && (_bandwidth != _outSamplerate);
             ftaps.taps = NULL;
+            fadingTaps.taps = NULL;
+            channelizer = NULL;
+            channel = -1;
+            chanSamplerate = _inSamplerate;
+            spectrum = NULL;
+            chunk = buffer::alloc<complex_t>(RX_VFO_CHUNK_SIZE);
 
             xlator.init(NULL, -_offset, _inSamplerate);
             resamp.init(NULL, _inSamplerate, _outSamplerate);
-            generateTaps();
+            resamp.setCICAllowed(true);
+            ftaps = designTaps(_bandwidth, _outSamplerate);
             filter.init(NULL, ftaps);
 
+            designStop = false;
+            designThread = std::thread(&RxVFO::designWorker, this);
             base_type::init(in);
         }
 
         void setInSamplerate(double inSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
             _inSamplerate = inSamplerate;
-            xlator.setOffset(-_offset, _inSamplerate);
-            resamp.setInSamplerate(_inSamplerate);
-            base_type::tempStart();
+            route(true);
         }
 
+        // The filter is updated right away, without fading since the output changes anyway
         void setOutSamplerate(double outSamplerate, double bandwidth) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _outSamplerate = outSamplerate;
-            _bandwidth = bandwidth;
-            filterNeeded = (_bandwidth != _outSamplerate);
-            resamp.setOutSamplerate(_outSamplerate);
-            if (filterNeeded) {
-                generateTaps();
-                filter.setTaps(ftaps);
+            std::lock_guard<std::mutex> lck2(applyMtx);
+            std::lock_guard<std::mutex> lck3(base_type::paramMtx);
+            bool enabled;
+            {
+                std::lock_guard<std::mutex> lck4(designMtx);
+                _outSamplerate = outSamplerate;
+                _bandwidth = bandwidth;
+                enabled = filterEnabled;
             }
-            base_type::tempStart();
+            resamp.setOutSamplerate(_outSamplerate);
+            route();
+            updateFilter(enabled, bandwidth, outSamplerate, false);
         }
 
+        // Changes are only recorded, the filter is designed by a worker thread at most every
+        // RX_VFO_FILTER_UPDATE_INTERVAL and crossfaded in, so that dragging the bandwidth only designs the filters
+        // that can be heard
         void setBandwidth(double bandwidth) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            std::lock_guard<std::mutex> lck2(filterMtx);
-            _bandwidth = bandwidth;
-            filterNeeded = (_bandwidth != _outSamplerate);
-            if (filterNeeded) {
-                generateTaps();
-                filter.setTaps(ftaps);
+            {
+                std::lock_guard<std::mutex> lck(designMtx);
+                _bandwidth = bandwidth;
+                designPending = true;
+            }
+            designCond.notify_all();
+        }
+
+        // Leave the bandwidth to the block using the output, which then receives the full band of the output
+        // samplerate. Applied like bandwidth changes
+        void setFilterEnabled(bool enabled) {
+            assert(base_type::_block_init);
+            {
+                std::lock_guard<std::mutex> lck(designMtx);
+                filterEnabled = enabled;
+                designPending = true;
             }
+            designCond.notify_all();
         }
 
         void setOffset(double offset) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
             _offset = offset;
-            xlator.setOffset(-_offset, _inSamplerate);
+            route();
+        }
+
+        // Take the input from a channelizer instead of the full band. The input stream must be bound to it,
+        // the VFO then selects the channel that contains it and follows it when retuned. NULL to go back to the full band
+        void setChannelizer(Channelizer* channelizer) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+            this->channelizer = channelizer;
+            route(true);
+        }
+
+        // While inactive, the input is drained without any processing and nothing is output, so that the blocks
+        // downstream sleep. Processing resumes on the next buffer, flagged as a discontinuity
+        void setActive(bool active) {
+            _active = active;
+        }
+
+        bool isActive() {
+            return _active;
+        }
+
+        // Feed the output to a spectrum, NULL to stop. The spectrum must be at the output samplerate
+        void setSpectrum(fft::Spectrum* spectrum) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::mutex> lck(spectrumMtx);
+            this->spectrum = spectrum;
+        }
+
+        // Channel of the channelizer currently used, -1 if the VFO is processing the full band
+        int getChannel() {
+            return channel;
         }
 
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
             xlator.reset();
             resamp.reset();
             filter.reset();
-            base_type::tempStart();
         }
 
+        // Translate the input a chunk at a time, each chunk going through the resampler right away. The samples at the
+        // input rate are then only read once from memory instead of being written out whole and read back. Can't be
+        // done in place
         inline int process(int count, const complex_t* in, complex_t* out) {
-            xlator.process(count, in, out);
-            if (!filterNeeded) {
-                return resamp.process(count, out, out);
-            }
-            count = resamp.process(count, out, out);
-            {
-                std::lock_guard<std::mutex> lck(filterMtx);
-                filter.process(count, out, out);
+            int outCount = translate(count, in, out);
+            if (filterNeeded) {
+                filter.process(outCount, out, out);
             }
-            return count;
+            return outCount;
         }
 
+        int maxOutputCount(int inputCount) { return resamp.maxOutputCount(inputCount); }
+
+        // The resampler can store the intermediate results of a chunk in the output buffer
+        int outputBufferSize(int inputCount) { return std::max<int>(inputCount, resamp.outputBufferSize(inputCount)); }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            if (!_active) {
+                base_type::_in->flush();
+                idled = true;
+                return 0;
+            }
 
-            int outCount = process(count, base_type::_in->readBuf, out.writeBuf);
+            // Samplerate and channel changes land between two buffers
+            int outCount;
+            {
+                std::lock_guard<std::mutex> lck(base_type::paramMtx);
+                base_type::out.reserve(outputBufferSize(count));
+                outCount = process(count, base_type::_in->readBuf, out.writeBuf);
+                setOutputMeta(base_type::_in->readMeta);
+            }
 
-            // Swap if some data was generated
             base_type::_in->flush();
-            if (outCount) {
-                if (!out.swap(outCount)) { return -1; }
+            return send(outCount) ? outCount : -1;
+        }
+
+        // Processing of the VFO by a VFOGroup, instead of run(), the input it was given being left unused. Returns false
+        // if the VFO skips the buffer, being stopped or inactive. Otherwise the whole buffer must be given to
+        // processShared() in order and endShared() called, paramMtx being held until then
+        bool beginShared(int count) {
+            if (!base_type::running) { return false; }
+            if (!_active) {
+                idled = true;
+                return false;
             }
-            return outCount;
+            base_type::paramMtx.lock();
+            base_type::out.reserve(outputBufferSize(count));
+            sharedCount = 0;
+            return true;
+        }
+
+        // Parts must be multiples of RX_VFO_CHUNK_SIZE but for the last one, for the output to be the same as run()
+        inline void processShared(int count, const complex_t* in) {
+            sharedCount += translate(count, in, &out.writeBuf[sharedCount]);
+        }
+
+        // Send the output of the buffer, returns false if the output was stopped
+        bool endShared(const stream_meta& meta) {
+            int outCount = sharedCount;
+            if (filterNeeded) {
+                filter.process(outCount, out.writeBuf, out.writeBuf);
+            }
+            setOutputMeta(meta);
+            base_type::paramMtx.unlock();
+            return send(outCount);
         }
 
     protected:
-        void generateTaps() {
-            taps::free(ftaps);
-            double filterWidth = _bandwidth / 2.0;
-            ftaps = taps::lowPass(filterWidth, filterWidth * 0.1, _outSamplerate);
+        inline int translate(int count, const complex_t* in, complex_t* out) {
+            int outCount = 0;
+            for (int i = 0; i < count; i += RX_VFO_CHUNK_SIZE) {
+                int n = std::min<int>(count - i, RX_VFO_CHUNK_SIZE);
+                xlator.process(n, &in[i], chunk);
+                outCount += resamp.process(n, chunk, &out[outCount]);
+            }
+            return outCount;
+        }
+
+        // Must be called with paramMtx locked
+        inline void setOutputMeta(const stream_meta& meta) {
+            out.writeMeta = meta.rescaled(_outSamplerate / chanSamplerate);
+            if (out.writeMeta.frequency != 0.0) { out.writeMeta.frequency += residual; }
+        }
+
+        bool send(int outCount) {
+            if (idled) {
+                out.writeMeta.discontinuity = true;
+                idled = false;
+            }
+            {
+                std::lock_guard<std::mutex> lck(spectrumMtx);
+                if (spectrum) { spectrum->feed(out.writeBuf, outCount); }
+            }
+
+            // Swap if some data was generated
+            if (outCount) { return out.swap(outCount); }
+            return true;
+        }
+
+        // Select the input of the VFO and tune to the right offset within it. Must be called with paramMtx locked, the
+        // worker reading the residual and the xlator under it
+        void route(bool force = false) {
+            int newChannel = -1;
+            if (channelizer && _outSamplerate <= channelizer->getUsableBandwidth()) {
+                newChannel = channelizer->channelFor(_offset);
+            }
+            double samplerate = (newChannel >= 0) ? channelizer->getChannelSamplerate() : _inSamplerate;
+            residual = (newChannel >= 0) ? (_offset - channelizer->getChannelOffset(newChannel)) : _offset;
+
+            // Switch channel
+            if (channelizer && (newChannel != channel || force)) {
+                channelizer->setOutputChannel(base_type::_in, newChannel);
+            }
+            channel = newChannel;
+
+            xlator.setOffset(-residual, samplerate);
+            if (samplerate != chanSamplerate || force) {
+                chanSamplerate = samplerate;
+                resamp.setInSamplerate(chanSamplerate);
+            }
+        }
+
+        static tap<float> designTaps(double bandwidth, double outSamplerate) {
+            double filterWidth = bandwidth / 2.0;
+            return taps::cache::lowPass(filterWidth, filterWidth * 0.1, outSamplerate);
+        }
+
+        // Must be called with applyMtx locked. The taps faded out stay in use until the next update
+        void updateFilter(bool enabled, double bandwidth, double outSamplerate, bool fade) {
+            bool needed = enabled && (bandwidth != outSamplerate);
+            if (needed) {
+                tap<float> newTaps = designTaps(bandwidth, outSamplerate);
+                int fadeLength = (fade && filterNeeded) ? (int)(outSamplerate * RX_VFO_FILTER_FADE / 1000.0) : 0;
+                filter.setTaps(newTaps, fadeLength);
+                taps::cache::release(fadingTaps);
+                fadingTaps = ftaps;
+                ftaps = newTaps;
+            }
+            filterNeeded = needed;
+        }
+
+        void designWorker() {
+            std::unique_lock<std::mutex> lck(designMtx);
+            auto lastUpdate = std::chrono::steady_clock::now() - std::chrono::milliseconds(RX_VFO_FILTER_UPDATE_INTERVAL);
+            while (true) {
+                designCond.wait(lck, [this]() { return designPending || designStop; });
+
+                // Wait out the interval, changes made meanwhile are merged into this update
+                auto due = lastUpdate + std::chrono::milliseconds(RX_VFO_FILTER_UPDATE_INTERVAL);
+                if (designCond.wait_until(lck, due, [this]() { return designStop; })) { return; }
+                designPending = false;
+                lck.unlock();
+
+                // The parameters are read while holding applyMtx so that a new output samplerate isn't overwritten
+                {
+                    std::lock_guard<std::mutex> alck(applyMtx);
+                    bool enabled;
+                    double bandwidth, outSamplerate;
+                    {
+                        std::lock_guard<std::mutex> dlck(designMtx);
+                        enabled = filterEnabled;
+                        bandwidth = _bandwidth;
+                        outSamplerate = _outSamplerate;
+                    }
+                    updateFilter(enabled, bandwidth, outSamplerate, true);
+                }
+                lastUpdate = std::chrono::steady_clock::now();
+                lck.lock();
+            }
         }
 
         FrequencyXlator xlator;
+        complex_t* chunk;
         multirate::RationalResampler<complex_t> resamp;
         filter::FIR<complex_t, float> filter;
         tap<float> ftaps;
-        bool filterNeeded;
+        tap<float> fadingTaps;
+        std::atomic<bool> filterNeeded;
+        bool filterEnabled = true;
 
         double _inSamplerate;
         double _outSamplerate;
         double _bandwidth;
         double _offset;
 
-        std::mutex filterMtx;
+        Channelizer* channelizer;
+        int channel;
+        double chanSamplerate;
+        double residual = 0.0;      // Offset of the VFO from the center of its input
+
+        // designMtx guards the bandwidth and the filter switch, applyMtx is held while updating the filter
+        std::mutex designMtx;
+        std::mutex applyMtx;
+        std::condition_variable designCond;
+        bool designPending = false;
+        bool designStop = false;
+        std::thread designThread;
+
+        fft::Spectrum* spectrum;
+        std::mutex spectrumMtx;
+
+        std::atomic<bool> _active = true;
+        bool idled = false;
+        int sharedCount = 0;
     };
 }
\ No newline at end of file
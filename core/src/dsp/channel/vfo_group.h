@@ -0,0 +1,95 @@
+#pragma once
+#include "../sink.h"
+#include "rx_vfo.h"
+
+// Samples of input processed by every VFO of a group before moving on to the next ones, small enough for them to
+// stay in the L2 cache meanwhile. Must be a multiple of RX_VFO_CHUNK_SIZE for the VFOs to output what they would alone
+#define VFO_GROUP_CHUNK_SIZE    (8 * RX_VFO_CHUNK_SIZE)
+
+namespace dsp::channel {
+    // Runs several VFOs on the same input from a single thread. Each VFO running on its own reads the whole buffer
+    // from memory, the group instead goes over it a chunk at a time, each chunk being processed by all the VFOs while
+    // it's in cache. This trades the parallelism of the VFOs for memory bandwidth, which is what runs out first with
+    // many VFOs on a wide band. The VFOs are hosted by the group, the input they were given going unused, and can be
+    // started, stopped and configured as usual
+    class VFOGroup : public Sink<complex_t> {
+        using base_type = Sink<complex_t>;
+    public:
+        VFOGroup() {}
+
+        VFOGroup(stream<complex_t>* in) { init(in); }
+
+        ~VFOGroup() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            std::vector<RxVFO*> remaining = vfos;
+            for (auto& vfo : remaining) { removeVFO(vfo); }
+        }
+
+        void addVFO(RxVFO* vfo) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            if (std::find(vfos.begin(), vfos.end(), vfo) != vfos.end()) {
+                throw std::runtime_error("[VFOGroup] Tried to add a VFO that is already part of the group");
+            }
+            base_type::tempStop();
+            vfo->setHost(this);
+            vfos.push_back(vfo);
+
+            // Stopping the group must release it when waiting on the output of a VFO. The buffers stay accounted
+            // under the VFO
+            base_type::outputs.push_back(&vfo->out);
+            base_type::tempStart();
+        }
+
+        // The VFO runs on its own again if it's running
+        void removeVFO(RxVFO* vfo) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            auto it = std::find(vfos.begin(), vfos.end(), vfo);
+            if (it == vfos.end()) {
+                throw std::runtime_error("[VFOGroup] Tried to remove a VFO that isn't part of the group");
+            }
+            base_type::tempStop();
+            vfos.erase(it);
+            base_type::unregisterOutput(&vfo->out);
+            vfo->setHost(NULL);
+            base_type::tempStart();
+        }
+
+        int getVFOCount() {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return vfos.size();
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // VFOs that are stopped or inactive skip the buffer
+            active.clear();
+            for (auto& vfo : vfos) {
+                if (vfo->beginShared(count)) { active.push_back(vfo); }
+            }
+
+            const complex_t* in = base_type::_in->readBuf;
+            for (int i = 0; i < count; i += VFO_GROUP_CHUNK_SIZE) {
+                int n = std::min<int>(count - i, VFO_GROUP_CHUNK_SIZE);
+                for (auto& vfo : active) { vfo->processShared(n, &in[i]); }
+            }
+
+            // Every VFO must be ended to release it, even once one of the outputs was stopped
+            bool ok = true;
+            for (auto& vfo : active) {
+                if (!vfo->endShared(base_type::_in->readMeta)) { ok = false; }
+            }
+
+            base_type::_in->flush();
+            return ok ? count : -1;
+        }
+
+    protected:
+        std::vector<RxVFO*> vfos;
+        std::vector<RxVFO*> active;
+    };
+}
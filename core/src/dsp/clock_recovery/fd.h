@@ -154,6 +154,7 @@ namespace dsp::clock_recovery {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / _omega);
 
             // Swap if some data was generated
             base_type::_in->flush();
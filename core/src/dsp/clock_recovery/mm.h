@@ -5,6 +5,10 @@
 #include "../multirate/polyphase_bank.h"
 #include "../math/step.h"
 
+// Interpolator length with a dedicated implementation, the taps of each phase then being kept in a table where the
+// dot product is done with fixed size loops the compiler vectorizes, instead of calling volk for 8 taps per symbol
+#define MM_FAST_INTERP_TAP_COUNT    8
+
 namespace dsp::clock_recovery {
     template<class T>
     class MM : public Processor<T, T> {
@@ -18,6 +22,7 @@ namespace dsp::clock_recovery {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             dsp::multirate::freePolyphaseBank(interpBank);
+            buffer::free(interpTable);
             buffer::free(buffer);
         }
 
@@ -31,8 +36,7 @@ namespace dsp::clock_recovery {
 
             pcl.init(_muGain, _omegaGain, 0.0, 0.0, 1.0, _omega, _omega * (1.0 - omegaRelLimit), _omega * (1.0 + omegaRelLimit));
             generateInterpTaps();
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + _interpTapCount);
-            bufStart = &buffer[_interpTapCount - 1];
+            allocBuffer();
         
             base_type::init(in);
         }
@@ -77,10 +81,10 @@ namespace dsp::clock_recovery {
             _interpPhaseCount = interpPhaseCount;
             _interpTapCount = interpTapCount;
             dsp::multirate::freePolyphaseBank(interpBank);
+            buffer::free(interpTable);
             buffer::free(buffer);
             generateInterpTaps();
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + _interpTapCount);
-            bufStart = &buffer[_interpTapCount - 1];
+            allocBuffer();
             base_type::tempStart();
         }
 
@@ -98,8 +102,37 @@ namespace dsp::clock_recovery {
         }
 
         inline int process(int count, const T* in, T* out) {
-            // Copy data to work buffer
-            memcpy(bufStart, in, count * sizeof(T));
+            if (_interpTapCount == MM_FAST_INTERP_TAP_COUNT) { return processInternal<true>(count, in, out); }
+            return processInternal<false>(count, in, out);
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / _omega);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // Components per sample when handled as an array of floats
+        static constexpr int COMPONENTS = std::is_same_v<T, float> ? 1 : 2;
+
+        template <bool FAST>
+        inline int processInternal(int count, const T* in, T* out) {
+            int hist = _interpTapCount - 1;
+
+            // Only the symbols overlapping the history are interpolated from the work buffer, which then just needs the
+            // start of the input. When there are less samples than the history, all of them go to the work buffer
+            bool direct = (count >= hist);
+            memcpy(bufStart, in, (direct ? hist : count) * sizeof(T));
 
             // Process all samples
             int outCount = 0;
@@ -109,11 +142,17 @@ namespace dsp::clock_recovery {
 
                 // Calculate new output value
                 int phase = std::clamp<int>(floorf(pcl.phase * (float)_interpPhaseCount), 0, _interpPhaseCount - 1);
-                if constexpr (std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&outVal, &buffer[offset], interpBank.phases[phase], _interpTapCount);
+                const T* x = (direct && offset >= hist) ? &in[offset - hist] : &buffer[offset];
+                if constexpr (FAST) {
+                    outVal = interpolate(x, &interpTable[phase * MM_FAST_INTERP_TAP_COUNT * COMPONENTS]);
                 }
-                if constexpr (std::is_same_v<T, complex_t>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&outVal, (lv_32fc_t*)&buffer[offset], interpBank.phases[phase], _interpTapCount);
+                else {
+                    if constexpr (std::is_same_v<T, float>) {
+                        volk_32f_x2_dot_prod_32f(&outVal, x, interpBank.phases[phase], _interpTapCount);
+                    }
+                    if constexpr (std::is_same_v<T, complex_t>) {
+                        volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&outVal, (lv_32fc_t*)x, interpBank.phases[phase], _interpTapCount);
+                    }
                 }
                 out[outCount++] = outVal;
 
@@ -138,8 +177,7 @@ namespace dsp::clock_recovery {
                 }
 
                 // Clamp symbol phase error
-                if (error > 1.0f) { error = 1.0f; }
-                if (error < -1.0f) { error = -1.0f; }
+                error = std::clamp<float>(error, -1.0f, 1.0f);
 
                 // Advance symbol offset and phase
                 pcl.advance(error);
@@ -150,34 +188,60 @@ namespace dsp::clock_recovery {
             offset -= count;
 
             // Update delay buffer
-            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(T));
+            if (direct) {
+                memcpy(buffer, &in[count - hist], hist * sizeof(T));
+            }
+            else {
+                memmove(buffer, &buffer[count], hist * sizeof(T));
+            }
 
             return outCount;
         }
 
-        int run() {
-            int count = base_type::_in->read();
-            if (count < 0) { return -1; }
-
-            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
-
-            // Swap if some data was generated
-            base_type::_in->flush();
-            if (outCount) {
-                if (!base_type::out.swap(outCount)) { return -1; }
+        // Dot product of the fast interpolator, with the taps duplicated for both components of complex samples
+        static inline T interpolate(const T* in, const float* taps) {
+            constexpr int LEN = MM_FAST_INTERP_TAP_COUNT * COMPONENTS;
+            const float* x = (const float*)in;
+            float acc[LEN];
+            for (int i = 0; i < LEN; i++) { acc[i] = x[i] * taps[i]; }
+            if constexpr (std::is_same_v<T, float>) {
+                return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+            }
+            if constexpr (std::is_same_v<T, complex_t>) {
+                float re = 0.0f, im = 0.0f;
+                for (int i = 0; i < LEN; i += 2) {
+                    re += acc[i];
+                    im += acc[i + 1];
+                }
+                return { re, im };
             }
-            return outCount;
         }
 
-    protected:
         void generateInterpTaps() {
             double bw = 0.5 / (double)_interpPhaseCount;
             dsp::tap<float> lp = dsp::taps::windowedSinc<float>(_interpPhaseCount * _interpTapCount, dsp::math::hzToRads(bw, 1.0), dsp::window::nuttall, _interpPhaseCount);
             interpBank = dsp::multirate::buildPolyphaseBank<float>(_interpPhaseCount, lp);
             taps::free(lp);
+
+            // Table of the phases one after the other, for the fast interpolator
+            interpTable = NULL;
+            if (_interpTapCount != MM_FAST_INTERP_TAP_COUNT) { return; }
+            int stride = MM_FAST_INTERP_TAP_COUNT * COMPONENTS;
+            interpTable = buffer::alloc<float>(_interpPhaseCount * stride);
+            for (int i = 0; i < _interpPhaseCount * stride; i++) {
+                interpTable[i] = interpBank.phases[i / stride][(i % stride) / COMPONENTS];
+            }
+        }
+
+        // The work buffer holds the history followed by as many input samples
+        void allocBuffer() {
+            buffer = buffer::alloc<T>(2 * _interpTapCount);
+            buffer::clear<T>(buffer, 2 * _interpTapCount);
+            bufStart = &buffer[_interpTapCount - 1];
         }
 
         dsp::multirate::PolyphaseBank<float> interpBank;
+        float* interpTable = NULL;
         loop::PhaseControlLoop<float, false> pcl;
 
         double _omega;
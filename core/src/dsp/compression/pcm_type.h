@@ -1,9 +1,17 @@
 #pragma once
 
+// Number of complex samples sharing an exponent in block floating point samples
+#define PCM_BFP_BLOCK_SIZE  64
+
+// Size in bytes of a full block floating point block, its exponent followed by one byte per component
+#define PCM_BFP8_BLOCK_BYTES    (1 + (PCM_BFP_BLOCK_SIZE * 2))
+
 namespace dsp::compression {
     enum PCMType {
         PCM_TYPE_I8,
         PCM_TYPE_I16,
-        PCM_TYPE_F32
+        PCM_TYPE_F32,
+        PCM_TYPE_BFP8,
+        _PCM_TYPE_COUNT
     };
 }
\ No newline at end of file
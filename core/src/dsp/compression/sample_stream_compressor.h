@@ -1,6 +1,7 @@
 #pragma once
 #include "../processor.h"
 #include "pcm_type.h"
+#include <math.h>
 
 namespace dsp::compression {
     class SampleStreamCompressor : public Processor<complex_t, uint8_t> {
@@ -44,10 +45,16 @@ namespace dsp::compression {
                 return 8 + (count * sizeof(complex_t));
             }
 
-            // Find maximum value
+            // Block floating point, each block is scaled to its own peak
+            if (pcmType == PCMType::PCM_TYPE_BFP8) {
+                *scaler = 0;
+                return 8 + encodeBFP8(count, in, (uint8_t*)dataBuf);
+            }
+
+            // Find the largest magnitude, which bounds both components of all samples
             uint32_t maxIdx;
-            volk_32f_index_max_32u(&maxIdx, (float*)in, count * 2);
-            float maxVal = ((float*)in)[maxIdx];
+            volk_32fc_index_max_32u(&maxIdx, (lv_32fc_t*)in, count);
+            float maxVal = std::max<float>(sqrtf((in[maxIdx].re * in[maxIdx].re) + (in[maxIdx].im * in[maxIdx].im)), 1e-30f);
             *scaler = maxVal;
 
             // Convert to the right type and send it out (sign bit determines pcm type)
@@ -63,6 +70,34 @@ namespace dsp::compression {
             return count;
         }
 
+        // Each block is stored as the exponent of its largest component followed by the components as 8 bit mantissas,
+        // component c being mantissa * 2^(exponent - 7)
+        inline static int encodeBFP8(int count, const complex_t* in, uint8_t* out) {
+            const float* comps = (const float*)in;
+            uint8_t* start = out;
+            for (int i = 0; i < count; i += PCM_BFP_BLOCK_SIZE) {
+                int n = std::min<int>(PCM_BFP_BLOCK_SIZE, count - i) * 2;
+                const float* block = &comps[i * 2];
+
+                // Find the exponent of the block
+                float peak = 0.0f;
+                for (int j = 0; j < n; j++) { peak = std::max<float>(peak, fabsf(block[j])); }
+                int exp = 0;
+                frexpf(peak, &exp);
+                exp = std::clamp<int>(exp, -127, 127);
+                *(out++) = (uint8_t)(int8_t)exp;
+
+                // Quantize the components
+                float scale = ldexpf(1.0f, 7 - exp);
+                int8_t* mant = (int8_t*)out;
+                for (int j = 0; j < n; j++) {
+                    mant[j] = (int8_t)std::clamp<float>(roundf(block[j] * scale), -127.0f, 127.0f);
+                }
+                out += n;
+            }
+            return out - start;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
@@ -1,6 +1,7 @@
 #pragma once
 #include "../processor.h"
 #include "pcm_type.h"
+#include <math.h>
 
 namespace dsp::compression {
     class SampleStreamDecompressor : public Processor<uint8_t, complex_t> {
@@ -10,7 +11,7 @@ namespace dsp::compression {
 
         SampleStreamDecompressor(stream<uint8_t>* in) { base_type::init(in); }
 
-        inline int process(int count, const uint8_t* in, complex_t* out) {
+        inline static int process(int count, const uint8_t* in, complex_t* out) {
             uint16_t sampleType = *(uint16_t*)&in[2];
             float scaler = *(float*)&in[4];
             const void* dataBuf = &in[8];
@@ -29,10 +30,49 @@ namespace dsp::compression {
                 volk_8i_s32f_convert_32f((float*)out, (int8_t*)dataBuf, 128.0f / scaler, outCount * 2);
                 return outCount;
             }
-            
+            else if (sampleType == PCMType::PCM_TYPE_BFP8) {
+                return decodeBFP8(count - 8, (const uint8_t*)dataBuf, out);
+            }
+
             return 0;
         }
 
+        // Number of samples held by a compressed buffer of count bytes
+        inline static int sampleCount(int count, const uint8_t* in) {
+            if (count < 8) { return 0; }
+            uint16_t sampleType = *(uint16_t*)&in[2];
+            int size = count - 8;
+            switch (sampleType) {
+            case PCMType::PCM_TYPE_F32:
+                return size / sizeof(complex_t);
+            case PCMType::PCM_TYPE_I16:
+                return size / (sizeof(int16_t) * 2);
+            case PCMType::PCM_TYPE_I8:
+                return size / (sizeof(int8_t) * 2);
+            case PCMType::PCM_TYPE_BFP8:
+                return ((size / PCM_BFP8_BLOCK_BYTES) * PCM_BFP_BLOCK_SIZE) + std::max<int>((size % PCM_BFP8_BLOCK_BYTES) - 1, 0) / 2;
+            default:
+                return 0;
+            }
+        }
+
+        inline static int decodeBFP8(int size, const uint8_t* in, complex_t* out) {
+            float* comps = (float*)out;
+            int outCount = 0;
+            while (size >= 3) {
+                // Exponent of the block followed by its components, the last block may be partial
+                int n = (std::min<int>(PCM_BFP8_BLOCK_BYTES, size) - 1) & ~1;
+                float scale = ldexpf(1.0f, (int)(int8_t)in[0] - 7);
+                const int8_t* mant = (const int8_t*)&in[1];
+                for (int j = 0; j < n; j++) { comps[j] = (float)mant[j] * scale; }
+                comps += n;
+                outCount += n / 2;
+                in += n + 1;
+                size -= n + 1;
+            }
+            return outCount;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
@@ -11,11 +11,15 @@ namespace dsp::convert {
 
         void init(stream<complex_t>* in) { base_type::init(in); }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             memcpy(base_type::out.writeBuf, base_type::_in->readBuf, count * sizeof(complex_t));
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
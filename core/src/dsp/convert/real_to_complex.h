@@ -26,11 +26,15 @@ namespace dsp::convert {
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
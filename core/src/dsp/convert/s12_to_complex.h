@@ -0,0 +1,72 @@
+#pragma once
+#include "../processor.h"
+
+namespace dsp::convert {
+    // Packed signed 12 bit IQ to complex. Each complex sample takes 3 bytes, I being the low 12 bits and Q the high
+    // 12 bits of the little endian 24 bit word. The sign extension and scaling of the 4096 possible values are done once
+    // in a table that fits in L1 cache
+    class S12ToComplex : public Processor<uint8_t, complex_t> {
+        using base_type = Processor<uint8_t, complex_t>;
+    public:
+        S12ToComplex() {}
+
+        S12ToComplex(stream<uint8_t>* in, float scale = 2048.0f) { init(in, scale); }
+
+        void init(stream<uint8_t>* in, float scale = 2048.0f) {
+            _scale = scale;
+            base_type::init(in);
+        }
+
+        void setScale(float scale) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _scale = scale;
+            base_type::tempStart();
+        }
+
+        // Count is in complex samples, in holds three times as many bytes
+        static inline int process(int count, const uint8_t* in, complex_t* out, float scale = 2048.0f) {
+            const float* lut = table();
+            for (int i = 0; i < count; i++) {
+                const uint8_t* s = &in[i * 3];
+                out[i].re = lut[s[0] | ((s[1] & 0x0F) << 8)];
+                out[i].im = lut[(s[1] >> 4) | (s[2] << 4)];
+            }
+            if (scale != 2048.0f) { volk_32f_s32f_multiply_32f((float*)out, (float*)out, 2048.0f / scale, count * 2); }
+            return count;
+        }
+
+        int maxOutputCount(int inputCount) { return inputCount / 3; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            int outCount = count / 3;
+            base_type::out.reserve(outCount);
+
+            process(outCount, base_type::_in->readBuf, base_type::out.writeBuf, _scale);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / 3.0);
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(outCount)) { return -1; }
+            return count;
+        }
+
+    private:
+        // Raw 12 bit value to float, scaled to +/-1
+        static const float* table() {
+            static const struct Table {
+                Table() {
+                    for (int i = 0; i < 4096; i++) {
+                        lut[i] = (float)((i & 0x800) ? (i - 4096) : i) / 2048.0f;
+                    }
+                }
+                float lut[4096];
+            } t;
+            return t.lut;
+        }
+
+        float _scale = 2048.0f;
+    };
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "../processor.h"
+
+#define S16_TO_COMPLEX_SWAP_CHUNK   2048
+
+namespace dsp::convert {
+    // Interleaved signed 16 bit IQ to complex, in host or big endian byte order
+    class S16ToComplex : public Processor<int16_t, complex_t> {
+        using base_type = Processor<int16_t, complex_t>;
+    public:
+        S16ToComplex() {}
+
+        S16ToComplex(stream<int16_t>* in, float scale = 32768.0f, bool bigEndian = false) { init(in, scale, bigEndian); }
+
+        void init(stream<int16_t>* in, float scale = 32768.0f, bool bigEndian = false) {
+            _scale = scale;
+            _bigEndian = bigEndian;
+            base_type::init(in);
+        }
+
+        void setScale(float scale) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _scale = scale;
+            base_type::tempStart();
+        }
+
+        void setBigEndian(bool bigEndian) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _bigEndian = bigEndian;
+            base_type::tempStart();
+        }
+
+        // Count is in complex samples, in holds twice as many values
+        static inline int process(int count, const int16_t* in, complex_t* out, float scale = 32768.0f) {
+            volk_16i_s32f_convert_32f((float*)out, in, scale, count * 2);
+            return count;
+        }
+
+        // Same as process() for big endian input. The values are swapped in chunks small enough to stay in L1 cache
+        static inline int processBigEndian(int count, const int16_t* in, complex_t* out, float scale = 32768.0f) {
+            uint16_t swapped[S16_TO_COMPLEX_SWAP_CHUNK];
+            int values = count * 2;
+            for (int i = 0; i < values; i += S16_TO_COMPLEX_SWAP_CHUNK) {
+                int n = std::min<int>(S16_TO_COMPLEX_SWAP_CHUNK, values - i);
+                memcpy(swapped, &in[i], n * sizeof(int16_t));
+                volk_16u_byteswap(swapped, n);
+                volk_16i_s32f_convert_32f(&((float*)out)[i], (const int16_t*)swapped, scale, n);
+            }
+            return count;
+        }
+
+        int maxOutputCount(int inputCount) { return inputCount / 2; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            int outCount = count / 2;
+            base_type::out.reserve(outCount);
+
+            if (_bigEndian) {
+                processBigEndian(outCount, base_type::_in->readBuf, base_type::out.writeBuf, _scale);
+            }
+            else {
+                process(outCount, base_type::_in->readBuf, base_type::out.writeBuf, _scale);
+            }
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(outCount)) { return -1; }
+            return count;
+        }
+
+    private:
+        float _scale = 32768.0f;
+        bool _bigEndian = false;
+    };
+}
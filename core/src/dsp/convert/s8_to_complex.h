@@ -0,0 +1,51 @@
+#pragma once
+#include "../processor.h"
+
+namespace dsp::convert {
+    // Interleaved signed 8 bit IQ to complex
+    class S8ToComplex : public Processor<int8_t, complex_t> {
+        using base_type = Processor<int8_t, complex_t>;
+    public:
+        S8ToComplex() {}
+
+        S8ToComplex(stream<int8_t>* in, float scale = 128.0f) { init(in, scale); }
+
+        void init(stream<int8_t>* in, float scale = 128.0f) {
+            _scale = scale;
+            base_type::init(in);
+        }
+
+        void setScale(float scale) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _scale = scale;
+            base_type::tempStart();
+        }
+
+        // Count is in complex samples, in holds twice as many values
+        static inline int process(int count, const int8_t* in, complex_t* out, float scale = 128.0f) {
+            volk_8i_s32f_convert_32f((float*)out, in, scale, count * 2);
+            return count;
+        }
+
+        int maxOutputCount(int inputCount) { return inputCount / 2; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            int outCount = count / 2;
+            base_type::out.reserve(outCount);
+
+            process(outCount, base_type::_in->readBuf, base_type::out.writeBuf, _scale);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(outCount)) { return -1; }
+            return count;
+        }
+
+    private:
+        float _scale = 128.0f;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "../processor.h"
+
+namespace dsp::convert {
+    // Interleaved unsigned 8 bit IQ (offset binary, as produced by RTL-SDR dongles) to complex. Volk has no kernel for
+    // unsigned bytes so every possible byte is converted once to a table that fits in L1 cache and each component costs
+    // a single lookup. The table is rebuilt on each call, which is negligible next to the size of a block
+    class U8ToComplex : public Processor<uint8_t, complex_t> {
+        using base_type = Processor<uint8_t, complex_t>;
+    public:
+        U8ToComplex() {}
+
+        U8ToComplex(stream<uint8_t>* in, float offset = 127.5f, float scale = 128.0f) { init(in, offset, scale); }
+
+        // A byte b converts to (b - offset) / scale
+        void init(stream<uint8_t>* in, float offset = 127.5f, float scale = 128.0f) {
+            _offset = offset;
+            _scale = scale;
+            base_type::init(in);
+        }
+
+        void setOffset(float offset, float scale) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _offset = offset;
+            _scale = scale;
+            base_type::tempStart();
+        }
+
+        // Count is in complex samples, in holds twice as many bytes
+        static inline int process(int count, const uint8_t* in, complex_t* out, float offset = 127.5f, float scale = 128.0f) {
+            float lut[256];
+            for (int i = 0; i < 256; i++) {
+                lut[i] = ((float)i - offset) / scale;
+            }
+            for (int i = 0; i < count; i++) {
+                out[i].re = lut[in[i * 2]];
+                out[i].im = lut[in[(i * 2) + 1]];
+            }
+            return count;
+        }
+
+        int maxOutputCount(int inputCount) { return inputCount / 2; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            int outCount = count / 2;
+            base_type::out.reserve(outCount);
+
+            process(outCount, base_type::_in->readBuf, base_type::out.writeBuf, _offset, _scale);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(outCount)) { return -1; }
+            return count;
+        }
+
+    private:
+        float _offset = 127.5f;
+        float _scale = 128.0f;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "../filter/first_order_iir.h"
 
 namespace dsp::correction {
     template<class T>
@@ -14,12 +15,8 @@ namespace dsp::correction {
 
         void init(stream<T>* in, double rate) {
             _rate = rate;
-            if constexpr (std::is_same_v<T, float>) {
-                offset = 0.0f;
-            }
-            if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                offset = { 0.0f, 0.0f };
-            }
+            iir.setCoefficients(_rate, 1.0f - _rate);
+            iir.reset();
             base_type::init(in);
         }
 
@@ -31,6 +28,7 @@ namespace dsp::correction {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             _rate = rate;
+            iir.setCoefficients(_rate, 1.0f - _rate);
         }
 
         void setRate(double rate, double samplerate)  {
@@ -41,29 +39,29 @@ namespace dsp::correction {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            if constexpr (std::is_same_v<T, float>) {
-                offset = 0.0f;
-            }
-            if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                offset = { 0.0f, 0.0f };
-            }
+            iir.reset();
             base_type::tempStart();
         }
 
+        // The offset is followed by a first order IIR, removed from the input with a delay of one sample
         // TODO: Add back the const
         int process(int count, T* in, T* out) {
-            for (int i = 0; i < count; i++) {
-                out[i] = in[i] - offset;
-                offset += out[i] * _rate;
-            }
+            iir.processResidual(count, (const float*)in, (float*)out);
             return count;
         }
 
+        bool fusable() { return true; }
+        int processFused(int count, const T* in, T* out) { return process(count, (T*)in, out); }
+
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -72,6 +70,6 @@ namespace dsp::correction {
 
     protected:
         float _rate;
-        T offset;
+        filter::FirstOrderIIR<sizeof(T) / sizeof(float)> iir;
     };
 }
\ No newline at end of file
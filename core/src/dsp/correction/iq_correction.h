@@ -0,0 +1,61 @@
+#pragma once
+#include "../types.h"
+#include "../filter/first_order_iir.h"
+#include <volk/volk.h>
+#include <string.h>
+
+namespace dsp::correction {
+    // IQ inversion and DC removal, meant to be run by another block on the samples it just wrote rather than as blocks
+    // of their own, so that they are still in the cache. The DC removal is the same as DCBlocker's
+    class IQCorrection {
+    public:
+        // rate is the fraction of the distance to the input by which the estimated offset moves at each sample
+        void configure(bool conjugate, bool dcBlocking, float rate) {
+            _conjugate = conjugate;
+            if (rate != _rate) { dc.setCoefficients(rate, 1.0f - rate); }
+            _rate = rate;
+            if (dcBlocking != _dcBlocking) { dc.reset(); }
+            _dcBlocking = dcBlocking;
+        }
+
+        void reset() {
+            dc.reset();
+        }
+
+        inline bool isActive() { return _conjugate || _dcBlocking; }
+
+        // in and out may be the same buffer
+        inline void process(int count, const complex_t* in, complex_t* out) {
+            if (!_dcBlocking) {
+                if (_conjugate) { volk_32fc_conjugate_32fc((lv_32fc_t*)out, (const lv_32fc_t*)in, count); }
+                else if (in != out) { memcpy(out, in, count * sizeof(complex_t)); }
+                return;
+            }
+
+            // The conjugation is a pass of its own, the DC removal being done four samples at a time
+            if (_conjugate) {
+                volk_32fc_conjugate_32fc((lv_32fc_t*)out, (const lv_32fc_t*)in, count);
+                dc.processResidual(count, (const float*)out, (float*)out);
+            }
+            else {
+                dc.processResidual(count, (const float*)in, (float*)out);
+            }
+        }
+
+        // Same as process() on 16 bit IQ whose full scale is given by scale, the conversion being done first
+        inline void process(int count, const complex_s16_t* in, complex_t* out, float scale) {
+            float iScale = 1.0f / scale;
+            float iScaleIm = _conjugate ? -iScale : iScale;
+            for (int i = 0; i < count; i++) {
+                out[i] = { (float)in[i].re * iScale, (float)in[i].im * iScaleIm };
+            }
+            if (_dcBlocking) { dc.processResidual(count, (const float*)out, (float*)out); }
+        }
+
+    private:
+        bool _conjugate = false;
+        bool _dcBlocking = false;
+        float _rate = 0.0f;
+        filter::FirstOrderIIR<2> dc;
+    };
+}
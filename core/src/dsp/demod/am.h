@@ -5,6 +5,7 @@
 #include "../convert/mono_to_stereo.h"
 #include "../filter/fir.h"
 #include "../taps/low_pass.h"
+#include "../taps/cache.h"
 
 namespace dsp::demod {
     template <class T>
@@ -23,18 +24,19 @@ namespace dsp::demod {
         ~AM() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            taps::free(lpfTaps);
+            taps::cache::release(lpfTaps);
         }
 
         void init(stream<complex_t>* in, AGCMode agcMode, double bandwidth, double agcAttack, double agcDecay, double dcBlockRate, double samplerate) {
             _agcMode = agcMode;
             _bandwidth = bandwidth;
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
 
-            carrierAgc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY);
-            audioAgc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY);
+            carrierAgc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY, round(samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
+            audioAgc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY, round(samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
             dcBlock.init(NULL, dcBlockRate);
-            lpfTaps = taps::lowPass(bandwidth / 2.0, (bandwidth / 2.0) * 0.1, samplerate);
+            lpfTaps = taps::cache::lowPass(bandwidth / 2.0, (bandwidth / 2.0) * 0.1, samplerate);
             lpf.init(NULL, lpfTaps);
 
             if constexpr (std::is_same_v<T, float>) {
@@ -61,8 +63,8 @@ namespace dsp::demod {
             if (bandwidth == _bandwidth) { return; }
             _bandwidth = bandwidth;
             std::lock_guard<std::mutex> lck2(lpfMtx);
-            taps::free(lpfTaps);
-            lpfTaps = taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
+            taps::cache::release(lpfTaps);
+            lpfTaps = taps::cache::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
             lpf.setTaps(lpfTaps);
         }
 
@@ -132,11 +134,22 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
-            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+            base_type::out.writeMeta.silent = false;
+            if (silence.skip(base_type::_in->readMeta, count)) {
+                memset(base_type::out.writeBuf, 0, count * sizeof(T));
+                base_type::out.writeMeta.silent = true;
+            }
+            else {
+                process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            }
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -147,6 +160,7 @@ namespace dsp::demod {
         AGCMode _agcMode;
 
         double _samplerate;
+        silence_tracker silence;
         double _bandwidth;
 
         loop::AGC<complex_t> carrierAgc;
@@ -0,0 +1,242 @@
+#pragma once
+#include "../taps/root_raised_cosine.h"
+#include "../filter/fir.h"
+#include "../loop/fast_agc.h"
+#include "../loop/block_costas.h"
+#include "../clock_recovery/mm.h"
+
+// Samples taken through all the stages at once, so that they stay in the L1 cache from the filter to the clock recovery
+#define BLOCK_PSK_CHUNK_SIZE        2048
+
+// Default number of samples over which the Costas loop averages its error, see BlockCostas
+#define BLOCK_PSK_COSTAS_INTERVAL   16
+
+namespace dsp::demod {
+    // Variant of PSK for high symbol rates. Instead of each stage going over the whole block, which is then read from
+    // memory again by the next one, the block is processed one chunk at a time through all of them. The carrier is
+    // tracked by a BlockCostas, derotating with a vectorized rotator and updating its loop once per interval, which
+    // makes the loop slightly slower to react than the one of PSK. With oqpsk, the quadrature component is delayed by
+    // half a symbol before the clock recovery, which is only meaningful for order 4
+    template<int ORDER>
+    class BlockPSK : public Processor<complex_t, complex_t> {
+        using base_type = Processor<complex_t, complex_t>;
+    public:
+        BlockPSK() {}
+
+        BlockPSK(stream<complex_t>* in, double symbolrate, double samplerate, int rrcTapCount, double rrcBeta, double agcRate, double costasBandwidth, double omegaGain, double muGain, double omegaRelLimit = 0.01, bool oqpsk = false, int costasInterval = BLOCK_PSK_COSTAS_INTERVAL) {
+            init(in, symbolrate, samplerate, rrcTapCount, rrcBeta, agcRate, costasBandwidth, omegaGain, muGain, omegaRelLimit, oqpsk, costasInterval);
+        }
+
+        ~BlockPSK() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            taps::free(rrcTaps);
+            buffer::free(work);
+            buffer::free(delayBuf);
+        }
+
+        void init(stream<complex_t>* in, double symbolrate, double samplerate, int rrcTapCount, double rrcBeta, double agcRate, double costasBandwidth, double omegaGain, double muGain, double omegaRelLimit = 0.01, bool oqpsk = false, int costasInterval = BLOCK_PSK_COSTAS_INTERVAL) {
+            assert(!oqpsk || ORDER == 4);
+            _symbolrate = symbolrate;
+            _samplerate = samplerate;
+            _rrcTapCount = rrcTapCount;
+            _rrcBeta = rrcBeta;
+            _oqpsk = oqpsk;
+
+            rrcTaps = taps::rootRaisedCosine<float>(_rrcTapCount, _rrcBeta, _symbolrate, _samplerate);
+            rrc.init(NULL, rrcTaps);
+            agc.init(NULL, 1.0, 10e6, agcRate);
+            costas.init(NULL, costasBandwidth, costasInterval);
+            recov.init(NULL, _samplerate / _symbolrate, omegaGain, muGain, omegaRelLimit);
+
+            rrc.out.free();
+            agc.out.free();
+            costas.out.free();
+            recov.out.free();
+
+            work = buffer::alloc<complex_t>(BLOCK_PSK_CHUNK_SIZE);
+            configureDelay();
+
+            base_type::init(in);
+        }
+
+        void setSymbolrate(double symbolrate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _symbolrate = symbolrate;
+            taps::free(rrcTaps);
+            rrcTaps = taps::rootRaisedCosine<float>(_rrcTapCount, _rrcBeta, _symbolrate, _samplerate);
+            rrc.setTaps(rrcTaps);
+            recov.setOmega(_samplerate / _symbolrate);
+            configureDelay();
+            base_type::tempStart();
+        }
+
+        void setSamplerate(double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _samplerate = samplerate;
+            taps::free(rrcTaps);
+            rrcTaps = taps::rootRaisedCosine<float>(_rrcTapCount, _rrcBeta, _symbolrate, _samplerate);
+            rrc.setTaps(rrcTaps);
+            recov.setOmega(_samplerate / _symbolrate);
+            configureDelay();
+            base_type::tempStart();
+        }
+
+        void setRRCParams(int rrcTapCount, double rrcBeta) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _rrcTapCount = rrcTapCount;
+            _rrcBeta = rrcBeta;
+            taps::free(rrcTaps);
+            rrcTaps = taps::rootRaisedCosine<float>(_rrcTapCount, _rrcBeta, _symbolrate, _samplerate);
+            rrc.setTaps(rrcTaps);
+            base_type::tempStart();
+        }
+
+        void setRRCTapCount(int rrcTapCount) {
+            setRRCParams(rrcTapCount, _rrcBeta);
+        }
+
+        void setRRCBeta(double rrcBeta) {
+            setRRCParams(_rrcTapCount, rrcBeta);
+        }
+
+        void setAGCRate(double agcRate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            agc.setRate(agcRate);
+        }
+
+        void setCostasBandwidth(double bandwidth) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            costas.setBandwidth(bandwidth);
+        }
+
+        // See loop::BlockPLL::setInterval()
+        void setCostasInterval(int interval) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            costas.setInterval(interval);
+        }
+
+        void setMMParams(double omegaGain, double muGain, double omegaRelLimit = 0.01) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            recov.setOmegaGain(omegaGain);
+            recov.setMuGain(muGain);
+            recov.setOmegaRelLimit(omegaRelLimit);
+        }
+
+        void setOmegaGain(double omegaGain) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            recov.setOmegaGain(omegaGain);
+        }
+
+        void setMuGain(double muGain) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            recov.setMuGain(muGain);
+        }
+
+        void setOmegaRelLimit(double omegaRelLimit) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            recov.setOmegaRelLimit(omegaRelLimit);
+        }
+
+        void setOQPSK(bool enabled) {
+            assert(base_type::_block_init);
+            assert(!enabled || ORDER == 4);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _oqpsk = enabled;
+            configureDelay();
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            rrc.reset();
+            agc.reset();
+            costas.reset();
+            recov.reset();
+            buffer::clear<float>(delayBuf, delay);
+            base_type::tempStart();
+        }
+
+        // Can't be done in place, the symbols being written while later samples are still to be read
+        inline int process(int count, const complex_t* in, complex_t* out) {
+            int outCount = 0;
+            for (int i = 0; i < count; i += BLOCK_PSK_CHUNK_SIZE) {
+                int n = std::min<int>(count - i, BLOCK_PSK_CHUNK_SIZE);
+                rrc.process(n, &in[i], work);
+                agc.process(n, work, work);
+                costas.process(n, work, work);
+                if (_oqpsk) { delayQuadrature(n); }
+                outCount += recov.process(n, work, &out[outCount]);
+            }
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_symbolrate / _samplerate);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // The quadrature component lags by half a symbol, rounded to a whole number of samples
+        void configureDelay() {
+            buffer::free(delayBuf);
+            delayBuf = NULL;
+            delay = 0;
+            if (!_oqpsk) { return; }
+            delay = std::max<int>(1, (int)round(0.5 * _samplerate / _symbolrate));
+            delayBuf = buffer::alloc<float>(delay + BLOCK_PSK_CHUNK_SIZE);
+            buffer::clear<float>(delayBuf, delay);
+        }
+
+        // Same as the delay of Meteor, which is one sample at its two samples per symbol
+        inline void delayQuadrature(int count) {
+            for (int i = 0; i < count; i++) {
+                delayBuf[delay + i] = work[i].im;
+                work[i].im = delayBuf[i];
+            }
+            memmove(delayBuf, &delayBuf[count], delay * sizeof(float));
+        }
+
+        double _symbolrate;
+        double _samplerate;
+        int _rrcTapCount;
+        double _rrcBeta;
+        bool _oqpsk = false;
+
+        tap<float> rrcTaps;
+        filter::FIR<complex_t, float> rrc;
+        loop::FastAGC<complex_t> agc;
+        loop::BlockCostas<ORDER> costas;
+        clock_recovery::MM<complex_t> recov;
+
+        complex_t* work = NULL;
+        float* delayBuf = NULL;
+        int delay = 0;
+    };
+}
@@ -1,20 +1,29 @@
 #pragma once
 #include "quadrature.h"
 #include "../taps/low_pass.h"
-#include "../taps/band_pass.h"
+#include "../taps/cache.h"
 #include "../filter/fir.h"
-#include "../loop/pll.h"
+#include "../loop/phase_control_loop.h"
 #include "../convert/l_r_to_stereo.h"
 #include "../convert/real_to_complex.h"
-#include "../convert/complex_to_real.h"
-#include "../math/conjugate.h"
-#include "../math/delay.h"
-#include "../math/multiply.h"
-#include "../math/add.h"
-#include "../math/subtract.h"
+#include "../channel/frequency_xlator.h"
+#include "../math/normalize_phase.h"
+#include "../math/hz_to_rads.h"
+#include "../math/phasor.h"
 #include "../multirate/rational_resampler.h"
 
+// Number of samples demodulated and decoded together before moving on to the next ones
+#define BROADCAST_FM_CHUNK_SIZE         1024
+
+// The pilot is isolated by a cascade of complex one pole resonators, each of this bandwidth
+#define BROADCAST_FM_PILOT_SECTIONS     4
+#define BROADCAST_FM_PILOT_BANDWIDTH    500.0
+
 namespace dsp::demod {
+    // The stereo decoder runs in a single pass over each chunk of the MPX. The pilot is isolated by resonators instead
+    // of a long band-pass filter which, having no phase shift at 19KHz, need no delay on the L+R and L-R signals. For
+    // each sample the pilot PLL is advanced, the L-R signal brought down by the square of its conjugate and the left
+    // and right channels written interleaved, the audio low-pass then being run once on the stereo samples.
     class BroadcastFM : public Processor<complex_t, stereo_t> {
         using base_type = Processor<complex_t, stereo_t>;
     public:
@@ -25,11 +34,7 @@ namespace dsp::demod {
         ~BroadcastFM() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(lmr);
-            buffer::free(l);
-            buffer::free(r);
-            taps::free(pilotFirTaps);
-            taps::free(audioFirTaps);
+            taps::cache::release(audioFirTaps);
         }
 
         virtual void init(stream<complex_t>* in, double deviation, double samplerate, bool stereo = true, bool lowPass = true, bool rdsOut = false) {
@@ -40,25 +45,16 @@ namespace dsp::demod {
             _rdsOut = rdsOut;
             
             demod.init(NULL, _deviation, _samplerate);
-            pilotFirTaps = taps::bandPass<complex_t>(18750.0, 19250.0, 3000.0, _samplerate, true);
-            pilotFir.init(NULL, pilotFirTaps);
+            initPilot();
             rtoc.init(NULL);
-            pilotPLL.init(NULL, 25000.0 / _samplerate, 0.0, math::hzToRads(19000.0, _samplerate), math::hzToRads(18750.0, _samplerate), math::hzToRads(19250.0, _samplerate));
-            lprDelay.init(NULL, ((pilotFirTaps.size - 1) / 2) + 1);
-            lmrDelay.init(NULL, ((pilotFirTaps.size - 1) / 2) + 1);
-            audioFirTaps = taps::lowPass(15000.0, 4000.0, _samplerate);
-            alFir.init(NULL, audioFirTaps);
-            arFir.init(NULL, audioFirTaps);
+            audioFirTaps = taps::cache::lowPass(15000.0, 4000.0, _samplerate);
+            monoFir.init(NULL, audioFirTaps);
+            stereoFir.init(NULL, audioFirTaps);
             xlator.init(NULL, -57000.0, samplerate);
             rdsResamp.init(NULL, samplerate, 5000.0);
 
-            lmr = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-            l = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-            r = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-
-            lprDelay.out.free();
-            arFir.out.free();
-            alFir.out.free();
+            monoFir.out.free();
+            stereoFir.out.free();
             xlator.out.free();
             rdsResamp.out.free();
 
@@ -79,19 +75,12 @@ namespace dsp::demod {
             _samplerate = samplerate;
 
             demod.setDeviation(_deviation, _samplerate);
-            taps::free(pilotFirTaps);
-            pilotFirTaps = taps::bandPass<complex_t>(18750.0, 19250.0, 3000.0, samplerate, true);
-            pilotFir.setTaps(pilotFirTaps);
-            
-            pilotPLL.setFrequencyLimits(math::hzToRads(18750.0, _samplerate), math::hzToRads(19250.0, _samplerate));
-            pilotPLL.setInitialFreq(math::hzToRads(19000.0, _samplerate));
-            lprDelay.setDelay(((pilotFirTaps.size - 1) / 2) + 1);
-            lmrDelay.setDelay(((pilotFirTaps.size - 1) / 2) + 1);
+            initPilot();
 
-            taps::free(audioFirTaps);
-            audioFirTaps = taps::lowPass(15000.0, 4000.0, _samplerate);
-            alFir.setTaps(audioFirTaps);
-            arFir.setTaps(audioFirTaps);
+            taps::cache::release(audioFirTaps);
+            audioFirTaps = taps::cache::lowPass(15000.0, 4000.0, _samplerate);
+            monoFir.setTaps(audioFirTaps);
+            stereoFir.setTaps(audioFirTaps);
 
             xlator.setOffset(-57000.0, samplerate);
             rdsResamp.setInSamplerate(samplerate);
@@ -132,83 +121,44 @@ namespace dsp::demod {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             demod.reset();
-            pilotFir.reset();
-            pilotPLL.reset();
-            lprDelay.reset();
-            lmrDelay.reset();
-            alFir.reset();
-            arFir.reset();
+            resetPilot();
+            monoFir.reset();
+            stereoFir.reset();
             base_type::tempStart();
         }
 
         inline int process(int count, complex_t* in, stereo_t* out, int& rdsOutCount, complex_t* rdsout = NULL) {
-            // Demodulate
-            demod.process(count, in, demod.out.writeBuf);
-            if (_stereo) {
-                // Convert to complex
-                rtoc.process(count, demod.out.writeBuf, rtoc.out.writeBuf);
-
-                // Filter out pilot and run through PLL
-                pilotFir.process(count, rtoc.out.writeBuf, pilotFir.out.writeBuf);
-                pilotPLL.process(count, pilotFir.out.writeBuf, pilotPLL.out.writeBuf);
-
-                // Delay
-                lprDelay.process(count, demod.out.writeBuf, demod.out.writeBuf);
-                lmrDelay.process(count, rtoc.out.writeBuf, lmrDelay.out.writeBuf);
-                
-                // conjugate PLL output to down convert twice the L-R signal
-                math::Conjugate::process(count, pilotPLL.out.writeBuf, pilotPLL.out.writeBuf);
-                math::Multiply<dsp::complex_t>::process(count, lmrDelay.out.writeBuf, pilotPLL.out.writeBuf, lmrDelay.out.writeBuf);
-                math::Multiply<dsp::complex_t>::process(count, lmrDelay.out.writeBuf, pilotPLL.out.writeBuf, lmrDelay.out.writeBuf);
-
-                // Do RDS demod
-                if (_rdsOut) {
-                    // Translate to 0Hz
-                    xlator.process(count, rtoc.out.writeBuf, rtoc.out.writeBuf);
-
-                    // Resample to the output samplerate
-                    rdsOutCount = rdsResamp.process(count, rtoc.out.writeBuf, rdsout);
-                }
-
-                // Convert output back to real for further processing
-                convert::ComplexToReal::process(count, lmrDelay.out.writeBuf, lmr);
+            float* mpx = demod.out.writeBuf;
+            complex_t* rds = rtoc.out.writeBuf;
+            for (int i = 0; i < count; i += BROADCAST_FM_CHUNK_SIZE) {
+                int n = std::min<int>(BROADCAST_FM_CHUNK_SIZE, count - i);
 
-                // Amplify by 2x
-                volk_32f_s32f_multiply_32f(lmr, lmr, 2.0f, count);
+                // Demodulate
+                demod.process(n, &in[i], &mpx[i]);
 
-                // Do L = (L+R) + (L-R), R = (L+R) - (L-R)
-                math::Add<float>::process(count, demod.out.writeBuf, lmr, l);
-                math::Subtract<float>::process(count, demod.out.writeBuf, lmr, r);
-
-                // Filter if needed
-                if (_lowPass) {
-                    alFir.process(count, l, l);
-                    arFir.process(count, r, r);
-                }
-
-                // Interleave into stereo
-                convert::LRToStereo::process(count, l, r, out);
-            }
-            else {
-                // Process RDS if needed. Note: find a way to not have to copy half the code from the stereo demod
+                // Translate RDS to 0Hz
                 if (_rdsOut) {
-                    // Convert to complex
-                    rtoc.process(count, demod.out.writeBuf, rtoc.out.writeBuf);
-
-                    // Translate to 0Hz
-                    xlator.process(count, rtoc.out.writeBuf, rtoc.out.writeBuf);
-
-                    // Resample to the output samplerate
-                    rdsOutCount = rdsResamp.process(count, rtoc.out.writeBuf, rdsout);
+                    rtoc.process(n, &mpx[i], &rds[i]);
+                    xlator.process(n, &rds[i], &rds[i]);
                 }
 
-                // Filter if needed
-                if (_lowPass) {
-                    alFir.process(count, demod.out.writeBuf, demod.out.writeBuf);
-                }
+                // Decode stereo
+                if (_stereo) { decodeStereo(n, &mpx[i], &out[i]); }
+            }
 
+            // Filter if needed, the filters being run on the whole buffer for the fast convolution to use full segments
+            if (_stereo) {
+                if (_lowPass) { stereoFir.process(count, out, out); }
+            }
+            else {
                 // Interleave raw MPX to stereo
-                convert::LRToStereo::process(count, demod.out.writeBuf, demod.out.writeBuf, out);
+                if (_lowPass) { monoFir.process(count, mpx, mpx); }
+                convert::LRToStereo::process(count, mpx, mpx, out);
+            }
+
+            // Resample RDS to the output samplerate
+            if (_rdsOut) {
+                rdsOutCount = rdsResamp.process(count, rds, rdsout);
             }
 
             return count;
@@ -220,6 +170,7 @@ namespace dsp::demod {
 
             int rdsOutCount = 0;
             process(count, base_type::_in->readBuf, base_type::out.writeBuf, rdsOutCount, rdsOut.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -232,6 +183,45 @@ namespace dsp::demod {
         stream<complex_t> rdsOut;
 
     protected:
+        void initPilot() {
+            // Resonators centered on the pilot
+            float r = expf(-2.0f * FL_M_PI * BROADCAST_FM_PILOT_BANDWIDTH / _samplerate);
+            pilotPole = math::phasor(math::hzToRads(19000.0, _samplerate)) * r;
+            pilotGain = 1.0f - r;
+
+            float alpha, beta;
+            loop::PhaseControlLoop<float>::criticallyDamped(25000.0 / _samplerate, alpha, beta);
+            pilotPLL.init(alpha, beta, 0.0, -FL_M_PI, FL_M_PI, math::hzToRads(19000.0, _samplerate), math::hzToRads(18750.0, _samplerate), math::hzToRads(19250.0, _samplerate));
+            resetPilot();
+        }
+
+        void resetPilot() {
+            for (int i = 0; i < BROADCAST_FM_PILOT_SECTIONS; i++) { pilotState[i] = { 0.0f, 0.0f }; }
+            pilotPLL.phase = 0.0f;
+            pilotPLL.freq = math::hzToRads(19000.0, _samplerate);
+        }
+
+        inline void decodeStereo(int count, const float* mpx, stereo_t* out) {
+            for (int i = 0; i < count; i++) {
+                // Isolate the pilot
+                complex_t pilot = { mpx[i] * pilotGain, 0.0f };
+                for (int j = 0; j < BROADCAST_FM_PILOT_SECTIONS; j++) {
+                    pilotState[j] = (pilotState[j] * pilotPole) + pilot;
+                    pilot = pilotState[j] * pilotGain;
+                }
+
+                // The PLL locks on the analytic pilot, a sine wave being a quarter turn late. The subcarrier, a sine wave
+                // in phase with the pilot, is then minus the imaginary part of the square of the PLL output
+                complex_t ref = math::phasor(pilotPLL.phase);
+                pilotPLL.advance(math::normalizePhase(pilot.phase() - pilotPLL.phase));
+                float lmr = -4.0f * mpx[i] * ref.re * ref.im;
+
+                // L = (L+R) + (L-R), R = (L+R) - (L-R)
+                out[i].l = mpx[i] + lmr;
+                out[i].r = mpx[i] - lmr;
+            }
+        }
+
         double _deviation;
         double _samplerate;
         bool _stereo;
@@ -239,21 +229,15 @@ namespace dsp::demod {
         bool _rdsOut;
 
         Quadrature demod;
-        tap<complex_t> pilotFirTaps;
-        filter::FIR<complex_t, complex_t> pilotFir;
+        complex_t pilotPole;
+        float pilotGain;
+        complex_t pilotState[BROADCAST_FM_PILOT_SECTIONS];
+        loop::PhaseControlLoop<float> pilotPLL;
         convert::RealToComplex rtoc;
         channel::FrequencyXlator xlator;
-        loop::PLL pilotPLL;
-        math::Delay<float> lprDelay;
-        math::Delay<complex_t> lmrDelay;
         tap<float> audioFirTaps;
-        filter::FIR<float, float> arFir;
-        filter::FIR<float, float> alFir;
+        filter::FIR<float, float> monoFir;
+        filter::FIR<stereo_t, float> stereoFir;
         multirate::RationalResampler<dsp::complex_t> rdsResamp;
-
-        float* lmr;
-        float* l;
-        float* r;
-        
     };
 }
\ No newline at end of file
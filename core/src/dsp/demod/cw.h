@@ -17,9 +17,10 @@ namespace dsp::demod {
         void init(stream<complex_t>* in, double tone, double agcAttack, double agcDecay, double samplerate) {
             _tone = tone;
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
             
             xlator.init(NULL, tone, samplerate);
-            agc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY);
+            agc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY, round(samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
 
             if constexpr (std::is_same_v<T, float>) {
                 agc.out.free();
@@ -51,7 +52,9 @@ namespace dsp::demod {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
             xlator.setOffset(_tone, _samplerate);
+            agc.setLookahead(round(_samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
         }
 
         inline int process(int count, const complex_t* in, T* out) {
@@ -68,11 +71,22 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
-            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+            base_type::out.writeMeta.silent = false;
+            if (silence.skip(base_type::_in->readMeta, count)) {
+                memset(base_type::out.writeBuf, 0, count * sizeof(T));
+                base_type::out.writeMeta.silent = true;
+            }
+            else {
+                process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            }
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -82,6 +96,7 @@ namespace dsp::demod {
     private:
         double _tone;
         double _samplerate;
+        silence_tracker silence;
 
         dsp::channel::FrequencyXlator xlator;
         dsp::loop::AGC<float> agc;
@@ -3,6 +3,7 @@
 #include "quadrature.h"
 #include "../filter/fir.h"
 #include "../taps/low_pass.h"
+#include "../taps/cache.h"
 #include "../taps/high_pass.h"
 #include "../taps/band_pass.h"
 #include "../convert/mono_to_stereo.h"
@@ -19,11 +20,12 @@ namespace dsp::demod {
         ~FM() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            dsp::taps::free(filterTaps);
+            dsp::taps::cache::release(filterTaps);
         }
 
         void init(dsp::stream<dsp::complex_t>* in, double samplerate, double bandwidth, bool lowPass, bool highPass) {
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
             _bandwidth = bandwidth;
             _lowPass = lowPass;
             _highPass = highPass;
@@ -48,6 +50,7 @@ namespace dsp::demod {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
             demod.setDeviation(_bandwidth / 2.0, _samplerate);
             updateFilter(_lowPass, _highPass);
             base_type::tempStart();
@@ -102,11 +105,23 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
-
-            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.reserve(count);
+
+            // The output only turns silent once the input has been for long enough, see silence_tracker
+            base_type::out.writeMeta = base_type::_in->readMeta;
+            base_type::out.writeMeta.silent = false;
+            if (silence.skip(base_type::_in->readMeta, count)) {
+                memset(base_type::out.writeBuf, 0, count * sizeof(T));
+                base_type::out.writeMeta.silent = true;
+            }
+            else {
+                process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            }
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -123,17 +138,17 @@ namespace dsp::demod {
             filtering = (lowPass || highPass);
 
             // Free filter taps
-            dsp::taps::free(filterTaps);
+            dsp::taps::cache::release(filterTaps);
 
             // Generate filter depending on low and high pass settings
             if (_lowPass && _highPass) {
-                filterTaps = dsp::taps::bandPass<float>(300.0, _bandwidth / 2.0, 100.0, _samplerate);
+                filterTaps = dsp::taps::cache::bandPass(300.0, _bandwidth / 2.0, 100.0, _samplerate);
             }
             else if (_highPass) {
-                filterTaps = dsp::taps::highPass(300.0, 100.0, _samplerate);
+                filterTaps = dsp::taps::cache::highPass(300.0, 100.0, _samplerate);
             }
             else if (_lowPass) {
-                filterTaps = dsp::taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
+                filterTaps = dsp::taps::cache::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
             }
             else {
                 loadDummyTaps();
@@ -150,6 +165,7 @@ namespace dsp::demod {
         }
 
         double _samplerate;
+        silence_tracker silence;
         double _bandwidth;
         bool _lowPass;
         bool _highPass;
@@ -0,0 +1,152 @@
+#pragma once
+#include "quadrature.h"
+#include "../filter/fir.h"
+#include "../clock_recovery/mm.h"
+#include "../digital/binary_slicer.h"
+
+// Number of input samples run through all the stages at once, small enough for the intermediate buffers to stay in L1
+#define FSK_CHUNK_SIZE  1024
+
+namespace dsp::demod {
+    // Binary FSK receiver: quadrature demodulator, matched filter, clock recovery and slicer. The hard bits are sent on
+    // out and the soft symbols on soft if enabled. Instead of running each stage on the whole buffer, the buffer is
+    // processed by chunks of FSK_CHUNK_SIZE samples going through every stage before the next one is started.
+    class FSK : public Processor<complex_t, uint8_t> {
+        using base_type = Processor<complex_t, uint8_t>;
+    public:
+        FSK() {}
+
+        FSK(stream<complex_t>* in, double symbolrate, double samplerate, double deviation, const tap<float>& shape, double omegaGain, double muGain, double omegaRelLimit = 0.01, bool enableSoft = false) {
+            init(in, symbolrate, samplerate, deviation, shape, omegaGain, muGain, omegaRelLimit, enableSoft);
+        }
+
+        ~FSK() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            taps::free(shapeTaps);
+            buffer::free(work);
+        }
+
+        // The matched filter taps are copied
+        void init(stream<complex_t>* in, double symbolrate, double samplerate, double deviation, const tap<float>& shape, double omegaGain, double muGain, double omegaRelLimit = 0.01, bool enableSoft = false) {
+            _symbolrate = symbolrate;
+            _samplerate = samplerate;
+            _deviation = deviation;
+            _enableSoft = enableSoft;
+
+            copyShape(shape);
+            demod.init(NULL, _deviation, _samplerate);
+            fir.init(NULL, shapeTaps);
+            recov.init(NULL, _samplerate / _symbolrate, omegaGain, muGain, omegaRelLimit);
+            work = buffer::alloc<float>(FSK_CHUNK_SIZE);
+
+            // Free useless buffers
+            demod.out.free();
+            fir.out.free();
+            recov.out.free();
+
+            base_type::init(in);
+        }
+
+        void setSymbolrate(double symbolrate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _symbolrate = symbolrate;
+            recov.setOmega(_samplerate / _symbolrate);
+            base_type::tempStart();
+        }
+
+        void setDeviation(double deviation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _deviation = deviation;
+            demod.setDeviation(_deviation, _samplerate);
+        }
+
+        void setShape(const tap<float>& shape) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            taps::free(shapeTaps);
+            copyShape(shape);
+            fir.setTaps(shapeTaps);
+            base_type::tempStart();
+        }
+
+        void setMMParams(double omegaGain, double muGain, double omegaRelLimit = 0.01) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            recov.setOmegaGain(omegaGain);
+            recov.setMuGain(muGain);
+            recov.setOmegaRelLimit(omegaRelLimit);
+        }
+
+        void setSoftEnabled(bool enable) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _enableSoft = enable;
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            demod.reset();
+            fir.reset();
+            recov.reset();
+            base_type::tempStart();
+        }
+
+        inline int process(int count, complex_t* in, float* softOut, uint8_t* hardOut) {
+            int outCount = 0;
+            for (int i = 0; i < count; i += FSK_CHUNK_SIZE) {
+                int n = std::min<int>(FSK_CHUNK_SIZE, count - i);
+                demod.process(n, &in[i], work);
+                fir.process(n, work, work);
+                int symbols = recov.process(n, work, &softOut[outCount]);
+                digital::BinarySlicer::process(symbols, &softOut[outCount], &hardOut[outCount]);
+                outCount += symbols;
+            }
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, soft.writeBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_symbolrate / _samplerate);
+            soft.writeMeta = base_type::out.writeMeta;
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+                if (_enableSoft && !soft.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+        stream<float> soft;
+
+    protected:
+        void copyShape(const tap<float>& shape) {
+            shapeTaps = taps::alloc<float>(shape.size);
+            memcpy(shapeTaps.taps, shape.taps, shape.size * sizeof(float));
+        }
+
+        double _symbolrate;
+        double _samplerate;
+        double _deviation;
+        bool _enableSoft;
+
+        Quadrature demod;
+        tap<float> shapeTaps;
+        filter::FIR<float, float> fir;
+        clock_recovery::MM<float> recov;
+        float* work = NULL;
+    };
+}
@@ -3,6 +3,7 @@
 #include "../taps/root_raised_cosine.h"
 #include "../filter/fir.h"
 #include "../clock_recovery/mm.h"
+#include "fsk.h"
 
 namespace dsp::demod {
     // Note: I don't like how this demodulator reuses 90% of the code from the PSK demod. Same will be for the PM demod...
@@ -19,6 +20,7 @@ namespace dsp::demod {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             taps::free(rrcTaps);
+            buffer::free(work);
         }
 
         void init(stream<complex_t>* in, double symbolrate, double samplerate, double deviation, int rrcTapCount, double rrcBeta, double omegaGain, double muGain, double omegaRelLimit = 0.01) {
@@ -33,6 +35,8 @@ namespace dsp::demod {
             rrc.init(NULL, rrcTaps);
             recov.init(NULL, _samplerate / _symbolrate,  omegaGain, muGain, omegaRelLimit);
 
+            work = buffer::alloc<float>(FSK_CHUNK_SIZE);
+
             demod.out.free();
             rrc.out.free();
             recov.out.free();
@@ -128,10 +132,16 @@ namespace dsp::demod {
             base_type::tempStart();
         }
 
+        // Run by chunks like the binary FSK receiver, see FSK::process()
         inline int process(int count, complex_t* in, float* out) {
-            demod.process(count, in, out);
-            rrc.process(count, out, out);
-            return recov.process(count, out, out);
+            int outCount = 0;
+            for (int i = 0; i < count; i += FSK_CHUNK_SIZE) {
+                int n = std::min<int>(FSK_CHUNK_SIZE, count - i);
+                demod.process(n, &in[i], work);
+                rrc.process(n, work, work);
+                outCount += recov.process(n, work, &out[outCount]);
+            }
+            return outCount;
         }
 
         int run() {
@@ -139,6 +149,7 @@ namespace dsp::demod {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_symbolrate / _samplerate);
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -159,5 +170,6 @@ namespace dsp::demod {
         tap<float> rrcTaps;
         filter::FIR<float, float> rrc;
         clock_recovery::MM<float> recov;
+        float* work = NULL;
     };
 }
\ No newline at end of file
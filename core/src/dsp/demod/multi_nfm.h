@@ -0,0 +1,402 @@
+#pragma once
+#include <mutex>
+#include "../channel/channelizer.h"
+#include "../taps/low_pass.h"
+#include "../math/hz_to_rads.h"
+
+// Number of frames processed at once for all the channels, small enough for the work buffers to stay in cache
+#define MULTI_NFM_CHUNK_SIZE    256
+
+// The channels are padded to a multiple of this many lanes, the padding lanes being kept silent
+#define MULTI_NFM_LANES         8
+
+namespace dsp::demod {
+    // Narrow band FM receiver for many channels of one wideband stream. The channelizer splits the band and a rotator
+    // per channel removes what is left of its offset. The channel filter, squelch, quadrature demodulator and
+    // deemphasis of all the channels then run together on buffers laid out frame by frame with one lane per channel.
+    // Every step is a loop over the lanes with the state of each channel in arrays, which the compiler vectorizes, and
+    // the whole receiver runs in one thread. The audio comes out at the channel samplerate, the open channels being
+    // mixed together on out.
+    class MultiNFM : public channel::Channelizer {
+        using base_type = channel::Channelizer;
+    public:
+        MultiNFM() {}
+
+        MultiNFM(stream<complex_t>* in, double samplerate, int channels, double bandwidth, double squelchLevel, double deempTau) { init(in, samplerate, channels, bandwidth, squelchLevel, deempTau); }
+
+        ~MultiNFM() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            taps::free(filterTaps);
+            freeBuffers();
+        }
+
+        void init(stream<complex_t>* in, double samplerate, int channels, double bandwidth, double squelchLevel, double deempTau) {
+            _bandwidth = bandwidth;
+            _squelchLevel = squelchLevel;
+            _deempTau = deempTau;
+            base_type::init(in, samplerate, channels);
+            base_type::registerOutput(&out);
+            configure();
+        }
+
+        void setSamplerate(double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            base_type::setSamplerate(samplerate);
+            configure();
+            base_type::tempStart();
+        }
+
+        // Replace the channels to receive, the offsets being relative to the center of the band
+        void setChannels(const std::vector<double>& offsets) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+
+            // Unbind the previous channels
+            for (auto& s : chanStreams) { base_type::unbindOutput(s.get()); }
+            chanStreams.clear();
+
+            // Bind a stream per channel, only used as the buffer the channelizer writes into
+            _offsets = offsets;
+            for (int i = 0; i < _offsets.size(); i++) {
+                chanStreams.push_back(std::make_unique<stream<complex_t>>(4096));
+                base_type::bindOutput(chanStreams[i].get(), -1);
+            }
+            gain.assign(_offsets.size(), 1.0f);
+            configure();
+
+            base_type::tempStart();
+        }
+
+        // Follow a change of the offset of a channel without interrupting the others
+        void setChannelOffset(int channel, double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            if (channel < 0 || channel >= chanStreams.size()) { return; }
+            _offsets[channel] = offset;
+            tuneChannel(channel);
+        }
+
+        // Gain of a channel in the mix, 0 to mute it
+        void setChannelGain(int channel, float channelGain) {
+            std::lock_guard<std::mutex> lck(tuneMtx);
+            if (channel < 0 || channel >= gain.size()) { return; }
+            gain[channel] = channelGain;
+        }
+
+        void setBandwidth(double bandwidth) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _bandwidth = bandwidth;
+            configure();
+            base_type::tempStart();
+        }
+
+        void setSquelchLevel(double level) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _squelchLevel = level;
+        }
+
+        // Deemphasis time constant, 0 to disable it
+        void setDeemphasisTau(double tau) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _deempTau = tau;
+            updateDeemphasis();
+        }
+
+        // Whether an offset can be received, the edges of the band are left to the filter of the VFO
+        bool inBand(double offset) {
+            return fabs(offset) <= (_samplerate - base_type::getChannelSpacing()) / 2.0;
+        }
+
+        // Whether the squelch of a channel is open, inaccurate but safe to call from any thread
+        bool isOpen(int channel) {
+            std::lock_guard<std::mutex> lck(tuneMtx);
+            return (channel >= 0 && channel < sharedOpen.size()) ? sharedOpen[channel] : false;
+        }
+
+        // Level of a channel in dB as seen by the squelch, inaccurate but safe to call from any thread
+        float getLevel(int channel) {
+            std::lock_guard<std::mutex> lck(tuneMtx);
+            return (channel >= 0 && channel < sharedLevel.size()) ? sharedLevel[channel] : -INFINITY;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Take a consistent view of the tuning for this block
+            bool any = false;
+            {
+                std::lock_guard<std::mutex> lck(tuneMtx);
+                for (int i = 0; i < base_type::outputs.size(); i++) {
+                    base_type::channelSnapshot[i] = base_type::outputs[i]->channel;
+                    any |= (base_type::channelSnapshot[i] >= 0);
+                }
+                rotDeltaSnapshot = rotDelta;
+                for (int c = 0; c < chanStreams.size(); c++) {
+                    gainSnapshot[c] = (base_type::channelSnapshot[c] >= 0) ? gain[c] : 0.0f;
+                }
+            }
+
+            // Extract the channels, the streams are never swapped
+            int frames = 0;
+            if (any) {
+                frames = base_type::process(count, base_type::_in->readBuf);
+            }
+            else {
+                base_type::skip(count, base_type::_in->readBuf);
+            }
+            stream_meta meta = base_type::_in->readMeta.rescaled(base_type::getChannelSamplerate() / base_type::_samplerate);
+            base_type::_in->flush();
+            if (!frames) { return count; }
+
+            out.reserve(frames);
+            demodulate(frames, out.writeBuf);
+            out.writeMeta = meta;
+            if (!out.swap(frames)) { return -1; }
+            return count;
+        }
+
+        stream<stereo_t> out;
+
+    private:
+        // Regenerate everything that depends on the samplerate, bandwidth or channel list
+        void configure() {
+            double chanSr = base_type::getChannelSamplerate();
+            int n = chanStreams.size();
+            lanes = ((n + MULTI_NFM_LANES - 1) / MULTI_NFM_LANES) * MULTI_NFM_LANES;
+
+            // Channel filter, the signal being already limited to the usable bandwidth of the channelizer
+            taps::free(filterTaps);
+            filterTaps = taps::lowPass(_bandwidth / 2.0, _bandwidth / 8.0, chanSr, true);
+            invDeviation = 1.0f / math::hzToRads(_bandwidth / 2.0, chanSr);
+            updateDeemphasis();
+
+            // Reset the state of every channel
+            rotPhase.assign(n, lv_cmake(1.0f, 0.0f));
+            lastRe.assign(lanes, 1.0f);
+            lastIm.assign(lanes, 0.0f);
+            deemp.assign(lanes, 0.0f);
+            power.assign(lanes, 0.0f);
+            mixGain.assign(lanes, 0.0f);
+            gainSnapshot.assign(lanes, 0.0f);
+            open.assign(lanes, false);
+            level.assign(lanes, -INFINITY);
+            {
+                std::lock_guard<std::mutex> lck(tuneMtx);
+                rotDelta.assign(n, lv_cmake(1.0f, 0.0f));
+                sharedOpen.assign(n, false);
+                sharedLevel.assign(n, -INFINITY);
+            }
+
+            // The history of the channel filter is kept in front of the chunk being processed
+            freeBuffers();
+            histLen = filterTaps.size - 1;
+            int histSize = (histLen + MULTI_NFM_CHUNK_SIZE) * lanes;
+            histRe = buffer::alloc<float>(histSize);
+            histIm = buffer::alloc<float>(histSize);
+            filtRe = buffer::alloc<float>(MULTI_NFM_CHUNK_SIZE * lanes);
+            filtIm = buffer::alloc<float>(MULTI_NFM_CHUNK_SIZE * lanes);
+            audio = buffer::alloc<float>(MULTI_NFM_CHUNK_SIZE * lanes);
+            buffer::clear(histRe, histSize);
+            buffer::clear(histIm, histSize);
+
+            for (int i = 0; i < n; i++) { tuneChannel(i); }
+        }
+
+        void freeBuffers() {
+            buffer::free(histRe);
+            buffer::free(histIm);
+            buffer::free(filtRe);
+            buffer::free(filtIm);
+            buffer::free(audio);
+        }
+
+        void updateDeemphasis() {
+            float dt = 1.0f / base_type::getChannelSamplerate();
+            deempAlpha = (_deempTau > 0.0) ? (dt / (_deempTau + dt)) : 1.0f;
+        }
+
+        void tuneChannel(int channel) {
+            std::lock_guard<std::mutex> lck(tuneMtx);
+            double offset = _offsets[channel];
+            int ch = inBand(offset) ? base_type::channelFor(offset) : -1;
+            double residual = (ch >= 0) ? (offset - base_type::getChannelOffset(ch)) : 0.0;
+            float delta = math::hzToRads(-residual, base_type::getChannelSamplerate());
+            rotDelta[channel] = lv_cmake(cosf(delta), sinf(delta));
+            base_type::setOutputChannel(chanStreams[channel].get(), ch);
+        }
+
+        // Branchless atan2 so that it vectorizes, the angle is found from the atan of (|x| - |y|) / (|x| + |y|) which
+        // the polynomial approximates to about 2e-6 rad. Conditional arithmetic would keep the compiler from vectorizing
+        static inline float laneAtan2(float y, float x) {
+            float ax = fabsf(x);
+            float ay = fabsf(y);
+            float u = (ax - ay) / (ax + ay + 1e-30f);
+            float s = u * u;
+            float p = u * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f - s * 0.01172120f)))));
+            float r = ((x < 0.0f) ? (0.75f * FL_M_PI) : (0.25f * FL_M_PI)) + ((x < 0.0f) ? p : -p);
+            return copysignf(r, y);
+        }
+
+        void demodulate(int frames, stereo_t* mix) {
+            int n = chanStreams.size();
+            int L = lanes;
+            int tapCount = filterTaps.size;
+            const float* h = filterTaps.taps;
+            float* pLastRe = lastRe.data();
+            float* pLastIm = lastIm.data();
+            float* pDeemp = deemp.data();
+            float* pPower = power.data();
+            const float* pMixGain = mixGain.data();
+            float alpha = deempAlpha;
+            float norm = invDeviation;
+            float squelchLevel = _squelchLevel;
+
+            // Remove the rest of the offset of each channel
+            for (int c = 0; c < n; c++) {
+                if (base_type::channelSnapshot[c] < 0) { continue; }
+                lv_32fc_t* s = (lv_32fc_t*)chanStreams[c]->writeBuf;
+#if VOLK_VERSION >= 030100
+                volk_32fc_s32fc_x2_rotator2_32fc(s, s, &rotDeltaSnapshot[c], &rotPhase[c], frames);
+#else
+                volk_32fc_s32fc_x2_rotator_32fc(s, s, rotDeltaSnapshot[c], &rotPhase[c], frames);
+#endif
+            }
+
+            for (int i = 0; i < frames; i += MULTI_NFM_CHUNK_SIZE) {
+                int count = std::min<int>(MULTI_NFM_CHUNK_SIZE, frames - i);
+                float* xRe = &histRe[histLen * L];
+                float* xIm = &histIm[histLen * L];
+
+                // Gather the channels into their lanes, channels out of the band being silent
+                for (int c = 0; c < n; c++) {
+                    if (base_type::channelSnapshot[c] < 0) {
+                        for (int t = 0; t < count; t++) {
+                            xRe[t * L + c] = 0.0f;
+                            xIm[t * L + c] = 0.0f;
+                        }
+                        continue;
+                    }
+                    const complex_t* s = &chanStreams[c]->writeBuf[i];
+                    for (int t = 0; t < count; t++) {
+                        xRe[t * L + c] = s[t].re;
+                        xIm[t * L + c] = s[t].im;
+                    }
+                }
+
+                // Channel filter, the taps being symmetric
+                for (int t = 0; t < count; t++) {
+                    float* yRe = &filtRe[t * L];
+                    float* yIm = &filtIm[t * L];
+                    for (int c = 0; c < L; c++) {
+                        yRe[c] = 0.0f;
+                        yIm[c] = 0.0f;
+                    }
+                    for (int k = 0; k < tapCount; k++) {
+                        float w = h[k];
+                        const float* re = &histRe[(t + k) * L];
+                        const float* im = &histIm[(t + k) * L];
+                        for (int c = 0; c < L; c++) {
+                            yRe[c] += w * re[c];
+                            yIm[c] += w * im[c];
+                        }
+                    }
+                }
+
+                // Squelch on the RMS amplitude of the chunk
+                for (int c = 0; c < L; c++) { pPower[c] = 0.0f; }
+                for (int t = 0; t < count; t++) {
+                    const float* yRe = &filtRe[t * L];
+                    const float* yIm = &filtIm[t * L];
+                    for (int c = 0; c < L; c++) { pPower[c] += yRe[c] * yRe[c] + yIm[c] * yIm[c]; }
+                }
+                for (int c = 0; c < n; c++) {
+                    level[c] = 5.0f * log10f(std::max<float>(pPower[c] / (float)count, 1e-20f));
+                    open[c] = (level[c] >= squelchLevel);
+                    mixGain[c] = open[c] ? gainSnapshot[c] : 0.0f;
+                }
+
+                // Quadrature demodulation and deemphasis
+                for (int t = 0; t < count; t++) {
+                    const float* yRe = &filtRe[t * L];
+                    const float* yIm = &filtIm[t * L];
+                    float* a = &audio[t * L];
+                    for (int c = 0; c < L; c++) {
+                        float re = yRe[c] * pLastRe[c] + yIm[c] * pLastIm[c];
+                        float im = yIm[c] * pLastRe[c] - yRe[c] * pLastIm[c];
+                        pLastRe[c] = yRe[c];
+                        pLastIm[c] = yIm[c];
+                        pDeemp[c] += alpha * (laneAtan2(im, re) * norm - pDeemp[c]);
+                        a[c] = pDeemp[c];
+                    }
+                }
+
+                // Mix the open channels
+                for (int t = 0; t < count; t++) {
+                    const float* a = &audio[t * L];
+                    float sum = 0.0f;
+                    for (int c = 0; c < L; c++) { sum += pMixGain[c] * a[c]; }
+                    mix[i + t] = { sum, sum };
+                }
+
+                // Keep the end of the chunk as the history of the channel filter
+                memmove(histRe, &histRe[count * L], histLen * L * sizeof(float));
+                memmove(histIm, &histIm[count * L], histLen * L * sizeof(float));
+            }
+
+            // Publish the squelch state
+            std::lock_guard<std::mutex> lck(tuneMtx);
+            for (int c = 0; c < n; c++) {
+                sharedOpen[c] = open[c];
+                sharedLevel[c] = level[c];
+            }
+        }
+
+        double _bandwidth;
+        double _squelchLevel;
+        double _deempTau;
+        std::vector<double> _offsets;
+
+        std::vector<std::unique_ptr<stream<complex_t>>> chanStreams;
+        std::mutex tuneMtx;
+        std::vector<float> gain;
+        std::vector<lv_32fc_t> rotDelta;
+        std::vector<bool> sharedOpen;
+        std::vector<float> sharedLevel;
+
+        tap<float> filterTaps;
+        float invDeviation = 1.0f;
+        float deempAlpha = 1.0f;
+
+        // Per channel state, only touched by the DSP thread
+        std::vector<lv_32fc_t> rotPhase;
+        std::vector<lv_32fc_t> rotDeltaSnapshot;
+
+        // Per lane state, only touched by the DSP thread
+        int lanes = 0;
+        std::vector<float> lastRe;
+        std::vector<float> lastIm;
+        std::vector<float> deemp;
+        std::vector<float> power;
+        std::vector<float> mixGain;
+        std::vector<float> gainSnapshot;
+        std::vector<bool> open;
+        std::vector<float> level;
+
+        // Lane interleaved work buffers
+        int histLen = 0;
+        float* histRe = NULL;
+        float* histIm = NULL;
+        float* filtRe = NULL;
+        float* filtIm = NULL;
+        float* audio = NULL;
+    };
+}
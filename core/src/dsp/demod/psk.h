@@ -147,6 +147,7 @@ namespace dsp::demod {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_symbolrate / _samplerate);
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -14,7 +14,12 @@ namespace dsp::demod {
 
         Quadrature(stream<complex_t>* in, double deviation, double samplerate) { init(in, deviation, samplerate); }
 
-        
+        ~Quadrature() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(diff);
+        }
+
         virtual void init(stream<complex_t>* in, double deviation) {
             _invDeviation = 1.0 / deviation;
             base_type::init(in);
@@ -37,25 +42,37 @@ namespace dsp::demod {
         }
 
         inline int process(int count, complex_t* in, float* out) {
-            for (int i = 0; i < count; i++) {
-                float cphase = in[i].phase();
-                out[i] = math::normalizePhase(cphase - phase) * _invDeviation;
-                phase = cphase;
+            if (!count) { return 0; }
+            if (count > diffCapacity) {
+                buffer::free(diff);
+                diff = buffer::alloc<complex_t>(count);
+                diffCapacity = count;
             }
+
+            // The phase difference between two samples is the argument of x[n] * conj(x[n-1]), this avoids
+            // having to unwrap the phase and lets volk use its vectorized atan2 for the whole block
+            diff[0] = in[0] * last.conj();
+            volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)&diff[1], (lv_32fc_t*)&in[1], (lv_32fc_t*)in, count - 1);
+            last = in[count - 1];
+            volk_32fc_s32f_atan2_32f(out, (lv_32fc_t*)diff, 1.0f / _invDeviation, count);
             return count;
         }
 
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            phase = 0.0f;
+            last = { 1.0f, 0.0f };
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -64,6 +81,8 @@ namespace dsp::demod {
 
     protected:
         float _invDeviation;
-        float phase = 0.0f;
+        complex_t last = { 1.0f, 0.0f };
+        complex_t* diff = NULL;
+        int diffCapacity = 0;
     };
 }
\ No newline at end of file
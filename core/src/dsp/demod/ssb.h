@@ -24,9 +24,10 @@ namespace dsp::demod {
             _mode = mode;
             _bandwidth = bandwidth;
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
 
             xlator.init(NULL, getTranslation(), _samplerate);
-            agc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY);
+            agc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY, round(samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
 
             if constexpr (std::is_same_v<T, float>) {
                 agc.out.free();
@@ -58,7 +59,9 @@ namespace dsp::demod {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
             xlator.setOffset(getTranslation(), _samplerate);
+            agc.setLookahead(round(_samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
             base_type::tempStart();
         }
 
@@ -91,11 +94,22 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
-            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+            base_type::out.writeMeta.silent = false;
+            if (silence.skip(base_type::_in->readMeta, count)) {
+                memset(base_type::out.writeBuf, 0, count * sizeof(T));
+                base_type::out.writeMeta.silent = true;
+            }
+            else {
+                process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            }
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -118,6 +132,7 @@ namespace dsp::demod {
         Mode _mode;
         double _bandwidth;
         double _samplerate;
+        silence_tracker silence;
         channel::FrequencyXlator xlator;
         loop::AGC<float> agc;
 
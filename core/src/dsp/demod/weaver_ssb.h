@@ -0,0 +1,211 @@
+#pragma once
+#include "ssb.h"
+#include "../filter/decimating_fir.h"
+#include "../multirate/polyphase_resampler.h"
+#include "../taps/cache.h"
+
+// Lowest ratio of the intermediate samplerate to the bandwidth, the excess is left to the transitions of the decimation
+// and interpolation filters
+#define WEAVER_SSB_MIN_OVERSAMPLING 1.5
+
+namespace dsp::demod {
+    // SSB demodulator doing its own sideband filtering at a low intermediate rate, to be fed with the unfiltered output
+    // of a VFO centered on the passband. The band is decimated to about 1.5 times the bandwidth by a filter of relaxed
+    // transition, the sharp channel filter runs at that rate where it needs several times less taps per sample, then the
+    // band is interpolated back and shifted into place like dsp::demod::SSB. For a 2.8KHz channel at 24KHz this is about
+    // 15 times less multiply-accumulates than filtering the full rate IF.
+    template <class T>
+    class WeaverSSB : public Processor<complex_t, T> {
+        using base_type = Processor<complex_t, T>;
+    public:
+        using Mode = typename SSB<T>::Mode;
+
+        WeaverSSB() {}
+
+        WeaverSSB(stream<complex_t>* in, Mode mode, double bandwidth, double samplerate, double agcAttack, double agcDecay) { init(in, mode, bandwidth, samplerate, agcAttack, agcDecay); }
+
+        ~WeaverSSB() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            taps::cache::release(decimTaps);
+            taps::cache::release(chanTaps);
+            taps::cache::release(interpTaps);
+            buffer::free(lowBuf);
+            buffer::free(highBuf);
+            buffer::free(realBuf);
+        }
+
+        void init(stream<complex_t>* in, Mode mode, double bandwidth, double samplerate, double agcAttack, double agcDecay) {
+            _mode = mode;
+            _bandwidth = bandwidth;
+            _samplerate = samplerate;
+
+            generateTaps();
+            decim.init(NULL, decimTaps, _decimation);
+            chanFilter.init(NULL, chanTaps);
+            interp.init(NULL, _decimation, 1, interpTaps);
+            xlator.init(NULL, getTranslation(), _samplerate);
+            agc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY, round(samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
+
+            // Free useless buffers
+            decim.out.free();
+            chanFilter.out.free();
+            interp.out.free();
+            xlator.out.free();
+            agc.out.free();
+
+            base_type::init(in);
+        }
+
+        void setMode(Mode mode) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _mode = mode;
+            xlator.setOffset(getTranslation(), _samplerate);
+            base_type::tempStart();
+        }
+
+        void setBandwidth(double bandwidth) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _bandwidth = bandwidth;
+            reconfigure();
+            base_type::tempStart();
+        }
+
+        void setSamplerate(double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _samplerate = samplerate;
+            reconfigure();
+            agc.setLookahead(round(_samplerate * AGC_DEMOD_LOOKAHEAD_TIME));
+            base_type::tempStart();
+        }
+
+        void setAGCAttack(double attack) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            agc.setAttack(attack);
+        }
+
+        void setAGCDecay(double decay) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            agc.setDecay(decay);
+        }
+
+        int process(int count, const complex_t* in, T* out) {
+            int maxLow = (count / _decimation) + 1;
+            if (maxLow > lowCapacity) {
+                buffer::free(lowBuf);
+                buffer::free(highBuf);
+                buffer::free(realBuf);
+                lowBuf = buffer::alloc<complex_t>(maxLow);
+                highBuf = buffer::alloc<complex_t>(maxLow * _decimation);
+                realBuf = buffer::alloc<float>(maxLow * _decimation);
+                lowCapacity = maxLow;
+            }
+
+            // Narrow the band at the intermediate rate and bring it back
+            int lowCount = decim.process(count, in, lowBuf);
+            chanFilter.process(lowCount, lowBuf, lowBuf);
+            int outCount = interp.process(lowCount, lowBuf, highBuf);
+
+            // Move back sideband
+            xlator.process(outCount, highBuf, highBuf);
+
+            if constexpr (std::is_same_v<T, float>) {
+                convert::ComplexToReal::process(outCount, highBuf, out);
+                agc.process(outCount, out, out);
+            }
+            if constexpr (std::is_same_v<T, stereo_t>) {
+                convert::ComplexToReal::process(outCount, highBuf, realBuf);
+                agc.process(outCount, realBuf, realBuf);
+                convert::MonoToStereo::process(outCount, realBuf, out);
+            }
+
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return ((inputCount / _decimation) + 1) * _decimation; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        double getTranslation() {
+            if (_mode == Mode::USB) {
+                return _bandwidth / 2.0;
+            }
+            else if (_mode == Mode::LSB) {
+                return -_bandwidth / 2.0;
+            }
+            else {
+                return 0.0;
+            }
+        }
+
+        void generateTaps() {
+            taps::cache::release(decimTaps);
+            taps::cache::release(chanTaps);
+            taps::cache::release(interpTaps);
+
+            // The decimation and interpolation filters only need to keep their images off the passband
+            _decimation = std::max<int>(floor(_samplerate / (_bandwidth * WEAVER_SSB_MIN_OVERSAMPLING)), 1);
+            double lowSamplerate = _samplerate / (double)_decimation;
+            double transWidth = lowSamplerate - _bandwidth;
+            decimTaps = taps::cache::lowPass(lowSamplerate / 2.0, transWidth, _samplerate);
+            interpTaps = taps::cache::lowPass(lowSamplerate / 2.0, transWidth, _samplerate, false, _decimation);
+
+            // Same response as the filter of the VFO
+            double filterWidth = _bandwidth / 2.0;
+            chanTaps = taps::cache::lowPass(filterWidth, filterWidth * 0.1, lowSamplerate);
+        }
+
+        void reconfigure() {
+            generateTaps();
+            decim.setDecimation(_decimation);
+            decim.setTaps(decimTaps);
+            chanFilter.setTaps(chanTaps);
+            interp.setRatio(_decimation, 1, interpTaps);
+            xlator.setOffset(getTranslation(), _samplerate);
+
+            // The work buffers depend on the decimation, they are reallocated on the next block
+            lowCapacity = 0;
+        }
+
+        Mode _mode;
+        double _bandwidth;
+        double _samplerate;
+        int _decimation = 1;
+
+        tap<float> decimTaps;
+        tap<float> chanTaps;
+        tap<float> interpTaps;
+        filter::DecimatingFIR<complex_t, float> decim;
+        filter::FIR<complex_t, float> chanFilter;
+        multirate::PolyphaseResampler<complex_t> interp;
+        channel::FrequencyXlator xlator;
+        loop::AGC<float> agc;
+
+        complex_t* lowBuf = NULL;
+        complex_t* highBuf = NULL;
+        float* realBuf = NULL;
+        int lowCapacity = 0;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "packed_bits.h"
 
 namespace dsp::digital {
     class BinarySlicer : public Processor<float, uint8_t> {
@@ -22,10 +23,84 @@ namespace dsp::digital {
             if (count < 0) { return -1; }
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
             return count;
         }
     };
+
+    // Same as BinarySlicer with a packed bit output, see packed_bits.h
+    class PackedBinarySlicer : public Processor<float, uint64_t> {
+        using base_type = Processor<float, uint64_t>;
+    public:
+        PackedBinarySlicer() {}
+
+        PackedBinarySlicer(stream<float>* in) { init(in); }
+
+        void init(stream<float>* in) {
+            acc = 0;
+            accBits = 0;
+            base_type::init(in);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            acc = 0;
+            accBits = 0;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const float* in, uint64_t* out) {
+            int outCount = 0;
+            int i = 0;
+
+            // Complete the word started in the previous buffer
+            for (; accBits && i < count; i++) {
+                acc = (acc << 1) | (in[i] > 0.0f);
+                if (++accBits == 64) {
+                    out[outCount++] = acc;
+                    accBits = 0;
+                }
+            }
+
+            // Whole words, without carrying state through the loop so that it vectorizes
+            for (; i + 64 <= count; i += 64) {
+                uint64_t w = 0;
+                for (int j = 0; j < 64; j++) { w |= (uint64_t)(in[i + j] > 0.0f) << (63 - j); }
+                out[outCount++] = w;
+            }
+
+            // Keep the rest for the next buffer
+            for (; i < count; i++) {
+                acc = (acc << 1) | (in[i] > 0.0f);
+                accBits++;
+            }
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return (inputCount / 64) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / 64.0);
+
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        uint64_t acc = 0;
+        int accBits = 0;
+    };
 }
\ No newline at end of file
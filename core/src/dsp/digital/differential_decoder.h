@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "packed_bits.h"
 
 namespace dsp::digital {
     class DifferentialDecoder : public Processor<uint8_t, uint8_t> {
@@ -51,6 +52,7 @@ namespace dsp::digital {
             if (count < 0) { return -1; }
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -62,4 +64,61 @@ namespace dsp::digital {
         uint8_t _initSym;
         uint8_t _modulus;
     };
+
+    // Binary differential decoder on a packed bit stream, each output bit being the XOR of an input bit with the one
+    // before it. A whole word is decoded with a shift and a XOR
+    class PackedDifferentialDecoder : public Processor<uint64_t, uint64_t> {
+        using base_type = Processor<uint64_t, uint64_t>;
+    public:
+        PackedDifferentialDecoder() {}
+
+        PackedDifferentialDecoder(stream<uint64_t>* in, bool initBit = false) { init(in, initBit); }
+
+        void init(stream<uint64_t>* in, bool initBit = false) {
+            _initBit = initBit;
+            last = _initBit;
+            base_type::init(in);
+        }
+
+        void setInitBit(bool initBit) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _initBit = initBit;
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            last = _initBit;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const uint64_t* in, uint64_t* out) {
+            for (int i = 0; i < count; i++) {
+                uint64_t w = in[i];
+                out[i] = w ^ ((w >> 1) | (last << 63));
+                last = w & 1;
+            }
+            return count;
+        }
+
+        int maxOutputCount(int inputCount) { return inputCount; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+
+    protected:
+        uint64_t last;
+        bool _initBit;
+    };
 }
\ No newline at end of file
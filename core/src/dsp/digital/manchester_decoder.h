@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "packed_bits.h"
 
 namespace dsp::digital {
     class ManchesterDecoder : public Processor<uint8_t, uint8_t> {
@@ -32,6 +33,7 @@ namespace dsp::digital {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -44,4 +46,76 @@ namespace dsp::digital {
     protected:
         int offset = 0;
     };
+
+    // Same as ManchesterDecoder on a packed bit stream, keeping the first bit of each pair. The kept bits of a word
+    // are gathered with a few masks and shifts instead of one at a time
+    class PackedManchesterDecoder : public Processor<uint64_t, uint64_t> {
+        using base_type = Processor<uint64_t, uint64_t>;
+    public:
+        PackedManchesterDecoder() {}
+
+        PackedManchesterDecoder(stream<uint64_t>* in) { init(in); }
+
+        void init(stream<uint64_t>* in) {
+            half = 0;
+            halfFull = false;
+            base_type::init(in);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            half = 0;
+            halfFull = false;
+            base_type::tempStart();
+        }
+
+        // Keep the even bits counting from the first one, ie. the odd bits counting from the least significant one
+        static inline uint64_t compress(uint64_t x) {
+            x = (x >> 1) & 0x5555555555555555ULL;
+            x = (x | (x >> 1)) & 0x3333333333333333ULL;
+            x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+            x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+            x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+            x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+            return x;
+        }
+
+        inline int process(int count, const uint64_t* in, uint64_t* out) {
+            int outCount = 0;
+            for (int i = 0; i < count; i++) {
+                uint64_t bits = compress(in[i]);
+                if (halfFull) {
+                    out[outCount++] = (half << 32) | bits;
+                }
+                else {
+                    half = bits;
+                }
+                halfFull = !halfFull;
+            }
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return (inputCount / 2) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        uint64_t half = 0;
+        bool halfFull = false;
+    };
 }
\ No newline at end of file
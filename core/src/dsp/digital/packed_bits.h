@@ -0,0 +1,174 @@
+#pragma once
+#include "../processor.h"
+#include <stdint.h>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Packed bit streams carry 64 bits per uint64_t, the first bit in time being the most significant one. Blocks
+// producing them only output complete words, the bits that don't make up a word yet being kept for the next buffer
+
+namespace dsp::digital {
+    inline int popcount(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return (int)__popcnt64(x);
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    // Read count bits, at most 64, starting at bit pos of a packed buffer. They are returned in the low bits, the
+    // first one being the most significant
+    inline uint64_t readBits(const uint64_t* words, int64_t pos, int count) {
+        if (!count) { return 0; }
+        int64_t q = pos >> 6;
+        int r = pos & 63;
+        uint64_t v = words[q] << r;
+        if (r + count > 64) { v |= words[q + 1] >> (64 - r); }
+        return v >> (64 - count);
+    }
+
+    // Finds a sync word of up to 64 bits in a packed bit stream, allowing for a number of bit errors. Every alignment
+    // of a word is compared at once with a XOR and a popcount, instead of shifting the stream in a bit at a time. The
+    // last bits of the previous buffer are kept so that sync words spanning two buffers are found
+    class SyncCorrelator {
+    public:
+        SyncCorrelator() {}
+
+        SyncCorrelator(uint64_t sync, int bits, int maxErrors) { init(sync, bits, maxErrors); }
+
+        // sync holds the bits in its low bits, the first one being the most significant
+        void init(uint64_t sync, int bits, int maxErrors) {
+            _bits = bits;
+            _mask = (bits >= 64) ? ~0ULL : ((1ULL << bits) - 1);
+            _sync = sync & _mask;
+            _maxErrors = maxErrors;
+            reset();
+        }
+
+        void reset() {
+            history = 0;
+            seen = 0;
+        }
+
+        // Search a buffer of count words from bit from. Returns the position of the bit following the first sync word
+        // found, so that its last bit is at the returned position minus one, or -1 if none was found. The position
+        // can be 64 * count when the sync word ends the buffer. errors is set to the number of bits that differed.
+        // Once the search of a buffer is over, call next() before searching the following one
+        int64_t find(const uint64_t* words, int count, int64_t from, int* errors = NULL) {
+            int64_t end = (int64_t)count * 64;
+            for (int64_t e = std::max<int64_t>(from, 1); e <= end; e++) {
+                // Make sure enough bits were seen for a whole sync word
+                if (seen + e < _bits) { continue; }
+
+                // The 64 bits before position e, taken from the previous buffer for the first word
+                int64_t q = (e - 1) >> 6;
+                int r = e & 63;
+                uint64_t prev = q ? words[q - 1] : history;
+                uint64_t window = r ? ((prev << r) | (words[q] >> (64 - r))) : words[q];
+
+                int d = popcount((window ^ _sync) & _mask);
+                if (d <= _maxErrors) {
+                    if (errors) { *errors = d; }
+                    return e;
+                }
+            }
+            return -1;
+        }
+
+        // Register the end of a buffer, its last word becoming the history of the next search
+        void next(const uint64_t* words, int count) {
+            if (!count) { return; }
+            history = words[count - 1];
+            seen = std::min<int64_t>(seen + (int64_t)count * 64, 64);
+        }
+
+    private:
+        uint64_t _sync = 0;
+        uint64_t _mask = 0;
+        int _bits = 0;
+        int _maxErrors = 0;
+        uint64_t history = 0;
+        int64_t seen = 0;
+    };
+
+    // Packs a stream of one bit per byte, with bits 0 or 1, into a packed bit stream, for producers of single bits to
+    // feed the packed blocks
+    class BitPacker : public Processor<uint8_t, uint64_t> {
+        using base_type = Processor<uint8_t, uint64_t>;
+    public:
+        BitPacker() {}
+
+        BitPacker(stream<uint8_t>* in) { init(in); }
+
+        void init(stream<uint8_t>* in) {
+            acc = 0;
+            accBits = 0;
+            base_type::init(in);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            acc = 0;
+            accBits = 0;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const uint8_t* in, uint64_t* out) {
+            int outCount = 0;
+            int i = 0;
+
+            // Complete the word started in the previous buffer
+            for (; accBits && i < count; i++) {
+                acc = (acc << 1) | (in[i] & 1);
+                if (++accBits == 64) {
+                    out[outCount++] = acc;
+                    accBits = 0;
+                }
+            }
+
+            // Whole words, without carrying state through the loop so that it vectorizes
+            for (; i + 64 <= count; i += 64) {
+                uint64_t w = 0;
+                for (int j = 0; j < 64; j++) { w |= (uint64_t)(in[i + j] & 1) << (63 - j); }
+                out[outCount++] = w;
+            }
+
+            // Keep the rest for the next buffer
+            for (; i < count; i++) {
+                acc = (acc << 1) | (in[i] & 1);
+                accBits++;
+            }
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return (inputCount / 64) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / 64.0);
+
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        uint64_t acc = 0;
+        int accBits = 0;
+    };
+}
@@ -0,0 +1,248 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define REED_SOLOMON_DECODER_SSSE3
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define REED_SOLOMON_DECODER_NEON
+#endif
+
+namespace dsp::digital {
+    // Reed-Solomon decoder for (255, 255 - roots) codes over GF(256), a drop-in for libcorrect's
+    // correct_reed_solomon_decode(). The generator roots are alpha^(rootGap * (firstRoot + i)) and the codewords are
+    // sent message first, highest order coefficient first. Since most blocks on a good link are error free, the
+    // syndromes are computed first, for all roots at once using nibble lookup tables where SSSE3 or NEON is
+    // available, and the actual decoding only runs for codewords that need it. Codewords interleaved byte by byte can
+    // be decoded straight from the frame.
+    class ReedSolomonDecoder {
+    public:
+        ReedSolomonDecoder() {}
+
+        ReedSolomonDecoder(uint16_t primitivePoly, int firstRoot, int rootGap, int roots) { init(primitivePoly, firstRoot, rootGap, roots); }
+
+        void init(uint16_t primitivePoly, int firstRoot, int rootGap, int roots) {
+            if (roots <= 0 || roots > 64 || roots % 2) {
+                throw std::runtime_error("Unsupported number of Reed-Solomon roots");
+            }
+            _firstRoot = firstRoot;
+            _rootGap = rootGap;
+            _roots = roots;
+            msgLen = 255 - roots;
+
+            // Field tables, alpha being x
+            int element = 1;
+            for (int i = 0; i < 255; i++) {
+                expTab[i] = element;
+                expTab[i + 255] = element;
+                logTab[element] = i;
+                element <<= 1;
+                if (element & 0x100) { element ^= primitivePoly; }
+            }
+            logTab[0] = 0;
+
+            // The positions are found back from powers of alpha^rootGap, which must then be a primitive element
+            for (int f : { 3, 5, 17 }) {
+                if (rootGap % f == 0) { throw std::runtime_error("Reed-Solomon root gap must be coprime with 255"); }
+            }
+
+            // Per root multiplication tables for the scalar syndromes
+            rootMul.resize(roots * 256);
+            for (int i = 0; i < roots; i++) {
+                int rootLog = (rootGap * (firstRoot + i)) % 255;
+                for (int x = 0; x < 256; x++) {
+                    rootMul[i * 256 + x] = x ? expTab[(logTab[x] + rootLog) % 255] : 0;
+                }
+            }
+
+#if defined(REED_SOLOMON_DECODER_SSSE3) || defined(REED_SOLOMON_DECODER_NEON)
+            // The syndromes are the sum of each byte times the powers of the roots for its position. Those powers are
+            // kept split into nibbles, and each byte value gets nibble tables of its products
+            lanes = ((roots + 15) / 16) * 16;
+            powLo.assign(255 * lanes, 0);
+            powHi.assign(255 * lanes, 0);
+            for (int j = 0; j < 255; j++) {
+                for (int i = 0; i < roots; i++) {
+                    int p = expTab[((rootGap * (firstRoot + i)) % 255) * (254 - j) % 255];
+                    powLo[j * lanes + i] = p & 0xF;
+                    powHi[j * lanes + i] = p >> 4;
+                }
+            }
+            for (int c = 0; c < 256; c++) {
+                for (int n = 0; n < 16; n++) {
+                    nibLo[c][n] = mul(c, n);
+                    nibHi[c][n] = mul(c, n << 4);
+                }
+            }
+#endif
+        }
+
+        // Number of message bytes in a codeword
+        int getMessageLength() { return msgLen; }
+
+        // Decode a 255 byte codeword. Returns the message length or -1 if it couldn't be corrected
+        int decode(const uint8_t* in, uint8_t* out) {
+            return decodeStrided(in, 1, out);
+        }
+
+        // Decode count codewords interleaved byte by byte, byte j of codeword k being in[j*count + k]. The messages
+        // are written one after the other. Returns the number of codewords that couldn't be corrected, 0 on success
+        int decodeInterleaved(const uint8_t* in, int count, uint8_t* out) {
+            int failed = 0;
+            for (int k = 0; k < count; k++) {
+                if (decodeStrided(&in[k], count, &out[k * msgLen]) < 0) { failed++; }
+            }
+            return failed;
+        }
+
+    private:
+        inline uint8_t mul(int a, int b) {
+            if (!a || !b) { return 0; }
+            return expTab[logTab[a] + logTab[b]];
+        }
+
+        int decodeStrided(const uint8_t* in, int stride, uint8_t* out) {
+            uint8_t synd[64];
+            if (!syndromes(in, stride, synd)) {
+                for (int j = 0; j < msgLen; j++) { out[j] = in[j * stride]; }
+                return msgLen;
+            }
+
+            // Gather the codeword and correct it
+            uint8_t cw[255];
+            for (int j = 0; j < 255; j++) { cw[j] = in[j * stride]; }
+            if (!correct(cw, synd)) { return -1; }
+            memcpy(out, cw, msgLen);
+            return msgLen;
+        }
+
+        // Compute the syndromes, returns false if they're all zero
+        bool syndromes(const uint8_t* in, int stride, uint8_t* synd) {
+#if defined(REED_SOLOMON_DECODER_SSSE3)
+            for (int l = 0; l < lanes; l += 16) {
+                __m128i acc = _mm_setzero_si128();
+                for (int j = 0; j < 255; j++) {
+                    uint8_t c = in[j * stride];
+                    __m128i lo = _mm_loadu_si128((const __m128i*)&powLo[j * lanes + l]);
+                    __m128i hi = _mm_loadu_si128((const __m128i*)&powHi[j * lanes + l]);
+                    __m128i tlo = _mm_loadu_si128((const __m128i*)nibLo[c]);
+                    __m128i thi = _mm_loadu_si128((const __m128i*)nibHi[c]);
+                    acc = _mm_xor_si128(acc, _mm_xor_si128(_mm_shuffle_epi8(tlo, lo), _mm_shuffle_epi8(thi, hi)));
+                }
+                _mm_storeu_si128((__m128i*)&lanesBuf[l], acc);
+            }
+            memcpy(synd, lanesBuf, _roots);
+#elif defined(REED_SOLOMON_DECODER_NEON)
+            for (int l = 0; l < lanes; l += 16) {
+                uint8x16_t acc = vdupq_n_u8(0);
+                for (int j = 0; j < 255; j++) {
+                    uint8_t c = in[j * stride];
+                    uint8x16_t lo = vld1q_u8(&powLo[j * lanes + l]);
+                    uint8x16_t hi = vld1q_u8(&powHi[j * lanes + l]);
+                    acc = veorq_u8(acc, veorq_u8(vqtbl1q_u8(vld1q_u8(nibLo[c]), lo), vqtbl1q_u8(vld1q_u8(nibHi[c]), hi)));
+                }
+                vst1q_u8(&lanesBuf[l], acc);
+            }
+            memcpy(synd, lanesBuf, _roots);
+#else
+            // Horner's rule with a multiplication table per root
+            memset(synd, 0, _roots);
+            for (int j = 0; j < 255; j++) {
+                uint8_t c = in[j * stride];
+                for (int i = 0; i < _roots; i++) { synd[i] = rootMul[i * 256 + synd[i]] ^ c; }
+            }
+#endif
+            uint8_t any = 0;
+            for (int i = 0; i < _roots; i++) { any |= synd[i]; }
+            return any;
+        }
+
+        // Berlekamp-Massey, Chien search and Forney's algorithm. The locators are X = beta^p, beta = alpha^rootGap,
+        // p being the degree of the erroneous coefficient
+        bool correct(uint8_t* cw, const uint8_t* synd) {
+            uint8_t lambda[65] = { 1 };
+            uint8_t prev[65] = { 1 };
+            uint8_t tmp[65];
+            int L = 0;
+            int m = 1;
+            uint8_t b = 1;
+            for (int n = 0; n < _roots; n++) {
+                uint8_t d = synd[n];
+                for (int i = 1; i <= L; i++) { d ^= mul(lambda[i], synd[n - i]); }
+                if (!d) {
+                    m++;
+                    continue;
+                }
+                uint8_t coef = expTab[(logTab[d] + 255 - logTab[b]) % 255];
+                memcpy(tmp, lambda, sizeof(tmp));
+                for (int i = 0; i + m <= _roots; i++) { lambda[i + m] ^= mul(coef, prev[i]); }
+                if (2 * L <= n) {
+                    L = n + 1 - L;
+                    memcpy(prev, tmp, sizeof(prev));
+                    b = d;
+                    m = 1;
+                }
+                else {
+                    m++;
+                }
+            }
+            if (L > _roots / 2) { return false; }
+
+            // Error evaluator, omega = S * lambda mod z^roots
+            uint8_t omega[64] = { 0 };
+            for (int i = 0; i < _roots; i++) {
+                for (int j = 0; j <= std::min<int>(i, L); j++) { omega[i] ^= mul(synd[i - j], lambda[j]); }
+            }
+
+            // Find the roots of lambda, X^-1 = beta^-p
+            int found = 0;
+            for (int p = 0; p < 255 && found < L; p++) {
+                int xInvLog = (255 - (_rootGap * p) % 255) % 255;
+                uint8_t v = 0;
+                for (int i = 0; i <= L; i++) {
+                    if (lambda[i]) { v ^= expTab[(logTab[lambda[i]] + xInvLog * i) % 255]; }
+                }
+                if (v) { continue; }
+
+                // Forney: e = X^(1 - firstRoot) * omega(X^-1) / lambda'(X^-1)
+                uint8_t num = 0;
+                for (int i = 0; i < _roots; i++) {
+                    if (omega[i]) { num ^= expTab[(logTab[omega[i]] + xInvLog * i) % 255]; }
+                }
+                uint8_t den = 0;
+                for (int i = 1; i <= L; i += 2) {
+                    if (lambda[i]) { den ^= expTab[(logTab[lambda[i]] + xInvLog * (i - 1)) % 255]; }
+                }
+                if (!den) { return false; }
+                int xLog = (_rootGap * p) % 255;
+                int eLog = ((logTab[num] + 255 - logTab[den]) + xLog * ((1 - _firstRoot) % 255 + 255)) % 255;
+                if (num) { cw[254 - p] ^= expTab[eLog]; }
+                found++;
+            }
+            return found == L;
+        }
+
+        int _firstRoot = 0;
+        int _rootGap = 1;
+        int _roots = 0;
+        int msgLen = 0;
+
+        uint8_t expTab[510];
+        int logTab[256];
+        std::vector<uint8_t> rootMul;
+
+#if defined(REED_SOLOMON_DECODER_SSSE3) || defined(REED_SOLOMON_DECODER_NEON)
+        int lanes = 0;
+        std::vector<uint8_t> powLo;
+        std::vector<uint8_t> powHi;
+        alignas(16) uint8_t nibLo[256][16];
+        alignas(16) uint8_t nibHi[256][16];
+        alignas(16) uint8_t lanesBuf[64];
+#endif
+    };
+}
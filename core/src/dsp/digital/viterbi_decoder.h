@@ -0,0 +1,274 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VITERBI_DECODER_SSE2
+#define VITERBI_DECODER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VITERBI_DECODER_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VITERBI_DECODER_NEON
+#endif
+
+namespace dsp::digital {
+    // Soft decision Viterbi decoder for rate 1/2 convolutional codes, a drop-in for libcorrect's
+    // correct_convolutional_decode_soft(). The polynomials, soft symbols (0 for a 0 bit, 255 for a 1 bit and 128 for
+    // an erasure) and output follow its conventions. The encoder starts in state 0 and its last order - 1 input bits
+    // are zero. The add-compare-select runs on 16 bit metrics eight or sixteen states at a time for K=5 and K=7,
+    // other orders up to 9 going through a plain loop.
+    class ViterbiDecoder {
+    public:
+        ViterbiDecoder() {}
+
+        ViterbiDecoder(int order, const uint16_t* polys) { init(order, polys); }
+
+        void init(int order, const uint16_t* polys) {
+            if (order < 3 || order > 9) {
+                throw std::runtime_error("Unsupported convolutional code order");
+            }
+            _order = order;
+            states = 1 << (order - 1);
+            half = states / 2;
+
+            // Sign masks of the two output bits for each butterfly and path, -1 where the bit is expected to be 1.
+            // Paths 0 and 1 are input 0 from the predecessor with its oldest bit cleared and set, 2 and 3 input 1
+            int size = ((half + 15) / 16) * 16;
+            for (int path = 0; path < 4; path++) {
+                for (int k = 0; k < 2; k++) {
+                    sign[path][k].assign(size, 0);
+                    for (int j = 0; j < half; j++) {
+                        int reg = (j << 1) | (path >> 1) | ((path & 1) ? states : 0);
+                        sign[path][k][j] = parity(reg & polys[k]) ? -1 : 0;
+                    }
+                }
+            }
+
+            metrics.assign(states, 0);
+            next.assign(states, 0);
+            decWords = (states * 2 + 63) / 64;
+        }
+
+        // Decode bits soft symbols, two per trellis step, into bytes MSB first. Returns the number of whole bytes
+        // written, the decoded message being bits / 2 - order + 1 bits long
+        int decode(const uint8_t* soft, int bits, uint8_t* out) {
+            int steps = bits / 2;
+            int outBits = steps - _order + 1;
+            if (outBits <= 0) { return 0; }
+            decisions.resize(steps * decWords);
+
+            // Only state 0 is valid at the start
+            std::fill(metrics.begin(), metrics.end(), INT16_MIN / 2);
+            metrics[0] = 0;
+
+            for (int t = 0; t < steps; t++) {
+                // Metric is +sym for an expected 1 and -sym for an expected 0
+                int16_t sym0 = (int16_t)soft[2*t] - 128;
+                int16_t sym1 = (int16_t)soft[2*t + 1] - 128;
+                uint64_t* dec = &decisions[t * decWords];
+                memset(dec, 0, decWords * sizeof(uint64_t));
+#if defined(VITERBI_DECODER_AVX2)
+                if (half % 16 == 0) { stepAVX2(sym0, sym1, dec); }
+                else
+#endif
+#if defined(VITERBI_DECODER_SSE2)
+                if (half % 8 == 0) { stepSSE2(sym0, sym1, dec); }
+                else
+#elif defined(VITERBI_DECODER_NEON)
+                if (half % 8 == 0) { stepNEON(sym0, sym1, dec); }
+                else
+#endif
+                { stepGeneric(sym0, sym1, dec); }
+                metrics.swap(next);
+            }
+
+            // Trace back from state 0, the input bit of each step being the newest bit of the state it led to
+            int bytes = outBits / 8;
+            memset(out, 0, bytes);
+            int state = 0;
+            for (int t = steps - 1; t >= 0; t--) {
+                if (t < bytes * 8) { out[t >> 3] |= (state & 1) << (7 - (t & 7)); }
+                int j = state >> 1;
+                int idx = ((j >> 3) << 4) | ((state & 1) << 3) | (j & 7);
+                bool fromB = (decisions[t * decWords + (idx >> 6)] >> (idx & 63)) & 1;
+                state = fromB ? (j + half) : j;
+            }
+            return bytes;
+        }
+
+    private:
+        static int parity(int x) {
+            int p = 0;
+            for (; x; x >>= 1) { p ^= x & 1; }
+            return p;
+        }
+
+        static inline int16_t branch(int16_t mask0, int16_t mask1, int16_t sym0, int16_t sym1) {
+            return ((sym0 ^ mask0) - mask0) + ((sym1 ^ mask1) - mask1);
+        }
+
+        static inline int16_t sat(int x) {
+            return (x > INT16_MAX) ? INT16_MAX : ((x < INT16_MIN) ? INT16_MIN : x);
+        }
+
+        // Decisions are laid out in groups of 8 butterflies: 8 bits for input 0 then 8 for input 1
+        void stepGeneric(int16_t sym0, int16_t sym1, uint64_t* dec) {
+            int16_t* m = metrics.data();
+            int16_t* n = next.data();
+            for (int j = 0; j < half; j++) {
+                int16_t a = m[j];
+                int16_t b = m[j + half];
+                for (int bit = 0; bit < 2; bit++) {
+                    int va = sat(a - branch(sign[bit*2][0][j], sign[bit*2][1][j], sym0, sym1));
+                    int vb = sat(b - branch(sign[bit*2 + 1][0][j], sign[bit*2 + 1][1][j], sym0, sym1));
+                    n[(j << 1) | bit] = (vb > va) ? vb : va;
+                    int idx = ((j >> 3) << 4) | (bit << 3) | (j & 7);
+                    if (vb > va) { dec[idx >> 6] |= 1ull << (idx & 63); }
+                }
+            }
+            int16_t ref = n[0];
+            for (int i = 0; i < states; i++) { n[i] -= ref; }
+        }
+
+#if defined(VITERBI_DECODER_SSE2)
+        void stepSSE2(int16_t sym0, int16_t sym1, uint64_t* dec) {
+            const __m128i s0 = _mm_set1_epi16(sym0);
+            const __m128i s1 = _mm_set1_epi16(sym1);
+            const int16_t* m = metrics.data();
+            int16_t* n = next.data();
+            uint16_t* d = (uint16_t*)dec;
+            for (int j = 0; j < half; j += 8) {
+                __m128i a = _mm_loadu_si128((const __m128i*)&m[j]);
+                __m128i b = _mm_loadu_si128((const __m128i*)&m[j + half]);
+                __m128i na[2], nb[2];
+                for (int bit = 0; bit < 2; bit++) {
+                    __m128i bma = branchSSE2(bit*2, j, s0, s1);
+                    __m128i bmb = branchSSE2(bit*2 + 1, j, s0, s1);
+                    na[bit] = _mm_subs_epi16(a, bma);
+                    nb[bit] = _mm_subs_epi16(b, bmb);
+                }
+                __m128i n0 = _mm_max_epi16(na[0], nb[0]);
+                __m128i n1 = _mm_max_epi16(na[1], nb[1]);
+                __m128i d0 = _mm_cmpgt_epi16(nb[0], na[0]);
+                __m128i d1 = _mm_cmpgt_epi16(nb[1], na[1]);
+                _mm_storeu_si128((__m128i*)&n[2*j], _mm_unpacklo_epi16(n0, n1));
+                _mm_storeu_si128((__m128i*)&n[2*j + 8], _mm_unpackhi_epi16(n0, n1));
+                d[j >> 3] = _mm_movemask_epi8(_mm_packs_epi16(d0, d1));
+            }
+            renormSSE2(n);
+        }
+
+        // Branch metrics of a path for 8 butterflies, computed as -sym where a 1 is expected and +sym otherwise
+        inline __m128i branchSSE2(int path, int j, __m128i s0, __m128i s1) {
+            __m128i m0 = _mm_loadu_si128((const __m128i*)&sign[path][0][j]);
+            __m128i m1 = _mm_loadu_si128((const __m128i*)&sign[path][1][j]);
+            __m128i b0 = _mm_sub_epi16(_mm_xor_si128(s0, m0), m0);
+            __m128i b1 = _mm_sub_epi16(_mm_xor_si128(s1, m1), m1);
+            return _mm_adds_epi16(b0, b1);
+        }
+
+        inline void renormSSE2(int16_t* n) {
+            __m128i ref = _mm_set1_epi16(n[0]);
+            for (int i = 0; i < states; i += 8) {
+                __m128i v = _mm_loadu_si128((const __m128i*)&n[i]);
+                _mm_storeu_si128((__m128i*)&n[i], _mm_subs_epi16(v, ref));
+            }
+        }
+#endif
+
+#if defined(VITERBI_DECODER_AVX2)
+        void stepAVX2(int16_t sym0, int16_t sym1, uint64_t* dec) {
+            const __m256i s0 = _mm256_set1_epi16(sym0);
+            const __m256i s1 = _mm256_set1_epi16(sym1);
+            const int16_t* m = metrics.data();
+            int16_t* n = next.data();
+            uint32_t* d = (uint32_t*)dec;
+            for (int j = 0; j < half; j += 16) {
+                __m256i a = _mm256_loadu_si256((const __m256i*)&m[j]);
+                __m256i b = _mm256_loadu_si256((const __m256i*)&m[j + half]);
+                __m256i na[2], nb[2];
+                for (int bit = 0; bit < 2; bit++) {
+                    na[bit] = _mm256_subs_epi16(a, branchAVX2(bit*2, j, s0, s1));
+                    nb[bit] = _mm256_subs_epi16(b, branchAVX2(bit*2 + 1, j, s0, s1));
+                }
+                __m256i n0 = _mm256_max_epi16(na[0], nb[0]);
+                __m256i n1 = _mm256_max_epi16(na[1], nb[1]);
+                __m256i d0 = _mm256_cmpgt_epi16(nb[0], na[0]);
+                __m256i d1 = _mm256_cmpgt_epi16(nb[1], na[1]);
+
+                // The unpacks work within each 128 bit lane, put the states back in order
+                __m256i lo = _mm256_unpacklo_epi16(n0, n1);
+                __m256i hi = _mm256_unpackhi_epi16(n0, n1);
+                _mm256_storeu_si256((__m256i*)&n[2*j], _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256((__m256i*)&n[2*j + 16], _mm256_permute2x128_si256(lo, hi, 0x31));
+
+                // Packing also works per lane, which gives the same layout as two SSE2 groups
+                d[j >> 4] = _mm256_movemask_epi8(_mm256_packs_epi16(d0, d1));
+            }
+            renormSSE2(n);
+        }
+
+        inline __m256i branchAVX2(int path, int j, __m256i s0, __m256i s1) {
+            __m256i m0 = _mm256_loadu_si256((const __m256i*)&sign[path][0][j]);
+            __m256i m1 = _mm256_loadu_si256((const __m256i*)&sign[path][1][j]);
+            __m256i b0 = _mm256_sub_epi16(_mm256_xor_si256(s0, m0), m0);
+            __m256i b1 = _mm256_sub_epi16(_mm256_xor_si256(s1, m1), m1);
+            return _mm256_adds_epi16(b0, b1);
+        }
+#endif
+
+#if defined(VITERBI_DECODER_NEON)
+        void stepNEON(int16_t sym0, int16_t sym1, uint64_t* dec) {
+            static const uint16_t weights[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+            const int16x8_t s0 = vdupq_n_s16(sym0);
+            const int16x8_t s1 = vdupq_n_s16(sym1);
+            const uint16x8_t w = vld1q_u16(weights);
+            const int16_t* m = metrics.data();
+            int16_t* n = next.data();
+            uint16_t* d = (uint16_t*)dec;
+            for (int j = 0; j < half; j += 8) {
+                int16x8_t a = vld1q_s16(&m[j]);
+                int16x8_t b = vld1q_s16(&m[j + half]);
+                int16x8_t na[2], nb[2];
+                for (int bit = 0; bit < 2; bit++) {
+                    na[bit] = vqsubq_s16(a, branchNEON(bit*2, j, s0, s1));
+                    nb[bit] = vqsubq_s16(b, branchNEON(bit*2 + 1, j, s0, s1));
+                }
+                int16x8x2_t z = vzipq_s16(vmaxq_s16(na[0], nb[0]), vmaxq_s16(na[1], nb[1]));
+                vst1q_s16(&n[2*j], z.val[0]);
+                vst1q_s16(&n[2*j + 8], z.val[1]);
+                uint16_t d0 = vaddvq_u16(vandq_u16(vcgtq_s16(nb[0], na[0]), w));
+                uint16_t d1 = vaddvq_u16(vandq_u16(vcgtq_s16(nb[1], na[1]), w));
+                d[j >> 3] = d0 | (d1 << 8);
+            }
+            int16x8_t ref = vdupq_n_s16(n[0]);
+            for (int i = 0; i < states; i += 8) { vst1q_s16(&n[i], vqsubq_s16(vld1q_s16(&n[i]), ref)); }
+        }
+
+        inline int16x8_t branchNEON(int path, int j, int16x8_t s0, int16x8_t s1) {
+            int16x8_t m0 = vld1q_s16(&sign[path][0][j]);
+            int16x8_t m1 = vld1q_s16(&sign[path][1][j]);
+            int16x8_t b0 = vsubq_s16(veorq_s16(s0, m0), m0);
+            int16x8_t b1 = vsubq_s16(veorq_s16(s1, m1), m1);
+            return vqaddq_s16(b0, b1);
+        }
+#endif
+
+        int _order = 0;
+        int states = 0;
+        int half = 0;
+        int decWords = 0;
+
+        std::vector<int16_t> sign[4][2];
+
+        std::vector<int16_t> metrics;
+        std::vector<int16_t> next;
+        std::vector<uint64_t> decisions;
+    };
+}
@@ -0,0 +1,163 @@
+#include "plan.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <utils/flog.h>
+
+namespace dsp::fft {
+    static std::mutex plannerMtx;
+
+    static std::string wisdomPath;
+    static std::mutex jobMtx;
+    static std::condition_variable jobCV;
+    static std::deque<std::pair<int, int>> jobs;
+    static std::vector<Plan*> waiting;
+    static std::thread* worker = NULL;
+    static bool stopWorker = false;
+
+    std::mutex& plannerMutex() {
+        return plannerMtx;
+    }
+
+    static void measure(int size, int sign) {
+        // Measure the size on scratch buffers since measuring overwrites them
+        fftwf_complex* in = fftwf_alloc_complex(size);
+        fftwf_complex* out = fftwf_alloc_complex(size);
+        flog::info("Measuring FFT plan of size {}", size);
+        std::lock_guard<std::mutex> lck(plannerMtx);
+        fftwf_set_timelimit(FFT_WISDOM_TIME_LIMIT);
+        fftwf_plan p = fftwf_plan_dft_1d(size, in, out, sign, FFT_WISDOM_FLAGS);
+        fftwf_set_timelimit(-1.0);
+        if (p) { fftwf_destroy_plan(p); }
+
+        // Save it for next time
+        if (!fftwf_export_wisdom_to_filename(wisdomPath.c_str())) {
+            flog::warn("Could not save FFTW wisdom to '{}'", wisdomPath);
+        }
+
+        // Give the plans waiting for that size their measured version, made from the wisdom so it's immediate
+        {
+            std::lock_guard<std::mutex> lck2(jobMtx);
+            for (auto it = waiting.begin(); it != waiting.end();) {
+                Plan* plan = *it;
+                if (plan->_size != size || plan->_sign != sign) {
+                    it++;
+                    continue;
+                }
+                plan->measured.store(fftwf_plan_dft_1d(size, in, out, sign, FFT_WISDOM_FLAGS | FFTW_WISDOM_ONLY), std::memory_order_release);
+                it = waiting.erase(it);
+            }
+        }
+
+        fftwf_free(in);
+        fftwf_free(out);
+    }
+
+    static void workerLoop() {
+        while (true) {
+            std::pair<int, int> job;
+            {
+                std::unique_lock<std::mutex> lck(jobMtx);
+                jobCV.wait(lck, [] { return !jobs.empty() || stopWorker; });
+                if (stopWorker) { return; }
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            measure(job.first, job.second);
+
+            // Let the threads that waited on the planner lock take it before measuring the next size
+            std::this_thread::yield();
+        }
+    }
+
+    void loadWisdom(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lck(plannerMtx);
+            wisdomPath = path;
+            if (!fftwf_import_wisdom_from_filename(path.c_str())) {
+                flog::info("No FFTW wisdom loaded from '{}', FFT sizes will be measured on first use", path);
+            }
+        }
+
+        // Start the background planner
+        std::lock_guard<std::mutex> lck(jobMtx);
+        if (worker) { return; }
+        stopWorker = false;
+
+        // Never destroyed so that exiting without stopping it doesn't terminate the process
+        worker = new std::thread(workerLoop);
+    }
+
+    void stopWisdom() {
+        {
+            std::lock_guard<std::mutex> lck(jobMtx);
+            stopWorker = true;
+        }
+        jobCV.notify_all();
+        if (worker && worker->joinable()) { worker->join(); }
+    }
+
+    Plan::~Plan() {
+        destroy();
+    }
+
+    void Plan::create(int size, fftwf_complex* in, fftwf_complex* out, int sign) {
+        destroy();
+        _size = size;
+        _sign = sign;
+        _in = in;
+        _out = out;
+
+#ifdef SDRPP_USE_ACCELERATE
+        // Let vDSP run the size if it supports it
+        dft = vDSP_DFT_zop_CreateSetup(NULL, size, (sign == FFTW_FORWARD) ? vDSP_DFT_FORWARD : vDSP_DFT_INVERSE);
+        if (dft) {
+            split.realp = (float*)fftwf_malloc(size * sizeof(float));
+            split.imagp = (float*)fftwf_malloc(size * sizeof(float));
+            return;
+        }
+#endif
+
+        std::lock_guard<std::mutex> lck(plannerMtx);
+
+        // Use the wisdom if this size was already measured
+        plan = fftwf_plan_dft_1d(size, in, out, sign, FFT_WISDOM_FLAGS | FFTW_WISDOM_ONLY);
+        fromWisdom = (plan != NULL);
+        if (fromWisdom) { return; }
+
+        // Otherwise start with an estimated plan and measure it in the background if possible
+        plan = fftwf_plan_dft_1d(size, in, out, sign, FFTW_ESTIMATE);
+        std::lock_guard<std::mutex> lck2(jobMtx);
+        if (!worker || stopWorker) { return; }
+        waiting.push_back(this);
+        auto job = std::make_pair(size, sign);
+        if (std::find(jobs.begin(), jobs.end(), job) == jobs.end()) {
+            jobs.push_back(job);
+            jobCV.notify_one();
+        }
+    }
+
+    void Plan::destroy() {
+#ifdef SDRPP_USE_ACCELERATE
+        if (dft) {
+            vDSP_DFT_DestroySetup(dft);
+            fftwf_free(split.realp);
+            fftwf_free(split.imagp);
+            dft = NULL;
+            split = { NULL, NULL };
+        }
+#endif
+        if (!plan) { return; }
+        std::lock_guard<std::mutex> lck(plannerMtx);
+        {
+            std::lock_guard<std::mutex> lck2(jobMtx);
+            waiting.erase(std::remove(waiting.begin(), waiting.end(), this), waiting.end());
+        }
+        fftwf_destroy_plan(plan);
+        plan = NULL;
+        fftwf_plan m = measured.exchange(NULL);
+        if (m) { fftwf_destroy_plan(m); }
+    }
+}
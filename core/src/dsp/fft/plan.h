@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <fftw3.h>
+
+#ifdef SDRPP_USE_ACCELERATE
+#include <Accelerate/Accelerate.h>
+#endif
+
+// Planning flags used for the measured plans
+#define FFT_WISDOM_FLAGS        FFTW_MEASURE
+
+// Maximum time spent measuring a single size, in seconds. The FFTW planner is global, so measuring holds the planner
+// lock and everything creating or destroying a plan meanwhile waits for it, the GUI thread included. FFTW keeps the
+// best plan found within the limit
+#define FFT_WISDOM_TIME_LIMIT   0.5
+
+namespace dsp::fft {
+    // The FFTW planner isn't thread safe, every call creating or destroying a plan must hold this lock
+    std::mutex& plannerMutex();
+
+    // Import the wisdom saved in a file and save the plans measured from now on to it. Until this is called,
+    // plans are only estimated
+    void loadWisdom(const std::string& path);
+
+    // Stop measuring plans in the background, must be called before exiting
+    void stopWisdom();
+
+    // Complex FFT plan that gets faster over time. It is created from the stored wisdom if the size was already
+    // measured, otherwise it starts out estimated while the size is measured in the background and switches to
+    // the measured plan on its own once available. The measured plan runs on the buffers given to create(),
+    // which must therefore be allocated with fftwf_malloc.
+    //
+    // When built with OPT_USE_ACCELERATE, the sizes vDSP supports (1, 3, 5 or 15 times a power of two of at least 16)
+    // are run by vDSP instead and never measured, the others still going to FFTW.
+    class Plan {
+    public:
+        Plan() {}
+        ~Plan();
+
+        void create(int size, fftwf_complex* in, fftwf_complex* out, int sign);
+        void destroy();
+
+        inline void execute() {
+#ifdef SDRPP_USE_ACCELERATE
+            if (dft) {
+                // vDSP works on split complex buffers
+                vDSP_ctoz((const DSPComplex*)_in, 2, &split, 1, _size);
+                vDSP_DFT_Execute(dft, split.realp, split.imagp, split.realp, split.imagp);
+                vDSP_ztoc(&split, 1, (DSPComplex*)_out, 2, _size);
+                return;
+            }
+#endif
+            fftwf_plan m = measured.load(std::memory_order_acquire);
+            if (m) {
+                fftwf_execute_dft(m, _in, _out);
+                return;
+            }
+            fftwf_execute(plan);
+        }
+
+        bool isMeasured() {
+#ifdef SDRPP_USE_ACCELERATE
+            if (dft) { return true; }
+#endif
+            return measured.load() || fromWisdom;
+        }
+
+        // Used by the background planner
+        int _size;
+        int _sign;
+        std::atomic<fftwf_plan> measured = NULL;
+
+    private:
+        fftwf_complex* _in;
+        fftwf_complex* _out;
+        fftwf_plan plan = NULL;
+        bool fromWisdom = false;
+
+#ifdef SDRPP_USE_ACCELERATE
+        vDSP_DFT_Setup dft = NULL;
+        DSPSplitComplex split = { NULL, NULL };
+#endif
+    };
+}
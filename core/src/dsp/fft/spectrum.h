@@ -0,0 +1,128 @@
+#pragma once
+#include <mutex>
+#include <algorithm>
+#include <math.h>
+#include <volk/volk.h>
+#include "plan.h"
+#include "../types.h"
+#include "../accelerate.h"
+#include "../buffer/buffer.h"
+#include "../window/nuttall.h"
+
+namespace dsp::fft {
+    // Power spectrum of a stream fed in blocks of any size, computed at most rate times per second. Meant to be fed
+    // from the thread of the block producing the samples, the latest spectrum being picked up by another thread with read().
+    // The spectrum is centered, the first bin being the lowest frequency.
+    class Spectrum {
+    public:
+        Spectrum() {}
+
+        Spectrum(int size, double samplerate, double rate) { init(size, samplerate, rate); }
+
+        ~Spectrum() {
+            destroy();
+        }
+
+        void init(int size, double samplerate, double rate) {
+            std::lock_guard<std::mutex> lck(mtx);
+            destroy();
+            _size = size;
+            _samplerate = samplerate;
+            _rate = rate;
+            interval = std::max<int>(_size, round(_samplerate / _rate));
+            filled = 0;
+            skip = 0;
+            fresh = false;
+
+            // The window alternates the sign of the samples to center the spectrum
+            window = buffer::alloc<float>(_size);
+            for (int i = 0; i < _size; i++) {
+                window[i] = window::nuttall(i, _size) * ((i % 2) ? -1.0f : 1.0f);
+            }
+            frame = buffer::alloc<complex_t>(_size);
+            spectrum = buffer::alloc<float>(_size);
+            latest = buffer::alloc<float>(_size);
+            buffer::clear(latest, _size);
+            fftIn = (fftwf_complex*)fftwf_malloc(_size * sizeof(fftwf_complex));
+            fftOut = (fftwf_complex*)fftwf_malloc(_size * sizeof(fftwf_complex));
+            plan.create(_size, fftIn, fftOut, FFTW_FORWARD);
+        }
+
+        void feed(const complex_t* in, int count) {
+            while (count) {
+                // Drop the samples between two spectra
+                if (skip) {
+                    int n = std::min<int>(skip, count);
+                    skip -= n;
+                    in += n;
+                    count -= n;
+                    continue;
+                }
+
+                // Accumulate a frame
+                int n = std::min<int>(_size - filled, count);
+                memcpy(&frame[filled], in, n * sizeof(complex_t));
+                filled += n;
+                in += n;
+                count -= n;
+                if (filled < _size) { break; }
+                filled = 0;
+                skip = interval - _size;
+
+                // Compute its spectrum and make it the latest one
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)fftIn, (lv_32fc_t*)frame, window, _size);
+                plan.execute();
+                accelerate::powerSpectrum(spectrum, (complex_t*)fftOut, _size, _size);
+                std::lock_guard<std::mutex> lck(mtx);
+                memcpy(latest, spectrum, _size * sizeof(float));
+                fresh = true;
+            }
+        }
+
+        // Copy the latest spectrum to out if a new one was computed since the last call, out must hold getSize() values
+        bool read(float* out) {
+            std::lock_guard<std::mutex> lck(mtx);
+            if (!fresh) { return false; }
+            memcpy(out, latest, _size * sizeof(float));
+            fresh = false;
+            return true;
+        }
+
+        int getSize() { return _size; }
+
+        double getSamplerate() { return _samplerate; }
+
+        double getRate() { return _rate; }
+
+    private:
+        void destroy() {
+            if (!window) { return; }
+            plan.destroy();
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            buffer::free(window);
+            buffer::free(frame);
+            buffer::free(spectrum);
+            buffer::free(latest);
+            window = NULL;
+        }
+
+        int _size = 0;
+        double _samplerate = 0.0;
+        double _rate = 0.0;
+        int interval = 0;
+        int filled = 0;
+        int skip = 0;
+
+        float* window = NULL;
+        complex_t* frame = NULL;
+        float* spectrum = NULL;
+        fftwf_complex* fftIn = NULL;
+        fftwf_complex* fftOut = NULL;
+        Plan plan;
+
+        std::mutex mtx;
+        float* latest = NULL;
+        bool fresh = false;
+    };
+}
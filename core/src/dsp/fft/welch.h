@@ -0,0 +1,177 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <volk/volk.h>
+#include "plan.h"
+#include "../types.h"
+#include "../buffer/buffer.h"
+
+// Maximum number of segments averaged into one spectrum
+#define WELCH_MAX_SEGMENTS      64
+
+// Minimum FFT size for the segments to be spread across threads
+#define WELCH_THREAD_MIN_SIZE   65536
+
+namespace dsp::fft {
+    // Power spectrum estimate using Welch's method. The input is cut into overlapping segments that are
+    // windowed and transformed, their power being averaged in the linear domain before the single conversion
+    // to dB. For large sizes, the segments can be spread across several threads each with their own plan.
+    class Welch {
+    public:
+        Welch() {}
+
+        ~Welch() {
+            destroy();
+        }
+
+        void init(int size, double overlap, int threads = 1) {
+            destroy();
+            _size = size;
+            _hop = std::max<int>(1, round((double)size * (1.0 - overlap)));
+            if (size < WELCH_THREAD_MIN_SIZE) { threads = 1; }
+
+            for (int i = 0; i < std::max<int>(threads, 1); i++) {
+                auto w = std::make_unique<Worker>();
+                w->in = (fftwf_complex*)fftwf_malloc(_size * sizeof(fftwf_complex));
+                w->out = (fftwf_complex*)fftwf_malloc(_size * sizeof(fftwf_complex));
+                w->plan.create(_size, w->in, w->out, FFTW_FORWARD);
+                w->acc = buffer::alloc<float>(_size);
+                w->power = buffer::alloc<float>(_size);
+                workers.push_back(std::move(w));
+            }
+
+            // Start the helper threads once all workers exist
+            for (int i = 1; i < workers.size(); i++) {
+                workers[i]->thread = std::thread(&Welch::worker, this, i, generation);
+            }
+        }
+
+        void destroy() {
+            if (workers.empty()) { return; }
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                stopWorkers = true;
+            }
+            startCV.notify_all();
+            for (auto& w : workers) {
+                if (w->thread.joinable()) { w->thread.join(); }
+                w->plan.destroy();
+                fftwf_free(w->in);
+                fftwf_free(w->out);
+                buffer::free(w->acc);
+                buffer::free(w->power);
+            }
+            workers.clear();
+            stopWorkers = false;
+        }
+
+        // Number of input samples needed to average a given number of segments
+        int getInputSize(int segments) {
+            return _size + (std::max<int>(segments, 1) - 1) * _hop;
+        }
+
+        int getHop() { return _hop; }
+
+        // Average the power of all segments contained in count samples and write the result in dB to out.
+        // window must hold size samples. Returns the number of segments averaged
+        int process(const complex_t* in, int count, const float* window, float* out) {
+            int segments = (count >= _size) ? (((count - _size) / _hop) + 1) : 0;
+            if (!segments) { return 0; }
+
+            // Let the other workers take their share of the segments
+            _jobIn = in;
+            _jobWindow = window;
+            _jobSegments = segments;
+            int helpers = std::min<int>(workers.size(), segments) - 1;
+            if (helpers > 0) {
+                std::lock_guard<std::mutex> lck(mtx);
+                pending = helpers;
+                generation++;
+            }
+            if (helpers > 0) { startCV.notify_all(); }
+            accumulate(0);
+
+            // Wait for them to finish and sum their results
+            if (helpers > 0) {
+                std::unique_lock<std::mutex> lck(mtx);
+                doneCV.wait(lck, [this] { return !pending; });
+            }
+            float* acc = workers[0]->acc;
+            for (int i = 1; i <= helpers; i++) {
+                volk_32f_x2_add_32f(acc, acc, workers[i]->acc, _size);
+            }
+
+            // Convert the average to dB, normalised like volk_32fc_s32f_power_spectrum_32f
+            float norm = (float)segments * (float)_size * (float)_size;
+            volk_32f_s32f_multiply_32f(acc, acc, 1.0f / norm, _size);
+            for (int i = 0; i < _size; i++) {
+                out[i] = 10.0f * log10f(acc[i] + 1e-20f);
+            }
+
+            return segments;
+        }
+
+    private:
+        struct Worker {
+            fftwf_complex* in = NULL;
+            fftwf_complex* out = NULL;
+            Plan plan;
+            float* acc = NULL;
+            float* power = NULL;
+            std::thread thread;
+        };
+
+        void accumulate(int id) {
+            Worker& w = *workers[id];
+            int stride = std::min<int>(workers.size(), _jobSegments);
+            buffer::clear(w.acc, _size);
+            for (int s = id; s < _jobSegments; s += stride) {
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)w.in, (const lv_32fc_t*)&_jobIn[s * _hop], _jobWindow, _size);
+                w.plan.execute();
+                volk_32fc_magnitude_squared_32f(w.power, (const lv_32fc_t*)w.out, _size);
+                volk_32f_x2_add_32f(w.acc, w.acc, w.power, _size);
+            }
+        }
+
+        void worker(int id, uint64_t lastGen) {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    startCV.wait(lck, [&] { return generation != lastGen || stopWorkers; });
+                    if (stopWorkers) { return; }
+                    lastGen = generation;
+                }
+
+                // Only the workers needed for this job take part
+                if (id >= std::min<int>(workers.size(), _jobSegments)) { continue; }
+                accumulate(id);
+
+                {
+                    std::lock_guard<std::mutex> lck(mtx);
+                    pending--;
+                }
+                doneCV.notify_one();
+            }
+        }
+
+        int _size = 0;
+        int _hop = 0;
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        const complex_t* _jobIn;
+        const float* _jobWindow;
+        int _jobSegments = 0;
+
+        std::mutex mtx;
+        std::condition_variable startCV;
+        std::condition_variable doneCV;
+        uint64_t generation = 0;
+        int pending = 0;
+        bool stopWorkers = false;
+    };
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include "fir.h"
 
 namespace dsp::filter {
@@ -12,66 +13,72 @@ namespace dsp::filter {
 
         void init(stream<D>* in, tap<T>& taps, int decimation) {
             _decimation = decimation;
+            base_type::fftAllowed = false;
+            base_type::fadeAllowed = false;
             base_type::init(in, taps);
         }
 
-        void setTaps(tap<T>& taps) {
-            assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            offset = 0;
-            base_type::setTaps(taps);
-            base_type::tempStart();
-        }
-
         void setDecimation(int decimation) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
             _decimation = decimation;
             offset = 0;
-            base_type::tempStart();
         }
 
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
             offset = 0;
-            base_type::reset();
-            base_type::tempStart();
+            buffer::clear<D>(base_type::buffer, base_type::_taps.size - 1);
         }
 
         inline int process(int count, const D* in, D* out) {
-            // Copy data to work buffer
-            memcpy(base_type::bufStart, in, count * sizeof(D));
-
-            // Do convolution
-            int outCount = 0;
-            for (; offset < count; offset += _decimation) {
-                if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[outCount++], &base_type::buffer[offset], base_type::_taps.taps, base_type::_taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&base_type::buffer[offset], base_type::_taps.taps, base_type::_taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
-                    volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&base_type::buffer[offset], (lv_32fc_t*)base_type::_taps.taps, base_type::_taps.size);
-                }
+            if (count > base_type::bufCapacity) { base_type::growBuffer(count); }
+            int hist = base_type::_taps.size - 1;
+
+            // Number of outputs in this block, only the kept ones are computed
+            int outCount = (offset < count) ? ((count - offset + _decimation - 1) / _decimation) : 0;
+
+            // When processing in place or with less samples than the history, work from a copy of the input
+            if (in == out || count < hist) {
+                memcpy(base_type::bufStart, in, count * sizeof(D));
+                base_type::kernel.process(out, &base_type::buffer[offset], _decimation, outCount);
+                memmove(base_type::buffer, &base_type::buffer[count], hist * sizeof(D));
+                offset += outCount * _decimation - count;
+                return outCount;
+            }
+
+            // Otherwise, only the outputs that overlap the history need the work buffer, the others are computed from the input directly
+            int histCount = (offset < hist) ? std::min<int>((hist - offset + _decimation - 1) / _decimation, outCount) : 0;
+            memcpy(base_type::bufStart, in, hist * sizeof(D));
+            base_type::kernel.process(out, &base_type::buffer[offset], _decimation, histCount);
+            if (outCount > histCount) {
+                int start = offset + histCount * _decimation - hist;
+                base_type::kernel.process(&out[histCount], &in[start], _decimation, outCount - histCount);
             }
-            offset -= count;
 
-            // Move unused data
-            memmove(base_type::buffer, &base_type::buffer[count], (base_type::_taps.size - 1) * sizeof(D));
+            // Keep the end of the input as history
+            memcpy(base_type::buffer, &in[count - hist], hist * sizeof(D));
+            offset += outCount * _decimation - count;
 
             return outCount;
         }
 
+        int maxOutputCount(int inputCount) { return (inputCount / _decimation) + 1; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
-            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            int outCount;
+            {
+                std::lock_guard<std::mutex> lck(base_type::paramMtx);
+                base_type::out.reserve(maxOutputCount(count));
+                outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+                base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / (double)_decimation);
+            }
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -82,6 +89,8 @@ namespace dsp::filter {
         }
 
     protected:
+        void tapsChanged() { offset = 0; }
+
         int _decimation;
         int offset = 0;
     };
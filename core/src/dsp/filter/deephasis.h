@@ -1,6 +1,6 @@
 #pragma once
 #include "../processor.h"
-
+#include "first_order_iir.h"
 
 namespace dsp::filter {
     template<class T>
@@ -14,16 +14,10 @@ namespace dsp::filter {
         void init(stream<T>* in, double tau, double samplerate) {
             _tau = tau;
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
 
             updateAlpha();
-
-            // Initialize state
-            if constexpr (std::is_same_v<T, float>) {
-                lastOut = 0;
-            }
-            if constexpr (std::is_same_v<T, stereo_t>) {
-                lastOut = { 0, 0 };
-            }
+            iir.reset();
 
             base_type::init(in);
         }
@@ -39,6 +33,7 @@ namespace dsp::filter {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             _samplerate = samplerate;
+            silence.setSamplerate(_samplerate);
             updateAlpha();
         }
 
@@ -46,33 +41,12 @@ namespace dsp::filter {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            if constexpr (std::is_same_v<T, float>) {
-                lastOut = 0;
-            }
-            if constexpr (std::is_same_v<T, stereo_t>) {
-                lastOut = { 0, 0 };
-            }
+            iir.reset();
             base_type::tempStart();
         }
 
         inline int process(int count, const T* in, T* out) {
-            if constexpr (std::is_same_v<T, float>) {
-                out[0] = (alpha * in[0]) + ((1 - alpha) * lastOut);
-                for (int i = 1; i < count; i++) {
-                    out[i] = (alpha * in[i]) + ((1 - alpha) * out[i - 1]);
-                }
-                lastOut = out[count - 1];
-            }
-            if constexpr (std::is_same_v<T, stereo_t>) {
-                out[0].l = (alpha * in[0].l) + ((1 - alpha) * lastOut.l);
-                out[0].r = (alpha * in[0].r) + ((1 - alpha) * lastOut.r);
-                for (int i = 1; i < count; i++) {
-                    out[i].l = (alpha * in[i].l) + ((1 - alpha) * out[i - 1].l);
-                    out[i].r = (alpha * in[i].r) + ((1 - alpha) * out[i - 1].r);
-                }
-                lastOut.l = out[count - 1].l;
-                lastOut.r = out[count - 1].r;
-            }
+            iir.process(count, (const float*)in, (float*)out);
             return count;
         }
 
@@ -81,7 +55,17 @@ namespace dsp::filter {
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
-            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Only marked silent below once the tracker agrees
+            base_type::out.writeMeta = base_type::_in->readMeta;
+            base_type::out.writeMeta.silent = false;
+            if (silence.skip(base_type::_in->readMeta, count)) {
+                memset(base_type::out.writeBuf, 0, count * sizeof(T));
+                base_type::out.writeMeta.silent = true;
+            }
+            else {
+                process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            }
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
             return count;
@@ -91,12 +75,14 @@ namespace dsp::filter {
         void updateAlpha() {
             float dt = 1.0f / _samplerate;
             alpha = dt / (_tau + dt);
+            iir.setCoefficients(alpha, 1.0f - alpha);
         }
 
         double _tau;
         double _samplerate;
+        silence_tracker silence;
 
         float alpha;
-        T lastOut;
+        FirstOrderIIR<sizeof(T) / sizeof(float)> iir;
     };
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "../processor.h"
 #include "../taps/tap.h"
+#include "kernel.h"
+#include "overlap_save.h"
 
 namespace dsp::filter {
     template <class D, class T>
@@ -15,78 +17,144 @@ namespace dsp::filter {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             buffer::free(buffer);
+            buffer::free(fadeHist);
+            buffer::free(fadeOut);
         }
 
         virtual void init(stream<D>* in, tap<T>& taps) {
             _taps = taps;
+            selectKernel();
 
-            // Allocate and clear buffer
-            buffer = buffer::alloc<D>(STREAM_BUFFER_SIZE + 64000);
+            // Allocate and clear buffer, it is grown later if larger blocks come through
+            bufCapacity = in ? in->getMaxBlockSize() : 0;
+            buffer = buffer::alloc<D>(bufCapacity + _taps.size);
             bufStart = &buffer[_taps.size - 1];
             buffer::clear<D>(buffer, _taps.size - 1);
 
             base_type::init(in);
         }
 
-        virtual void setTaps(tap<T>& taps) {
+        // Swapped in between two buffers, the worker keeps running. The kernel of the new taps is built beforehand,
+        // which for long filters means planning their transforms. With fadeLength, the old taps keep filtering for
+        // that many samples and the output crossfades from them to the new ones, hiding the step of the output and
+        // the history that the new taps didn't see. The old taps must then stay valid until the taps are set again
+        virtual void setTaps(tap<T>& taps, int fadeLength = 0) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            bool newUseFFT = (OverlapSave<D, T>::supported() && fftAllowed && taps.size >= FIR_FFT_MIN_TAPS);
+            BlockKernel<D, T> newKernel;
+            OverlapSave<D, T> newFast;
+            if (newUseFFT) {
+                newFast.setTaps(taps);
+            }
+            else {
+                newKernel.setTaps(taps);
+            }
 
-            int oldTC = _taps.size;
-            _taps = taps;
+            // Buffers of the old taps while fading, the history of the old taps followed by the input
+            if (!fadeAllowed) { fadeLength = 0; }
+            D* newFadeHist = NULL;
+            D* newFadeOut = NULL;
+            if (fadeLength > 0) {
+                newFadeHist = buffer::alloc<D>(_taps.size - 1 + fadeLength);
+                newFadeOut = buffer::alloc<D>(fadeLength);
+            }
 
-            // Update start of buffer
-            bufStart = &buffer[_taps.size - 1];
+            // The old kernel is freed along with newKernel and newFast, once the lock is released
+            D* oldBuf = NULL;
+            {
+                std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+                int oldTC = _taps.size;
+                if (newFadeHist) { memcpy(newFadeHist, buffer, (oldTC - 1) * sizeof(D)); }
+                std::swap(fadeHist, newFadeHist);
+                std::swap(fadeOut, newFadeOut);
+                fadeUseFFT = useFFT;
+                fadeTapCount = oldTC;
+                fadeLen = fadeLength;
+                fadePos = 0;
+
+                // The current kernel becomes the one fading out, the one fading out until now is freed
+                _taps = taps;
+                useFFT = newUseFFT;
+                kernel.swap(newKernel);
+                fast.swap(newFast);
+                if (fadeLength > 0) {
+                    fadeKernel.swap(newKernel);
+                    fadeFast.swap(newFast);
+                }
 
-            // Move existing data to make transition seemless
-            if (_taps.size < oldTC) {
-                memmove(buffer, &buffer[oldTC - _taps.size], (_taps.size - 1) * sizeof(D));
-            }
-            else if (_taps.size > oldTC) {
-                memmove(&buffer[_taps.size - oldTC], buffer, (oldTC - 1) * sizeof(D));
-                buffer::clear<D>(buffer, _taps.size - oldTC);
+                // Move existing data to make transition seemless
+                if (_taps.size < oldTC) {
+                    memmove(buffer, &buffer[oldTC - _taps.size], (_taps.size - 1) * sizeof(D));
+                }
+                else if (_taps.size > oldTC) {
+                    // The history is longer, the buffer needs to be reallocated to make room for it
+                    D* newBuf = buffer::alloc<D>(bufCapacity + _taps.size);
+                    memcpy(&newBuf[_taps.size - oldTC], buffer, (oldTC - 1) * sizeof(D));
+                    buffer::clear<D>(newBuf, _taps.size - oldTC);
+                    oldBuf = buffer;
+                    buffer = newBuf;
+                }
+
+                // Update start of buffer
+                bufStart = &buffer[_taps.size - 1];
+                tapsChanged();
             }
-            
-            base_type::tempStart();
+            if (oldBuf) { buffer::free(oldBuf); }
+            buffer::free(newFadeHist);
+            buffer::free(newFadeOut);
         }
 
         virtual void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
             buffer::clear<D>(buffer, _taps.size - 1);
-            base_type::tempStart();
+            fadeLen = 0;
         }
 
+        // Safe to call while the taps are being changed from another thread
         inline int process(int count, const D* in, D* out) {
-            // Copy data to work buffer
-            memcpy(bufStart, in, count * sizeof(D));
-            
-            // Do convolution
-            for (int i = 0; i < count; i++) {
-                if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[i], &buffer[i], _taps.taps, _taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&buffer[i], _taps.taps, _taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
-                    volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&buffer[i], (lv_32fc_t*)_taps.taps, _taps.size);
+            std::lock_guard<std::mutex> lck(base_type::paramMtx);
+            if (fadePos >= fadeLen) { return convolve(count, in, out); }
+
+            // The old taps go first, the input may be overwritten by the new ones when processing in place
+            int n = std::min<int>(count, fadeLen - fadePos);
+            int fadeHistLen = fadeTapCount - 1;
+            if (fadeUseFFT) {
+                fadeFast.process(n, in, fadeOut, fadeHist);
+            }
+            else {
+                memcpy(&fadeHist[fadeHistLen], in, n * sizeof(D));
+                fadeKernel.process(fadeOut, fadeHist, 1, n);
+                memmove(fadeHist, &fadeHist[n], fadeHistLen * sizeof(D));
+            }
+            convolve(count, in, out);
+
+            // Linear crossfade over the fade length
+            constexpr int comps = sizeof(D) / sizeof(float);
+            float* y = (float*)out;
+            const float* o = (const float*)fadeOut;
+            float step = 1.0f / (float)fadeLen;
+            for (int i = 0; i < n; i++) {
+                float w = (float)(fadePos + i + 1) * step;
+                for (int c = 0; c < comps; c++) {
+                    y[i * comps + c] = o[i * comps + c] + (y[i * comps + c] - o[i * comps + c]) * w;
                 }
             }
-
-            // Move unused data
-            memmove(buffer, &buffer[count], (_taps.size - 1) * sizeof(D));
-
+            fadePos += n;
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -94,8 +162,79 @@ namespace dsp::filter {
         }
 
     protected:
+        // Called with the new taps in place, while the worker is held
+        virtual void tapsChanged() {}
+
+        inline int convolve(int count, const D* in, D* out) {
+            // Long filters are done in the frequency domain
+            if (useFFT) {
+                fast.process(count, in, out, buffer);
+                return count;
+            }
+
+            if (count > bufCapacity) { growBuffer(count); }
+            int hist = _taps.size - 1;
+
+            // When processing in place or with less samples than the history, work from a copy of the input
+            if (in == out || count < hist) {
+                memcpy(bufStart, in, count * sizeof(D));
+                kernel.process(out, buffer, 1, count);
+                memmove(buffer, &buffer[count], hist * sizeof(D));
+                return count;
+            }
+
+            // Otherwise, only the outputs that overlap the history need the work buffer, the others are computed from the input directly
+            memcpy(bufStart, in, hist * sizeof(D));
+            kernel.process(out, buffer, 1, hist);
+            kernel.process(&out[hist], in, 1, count - hist);
+
+            // Keep the end of the input as history
+            memcpy(buffer, &in[count - hist], hist * sizeof(D));
+
+            return count;
+        }
+
+        void selectKernel() {
+            useFFT = (OverlapSave<D, T>::supported() && fftAllowed && _taps.size >= FIR_FFT_MIN_TAPS);
+            if (useFFT) {
+                fast.setTaps(_taps);
+            }
+            else {
+                kernel.setTaps(_taps);
+            }
+        }
+
+        void growBuffer(int count) {
+            // Reallocate the work buffer, keeping the history
+            D* newBuf = buffer::alloc<D>(count + _taps.size);
+            memcpy(newBuf, buffer, (_taps.size - 1) * sizeof(D));
+            buffer::free(buffer);
+            buffer = newBuf;
+            bufStart = &buffer[_taps.size - 1];
+            bufCapacity = count;
+        }
+
         tap<T> _taps;
+        BlockKernel<D, T> kernel;
+        OverlapSave<D, T> fast;
+        bool useFFT = false;
+
+        // Fast convolution computes every output and fading mixes them, decimating filters allow neither
+        bool fftAllowed = true;
+        bool fadeAllowed = true;
+
+        // Old taps fading out after a change, for fadeLen samples of which fadePos are done
+        BlockKernel<D, T> fadeKernel;
+        OverlapSave<D, T> fadeFast;
+        bool fadeUseFFT = false;
+        int fadeTapCount = 0;
+        int fadeLen = 0;
+        int fadePos = 0;
+        D* fadeHist = NULL;
+        D* fadeOut = NULL;
+
         D* buffer;
         D* bufStart;
+        int bufCapacity;
     };
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#pragma once
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FIRST_ORDER_IIR_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FIRST_ORDER_IIR_NEON
+#endif
+
+namespace dsp::filter {
+#if defined(FIRST_ORDER_IIR_SSE2) || defined(FIRST_ORDER_IIR_NEON)
+    // Four lanes of floats, only what the IIR needs
+    namespace iir_lanes {
+#ifdef FIRST_ORDER_IIR_SSE2
+        typedef __m128 v4;
+        inline v4 load(const float* p) { return _mm_loadu_ps(p); }
+        inline void store(float* p, v4 a) { _mm_storeu_ps(p, a); }
+        inline v4 set1(float a) { return _mm_set1_ps(a); }
+        inline v4 mul(v4 a, v4 b) { return _mm_mul_ps(a, b); }
+        inline v4 madd(v4 acc, v4 a, v4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+        inline v4 sub(v4 a, v4 b) { return _mm_sub_ps(a, b); }
+        inline float last(v4 a) { return _mm_cvtss_f32(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3))); }
+
+        // [0, a0, a1, a2]
+        inline v4 shiftIn(v4 a) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(a), 4)); }
+
+        // Store two channels of four samples interleaved
+        inline void storeInterleaved(float* p, v4 a, v4 b) {
+            _mm_storeu_ps(p, _mm_unpacklo_ps(a, b));
+            _mm_storeu_ps(p + 4, _mm_unpackhi_ps(a, b));
+        }
+#else
+        typedef float32x4_t v4;
+        inline v4 load(const float* p) { return vld1q_f32(p); }
+        inline void store(float* p, v4 a) { vst1q_f32(p, a); }
+        inline v4 set1(float a) { return vdupq_n_f32(a); }
+        inline v4 mul(v4 a, v4 b) { return vmulq_f32(a, b); }
+        inline v4 madd(v4 acc, v4 a, v4 b) { return vmlaq_f32(acc, a, b); }
+        inline v4 sub(v4 a, v4 b) { return vsubq_f32(a, b); }
+        inline float last(v4 a) { return vgetq_lane_f32(a, 3); }
+        inline v4 shiftIn(v4 a) { return vextq_f32(vdupq_n_f32(0.0f), a, 3); }
+        inline void storeInterleaved(float* p, v4 a, v4 b) {
+            float32x4x2_t z = { { a, b } };
+            vst2q_f32(p, z);
+        }
+#endif
+    }
+#endif
+
+    // First order IIR y[n] = a*x[n] + b*y[n-1] over C interleaved channels, 1 for real samples and 2 for stereo or
+    // complex ones. Computed one sample at a time, each output would wait for the previous one. Instead, four samples
+    // of each channel are computed at once from the four inputs and the last output of the previous group:
+    //      y[n+i] = sum(j <= i) a*b^(i-j)*x[n+j] + b^(i+1)*y[n-1]
+    // The sums don't depend on the previous outputs and are done over the four samples in SIMD lanes, leaving a
+    // single multiply-add per group on the dependency chain. The results match those of the sample by sample
+    // recursion to rounding
+    template <int C>
+    class FirstOrderIIR {
+        static_assert(C == 1 || C == 2, "Only one or two channels are supported");
+    public:
+        FirstOrderIIR() { setCoefficients(1.0f, 0.0f); }
+
+        void setCoefficients(float a, float b) {
+            _a = a;
+            _b = b;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    taps[j][i] = (j <= i) ? (float)((double)a * pow((double)b, i - j)) : 0.0f;
+                }
+                carry[i] = (float)pow((double)b, i + 1);
+            }
+        }
+
+        void reset() {
+            for (int c = 0; c < C; c++) { state[c] = 0.0f; }
+        }
+
+        // in and out may be the same buffer, count is in samples of C channels
+        inline void process(int count, const float* in, float* out) {
+            int i = 0;
+#if defined(FIRST_ORDER_IIR_SSE2) || defined(FIRST_ORDER_IIR_NEON)
+            using namespace iir_lanes;
+            v4 t[4] = { load(taps[0]), load(taps[1]), load(taps[2]), load(taps[3]) };
+            v4 cr = load(carry);
+            for (; i + 4 <= count; i += 4) {
+                const float* x = &in[i * C];
+                v4 y[C];
+                for (int c = 0; c < C; c++) {
+                    v4 acc = mul(t[0], set1(x[c]));
+                    for (int j = 1; j < 4; j++) { acc = madd(acc, t[j], set1(x[j * C + c])); }
+                    y[c] = madd(acc, cr, set1(state[c]));
+                    state[c] = last(y[c]);
+                }
+                if constexpr (C == 1) { store(&out[i], y[0]); }
+                else { storeInterleaved(&out[i * C], y[0], y[1]); }
+            }
+#else
+            for (; i + 4 <= count; i += 4) {
+                const float* x = &in[i * C];
+                float* o = &out[i * C];
+                for (int c = 0; c < C; c++) {
+                    float y[4];
+                    for (int k = 0; k < 4; k++) { y[k] = carry[k] * state[c]; }
+                    for (int j = 0; j < 4; j++) {
+                        for (int k = 0; k < 4; k++) { y[k] += taps[j][k] * x[j * C + c]; }
+                    }
+                    for (int k = 0; k < 4; k++) { o[k * C + c] = y[k]; }
+                    state[c] = y[3];
+                }
+            }
+#endif
+            for (; i < count; i++) {
+                for (int c = 0; c < C; c++) {
+                    state[c] = (_a * in[i * C + c]) + (_b * state[c]);
+                    out[i * C + c] = state[c];
+                }
+            }
+        }
+
+        // Remove the output from the input instead of outputting it, with a delay of one sample. With a = rate and
+        // b = 1 - rate, the output follows the DC offset of the input and this is a DC blocker:
+        //      out[n] = x[n] - y[n-1]
+        // The group is then computed from the distance of the inputs to the last output, since with a rate near zero
+        // b^(i+1) can't be told apart from one in single precision:
+        //      y[n+i] = y[n-1] + sum(j <= i) a*b^(i-j)*(x[n+j] - y[n-1])
+        inline void processResidual(int count, const float* in, float* out) {
+            int i = 0;
+#if defined(FIRST_ORDER_IIR_SSE2) || defined(FIRST_ORDER_IIR_NEON)
+            using namespace iir_lanes;
+            v4 t[4] = { load(taps[0]), load(taps[1]), load(taps[2]), load(taps[3]) };
+            for (; i + 4 <= count; i += 4) {
+                const float* x = &in[i * C];
+                v4 o[C];
+                for (int c = 0; c < C; c++) {
+                    float s = state[c];
+                    float e[4];
+                    for (int j = 0; j < 4; j++) { e[j] = x[j * C + c] - s; }
+                    v4 y = mul(t[0], set1(e[0]));
+                    for (int j = 1; j < 4; j++) { y = madd(y, t[j], set1(e[j])); }
+
+                    // Each output is its input minus the offset before it, the first one being the last state
+                    o[c] = sub(load(e), shiftIn(y));
+                    state[c] = s + last(y);
+                }
+                if constexpr (C == 1) { store(&out[i], o[0]); }
+                else { storeInterleaved(&out[i * C], o[0], o[1]); }
+            }
+#else
+            for (; i + 4 <= count; i += 4) {
+                const float* x = &in[i * C];
+                float* o = &out[i * C];
+                for (int c = 0; c < C; c++) {
+                    float s = state[c];
+                    float e[4];
+                    float y[4] = {};
+                    for (int j = 0; j < 4; j++) { e[j] = x[j * C + c] - s; }
+                    for (int j = 0; j < 4; j++) {
+                        for (int k = 0; k < 4; k++) { y[k] += taps[j][k] * e[j]; }
+                    }
+                    o[c] = e[0];
+                    for (int k = 1; k < 4; k++) { o[k * C + c] = e[k] - y[k - 1]; }
+                    state[c] = s + y[3];
+                }
+            }
+#endif
+            for (; i < count; i++) {
+                for (int c = 0; c < C; c++) {
+                    float d = in[i * C + c] - state[c];
+                    out[i * C + c] = d;
+                    state[c] += d * _a;
+                }
+            }
+        }
+
+        // Last output of each channel
+        float state[C] = {};
+
+    private:
+        float _a = 1.0f;
+        float _b = 0.0f;
+        float taps[4][4];
+        float carry[4];
+    };
+}
@@ -0,0 +1,258 @@
+#pragma once
+#include "../processor.h"
+#include "../taps/tap.h"
+#include "../worker_group.h"
+
+// Number of floats of output computed together, the accumulators staying in registers for the whole filter
+#define HALF_BAND_OUTPUT_BLOCK  32
+
+namespace dsp::filter {
+    // Decimate by two with a half-band filter, such as generated by dsp::taps::halfBand. Only the taps that aren't
+    // zero are computed, and each pair of symmetric taps is applied to the sum of its two samples, so a filter of
+    // 4k+3 taps takes k+2 multiplies per output instead of 4k+3. The input is split into its even and odd samples:
+    // the symmetric taps then only see consecutive even samples and the center tap a single odd one. Consecutive
+    // outputs read consecutive samples, so the loops over the outputs vectorize without any shuffle.
+    template <class D>
+    class HalfBandDecimator : public Processor<D, D> {
+        using base_type = Processor<D, D>;
+    public:
+        // Components per sample when handled as an array of floats
+        static constexpr int COMPONENTS = std::is_same_v<D, float> ? 1 : 2;
+
+        HalfBandDecimator() {}
+
+        HalfBandDecimator(stream<D>* in, const tap<float>& taps) { init(in, taps); }
+
+        ~HalfBandDecimator() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(even);
+            buffer::free(odd);
+            buffer::free(coefs);
+        }
+
+        void init(stream<D>* in, const tap<float>& taps) {
+            loadTaps(taps);
+            grow(in ? in->getMaxBlockSize() : 0);
+            clearHistory();
+            base_type::init(in);
+        }
+
+        void setTaps(const tap<float>& taps) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            loadTaps(taps);
+            grow(capacity);
+            clearHistory();
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            clearHistory();
+            base_type::tempStart();
+        }
+
+        // Gives the same output as a DecimatingFIR with the same taps and a decimation of two. Can be done in place
+        inline int process(int count, const D* in, D* out) {
+            split(count, in, 1.0f);
+            return filter(out);
+        }
+
+        // Same as process() with 16 bit IQ input, whose full scale is given by scale. The samples are converted as
+        // they are split
+        inline int process(int count, const complex_s16_t* in, D* out, float scale) {
+            static_assert(std::is_same_v<D, complex_t>, "Only complex samples can be given as 16 bit IQ");
+            split(count, in, 1.0f / scale);
+            return filter(out);
+        }
+
+        // Same as process() with the work split over a group of threads, the output staying the same
+        inline int process(int count, const D* in, D* out, WorkerGroup& workers) {
+            split(count, in, 1.0f, &workers);
+            return filter(out, &workers);
+        }
+
+        inline int process(int count, const complex_s16_t* in, D* out, float scale, WorkerGroup& workers) {
+            static_assert(std::is_same_v<D, complex_t>, "Only complex samples can be given as 16 bit IQ");
+            split(count, in, 1.0f / scale, &workers);
+            return filter(out, &workers);
+        }
+
+        int maxOutputCount(int inputCount) { return (inputCount / 2) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(0.5);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        template <class I>
+        static inline D load(const I& v, float scale) {
+            if constexpr (std::is_same_v<I, D>) { return v; }
+            else { return D{ (float)v.re * scale, (float)v.im * scale }; }
+        }
+
+        // Split the input into its even and odd samples, continuing from the parity the last block ended on. With
+        // workers, each of them splits a part of the pairs
+        template <class I>
+        inline void split(int count, const I* in, float scale, WorkerGroup* workers = NULL) {
+            if (count > capacity) { grow(count); }
+            int i = 0;
+            if (nextOdd && count) {
+                odd[oddCount++] = load(in[i++], scale);
+            }
+            int halves = (count - i) / 2;
+            D* ev = &even[evenCount];
+            D* od = &odd[oddCount];
+            const I* x = &in[i];
+            if (workers) {
+                int parts = workers->getThreadCount();
+                workers->run(parts, [&](int p) {
+                    int from = (int)(((int64_t)halves * p) / parts);
+                    int to = (int)(((int64_t)halves * (p + 1)) / parts);
+                    deinterleave(from, to, x, ev, od, scale);
+                });
+            }
+            else {
+                deinterleave(0, halves, x, ev, od, scale);
+            }
+            evenCount += halves;
+            oddCount += halves;
+            i += 2 * halves;
+            if (i < count) {
+                even[evenCount++] = load(in[i], scale);
+                nextOdd = true;
+            }
+            else if (count) {
+                nextOdd = false;
+            }
+        }
+
+        template <class I>
+        static inline void deinterleave(int from, int to, const I* x, D* ev, D* od, float scale) {
+            for (int h = from; h < to; h++) {
+                ev[h] = load(x[2 * h], scale);
+                od[h] = load(x[2 * h + 1], scale);
+            }
+        }
+
+        // Compute all the outputs the split samples allow. With workers, each of them computes a part of the blocks
+        // of outputs, the last one also computing those left over
+        inline int filter(D* out, WorkerGroup* workers = NULL) {
+            // Each output needs 2 * pairs consecutive even samples
+            int hist = 2 * pairs - 1;
+            int outCount = std::max<int>(evenCount - hist, 0);
+
+            // Complex and stereo samples are handled as arrays of floats, the taps being the same for both components
+            const float* e = (const float*)even;
+            const float* o = (const float*)&odd[pairs - 1];
+            float* y = (float*)out;
+            int len = outCount * COMPONENTS;
+            if (workers) {
+                int parts = workers->getThreadCount();
+                int blocks = len / HALF_BAND_OUTPUT_BLOCK;
+                workers->run(parts, [&](int p) {
+                    int from = (int)(((int64_t)blocks * p) / parts) * HALF_BAND_OUTPUT_BLOCK;
+                    int to = (p == parts - 1) ? len : (int)(((int64_t)blocks * (p + 1)) / parts) * HALF_BAND_OUTPUT_BLOCK;
+                    compute(from, to, y, e, o);
+                });
+            }
+            else {
+                compute(0, len, y, e, o);
+            }
+
+            // Keep what the next outputs need
+            memmove(even, &even[outCount], (evenCount - outCount) * sizeof(D));
+            memmove(odd, &odd[outCount], (oddCount - outCount) * sizeof(D));
+            evenCount -= outCount;
+            oddCount -= outCount;
+
+            return outCount;
+        }
+
+        // Compute the floats of output from to to, from being a multiple of HALF_BAND_OUTPUT_BLOCK
+        inline void compute(int from, int to, float* y, const float* e, const float* o) {
+            int k = from;
+            for (; k + HALF_BAND_OUTPUT_BLOCK <= to; k += HALF_BAND_OUTPUT_BLOCK) {
+                compute<HALF_BAND_OUTPUT_BLOCK>(&y[k], &e[k], &o[k]);
+            }
+            for (; k < to; k++) {
+                compute<1>(&y[k], &e[k], &o[k]);
+            }
+        }
+
+        template <int N>
+        inline void compute(float* y, const float* e, const float* o) {
+            float acc[N];
+            for (int l = 0; l < N; l++) { acc[l] = center * o[l]; }
+            for (int j = 0; j < pairs; j++) {
+                const float* a = &e[j * COMPONENTS];
+                const float* b = &e[(2 * pairs - 1 - j) * COMPONENTS];
+                float c = coefs[j];
+                for (int l = 0; l < N; l++) { acc[l] += c * (a[l] + b[l]); }
+            }
+            for (int l = 0; l < N; l++) { y[l] = acc[l]; }
+        }
+
+        void loadTaps(const tap<float>& taps) {
+            // Only the taps at an odd distance from the center and the center tap itself are used
+            assert(taps.size >= 3 && (taps.size % 4) == 3);
+            buffer::free(coefs);
+            pairs = (taps.size + 1) / 4;
+            coefs = buffer::alloc<float>(pairs);
+            for (int j = 0; j < pairs; j++) { coefs[j] = taps.taps[2 * j]; }
+            center = taps.taps[taps.size / 2];
+        }
+
+        void grow(int count) {
+            // Room for the history and the even or odd half of a block, the history being kept
+            int size = 2 * pairs + (count / 2) + 1;
+            D* newEven = buffer::alloc<D>(size);
+            D* newOdd = buffer::alloc<D>(size);
+            if (even) {
+                memcpy(newEven, even, std::min<int>(evenCount, size) * sizeof(D));
+                memcpy(newOdd, odd, std::min<int>(oddCount, size) * sizeof(D));
+                buffer::free(even);
+                buffer::free(odd);
+            }
+            even = newEven;
+            odd = newOdd;
+            capacity = count;
+        }
+
+        void clearHistory() {
+            // Same history of zeros as a FIR filter of the same length
+            evenCount = 2 * pairs - 1;
+            oddCount = 2 * pairs - 1;
+            nextOdd = false;
+            buffer::clear(even, evenCount);
+            buffer::clear(odd, oddCount);
+        }
+
+        float* coefs = NULL;
+        float center = 0.0f;
+        int pairs = 0;
+
+        D* even = NULL;
+        D* odd = NULL;
+        int evenCount = 0;
+        int oddCount = 0;
+        bool nextOdd = false;
+        int capacity = 0;
+    };
+}
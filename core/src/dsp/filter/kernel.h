@@ -0,0 +1,127 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include "../accelerate.h"
+#include "../types.h"
+#include "../taps/tap.h"
+#include "../buffer/buffer.h"
+
+// Number of outputs computed together by the block kernel
+#define FIR_KERNEL_OUTPUT_BLOCK     4
+
+// Number of float lanes accumulated separately, allows the compiler to vectorize without reordering the sums
+#define FIR_KERNEL_LANES            8
+
+// Above this number of taps, the dispatch of volk is cheap compared to the dot product itself
+#define FIR_KERNEL_MAX_TAPS         128
+
+namespace dsp::filter {
+    // Convolution kernel shared by the FIR filters. Several outputs are computed in one pass over the
+    // taps so that each tap is loaded once for all of them, and the dot product is accumulated in
+    // separate lanes so that the loops vectorize. Complex and stereo samples are convolved with real
+    // taps by duplicating each tap for the two components. Filters that are too long or use complex
+    // taps are handed to volk.
+    template <class D, class T>
+    class BlockKernel {
+    public:
+        // Components per sample when handled as an array of floats
+        static constexpr int COMPONENTS = std::is_same_v<D, float> ? 1 : 2;
+
+        BlockKernel() {}
+
+        ~BlockKernel() {
+            buffer::free(ktaps);
+        }
+
+        void setTaps(const tap<T>& taps) {
+            _taps = taps;
+            buffer::free(ktaps);
+            ktaps = NULL;
+            len = 0;
+            if constexpr (std::is_same_v<T, float>) {
+                if (!taps.size || taps.size > FIR_KERNEL_MAX_TAPS) { return; }
+                len = taps.size * COMPONENTS;
+                ktaps = buffer::alloc<float>(len);
+                for (int i = 0; i < len; i++) {
+                    ktaps[i] = taps.taps[i / COMPONENTS];
+                }
+            }
+        }
+
+        // Exchange the taps with another kernel, so that a kernel can be prepared before replacing one in use
+        void swap(BlockKernel& other) {
+            std::swap(_taps, other._taps);
+            std::swap(ktaps, other.ktaps);
+            std::swap(len, other.len);
+        }
+
+        // Compute count outputs, output i being the dot product of the taps with the samples starting at in[i * stride]
+        // and going to out[i * outStride]
+        inline void process(D* out, const D* in, int stride, int count, int outStride = 1) {
+            if (!ktaps) {
+                for (int i = 0; i < count; i++) {
+                    if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
+                        accelerate::dotProd(&out[i * outStride], &in[i * stride], _taps.taps, _taps.size);
+                    }
+                    if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
+                        accelerate::dotProd((complex_t*)&out[i * outStride], (const complex_t*)&in[i * stride], _taps.taps, _taps.size);
+                    }
+                    if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
+                        accelerate::dotProd((complex_t*)&out[i * outStride], (const complex_t*)&in[i * stride], (const complex_t*)_taps.taps, _taps.size);
+                    }
+                }
+                return;
+            }
+
+            const float* x = (const float*)in;
+            float* y = (float*)out;
+            int xStride = stride * COMPONENTS;
+            int yStride = outStride * COMPONENTS;
+
+            int i = 0;
+            for (; i + FIR_KERNEL_OUTPUT_BLOCK <= count; i += FIR_KERNEL_OUTPUT_BLOCK) {
+                dot<FIR_KERNEL_OUTPUT_BLOCK>(&y[i * yStride], &x[i * xStride], xStride, yStride);
+            }
+            for (; i < count; i++) {
+                dot<1>(&y[i * yStride], &x[i * xStride], xStride, yStride);
+            }
+        }
+
+    private:
+        template <int N>
+        inline void dot(float* y, const float* x, int xStride, int yStride) {
+            float acc[N][FIR_KERNEL_LANES] = {};
+
+            // Main part, one vector of taps at a time for all outputs
+            int j = 0;
+            for (; j + FIR_KERNEL_LANES <= len; j += FIR_KERNEL_LANES) {
+                for (int n = 0; n < N; n++) {
+                    const float* xn = &x[n * xStride + j];
+                    for (int l = 0; l < FIR_KERNEL_LANES; l++) {
+                        acc[n][l] += xn[l] * ktaps[j + l];
+                    }
+                }
+            }
+
+            // Remainder, the lane count being even keeps the components in their lanes
+            for (; j < len; j++) {
+                for (int n = 0; n < N; n++) {
+                    acc[n][j % FIR_KERNEL_LANES] += x[n * xStride + j] * ktaps[j];
+                }
+            }
+
+            // Sum the lanes of each component
+            for (int n = 0; n < N; n++) {
+                for (int c = 0; c < COMPONENTS; c++) {
+                    float sum = 0.0f;
+                    for (int l = c; l < FIR_KERNEL_LANES; l += COMPONENTS) { sum += acc[n][l]; }
+                    y[n * yStride + c] = sum;
+                }
+            }
+        }
+
+        tap<T> _taps;
+        float* ktaps = NULL;
+        int len = 0;
+    };
+}
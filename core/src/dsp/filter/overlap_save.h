@@ -0,0 +1,149 @@
+#pragma once
+#include <type_traits>
+#include <algorithm>
+#include <volk/volk.h>
+#include "../types.h"
+#include "../fft/plan.h"
+#include "../taps/tap.h"
+#include "../buffer/buffer.h"
+
+// Minimum number of taps for a FIR filter to switch to fast convolution
+#define FIR_FFT_MIN_TAPS    256
+
+namespace dsp::filter {
+    // Fast convolution using the overlap-save method. The input is cut into segments that are
+    // transformed along with the history preceding them, multiplied by the spectrum of the taps
+    // and transformed back, the first taps-1 outputs that wrapped around being discarded. A
+    // partial segment is zero padded so that every call produces as many outputs as it got
+    // inputs, without adding latency. Real signals use real transforms, complex and stereo
+    // samples are handled as complex numbers.
+    template <class D, class T>
+    class OverlapSave {
+    public:
+        static constexpr bool REAL = std::is_same_v<D, float>;
+
+        OverlapSave() {}
+
+        ~OverlapSave() {
+            destroy();
+        }
+
+        static constexpr bool supported() {
+            return (std::is_same_v<D, float> && std::is_same_v<T, float>) ||
+                   ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && (std::is_same_v<T, float> || std::is_same_v<T, complex_t>));
+        }
+
+        void setTaps(const tap<T>& taps) {
+            destroy();
+            tapCount = taps.size;
+            hist = tapCount - 1;
+
+            // Segments of at least three times the filter length keep the wasted part of each transform small
+            fftSize = 1;
+            while (fftSize < tapCount * 4) { fftSize <<= 1; }
+            segSize = fftSize - hist;
+            bins = REAL ? ((fftSize / 2) + 1) : fftSize;
+
+            // Allocate buffers and plan the transforms
+            work = (D*)fftwf_malloc(fftSize * sizeof(D));
+            spectrum = (complex_t*)fftwf_malloc(bins * sizeof(complex_t));
+            response = (complex_t*)fftwf_malloc(bins * sizeof(complex_t));
+            result = (D*)fftwf_malloc(fftSize * sizeof(D));
+            std::unique_lock<std::mutex> lck(fft::plannerMutex());
+            if constexpr (REAL) {
+                forwardPlan = fftwf_plan_dft_r2c_1d(fftSize, (float*)work, (fftwf_complex*)spectrum, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
+                backwardPlan = fftwf_plan_dft_c2r_1d(fftSize, (fftwf_complex*)spectrum, (float*)result, FFTW_ESTIMATE);
+            }
+            else {
+                forwardPlan = fftwf_plan_dft_1d(fftSize, (fftwf_complex*)work, (fftwf_complex*)spectrum, FFTW_FORWARD, FFTW_ESTIMATE);
+                backwardPlan = fftwf_plan_dft_1d(fftSize, (fftwf_complex*)spectrum, (fftwf_complex*)result, FFTW_BACKWARD, FFTW_ESTIMATE);
+            }
+            lck.unlock();
+
+            // Compute the frequency response of the taps, including the normalisation of the backward transform.
+            // FIR filters take the dot product of the taps with the samples, so the taps are reversed to get the same result
+            buffer::clear(work, fftSize);
+            float scale = 1.0f / (float)fftSize;
+            for (int i = 0; i < tapCount; i++) {
+                const T& t = taps.taps[hist - i];
+                if constexpr (std::is_same_v<T, float>) {
+                    if constexpr (REAL) { work[i] = t * scale; }
+                    else { work[i] = { t * scale, 0.0f }; }
+                }
+                else if constexpr (!REAL) {
+                    work[i] = { t.re * scale, t.im * scale };
+                }
+            }
+            fftwf_execute(forwardPlan);
+            memcpy(response, spectrum, bins * sizeof(complex_t));
+        }
+
+        // Exchange the taps with another instance, planning the transforms being too slow to do while one is in use
+        void swap(OverlapSave& other) {
+            std::swap(tapCount, other.tapCount);
+            std::swap(hist, other.hist);
+            std::swap(fftSize, other.fftSize);
+            std::swap(segSize, other.segSize);
+            std::swap(bins, other.bins);
+            std::swap(work, other.work);
+            std::swap(spectrum, other.spectrum);
+            std::swap(response, other.response);
+            std::swap(result, other.result);
+            std::swap(forwardPlan, other.forwardPlan);
+            std::swap(backwardPlan, other.backwardPlan);
+        }
+
+        // Filter count samples. history holds the last taps-1 inputs and is updated, in and out may be the same buffer
+        inline void process(int count, const D* in, D* out, D* history) {
+            memcpy(work, history, hist * sizeof(D));
+            for (int i = 0; i < count;) {
+                // Load the segment after the history, zero padding it if it's incomplete
+                int seg = std::min<int>(count - i, segSize);
+                memcpy(&work[hist], &in[i], seg * sizeof(D));
+                if (seg < segSize) { buffer::clear(&work[hist + seg], segSize - seg); }
+
+                // Filter in the frequency domain
+                fftwf_execute(forwardPlan);
+                volk_32fc_x2_multiply_32fc((lv_32fc_t*)spectrum, (lv_32fc_t*)spectrum, (lv_32fc_t*)response, bins);
+                fftwf_execute(backwardPlan);
+
+                // The end of the segment becomes the history of the next one
+                memmove(work, &work[seg], hist * sizeof(D));
+
+                // Only the outputs that didn't wrap around are valid
+                memcpy(&out[i], &result[hist], seg * sizeof(D));
+                i += seg;
+            }
+            memcpy(history, work, hist * sizeof(D));
+        }
+
+    private:
+        void destroy() {
+            if (!work) { return; }
+            {
+                std::lock_guard<std::mutex> lck(fft::plannerMutex());
+                fftwf_destroy_plan(forwardPlan);
+                fftwf_destroy_plan(backwardPlan);
+            }
+            fftwf_free(work);
+            fftwf_free(spectrum);
+            fftwf_free(response);
+            fftwf_free(result);
+            work = NULL;
+        }
+
+        int tapCount = 0;
+        int hist = 0;
+        int fftSize = 0;
+        int segSize = 0;
+        int bins = 0;
+
+        D* work = NULL;
+        complex_t* spectrum = NULL;
+        complex_t* response = NULL;
+        D* result = NULL;
+
+        fftwf_plan forwardPlan;
+        fftwf_plan backwardPlan;
+    };
+}
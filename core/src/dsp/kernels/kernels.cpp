@@ -0,0 +1,92 @@
+#include "kernels.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <utils/flog.h>
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SVE
+#define HWCAP_SVE   (1 << 22)
+#endif
+#endif
+
+namespace dsp::kernels {
+    namespace baseline { extern const Table table; }
+#ifdef SDRPP_KERNELS_X86_V2
+    namespace x86_v2 { extern const Table table; }
+#endif
+#ifdef SDRPP_KERNELS_X86_V3
+    namespace x86_v3 { extern const Table table; }
+#endif
+#ifdef SDRPP_KERNELS_X86_V4
+    namespace x86_v4 { extern const Table table; }
+#endif
+#ifdef SDRPP_KERNELS_SVE
+    namespace sve { extern const Table table; }
+#endif
+
+    // The features checked are those that the compiler is allowed to use at each level, the OS support of the wider
+    // registers being checked along by the compiler's own detection
+    static bool supported(const Table* table) {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        bool v2 = __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        bool v3 = v2 && __builtin_cpu_supports("avx") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2");
+        bool v4 = v3 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+#ifdef SDRPP_KERNELS_X86_V2
+        if (table == &x86_v2::table) { return v2; }
+#endif
+#ifdef SDRPP_KERNELS_X86_V3
+        if (table == &x86_v3::table) { return v3; }
+#endif
+#ifdef SDRPP_KERNELS_X86_V4
+        if (table == &x86_v4::table) { return v4; }
+#endif
+#endif
+#if defined(SDRPP_KERNELS_SVE) && defined(__aarch64__) && defined(__linux__)
+        if (table == &sve::table) { return getauxval(AT_HWCAP) & HWCAP_SVE; }
+#endif
+        return table == &baseline::table;
+    }
+
+    static const Table* select() {
+        // From the best level to the baseline
+        std::vector<const Table*> tables;
+#ifdef SDRPP_KERNELS_X86_V4
+        tables.push_back(&x86_v4::table);
+#endif
+#ifdef SDRPP_KERNELS_X86_V3
+        tables.push_back(&x86_v3::table);
+#endif
+#ifdef SDRPP_KERNELS_X86_V2
+        tables.push_back(&x86_v2::table);
+#endif
+#ifdef SDRPP_KERNELS_SVE
+        tables.push_back(&sve::table);
+#endif
+        tables.push_back(&baseline::table);
+
+        // A forced level must still be supported, otherwise the best one is used
+        const char* forced = getenv("SDRPP_KERNEL_ISA");
+        if (forced && forced[0]) {
+            const Table* match = NULL;
+            for (const Table* table : tables) {
+                if (!strcmp(table->isa, forced)) { match = table; }
+            }
+            if (match && supported(match)) { return match; }
+            if (match) { flog::warn("The CPU doesn't support the {} DSP kernels asked for by SDRPP_KERNEL_ISA", forced); }
+            else { flog::warn("No {} DSP kernels in this build, SDRPP_KERNEL_ISA ignored", forced); }
+        }
+
+        for (const Table* table : tables) {
+            if (supported(table)) { return table; }
+        }
+        return &baseline::table;
+    }
+
+    const Table& get() {
+        static const Table* table = select();
+        return *table;
+    }
+}
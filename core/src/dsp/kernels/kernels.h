@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include "../types.h"
+
+namespace dsp::kernels {
+    // Hot loops of the core that VOLK has no kernel for. With OPT_MULTI_ISA_KERNELS they are also compiled for newer
+    // ISA levels than the baseline of the build, the best one the CPU supports being picked on first use
+    struct Table {
+        // Name of the ISA level, "baseline" being that of the build
+        const char* isa;
+
+        // Power in dB of the samples scaled down by norm, see dsp::math::fastPowerSpectrum()
+        void (*powerSpectrum)(float* out, const complex_t* in, float norm, int count);
+
+        // Levels in dB to the colors of the palette, min and max being mapped to its first and last color
+        void (*colorize)(uint32_t* out, const float* in, int count, float min, float max, const uint32_t* palette, int paletteSize);
+
+        // Planar complex samples, see dsp::planar_stream. Each sample is multiplied by phase and by the step of the
+        // same index, the step holding the phasors of the first count samples of the rotation
+        void (*planarRotate)(float* outRe, float* outIm, const float* inRe, const float* inIm, const float* stepRe, const float* stepIm, float phaseRe, float phaseIm, int count);
+
+        // Amplitude of each planar sample
+        void (*planarMagnitude)(float* out, const float* re, const float* im, int count);
+
+        // Phase difference in radians times scale between each planar sample and the one before it, the one before
+        // the first being last
+        void (*planarPhaseDiff)(float* out, const float* re, const float* im, float lastRe, float lastIm, float scale, int count);
+    };
+
+    // Kernels of the best ISA level compiled in that the CPU supports. The SDRPP_KERNEL_ISA environment variable
+    // forces a lower level by name, eg. to compare them
+    const Table& get();
+}
@@ -0,0 +1,4 @@
+// Baseline of the build, always compiled
+#define SDRPP_KERNELS_NAMESPACE baseline
+#define SDRPP_KERNELS_NAME      "baseline"
+#include "kernels_impl.h"
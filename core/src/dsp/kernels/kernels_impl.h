@@ -0,0 +1,95 @@
+#pragma once
+// Included by the translation units compiled for each ISA level, within their own namespace. The wide levels only use
+// plain loops that the compiler vectorizes to the width of the level, and call nothing inline from other headers: an
+// inline function compiled here with a newer ISA could be the copy the linker keeps for the whole library
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "kernels.h"
+#include "../math/fast_log.h"
+
+namespace dsp::kernels::SDRPP_KERNELS_NAMESPACE {
+#ifdef SDRPP_KERNELS_WIDE
+    static void powerSpectrum(float* out, const complex_t* in, float norm, int count) {
+        float floor = norm * norm * 1e-20f;
+        float offset = -FAST_LOG_DB_FACTOR * log2f(norm * norm);
+        const float* f = (const float*)in;
+        for (int i = 0; i < count; i++) {
+            float re = f[2 * i];
+            float im = f[2 * i + 1];
+            float p = re * re + im * im;
+            p = (p > floor) ? p : floor;
+
+            // Same approximation of the log as dsp::math::fastLog2()
+            uint32_t bits;
+            memcpy(&bits, &p, sizeof(float));
+            float e = (float)((int)(bits >> 23) - 127);
+            bits = (bits & 0x007FFFFF) | 0x3F800000;
+            float t;
+            memcpy(&t, &bits, sizeof(float));
+            t -= 1.0f;
+            float l = e + (FAST_LOG_C0 + t * (FAST_LOG_C1 + t * (FAST_LOG_C2 + t * FAST_LOG_C3)));
+            out[i] = l * FAST_LOG_DB_FACTOR + offset;
+        }
+    }
+#else
+    static void powerSpectrum(float* out, const complex_t* in, float norm, int count) {
+        dsp::math::fastPowerSpectrum(out, in, norm, count);
+    }
+#endif
+
+    static void colorize(uint32_t* out, const float* in, int count, float min, float max, const uint32_t* palette, int paletteSize) {
+        float range = max - min;
+        for (int i = 0; i < count; i++) {
+            float v = in[i];
+            v = (v < min) ? min : v;
+            v = (v > max) ? max : v;
+            out[i] = palette[(int)(((v - min) / range) * (paletteSize - 1))];
+        }
+    }
+
+    static void planarRotate(float* outRe, float* outIm, const float* inRe, const float* inIm, const float* stepRe, const float* stepIm, float phaseRe, float phaseIm, int count) {
+        for (int i = 0; i < count; i++) {
+            float pr = phaseRe * stepRe[i] - phaseIm * stepIm[i];
+            float pi = phaseRe * stepIm[i] + phaseIm * stepRe[i];
+            float re = inRe[i];
+            float im = inIm[i];
+            outRe[i] = re * pr - im * pi;
+            outIm[i] = re * pi + im * pr;
+        }
+    }
+
+    static void planarMagnitude(float* out, const float* re, const float* im, int count) {
+        for (int i = 0; i < count; i++) {
+            out[i] = sqrtf(re[i] * re[i] + im[i] * im[i]);
+        }
+    }
+
+    // Polynomial arctangent of the smaller over the larger component, within about 1e-5 radians, then unfolded
+    static inline float atan2Poly(float y, float x) {
+        float ax = fabsf(x);
+        float ay = fabsf(y);
+        float mx = (ax > ay) ? ax : ay;
+        float mn = (ax > ay) ? ay : ax;
+        float a = mn / ((mx > 0.0f) ? mx : 1.0f);
+        float s = a * a;
+        float r = a * (0.9998660f + s * (-0.3302995f + s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+        r = (ay > ax) ? (1.57079637f - r) : r;
+        r = (x < 0.0f) ? (3.14159274f - r) : r;
+        return (y < 0.0f) ? -r : r;
+    }
+
+    static void planarPhaseDiff(float* out, const float* re, const float* im, float lastRe, float lastIm, float scale, int count) {
+        // Argument of x[n] * conj(x[n-1]), the first sample on its own so that the loop only reads the input
+        if (count <= 0) { return; }
+        out[0] = atan2Poly(im[0] * lastRe - re[0] * lastIm, re[0] * lastRe + im[0] * lastIm) * scale;
+        for (int i = 1; i < count; i++) {
+            float x = re[i] * re[i - 1] + im[i] * im[i - 1];
+            float y = im[i] * re[i - 1] - re[i] * im[i - 1];
+            out[i] = atan2Poly(y, x) * scale;
+        }
+    }
+
+    extern const Table table;
+    const Table table = { SDRPP_KERNELS_NAME, powerSpectrum, colorize, planarRotate, planarMagnitude, planarPhaseDiff };
+}
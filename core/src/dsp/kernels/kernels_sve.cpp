@@ -0,0 +1,7 @@
+// Compiled with -march=armv8-a+sve when OPT_MULTI_ISA_KERNELS is enabled
+#ifdef SDRPP_KERNELS_SVE
+#define SDRPP_KERNELS_NAMESPACE sve
+#define SDRPP_KERNELS_NAME      "armv8-a+sve"
+#define SDRPP_KERNELS_WIDE
+#include "kernels_impl.h"
+#endif
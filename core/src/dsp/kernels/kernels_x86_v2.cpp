@@ -0,0 +1,7 @@
+// Compiled with -march=x86-64-v2 when OPT_MULTI_ISA_KERNELS is enabled
+#ifdef SDRPP_KERNELS_X86_V2
+#define SDRPP_KERNELS_NAMESPACE x86_v2
+#define SDRPP_KERNELS_NAME      "x86-64-v2"
+#define SDRPP_KERNELS_WIDE
+#include "kernels_impl.h"
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <math.h>
+#include <utils/flog.h>
+
+// Duration of the windows over which the average and maximum latency are computed, in seconds
+#define LATENCY_PROBE_WINDOW        1.0
+
+// Interval between two reports of a named probe in the log, in seconds
+#define LATENCY_PROBE_LOG_INTERVAL  60.0
+
+namespace dsp {
+    // Time of the steady clock in seconds, the clock of stream_meta::arrival
+    inline double steadyTime() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Latencies in seconds, the average and maximum being those of the last complete window
+    struct LatencyStats {
+        double current = 0.0;
+        double average = 0.0;
+        double max = 0.0;
+        bool valid = false;     // Buffers went through the probe during the last two windows
+    };
+
+    // Measures the time between samples entering the DSP and them reaching a point of the graph, from the arrival time
+    // carried by the stream metadata. Once given to stream::setLatencyProbe(), the stream updates it from its writer
+    // thread on every swap. The stats can be read from any thread. A named probe also reports to the log periodically
+    class LatencyProbe {
+    public:
+        LatencyProbe() {}
+
+        LatencyProbe(const std::string& name) { setName(name); }
+
+        // Must be set before the probe is updated
+        void setName(const std::string& name) {
+            _name = name;
+        }
+
+        inline void update(double arrival) {
+            if (arrival <= 0.0) { return; }
+            double now = steadyTime();
+            double latency = now - arrival;
+            current.store(latency, std::memory_order_relaxed);
+            lastUpdate.store(now, std::memory_order_relaxed);
+
+            sum += latency;
+            count++;
+            if (latency > peak) { peak = latency; }
+            if (windowStart == 0.0) { windowStart = now; }
+            if (now - windowStart < LATENCY_PROBE_WINDOW) { return; }
+
+            // Publish the window and start the next one
+            double avg = sum / (double)count;
+            average.store(avg, std::memory_order_relaxed);
+            max.store(peak, std::memory_order_relaxed);
+            if (!_name.empty() && now - lastLog >= LATENCY_PROBE_LOG_INTERVAL) {
+                lastLog = now;
+                flog::info("Latency of {0}: {1} ms average, {2} ms max", _name, (int)round(avg * 1e3), (int)round(peak * 1e3));
+            }
+            sum = 0.0;
+            count = 0;
+            peak = 0.0;
+            windowStart = now;
+        }
+
+        LatencyStats getStats() {
+            LatencyStats stats;
+            stats.current = current.load(std::memory_order_relaxed);
+            stats.average = average.load(std::memory_order_relaxed);
+            stats.max = max.load(std::memory_order_relaxed);
+            stats.valid = (lastUpdate.load(std::memory_order_relaxed) > steadyTime() - 2.0 * LATENCY_PROBE_WINDOW);
+            return stats;
+        }
+
+    private:
+        std::string _name;
+
+        std::atomic<double> current = 0.0;
+        std::atomic<double> average = 0.0;
+        std::atomic<double> max = 0.0;
+        std::atomic<double> lastUpdate = 0.0;
+
+        // Window being measured, only used by the writer thread
+        double windowStart = 0.0;
+        double sum = 0.0;
+        int count = 0;
+        double peak = 0.0;
+        double lastLog = 0.0;
+    };
+}
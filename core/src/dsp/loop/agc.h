@@ -1,16 +1,29 @@
 #pragma once
 #include "../processor.h"
+#include "../buffer/buffer.h"
+
+// Look-ahead used by the demodulators, in seconds
+#define AGC_DEMOD_LOOKAHEAD_TIME    0.005
 
 namespace dsp::loop {
+    // When the gain would make a sample clip, it is lowered so that none of the lookahead following samples clip
+    // either. The output is delayed by lookahead samples so that they are known, the highest amplitude of the window
+    // being tracked with a monotonic queue. With no look-ahead only the clipping sample itself is taken into account.
     template <class T>
     class AGC : public Processor<T, T> {
         using base_type = Processor<T, T>;
     public:
         AGC() {}
 
-        AGC(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0) { init(in, setPoint, attack, decay, maxGain, maxOutputAmp, initGain); }
+        AGC(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0, int lookahead = 0) { init(in, setPoint, attack, decay, maxGain, maxOutputAmp, initGain, lookahead); }
+
+        ~AGC() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            freeBuffers();
+        }
 
-        void init(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0) {
+        void init(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0, int lookahead = 0) {
             _setPoint = setPoint;
             _attack = attack;
             _invAttack = 1.0f - _attack;
@@ -20,6 +33,8 @@ namespace dsp::loop {
             _maxOutputAmp = maxOutputAmp;
             _initGain = initGain;
             amp = _setPoint / _initGain;
+            _lookahead = std::max<int>(lookahead, 0);
+            allocBuffers(_lookahead);
             base_type::init(in);
         }
 
@@ -61,24 +76,57 @@ namespace dsp::loop {
             _initGain = initGain;
         }
 
+        // Number of samples the output is delayed by to look for upcoming peaks
+        void setLookahead(int lookahead) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _lookahead = std::max<int>(lookahead, 0);
+            freeBuffers();
+            allocBuffers(_lookahead);
+            base_type::tempStart();
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             amp = _setPoint / _initGain;
+            buffer::clear(work, _lookahead);
+            buffer::clear(amps, _lookahead);
         }
 
         inline int process(int count, T* in, T* out) {
+            // The samples still delayed from the previous call come first
+            int total = _lookahead + count;
+            if (total > capacity) { growBuffers(total); }
+            memcpy(&work[_lookahead], in, count * sizeof(T));
+
+            // Get signal amplitudes
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_magnitude_32f(&amps[_lookahead], (lv_32fc_t*)in, count);
+            }
+            if constexpr (std::is_same_v<T, float>) {
+                for (int i = 0; i < count; i++) { amps[_lookahead + i] = fabsf(in[i]); }
+            }
+
+            // Queue of the indices of decreasing amplitudes in the window, the window of the first sample lacking its last one
+            int head = 0;
+            int tail = 0;
+            for (int j = 0; j < _lookahead; j++) {
+                while (tail > head && amps[queue[tail - 1]] <= amps[j]) { tail--; }
+                queue[tail++] = j;
+            }
+
             for (int i = 0; i < count; i++) {
-                // Get signal amplitude
-                float inAmp, gain;
-                if constexpr (std::is_same_v<T, complex_t>) {
-                    inAmp = in[i].amplitude();
-                }
-                if constexpr (std::is_same_v<T, float>) {
-                    inAmp = fabsf(in[i]);
-                }
+                // Slide the window to [i, i + lookahead]
+                int j = i + _lookahead;
+                while (tail > head && amps[queue[tail - 1]] <= amps[j]) { tail--; }
+                queue[tail++] = j;
+                if (queue[head] < i) { head++; }
 
                 // Update average amplitude
+                float inAmp = amps[i];
+                float gain;
                 if (inAmp != 0.0f) {
                     amp = (inAmp > amp) ? ((amp * _invAttack) + (inAmp * _attack)) : ((amp * _invDecay) + (inAmp * _decay));
                     gain = std::min<float>(_setPoint / amp, _maxGain);
@@ -87,33 +135,37 @@ namespace dsp::loop {
                     gain = 1.0f;
                 }
 
-                // If clipping is detected look ahead and correct
+                // If clipping is detected, lower the gain for the highest peak in the window
                 if (inAmp*gain > _maxOutputAmp) {
-                    float maxAmp = 0;
-                    for (int j = i; j < count; j++) {
-                        if constexpr (std::is_same_v<T, complex_t>) {
-                            inAmp = in[j].amplitude();
-                        }
-                        if constexpr (std::is_same_v<T, float>) {
-                            inAmp = fabsf(in[j]);
-                        }
-                        if (inAmp > maxAmp) { maxAmp = inAmp; }
-                    }
-                    amp = maxAmp;
+                    amp = amps[queue[head]];
                     gain = std::min<float>(_setPoint / amp, _maxGain);
                 }
-                
-                // Scale output by gain
-                out[i] = in[i] * gain;
+                gains[i] = gain;
+            }
+
+            // Scale output by gain
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)out, (lv_32fc_t*)work, gains, count);
             }
+            if constexpr (std::is_same_v<T, float>) {
+                volk_32f_x2_multiply_32f(out, work, gains, count);
+            }
+
+            // Keep the last samples for the next call
+            memmove(work, &work[count], _lookahead * sizeof(T));
+            memmove(amps, &amps[count], _lookahead * sizeof(float));
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return inputCount; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::out.reserve(count);
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -132,5 +184,43 @@ namespace dsp::loop {
 
         float amp = 1.0;
 
+    private:
+        void allocBuffers(int size) {
+            size = std::max<int>(size, 1);
+            work = buffer::alloc<T>(size);
+            amps = buffer::alloc<float>(size);
+            gains = buffer::alloc<float>(size);
+            queue = buffer::alloc<int>(size);
+            buffer::clear(work, size);
+            buffer::clear(amps, size);
+            capacity = size;
+        }
+
+        // Grow the buffers, keeping the delayed samples
+        void growBuffers(int size) {
+            T* oldWork = work;
+            float* oldAmps = amps;
+            buffer::free(gains);
+            buffer::free(queue);
+            allocBuffers(size);
+            memcpy(work, oldWork, _lookahead * sizeof(T));
+            memcpy(amps, oldAmps, _lookahead * sizeof(float));
+            buffer::free(oldWork);
+            buffer::free(oldAmps);
+        }
+
+        void freeBuffers() {
+            buffer::free(work);
+            buffer::free(amps);
+            buffer::free(gains);
+            buffer::free(queue);
+        }
+
+        int _lookahead = 0;
+        int capacity = 0;
+        T* work = NULL;
+        float* amps = NULL;
+        float* gains = NULL;
+        int* queue = NULL;
     };
 }
\ No newline at end of file
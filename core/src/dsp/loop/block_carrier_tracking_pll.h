@@ -0,0 +1,34 @@
+#pragma once
+#include "block_pll.h"
+
+namespace dsp::loop {
+    // Variant of CarrierTrackingPLL updating the loop once every interval samples, see BlockPLL
+    class BlockCarrierTrackingPLL : public BlockPLL {
+        using base_type = BlockPLL;
+    public:
+        BlockCarrierTrackingPLL() {}
+
+        BlockCarrierTrackingPLL(stream<complex_t>* in, double bandwidth, int interval, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            init(in, bandwidth, interval, initPhase, initFreq, minFreq, maxFreq);
+        }
+
+        void init(stream<complex_t>* in, double bandwidth, int interval, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            derotate = true;
+            base_type::init(in, bandwidth, interval, initPhase, initFreq, minFreq, maxFreq);
+        }
+
+        inline int process(int count, const complex_t* in, complex_t* out) {
+            for (int i = 0; i < count;) {
+                int n = std::min<int>(count - i, _interval - pending);
+
+                // The derotated input summed over the interval points at the phase error
+                rotate(n, &in[i], &out[i], ncoStep, nco);
+                for (int j = i; j < i + n; j++) { errCorr += out[j]; }
+
+                i += n;
+                if ((pending += n) == _interval) { update(errCorr.phase()); }
+            }
+            return count;
+        }
+    };
+}
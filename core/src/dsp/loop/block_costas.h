@@ -0,0 +1,37 @@
+#pragma once
+#include "block_pll.h"
+#include "costas.h"
+
+namespace dsp::loop {
+    // Variant of Costas updating the loop once every interval samples, see BlockPLL. The error is averaged over the
+    // interval, the derotation being done with a vectorized rotator
+    template<int ORDER>
+    class BlockCostas : public BlockPLL {
+        static_assert(ORDER == 2 || ORDER == 4 || ORDER == 8, "Invalid costas order");
+        using base_type = BlockPLL;
+    public:
+        BlockCostas() {}
+
+        BlockCostas(stream<complex_t>* in, double bandwidth, int interval, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            init(in, bandwidth, interval, initPhase, initFreq, minFreq, maxFreq);
+        }
+
+        void init(stream<complex_t>* in, double bandwidth, int interval, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            derotate = true;
+            base_type::init(in, bandwidth, interval, initPhase, initFreq, minFreq, maxFreq);
+        }
+
+        inline int process(int count, const complex_t* in, complex_t* out) {
+            for (int i = 0; i < count;) {
+                int n = std::min<int>(count - i, _interval - pending);
+
+                rotate(n, &in[i], &out[i], ncoStep, nco);
+                for (int j = i; j < i + n; j++) { errSum += Costas<ORDER>::errorFunction(out[j]); }
+
+                i += n;
+                if ((pending += n) == _interval) { update(errSum / (float)_interval); }
+            }
+            return count;
+        }
+    };
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include "../processor.h"
+#include "../math/phasor.h"
+#include "phase_control_loop.h"
+
+// Highest loop bandwidth, relative to the update rate, a block loop runs at. Intervals that would exceed it are
+// shortened, the phase error being averaged over a whole interval before the loop reacts to it
+#define BLOCK_PLL_MAX_LOOP_BANDWIDTH    0.125
+
+namespace dsp::loop {
+    // Variant of PLL updating the loop once every interval samples instead of on every sample. The VCO runs at a fixed
+    // frequency over each interval and is generated with a vectorized rotator, the phase error being measured once over
+    // the whole interval. This costs a delay of one interval in the loop, so the bandwidth times the interval is bounded
+    class BlockPLL : public Processor<complex_t, complex_t> {
+        using base_type = Processor<complex_t, complex_t>;
+    public:
+        BlockPLL() {}
+
+        BlockPLL(stream<complex_t>* in, double bandwidth, int interval, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) { init(in, bandwidth, interval, initPhase, initFreq, minFreq, maxFreq); }
+
+        ~BlockPLL() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(ones);
+        }
+
+        void init(stream<complex_t>* in, double bandwidth, int interval, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            _bandwidth = bandwidth;
+            _requestedInterval = interval;
+            _initPhase = initPhase;
+            _initFreq = initFreq;
+            _minFreq = minFreq;
+            _maxFreq = maxFreq;
+            configure(_initPhase, _initFreq);
+
+            base_type::init(in);
+        }
+
+        void setBandwidth(double bandwidth) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _bandwidth = bandwidth;
+            configure(pcl.phase, pcl.freq / _interval);
+            base_type::tempStart();
+        }
+
+        void setInterval(int interval) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _requestedInterval = interval;
+            configure(pcl.phase, pcl.freq / _interval);
+            base_type::tempStart();
+        }
+
+        // Interval actually used, which may be shorter than the one given to keep the loop stable
+        int getInterval() { return _interval; }
+
+        void setInitialPhase(double initPhase) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _initPhase = initPhase;
+        }
+
+        void setInitialFreq(double initFreq) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _initFreq = initFreq;
+        }
+
+        void setFrequencyLimits(double minFreq, double maxFreq) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _minFreq = minFreq;
+            _maxFreq = maxFreq;
+            pcl.setFreqLimits(_minFreq * _interval, _maxFreq * _interval);
+            startInterval();
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            configure(_initPhase, _initFreq);
+            base_type::tempStart();
+        }
+
+        virtual inline int process(int count, const complex_t* in, complex_t* out) {
+            for (int i = 0; i < count;) {
+                int n = std::min<int>(count - i, _interval - pending);
+
+                // Generate the VCO and correlate the input against it
+                rotate(n, ones, &out[i], ncoStep, nco);
+                complex_t corr;
+                volk_32fc_x2_conjugate_dot_prod_32fc((lv_32fc_t*)&corr, (lv_32fc_t*)&in[i], (lv_32fc_t*)&out[i], n);
+                errCorr += corr;
+
+                i += n;
+                if ((pending += n) == _interval) { update(errCorr.phase()); }
+            }
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+
+    protected:
+        // The loop runs once per interval, its frequency being per interval too. freq is given per sample
+        void configure(float phase, float freq) {
+            _interval = std::max<int>(1, (int)std::min<double>(_requestedInterval, BLOCK_PLL_MAX_LOOP_BANDWIDTH / _bandwidth));
+            float alpha, beta;
+            PhaseControlLoop<float>::criticallyDamped(_bandwidth * _interval, alpha, beta);
+            pcl.init(alpha, beta, phase, -FL_M_PI, FL_M_PI, freq * _interval, _minFreq * _interval, _maxFreq * _interval);
+            buffer::free(ones);
+            ones = buffer::alloc<complex_t>(_interval);
+            for (int i = 0; i < _interval; i++) { ones[i] = { 1.0f, 0.0f }; }
+            startInterval();
+        }
+
+        static inline void rotate(int count, const complex_t* in, complex_t* out, complex_t& step, complex_t& phase) {
+#if VOLK_VERSION >= 030100
+            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)out, (lv_32fc_t*)in, (lv_32fc_t*)&step, (lv_32fc_t*)&phase, count);
+#else
+            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)out, (lv_32fc_t*)in, *(lv_32fc_t*)&step, (lv_32fc_t*)&phase, count);
+#endif
+        }
+
+        // Advance the loop with the error measured over the interval that just ended and start the next one
+        inline void update(float error) {
+            pcl.advance(error);
+            startInterval();
+        }
+
+        // Variants derotating the input run the VCO backwards
+        inline void startInterval() {
+            float sign = derotate ? -1.0f : 1.0f;
+            nco = math::phasor(sign * pcl.phase);
+            ncoStep = math::phasor(sign * pcl.freq / _interval);
+            errCorr = { 0.0f, 0.0f };
+            errSum = 0.0f;
+            pending = 0;
+        }
+
+        PhaseControlLoop<float> pcl;
+        double _bandwidth;
+        int _requestedInterval;
+        int _interval;
+        float _initPhase;
+        float _initFreq;
+        float _minFreq;
+        float _maxFreq;
+
+        bool derotate = false;
+        complex_t* ones = NULL;
+        complex_t nco;
+        complex_t ncoStep;
+        complex_t errCorr;
+        float errSum;
+        int pending;
+    };
+}
@@ -22,8 +22,8 @@ namespace dsp::loop {
             return count;
         }
 
-    protected:
-        inline float errorFunction(complex_t val) {
+        // Also used by BlockCostas
+        static inline float errorFunction(complex_t val) {
             float err;
             if constexpr (ORDER == 2) {
                 err = val.re * val.im;
@@ -1,6 +1,9 @@
 #pragma once
 #include "../processor.h"
 
+// Number of samples whose gains are computed at once
+#define FAST_AGC_CHUNK_SIZE 1024
+
 namespace dsp::loop {
     template <class T>
     class FastAGC : public Processor<T, T> {
@@ -58,22 +61,34 @@ namespace dsp::loop {
         }
 
         inline int process(int count, T* in, T* out) {
-            for (int i = 0; i < count; i++) {
-                // Output scaled input
-                out[i] = in[i] * _gain;
+            for (int i = 0; i < count; i += FAST_AGC_CHUNK_SIZE) {
+                int n = std::min<int>(FAST_AGC_CHUNK_SIZE, count - i);
 
-                // Calculate output amplitude
-                float amp;
+                // Get input amplitudes
                 if constexpr (std::is_same_v<T, float>) {
-                    amp = fabsf(out[i]);
+                    for (int j = 0; j < n; j++) { gains[j] = fabsf(in[i + j]); }
                 }
                 if constexpr (std::is_same_v<T, complex_t>) {
-                    amp = out[i].amplitude();
+                    volk_32fc_magnitude_32f(gains, (lv_32fc_t*)&in[i], n);
+                }
+
+                // Run the loop on the output amplitudes, the amplitudes being replaced in place by the gains used
+                for (int j = 0; j < n; j++) {
+                    float amp = gains[j] * fabsf(_gain);
+                    gains[j] = _gain;
+
+                    // Update and clamp gain
+                    _gain += (_setPoint - amp) * _rate;
+                    if (_gain > _maxGain) { _gain = _maxGain; }
                 }
 
-                // Update and clamp gain
-                _gain += (_setPoint - amp) * _rate;
-                if (_gain > _maxGain) { _gain = _maxGain; }
+                // Output scaled input
+                if constexpr (std::is_same_v<T, float>) {
+                    volk_32f_x2_multiply_32f(&out[i], &in[i], gains, n);
+                }
+                if constexpr (std::is_same_v<T, complex_t>) {
+                    volk_32fc_32f_multiply_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&in[i], gains, n);
+                }
             }
             return count;
         }
@@ -83,6 +98,7 @@ namespace dsp::loop {
             if (count < 0) { return -1; }
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -96,5 +112,8 @@ namespace dsp::loop {
         float _maxGain;
         float _initGain;
 
+    private:
+        float gains[FAST_AGC_CHUNK_SIZE];
+
     };
 }
\ No newline at end of file
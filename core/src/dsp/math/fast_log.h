@@ -0,0 +1,102 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "../types.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FAST_LOG_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FAST_LOG_NEON
+#endif
+
+// Minimax polynomial of log2(1 + t) for t from 0 to 1, within 0.00064 of it, 0.002dB once scaled to decibels
+#define FAST_LOG_C0     0.00063711728f
+#define FAST_LOG_C1     1.41888021f
+#define FAST_LOG_C2     -0.57712891f
+#define FAST_LOG_C3     0.15824870f
+
+// 10 * log10(2), converting log2 of a power to dB
+#define FAST_LOG_DB_FACTOR  3.01029996f
+
+namespace dsp::math {
+    // log2 of a positive normal number, its exponent being extracted from the bits of the float and the log of its
+    // mantissa approximated by a polynomial
+    inline float fastLog2(float x) {
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(float));
+        float e = (float)((int)((bits >> 23) & 0xFF) - 127);
+        bits = (bits & 0x007FFFFF) | 0x3F800000;
+        float t;
+        memcpy(&t, &bits, sizeof(float));
+        t -= 1.0f;
+        return e + (FAST_LOG_C0 + t * (FAST_LOG_C1 + t * (FAST_LOG_C2 + t * FAST_LOG_C3)));
+    }
+
+    // Power in dB of the samples scaled down by norm, like volk_32fc_s32f_power_spectrum_32f but within 0.002dB of it.
+    // The power is clamped 200dB below full scale so that empty bins don't give -inf, which also keeps it normal
+    inline void fastPowerSpectrum(float* out, const complex_t* in, float norm, int count) {
+        float floor = norm * norm * 1e-20f;
+        float offset = -FAST_LOG_DB_FACTOR * log2f(norm * norm);
+        int i = 0;
+
+#if defined(FAST_LOG_SSE2)
+        const __m128 vFloor = _mm_set1_ps(floor);
+        const __m128 vOne = _mm_set1_ps(1.0f);
+        const __m128 vFactor = _mm_set1_ps(FAST_LOG_DB_FACTOR);
+        const __m128 vOffset = _mm_set1_ps(offset);
+        const __m128i vMantMask = _mm_set1_epi32(0x007FFFFF);
+        const __m128i vOneBits = _mm_set1_epi32(0x3F800000);
+        const __m128i vBias = _mm_set1_epi32(127);
+        const float* f = (const float*)in;
+        for (; i + 4 <= count; i += 4) {
+            // Deinterleave four samples
+            __m128 a = _mm_loadu_ps(&f[2 * i]);
+            __m128 b = _mm_loadu_ps(&f[2 * i + 4]);
+            __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            __m128 p = _mm_max_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)), vFloor);
+
+            // Split the power into its exponent and mantissa
+            __m128i bits = _mm_castps_si128(p);
+            __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), vBias));
+            __m128 t = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, vMantMask), vOneBits)), vOne);
+
+            __m128 l = _mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(FAST_LOG_C3)), _mm_set1_ps(FAST_LOG_C2));
+            l = _mm_add_ps(_mm_mul_ps(t, l), _mm_set1_ps(FAST_LOG_C1));
+            l = _mm_add_ps(_mm_mul_ps(t, l), _mm_set1_ps(FAST_LOG_C0));
+            l = _mm_add_ps(l, e);
+            _mm_storeu_ps(&out[i], _mm_add_ps(_mm_mul_ps(l, vFactor), vOffset));
+        }
+#elif defined(FAST_LOG_NEON)
+        const float32x4_t vFloor = vdupq_n_f32(floor);
+        const float32x4_t vOne = vdupq_n_f32(1.0f);
+        const float32x4_t vOffset = vdupq_n_f32(offset);
+        const uint32x4_t vMantMask = vdupq_n_u32(0x007FFFFF);
+        const uint32x4_t vOneBits = vdupq_n_u32(0x3F800000);
+        const int32x4_t vBias = vdupq_n_s32(127);
+        const float* f = (const float*)in;
+        for (; i + 4 <= count; i += 4) {
+            float32x4x2_t s = vld2q_f32(&f[2 * i]);
+            float32x4_t p = vmaxq_f32(vmlaq_f32(vmulq_f32(s.val[0], s.val[0]), s.val[1], s.val[1]), vFloor);
+
+            uint32x4_t bits = vreinterpretq_u32_f32(p);
+            float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vBias));
+            float32x4_t t = vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vMantMask), vOneBits)), vOne);
+
+            float32x4_t l = vmlaq_f32(vdupq_n_f32(FAST_LOG_C2), t, vdupq_n_f32(FAST_LOG_C3));
+            l = vmlaq_f32(vdupq_n_f32(FAST_LOG_C1), t, l);
+            l = vmlaq_f32(vdupq_n_f32(FAST_LOG_C0), t, l);
+            l = vaddq_f32(l, e);
+            vst1q_f32(&out[i], vmlaq_f32(vOffset, l, vdupq_n_f32(FAST_LOG_DB_FACTOR)));
+        }
+#endif
+
+        for (; i < count; i++) {
+            float p = fmaxf((in[i].re * in[i].re) + (in[i].im * in[i].im), floor);
+            out[i] = (FAST_LOG_DB_FACTOR * fastLog2(p)) + offset;
+        }
+    }
+}
@@ -32,6 +32,7 @@ namespace dsp::math {
             }
 
             process(a_count, base_type::_a->readBuf, base_type::_b->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_a->readMeta;
 
             base_type::_a->flush();
             base_type::_b->flush();
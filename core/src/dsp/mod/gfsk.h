@@ -13,6 +13,7 @@ namespace dsp::mod {
         }
 
         void init(stream<float>* in, double symbolrate, double samplerate, double rrcBeta, int rrcTapCount, double deviation) {
+            _symbolrate = symbolrate;
             _samplerate = samplerate;
             _deviation = deviation;
             
@@ -26,6 +27,7 @@ namespace dsp::mod {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
+            _symbolrate = symbolrate;
             _samplerate = samplerate;
             interp.setRates(symbolrate, _samplerate);
             mod.setDeviation(_deviation, _samplerate);
@@ -67,6 +69,7 @@ namespace dsp::mod {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_samplerate / _symbolrate);
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -77,6 +80,7 @@ namespace dsp::mod {
         }
 
     private:
+        double _symbolrate;
         double _samplerate;
         double _deviation;
 
@@ -0,0 +1,202 @@
+#pragma once
+#include <stdint.h>
+#include "../processor.h"
+
+// Number of integrator and comb stages
+#define CIC_DECIMATOR_ORDER         4
+
+// Bits of the fixed point input below 1.0 when the ratio leaves room for them, the input itself is kept on 32 bits
+#define CIC_DECIMATOR_INPUT_BITS    24
+
+// Bits of the accumulators left for the growth of the output, allows the input to go up to 8.0 at any ratio
+#define CIC_DECIMATOR_GROWTH_BITS   60
+
+namespace dsp::multirate {
+    // Cascaded integrator-comb decimator. The samples are converted to fixed point and only go through additions, the
+    // integrators being left to wrap around which the combs undo exactly. The response is a sinc to the power of the
+    // order, its droop is flattened by a three tap filter on the output. The aliases it lets through are only at least
+    // 90dB down within the lowest eighth of its output band, so it must be followed by more decimation, see
+    // dsp::multirate::PowerDecimator.
+    template <class T>
+    class CICDecimator : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        // Components per sample when handled as an array of floats
+        static constexpr int COMPONENTS = std::is_same_v<T, float> ? 1 : 2;
+
+        CICDecimator() {}
+
+        CICDecimator(stream<T>* in, int decimation) { init(in, decimation); }
+
+        ~CICDecimator() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(fixed);
+        }
+
+        void init(stream<T>* in, int decimation) {
+            configure(decimation);
+            base_type::init(in);
+        }
+
+        void setDecimation(int decimation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            configure(decimation);
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            clearState();
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            if (count > capacity) { grow(count); }
+
+            // Convert to fixed point all at once, the conversion vectorizes unlike the integrators
+            const float* x = (const float*)in;
+            int len = count * COMPONENTS;
+            for (int j = 0; j < len; j++) { fixed[j] = (int32_t)(x[j] * inScale); }
+
+            return integrate(count, out);
+        }
+
+        // Same as process() with 16 bit IQ input, whose full scale is given by scale
+        inline int process(int count, const complex_s16_t* in, T* out, float scale) {
+            static_assert(std::is_same_v<T, complex_t>, "Only complex samples can be given as 16 bit IQ");
+            if (count > capacity) { grow(count); }
+
+            const int16_t* x = (const int16_t*)in;
+            float s = inScale / scale;
+            int len = count * COMPONENTS;
+            for (int j = 0; j < len; j++) { fixed[j] = (int32_t)((float)x[j] * s); }
+
+            return integrate(count, out);
+        }
+
+        int maxOutputCount(int inputCount) { return (inputCount / _decimation) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / (double)_decimation);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // Run the fixed point samples through the filter
+        inline int integrate(int count, T* out) {
+            float* y = (float*)out;
+            int outCount = 0;
+
+            // The state is kept in locals so that it stays in registers, each component being integrated on its own
+            uint64_t integ[CIC_DECIMATOR_ORDER][COMPONENTS];
+            memcpy(integ, integrators, sizeof(integ));
+
+            int i = 0;
+            int ph = phase;
+            int dec = _decimation;
+            while (i < count) {
+                // Integrate up to the next output
+                int n = std::min<int>(count - i, dec - ph);
+                const int32_t* f = &fixed[i * COMPONENTS];
+                for (int c = 0; c < COMPONENTS; c++) {
+                    uint64_t acc[CIC_DECIMATOR_ORDER];
+                    for (int s = 0; s < CIC_DECIMATOR_ORDER; s++) { acc[s] = integ[s][c]; }
+                    for (int k = 0; k < n; k++) {
+                        uint64_t v = (uint64_t)(int64_t)f[k * COMPONENTS + c];
+                        for (int s = 0; s < CIC_DECIMATOR_ORDER; s++) {
+                            acc[s] += v;
+                            v = acc[s];
+                        }
+                    }
+                    for (int s = 0; s < CIC_DECIMATOR_ORDER; s++) { integ[s][c] = acc[s]; }
+                }
+                i += n;
+                ph += n;
+                if (ph < dec) { break; }
+                ph = 0;
+
+                // Differentiate the decimated integrators and compensate, which delays the output by one sample
+                for (int c = 0; c < COMPONENTS; c++) {
+                    uint64_t v = integ[CIC_DECIMATOR_ORDER - 1][c];
+                    for (int s = 0; s < CIC_DECIMATOR_ORDER; s++) {
+                        uint64_t d = v - combs[s][c];
+                        combs[s][c] = v;
+                        v = d;
+                    }
+                    float cur = (float)(int64_t)v * outScale;
+                    y[outCount * COMPONENTS + c] = (compCenter * last[0][c]) + (compSide * (last[1][c] + cur));
+                    last[1][c] = last[0][c];
+                    last[0][c] = cur;
+                }
+                outCount++;
+            }
+
+            memcpy(integrators, integ, sizeof(integ));
+            phase = ph;
+            return outCount;
+        }
+
+        void configure(int decimation) {
+            assert(decimation >= 1);
+            _decimation = decimation;
+
+            // The gain is decimation^order, take as many fractional bits as that leaves room for
+            double growth = CIC_DECIMATOR_ORDER * log2((double)_decimation);
+            int inBits = std::min<int>(CIC_DECIMATOR_INPUT_BITS, floor(CIC_DECIMATOR_GROWTH_BITS - growth));
+            inScale = pow(2.0, inBits);
+            outScale = 1.0 / (inScale * pow((double)_decimation, CIC_DECIMATOR_ORDER));
+
+            // The droop is about order * (pi * f)^2 / 6 at low frequencies, set the boost of the filter to match it
+            double a = (double)CIC_DECIMATOR_ORDER / 24.0;
+            compCenter = 1.0 + 2.0 * a;
+            compSide = -a;
+
+            clearState();
+        }
+
+        void grow(int count) {
+            buffer::free(fixed);
+            fixed = buffer::alloc<int32_t>(count * COMPONENTS);
+            capacity = count;
+        }
+
+        void clearState() {
+            memset(integrators, 0, sizeof(integrators));
+            memset(combs, 0, sizeof(combs));
+            memset(last, 0, sizeof(last));
+            phase = 0;
+        }
+
+        int _decimation = 1;
+        float inScale = 1.0f;
+        float outScale = 1.0f;
+
+        uint64_t integrators[CIC_DECIMATOR_ORDER][COMPONENTS];
+        uint64_t combs[CIC_DECIMATOR_ORDER][COMPONENTS];
+        int phase = 0;
+
+        // Compensation filter and its last two inputs
+        float compCenter = 1.0f;
+        float compSide = 0.0f;
+        float last[2][COMPONENTS];
+
+        int32_t* fixed = NULL;
+        int capacity = 0;
+    };
+}
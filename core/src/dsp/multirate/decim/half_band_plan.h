@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include "../../taps/half_band.h"
+
+namespace dsp::multirate::decim {
+    // Taps of a cascade of half-band filters decimating by 2^stages. The passband is the fraction of the output
+    // bandwidth to keep free of aliases, each stage only needing to protect that same band. Only the last stages have
+    // a narrow transition, at the first ones the band is tiny compared to their samplerate and a few taps do.
+    inline std::vector<tap<float>> halfBandPlan(int stages, double passband, double attenuation) {
+        std::vector<tap<float>> plan;
+        for (int i = 0; i < stages; i++) {
+            // Work relative to the output samplerate, the input samplerate of the stage being 2^(stages - i)
+            double samplerate = (double)(1 << (stages - i));
+            plan.push_back(taps::halfBand(passband / 2.0, samplerate, attenuation));
+        }
+        return plan;
+    }
+}
@@ -1,269 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_1024_64_len = 257;
-    const float fir_1024_64_taps[] = {
-        0.000006462031529,
-        0.000003762409463,
-        0.000004844873785,
-        0.000006123946040,
-        0.000007623557621,
-        0.000009369500189,
-        0.000011389489511,
-        0.000013713225713,
-        0.000016372450007,
-        0.000019400995965,
-        0.000022834836357,
-        0.000026712124166,
-        0.000031073227314,
-        0.000035960757034,
-        0.000041419588684,
-        0.000047496875380,
-        0.000054242053050,
-        0.000061706837053,
-        0.000069945209697,
-        0.000079013398311,
-        0.000088969843345,
-        0.000099875155888,
-        0.000111792065160,
-        0.000124785354321,
-        0.000138921785260,
-        0.000154270012137,
-        0.000170900482798,
-        0.000188885328279,
-        0.000208298240660,
-        0.000229214338496,
-        0.000251710020027,
-        0.000275862804808,
-        0.000301751162750,
-        0.000329454331625,
-        0.000359052122812,
-        0.000390624715628,
-        0.000424252440518,
-        0.000460015551653,
-        0.000497993989069,
-        0.000538267130868,
-        0.000580913536707,
-        0.000626010681838,
-        0.000673634683977,
-        0.000723860022294,
-        0.000776759250136,
-        0.000832402702294,
-        0.000890858197110,
-        0.000952190735149,
-        0.001016462194703,
-        0.001083731025617,
-        0.001154051942217,
-        0.001227475616900,
-        0.001304048374716,
-        0.001383811890755,
-        0.001466802891491,
-        0.001553052860930,
-        0.001642587753007,
-        0.001735427711423,
-        0.001831586798359,
-        0.001931072732585,
-        0.002033886639476,
-        0.002140022812541,
-        0.002249468489330,
-        0.002362203641302,
-        0.002478200780155,
-        0.002597424780897,
-        0.002719832722953,
-        0.002845373750630,
-        0.002973988953416,
-        0.003105611267477,
-        0.003240165399026,
-        0.003377567770453,
-        0.003517726489639,
-        0.003660541344023,
-        0.003805903818490,
-        0.003953697139430,
-        0.004103796343600,
-        0.004256068373481,
-        0.004410372198649,
-        0.004566558963662,
-        0.004724472161982,
-        0.004883947836741,
-        0.005044814807351,
-        0.005206894922255,
-        0.005370003337046,
-        0.005533948818282,
-        0.005698534071229,
-        0.005863556091925,
-        0.006028806542319,
-        0.006194072147902,
-        0.006359135116484,
-        0.006523773577483,
-        0.006687762040265,
-        0.006850871870724,
-        0.007012871784157,
-        0.007173528353865,
-        0.007332606533364,
-        0.007489870190776,
-        0.007645082654370,
-        0.007798007266777,
-        0.007948407946740,
-        0.008096049756555,
-        0.008240699473269,
-        0.008382126161983,
-        0.008520101749207,
-        0.008654401594640,
-        0.008784805059577,
-        0.008911096069443,
-        0.009033063669314,
-        0.009150502570440,
-        0.009263213685289,
-        0.009371004650260,
-        0.009473690333377,
-        0.009571093325806,
-        0.009663044415454,
-        0.009749383040556,
-        0.009829957722201,
-        0.009904626474092,
-        0.009973257187859,
-        0.010035727993149,
-        0.010091927590538,
-        0.010141755556416,
-        0.010185122619096,
-        0.010221950904489,
-        0.010252174150955,
-        0.010275737892470,
-        0.010292599609103,
-        0.010302728845123,
-        0.010306107293174,
-        0.010302728845123,
-        0.010292599609103,
-        0.010275737892470,
-        0.010252174150955,
-        0.010221950904489,
-        0.010185122619096,
-        0.010141755556416,
-        0.010091927590538,
-        0.010035727993149,
-        0.009973257187859,
-        0.009904626474092,
-        0.009829957722201,
-        0.009749383040556,
-        0.009663044415454,
-        0.009571093325806,
-        0.009473690333377,
-        0.009371004650260,
-        0.009263213685289,
-        0.009150502570440,
-        0.009033063669314,
-        0.008911096069443,
-        0.008784805059577,
-        0.008654401594640,
-        0.008520101749207,
-        0.008382126161983,
-        0.008240699473269,
-        0.008096049756555,
-        0.007948407946740,
-        0.007798007266777,
-        0.007645082654370,
-        0.007489870190776,
-        0.007332606533364,
-        0.007173528353865,
-        0.007012871784157,
-        0.006850871870724,
-        0.006687762040265,
-        0.006523773577483,
-        0.006359135116484,
-        0.006194072147902,
-        0.006028806542319,
-        0.005863556091925,
-        0.005698534071229,
-        0.005533948818282,
-        0.005370003337046,
-        0.005206894922255,
-        0.005044814807351,
-        0.004883947836741,
-        0.004724472161982,
-        0.004566558963662,
-        0.004410372198649,
-        0.004256068373481,
-        0.004103796343600,
-        0.003953697139430,
-        0.003805903818490,
-        0.003660541344023,
-        0.003517726489639,
-        0.003377567770453,
-        0.003240165399026,
-        0.003105611267477,
-        0.002973988953416,
-        0.002845373750630,
-        0.002719832722953,
-        0.002597424780897,
-        0.002478200780155,
-        0.002362203641302,
-        0.002249468489330,
-        0.002140022812541,
-        0.002033886639476,
-        0.001931072732585,
-        0.001831586798359,
-        0.001735427711423,
-        0.001642587753007,
-        0.001553052860930,
-        0.001466802891491,
-        0.001383811890755,
-        0.001304048374716,
-        0.001227475616900,
-        0.001154051942217,
-        0.001083731025617,
-        0.001016462194703,
-        0.000952190735149,
-        0.000890858197110,
-        0.000832402702294,
-        0.000776759250136,
-        0.000723860022294,
-        0.000673634683977,
-        0.000626010681838,
-        0.000580913536707,
-        0.000538267130868,
-        0.000497993989069,
-        0.000460015551653,
-        0.000424252440518,
-        0.000390624715628,
-        0.000359052122812,
-        0.000329454331625,
-        0.000301751162750,
-        0.000275862804808,
-        0.000251710020027,
-        0.000229214338496,
-        0.000208298240660,
-        0.000188885328279,
-        0.000170900482798,
-        0.000154270012137,
-        0.000138921785260,
-        0.000124785354321,
-        0.000111792065160,
-        0.000099875155888,
-        0.000088969843345,
-        0.000079013398311,
-        0.000069945209697,
-        0.000061706837053,
-        0.000054242053050,
-        0.000047496875380,
-        0.000041419588684,
-        0.000035960757034,
-        0.000031073227314,
-        0.000026712124166,
-        0.000022834836357,
-        0.000019400995965,
-        0.000016372450007,
-        0.000013713225713,
-        0.000011389489511,
-        0.000009369500189,
-        0.000007623557621,
-        0.000006123946040,
-        0.000004844873785,
-        0.000003762409463,
-        0.000006462031529,
-    };
-}
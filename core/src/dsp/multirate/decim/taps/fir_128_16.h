@@ -1,84 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_128_16_len = 72;
-    const float fir_128_16_taps[] = {
-        0.000003688211243,
-        0.000013660745184,
-        0.000027864244875,
-        0.000056024595736,
-        0.000099948148808,
-        0.000168552197041,
-        0.000269382284025,
-        0.000413325712010,
-        0.000612084815649,
-        0.000879405538662,
-        0.001230104825804,
-        0.001680092905716,
-        0.002245658820654,
-        0.002942957882659,
-        0.003787212583021,
-        0.004791922493325,
-        0.005967969572298,
-        0.007322738536994,
-        0.008859256322921,
-        0.010575423925694,
-        0.012463379308760,
-        0.014509046778473,
-        0.016691912242846,
-        0.018985060458242,
-        0.021355495646189,
-        0.023764754477139,
-        0.026169804021396,
-        0.028524201614471,
-        0.030779477612194,
-        0.032886687871454,
-        0.034798070863046,
-        0.036468735790737,
-        0.037858303447209,
-        0.038932421304764,
-        0.039664078609141,
-        0.040034655893826,
-        0.040034655893826,
-        0.039664078609141,
-        0.038932421304764,
-        0.037858303447209,
-        0.036468735790737,
-        0.034798070863046,
-        0.032886687871454,
-        0.030779477612194,
-        0.028524201614471,
-        0.026169804021396,
-        0.023764754477139,
-        0.021355495646189,
-        0.018985060458242,
-        0.016691912242846,
-        0.014509046778473,
-        0.012463379308760,
-        0.010575423925694,
-        0.008859256322921,
-        0.007322738536994,
-        0.005967969572298,
-        0.004791922493325,
-        0.003787212583021,
-        0.002942957882659,
-        0.002245658820654,
-        0.001680092905716,
-        0.001230104825804,
-        0.000879405538662,
-        0.000612084815649,
-        0.000413325712010,
-        0.000269382284025,
-        0.000168552197041,
-        0.000099948148808,
-        0.000056024595736,
-        0.000027864244875,
-        0.000013660745184,
-        0.000003688211243,
-    };
-}
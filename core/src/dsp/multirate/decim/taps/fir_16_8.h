@@ -1,66 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_16_8_len = 54;
-    const float fir_16_8_taps[] = {
-        -0.000010549050011,
-        -0.000061489537039,
-        -0.000169592150226,
-        -0.000389171926135,
-        -0.000769975911674,
-        -0.001370854592385,
-        -0.002239650734147,
-        -0.003399889102518,
-        -0.004830705343877,
-        -0.006448446354249,
-        -0.008091855414668,
-        -0.009515841436220,
-        -0.010397441921856,
-        -0.010356613271974,
-        -0.008992201469341,
-        -0.005930787518203,
-        -0.000883278427221,
-        0.006298245739840,
-        0.015572308400311,
-        0.026677311102094,
-        0.039125595948408,
-        0.052226522148894,
-        0.065138644768753,
-        0.076946519590666,
-        0.086753453366436,
-        0.093778448420600,
-        0.097444265291570,
-        0.097444265291570,
-        0.093778448420600,
-        0.086753453366436,
-        0.076946519590666,
-        0.065138644768753,
-        0.052226522148894,
-        0.039125595948408,
-        0.026677311102094,
-        0.015572308400311,
-        0.006298245739840,
-        -0.000883278427221,
-        -0.005930787518203,
-        -0.008992201469341,
-        -0.010356613271974,
-        -0.010397441921856,
-        -0.009515841436220,
-        -0.008091855414668,
-        -0.006448446354249,
-        -0.004830705343877,
-        -0.003399889102518,
-        -0.002239650734147,
-        -0.001370854592385,
-        -0.000769975911674,
-        -0.000389171926135,
-        -0.000169592150226,
-        -0.000061489537039,
-        -0.000010549050011,
-    };
-}
@@ -1,341 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_2048_64_len = 329;
-    const float fir_2048_64_taps[] = {
-        0.000000000199668,
-        0.000000205043166,
-        0.000000156335587,
-        0.000000215541606,
-        0.000000289043906,
-        0.000000379397653,
-        0.000000489366234,
-        0.000000622040059,
-        0.000000780862872,
-        0.000000969659261,
-        0.000001192663259,
-        0.000001454547981,
-        0.000001760456262,
-        0.000002116032238,
-        0.000002527453817,
-        0.000003001465946,
-        0.000003545414625,
-        0.000004167281561,
-        0.000004875719359,
-        0.000005680087172,
-        0.000006590486661,
-        0.000007617798168,
-        0.000008773716957,
-        0.000010070789376,
-        0.000011522448815,
-        0.000013143051261,
-        0.000014947910332,
-        0.000016953331574,
-        0.000019176645863,
-        0.000021636241718,
-        0.000024351596326,
-        0.000027343305093,
-        0.000030633109489,
-        0.000034243923000,
-        0.000038199854973,
-        0.000042526232102,
-        0.000047249617395,
-        0.000052397826336,
-        0.000057999940064,
-        0.000064086315335,
-        0.000070688591034,
-        0.000077839691045,
-        0.000085573823231,
-        0.000093926474339,
-        0.000102934400627,
-        0.000112635613980,
-        0.000123069363379,
-        0.000134276111489,
-        0.000146297506226,
-        0.000159176347141,
-        0.000172956546458,
-        0.000187683084638,
-        0.000203401960366,
-        0.000220160134836,
-        0.000238005470250,
-        0.000256986662475,
-        0.000277153167800,
-        0.000298555123757,
-        0.000321243264012,
-        0.000345268827318,
-        0.000370683460586,
-        0.000397539116108,
-        0.000425887943051,
-        0.000455782173269,
-        0.000487274001624,
-        0.000520415460934,
-        0.000555258291741,
-        0.000591853807104,
-        0.000630252752645,
-        0.000670505162114,
-        0.000712660208750,
-        0.000756766052737,
-        0.000802869685119,
-        0.000851016768484,
-        0.000901251474847,
-        0.000953616321094,
-        0.001008152002452,
-        0.001064897224391,
-        0.001123888533469,
-        0.001185160147570,
-        0.001248743786063,
-        0.001314668500389,
-        0.001382960505628,
-        0.001453643013568,
-        0.001526736067868,
-        0.001602256381861,
-        0.001680217179590,
-        0.001760628040646,
-        0.001843494749418,
-        0.001928819149316,
-        0.002016599002583,
-        0.002106827856267,
-        0.002199494914939,
-        0.002294584920730,
-        0.002392078041256,
-        0.002491949765985,
-        0.002594170811576,
-        0.002698707036722,
-        0.002805519367007,
-        0.002914563730244,
-        0.003025791002763,
-        0.003139146967090,
-        0.003254572281416,
-        0.003372002461236,
-        0.003491367873501,
-        0.003612593743601,
-        0.003735600175462,
-        0.003860302184972,
-        0.003986609746975,
-        0.004114427855956,
-        0.004243656600570,
-        0.004374191252069,
-        0.004505922366671,
-        0.004638735901866,
-        0.004772513346579,
-        0.004907131865119,
-        0.005042464454740,
-        0.005178380116639,
-        0.005314744040122,
-        0.005451417799686,
-        0.005588259564642,
-        0.005725124320935,
-        0.005861864104709,
-        0.005998328247162,
-        0.006134363630171,
-        0.006269814952126,
-        0.006404525003407,
-        0.006538334950818,
-        0.006671084630359,
-        0.006802612847587,
-        0.006932757684861,
-        0.007061356814659,
-        0.007188247818209,
-        0.007313268508566,
-        0.007436257257322,
-        0.007557053324043,
-        0.007675497187571,
-        0.007791430878266,
-        0.007904698310281,
-        0.008015145612939,
-        0.008122621460286,
-        0.008226977397872,
-        0.008328068165838,
-        0.008425752017374,
-        0.008519891031616,
-        0.008610351420080,
-        0.008697003825729,
-        0.008779723613781,
-        0.008858391153404,
-        0.008932892089457,
-        0.009003117603448,
-        0.009068964662954,
-        0.009130336258703,
-        0.009187141628648,
-        0.009239296468318,
-        0.009286723126810,
-        0.009329350787828,
-        0.009367115635223,
-        0.009399961002488,
-        0.009427837505799,
-        0.009450703160140,
-        0.009468523478197,
-        0.009481271551679,
-        0.009488928114839,
-        0.009491481589983,
-        0.009488928114839,
-        0.009481271551679,
-        0.009468523478197,
-        0.009450703160140,
-        0.009427837505799,
-        0.009399961002488,
-        0.009367115635223,
-        0.009329350787828,
-        0.009286723126810,
-        0.009239296468318,
-        0.009187141628648,
-        0.009130336258703,
-        0.009068964662954,
-        0.009003117603448,
-        0.008932892089457,
-        0.008858391153404,
-        0.008779723613781,
-        0.008697003825729,
-        0.008610351420080,
-        0.008519891031616,
-        0.008425752017374,
-        0.008328068165838,
-        0.008226977397872,
-        0.008122621460286,
-        0.008015145612939,
-        0.007904698310281,
-        0.007791430878266,
-        0.007675497187571,
-        0.007557053324043,
-        0.007436257257322,
-        0.007313268508566,
-        0.007188247818209,
-        0.007061356814659,
-        0.006932757684861,
-        0.006802612847587,
-        0.006671084630359,
-        0.006538334950818,
-        0.006404525003407,
-        0.006269814952126,
-        0.006134363630171,
-        0.005998328247162,
-        0.005861864104709,
-        0.005725124320935,
-        0.005588259564642,
-        0.005451417799686,
-        0.005314744040122,
-        0.005178380116639,
-        0.005042464454740,
-        0.004907131865119,
-        0.004772513346579,
-        0.004638735901866,
-        0.004505922366671,
-        0.004374191252069,
-        0.004243656600570,
-        0.004114427855956,
-        0.003986609746975,
-        0.003860302184972,
-        0.003735600175462,
-        0.003612593743601,
-        0.003491367873501,
-        0.003372002461236,
-        0.003254572281416,
-        0.003139146967090,
-        0.003025791002763,
-        0.002914563730244,
-        0.002805519367007,
-        0.002698707036722,
-        0.002594170811576,
-        0.002491949765985,
-        0.002392078041256,
-        0.002294584920730,
-        0.002199494914939,
-        0.002106827856267,
-        0.002016599002583,
-        0.001928819149316,
-        0.001843494749418,
-        0.001760628040646,
-        0.001680217179590,
-        0.001602256381861,
-        0.001526736067868,
-        0.001453643013568,
-        0.001382960505628,
-        0.001314668500389,
-        0.001248743786063,
-        0.001185160147570,
-        0.001123888533469,
-        0.001064897224391,
-        0.001008152002452,
-        0.000953616321094,
-        0.000901251474847,
-        0.000851016768484,
-        0.000802869685119,
-        0.000756766052737,
-        0.000712660208750,
-        0.000670505162114,
-        0.000630252752645,
-        0.000591853807104,
-        0.000555258291741,
-        0.000520415460934,
-        0.000487274001624,
-        0.000455782173269,
-        0.000425887943051,
-        0.000397539116108,
-        0.000370683460586,
-        0.000345268827318,
-        0.000321243264012,
-        0.000298555123757,
-        0.000277153167800,
-        0.000256986662475,
-        0.000238005470250,
-        0.000220160134836,
-        0.000203401960366,
-        0.000187683084638,
-        0.000172956546458,
-        0.000159176347141,
-        0.000146297506226,
-        0.000134276111489,
-        0.000123069363379,
-        0.000112635613980,
-        0.000102934400627,
-        0.000093926474339,
-        0.000085573823231,
-        0.000077839691045,
-        0.000070688591034,
-        0.000064086315335,
-        0.000057999940064,
-        0.000052397826336,
-        0.000047249617395,
-        0.000042526232102,
-        0.000038199854973,
-        0.000034243923000,
-        0.000030633109489,
-        0.000027343305093,
-        0.000024351596326,
-        0.000021636241718,
-        0.000019176645863,
-        0.000016953331574,
-        0.000014947910332,
-        0.000013143051261,
-        0.000011522448815,
-        0.000010070789376,
-        0.000008773716957,
-        0.000007617798168,
-        0.000006590486661,
-        0.000005680087172,
-        0.000004875719359,
-        0.000004167281561,
-        0.000003545414625,
-        0.000003001465946,
-        0.000002527453817,
-        0.000002116032238,
-        0.000001760456262,
-        0.000001454547981,
-        0.000001192663259,
-        0.000000969659261,
-        0.000000780862872,
-        0.000000622040059,
-        0.000000489366234,
-        0.000000379397653,
-        0.000000289043906,
-        0.000000215541606,
-        0.000000156335587,
-        0.000000205043166,
-        0.000000000199668,
-    };
-}
@@ -1,155 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_256_32_len = 143;
-    const float fir_256_32_taps[] = {
-        0.000002024710441,
-        0.000005071986063,
-        0.000005649621619,
-        0.000009996317351,
-        0.000013960233561,
-        0.000020203028684,
-        0.000027743453140,
-        0.000037649365146,
-        0.000049946026699,
-        0.000065301488097,
-        0.000084113029863,
-        0.000107006458486,
-        0.000134566059018,
-        0.000167482006932,
-        0.000206469601804,
-        0.000252311382077,
-        0.000305831073218,
-        0.000367903193892,
-        0.000439441775093,
-        0.000521398892491,
-        0.000614756278678,
-        0.000720519104213,
-        0.000839706996025,
-        0.000973345013002,
-        0.001122453164999,
-        0.001288035337090,
-        0.001471067271555,
-        0.001672483946636,
-        0.001893166344323,
-        0.002133927814945,
-        0.002395500153619,
-        0.002678519576086,
-        0.002983512762124,
-        0.003310883161302,
-        0.003660897754233,
-        0.004033674471928,
-        0.004429170475222,
-        0.004847171495793,
-        0.005287282435142,
-        0.005748919410995,
-        0.006231303428249,
-        0.006733455837854,
-        0.007254195729720,
-        0.007792139384731,
-        0.008345701888126,
-        0.008913100980819,
-        0.009492363197372,
-        0.010081332310191,
-        0.010677680068163,
-        0.011278919186999,
-        0.011882418516063,
-        0.012485420274634,
-        0.013085059219684,
-        0.013678383576860,
-        0.014262377537964,
-        0.014833985102374,
-        0.015390135015749,
-        0.015927766539308,
-        0.016443855765594,
-        0.016935442183430,
-        0.017399655185551,
-        0.017833740207285,
-        0.018235084184538,
-        0.018601240022499,
-        0.018929949775865,
-        0.019219166253362,
-        0.019467072776985,
-        0.019672100847465,
-        0.019832945492079,
-        0.019948578099591,
-        0.020018256578123,
-        0.020041532705549,
-        0.020018256578123,
-        0.019948578099591,
-        0.019832945492079,
-        0.019672100847465,
-        0.019467072776985,
-        0.019219166253362,
-        0.018929949775865,
-        0.018601240022499,
-        0.018235084184538,
-        0.017833740207285,
-        0.017399655185551,
-        0.016935442183430,
-        0.016443855765594,
-        0.015927766539308,
-        0.015390135015749,
-        0.014833985102374,
-        0.014262377537964,
-        0.013678383576860,
-        0.013085059219684,
-        0.012485420274634,
-        0.011882418516063,
-        0.011278919186999,
-        0.010677680068163,
-        0.010081332310191,
-        0.009492363197372,
-        0.008913100980819,
-        0.008345701888126,
-        0.007792139384731,
-        0.007254195729720,
-        0.006733455837854,
-        0.006231303428249,
-        0.005748919410995,
-        0.005287282435142,
-        0.004847171495793,
-        0.004429170475222,
-        0.004033674471928,
-        0.003660897754233,
-        0.003310883161302,
-        0.002983512762124,
-        0.002678519576086,
-        0.002395500153619,
-        0.002133927814945,
-        0.001893166344323,
-        0.001672483946636,
-        0.001471067271555,
-        0.001288035337090,
-        0.001122453164999,
-        0.000973345013002,
-        0.000839706996025,
-        0.000720519104213,
-        0.000614756278678,
-        0.000521398892491,
-        0.000439441775093,
-        0.000367903193892,
-        0.000305831073218,
-        0.000252311382077,
-        0.000206469601804,
-        0.000167482006932,
-        0.000134566059018,
-        0.000107006458486,
-        0.000084113029863,
-        0.000065301488097,
-        0.000049946026699,
-        0.000037649365146,
-        0.000027743453140,
-        0.000020203028684,
-        0.000013960233561,
-        0.000009996317351,
-        0.000005649621619,
-        0.000005071986063,
-        0.000002024710441,
-    };
-}
@@ -1,81 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_2_2_len = 69;
-    const float fir_2_2_taps[] = {
-        0.000400633624864,
-        0.002075598505552,
-        0.004856364956715,
-        0.005979016698235,
-        0.002622922607902,
-        -0.002718259152577,
-        -0.003381533671376,
-        0.001638638539759,
-        0.004081814705993,
-        -0.000984029228217,
-        -0.005120988470135,
-        0.000177440907285,
-        0.006425852662023,
-        0.001009351602305,
-        -0.007912827910006,
-        -0.002713700675199,
-        0.009509311257450,
-        0.005070635723474,
-        -0.011154020477109,
-        -0.008246059919867,
-        0.012785716787299,
-        0.012487906837156,
-        -0.014347452386709,
-        -0.018205770848481,
-        0.015781858576801,
-        0.026172374716730,
-        -0.017037643409603,
-        -0.038051489304887,
-        0.018067070624730,
-        0.058212412671604,
-        -0.018832304184135,
-        -0.102772486604899,
-        0.019303165035556,
-        0.317189488733641,
-        0.480537520090363,
-        0.317189488733641,
-        0.019303165035556,
-        -0.102772486604899,
-        -0.018832304184135,
-        0.058212412671604,
-        0.018067070624730,
-        -0.038051489304887,
-        -0.017037643409603,
-        0.026172374716730,
-        0.015781858576801,
-        -0.018205770848481,
-        -0.014347452386709,
-        0.012487906837156,
-        0.012785716787299,
-        -0.008246059919867,
-        -0.011154020477109,
-        0.005070635723474,
-        0.009509311257450,
-        -0.002713700675199,
-        -0.007912827910006,
-        0.001009351602305,
-        0.006425852662023,
-        0.000177440907285,
-        -0.005120988470135,
-        -0.000984029228217,
-        0.004081814705993,
-        0.001638638539759,
-        -0.003381533671376,
-        -0.002718259152577,
-        0.002622922607902,
-        0.005979016698235,
-        0.004856364956715,
-        0.002075598505552,
-        0.000400633624864,
-    };
-}
@@ -1,56 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_32_8_len = 44;
-    const float fir_32_8_taps[] = {
-        -0.000029744589241,
-        -0.000102805435515,
-        -0.000256933218578,
-        -0.000524425617107,
-        -0.000923167111410,
-        -0.001434928315096,
-        -0.001981567015438,
-        -0.002404088713278,
-        -0.002451791426948,
-        -0.001788676228348,
-        -0.000022184036340,
-        0.003244839156945,
-        0.008343584867029,
-        0.015460483392566,
-        0.024564907542072,
-        0.035359785525755,
-        0.047269560715908,
-        0.059474265224980,
-        0.070989991387120,
-        0.080786468196769,
-        0.087923948445323,
-        0.091686274752633,
-        0.091686274752633,
-        0.087923948445323,
-        0.080786468196769,
-        0.070989991387120,
-        0.059474265224980,
-        0.047269560715908,
-        0.035359785525755,
-        0.024564907542072,
-        0.015460483392566,
-        0.008343584867029,
-        0.003244839156945,
-        -0.000022184036340,
-        -0.001788676228348,
-        -0.002451791426948,
-        -0.002404088713278,
-        -0.001981567015438,
-        -0.001434928315096,
-        -0.000923167111410,
-        -0.000524425617107,
-        -0.000256933218578,
-        -0.000102805435515,
-        -0.000029744589241,
-    };
-}
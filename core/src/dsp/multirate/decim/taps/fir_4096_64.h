@@ -1,412 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_4096_64_len = 400;
-    const float fir_4096_64_taps[] = {
-        -0.000000046390182,
-        -0.000000032671747,
-        -0.000000044019252,
-        -0.000000057847980,
-        -0.000000074525736,
-        -0.000000094444277,
-        -0.000000118038962,
-        -0.000000145771056,
-        -0.000000178146920,
-        -0.000000215699912,
-        -0.000000259008968,
-        -0.000000308679966,
-        -0.000000365363532,
-        -0.000000429735743,
-        -0.000000502514971,
-        -0.000000584441775,
-        -0.000000676294593,
-        -0.000000778868675,
-        -0.000000892990408,
-        -0.000001019495135,
-        -0.000001159239908,
-        -0.000001313080019,
-        -0.000001481879981,
-        -0.000001666488590,
-        -0.000001867747936,
-        -0.000002086466837,
-        -0.000002323427660,
-        -0.000002579357987,
-        -0.000002854935059,
-        -0.000003150755519,
-        -0.000003467337309,
-        -0.000003805087370,
-        -0.000004164300851,
-        -0.000004545126650,
-        -0.000004947563816,
-        -0.000005371424879,
-        -0.000005816329343,
-        -0.000006281664776,
-        -0.000006766577359,
-        -0.000007269930729,
-        -0.000007790293600,
-        -0.000008325896421,
-        -0.000008874616111,
-        -0.000009433930650,
-        -0.000010000901045,
-        -0.000010572124028,
-        -0.000011143711423,
-        -0.000011711241185,
-        -0.000012269734415,
-        -0.000012813605044,
-        -0.000013336634806,
-        -0.000013831921934,
-        -0.000014291854483,
-        -0.000014708058478,
-        -0.000015071370042,
-        -0.000015371783506,
-        -0.000015598422879,
-        -0.000015739490502,
-        -0.000015782238450,
-        -0.000015712918389,
-        -0.000015516753573,
-        -0.000015177890614,
-        -0.000014679372808,
-        -0.000014003094579,
-        -0.000013129776918,
-        -0.000012038925327,
-        -0.000010708808188,
-        -0.000009116419073,
-        -0.000007237458911,
-        -0.000005046303536,
-        -0.000002515990559,
-        0.000000381806950,
-        0.000003676787983,
-        0.000007400042869,
-        0.000011584054294,
-        0.000016262708632,
-        0.000021471289584,
-        0.000027246480702,
-        0.000033626350795,
-        0.000040650346831,
-        0.000048359270314,
-        0.000056795259795,
-        0.000066001757509,
-        0.000076023480814,
-        0.000086906378438,
-        0.000098697590282,
-        0.000111445392736,
-        0.000125199146376,
-        0.000140009229952,
-        0.000155926975644,
-        0.000173004591440,
-        0.000191295083774,
-        0.000210852168180,
-        0.000231730179287,
-        0.000253983969797,
-        0.000277668807996,
-        0.000302840265281,
-        0.000329554101525,
-        0.000357866141575,
-        0.000387832149003,
-        0.000419507692185,
-        0.000452948007177,
-        0.000488207854178,
-        0.000525341370472,
-        0.000564401918290,
-        0.000605441928944,
-        0.000648512743304,
-        0.000693664448459,
-        0.000740945712207,
-        0.000790403613766,
-        0.000842083473864,
-        0.000896028681201,
-        0.000952280519889,
-        0.001010877993535,
-        0.001071857651943,
-        0.001135253414817,
-        0.001201096399779,
-        0.001269414747828,
-        0.001340233454817,
-        0.001413574200910,
-        0.001489455187766,
-        0.001567890974290,
-        0.001648892321822,
-        0.001732466038541,
-        0.001818614834973,
-        0.001907337179413,
-        0.001998627166072,
-        0.002092474383846,
-        0.002188863799386,
-        0.002287775641494,
-        0.002389185301308,
-        0.002493063234514,
-        0.002599374880741,
-        0.002708080585641,
-        0.002819135541432,
-        0.002932489730741,
-        0.003048087890061,
-        0.003165869477045,
-        0.003285768658416,
-        0.003407714302186,
-        0.003531629991321,
-        0.003657434042076,
-        0.003785039544443,
-        0.003914354407524,
-        0.004045281427483,
-        0.004177718360558,
-        0.004311558018921,
-        0.004446688371607,
-        0.004582992668347,
-        0.004720349568330,
-        0.004858633291726,
-        0.004997713775860,
-        0.005137456853766,
-        0.005277724436980,
-        0.005418374720123,
-        0.005559262389150,
-        0.005700238850592,
-        0.005841152463751,
-        0.005981848792879,
-        0.006122170861453,
-        0.006261959425236,
-        0.006401053246440,
-        0.006539289385285,
-        0.006676503491561,
-        0.006812530112001,
-        0.006947202996460,
-        0.007080355418172,
-        0.007211820491505,
-        0.007341431501933,
-        0.007469022232125,
-        0.007594427298261,
-        0.007717482481038,
-        0.007838025064813,
-        0.007955894169977,
-        0.008070931091297,
-        0.008182979628023,
-        0.008291886417752,
-        0.008397501260587,
-        0.008499677444830,
-        0.008598272061538,
-        0.008693146318384,
-        0.008784165841015,
-        0.008871200971516,
-        0.008954127053079,
-        0.009032824709643,
-        0.009107180110554,
-        0.009177085228136,
-        0.009242438079217,
-        0.009303142957628,
-        0.009359110649733,
-        0.009410258639107,
-        0.009456511293501,
-        0.009497800039280,
-        0.009534063517579,
-        0.009565247726420,
-        0.009591306144175,
-        0.009612199837674,
-        0.009627897551475,
-        0.009638375780671,
-        0.009643618824881,
-        0.009643618824881,
-        0.009638375780671,
-        0.009627897551475,
-        0.009612199837674,
-        0.009591306144175,
-        0.009565247726420,
-        0.009534063517579,
-        0.009497800039280,
-        0.009456511293501,
-        0.009410258639107,
-        0.009359110649733,
-        0.009303142957628,
-        0.009242438079217,
-        0.009177085228136,
-        0.009107180110554,
-        0.009032824709643,
-        0.008954127053079,
-        0.008871200971516,
-        0.008784165841015,
-        0.008693146318384,
-        0.008598272061538,
-        0.008499677444830,
-        0.008397501260587,
-        0.008291886417752,
-        0.008182979628023,
-        0.008070931091297,
-        0.007955894169977,
-        0.007838025064813,
-        0.007717482481038,
-        0.007594427298261,
-        0.007469022232125,
-        0.007341431501933,
-        0.007211820491505,
-        0.007080355418172,
-        0.006947202996460,
-        0.006812530112001,
-        0.006676503491561,
-        0.006539289385285,
-        0.006401053246440,
-        0.006261959425236,
-        0.006122170861453,
-        0.005981848792879,
-        0.005841152463751,
-        0.005700238850592,
-        0.005559262389150,
-        0.005418374720123,
-        0.005277724436980,
-        0.005137456853766,
-        0.004997713775860,
-        0.004858633291726,
-        0.004720349568330,
-        0.004582992668347,
-        0.004446688371607,
-        0.004311558018921,
-        0.004177718360558,
-        0.004045281427483,
-        0.003914354407524,
-        0.003785039544443,
-        0.003657434042076,
-        0.003531629991321,
-        0.003407714302186,
-        0.003285768658416,
-        0.003165869477045,
-        0.003048087890061,
-        0.002932489730741,
-        0.002819135541432,
-        0.002708080585641,
-        0.002599374880741,
-        0.002493063234514,
-        0.002389185301308,
-        0.002287775641494,
-        0.002188863799386,
-        0.002092474383846,
-        0.001998627166072,
-        0.001907337179413,
-        0.001818614834973,
-        0.001732466038541,
-        0.001648892321822,
-        0.001567890974290,
-        0.001489455187766,
-        0.001413574200910,
-        0.001340233454817,
-        0.001269414747828,
-        0.001201096399779,
-        0.001135253414817,
-        0.001071857651943,
-        0.001010877993535,
-        0.000952280519889,
-        0.000896028681201,
-        0.000842083473864,
-        0.000790403613766,
-        0.000740945712207,
-        0.000693664448459,
-        0.000648512743304,
-        0.000605441928944,
-        0.000564401918290,
-        0.000525341370472,
-        0.000488207854178,
-        0.000452948007177,
-        0.000419507692185,
-        0.000387832149003,
-        0.000357866141575,
-        0.000329554101525,
-        0.000302840265281,
-        0.000277668807996,
-        0.000253983969797,
-        0.000231730179287,
-        0.000210852168180,
-        0.000191295083774,
-        0.000173004591440,
-        0.000155926975644,
-        0.000140009229952,
-        0.000125199146376,
-        0.000111445392736,
-        0.000098697590282,
-        0.000086906378438,
-        0.000076023480814,
-        0.000066001757509,
-        0.000056795259795,
-        0.000048359270314,
-        0.000040650346831,
-        0.000033626350795,
-        0.000027246480702,
-        0.000021471289584,
-        0.000016262708632,
-        0.000011584054294,
-        0.000007400042869,
-        0.000003676787983,
-        0.000000381806950,
-        -0.000002515990559,
-        -0.000005046303536,
-        -0.000007237458911,
-        -0.000009116419073,
-        -0.000010708808188,
-        -0.000012038925327,
-        -0.000013129776918,
-        -0.000014003094579,
-        -0.000014679372808,
-        -0.000015177890614,
-        -0.000015516753573,
-        -0.000015712918389,
-        -0.000015782238450,
-        -0.000015739490502,
-        -0.000015598422879,
-        -0.000015371783506,
-        -0.000015071370042,
-        -0.000014708058478,
-        -0.000014291854483,
-        -0.000013831921934,
-        -0.000013336634806,
-        -0.000012813605044,
-        -0.000012269734415,
-        -0.000011711241185,
-        -0.000011143711423,
-        -0.000010572124028,
-        -0.000010000901045,
-        -0.000009433930650,
-        -0.000008874616111,
-        -0.000008325896421,
-        -0.000007790293600,
-        -0.000007269930729,
-        -0.000006766577359,
-        -0.000006281664776,
-        -0.000005816329343,
-        -0.000005371424879,
-        -0.000004947563816,
-        -0.000004545126650,
-        -0.000004164300851,
-        -0.000003805087370,
-        -0.000003467337309,
-        -0.000003150755519,
-        -0.000002854935059,
-        -0.000002579357987,
-        -0.000002323427660,
-        -0.000002086466837,
-        -0.000001867747936,
-        -0.000001666488590,
-        -0.000001481879981,
-        -0.000001313080019,
-        -0.000001159239908,
-        -0.000001019495135,
-        -0.000000892990408,
-        -0.000000778868675,
-        -0.000000676294593,
-        -0.000000584441775,
-        -0.000000502514971,
-        -0.000000429735743,
-        -0.000000365363532,
-        -0.000000308679966,
-        -0.000000259008968,
-        -0.000000215699912,
-        -0.000000178146920,
-        -0.000000145771056,
-        -0.000000118038962,
-        -0.000000094444277,
-        -0.000000074525736,
-        -0.000000057847980,
-        -0.000000044019252,
-        -0.000000032671747,
-        -0.000000046390182,
-    };
-}
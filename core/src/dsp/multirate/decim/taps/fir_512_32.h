@@ -1,141 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_512_32_len = 129;
-    const float fir_512_32_taps[] = {
-        0.000008540968797,
-        0.000009922400188,
-        0.000015550948353,
-        0.000023167181508,
-        0.000033231811476,
-        0.000046270708161,
-        0.000062878000273,
-        0.000083718456393,
-        0.000109529013922,
-        0.000141119329083,
-        0.000179371225499,
-        0.000225236929029,
-        0.000279735987160,
-        0.000343950788528,
-        0.000419020613557,
-        0.000506134170029,
-        0.000606520589550,
-        0.000721438886986,
-        0.000852165912394,
-        0.000999982852844,
-        0.001166160372943,
-        0.001351942511872,
-        0.001558529485270,
-        0.001787059568999,
-        0.002038590271450,
-        0.002314079024704,
-        0.002614363649958,
-        0.002940142872027,
-        0.003291957174154,
-        0.003670170297288,
-        0.004074951693870,
-        0.004506260250540,
-        0.004963829590056,
-        0.005447155254368,
-        0.005955484057066,
-        0.006487805874260,
-        0.007042848116484,
-        0.007619073095444,
-        0.008214678463585,
-        0.008827600864209,
-        0.009455522888034,
-        0.010095883384323,
-        0.010745891124847,
-        0.011402541770574,
-        0.012062638037206,
-        0.012722812904219,
-        0.013379555663224,
-        0.014029240550834,
-        0.014668157666599,
-        0.015292545833545,
-        0.015898627022289,
-        0.016482641925719,
-        0.017040886246767,
-        0.017569747239682,
-        0.018065740033662,
-        0.018525543262431,
-        0.018946033522759,
-        0.019324318198100,
-        0.019657766196845,
-        0.019944036181861,
-        0.020181101897746,
-        0.020367274240763,
-        0.020501219760524,
-        0.020581975330434,
-        0.020608958779118,
-        0.020581975330434,
-        0.020501219760524,
-        0.020367274240763,
-        0.020181101897746,
-        0.019944036181861,
-        0.019657766196845,
-        0.019324318198100,
-        0.018946033522759,
-        0.018525543262431,
-        0.018065740033662,
-        0.017569747239682,
-        0.017040886246767,
-        0.016482641925719,
-        0.015898627022289,
-        0.015292545833545,
-        0.014668157666599,
-        0.014029240550834,
-        0.013379555663224,
-        0.012722812904219,
-        0.012062638037206,
-        0.011402541770574,
-        0.010745891124847,
-        0.010095883384323,
-        0.009455522888034,
-        0.008827600864209,
-        0.008214678463585,
-        0.007619073095444,
-        0.007042848116484,
-        0.006487805874260,
-        0.005955484057066,
-        0.005447155254368,
-        0.004963829590056,
-        0.004506260250540,
-        0.004074951693870,
-        0.003670170297288,
-        0.003291957174154,
-        0.002940142872027,
-        0.002614363649958,
-        0.002314079024704,
-        0.002038590271450,
-        0.001787059568999,
-        0.001558529485270,
-        0.001351942511872,
-        0.001166160372943,
-        0.000999982852844,
-        0.000852165912394,
-        0.000721438886986,
-        0.000606520589550,
-        0.000506134170029,
-        0.000419020613557,
-        0.000343950788528,
-        0.000279735987160,
-        0.000225236929029,
-        0.000179371225499,
-        0.000141119329083,
-        0.000109529013922,
-        0.000083718456393,
-        0.000062878000273,
-        0.000046270708161,
-        0.000033231811476,
-        0.000023167181508,
-        0.000015550948353,
-        0.000009922400188,
-        0.000008540968797,
-    };
-}
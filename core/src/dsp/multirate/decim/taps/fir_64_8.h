@@ -1,48 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_64_8_len = 36;
-    const float fir_64_8_taps[] = {
-        0.000015230923996,
-        0.000082077920191,
-        0.000262521513750,
-        0.000673128659394,
-        0.001475675202716,
-        0.002887947811052,
-        0.005159198622906,
-        0.008543963462691,
-        0.013252097427442,
-        0.019396810069284,
-        0.026940321432500,
-        0.035656237803203,
-        0.045115851141008,
-        0.054709465624648,
-        0.063702603363867,
-        0.071322539438903,
-        0.076861237718122,
-        0.079777267801515,
-        0.079777267801515,
-        0.076861237718122,
-        0.071322539438903,
-        0.063702603363867,
-        0.054709465624648,
-        0.045115851141008,
-        0.035656237803203,
-        0.026940321432500,
-        0.019396810069284,
-        0.013252097427442,
-        0.008543963462691,
-        0.005159198622906,
-        0.002887947811052,
-        0.001475675202716,
-        0.000673128659394,
-        0.000262521513750,
-        0.000082077920191,
-        0.000015230923996,
-    };
-}
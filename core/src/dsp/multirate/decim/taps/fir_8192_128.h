@@ -1,738 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_8192_128_len = 726;
-    const float fir_8192_128_taps[] = {
-        -0.000000038736989,
-        -0.000000002900423,
-        -0.000000002802657,
-        -0.000000002550081,
-        -0.000000002127632,
-        -0.000000001515543,
-        -0.000000000693742,
-        0.000000000362461,
-        0.000000001678381,
-        0.000000003283860,
-        0.000000005209816,
-        0.000000007491597,
-        0.000000010166182,
-        0.000000013274887,
-        0.000000016861297,
-        0.000000020973250,
-        0.000000025661549,
-        0.000000030981198,
-        0.000000036990894,
-        0.000000043753522,
-        0.000000051336412,
-        0.000000059811125,
-        0.000000069254410,
-        0.000000079747366,
-        0.000000091377013,
-        0.000000104234914,
-        0.000000118419261,
-        0.000000134033072,
-        0.000000151186668,
-        0.000000169995579,
-        0.000000190583271,
-        0.000000213078893,
-        0.000000237620132,
-        0.000000264350922,
-        0.000000293424307,
-        0.000000325000228,
-        0.000000359248280,
-        0.000000396345681,
-        0.000000436479839,
-        0.000000479846570,
-        0.000000526652414,
-        0.000000577113153,
-        0.000000631455840,
-        0.000000689917640,
-        0.000000752747558,
-        0.000000820205604,
-        0.000000892564232,
-        0.000000970107802,
-        0.000001053133766,
-        0.000001141952384,
-        0.000001236887707,
-        0.000001338277486,
-        0.000001446474015,
-        0.000001561844168,
-        0.000001684770169,
-        0.000001815649686,
-        0.000001954896596,
-        0.000002102941065,
-        0.000002260230379,
-        0.000002427228940,
-        0.000002604419221,
-        0.000002792301631,
-        0.000002991395630,
-        0.000003202239426,
-        0.000003425391279,
-        0.000003661429009,
-        0.000003910951502,
-        0.000004174578014,
-        0.000004452949882,
-        0.000004746729636,
-        0.000005056602883,
-        0.000005383277263,
-        0.000005727484467,
-        0.000006089979070,
-        0.000006471540645,
-        0.000006872972514,
-        0.000007295103905,
-        0.000007738788674,
-        0.000008204907452,
-        0.000008694366379,
-        0.000009208099195,
-        0.000009747066037,
-        0.000010312255416,
-        0.000010904683121,
-        0.000011525394046,
-        0.000012175461221,
-        0.000012855987475,
-        0.000013568104599,
-        0.000014312974832,
-        0.000015091790163,
-        0.000015905773637,
-        0.000016756178784,
-        0.000017644290759,
-        0.000018571425876,
-        0.000019538932599,
-        0.000020548191156,
-        0.000021600614406,
-        0.000022697647498,
-        0.000023840768647,
-        0.000025031488798,
-        0.000026271352347,
-        0.000027561936767,
-        0.000028904853308,
-        0.000030301746554,
-        0.000031754295124,
-        0.000033264211132,
-        0.000034833240906,
-        0.000036463164339,
-        0.000038155795629,
-        0.000039912982509,
-        0.000041736607015,
-        0.000043628584589,
-        0.000045590864869,
-        0.000047625430672,
-        0.000049734298789,
-        0.000051919518862,
-        0.000054183174163,
-        0.000056527380385,
-        0.000058954286377,
-        0.000061466072873,
-        0.000064064953157,
-        0.000066753171753,
-        0.000069533004984,
-        0.000072406759655,
-        0.000075376773486,
-        0.000078445413795,
-        0.000081615077781,
-        0.000084888191239,
-        0.000088267208670,
-        0.000091754612028,
-        0.000095352910659,
-        0.000099064640077,
-        0.000102892361735,
-        0.000106838661821,
-        0.000110906150870,
-        0.000115097462565,
-        0.000119415253203,
-        0.000123862200490,
-        0.000128441002875,
-        0.000133154378310,
-        0.000138005063487,
-        0.000142995812533,
-        0.000148129396174,
-        0.000153408600336,
-        0.000158836225271,
-        0.000164415084034,
-        0.000170148001590,
-        0.000176037813151,
-        0.000182087363287,
-        0.000188299504104,
-        0.000194677094367,
-        0.000201222997522,
-        0.000207940080827,
-        0.000214831213225,
-        0.000221899264481,
-        0.000229147102908,
-        0.000236577594510,
-        0.000244193600571,
-        0.000251997976791,
-        0.000259993570757,
-        0.000268183221059,
-        0.000276569754666,
-        0.000285155985994,
-        0.000293944714221,
-        0.000302938722286,
-        0.000312140774168,
-        0.000321553613799,
-        0.000331179962326,
-        0.000341022516922,
-        0.000351083948063,
-        0.000361366898216,
-        0.000371873979149,
-        0.000382607770491,
-        0.000393570817086,
-        0.000404765627430,
-        0.000416194671069,
-        0.000427860376920,
-        0.000439765130714,
-        0.000451911273216,
-        0.000464301097709,
-        0.000476936848125,
-        0.000489820716559,
-        0.000502954841349,
-        0.000516341304591,
-        0.000529982130195,
-        0.000543879281395,
-        0.000558034658807,
-        0.000572450097909,
-        0.000587127367134,
-        0.000602068165314,
-        0.000617274119823,
-        0.000632746783974,
-        0.000648487635243,
-        0.000664498072604,
-        0.000680779414857,
-        0.000697332897898,
-        0.000714159673158,
-        0.000731260804822,
-        0.000748637268384,
-        0.000766289947817,
-        0.000784219634251,
-        0.000802427023116,
-        0.000820912712927,
-        0.000839677202426,
-        0.000858720889471,
-        0.000878044068197,
-        0.000897646927996,
-        0.000917529550724,
-        0.000937691909762,
-        0.000958133867299,
-        0.000978855173459,
-        0.000999855463679,
-        0.001021134257902,
-        0.001042690958069,
-        0.001064524847376,
-        0.001086635087889,
-        0.001109020719868,
-        0.001131680659525,
-        0.001154613698409,
-        0.001177818501315,
-        0.001201293605747,
-        0.001225037419975,
-        0.001249048222589,
-        0.001273324160700,
-        0.001297863249606,
-        0.001322663371131,
-        0.001347722273419,
-        0.001373037569408,
-        0.001398606736769,
-        0.001424427116503,
-        0.001450495913054,
-        0.001476810193013,
-        0.001503366885426,
-        0.001530162780600,
-        0.001557194530614,
-        0.001584458648234,
-        0.001611951507632,
-        0.001639669343409,
-        0.001667608251533,
-        0.001695764188468,
-        0.001724132972335,
-        0.001752710282160,
-        0.001781491659250,
-        0.001810472506568,
-        0.001839648090323,
-        0.001869013539487,
-        0.001898563847581,
-        0.001928293872358,
-        0.001958198337767,
-        0.001988271833820,
-        0.002018508818723,
-        0.002048903618943,
-        0.002079450431484,
-        0.002110143324177,
-        0.002140976238089,
-        0.002171942988045,
-        0.002203037265157,
-        0.002234252637585,
-        0.002265582553187,
-        0.002297020340518,
-        0.002328559211596,
-        0.002360192263134,
-        0.002391912479431,
-        0.002423712733825,
-        0.002455585791711,
-        0.002487524312210,
-        0.002519520851317,
-        0.002551567863769,
-        0.002583657706338,
-        0.002615782639873,
-        0.002647934832758,
-        0.002680106363099,
-        0.002712289222360,
-        0.002744475317679,
-        0.002776656475687,
-        0.002808824444935,
-        0.002840970899902,
-        0.002873087443517,
-        0.002905165611358,
-        0.002937196874253,
-        0.002969172642675,
-        0.003001084269403,
-        0.003032923054110,
-        0.003064680246083,
-        0.003096347048983,
-        0.003127914623627,
-        0.003159374092903,
-        0.003190716544618,
-        0.003221933036540,
-        0.003253014599320,
-        0.003283952241645,
-        0.003314736953226,
-        0.003345359710043,
-        0.003375811477414,
-        0.003406083215285,
-        0.003436165881409,
-        0.003466050436636,
-        0.003495727848217,
-        0.003525189095072,
-        0.003554425171206,
-        0.003583427090950,
-        0.003612185892482,
-        0.003640692643008,
-        0.003668938442406,
-        0.003696914428318,
-        0.003724611779908,
-        0.003752021722856,
-        0.003779135533213,
-        0.003805944542296,
-        0.003832440140619,
-        0.003858613782678,
-        0.003884456990948,
-        0.003909961360553,
-        0.003935118563301,
-        0.003959920352242,
-        0.003984358565720,
-        0.004008425131820,
-        0.004032112072405,
-        0.004055411507458,
-        0.004078315659082,
-        0.004100816855733,
-        0.004122907536163,
-        0.004144580253543,
-        0.004165827679324,
-        0.004186642607254,
-        0.004207017957131,
-        0.004226946778713,
-        0.004246422255352,
-        0.004265437707780,
-        0.004283986597615,
-        0.004302062531015,
-        0.004319659262048,
-        0.004336770696196,
-        0.004353390893585,
-        0.004369514072328,
-        0.004385134611605,
-        0.004400247054833,
-        0.004414846112595,
-        0.004428926665616,
-        0.004442483767539,
-        0.004455512647703,
-        0.004468008713752,
-        0.004479967554203,
-        0.004491384940889,
-        0.004502256831302,
-        0.004512579370872,
-        0.004522348895071,
-        0.004531561931516,
-        0.004540215201843,
-        0.004548305623618,
-        0.004555830311974,
-        0.004562786581324,
-        0.004569171946769,
-        0.004574984125591,
-        0.004580221038437,
-        0.004584880810586,
-        0.004588961772907,
-        0.004592462462888,
-        0.004595381625379,
-        0.004597718213369,
-        0.004599471388516,
-        0.004600640521669,
-        0.004601225193182,
-        0.004601225193182,
-        0.004600640521669,
-        0.004599471388516,
-        0.004597718213369,
-        0.004595381625379,
-        0.004592462462888,
-        0.004588961772907,
-        0.004584880810586,
-        0.004580221038437,
-        0.004574984125591,
-        0.004569171946769,
-        0.004562786581324,
-        0.004555830311974,
-        0.004548305623618,
-        0.004540215201843,
-        0.004531561931516,
-        0.004522348895071,
-        0.004512579370872,
-        0.004502256831302,
-        0.004491384940889,
-        0.004479967554203,
-        0.004468008713752,
-        0.004455512647703,
-        0.004442483767539,
-        0.004428926665616,
-        0.004414846112595,
-        0.004400247054833,
-        0.004385134611605,
-        0.004369514072328,
-        0.004353390893585,
-        0.004336770696196,
-        0.004319659262048,
-        0.004302062531015,
-        0.004283986597615,
-        0.004265437707780,
-        0.004246422255352,
-        0.004226946778713,
-        0.004207017957131,
-        0.004186642607254,
-        0.004165827679324,
-        0.004144580253543,
-        0.004122907536163,
-        0.004100816855733,
-        0.004078315659082,
-        0.004055411507458,
-        0.004032112072405,
-        0.004008425131820,
-        0.003984358565720,
-        0.003959920352242,
-        0.003935118563301,
-        0.003909961360553,
-        0.003884456990948,
-        0.003858613782678,
-        0.003832440140619,
-        0.003805944542296,
-        0.003779135533213,
-        0.003752021722856,
-        0.003724611779908,
-        0.003696914428318,
-        0.003668938442406,
-        0.003640692643008,
-        0.003612185892482,
-        0.003583427090950,
-        0.003554425171206,
-        0.003525189095072,
-        0.003495727848217,
-        0.003466050436636,
-        0.003436165881409,
-        0.003406083215285,
-        0.003375811477414,
-        0.003345359710043,
-        0.003314736953226,
-        0.003283952241645,
-        0.003253014599320,
-        0.003221933036540,
-        0.003190716544618,
-        0.003159374092903,
-        0.003127914623627,
-        0.003096347048983,
-        0.003064680246083,
-        0.003032923054110,
-        0.003001084269403,
-        0.002969172642675,
-        0.002937196874253,
-        0.002905165611358,
-        0.002873087443517,
-        0.002840970899902,
-        0.002808824444935,
-        0.002776656475687,
-        0.002744475317679,
-        0.002712289222360,
-        0.002680106363099,
-        0.002647934832758,
-        0.002615782639873,
-        0.002583657706338,
-        0.002551567863769,
-        0.002519520851317,
-        0.002487524312210,
-        0.002455585791711,
-        0.002423712733825,
-        0.002391912479431,
-        0.002360192263134,
-        0.002328559211596,
-        0.002297020340518,
-        0.002265582553187,
-        0.002234252637585,
-        0.002203037265157,
-        0.002171942988045,
-        0.002140976238089,
-        0.002110143324177,
-        0.002079450431484,
-        0.002048903618943,
-        0.002018508818723,
-        0.001988271833820,
-        0.001958198337767,
-        0.001928293872358,
-        0.001898563847581,
-        0.001869013539487,
-        0.001839648090323,
-        0.001810472506568,
-        0.001781491659250,
-        0.001752710282160,
-        0.001724132972335,
-        0.001695764188468,
-        0.001667608251533,
-        0.001639669343409,
-        0.001611951507632,
-        0.001584458648234,
-        0.001557194530614,
-        0.001530162780600,
-        0.001503366885426,
-        0.001476810193013,
-        0.001450495913054,
-        0.001424427116503,
-        0.001398606736769,
-        0.001373037569408,
-        0.001347722273419,
-        0.001322663371131,
-        0.001297863249606,
-        0.001273324160700,
-        0.001249048222589,
-        0.001225037419975,
-        0.001201293605747,
-        0.001177818501315,
-        0.001154613698409,
-        0.001131680659525,
-        0.001109020719868,
-        0.001086635087889,
-        0.001064524847376,
-        0.001042690958069,
-        0.001021134257902,
-        0.000999855463679,
-        0.000978855173459,
-        0.000958133867299,
-        0.000937691909762,
-        0.000917529550724,
-        0.000897646927996,
-        0.000878044068197,
-        0.000858720889471,
-        0.000839677202426,
-        0.000820912712927,
-        0.000802427023116,
-        0.000784219634251,
-        0.000766289947817,
-        0.000748637268384,
-        0.000731260804822,
-        0.000714159673158,
-        0.000697332897898,
-        0.000680779414857,
-        0.000664498072604,
-        0.000648487635243,
-        0.000632746783974,
-        0.000617274119823,
-        0.000602068165314,
-        0.000587127367134,
-        0.000572450097909,
-        0.000558034658807,
-        0.000543879281395,
-        0.000529982130195,
-        0.000516341304591,
-        0.000502954841349,
-        0.000489820716559,
-        0.000476936848125,
-        0.000464301097709,
-        0.000451911273216,
-        0.000439765130714,
-        0.000427860376920,
-        0.000416194671069,
-        0.000404765627430,
-        0.000393570817086,
-        0.000382607770491,
-        0.000371873979149,
-        0.000361366898216,
-        0.000351083948063,
-        0.000341022516922,
-        0.000331179962326,
-        0.000321553613799,
-        0.000312140774168,
-        0.000302938722286,
-        0.000293944714221,
-        0.000285155985994,
-        0.000276569754666,
-        0.000268183221059,
-        0.000259993570757,
-        0.000251997976791,
-        0.000244193600571,
-        0.000236577594510,
-        0.000229147102908,
-        0.000221899264481,
-        0.000214831213225,
-        0.000207940080827,
-        0.000201222997522,
-        0.000194677094367,
-        0.000188299504104,
-        0.000182087363287,
-        0.000176037813151,
-        0.000170148001590,
-        0.000164415084034,
-        0.000158836225271,
-        0.000153408600336,
-        0.000148129396174,
-        0.000142995812533,
-        0.000138005063487,
-        0.000133154378310,
-        0.000128441002875,
-        0.000123862200490,
-        0.000119415253203,
-        0.000115097462565,
-        0.000110906150870,
-        0.000106838661821,
-        0.000102892361735,
-        0.000099064640077,
-        0.000095352910659,
-        0.000091754612028,
-        0.000088267208670,
-        0.000084888191239,
-        0.000081615077781,
-        0.000078445413795,
-        0.000075376773486,
-        0.000072406759655,
-        0.000069533004984,
-        0.000066753171753,
-        0.000064064953157,
-        0.000061466072873,
-        0.000058954286377,
-        0.000056527380385,
-        0.000054183174163,
-        0.000051919518862,
-        0.000049734298789,
-        0.000047625430672,
-        0.000045590864869,
-        0.000043628584589,
-        0.000041736607015,
-        0.000039912982509,
-        0.000038155795629,
-        0.000036463164339,
-        0.000034833240906,
-        0.000033264211132,
-        0.000031754295124,
-        0.000030301746554,
-        0.000028904853308,
-        0.000027561936767,
-        0.000026271352347,
-        0.000025031488798,
-        0.000023840768647,
-        0.000022697647498,
-        0.000021600614406,
-        0.000020548191156,
-        0.000019538932599,
-        0.000018571425876,
-        0.000017644290759,
-        0.000016756178784,
-        0.000015905773637,
-        0.000015091790163,
-        0.000014312974832,
-        0.000013568104599,
-        0.000012855987475,
-        0.000012175461221,
-        0.000011525394046,
-        0.000010904683121,
-        0.000010312255416,
-        0.000009747066037,
-        0.000009208099195,
-        0.000008694366379,
-        0.000008204907452,
-        0.000007738788674,
-        0.000007295103905,
-        0.000006872972514,
-        0.000006471540645,
-        0.000006089979070,
-        0.000005727484467,
-        0.000005383277263,
-        0.000005056602883,
-        0.000004746729636,
-        0.000004452949882,
-        0.000004174578014,
-        0.000003910951502,
-        0.000003661429009,
-        0.000003425391279,
-        0.000003202239426,
-        0.000002991395630,
-        0.000002792301631,
-        0.000002604419221,
-        0.000002427228940,
-        0.000002260230379,
-        0.000002102941065,
-        0.000001954896596,
-        0.000001815649686,
-        0.000001684770169,
-        0.000001561844168,
-        0.000001446474015,
-        0.000001338277486,
-        0.000001236887707,
-        0.000001141952384,
-        0.000001053133766,
-        0.000000970107802,
-        0.000000892564232,
-        0.000000820205604,
-        0.000000752747558,
-        0.000000689917640,
-        0.000000631455840,
-        0.000000577113153,
-        0.000000526652414,
-        0.000000479846570,
-        0.000000436479839,
-        0.000000396345681,
-        0.000000359248280,
-        0.000000325000228,
-        0.000000293424307,
-        0.000000264350922,
-        0.000000237620132,
-        0.000000213078893,
-        0.000000190583271,
-        0.000000169995579,
-        0.000000151186668,
-        0.000000134033072,
-        0.000000118419261,
-        0.000000104234914,
-        0.000000091377013,
-        0.000000079747366,
-        0.000000069254410,
-        0.000000059811125,
-        0.000000051336412,
-        0.000000043753522,
-        0.000000036990894,
-        0.000000030981198,
-        0.000000025661549,
-        0.000000020973250,
-        0.000000016861297,
-        0.000000013274887,
-        0.000000010166182,
-        0.000000007491597,
-        0.000000005209816,
-        0.000000003283860,
-        0.000000001678381,
-        0.000000000362461,
-        -0.000000000693742,
-        -0.000000001515543,
-        -0.000000002127632,
-        -0.000000002550081,
-        -0.000000002802657,
-        -0.000000002900423,
-        -0.000000038736989,
-    };
-}
@@ -1,39 +0,0 @@
-#pragma once
-
-/*
-    This file was auto-generated by the magic optimized FIR script.
-    DO NOT EDIT MANUALLY!!!
-*/
-
-namespace dsp::multirate::decim {
-    const unsigned int fir_8_4_len = 27;
-    const float fir_8_4_taps[] = {
-        -0.000069910742154,
-        -0.000552526802288,
-        -0.002127088129249,
-        -0.005633575976279,
-        -0.011315295341167,
-        -0.017735691906137,
-        -0.021011120930551,
-        -0.015296134618958,
-        0.005014080997102,
-        0.041970748926553,
-        0.091347535728189,
-        0.142430310818233,
-        0.181170927236212,
-        0.195642275183578,
-        0.181170927236212,
-        0.142430310818233,
-        0.091347535728189,
-        0.041970748926553,
-        0.005014080997102,
-        -0.015296134618958,
-        -0.021011120930551,
-        -0.017735691906137,
-        -0.011315295341167,
-        -0.005633575976279,
-        -0.002127088129249,
-        -0.000552526802288,
-        -0.000069910742154,
-    };
-}
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include "../processor.h"
+
+// Largest deviation of the ratio from 1, far more than the drift of any real clock
+#define DRIFT_RESAMPLER_MAX_CORRECTION  0.01
+
+namespace dsp::multirate {
+    // Resampler for ratios very close to one, used to follow the drift between two clocks of the same nominal rate.
+    // The ratio is the number of output samples per input sample and can be changed at any time from any thread, the
+    // change taking effect on the next block. A Catmull-Rom spline is plenty for audio at such ratios, unlike a
+    // polyphase filter it can be moved by arbitrarily small steps.
+    template <class T>
+    class DriftResampler : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        DriftResampler() {}
+
+        DriftResampler(stream<T>* in) { init(in); }
+
+        ~DriftResampler() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(hist);
+        }
+
+        void init(stream<T>* in) {
+            reset();
+            base_type::init(in);
+        }
+
+        // Clamped to DRIFT_RESAMPLER_MAX_CORRECTION around 1
+        void setRatio(double ratio) {
+            _ratio = std::clamp<double>(ratio, 1.0 - DRIFT_RESAMPLER_MAX_CORRECTION, 1.0 + DRIFT_RESAMPLER_MAX_CORRECTION);
+        }
+
+        double getRatio() { return _ratio; }
+
+        void reset() {
+            mu = 0.0;
+            skip = 0;
+            if (hist) { buffer::clear(hist, 3); }
+        }
+
+        int process(int count, const T* in, T* out) {
+            if (count + 3 > histCapacity) { grow(count + 3); }
+
+            // The last three input samples of the previous block are kept in front of this one
+            memcpy(&hist[3], in, count * sizeof(T));
+
+            double step = 1.0 / _ratio;
+            int outCount = 0;
+            int pos = skip;
+            while (pos < count) {
+                out[outCount++] = interpolate(&hist[pos], mu);
+                mu += step;
+                int adv = (int)mu;
+                mu -= (double)adv;
+                pos += adv;
+            }
+
+            // The step is under two samples, so at most one sample of the next block was stepped over
+            skip = pos - count;
+            memmove(hist, &hist[count], 3 * sizeof(T));
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return (int)ceil((double)inputCount * (1.0 + DRIFT_RESAMPLER_MAX_CORRECTION)) + 2; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // The output keeps the nominal rate, the correction only makes up for the drift of the clocks
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        void grow(int size) {
+            T* newHist = buffer::alloc<T>(size);
+            if (hist) {
+                memcpy(newHist, hist, 3 * sizeof(T));
+                buffer::free(hist);
+            }
+            else {
+                buffer::clear(newHist, 3);
+            }
+            hist = newHist;
+            histCapacity = size;
+        }
+
+        // Catmull-Rom spline between the second and third of four consecutive samples
+        inline T interpolate(const T* x, double frac) {
+            float t = frac;
+            T x0 = x[0];
+            T x1 = x[1];
+            T x2 = x[2];
+            T x3 = x[3];
+            T a = (x1 * 3.0f) - (x2 * 3.0f) + x3 - x0;
+            T b = (x0 * 2.0f) - (x1 * 5.0f) + (x2 * 4.0f) - x3;
+            T c = x2 - x0;
+            return x1 + ((((a * t) + b) * t + c) * t) * 0.5f;
+        }
+
+        std::atomic<double> _ratio = 1.0;
+        double mu = 0.0;
+        int skip = 0;
+        T* hist = NULL;
+        int histCapacity = 0;
+    };
+}
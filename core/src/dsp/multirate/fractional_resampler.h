@@ -0,0 +1,210 @@
+#pragma once
+#include "../processor.h"
+#include "../taps/low_pass.h"
+
+// Number of phases of the filter bank, the output is interpolated linearly between the two nearest ones
+#define FRACTIONAL_RESAMPLER_PHASES     64
+
+// Number of float lanes accumulated separately, allows the compiler to vectorize without reordering the sums
+#define FRACTIONAL_RESAMPLER_LANES      8
+
+namespace dsp::multirate {
+    // Resampler for any ratio, including ones that aren't a ratio of integers. The low pass filter is split into a
+    // fixed number of phases, each output being interpolated between the two phases around its position in time, so
+    // that the memory taken doesn't depend on the ratio at all unlike a PolyphaseResampler. The interpolation is
+    // exact at DC and its error rises with frequency, it stays around -80dB at 0.3 times the input samplerate.
+    template <class T>
+    class FractionalResampler : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        // Components per sample when handled as an array of floats
+        static constexpr int COMPONENTS = std::is_same_v<T, float> ? 1 : 2;
+
+        FractionalResampler() {}
+
+        FractionalResampler(stream<T>* in, double inSamplerate, double outSamplerate) { init(in, inSamplerate, outSamplerate); }
+
+        ~FractionalResampler() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(bank);
+            buffer::free(buffer);
+        }
+
+        void init(stream<T>* in, double inSamplerate, double outSamplerate) {
+            _inSamplerate = inSamplerate;
+            _outSamplerate = outSamplerate;
+            generateBank();
+            grow(in ? in->getMaxBlockSize() : 0);
+            clearHistory();
+            base_type::init(in);
+        }
+
+        void setRates(double inSamplerate, double outSamplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _inSamplerate = inSamplerate;
+            _outSamplerate = outSamplerate;
+            generateBank();
+            grow(bufCapacity);
+            clearHistory();
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            clearHistory();
+            base_type::tempStart();
+        }
+
+        // Can be done in place
+        inline int process(int count, const T* in, T* out) {
+            if (count > bufCapacity) { grow(count); }
+            memcpy(&buffer[hist], in, count * sizeof(T));
+
+            const float* x = (const float*)buffer;
+            float* y = (float*)out;
+            int outCount = 0;
+            while (offset < count) {
+                // Phase just before the position of the output, and the distance to it
+                double p = frac * (double)FRACTIONAL_RESAMPLER_PHASES;
+                int phase = (int)p;
+                float mu = (float)(p - (double)phase);
+                const float* ta = &bank[phase * phaseLen];
+                dot(&y[outCount * COMPONENTS], &x[offset * COMPONENTS], ta, &ta[phaseLen], mu);
+                outCount++;
+
+                // Move to the next output
+                frac += step;
+                int adv = (int)frac;
+                frac -= (double)adv;
+                offset += adv;
+            }
+            offset -= count;
+
+            memmove(buffer, &buffer[count], hist * sizeof(T));
+            return outCount;
+        }
+
+        // Output what a silent input gives once the delay line only holds zeros, without computing any of it
+        inline int skip(int count, T* out) {
+            int outCount = 0;
+            while (offset < count) {
+                outCount++;
+                frac += step;
+                int adv = (int)frac;
+                frac -= (double)adv;
+                offset += adv;
+            }
+            offset -= count;
+            memset(out, 0, outCount * sizeof(T));
+            buffer::clear<T>(buffer, hist);
+            return outCount;
+        }
+
+        int maxOutputCount(int inputCount) { return (int)ceil((double)inputCount / step) + 1; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(maxOutputCount(count));
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_outSamplerate / _inSamplerate);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // Dot product of the samples with the taps interpolated between two phases. The phases are padded to a
+        // multiple of the lanes, the even lane count keeping the components in their lanes
+        inline void dot(float* y, const float* x, const float* ta, const float* tb, float mu) {
+            float acc[FRACTIONAL_RESAMPLER_LANES] = {};
+            for (int j = 0; j < phaseLen; j += FRACTIONAL_RESAMPLER_LANES) {
+                for (int l = 0; l < FRACTIONAL_RESAMPLER_LANES; l++) {
+                    float t = ta[j + l] + mu * (tb[j + l] - ta[j + l]);
+                    acc[l] += x[j + l] * t;
+                }
+            }
+            for (int c = 0; c < COMPONENTS; c++) {
+                float sum = 0.0f;
+                for (int l = c; l < FRACTIONAL_RESAMPLER_LANES; l += COMPONENTS) { sum += acc[l]; }
+                y[c] = sum;
+            }
+        }
+
+        void generateBank() {
+            // Same filter as the polyphase path of the RationalResampler, designed at the rate of the phases
+            double phaseSamplerate = _inSamplerate * (double)FRACTIONAL_RESAMPLER_PHASES;
+            double bandwidth = std::min<double>(_inSamplerate, _outSamplerate) / 2.0;
+            tap<float> proto = taps::lowPass(bandwidth, bandwidth * 0.1, phaseSamplerate);
+
+            // One more tap per phase and one more phase, the last being the first delayed by one sample, so that the
+            // two phases around any position use the same samples. The taps are repeated for each component and
+            // padded with zeros to a multiple of the lanes
+            tapsPerPhase = (proto.size + FRACTIONAL_RESAMPLER_PHASES - 1) / FRACTIONAL_RESAMPLER_PHASES + 1;
+            phaseLen = tapsPerPhase * COMPONENTS;
+            phaseLen = ((phaseLen + FRACTIONAL_RESAMPLER_LANES - 1) / FRACTIONAL_RESAMPLER_LANES) * FRACTIONAL_RESAMPLER_LANES;
+            int paddedTaps = phaseLen / COMPONENTS;
+            buffer::free(bank);
+            bank = buffer::alloc<float>((FRACTIONAL_RESAMPLER_PHASES + 1) * phaseLen);
+            for (int k = 0; k <= FRACTIONAL_RESAMPLER_PHASES; k++) {
+                for (int j = 0; j < paddedTaps; j++) {
+                    int i = j * FRACTIONAL_RESAMPLER_PHASES + (FRACTIONAL_RESAMPLER_PHASES - 1 - k);
+                    float t = (j < tapsPerPhase && i >= 0 && i < proto.size) ? (proto.taps[i] * (float)FRACTIONAL_RESAMPLER_PHASES) : 0.0f;
+                    for (int c = 0; c < COMPONENTS; c++) { bank[k * phaseLen + j * COMPONENTS + c] = t; }
+                }
+            }
+            taps::free(proto);
+
+            step = _inSamplerate / _outSamplerate;
+            hist = tapsPerPhase - 1;
+            padding = paddedTaps - tapsPerPhase;
+        }
+
+        void grow(int count) {
+            // Reallocate the delay buffer, keeping the history. The padding of the taps reads past the end of the
+            // samples, it is cleared so that it never holds anything but finite values
+            int size = count + tapsPerPhase + padding;
+            T* newBuf = buffer::alloc<T>(size);
+            buffer::clear<T>(newBuf, size);
+            if (buffer) {
+                memcpy(newBuf, buffer, std::min<int>(hist, bufSize) * sizeof(T));
+                buffer::free(buffer);
+            }
+            buffer = newBuf;
+            bufCapacity = count;
+            bufSize = size;
+        }
+
+        void clearHistory() {
+            buffer::clear<T>(buffer, hist);
+            frac = 0.0;
+            offset = 0;
+        }
+
+        double _inSamplerate;
+        double _outSamplerate;
+        double step = 1.0;
+
+        float* bank = NULL;
+        int tapsPerPhase = 0;
+        int phaseLen = 0;
+        int padding = 0;
+
+        T* buffer = NULL;
+        int bufCapacity = 0;
+        int bufSize = 0;
+        int hist = 0;
+        double frac = 0.0;
+        int offset = 0;
+    };
+}
@@ -1,9 +1,13 @@
 #pragma once
 #include "../processor.h"
 #include "../taps/tap.h"
+#include "../filter/kernel.h"
 #include "polyphase_bank.h"
 
 namespace dsp::multirate {
+    // Every interp outputs, the phases repeat and the input has moved by exactly decim samples. The outputs are
+    // therefore computed one phase at a time: all those of a phase use the same taps at a fixed input stride, so a
+    // block kernel computes several of them in one pass over the taps.
     template<class T>
     class PolyphaseResampler : public Processor<T, T> {
         using base_type = Processor<T, T>;
@@ -16,6 +20,7 @@ namespace dsp::multirate {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             buffer::free(buffer);
+            delete[] kernels;
             freePolyphaseBank(phases);
         }
 
@@ -26,9 +31,11 @@ namespace dsp::multirate {
 
             // Build filter bank
             phases = buildPolyphaseBank(_interp, _taps);
+            buildKernels();
 
-            // Allocate delay buffer
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
+            // Allocate delay buffer, it is grown later if larger blocks come through
+            bufCapacity = in ? in->getMaxBlockSize() : 0;
+            buffer = buffer::alloc<T>(bufCapacity + phases.tapsPerPhase);
             bufStart = &buffer[phases.tapsPerPhase - 1];
             buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
 
@@ -48,8 +55,11 @@ namespace dsp::multirate {
             // Re-generate polyphase bank
             freePolyphaseBank(phases);
             phases = buildPolyphaseBank(_interp, _taps);
+            buildKernels();
 
-            // Reset buffer
+            // Reallocate the delay buffer for the new history, it is cleared by the reset
+            buffer::free(buffer);
+            buffer = buffer::alloc<T>(bufCapacity + phases.tapsPerPhase);
             bufStart = &buffer[phases.tapsPerPhase - 1];
             reset();
 
@@ -67,34 +77,52 @@ namespace dsp::multirate {
         }
 
         inline int process(int count, const T* in, T* out) {
-            int outCount = 0;
-
-            // Copy input to buffer
-            memcpy(bufStart, in, count * sizeof(T));
-
-            while (offset < count) {
-                // Do convolution
-                if constexpr (std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[outCount++], &buffer[offset], phases.phases[phase], phases.tapsPerPhase);
+            if (count > bufCapacity) { growBuffer(count); }
+            int hist = phases.tapsPerPhase - 1;
+            int outCount = outputCount(count);
+
+            // When processing in place or with less samples than the history, work from a copy of the input
+            bool copy = (in == out || count < hist);
+            memcpy(bufStart, in, (copy ? count : hist) * sizeof(T));
+
+            // Go through the outputs one phase at a time, output k being the first of its phase
+            int first = std::min<int>(outCount, _interp);
+            for (int k = 0; k < first; k++) {
+                int64_t pos = (int64_t)phase + (int64_t)k * _decim;
+                int start = offset + (int)(pos / _interp);
+                auto& kernel = kernels[pos % _interp];
+                int n = (outCount - k + _interp - 1) / _interp;
+                if (copy) {
+                    kernel.process(&out[k], &buffer[start], _decim, n, _interp);
+                    continue;
                 }
-                if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&buffer[offset], phases.phases[phase], phases.tapsPerPhase);
-                }
-
-                // Increment phase
-                phase += _decim;
 
-                // Branchless phase advance if phase wrap arround occurs
-                offset += phase / _interp;
+                // Only the outputs that overlap the history need the work buffer, the others are computed from the input directly
+                int histCount = (start < hist) ? std::min<int>((hist - start + _decim - 1) / _decim, n) : 0;
+                kernel.process(&out[k], &buffer[start], _decim, histCount, _interp);
+                if (n > histCount) {
+                    kernel.process(&out[k + histCount * _interp], &in[start + histCount * _decim - hist], _decim, n - histCount, _interp);
+                }
+            }
+            advance(outCount, count);
 
-                // Wrap around if needed
-                phase = phase % _interp;
+            // Keep the end of the input as history
+            if (copy) {
+                memmove(buffer, &buffer[count], hist * sizeof(T));
+            }
+            else {
+                memcpy(buffer, &in[count - hist], hist * sizeof(T));
             }
-            offset -= count;
 
-            // Move delay
-            memmove(buffer, &buffer[count], (phases.tapsPerPhase - 1) * sizeof(T));
+            return outCount;
+        }
 
+        // Output what a silent input gives once the delay line only holds zeros, without computing any of it
+        inline int skip(int count, T* out) {
+            int outCount = outputCount(count);
+            advance(outCount, count);
+            memset(out, 0, outCount * sizeof(T));
+            buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
             return outCount;
         }
 
@@ -103,6 +131,7 @@ namespace dsp::multirate {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled((double)_interp / (double)_decim);
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -113,14 +142,51 @@ namespace dsp::multirate {
         }
 
     protected:
+        // Number of outputs whose first sample is within the next count samples
+        inline int outputCount(int count) {
+            if (offset >= count) { return 0; }
+            int64_t span = (int64_t)(count - offset) * _interp - phase;
+            return (int)((span + _decim - 1) / _decim);
+        }
+
+        // Move the phase and offset past the outputs of a block
+        inline void advance(int outCount, int count) {
+            int64_t pos = (int64_t)phase + (int64_t)outCount * _decim;
+            offset += (int)(pos / _interp) - count;
+            phase = (int)(pos % _interp);
+        }
+
+        void buildKernels() {
+            delete[] kernels;
+            kernels = new filter::BlockKernel<T, float>[_interp];
+            for (int i = 0; i < _interp; i++) {
+                tap<float> ptaps;
+                ptaps.taps = phases.phases[i];
+                ptaps.size = phases.tapsPerPhase;
+                kernels[i].setTaps(ptaps);
+            }
+        }
+
+        void growBuffer(int count) {
+            // Reallocate the delay buffer, keeping the history
+            T* newBuf = buffer::alloc<T>(count + phases.tapsPerPhase);
+            memcpy(newBuf, buffer, (phases.tapsPerPhase - 1) * sizeof(T));
+            buffer::free(buffer);
+            buffer = newBuf;
+            bufStart = &buffer[phases.tapsPerPhase - 1];
+            bufCapacity = count;
+        }
+
         int _interp;
         int _decim;
         tap<float> _taps;
         PolyphaseBank<float> phases;
         int phase = 0;
         int offset = 0;
+        filter::BlockKernel<T, float>* kernels = NULL;
         T* buffer;
         T* bufStart;
+        int bufCapacity = 0;
 
     };
 }
\ No newline at end of file
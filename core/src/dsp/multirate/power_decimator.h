@@ -1,9 +1,34 @@
 #pragma once
-#include "../filter/decimating_fir.h"
-#include "../taps/from_array.h"
-#include "decim/plans.h"
+#include "../filter/half_band_decimator.h"
+#include "cic_decimator.h"
+#include "decim/half_band_plan.h"
+#include "../worker_group.h"
+#include "../correction/iq_correction.h"
+#include <memory>
+
+// Largest power of two of the ratio
+#define POWER_DECIMATOR_MAX_POWER       13
+
+// Fraction of the output bandwidth kept free of aliases, the rest being left to the transition of the filters
+#define POWER_DECIMATOR_PASSBAND        0.9
+
+// Attenuation of what would alias into the passband, in dB
+#define POWER_DECIMATOR_ATTENUATION     90.0
+
+// Lowest ratio at which a CIC decimator is used for the first stages when allowed
+#define POWER_DECIMATOR_CIC_MIN_RATIO   128
+
+// Number of half-band stages after the CIC decimator, its aliases are low enough in the lowest eighth of its band
+#define POWER_DECIMATOR_CIC_HALF_BANDS  3
+
+// Input samples per thread below which a stage isn't worth splitting over several threads
+#define POWER_DECIMATOR_PARALLEL_MIN_SAMPLES    16384
 
 namespace dsp::multirate {
+    // Decimates by a power of two with a cascade of half-band decimators. When allowed, large ratios start with a
+    // CIC decimator instead, which integrates without any multiply, followed by only the last half-band stages.
+    // The half-band stages can be split over several threads, see setThreads(). Complex decimators can also invert and
+    // remove the DC offset of their output as part of their pass, see setCorrection()
     template<class T>
     class PowerDecimator : public Processor<T, T> {
         using base_type = Processor<T, T>;
@@ -21,66 +46,193 @@ namespace dsp::multirate {
         void init(stream<T>* in, unsigned int ratio) {
             assert(checkRatio(ratio));
             _ratio = ratio;
-            reconfigure();
+            cic.init(NULL, 2);
+            cic.out.free();
+
+            reconfigure(ratio, cicAllowed);
             base_type::init(in);
         }
 
         static inline unsigned int getMaxRatio() {
-            return 1 << decim::plans_len;
+            return 1 << POWER_DECIMATOR_MAX_POWER;
         }
 
         void setRatio(unsigned int ratio) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _ratio = ratio;
-            reconfigure();
-            base_type::tempStart();
+            reconfigure(ratio, cicAllowed);
         }
 
+        // Allow the use of a CIC decimator for the ratios of at least POWER_DECIMATOR_CIC_MIN_RATIO. It is much
+        // cheaper than the half-band stages it replaces, but its fixed point arithmetic limits the input to +-8.0
+        void setCICAllowed(bool allowed) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            reconfigure(_ratio, allowed);
+        }
+
+        // Split the half-band stages that get enough samples over the given number of threads, the one processing
+        // the buffer included, for sources too fast for a single core. Each buffer is still done before the next one
+        // is started, so the latency and the output stay the same. The CIC decimator isn't split, its integrators
+        // carrying on from one sample to the next
+        void setThreads(int threads) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            std::unique_ptr<WorkerGroup> newWorkers;
+            if (threads > 1) { newWorkers = std::make_unique<WorkerGroup>(threads); }
+            {
+                std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+                workers.swap(newWorkers);
+            }
+        }
+
+        int getThreads() { return workers ? workers->getThreadCount() : 1; }
+
+        // Conjugate the output and/or remove its DC offset, dcRate being the rate of the DC blocker at the output
+        // samplerate. With a ratio of one, the copy or conversion of the input does it in the same pass, otherwise it is
+        // done in place on the output of the last stage
+        void setCorrection(bool conjugate, bool dcBlocking, float dcRate) {
+            static_assert(std::is_same_v<T, complex_t>, "Only complex samples can be corrected");
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+            correction.configure(conjugate, dcBlocking, dcRate);
+        }
+
+        bool isCorrecting() { return correction.isActive(); }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+            correction.reset();
+            cic.reset();
             for (auto& fir : decimFirs) {
                 fir->reset();
             }
-            base_type::tempStart();
         }
 
         inline int process(int count, const T* in, T* out) {
+            std::lock_guard<std::mutex> lck(base_type::paramMtx);
+            return processUnlocked(count, in, out);
+        }
+
+        // Same as process() with 16 bit IQ input, whose full scale is given by scale. The first stage reads the
+        // integers directly, the later ones work on floats at the reduced rate
+        inline int process(int count, const complex_s16_t* in, T* out, float scale) {
+            std::lock_guard<std::mutex> lck(base_type::paramMtx);
+            return processUnlocked(count, in, out, scale);
+        }
+
+        // Also gives the ratio the samples were decimated by, which may change from one buffer to the next
+        inline int process(int count, const complex_s16_t* in, T* out, float scale, unsigned int& ratio) {
+            std::lock_guard<std::mutex> lck(base_type::paramMtx);
+            ratio = _ratio;
+            return processUnlocked(count, in, out, scale);
+        }
+
+        bool fusable() { return true; }
+        int processFused(int count, const T* in, T* out) {
+            std::lock_guard<std::mutex> lck(base_type::paramMtx);
+            fusedRatio = _ratio;
+            return processUnlocked(count, in, out);
+        }
+
+        // The ratio may have changed since the buffer was decimated
+        stream_meta fusedMeta(const stream_meta& meta) { return meta.rescaled(1.0 / (double)fusedRatio); }
+
+        // Each stage can round up by one sample
+        int maxOutputCount(int inputCount) { return (_ratio == 1) ? inputCount : ((inputCount / _ratio) + stageCount + 1); }
+
+        // Intermediate stages are processed in the output buffer
+        int outputBufferSize(int inputCount) { return inputCount; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(outputBufferSize(count));
+
+            int outCount;
+            {
+                std::lock_guard<std::mutex> lck(base_type::paramMtx);
+                outCount = processUnlocked(count, base_type::_in->readBuf, base_type::out.writeBuf);
+                base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / (double)_ratio);
+            }
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        inline int processUnlocked(int count, const T* in, T* out) {
             // If the ratio is 1, no need to decimate
             if (_ratio == 1) {
+                if constexpr (std::is_same_v<T, complex_t>) {
+                    if (correction.isActive()) {
+                        correction.process(count, in, out);
+                        return count;
+                    }
+                }
                 memcpy(out, in, count * sizeof(T));
                 return count;
             }
             
             // Process data through each stage
             const T* data = in;
-            int last = stageCount - 1;
+            if (useCIC) {
+                count = cic.process(count, data, out);
+                data = out;
+            }
             for (int i = 0; i < stageCount; i++) {
                 auto fir = decimFirs[i];
-                count = fir->process(count, data, out);
+                count = splitStage(count) ? fir->process(count, data, out, *workers) : fir->process(count, data, out);
                 data = out;
             }
+            if constexpr (std::is_same_v<T, complex_t>) {
+                if (correction.isActive()) { correction.process(count, out, out); }
+            }
             return count;
         }
 
-        int run() {
-            int count = base_type::_in->read();
-            if (count < 0) { return -1; }
-
-            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+        inline int processUnlocked(int count, const complex_s16_t* in, T* out, float scale) {
+            static_assert(std::is_same_v<T, complex_t>, "Only complex samples can be given as 16 bit IQ");
+            if (_ratio == 1) {
+                if (correction.isActive()) {
+                    correction.process(count, in, out, scale);
+                    return count;
+                }
+                volk_16i_s32f_convert_32f((float*)out, (const int16_t*)in, scale, count * 2);
+                return count;
+            }
 
-            // Swap if some data was generated
-            base_type::_in->flush();
-            if (outCount) {
-                if (!base_type::out.swap(outCount)) { return -1; }
+            int first = 0;
+            if (useCIC) {
+                count = cic.process(count, in, out, scale);
             }
-            return outCount;
+            else if (splitStage(count)) {
+                count = decimFirs[0]->process(count, in, out, scale, *workers);
+                first = 1;
+            }
+            else {
+                count = decimFirs[0]->process(count, in, out, scale);
+                first = 1;
+            }
+            for (int i = first; i < stageCount; i++) {
+                auto fir = decimFirs[i];
+                count = splitStage(count) ? fir->process(count, out, out, *workers) : fir->process(count, out, out);
+            }
+            if (correction.isActive()) { correction.process(count, out, out); }
+            return count;
+        }
+
+        inline bool splitStage(int count) {
+            return workers && count >= POWER_DECIMATOR_PARALLEL_MIN_SAMPLES * workers->getThreadCount();
         }
 
-    protected:
         void freeFirs() {
             for (auto& fir : decimFirs) { delete fir; }
             for (auto& taps : decimTaps) { taps::free(taps); }
@@ -88,23 +240,35 @@ namespace dsp::multirate {
             decimTaps.clear();
         }
 
-        void reconfigure() {
-            // Delete DDC FIRs and taps
-            freeFirs();
+        // The stages are designed without holding the worker, then swapped in between two buffers and the old ones
+        // freed once it's released again
+        void reconfigure(unsigned int ratio, bool allowCIC) {
+            // Generate a half-band stage for each power of two, or only for the last ones after a CIC decimator
+            int newStageCount = log2(ratio);
+            bool newUseCIC = (allowCIC && ratio >= POWER_DECIMATOR_CIC_MIN_RATIO);
+            if (newUseCIC) { newStageCount = POWER_DECIMATOR_CIC_HALF_BANDS; }
+            std::vector<tap<float>> newTaps = decim::halfBandPlan(newStageCount, POWER_DECIMATOR_PASSBAND, POWER_DECIMATOR_ATTENUATION);
+            std::vector<filter::HalfBandDecimator<T>*> newFirs;
+            for (auto& taps : newTaps) {
+                auto fir = new filter::HalfBandDecimator<T>(NULL, taps);
+                fir->out.free();
+                newFirs.push_back(fir);
+            }
 
-            // Generate filters based on DDC plan
-            if (_ratio > 1) {
-                int planId = log2(_ratio) - 1;
-                decim::plan plan = decim::plans[planId];
-                stageCount = plan.stageCount;
-                for (int i = 0; i < stageCount; i++) {
-                    tap<float> taps = taps::fromArray<float>(plan.stages[i].tapcount, plan.stages[i].taps);
-                    auto fir = new filter::DecimatingFIR<T, float>(NULL, taps, plan.stages[i].decimation);
-                    fir->out.free();
-                    decimTaps.push_back(taps);
-                    decimFirs.push_back(fir);
-                }
+            {
+                std::lock_guard<std::mutex> lck(base_type::paramMtx);
+                _ratio = ratio;
+                cicAllowed = allowCIC;
+                stageCount = newStageCount;
+                useCIC = newUseCIC;
+                if (useCIC) { cic.setDecimation(_ratio >> stageCount); }
+                decimFirs.swap(newFirs);
+                decimTaps.swap(newTaps);
             }
+
+            // Delete the previous FIRs and taps
+            for (auto& fir : newFirs) { delete fir; }
+            for (auto& taps : newTaps) { taps::free(taps); }
         }
 
         bool checkRatio(unsigned int ratio) {
@@ -112,9 +276,18 @@ namespace dsp::multirate {
             return ((ratio & (ratio - 1)) == 0) && ratio && ratio <= getMaxRatio();
         }
 
-        std::vector<filter::DecimatingFIR<T, float>*> decimFirs;
+        correction::IQCorrection correction;
+
+        CICDecimator<T> cic;
+        bool cicAllowed = false;
+        bool useCIC = false;
+
+        std::vector<filter::HalfBandDecimator<T>*> decimFirs;
         std::vector<tap<float>> decimTaps;
         unsigned int _ratio;
-        int stageCount;
+        unsigned int fusedRatio = 1;
+        int stageCount = 0;
+
+        std::unique_ptr<WorkerGroup> workers;
     };
 }
\ No newline at end of file
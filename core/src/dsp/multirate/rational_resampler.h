@@ -5,9 +5,16 @@
 #include "../filter/decimating_fir.h"
 #include "../taps/from_array.h"
 #include "polyphase_resampler.h"
+#include "fractional_resampler.h"
 #include "power_decimator.h"
 #include "../taps/low_pass.h"
+#include "../taps/cache.h"
 #include "../window/nuttall.h"
+#include <utils/flog.h>
+#include "../taps/estimate_tap_count.h"
+
+// Largest polyphase filter used for an exact ratio, above it the fractional resampler is used instead
+#define RATIONAL_RESAMPLER_MAX_TAPS     32768
 
 namespace dsp::multirate {
     template<class T>
@@ -21,7 +28,7 @@ namespace dsp::multirate {
         ~RationalResampler() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            taps::free(rtaps);
+            taps::cache::release(rtaps);
         }
 
         void init(stream<T>* in, double inSamplerate, double outSamplerate) {
@@ -29,12 +36,14 @@ namespace dsp::multirate {
             _outSamplerate = outSamplerate;
             
             // Dummy initialization since only used for processing
-            rtaps = taps::lowPass(0.25, 0.1, 1.0);
+            rtaps = taps::cache::lowPass(0.25, 0.1, 1.0);
             decim.init(NULL, 2);
             resamp.init(NULL, 1, 1, rtaps);
+            frac.init(NULL, 1.0, 1.0);
 
             decim.out.free();
             resamp.out.free();
+            frac.out.free();
 
             // Proper configuration
             reconfigure();
@@ -42,12 +51,22 @@ namespace dsp::multirate {
             base_type::init(in);
         }
 
+        // Let the power decimator start with a CIC decimator for large ratios, see PowerDecimator::setCICAllowed()
+        void setCICAllowed(bool allowed) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            decim.setCICAllowed(allowed);
+            base_type::tempStart();
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             decim.reset();
             resamp.reset();
+            frac.reset();
             base_type::tempStart();
         }
 
@@ -83,11 +102,11 @@ namespace dsp::multirate {
             switch(mode) {
                 case Mode::BOTH:
                     count = decim.process(count, in, out);
-                    return resamp.process(count, out, out);
+                    return fractional ? frac.process(count, out, out) : resamp.process(count, out, out);
                 case Mode::DECIM_ONLY:
                     return decim.process(count, in, out);
                 case Mode::RESAMP_ONLY:
-                    return resamp.process(count, in, out);
+                    return fractional ? frac.process(count, in, out) : resamp.process(count, in, out);
                 case Mode::NONE:
                     memcpy(out, in, count * sizeof(T));
                     return count;
@@ -95,11 +114,34 @@ namespace dsp::multirate {
             return count;
         }
 
+        int maxOutputCount(int inputCount) { return (int)ceil((double)inputCount * outRatio) + 32; }
+
+        // In BOTH mode, the power decimator runs its stages in the output buffer before resampling
+        int outputBufferSize(int inputCount) {
+            if (predecRatio == 1) { return maxOutputCount(inputCount); }
+            return std::max<int>(maxOutputCount(inputCount), decim.outputBufferSize(inputCount));
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
-
-            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.reserve(outputBufferSize(count));
+
+            // Only the resamplers can skip silence, the power decimator always has to run
+            int outCount;
+            bool skipping = silence.skip(base_type::_in->readMeta, count);
+            if (skipping && (mode == Mode::RESAMP_ONLY || mode == Mode::NONE)) {
+                if (mode == Mode::NONE) { outCount = count; }
+                else if (fractional) { outCount = frac.skip(count, base_type::out.writeBuf); }
+                else { outCount = resamp.skip(count, base_type::out.writeBuf); }
+                if (mode == Mode::NONE) { memset(base_type::out.writeBuf, 0, count * sizeof(T)); }
+            }
+            else {
+                outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+                skipping = false;
+            }
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_outSamplerate / _inSamplerate);
+            base_type::out.writeMeta.silent = skipping;
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -118,6 +160,8 @@ namespace dsp::multirate {
         };
 
         void reconfigure() {
+            silence.setSamplerate(_inSamplerate);
+
             // Calculate highest power-of-two decimation for the power decimator 
             int predecPower = std::min<int>(floor(log2(_inSamplerate / _outSamplerate)), PowerDecimator<T>::getMaxRatio());
             int predecRatio = std::min<int>(1 << predecPower, PowerDecimator<T>::getMaxRatio());
@@ -129,6 +173,7 @@ namespace dsp::multirate {
                 intSamplerate = _inSamplerate / (double)predecRatio;
                 decim.setRatio(predecRatio);
             }
+            this->predecRatio = useDecim ? predecRatio : 1;
 
             // Calculate interpolation and decimation for polyphase resampler
             int IntSR = round(intSamplerate);
@@ -137,26 +182,38 @@ namespace dsp::multirate {
             int interp = OutSR / gcd;
             int decim = IntSR / gcd;
 
-            // Check for excessive error
+            // Check how far off the rounded rates are
             double actualOutSR = (double)IntSR * (double)interp / (double)decim;
             double error = abs((actualOutSR - _outSamplerate) / _outSamplerate) * 100.0;
             if (error > 0.01) {
-                fprintf(stderr, "Warning: resampling error is over 0.01%%: %lf\n", error);
+                flog::warn("Resampling error is over 0.01%: {}, using the fractional resampler", error);
             }
             
             // If the power decimator already did all the work, don't use the resampler
-            if (interp == decim) {
+            if (interp == decim && error <= 0.01) {
                 mode = useDecim ? Mode::DECIM_ONLY : Mode::NONE;
+                outRatio = 1.0 / (double)this->predecRatio;
+                fractional = false;
                 return;
             }
 
-            // Configure the polyphase resampler
+            // An inexact ratio, or one needing a huge polyphase filter, is left to the fractional resampler
             double tapSamplerate = intSamplerate * (double)interp;
             double tapBandwidth = std::min<double>(_inSamplerate, _outSamplerate) / 2.0;
             double tapTransWidth = tapBandwidth * 0.1;
-            taps::free(rtaps);
-            rtaps = taps::lowPass(tapBandwidth, tapTransWidth, tapSamplerate);
-            for (int i = 0; i < rtaps.size; i++) { rtaps.taps[i] *= (float)interp; }
+            fractional = (error > 0.01 || taps::estimateTapCount(tapTransWidth, tapSamplerate) > RATIONAL_RESAMPLER_MAX_TAPS);
+            if (fractional) {
+                frac.setRates(intSamplerate, _outSamplerate);
+                outRatio = _outSamplerate / _inSamplerate;
+                flog::debug("Resampler: predec {}, fractional ratio {}", this->predecRatio, intSamplerate / _outSamplerate);
+                mode = useDecim ? Mode::BOTH : Mode::RESAMP_ONLY;
+                return;
+            }
+            outRatio = (double)interp / ((double)decim * (double)this->predecRatio);
+
+            // Configure the polyphase resampler
+            taps::cache::release(rtaps);
+            rtaps = taps::cache::lowPass(tapBandwidth, tapTransWidth, tapSamplerate, false, interp);
             resamp.setRatio(interp, decim, rtaps);
 
             printf("[Resamp] predec: %d, interp: %d, decim: %d, inacc: %lf%%, taps: %d\n", predecRatio, interp, decim, error, rtaps.size);
@@ -166,9 +223,14 @@ namespace dsp::multirate {
         
         PowerDecimator<T> decim;
         PolyphaseResampler<T> resamp;
+        FractionalResampler<T> frac;
         tap<float> rtaps;
         double _inSamplerate;
         double _outSamplerate;
         Mode mode;
+        bool fractional = false;
+        int predecRatio = 1;
+        double outRatio = 1.0;
+        silence_tracker silence;
     };
 }
\ No newline at end of file
@@ -62,6 +62,7 @@ namespace dsp::multirate {
             if (count < 0) { return -1; }
 
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta.rescaled(_samplerate / _symbolrate);
 
             // Swap if some data was generated
             base_type::_in->flush();
@@ -0,0 +1,100 @@
+#pragma once
+#include "power_decimator.h"
+
+namespace dsp::multirate {
+    // Power decimator taking 16 bit IQ and outputting complex samples. The first stage reads the integers and converts
+    // them itself, so the samples at the full rate are only ever stored at four bytes each. With a ratio of one, the
+    // samples are only converted, and corrected in the same pass if enabled
+    class S16PowerDecimator : public Processor<complex_s16_t, complex_t> {
+        using base_type = Processor<complex_s16_t, complex_t>;
+    public:
+        // The ratio and scale are changed between two buffers, the stages being swapped by the inner decimator
+        S16PowerDecimator() {}
+
+        S16PowerDecimator(stream<complex_s16_t>* in, unsigned int ratio, float scale = 32768.0f) { init(in, ratio, scale); }
+
+        void init(stream<complex_s16_t>* in, unsigned int ratio, float scale = 32768.0f) {
+            _scale = scale;
+            decim.init(NULL, ratio);
+            decim.out.free();
+            base_type::init(in);
+        }
+
+        // The new stages are designed without holding the worker, the inner decimator only locking it to swap them in.
+        // The ratio of the metadata is taken from the stages that processed each buffer
+        void setRatio(unsigned int ratio) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            decim.setRatio(ratio);
+        }
+
+        // Value of the integers that corresponds to 1.0
+        void setScale(float scale) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+            _scale = scale;
+        }
+
+        // See PowerDecimator::setCICAllowed()
+        void setCICAllowed(bool allowed) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            decim.setCICAllowed(allowed);
+        }
+
+        // See PowerDecimator::setThreads()
+        void setThreads(int threads) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            decim.setThreads(threads);
+        }
+
+        // See PowerDecimator::setCorrection()
+        void setCorrection(bool conjugate, bool dcBlocking, float dcRate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            decim.setCorrection(conjugate, dcBlocking, dcRate);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            decim.reset();
+        }
+
+        inline int process(int count, const complex_s16_t* in, complex_t* out) {
+            return decim.process(count, in, out, _scale);
+        }
+
+        int maxOutputCount(int inputCount) { return decim.maxOutputCount(inputCount); }
+
+        // Intermediate stages are processed in the output buffer
+        int outputBufferSize(int inputCount) { return decim.outputBufferSize(inputCount); }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(outputBufferSize(count));
+
+            int outCount;
+            {
+                std::lock_guard<std::mutex> lck(base_type::paramMtx);
+                unsigned int ratio;
+                outCount = decim.process(count, base_type::_in->readBuf, base_type::out.writeBuf, _scale, ratio);
+                base_type::out.writeMeta = base_type::_in->readMeta.rescaled(1.0 / (double)ratio);
+            }
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        PowerDecimator<complex_t> decim;
+        float _scale = 32768.0f;
+    };
+}
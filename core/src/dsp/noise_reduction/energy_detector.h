@@ -0,0 +1,192 @@
+#pragma once
+#include "../processor.h"
+#include <atomic>
+#include <vector>
+
+namespace dsp::noise_reduction {
+    // Passes the samples through only while a signal is present, so that the blocks downstream sleep on their input
+    // while the channel is empty. The power of each buffer is compared to a noise floor tracked while closed: the
+    // detector opens when it gets openLevel dB above it and closes once it stayed under closeLevel dB for hang
+    // samples. On opening, the last preRoll samples are sent first so that the start of the burst isn't lost, the
+    // first buffer being flagged as a discontinuity.
+    class EnergyDetector : public Processor<complex_t, complex_t> {
+        using base_type = Processor<complex_t, complex_t>;
+    public:
+        EnergyDetector() {}
+
+        EnergyDetector(stream<complex_t>* in, double openLevel, double closeLevel, int hang, int preRoll) { init(in, openLevel, closeLevel, hang, preRoll); }
+
+        ~EnergyDetector() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(powerBuf);
+        }
+
+        void init(stream<complex_t>* in, double openLevel, double closeLevel, int hang, int preRoll) {
+            _openLevel = openLevel;
+            _closeLevel = closeLevel;
+            _hang = hang;
+            setPreRollSize(preRoll);
+
+            powerBuf = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+
+            base_type::init(in);
+        }
+
+        // Levels are in dB above the noise floor, closeLevel being lower than openLevel for hysteresis
+        void setLevels(double openLevel, double closeLevel) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _openLevel = openLevel;
+            _closeLevel = closeLevel;
+        }
+
+        void setHang(int hang) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _hang = hang;
+        }
+
+        void setPreRoll(int preRoll) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            setPreRollSize(preRoll);
+            base_type::tempStart();
+        }
+
+        // Called from the DSP thread whenever the detector opens or closes
+        void setStateHandler(void (*handler)(bool open, void* ctx), void* ctx) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _handler = handler;
+            _ctx = ctx;
+            base_type::tempStart();
+        }
+
+        bool isOpen() {
+            return _open;
+        }
+
+        float getNoiseFloor() {
+            return noiseFloor;
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _open = false;
+            floorValid = false;
+            histFill = 0;
+            base_type::tempStart();
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Average power of the buffer
+            float sum;
+            volk_32fc_magnitude_squared_32f(powerBuf, (lv_32fc_t*)base_type::_in->readBuf, count);
+            volk_32f_accumulator_s32f(&sum, powerBuf, count);
+            float level = 10.0f * log10f(std::max<float>(sum / (float)count, 1e-20f));
+
+            // Update the state, the noise floor only following the level while closed
+            bool wasOpen = _open;
+            if (!floorValid) {
+                noiseFloor = level;
+                floorValid = true;
+            }
+            if (!_open) {
+                if (level - noiseFloor >= _openLevel) {
+                    _open = true;
+                    hangLeft = _hang;
+                }
+                else {
+                    noiseFloor += ((level < noiseFloor) ? 0.5f : 0.01f) * (level - noiseFloor);
+                }
+            }
+            else if (level - noiseFloor >= _closeLevel) {
+                hangLeft = _hang;
+            }
+            else if ((hangLeft -= count) <= 0) {
+                _open = false;
+            }
+            if (_open != wasOpen && _handler) { _handler(_open, _ctx); }
+
+            // While closed, only keep the samples for the pre-roll
+            if (!_open) {
+                pushHistory(base_type::_in->readBuf, count);
+                base_type::_in->flush();
+                return count;
+            }
+
+            // Send out the pre-roll ahead of the first buffer
+            int outCount = count;
+            if (!wasOpen) {
+                outCount += histFill;
+                base_type::out.reserve(outCount);
+                int start = (histPos + history.size() - histFill) % std::max<int>(history.size(), 1);
+                for (int i = 0; i < histFill; i++) {
+                    base_type::out.writeBuf[i] = history[(start + i) % history.size()];
+                }
+                memcpy(&base_type::out.writeBuf[histFill], base_type::_in->readBuf, count * sizeof(complex_t));
+
+                // The pre-roll starts before the buffer
+                stream_meta& meta = base_type::out.writeMeta;
+                meta = base_type::_in->readMeta;
+                meta.sampleIndex -= std::min<uint64_t>(histFill, meta.sampleIndex);
+                if (meta.timestamp != 0.0 && meta.samplerate != 0.0) { meta.timestamp -= (double)histFill / meta.samplerate; }
+                meta.discontinuity = true;
+                histFill = 0;
+            }
+            else {
+                memcpy(base_type::out.writeBuf, base_type::_in->readBuf, count * sizeof(complex_t));
+                base_type::out.writeMeta = base_type::_in->readMeta;
+            }
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(outCount)) { return -1; }
+            return count;
+        }
+
+    private:
+        void setPreRollSize(int preRoll) {
+            history.assign(std::max<int>(preRoll, 0), complex_t{ 0.0f, 0.0f });
+            histPos = 0;
+            histFill = 0;
+        }
+
+        void pushHistory(const complex_t* in, int count) {
+            int size = history.size();
+            if (!size) { return; }
+            if (count > size) {
+                in += count - size;
+                count = size;
+            }
+            int first = std::min<int>(count, size - histPos);
+            memcpy(&history[histPos], in, first * sizeof(complex_t));
+            if (first < count) { memcpy(history.data(), &in[first], (count - first) * sizeof(complex_t)); }
+            histPos = (histPos + count) % size;
+            histFill = std::min<int>(histFill + count, size);
+        }
+
+        float* powerBuf;
+        float _openLevel;
+        float _closeLevel;
+        int _hang;
+        int hangLeft = 0;
+        std::atomic<bool> _open = false;
+        float noiseFloor = 0.0f;
+        bool floorValid = false;
+
+        std::vector<complex_t> history;
+        int histPos = 0;
+        int histFill = 0;
+
+        void (*_handler)(bool open, void* ctx) = NULL;
+        void* _ctx = NULL;
+    };
+}
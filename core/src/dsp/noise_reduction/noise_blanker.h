@@ -1,6 +1,9 @@
 #pragma once
 #include "../processor.h"
 
+// Number of samples whose gains are computed at once
+#define NOISE_BLANKER_CHUNK_SIZE    1024
+
 namespace dsp::noise_reduction {
     class NoiseBlanker : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
@@ -36,22 +39,28 @@ namespace dsp::noise_reduction {
         }
 
         inline int process(int count, complex_t* in, complex_t* out) {
-            for (int i = 0; i < count; i++) {
-                // Get signal amplitude
-                float inAmp = in[i].amplitude();
-
-                // Update average amplitude
-                float gain = 1.0f;
-                if (inAmp != 0.0f) {
-                    amp = (amp * _invRate) + (inAmp * _rate);
-                    float excess = inAmp / amp;
-                    if (excess > _level) {
-                        gain = 1.0f / excess;
+            for (int i = 0; i < count; i += NOISE_BLANKER_CHUNK_SIZE) {
+                int n = std::min<int>(NOISE_BLANKER_CHUNK_SIZE, count - i);
+
+                // Get signal amplitudes
+                volk_32fc_magnitude_32f(gains, (lv_32fc_t*)&in[i], n);
+
+                // Update average amplitude and turn the amplitudes into gains in place
+                for (int j = 0; j < n; j++) {
+                    float inAmp = gains[j];
+                    float gain = 1.0f;
+                    if (inAmp != 0.0f) {
+                        amp = (amp * _invRate) + (inAmp * _rate);
+                        float excess = inAmp / amp;
+                        if (excess > _level) {
+                            gain = 1.0f / excess;
+                        }
                     }
+                    gains[j] = gain;
                 }
-                
+
                 // Scale output by gain
-                out[i] = in[i] * gain;
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&in[i], gains, n);
             }
             return count;
         }
@@ -61,6 +70,7 @@ namespace dsp::noise_reduction {
             if (count < 0) { return -1; }
 
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -74,5 +84,7 @@ namespace dsp::noise_reduction {
 
         float amp = 1.0;
 
+    private:
+        float gains[NOISE_BLANKER_CHUNK_SIZE];
     };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include <atomic>
 
 // TODO: Rewrite better!!!!!
 namespace dsp::noise_reduction {
@@ -30,19 +31,39 @@ namespace dsp::noise_reduction {
             _level = level;
         }
 
+        // Called from the DSP thread whenever the squelch opens or closes
+        void setStateHandler(void (*handler)(bool open, void* ctx), void* ctx) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _handler = handler;
+            _ctx = ctx;
+            base_type::tempStart();
+        }
+
+        bool isOpen() {
+            return _open;
+        }
+
         inline int process(int count, const complex_t* in, complex_t* out) {
             float sum;
             volk_32fc_magnitude_32f(normBuffer, (lv_32fc_t*)in, count);
             volk_32f_accumulator_s32f(&sum, normBuffer, count);
             sum /= (float)count;
 
-            if (10.0f * log10f(sum) >= _level) {
+            bool open = (10.0f * log10f(sum) >= _level);
+            if (open) {
                 memcpy(out, in, count * sizeof(complex_t));
             }
             else {
                 memset(out, 0, count * sizeof(complex_t));
             }
 
+            if (open != _open) {
+                _open = open;
+                if (_handler) { _handler(open, _ctx); }
+            }
+
             return count;
         }
 
@@ -52,6 +73,11 @@ namespace dsp::noise_reduction {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            // Let the blocks downstream skip their processing while closed
+            base_type::out.writeMeta.silent = !_open;
+
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
             return count;
@@ -60,6 +86,9 @@ namespace dsp::noise_reduction {
     private:
         float* normBuffer;
         float _level = -50.0f;
+        std::atomic<bool> _open = false;
+        void (*_handler)(bool open, void* ctx) = NULL;
+        void* _ctx = NULL;
                 
     };
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include "processor.h"
+#include "../types.h"
+
+namespace dsp::planar {
+    // Entry of a chain of planar blocks
+    class ComplexToPlanar : public Processor<stream<complex_t>, planar_stream> {
+        using base_type = Processor<stream<complex_t>, planar_stream>;
+    public:
+        ComplexToPlanar() {}
+
+        ComplexToPlanar(stream<complex_t>* in) { init(in); }
+
+        ~ComplexToPlanar() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+        }
+
+        static inline int process(int count, const complex_t* in, float* re, float* im) {
+            volk_32fc_deinterleave_32f_x2(re, im, (const lv_32fc_t*)in, count);
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(count);
+
+            float* buf = base_type::out.writeBuf;
+            process(count, base_type::_in->readBuf, planar_stream::re(buf, count), planar_stream::im(buf, count));
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+    };
+
+    // Exit of a chain of planar blocks
+    class PlanarToComplex : public Processor<planar_stream, stream<complex_t>> {
+        using base_type = Processor<planar_stream, stream<complex_t>>;
+    public:
+        PlanarToComplex() {}
+
+        PlanarToComplex(planar_stream* in) { init(in); }
+
+        ~PlanarToComplex() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+        }
+
+        static inline int process(int count, const float* re, const float* im, complex_t* out) {
+            volk_32f_x2_interleave_32fc((lv_32fc_t*)out, re, im, count);
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(count);
+
+            float* buf = base_type::_in->readBuf;
+            process(count, planar_stream::re(buf, count), planar_stream::im(buf, count), base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+    };
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "processor.h"
+#include "../filter/kernel.h"
+
+namespace dsp::planar {
+    // Complex FIR with real taps, each component being convolved on its own with the kernel of a real filter. Unlike
+    // filter::FIR, long filters aren't done in the frequency domain and changing the taps doesn't crossfade
+    class FIR : public Processor<planar_stream, planar_stream> {
+        using base_type = Processor<planar_stream, planar_stream>;
+    public:
+        FIR() {}
+
+        FIR(planar_stream* in, tap<float>& taps) { init(in, taps); }
+
+        ~FIR() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(bufRe);
+            buffer::free(bufIm);
+        }
+
+        void init(planar_stream* in, tap<float>& taps) {
+            _taps = taps;
+            kernel.setTaps(_taps);
+
+            // Allocate and clear the buffers, they are grown later if larger blocks come through
+            bufCapacity = in ? in->getMaxBlockSize() : 0;
+            bufRe = buffer::alloc<float>(bufCapacity + _taps.size);
+            bufIm = buffer::alloc<float>(bufCapacity + _taps.size);
+            buffer::clear<float>(bufRe, _taps.size - 1);
+            buffer::clear<float>(bufIm, _taps.size - 1);
+
+            base_type::init(in);
+        }
+
+        void setTaps(tap<float>& taps) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            int oldTC = _taps.size;
+            _taps = taps;
+            kernel.setTaps(_taps);
+
+            // Keep as much of the history as the new taps need, the buffers are reallocated to make room for a longer one
+            if (_taps.size < oldTC) {
+                memmove(bufRe, &bufRe[oldTC - _taps.size], (_taps.size - 1) * sizeof(float));
+                memmove(bufIm, &bufIm[oldTC - _taps.size], (_taps.size - 1) * sizeof(float));
+            }
+            else if (_taps.size > oldTC) {
+                bufRe = regrow(bufRe, bufCapacity, oldTC - 1, _taps.size - oldTC);
+                bufIm = regrow(bufIm, bufCapacity, oldTC - 1, _taps.size - oldTC);
+            }
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            buffer::clear<float>(bufRe, _taps.size - 1);
+            buffer::clear<float>(bufIm, _taps.size - 1);
+            base_type::tempStart();
+        }
+
+        // May be done in place
+        inline int process(int count, const float* inRe, const float* inIm, float* outRe, float* outIm) {
+            if (count > bufCapacity) {
+                int hist = _taps.size - 1;
+                bufRe = regrow(bufRe, count, hist, 0);
+                bufIm = regrow(bufIm, count, hist, 0);
+                bufCapacity = count;
+            }
+            convolve(count, inRe, outRe, bufRe);
+            convolve(count, inIm, outIm, bufIm);
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(count);
+
+            float* in = base_type::_in->readBuf;
+            float* out = base_type::out.writeBuf;
+            process(count, planar_stream::re(in, count), planar_stream::im(in, count), planar_stream::re(out, count), planar_stream::im(out, count));
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+
+    protected:
+        // Same as filter::FIR, the history of the component being at the start of its buffer
+        inline void convolve(int count, const float* in, float* out, float* buf) {
+            int hist = _taps.size - 1;
+            if (in == out || count < hist) {
+                memcpy(&buf[hist], in, count * sizeof(float));
+                kernel.process(out, buf, 1, count);
+                memmove(buf, &buf[count], hist * sizeof(float));
+                return;
+            }
+            memcpy(&buf[hist], in, hist * sizeof(float));
+            kernel.process(out, buf, 1, hist);
+            kernel.process(&out[hist], in, 1, count - hist);
+            memcpy(buf, &in[count - hist], hist * sizeof(float));
+        }
+
+        // Buffer for capacity samples and the history of the taps, the current history being kept after pad zeros
+        float* regrow(float* buf, int capacity, int hist, int pad) {
+            float* newBuf = buffer::alloc<float>(capacity + _taps.size);
+            buffer::clear<float>(newBuf, pad);
+            memcpy(&newBuf[pad], buf, hist * sizeof(float));
+            buffer::free(buf);
+            return newBuf;
+        }
+
+        tap<float> _taps;
+        filter::BlockKernel<float, float> kernel;
+        float* bufRe = NULL;
+        float* bufIm = NULL;
+        int bufCapacity = 0;
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "processor.h"
+#include "../kernels/kernels.h"
+
+namespace dsp::planar {
+    class Magnitude : public Processor<planar_stream, stream<float>> {
+        using base_type = Processor<planar_stream, stream<float>>;
+    public:
+        Magnitude() {}
+
+        Magnitude(planar_stream* in) { init(in); }
+
+        ~Magnitude() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+        }
+
+        static inline int process(int count, const float* re, const float* im, float* out) {
+            kernels::get().planarMagnitude(out, re, im, count);
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(count);
+
+            float* in = base_type::_in->readBuf;
+            process(count, planar_stream::re(in, count), planar_stream::im(in, count), base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+    };
+}
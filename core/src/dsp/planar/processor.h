@@ -0,0 +1,47 @@
+#pragma once
+#include "../block.h"
+#include "../planar_stream.h"
+
+namespace dsp::planar {
+    // Same as dsp::Processor, with the types of the input and output streams instead of those of their samples so that
+    // either can be a planar_stream. Outputs are at the input rate
+    template <class I, class O>
+    class Processor : public block {
+    public:
+        Processor() {}
+
+        virtual ~Processor() {}
+
+        virtual void init(I* in) {
+            _in = in;
+            registerInput(_in);
+            registerOutput(&out);
+            if (_in) {
+                out.setBufferSize(_in->getMaxBlockSize());
+                out.setMaxBlockSize(_in->getMaxBlockSize());
+            }
+            _block_init = true;
+        }
+
+        virtual void setInput(I* in) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            tempStop();
+            unregisterInput(_in);
+            _in = in;
+            registerInput(_in);
+            if (_in) {
+                out.reserve(_in->getMaxBlockSize());
+                out.setMaxBlockSize(std::max<int>(out.getMaxBlockSize(), _in->getMaxBlockSize()));
+            }
+            tempStart();
+        }
+
+        virtual int run() = 0;
+
+        O out;
+
+    protected:
+        I* _in;
+    };
+}
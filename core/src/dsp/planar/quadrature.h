@@ -0,0 +1,80 @@
+#pragma once
+#include "processor.h"
+#include "../kernels/kernels.h"
+#include "../math/hz_to_rads.h"
+
+namespace dsp::planar {
+    // Planar counterpart of demod::Quadrature, the phase difference being computed without the product of the
+    // interleaved samples in between
+    class Quadrature : public Processor<planar_stream, stream<float>> {
+        using base_type = Processor<planar_stream, stream<float>>;
+    public:
+        Quadrature() {}
+
+        Quadrature(planar_stream* in, double deviation) { init(in, deviation); }
+
+        Quadrature(planar_stream* in, double deviation, double samplerate) { init(in, deviation, samplerate); }
+
+        ~Quadrature() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+        }
+
+        void init(planar_stream* in, double deviation) {
+            _invDeviation = 1.0 / deviation;
+            base_type::init(in);
+        }
+
+        void init(planar_stream* in, double deviation, double samplerate) {
+            init(in, math::hzToRads(deviation, samplerate));
+        }
+
+        void setDeviation(double deviation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _invDeviation = 1.0 / deviation;
+        }
+
+        void setDeviation(double deviation, double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _invDeviation = 1.0 / math::hzToRads(deviation, samplerate);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            lastRe = 1.0f;
+            lastIm = 0.0f;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const float* re, const float* im, float* out) {
+            if (!count) { return 0; }
+            kernels::get().planarPhaseDiff(out, re, im, lastRe, lastIm, _invDeviation, count);
+            lastRe = re[count - 1];
+            lastIm = im[count - 1];
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(count);
+
+            float* in = base_type::_in->readBuf;
+            process(count, planar_stream::re(in, count), planar_stream::im(in, count), base_type::out.writeBuf);
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+
+    protected:
+        float _invDeviation;
+        float lastRe = 1.0f;
+        float lastIm = 0.0f;
+    };
+}
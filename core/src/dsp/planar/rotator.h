@@ -0,0 +1,101 @@
+#pragma once
+#include "processor.h"
+#include "../kernels/kernels.h"
+#include "../math/hz_to_rads.h"
+#include "../math/constants.h"
+
+// Samples rotated from one phase, with the phasors of as many samples computed once for a given offset
+#define PLANAR_ROTATOR_CHUNK_SIZE   1024
+
+namespace dsp::planar {
+    // Planar counterpart of channel::FrequencyXlator. The phase of each chunk is recomputed from an angle kept in
+    // double precision, so the amplitude doesn't drift as with a phasor updated by multiplication
+    class Rotator : public Processor<planar_stream, planar_stream> {
+        using base_type = Processor<planar_stream, planar_stream>;
+    public:
+        Rotator() {}
+
+        Rotator(planar_stream* in, double offset) { init(in, offset); }
+
+        Rotator(planar_stream* in, double offset, double samplerate) { init(in, offset, samplerate); }
+
+        ~Rotator() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(stepRe);
+            buffer::free(stepIm);
+        }
+
+        void init(planar_stream* in, double offset) {
+            stepRe = buffer::alloc<float>(PLANAR_ROTATOR_CHUNK_SIZE);
+            stepIm = buffer::alloc<float>(PLANAR_ROTATOR_CHUNK_SIZE);
+            phase = 0.0;
+            computeSteps(offset);
+            base_type::init(in);
+        }
+
+        void init(planar_stream* in, double offset, double samplerate) {
+            init(in, math::hzToRads(offset, samplerate));
+        }
+
+        void setOffset(double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            computeSteps(offset);
+            base_type::tempStart();
+        }
+
+        void setOffset(double offset, double samplerate) {
+            setOffset(math::hzToRads(offset, samplerate));
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            phase = 0.0;
+            base_type::tempStart();
+        }
+
+        // May be done in place
+        inline int process(int count, const float* inRe, const float* inIm, float* outRe, float* outIm) {
+            const kernels::Table& k = kernels::get();
+            for (int i = 0; i < count; i += PLANAR_ROTATOR_CHUNK_SIZE) {
+                int n = std::min<int>(count - i, PLANAR_ROTATOR_CHUNK_SIZE);
+                k.planarRotate(&outRe[i], &outIm[i], &inRe[i], &inIm[i], stepRe, stepIm, (float)cos(phase), (float)sin(phase), n);
+                phase = remainder(phase + _offset * (double)n, 2.0 * DB_M_PI);
+            }
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+            base_type::out.reserve(count);
+
+            float* in = base_type::_in->readBuf;
+            float* out = base_type::out.writeBuf;
+            process(count, planar_stream::re(in, count), planar_stream::im(in, count), planar_stream::re(out, count), planar_stream::im(out, count));
+            base_type::out.writeMeta = base_type::_in->readMeta;
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+
+    protected:
+        void computeSteps(double offset) {
+            _offset = offset;
+            for (int i = 0; i < PLANAR_ROTATOR_CHUNK_SIZE; i++) {
+                stepRe[i] = cos(offset * (double)i);
+                stepIm[i] = sin(offset * (double)i);
+            }
+        }
+
+        double _offset;
+        double phase;
+        float* stepRe = NULL;
+        float* stepIm = NULL;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "stream.h"
+
+namespace dsp {
+    // Stream of complex samples stored as split I/Q: a buffer of count samples holds the count real parts followed by
+    // the count imaginary parts. Kernels working on each component then load whole vectors of them instead of shuffling
+    // the lanes of interleaved samples. Counts and sizes are in complex samples, the float buffers being twice as large.
+    // Only blocks of dsp::planar are meant to read or write it, converters from dsp::planar join it to the rest of the graph
+    class planar_stream : public stream<float> {
+    public:
+        planar_stream(int bufferSize = STREAM_BUFFER_SIZE) : stream<float>(2 * bufferSize) {
+            setMaxBlockSize(bufferSize);
+        }
+
+        virtual void setBufferSize(int samples) {
+            stream<float>::setBufferSize(2 * samples);
+            setMaxBlockSize(samples);
+        }
+
+        virtual inline void reserve(int samples) {
+            stream<float>::reserve(2 * samples);
+        }
+
+        virtual int getBufferSize() {
+            return stream<float>::getBufferSize() / 2;
+        }
+
+        // Components of a block of count samples
+        static inline float* re(float* buf, int count) { return buf; }
+        static inline float* im(float* buf, int count) { return &buf[count]; }
+    };
+}
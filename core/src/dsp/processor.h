@@ -5,14 +5,17 @@
 // This is needed because not all process functions have the same arguments
 
 #define OVERRIDE_PROC_RUN(exp)\
+    int maxOutputCount(int inputCount) { return inputCount; }\
     int run() {\
         int count = _in->read();\
         if (count < 0) {\
             return -1;\
         }\
+        base_type::out.reserve(count);\
         \
         exp;\
         \
+        base_type::out.writeMeta = base_type::_in->readMeta;\
         base_type::_in->flush();\
         if (!base_type::out.swap(count)) { return -1; }\
         return count;\
@@ -24,6 +27,7 @@
         if (count < 0) {\
             return -1;\
         }\
+        base_type::out.reserve(base_type::outputBufferSize(count));\
         \
         int outCount = exp;\
         \
@@ -51,6 +55,14 @@ namespace dsp {
             _in = in;
             registerInput(_in);
             registerOutput(&out);
+
+            // Size the output stream from the largest block the input will carry
+            if (_in) {
+                int inBlockSize = _in->getMaxBlockSize();
+                out.setBufferSize(outputBufferSize(inBlockSize));
+                out.setMaxBlockSize(maxOutputCount(inBlockSize));
+            }
+
             _block_init = true;
         }
 
@@ -61,9 +73,32 @@ namespace dsp {
             unregisterInput(_in);
             _in = in;
             registerInput(_in);
+            if (_in) {
+                int inBlockSize = _in->getMaxBlockSize();
+                out.reserve(outputBufferSize(inBlockSize));
+                out.setMaxBlockSize(std::max<int>(out.getMaxBlockSize(), maxOutputCount(inBlockSize)));
+            }
             tempStart();
         }
 
+        // Maximum number of samples handed to the output for a given number of input samples.
+        // By default, the output is a full size buffer regardless of the input.
+        virtual int maxOutputCount(int inputCount) { return STREAM_BUFFER_SIZE; }
+
+        // Size of the output buffer needed to process a given number of input samples. This is larger than
+        // maxOutputCount() for blocks that use their output buffer as scratch space at the input rate.
+        // Blocks that override maxOutputCount() must reserve() this many samples in the output before writing to it.
+        virtual int outputBufferSize(int inputCount) { return maxOutputCount(inputCount); }
+
+        // Process samples from the calling thread. Blocks that return true from fusable() implement this
+        // so that several of them can be run back-to-back on a single thread (see chain)
+        virtual bool fusable() { return false; }
+        virtual int processFused(int count, const I* in, O* out) { return -1; }
+
+        // Meta of the output of the last processFused() call given the meta of its input. Blocks changing the samplerate or the
+        // center frequency override it so that a fused chain can describe its output
+        virtual stream_meta fusedMeta(const stream_meta& meta) { return meta; }
+
         virtual int run() = 0;
 
         stream<O> out;
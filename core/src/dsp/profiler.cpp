@@ -0,0 +1,211 @@
+#include "profiler.h"
+#include <mutex>
+#include <deque>
+#include <algorithm>
+#include <stdio.h>
+#include <utils/flog.h>
+
+// Events kept by each thread, a few seconds of a busy block
+#define PROFILER_TRACE_EVENTS       32768
+
+// Most threads traced at once, the rings of threads that exited are reused by new ones
+#define PROFILER_TRACE_MAX_THREADS  256
+
+namespace dsp::profiler {
+    struct Entry {
+        std::string name;
+        Counters* counters;
+    };
+
+    static std::atomic<bool> enabled = false;
+    static std::mutex registryMtx;
+    static std::vector<Entry> registry;
+
+    // Names given to traces, never freed so that events can point to them. The deque keeps the strings in place
+    static std::deque<std::string> names;
+
+    static const char* internName(const std::string& name) {
+        for (const auto& n : names) {
+            if (n == name) { return n.c_str(); }
+        }
+        names.push_back(name);
+        return names.back().c_str();
+    }
+
+    void setEnabled(bool enabled) {
+        profiler::enabled = enabled;
+    }
+
+    bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void registerBlock(const std::string& name, Counters* counters) {
+        std::lock_guard<std::mutex> lck(registryMtx);
+        counters->traceName = internName(name);
+        registry.push_back({ name, counters });
+    }
+
+    void unregisterBlock(Counters* counters) {
+        std::lock_guard<std::mutex> lck(registryMtx);
+        registry.erase(std::remove_if(registry.begin(), registry.end(), [counters](const Entry& e) { return e.counters == counters; }), registry.end());
+    }
+
+    std::vector<Values> getValues() {
+        std::lock_guard<std::mutex> lck(registryMtx);
+        std::vector<Values> values;
+        for (const auto& e : registry) {
+            const Counters* c = e.counters;
+            values.push_back({ e.name, c->runs, c->runTime, c->readWait, c->swapWait, c->samplesIn, c->samplesOut, c->reads, c->readsWaited, c->swaps, c->swapsWaited });
+        }
+        return values;
+    }
+
+    // Ring of the events of a thread. Only its thread writes to it, saving the trace reads it concurrently and keeps
+    // the events that couldn't have been overwritten while they were copied
+    struct ThreadTrace {
+        Event events[PROFILER_TRACE_EVENTS];
+        std::atomic<uint64_t> head = 0;
+    };
+
+    static std::atomic<bool> tracing = false;
+    static std::atomic<uint64_t> traceStart = 0;
+    static std::mutex traceMtx;
+    static std::vector<ThreadTrace*> traces;
+    static std::vector<ThreadTrace*> freeTraces;
+    static uint32_t nextThread = 1;
+
+    // Gives the ring back when the thread exits, blocks start a new thread each time they are restarted
+    struct ThreadSlot {
+        ~ThreadSlot() {
+            if (!trace) { return; }
+            std::lock_guard<std::mutex> lck(traceMtx);
+            freeTraces.push_back(trace);
+        }
+
+        ThreadTrace* trace = NULL;
+        uint32_t thread = 0;
+        bool full = false;
+    };
+
+    static thread_local ThreadSlot slot;
+
+    void setTracing(bool enabled) {
+        if (enabled) { traceStart = now(); }
+        tracing = enabled;
+    }
+
+    bool isTracing() {
+        return tracing.load(std::memory_order_relaxed);
+    }
+
+    void trace(EventType type, const char* name, uint64_t start, uint64_t flow, int count) {
+        uint64_t end = now();
+
+        // Get a ring on the first event of the thread
+        ThreadSlot& s = slot;
+        if (!s.trace) {
+            if (s.full) { return; }
+            std::lock_guard<std::mutex> lck(traceMtx);
+            if (!freeTraces.empty()) {
+                s.trace = freeTraces.back();
+                freeTraces.pop_back();
+            }
+            else if (traces.size() < PROFILER_TRACE_MAX_THREADS) {
+                s.trace = new ThreadTrace;
+                traces.push_back(s.trace);
+            }
+            else {
+                s.full = true;
+                return;
+            }
+            s.thread = nextThread++;
+        }
+
+        ThreadTrace* t = s.trace;
+        uint64_t h = t->head.load(std::memory_order_relaxed);
+        Event& e = t->events[h % PROFILER_TRACE_EVENTS];
+        e.start = start;
+        e.duration = end - start;
+        e.flow = flow;
+        e.name = name;
+        e.thread = s.thread;
+        e.count = count;
+        e.type = type;
+        t->head.store(h + 1, std::memory_order_release);
+    }
+
+    static void writeString(FILE* f, const char* str) {
+        fputc('"', f);
+        for (const char* c = str; *c; c++) {
+            if (*c == '"' || *c == '\\') { fputc('\\', f); }
+            if ((unsigned char)*c < 0x20) { continue; }
+            fputc(*c, f);
+        }
+        fputc('"', f);
+    }
+
+    bool saveTrace(const std::string& path) {
+        // Copy the events of the current trace out of the rings
+        std::vector<Event> events;
+        uint64_t since = traceStart.load();
+        {
+            std::lock_guard<std::mutex> lck(traceMtx);
+            for (ThreadTrace* t : traces) {
+                uint64_t end = t->head.load(std::memory_order_acquire);
+                uint64_t begin = (end > PROFILER_TRACE_EVENTS) ? end - PROFILER_TRACE_EVENTS : 0;
+                std::vector<Event> copy(&t->events[0], &t->events[PROFILER_TRACE_EVENTS]);
+
+                // Events up to the head now minus the ring size may have been overwritten during the copy
+                uint64_t head = t->head.load(std::memory_order_acquire);
+                if (head > PROFILER_TRACE_EVENTS) { begin = std::max<uint64_t>(begin, head - PROFILER_TRACE_EVENTS + 1); }
+                for (uint64_t i = begin; i < end; i++) {
+                    const Event& e = copy[i % PROFILER_TRACE_EVENTS];
+                    if (e.start >= since) { events.push_back(e); }
+                }
+            }
+        }
+        std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+
+        FILE* f = fopen(path.c_str(), "w");
+        if (!f) {
+            flog::error("Could not open {0} to save the DSP trace", path);
+            return false;
+        }
+
+        // Threads are named after the first block or scope seen running on them
+        fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SDR++\"}}");
+        std::vector<uint32_t> named;
+        for (const Event& e : events) {
+            if ((e.type != EVENT_RUN && e.type != EVENT_SCOPE) || std::find(named.begin(), named.end(), e.thread) != named.end()) { continue; }
+            named.push_back(e.thread);
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", e.thread);
+            writeString(f, e.name);
+            fprintf(f, "}}");
+        }
+
+        static const char* categories[] = { "run", "stream", "stream", "scope" };
+        uint64_t base = events.empty() ? 0 : events[0].start;
+        for (const Event& e : events) {
+            double ts = (double)(e.start - base) * 1e-3;
+            double dur = (double)e.duration * 1e-3;
+            fprintf(f, ",\n{\"name\":");
+            writeString(f, e.name);
+            fprintf(f, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"samples\":%d}}",
+                    categories[e.type], ts, dur, e.thread, e.count);
+
+            // A handoff starts when the writer leaves swap() and ends when the reader leaves read()
+            if (e.flow && (e.type == EVENT_SWAP || e.type == EVENT_READ)) {
+                fprintf(f, ",\n{\"name\":\"handoff\",\"cat\":\"stream\",\"ph\":\"%s\",\"id\":\"0x%llx\",\"ts\":%.3f,\"pid\":1,\"tid\":%u%s}",
+                        (e.type == EVENT_SWAP) ? "s" : "f", (unsigned long long)e.flow, ts + dur, e.thread, (e.type == EVENT_READ) ? ",\"bp\":\"e\"" : "");
+            }
+        }
+        fprintf(f, "\n]}\n");
+        bool ok = !ferror(f);
+        fclose(f);
+
+        flog::info("Saved {0} DSP trace events to {1}", events.size(), path);
+        return ok;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace dsp::profiler {
+    // Counters of a profiled block. They are only ever written by the thread running the block, so they are updated
+    // without any locked instruction and can be read at any time from any thread
+    struct Counters {
+        std::atomic<uint64_t> runs = 0;
+        std::atomic<uint64_t> runTime = 0;      // Nanoseconds spent in run(), waits included
+        std::atomic<uint64_t> readWait = 0;     // Nanoseconds spent waiting for input
+        std::atomic<uint64_t> swapWait = 0;     // Nanoseconds spent waiting for room in the outputs
+        std::atomic<uint64_t> samplesIn = 0;
+        std::atomic<uint64_t> samplesOut = 0;   // Summed over all outputs
+        std::atomic<uint64_t> reads = 0;
+        std::atomic<uint64_t> readsWaited = 0;  // Reads that found no data waiting
+        std::atomic<uint64_t> swaps = 0;
+        std::atomic<uint64_t> swapsWaited = 0;  // Swaps that found the output still held by its reader
+        const char* traceName = NULL;           // Name of the block in traces, set on registration
+    };
+
+    // Copy of the counters of a block
+    struct Values {
+        std::string name;
+        uint64_t runs;
+        uint64_t runTime;
+        uint64_t readWait;
+        uint64_t swapWait;
+        uint64_t samplesIn;
+        uint64_t samplesOut;
+        uint64_t reads;
+        uint64_t readsWaited;
+        uint64_t swaps;
+        uint64_t swapsWaited;
+    };
+
+    // Counters of the block being run by the current thread, NULL if it isn't profiled or profiling is disabled.
+    // Streams add their waits and samples to it
+    inline thread_local Counters* current = NULL;
+
+    inline uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Only the thread running the block writes its counters
+    inline void add(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Profiling is off by default, profiled blocks then only check this once per run()
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    void registerBlock(const std::string& name, Counters* counters);
+    void unregisterBlock(Counters* counters);
+
+    // Counters of all profiled blocks, in the order they were registered
+    std::vector<Values> getValues();
+
+    // Tracing records a timeline of the run() of the profiled blocks and of every read and swap of the streams, each
+    // thread keeping its last events in a ring of its own. Swaps and the reads that receive their buffer are linked as
+    // flows, identified by the stream and the index of the first sample of the buffer.
+    enum EventType {
+        EVENT_RUN,
+        EVENT_READ,
+        EVENT_SWAP,
+        EVENT_SCOPE
+    };
+
+    struct Event {
+        uint64_t start;
+        uint64_t duration;
+        uint64_t flow;      // 0 if the event isn't part of a handoff
+        const char* name;   // Must stay valid until the trace is saved
+        uint32_t thread;
+        int32_t count;      // Samples read, swapped or output by run()
+        EventType type;
+    };
+
+    // Tracing is off by default. Enabling it starts a new trace, events recorded before are no longer saved
+    void setTracing(bool enabled);
+    bool isTracing();
+
+    // Record an event that ends now in the ring of the current thread
+    void trace(EventType type, const char* name, uint64_t start, uint64_t flow = 0, int count = 0);
+
+    inline uint64_t flowId(const void* stream, uint64_t sampleIndex) {
+        uint64_t id = ((uint64_t)(uintptr_t)stream * 0x9E3779B97F4A7C15ULL) ^ (sampleIndex + 1);
+        return id ? id : 1;
+    }
+
+    // Write the events of the current trace in the Chrome trace format, which the Perfetto UI also opens
+    bool saveTrace(const std::string& path);
+
+    // Traces the lifetime of the object, for work that isn't a block like a device callback. The name must be a literal
+    class TraceScope {
+    public:
+        TraceScope(const char* name) : name(name) {
+            if (isTracing()) { start = now(); }
+        }
+
+        ~TraceScope() {
+            if (start) { trace(EVENT_SCOPE, name, start); }
+        }
+
+    private:
+        const char* name;
+        uint64_t start = 0;
+    };
+}
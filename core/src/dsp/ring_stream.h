@@ -0,0 +1,264 @@
+#pragma once
+#include <assert.h>
+#include <atomic>
+#include <vector>
+#include "stream.h"
+
+// Default number of buffers in a ring stream
+#define RING_STREAM_DEFAULT_DEPTH 4
+
+namespace dsp {
+    // Single producer / single consumer stream backed by a ring of buffers.
+    // It is a drop-in replacement for stream<T>: the writer fills writeBuf and calls swap(),
+    // the reader calls read(), uses readBuf and then calls flush(). Unlike stream<T>, the writer
+    // can run ahead of the reader by up to depth buffers and both sides only park on a condition
+    // variable when the ring is actually full or empty.
+    template <class T>
+    class ring_stream : public stream<T> {
+    public:
+        ring_stream(int depth = RING_STREAM_DEFAULT_DEPTH, int bufferSize = STREAM_BUFFER_SIZE) : stream<T>(0) {
+            // Release the (empty) double buffer allocated by stream<T>, the ring buffers replace it
+            stream<T>::free();
+            allocSlots(depth, bufferSize);
+        }
+
+        virtual ~ring_stream() {
+            freeSlots();
+        }
+
+        virtual void setBufferSize(int samples) {
+            int depth = slots.size();
+            freeSlots();
+            allocSlots(depth, samples);
+        }
+
+        virtual inline void reserve(int samples) {
+            if (samples <= bufferSize) { return; }
+            bufferSize = samples;
+
+            // The slot currently being written belongs to the writer, the others are grown when they come back
+            int slot = head.load(std::memory_order_relaxed) % slots.size();
+            buffer::free(slots[slot]);
+            slots[slot] = buffer::alloc<T>(samples);
+            slotSizes[slot] = samples;
+            stream<T>::writeBuf = slots[slot];
+            stream<T>::setMaxBlockSize(samples);
+        }
+
+        virtual int getBufferSize() {
+            return bufferSize;
+        }
+
+        // The slots stay with the ring
+        virtual T* takeReadBuf(T* replacement, int& capacity) {
+            return NULL;
+        }
+
+        void setDepth(int depth) {
+            freeSlots();
+            allocSlots(depth, bufferSize);
+        }
+
+        int getDepth() {
+            return slots.size();
+        }
+
+        // Number of buffers written but not yet flushed by the reader
+        int getFill() {
+            return head.load() - tail.load();
+        }
+
+        virtual inline bool swap(int size) {
+            // Publish the buffer that was just written
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
+            uint64_t flow = traceStart ? profiler::flowId(this, stream<T>::writeMeta.sampleIndex) : 0;
+            stream<T>::stampArrival();
+            uint64_t h = head.load(std::memory_order_relaxed);
+            sizes[h % slots.size()] = size;
+            metas[h % slots.size()] = stream<T>::writeMeta;
+            LatencyProbe* probe = stream<T>::latencyProbe;
+            if (probe) { probe->update(stream<T>::writeMeta.arrival); }
+            stream<T>::writeMeta.advance(size);
+            head.store(++h);
+            if (readerWaiting.load()) {
+                { std::lock_guard<std::mutex> lck(rdyMtx); }
+                rdyCV.notify_all();
+            }
+            if (this->readListener.load()) {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                stream_listener* l = this->readListener;
+                if (l) { l->onStreamEvent(); }
+            }
+
+            profiler::Counters* prof = profiler::current;
+            if (prof) {
+                profiler::add(prof->swaps, 1);
+                profiler::add(prof->samplesOut, size);
+            }
+
+            // Wait for the next slot to be released by the reader, or to be stopped
+            if (h - tail.load() >= slots.size() && !writerStop.load()) {
+                uint64_t start = prof ? profiler::now() : 0;
+                std::unique_lock<std::mutex> lck(swapMtx);
+                writerWaiting.store(true);
+                swapCV.wait(lck, [this, h] { return (h - tail.load() < slots.size()) || writerStop.load(); });
+                writerWaiting.store(false);
+                if (prof) {
+                    profiler::add(prof->swapWait, profiler::now() - start);
+                    profiler::add(prof->swapsWaited, 1);
+                }
+            }
+            if (writerStop.load()) { return false; }
+
+            // Grow the slot if the stream was enlarged since it was last written
+            int slot = h % slots.size();
+            if (slotSizes[slot] < bufferSize) {
+                buffer::free(slots[slot]);
+                slots[slot] = buffer::alloc<T>(bufferSize);
+                slotSizes[slot] = bufferSize;
+            }
+
+            stream<T>::writeBuf = slots[slot];
+            if (traceStart) { profiler::trace(profiler::EVENT_SWAP, "swap", traceStart, flow, size); }
+            return true;
+        }
+
+        virtual inline int read() {
+            // Wait for a buffer to be available or to be stopped
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            profiler::Counters* prof = profiler::current;
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
+            if (head.load() == t && !readerStop.load()) {
+                uint64_t start = prof ? profiler::now() : 0;
+                std::unique_lock<std::mutex> lck(rdyMtx);
+                readerWaiting.store(true);
+                rdyCV.wait(lck, [this, t] { return (head.load() != t) || readerStop.load(); });
+                readerWaiting.store(false);
+                if (prof) {
+                    profiler::add(prof->readWait, profiler::now() - start);
+                    profiler::add(prof->readsWaited, 1);
+                }
+            }
+            if (readerStop.load()) { return -1; }
+            if (prof) {
+                profiler::add(prof->reads, 1);
+                profiler::add(prof->samplesIn, sizes[t % slots.size()]);
+            }
+
+            stream<T>::readBuf = slots[t % slots.size()];
+            stream<T>::readMeta = metas[t % slots.size()];
+            if (traceStart) { profiler::trace(profiler::EVENT_READ, "read", traceStart, profiler::flowId(this, stream<T>::readMeta.sampleIndex), sizes[t % slots.size()]); }
+            return sizes[t % slots.size()];
+        }
+
+        virtual inline void flush() {
+            // Release the buffer back to the writer
+            tail.store(tail.load(std::memory_order_relaxed) + 1);
+            if (writerWaiting.load()) {
+                { std::lock_guard<std::mutex> lck(swapMtx); }
+                swapCV.notify_all();
+            }
+            if (this->writeListener.load()) {
+                std::lock_guard<std::mutex> lck(swapMtx);
+                stream_listener* l = this->writeListener;
+                if (l) { l->onStreamEvent(); }
+            }
+        }
+
+        virtual bool canRead() {
+            return head.load() != tail.load();
+        }
+
+        // swap() waits for the next slot after publishing, so one more than the published one must be free
+        virtual bool canWrite() {
+            return head.load() - tail.load() + 1 < slots.size();
+        }
+
+        virtual void setReadListener(stream_listener* listener) {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            this->readListener = listener;
+        }
+
+        virtual void setWriteListener(stream_listener* listener) {
+            std::lock_guard<std::mutex> lck(swapMtx);
+            this->writeListener = listener;
+        }
+
+        virtual void stopWriter() {
+            {
+                std::lock_guard<std::mutex> lck(swapMtx);
+                writerStop = true;
+            }
+            swapCV.notify_all();
+        }
+
+        virtual void clearWriteStop() {
+            writerStop = false;
+        }
+
+        virtual void stopReader() {
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                readerStop = true;
+            }
+            rdyCV.notify_all();
+        }
+
+        virtual void clearReadStop() {
+            readerStop = false;
+        }
+
+    private:
+        void allocSlots(int depth, int samples) {
+            assert(depth >= 2);
+            bufferSize = samples;
+            slots.resize(depth);
+            sizes.resize(depth);
+            metas.resize(depth);
+            slotSizes.assign(depth, samples);
+            for (auto& s : slots) {
+                s = buffer::alloc<T>(samples);
+            }
+            head = 0;
+            tail = 0;
+            stream<T>::writeBuf = slots[0];
+            stream<T>::readBuf = slots[0];
+            stream<T>::setMaxBlockSize(samples);
+        }
+
+        void freeSlots() {
+            for (auto& s : slots) {
+                buffer::free(s);
+            }
+            slots.clear();
+            sizes.clear();
+            metas.clear();
+            slotSizes.clear();
+
+            // Prevent stream<T> from freeing the ring buffers a second time
+            stream<T>::writeBuf = NULL;
+            stream<T>::readBuf = NULL;
+        }
+
+        std::vector<T*> slots;
+        std::vector<int> sizes;
+        std::vector<stream_meta> metas;
+        std::vector<int> slotSizes;
+        int bufferSize;
+
+        // Monotonic counters, the slot index is the counter modulo the depth
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+
+        std::mutex swapMtx;
+        std::condition_variable swapCV;
+        std::atomic<bool> writerWaiting = false;
+
+        std::mutex rdyMtx;
+        std::condition_variable rdyCV;
+        std::atomic<bool> readerWaiting = false;
+
+        std::atomic<bool> readerStop = false;
+        std::atomic<bool> writerStop = false;
+    };
+}
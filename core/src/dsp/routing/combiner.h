@@ -0,0 +1,98 @@
+#pragma once
+#include "../block.h"
+#include "../math/add.h"
+
+// Default maximum number of samples an input may run ahead of the slowest one
+#define COMBINER_DEFAULT_MAX_LAG    1000000
+
+namespace dsp::routing {
+    // Sums streams coming from independent writers, eg. several devices. Each input is queued in its own FIFO
+    // and the output gets as many samples as all inputs have in common. When the clocks of the writers drift
+    // apart, the samples of an input running more than maxLag samples ahead of the slowest one are dropped.
+    template <class T>
+    class Combiner : public block {
+    public:
+        Combiner() {}
+
+        Combiner(const std::vector<stream<T>*>& in, int maxLag = COMBINER_DEFAULT_MAX_LAG) { init(in, maxLag); }
+
+        void init(const std::vector<stream<T>*>& in, int maxLag = COMBINER_DEFAULT_MAX_LAG) {
+            _in = in;
+            _maxLag = maxLag;
+            fifos.resize(_in.size());
+            for (auto& s : _in) { registerInput(s); }
+            registerOutput(&out);
+            _block_init = true;
+        }
+
+        void setInputs(const std::vector<stream<T>*>& in) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            tempStop();
+            for (auto& s : _in) { unregisterInput(s); }
+            _in = in;
+            fifos.clear();
+            fifos.resize(_in.size());
+            for (auto& s : _in) { registerInput(s); }
+            tempStart();
+        }
+
+        // Number of samples dropped to keep the inputs aligned
+        uint64_t getDropped() {
+            return dropped;
+        }
+
+        int run() {
+            if (_in.empty()) { return -1; }
+
+            // Read from the input that is the most behind
+            int id = 0;
+            for (int i = 1; i < _in.size(); i++) {
+                if (fifos[i].size() < fifos[id].size()) { id = i; }
+            }
+            int count = _in[id]->read();
+            if (count < 0) { return -1; }
+            std::vector<T>& fifo = fifos[id];
+            fifo.insert(fifo.end(), _in[id]->readBuf, _in[id]->readBuf + count);
+            gap |= _in[id]->readMeta.discontinuity;
+            _in[id]->flush();
+
+            // Send out what all inputs have
+            int outCount = fifo.size();
+            for (const auto& f : fifos) { outCount = std::min<int>(outCount, f.size()); }
+            if (outCount) {
+                out.reserve(outCount);
+                memcpy(out.writeBuf, fifos[0].data(), outCount * sizeof(T));
+                for (int i = 1; i < fifos.size(); i++) {
+                    math::Add<T>::process(outCount, out.writeBuf, fifos[i].data(), out.writeBuf);
+                }
+                for (auto& f : fifos) { f.erase(f.begin(), f.begin() + outCount); }
+            }
+
+            // Keep the inputs within maxLag of each other
+            for (auto& f : fifos) {
+                if (f.size() <= _maxLag) { continue; }
+                int excess = f.size() - _maxLag;
+                f.erase(f.begin(), f.begin() + excess);
+                dropped += excess;
+                gap = true;
+            }
+
+            if (outCount) {
+                out.writeMeta.discontinuity = gap;
+                gap = false;
+                if (!out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+        stream<T> out;
+
+    private:
+        std::vector<stream<T>*> _in;
+        std::vector<std::vector<T>> fifos;
+        int _maxLag;
+        bool gap = false;
+        std::atomic<uint64_t> dropped = 0;
+    };
+}
@@ -22,6 +22,8 @@ namespace dsp::routing {
 
             memcpy(outA.writeBuf, base_type::_in->readBuf, count * sizeof(T));
             memcpy(outB.writeBuf, base_type::_in->readBuf, count * sizeof(T));
+            outA.writeMeta = base_type::_in->readMeta;
+            outB.writeMeta = base_type::_in->readMeta;
             if (!outA.swap(count)) {
                 base_type::_in->flush();
                 return -1;
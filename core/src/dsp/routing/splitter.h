@@ -1,7 +1,15 @@
 #pragma once
 #include "../sink.h"
+#include "../shared_stream.h"
 
 namespace dsp::routing {
+    // What the splitter does when an output isn't ready to take the next buffer
+    enum Backpressure {
+        BACKPRESSURE_BLOCK,         // Wait for the reader, nothing is lost but a slow reader holds up every output
+        BACKPRESSURE_DROP_OLDEST,   // Keep the latest buffer for when the reader is ready, dropping the one kept before
+        BACKPRESSURE_DROP_NEWEST    // Drop the buffer
+    };
+
     template <class T>
     class Splitter : public Sink<T> {
         using base_type = Sink<T>;
@@ -10,7 +18,25 @@ namespace dsp::routing {
 
         Splitter(stream<T>* in) { base_type::init(in); }
 
-        void bindStream(stream<T>* stream) {
+        ~Splitter() {
+            if (base_type::_block_init) {
+                base_type::stop();
+                for (auto& out : lossyOutputs) {
+                    buffer::free(out->pending);
+                    delete out;
+                }
+            }
+
+            // The buffers still held by shared readers go with the last of them
+            pool->close();
+        }
+
+        // Outputs that may drop buffers never hold up the others and always receive a copy. Shared streams that block
+        // are handed a reference to the input buffer instead, and only hold up the others once their reader is
+        // SHARED_STREAM_DEPTH buffers behind. Other outputs that block get a copy and hold up the others as soon as
+        // their reader is one buffer behind. Outputs are bound and unbound between two buffers, the other outputs keep
+        // receiving theirs, except when run by a scheduler which reads the outputs on its own
+        void bindStream(stream<T>* stream, Backpressure policy = BACKPRESSURE_BLOCK) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             
@@ -19,11 +45,33 @@ namespace dsp::routing {
                 throw std::runtime_error("[Splitter] Tried to bind stream to that is already bound");
             }
 
-            // Add to the list
-            base_type::tempStop();
-            base_type::registerOutput(stream);
-            streams.push_back(stream);
-            base_type::tempStart();
+            // Shared streams get a reference to the input buffer instead of a copy
+            shared_stream<T>* shared = dynamic_cast<shared_stream<T>*>(stream);
+            LossyOutput* out = NULL;
+            if (policy != BACKPRESSURE_BLOCK) {
+                out = new LossyOutput;
+                out->output = stream;
+                out->policy = policy;
+            }
+
+            // Add to the lists
+            bool scheduled = base_type::scheduledOn;
+            if (scheduled) { base_type::tempStop(); }
+            {
+                std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+                base_type::registerOutput(stream);
+                streams.push_back(stream);
+                if (out) {
+                    lossyOutputs.push_back(out);
+                }
+                else if (shared) {
+                    sharedStreams.push_back(shared);
+                }
+                else {
+                    copyStreams.push_back(stream);
+                }
+            }
+            if (scheduled) { base_type::tempStart(); }
         }
 
         void unbindStream(stream<T>* stream) {
@@ -36,32 +84,208 @@ namespace dsp::routing {
                 throw std::runtime_error("[Splitter] Tried to unbind stream to that isn't bound");
             }
 
-            // Add to the list
-            base_type::tempStop();
-            streams.erase(sit);
-            base_type::unregisterOutput(stream);
-            base_type::tempStart();
+            bool scheduled = base_type::scheduledOn;
+            if (scheduled) { base_type::tempStop(); }
+
+            // The worker may be waiting for the reader of the stream, which may never come back. Stopping the stream
+            // releases it and it then skips the stream instead of stopping
+            removing = stream;
+            stream->stopWriter();
+
+            // Remove from the lists
+            LossyOutput* removed = NULL;
+            {
+                std::lock_guard<std::mutex> lck2(base_type::paramMtx);
+                streams.erase(std::find(streams.begin(), streams.end(), stream));
+                copyStreams.erase(std::remove(copyStreams.begin(), copyStreams.end(), stream), copyStreams.end());
+                sharedStreams.erase(std::remove(sharedStreams.begin(), sharedStreams.end(), stream), sharedStreams.end());
+                for (auto it = lossyOutputs.begin(); it != lossyOutputs.end(); it++) {
+                    if ((*it)->output != stream) { continue; }
+                    removed = *it;
+                    lossyOutputs.erase(it);
+                    break;
+                }
+                base_type::unregisterOutput(stream);
+            }
+            stream->clearWriteStop();
+            removing = NULL;
+
+            // The buffers queued for a shared stream go back to the others
+            shared_stream<T>* shared = dynamic_cast<shared_stream<T>*>(stream);
+            if (shared) { shared->dropQueued(); }
+
+            if (removed) {
+                buffer::free(removed->pending);
+                delete removed;
+            }
+            if (scheduled) { base_type::tempStart(); }
+        }
+
+        // Number of buffers dropped for an output since it was bound, always 0 for outputs that block
+        uint64_t getDrops(stream<T>* stream) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            for (const auto& out : lossyOutputs) {
+                if (out->output == stream) { return out->drops; }
+            }
+            return 0;
         }
 
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            std::lock_guard<std::mutex> lck(base_type::paramMtx);
+
+            // The shared streams get a reference to the input buffer, taken over from the input so that it can be
+            // flushed right away, the writer of the input getting a recycled buffer in its place. An input that keeps
+            // its buffers is copied into one instead
+            const T* data = base_type::_in->readBuf;
+            stream_meta meta = base_type::_in->readMeta;
+            shared_buffer<T>* shared = NULL;
+            if (!sharedStreams.empty()) {
+                shared = take(count);
+                shared->refs = 1;
+                data = shared->data;
+                base_type::_in->flush();
+                for (const auto& stream : sharedStreams) {
+                    stream->writeMeta = meta;
+                    if (!stream->publish(shared, count) && stream != removing) {
+                        shared->release();
+                        return -1;
+                    }
+                }
+            }
+
+            // Outputs that may drop never wait, the splitter being their only writer a stream that can be written
+            // to stays so until it is
+            for (const auto& out : lossyOutputs) {
+                if (out->pendingCount && out->output->canWrite()) {
+                    if (!deliver(out, out->pending, out->pendingCount, out->pendingMeta) && out->output != removing) {
+                        return fail(shared);
+                    }
+                    out->pendingCount = 0;
+                }
+
+                if (out->output->canWrite()) {
+                    if (!deliver(out, data, count, meta) && out->output != removing) {
+                        return fail(shared);
+                    }
+                }
+                else if (out->policy == BACKPRESSURE_DROP_OLDEST) {
+                    if (out->pendingCount) {
+                        out->drops++;
+                        out->dropped = true;
+                    }
+                    if (count > out->pendingCapacity) {
+                        buffer::free(out->pending);
+                        out->pending = buffer::alloc<T>(count);
+                        out->pendingCapacity = count;
+                    }
+                    memcpy(out->pending, data, count * sizeof(T));
+                    out->pendingCount = count;
+                    out->pendingMeta = meta;
+                }
+                else {
+                    out->drops++;
+                    out->dropped = true;
+                }
+            }
 
-            for (const auto& stream : streams) {
-                memcpy(stream->writeBuf, base_type::_in->readBuf, count * sizeof(T));
-                if (!stream->swap(count)) {
-                    base_type::_in->flush();
-                    return -1;
+            for (const auto& stream : copyStreams) {
+                stream->reserve(count);
+                memcpy(stream->writeBuf, data, count * sizeof(T));
+                stream->writeMeta = meta;
+                if (!stream->swap(count) && stream != removing) {
+                    return fail(shared);
                 }
             }
 
-            base_type::_in->flush();
+            // The shared buffer is recycled once the last shared reader flushes it
+            if (shared) {
+                shared->release();
+            }
+            else {
+                base_type::_in->flush();
+            }
 
             return count;
         }
 
     protected:
+        struct LossyOutput {
+            stream<T>* output;
+            Backpressure policy;
+            std::atomic<uint64_t> drops = 0;
+            bool dropped = false;   // The next buffer output follows a drop
+
+            // Buffer kept until the reader is ready when dropping the oldest
+            T* pending = NULL;
+            int pendingCapacity = 0;
+            int pendingCount = 0;
+            stream_meta pendingMeta;
+        };
+
+        // Shared buffer holding the input buffer, taken over from the input or copied if it can't be
+        shared_buffer<T>* take(int count) {
+            shared_buffer<T>* buf = pool->acquire();
+            int capacity = buf->capacity;
+            T* replacement = buf->data;
+            if (!replacement) {
+                capacity = base_type::_in->getBufferSize();
+                replacement = buffer::alloc<T>(capacity);
+            }
+            T* taken = base_type::_in->takeReadBuf(replacement, capacity);
+            if (taken) {
+                buf->data = taken;
+                buf->capacity = capacity;
+                return buf;
+            }
+
+            // The replacement stays with the shared buffer
+            if (capacity < count) {
+                buffer::free(replacement);
+                capacity = count;
+                replacement = buffer::alloc<T>(capacity);
+            }
+            buf->data = replacement;
+            buf->capacity = capacity;
+            memcpy(buf->data, base_type::_in->readBuf, count * sizeof(T));
+            return buf;
+        }
+
+        // Let go of the input after an output was stopped
+        int fail(shared_buffer<T>* shared) {
+            if (shared) {
+                shared->release();
+            }
+            else {
+                base_type::_in->flush();
+            }
+            return -1;
+        }
+
+        // Copy a buffer to a lossy output, flagged as a discontinuity after a drop
+        bool deliver(LossyOutput* out, const T* data, int count, const stream_meta& meta) {
+            out->output->reserve(count);
+            memcpy(out->output->writeBuf, data, count * sizeof(T));
+            out->output->writeMeta = meta;
+            if (out->dropped) {
+                out->output->writeMeta.discontinuity = true;
+                out->dropped = false;
+            }
+            return out->output->swap(count);
+        }
+
         std::vector<stream<T>*> streams;
+        std::vector<stream<T>*> copyStreams;
+        std::vector<shared_stream<T>*> sharedStreams;
+        std::vector<LossyOutput*> lossyOutputs;
+
+        // Output being unbound, whose writes fail until it's removed
+        std::atomic<stream<T>*> removing = NULL;
+
+        // Buffers taken over from the input while the shared streams read them
+        shared_buffer_pool<T>* pool = new shared_buffer_pool<T>;
 
     };
 }
\ No newline at end of file
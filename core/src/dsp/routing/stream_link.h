@@ -31,6 +31,7 @@ namespace dsp::routing {
             if (count < 0) { return -1; }
 
             memcpy(_out->writeBuf, base_type::_in->readBuf, count * sizeof(T));
+            _out->writeMeta = base_type::_in->readMeta;
 
             base_type::_in->flush();
             if (!_out->swap(count)) { return -1; }
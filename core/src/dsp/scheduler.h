@@ -0,0 +1,246 @@
+#pragma once
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include "stream.h"
+#include "thread_role.h"
+
+// Maximum number of consecutive executions of a task before it goes back in the queue
+#define SCHEDULER_TASK_BUDGET   16
+
+namespace dsp {
+    // Fixed pool of worker threads running blocks as tasks instead of giving each block its own thread.
+    // A task is queued whenever one of its streams changes state and only executed if it is ready, that
+    // is if its inputs have data and its outputs have room, so that a unit of work never has to park.
+    // Each worker has its own queue, idle workers steal work from the others.
+    class Scheduler {
+    public:
+        class Task : public stream_listener {
+            friend Scheduler;
+        public:
+            virtual ~Task() {}
+
+            // Check if the task can do work without blocking
+            virtual bool ready() = 0;
+
+            // Do one unit of work, returns a negative value if the task was stopped
+            virtual int execute() = 0;
+
+            void onStreamEvent() {
+                Scheduler* s = sched;
+                if (s) { s->notify(this); }
+            }
+
+        private:
+            enum State {
+                IDLE,
+                QUEUED,
+                RUNNING,
+                RUN_AGAIN
+            };
+
+            std::atomic<int> state = IDLE;
+            std::atomic<bool> detaching = false;
+            Scheduler* sched = NULL;
+        };
+
+        // The workers apply the policy of the given role, which is that of the blocks they run
+        Scheduler(int threadCount = 0, ThreadRole role = THREAD_ROLE_NONE) {
+            this->role = role;
+            if (threadCount <= 0) {
+                threadCount = std::max<int>(std::thread::hardware_concurrency(), 1);
+            }
+            queues = std::vector<Queue>(threadCount);
+            for (int i = 0; i < threadCount; i++) {
+                workers.push_back(std::thread(&Scheduler::worker, this, i));
+            }
+        }
+
+        ~Scheduler() {
+            {
+                std::lock_guard<std::mutex> lck(parkMtx);
+                stopWorkers = true;
+            }
+            parkCV.notify_all();
+            for (auto& w : workers) {
+                if (w.joinable()) { w.join(); }
+            }
+        }
+
+        int getThreadCount() {
+            return workers.size();
+        }
+
+        // Start scheduling a task
+        void attach(Task* task) {
+            assert(!task->sched);
+            task->detaching = false;
+            task->state = Task::IDLE;
+            task->sched = this;
+
+            // The task may already be ready
+            notify(task);
+        }
+
+        // Stop scheduling a task, waits for it to finish executing if it is.
+        // The task must already be unregistered from its streams so that it can't be notified anymore
+        void detach(Task* task) {
+            assert(task->sched == this);
+            task->detaching = true;
+
+            // Remove it from the queues
+            for (auto& q : queues) {
+                std::lock_guard<std::mutex> lck(q.mtx);
+                auto it = std::find(q.tasks.begin(), q.tasks.end(), task);
+                if (it == q.tasks.end()) { continue; }
+                q.tasks.erase(it);
+                pending--;
+                std::lock_guard<std::mutex> lck2(doneMtx);
+                task->state = Task::IDLE;
+            }
+
+            // Wait for a worker to be done with it
+            {
+                std::unique_lock<std::mutex> lck(doneMtx);
+                doneCV.wait(lck, [task] { return task->state == Task::IDLE; });
+            }
+
+            task->sched = NULL;
+        }
+
+        // Signal that a task might be ready
+        void notify(Task* task) {
+            if (task->detaching) { return; }
+            while (true) {
+                int state = task->state;
+                if (state == Task::IDLE) {
+                    if (task->state.compare_exchange_weak(state, Task::QUEUED)) {
+                        enqueue(task);
+                        return;
+                    }
+                }
+                else if (state == Task::RUNNING) {
+                    if (task->state.compare_exchange_weak(state, Task::RUN_AGAIN)) { return; }
+                }
+                else {
+                    // Already queued or going to be run again
+                    return;
+                }
+            }
+        }
+
+    private:
+        struct Queue {
+            std::mutex mtx;
+            std::deque<Task*> tasks;
+        };
+
+        void enqueue(Task* task) {
+            // Prefer the queue of the current worker to keep the data in its cache
+            int id = (currentScheduler == this) ? currentWorker : (int)(nextQueue++ % queues.size());
+            {
+                std::lock_guard<std::mutex> lck(queues[id].mtx);
+                queues[id].tasks.push_back(task);
+            }
+            {
+                std::lock_guard<std::mutex> lck(parkMtx);
+                pending++;
+            }
+            parkCV.notify_one();
+        }
+
+        Task* dequeue(int id) {
+            // Take from the front of our own queue first
+            {
+                std::lock_guard<std::mutex> lck(queues[id].mtx);
+                if (!queues[id].tasks.empty()) {
+                    Task* task = queues[id].tasks.front();
+                    queues[id].tasks.pop_front();
+                    pending--;
+                    return task;
+                }
+            }
+
+            // Otherwise steal from the back of the others
+            for (int i = 1; i < queues.size(); i++) {
+                Queue& q = queues[(id + i) % queues.size()];
+                std::lock_guard<std::mutex> lck(q.mtx);
+                if (q.tasks.empty()) { continue; }
+                Task* task = q.tasks.back();
+                q.tasks.pop_back();
+                pending--;
+                return task;
+            }
+
+            return NULL;
+        }
+
+        void worker(int id) {
+            currentScheduler = this;
+            currentWorker = id;
+            applyThreadRole(role);
+
+            while (true) {
+                // Wait for work
+                Task* task = dequeue(id);
+                if (!task) {
+                    std::unique_lock<std::mutex> lck(parkMtx);
+                    parkCV.wait(lck, [this] { return pending > 0 || stopWorkers; });
+                    if (stopWorkers) { return; }
+                    continue;
+                }
+
+                int state = Task::QUEUED;
+                if (!task->state.compare_exchange_strong(state, Task::RUNNING)) { continue; }
+
+                // Run the task as long as it has work to do, but give other tasks a chance once in a while
+                int budget = SCHEDULER_TASK_BUDGET;
+                while (!task->detaching && task->ready()) {
+                    task->state = Task::RUNNING;
+                    if (task->execute() < 0) { break; }
+                    if (!--budget) {
+                        task->state = Task::RUN_AGAIN;
+                        break;
+                    }
+                }
+
+                // Go back to idle unless something happened while running
+                if (!task->detaching) {
+                    state = Task::RUNNING;
+                    if (task->state.compare_exchange_strong(state, Task::IDLE)) { continue; }
+                    task->state = Task::QUEUED;
+                    enqueue(task);
+                    continue;
+                }
+
+                // Let a detach in progress know that the task is not running anymore
+                {
+                    std::lock_guard<std::mutex> lck(doneMtx);
+                    task->state = Task::IDLE;
+                }
+                doneCV.notify_all();
+            }
+        }
+
+        std::vector<Queue> queues;
+        std::vector<std::thread> workers;
+        std::atomic<unsigned int> nextQueue = 0;
+        ThreadRole role;
+
+        std::mutex parkMtx;
+        std::condition_variable parkCV;
+        std::atomic<int> pending = 0;
+        bool stopWorkers = false;
+
+        std::mutex doneMtx;
+        std::condition_variable doneCV;
+
+        static inline thread_local Scheduler* currentScheduler = NULL;
+        static inline thread_local int currentWorker = 0;
+    };
+}
@@ -0,0 +1,376 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "stream.h"
+
+// Buffers published to a shared stream that its reader hasn't flushed yet. Bounds how far a reader can fall behind
+// the writer of reference counted buffers before the writer has to wait for it
+#define SHARED_STREAM_DEPTH 3
+
+namespace dsp {
+    template <class T>
+    class shared_buffer_pool;
+
+    // Buffer handed to several shared streams at once, recycled into its pool when the last of them flushes it
+    template <class T>
+    struct shared_buffer {
+        T* data = NULL;
+        int capacity = 0;
+        std::atomic<int> refs = 0;
+        shared_buffer_pool<T>* pool = NULL;
+
+        // Drop a reference, the last one gives the buffer back to its pool
+        void release() {
+            if (--refs > 0) { return; }
+            pool->recycle(this);
+        }
+    };
+
+    // Recycles the shared buffers of a writer so that the readers holding them never cost an allocation. The writer
+    // closes the pool instead of deleting it, the buffers still held by readers then being freed by the last of them
+    template <class T>
+    class shared_buffer_pool {
+        friend shared_buffer<T>;
+    public:
+        // Buffer with no reference, keeping the data it had when it was recycled
+        shared_buffer<T>* acquire() {
+            std::lock_guard<std::mutex> lck(mtx);
+            outstanding++;
+            if (freeBuffers.empty()) {
+                shared_buffer<T>* buf = new shared_buffer<T>;
+                buf->pool = this;
+                return buf;
+            }
+            shared_buffer<T>* buf = freeBuffers.back();
+            freeBuffers.pop_back();
+            return buf;
+        }
+
+        void close() {
+            bool last;
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                closed = true;
+                for (auto& buf : freeBuffers) { destroy(buf); }
+                freeBuffers.clear();
+                last = !outstanding;
+            }
+            if (last) { delete this; }
+        }
+
+    private:
+        void recycle(shared_buffer<T>* buf) {
+            bool last;
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                outstanding--;
+                if (!closed) {
+                    freeBuffers.push_back(buf);
+                    return;
+                }
+                destroy(buf);
+                last = !outstanding;
+            }
+            if (last) { delete this; }
+        }
+
+        static void destroy(shared_buffer<T>* buf) {
+            buffer::free(buf->data);
+            delete buf;
+        }
+
+        std::mutex mtx;
+        std::vector<shared_buffer<T>*> freeBuffers;
+        int outstanding = 0;
+        bool closed = false;
+    };
+
+    // Stream whose reader can be handed a buffer owned by someone else instead of a copy.
+    // The owner calls publish() with a pointer to its data, the reader consumes it through the
+    // usual read()/readBuf/flush() sequence and the owner waits in waitReleased() until flush()
+    // before recycling the buffer. This lets a single block be fanned out to several readers
+    // without copying it. When written to through swap(), it behaves like a regular stream<T>.
+    // A shared_buffer can be published instead, which the stream queues and releases on flush(),
+    // so that the writer only waits for a reader more than SHARED_STREAM_DEPTH buffers behind
+    // (see routing::Splitter).
+    template <class T>
+    class shared_stream : public stream<T> {
+    public:
+        shared_stream(int bufferSize = STREAM_BUFFER_SIZE) : stream<T>(bufferSize) {
+            spareBuf = stream<T>::readBuf;
+            writeBufSize = bufferSize;
+            spareBufSize = bufferSize;
+        }
+
+        virtual ~shared_stream() {
+            // readBuf may point to a buffer owned by someone else, only free our own
+            stream<T>::readBuf = spareBuf;
+            for (auto& e : queue) {
+                if (e.shared) { e.shared->release(); }
+            }
+        }
+
+        virtual void setBufferSize(int samples) {
+            stream<T>::readBuf = spareBuf;
+            stream<T>::setBufferSize(samples);
+            spareBuf = stream<T>::readBuf;
+            writeBufSize = samples;
+            spareBufSize = samples;
+        }
+
+        virtual inline void reserve(int samples) {
+            if (samples <= maxSize) { return; }
+            maxSize = samples;
+
+            // The spare buffer may still be held by the reader, it is grown in swap()
+            if (writeBufSize < samples) {
+                buffer::free(stream<T>::writeBuf);
+                stream<T>::writeBuf = buffer::alloc<T>(samples);
+                writeBufSize = samples;
+            }
+        }
+
+        virtual int getBufferSize() {
+            return std::max<int>(maxSize, stream<T>::getBufferSize());
+        }
+
+        // The buffer being read may belong to someone else
+        virtual T* takeReadBuf(T* replacement, int& capacity) {
+            return NULL;
+        }
+
+        // Hand a buffer to the reader without copying. The buffer must stay valid and unmodified until waitReleased() returns.
+        // The buffer is described by writeMeta, as with swap()
+        inline bool publish(T* data, int size) {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                if (writerStop) { return false; }
+                held = true;
+            }
+            enqueue(data, size, NULL);
+            return true;
+        }
+
+        // Queue a reference to a shared buffer for the reader, released when it flushes it. Only waits if the reader
+        // is SHARED_STREAM_DEPTH buffers behind, returns false without taking the reference if the writer was stopped
+        inline bool publish(shared_buffer<T>* buf, int size) {
+            {
+                std::unique_lock<std::mutex> lck(rdyMtx);
+                if (queue.size() >= SHARED_STREAM_DEPTH && !writerStop) {
+                    uint64_t start = profiler::current ? profiler::now() : 0;
+                    roomCV.wait(lck, [this] { return queue.size() < SHARED_STREAM_DEPTH || writerStop; });
+                    if (start) {
+                        profiler::add(profiler::current->swapWait, profiler::now() - start);
+                        profiler::add(profiler::current->swapsWaited, 1);
+                    }
+                }
+                if (writerStop) { return false; }
+            }
+            buf->refs++;
+            enqueue(buf->data, size, buf);
+            return true;
+        }
+
+        // Release the shared buffers queued but not yet being read, for when the writer lets go of the stream
+        void dropQueued() {
+            std::vector<shared_buffer<T>*> dropped;
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                auto first = queue.begin() + (reading ? 1 : 0);
+                for (auto it = first; it != queue.end(); it++) {
+                    if (it->shared) { dropped.push_back(it->shared); }
+                }
+                queue.erase(first, queue.end());
+            }
+            roomCV.notify_all();
+            for (auto& buf : dropped) { buf->release(); }
+        }
+
+        // Wait for the reader to flush the last published buffer, returns false if the writer was stopped
+        inline bool waitReleased() {
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
+            std::unique_lock<std::mutex> lck(mtx);
+            profiler::Counters* prof = profiler::current;
+            if (prof && held && !writerStop) {
+                uint64_t start = profiler::now();
+                releaseCV.wait(lck, [this] { return (!held || writerStop); });
+                profiler::add(prof->swapWait, profiler::now() - start);
+                profiler::add(prof->swapsWaited, 1);
+            }
+            else {
+                releaseCV.wait(lck, [this] { return (!held || writerStop); });
+            }
+            if (traceStart) { profiler::trace(profiler::EVENT_SWAP, "wait released", traceStart); }
+            return !writerStop;
+        }
+
+        virtual inline bool swap(int size) {
+            // Wait for the reader to be done with the previous buffer
+            if (!waitReleased()) { return false; }
+
+            // Hand the written buffer to the reader and write into the spare one next
+            T* temp = stream<T>::writeBuf;
+            stream<T>::writeBuf = spareBuf;
+            spareBuf = temp;
+            std::swap(writeBufSize, spareBufSize);
+            if (writeBufSize < maxSize) {
+                buffer::free(stream<T>::writeBuf);
+                stream<T>::writeBuf = buffer::alloc<T>(maxSize);
+                writeBufSize = maxSize;
+            }
+            return publish(temp, size);
+        }
+
+        virtual inline int read() {
+            // Wait for data to be ready or to be stopped
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
+            std::unique_lock<std::mutex> lck(rdyMtx);
+            profiler::Counters* prof = profiler::current;
+            if (prof && queue.empty() && !readerStop) {
+                uint64_t start = profiler::now();
+                rdyCV.wait(lck, [this] { return (!queue.empty() || readerStop); });
+                profiler::add(prof->readWait, profiler::now() - start);
+                profiler::add(prof->readsWaited, 1);
+            }
+            else {
+                rdyCV.wait(lck, [this] { return (!queue.empty() || readerStop); });
+            }
+
+            if (readerStop) { return -1; }
+            Entry& e = queue.front();
+            stream<T>::readBuf = e.data;
+            stream<T>::readMeta = e.meta;
+            reading = true;
+            if (prof) {
+                profiler::add(prof->reads, 1);
+                profiler::add(prof->samplesIn, e.size);
+            }
+            if (traceStart) { profiler::trace(profiler::EVENT_READ, "read", traceStart, profiler::flowId(this, e.meta.sampleIndex), e.size); }
+            return e.size;
+        }
+
+        virtual inline void flush() {
+            // Take the buffer off the queue
+            Entry e = {};
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                if (!reading) { return; }
+                e = queue.front();
+                queue.pop_front();
+                reading = false;
+            }
+            roomCV.notify_all();
+
+            // Release the buffer to its owner
+            if (e.shared) { e.shared->release(); }
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                if (!e.shared) { held = false; }
+                stream_listener* l = this->writeListener;
+                if (l) { l->onStreamEvent(); }
+            }
+            releaseCV.notify_all();
+        }
+
+        virtual bool canRead() {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            return !queue.empty();
+        }
+
+        virtual bool canWrite() {
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                if (queue.size() >= SHARED_STREAM_DEPTH) { return false; }
+            }
+            std::lock_guard<std::mutex> lck(mtx);
+            return !held;
+        }
+
+        virtual void setReadListener(stream_listener* listener) {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            this->readListener = listener;
+        }
+
+        virtual void setWriteListener(stream_listener* listener) {
+            std::lock_guard<std::mutex> lck(mtx);
+            this->writeListener = listener;
+        }
+
+        virtual void stopWriter() {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                writerStop = true;
+            }
+            releaseCV.notify_all();
+            { std::lock_guard<std::mutex> lck(rdyMtx); }
+            roomCV.notify_all();
+        }
+
+        virtual void clearWriteStop() {
+            writerStop = false;
+        }
+
+        virtual void stopReader() {
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                readerStop = true;
+            }
+            rdyCV.notify_all();
+        }
+
+        virtual void clearReadStop() {
+            readerStop = false;
+        }
+
+    private:
+        struct Entry {
+            T* data;
+            int size;
+            stream_meta meta;
+            shared_buffer<T>* shared;   // NULL for a buffer the writer waits on with waitReleased()
+        };
+
+        void enqueue(T* data, int size, shared_buffer<T>* shared) {
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
+            profiler::Counters* prof = profiler::current;
+            if (prof) {
+                profiler::add(prof->swaps, 1);
+                profiler::add(prof->samplesOut, size);
+            }
+
+            uint64_t flow = traceStart ? profiler::flowId(this, stream<T>::writeMeta.sampleIndex) : 0;
+            stream<T>::stampArrival();
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                queue.push_back({ data, size, stream<T>::writeMeta, shared });
+                stream<T>::writeMeta.advance(size);
+                LatencyProbe* probe = stream<T>::latencyProbe;
+                if (probe) { probe->update(queue.back().meta.arrival); }
+                stream_listener* l = this->readListener;
+                if (l) { l->onStreamEvent(); }
+            }
+            rdyCV.notify_all();
+
+            if (traceStart) { profiler::trace(profiler::EVENT_SWAP, "publish", traceStart, flow, size); }
+        }
+
+        T* spareBuf;
+        int writeBufSize;
+        int spareBufSize;
+        int maxSize = 0;
+
+        std::mutex mtx;
+        std::condition_variable releaseCV;
+        bool held = false;
+
+        std::mutex rdyMtx;
+        std::condition_variable rdyCV;
+        std::condition_variable roomCV;
+        std::deque<Entry> queue;
+        bool reading = false;
+
+        bool readerStop = false;
+        std::atomic<bool> writerStop = false;
+    };
+}
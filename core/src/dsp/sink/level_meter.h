@@ -0,0 +1,162 @@
+#pragma once
+#include "../sink.h"
+#include <atomic>
+#include <algorithm>
+#include <math.h>
+#include <volk/volk.h>
+
+// Entries of the level history, ten seconds at a hundred entries per second
+#define LEVEL_METER_HISTORY     1024
+
+namespace dsp::sink {
+    // Peak and RMS levels of a float, complex or stereo stream, computed once per block with volk and published as a
+    // history of one entry per decimation samples. Any number of readers follow the history with cursors of their own,
+    // so that meters drawn every frame and the metrics endpoint don't reset each other's levels or touch the samples
+    template <class T>
+    class LevelMeter : public Sink<T> {
+        using base_type = Sink<T>;
+    public:
+        static constexpr int CHANNELS = std::is_same_v<T, float> ? 1 : 2;
+
+        // Linear levels of each channel, the real and imaginary parts of a complex stream being two channels
+        struct Level {
+            float peak[CHANNELS];
+            float rms[CHANNELS];
+        };
+
+        LevelMeter() {}
+
+        LevelMeter(stream<T>* in, int decimation = 1024) { init(in, decimation); }
+
+        ~LevelMeter() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            for (int c = 0; c < CHANNELS; c++) { buffer::free(chanBuf[c]); }
+            buffer::free(squares);
+        }
+
+        void init(stream<T>* in, int decimation = 1024) {
+            _decimation = std::max<int>(decimation, 1);
+            for (int c = 0; c < CHANNELS; c++) { chanBuf[c] = buffer::alloc<float>(STREAM_BUFFER_SIZE); }
+            squares = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+            clearAccumulator();
+            base_type::init(in);
+        }
+
+        // Number of samples summed up by each entry of the history
+        void setDecimation(int decimation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _decimation = std::max<int>(decimation, 1);
+            clearAccumulator();
+            base_type::tempStart();
+        }
+
+        // Combine the entries published since the cursor: the highest peak and the RMS over all of them. Returns false
+        // and leaves lvl untouched if there were none. Entries that were overwritten since are skipped
+        bool read(Level& lvl, uint64_t& cursor) {
+            uint64_t end = written.load(std::memory_order_acquire);
+            uint64_t begin = std::max<uint64_t>(cursor, (end > LEVEL_METER_HISTORY) ? (end - LEVEL_METER_HISTORY) : 0);
+            cursor = end;
+            if (begin >= end) { return false; }
+
+            float peak[CHANNELS] = {};
+            float power[CHANNELS] = {};
+            for (uint64_t i = begin; i < end; i++) {
+                const Entry& e = history[i % LEVEL_METER_HISTORY];
+                for (int c = 0; c < CHANNELS; c++) {
+                    peak[c] = std::max<float>(peak[c], e.peak[c].load(std::memory_order_relaxed));
+                    float rms = e.rms[c].load(std::memory_order_relaxed);
+                    power[c] += rms * rms;
+                }
+            }
+            for (int c = 0; c < CHANNELS; c++) {
+                lvl.peak[c] = peak[c];
+                lvl.rms[c] = sqrtf(power[c] / (float)(end - begin));
+            }
+            return true;
+        }
+
+        // Position of the newest entry, for a reader to only follow what comes next
+        uint64_t getCursor() { return written.load(std::memory_order_acquire); }
+
+        int process(int count, const T* in) {
+            // Split the channels to work on each with volk
+            const float* chans[CHANNELS];
+            if constexpr (CHANNELS == 1) {
+                chans[0] = in;
+            }
+            else {
+                volk_32fc_deinterleave_32f_x2(chanBuf[0], chanBuf[1], (const lv_32fc_t*)in, count);
+                chans[0] = chanBuf[0];
+                chans[1] = chanBuf[1];
+            }
+
+            // Cut the block at the entry boundaries
+            for (int i = 0; i < count;) {
+                int n = std::min<int>(count - i, _decimation - accCount);
+                for (int c = 0; c < CHANNELS; c++) {
+                    volk_32f_x2_multiply_32f(squares, &chans[c][i], &chans[c][i], n);
+                    uint32_t idx;
+                    float sum;
+                    volk_32f_index_max_32u(&idx, squares, n);
+                    volk_32f_accumulator_s32f(&sum, squares, n);
+                    accPeak[c] = std::max<float>(accPeak[c], squares[idx]);
+                    accPower[c] += sum;
+                }
+                accCount += n;
+                i += n;
+                if (accCount >= _decimation) { publish(); }
+            }
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            process(count, base_type::_in->readBuf);
+
+            base_type::_in->flush();
+            return count;
+        }
+
+    protected:
+        struct Entry {
+            std::atomic<float> peak[CHANNELS];
+            std::atomic<float> rms[CHANNELS];
+        };
+
+        void publish() {
+            uint64_t pos = written.load(std::memory_order_relaxed);
+            Entry& e = history[pos % LEVEL_METER_HISTORY];
+            for (int c = 0; c < CHANNELS; c++) {
+                e.peak[c].store(sqrtf(accPeak[c]), std::memory_order_relaxed);
+                e.rms[c].store(sqrtf((float)(accPower[c] / (double)accCount)), std::memory_order_relaxed);
+            }
+            written.store(pos + 1, std::memory_order_release);
+            clearAccumulator();
+        }
+
+        void clearAccumulator() {
+            for (int c = 0; c < CHANNELS; c++) {
+                accPeak[c] = 0.0f;
+                accPower[c] = 0.0;
+            }
+            accCount = 0;
+        }
+
+        int _decimation = 1024;
+        float* chanBuf[CHANNELS] = {};
+        float* squares = NULL;
+
+        // Entry being summed up, squared values
+        float accPeak[CHANNELS];
+        double accPower[CHANNELS];
+        int accCount = 0;
+
+        Entry history[LEVEL_METER_HISTORY];
+        std::atomic<uint64_t> written = 0;
+    };
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include "../sink.h"
+
+// Time over which the fill level is watched before correcting the resampling ratio, in seconds
+#define PLAYOUT_WINDOW_TIME         0.25
+
+// Time over which the excess of fill level seen by a window is drained, in seconds
+#define PLAYOUT_DRAIN_TIME          2.0
+
+// Largest correction of the resampling ratio, 0.5% is well under what can be heard on speech
+#define PLAYOUT_MAX_CORRECTION      0.005
+
+// Decay of the margin added by underruns on each window, halving it in about 8 seconds
+#define PLAYOUT_MARGIN_DECAY        0.98
+
+namespace dsp::sink {
+    // Low latency buffer between the DSP and the callback of an audio device. The samples are written into a single
+    // producer single consumer FIFO that the callback reads without ever blocking. The fill level is kept just above
+    // what the jitter of the callbacks and of the DSP blocks requires: the lowest fill level of each window is compared
+    // to a margin derived from the measured callback jitter, and the difference is drained or filled up by slightly
+    // changing the ratio of a cubic fractional resampler. This also absorbs the drift between the clock of the source
+    // and the clock of the audio device, so that the latency stays bounded without underruns.
+    template <class T>
+    class Playout : public Sink<T> {
+        using base_type = Sink<T>;
+    public:
+        Playout() {}
+
+        Playout(stream<T>* in, double samplerate, double minLatency, double maxLatency) { init(in, samplerate, minLatency, maxLatency); }
+
+        ~Playout() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(fifo);
+        }
+
+        // The latencies are in seconds, the FIFO never holds more than maxLatency
+        void init(stream<T>* in, double samplerate, double minLatency, double maxLatency) {
+            _samplerate = samplerate;
+            _minLatency = minLatency;
+            _maxLatency = maxLatency;
+            allocate();
+            base_type::init(in);
+        }
+
+        void setSamplerate(double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _samplerate = samplerate;
+            buffer::free(fifo);
+            allocate();
+            base_type::tempStart();
+        }
+
+        // Empty the FIFO, must not be called while the audio callback may run
+        void reset() {
+            writeCount = 0;
+            readCount = 0;
+            ratio = 1.0;
+            jitter = 0.0;
+            extraMargin = 0.0;
+            resetReader();
+        }
+
+        // Called from the audio callback, never blocks. Outputs silence when not enough samples are buffered
+        void read(T* out, int count) {
+            auto now = std::chrono::steady_clock::now();
+            measureJitter(now, count);
+
+            int64_t avail = writeCount.load(std::memory_order_acquire) - readCount.load(std::memory_order_relaxed);
+            int margin = getMargin(count);
+
+            // Wait for enough samples to last until the next DSP block after an underrun, so that playback doesn't stutter
+            if (priming) {
+                if (avail < margin + count + blockSize.load(std::memory_order_relaxed) + 3) {
+                    memset(out, 0, count * sizeof(T));
+                    return;
+                }
+                priming = false;
+            }
+
+            // Drop what is over the maximum latency, this only happens when the DSP sent a burst or stalled the device
+            if (avail > maxFill) {
+                int64_t drop = avail - (maxFill / 2);
+                readCount.fetch_add(drop, std::memory_order_release);
+                avail -= drop;
+            }
+
+            // Interpolate between the samples at the read position and the three after it
+            int i = 0;
+            int64_t pos = readCount.load(std::memory_order_relaxed);
+            for (; i < count; i++) {
+                if (avail < 4) { break; }
+                out[i] = interpolate(pos, mu);
+                mu += ratio;
+                int adv = (int)mu;
+                mu -= (double)adv;
+                pos += adv;
+                avail -= adv;
+            }
+            readCount.store(pos, std::memory_order_release);
+            if (i < count) {
+                memset(&out[i], 0, (count - i) * sizeof(T));
+                underruns++;
+                extraMargin += count;
+                resetReader();
+                return;
+            }
+
+            // Track the lowest fill level and correct the ratio at the end of each window
+            lowWater = std::min<int64_t>(lowWater, avail);
+            fillSum += avail;
+            fillCount++;
+            windowLeft -= count;
+            if (windowLeft <= 0) {
+                double excess = (double)(lowWater - margin);
+                double correction = excess / (PLAYOUT_DRAIN_TIME * _samplerate);
+                ratio = 1.0 + std::clamp<double>(correction, -PLAYOUT_MAX_CORRECTION, PLAYOUT_MAX_CORRECTION);
+                latency = ((double)fillSum / (double)fillCount) / _samplerate;
+                lowWater = INT64_MAX;
+                fillSum = 0;
+                fillCount = 0;
+                windowLeft = PLAYOUT_WINDOW_TIME * _samplerate;
+                extraMargin *= PLAYOUT_MARGIN_DECAY;
+            }
+        }
+
+        // Approximate latency of the FIFO in seconds, safe to call from any thread
+        double getLatency() { return latency; }
+
+        int getUnderruns() { return underruns; }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Anything that doesn't fit is dropped, the reader is never waited for
+            int64_t used = writeCount.load(std::memory_order_relaxed) - readCount.load(std::memory_order_acquire);
+            int n = std::min<int64_t>(count, capacity - used);
+            int64_t w = writeCount.load(std::memory_order_relaxed);
+            for (int i = 0; i < n; i++) { fifo[(w + i) & mask] = base_type::_in->readBuf[i]; }
+            writeCount.store(w + n, std::memory_order_release);
+            blockSize.store(count, std::memory_order_relaxed);
+
+            base_type::_in->flush();
+            return count;
+        }
+
+    private:
+        void allocate() {
+            // Room for the maximum latency, the interpolator and a full DSP block
+            maxFill = std::max<int>(_maxLatency * _samplerate, 64);
+            capacity = 1;
+            while (capacity < maxFill + STREAM_BUFFER_SIZE) { capacity <<= 1; }
+            mask = capacity - 1;
+            fifo = buffer::alloc<T>(capacity);
+            reset();
+        }
+
+        // The ratio is kept, it holds the correction for the drift of the clocks
+        void resetReader() {
+            mu = 0.0;
+            priming = true;
+            lowWater = INT64_MAX;
+            fillSum = 0;
+            fillCount = 0;
+            windowLeft = PLAYOUT_WINDOW_TIME * _samplerate;
+            lastCallback = std::chrono::steady_clock::time_point();
+        }
+
+        // Peak deviation of the time between callbacks from the expected one, decaying by half every second or so
+        void measureJitter(std::chrono::steady_clock::time_point now, int count) {
+            if (lastCallback != std::chrono::steady_clock::time_point()) {
+                double interval = std::chrono::duration<double>(now - lastCallback).count();
+                double expected = (double)count / _samplerate;
+                double dev = fabs(interval - expected);
+                jitter = std::max<double>(dev, jitter * (1.0 - expected * 0.7));
+            }
+            lastCallback = now;
+        }
+
+        // Lowest fill level to keep, one callback worth of samples plus twice the callback jitter. Each underrun adds
+        // another callback worth, which slowly decays
+        int getMargin(int count) {
+            double margin = (double)count + 2.0 * jitter * _samplerate + extraMargin;
+            return std::clamp<double>(margin, _minLatency * _samplerate, maxFill / 2);
+        }
+
+        // Catmull-Rom spline between the second and third of four consecutive samples
+        inline T interpolate(int64_t pos, double frac) {
+            float t = frac;
+            T x0 = fifo[pos & mask];
+            T x1 = fifo[(pos + 1) & mask];
+            T x2 = fifo[(pos + 2) & mask];
+            T x3 = fifo[(pos + 3) & mask];
+            T a = (x1 * 3.0f) - (x2 * 3.0f) + x3 - x0;
+            T b = (x0 * 2.0f) - (x1 * 5.0f) + (x2 * 4.0f) - x3;
+            T c = x2 - x0;
+            return x1 + ((((a * t) + b) * t + c) * t) * 0.5f;
+        }
+
+        double _samplerate;
+        double _minLatency;
+        double _maxLatency;
+
+        // FIFO, the counters are never wrapped
+        T* fifo = NULL;
+        int capacity = 0;
+        int mask = 0;
+        int maxFill = 0;
+        std::atomic<int64_t> writeCount = 0;
+        std::atomic<int64_t> readCount = 0;
+        std::atomic<int> blockSize = 0;
+
+        // Reader state, only touched by the audio callback
+        double mu = 0.0;
+        double ratio = 1.0;
+        bool priming = true;
+        int64_t lowWater = INT64_MAX;
+        int64_t fillSum = 0;
+        int fillCount = 0;
+        int windowLeft = 0;
+        double jitter = 0.0;
+        double extraMargin = 0.0;
+        std::chrono::steady_clock::time_point lastCallback;
+
+        std::atomic<double> latency = 0.0;
+        std::atomic<int> underruns = 0;
+    };
+}
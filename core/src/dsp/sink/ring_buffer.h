@@ -1,6 +1,18 @@
 #pragma once
 #include "../sink.h"
-#include "../buffer/ring_buffer.h"
+#include "../buffer/spsc_ring_buffer.h"
+#include "../multirate/drift_resampler.h"
+
+// Proportional and integral gains of the servo keeping the ring buffer half full, on the fill error normalized to the
+// target fill. The integral gain is per second, the loop settles in ten to twenty seconds for buffers of 15 to 50ms
+#define RING_BUFFER_SERVO_KP    0.01
+#define RING_BUFFER_SERVO_KI    0.002
+
+// Time constant of the average of the fill level, which hides the steps due to the reads of the callback
+#define RING_BUFFER_SERVO_AVG_TIME  0.5
+
+// Largest correction of the ratio applied by the servo
+#define RING_BUFFER_SERVO_MAX_CORRECTION    0.005
 
 // NOTE: THIS IS COMPLETELY UNTESTED AND PROBABLY BROKEN!!!
 
@@ -13,22 +25,84 @@ namespace dsp::sink {
 
         RingBuffer(stream<T>* in, int maxLatency) { init(in, maxLatency); }
 
+        ~RingBuffer() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(work);
+        }
+
         void init(stream<T>* in, int maxLatency) {
             data.init(maxLatency);
+            _maxLatency = maxLatency;
+            resamp.init(NULL);
+            resamp.out.free();
             base_type::init(in);
         }
 
+        void setMaxLatency(int maxLatency) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _maxLatency = maxLatency;
+            data.setMaxLatency(maxLatency);
+        }
+
+        // When enabled, the stream is resampled by a ratio servo-controlled to keep the buffer half full. This follows the
+        // drift between the clock of the source and the clock of the reader instead of slowly filling or emptying the
+        // buffer until it stalls one side, so that a much smaller buffer can be used for the same glitch rate
+        void setDriftCompensation(bool enabled, double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _compensate = enabled;
+            _samplerate = samplerate;
+            integral = 0.0;
+            avgFill = (double)_maxLatency / 2.0;
+            resamp.setRatio(1.0);
+            resamp.reset();
+            base_type::tempStart();
+        }
+
+        // Current ratio of the drift compensation, output samples per input sample
+        double getRatio() { return resamp.getRatio(); }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
-            if (data.write(base_type::_in->readBuf, count) < 0) { return -1; }
+            if (!_compensate) {
+                if (data.write(base_type::_in->readBuf, count) < 0) { return -1; }
+                base_type::_in->flush();
+                return count;
+            }
+
+            // Servo the ratio on the average fill level, taken halfway through the write so that it doesn't depend on
+            // the size of the blocks
+            double dt = (double)count / _samplerate;
+            double alpha = std::min<double>(dt / RING_BUFFER_SERVO_AVG_TIME, 1.0);
+            double fill = (double)data.getReadable() + (double)count / 2.0;
+            avgFill += alpha * (fill - avgFill);
+            double target = (double)_maxLatency / 2.0;
+            double error = (target - avgFill) / target;
+            integral += RING_BUFFER_SERVO_KI * error * dt;
+            integral = std::clamp<double>(integral, -RING_BUFFER_SERVO_MAX_CORRECTION, RING_BUFFER_SERVO_MAX_CORRECTION);
+            double correction = std::clamp<double>(RING_BUFFER_SERVO_KP * error + integral, -RING_BUFFER_SERVO_MAX_CORRECTION, RING_BUFFER_SERVO_MAX_CORRECTION);
+            resamp.setRatio(1.0 + correction);
 
+            int needed = resamp.maxOutputCount(count);
+            if (needed > workCapacity) {
+                buffer::free(work);
+                work = buffer::alloc<T>(needed);
+                workCapacity = needed;
+            }
+            int outCount = resamp.process(count, base_type::_in->readBuf, work);
             base_type::_in->flush();
+
+            if (data.write(work, outCount) < 0) { return -1; }
             return count;
         }
 
-        buffer::RingBuffer<T> data;
+        // Read from the audio callback, which never blocks on it
+        buffer::SPSCRingBuffer<T> data;
 
     private:
         void doStop() {
@@ -40,5 +114,14 @@ namespace dsp::sink {
             base_type::_in->clearReadStop();
             data.clearWriteStop();
         }
+
+        int _maxLatency;
+        bool _compensate = false;
+        double _samplerate = 48000.0;
+        double integral = 0.0;
+        double avgFill = 0.0;
+        multirate::DriftResampler<T> resamp;
+        T* work = NULL;
+        int workCapacity = 0;
     };
 }
\ No newline at end of file
@@ -1,14 +1,88 @@
 #pragma once
 #include <string.h>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
+#include <utility>
+#include <stdint.h>
+#include <math.h>
 #include <volk/volk.h>
 #include "buffer/buffer.h"
+#include "profiler.h"
+#include "latency_probe.h"
 
 // 1MSample buffer
 #define STREAM_BUFFER_SIZE 1000000
 
+// Time during which blocks keep processing silent buffers before skipping them, long enough to flush their filters,
+// look-ahead delays and IIR tails
+#define SILENCE_SETTLE_TIME 0.1
+
 namespace dsp {
+    // Notified when a stream becomes readable (for the reader) or writable (for the writer)
+    class stream_listener {
+    public:
+        virtual ~stream_listener() {}
+        virtual void onStreamEvent() = 0;
+    };
+
+    // Optional metadata of the first sample of a buffer, fields left at 0 are unknown.
+    // The writer updates writeMeta before swap(), the reader finds it in readMeta between read() and flush().
+    // After each swap(), writeMeta is advanced by the size of the buffer so that writers only need to set the fields once
+    struct stream_meta {
+        uint64_t sampleIndex = 0;       // Index of the first sample since the writer was started
+        double timestamp = 0.0;         // Unix time of the first sample, from the hardware or the host
+        double samplerate = 0.0;
+        double frequency = 0.0;         // Center frequency of the samples
+        bool discontinuity = false;     // Samples were lost right before this buffer
+        bool silent = false;            // Every sample of the buffer is zero, eg. the squelch is closed
+        double arrival = 0.0;           // Steady clock time at which the first sample entered the DSP, see steadyTime()
+
+        // Move on to the buffer following one of count samples
+        inline void advance(int count) {
+            sampleIndex += count;
+            if (timestamp != 0.0 && samplerate != 0.0) { timestamp += (double)count / samplerate; }
+            discontinuity = false;
+            silent = false;
+            arrival = 0.0;
+        }
+
+        // Same instant after a samplerate change by ratio (output rate over input rate). The filters of a rate change
+        // have a tail, so a silent input doesn't make a silent output
+        inline stream_meta rescaled(double ratio) const {
+            stream_meta meta = *this;
+            meta.sampleIndex = (uint64_t)round((double)sampleIndex * ratio);
+            meta.samplerate = samplerate * ratio;
+            meta.silent = false;
+            return meta;
+        }
+    };
+
+    // Used by blocks to skip their processing on silent input. The first SILENCE_SETTLE_TIME of silence is processed
+    // normally so that the state of the block is flushed, then skip() returns true and the block only has to output
+    // zeros flagged as silent. The state is left untouched while skipping, processing resumes from it on the next
+    // buffer that isn't silent.
+    class silence_tracker {
+    public:
+        void setSamplerate(double samplerate) {
+            settle = samplerate * SILENCE_SETTLE_TIME;
+        }
+
+        inline bool skip(const stream_meta& meta, int count) {
+            if (!meta.silent) {
+                silentCount = 0;
+                return false;
+            }
+            if (silentCount >= settle) { return true; }
+            silentCount += count;
+            return false;
+        }
+
+    private:
+        double settle = 0.0;
+        double silentCount = 0.0;
+    };
+
     class untyped_stream {
     public:
         virtual ~untyped_stream() {}
@@ -19,60 +93,177 @@ namespace dsp {
         virtual void clearWriteStop() {}
         virtual void stopReader() {}
         virtual void clearReadStop() {}
+
+        // Non-blocking state checks, used by the scheduler to know if read() and swap() would block
+        virtual bool canRead() { return true; }
+        virtual bool canWrite() { return true; }
+
+        // Listeners are called with the stream's internal lock held, once set to NULL they won't be called anymore
+        virtual void setReadListener(stream_listener* listener) { readListener = listener; }
+        virtual void setWriteListener(stream_listener* listener) { writeListener = listener; }
+
+        // Account the buffers of the stream, now and once reallocated, under the given kind, see buffer::pool
+        virtual void setMemoryKind(buffer::pool::Tag kind) {}
+
+    protected:
+        std::atomic<stream_listener*> readListener = NULL;
+        std::atomic<stream_listener*> writeListener = NULL;
     };
 
     template <class T>
     class stream : public untyped_stream {
     public:
-        stream() {
-            writeBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
-            readBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
+        stream(int bufferSize = STREAM_BUFFER_SIZE) {
+            this->bufferSize = bufferSize;
+            maxBlockSize = bufferSize;
+            writeBufSize = bufferSize;
+            readBufSize = bufferSize;
+            writeBuf = buffer::alloc<T>(bufferSize);
+            readBuf = buffer::alloc<T>(bufferSize);
+
+            // Buffers allocated later, from whatever thread, are accounted to whoever created the stream
+            memOwner = buffer::pool::currentOwner();
+            memKind = buffer::pool::currentKind();
         }
 
         virtual ~stream() {
             free();
         }
 
+        // Reallocate both buffers. Must only be called while neither side is using the stream
         virtual void setBufferSize(int samples) {
+            if (samples == bufferSize && writeBuf && readBuf) { return; }
+            buffer::pool::Scope scope(memOwner, memKind);
             buffer::free(writeBuf);
             buffer::free(readBuf);
+            bufferSize = samples;
+            maxBlockSize = samples;
+            writeBufSize = samples;
+            readBufSize = samples;
             writeBuf = buffer::alloc<T>(samples);
             readBuf = buffer::alloc<T>(samples);
         }
 
+        // Make sure the stream can hold at least the given number of samples. Must be called from the writer side,
+        // the write buffer is grown immediately and the read buffer once the reader hands it back on the next swap
+        virtual inline void reserve(int samples) {
+            if (samples <= bufferSize) { return; }
+            buffer::pool::Scope scope(memOwner, memKind);
+            bufferSize = samples;
+            buffer::free(writeBuf);
+            writeBuf = buffer::alloc<T>(samples);
+            writeBufSize = samples;
+        }
+
+        virtual int getBufferSize() {
+            return bufferSize;
+        }
+
+        // Largest block the writer will hand to the reader, used by the reader to size its own buffers.
+        // This is only a hint, readers must still handle larger blocks by reserving space as they come.
+        void setMaxBlockSize(int samples) {
+            maxBlockSize = samples;
+        }
+
+        int getMaxBlockSize() {
+            return maxBlockSize;
+        }
+
+        // Take the buffer being read over, handing the given one, of the given capacity, to the writer in its place
+        // when flush() is called. The capacity is set to that of the buffer taken. Must be called by the reader
+        // between read() and flush(). Returns NULL, the replacement staying with the caller, if the stream doesn't
+        // own the buffers it hands to its reader
+        virtual T* takeReadBuf(T* replacement, int& capacity) {
+            std::lock_guard<std::mutex> lck(swapMtx);
+            T* taken = readBuf;
+            readBuf = replacement;
+            std::swap(capacity, readBufSize);
+            return taken;
+        }
+
         virtual inline bool swap(int size) {
+            profiler::Counters* prof = profiler::current;
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
+            uint64_t flow = 0;
+            stampArrival();
             {
                 // Wait to either swap or stop
                 std::unique_lock<std::mutex> lck(swapMtx);
-                swapCV.wait(lck, [this] { return (canSwap || writerStop); });
+                if (prof && !canSwap && !writerStop) {
+                    uint64_t start = profiler::now();
+                    swapCV.wait(lck, [this] { return (canSwap || writerStop); });
+                    profiler::add(prof->swapWait, profiler::now() - start);
+                    profiler::add(prof->swapsWaited, 1);
+                }
+                else {
+                    swapCV.wait(lck, [this] { return (canSwap || writerStop); });
+                }
 
                 // If writer was stopped, abandon operation
                 if (writerStop) { return false; }
+                if (prof) {
+                    profiler::add(prof->swaps, 1);
+                    profiler::add(prof->samplesOut, size);
+                }
+
+                if (traceStart) { flow = profiler::flowId(this, writeMeta.sampleIndex); }
 
                 // Swap buffers
                 dataSize = size;
                 T* temp = writeBuf;
                 writeBuf = readBuf;
                 readBuf = temp;
+                std::swap(writeBufSize, readBufSize);
                 canSwap = false;
+                readMeta = writeMeta;
+                writeMeta.advance(size);
+                LatencyProbe* probe = latencyProbe;
+                if (probe) { probe->update(readMeta.arrival); }
+
+                // Grow the buffer given back by the reader if the stream was enlarged in the meantime
+                if (writeBufSize < bufferSize) {
+                    buffer::pool::Scope scope(memOwner, memKind);
+                    buffer::free(writeBuf);
+                    writeBuf = buffer::alloc<T>(bufferSize);
+                    writeBufSize = bufferSize;
+                }
             }
 
             // Notify reader that some data is ready
             {
                 std::lock_guard<std::mutex> lck(rdyMtx);
                 dataReady = true;
+                stream_listener* l = readListener;
+                if (l) { l->onStreamEvent(); }
             }
             rdyCV.notify_all();
 
+            if (traceStart) { profiler::trace(profiler::EVENT_SWAP, "swap", traceStart, flow, size); }
             return true;
         }
 
         virtual inline int read() {
             // Wait for data to be ready or to be stopped
+            uint64_t traceStart = profiler::isTracing() ? profiler::now() : 0;
             std::unique_lock<std::mutex> lck(rdyMtx);
-            rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+            profiler::Counters* prof = profiler::current;
+            if (prof && !dataReady && !readerStop) {
+                uint64_t start = profiler::now();
+                rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+                profiler::add(prof->readWait, profiler::now() - start);
+                profiler::add(prof->readsWaited, 1);
+            }
+            else {
+                rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+            }
 
-            return (readerStop ? -1 : dataSize);
+            if (readerStop) { return -1; }
+            if (prof) {
+                profiler::add(prof->reads, 1);
+                profiler::add(prof->samplesIn, dataSize);
+            }
+            if (traceStart) { profiler::trace(profiler::EVENT_READ, "read", traceStart, profiler::flowId(this, readMeta.sampleIndex), dataSize); }
+            return dataSize;
         }
 
         virtual inline void flush() {
@@ -86,11 +277,33 @@ namespace dsp {
             {
                 std::lock_guard<std::mutex> lck(swapMtx);
                 canSwap = true;
+                stream_listener* l = writeListener;
+                if (l) { l->onStreamEvent(); }
             }
 
             swapCV.notify_all();
         }
 
+        virtual bool canRead() {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            return dataReady;
+        }
+
+        virtual bool canWrite() {
+            std::lock_guard<std::mutex> lck(swapMtx);
+            return canSwap;
+        }
+
+        virtual void setReadListener(stream_listener* listener) {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            readListener = listener;
+        }
+
+        virtual void setWriteListener(stream_listener* listener) {
+            std::lock_guard<std::mutex> lck(swapMtx);
+            writeListener = listener;
+        }
+
         virtual void stopWriter() {
             {
                 std::lock_guard<std::mutex> lck(swapMtx);
@@ -115,6 +328,19 @@ namespace dsp {
             readerStop = false;
         }
 
+        // Updated with the latency of every buffer handed to the reader, NULL for none. The probe must outlive the stream
+        // or be removed while the writer is stopped
+        void setLatencyProbe(LatencyProbe* probe) {
+            latencyProbe = probe;
+        }
+
+        virtual void setMemoryKind(buffer::pool::Tag kind) {
+            std::lock_guard<std::mutex> lck(swapMtx);
+            memKind = kind;
+            buffer::pool::setKind(writeBuf, kind);
+            buffer::pool::setKind(readBuf, kind);
+        }
+
         void free() {
             if (writeBuf) { buffer::free(writeBuf); }
             if (readBuf) { buffer::free(readBuf); }
@@ -125,6 +351,17 @@ namespace dsp {
         T* writeBuf;
         T* readBuf;
 
+        stream_meta writeMeta;
+        stream_meta readMeta;
+
+    protected:
+        // Buffers written by blocks that don't carry the metadata over, or by sources, enter the DSP when swapped
+        inline void stampArrival() {
+            if (writeMeta.arrival == 0.0) { writeMeta.arrival = steadyTime(); }
+        }
+
+        std::atomic<LatencyProbe*> latencyProbe = NULL;
+
     private:
         std::mutex swapMtx;
         std::condition_variable swapCV;
@@ -138,5 +375,13 @@ namespace dsp {
         bool writerStop = false;
 
         int dataSize = 0;
+
+        int bufferSize;
+        int maxBlockSize;
+        int writeBufSize;
+        int readBufSize;
+
+        buffer::pool::Tag memOwner;
+        buffer::pool::Tag memKind;
     };
 }
\ No newline at end of file
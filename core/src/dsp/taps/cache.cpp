@@ -0,0 +1,183 @@
+#include "cache.h"
+#include <map>
+#include <tuple>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <algorithm>
+#include <session_snapshot.h>
+#include "../types.h"
+#include "low_pass.h"
+#include "high_pass.h"
+#include "band_pass.h"
+
+namespace dsp::taps::cache {
+    enum Type {
+        LOW_PASS,
+        HIGH_PASS,
+        BAND_PASS
+    };
+
+    // Filters are identified by their type and exact parameters
+    typedef std::tuple<int, double, double, double, double, bool> Key;
+
+    struct Entry {
+        tap<float> taps;
+        int users;
+    };
+
+    static std::mutex mtx;
+    static std::map<Key, Entry> entries;
+    static std::map<float*, Key> owners;
+    static std::deque<Key> unused;
+    static std::set<Key> preloaded;
+
+    // Longest filter accepted from a snapshot, anything larger means it's damaged
+    static constexpr uint32_t MAX_PRELOAD_TAPS = 1 << 24;
+
+    // Free the least recently used taps if too many are unused, with the lock held
+    static void trimUnused() {
+        while (unused.size() > TAP_CACHE_MAX_UNUSED) {
+            auto it = entries.find(unused.front());
+            unused.pop_front();
+            owners.erase(it->second.taps.taps);
+            taps::free(it->second.taps);
+            entries.erase(it);
+        }
+    }
+
+    template <typename Func>
+    static tap<float> acquire(const Key& key, Func generate) {
+        std::lock_guard<std::mutex> lck(mtx);
+
+        // Return the existing taps if they were already generated
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            if (!it->second.users++) {
+                unused.erase(std::remove(unused.begin(), unused.end(), key), unused.end());
+                preloaded.erase(key);
+            }
+            return it->second.taps;
+        }
+
+        // Otherwise generate and register them
+        Entry e;
+        e.taps = generate();
+        e.users = 1;
+        entries[key] = e;
+        owners[e.taps.taps] = key;
+        return e.taps;
+    }
+
+    tap<float> lowPass(double cutoff, double transWidth, double sampleRate, bool oddTapCount, double gain) {
+        return acquire(Key(LOW_PASS, cutoff, transWidth, sampleRate, gain, oddTapCount), [=]() {
+            tap<float> t = taps::lowPass(cutoff, transWidth, sampleRate, oddTapCount);
+            if (gain != 1.0) {
+                for (int i = 0; i < t.size; i++) { t.taps[i] *= (float)gain; }
+            }
+            return t;
+        });
+    }
+
+    tap<float> highPass(double cutoff, double transWidth, double sampleRate, bool oddTapCount) {
+        return acquire(Key(HIGH_PASS, cutoff, transWidth, sampleRate, 0.0, oddTapCount), [=]() {
+            return taps::highPass(cutoff, transWidth, sampleRate, oddTapCount);
+        });
+    }
+
+    tap<float> bandPass(double bandStart, double bandStop, double transWidth, double sampleRate, bool oddTapCount) {
+        return acquire(Key(BAND_PASS, bandStart, bandStop, transWidth, sampleRate, oddTapCount), [=]() {
+            return taps::bandPass<float>(bandStart, bandStop, transWidth, sampleRate, oddTapCount);
+        });
+    }
+
+    void release(tap<float>& t) {
+        if (!t.taps) { return; }
+        std::lock_guard<std::mutex> lck(mtx);
+
+        // Taps that weren't obtained from the cache are owned by the caller
+        auto oit = owners.find(t.taps);
+        if (oit == owners.end()) {
+            taps::free(t);
+            return;
+        }
+        t.taps = NULL;
+        t.size = 0;
+
+        // Keep the taps around for a while once unused
+        Key key = oit->second;
+        Entry& e = entries[key];
+        if (--e.users) { return; }
+        unused.push_back(key);
+        trimUnused();
+    }
+
+    void getStats(int& filters, int& users) {
+        std::lock_guard<std::mutex> lck(mtx);
+        filters = entries.size();
+        users = 0;
+        for (const auto& [key, e] : entries) { users += e.users; }
+    }
+
+    std::vector<uint8_t> snapshot() {
+        std::lock_guard<std::mutex> lck(mtx);
+        session_snapshot::Writer w;
+        w.put<uint32_t>(entries.size());
+        for (const auto& [key, e] : entries) {
+            w.put<int32_t>(std::get<0>(key));
+            w.put<double>(std::get<1>(key));
+            w.put<double>(std::get<2>(key));
+            w.put<double>(std::get<3>(key));
+            w.put<double>(std::get<4>(key));
+            w.put<uint8_t>(std::get<5>(key));
+            w.put<uint32_t>(e.taps.size);
+            w.putRaw(e.taps.taps, e.taps.size * sizeof(float));
+        }
+        return w.data;
+    }
+
+    int preload(const std::vector<uint8_t>& data) {
+        std::lock_guard<std::mutex> lck(mtx);
+        session_snapshot::Reader r(data);
+        uint32_t count = 0;
+        r.get(count);
+        int loaded = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            int32_t type;
+            double p1, p2, p3, p4;
+            uint8_t odd;
+            uint32_t size;
+            r.get(type);
+            r.get(p1);
+            r.get(p2);
+            r.get(p3);
+            r.get(p4);
+            r.get(odd);
+            if (!r.get(size) || !size || size > MAX_PRELOAD_TAPS || size * sizeof(float) > r.remaining()) { break; }
+
+            Key key(type, p1, p2, p3, p4, odd != 0);
+            tap<float> t = taps::alloc<float>(size);
+            r.getRaw(t.taps, size * sizeof(float));
+            if (entries.count(key)) {
+                taps::free(t);
+                continue;
+            }
+            Entry e;
+            e.taps = t;
+            e.users = 0;
+            entries[key] = e;
+            owners[t.taps] = key;
+            preloaded.insert(key);
+            loaded++;
+        }
+        return loaded;
+    }
+
+    void endPreload() {
+        std::lock_guard<std::mutex> lck(mtx);
+        // Unclaimed, they are the first to go
+        for (const Key& key : preloaded) { unused.push_front(key); }
+        preloaded.clear();
+        trimUnused();
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "tap.h"
+
+// Number of taps kept around after their last user released them, so that going back to a previous setting is free
+#define TAP_CACHE_MAX_UNUSED    32
+
+namespace dsp::taps::cache {
+    // Process-wide cache of generated filters. Identical requests get the same taps, shared and reference counted,
+    // instead of generating and storing them again. Cached taps must not be modified and are given back with release()
+
+    tap<float> lowPass(double cutoff, double transWidth, double sampleRate, bool oddTapCount = false, double gain = 1.0);
+
+    tap<float> highPass(double cutoff, double transWidth, double sampleRate, bool oddTapCount = false);
+
+    tap<float> bandPass(double bandStart, double bandStop, double transWidth, double sampleRate, bool oddTapCount = false);
+
+    // Give back taps obtained from the cache. Taps that don't come from the cache are simply freed
+    void release(tap<float>& taps);
+
+    // Number of distinct filters currently stored and number of users of cached taps
+    void getStats(int& filters, int& users);
+
+    // Every filter stored, for the session snapshot
+    std::vector<uint8_t> snapshot();
+
+    // Store the filters of a snapshot without users, returns how many. They aren't dropped when unused taps are freed
+    // until endPreload(), so that they survive the startup until the filter that needs them asks for them
+    int preload(const std::vector<uint8_t>& data);
+    void endPreload();
+}
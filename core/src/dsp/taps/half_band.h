@@ -0,0 +1,52 @@
+#pragma once
+#include <math.h>
+#include <algorithm>
+#include "windowed_sinc.h"
+#include "../window/nuttall.h"
+
+// Longest half-band filter that will be generated, far more than any stopband that can be reached with the window
+#define HALF_BAND_MAX_TAPS          1023
+
+// Number of frequencies at which the stopband is checked
+#define HALF_BAND_CHECK_POINTS      256
+
+namespace dsp::taps {
+    // Half-band low pass cut at a quarter of the samplerate, for decimating by two. The count is always of the form
+    // 4k+3 so that the taps are symmetric, every other one is zero and the first and last ones are not. The shortest
+    // filter attenuating by at least the given amount (in dB) everything that would alias between 0 and the passband,
+    // that is from samplerate/2 - passband to samplerate/2, is returned.
+    inline tap<float> halfBand(double passband, double sampleRate, double attenuation) {
+        double stopband = (sampleRate / 2.0) - passband;
+        double maxGain = pow(10.0, -attenuation / 20.0);
+
+        tap<float> taps;
+        for (int count = 7; count <= HALF_BAND_MAX_TAPS; count += 4) {
+            taps::free(taps);
+            taps = windowedSinc<float>(count, sampleRate / 4.0, sampleRate, window::nuttall);
+
+            // The taps at an even distance from the center are zero, only to the rounding of the sinc
+            int center = count / 2;
+            for (int i = 1; i < count; i += 2) {
+                if (i != center) { taps.taps[i] = 0.0f; }
+            }
+
+            // Unity gain, so that a cascade of them doesn't drift in level
+            double dc = 0.0;
+            for (int i = 0; i < count; i++) { dc += taps.taps[i]; }
+            for (int i = 0; i < count; i++) { taps.taps[i] /= dc; }
+
+            // Check the stopband, the filter being linear phase only the magnitude of the symmetric part matters
+            double worst = 0.0;
+            for (int p = 0; p <= HALF_BAND_CHECK_POINTS; p++) {
+                double f = stopband + (sampleRate / 2.0 - stopband) * (double)p / (double)HALF_BAND_CHECK_POINTS;
+                double w = 2.0 * DB_M_PI * f / sampleRate;
+                double gain = taps.taps[center];
+                for (int i = 0; i < center; i += 2) { gain += 2.0 * taps.taps[i] * cos(w * (double)(center - i)); }
+                worst = std::max<double>(worst, fabs(gain));
+            }
+            if (worst <= maxGain) { break; }
+        }
+
+        return taps;
+    }
+}
@@ -0,0 +1,258 @@
+#include "thread_role.h"
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <utils/flog.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <pthread/qos.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+// Nice value of high and low priority threads on Linux
+#define THREAD_ROLE_HIGH_NICE       -10
+#define THREAD_ROLE_LOW_NICE        10
+
+// set_mempolicy() mode preferring a node, from linux/mempolicy.h
+#define THREAD_ROLE_MPOL_PREFERRED  1
+
+namespace dsp {
+    static const char* roleNames[_THREAD_ROLE_COUNT] = { "source", "wideband", "vfo", "audio", "gui", "io" };
+
+    // SCHED_FIFO priority of each role, the audio callback preempting everything else
+    static const int realtimePriorities[_THREAD_ROLE_COUNT] = { 60, 50, 40, 70, 10, 5 };
+
+    static std::mutex policyMtx;
+    static ThreadPolicy policies[_THREAD_ROLE_COUNT];
+    static std::atomic<int> policyVersion = 1;
+    static std::atomic<bool> warned[_THREAD_ROLE_COUNT];
+
+    static thread_local ThreadRole appliedRole = THREAD_ROLE_NONE;
+    static thread_local int appliedVersion = 0;
+
+    const char* threadRoleName(ThreadRole role) {
+        if (role < 0 || role >= _THREAD_ROLE_COUNT) { return "none"; }
+        return roleNames[role];
+    }
+
+    void setThreadPolicy(ThreadRole role, const ThreadPolicy& policy) {
+        if (role < 0 || role >= _THREAD_ROLE_COUNT) { return; }
+        std::lock_guard<std::mutex> lck(policyMtx);
+        policies[role] = policy;
+        warned[role] = false;
+        policyVersion++;
+    }
+
+    ThreadPolicy getThreadPolicy(ThreadRole role) {
+        if (role < 0 || role >= _THREAD_ROLE_COUNT) { return ThreadPolicy(); }
+        std::lock_guard<std::mutex> lck(policyMtx);
+        return policies[role];
+    }
+
+    // Failing to apply a policy usually means missing privileges, which won't change, so it's only reported once
+    static void warnOnce(ThreadRole role, const char* what) {
+        if (warned[role].exchange(true)) { return; }
+        flog::warn("Could not set the {0} of the {1} threads", what, roleNames[role]);
+    }
+
+#if defined(_WIN32)
+    typedef HANDLE(WINAPI* AvSetMmThreadCharacteristicsFunc)(LPCWSTR, LPDWORD);
+    typedef BOOL(WINAPI* AvRevertMmThreadCharacteristicsFunc)(HANDLE);
+    static thread_local HANDLE mmcssHandle = NULL;
+
+    static void applyPolicy(ThreadRole role, const ThreadPolicy& policy) {
+        // Affinity, the CPUs of the node if none are given
+        DWORD_PTR mask = 0;
+        for (int cpu : policy.cpus) {
+            if (cpu >= 0 && cpu < (int)(sizeof(DWORD_PTR) * 8)) { mask |= ((DWORD_PTR)1 << cpu); }
+        }
+        ULONGLONG nodeMask = 0;
+        if (!mask && policy.numaNode >= 0 && GetNumaNodeProcessorMask((UCHAR)policy.numaNode, &nodeMask)) { mask = (DWORD_PTR)nodeMask; }
+        if (mask && !SetThreadAffinityMask(GetCurrentThread(), mask)) { warnOnce(role, "affinity"); }
+
+        // Real-time threads are registered with MMCSS, avrt.dll is loaded on demand so that nothing else depends on it
+        static HMODULE avrt = LoadLibraryA("avrt.dll");
+        static auto avSet = avrt ? (AvSetMmThreadCharacteristicsFunc)GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW") : NULL;
+        static auto avRevert = avrt ? (AvRevertMmThreadCharacteristicsFunc)GetProcAddress(avrt, "AvRevertMmThreadCharacteristics") : NULL;
+        if (mmcssHandle && avRevert) {
+            avRevert(mmcssHandle);
+            mmcssHandle = NULL;
+        }
+        if (policy.priority == THREAD_PRIO_REALTIME && avSet) {
+            DWORD taskIndex = 0;
+            mmcssHandle = avSet((role == THREAD_ROLE_AUDIO) ? L"Pro Audio" : L"Capture", &taskIndex);
+            if (!mmcssHandle) { warnOnce(role, "MMCSS class"); }
+        }
+
+        int prio = THREAD_PRIORITY_NORMAL;
+        switch (policy.priority) {
+            case dsp::THREAD_PRIO_LOW:      prio = THREAD_PRIORITY_BELOW_NORMAL; break;
+            case dsp::THREAD_PRIO_HIGH:     prio = THREAD_PRIORITY_ABOVE_NORMAL; break;
+            case dsp::THREAD_PRIO_REALTIME: prio = THREAD_PRIORITY_TIME_CRITICAL; break;
+            default: break;
+        }
+        if (!SetThreadPriority(GetCurrentThread(), prio)) { warnOnce(role, "priority"); }
+    }
+#elif defined(__APPLE__)
+    static void applyPolicy(ThreadRole role, const ThreadPolicy& policy) {
+        // macOS has no affinity nor NUMA, the priority is given as a quality of service class
+        qos_class_t qos = QOS_CLASS_DEFAULT;
+        switch (policy.priority) {
+            case THREAD_PRIO_LOW:       qos = QOS_CLASS_UTILITY; break;
+            case THREAD_PRIO_HIGH:      qos = QOS_CLASS_USER_INITIATED; break;
+            case THREAD_PRIO_REALTIME:  qos = QOS_CLASS_USER_INTERACTIVE; break;
+            default: break;
+        }
+        if (pthread_set_qos_class_self_np(qos, 0)) { warnOnce(role, "priority"); }
+    }
+#else
+    // CPUs of a NUMA node, from a list like "0-7,16-23"
+    static std::vector<int> nodeCPUs(int node) {
+        std::vector<int> cpus;
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string range;
+        while (std::getline(file, range, ',')) {
+            int first, last;
+            char dash;
+            std::istringstream ss(range);
+            if (!(ss >> first)) { continue; }
+            last = (ss >> dash >> last) ? last : first;
+            for (int cpu = first; cpu <= last; cpu++) { cpus.push_back(cpu); }
+        }
+        return cpus;
+    }
+
+    static void applyPolicy(ThreadRole role, const ThreadPolicy& policy) {
+        // Affinity, the CPUs of the node if none are given
+        std::vector<int> cpus = policy.cpus;
+        if (cpus.empty() && policy.numaNode >= 0) { cpus = nodeCPUs(policy.numaNode); }
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+            }
+            if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) { warnOnce(role, "affinity"); }
+        }
+
+        // Pages are placed on the node of the thread that touches them first, stream buffers being written by their
+        // block, preferring the node makes that hold even when the thread may run elsewhere
+        if (policy.numaNode >= 0 && policy.numaNode < 64) {
+            unsigned long nodeMask = 1UL << policy.numaNode;
+            if (syscall(SYS_set_mempolicy, THREAD_ROLE_MPOL_PREFERRED, &nodeMask, 64)) { warnOnce(role, "NUMA memory policy"); }
+        }
+
+        // Scheduling class, then the nice value for the others
+        sched_param param = {};
+        int sched = SCHED_OTHER;
+        if (policy.priority == THREAD_PRIO_REALTIME) {
+            sched = SCHED_FIFO;
+            param.sched_priority = realtimePriorities[role];
+        }
+        if (pthread_setschedparam(pthread_self(), sched, &param)) {
+            warnOnce(role, "real-time priority");
+            if (sched == SCHED_FIFO) {
+                param.sched_priority = 0;
+                pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+                sched = SCHED_OTHER;
+            }
+        }
+        if (sched == SCHED_OTHER) {
+            int nice = 0;
+            if (policy.priority == THREAD_PRIO_LOW) { nice = THREAD_ROLE_LOW_NICE; }
+            else if (policy.priority >= THREAD_PRIO_HIGH) { nice = THREAD_ROLE_HIGH_NICE; }
+            if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice)) { warnOnce(role, "priority"); }
+        }
+    }
+#endif
+
+#if defined(_WIN32) || defined(__APPLE__)
+    static void trackThread(ThreadRole role) {}
+
+    void getThreadRoleCPUTimes(double times[_THREAD_ROLE_COUNT]) {
+        for (int i = 0; i < _THREAD_ROLE_COUNT; i++) { times[i] = 0.0; }
+    }
+#else
+    struct TrackedThread {
+        ThreadRole role;
+        double lastTime;
+    };
+
+    static std::mutex trackMtx;
+    static std::map<pid_t, TrackedThread> trackedThreads;
+    static double roleTimes[_THREAD_ROLE_COUNT];
+
+    // User and system time of a thread of the process, negative if it exited
+    static double threadCPUTime(pid_t tid) {
+        std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/stat");
+        std::string stat;
+        if (!std::getline(file, stat)) { return -1.0; }
+
+        // The name of the thread may hold spaces, the fields are counted from the parenthesis closing it
+        size_t end = stat.rfind(')');
+        if (end == std::string::npos) { return -1.0; }
+        std::istringstream ss(stat.substr(end + 2));
+        std::string field;
+        unsigned long long utime = 0, stime = 0;
+        for (int i = 3; i <= 15 && (ss >> field); i++) {
+            if (i == 14) { utime = std::stoull(field); }
+            if (i == 15) { stime = std::stoull(field); }
+        }
+        static const double tick = 1.0 / (double)sysconf(_SC_CLK_TCK);
+        return (double)(utime + stime) * tick;
+    }
+
+    // The time of the thread until now is counted to the role it had, if any
+    static void trackThread(ThreadRole role) {
+        pid_t tid = (pid_t)syscall(SYS_gettid);
+        double now = threadCPUTime(tid);
+        if (now < 0.0) { return; }
+        std::lock_guard<std::mutex> lck(trackMtx);
+        auto it = trackedThreads.find(tid);
+        if (it != trackedThreads.end()) {
+            roleTimes[it->second.role] += std::max<double>(now - it->second.lastTime, 0.0);
+        }
+        trackedThreads[tid] = { role, now };
+    }
+
+    void getThreadRoleCPUTimes(double times[_THREAD_ROLE_COUNT]) {
+        std::lock_guard<std::mutex> lck(trackMtx);
+        for (auto it = trackedThreads.begin(); it != trackedThreads.end();) {
+            double now = threadCPUTime(it->first);
+            if (now < 0.0) {
+                it = trackedThreads.erase(it);
+                continue;
+            }
+            roleTimes[it->second.role] += std::max<double>(now - it->second.lastTime, 0.0);
+            it->second.lastTime = now;
+            it++;
+        }
+        for (int i = 0; i < _THREAD_ROLE_COUNT; i++) { times[i] = roleTimes[i]; }
+    }
+#endif
+
+    void applyThreadRole(ThreadRole role) {
+        if (role < 0 || role >= _THREAD_ROLE_COUNT) { return; }
+        int version = policyVersion.load(std::memory_order_relaxed);
+        if (role == appliedRole && version == appliedVersion) { return; }
+        if (role != appliedRole) { trackThread(role); }
+        appliedRole = role;
+        appliedVersion = version;
+        applyPolicy(role, getThreadPolicy(role));
+    }
+
+    ThreadRole currentThreadRole() {
+        return appliedRole;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+
+namespace dsp {
+    // Kinds of threads that get their own scheduling policy
+    enum ThreadRole {
+        THREAD_ROLE_NONE = -1,      // Left as created
+        THREAD_ROLE_SOURCE,         // Driver callbacks and source ingress
+        THREAD_ROLE_WIDEBAND,       // Blocks running at the samplerate of the source
+        THREAD_ROLE_VFO,            // Blocks running at the samplerate of a VFO
+        THREAD_ROLE_AUDIO,          // Audio device callbacks and their buffers
+        THREAD_ROLE_GUI,
+        THREAD_ROLE_IO,             // Network and file writing
+        _THREAD_ROLE_COUNT
+    };
+
+    enum ThreadPriority {
+        THREAD_PRIO_LOW,
+        THREAD_PRIO_NORMAL,
+        THREAD_PRIO_HIGH,       // Above the other threads of the system, may need privileges on Linux
+        THREAD_PRIO_REALTIME    // SCHED_FIFO on Linux, MMCSS on Windows
+    };
+
+    struct ThreadPolicy {
+        ThreadPriority priority = THREAD_PRIO_NORMAL;
+        std::vector<int> cpus;      // CPUs the threads may run on, all if empty
+        int numaNode = -1;          // Node to place the threads and the memory they touch first on, -1 for any
+    };
+
+    // Name of the role in the config
+    const char* threadRoleName(ThreadRole role);
+
+    // Threads pick the new policy up the next time they apply their role
+    void setThreadPolicy(ThreadRole role, const ThreadPolicy& policy);
+    ThreadPolicy getThreadPolicy(ThreadRole role);
+
+    // Apply the policy of a role to the calling thread. Only does anything the first time it's called for a role
+    // by a thread, and after the policy changes, so it can be called at the start of every callback
+    void applyThreadRole(ThreadRole role);
+
+    // Role last applied to the calling thread, THREAD_ROLE_NONE if none was
+    ThreadRole currentThreadRole();
+
+    // CPU time spent by the threads of each role since they applied it, in seconds. Threads are only followed on
+    // Linux and Android, and the time of a thread since the last call is lost when it exits, so the count is close
+    // but not exact for roles with short lived threads
+    void getThreadRoleCPUTimes(double times[_THREAD_ROLE_COUNT]);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <math.h>
+#include <stdint.h>
 #include "math/constants.h"
 
 namespace dsp {
@@ -125,4 +126,11 @@ namespace dsp {
         float l;
         float r;
     };
+
+    // Interleaved 16 bit IQ, half the size of a complex_t for the wideband path of sources that produce integers.
+    // The full scale value depends on the source
+    struct complex_s16_t {
+        int16_t re;
+        int16_t im;
+    };
 }
@@ -0,0 +1,258 @@
+#include "volk_profile.h"
+#include <volk/volk.h>
+#include <volk/volk_cpu.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <math.h>
+#include <stdlib.h>
+#include <utils/flog.h>
+
+namespace dsp::volk_profile {
+    // Inputs and outputs shared by all kernels, the values don't change the timing
+    struct Buffers {
+        lv_32fc_t* ca;
+        lv_32fc_t* cb;
+        lv_32fc_t* cout;
+        float* fa;
+        float* fb;
+        float* fout;
+        int16_t* s16in;
+        int16_t* s16out;
+        int8_t* s8in;
+        float fres;
+        lv_32fc_t cres;
+        lv_32fc_t phase;
+        lv_32fc_t phaseInc;
+    };
+
+    struct Kernel {
+        const char* name;
+        volk_func_desc_t (*desc)();
+        std::function<void(Buffers& b, const char* impl)> run;
+    };
+
+    static std::mutex mtx;
+    static std::string configPath;
+    static std::thread* worker = NULL;
+    static std::atomic<bool> profiling = false;
+    static std::atomic<bool> stopWorker = false;
+
+    // The kernels of the hot paths: filters, frequency translation, conversions of the sources and sinks, demodulators and FFT
+    static std::vector<Kernel> kernels() {
+        const int n = VOLK_PROFILE_POINTS;
+        return {
+            { "volk_32fc_32f_dot_prod_32fc", volk_32fc_32f_dot_prod_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_32f_dot_prod_32fc_manual(&b.cres, b.ca, b.fa, n, impl); } },
+            { "volk_32f_x2_dot_prod_32f", volk_32f_x2_dot_prod_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32f_x2_dot_prod_32f_manual(&b.fres, b.fa, b.fb, n, impl); } },
+            { "volk_32fc_x2_dot_prod_32fc", volk_32fc_x2_dot_prod_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_x2_dot_prod_32fc_manual(&b.cres, b.ca, b.cb, n, impl); } },
+#if VOLK_VERSION >= 030100
+            { "volk_32fc_s32fc_x2_rotator2_32fc", volk_32fc_s32fc_x2_rotator2_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_s32fc_x2_rotator2_32fc_manual(b.cout, b.ca, &b.phaseInc, &b.phase, n, impl); } },
+#else
+            { "volk_32fc_s32fc_x2_rotator_32fc", volk_32fc_s32fc_x2_rotator_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_s32fc_x2_rotator_32fc_manual(b.cout, b.ca, b.phaseInc, &b.phase, n, impl); } },
+#endif
+            { "volk_16i_s32f_convert_32f", volk_16i_s32f_convert_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_16i_s32f_convert_32f_manual(b.fout, b.s16in, 32768.0f, 2 * n, impl); } },
+            { "volk_8i_s32f_convert_32f", volk_8i_s32f_convert_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_8i_s32f_convert_32f_manual(b.fout, b.s8in, 128.0f, 2 * n, impl); } },
+            { "volk_32f_s32f_convert_16i", volk_32f_s32f_convert_16i_get_func_desc, [n](Buffers& b, const char* impl) { volk_32f_s32f_convert_16i_manual(b.s16out, b.fa, 32767.0f, n, impl); } },
+            { "volk_32f_x2_interleave_32fc", volk_32f_x2_interleave_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32f_x2_interleave_32fc_manual(b.cout, b.fa, b.fb, n, impl); } },
+            { "volk_32fc_magnitude_32f", volk_32fc_magnitude_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_magnitude_32f_manual(b.fout, b.ca, n, impl); } },
+            { "volk_32fc_magnitude_squared_32f", volk_32fc_magnitude_squared_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_magnitude_squared_32f_manual(b.fout, b.ca, n, impl); } },
+            { "volk_32fc_s32f_atan2_32f", volk_32fc_s32f_atan2_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_s32f_atan2_32f_manual(b.fout, b.ca, 1.0f, n, impl); } },
+            { "volk_32fc_s32f_power_spectrum_32f", volk_32fc_s32f_power_spectrum_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_s32f_power_spectrum_32f_manual(b.fout, b.ca, (float)n, n, impl); } },
+            { "volk_32f_s32f_multiply_32f", volk_32f_s32f_multiply_32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32f_s32f_multiply_32f_manual(b.fout, b.fa, 0.5f, n, impl); } },
+            { "volk_32fc_32f_multiply_32fc", volk_32fc_32f_multiply_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_32f_multiply_32fc_manual(b.cout, b.ca, b.fa, n, impl); } },
+            { "volk_32fc_x2_multiply_32fc", volk_32fc_x2_multiply_32fc_get_func_desc, [n](Buffers& b, const char* impl) { volk_32fc_x2_multiply_32fc_manual(b.cout, b.ca, b.cb, n, impl); } },
+            { "volk_32f_accumulator_s32f", volk_32f_accumulator_s32f_get_func_desc, [n](Buffers& b, const char* impl) { volk_32f_accumulator_s32f_manual(&b.fres, b.fa, n, impl); } }
+        };
+    }
+
+    // Fastest implementation usable on this CPU, among those that accept unaligned buffers if requested
+    static std::string fastest(const Kernel& k, Buffers& b, bool aligned) {
+        volk_func_desc_t desc = k.desc();
+        unsigned int arch = volk_get_lvarch();
+        std::string best;
+        double bestTime = INFINITY;
+        for (size_t i = 0; i < desc.n_impls; i++) {
+            if ((desc.impl_deps[i] & ~arch) || (!aligned && desc.impl_alignment[i])) { continue; }
+            if (stopWorker) { return ""; }
+
+            k.run(b, desc.impl_names[i]);
+            auto start = std::chrono::steady_clock::now();
+            double elapsed = 0.0;
+            int calls = 0;
+            do {
+                k.run(b, desc.impl_names[i]);
+                calls++;
+                elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (elapsed < VOLK_PROFILE_TIME_PER_IMPL);
+
+            double t = elapsed / (double)calls;
+            if (t < bestTime) {
+                bestTime = t;
+                best = desc.impl_names[i];
+            }
+        }
+        return best;
+    }
+
+    static void profile(std::string path) {
+        flog::info("No VOLK profile found, profiling the DSP kernels in the background");
+
+        // The real buffers are twice as long for the conversions that take interleaved IQ
+        const int n = VOLK_PROFILE_POINTS;
+        Buffers b;
+        size_t align = volk_get_alignment();
+        b.ca = (lv_32fc_t*)volk_malloc(n * sizeof(lv_32fc_t), align);
+        b.cb = (lv_32fc_t*)volk_malloc(n * sizeof(lv_32fc_t), align);
+        b.cout = (lv_32fc_t*)volk_malloc(n * sizeof(lv_32fc_t), align);
+        b.fa = (float*)volk_malloc(2 * n * sizeof(float), align);
+        b.fb = (float*)volk_malloc(2 * n * sizeof(float), align);
+        b.fout = (float*)volk_malloc(2 * n * sizeof(float), align);
+        b.s16in = (int16_t*)volk_malloc(2 * n * sizeof(int16_t), align);
+        b.s16out = (int16_t*)volk_malloc(2 * n * sizeof(int16_t), align);
+        b.s8in = (int8_t*)volk_malloc(2 * n * sizeof(int8_t), align);
+        for (int i = 0; i < 2 * n; i++) {
+            float v = sinf((float)i * 0.01f);
+            b.fa[i] = v;
+            b.fb[i] = -v;
+            b.s16in[i] = (int16_t)(v * 30000.0f);
+            b.s8in[i] = (int8_t)(v * 120.0f);
+        }
+        for (int i = 0; i < n; i++) {
+            b.ca[i] = lv_cmake(b.fa[i], b.fb[i]);
+            b.cb[i] = lv_cmake(b.fb[i], b.fa[i]);
+        }
+        b.phase = lv_cmake(1.0f, 0.0f);
+        b.phaseInc = lv_cmake(cosf(0.01f), sinf(0.01f));
+
+        std::vector<Choice> choices;
+        for (const auto& k : kernels()) {
+            Choice c;
+            c.kernel = k.name;
+            c.aligned = fastest(k, b, true);
+            c.unaligned = fastest(k, b, false);
+            if (stopWorker) { break; }
+            if (c.aligned.empty() || c.unaligned.empty()) { continue; }
+            choices.push_back(c);
+        }
+
+        volk_free(b.ca);
+        volk_free(b.cb);
+        volk_free(b.cout);
+        volk_free(b.fa);
+        volk_free(b.fb);
+        volk_free(b.fout);
+        volk_free(b.s16in);
+        volk_free(b.s16out);
+        volk_free(b.s8in);
+
+        // An interrupted profile isn't saved, it will be redone on the next start
+        if (stopWorker) {
+            profiling = false;
+            return;
+        }
+
+        // Write to a temporary file first so that VOLK never reads a partial config
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath);
+            for (const auto& c : choices) {
+                file << c.kernel << " " << c.aligned << " " << c.unaligned << "\n";
+            }
+        }
+        std::error_code err;
+        std::filesystem::rename(tmpPath, path, err);
+        if (err) {
+            flog::error("Could not save the VOLK profile to '{}'", path);
+        }
+        else {
+            flog::info("VOLK profile saved to '{}', it will be used from the next start", path);
+            std::lock_guard<std::mutex> lck(mtx);
+            configPath = path;
+        }
+        profiling = false;
+    }
+
+    static bool exists(const std::string& path) {
+        std::error_code err;
+        return std::filesystem::is_regular_file(path, err);
+    }
+
+    static void setConfigDir(const std::string& dir) {
+#ifdef _WIN32
+        _putenv_s("VOLK_CONFIGPATH", dir.c_str());
+#else
+        setenv("VOLK_CONFIGPATH", dir.c_str(), 1);
+#endif
+    }
+
+    void init(const std::string& dir) {
+        std::lock_guard<std::mutex> lck(mtx);
+        if (worker) { return; }
+
+        // A directory given by the user is always used, profiled into if it has no config yet
+        std::string target = dir + "/volk_config";
+        const char* env = getenv("VOLK_CONFIGPATH");
+        if (env && env[0]) {
+            target = std::string(env) + "/volk_config";
+        }
+        else if (!exists(target)) {
+            // Use the config written by volk_profile if there is one
+            const char* home = getenv("HOME");
+            const char* appData = getenv("APPDATA");
+            for (const char* base : { home, appData }) {
+                if (!base) { continue; }
+                std::string path = std::string(base) + "/.volk/volk_config";
+                if (exists(path)) {
+                    configPath = path;
+                    return;
+                }
+            }
+            setConfigDir(dir);
+        }
+        else {
+            setConfigDir(dir);
+        }
+
+        if (exists(target)) {
+            configPath = target;
+            return;
+        }
+
+        // Never destroyed so that exiting without stopping it doesn't terminate the process
+        profiling = true;
+        stopWorker = false;
+        worker = new std::thread(profile, target);
+    }
+
+    void stop() {
+        stopWorker = true;
+        if (worker && worker->joinable()) { worker->join(); }
+    }
+
+    bool isProfiling() {
+        return profiling;
+    }
+
+    std::string getConfigPath() {
+        std::lock_guard<std::mutex> lck(mtx);
+        return configPath;
+    }
+
+    std::vector<Choice> getChoices() {
+        std::vector<Choice> choices;
+        std::ifstream file(getConfigPath());
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream ss(line);
+            Choice c;
+            if (!(ss >> c.kernel >> c.aligned >> c.unaligned) || c.kernel.rfind("volk_", 0)) { continue; }
+            choices.push_back(c);
+        }
+        return choices;
+    }
+}
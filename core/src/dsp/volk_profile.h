@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Time spent running each implementation of a kernel when profiling, in seconds
+#define VOLK_PROFILE_TIME_PER_IMPL  0.02
+
+// Number of samples processed per call when profiling, the size of a typical DSP block
+#define VOLK_PROFILE_POINTS         8192
+
+namespace dsp::volk_profile {
+    // Implementations picked for a kernel, as written in a VOLK config file
+    struct Choice {
+        std::string kernel;
+        std::string aligned;
+        std::string unaligned;
+    };
+
+    // Use the VOLK config found by VOLK itself, or the one in the given directory. If there is none, the kernels used by
+    // the DSP are profiled in the background and the result saved to that directory, VOLK loads it on the next start.
+    // Must be called before any VOLK kernel is used
+    void init(const std::string& dir);
+
+    // Stop profiling, must be called before exiting
+    void stop();
+
+    bool isProfiling();
+
+    // Path of the config in use, empty if VOLK runs from its default ranking
+    std::string getConfigPath();
+
+    // Contents of the config in use
+    std::vector<Choice> getChoices();
+}
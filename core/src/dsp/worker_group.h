@@ -0,0 +1,123 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include "thread_role.h"
+
+namespace dsp {
+    // Helper threads a block splits the work of a buffer over. run() hands out the parts of the work to the helpers
+    // and the calling thread alike and only returns once all of them are done, so that the block still processes one
+    // buffer at a time and its output doesn't change. The helpers take the role of the thread calling run()
+    class WorkerGroup {
+    public:
+        // Number of threads working on each run, the calling one included
+        WorkerGroup(int threads) {
+            for (int i = 1; i < threads; i++) {
+                helpers.push_back(std::thread(&WorkerGroup::worker, this));
+            }
+        }
+
+        ~WorkerGroup() {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                stopping = true;
+            }
+            startCV.notify_all();
+            for (auto& h : helpers) {
+                if (h.joinable()) { h.join(); }
+            }
+        }
+
+        int getThreadCount() { return helpers.size() + 1; }
+
+        // Call f(i) for each i from 0 to count - 1, spread over the threads. Must not be called from several threads
+        // at once
+        template <class F>
+        void run(int count, F f) {
+            if (helpers.empty() || count <= 1) {
+                for (int i = 0; i < count; i++) { f(i); }
+                return;
+            }
+
+            {
+                // Helpers still leaving the previous run must be gone before its parts are handed out again
+                std::unique_lock<std::mutex> lck(mtx);
+                doneCV.wait(lck, [this] { return !active; });
+                job = &call<F>;
+                jobCtx = &f;
+                jobCount = count;
+                jobRole = currentThreadRole();
+                next = 0;
+                generation++;
+            }
+            startCV.notify_all();
+
+            work(job, jobCtx, count);
+
+            std::unique_lock<std::mutex> lck(mtx);
+            doneCV.wait(lck, [this] { return !active && done == jobCount; });
+            done = 0;
+        }
+
+    private:
+        template <class F>
+        static void call(void* ctx, int i) { (*(F*)ctx)(i); }
+
+        void work(void (*fn)(void*, int), void* ctx, int count) {
+            int finished = 0;
+            for (int i = next++; i < count; i = next++) {
+                fn(ctx, i);
+                finished++;
+            }
+            done += finished;
+        }
+
+        void worker() {
+            uint64_t seen = 0;
+            while (true) {
+                void (*fn)(void*, int);
+                void* ctx;
+                int count;
+                ThreadRole role;
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    startCV.wait(lck, [&] { return generation != seen || stopping; });
+                    if (stopping) { return; }
+                    seen = generation;
+                    fn = job;
+                    ctx = jobCtx;
+                    count = jobCount;
+                    role = jobRole;
+                    active++;
+                }
+
+                applyThreadRole(role);
+                work(fn, ctx, count);
+
+                {
+                    std::lock_guard<std::mutex> lck(mtx);
+                    active--;
+                }
+                doneCV.notify_all();
+            }
+        }
+
+        std::vector<std::thread> helpers;
+
+        std::mutex mtx;
+        std::condition_variable startCV;
+        std::condition_variable doneCV;
+        bool stopping = false;
+        uint64_t generation = 0;
+        int active = 0;
+
+        void (*job)(void*, int) = NULL;
+        void* jobCtx = NULL;
+        int jobCount = 0;
+        ThreadRole jobRole = THREAD_ROLE_NONE;
+        std::atomic<int> next = 0;
+        std::atomic<int> done = 0;
+    };
+}
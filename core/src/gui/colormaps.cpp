@@ -3,11 +3,13 @@
 #include <utils/flog.h>
 #include <fstream>
 #include <json.hpp>
+#include <thread>
 
 using nlohmann::json;
 
 namespace colormaps {
     std::map<std::string, Map> maps;
+    std::thread loaderThread;
 
     void loadMap(std::string path) {
         if (!std::filesystem::is_regular_file(path)) {
@@ -45,4 +47,29 @@ namespace colormaps {
 
         maps[map.name] = map;
     }
-}
\ No newline at end of file
+
+    void loadFromDir(std::string path) {
+        if (!std::filesystem::is_directory(path)) {
+            flog::warn("Color map directory {0} does not exist, not loading color maps from directory", path);
+            return;
+        }
+        for (const auto& file : std::filesystem::directory_iterator(path)) {
+            std::string path = file.path().generic_string();
+            if (file.path().extension().generic_string() != ".json") {
+                continue;
+            }
+            if (!file.is_regular_file()) { continue; }
+            flog::info("Loading {0}", path);
+            loadMap(path);
+        }
+    }
+
+    void loadFromDirAsync(std::string path) {
+        waitLoaded();
+        loaderThread = std::thread(loadFromDir, path);
+    }
+
+    void waitLoaded() {
+        if (loaderThread.joinable()) { loaderThread.join(); }
+    }
+}
@@ -13,6 +13,11 @@ namespace colormaps {
     };
 
     void loadMap(std::string path);
+    void loadFromDir(std::string path);
+
+    // Load the maps of a directory on a thread of their own, waitLoaded() must be called before using them
+    void loadFromDirAsync(std::string path);
+    void waitLoaded();
 
     SDRPP_EXPORT std::map<std::string, Map> maps;
 }
\ No newline at end of file
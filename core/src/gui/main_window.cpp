@@ -18,8 +18,12 @@
 #include <gui/menus/bandplan.h>
 #include <gui/menus/sink.h>
 #include <gui/menus/vfo_color.h>
+#include <gui/menus/vfo_spectrum.h>
+#include <gui/menus/sweep.h>
 #include <gui/menus/module_manager.h>
 #include <gui/menus/theme.h>
+#include <gui/menus/dsp_performance.h>
+#include <gui/menus/power.h>
 #include <gui/dialogs/credits.h>
 #include <filesystem>
 #include <signal_path/source.h>
@@ -27,9 +31,16 @@
 #include <gui/colormaps.h>
 #include <gui/widgets/snr_meter.h>
 #include <gui/tuner.h>
+#include <dsp/thread_role.h>
+#include <utils/startup_timer.h>
+#include <session_snapshot.h>
+#include <backend.h>
 
 void MainWindow::init() {
+    // The UI runs on the thread calling init()
+    dsp::applyThreadRole(dsp::THREAD_ROLE_GUI);
     LoadingScreen::show("Initializing UI");
+    startup_timer::begin("Initializing UI");
     gui::waterfall.init();
     gui::waterfall.setRawFFTSize(fftSize);
 
@@ -76,7 +87,11 @@ void MainWindow::init() {
     gui::menu.registerEntry("Display", displaymenu::draw, NULL);
     gui::menu.registerEntry("Theme", thememenu::draw, NULL);
     gui::menu.registerEntry("VFO Color", vfo_color_menu::draw, NULL);
+    gui::menu.registerEntry("VFO Spectrum", vfo_spectrum_menu::draw, NULL);
+    gui::menu.registerEntry("Sweep", sweep_menu::draw, NULL);
     gui::menu.registerEntry("Module Manager", module_manager_menu::draw, NULL);
+    gui::menu.registerEntry("DSP Performance", dsp_performance_menu::draw, NULL);
+    gui::menu.registerEntry("Power", power_menu::draw, NULL);
 
     gui::freqSelect.init();
 
@@ -86,7 +101,10 @@ void MainWindow::init() {
 
     fft_in = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
     fft_out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
-    fftwPlan = fftwf_plan_dft_1d(fftSize, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    {
+        std::lock_guard<std::mutex> lck(dsp::fft::plannerMutex());
+        fftwPlan = fftwf_plan_dft_1d(fftSize, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    }
 
     sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, acquireFFTBuffer, releaseFFTBuffer, this);
     sigpath::iqFrontEnd.start();
@@ -95,9 +113,21 @@ void MainWindow::init() {
     vfoCreatedHandler.ctx = this;
     sigpath::vfoManager.onVfoCreated.bindHandler(&vfoCreatedHandler);
 
+    // The spectrum statistics only hold for the frequency they were gathered on
+    onRetuneHandler.handler = retuneHandler;
+    onRetuneHandler.ctx = this;
+    sigpath::sourceManager.onRetune.bindHandler(&onRetuneHandler);
+
+    // Additional receivers must exist before the modules using them are loaded
+    sigpath::createPaths();
+
     flog::info("Loading modules");
 
-    // Load modules from /module directory
+    // Parse the color maps while the modules load, nothing uses them before the menus are initialized
+    colormaps::loadFromDirAsync(resourcesDir + "/colormaps");
+
+    // List the modules of the module directory, then those specified through the config
+    std::vector<std::string> modulePaths;
     if (std::filesystem::is_directory(modulesDir)) {
         for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
             std::string path = file.path().generic_string();
@@ -105,9 +135,7 @@ void MainWindow::init() {
                 continue;
             }
             if (!file.is_regular_file()) { continue; }
-            flog::info("Loading {0}", path);
-            LoadingScreen::show("Loading " + file.path().filename().string());
-            core::moduleManager.loadModule(path);
+            modulePaths.push_back(path);
         }
     }
     else {
@@ -120,61 +148,60 @@ void MainWindow::init() {
     auto modList = core::configManager.conf["moduleInstances"].items();
     core::configManager.release();
 
-    // Load additional modules specified through config
     for (auto const& path : modules) {
 #ifndef __ANDROID__
-        std::string apath = std::filesystem::absolute(path).string();
-        flog::info("Loading {0}", apath);
-        LoadingScreen::show("Loading " + std::filesystem::path(path).filename().string());
-        core::moduleManager.loadModule(apath);
+        modulePaths.push_back(std::filesystem::absolute(path).string());
 #else
-        core::moduleManager.loadModule(path);
+        modulePaths.push_back(path);
 #endif
     }
 
+    // Load the modules, their files being read ahead in the background
+    core::moduleManager.prefetch(modulePaths);
+    for (auto const& path : modulePaths) {
+        std::string filename = std::filesystem::path(path).filename().string();
+        flog::info("Loading {0}", path);
+        LoadingScreen::show("Loading " + filename);
+        startup_timer::begin("Loading " + filename);
+        core::moduleManager.loadModule(path);
+    }
+    core::moduleManager.waitPrefetch();
+
     // Create module instances
     for (auto const& [name, _module] : modList) {
         std::string mod = _module["module"];
         bool enabled = _module["enabled"];
         flog::info("Initializing {0} ({1})", name, mod);
         LoadingScreen::show("Initializing " + name + " (" + mod + ")");
+        startup_timer::begin("Initializing " + name);
         core::moduleManager.createInstance(name, mod);
         if (!enabled) { core::moduleManager.disableInstance(name); }
     }
 
-    // Load color maps
+    // Wait for the color maps
     LoadingScreen::show("Loading color maps");
-    flog::info("Loading color maps");
-    if (std::filesystem::is_directory(resourcesDir + "/colormaps")) {
-        for (const auto& file : std::filesystem::directory_iterator(resourcesDir + "/colormaps")) {
-            std::string path = file.path().generic_string();
-            LoadingScreen::show("Loading " + file.path().filename().string());
-            flog::info("Loading {0}", path);
-            if (file.path().extension().generic_string() != ".json") {
-                continue;
-            }
-            if (!file.is_regular_file()) { continue; }
-            colormaps::loadMap(path);
-        }
-    }
-    else {
-        flog::warn("Color map directory {0} does not exist, not loading modules from directory", modulesDir);
-    }
+    startup_timer::begin("Loading color maps");
+    colormaps::waitLoaded();
 
     gui::waterfall.updatePalletteFromArray(colormaps::maps["Turbo"].map, colormaps::maps["Turbo"].entryCount);
 
+    startup_timer::begin("Initializing menus");
     sourcemenu::init();
     sinkmenu::init();
     bandplanmenu::init();
     displaymenu::init();
     vfo_color_menu::init();
+    vfo_spectrum_menu::init();
+    sweep_menu::init();
     module_manager_menu::init();
+    power_menu::init();
 
     // TODO for 0.2.5
     // Fix gain not updated on startup, soapysdr
 
     // Update UI settings
     LoadingScreen::show("Loading configuration");
+    startup_timer::begin("Loading configuration");
     core::configManager.acquire();
     fftMin = core::configManager.conf["min"];
     fftMax = core::configManager.conf["max"];
@@ -224,7 +251,9 @@ void MainWindow::init() {
     autostart = core::args["autostart"].b();
     initComplete = true;
 
+    startup_timer::begin("Module post-init");
     core::moduleManager.doPostInitAll();
+    session_snapshot::restoreDone();
 }
 
 float* MainWindow::acquireFFTBuffer(void* ctx) {
@@ -233,6 +262,18 @@ float* MainWindow::acquireFFTBuffer(void* ctx) {
 
 void MainWindow::releaseFFTBuffer(void* ctx) {
     gui::waterfall.pushFFT();
+    backend::requestRedraw();
+}
+
+void MainWindow::retuneHandler(double freq, void* ctx) {
+    MainWindow* _this = (MainWindow*)ctx;
+    sigpath::spectrumStats.reset();
+
+    // Follow the retunes made by modules working on the signal path directly, the waterfall being already up to date otherwise
+    if (gui::waterfall.getCenterFrequency() != freq) {
+        gui::waterfall.setCenterFrequency(freq);
+        _this->externalRetune = true;
+    }
 }
 
 void MainWindow::vfoAddedHandler(VFOManager::VFO* vfo, void* ctx) {
@@ -276,11 +317,12 @@ void MainWindow::draw() {
             gui::freqSelect.frequencyChanged = false;
             core::configManager.acquire();
             core::configManager.conf["vfoOffsets"][gui::waterfall.selectedVFO] = vfo->generalOffset;
-            core::configManager.release(true);
+            core::configManager.release(true, "vfoOffsets");
         }
     }
 
     sigpath::vfoManager.updateFromWaterfall(&gui::waterfall);
+    power_menu::update();
 
     // Handle selection of another VFO
     if (gui::waterfall.selectedVFOChanged) {
@@ -306,6 +348,14 @@ void MainWindow::draw() {
         core::configManager.release(true);
     }
 
+    // Show the frequency of a retune made by a module
+    if (externalRetune.exchange(false)) {
+        gui::freqSelect.setFrequency((vfo != NULL) ? (gui::waterfall.getCenterFrequency() + vfo->generalOffset) : gui::waterfall.getCenterFrequency());
+        core::configManager.acquire();
+        core::configManager.conf["frequency"] = gui::waterfall.getCenterFrequency();
+        core::configManager.release(true, "frequency");
+    }
+
     // Handle dragging the frequency scale
     if (gui::waterfall.centerFreqMoved) {
         gui::waterfall.centerFreqMoved = false;
@@ -318,7 +368,7 @@ void MainWindow::draw() {
         }
         core::configManager.acquire();
         core::configManager.conf["frequency"] = gui::waterfall.getCenterFrequency();
-        core::configManager.release(true);
+        core::configManager.release(true, "frequency");
     }
 
     int _fftHeight = gui::waterfall.getFFTHeight();
@@ -326,7 +376,7 @@ void MainWindow::draw() {
         fftHeight = _fftHeight;
         core::configManager.acquire();
         core::configManager.conf["fftHeight"] = fftHeight;
-        core::configManager.release(true);
+        core::configManager.release(true, "fftHeight");
     }
 
     // To Bar
@@ -337,7 +387,7 @@ void MainWindow::draw() {
         showMenu = !showMenu;
         core::configManager.acquire();
         core::configManager.conf["showMenu"] = showMenu;
-        core::configManager.release(true);
+        core::configManager.release(true, "showMenu");
     }
     ImGui::PopID();
 
@@ -387,7 +437,7 @@ void MainWindow::draw() {
             gui::waterfall.VFOMoveSingleClick = false;
             core::configManager.acquire();
             core::configManager.conf["centerTuning"] = false;
-            core::configManager.release(true);
+            core::configManager.release(true, "centerTuning");
         }
         ImGui::PopID();
     }
@@ -399,7 +449,7 @@ void MainWindow::draw() {
             tuner::tune(tuner::TUNER_MODE_CENTER, gui::waterfall.selectedVFO, gui::freqSelect.frequency);
             core::configManager.acquire();
             core::configManager.conf["centerTuning"] = true;
-            core::configManager.release(true);
+            core::configManager.release(true, "centerTuning");
         }
         ImGui::PopID();
     }
@@ -462,7 +512,7 @@ void MainWindow::draw() {
             menuWidth = newWidth;
             core::configManager.acquire();
             core::configManager.conf["menuWidth"] = menuWidth;
-            core::configManager.release(true);
+            core::configManager.release(true, "menuWidth");
         }
     }
 
@@ -639,7 +689,7 @@ void MainWindow::draw() {
         fftMax = std::max<float>(fftMax, fftMin + 10);
         core::configManager.acquire();
         core::configManager.conf["max"] = fftMax;
-        core::configManager.release(true);
+        core::configManager.release(true, "max");
     }
 
     ImGui::NewLine();
@@ -652,7 +702,7 @@ void MainWindow::draw() {
         fftMin = std::min<float>(fftMax - 10, fftMin);
         core::configManager.acquire();
         core::configManager.conf["min"] = fftMin;
-        core::configManager.release(true);
+        core::configManager.release(true, "min");
     }
 
     ImGui::EndChild();
@@ -683,6 +733,8 @@ void MainWindow::setPlayState(bool _playing) {
         onPlayStateChange.emit(true);
     }
     else {
+        // A sweep can't go on without the source
+        sigpath::sweeper.stop();
         playing = false;
         onPlayStateChange.emit(false);
         sigpath::sourceManager.stop();
@@ -7,6 +7,7 @@
 #include <string>
 #include <utils/event.h>
 #include <mutex>
+#include <atomic>
 #include <gui/tuner.h>
 
 #define WINDOW_FLAGS ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoBackground
@@ -35,6 +36,7 @@ public:
 
 private:
     static void vfoAddedHandler(VFOManager::VFO* vfo, void* ctx);
+    static void retuneHandler(double freq, void* ctx);
 
     // FFT Variables
     int fftSize = 8192 * 8;
@@ -66,4 +68,8 @@ private:
     bool autostart = false;
 
     EventHandler<VFOManager::VFO*> vfoCreatedHandler;
+    EventHandler<double> onRetuneHandler;
+
+    // Set when the source was retuned without going through the waterfall
+    std::atomic<bool> externalRetune = false;
 };
\ No newline at end of file
@@ -12,6 +12,8 @@ namespace bandplanmenu {
     const char* bandPlanPosTxt = "Bottom\0Top\0";
 
     void init() {
+        bandplan::waitLoaded();
+
         // todo: check if the bandplan wasn't removed
         if (bandplan::bandplanNames.size() == 0) {
             gui::waterfall.hideBandplan();
@@ -41,7 +43,7 @@ namespace bandplanmenu {
             gui::waterfall.bandplan = &bandplan::bandplans[bandplan::bandplanNames[bandplanId]];
             core::configManager.acquire();
             core::configManager.conf["bandPlan"] = bandplan::bandplanNames[bandplanId];
-            core::configManager.release(true);
+            core::configManager.release(true, "bandPlan");
         }
         ImGui::PopItemWidth();
 
@@ -51,16 +53,16 @@ namespace bandplanmenu {
             gui::waterfall.setBandPlanPos(bandPlanPos);
             core::configManager.acquire();
             core::configManager.conf["bandPlanPos"] = bandPlanPos;
-            core::configManager.release(true);
+            core::configManager.release(true, "bandPlanPos");
         }
 
         if (ImGui::Checkbox("Enabled", &bandPlanEnabled)) {
             bandPlanEnabled ? gui::waterfall.showBandplan() : gui::waterfall.hideBandplan();
             core::configManager.acquire();
             core::configManager.conf["bandPlanEnabled"] = bandPlanEnabled;
-            core::configManager.release(true);
+            core::configManager.release(true, "bandPlanEnabled");
         }
-        bandplan::BandPlan_t plan = bandplan::bandplans[bandplan::bandplanNames[bandplanId]];
+        bandplan::BandPlan_t& plan = bandplan::bandplans[bandplan::bandplanNames[bandplanId]];
         ImGui::Text("Country: %s (%s)", plan.countryName.c_str(), plan.countryCode.c_str());
         ImGui::Text("Author: %s", plan.authorName.c_str());
     }
@@ -1,4 +1,5 @@
 #include <gui/menus/display.h>
+#include <backend.h>
 #include <imgui.h>
 #include <gui/gui.h>
 #include <core.h>
@@ -10,6 +11,11 @@
 #include <utils/optionlist.h>
 #include <algorithm>
 
+// While power saving, the FFT and the UI are capped to these
+#define POWER_SAVING_FFT_RATE   10
+#define POWER_SAVING_FFT_SIZE   8192
+#define POWER_SAVING_MAX_FPS    30
+
 namespace displaymenu {
     bool showWaterfall;
     bool fullWaterfallUpdate = true;
@@ -18,8 +24,16 @@ namespace displaymenu {
     std::string colorMapNamesTxt = "";
     std::string colorMapAuthor = "";
     int selectedWindow = 0;
+    int zoomModeId = 0;
+    int lineIntegrationId = 0;
     int fftRate = 20;
+    int maxFPS = 60;
     int fftSizeId = 0;
+    bool fftAveraging = false;
+    int fftOverlapId = 2;
+    bool gpuFFT = false;
+    int fftLogModeId = 0;
+    bool fftVisibleOnly = false;
     int uiScaleId = 0;
     bool restartRequired = false;
     bool fftHold = false;
@@ -28,8 +42,10 @@ namespace displaymenu {
     int fftSmoothingSpeed = 100;
     bool snrSmoothing = false;
     int snrSmoothingSpeed = 20;
+    bool powerSaving = false;
 
     OptionList<int, int> fftSizes;
+    OptionList<int, double> fftOverlaps;
     OptionList<float, float> uiScales;
 
     const IQFrontEnd::FFTWindow fftWindowList[] = {
@@ -38,10 +54,59 @@ namespace displaymenu {
         IQFrontEnd::FFTWindow::NUTTALL
     };
 
+    const ImGui::ZoomMap::Mode zoomModeList[] = {
+        ImGui::ZoomMap::Mode::PEAK,
+        ImGui::ZoomMap::Mode::MEAN
+    };
+
+    const ImGui::WaterFall::LineIntegration lineIntegrationList[] = {
+        ImGui::WaterFall::LINE_INTEGRATION_LATEST,
+        ImGui::WaterFall::LINE_INTEGRATION_MAX,
+        ImGui::WaterFall::LINE_INTEGRATION_AVERAGE
+    };
+
+    // Values in effect, the configured ones being capped while power saving
+    int effectiveFFTRate() {
+        return powerSaving ? std::min<int>(fftRate, POWER_SAVING_FFT_RATE) : fftRate;
+    }
+
+    int effectiveFFTSize() {
+        int size = fftSizes.value(fftSizeId);
+        return powerSaving ? std::min<int>(size, POWER_SAVING_FFT_SIZE) : size;
+    }
+
+    int effectiveMaxFPS() {
+        if (!powerSaving) { return maxFPS; }
+        return (maxFPS > 0) ? std::min<int>(maxFPS, POWER_SAVING_MAX_FPS) : POWER_SAVING_MAX_FPS;
+    }
+
     void updateFFTSpeeds() {
-        gui::waterfall.setFFTHoldSpeed((float)fftHoldSpeed / ((float)fftRate * 10.0f));
-        gui::waterfall.setFFTSmoothingSpeed(std::min<float>((float)fftSmoothingSpeed / (float)(fftRate * 10.0f), 1.0f));
-        gui::waterfall.setSNRSmoothingSpeed(std::min<float>((float)snrSmoothingSpeed / (float)(fftRate * 10.0f), 1.0f));
+        int rate = effectiveFFTRate();
+        gui::waterfall.setFFTHoldSpeed((float)fftHoldSpeed / ((float)rate * 10.0f));
+        gui::waterfall.setFFTSmoothingSpeed(std::min<float>((float)fftSmoothingSpeed / (float)(rate * 10.0f), 1.0f));
+        gui::waterfall.setSNRSmoothingSpeed(std::min<float>((float)snrSmoothingSpeed / (float)(rate * 10.0f), 1.0f));
+    }
+
+    void setPowerSaving(bool enabled) {
+        if (enabled == powerSaving) { return; }
+        powerSaving = enabled;
+        sigpath::iqFrontEnd.setFFTSize(effectiveFFTSize());
+        sigpath::iqFrontEnd.setFFTRate(effectiveFFTRate());
+        backend::setMaxFPS(effectiveMaxFPS());
+        updateFFTSpeeds();
+    }
+
+    bool isPowerSaving() {
+        return powerSaving;
+    }
+
+    void updateGPUFFT() {
+        if (gpuFFT && gui::waterfall.gpuFFT.isAvailable()) {
+            sigpath::iqFrontEnd.setFFTOffload(ImGui::GPUFFT::configureHandler, ImGui::GPUFFT::submitHandler, &gui::waterfall.gpuFFT);
+        }
+        else {
+            sigpath::iqFrontEnd.setFFTOffload(NULL, NULL, NULL);
+        }
     }
 
     void init() {
@@ -57,6 +122,12 @@ namespace displaymenu {
         fftSizes.define(2048, "2048", 2048);
         fftSizes.define(1024, "1024", 1024);
 
+        // Define FFT overlaps
+        fftOverlaps.define(0, "0%", 0.0);
+        fftOverlaps.define(25, "25%", 0.25);
+        fftOverlaps.define(50, "50%", 0.5);
+        fftOverlaps.define(75, "75%", 0.75);
+
         showWaterfall = core::configManager.conf["showWaterfall"];
         showWaterfall ? gui::waterfall.showWaterfall() : gui::waterfall.hideWaterfall();
         std::string colormapName = core::configManager.conf["colorMap"];
@@ -83,14 +154,38 @@ namespace displaymenu {
         if (fftSizes.keyExists(size)) {
             fftSizeId = fftSizes.keyId(size);
         }
-        sigpath::iqFrontEnd.setFFTSize(fftSizes.value(fftSizeId));
+        sigpath::iqFrontEnd.setFFTSize(effectiveFFTSize());
 
         fftRate = core::configManager.conf["fftRate"];
-        sigpath::iqFrontEnd.setFFTRate(fftRate);
+        sigpath::iqFrontEnd.setFFTRate(effectiveFFTRate());
+
+        maxFPS = core::configManager.conf["maxFPS"];
+        backend::setMaxFPS(effectiveMaxFPS());
 
         selectedWindow = std::clamp<int>((int)core::configManager.conf["fftWindow"], 0, (sizeof(fftWindowList) / sizeof(IQFrontEnd::FFTWindow)) - 1);
         sigpath::iqFrontEnd.setFFTWindow(fftWindowList[selectedWindow]);
 
+        fftOverlapId = fftOverlaps.keyId(50);
+        int overlap = core::configManager.conf["fftOverlap"];
+        if (fftOverlaps.keyExists(overlap)) {
+            fftOverlapId = fftOverlaps.keyId(overlap);
+        }
+        sigpath::iqFrontEnd.setFFTOverlap(fftOverlaps.value(fftOverlapId));
+        fftAveraging = core::configManager.conf["fftAveraging"];
+        sigpath::iqFrontEnd.setFFTAveraging(fftAveraging);
+        fftLogModeId = core::configManager.conf["fftFastLog"] ? 1 : 0;
+        sigpath::iqFrontEnd.setFFTFastLog(fftLogModeId);
+        fftVisibleOnly = core::configManager.conf["fftVisibleOnly"];
+        sigpath::iqFrontEnd.setFFTVisibleOnly(fftVisibleOnly);
+        gpuFFT = core::configManager.conf["gpuFFT"];
+        updateGPUFFT();
+
+        zoomModeId = std::clamp<int>((int)core::configManager.conf["fftZoomMode"], 0, (sizeof(zoomModeList) / sizeof(ImGui::ZoomMap::Mode)) - 1);
+        gui::waterfall.setZoomMode(zoomModeList[zoomModeId]);
+
+        lineIntegrationId = std::clamp<int>((int)core::configManager.conf["fftLineIntegration"], 0, (sizeof(lineIntegrationList) / sizeof(ImGui::WaterFall::LineIntegration)) - 1);
+        gui::waterfall.setLineIntegration(lineIntegrationList[lineIntegrationId]);
+
         gui::menu.locked = core::configManager.conf["lockMenuOrder"];
 
         fftHold = core::configManager.conf["fftHold"];
@@ -117,7 +212,7 @@ namespace displaymenu {
         showWaterfall ? gui::waterfall.showWaterfall() : gui::waterfall.hideWaterfall();
         core::configManager.acquire();
         core::configManager.conf["showWaterfall"] = showWaterfall;
-        core::configManager.release(true);
+        core::configManager.release(true, "showWaterfall");
     }
 
     void checkKeybinds() {
@@ -136,20 +231,20 @@ namespace displaymenu {
             gui::waterfall.setFullWaterfallUpdate(fullWaterfallUpdate);
             core::configManager.acquire();
             core::configManager.conf["fullWaterfallUpdate"] = fullWaterfallUpdate;
-            core::configManager.release(true);
+            core::configManager.release(true, "fullWaterfallUpdate");
         }
 
         if (ImGui::Checkbox("Lock Menu Order##_sdrpp", &gui::menu.locked)) {
             core::configManager.acquire();
             core::configManager.conf["lockMenuOrder"] = gui::menu.locked;
-            core::configManager.release(true);
+            core::configManager.release(true, "lockMenuOrder");
         }
 
         if (ImGui::Checkbox("FFT Hold##_sdrpp", &fftHold)) {
             gui::waterfall.setFFTHold(fftHold);
             core::configManager.acquire();
             core::configManager.conf["fftHold"] = fftHold;
-            core::configManager.release(true);
+            core::configManager.release(true, "fftHold");
         }
         ImGui::SameLine();
         ImGui::FillWidth();
@@ -157,14 +252,14 @@ namespace displaymenu {
             updateFFTSpeeds();
             core::configManager.acquire();
             core::configManager.conf["fftHoldSpeed"] = fftHoldSpeed;
-            core::configManager.release(true);
+            core::configManager.release(true, "fftHoldSpeed");
         }
 
         if (ImGui::Checkbox("FFT Smoothing##_sdrpp", &fftSmoothing)) {
             gui::waterfall.setFFTSmoothing(fftSmoothing);
             core::configManager.acquire();
             core::configManager.conf["fftSmoothing"] = fftSmoothing;
-            core::configManager.release(true);
+            core::configManager.release(true, "fftSmoothing");
         }
         ImGui::SameLine();
         ImGui::FillWidth();
@@ -173,14 +268,14 @@ namespace displaymenu {
             updateFFTSpeeds();
             core::configManager.acquire();
             core::configManager.conf["fftSmoothingSpeed"] = fftSmoothingSpeed;
-            core::configManager.release(true);
+            core::configManager.release(true, "fftSmoothingSpeed");
         }
 
         if (ImGui::Checkbox("SNR Smoothing##_sdrpp", &snrSmoothing)) {
             gui::waterfall.setSNRSmoothing(snrSmoothing);
             core::configManager.acquire();
             core::configManager.conf["snrSmoothing"] = snrSmoothing;
-            core::configManager.release(true);
+            core::configManager.release(true, "snrSmoothing");
         }
         ImGui::SameLine();
         ImGui::FillWidth();
@@ -189,7 +284,7 @@ namespace displaymenu {
             updateFFTSpeeds();
             core::configManager.acquire();
             core::configManager.conf["snrSmoothingSpeed"] = snrSmoothingSpeed;
-            core::configManager.release(true);
+            core::configManager.release(true, "snrSmoothingSpeed");
         }
 
         ImGui::LeftLabel("High-DPI Scaling");
@@ -197,7 +292,7 @@ namespace displaymenu {
         if (ImGui::Combo("##sdrpp_ui_scale", &uiScaleId, uiScales.txt)) {
             core::configManager.acquire();
             core::configManager.conf["uiScale"] = uiScales[uiScaleId];
-            core::configManager.release(true);
+            core::configManager.release(true, "uiScale");
             restartRequired = true;
         }
 
@@ -205,20 +300,31 @@ namespace displaymenu {
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputInt("##sdrpp_fft_rate", &fftRate, 1, 10)) {
             fftRate = std::max<int>(1, fftRate);
-            sigpath::iqFrontEnd.setFFTRate(fftRate);
+            sigpath::iqFrontEnd.setFFTRate(effectiveFFTRate());
             updateFFTSpeeds();
             core::configManager.acquire();
             core::configManager.conf["fftRate"] = fftRate;
-            core::configManager.release(true);
+            core::configManager.release(true, "fftRate");
+        }
+
+        ImGui::LeftLabel("Max UI Framerate");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::InputInt("##sdrpp_max_fps", &maxFPS, 1, 10)) {
+            maxFPS = std::max<int>(0, maxFPS);
+            backend::setMaxFPS(effectiveMaxFPS());
+            core::configManager.acquire();
+            core::configManager.conf["maxFPS"] = maxFPS;
+            core::configManager.release(true, "maxFPS");
         }
+        if (ImGui::IsItemHovered()) { ImGui::SetTooltip("0 for no limit other than vsync. The UI only redraws this fast on input or new FFT data"); }
 
         ImGui::LeftLabel("FFT Size");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::Combo("##sdrpp_fft_size", &fftSizeId, fftSizes.txt)) {
-            sigpath::iqFrontEnd.setFFTSize(fftSizes.value(fftSizeId));
+            sigpath::iqFrontEnd.setFFTSize(effectiveFFTSize());
             core::configManager.acquire();
             core::configManager.conf["fftSize"] = fftSizes.key(fftSizeId);
-            core::configManager.release(true);
+            core::configManager.release(true, "fftSize");
         }
 
         ImGui::LeftLabel("FFT Window");
@@ -227,7 +333,80 @@ namespace displaymenu {
             sigpath::iqFrontEnd.setFFTWindow(fftWindowList[selectedWindow]);
             core::configManager.acquire();
             core::configManager.conf["fftWindow"] = selectedWindow;
-            core::configManager.release(true);
+            core::configManager.release(true, "fftWindow");
+        }
+
+        ImGui::LeftLabel("Zoom Mode");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_fft_zoom_mode", &zoomModeId, "Peak\0Average\0")) {
+            gui::waterfall.setZoomMode(zoomModeList[zoomModeId]);
+            core::configManager.acquire();
+            core::configManager.conf["fftZoomMode"] = zoomModeId;
+            core::configManager.release(true, "fftZoomMode");
+        }
+
+        ImGui::LeftLabel("Line Integration");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_fft_line_integration", &lineIntegrationId, "Latest\0Max Hold\0Average\0")) {
+            gui::waterfall.setLineIntegration(lineIntegrationList[lineIntegrationId]);
+            core::configManager.acquire();
+            core::configManager.conf["fftLineIntegration"] = lineIntegrationId;
+            core::configManager.release(true, "fftLineIntegration");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("How the spectra computed faster than the display refreshes are combined into one line");
+        }
+
+        if (ImGui::Checkbox("FFT Averaging##_sdrpp", &fftAveraging)) {
+            sigpath::iqFrontEnd.setFFTAveraging(fftAveraging);
+            core::configManager.acquire();
+            core::configManager.conf["fftAveraging"] = fftAveraging;
+            core::configManager.release(true, "fftAveraging");
+        }
+        if (!fftAveraging) { ImGui::BeginDisabled(); }
+        ImGui::LeftLabel("FFT Overlap");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_fft_overlap", &fftOverlapId, fftOverlaps.txt)) {
+            sigpath::iqFrontEnd.setFFTOverlap(fftOverlaps.value(fftOverlapId));
+            core::configManager.acquire();
+            core::configManager.conf["fftOverlap"] = fftOverlaps.key(fftOverlapId);
+            core::configManager.release(true, "fftOverlap");
+        }
+        if (!fftAveraging) { ImGui::EndDisabled(); }
+
+        ImGui::LeftLabel("dB Conversion");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_fft_log_mode", &fftLogModeId, "Exact\0Fast\0")) {
+            sigpath::iqFrontEnd.setFFTFastLog(fftLogModeId);
+            core::configManager.acquire();
+            core::configManager.conf["fftFastLog"] = (bool)fftLogModeId;
+            core::configManager.release(true, "fftFastLog");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Fast is within 0.002dB of exact");
+        }
+
+        if (ImGui::Checkbox("Convert Visible Bins Only##_sdrpp", &fftVisibleOnly)) {
+            sigpath::iqFrontEnd.setFFTVisibleOnly(fftVisibleOnly);
+            core::configManager.acquire();
+            core::configManager.conf["fftVisibleOnly"] = fftVisibleOnly;
+            core::configManager.release(true, "fftVisibleOnly");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Bins out of view keep their last level, which the scanner and signal statistics also see");
+        }
+
+        // Averaged spectra are always computed on the CPU
+        if (gui::waterfall.gpuFFT.isAvailable()) {
+            if (ImGui::Checkbox("GPU FFT##_sdrpp", &gpuFFT)) {
+                updateGPUFFT();
+                core::configManager.acquire();
+                core::configManager.conf["gpuFFT"] = gpuFFT;
+                core::configManager.release(true, "gpuFFT");
+            }
+            if (gpuFFT && !sigpath::iqFrontEnd.isFFTOffloaded() && ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Not used with FFT averaging or FFT sizes the GPU can't handle");
+            }
         }
 
         if (colorMapNames.size() > 0) {
@@ -238,7 +417,7 @@ namespace displaymenu {
                 gui::waterfall.updatePalletteFromArray(map.map, map.entryCount);
                 core::configManager.acquire();
                 core::configManager.conf["colorMap"] = colorMapNames[colorMapId];
-                core::configManager.release(true);
+                core::configManager.release(true, "colorMap");
                 colorMapAuthor = map.author;
             }
             ImGui::Text("Color map Author: %s", colorMapAuthor.c_str());
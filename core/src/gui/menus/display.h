@@ -4,4 +4,8 @@ namespace displaymenu {
     void init();
     void checkKeybinds();
     void draw(void* ctx);
+
+    // Cap the FFT rate and size and the UI frame rate without changing the config, see power_menu
+    void setPowerSaving(bool enabled);
+    bool isPowerSaving();
 }
\ No newline at end of file
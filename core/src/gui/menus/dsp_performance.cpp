@@ -0,0 +1,221 @@
+#include <gui/menus/dsp_performance.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <dsp/profiler.h>
+#include <dsp/volk_profile.h>
+#include <dsp/buffer/pool.h>
+#include <volk/volk.h>
+#include <core.h>
+#include <map>
+#include <algorithm>
+#include <time.h>
+
+// Interval between two updates of the rates, in nanoseconds
+#define DSP_PERFORMANCE_UPDATE_INTERVAL     500000000ULL
+
+namespace dsp_performance_menu {
+    struct Rates {
+        double busy;        // Fraction of the time spent processing
+        double starved;     // Fraction of the time spent waiting for input
+        double blocked;     // Fraction of the time spent waiting for room in the outputs
+        double inRate;
+        double outRate;
+        double inputReady;  // Fraction of the reads that found data waiting
+        double outputFull;  // Fraction of the swaps that found the output still held
+    };
+
+    bool enabled = false;
+    bool tracing = false;
+    std::string lastTrace;
+    uint64_t lastUpdate = 0;
+    std::map<std::string, dsp::profiler::Values> last;
+    std::vector<std::pair<std::string, Rates>> rates;
+
+    void update() {
+        uint64_t now = dsp::profiler::now();
+        if (now - lastUpdate < DSP_PERFORMANCE_UPDATE_INTERVAL) { return; }
+        double dt = (double)(now - lastUpdate) * 1e-9;
+        lastUpdate = now;
+
+        // Rates over the interval, blocks that were just registered are only shown from the next update
+        std::map<std::string, dsp::profiler::Values> current;
+        rates.clear();
+        for (const auto& v : dsp::profiler::getValues()) {
+            current[v.name] = v;
+            auto it = last.find(v.name);
+            if (it == last.end()) { continue; }
+            const dsp::profiler::Values& p = it->second;
+            double readWait = (double)(v.readWait - p.readWait) * 1e-9;
+            double swapWait = (double)(v.swapWait - p.swapWait) * 1e-9;
+            double run = (double)(v.runTime - p.runTime) * 1e-9;
+            uint64_t reads = v.reads - p.reads;
+            uint64_t swaps = v.swaps - p.swaps;
+
+            Rates r;
+            r.busy = std::max<double>(run - readWait - swapWait, 0.0) / dt;
+            r.starved = readWait / dt;
+            r.blocked = swapWait / dt;
+            r.inRate = (double)(v.samplesIn - p.samplesIn) / dt;
+            r.outRate = (double)(v.samplesOut - p.samplesOut) / dt;
+            r.inputReady = reads ? 1.0 - (double)(v.readsWaited - p.readsWaited) / (double)reads : 0.0;
+            r.outputFull = swaps ? (double)(v.swapsWaited - p.swapsWaited) / (double)swaps : 0.0;
+            rates.push_back({ v.name, r });
+        }
+        last = current;
+    }
+
+    // Save the trace next to the config, named after the current time
+    void saveTrace() {
+        char name[64];
+        time_t now = time(NULL);
+        strftime(name, sizeof(name), "sdrpp_trace_%Y%m%d_%H%M%S.json", localtime(&now));
+        std::string path = (std::string)core::args["root"] + "/" + name;
+        lastTrace = dsp::profiler::saveTrace(path) ? path : "";
+    }
+
+    // Implementations VOLK was told to use, kernels that aren't listed use its default ranking
+    void drawVolk() {
+        if (!ImGui::CollapsingHeader("VOLK kernels##_dsp_perf_volk")) { return; }
+        ImGui::Text("Machine: %s", volk_get_machine());
+        if (dsp::volk_profile::isProfiling()) {
+            ImGui::TextUnformatted("Profiling the kernels...");
+            return;
+        }
+        std::string path = dsp::volk_profile::getConfigPath();
+        if (path.empty()) {
+            ImGui::TextUnformatted("No profile, using the default ranking");
+            return;
+        }
+        ImGui::TextWrapped("Profile: %s", path.c_str());
+
+        if (ImGui::BeginTable("DSP Performance VOLK Table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
+            ImGui::TableSetupColumn("Kernel");
+            ImGui::TableSetupColumn("Aligned");
+            ImGui::TableSetupColumn("Unaligned");
+            ImGui::TableSetupScrollFreeze(3, 1);
+            ImGui::TableHeadersRow();
+            for (const auto& c : dsp::volk_profile::getChoices()) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(c.kernel.c_str());
+                ImGui::TableSetColumnIndex(1);
+                ImGui::TextUnformatted(c.aligned.c_str());
+                ImGui::TableSetColumnIndex(2);
+                ImGui::TextUnformatted(c.unaligned.c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    // Memory held by the buffers of each owner, the kinds making it up being shown when hovering it
+    void drawMemory() {
+        if (!ImGui::CollapsingHeader("Memory##_dsp_perf_memory")) { return; }
+        struct Owner {
+            size_t bytes = 0;
+            int64_t buffers = 0;
+            std::vector<dsp::buffer::pool::Usage> kinds;
+        };
+        std::map<std::string, Owner> owners;
+        size_t total = 0;
+        for (const auto& u : dsp::buffer::pool::getUsage()) {
+            Owner& o = owners[u.owner];
+            o.bytes += u.bytes;
+            o.buffers += u.buffers;
+            o.kinds.push_back(u);
+            total += u.bytes;
+        }
+        ImGui::Text("Total: %.1f MB", (double)total / 1048576.0);
+
+        if (ImGui::BeginTable("DSP Performance Memory Table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
+            ImGui::TableSetupColumn("Owner");
+            ImGui::TableSetupColumn("MB");
+            ImGui::TableSetupColumn("Buffers");
+            ImGui::TableSetupScrollFreeze(3, 1);
+            ImGui::TableHeadersRow();
+            for (auto& [name, o] : owners) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(name.c_str());
+                if (ImGui::IsItemHovered()) {
+                    std::sort(o.kinds.begin(), o.kinds.end(), [](const auto& a, const auto& b) { return a.bytes > b.bytes; });
+                    ImGui::BeginTooltip();
+                    for (const auto& k : o.kinds) {
+                        ImGui::Text("%s: %.2f MB in %d buffers", k.kind.c_str(), (double)k.bytes / 1048576.0, (int)k.buffers);
+                    }
+                    ImGui::EndTooltip();
+                }
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.2f", (double)o.bytes / 1048576.0);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%d", (int)o.buffers);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    void draw(void* ctx) {
+        drawVolk();
+        drawMemory();
+
+        // The trace keeps the last events of each thread, it can be saved while recording
+        if (ImGui::Checkbox("Record trace##_dsp_perf_trace", &tracing)) {
+            dsp::profiler::setTracing(tracing);
+        }
+        ImGui::SameLine();
+        if (!tracing) { ImGui::BeginDisabled(); }
+        if (ImGui::Button("Save##_dsp_perf_save_trace")) { saveTrace(); }
+        if (!tracing) { ImGui::EndDisabled(); }
+        if (!lastTrace.empty()) {
+            ImGui::TextWrapped("Saved to %s", lastTrace.c_str());
+            if (ImGui::IsItemHovered()) { ImGui::SetTooltip("Open in chrome://tracing or ui.perfetto.dev"); }
+        }
+
+        if (ImGui::Checkbox("Profile DSP blocks##_dsp_perf_enable", &enabled)) {
+            dsp::profiler::setEnabled(enabled);
+            last.clear();
+            rates.clear();
+            lastUpdate = 0;
+        }
+        if (!enabled) { return; }
+        update();
+
+        if (ImGui::BeginTable("DSP Performance Table", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
+            ImGui::TableSetupColumn("Block");
+            ImGui::TableSetupColumn("Busy");
+            ImGui::TableSetupColumn("In MS/s");
+            ImGui::TableSetupColumn("Blocked");
+            ImGui::TableSetupScrollFreeze(4, 1);
+            ImGui::TableHeadersRow();
+
+            for (const auto& [name, r] : rates) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(name.c_str());
+                if (ImGui::IsItemHovered()) {
+                    ImGui::BeginTooltip();
+                    ImGui::Text("Processing: %.1f%%", r.busy * 100.0);
+                    ImGui::Text("Waiting for input: %.1f%%", r.starved * 100.0);
+                    ImGui::Text("Waiting for outputs: %.1f%%", r.blocked * 100.0);
+                    ImGui::Text("Input: %.3f MS/s, Output: %.3f MS/s", r.inRate * 1e-6, r.outRate * 1e-6);
+                    ImGui::Text("Input already waiting: %.0f%% of reads", r.inputReady * 100.0);
+                    ImGui::Text("Output still full: %.0f%% of swaps", r.outputFull * 100.0);
+                    ImGui::EndTooltip();
+                }
+
+                // A block that is busy most of the time is the bottleneck of its chain
+                ImGui::TableSetColumnIndex(1);
+                if (r.busy > 0.8) {
+                    ImGui::TextColored(ImVec4(1.0, 0.3, 0.3, 1.0), "%.0f%%", r.busy * 100.0);
+                }
+                else {
+                    ImGui::Text("%.0f%%", r.busy * 100.0);
+                }
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%.3f", r.inRate * 1e-6);
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%.0f%%", r.blocked * 100.0);
+            }
+            ImGui::EndTable();
+        }
+    }
+}
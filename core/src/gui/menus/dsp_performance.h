@@ -0,0 +1,5 @@
+#pragma once
+
+namespace dsp_performance_menu {
+    void draw(void* ctx);
+}
@@ -0,0 +1,110 @@
+#include <gui/menus/power.h>
+#include <gui/menus/display.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <utils/power.h>
+#include <utils/optionlist.h>
+#include <dsp/thread_role.h>
+#include <dsp/profiler.h>
+#include <core.h>
+#include <string>
+#include <vector>
+
+// Interval between two checks of the battery and two updates of the CPU loads, in nanoseconds
+#define POWER_BATTERY_CHECK_INTERVAL    5000000000ULL
+#define POWER_LOAD_UPDATE_INTERVAL      1000000000ULL
+
+namespace power_menu {
+    OptionList<std::string, power::Profile> profiles;
+    int profileId = 0;
+    std::vector<int> performanceCPUs;
+    std::vector<int> efficiencyCPUs;
+    bool battery = false;
+    uint64_t lastBatteryCheck = 0;
+
+    uint64_t lastLoadUpdate = 0;
+    double lastCPUTimes[dsp::_THREAD_ROLE_COUNT];
+    double loads[dsp::_THREAD_ROLE_COUNT];
+
+    std::string cpuList(const std::vector<int>& cpus) {
+        std::string list;
+        for (int cpu : cpus) {
+            if (!list.empty()) { list += ", "; }
+            list += std::to_string(cpu);
+        }
+        return list;
+    }
+
+    void init() {
+        profiles.define(power::profileName(power::PROFILE_DEFAULT), "Default", power::PROFILE_DEFAULT);
+        profiles.define(power::profileName(power::PROFILE_POWER_AWARE), "Power aware", power::PROFILE_POWER_AWARE);
+        profileId = profiles.valueId(power::getProfile());
+        power::getCoreClasses(performanceCPUs, efficiencyCPUs);
+        dsp::getThreadRoleCPUTimes(lastCPUTimes);
+        for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) { loads[i] = 0.0; }
+        update();
+    }
+
+    void update() {
+        uint64_t now = dsp::profiler::now();
+        if (lastBatteryCheck && now - lastBatteryCheck < POWER_BATTERY_CHECK_INTERVAL) { return; }
+        lastBatteryCheck = now;
+        battery = power::onBattery();
+        displaymenu::setPowerSaving(battery && power::getProfile() == power::PROFILE_POWER_AWARE);
+    }
+
+    // Share of one core used by the threads of each role over the last interval
+    void updateLoads() {
+        uint64_t now = dsp::profiler::now();
+        if (now - lastLoadUpdate < POWER_LOAD_UPDATE_INTERVAL) { return; }
+        double dt = (double)(now - lastLoadUpdate) * 1e-9;
+        double times[dsp::_THREAD_ROLE_COUNT];
+        dsp::getThreadRoleCPUTimes(times);
+        for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+            if (lastLoadUpdate) { loads[i] = (times[i] - lastCPUTimes[i]) / dt; }
+            lastCPUTimes[i] = times[i];
+        }
+        lastLoadUpdate = now;
+    }
+
+    void draw(void* ctx) {
+        ImGui::LeftLabel("Profile");
+        ImGui::FillWidth();
+        if (ImGui::Combo("##_power_profile", &profileId, profiles.txt)) {
+            power::setProfile(profiles.value(profileId));
+            lastBatteryCheck = 0;
+            update();
+            core::configManager.acquire();
+            core::configManager.conf["powerProfile"] = profiles.key(profileId);
+            core::configManager.release(true, "powerProfile");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Power aware: wideband DSP on the performance cores, decoders and I/O on the efficiency cores, FFT and UI slowed down on battery");
+        }
+
+        if (performanceCPUs.empty()) {
+            ImGui::TextUnformatted("Cores: all alike");
+        }
+        else {
+            ImGui::TextWrapped("Performance cores: %s", cpuList(performanceCPUs).c_str());
+            ImGui::TextWrapped("Efficiency cores: %s", cpuList(efficiencyCPUs).c_str());
+        }
+        ImGui::Text("Power: %s%s", battery ? "battery" : "external", displaymenu::isPowerSaving() ? ", saving" : "");
+
+        updateLoads();
+        if (ImGui::BeginTable("Power CPU Load Table", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Role");
+            ImGui::TableSetupColumn("CPU");
+            ImGui::TableHeadersRow();
+            for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(dsp::threadRoleName((dsp::ThreadRole)i));
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.1f%%", loads[i] * 100.0);
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::IsItemHovered()) { ImGui::SetTooltip("Share of one core, only measured on Linux and Android"); }
+    }
+}
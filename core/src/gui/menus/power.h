@@ -0,0 +1,10 @@
+#pragma once
+
+namespace power_menu {
+    void init();
+
+    // Called on every frame, follows the battery state for the power aware profile
+    void update();
+
+    void draw(void* ctx);
+}
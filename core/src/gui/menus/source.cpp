@@ -7,6 +7,9 @@
 #include <signal_path/signal_path.h>
 #include <utils/optionlist.h>
 #include <gui/dialogs/dialog_box.h>
+#include <chrono>
+#include <thread>
+#include <algorithm>
 
 namespace sourcemenu {
     int sourceId = 0;
@@ -17,6 +20,14 @@ namespace sourcemenu {
 
     int decimId = 0;
     OptionList<int, int> decimations;
+    bool autoDecimation = false;
+    int decimThreads = 1;
+    bool vfoGrouping = false;
+    bool vfoScheduler = false;
+    bool asyncTuning = true;
+
+    int channelizerId = 0;
+    OptionList<int, int> channelizers;
 
     bool iqCorrection = false;
     bool invertIQ = false;
@@ -42,6 +53,10 @@ namespace sourcemenu {
         OFFSET_ID_CUSTOM_BASE
     };
 
+    int maxDecimThreads() {
+        return std::max<int>(std::thread::hardware_concurrency(), 1);
+    }
+
     void updateOffset() {
         // Compute the effective offset
         switch (offsetId) {
@@ -167,6 +182,14 @@ namespace sourcemenu {
         decimations.define(32, "32x", 32);
         decimations.define(64, "64x", 64);
 
+        // Define channelizer sizes
+        channelizers.define(0, "Disabled", 0);
+        channelizers.define(16, "16 channels", 16);
+        channelizers.define(32, "32 channels", 32);
+        channelizers.define(64, "64 channels", 64);
+        channelizers.define(128, "128 channels", 128);
+        channelizers.define(256, "256 channels", 256);
+
         // Acquire the config file
         core::configManager.acquire();
 
@@ -180,11 +203,21 @@ namespace sourcemenu {
         if (decimations.keyExists(decimation)) {
             decimId = decimations.keyId(decimation);
         }
+        autoDecimation = core::configManager.conf["autoDecimation"];
+        vfoGrouping = core::configManager.conf["vfoGrouping"];
+        vfoScheduler = core::configManager.conf["vfoScheduler"];
+        asyncTuning = core::configManager.conf["asyncTuning"];
+        decimThreads = std::clamp<int>(core::configManager.conf["decimationThreads"], 1, maxDecimThreads());
+        int channels = core::configManager.conf["channelizerChannels"];
+        if (channelizers.keyExists(channels)) {
+            channelizerId = channelizers.keyId(channels);
+        }
 
         // Release the config file
         core::configManager.release();
 
         // Select the source module
+        sigpath::sourceManager.setAsyncTuning(asyncTuning);
         refreshSources();
         selectSource(selectedSource);
 
@@ -192,6 +225,11 @@ namespace sourcemenu {
         sigpath::iqFrontEnd.setDCBlocking(iqCorrection);
         sigpath::iqFrontEnd.setInvertIQ(invertIQ);
         sigpath::iqFrontEnd.setDecimation(decimations.value(decimId));
+        sigpath::iqFrontEnd.setAutoDecimation(autoDecimation);
+        sigpath::iqFrontEnd.setDecimationThreads(decimThreads);
+        sigpath::iqFrontEnd.setVFOGrouping(vfoGrouping);
+        sigpath::iqFrontEnd.setVFOScheduler(vfoScheduler);
+        sigpath::iqFrontEnd.setChannelizer(channelizers.value(channelizerId));
         selectOffsetByName(selectedOffset);
 
         // Register handlers
@@ -294,25 +332,51 @@ namespace sourcemenu {
             selectSource(newSource);
             core::configManager.acquire();
             core::configManager.conf["source"] = newSource;
-            core::configManager.release(true);
+            core::configManager.release(true, "source");
         }
 
         if (running) { style::endDisabled(); }
 
         sigpath::sourceManager.showSelectedMenu();
 
+        SourceStats::Values stats;
+        if (sigpath::sourceManager.getStats(stats)) {
+            ImGui::Text("Samples: %llu", (unsigned long long)stats.samples);
+            if (stats.overflows || stats.discontinuities) {
+                double ago = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count() - stats.lastGapTime;
+                ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Overflows: %llu, Gaps: %llu (last %.0fs ago)", (unsigned long long)stats.overflows, (unsigned long long)stats.discontinuities, ago);
+            }
+        }
+
+        SourceManager::TuneStats tuneStats = sigpath::sourceManager.getTuneStats();
+        if (tuneStats.applied) {
+            ImGui::Text("Retune: %.1fms (max %.1fms)", tuneStats.lastSettle * 1000.0, tuneStats.maxSettle * 1000.0);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%llu of %llu tuning requests reached the hardware", (unsigned long long)tuneStats.applied, (unsigned long long)tuneStats.requests);
+            }
+        }
+
+        // Only worth showing once the input buffer was actually needed
+        dsp::buffer::FrameBufferStats bufStats = sigpath::iqFrontEnd.getInputBufferStats();
+        if (running && bufStats.highWater > bufStats.budget / 4) {
+            ImGui::Text("Input buffer: %d%% (peak %d%%)", (int)(100 * bufStats.fill / bufStats.budget), (int)(100 * bufStats.highWater / bufStats.budget));
+        }
+        if (bufStats.overflows) {
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Input buffer drops: %llu", (unsigned long long)bufStats.overflows);
+        }
+
         if (ImGui::Checkbox("IQ Correction##_sdrpp_iq_corr", &iqCorrection)) {
             sigpath::iqFrontEnd.setDCBlocking(iqCorrection);
             core::configManager.acquire();
             core::configManager.conf["iqCorrection"] = iqCorrection;
-            core::configManager.release(true);
+            core::configManager.release(true, "iqCorrection");
         }
 
         if (ImGui::Checkbox("Invert IQ##_sdrpp_inv_iq", &invertIQ)) {
             sigpath::iqFrontEnd.setInvertIQ(invertIQ);
             core::configManager.acquire();
             core::configManager.conf["invertIQ"] = invertIQ;
-            core::configManager.release(true);
+            core::configManager.release(true, "invertIQ");
         }
 
         ImGui::LeftLabel("Offset mode");
@@ -321,7 +385,7 @@ namespace sourcemenu {
             selectOffsetById(offsetId);
             core::configManager.acquire();
             core::configManager.conf["selectedOffset"] = offsets.key(offsetId);
-            core::configManager.release(true);
+            core::configManager.release(true, "selectedOffset");
         }
         ImGui::SameLine();
         ImGui::SetCursorPosX(ImGui::GetCursorPosX() - spacing);
@@ -355,7 +419,7 @@ namespace sourcemenu {
                 updateOffset();
                 core::configManager.acquire();
                 core::configManager.conf["manualOffset"] = manualOffset;
-                core::configManager.release(true);
+                core::configManager.release(true, "manualOffset");
             }
         }
         else {
@@ -371,8 +435,72 @@ namespace sourcemenu {
             sigpath::iqFrontEnd.setDecimation(decimations.value(decimId));
             core::configManager.acquire();
             core::configManager.conf["decimation"] = decimations.key(decimId);
-            core::configManager.release(true);
+            core::configManager.release(true, "decimation");
         }
         if (running) { style::endDisabled(); }
+
+        // Swapped between two buffers, so it can be changed while running
+        ImGui::LeftLabel("Decimation threads");
+        ImGui::FillWidth();
+        if (ImGui::InputInt("##source_decim_threads", &decimThreads)) {
+            decimThreads = std::clamp<int>(decimThreads, 1, maxDecimThreads());
+            sigpath::iqFrontEnd.setDecimationThreads(decimThreads);
+            core::configManager.acquire();
+            core::configManager.conf["decimationThreads"] = decimThreads;
+            core::configManager.release(true, "decimationThreads");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Split the decimation of the full band over several cores, for sources of tens of MS/s");
+        }
+
+        // Follows the VFOs, so it can be changed while running
+        if (ImGui::Checkbox("Auto VFO decimation##_sdrpp_auto_decim", &autoDecimation)) {
+            sigpath::iqFrontEnd.setAutoDecimation(autoDecimation);
+            core::configManager.acquire();
+            core::configManager.conf["autoDecimation"] = autoDecimation;
+            core::configManager.release(true, "autoDecimation");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Feed the VFOs only the part of the band they're in, decimated as much as possible");
+        }
+
+        if (ImGui::Checkbox("Asynchronous tuning##_sdrpp_async_tuning", &asyncTuning)) {
+            sigpath::sourceManager.setAsyncTuning(asyncTuning);
+            core::configManager.acquire();
+            core::configManager.conf["asyncTuning"] = asyncTuning;
+            core::configManager.release(true, "asyncTuning");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Retune the hardware from its own thread, only to the latest frequency asked for. Turn off for drivers that must be called from the GUI thread");
+        }
+
+        if (ImGui::Checkbox("Group VFOs##_sdrpp_vfo_grouping", &vfoGrouping)) {
+            sigpath::iqFrontEnd.setVFOGrouping(vfoGrouping);
+            core::configManager.acquire();
+            core::configManager.conf["vfoGrouping"] = vfoGrouping;
+            core::configManager.release(true, "vfoGrouping");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Process all the VFOs from one thread, sharing the band in cache. Saves memory bandwidth with many VFOs");
+        }
+
+        if (ImGui::Checkbox("Pool VFO threads##_sdrpp_vfo_scheduler", &vfoScheduler)) {
+            sigpath::iqFrontEnd.setVFOScheduler(vfoScheduler);
+            core::configManager.acquire();
+            core::configManager.conf["vfoScheduler"] = vfoScheduler;
+            core::configManager.release(true, "vfoScheduler");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Run the VFOs on a pool of one thread per core instead of a thread each. Fewer context switches with many VFOs");
+        }
+
+        ImGui::LeftLabel("Channelizer");
+        ImGui::FillWidth();
+        if (ImGui::Combo("##source_channelizer", &channelizerId, channelizers.txt)) {
+            sigpath::iqFrontEnd.setChannelizer(channelizers.value(channelizerId));
+            core::configManager.acquire();
+            core::configManager.conf["channelizerChannels"] = channelizers.key(channelizerId);
+            core::configManager.release(true, "channelizerChannels");
+        }
     }
 }
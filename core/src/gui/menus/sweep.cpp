@@ -0,0 +1,96 @@
+#include <gui/menus/sweep.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <signal_path/signal_path.h>
+#include <utils/optionlist.h>
+#include <core.h>
+#include <algorithm>
+
+namespace sweep_menu {
+    double startFreq = 88000000.0;
+    double stopFreq = 108000000.0;
+    double settleTime = SWEEP_DEFAULT_SETTLE_TIME * 1000.0;
+    int sizeId = 0;
+    OptionList<int, int> sizes;
+
+    void init() {
+        sizes.define(65536, "65536", 65536);
+        sizes.define(32768, "32768", 32768);
+        sizes.define(16384, "16384", 16384);
+        sizes.define(8192, "8192", 8192);
+        sizes.define(4096, "4096", 4096);
+        sizes.define(2048, "2048", 2048);
+        sizes.define(1024, "1024", 1024);
+        sizes.define(512, "512", 512);
+        sizes.define(256, "256", 256);
+
+        core::configManager.acquire();
+        startFreq = core::configManager.conf["sweepStart"];
+        stopFreq = core::configManager.conf["sweepStop"];
+        settleTime = core::configManager.conf["sweepSettleTime"];
+        int size = core::configManager.conf["sweepFFTSize"];
+        sizeId = sizes.keyExists(size) ? sizes.keyId(size) : sizes.keyId(4096);
+        core::configManager.release();
+    }
+
+    void draw(void* ctx) {
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+        bool sweeping = sigpath::sweeper.isRunning();
+
+        if (sweeping) { style::beginDisabled(); }
+        ImGui::LeftLabel("Start");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::InputDouble("##sdrpp_sweep_start", &startFreq, 100000.0, 1000000.0, "%0.0f")) {
+            startFreq = std::max<double>(round(startFreq), 0.0);
+            core::configManager.acquire();
+            core::configManager.conf["sweepStart"] = startFreq;
+            core::configManager.release(true, "sweepStart");
+        }
+        ImGui::LeftLabel("Stop");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::InputDouble("##sdrpp_sweep_stop", &stopFreq, 100000.0, 1000000.0, "%0.0f")) {
+            stopFreq = std::max<double>(round(stopFreq), 0.0);
+            core::configManager.acquire();
+            core::configManager.conf["sweepStop"] = stopFreq;
+            core::configManager.release(true, "sweepStop");
+        }
+        ImGui::LeftLabel("FFT Size");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_sweep_size", &sizeId, sizes.txt)) {
+            core::configManager.acquire();
+            core::configManager.conf["sweepFFTSize"] = sizes.key(sizeId);
+            core::configManager.release(true, "sweepFFTSize");
+        }
+        ImGui::LeftLabel("Settle Time (ms)");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::InputDouble("##sdrpp_sweep_settle", &settleTime, 0.1, 1.0, "%0.1f")) {
+            settleTime = std::clamp<double>(settleTime, 0.0, 1000.0);
+            core::configManager.acquire();
+            core::configManager.conf["sweepSettleTime"] = settleTime;
+            core::configManager.release(true, "sweepSettleTime");
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Samples discarded after each retune while the hardware settles, when hopping in software");
+        }
+        if (sweeping) { style::endDisabled(); }
+
+        // The source has to be running to be hopped
+        bool canStart = sweeping || (gui::mainWindow.sdrIsRunning() && stopFreq > startFreq);
+        if (!canStart) { style::beginDisabled(); }
+        if (ImGui::Button(sweeping ? "Stop##sdrpp_sweep_toggle" : "Start##sdrpp_sweep_toggle", ImVec2(menuWidth, 0))) {
+            if (sweeping) {
+                sigpath::sweeper.stop();
+            }
+            else {
+                sigpath::sweeper.start(startFreq, stopFreq, sizes.value(sizeId), settleTime / 1000.0);
+            }
+        }
+        if (!canStart) { style::endDisabled(); }
+        if (!sweeping) { return; }
+
+        Sweeper::Stats stats = sigpath::sweeper.getStats();
+        ImGui::Text("Mode: %s", stats.native ? "Hardware" : "Software");
+        ImGui::Text("Sweeps: %llu (%llu hops)", (unsigned long long)stats.sweeps, (unsigned long long)stats.hops);
+        if (stats.sweeps) { ImGui::Text("Sweep time: %.1f ms", stats.sweepTime * 1000.0); }
+    }
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace sweep_menu {
+    void init();
+    void draw(void* ctx);
+}
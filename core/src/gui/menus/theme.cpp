@@ -47,7 +47,7 @@ namespace thememenu {
             applyTheme();
             core::configManager.acquire();
             core::configManager.conf["theme"] = themeNames[themeId];
-            core::configManager.release(true);
+            core::configManager.release(true, "theme");
         }
     }
 }
\ No newline at end of file
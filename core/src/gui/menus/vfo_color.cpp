@@ -105,7 +105,7 @@ namespace vfo_color_menu {
                 vfo->color = IM_COL32(255, 255, 255, 50);
                 core::configManager.acquire();
                 core::configManager.conf["vfoColors"][name] = "#FFFFFF";
-                core::configManager.release(true);
+                core::configManager.release(true, "vfoColors");
             }
         }
 
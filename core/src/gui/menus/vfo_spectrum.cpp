@@ -0,0 +1,101 @@
+#include <gui/menus/vfo_spectrum.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <gui/widgets/spectrum_view.h>
+#include <signal_path/signal_path.h>
+#include <utils/optionlist.h>
+#include <core.h>
+#include <vector>
+
+namespace vfo_spectrum_menu {
+    std::string selectedVFO = "";
+    std::string vfoNamesTxt = "";
+    int vfoId = 0;
+    int sizeId = 0;
+    OptionList<int, int> sizes;
+    ImGui::SpectrumView view;
+    std::vector<float> spectrum;
+
+    void init() {
+        // Define spectrum sizes
+        sizes.define(65536, "65536", 65536);
+        sizes.define(32768, "32768", 32768);
+        sizes.define(16384, "16384", 16384);
+        sizes.define(8192, "8192", 8192);
+        sizes.define(4096, "4096", 4096);
+        sizes.define(2048, "2048", 2048);
+        sizes.define(1024, "1024", 1024);
+        sizes.define(512, "512", 512);
+
+        core::configManager.acquire();
+        int size = core::configManager.conf["vfoSpectrumSize"];
+        sizeId = sizes.keyExists(size) ? sizes.keyId(size) : sizes.keyId(4096);
+        core::configManager.release();
+    }
+
+    void selectVFO(const std::string& name) {
+        // The spectrum is only computed for the VFO being shown
+        if (!selectedVFO.empty()) { sigpath::vfoManager.setSpectrumSize(selectedVFO, 0); }
+        selectedVFO = name;
+        view.clear();
+    }
+
+    void draw(void* ctx) {
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        // List the VFOs and keep the selection valid
+        vfoNamesTxt = "";
+        int id = 0;
+        vfoId = -1;
+        for (auto& [name, vfo] : gui::waterfall.vfos) {
+            if (name == selectedVFO) { vfoId = id; }
+            vfoNamesTxt += name;
+            vfoNamesTxt += '\0';
+            id++;
+        }
+        if (vfoId < 0) {
+            selectedVFO = "";
+            view.clear();
+            vfoId = 0;
+        }
+        if (gui::waterfall.vfos.empty()) {
+            ImGui::TextUnformatted("No VFO");
+            return;
+        }
+
+        ImGui::LeftLabel("VFO");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_vfo_spectrum_vfo", &vfoId, vfoNamesTxt.c_str())) {
+            auto it = gui::waterfall.vfos.begin();
+            std::advance(it, vfoId);
+            selectVFO(it->first);
+        }
+        if (selectedVFO.empty()) { selectedVFO = gui::waterfall.vfos.begin()->first; }
+
+        ImGui::LeftLabel("FFT Size");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_vfo_spectrum_size", &sizeId, sizes.txt)) {
+            if (sigpath::vfoManager.getSpectrumSize(selectedVFO)) {
+                sigpath::vfoManager.setSpectrumSize(selectedVFO, sizes.value(sizeId));
+                view.clear();
+            }
+            core::configManager.acquire();
+            core::configManager.conf["vfoSpectrumSize"] = sizes.key(sizeId);
+            core::configManager.release(true, "vfoSpectrumSize");
+        }
+
+        bool enabled = sigpath::vfoManager.getSpectrumSize(selectedVFO);
+        if (ImGui::Checkbox("Show Spectrum##sdrpp_vfo_spectrum", &enabled)) {
+            sigpath::vfoManager.setSpectrumSize(selectedVFO, enabled ? sizes.value(sizeId) : 0);
+            view.clear();
+        }
+        if (!enabled) { return; }
+
+        // Show the latest spectrum of the VFO
+        dsp::fft::Spectrum* spec = sigpath::vfoManager.getSpectrum(selectedVFO);
+        if (!spec) { return; }
+        spectrum.resize(spec->getSize());
+        if (spec->read(spectrum.data())) { view.push(spectrum.data(), spectrum.size()); }
+        view.draw(gui::waterfall.getFFTMin(), gui::waterfall.getFFTMax(), spec->getSamplerate(), ImVec2(menuWidth, 200.0f * style::uiScale));
+    }
+}
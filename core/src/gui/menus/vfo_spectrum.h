@@ -0,0 +1,6 @@
+#pragma once
+
+namespace vfo_spectrum_menu {
+    void init();
+    void draw(void* ctx);
+}
@@ -376,6 +376,222 @@ namespace SmGui {
         return size;
     }
 
+    // Tag of an encoded element, the kind in the low bits and a flag holding the force sync of a step, the value of a
+    // bool or whether a string is interned
+    enum CodecKind {
+        CODEC_KIND_STEP,
+        CODEC_KIND_BOOL,
+        CODEC_KIND_INT,
+        CODEC_KIND_FLOAT,
+        CODEC_KIND_STRING,
+        CODEC_KIND_STRING_REF
+    };
+    #define CODEC_TAG_KIND_MASK     0x07
+    #define CODEC_TAG_FLAG          0x08
+
+    static int writeVarint(uint8_t* buf, int len, uint32_t val) {
+        int i = 0;
+        do {
+            if (i >= len) { return -1; }
+            uint8_t b = val & 0x7F;
+            val >>= 7;
+            buf[i++] = b | (val ? 0x80 : 0);
+        } while (val);
+        return i;
+    }
+
+    static int readVarint(const uint8_t* buf, int len, uint32_t& val) {
+        val = 0;
+        for (int i = 0; i < 5 && i < len; i++) {
+            val |= (uint32_t)(buf[i] & 0x7F) << (7 * i);
+            if (!(buf[i] & 0x80)) { return i + 1; }
+        }
+        return -1;
+    }
+
+    static bool sameElem(const DrawListElem& a, const DrawListElem& b) {
+        if (a.type != b.type) { return false; }
+        switch (a.type) {
+            case DRAW_LIST_ELEM_TYPE_DRAW_STEP: return a.step == b.step && a.forceSync == b.forceSync;
+            case DRAW_LIST_ELEM_TYPE_BOOL:      return a.b == b.b;
+            case DRAW_LIST_ELEM_TYPE_INT:       return a.i == b.i;
+            case DRAW_LIST_ELEM_TYPE_FLOAT:     return memcmp(&a.f, &b.f, sizeof(float)) == 0;
+            case DRAW_LIST_ELEM_TYPE_STRING:    return a.str == b.str;
+        }
+        return false;
+    }
+
+    void DrawListCodec::reset() {
+        last.clear();
+        ids.clear();
+        strings.clear();
+    }
+
+    int DrawListCodec::encodeItem(const DrawListElem& elem, void* data, int len) {
+        uint8_t* buf = (uint8_t*)data;
+        if (len < 1) { return -1; }
+        int i = 1;
+        int n;
+
+        switch (elem.type) {
+            case DRAW_LIST_ELEM_TYPE_DRAW_STEP:
+                if (len < 2) { return -1; }
+                buf[0] = CODEC_KIND_STEP | (elem.forceSync ? CODEC_TAG_FLAG : 0);
+                buf[i++] = elem.step;
+                return i;
+            case DRAW_LIST_ELEM_TYPE_BOOL:
+                buf[0] = CODEC_KIND_BOOL | (elem.b ? CODEC_TAG_FLAG : 0);
+                return i;
+            case DRAW_LIST_ELEM_TYPE_INT:
+                // Zigzag so that small negative values stay short
+                buf[0] = CODEC_KIND_INT;
+                n = writeVarint(&buf[i], len - i, ((uint32_t)elem.i << 1) ^ (uint32_t)(elem.i >> 31));
+                return (n < 0) ? -1 : i + n;
+            case DRAW_LIST_ELEM_TYPE_FLOAT:
+                if (len < 5) { return -1; }
+                buf[0] = CODEC_KIND_FLOAT;
+                memcpy(&buf[i], &elem.f, sizeof(float));
+                return i + sizeof(float);
+            case DRAW_LIST_ELEM_TYPE_STRING:
+                break;
+            default:
+                return -1;
+        }
+
+        // Strings already in the table only take their index
+        auto it = ids.find(elem.str);
+        if (it != ids.end()) {
+            buf[0] = CODEC_KIND_STRING_REF;
+            n = writeVarint(&buf[i], len - i, it->second);
+            return (n < 0) ? -1 : i + n;
+        }
+        bool intern = (ids.size() < SMGUI_CODEC_MAX_STRINGS);
+        buf[0] = CODEC_KIND_STRING | (intern ? CODEC_TAG_FLAG : 0);
+        n = writeVarint(&buf[i], len - i, elem.str.size());
+        if (n < 0 || len - i - n < (int)elem.str.size()) { return -1; }
+        i += n;
+        memcpy(&buf[i], elem.str.c_str(), elem.str.size());
+        i += elem.str.size();
+        if (intern) {
+            uint32_t id = ids.size();
+            ids[elem.str] = id;
+        }
+        return i;
+    }
+
+    int DrawListCodec::decodeItem(DrawListElem& elem, const void* data, int len) {
+        const uint8_t* buf = (const uint8_t*)data;
+        if (len < 1) { return -1; }
+        int kind = buf[0] & CODEC_TAG_KIND_MASK;
+        bool flag = buf[0] & CODEC_TAG_FLAG;
+        int i = 1;
+        int n;
+        uint32_t val;
+
+        switch (kind) {
+            case CODEC_KIND_STEP:
+                if (len < 2) { return -1; }
+                elem.type = DRAW_LIST_ELEM_TYPE_DRAW_STEP;
+                elem.step = (DrawStep)buf[i++];
+                elem.forceSync = flag;
+                return i;
+            case CODEC_KIND_BOOL:
+                elem.type = DRAW_LIST_ELEM_TYPE_BOOL;
+                elem.b = flag;
+                return i;
+            case CODEC_KIND_INT:
+                n = readVarint(&buf[i], len - i, val);
+                if (n < 0) { return -1; }
+                elem.type = DRAW_LIST_ELEM_TYPE_INT;
+                elem.i = (int)((val >> 1) ^ (~(val & 1) + 1));
+                return i + n;
+            case CODEC_KIND_FLOAT:
+                if (len < 5) { return -1; }
+                elem.type = DRAW_LIST_ELEM_TYPE_FLOAT;
+                memcpy(&elem.f, &buf[i], sizeof(float));
+                return i + sizeof(float);
+            case CODEC_KIND_STRING:
+                n = readVarint(&buf[i], len - i, val);
+                if (n < 0 || len - i - n < (int)val) { return -1; }
+                i += n;
+                elem.type = DRAW_LIST_ELEM_TYPE_STRING;
+                elem.str = std::string((const char*)&buf[i], val);
+                if (flag) { strings.push_back(elem.str); }
+                return i + val;
+            case CODEC_KIND_STRING_REF:
+                n = readVarint(&buf[i], len - i, val);
+                if (n < 0 || val >= strings.size()) { return -1; }
+                elem.type = DRAW_LIST_ELEM_TYPE_STRING;
+                elem.str = strings[val];
+                return i + n;
+        }
+        return -1;
+    }
+
+    int DrawListCodec::encode(const DrawList& dl, void* data, int len) {
+        uint8_t* buf = (uint8_t*)data;
+        const std::vector<DrawListElem>& elems = dl.elements;
+        int count = elems.size();
+        int lastCount = last.size();
+
+        // Elements shared with the previous list at the start, then at the end without overlapping the start
+        int prefix = 0;
+        int shared = std::min<int>(count, lastCount);
+        while (prefix < shared && sameElem(elems[prefix], last[prefix])) { prefix++; }
+        int suffix = 0;
+        while (suffix < shared - prefix && sameElem(elems[count - 1 - suffix], last[lastCount - 1 - suffix])) { suffix++; }
+
+        int i = 0;
+        int n;
+        if ((n = writeVarint(&buf[i], len - i, prefix)) < 0) { return -1; }
+        i += n;
+        if ((n = writeVarint(&buf[i], len - i, suffix)) < 0) { return -1; }
+        i += n;
+        if ((n = writeVarint(&buf[i], len - i, count - prefix - suffix)) < 0) { return -1; }
+        i += n;
+        for (int j = prefix; j < count - suffix; j++) {
+            if ((n = encodeItem(elems[j], &buf[i], len - i)) < 0) { return -1; }
+            i += n;
+        }
+
+        last = elems;
+        return i;
+    }
+
+    int DrawListCodec::decode(DrawList& dl, const void* data, int len) {
+        const uint8_t* buf = (const uint8_t*)data;
+        uint32_t prefix, suffix, count;
+        int i = 0;
+        int n;
+        if ((n = readVarint(&buf[i], len - i, prefix)) < 0) { return -1; }
+        i += n;
+        if ((n = readVarint(&buf[i], len - i, suffix)) < 0) { return -1; }
+        i += n;
+        if ((n = readVarint(&buf[i], len - i, count)) < 0) { return -1; }
+        i += n;
+        if ((uint64_t)prefix + suffix > last.size()) { return -1; }
+
+        std::vector<DrawListElem> elems(last.begin(), last.begin() + prefix);
+        for (uint32_t j = 0; j < count; j++) {
+            DrawListElem elem;
+            if ((n = decodeItem(elem, &buf[i], len - i)) < 0) { return -1; }
+            i += n;
+            elems.push_back(elem);
+        }
+        elems.insert(elems.end(), last.end() - suffix, last.end());
+
+        // Validate before replacing the list being drawn
+        DrawList decoded;
+        decoded.elements = std::move(elems);
+        if (!decoded.validate()) {
+            flog::error("Drawlist validation failed");
+            return -1;
+        }
+        last = decoded.elements;
+        dl.elements.swap(decoded.elements);
+        return i;
+    }
+
     bool DrawList::checkTypes(int firstId, int n, ...) {
         va_list args;
         va_start(args, n);
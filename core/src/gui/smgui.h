@@ -5,6 +5,9 @@
 #include <vector>
 #include <map>
 
+// Strings interned by a draw list codec past this many are sent in full every time
+#define SMGUI_CODEC_MAX_STRINGS     4096
+
 namespace SmGui {
     enum DrawStep {
         // Format calls
@@ -99,6 +102,32 @@ namespace SmGui {
         std::vector<DrawListElem> elements;
     };
 
+    // Keeps what was last exchanged with a peer to send draw lists in a few bytes. A list is encoded as the number of
+    // elements it shares at its start and at its end with the previous one, followed by the elements in between. Strings
+    // are interned, the first time one is sent it takes the next index of a table both sides keep and only that index is
+    // sent afterwards. Ints are sent as variable length integers. A codec is either used to encode or to decode, and must
+    // be reset on both sides at the same time
+    class DrawListCodec {
+    public:
+        void reset();
+
+        // Encode a list against the previous one, returns the size written or -1 if it doesn't fit
+        int encode(const DrawList& dl, void* data, int len);
+
+        // Decode a list against the previous one, returns the size read or -1 if invalid, in which case the codec must
+        // be reset
+        int decode(DrawList& dl, const void* data, int len);
+
+        // Encode and decode single elements, with the strings interned
+        int encodeItem(const DrawListElem& elem, void* data, int len);
+        int decodeItem(DrawListElem& elem, const void* data, int len);
+
+    private:
+        std::vector<DrawListElem> last;
+        std::map<std::string, uint32_t> ids;
+        std::vector<std::string> strings;
+    };
+
     // Rec/Play functions
     // TODO: Maybe move verification to the load function instead of checking in drawFrame
     void init(bool server);
@@ -4,6 +4,13 @@
 #include <config.h>
 #include <utils/flog.h>
 #include <filesystem>
+#include <fstream>
+#include <vector>
+#include <string.h>
+
+// Bump when the layout of the font cache changes
+#define FONT_CACHE_VERSION  1
+#define FONT_CACHE_MAGIC    "SDRPPFNT"
 
 namespace style {
     ImFont* baseFont;
@@ -19,7 +26,173 @@ namespace style {
     float uiScale = 3.0f;
 #endif
 
-    bool loadFonts(std::string resDir) {
+    // FNV-1a, used to identify the inputs of the font atlas
+    void hashBytes(uint64_t& hash, const void* data, size_t len) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < len; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ULL;
+        }
+    }
+
+    template <class T>
+    void hashValue(uint64_t& hash, const T& value) {
+        hashBytes(hash, &value, sizeof(T));
+    }
+
+    // Everything the baked atlas depends on: the font file, sizes, ranges, atlas settings and ImGui's own layout
+    uint64_t fontCacheKey(const std::vector<char>& fontData, ImFontAtlas* fonts, const ImVector<ImWchar>* ranges[], int rangeCount) {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        hashValue(hash, (int)FONT_CACHE_VERSION);
+        hashValue(hash, (int)IMGUI_VERSION_NUM);
+        hashValue(hash, sizeof(ImFontGlyph));
+        hashValue(hash, sizeof(ImFontAtlasCustomRect));
+        hashValue(hash, uiScale);
+        hashValue(hash, fonts->Flags);
+        hashValue(hash, fonts->TexDesiredWidth);
+        hashValue(hash, fonts->TexGlyphPadding);
+        hashBytes(hash, fontData.data(), fontData.size());
+        for (int i = 0; i < rangeCount; i++) {
+            hashBytes(hash, ranges[i]->Data, ranges[i]->Size * sizeof(ImWchar));
+        }
+        return hash;
+    }
+
+    bool loadFontCache(const std::string& path, uint64_t key, ImFontAtlas* fonts, const float* sizes, int fontCount) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) { return false; }
+        auto get = [&file](void* data, size_t len) { return (bool)file.read((char*)data, len); };
+
+        // Check that the cache was made from the same inputs
+        char magic[8];
+        uint64_t cachedKey;
+        int count;
+        if (!get(magic, 8) || memcmp(magic, FONT_CACHE_MAGIC, 8) || !get(&cachedKey, sizeof(cachedKey)) || cachedKey != key) { return false; }
+        if (!get(&count, sizeof(count)) || count != fontCount) { return false; }
+
+        // Texture and atlas metrics
+        int width, height, rectCount;
+        ImVec2 uvScale, uvWhitePixel;
+        ImVec4 uvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+        int packIdMouseCursors, packIdLines;
+        if (!get(&width, sizeof(width)) || !get(&height, sizeof(height)) || width <= 0 || height <= 0) { return false; }
+        get(&uvScale, sizeof(uvScale));
+        get(&uvWhitePixel, sizeof(uvWhitePixel));
+        get(uvLines, sizeof(uvLines));
+        get(&packIdMouseCursors, sizeof(packIdMouseCursors));
+        get(&packIdLines, sizeof(packIdLines));
+        if (!get(&rectCount, sizeof(rectCount)) || rectCount < 0) { return false; }
+        std::vector<ImFontAtlasCustomRect> rects(rectCount);
+        for (auto& rect : rects) {
+            get(&rect, sizeof(rect));
+            rect.Font = NULL;
+        }
+        std::vector<unsigned char> pixels((size_t)width * height);
+        if (!get(pixels.data(), pixels.size())) { return false; }
+
+        // Glyphs of each font
+        struct CachedFont {
+            float ascent, descent;
+            int surface;
+            std::vector<ImFontGlyph> glyphs;
+        };
+        std::vector<CachedFont> cached(fontCount);
+        for (auto& cf : cached) {
+            int glyphCount;
+            get(&cf.ascent, sizeof(cf.ascent));
+            get(&cf.descent, sizeof(cf.descent));
+            get(&cf.surface, sizeof(cf.surface));
+            if (!get(&glyphCount, sizeof(glyphCount)) || glyphCount < 0) { return false; }
+            cf.glyphs.resize(glyphCount);
+            if (!get(cf.glyphs.data(), glyphCount * sizeof(ImFontGlyph))) { return false; }
+        }
+
+        // Everything was read, set the atlas up as Build() would have. The configs have no font data, the atlas must
+        // not be built again
+        for (int i = 0; i < fontCount; i++) {
+            ImFontConfig cfg;
+            cfg.FontDataOwnedByAtlas = false;
+            cfg.SizePixels = sizes[i];
+            snprintf(cfg.Name, sizeof(cfg.Name), "Roboto-Medium.ttf, %dpx (cached)", (int)sizes[i]);
+            fonts->ConfigData.push_back(cfg);
+        }
+        for (int i = 0; i < fontCount; i++) {
+            ImFont* font = IM_NEW(ImFont);
+            fonts->Fonts.push_back(font);
+            font->ContainerAtlas = fonts;
+            font->ConfigData = &fonts->ConfigData[i];
+            font->ConfigDataCount = 1;
+            fonts->ConfigData[i].DstFont = font;
+            font->FontSize = sizes[i];
+            font->Ascent = cached[i].ascent;
+            font->Descent = cached[i].descent;
+            font->MetricsTotalSurface = cached[i].surface;
+            for (const auto& glyph : cached[i].glyphs) { font->Glyphs.push_back(glyph); }
+            font->BuildLookupTable();
+        }
+        fonts->CustomRects.clear();
+        for (const auto& rect : rects) { fonts->CustomRects.push_back(rect); }
+        fonts->PackIdMouseCursors = packIdMouseCursors;
+        fonts->PackIdLines = packIdLines;
+        fonts->TexWidth = width;
+        fonts->TexHeight = height;
+        fonts->TexUvScale = uvScale;
+        fonts->TexUvWhitePixel = uvWhitePixel;
+        memcpy(fonts->TexUvLines, uvLines, sizeof(uvLines));
+        fonts->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(pixels.size());
+        memcpy(fonts->TexPixelsAlpha8, pixels.data(), pixels.size());
+        fonts->TexReady = true;
+        return true;
+    }
+
+    void saveFontCache(const std::string& path, uint64_t key, ImFontAtlas* fonts) {
+        // Only the alpha texture can be cached, and custom rects only if they don't belong to a font
+        unsigned char* pixels;
+        int width, height;
+        fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+        if (!pixels) { return; }
+        for (const auto& rect : fonts->CustomRects) {
+            if (rect.Font) { return; }
+        }
+
+        std::string tmpPath = path + ".tmp";
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        auto put = [&file](const void* data, size_t len) { file.write((const char*)data, len); };
+        int count = fonts->Fonts.Size;
+        int rectCount = fonts->CustomRects.Size;
+        put(FONT_CACHE_MAGIC, 8);
+        put(&key, sizeof(key));
+        put(&count, sizeof(count));
+        put(&width, sizeof(width));
+        put(&height, sizeof(height));
+        put(&fonts->TexUvScale, sizeof(fonts->TexUvScale));
+        put(&fonts->TexUvWhitePixel, sizeof(fonts->TexUvWhitePixel));
+        put(fonts->TexUvLines, sizeof(fonts->TexUvLines));
+        put(&fonts->PackIdMouseCursors, sizeof(fonts->PackIdMouseCursors));
+        put(&fonts->PackIdLines, sizeof(fonts->PackIdLines));
+        put(&rectCount, sizeof(rectCount));
+        put(fonts->CustomRects.Data, rectCount * sizeof(ImFontAtlasCustomRect));
+        put(pixels, (size_t)width * height);
+        for (ImFont* font : fonts->Fonts) {
+            int glyphCount = font->Glyphs.Size;
+            put(&font->Ascent, sizeof(font->Ascent));
+            put(&font->Descent, sizeof(font->Descent));
+            put(&font->MetricsTotalSurface, sizeof(font->MetricsTotalSurface));
+            put(&glyphCount, sizeof(glyphCount));
+            put(font->Glyphs.Data, glyphCount * sizeof(ImFontGlyph));
+        }
+        file.close();
+        if (file.fail()) {
+            flog::warn("Could not write font cache {0}", tmpPath);
+            return;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) { flog::warn("Could not write font cache {0}: {1}", path, ec.message()); }
+    }
+
+    bool loadFonts(std::string resDir, std::string cacheDir) {
         ImFontAtlas* fonts = ImGui::GetIO().Fonts;
         if (!std::filesystem::is_directory(resDir)) {
             flog::error("Invalid resource directory: {0}", resDir);
@@ -43,11 +216,34 @@ namespace style {
         const ImWchar hugeRange[] = { 'S', 'S', 'D', 'D', 'R', 'R', '+', '+', ' ', ' ', 0 };
         hugeBuilder.AddRanges(hugeRange);
         hugeBuilder.BuildRanges(&hugeRanges);
+
+        // Reuse the atlas baked on a previous start if nothing it depends on changed. Only done for a fresh atlas
+        std::string fontPath = resDir + "/fonts/Roboto-Medium.ttf";
+        std::string cachePath = cacheDir.empty() ? "" : (cacheDir + "/font_cache.bin");
+        const float sizes[3] = { 16.0f * uiScale, 45.0f * uiScale, 128.0f * uiScale };
+        uint64_t key = 0;
+        bool useCache = !cachePath.empty() && fonts->Fonts.empty();
+        if (useCache) {
+            std::ifstream file(fontPath, std::ios::binary);
+            std::vector<char> fontData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            const ImVector<ImWchar>* ranges[3] = { &baseRanges, &bigRanges, &hugeRanges };
+            key = fontCacheKey(fontData, fonts, ranges, 3);
+            if (loadFontCache(cachePath, key, fonts, sizes, 3)) {
+                baseFont = fonts->Fonts[0];
+                bigFont = fonts->Fonts[1];
+                hugeFont = fonts->Fonts[2];
+                flog::info("Loaded font atlas from {0}", cachePath);
+                return true;
+            }
+        }
         
         // Add bigger fonts for frequency select and title
-        baseFont = fonts->AddFontFromFileTTF(((std::string)(resDir + "/fonts/Roboto-Medium.ttf")).c_str(), 16.0f * uiScale, NULL, baseRanges.Data);
-        bigFont = fonts->AddFontFromFileTTF(((std::string)(resDir + "/fonts/Roboto-Medium.ttf")).c_str(), 45.0f * uiScale, NULL, bigRanges.Data);
-        hugeFont = fonts->AddFontFromFileTTF(((std::string)(resDir + "/fonts/Roboto-Medium.ttf")).c_str(), 128.0f * uiScale, NULL, hugeRanges.Data);
+        baseFont = fonts->AddFontFromFileTTF(fontPath.c_str(), sizes[0], NULL, baseRanges.Data);
+        bigFont = fonts->AddFontFromFileTTF(fontPath.c_str(), sizes[1], NULL, bigRanges.Data);
+        hugeFont = fonts->AddFontFromFileTTF(fontPath.c_str(), sizes[2], NULL, hugeRanges.Data);
+
+        // Bake the atlas now instead of on the first frame so that it can be cached
+        if (useCache && fonts->Build()) { saveFontCache(cachePath, key, fonts); }
 
         return true;
     }
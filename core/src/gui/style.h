@@ -10,7 +10,8 @@ namespace style {
     SDRPP_EXPORT float uiScale;
 
     bool setDefaultStyle(std::string resDir);
-    bool loadFonts(std::string resDir);
+    // The baked font atlas is cached in cacheDir if given, and reloaded from there as long as the font and scale match
+    bool loadFonts(std::string resDir, std::string cacheDir = "");
     void beginDisabled();
     void endDisabled();
     void testtt();
@@ -4,12 +4,16 @@
 #include <filesystem>
 #include <sstream>
 #include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <math.h>
 
 namespace bandplan {
     std::map<std::string, BandPlan_t> bandplans;
     std::vector<std::string> bandplanNames;
     std::string bandplanNameTxt;
     std::map<std::string, BandPlanColor_t> colorTable;
+    std::thread loaderThread;
 
     void generateTxt() {
         bandplanNameTxt = "";
@@ -53,6 +57,44 @@ namespace bandplan {
         j.at("author_name").get_to(b.authorName);
         j.at("author_url").get_to(b.authorURL);
         j.at("bands").get_to(b.bands);
+
+        // Index the bands by start
+        b.startOrder.resize(b.bands.size());
+        for (int i = 0; i < b.bands.size(); i++) { b.startOrder[i] = i; }
+        std::stable_sort(b.startOrder.begin(), b.startOrder.end(), [&b](int x, int y) { return b.bands[x].start < b.bands[y].start; });
+        b.maxEnd.resize(b.bands.size());
+        double maxEnd = -INFINITY;
+        for (int i = 0; i < b.startOrder.size(); i++) {
+            maxEnd = std::max<double>(maxEnd, b.bands[b.startOrder[i]].end);
+            b.maxEnd[i] = maxEnd;
+        }
+        b.layoutValid = false;
+    }
+
+    void findBands(const BandPlan_t& plan, double low, double high, int& first, int& last) {
+        // Bands starting after the high edge are past the view, and maxEnd only grows so the bands before the first
+        // entry reaching the low edge all end before it
+        auto endIt = std::upper_bound(plan.startOrder.begin(), plan.startOrder.end(), high, [&plan](double freq, int i) {
+            return freq < plan.bands[i].start;
+        });
+        last = std::distance(plan.startOrder.begin(), endIt);
+        first = std::distance(plan.maxEnd.begin(), std::lower_bound(plan.maxEnd.begin(), plan.maxEnd.begin() + last, low));
+    }
+
+    void updateLayout(BandPlan_t& plan) {
+        if (plan.layoutValid) { return; }
+        int count = plan.bands.size();
+        plan.nameSizes.resize(count);
+        plan.colors.resize(count);
+        plan.transColors.resize(count);
+        for (int i = 0; i < count; i++) {
+            const Band_t& band = plan.bands[i];
+            plan.nameSizes[i] = ImGui::CalcTextSize(band.name.c_str());
+            auto it = colorTable.find(band.type);
+            plan.colors[i] = (it != colorTable.end()) ? it->second.colorValue : IM_COL32(255, 255, 255, 255);
+            plan.transColors[i] = (it != colorTable.end()) ? it->second.transColorValue : IM_COL32(255, 255, 255, 100);
+        }
+        plan.layoutValid = true;
     }
 
     void to_json(json& j, const BandPlanColor_t& ct) {
@@ -108,7 +150,17 @@ namespace bandplan {
         }
     }
 
+    void loadFromDirAsync(std::string path) {
+        waitLoaded();
+        loaderThread = std::thread(loadFromDir, path);
+    }
+
+    void waitLoaded() {
+        if (loaderThread.joinable()) { loaderThread.join(); }
+    }
+
     void loadColorTable(json table) {
         colorTable = table.get<std::map<std::string, BandPlanColor_t>>();
+        for (auto& [name, plan] : bandplans) { plan.layoutValid = false; }
     }
 };
\ No newline at end of file
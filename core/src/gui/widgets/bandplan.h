@@ -2,6 +2,7 @@
 #include <json.hpp>
 #include <imgui/imgui.h>
 #include <stdint.h>
+#include <vector>
 
 using nlohmann::json;
 
@@ -23,6 +24,16 @@ namespace bandplan {
         std::string authorName;
         std::string authorURL;
         std::vector<Band_t> bands;
+
+        // Bands by start frequency along with the highest end of the bands up to each of them, built on load
+        std::vector<int> startOrder;
+        std::vector<double> maxEnd;
+
+        // Size of the name and colors of each band, computed on first draw since they need the font
+        std::vector<ImVec2> nameSizes;
+        std::vector<uint32_t> colors;
+        std::vector<uint32_t> transColors;
+        bool layoutValid = false;
     };
 
     void to_json(json& j, const BandPlan_t& b);
@@ -36,8 +47,19 @@ namespace bandplan {
     void to_json(json& j, const BandPlanColor_t& ct);
     void from_json(const json& j, BandPlanColor_t& ct);
 
+    // Range of startOrder holding every band that overlaps [low, high]. Bands in the range that end before low must
+    // still be skipped, they are nested in an earlier, longer band
+    void findBands(const BandPlan_t& plan, double low, double high, int& first, int& last);
+
+    // Measure the names and look up the colors of the bands if not done yet
+    void updateLayout(BandPlan_t& plan);
+
     void loadBandPlan(std::string path);
     void loadFromDir(std::string path);
+
+    // Load the band plans of a directory on a thread of their own, waitLoaded() must be called before using them
+    void loadFromDirAsync(std::string path);
+    void waitLoaded();
     void loadColorTable(json table);
 
     extern std::map<std::string, BandPlan_t> bandplans;
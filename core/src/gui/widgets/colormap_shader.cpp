@@ -0,0 +1,181 @@
+#include <gui/widgets/colormap_shader.h>
+#include <gui/widgets/gl_functions.h>
+#include <utils/flog.h>
+#include <string>
+#include <algorithm>
+
+namespace ImGui {
+    const char* COLORMAP_VERTEX_SHADER =
+        "uniform mat4 ProjMtx;\n"
+        "in vec2 Position;\n"
+        "in vec2 UV;\n"
+        "in vec4 Color;\n"
+        "out vec2 Frag_UV;\n"
+        "void main() {\n"
+        "    Frag_UV = UV;\n"
+        "    gl_Position = ProjMtx * vec4(Position.xy, 0, 1);\n"
+        "}\n";
+
+    const char* COLORMAP_FRAGMENT_SHADER =
+        "uniform sampler2D Texture;\n"
+        "uniform sampler2D Palette;\n"
+        "uniform float Low;\n"
+        "uniform float Scale;\n"
+        "in vec2 Frag_UV;\n"
+        "out vec4 Out_Color;\n"
+        "void main() {\n"
+        "    float v = texture(Texture, Frag_UV).r;\n"
+        "    if (v < BLANK) { Out_Color = vec4(0.0, 0.0, 0.0, 1.0); return; }\n"
+        "    float x = clamp((v - Low) * Scale, 0.0, 1.0);\n"
+        "    Out_Color = texture(Palette, vec2((x * (PALETTE_SIZE - 1.0) + 0.5) / PALETTE_SIZE, 0.5));\n"
+        "}\n";
+
+    static GLuint compileShader(GLenum type, const std::string& header, const char* source) {
+        GLuint shader = gl::CreateShader(type);
+        const char* sources[2] = { header.c_str(), source };
+        gl::ShaderSource(shader, 2, sources, NULL);
+        gl::CompileShader(shader);
+        GLint status = 0;
+        gl::GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (!status) {
+            char log[1024] = { 0 };
+            gl::GetShaderInfoLog(shader, sizeof(log) - 1, NULL, log);
+            flog::warn("Could not compile the colormap shader: {}", log);
+            return 0;
+        }
+        return shader;
+    }
+
+    bool ColormapShader::init() {
+        // Pick the GLSL version matching the context, single channel float textures need at least GL 3.0 or GL ES 3.0
+        int major, minor;
+        bool es;
+        if (!gl::getVersion(major, minor, es)) { return false; }
+        if (major < 3) {
+            flog::info("OpenGL {}.{} doesn't support the GPU colormap, coloring the waterfall on the CPU", major, minor);
+            return false;
+        }
+        std::string header;
+        if (es) { header = "#version 300 es\nprecision highp float;\n"; }
+        else if (major > 3 || minor >= 2) { header = "#version 150\n"; }
+        else { header = "#version 130\n"; }
+
+        if (!gl::load()) {
+            flog::warn("Could not load the OpenGL functions needed by the GPU colormap");
+            return false;
+        }
+
+        // Compile the shaders, linking is done on the first draw to use the same attribute locations as ImGui
+        header += "#define BLANK " + std::to_string(COLORMAP_SHADER_BLANK) + "\n";
+        header += "#define PALETTE_SIZE " + std::to_string((float)COLORMAP_SHADER_PALETTE_SIZE) + "\n";
+        vertexShader = compileShader(GL_VERTEX_SHADER, header, COLORMAP_VERTEX_SHADER);
+        fragmentShader = compileShader(GL_FRAGMENT_SHADER, header, COLORMAP_FRAGMENT_SHADER);
+        if (!vertexShader || !fragmentShader) { return false; }
+
+        glGenTextures(1, &paletteTex);
+        available = true;
+        return true;
+    }
+
+    void ColormapShader::setPalette(const uint32_t* colors, int count) {
+        if (!available) { return; }
+        // Linearly interpolate each channel between the two colors around each entry
+        uint32_t resampled[COLORMAP_SHADER_PALETTE_SIZE];
+        for (int i = 0; i < COLORMAP_SHADER_PALETTE_SIZE; i++) {
+            float pos = (float)i * (float)(count - 1) / (float)(COLORMAP_SHADER_PALETTE_SIZE - 1);
+            int k = std::min<int>((int)pos, count - 1);
+            int next = std::min<int>(k + 1, count - 1);
+            float frac = pos - (float)k;
+            uint32_t color = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                float a = (float)((colors[k] >> shift) & 0xFF);
+                float b = (float)((colors[next] >> shift) & 0xFF);
+                color |= (uint32_t)(a + (b - a) * frac + 0.5f) << shift;
+            }
+            resampled[i] = color;
+        }
+        glBindTexture(GL_TEXTURE_2D, paletteTex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, COLORMAP_SHADER_PALETTE_SIZE, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, (const uint8_t*)resampled);
+    }
+
+    void ColormapShader::uploadTexture(GLuint texture, int width, int height, const float* data) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_FLOAT, data);
+    }
+
+    void ColormapShader::uploadRows(GLuint texture, int width, int y, int rows, const float* data) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RED, GL_FLOAT, data);
+    }
+
+    void ColormapShader::addImage(ImDrawList* drawList, GLuint texture, const ImVec2& min, const ImVec2& max, const ImVec2& uv0, const ImVec2& uv1, float low, float high) {
+        _low = low;
+        _scale = 1.0f / std::max<float>(high - low, 1e-6f);
+        drawList->AddCallback(drawCallback, this);
+        drawList->AddImage((void*)(intptr_t)texture, min, max, uv0, uv1);
+        drawList->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+    }
+
+    void ColormapShader::drawCallback(const ImDrawList* list, const ImDrawCmd* cmd) {
+        ColormapShader* _this = (ColormapShader*)cmd->UserCallbackData;
+
+        // Link the first time using the attributes of the ImGui shader since its vertex setup is reused
+        GLint imguiProgram = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &imguiProgram);
+        if (!_this->linked && !_this->link(imguiProgram)) { return; }
+
+        // Reuse the projection set up by ImGui for this draw list
+        float proj[16];
+        gl::GetUniformfv(imguiProgram, gl::GetUniformLocation(imguiProgram, "ProjMtx"), proj);
+
+        gl::UseProgram(_this->program);
+        gl::UniformMatrix4fv(_this->projLoc, 1, GL_FALSE, proj);
+        gl::Uniform1i(_this->textureLoc, 0);
+        gl::Uniform1i(_this->paletteLoc, 1);
+        gl::Uniform1f(_this->lowLoc, _this->_low);
+        gl::Uniform1f(_this->scaleLoc, _this->_scale);
+
+        // The waterfall texture itself is bound to unit 0 by ImGui
+        gl::ActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, _this->paletteTex);
+        gl::ActiveTexture(GL_TEXTURE0);
+    }
+
+    bool ColormapShader::link(GLuint imguiProgram) {
+        program = gl::CreateProgram();
+        gl::AttachShader(program, vertexShader);
+        gl::AttachShader(program, fragmentShader);
+        const char* attribs[3] = { "Position", "UV", "Color" };
+        for (const char* attrib : attribs) {
+            GLint loc = gl::GetAttribLocation(imguiProgram, attrib);
+            if (loc >= 0) { gl::BindAttribLocation(program, loc, attrib); }
+        }
+        gl::LinkProgram(program);
+        linked = true;
+
+        GLint status = 0;
+        gl::GetProgramiv(program, GL_LINK_STATUS, &status);
+        if (!status) {
+            flog::warn("Could not link the colormap shader, coloring the waterfall on the CPU");
+            available = false;
+            return false;
+        }
+
+        projLoc = gl::GetUniformLocation(program, "ProjMtx");
+        textureLoc = gl::GetUniformLocation(program, "Texture");
+        paletteLoc = gl::GetUniformLocation(program, "Palette");
+        lowLoc = gl::GetUniformLocation(program, "Low");
+        scaleLoc = gl::GetUniformLocation(program, "Scale");
+        return true;
+    }
+}
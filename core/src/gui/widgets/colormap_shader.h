@@ -0,0 +1,61 @@
+#pragma once
+#include <imgui.h>
+#include <imgui_internal.h>
+#include <stdint.h>
+
+#include <utils/opengl_include_code.h>
+
+// Values lower than this are drawn black instead of going through the palette
+#define COLORMAP_SHADER_BLANK   -10000.0f
+
+// Number of palette entries kept on the GPU, the colors in between are interpolated
+#define COLORMAP_SHADER_PALETTE_SIZE    1024
+
+namespace ImGui {
+    // Draws a single channel float texture through a palette. The scaling of the values and the palette
+    // lookup are done in a fragment shader, so changing the range or the palette costs nothing on the CPU.
+    // Requires OpenGL 3.0 or OpenGL ES 3.0, init() returns false otherwise.
+    class ColormapShader {
+    public:
+        ColormapShader() {}
+
+        // Must be called with the OpenGL context current
+        bool init();
+
+        // Can become false after the first draw if the shader failed to link
+        bool isAvailable() { return available; }
+
+        // Upload the palette, colors are packed RGBA and resampled to COLORMAP_SHADER_PALETTE_SIZE entries
+        void setPalette(const uint32_t* colors, int count);
+
+        // Allocate a texture and upload all its rows
+        void uploadTexture(GLuint texture, int width, int height, const float* data);
+
+        // Upload some rows of a texture allocated by uploadTexture()
+        void uploadRows(GLuint texture, int width, int y, int rows, const float* data);
+
+        // Draw the texture mapping values from low to high to the whole palette
+        void addImage(ImDrawList* drawList, GLuint texture, const ImVec2& min, const ImVec2& max, const ImVec2& uv0, const ImVec2& uv1, float low, float high);
+
+    private:
+        static void drawCallback(const ImDrawList* list, const ImDrawCmd* cmd);
+        bool link(GLuint imguiProgram);
+
+        bool available = false;
+        bool linked = false;
+
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        GLuint program = 0;
+        GLuint paletteTex = 0;
+
+        int projLoc = -1;
+        int textureLoc = -1;
+        int paletteLoc = -1;
+        int lowLoc = -1;
+        int scaleLoc = -1;
+
+        float _low = 0.0f;
+        float _scale = 1.0f;
+    };
+}
@@ -1,8 +1,11 @@
 #include <gui/widgets/constellation_diagram.h>
+#include <gui/widgets/point_batch.h>
+#include <algorithm>
 
 namespace ImGui {
-    ConstellationDiagram::ConstellationDiagram() {
-        memset(buffer, 0, 1024 * sizeof(dsp::complex_t));
+    ConstellationDiagram::ConstellationDiagram(int count) {
+        dsp::complex_t zero = { 0.0f, 0.0f };
+        buffer.resize(std::max<int>(count, 1), zero);
     }
 
     void ConstellationDiagram::draw(const ImVec2& size_arg) {
@@ -20,20 +23,39 @@ namespace ImGui {
 
         window->DrawList->AddRectFilled(min, ImVec2(min.x + size.x, min.y + size.y), IM_COL32(0, 0, 0, 255));
         ImU32 col = ImGui::GetColorU32(ImGuiCol_CheckMark, 0.7f);
-        for (int i = 0; i < 1024; i++) {
+        int count = buffer.size();
+        PointBatch points;
+        points.begin(window->DrawList, count, col);
+        for (int i = 0; i < count; i++) {
             if (buffer[i].re > 1.5f || buffer[i].re < -1.5f) { continue; }
             if (buffer[i].im > 1.5f || buffer[i].im < -1.5f) { continue; }
-            window->DrawList->AddCircleFilled(ImVec2((((buffer[i].re / 1.5f) + 1) * (size.x * 0.5f)) + min.x, (((buffer[i].im / 1.5f) + 1) * (size.y * 0.5f)) + min.y), 2, col);
+            points.add((((buffer[i].re / 1.5f) + 1) * (size.x * 0.5f)) + min.x, (((buffer[i].im / 1.5f) + 1) * (size.y * 0.5f)) + min.y);
         }
+        points.end();
+    }
+
+    void ConstellationDiagram::push(const dsp::complex_t* data, int count) {
+        std::lock_guard<std::mutex> lck(bufferMtx);
+        int size = buffer.size();
+
+        // Only the last symbols can still be seen
+        if (count > size) {
+            data += count - size;
+            count = size;
+        }
+        int first = std::min<int>(count, size - writePos);
+        memcpy(&buffer[writePos], data, first * sizeof(dsp::complex_t));
+        memcpy(&buffer[0], &data[first], (count - first) * sizeof(dsp::complex_t));
+        writePos = (writePos + count) % size;
     }
 
     dsp::complex_t* ConstellationDiagram::acquireBuffer() {
         bufferMtx.lock();
-        return buffer;
+        return buffer.data();
     }
 
     void ConstellationDiagram::releaseBuffer() {
         bufferMtx.unlock();
     }
 
-}
\ No newline at end of file
+}
@@ -4,21 +4,30 @@
 #include <imgui_internal.h>
 #include <dsp/stream.h>
 #include <mutex>
+#include <vector>
 #include <dsp/types.h>
 
 namespace ImGui {
     class ConstellationDiagram {
     public:
-        ConstellationDiagram();
+        // count is the number of symbols shown, the last ones pushed
+        ConstellationDiagram(int count = 1024);
 
         void draw(const ImVec2& size_arg = ImVec2(0, 0));
 
+        // Add symbols to the history, the oldest ones being dropped
+        void push(const dsp::complex_t* data, int count);
+
+        // Direct access to the history, getCount() symbols long
         dsp::complex_t* acquireBuffer();
 
         void releaseBuffer();
 
+        int getCount() { return buffer.size(); }
+
     private:
         std::mutex bufferMtx;
-        dsp::complex_t buffer[1024];
+        std::vector<dsp::complex_t> buffer;
+        int writePos = 0;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// Levels below this are stored as this value
+#define FFT_HISTORY_FLOOR               -1000.0f
+
+// Smallest size of a reduced level of the history
+#define FFT_HISTORY_MIN_LEVEL_SIZE      512
+
+// Minimum number of bins of a level per displayed column for it to be used
+#define FFT_HISTORY_MIN_BINS_PER_COLUMN 4
+
+namespace ImGui {
+    // Waterfall history storing each line with 16 bits per bin. Every line holds its levels relative to its own
+    // minimum in steps of its range divided by 65535, which keeps a resolution far below the display's own.
+    // Each line also keeps a pyramid of levels each holding the maximum of pairs of bins of the previous one, so that a
+    // zoomed out view is read from the closest level instead of the full line. Since the quantization preserves the
+    // order of the levels, the pyramid is built directly from the stored values. Lines are decoded on demand, optionally
+    // only over the range of bins being displayed.
+    class FFTHistory {
+    public:
+        FFTHistory() {}
+
+        ~FFTHistory() {
+            ::free(data);
+            ::free(offsets);
+            ::free(steps);
+        }
+
+        // Reallocate for lines of lineSize bins, all lines are cleared
+        void resize(int lineSize, int lines) {
+            _lineSize = lineSize;
+            _lines = std::max<int>(lines, 1);
+
+            // Lay out the levels one after the other in each line
+            levelStarts.clear();
+            levelSizes.clear();
+            _stride = 0;
+            for (int size = _lineSize; !levelSizes.size() || size >= FFT_HISTORY_MIN_LEVEL_SIZE; size /= 2) {
+                levelStarts.push_back(_stride);
+                levelSizes.push_back(size);
+                _stride += size;
+            }
+
+            data = (uint16_t*)realloc(data, (size_t)_stride * _lines * sizeof(uint16_t));
+            offsets = (float*)realloc(offsets, _lines * sizeof(float));
+            steps = (float*)realloc(steps, _lines * sizeof(float));
+            clear();
+        }
+
+        // Change the number of lines, keeping as many as fit starting from the first one which becomes line 0
+        void reshape(int lines, int first) {
+            if (!data) { return; }
+            lines = std::max<int>(lines, 1);
+            if (first) {
+                std::rotate(data, &data[(size_t)first * _stride], &data[(size_t)_lines * _stride]);
+                std::rotate(offsets, &offsets[first], &offsets[_lines]);
+                std::rotate(steps, &steps[first], &steps[_lines]);
+            }
+            int oldLines = _lines;
+            _lines = lines;
+            data = (uint16_t*)realloc(data, (size_t)_stride * _lines * sizeof(uint16_t));
+            offsets = (float*)realloc(offsets, _lines * sizeof(float));
+            steps = (float*)realloc(steps, _lines * sizeof(float));
+            for (int i = oldLines; i < _lines; i++) { clearLine(i); }
+        }
+
+        void clear() {
+            for (int i = 0; i < _lines; i++) { clearLine(i); }
+        }
+
+        void write(int line, const float* in) {
+            // Find the range of the line
+            float min = INFINITY;
+            float max = -INFINITY;
+            for (int i = 0; i < _lineSize; i++) {
+                min = std::min<float>(min, in[i]);
+                max = std::max<float>(max, in[i]);
+            }
+            min = std::clamp<float>(min, FFT_HISTORY_FLOOR, -FFT_HISTORY_FLOOR);
+            max = std::clamp<float>(max, min, -FFT_HISTORY_FLOOR);
+
+            // Quantize it relative to its minimum
+            float step = (max - min) / 65535.0f;
+            float scale = (step > 0.0f) ? (1.0f / step) : 0.0f;
+            uint16_t* out = &data[(size_t)line * _stride];
+            for (int i = 0; i < _lineSize; i++) {
+                float q = (std::clamp<float>(in[i], min, max) - min) * scale;
+                out[i] = (uint16_t)(q + 0.5f);
+            }
+            offsets[line] = min;
+            steps[line] = step;
+
+            // Reduce each level into the next
+            for (int l = 1; l < levelSizes.size(); l++) {
+                const uint16_t* prev = &out[levelStarts[l - 1]];
+                uint16_t* next = &out[levelStarts[l]];
+                for (int i = 0; i < levelSizes[l]; i++) {
+                    next[i] = std::max<uint16_t>(prev[2 * i], prev[(2 * i) + 1]);
+                }
+            }
+        }
+
+        // Decode count bins of a level of a line starting at bin start to the same position in out
+        void read(int line, float* out, int start = 0, int count = -1, int level = 0) {
+            int size = levelSizes[level];
+            start = std::clamp<int>(start, 0, size);
+            if (count < 0 || start + count > size) { count = size - start; }
+            const uint16_t* in = &data[((size_t)line * _stride) + levelStarts[level] + start];
+            float offset = offsets[line];
+            float step = steps[line];
+            out = &out[start];
+            for (int i = 0; i < count; i++) { out[i] = offset + ((float)in[i] * step); }
+        }
+
+        int getLineSize() { return _lineSize; }
+
+        int getLines() { return _lines; }
+
+        int getLevels() { return levelSizes.size(); }
+
+        int getLevelSize(int level) { return levelSizes[level]; }
+
+        // Coarsest level to show width bins of the full line over columns. A few bins are kept per column so that the
+        // columns, rounded to whole bins of the level, cover nearly the same bins as they would on the full line
+        int getLevelFor(int width, int columns) {
+            int level = 0;
+            while (level + 1 < levelSizes.size() && (width >> (level + 1)) >= columns * FFT_HISTORY_MIN_BINS_PER_COLUMN) { level++; }
+            return level;
+        }
+
+    private:
+        void clearLine(int line) {
+            memset(&data[(size_t)line * _stride], 0, _stride * sizeof(uint16_t));
+            offsets[line] = 0.0f;
+            steps[line] = 0.0f;
+        }
+
+        uint16_t* data = NULL;
+        float* offsets = NULL;
+        float* steps = NULL;
+        std::vector<int> levelStarts;
+        std::vector<int> levelSizes;
+        int _lineSize = 0;
+        int _stride = 0;
+        int _lines = 0;
+    };
+}
@@ -0,0 +1,94 @@
+#include <gui/widgets/gl_functions.h>
+#include <backend.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace ImGui {
+    namespace gl {
+        CreateShader_t CreateShader;
+        ShaderSource_t ShaderSource;
+        CompileShader_t CompileShader;
+        GetShaderiv_t GetShaderiv;
+        GetShaderInfoLog_t GetShaderInfoLog;
+        CreateProgram_t CreateProgram;
+        AttachShader_t AttachShader;
+        BindAttribLocation_t BindAttribLocation;
+        LinkProgram_t LinkProgram;
+        GetProgramiv_t GetProgramiv;
+        GetAttribLocation_t GetAttribLocation;
+        GetUniformLocation_t GetUniformLocation;
+        GetUniformfv_t GetUniformfv;
+        UseProgram_t UseProgram;
+        Uniform1i_t Uniform1i;
+        Uniform1f_t Uniform1f;
+        UniformMatrix4fv_t UniformMatrix4fv;
+        ActiveTexture_t ActiveTexture;
+        GenFramebuffers_t GenFramebuffers;
+        DeleteFramebuffers_t DeleteFramebuffers;
+        BindFramebuffer_t BindFramebuffer;
+        FramebufferTexture2D_t FramebufferTexture2D;
+        CheckFramebufferStatus_t CheckFramebufferStatus;
+        GenBuffers_t GenBuffers;
+        DeleteBuffers_t DeleteBuffers;
+        BindBuffer_t BindBuffer;
+        BufferData_t BufferData;
+        MapBufferRange_t MapBufferRange;
+        UnmapBuffer_t UnmapBuffer;
+        GenVertexArrays_t GenVertexArrays;
+        DeleteVertexArrays_t DeleteVertexArrays;
+        BindVertexArray_t BindVertexArray;
+
+        bool load() {
+#ifdef __ANDROID__
+#define LOAD_GL(name) name = (name##_t)gl##name
+#else
+#define LOAD_GL(name) if (!(name = (name##_t)backend::getProcAddress("gl" #name))) { return false; }
+#endif
+            LOAD_GL(CreateShader);
+            LOAD_GL(ShaderSource);
+            LOAD_GL(CompileShader);
+            LOAD_GL(GetShaderiv);
+            LOAD_GL(GetShaderInfoLog);
+            LOAD_GL(CreateProgram);
+            LOAD_GL(AttachShader);
+            LOAD_GL(BindAttribLocation);
+            LOAD_GL(LinkProgram);
+            LOAD_GL(GetProgramiv);
+            LOAD_GL(GetAttribLocation);
+            LOAD_GL(GetUniformLocation);
+            LOAD_GL(GetUniformfv);
+            LOAD_GL(UseProgram);
+            LOAD_GL(Uniform1i);
+            LOAD_GL(Uniform1f);
+            LOAD_GL(UniformMatrix4fv);
+            LOAD_GL(ActiveTexture);
+            LOAD_GL(GenFramebuffers);
+            LOAD_GL(DeleteFramebuffers);
+            LOAD_GL(BindFramebuffer);
+            LOAD_GL(FramebufferTexture2D);
+            LOAD_GL(CheckFramebufferStatus);
+            LOAD_GL(GenBuffers);
+            LOAD_GL(DeleteBuffers);
+            LOAD_GL(BindBuffer);
+            LOAD_GL(BufferData);
+            LOAD_GL(MapBufferRange);
+            LOAD_GL(UnmapBuffer);
+            LOAD_GL(GenVertexArrays);
+            LOAD_GL(DeleteVertexArrays);
+            LOAD_GL(BindVertexArray);
+#undef LOAD_GL
+            return true;
+        }
+
+        bool getVersion(int& major, int& minor, bool& es) {
+            const char* version = (const char*)glGetString(GL_VERSION);
+            if (!version) { return false; }
+            major = 0;
+            minor = 0;
+            es = strstr(version, "OpenGL ES") != NULL;
+            if (es) { sscanf(strstr(version, "OpenGL ES") + 9, "%d.%d", &major, &minor); }
+            else { sscanf(version, "%d.%d", &major, &minor); }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <stddef.h>
+#include <utils/opengl_include_code.h>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER      0x8B30
+#define GL_VERTEX_SHADER        0x8B31
+#define GL_COMPILE_STATUS       0x8B81
+#define GL_LINK_STATUS          0x8B82
+#define GL_CURRENT_PROGRAM      0x8B8D
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0             0x84C0
+#define GL_TEXTURE1             0x84C1
+#define GL_ACTIVE_TEXTURE       0x84E0
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE        0x812F
+#endif
+#ifndef GL_RED
+#define GL_RED                  0x1903
+#endif
+#ifndef GL_RG
+#define GL_RG                   0x8227
+#endif
+#ifndef GL_R16F
+#define GL_R16F                 0x822D
+#define GL_R32F                 0x822E
+#define GL_RG32F                0x8230
+#endif
+#ifndef GL_RGBA32F
+#define GL_RGBA32F              0x8814
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER          0x8D40
+#define GL_FRAMEBUFFER_BINDING  0x8CA6
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_COLOR_ATTACHMENT0    0x8CE0
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER            0x88EB
+#define GL_PIXEL_PACK_BUFFER_BINDING    0x88ED
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ          0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT         0x0001
+#endif
+#ifndef GL_VERTEX_ARRAY_BINDING
+#define GL_VERTEX_ARRAY_BINDING 0x85B5
+#endif
+
+namespace ImGui {
+    // Entry points above OpenGL 1.1 aren't exported by the system library on every platform and must be loaded at runtime
+    namespace gl {
+        typedef GLuint (APIENTRY *CreateShader_t)(GLenum type);
+        typedef void (APIENTRY *ShaderSource_t)(GLuint shader, GLsizei count, const char* const* string, const GLint* length);
+        typedef void (APIENTRY *CompileShader_t)(GLuint shader);
+        typedef void (APIENTRY *GetShaderiv_t)(GLuint shader, GLenum pname, GLint* params);
+        typedef void (APIENTRY *GetShaderInfoLog_t)(GLuint shader, GLsizei bufSize, GLsizei* length, char* infoLog);
+        typedef GLuint (APIENTRY *CreateProgram_t)();
+        typedef void (APIENTRY *AttachShader_t)(GLuint program, GLuint shader);
+        typedef void (APIENTRY *BindAttribLocation_t)(GLuint program, GLuint index, const char* name);
+        typedef void (APIENTRY *LinkProgram_t)(GLuint program);
+        typedef void (APIENTRY *GetProgramiv_t)(GLuint program, GLenum pname, GLint* params);
+        typedef GLint (APIENTRY *GetAttribLocation_t)(GLuint program, const char* name);
+        typedef GLint (APIENTRY *GetUniformLocation_t)(GLuint program, const char* name);
+        typedef void (APIENTRY *GetUniformfv_t)(GLuint program, GLint location, GLfloat* params);
+        typedef void (APIENTRY *UseProgram_t)(GLuint program);
+        typedef void (APIENTRY *Uniform1i_t)(GLint location, GLint v0);
+        typedef void (APIENTRY *Uniform1f_t)(GLint location, GLfloat v0);
+        typedef void (APIENTRY *UniformMatrix4fv_t)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+        typedef void (APIENTRY *ActiveTexture_t)(GLenum texture);
+        typedef void (APIENTRY *GenFramebuffers_t)(GLsizei n, GLuint* framebuffers);
+        typedef void (APIENTRY *DeleteFramebuffers_t)(GLsizei n, const GLuint* framebuffers);
+        typedef void (APIENTRY *BindFramebuffer_t)(GLenum target, GLuint framebuffer);
+        typedef void (APIENTRY *FramebufferTexture2D_t)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+        typedef GLenum (APIENTRY *CheckFramebufferStatus_t)(GLenum target);
+        typedef void (APIENTRY *GenBuffers_t)(GLsizei n, GLuint* buffers);
+        typedef void (APIENTRY *DeleteBuffers_t)(GLsizei n, const GLuint* buffers);
+        typedef void (APIENTRY *BindBuffer_t)(GLenum target, GLuint buffer);
+        typedef void (APIENTRY *BufferData_t)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+        typedef void* (APIENTRY *MapBufferRange_t)(GLenum target, ptrdiff_t offset, ptrdiff_t length, GLbitfield access);
+        typedef GLboolean (APIENTRY *UnmapBuffer_t)(GLenum target);
+        typedef void (APIENTRY *GenVertexArrays_t)(GLsizei n, GLuint* arrays);
+        typedef void (APIENTRY *DeleteVertexArrays_t)(GLsizei n, const GLuint* arrays);
+        typedef void (APIENTRY *BindVertexArray_t)(GLuint array);
+
+        extern CreateShader_t CreateShader;
+        extern ShaderSource_t ShaderSource;
+        extern CompileShader_t CompileShader;
+        extern GetShaderiv_t GetShaderiv;
+        extern GetShaderInfoLog_t GetShaderInfoLog;
+        extern CreateProgram_t CreateProgram;
+        extern AttachShader_t AttachShader;
+        extern BindAttribLocation_t BindAttribLocation;
+        extern LinkProgram_t LinkProgram;
+        extern GetProgramiv_t GetProgramiv;
+        extern GetAttribLocation_t GetAttribLocation;
+        extern GetUniformLocation_t GetUniformLocation;
+        extern GetUniformfv_t GetUniformfv;
+        extern UseProgram_t UseProgram;
+        extern Uniform1i_t Uniform1i;
+        extern Uniform1f_t Uniform1f;
+        extern UniformMatrix4fv_t UniformMatrix4fv;
+        extern ActiveTexture_t ActiveTexture;
+        extern GenFramebuffers_t GenFramebuffers;
+        extern DeleteFramebuffers_t DeleteFramebuffers;
+        extern BindFramebuffer_t BindFramebuffer;
+        extern FramebufferTexture2D_t FramebufferTexture2D;
+        extern CheckFramebufferStatus_t CheckFramebufferStatus;
+        extern GenBuffers_t GenBuffers;
+        extern DeleteBuffers_t DeleteBuffers;
+        extern BindBuffer_t BindBuffer;
+        extern BufferData_t BufferData;
+        extern MapBufferRange_t MapBufferRange;
+        extern UnmapBuffer_t UnmapBuffer;
+        extern GenVertexArrays_t GenVertexArrays;
+        extern DeleteVertexArrays_t DeleteVertexArrays;
+        extern BindVertexArray_t BindVertexArray;
+
+        // Load all the entry points, must be called with the context current. Returns false if any is missing
+        bool load();
+
+        // Version of the current context, false if it couldn't be parsed
+        bool getVersion(int& major, int& minor, bool& es);
+    }
+}
@@ -0,0 +1,382 @@
+#include <gui/widgets/gpu_fft.h>
+#include <gui/widgets/gl_functions.h>
+#include <backend.h>
+#include <utils/flog.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+
+// Set on the pending frame index when it holds a frame the GUI hasn't taken yet
+#define GPU_FFT_FRESH   4
+
+namespace ImGui {
+    // Draws a triangle covering the whole target, one fragment per texel
+    const char* GPU_FFT_VERTEX_SHADER =
+        "void main() {\n"
+        "    gl_Position = vec4(float((gl_VertexID & 1) * 4 - 1), float((gl_VertexID & 2) * 2 - 1), 0.0, 1.0);\n"
+        "}\n";
+
+    // One radix-2 pass of a Stockham FFT merging transforms of Span bins into transforms of twice that, each fragment
+    // computing one output. The output comes out in natural order so no bit reversal is needed. The first pass windows
+    // the samples, everything past Count being the zero padding
+    const char* GPU_FFT_PASS_SHADER =
+        "uniform sampler2D Input;\n"
+        "uniform sampler2D Window;\n"
+        "uniform int Span;\n"
+        "uniform int Half;\n"
+        "uniform int Count;\n"
+        "uniform int First;\n"
+        "uniform int WidthLog2;\n"
+        "out vec2 Out_Value;\n"
+        "ivec2 texel(int i) { return ivec2(i & ((1 << WidthLog2) - 1), i >> WidthLog2); }\n"
+        "vec2 load(int i) {\n"
+        "    if (First == 0) { return texelFetch(Input, texel(i), 0).rg; }\n"
+        "    if (i >= Count) { return vec2(0.0); }\n"
+        "    return texelFetch(Input, texel(i), 0).rg * texelFetch(Window, texel(i), 0).r;\n"
+        "}\n"
+        "void main() {\n"
+        "    int k = (int(gl_FragCoord.y) << WidthLog2) | int(gl_FragCoord.x);\n"
+        "    int inner = k & (Span - 1);\n"
+        "    int j = ((k >> 1) & ~(Span - 1)) | inner;\n"
+        "    vec2 a = load(j);\n"
+        "    vec2 b = load(j + Half);\n"
+        "    float angle = -PI * float(inner) / float(Span);\n"
+        "    vec2 w = vec2(cos(angle), sin(angle));\n"
+        "    b = vec2(b.x * w.x - b.y * w.y, b.x * w.y + b.y * w.x);\n"
+        "    Out_Value = ((k & Span) != 0) ? a - b : a + b;\n"
+        "}\n";
+
+    // Power of four consecutive bins in dB, packed in an RGBA texel since that's the only float format every
+    // implementation can read back
+    const char* GPU_FFT_POWER_SHADER =
+        "uniform sampler2D Input;\n"
+        "uniform float Scale;\n"
+        "out vec4 Out_Value;\n"
+        "float level(ivec2 pos) {\n"
+        "    vec2 v = texelFetch(Input, pos, 0).rg;\n"
+        "    return 3.01029996 * log2(max(dot(v, v) * Scale, 1e-20));\n"
+        "}\n"
+        "void main() {\n"
+        "    ivec2 pos = ivec2(int(gl_FragCoord.x) * 4, int(gl_FragCoord.y));\n"
+        "    Out_Value = vec4(level(pos), level(pos + ivec2(1, 0)), level(pos + ivec2(2, 0)), level(pos + ivec2(3, 0)));\n"
+        "}\n";
+
+    static GLuint compileShader(GLenum type, const std::string& header, const char* source) {
+        GLuint shader = gl::CreateShader(type);
+        const char* sources[2] = { header.c_str(), source };
+        gl::ShaderSource(shader, 2, sources, NULL);
+        gl::CompileShader(shader);
+        GLint status = 0;
+        gl::GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (!status) {
+            char log[1024] = { 0 };
+            gl::GetShaderInfoLog(shader, sizeof(log) - 1, NULL, log);
+            flog::warn("Could not compile the GPU FFT shader: {}", log);
+            return 0;
+        }
+        return shader;
+    }
+
+    static GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader) {
+        GLuint program = gl::CreateProgram();
+        gl::AttachShader(program, vertexShader);
+        gl::AttachShader(program, fragmentShader);
+        gl::LinkProgram(program);
+        GLint status = 0;
+        gl::GetProgramiv(program, GL_LINK_STATUS, &status);
+        if (!status) {
+            flog::warn("Could not link the GPU FFT shader");
+            return 0;
+        }
+        return program;
+    }
+
+    static GLuint createTexture(GLint format, int width, int height) {
+        GLuint tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        GLenum layout = (format == GL_RG32F) ? GL_RG : ((format == GL_R32F) ? GL_RED : GL_RGBA);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, layout, GL_FLOAT, NULL);
+        return tex;
+    }
+
+    static GLuint createFramebuffer(GLuint tex) {
+        GLuint fb;
+        gl::GenFramebuffers(1, &fb);
+        gl::BindFramebuffer(GL_FRAMEBUFFER, fb);
+        gl::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+        bool complete = (gl::CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+        gl::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            gl::DeleteFramebuffers(1, &fb);
+            return 0;
+        }
+        return fb;
+    }
+
+    // Upload count texels row by row, the last row being partial
+    static void uploadTexels(GLuint tex, int width, GLenum layout, const float* data, int channels, int count) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        int rows = count / width;
+        int rem = count % width;
+        if (rows) { glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, rows, layout, GL_FLOAT, data); }
+        if (rem) { glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rows, rem, 1, layout, GL_FLOAT, &data[rows * width * channels]); }
+    }
+
+    bool GPUFFT::init() {
+        // Render targets of two float channels and integer operations in shaders need GL 3.0 or GL ES 3.0
+        int major, minor;
+        bool es;
+        if (!gl::getVersion(major, minor, es)) { return false; }
+        if (major < 3) {
+            flog::info("OpenGL {}.{} doesn't support the GPU FFT", major, minor);
+            return false;
+        }
+        std::string header;
+        if (es) { header = "#version 300 es\nprecision highp float;\nprecision highp int;\nprecision highp sampler2D;\n"; }
+        else if (major > 3 || minor >= 2) { header = "#version 150\n"; }
+        else { header = "#version 130\n"; }
+        header += "#define PI 3.14159265358979\n";
+
+        if (!gl::load()) {
+            flog::warn("Could not load the OpenGL functions needed by the GPU FFT");
+            return false;
+        }
+
+        vertexShader = compileShader(GL_VERTEX_SHADER, header, GPU_FFT_VERTEX_SHADER);
+        fftShader = compileShader(GL_FRAGMENT_SHADER, header, GPU_FFT_PASS_SHADER);
+        powerShader = compileShader(GL_FRAGMENT_SHADER, header, GPU_FFT_POWER_SHADER);
+        if (!vertexShader || !fftShader || !powerShader) { return false; }
+        fftProgram = linkProgram(vertexShader, fftShader);
+        powerProgram = linkProgram(vertexShader, powerShader);
+        if (!fftProgram || !powerProgram) { return false; }
+
+        fftInputLoc = gl::GetUniformLocation(fftProgram, "Input");
+        fftWindowLoc = gl::GetUniformLocation(fftProgram, "Window");
+        fftSpanLoc = gl::GetUniformLocation(fftProgram, "Span");
+        fftHalfLoc = gl::GetUniformLocation(fftProgram, "Half");
+        fftCountLoc = gl::GetUniformLocation(fftProgram, "Count");
+        fftFirstLoc = gl::GetUniformLocation(fftProgram, "First");
+        fftWidthLog2Loc = gl::GetUniformLocation(fftProgram, "WidthLog2");
+        powerInputLoc = gl::GetUniformLocation(powerProgram, "Input");
+        powerScaleLoc = gl::GetUniformLocation(powerProgram, "Scale");
+
+        // Core profiles can't draw without a vertex array even though the vertices come from gl_VertexID
+        gl::GenVertexArrays(1, &vao);
+
+        // OpenGL ES only renders to float textures with an extension, so check it works before offering the GPU
+        if (!allocate(GPU_FFT_TEX_WIDTH)) {
+            flog::info("Float render targets are not supported, the GPU FFT is unavailable");
+            return false;
+        }
+        destroy();
+
+        GLint maxTexSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
+        maxTexSize = std::min<int>(maxTexSize, 1 << 14);
+        maxSize = std::min<int>(maxTexSize, GPU_FFT_TEX_WIDTH) * maxTexSize;
+
+        available = true;
+        return true;
+    }
+
+    bool GPUFFT::configure(int fftSize, const float* window, int windowSize) {
+        if (!available || fftSize < 8 || fftSize > maxSize || (fftSize & (fftSize - 1)) || windowSize > fftSize) { return false; }
+        std::lock_guard<std::mutex> lck(configMtx);
+        configSize = fftSize;
+        configCount = windowSize;
+        configWindow.assign(window, window + windowSize);
+        submitGeneration = ++configGeneration;
+        submitCount = windowSize;
+        return true;
+    }
+
+    void GPUFFT::submit(const dsp::complex_t* frame) {
+        // The back buffer belongs to the submitting thread, so it can be resized freely
+        Frame& back = frames[frameBack];
+        back.samples.resize(submitCount);
+        memcpy(back.samples.data(), frame, submitCount * sizeof(dsp::complex_t));
+        back.generation = submitGeneration;
+        frameBack = framePending.exchange(frameBack | GPU_FFT_FRESH) & ~GPU_FFT_FRESH;
+    }
+
+    bool GPUFFT::process(float* out, int size) {
+        if (!available) { return false; }
+        bool fresh = framePending.load() & GPU_FFT_FRESH;
+        if (!readbackPending && !fresh) { return false; }
+
+        // Everything the passes touch is restored so the waterfall and ImGui draw as if nothing happened
+        GLint prevFb, prevProgram, prevVao, prevActive, prevTex[2], prevPack, prevViewport[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFb);
+        glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVao);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &prevActive);
+        glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &prevPack);
+        glGetIntegerv(GL_VIEWPORT, prevViewport);
+        for (int i = 0; i < 2; i++) {
+            gl::ActiveTexture(GL_TEXTURE0 + i);
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex[i]);
+        }
+        gl::ActiveTexture(GL_TEXTURE0);
+        GLboolean prevBlend = glIsEnabled(GL_BLEND);
+        GLboolean prevScissor = glIsEnabled(GL_SCISSOR_TEST);
+
+        // The spectrum started last frame is done by now
+        bool written = false;
+        if (readbackPending) {
+            gl::BindBuffer(GL_PIXEL_PACK_BUFFER, readback);
+            void* data = gl::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readbackSize * sizeof(float), GL_MAP_READ_BIT);
+            if (data) {
+                if (readbackSize == size) {
+                    memcpy(out, data, size * sizeof(float));
+                    written = true;
+                }
+                gl::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            readbackPending = false;
+        }
+
+        if (fresh) {
+            frameFront = framePending.exchange(frameFront) & ~GPU_FFT_FRESH;
+            const Frame& front = frames[frameFront];
+
+            // Apply the settings the frame was submitted with, frames of older settings are dropped
+            if (front.generation != glGeneration) {
+                std::lock_guard<std::mutex> lck(configMtx);
+                if (front.generation == configGeneration && (configSize == fftSize || allocate(configSize))) {
+                    count = configCount;
+                    uploadTexels(windowTex, width, GL_RED, configWindow.data(), 1, count);
+                    glGeneration = configGeneration;
+                }
+            }
+            if (front.generation == glGeneration && (int)front.samples.size() == count) { transform(front); }
+        }
+
+        gl::BindFramebuffer(GL_FRAMEBUFFER, prevFb);
+        gl::UseProgram(prevProgram);
+        gl::BindVertexArray(prevVao);
+        gl::BindBuffer(GL_PIXEL_PACK_BUFFER, prevPack);
+        glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+        for (int i = 0; i < 2; i++) {
+            gl::ActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, prevTex[i]);
+        }
+        gl::ActiveTexture(prevActive);
+        if (prevBlend) { glEnable(GL_BLEND); }
+        if (prevScissor) { glEnable(GL_SCISSOR_TEST); }
+        return written;
+    }
+
+    bool GPUFFT::configureHandler(int fftSize, const float* window, int windowSize, void* ctx) {
+        GPUFFT* _this = (GPUFFT*)ctx;
+        return _this->configure(fftSize, window, windowSize);
+    }
+
+    bool GPUFFT::submitHandler(const dsp::complex_t* frame, void* ctx) {
+        GPUFFT* _this = (GPUFFT*)ctx;
+        _this->submit(frame);
+        backend::requestRedraw();
+        return true;
+    }
+
+    bool GPUFFT::allocate(int size) {
+        destroy();
+        width = std::min<int>(size, GPU_FFT_TEX_WIDTH);
+        height = size / width;
+        widthLog2 = 0;
+        while ((1 << widthLog2) < width) { widthLog2++; }
+        passes = 0;
+        while ((1 << passes) < size) { passes++; }
+
+        // The samples are uploaded to the first data texture, the passes then going back and forth between the two
+        for (int i = 0; i < 2; i++) {
+            dataTex[i] = createTexture(GL_RG32F, width, height);
+            dataFb[i] = createFramebuffer(dataTex[i]);
+        }
+        windowTex = createTexture(GL_R32F, width, height);
+        powerTex = createTexture(GL_RGBA32F, width / 4, height);
+        powerFb = createFramebuffer(powerTex);
+        if (!dataFb[0] || !dataFb[1] || !powerFb) {
+            flog::warn("Could not create the render targets of the GPU FFT");
+            destroy();
+            return false;
+        }
+
+        gl::GenBuffers(1, &readback);
+        readbackSize = 0;
+        fftSize = size;
+        return true;
+    }
+
+    void GPUFFT::destroy() {
+        for (int i = 0; i < 2; i++) {
+            if (dataFb[i]) { gl::DeleteFramebuffers(1, &dataFb[i]); }
+            if (dataTex[i]) { glDeleteTextures(1, &dataTex[i]); }
+            dataFb[i] = 0;
+            dataTex[i] = 0;
+        }
+        if (powerFb) { gl::DeleteFramebuffers(1, &powerFb); }
+        if (powerTex) { glDeleteTextures(1, &powerTex); }
+        if (windowTex) { glDeleteTextures(1, &windowTex); }
+        if (readback) { gl::DeleteBuffers(1, &readback); }
+        powerFb = 0;
+        powerTex = 0;
+        windowTex = 0;
+        readback = 0;
+        readbackPending = false;
+        fftSize = 0;
+        glGeneration = -1;
+    }
+
+    void GPUFFT::transform(const Frame& frame) {
+        glDisable(GL_BLEND);
+        glDisable(GL_SCISSOR_TEST);
+        gl::BindVertexArray(vao);
+        glViewport(0, 0, width, height);
+
+        uploadTexels(dataTex[0], width, GL_RG, (const float*)frame.samples.data(), 2, count);
+        gl::ActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, windowTex);
+        gl::ActiveTexture(GL_TEXTURE0);
+
+        gl::UseProgram(fftProgram);
+        gl::Uniform1i(fftInputLoc, 0);
+        gl::Uniform1i(fftWindowLoc, 1);
+        gl::Uniform1i(fftHalfLoc, fftSize / 2);
+        gl::Uniform1i(fftCountLoc, count);
+        gl::Uniform1i(fftWidthLog2Loc, widthLog2);
+        for (int i = 0; i < passes; i++) {
+            gl::BindFramebuffer(GL_FRAMEBUFFER, dataFb[(i + 1) & 1]);
+            glBindTexture(GL_TEXTURE_2D, dataTex[i & 1]);
+            gl::Uniform1i(fftSpanLoc, 1 << i);
+            gl::Uniform1i(fftFirstLoc, i == 0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        // Same scaling as volk_32fc_s32f_power_spectrum_32f() normalized by the FFT size
+        gl::BindFramebuffer(GL_FRAMEBUFFER, powerFb);
+        glViewport(0, 0, width / 4, height);
+        glBindTexture(GL_TEXTURE_2D, dataTex[passes & 1]);
+        gl::UseProgram(powerProgram);
+        gl::Uniform1i(powerInputLoc, 0);
+        gl::Uniform1f(powerScaleLoc, 1.0f / ((float)fftSize * (float)fftSize));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // Start the read back, it's only waited for on the next call
+        gl::BindBuffer(GL_PIXEL_PACK_BUFFER, readback);
+        if (readbackSize != fftSize) {
+            gl::BufferData(GL_PIXEL_PACK_BUFFER, fftSize * sizeof(float), NULL, GL_STREAM_READ);
+            readbackSize = fftSize;
+        }
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width / 4, height, GL_RGBA, GL_FLOAT, NULL);
+        readbackPending = true;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <dsp/types.h>
+
+#include <utils/opengl_include_code.h>
+
+// Width of the textures holding the spectrum, bins are laid out row by row
+#define GPU_FFT_TEX_WIDTH   2048
+
+namespace ImGui {
+    // Computes the spectrum shown by the waterfall on the GPU. Frames are submitted by the DSP thread and transformed when
+    // the GUI thread calls process(), the windowing, radix-2 FFT passes and conversion to dB being done by fragment shaders
+    // so that only OpenGL 3.0 or OpenGL ES 3.0 with float render targets is needed. The result is read back one frame later
+    // through a pixel buffer, so the GUI never waits for the GPU to finish.
+    // The FFT size must be a power of two.
+    class GPUFFT {
+    public:
+        GPUFFT() {}
+
+        // Must be called with the OpenGL context current
+        bool init();
+
+        bool isAvailable() { return available; }
+
+        // Set the size of the FFT and the window, which also gives the number of samples of each frame, the rest being
+        // zero padding. Must not be called while a frame is submitted. Returns false if the GPU can't do this size, in
+        // which case no frame may be submitted until the next successful call
+        bool configure(int fftSize, const float* window, int windowSize);
+
+        // Hand a frame of windowSize samples over, can be called from any thread. Frames submitted faster than the GUI
+        // draws are replaced by newer ones
+        void submit(const dsp::complex_t* frame);
+
+        // Copy the spectrum read back since the last call to out if it is of the given size, then start transforming the
+        // newest frame. Must be called from the GUI thread. Returns true if out was written
+        bool process(float* out, int size);
+
+        // Callbacks for IQFrontEnd::setFFTOffload(), ctx being the GPUFFT
+        static bool configureHandler(int fftSize, const float* window, int windowSize, void* ctx);
+        static bool submitHandler(const dsp::complex_t* frame, void* ctx);
+
+    private:
+        struct Frame {
+            std::vector<dsp::complex_t> samples;
+            int generation = 0;
+        };
+
+        bool allocate(int fftSize);
+        void destroy();
+        void transform(const Frame& frame);
+
+        bool available = false;
+        std::atomic<int> maxSize = 0;
+
+        // Settings given by configure(), the GUI applies them on the first frame of their generation
+        std::mutex configMtx;
+        int configSize = 0;
+        int configCount = 0;
+        std::vector<float> configWindow;
+        int configGeneration = 0;
+
+        // Settings of the frames being submitted, only used by the submitting thread and configure()
+        int submitCount = 0;
+        int submitGeneration = 0;
+
+        // Frames are exchanged through three buffers like the spectra of the waterfall
+        Frame frames[3];
+        int frameBack = 0;
+        int frameFront = 1;
+        std::atomic<int> framePending = 2;
+
+        // GPU side, only used by the GUI thread
+        int glGeneration = -1;
+        int fftSize = 0;
+        int count = 0;
+        int width = 0;
+        int height = 0;
+        int widthLog2 = 0;
+        int passes = 0;
+
+        GLuint vertexShader = 0;
+        GLuint fftShader = 0;
+        GLuint powerShader = 0;
+        GLuint fftProgram = 0;
+        GLuint powerProgram = 0;
+        GLuint vao = 0;
+
+        GLuint dataTex[2] = { 0, 0 };
+        GLuint windowTex = 0;
+        GLuint powerTex = 0;
+        GLuint dataFb[2] = { 0, 0 };
+        GLuint powerFb = 0;
+        GLuint readback = 0;
+        int readbackSize = 0;
+        bool readbackPending = false;
+
+        int fftInputLoc = -1;
+        int fftWindowLoc = -1;
+        int fftSpanLoc = -1;
+        int fftHalfLoc = -1;
+        int fftCountLoc = -1;
+        int fftFirstLoc = -1;
+        int fftWidthLog2Loc = -1;
+        int powerInputLoc = -1;
+        int powerScaleLoc = -1;
+    };
+}
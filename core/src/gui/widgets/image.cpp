@@ -1,4 +1,5 @@
 #include <gui/widgets/image.h>
+#include <algorithm>
 
 namespace ImGui {
     ImageDisplay::ImageDisplay(int width, int height) {
@@ -49,16 +50,57 @@ namespace ImGui {
         void* tmp = activeBuffer;
         activeBuffer = buffer;
         buffer = tmp;
-        newData = true;
+        markDirty(0, 0, _width, _height);
         memset(buffer, 0, _width * _height * 4);
     }
 
+    void ImageDisplay::update(int x, int y, int width, int height) {
+        std::lock_guard<std::mutex> lck(bufferMtx);
+        x = std::clamp<int>(x, 0, _width);
+        y = std::clamp<int>(y, 0, _height);
+        width = std::clamp<int>(width, 0, _width - x);
+        height = std::clamp<int>(height, 0, _height - y);
+        uint32_t* src = (uint32_t*)buffer;
+        uint32_t* dst = (uint32_t*)activeBuffer;
+        for (int i = y; i < y + height; i++) {
+            memcpy(&dst[i * _width + x], &src[i * _width + x], width * sizeof(uint32_t));
+        }
+        markDirty(x, y, width, height);
+    }
+
+    void ImageDisplay::markDirty(int x, int y, int width, int height) {
+        if (!newData) {
+            dirtyX0 = x;
+            dirtyY0 = y;
+            dirtyX1 = x + width;
+            dirtyY1 = y + height;
+        }
+        else {
+            dirtyX0 = std::min<int>(dirtyX0, x);
+            dirtyY0 = std::min<int>(dirtyY0, y);
+            dirtyX1 = std::max<int>(dirtyX1, x + width);
+            dirtyY1 = std::max<int>(dirtyY1, y + height);
+        }
+        newData = true;
+    }
+
     void ImageDisplay::updateTexture() {
         glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Allocate and fill the texture once, after that only the dirty rectangle is uploaded
+        if (!textureAllocated) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, activeBuffer);
+            textureAllocated = true;
+            return;
+        }
+
+        if (dirtyX1 <= dirtyX0 || dirtyY1 <= dirtyY0) { return; }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, _width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, dirtyX0, dirtyY0, dirtyX1 - dirtyX0, dirtyY1 - dirtyY0, GL_RGBA, GL_UNSIGNED_BYTE, &((uint32_t*)activeBuffer)[dirtyY0 * _width + dirtyX0]);
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, activeBuffer);
     }
 
 }
\ No newline at end of file
@@ -15,9 +15,13 @@ namespace ImGui {
         void draw(const ImVec2& size_arg = ImVec2(0, 0));
         void swap();
 
+        // Show a rectangle of buffer without swapping, only that part of the texture is uploaded
+        void update(int x, int y, int width, int height);
+
         void* buffer;
 
     private:
+        void markDirty(int x, int y, int width, int height);
         void updateTexture();
 
         std::mutex bufferMtx;
@@ -27,7 +31,13 @@ namespace ImGui {
         int _height;
 
         GLuint textureId;
+        bool textureAllocated = false;
 
+        // Part of the image changed since the last upload
+        int dirtyX0 = 0;
+        int dirtyY0 = 0;
+        int dirtyX1 = 0;
+        int dirtyY1 = 0;
         bool newData = false;
     };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <gui/widgets/line_push_image.h>
+#include <algorithm>
 
 namespace ImGui {
     LinePushImage::LinePushImage(int frameWidth, int reservedIncrement) {
@@ -37,7 +38,8 @@ namespace ImGui {
             updateTexture();
         }
 
-        window->DrawList->AddImage((void*)(intptr_t)textureId, min, ImVec2(min.x + width, min.y + height));
+        // The texture is taller than the image, only show the lines that were pushed
+        window->DrawList->AddImage((void*)(intptr_t)textureId, min, ImVec2(min.x + width, min.y + height), ImVec2(0, 0), ImVec2(1, (float)_lineCount / (float)textureLines));
     }
 
     uint8_t* LinePushImage::acquireNextLine(int count) {
@@ -47,13 +49,15 @@ namespace ImGui {
         _lineCount += count;
 
         // If new data either fills up or exceeds the limit, reallocate
-        // TODO: Change it to avoid bug if count >= reservedIncrement
         if (_lineCount > reservedCount) {
-            printf("Reallocating\n");
-            reservedCount += _reservedIncrement;
+            while (_lineCount > reservedCount) { reservedCount += _reservedIncrement; }
             frameBuffer = (uint8_t*)realloc(frameBuffer, _frameWidth * reservedCount * 4);
         }
 
+        // Only the new lines will need to be uploaded
+        dirtyStart = newData ? std::min<int>(dirtyStart, oldLineCount) : oldLineCount;
+        dirtyEnd = _lineCount;
+
         return &frameBuffer[_frameWidth * oldLineCount * 4];
     }
 
@@ -67,6 +71,8 @@ namespace ImGui {
         _lineCount = 0;
         frameBuffer = (uint8_t*)realloc(frameBuffer, _frameWidth * _reservedIncrement * 4);
         reservedCount = _reservedIncrement;
+        dirtyStart = 0;
+        dirtyEnd = 0;
         newData = true;
     }
 
@@ -80,10 +86,24 @@ namespace ImGui {
 
     void LinePushImage::updateTexture() {
         glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _frameWidth, _lineCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, frameBuffer);
+
+        // The texture is allocated for all the reserved lines so that pushing a line only uploads that line.
+        // When the buffer grows, the texture is reallocated and everything uploaded again
+        if (textureLines != reservedCount) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _frameWidth, reservedCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            textureLines = reservedCount;
+            dirtyStart = 0;
+            dirtyEnd = _lineCount;
+        }
+
+        if (dirtyEnd > dirtyStart) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyStart, _frameWidth, dirtyEnd - dirtyStart, GL_RGBA, GL_UNSIGNED_BYTE, &frameBuffer[_frameWidth * dirtyStart * 4]);
+        }
+        dirtyStart = 0;
+        dirtyEnd = 0;
     }
 
 }
\ No newline at end of file
@@ -36,7 +36,11 @@ namespace ImGui {
         int reservedCount = 0;
 
         GLuint textureId;
+        int textureLines = 0;
 
+        // Lines changed since the last upload
+        int dirtyStart = 0;
+        int dirtyEnd = 0;
         bool newData = false;
     };
 }
\ No newline at end of file
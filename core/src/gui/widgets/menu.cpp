@@ -2,6 +2,7 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 #include <gui/style.h>
+#include <dsp/buffer/pool.h>
 
 Menu::Menu() {
 }
@@ -71,6 +72,8 @@ bool Menu::draw(bool updateStates) {
 
         MenuItem_t& item = items[opt.name];
 
+        // Allocations done while drawing the menu of an instance or enabling it are accounted to it
+        dsp::buffer::pool::Scope memScope(item.inst ? dsp::buffer::pool::tag(opt.name) : dsp::buffer::pool::currentOwner());
 
         ImRect orginalRect = window->WorkRect;
         if (item.inst != NULL) {
@@ -0,0 +1,19 @@
+#include <gui/widgets/point_batch.h>
+
+namespace ImGui {
+    void PointBatch::begin(ImDrawList* drawList, int maxCount, ImU32 col, float size) {
+        this->drawList = drawList;
+        this->col = col;
+        half = size * 0.5f;
+        reserved = maxCount;
+        count = 0;
+        drawList->PrimReserve(reserved * 6, reserved * 4);
+    }
+
+    void PointBatch::end() {
+        int unused = reserved - count;
+        if (unused > 0) { drawList->PrimUnreserve(unused * 6, unused * 4); }
+        reserved = 0;
+        count = 0;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+#include <gui/widgets/spectrum_view.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <utils/hrfreq.h>
+#include <algorithm>
+#include <imgui/imgui_internal.h>
+
+namespace ImGui {
+    SpectrumView::SpectrumView() {
+        lines.resize(SPECTRUM_VIEW_COLUMNS * SPECTRUM_VIEW_LINES);
+        pixels.resize(SPECTRUM_VIEW_COLUMNS * SPECTRUM_VIEW_LINES);
+    }
+
+    SpectrumView::~SpectrumView() {
+        if (textureId) { glDeleteTextures(1, &textureId); }
+    }
+
+    void SpectrumView::push(const float* data, int size) {
+        // Write the line over the oldest one
+        newest = (newest + SPECTRUM_VIEW_LINES - 1) % SPECTRUM_VIEW_LINES;
+        lineCount = std::min<int>(lineCount + 1, SPECTRUM_VIEW_LINES);
+        zoom.process(0, size, size, SPECTRUM_VIEW_COLUMNS, data, &lines[newest * SPECTRUM_VIEW_COLUMNS]);
+        newData = true;
+    }
+
+    void SpectrumView::clear() {
+        lineCount = 0;
+        newData = true;
+    }
+
+    void SpectrumView::draw(float min, float max, double bandwidth, const ImVec2& size_arg) {
+        ImGuiWindow* window = GetCurrentWindow();
+        ImGuiStyle& style = GImGui->Style;
+        ImVec2 pos = window->DC.CursorPos;
+        ImVec2 size = CalcItemSize(size_arg, CalcItemWidth(), 200.0f * style::uiScale);
+        ImRect bb(pos, pos + size);
+        ItemSize(size, style.FramePadding.y);
+        if (!ItemAdd(bb, 0)) { return; }
+
+        // The spectrum takes the top half and the waterfall the bottom one
+        float specHeight = roundf(size.y / 2.0f);
+        ImVec2 specMax = ImVec2(bb.Max.x, bb.Min.y + specHeight);
+        ImVec2 wfMin = ImVec2(bb.Min.x, specMax.y + 1);
+        ImU32 frame = IM_COL32(50, 50, 50, 255);
+        window->DrawList->AddRectFilled(bb.Min, bb.Max, ImGui::ColorConvertFloat4ToU32(gui::themeManager.waterfallBg));
+        window->DrawList->AddRect(bb.Min, specMax, frame);
+
+        // Bandwidth of the spectrum in the corner
+        std::string bw = hrfreq::toString(bandwidth);
+        window->DrawList->AddText(bb.Min + ImVec2(4.0f * style::uiScale, 2.0f * style::uiScale), ImGui::GetColorU32(ImGuiCol_Text), bw.c_str());
+
+        if (!lineCount) { return; }
+
+        // Trace of the newest spectrum
+        const float* line = &lines[newest * SPECTRUM_VIEW_COLUMNS];
+        float xScale = (size.x - 1.0f) / (float)(SPECTRUM_VIEW_COLUMNS - 1);
+        float yScale = (specHeight - 2.0f) / (max - min);
+        tracePoints.resize(SPECTRUM_VIEW_COLUMNS);
+        for (int i = 0; i < SPECTRUM_VIEW_COLUMNS; i++) {
+            float y = specMax.y - 1.0f - ((line[i] - min) * yScale);
+            tracePoints[i] = ImVec2(bb.Min.x + ((float)i * xScale), std::clamp<float>(y, bb.Min.y + 1.0f, specMax.y - 1.0f));
+        }
+        window->DrawList->AddPolyline(tracePoints.data(), SPECTRUM_VIEW_COLUMNS, ImGui::GetColorU32(ImGuiCol_PlotLines), ImDrawFlags_None, 1.0f);
+
+        // Waterfall, the newest line at the top
+        if (newData || min != lastMin || max != lastMax) {
+            updateTexture(min, max);
+            newData = false;
+            lastMin = min;
+            lastMax = max;
+        }
+        float rows = (float)lineCount / (float)SPECTRUM_VIEW_LINES;
+        window->DrawList->AddImage((void*)(intptr_t)textureId, wfMin, ImVec2(bb.Max.x, wfMin.y + ((bb.Max.y - wfMin.y) * rows)), ImVec2(0, 0), ImVec2(1, rows));
+    }
+
+    void SpectrumView::updateTexture(float min, float max) {
+        float range = max - min;
+        const uint32_t* pallette = gui::waterfall.getPallette();
+        for (int i = 0; i < lineCount; i++) {
+            const float* line = &lines[((newest + i) % SPECTRUM_VIEW_LINES) * SPECTRUM_VIEW_COLUMNS];
+            uint32_t* out = &pixels[i * SPECTRUM_VIEW_COLUMNS];
+            for (int j = 0; j < SPECTRUM_VIEW_COLUMNS; j++) {
+                float pixel = (std::clamp<float>(line[j], min, max) - min) / range;
+                out[j] = pallette[(int)(pixel * (WATERFALL_RESOLUTION - 1))];
+            }
+        }
+
+        if (!textureId) { glGenTextures(1, &textureId); }
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SPECTRUM_VIEW_COLUMNS, SPECTRUM_VIEW_LINES, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+}
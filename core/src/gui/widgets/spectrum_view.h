@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <imgui/imgui.h>
+#include <gui/widgets/zoom_map.h>
+
+#include <utils/opengl_include_code.h>
+
+// Number of columns and lines kept by a spectrum view
+#define SPECTRUM_VIEW_COLUMNS   512
+#define SPECTRUM_VIEW_LINES     128
+
+namespace ImGui {
+    // Small spectrum with a waterfall below it, used to show narrow spectra outside of the main waterfall.
+    // Spectra are reduced to a fixed number of columns keeping their peaks when pushed.
+    class SpectrumView {
+    public:
+        SpectrumView();
+        ~SpectrumView();
+
+        void push(const float* data, int size);
+        void clear();
+
+        void draw(float min, float max, double bandwidth, const ImVec2& size_arg = ImVec2(0, 0));
+
+    private:
+        void updateTexture(float min, float max);
+
+        ZoomMap zoom;
+        std::vector<float> lines;
+        std::vector<uint32_t> pixels;
+        int newest = 0;
+        int lineCount = 0;
+        bool newData = false;
+        float lastMin = 0.0f;
+        float lastMax = 0.0f;
+        std::vector<ImVec2> tracePoints;
+
+        GLuint textureId = 0;
+    };
+}
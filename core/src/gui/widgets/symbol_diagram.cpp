@@ -1,4 +1,5 @@
 #include <gui/widgets/symbol_diagram.h>
+#include <gui/widgets/point_batch.h>
 
 namespace ImGui {
     SymbolDiagram::SymbolDiagram(float scale, int count) {
@@ -36,11 +37,14 @@ namespace ImGui {
             window->DrawList->AddLine(ImVec2(min.x, (((l * _scale) + 1) * (size.y * 0.5f)) + min.y), ImVec2(min.x + size.x, (((l * _scale) + 1) * (size.y * 0.5f)) + min.y), IM_COL32(80, 80, 80, 255));
         }
 
+        PointBatch points;
+        points.begin(window->DrawList, sampleCount, col);
         for (int i = 0; i < sampleCount; i++) {
             val = buffer[i] * _scale;
             if (val > 1.0f || val < -1.0f) { continue; }
-            window->DrawList->AddCircleFilled(ImVec2(((float)i * increment) + min.x, ((val + 1) * (size.y * 0.5f)) + min.y), 2, col);
+            points.add(((float)i * increment) + min.x, ((val + 1) * (size.y * 0.5f)) + min.y);
         }
+        points.end();
     }
 
     float* SymbolDiagram::acquireBuffer() {
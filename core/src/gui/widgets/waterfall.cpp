@@ -7,6 +7,8 @@
 #include <utils/flog.h>
 #include <gui/gui.h>
 #include <gui/style.h>
+#include <signal_path/signal_path.h>
+#include <dsp/kernels/kernels.h>
 
 float DEFAULT_COLOR_MAP[][3] = {
     { 0x00, 0x00, 0x20 },
@@ -62,33 +64,6 @@ inline void printAndScale(double freq, char* buf) {
     }
 }
 
-inline void doZoom(int offset, int width, int inSize, int outSize, float* in, float* out) {
-    // NOTE: REMOVE THAT SHIT, IT'S JUST A HACKY FIX
-    if (offset < 0) {
-        offset = 0;
-    }
-    if (width > 524288) {
-        width = 524288;
-    }
-
-    float factor = (float)width / (float)outSize;
-    float sFactor = ceilf(factor);
-    float uFactor;
-    float id = offset;
-    float maxVal;
-    int sId;
-    for (int i = 0; i < outSize; i++) {
-        maxVal = -INFINITY;
-        sId = (int)id;
-        uFactor = (sId + sFactor > inSize) ? sFactor - ((sId + sFactor) - inSize) : sFactor;
-        for (int j = 0; j < uFactor; j++) {
-            if (in[sId + j] > maxVal) { maxVal = in[sId + j]; }
-        }
-        out[i] = maxVal;
-        id += factor;
-    }
-}
-
 namespace ImGui {
     WaterFall::WaterFall() {
         fftMin = -70.0;
@@ -115,6 +90,17 @@ namespace ImGui {
 
     void WaterFall::init() {
         glGenTextures(1, &textureId);
+        gpuColormap = colormap.init();
+        paletteUpdate = true;
+        gpuFFT.init();
+    }
+
+    void WaterFall::buildTrace(const float* data, float scaleFactor) {
+        tracePoints.resize(dataWidth);
+        for (int i = 0; i < dataWidth; i++) {
+            float pos = fftAreaMax.y - ((data[i] - fftMin) * scaleFactor);
+            tracePoints[i] = ImVec2(fftAreaMin.x + i, roundf(std::clamp<float>(pos, fftAreaMin.y + 1, fftAreaMax.y)));
+        }
     }
 
     void WaterFall::drawFFT() {
@@ -159,30 +145,33 @@ namespace ImGui {
             window->DrawList->AddText(ImVec2(roundf(xPos - (txtSz.x / 2.0)), fftAreaMax.y + txtSz.y), text, buf);
         }
 
-        // Data
+        // Data, the trace is a single polyline and its shadow a single triangle strip down to the axis
         if (latestFFT != NULL && fftLines != 0) {
-            for (int i = 1; i < dataWidth; i++) {
-                double aPos = fftAreaMax.y - ((latestFFT[i - 1] - fftMin) * scaleFactor);
-                double bPos = fftAreaMax.y - ((latestFFT[i] - fftMin) * scaleFactor);
-                aPos = std::clamp<double>(aPos, fftAreaMin.y + 1, fftAreaMax.y);
-                bPos = std::clamp<double>(bPos, fftAreaMin.y + 1, fftAreaMax.y);
-                window->DrawList->AddLine(ImVec2(fftAreaMin.x + i - 1, roundf(aPos)),
-                                          ImVec2(fftAreaMin.x + i, roundf(bPos)), trace, 1.0);
-                window->DrawList->AddLine(ImVec2(fftAreaMin.x + i, roundf(bPos)),
-                                          ImVec2(fftAreaMin.x + i, fftAreaMax.y), shadow, 1.0);
+            buildTrace(latestFFT, scaleFactor);
+            ImDrawList* dl = window->DrawList;
+            ImVec2 uv = ImGui::GetDrawListSharedData()->TexUvWhitePixel;
+            dl->PrimReserve((dataWidth - 1) * 6, dataWidth * 2);
+            ImDrawIdx base = (ImDrawIdx)dl->_VtxCurrentIdx;
+            for (int i = 0; i < dataWidth; i++) {
+                dl->PrimWriteVtx(tracePoints[i], uv, shadow);
+                dl->PrimWriteVtx(ImVec2(tracePoints[i].x, fftAreaMax.y), uv, shadow);
             }
+            for (int i = 0; i < dataWidth - 1; i++) {
+                ImDrawIdx a = base + (i * 2);
+                dl->PrimWriteIdx(a);
+                dl->PrimWriteIdx(a + 1);
+                dl->PrimWriteIdx(a + 2);
+                dl->PrimWriteIdx(a + 1);
+                dl->PrimWriteIdx(a + 3);
+                dl->PrimWriteIdx(a + 2);
+            }
+            dl->AddPolyline(tracePoints.data(), dataWidth, trace, ImDrawFlags_None, 1.0);
         }
 
         // Hold
         if (fftHold && latestFFT != NULL && latestFFTHold != NULL && fftLines != 0) {
-            for (int i = 1; i < dataWidth; i++) {
-                double aPos = fftAreaMax.y - ((latestFFTHold[i - 1] - fftMin) * scaleFactor);
-                double bPos = fftAreaMax.y - ((latestFFTHold[i] - fftMin) * scaleFactor);
-                aPos = std::clamp<double>(aPos, fftAreaMin.y + 1, fftAreaMax.y);
-                bPos = std::clamp<double>(bPos, fftAreaMin.y + 1, fftAreaMax.y);
-                window->DrawList->AddLine(ImVec2(fftAreaMin.x + i - 1, roundf(aPos)),
-                                          ImVec2(fftAreaMin.x + i, roundf(bPos)), traceHold, 1.0);
-            }
+            buildTrace(latestFFTHold, scaleFactor);
+            window->DrawList->AddPolyline(tracePoints.data(), dataWidth, traceHold, ImDrawFlags_None, 1.0);
         }
 
         FFTRedrawArgs args;
@@ -206,13 +195,32 @@ namespace ImGui {
     }
 
     void WaterFall::drawWaterfall() {
+        // Go back to coloring on the CPU if the shader couldn't be used
+        if (gpuColormap && !colormap.isAvailable()) {
+            {
+                std::lock_guard<std::mutex> lck(texMtx);
+                gpuColormap = false;
+            }
+            updateWaterfallFb();
+        }
+        if (gpuColormap && paletteUpdate) {
+            paletteUpdate = false;
+            colormap.setPalette(waterfallPallet, WATERFALL_RESOLUTION);
+        }
+
         if (waterfallUpdate) {
             waterfallUpdate = false;
             updateWaterfallTexture();
         }
         {
+            // The texture wraps around vertically so that the newest line ends up on top
             std::lock_guard<std::mutex> lck(texMtx);
-            window->DrawList->AddImage((void*)(intptr_t)textureId, wfMin, wfMax);
+            if (gpuColormap) {
+                colormap.addImage(window->DrawList, textureId, wfMin, wfMax, ImVec2(0.0f, texOffset), ImVec2(1.0f, texOffset + 1.0f), waterfallMin, waterfallMax);
+            }
+            else {
+                window->DrawList->AddImage((void*)(intptr_t)textureId, wfMin, wfMax, ImVec2(0.0f, texOffset), ImVec2(1.0f, texOffset + 1.0f));
+            }
         }
         
         ImVec2 mPos = ImGui::GetMousePos();
@@ -492,7 +500,7 @@ namespace ImGui {
                         ImGui::Text("Bandwidth Locked: %s", _vfo->bandwidthLocked ? "Yes" : "No");
 
                         float strength, snr;
-                        if (calculateVFOSignalInfo(waterfallVisible ? &rawFFTs[currentFFTLine * rawFFTSize] : rawFFTs, _vfo, strength, snr)) {
+                        if (calculateVFOSignalInfo(handoffBufs[handoffFront], _vfo, strength, snr)) {
                             ImGui::Text("Strength: %0.1fdBFS", strength);
                             ImGui::Text("SNR: %0.1fdB", snr);
                         }
@@ -572,19 +580,27 @@ namespace ImGui {
         float max = -INFINITY;
         int avgCount = 0;
 
-        // Calculate Left average
-        for (int i = vfoMinSideOffset; i < vfoMinOffset; i++) {
-            avg += fftLine[i];
-            avgCount++;
+        // Take the noise floor from the spectrum statistics. They aren't gathered for spectra pushed by sources,
+        // the average of the bins on each side of the VFO is used instead
+        SpectrumStats::ChannelStats stats;
+        if (sigpath::spectrumStats.getChannelStats(_vfo->centerOffset, _vfo->bandwidth, stats)) {
+            avg = stats.noiseFloor;
         }
+        else {
+            // Calculate Left average
+            for (int i = vfoMinSideOffset; i < vfoMinOffset; i++) {
+                avg += fftLine[i];
+                avgCount++;
+            }
 
-        // Calculate Right average
-        for (int i = vfoMaxOffset + 1; i < vfoMaxSideOffset; i++) {
-            avg += fftLine[i];
-            avgCount++;
-        }
+            // Calculate Right average
+            for (int i = vfoMaxOffset + 1; i < vfoMaxSideOffset; i++) {
+                avg += fftLine[i];
+                avgCount++;
+            }
 
-        avg /= (double)(avgCount);
+            avg /= (double)(avgCount);
+        }
 
         // Calculate max
         for (int i = vfoMinOffset; i <= vfoMaxOffset; i++) {
@@ -598,7 +614,7 @@ namespace ImGui {
     }
 
     void WaterFall::updateWaterfallFb() {
-        if (!waterfallVisible || rawFFTs == NULL) {
+        if (!waterfallVisible || !history.getLineSize()) {
             return;
         }
         double offsetRatio = viewOffset / (wholeBandwidth / 2.0);
@@ -606,32 +622,52 @@ namespace ImGui {
         int drawDataStart;
         // TODO: Maybe put on the stack for faster alloc?
         float* tempData = new float[dataWidth];
-        float pixel;
-        float dataRange = waterfallMax - waterfallMin;
+        float* lineData = new float[rawFFTSize];
         int count = std::min<float>(waterfallHeight, fftLines);
-        if (rawFFTs != NULL && fftLines >= 0) {
+        std::lock_guard<std::mutex> lck(texMtx);
+        if (fftLines >= 0) {
+            drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
+            drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
+
+            // Read from the coarsest level of the history that still has a bin per column, the levels being
+            // reduced by maximum they can't be used when averaging. Only the bins in view are decoded
+            int level = (historyZoom.getMode() == ZoomMap::PEAK) ? history.getLevelFor(drawDataSize, dataWidth) : 0;
+            int levelSize = history.getLevelSize(level);
+            int levelStart = drawDataStart >> level;
+            int levelWidth = drawDataSize >> level;
+            int decodeStart = std::max<int>(levelStart, 0);
+            int decodeCount = levelWidth + (levelWidth / std::max<int>(dataWidth, 1)) + 2;
             for (int i = 0; i < count; i++) {
-                drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
-                drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
-                doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, &rawFFTs[((i + currentFFTLine) % waterfallHeight) * rawFFTSize], tempData);
-                for (int j = 0; j < dataWidth; j++) {
-                    pixel = (std::clamp<float>(tempData[j], waterfallMin, waterfallMax) - waterfallMin) / dataRange;
-                    waterfallFb[(i * dataWidth) + j] = waterfallPallet[(int)(pixel * (WATERFALL_RESOLUTION - 1))];
+                history.read((i + currentFFTLine) % waterfallHeight, lineData, decodeStart, decodeCount, level);
+                if (gpuColormap) {
+                    historyZoom.process(levelStart, levelWidth, levelSize, dataWidth, lineData, &waterfallLevels[i * dataWidth]);
+                    continue;
                 }
+                historyZoom.process(levelStart, levelWidth, levelSize, dataWidth, lineData, tempData);
+                dsp::kernels::get().colorize(&waterfallFb[i * dataWidth], tempData, dataWidth, waterfallMin, waterfallMax, waterfallPallet, WATERFALL_RESOLUTION);
             }
 
             for (int i = count; i < waterfallHeight; i++) {
                 for (int j = 0; j < dataWidth; j++) {
-                    waterfallFb[(i * dataWidth) + j] = (uint32_t)255 << 24;
+                    if (gpuColormap) {
+                        waterfallLevels[(i * dataWidth) + j] = COLORMAP_SHADER_BLANK;
+                    }
+                    else {
+                        waterfallFb[(i * dataWidth) + j] = (uint32_t)255 << 24;
+                    }
                 }
             }
         }
         delete[] tempData;
+        delete[] lineData;
+
+        // The ring now starts at the first row again
+        fbHead = 0;
+        fbFullUpload = true;
         waterfallUpdate = true;
     }
 
     void WaterFall::drawBandPlan() {
-        int count = bandplan->bands.size();
         double horizScale = (double)dataWidth / viewBandwidth;
         double start, end, center, aPos, bPos, cPos, width;
         ImVec2 txtSz;
@@ -649,7 +685,13 @@ namespace ImGui {
         }
 
 
-        for (int i = 0; i < count; i++) {
+        // Only go through the bands that can overlap the view
+        int first, last;
+        bandplan::findBands(*bandplan, lowerFreq, upperFreq, first, last);
+        bandplan::updateLayout(*bandplan);
+
+        for (int k = first; k < last; k++) {
+            int i = bandplan->startOrder[k];
             start = bandplan->bands[i].start;
             end = bandplan->bands[i].end;
             if (start < lowerFreq && end < lowerFreq) {
@@ -667,15 +709,9 @@ namespace ImGui {
             bPos = fftAreaMin.x + ((end - lowerFreq) * horizScale);
             cPos = fftAreaMin.x + ((center - lowerFreq) * horizScale);
             width = bPos - aPos;
-            txtSz = ImGui::CalcTextSize(bandplan->bands[i].name.c_str());
-            if (bandplan::colorTable.find(bandplan->bands[i].type.c_str()) != bandplan::colorTable.end()) {
-                color = bandplan::colorTable[bandplan->bands[i].type].colorValue;
-                colorTrans = bandplan::colorTable[bandplan->bands[i].type].transColorValue;
-            }
-            else {
-                color = IM_COL32(255, 255, 255, 255);
-                colorTrans = IM_COL32(255, 255, 255, 100);
-            }
+            txtSz = bandplan->nameSizes[i];
+            color = bandplan->colors[i];
+            colorTrans = bandplan->transColors[i];
             if (aPos <= fftAreaMin.x) {
                 aPos = fftAreaMin.x + 1;
             }
@@ -703,11 +739,45 @@ namespace ImGui {
 
     void WaterFall::updateWaterfallTexture() {
         std::lock_guard<std::mutex> lck(texMtx);
+        if (waterfallHeight <= 0) { return; }
         glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dataWidth, waterfallHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)waterfallFb);
+
+        // Reallocate the whole texture when its size changed or the framebuffer was redrawn
+        bool full = (fbFullUpload || fbNewRows >= waterfallHeight || texWidth != dataWidth || texHeight != waterfallHeight);
+        if (gpuColormap && full) {
+            colormap.uploadTexture(textureId, dataWidth, waterfallHeight, waterfallLevels);
+            texWidth = dataWidth;
+            texHeight = waterfallHeight;
+        }
+        else if (gpuColormap) {
+            int first = fbHead;
+            int count = std::min<int>(fbNewRows, waterfallHeight - first);
+            colormap.uploadRows(textureId, dataWidth, first, count, &waterfallLevels[first * dataWidth]);
+            if (count < fbNewRows) {
+                colormap.uploadRows(textureId, dataWidth, 0, fbNewRows - count, waterfallLevels);
+            }
+        }
+        else if (full) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dataWidth, waterfallHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)waterfallFb);
+            texWidth = dataWidth;
+            texHeight = waterfallHeight;
+        }
+        else {
+            // Upload the new lines, which may wrap around the end of the ring
+            int first = fbHead;
+            int count = std::min<int>(fbNewRows, waterfallHeight - first);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, dataWidth, count, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)&waterfallFb[first * dataWidth]);
+            if (count < fbNewRows) {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, dataWidth, fbNewRows - count, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)waterfallFb);
+            }
+        }
+        fbFullUpload = false;
+        fbNewRows = 0;
+        texOffset = (float)fbHead / (float)waterfallHeight;
     }
 
     void WaterFall::onPositionChange() {
@@ -722,8 +792,6 @@ namespace ImGui {
             return;
         }
 
-        int lastWaterfallHeight = waterfallHeight;
-
         if (waterfallVisible) {
             FFTAreaHeight = std::min<int>(FFTAreaHeight, widgetSize.y - (50.0f * style::uiScale));
             newFFTAreaHeight = FFTAreaHeight;
@@ -738,21 +806,8 @@ namespace ImGui {
         if (waterfallVisible) {
             // Raw FFT resize
             fftLines = std::min<int>(fftLines, waterfallHeight) - 1;
-            if (rawFFTs != NULL) {
-                if (currentFFTLine != 0) {
-                    float* tempWF = new float[currentFFTLine * rawFFTSize];
-                    int moveCount = lastWaterfallHeight - currentFFTLine;
-                    memcpy(tempWF, rawFFTs, currentFFTLine * rawFFTSize * sizeof(float));
-                    memmove(rawFFTs, &rawFFTs[currentFFTLine * rawFFTSize], moveCount * rawFFTSize * sizeof(float));
-                    memcpy(&rawFFTs[moveCount * rawFFTSize], tempWF, currentFFTLine * rawFFTSize * sizeof(float));
-                    delete[] tempWF;
-                }
-                currentFFTLine = 0;
-                rawFFTs = (float*)realloc(rawFFTs, waterfallHeight * rawFFTSize * sizeof(float));
-            }
-            else {
-                rawFFTs = (float*)malloc(waterfallHeight * rawFFTSize * sizeof(float));
-            }
+            history.reshape(waterfallHeight, currentFFTLine);
+            currentFFTLine = 0;
             // ==============
         }
 
@@ -778,9 +833,15 @@ namespace ImGui {
         }
 
         if (waterfallVisible) {
+            std::lock_guard<std::mutex> lck3(texMtx);
             delete[] waterfallFb;
             waterfallFb = new uint32_t[dataWidth * waterfallHeight];
             memset(waterfallFb, 0, dataWidth * waterfallHeight * sizeof(uint32_t));
+            delete[] waterfallLevels;
+            waterfallLevels = new float[dataWidth * waterfallHeight];
+            std::fill(waterfallLevels, waterfallLevels + (dataWidth * waterfallHeight), COLORMAP_SHADER_BLANK);
+            fbHead = 0;
+            fbFullUpload = true;
         }
         for (int i = 0; i < dataWidth; i++) {
             latestFFT[i] = -1000.0f; // Hide everything
@@ -808,6 +869,7 @@ namespace ImGui {
 
     void WaterFall::draw() {
         buf_mtx.lock();
+        consumeFFT();
         window = GetCurrentWindow();
 
         widgetPos = ImGui::GetWindowContentRegionMin();
@@ -874,39 +936,114 @@ namespace ImGui {
     }
 
     float* WaterFall::getFFTBuffer() {
-        if (rawFFTs == NULL) { return NULL; }
-        buf_mtx.lock();
+        return handoffBufs[handoffBack];
+    }
+
+    void WaterFall::pushFFT() {
+        float* line = handoffBufs[handoffBack];
+        if (line == NULL) { return; }
+
+        // Combine the spectra with the ones published since the GUI took the last row, and hold on to the result for
+        // as long as it didn't take it, the back buffer being reused for the next spectrum
+        LineIntegration mode = lineIntegration.load();
+        if (mode != integrationMode) {
+            integrationMode = mode;
+            integratedLines = 0;
+        }
+        if (mode != LINE_INTEGRATION_LATEST) {
+            if (!integratedLines) {
+                memcpy(integrationBuf.data(), line, rawFFTSize * sizeof(float));
+            }
+            else if (mode == LINE_INTEGRATION_MAX) {
+                volk_32f_x2_max_32f(integrationBuf.data(), integrationBuf.data(), line, rawFFTSize);
+            }
+            else {
+                volk_32f_x2_add_32f(integrationBuf.data(), integrationBuf.data(), line, rawFFTSize);
+            }
+            integratedLines++;
+            if (handoffPending.load() & WATERFALL_HANDOFF_FRESH) { return; }
+
+            if (integratedLines > 1) {
+                float scale = (mode == LINE_INTEGRATION_AVERAGE) ? (1.0f / (float)integratedLines) : 1.0f;
+                volk_32f_s32f_multiply_32f(line, integrationBuf.data(), scale, rawFFTSize);
+            }
+            integratedLines = 0;
+        }
+
+        handoffBack = handoffPending.exchange(handoffBack | WATERFALL_HANDOFF_FRESH) & ~WATERFALL_HANDOFF_FRESH;
+    }
+
+    bool WaterFall::pushFFT(const float* data, int size) {
+        std::lock_guard<std::recursive_mutex> lck(buf_mtx);
+        if (size != rawFFTSize || handoffBufs[handoffBack] == NULL) { return false; }
+        memcpy(handoffBufs[handoffBack], data, size * sizeof(float));
+        pushFFT();
+        return true;
+    }
+
+    bool WaterFall::loadHistory(const float* lines, int count, int size) {
+        std::lock_guard<std::recursive_mutex> lck(buf_mtx);
+        if (size != rawFFTSize || !history.getLineSize() || !waterfallVisible) { return false; }
+        count = std::min<int>(count, waterfallHeight);
+        history.clear();
+        for (int i = 0; i < count; i++) { history.write(i, &lines[(size_t)i * size]); }
+        currentFFTLine = 0;
+        fftLines = count;
+        updateWaterfallFb();
+        return true;
+    }
+
+    int WaterFall::getHistoryLines() {
+        std::lock_guard<std::recursive_mutex> lck(buf_mtx);
+        return waterfallVisible ? waterfallHeight : 0;
+    }
+
+    void WaterFall::consumeFFT() {
+        // Spectra of the GPU are read back straight into the front buffer, the statistics being updated here since
+        // they never went through the DSP thread. Otherwise take the newest spectrum if one was published since the last frame
+        if (gpuFFT.process(handoffBufs[handoffFront], handoffBufs[handoffFront] ? rawFFTSize : 0)) {
+            sigpath::spectrumStats.process(handoffBufs[handoffFront], rawFFTSize, sigpath::iqFrontEnd.getEffectiveSamplerate());
+        }
+        else if (handoffPending.load() & WATERFALL_HANDOFF_FRESH) {
+            handoffFront = handoffPending.exchange(handoffFront) & ~WATERFALL_HANDOFF_FRESH;
+        }
+        else { return; }
+        if (!history.getLineSize()) { return; }
+
+        // Store it as the newest line of the history
         if (waterfallVisible) {
             currentFFTLine--;
             fftLines++;
             currentFFTLine = ((currentFFTLine + waterfallHeight) % waterfallHeight);
             fftLines = std::min<float>(fftLines, waterfallHeight);
-            return &rawFFTs[currentFFTLine * rawFFTSize];
+            history.write(currentFFTLine, handoffBufs[handoffFront]);
         }
-        return rawFFTs;
+        processFFT();
     }
 
-    void WaterFall::pushFFT() {
-        if (rawFFTs == NULL) { return; }
+    void WaterFall::processFFT() {
         std::lock_guard<std::recursive_mutex> lck(latestFFTMtx);
         double offsetRatio = viewOffset / (wholeBandwidth / 2.0);
         int drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
         int drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
 
         if (waterfallVisible) {
-            doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, &rawFFTs[currentFFTLine * rawFFTSize], latestFFT);
-            memmove(&waterfallFb[dataWidth], waterfallFb, dataWidth * (waterfallHeight - 1) * sizeof(uint32_t));
-            float pixel;
-            float dataRange = waterfallMax - waterfallMin;
-            for (int j = 0; j < dataWidth; j++) {
-                pixel = (std::clamp<float>(latestFFT[j], waterfallMin, waterfallMax) - waterfallMin) / dataRange;
-                int id = (int)(pixel * (WATERFALL_RESOLUTION - 1));
-                waterfallFb[j] = waterfallPallet[id];
+            zoom.process(drawDataStart, drawDataSize, rawFFTSize, dataWidth, handoffBufs[handoffFront], latestFFT);
+
+            // Write the new line over the oldest one instead of scrolling the whole framebuffer
+            std::lock_guard<std::mutex> lck2(texMtx);
+            fbHead = (fbHead + waterfallHeight - 1) % waterfallHeight;
+            fbNewRows = std::min<int>(fbNewRows + 1, waterfallHeight);
+            if (gpuColormap) {
+                memcpy(&waterfallLevels[fbHead * dataWidth], latestFFT, dataWidth * sizeof(float));
+            }
+            else {
+                dsp::kernels::get().colorize(&waterfallFb[fbHead * dataWidth], latestFFT, dataWidth, waterfallMin, waterfallMax, waterfallPallet, WATERFALL_RESOLUTION);
             }
             waterfallUpdate = true;
         }
         else {
-            doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, rawFFTs, latestFFT);
+            zoom.process(drawDataStart, drawDataSize, rawFFTSize, dataWidth, handoffBufs[handoffFront], latestFFT);
             fftLines = 1;
         }
 
@@ -923,11 +1060,11 @@ namespace ImGui {
             float dummy;
             if (snrSmoothing) {
                 float newSNR = 0.0f;
-                calculateVFOSignalInfo(waterfallVisible ? &rawFFTs[currentFFTLine * rawFFTSize] : rawFFTs, vfos[selectedVFO], dummy, newSNR);
+                calculateVFOSignalInfo(handoffBufs[handoffFront], vfos[selectedVFO], dummy, newSNR);
                 selectedVFOSNR = (snrSmoothingBeta*selectedVFOSNR) + (snrSmoothingAlpha*newSNR);
             }
             else {
-                calculateVFOSignalInfo(waterfallVisible ? &rawFFTs[currentFFTLine * rawFFTSize] : rawFFTs, vfos[selectedVFO], dummy, selectedVFOSNR);
+                calculateVFOSignalInfo(handoffBufs[handoffFront], vfos[selectedVFO], dummy, selectedVFOSNR);
             }
         }
 
@@ -937,8 +1074,6 @@ namespace ImGui {
                 latestFFTHold[i] = std::max<float>(latestFFT[i], latestFFTHold[i] - fftHoldSpeed);
             }
         }
-
-        buf_mtx.unlock();
     }
 
     void WaterFall::updatePallette(float colors[][3], int colorCount) {
@@ -954,7 +1089,12 @@ namespace ImGui {
             float b = (colors[lowerId][2] * (1.0 - ratio)) + (colors[upperId][2] * (ratio));
             waterfallPallet[i] = ((uint32_t)255 << 24) | ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
         }
-        updateWaterfallFb();
+        paletteUpdate = true;
+        if (!gpuColormap) { updateWaterfallFb(); }
+    }
+
+    const uint32_t* WaterFall::getPallette() {
+        return waterfallPallet;
     }
 
     void WaterFall::updatePalletteFromArray(float* colors, int colorCount) {
@@ -970,7 +1110,8 @@ namespace ImGui {
             float b = (colors[(lowerId * 3) + 2] * (1.0 - ratio)) + (colors[(upperId * 3) + 2] * (ratio));
             waterfallPallet[i] = ((uint32_t)255 << 24) | ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
         }
-        updateWaterfallFb();
+        paletteUpdate = true;
+        if (!gpuColormap) { updateWaterfallFb(); }
     }
 
     void WaterFall::autoRange() {
@@ -1095,7 +1236,9 @@ namespace ImGui {
             return;
         }
         waterfallMin = min;
-        if (_fullUpdate) { updateWaterfallFb(); };
+
+        // The shader applies the new range instantly
+        if (_fullUpdate && !gpuColormap) { updateWaterfallFb(); };
     }
 
     float WaterFall::getWaterfallMin() {
@@ -1108,7 +1251,9 @@ namespace ImGui {
             return;
         }
         waterfallMax = max;
-        if (_fullUpdate) { updateWaterfallFb(); };
+
+        // The shader applies the new range instantly
+        if (_fullUpdate && !gpuColormap) { updateWaterfallFb(); };
     }
 
     float WaterFall::getWaterfallMax() {
@@ -1134,15 +1279,21 @@ namespace ImGui {
     void WaterFall::setRawFFTSize(int size) {
         std::lock_guard<std::recursive_mutex> lck(buf_mtx);
         rawFFTSize = size;
-        int wfSize = std::max<int>(1, waterfallHeight);
-        if (rawFFTs != NULL) {
-            rawFFTs = (float*)realloc(rawFFTs, rawFFTSize * wfSize * sizeof(float));
-        }
-        else {
-            rawFFTs = (float*)malloc(rawFFTSize * wfSize * sizeof(float));
-        }
+        history.resize(rawFFTSize, waterfallHeight);
         fftLines = 0;
-        memset(rawFFTs, 0, rawFFTSize * waterfallHeight * sizeof(float));
+
+        // The FFT path is stopped while its size changes, so the handoff buffers can be replaced
+        for (int i = 0; i < 3; i++) {
+            float* buf = (float*)realloc(handoffBufs[i], rawFFTSize * sizeof(float));
+            memset(buf, 0, rawFFTSize * sizeof(float));
+            handoffBufs[i] = buf;
+        }
+        handoffBack = 0;
+        handoffFront = 1;
+        handoffPending = 2;
+        integrationBuf.resize(rawFFTSize);
+        integratedLines = 0;
+
         updateWaterfallFb();
     }
 
@@ -1150,6 +1301,18 @@ namespace ImGui {
         bandPlanPos = pos;
     }
 
+    void WaterFall::setZoomMode(ZoomMap::Mode mode) {
+        std::lock_guard<std::recursive_mutex> lck(buf_mtx);
+        std::lock_guard<std::recursive_mutex> lck2(latestFFTMtx);
+        zoom.setMode(mode);
+        historyZoom.setMode(mode);
+        updateWaterfallFb();
+    }
+
+    void WaterFall::setLineIntegration(LineIntegration mode) {
+        lineIntegration = mode;
+    }
+
     void WaterFall::setFFTHold(bool hold) {
         fftHold = hold;
         if (fftHold && latestFFTHold) {
@@ -1383,12 +1546,12 @@ namespace ImGui {
 
     void WaterFall::showWaterfall() {
         buf_mtx.lock();
-        if (rawFFTs == NULL) {
+        if (!history.getLineSize()) {
             flog::error("Null rawFFT");
         }
         waterfallVisible = true;
         onResize();
-        memset(rawFFTs, 0, waterfallHeight * rawFFTSize * sizeof(float));
+        history.clear();
         updateWaterfallFb();
         buf_mtx.unlock();
     }
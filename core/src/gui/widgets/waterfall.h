@@ -1,7 +1,12 @@
 #pragma once
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <gui/widgets/bandplan.h>
+#include <gui/widgets/colormap_shader.h>
+#include <gui/widgets/fft_history.h>
+#include <gui/widgets/gpu_fft.h>
+#include <gui/widgets/zoom_map.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 #include <utils/event.h>
@@ -10,6 +15,9 @@
 
 #define WATERFALL_RESOLUTION 1000000
 
+// Flag marking the pending FFT handoff buffer as not yet consumed by the GUI
+#define WATERFALL_HANDOFF_FRESH 4
+
 namespace ImGui {
     class WaterfallVFO {
     public:
@@ -90,9 +98,21 @@ namespace ImGui {
         float* getFFTBuffer();
         void pushFFT();
 
+        // Push a spectrum computed outside of the IQ front end, dropped unless it has the current raw FFT size
+        bool pushFFT(const float* data, int size);
+
+        // Replace the history with count lines of the current raw FFT size, the newest first, and redraw the waterfall
+        // from it. Meant for spectra read back from an archive, while the IQ front end doesn't compute any. Returns
+        // false if the lines don't have the raw FFT size. Lines beyond getHistoryLines() are dropped
+        bool loadHistory(const float* lines, int count, int size);
+        int getHistoryLines();
+
         void updatePallette(float colors[][3], int colorCount);
         void updatePalletteFromArray(float* colors, int colorCount);
 
+        // Palette of WATERFALL_RESOLUTION colors going from the lowest to the highest level
+        const uint32_t* getPallette();
+
         void setCenterFrequency(double freq);
         double getCenterFrequency();
 
@@ -139,6 +159,18 @@ namespace ImGui {
 
         void setBandPlanPos(int pos);
 
+        void setZoomMode(ZoomMap::Mode mode);
+
+        enum LineIntegration {
+            LINE_INTEGRATION_LATEST,
+            LINE_INTEGRATION_MAX,
+            LINE_INTEGRATION_AVERAGE
+        };
+
+        // How the spectra published while the GUI draws a frame make up the row it takes: only the latest one is kept,
+        // or they are combined into one with their highest or average level in dB
+        void setLineIntegration(LineIntegration mode);
+
         void setFFTHold(bool hold);
         void setFFTHoldSpeed(float speed);
 
@@ -194,6 +226,9 @@ namespace ImGui {
             double pixelToFreqRatio;
         };
 
+        // Computes the spectra on the GPU when IQFrontEnd offloads its frames to it, see IQFrontEnd::setFFTOffload()
+        GPUFFT gpuFFT;
+
         bool inputHandled = false;
         bool VFOMoveSingleClick = false;
         Event<InputHandlerArgs> onInputProcess;
@@ -220,6 +255,9 @@ namespace ImGui {
 
     private:
         void drawWaterfall();
+        void consumeFFT();
+        void processFFT();
+        void buildTrace(const float* data, float scaleFactor);
         void drawFFT();
         void drawVFOs();
         void drawBandPlan();
@@ -281,17 +319,51 @@ namespace ImGui {
         float waterfallMin;
         float waterfallMax;
 
-        //std::vector<std::vector<float>> rawFFTs;
         int rawFFTSize;
-        float* rawFFTs = NULL;
+        FFTHistory history;
         float* latestFFT = NULL;
         float* latestFFTHold = NULL;
+        std::vector<ImVec2> tracePoints;
+
+        // Spectra are handed from the DSP thread to the GUI through three buffers so that neither side waits for the other.
+        // The DSP fills the back buffer and swaps it with the pending one, the GUI takes the pending one at the start of
+        // each frame if it was refreshed. Spectra published faster than the GUI draws are replaced by newer ones, or
+        // integrated with them, see setLineIntegration()
+        float* handoffBufs[3] = { NULL, NULL, NULL };
+        int handoffBack = 0;
+        int handoffFront = 1;
+        std::atomic<int> handoffPending = 2;
+
+        // Spectra integrated by the DSP thread until the GUI takes the pending row
+        std::atomic<LineIntegration> lineIntegration = LINE_INTEGRATION_LATEST;
+        LineIntegration integrationMode = LINE_INTEGRATION_LATEST;
+        std::vector<float> integrationBuf;
+        int integratedLines = 0;
         float* smoothingBuf = NULL;
         int currentFFTLine = 0;
         int fftLines = 0;
 
         uint32_t* waterfallFb;
 
+        // The waterfall framebuffer is used as a ring, fbHead being the row of the newest line.
+        // Only the lines pushed since the last upload are sent to the texture unless it was redrawn entirely
+        int fbHead = 0;
+        int fbNewRows = 0;
+        bool fbFullUpload = true;
+        int texWidth = 0;
+        int texHeight = 0;
+        float texOffset = 0.0f;
+
+        // When the GPU supports it, the waterfall keeps levels in dB and the palette is applied by a shader
+        ColormapShader colormap;
+        bool gpuColormap = false;
+        bool paletteUpdate = false;
+        float* waterfallLevels = NULL;
+
+        // Bins to columns mapping of the current view for new lines and for redraws from the history
+        ZoomMap zoom;
+        ZoomMap historyZoom;
+
         bool draggingFW = false;
         int FFTAreaHeight;
         int newFFTAreaHeight;
@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <math.h>
+#include <algorithm>
+
+// Number of values reduced in parallel, allows the compiler to vectorize the loops
+#define ZOOM_MAP_LANES  8
+
+namespace ImGui {
+    // Maps the bins of an FFT to display columns. The bins covered by each column are computed once for a
+    // given view instead of for every line, and each column is reduced to the maximum of its bins so that
+    // narrow peaks stay visible when zoomed out, or optionally to their mean.
+    class ZoomMap {
+    public:
+        enum Mode {
+            PEAK,
+            MEAN
+        };
+
+        void setMode(Mode mode) { _mode = mode; }
+
+        Mode getMode() { return _mode; }
+
+        // Zoom width bins starting at offset out of the inSize bins of in to the outSize columns of out
+        inline void process(int offset, int width, int inSize, int outSize, const float* in, float* out) {
+            if (offset != _offset || width != _width || inSize != _inSize || outSize != _outSize) {
+                rebuild(offset, width, inSize, outSize);
+            }
+
+            const int* s = starts.data();
+            const int* c = counts.data();
+            if (_mode == MEAN) {
+                for (int i = 0; i < outSize; i++) { out[i] = mean(&in[s[i]], c[i]); }
+            }
+            else {
+                for (int i = 0; i < outSize; i++) { out[i] = peak(&in[s[i]], c[i]); }
+            }
+        }
+
+    private:
+        void rebuild(int offset, int width, int inSize, int outSize) {
+            _offset = offset;
+            _width = width;
+            _inSize = inSize;
+            _outSize = outSize;
+            starts.resize(outSize);
+            counts.resize(outSize);
+
+            // Each column starts at its position in the view and spans the rounded up number of bins per column
+            offset = std::max<int>(offset, 0);
+            width = std::min<int>(width, 524288);
+            double factor = (double)width / (double)outSize;
+            int span = ceil(factor);
+            for (int i = 0; i < outSize; i++) {
+                int start = std::clamp<int>(offset + (int)((double)i * factor), 0, inSize);
+                starts[i] = start;
+                counts[i] = std::clamp<int>(span, 0, inSize - start);
+            }
+        }
+
+        static inline float peak(const float* in, int count) {
+            if (count < ZOOM_MAP_LANES) {
+                float maxVal = -INFINITY;
+                for (int i = 0; i < count; i++) { maxVal = std::max<float>(maxVal, in[i]); }
+                return maxVal;
+            }
+
+            float acc[ZOOM_MAP_LANES];
+            for (int l = 0; l < ZOOM_MAP_LANES; l++) { acc[l] = in[l]; }
+            int i = ZOOM_MAP_LANES;
+            for (; i + ZOOM_MAP_LANES <= count; i += ZOOM_MAP_LANES) {
+                for (int l = 0; l < ZOOM_MAP_LANES; l++) { acc[l] = std::max<float>(acc[l], in[i + l]); }
+            }
+
+            // The last bins are covered by a final overlapping vector
+            for (int l = 0; l < ZOOM_MAP_LANES; l++) { acc[l] = std::max<float>(acc[l], in[count - ZOOM_MAP_LANES + l]); }
+            float maxVal = acc[0];
+            for (int l = 1; l < ZOOM_MAP_LANES; l++) { maxVal = std::max<float>(maxVal, acc[l]); }
+            return maxVal;
+        }
+
+        static inline float mean(const float* in, int count) {
+            if (!count) { return -INFINITY; }
+            float acc[ZOOM_MAP_LANES] = {};
+            int i = 0;
+            for (; i + ZOOM_MAP_LANES <= count; i += ZOOM_MAP_LANES) {
+                for (int l = 0; l < ZOOM_MAP_LANES; l++) { acc[l] += in[i + l]; }
+            }
+            float sum = 0.0f;
+            for (; i < count; i++) { sum += in[i]; }
+            for (int l = 0; l < ZOOM_MAP_LANES; l++) { sum += acc[l]; }
+            return sum / (float)count;
+        }
+
+        Mode _mode = PEAK;
+        int _offset = -1;
+        int _width = -1;
+        int _inSize = -1;
+        int _outSize = -1;
+        std::vector<int> starts;
+        std::vector<int> counts;
+    };
+}
@@ -0,0 +1,304 @@
+#include "headless.h"
+#include "core.h"
+#include "metrics.h"
+#include "session_snapshot.h"
+#include <utils/flog.h>
+#include <utils/net.h>
+#include <utils/startup_timer.h>
+#include <version.h>
+#include <config.h>
+#include <signal_path/signal_path.h>
+#include <gui/gui.h>
+#include <gui/smgui.h>
+#include <gui/tuner.h>
+#include <gui/menus/source.h>
+#include <gui/menus/sink.h>
+#include <dsp/fft/plan.h>
+#include <dsp/volk_profile.h>
+#include <filesystem>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <sstream>
+
+// Longest request line and number of header lines accepted by the HTTP interface
+#define HEADLESS_HTTP_MAX_LINE      4096
+#define HEADLESS_HTTP_MAX_HEADERS   64
+
+// Milliseconds after which a silent HTTP client is dropped
+#define HEADLESS_HTTP_TIMEOUT       2000
+
+namespace headless {
+    std::atomic<bool> running = true;
+    dsp::stream<dsp::complex_t> dummyStream;
+    EventHandler<VFOManager::VFO*> vfoCreatedHandler;
+
+    void signalHandler(int sig) {
+        running = false;
+    }
+
+    // Nothing displays the spectrum, so it's never computed
+    float* acquireFFTBuffer(void* ctx) { return NULL; }
+    void releaseFFTBuffer(void* ctx) {}
+
+    // Restore the offsets VFOs had when the config was last saved by the GUI
+    void vfoCreated(VFOManager::VFO* vfo, void* ctx) {
+        std::string name = vfo->getName();
+        core::configManager.acquire();
+        if (!core::configManager.conf["vfoOffsets"].contains(name)) {
+            core::configManager.release();
+            return;
+        }
+        double offset = core::configManager.conf["vfoOffsets"][name];
+        core::configManager.release();
+        sigpath::vfoManager.setCenterOffset(name, offset);
+    }
+
+    // Value of a parameter of the query string, no escape sequences are used by the numbers and names it carries
+    // except for spaces
+    std::string queryParam(const std::string& query, const std::string& name) {
+        std::istringstream ss(query);
+        std::string param;
+        while (std::getline(ss, param, '&')) {
+            size_t eq = param.find('=');
+            if (eq == std::string::npos || param.substr(0, eq) != name) { continue; }
+            std::string value = param.substr(eq + 1);
+            for (size_t i = 0; i < value.size(); i++) {
+                if (value[i] == '+') { value[i] = ' '; }
+                else if (value[i] == '%' && i + 2 < value.size()) {
+                    value.replace(i, 3, 1, (char)strtol(value.substr(i + 1, 2).c_str(), NULL, 16));
+                }
+            }
+            return value;
+        }
+        return "";
+    }
+
+    json status() {
+        json resp;
+        core::configManager.acquire();
+        resp["source"] = core::configManager.conf["source"];
+        core::configManager.release();
+        resp["playing"] = gui::mainWindow.isPlaying();
+        resp["frequency"] = gui::waterfall.getCenterFrequency();
+        resp["bandwidth"] = gui::waterfall.getBandwidth();
+        resp["vfos"] = json::object();
+        for (auto const& [name, vfo] : gui::waterfall.vfos) {
+            resp["vfos"][name]["frequency"] = gui::waterfall.getCenterFrequency() + vfo->generalOffset;
+            resp["vfos"][name]["bandwidth"] = vfo->bandwidth;
+        }
+        resp["modules"] = json::object();
+        for (auto const& [name, inst] : core::moduleManager.instances) {
+            resp["modules"][name]["module"] = core::moduleManager.getInstanceModuleName(name);
+            resp["modules"][name]["enabled"] = core::moduleManager.instanceEnabled(name);
+        }
+        return resp;
+    }
+
+    // Handle a request, returning the HTTP status code and filling the body. Every endpoint answers with the status
+    // of the SDR after the request was applied
+    int handleRequest(const std::string& path, const std::string& query, json& body) {
+        if (path == "/start") {
+            gui::mainWindow.setPlayState(true);
+        }
+        else if (path == "/stop") {
+            gui::mainWindow.setPlayState(false);
+        }
+        else if (path == "/tune") {
+            std::string freq = queryParam(query, "freq");
+            std::string vfo = queryParam(query, "vfo");
+            if (freq.empty()) {
+                body["error"] = "Missing freq parameter";
+                return 400;
+            }
+            if (!vfo.empty() && gui::waterfall.vfos.find(vfo) == gui::waterfall.vfos.end()) {
+                body["error"] = "Unknown VFO";
+                return 404;
+            }
+            tuner::tune(vfo.empty() ? tuner::TUNER_MODE_CENTER : tuner::TUNER_MODE_NORMAL, vfo, strtod(freq.c_str(), NULL));
+        }
+        else if (path == "/module") {
+            std::string name = queryParam(query, "name");
+            std::string enabled = queryParam(query, "enabled");
+            if (core::moduleManager.instances.find(name) == core::moduleManager.instances.end()) {
+                body["error"] = "Unknown module instance";
+                return 404;
+            }
+            if (enabled == "1" || enabled == "true") { core::moduleManager.enableInstance(name); }
+            else if (enabled == "0" || enabled == "false") { core::moduleManager.disableInstance(name); }
+        }
+        else if (path != "/" && path != "/status") {
+            body["error"] = "Unknown endpoint";
+            return 404;
+        }
+        body = status();
+        return 200;
+    }
+
+    void httpClient(std::shared_ptr<net::Socket> sock) {
+        // Request line, the headers are skipped since requests carry no body
+        std::string line;
+        if (sock->recvline(line, HEADLESS_HTTP_MAX_LINE, HEADLESS_HTTP_TIMEOUT) <= 0) { return; }
+        std::string header;
+        for (int i = 0; i < HEADLESS_HTTP_MAX_HEADERS; i++) {
+            if (sock->recvline(header, HEADLESS_HTTP_MAX_LINE, HEADLESS_HTTP_TIMEOUT) <= 0) { return; }
+            if (header.empty() || header == "\r") { break; }
+        }
+
+        std::istringstream ss(line);
+        std::string method, target;
+        ss >> method >> target;
+        json body;
+        int code;
+        if (method != "GET" && method != "POST") {
+            body["error"] = "Unsupported method";
+            code = 405;
+        }
+        else {
+            size_t q = target.find('?');
+            code = handleRequest(target.substr(0, q), (q != std::string::npos) ? target.substr(q + 1) : "", body);
+        }
+
+        std::string content = body.dump() + "\n";
+        const char* reason = (code == 200) ? "OK" : ((code == 400) ? "Bad Request" : ((code == 404) ? "Not Found" : "Method Not Allowed"));
+        std::string resp = "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n";
+        resp += "Content-Type: application/json\r\n";
+        resp += "Content-Length: " + std::to_string(content.size()) + "\r\n";
+        resp += "Connection: close\r\n\r\n";
+        sock->sendstr(resp + content);
+        sock->close();
+    }
+
+    void httpWorker(std::shared_ptr<net::Listener> listener) {
+        while (running) {
+            // Wake up regularly to notice the shutdown
+            auto sock = listener->accept(NULL, 500);
+            if (sock) { httpClient(sock); }
+        }
+        listener->stop();
+    }
+
+    int main() {
+        flog::info("=====| HEADLESS MODE |=====");
+
+        // Menus are never drawn, but anything a module draws through SmGui outside of them is only recorded
+        SmGui::init(true);
+
+        // The spectrum isn't computed since nothing displays it
+        sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, acquireFFTBuffer, releaseFFTBuffer, NULL);
+        sigpath::iqFrontEnd.setFFTEnabled(false);
+        sigpath::iqFrontEnd.start();
+        gui::waterfall.setBandwidth(8000000);
+        gui::waterfall.setViewBandwidth(8000000);
+
+        vfoCreatedHandler.handler = vfoCreated;
+        vfoCreatedHandler.ctx = NULL;
+        sigpath::vfoManager.onVfoCreated.bindHandler(&vfoCreatedHandler);
+        sigpath::createPaths();
+
+        // Load config
+        core::configManager.acquire();
+        std::string modulesDir = core::configManager.conf["modulesDirectory"];
+        std::vector<std::string> modules = core::configManager.conf["modules"];
+        auto modList = core::configManager.conf["moduleInstances"].items();
+        double frequency = core::configManager.conf["frequency"];
+        core::configManager.release();
+        modulesDir = std::filesystem::absolute(modulesDir).string();
+
+        // Unlike the server, every kind of module is loaded
+        flog::info("Loading modules");
+        std::vector<std::string> modulePaths;
+        if (std::filesystem::is_directory(modulesDir)) {
+            for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
+                if (file.path().extension().generic_string() != SDRPP_MOD_EXTENTSION) { continue; }
+                if (!file.is_regular_file()) { continue; }
+                modulePaths.push_back(file.path().generic_string());
+            }
+        }
+        else {
+            flog::warn("Module directory {0} does not exist, not loading modules from directory", modulesDir);
+        }
+        for (auto const& path : modules) {
+            modulePaths.push_back(std::filesystem::absolute(path).string());
+        }
+
+        // Load the modules, their files being read ahead in the background
+        core::moduleManager.prefetch(modulePaths);
+        for (auto const& path : modulePaths) {
+            flog::info("Loading {0}", path);
+            startup_timer::begin("Loading " + std::filesystem::path(path).filename().string());
+            core::moduleManager.loadModule(path);
+        }
+        core::moduleManager.waitPrefetch();
+
+        // Create module instances
+        for (auto const& [name, _module] : modList) {
+            std::string mod = _module["module"];
+            bool enabled = _module["enabled"];
+            flog::info("Initializing {0} ({1})", name, mod);
+            startup_timer::begin("Initializing " + name);
+            core::moduleManager.createInstance(name, mod);
+            if (!enabled) { core::moduleManager.disableInstance(name); }
+        }
+
+        // The source and sink menus only apply their config when initialized, they are never drawn
+        startup_timer::begin("Loading configuration");
+        sourcemenu::init();
+        sinkmenu::init();
+        tuner::tune(tuner::TUNER_MODE_CENTER, "", frequency);
+
+        startup_timer::begin("Module post-init");
+        core::moduleManager.doPostInitAll();
+        session_snapshot::restoreDone();
+
+        // Optional HTTP control interface
+        std::shared_ptr<net::Listener> listener;
+        std::thread httpThread;
+        int httpPort = (int)core::args["http-port"];
+        if (httpPort > 0) {
+            std::string httpAddr = (std::string)core::args["http-addr"];
+            try {
+                listener = net::listen(httpAddr, httpPort);
+                httpThread = std::thread(httpWorker, listener);
+                flog::info("HTTP control listening on {0}:{1}", httpAddr, httpPort);
+            }
+            catch (const std::exception& e) {
+                flog::error("Could not start the HTTP control interface: {0}", e.what());
+            }
+        }
+
+        startup_timer::finish();
+
+        // Unattended stations always run
+        gui::mainWindow.setPlayState(true);
+        flog::info("Ready.");
+
+        // Run until interrupted
+        std::signal(SIGINT, signalHandler);
+        std::signal(SIGTERM, signalHandler);
+        while (running) { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }
+        flog::info("Shutting down");
+
+        if (httpThread.joinable()) { httpThread.join(); }
+        metrics::stop();
+        sigpath::sweeper.stop();
+        sigpath::sourceManager.setAsyncTuning(false);
+        gui::mainWindow.setPlayState(false);
+        session_snapshot::save((std::string)core::args["root"] + "/session.snapshot");
+        for (auto& [name, mod] : core::moduleManager.modules) {
+            mod.end();
+        }
+        sigpath::destroyPaths();
+        sigpath::iqFrontEnd.stop();
+        dsp::fft::stopWisdom();
+        dsp::volk_profile::stop();
+
+        core::configManager.disableAutoSave();
+        core::configManager.save();
+
+        flog::info("Exiting successfully");
+        flog::setAsync(false);
+        return 0;
+    }
+}
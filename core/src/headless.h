@@ -0,0 +1,8 @@
+#pragma once
+
+// Runs the whole signal path and every module without a window, for unattended stations. The VFOs, sinks and module
+// instances come from the config, and the SDR is controlled through modules like the rigctl server or the optional
+// HTTP interface enabled with --http-port
+namespace headless {
+    int main();
+}
@@ -0,0 +1,247 @@
+#include "metrics.h"
+#include "core.h"
+#include <utils/flog.h>
+#include <utils/net.h>
+#include <utils/proto/http.h>
+#include <signal_path/signal_path.h>
+#include <dsp/profiler.h>
+#include <dsp/buffer/pool.h>
+#include <dsp/thread_role.h>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+
+// Milliseconds after which a silent client is dropped, scrapes are served one at a time
+#define METRICS_HTTP_TIMEOUT    2000
+
+namespace metrics {
+    struct Entry {
+        std::string id;
+        Collector collector;
+        void* ctx;
+    };
+
+    static std::mutex collectorsMtx;
+    static std::vector<Entry> collectors;
+
+    static std::atomic<bool> running = false;
+    static std::shared_ptr<net::Listener> listener;
+    static std::thread worker;
+
+    static std::string escapeLabel(const std::string& value) {
+        std::string out;
+        for (char c : value) {
+            if (c == '\\' || c == '"') { out += '\\'; out += c; }
+            else if (c == '\n') { out += "\\n"; }
+            else { out += c; }
+        }
+        return out;
+    }
+
+    void Writer::declare(const std::string& name, Type type, const std::string& help) {
+        if (declared.find(name) != declared.end()) { return; }
+        order.push_back(name);
+        declared[name] = { type, help, "" };
+    }
+
+    void Writer::add(const std::string& name, double value, const Labels& labels) {
+        auto it = declared.find(name);
+        if (it == declared.end()) {
+            flog::warn("[Metrics] Sample of undeclared metric {0} ignored", name);
+            return;
+        }
+        std::string& samples = it->second.samples;
+        samples += "sdrpp_" + name;
+        if (!labels.empty()) {
+            samples += '{';
+            for (int i = 0; i < labels.size(); i++) {
+                if (i) { samples += ','; }
+                samples += labels[i].first + "=\"" + escapeLabel(labels[i].second) + '"';
+            }
+            samples += '}';
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), " %.15g\n", value);
+        samples += buf;
+    }
+
+    std::string Writer::str() {
+        std::string out;
+        for (const auto& name : order) {
+            const Metric& m = declared[name];
+            if (m.samples.empty()) { continue; }
+            out += "# HELP sdrpp_" + name + " " + m.help + "\n";
+            out += "# TYPE sdrpp_" + name + ((m.type == TYPE_COUNTER) ? " counter\n" : " gauge\n");
+            out += m.samples;
+        }
+        return out;
+    }
+
+    void registerCollector(const std::string& id, Collector collector, void* ctx) {
+        std::lock_guard<std::mutex> lck(collectorsMtx);
+        collectors.push_back({ id, collector, ctx });
+    }
+
+    void unregisterCollector(const std::string& id) {
+        std::lock_guard<std::mutex> lck(collectorsMtx);
+        collectors.erase(std::remove_if(collectors.begin(), collectors.end(), [&id](const Entry& e) { return e.id == id; }), collectors.end());
+    }
+
+    // Source, input buffer and profiled blocks
+    static void collectCore(Writer& w) {
+        core::configManager.acquire();
+        std::string source = core::configManager.conf["source"];
+        core::configManager.release();
+        Labels src = { { "source", source } };
+
+        w.declare("source_samplerate_hz", TYPE_GAUGE, "Samplerate of the selected source");
+        w.declare("frontend_samplerate_hz", TYPE_GAUGE, "Samplerate after the decimation of the front end");
+        w.add("source_samplerate_hz", sigpath::iqFrontEnd.getInputSampleRate(), src);
+        w.add("frontend_samplerate_hz", sigpath::iqFrontEnd.getEffectiveSamplerate(), src);
+
+        SourceStats::Values sv;
+        if (sigpath::sourceManager.getStats(sv)) {
+            w.declare("source_samples_total", TYPE_COUNTER, "Samples delivered by the source since it was started");
+            w.declare("source_overflows_total", TYPE_COUNTER, "Buffers or samples the source dropped because the host didn't keep up");
+            w.declare("source_discontinuities_total", TYPE_COUNTER, "Gaps in the samples reported by the hardware or the transport");
+            w.add("source_samples_total", sv.samples, src);
+            w.add("source_overflows_total", sv.overflows, src);
+            w.add("source_discontinuities_total", sv.discontinuities, src);
+        }
+
+        dsp::buffer::FrameBufferStats bs = sigpath::iqFrontEnd.getInputBufferStats();
+        w.declare("input_buffer_fill_bytes", TYPE_GAUGE, "Bytes queued in the input buffer of the DSP");
+        w.declare("input_buffer_high_water_bytes", TYPE_GAUGE, "Highest fill of the input buffer since it was reset");
+        w.declare("input_buffer_budget_bytes", TYPE_GAUGE, "Bytes the input buffer may hold");
+        w.declare("input_buffer_overflows_total", TYPE_COUNTER, "Blocks dropped because the input buffer was full");
+        w.add("input_buffer_fill_bytes", bs.fill);
+        w.add("input_buffer_high_water_bytes", bs.highWater);
+        w.add("input_buffer_budget_bytes", bs.budget);
+        w.add("input_buffer_overflows_total", bs.overflows);
+
+        // Size classes of the buffer allocator, "system" being the buffers it doesn't pool
+        w.declare("buffer_bytes_in_use", TYPE_GAUGE, "Bytes of the DSP buffers in use, by size class of the allocator");
+        w.declare("buffers_in_use", TYPE_GAUGE, "DSP buffers in use, by size class of the allocator");
+        w.declare("buffers_cached", TYPE_GAUGE, "Freed DSP buffers kept by the allocator for reuse");
+        w.declare("buffers_huge_pages", TYPE_GAUGE, "DSP buffers in use or cached that are backed by huge pages");
+        for (const auto& cs : dsp::buffer::pool::getStats()) {
+            Labels cls = { { "class", cs.size ? std::to_string(cs.size) : "system" } };
+            w.add("buffer_bytes_in_use", cs.bytesInUse, cls);
+            w.add("buffers_in_use", cs.inUse, cls);
+            w.add("buffers_cached", cs.cached, cls);
+            w.add("buffers_huge_pages", cs.hugePages, cls);
+        }
+
+        // Footprint of each module instance or part of the core, by type of block owning the buffers
+        w.declare("memory_bytes", TYPE_GAUGE, "Bytes of DSP buffers held, size class rounding included, by owner and kind");
+        w.declare("memory_buffers", TYPE_GAUGE, "DSP buffers held, by owner and kind");
+        for (const auto& u : dsp::buffer::pool::getUsage()) {
+            Labels l = { { "owner", u.owner }, { "kind", u.kind } };
+            w.add("memory_bytes", u.bytes, l);
+            w.add("memory_buffers", u.buffers, l);
+        }
+
+        // Blocks sharing a name are told apart by their index among them
+        w.declare("block_runs_total", TYPE_COUNTER, "Calls to run() of the block");
+        w.declare("block_run_seconds_total", TYPE_COUNTER, "Time spent in run(), waits included");
+        w.declare("block_read_wait_seconds_total", TYPE_COUNTER, "Time spent waiting for input");
+        w.declare("block_swap_wait_seconds_total", TYPE_COUNTER, "Time spent waiting for room in the outputs");
+        w.declare("block_samples_in_total", TYPE_COUNTER, "Samples read by the block");
+        w.declare("block_samples_out_total", TYPE_COUNTER, "Samples written by the block, summed over its outputs");
+        w.declare("block_swaps_waited_total", TYPE_COUNTER, "Output buffers that were still held by their reader");
+        std::map<std::string, int> seen;
+        for (const auto& v : dsp::profiler::getValues()) {
+            int index = seen[v.name]++;
+            Labels block = { { "block", index ? v.name + "#" + std::to_string(index + 1) : v.name } };
+            w.add("block_runs_total", v.runs, block);
+            w.add("block_run_seconds_total", v.runTime * 1e-9, block);
+            w.add("block_read_wait_seconds_total", v.readWait * 1e-9, block);
+            w.add("block_swap_wait_seconds_total", v.swapWait * 1e-9, block);
+            w.add("block_samples_in_total", v.samplesIn, block);
+            w.add("block_samples_out_total", v.samplesOut, block);
+            w.add("block_swaps_waited_total", v.swapsWaited, block);
+        }
+
+        // Only measured on Linux and Android
+        double cpuTimes[dsp::_THREAD_ROLE_COUNT];
+        dsp::getThreadRoleCPUTimes(cpuTimes);
+        w.declare("thread_role_cpu_seconds_total", TYPE_COUNTER, "CPU time spent by the threads of each role");
+        for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+            w.add("thread_role_cpu_seconds_total", cpuTimes[i], { { "role", dsp::threadRoleName((dsp::ThreadRole)i) } });
+        }
+    }
+
+    static std::string scrape() {
+        Writer w;
+        collectCore(w);
+        std::lock_guard<std::mutex> lck(collectorsMtx);
+        for (const auto& e : collectors) { e.collector(w, e.ctx); }
+        return w.str();
+    }
+
+    static void serve(std::shared_ptr<net::Socket> sock) {
+        net::http::Client http(sock);
+        net::http::RequestHeader req;
+        if (http.recvRequestHeader(req, METRICS_HTTP_TIMEOUT)) {
+            sock->close();
+            return;
+        }
+
+        std::string uri = req.getURI();
+        std::string path = uri.substr(0, uri.find('?'));
+        net::http::Method method = req.getMethod();
+        net::http::StatusCode code = net::http::STATUS_CODE_OK;
+        std::string body;
+        if (method != net::http::METHOD_GET && method != net::http::METHOD_HEAD) {
+            code = net::http::STATUS_CODE_METHOD_NOT_ALLOWED;
+        }
+        else if (path == "/metrics") {
+            body = scrape();
+        }
+        else {
+            code = net::http::STATUS_CODE_NOT_FOUND;
+        }
+
+        net::http::ResponseHeader resp(code);
+        resp.setField("Content-Type", (code == net::http::STATUS_CODE_OK) ? "text/plain; version=0.0.4; charset=utf-8" : "text/plain");
+        resp.setField("Content-Length", std::to_string(body.size()));
+        resp.setField("Connection", "close");
+        http.sendResponseHeader(resp);
+        if (method != net::http::METHOD_HEAD && !body.empty()) { sock->sendstr(body); }
+        sock->close();
+    }
+
+    static void workerThread() {
+        while (running) {
+            // Wake up regularly to notice the shutdown
+            auto sock = listener->accept(NULL, 500);
+            if (sock) { serve(sock); }
+        }
+    }
+
+    bool start(const std::string& host, int port) {
+        if (running) { return true; }
+        try {
+            listener = net::listen(host, port);
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not serve the metrics on {0}:{1}: {2}", host, port, e.what());
+            return false;
+        }
+        dsp::profiler::setEnabled(true);
+        running = true;
+        worker = std::thread(workerThread);
+        flog::info("Serving metrics on http://{0}:{1}/metrics", host, port);
+        return true;
+    }
+
+    void stop() {
+        if (!running) { return; }
+        running = false;
+        if (worker.joinable()) { worker.join(); }
+        listener->stop();
+        listener.reset();
+    }
+}
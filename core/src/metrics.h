@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+// Statistics of the DSP and of the I/O served over HTTP in the Prometheus text format, at /metrics on the port given
+// with --metrics-port. The core reports the source, the input buffer and the profiled blocks, modules register a
+// collector adding their own metrics to every scrape. Metric names are prefixed with sdrpp_ by the writer
+namespace metrics {
+    enum Type {
+        TYPE_COUNTER,
+        TYPE_GAUGE
+    };
+
+    typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+    // Text of a scrape, the samples of each metric being grouped under its HELP and TYPE lines in the order the
+    // metrics were first declared
+    class Writer {
+    public:
+        // Must be called before adding samples of the metric, declaring it again is ignored
+        void declare(const std::string& name, Type type, const std::string& help);
+
+        // Each sample of a metric needs a different set of labels
+        void add(const std::string& name, double value, const Labels& labels = {});
+
+        std::string str();
+
+    private:
+        struct Metric {
+            Type type;
+            std::string help;
+            std::string samples;
+        };
+        std::vector<std::string> order;
+        std::map<std::string, Metric> declared;
+    };
+
+    // Collectors are called from the thread of the HTTP server, one scrape at a time. Unregistering waits for a scrape
+    // in progress, so it must not be done while holding a lock the collector takes
+    typedef void (*Collector)(Writer& w, void* ctx);
+    void registerCollector(const std::string& id, Collector collector, void* ctx);
+    void unregisterCollector(const std::string& id);
+
+    // Serving the metrics enables the DSP profiler, which the per-block metrics come from
+    bool start(const std::string& host, int port);
+    void stop();
+}
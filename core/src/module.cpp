@@ -1,6 +1,15 @@
 #include <module.h>
 #include <filesystem>
 #include <utils/flog.h>
+#include <fstream>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <dsp/buffer/pool.h>
+
+// Maximum number of threads reading modules ahead, and size of their reads
+#define MODULE_PREFETCH_THREADS 4
+#define MODULE_PREFETCH_CHUNK   (1 << 20)
 
 ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
     Module_t mod;
@@ -83,6 +92,32 @@ ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
     return mod;
 }
 
+void ModuleManager::prefetch(const std::vector<std::string>& paths) {
+    waitPrefetch();
+    auto files = std::make_shared<const std::vector<std::string>>(paths);
+    auto next = std::make_shared<std::atomic<size_t>>(0);
+    int threads = std::clamp<int>(std::thread::hardware_concurrency(), 1, MODULE_PREFETCH_THREADS);
+    for (int i = 0; i < threads; i++) {
+        prefetchThreads.emplace_back([files, next]() {
+            std::vector<char> buf(MODULE_PREFETCH_CHUNK);
+            while (true) {
+                // Take the files in the order they're loaded so that the loader doesn't overtake the prefetch
+                size_t id = (*next)++;
+                if (id >= files->size()) { return; }
+                std::ifstream file((*files)[id], std::ios::binary);
+                while (file.read(buf.data(), buf.size())) {}
+            }
+        });
+    }
+}
+
+void ModuleManager::waitPrefetch() {
+    for (auto& thread : prefetchThreads) {
+        if (thread.joinable()) { thread.join(); }
+    }
+    prefetchThreads.clear();
+}
+
 int ModuleManager::createInstance(std::string name, std::string module) {
     if (modules.find(module) == modules.end()) {
         flog::error("Module '{0}' doesn't exist", module);
@@ -99,7 +134,11 @@ int ModuleManager::createInstance(std::string name, std::string module) {
     }
     Instance_t inst;
     inst.module = modules[module];
-    inst.instance = inst.module.createInstance(name);
+    {
+        // Account what the instance allocates to it
+        dsp::buffer::pool::Scope scope(name);
+        inst.instance = inst.module.createInstance(name);
+    }
     instances[name] = inst;
     onInstanceCreated.emit(name);
     return 0;
@@ -128,6 +167,7 @@ int ModuleManager::enableInstance(std::string name) {
         flog::error("Cannot enable '{0}', instance doesn't exist", name);
         return -1;
     }
+    dsp::buffer::pool::Scope scope(name);
     instances[name].instance->enable();
     return 0;
 }
@@ -137,6 +177,7 @@ int ModuleManager::disableInstance(std::string name) {
         flog::error("Cannot disable '{0}', instance doesn't exist", name);
         return -1;
     }
+    dsp::buffer::pool::Scope scope(name);
     instances[name].instance->disable();
     return 0;
 }
@@ -154,6 +195,7 @@ void ModuleManager::postInit(std::string name) {
         flog::error("Cannot post-init '{0}', instance doesn't exist", name);
         return;
     }
+    dsp::buffer::pool::Scope scope(name);
     instances[name].instance->postInit();
 }
 
@@ -181,6 +223,7 @@ int ModuleManager::countModuleInstances(std::string module) {
 void ModuleManager::doPostInitAll() {
     for (auto& [name, inst] : instances) {
         flog::info("Running post-init for {0}", name);
+        dsp::buffer::pool::Scope scope(name);
         inst.instance->postInit();
     }
 }
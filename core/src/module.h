@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include <thread>
 #include <json.hpp>
 #include <utils/event.h>
 
@@ -79,6 +81,12 @@ public:
 
     ModuleManager::Module_t loadModule(std::string path);
 
+    // Read the files of modules about to be loaded from a few background threads. Loading is serialized by the system
+    // loader, it then mostly finds the files in the page cache instead of waiting on the disk. waitPrefetch() must be
+    // called once they are loaded
+    void prefetch(const std::vector<std::string>& paths);
+    void waitPrefetch();
+
     int createInstance(std::string name, std::string module);
     int deleteInstance(std::string name);
     int deleteInstance(ModuleManager::Instance* instance);
@@ -99,6 +107,9 @@ public:
 
     std::map<std::string, ModuleManager::Module_t> modules;
     std::map<std::string, ModuleManager::Instance_t> instances;
+
+private:
+    std::vector<std::thread> prefetchThreads;
 };
 
 #define SDRPP_MOD_INFO MOD_EXPORT const ModuleManager::ModuleInfo_t _INFO_
\ No newline at end of file
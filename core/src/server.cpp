@@ -8,73 +8,194 @@
 #include <signal_path/signal_path.h>
 #include <gui/smgui.h>
 #include <utils/optionlist.h>
+#include <utils/startup_timer.h>
+#include <metrics.h>
+#include <session_snapshot.h>
 #include "dsp/compression/sample_stream_compressor.h"
 #include "dsp/sink/handler_sink.h"
+#include "dsp/channel/rx_vfo.h"
+#include "dsp/fft/spectrum.h"
+#include "dsp/profiler.h"
 #include <zstd.h>
+#include <deque>
+#include <map>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// Maximum number of baseband packets waiting to be sent to a client before new ones are dropped for it
+#define SERVER_CLIENT_QUEUE_SIZE    32
+
+// Range of the zstd levels used for the baseband and number of packets over which the level is adapted
+#define SERVER_ZSTD_MIN_LEVEL       1
+#define SERVER_ZSTD_MAX_LEVEL       9
+#define SERVER_ZSTD_ADAPT_PACKETS   16
+
+// Maximum number of zstd worker threads per client
+#define SERVER_ZSTD_MAX_THREADS     4
+
+// Time the state of a client whose connection dropped is kept for it to resume its session
+#define SERVER_SESSION_TIMEOUT_MS   30000
 
 namespace server {
+    class PacketData;
+    typedef std::shared_ptr<PacketData> Packet;
+
+    // Packet shared by the send queues of the clients. The buffer is left uninitialized so that samples are encoded
+    // straight into it instead of being copied from a scratch buffer
+    class PacketData {
+    public:
+        PacketData(int size) {
+            buf = new uint8_t[size];
+            len = size;
+        }
+
+        ~PacketData() { delete[] buf; }
+
+        uint8_t* data() { return buf; }
+        int size() { return len; }
+        void shrink(int size) { len = std::min<int>(len, size); }
+
+        // Compressed copy of the packet at a given zstd level. The first sender asking for a level compresses it with
+        // its own context, the other clients at that level then send the same copy
+        template <class Func>
+        Packet compressed(int level, Func compress) {
+            std::shared_ptr<CompressedCopy> copy;
+            {
+                std::lock_guard<std::mutex> lck(copiesMtx);
+                std::shared_ptr<CompressedCopy>& c = copies[level];
+                if (!c) { c = std::make_shared<CompressedCopy>(); }
+                copy = c;
+            }
+            std::call_once(copy->once, [&]() { copy->pkt = compress(); });
+            return copy->pkt;
+        }
+
+    private:
+        struct CompressedCopy {
+            std::once_flag once;
+            Packet pkt;
+        };
+
+        uint8_t* buf;
+        int len;
+
+        std::mutex copiesMtx;
+        std::map<int, std::shared_ptr<CompressedCopy>> copies;
+    };
+
+    // Each client has its own sample format, compression and send queue. Baseband packets are dropped for a client whose
+    // queue is full so that a slow client only loses samples itself, replies to commands are always queued.
+    struct Client {
+        net::Conn conn;
+        dsp::compression::PCMType pcmType = dsp::compression::PCM_TYPE_I16;
+        std::atomic<bool> compression = false;
+        bool running = false;
+        uint8_t* rbuf = NULL;
+        uint8_t* sbuf = NULL;
+
+        // Compact UI protocol, what was last sent to the client and the strings of the actions it sent
+        SmGui::DrawListCodec uiCodec;
+        SmGui::DrawListCodec actionCodec;
+
+        std::mutex queueMtx;
+        std::condition_variable queueCnd;
+        std::deque<Packet> queue;
+        int queuedBaseband = 0;
+        uint64_t dropped = 0;
+        bool stopSender = false;
+        std::thread sender;
+        std::atomic<bool> closed = false;
+
+        // Token the client resumes its session with after its connection dropped, everything but the connection and
+        // the send queue being kept meanwhile. A client is established once it sent a command other than a resume
+        uint64_t sessionToken = 0;
+        bool established = false;
+        std::chrono::steady_clock::time_point detachedAt;
+
+        // Channel extracted from the baseband for this client only, sent as uncompressed VFO packets instead of the full
+        // baseband. It is run from the baseband handler so it has no stream of its own
+        dsp::channel::RxVFO* vfo = NULL;
+        dsp::complex_t* vfoBuf = NULL;
+        double vfoSamplerate = 0.0;
+
+        // Spectra of the full baseband computed for this client, sent as quantized FFT packets
+        dsp::fft::Spectrum* spectrum = NULL;
+        float* spectrumBuf = NULL;
+
+        // The baseband is compressed by the sender of the client rather than by the DSP, at a level following how the time
+        // spent compressing compares to the time spent sending: a slow link gets a higher level, a busy CPU a lower one.
+        // Clients sharing a sample type and a level share the compressed packet too, see PacketData::compressed()
+        ZSTD_CCtx* cctx = NULL;
+        int level = SERVER_ZSTD_MIN_LEVEL;
+        int adaptCount = 0;
+        double compressTime = 0.0;
+        double sendTime = 0.0;
+
+        // Optional UDP transport of the sample packets, used once the client has sent a hello on it. Commands, the UI
+        // and the spectra stay on the TCP connection
+        std::mutex udpMtx;
+        net::Conn udp;
+        uint8_t udpRbuf[sizeof(UDPHeader)];
+        uint32_t udpToken = 0;
+        int fecGroup = 0;
+        std::atomic<bool> udpReady = false;
+        uint32_t udpPacket = 0;
+        std::vector<uint8_t> parity;
+    };
+
+    bool isSamplePacket(uint32_t type) {
+        return type == PACKET_TYPE_BASEBAND || type == PACKET_TYPE_BASEBAND_COMPRESSED || type == PACKET_TYPE_VFO || type == PACKET_TYPE_FFT;
+    }
+
     dsp::stream<dsp::complex_t> dummyInput;
-    dsp::compression::SampleStreamCompressor comp;
-    dsp::sink::Handler<uint8_t> hnd;
-    net::Conn client;
-    uint8_t* rbuf = NULL;
-    uint8_t* sbuf = NULL;
-    uint8_t* bbuf = NULL;
-
-    PacketHeader* r_pkt_hdr = NULL;
-    uint8_t* r_pkt_data = NULL;
-    CommandHeader* r_cmd_hdr = NULL;
-    uint8_t* r_cmd_data = NULL;
-
-    PacketHeader* s_pkt_hdr = NULL;
-    uint8_t* s_pkt_data = NULL;
-    CommandHeader* s_cmd_hdr = NULL;
-    uint8_t* s_cmd_data = NULL;
-
-    PacketHeader* bb_pkt_hdr = NULL;
-    uint8_t* bb_pkt_data = NULL;
+    dsp::sink::Handler<dsp::complex_t> hnd;
+    std::vector<Client*> clients;
+    std::mutex clientsMtx;
 
-    SmGui::DrawListElem dummyElem;
+    // Sessions of the clients whose connection dropped, waiting to be resumed. Guarded by clientsMtx
+    std::vector<Client*> detached;
+    std::mutex cmdMtx;
 
-    ZSTD_CCtx* cctx;
+    SmGui::DrawListElem dummyElem;
 
     net::Listener listener;
 
     OptionList<std::string, std::string> sourceList;
     int sourceId = 0;
     bool running = false;
-    bool compression = false;
     double sampleRate = 1000000.0;
+    int maxClients = 1;
+
+    // Totals over all the clients that were ever connected, for the metrics
+    std::atomic<uint64_t> bytesSent = 0;
+    std::atomic<uint64_t> packetsDropped = 0;
+
+    void collectMetrics(metrics::Writer& w, void* ctx) {
+        int count, detachedCount;
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            count = clients.size();
+            detachedCount = detached.size();
+        }
+        w.declare("server_clients", metrics::TYPE_GAUGE, "Clients connected to the server");
+        w.declare("server_detached_sessions", metrics::TYPE_GAUGE, "Sessions of disconnected clients waiting to be resumed");
+        w.declare("server_sent_bytes_total", metrics::TYPE_COUNTER, "Bytes of samples, spectra and replies sent to the clients");
+        w.declare("server_dropped_packets_total", metrics::TYPE_COUNTER, "Sample packets dropped for clients that fell behind");
+        w.add("server_clients", count);
+        w.add("server_detached_sessions", detachedCount);
+        w.add("server_sent_bytes_total", bytesSent);
+        w.add("server_dropped_packets_total", packetsDropped);
+    }
 
     int main() {
         flog::info("=====| SERVER MODE |=====");
 
         // Init DSP
-        comp.init(&dummyInput, dsp::compression::PCM_TYPE_I8);
-        hnd.init(&comp.out, _testServerHandler, NULL);
-        rbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
-        sbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
-        bbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
-        comp.start();
+        hnd.init(&dummyInput, _basebandHandler, NULL);
         hnd.start();
 
-        // Initialize headers
-        r_pkt_hdr = (PacketHeader*)rbuf;
-        r_pkt_data = &rbuf[sizeof(PacketHeader)];
-        r_cmd_hdr = (CommandHeader*)r_pkt_data;
-        r_cmd_data = &rbuf[sizeof(PacketHeader) + sizeof(CommandHeader)];
-
-        s_pkt_hdr = (PacketHeader*)sbuf;
-        s_pkt_data = &sbuf[sizeof(PacketHeader)];
-        s_cmd_hdr = (CommandHeader*)s_pkt_data;
-        s_cmd_data = &sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)];
-
-        bb_pkt_hdr = (PacketHeader*)bbuf;
-        bb_pkt_data = &bbuf[sizeof(PacketHeader)];
-
-        // Initialize compressor
-        cctx = ZSTD_createCCtx();
-
         // Load config
         core::configManager.acquire();
         std::string modulesDir = core::configManager.conf["modulesDirectory"];
@@ -90,6 +211,7 @@ namespace server {
         flog::info("Loading modules");
         // Load modules and check type to only load sources ( TODO: Have a proper type parameter int the info )
         // TODO LATER: Add whitelist/blacklist stuff
+        std::vector<std::string> modulePaths;
         if (std::filesystem::is_directory(modulesDir)) {
             for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
                 std::string path = file.path().generic_string();
@@ -99,9 +221,7 @@ namespace server {
                 }
                 if (!file.is_regular_file()) { continue; }
                 if (fn.find("source") == std::string::npos) { continue; }
-
-                flog::info("Loading {0}", path);
-                core::moduleManager.loadModule(path);
+                modulePaths.push_back(path);
             }
         }
         else {
@@ -119,10 +239,17 @@ namespace server {
             }
             if (!std::filesystem::is_regular_file(file)) { continue; }
             if (fn.find("source") == std::string::npos) { continue; }
+            modulePaths.push_back(path);
+        }
 
+        // Load the modules, their files being read ahead in the background
+        core::moduleManager.prefetch(modulePaths);
+        for (auto const& path : modulePaths) {
             flog::info("Loading {0}", path);
+            startup_timer::begin("Loading " + std::filesystem::path(path).filename().string());
             core::moduleManager.loadModule(path);
         }
+        core::moduleManager.waitPrefetch();
 
         // Create module instances
         for (auto const& [name, _module] : modList) {
@@ -130,12 +257,15 @@ namespace server {
             bool enabled = _module["enabled"];
             if (core::moduleManager.modules.find(mod) == core::moduleManager.modules.end()) { continue; }
             flog::info("Initializing {0} ({1})", name, mod);
+            startup_timer::begin("Initializing " + name);
             core::moduleManager.createInstance(name, mod);
             if (!enabled) { core::moduleManager.disableInstance(name); }
         }
 
         // Do post-init
+        startup_timer::begin("Module post-init");
         core::moduleManager.doPostInitAll();
+        session_snapshot::restoreDone();
 
         // Generate source list
         auto list = sigpath::sourceManager.getSourceNames();
@@ -151,19 +281,30 @@ namespace server {
         // TODO: Use command line option
         std::string host = (std::string)core::args["addr"];
         int port = (int)core::args["port"];
+        maxClients = std::max<int>((int)core::args["clients"], 1);
         listener = net::listen(host, port);
         listener->acceptAsync(_clientHandler, NULL);
+        metrics::registerCollector("server", collectMetrics, NULL);
 
+        startup_timer::finish();
         flog::info("Ready, listening on {0}:{1}", host, port);
-        while(1) { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }
+        while(1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            pruneClients();
+        }
 
         return 0;
     }
 
     void _clientHandler(net::Conn conn, void* ctx) {
-        // Reject if someone else is already connected
-        if (client && client->isOpen()) {
-            flog::info("REJECTED Connection from {0}:{1}, another client is already connected.", "TODO", "TODO");
+        // Reject if the maximum number of clients are already connected
+        int clientCount;
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            clientCount = clients.size();
+        }
+        if (clientCount >= maxClients) {
+            flog::info("REJECTED Connection from {0}:{1}, too many clients are already connected.", "TODO", "TODO");
             
             // Issue a disconnect command to the client
             uint8_t buf[sizeof(PacketHeader) + sizeof(CommandHeader)];
@@ -185,70 +326,523 @@ namespace server {
         }
 
         flog::info("Connection from {0}:{1}", "TODO", "TODO");
-        client = std::move(conn);
-        client->readAsync(sizeof(PacketHeader), rbuf, _packetHandler, NULL);
+        Client* client = new Client;
+        client->conn = std::move(conn);
+        client->rbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
+        client->sbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
+        client->sender = std::thread(_senderWorker, client);
+        std::random_device rd;
+        while (!client->sessionToken) { client->sessionToken = ((uint64_t)rd() << 32) | rd(); }
 
-        // Perform settings reset
-        sigpath::sourceManager.stop();
-        comp.setPCMType(dsp::compression::PCM_TYPE_I16);
-        compression = false;
-
-        sendSampleRate(sampleRate);
+        // The first client starts from a stopped source, the others join the current session. A session waiting to
+        // be resumed keeps the source as it was
+        {
+            std::lock_guard<std::mutex> lck(cmdMtx);
+            std::lock_guard<std::mutex> lck2(clientsMtx);
+            if (clients.empty() && detached.empty()) {
+                sigpath::sourceManager.stop();
+                running = false;
+            }
+            clients.push_back(client);
+        }
 
-        // TODO: Wait otherwise someone else could connect
+        sendSampleRate(client, sampleRate);
+        sendSession(client);
+        client->conn->readAsync(sizeof(PacketHeader), client->rbuf, _packetHandler, client);
 
         listener->acceptAsync(_clientHandler, NULL);
     }
 
     void _packetHandler(int count, uint8_t* buf, void* ctx) {
+        Client* client = (Client*)ctx;
         PacketHeader* hdr = (PacketHeader*)buf;
+        if (count <= 0 || hdr->size < sizeof(PacketHeader) || hdr->size > SERVER_MAX_PACKET_SIZE) {
+            client->closed = true;
+            return;
+        }
 
-        // Read the rest of the data (TODO: CHECK SIZE OR SHIT WILL BE FUCKED + ADD TIMEOUT)
+        // Read the rest of the data (TODO: ADD TIMEOUT)
         int len = 0;
         int read = 0;
         int goal = hdr->size - sizeof(PacketHeader);
         while (len < goal) {
-            read = client->read(goal - len, &buf[sizeof(PacketHeader) + len]);
-            if (read < 0) { return; };
+            read = client->conn->read(goal - len, &buf[sizeof(PacketHeader) + len]);
+            if (read < 0) {
+                client->closed = true;
+                return;
+            }
             len += read;
         }
 
-        // Parse and process
+        // Parse and process, the source and the UI are shared by all clients. A resumed session carries on reading from
+        // the connection in place of the new client
         if (hdr->type == PACKET_TYPE_COMMAND && hdr->size >= sizeof(PacketHeader) + sizeof(CommandHeader)) {
             CommandHeader* chdr = (CommandHeader*)&buf[sizeof(PacketHeader)];
-            commandHandler((Command)chdr->cmd, &buf[sizeof(PacketHeader) + sizeof(CommandHeader)], hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
+            uint8_t* data = &buf[sizeof(PacketHeader) + sizeof(CommandHeader)];
+            int len = hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader);
+            std::lock_guard<std::mutex> lck(cmdMtx);
+            if (chdr->cmd == COMMAND_RESUME && len == sizeof(uint64_t) && !client->established) {
+                client = resumeSession(client, *(uint64_t*)data);
+            }
+            else {
+                if (!client->established) { establish(client); }
+                commandHandler(client, (Command)chdr->cmd, data, len);
+            }
         }
         else {
-            sendError(ERROR_INVALID_PACKET);
+            sendError(client, ERROR_INVALID_PACKET);
         }
 
         // Start another async read
-        client->readAsync(sizeof(PacketHeader), rbuf, _packetHandler, NULL);
+        client->conn->readAsync(sizeof(PacketHeader), client->rbuf, _packetHandler, client);
+    }
+
+    Packet encodeSamples(PacketType type, dsp::complex_t* data, int count, dsp::compression::PCMType pcmType) {
+        // No sample type takes more room than float32
+        Packet pkt = std::make_shared<PacketData>(sizeof(PacketHeader) + 8 + (count * sizeof(dsp::complex_t)));
+        int size = dsp::compression::SampleStreamCompressor::process(count, pcmType, data, &pkt->data()[sizeof(PacketHeader)]);
+        pkt->shrink(sizeof(PacketHeader) + size);
+        PacketHeader* hdr = (PacketHeader*)pkt->data();
+        hdr->type = type;
+        hdr->size = pkt->size();
+        return pkt;
     }
 
-    void _testServerHandler(uint8_t* data, int count, void* ctx) {
-        // Compress data if needed and fill out header fields
-        if (compression) {
-            bb_pkt_hdr->type = PACKET_TYPE_BASEBAND_COMPRESSED;
-            bb_pkt_hdr->size = sizeof(PacketHeader) + (uint32_t)ZSTD_compressCCtx(cctx, &bbuf[sizeof(PacketHeader)], SERVER_MAX_PACKET_SIZE-sizeof(PacketHeader), data, count, 1);
+    void initCompressor(Client* client) {
+        client->cctx = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(client->cctx, ZSTD_c_compressionLevel, client->level);
+
+        // Fails without effect if zstd was built without multithreading
+        int threads = std::clamp<int>(std::thread::hardware_concurrency() / 2, 1, SERVER_ZSTD_MAX_THREADS);
+        if (threads > 1) { ZSTD_CCtx_setParameter(client->cctx, ZSTD_c_nbWorkers, threads); }
+    }
+
+    // Returns NULL if the compression failed
+    Packet compressBaseband(ZSTD_CCtx* cctx, Packet pkt) {
+        int size = pkt->size() - sizeof(PacketHeader);
+        Packet cpkt = std::make_shared<PacketData>(sizeof(PacketHeader) + ZSTD_compressBound(size));
+        size_t csize = ZSTD_compress2(cctx, &cpkt->data()[sizeof(PacketHeader)], cpkt->size() - sizeof(PacketHeader), &pkt->data()[sizeof(PacketHeader)], size);
+        if (ZSTD_isError(csize)) {
+            flog::error("Could not compress baseband: {0}", ZSTD_getErrorName(csize));
+            return NULL;
         }
-        else {
-            bb_pkt_hdr->type = PACKET_TYPE_BASEBAND;
-            bb_pkt_hdr->size = sizeof(PacketHeader) + count;
-            memcpy(&bbuf[sizeof(PacketHeader)], data, count);
+        cpkt->shrink(sizeof(PacketHeader) + csize);
+        PacketHeader* hdr = (PacketHeader*)cpkt->data();
+        hdr->type = PACKET_TYPE_BASEBAND_COMPRESSED;
+        hdr->size = cpkt->size();
+        return cpkt;
+    }
+
+    void adaptCompression(Client* client, double compressTime, double sendTime) {
+        client->compressTime += compressTime;
+        client->sendTime += sendTime;
+        if (++client->adaptCount < SERVER_ZSTD_ADAPT_PACKETS) { return; }
+
+        // Compress more while the link is the bottleneck, less when the compression is
+        int level = client->level;
+        if (client->sendTime > 2.0 * client->compressTime) {
+            level = std::min<int>(level + 1, SERVER_ZSTD_MAX_LEVEL);
+        }
+        else if (client->compressTime > client->sendTime) {
+            level = std::max<int>(level - 1, SERVER_ZSTD_MIN_LEVEL);
+        }
+        if (level != client->level) {
+            client->level = level;
+            ZSTD_CCtx_setParameter(client->cctx, ZSTD_c_compressionLevel, level);
+        }
+        client->adaptCount = 0;
+        client->compressTime = 0.0;
+        client->sendTime = 0.0;
+    }
+
+    Packet encodeFFT(const float* data, int size) {
+        Packet pkt = std::make_shared<PacketData>(sizeof(PacketHeader) + sizeof(FFTHeader) + size);
+        PacketHeader* hdr = (PacketHeader*)pkt->data();
+        FFTHeader* fhdr = (FFTHeader*)&pkt->data()[sizeof(PacketHeader)];
+        uint8_t* out = &pkt->data()[sizeof(PacketHeader) + sizeof(FFTHeader)];
+        hdr->type = PACKET_TYPE_FFT;
+        hdr->size = pkt->size();
+
+        // Quantize the line over its own range
+        float min = INFINITY;
+        float max = -INFINITY;
+        for (int i = 0; i < size; i++) {
+            min = std::min<float>(min, data[i]);
+            max = std::max<float>(max, data[i]);
+        }
+        min = std::max<float>(min, SERVER_FFT_FLOOR);
+        max = std::max<float>(max, min);
+        float step = (max - min) / 255.0f;
+        float scale = (step > 0.0f) ? (1.0f / step) : 0.0f;
+        for (int i = 0; i < size; i++) {
+            out[i] = (uint8_t)((std::clamp<float>(data[i], min, max) - min) * scale + 0.5f);
+        }
+        fhdr->min = min;
+        fhdr->step = step;
+        return pkt;
+    }
+
+    void pushSamplePacket(Client* client, Packet pkt) {
+        // Queue it unless the client is already too far behind
+        {
+            std::lock_guard<std::mutex> lck(client->queueMtx);
+            if (client->queuedBaseband >= SERVER_CLIENT_QUEUE_SIZE) {
+                client->dropped++;
+                packetsDropped++;
+                return;
+            }
+            client->queue.push_back(pkt);
+            client->queuedBaseband++;
+        }
+        client->queueCnd.notify_one();
+    }
+
+    void _basebandHandler(dsp::complex_t* data, int count, void* ctx) {
+        // Encode the samples once for each format used by the clients receiving the full baseband
+        Packet encoded[dsp::compression::_PCM_TYPE_COUNT];
+        std::lock_guard<std::mutex> lck(clientsMtx);
+        for (Client* client : clients) {
+            if (client->closed) { continue; }
+
+            // Spectra are sent just before the samples they were computed from
+            if (client->spectrum) {
+                client->spectrum->feed(data, count);
+                if (client->spectrum->read(client->spectrumBuf)) {
+                    pushSamplePacket(client, encodeFFT(client->spectrumBuf, client->spectrum->getSize()));
+                }
+            }
+
+            if (client->vfo) {
+                int outCount = client->vfo->process(count, data, client->vfoBuf);
+                if (!outCount) { continue; }
+                pushSamplePacket(client, encodeSamples(PACKET_TYPE_VFO, client->vfoBuf, outCount, client->pcmType));
+            }
+            else {
+                Packet& shared = encoded[client->pcmType];
+                if (!shared) { shared = encodeSamples(PACKET_TYPE_BASEBAND, data, count, client->pcmType); }
+                pushSamplePacket(client, shared);
+            }
         }
+    }
+
+    void _senderWorker(Client* client) {
+        while (true) {
+            // Wait for a packet
+            Packet pkt;
+            {
+                std::unique_lock<std::mutex> lck(client->queueMtx);
+                client->queueCnd.wait(lck, [client]() { return !client->queue.empty() || client->stopSender; });
+                if (client->stopSender) { return; }
+                pkt = client->queue.front();
+                client->queue.pop_front();
+                PacketHeader* hdr = (PacketHeader*)pkt->data();
+                if (isSamplePacket(hdr->type)) { client->queuedBaseband--; }
+            }
+
+            // Send other packets as they are
+            PacketHeader* hdr = (PacketHeader*)pkt->data();
+            if (hdr->type != PACKET_TYPE_BASEBAND || !client->compression) {
+                net::ConnBuffer buf = { pkt->data(), pkt->size() };
+                bool ok = (isSamplePacket(hdr->type) && hdr->type != PACKET_TYPE_FFT) ? sendSamples(client, &buf, 1) : client->conn->write(pkt->size(), pkt->data());
+                if (!ok) {
+                    client->closed = true;
+                    return;
+                }
+                bytesSent += pkt->size();
+                continue;
+            }
+
+            // Compress the baseband unless a client at the same level already did
+            auto start = std::chrono::high_resolution_clock::now();
+            if (!client->cctx) { initCompressor(client); }
+            Packet cpkt = pkt->compressed(client->level, [&]() { return compressBaseband(client->cctx, pkt); });
+            if (!cpkt) { continue; }
+            auto compressed = std::chrono::high_resolution_clock::now();
+
+            // Send it and adapt the level to what took the longest
+            net::ConnBuffer buf = { cpkt->data(), cpkt->size() };
+            if (!sendSamples(client, &buf, 1)) {
+                client->closed = true;
+                return;
+            }
+            bytesSent += cpkt->size();
+            auto sent = std::chrono::high_resolution_clock::now();
+            adaptCompression(client, std::chrono::duration<double>(compressed - start).count(), std::chrono::duration<double>(sent - compressed).count());
+        }
+    }
+
+    bool sendSamples(Client* client, const net::ConnBuffer* bufs, int bufCount) {
+        // Fall back to TCP if the UDP transport fails
+        if (client->udpReady) {
+            std::lock_guard<std::mutex> lck(client->udpMtx);
+            if (client->udp && sendUDP(client, bufs, bufCount)) { return true; }
+            flog::warn("UDP transport failed, going back to TCP");
+            client->udpReady = false;
 
-        // Write to network
-        if (client && client->isOpen()) { client->write(bb_pkt_hdr->size, bbuf); }
+            // The failed packet may have stopped partway through a FEC group
+            std::fill(client->parity.begin(), client->parity.end(), 0);
+        }
+        return client->conn->writev(bufs, bufCount);
+    }
+
+    bool sendUDP(Client* client, const net::ConnBuffer* bufs, int bufCount) {
+        int size = 0;
+        for (int i = 0; i < bufCount; i++) { size += bufs[i].count; }
+        int fragments = (size + SERVER_UDP_MAX_PAYLOAD - 1) / SERVER_UDP_MAX_PAYLOAD;
+        int group = client->fecGroup;
+
+        UDPHeader hdr;
+        hdr.token = client->udpToken;
+        hdr.packet = client->udpPacket++;
+        hdr.size = size;
+        hdr.fecGroup = group;
+
+        int buf = 0;
+        int offset = 0;
+        for (int i = 0; i < fragments; i++) {
+            // Gather the fragment from the buffers and add it to the parity of its group
+            net::ConnBuffer vecs[8];
+            vecs[0] = { (const uint8_t*)&hdr, sizeof(UDPHeader) };
+            int vecCount = 1;
+            int fragLen = std::min<int>(SERVER_UDP_MAX_PAYLOAD, size - (i * SERVER_UDP_MAX_PAYLOAD));
+            int left = fragLen;
+            while (left) {
+                int n = std::min<int>(left, bufs[buf].count - offset);
+                if (n) {
+                    if (vecCount == 8) { return false; }
+                    vecs[vecCount++] = { &bufs[buf].buf[offset], n };
+                    if (group) {
+                        uint8_t* par = &client->parity[fragLen - left];
+                        for (int j = 0; j < n; j++) { par[j] ^= bufs[buf].buf[offset + j]; }
+                    }
+                }
+                offset += n;
+                left -= n;
+                if (offset == bufs[buf].count) {
+                    buf++;
+                    offset = 0;
+                }
+            }
+            hdr.index = i;
+            hdr.flags = 0;
+            if (!client->udp->writev(vecs, vecCount)) { return false; }
+
+            // Send the parity of the group once it's complete
+            if (group && (((i + 1) % group) == 0 || i == fragments - 1)) {
+                hdr.index = i / group;
+                hdr.flags = UDP_FLAG_PARITY;
+                vecs[1] = { client->parity.data(), SERVER_UDP_MAX_PAYLOAD };
+                if (!client->udp->writev(vecs, 2)) { return false; }
+                memset(client->parity.data(), 0, SERVER_UDP_MAX_PAYLOAD);
+            }
+        }
+        return true;
+    }
+
+    void _udpHandler(int count, uint8_t* buf, void* ctx) {
+        Client* client = (Client*)ctx;
+        UDPHeader* hdr = (UDPHeader*)buf;
+        if (count <= 0) { return; }
+        if (count < sizeof(UDPHeader)) {
+            // Too short to be a hello, and what's left in the buffer is from the previous one
+            client->udp->readAsync(sizeof(UDPHeader), client->udpRbuf, _udpHandler, client, false);
+            return;
+        }
+
+        // Only the hellos carrying the token given to the client over TCP tell where to send, anyone can send a datagram
+        if (hdr->token == client->udpToken && (hdr->flags & UDP_FLAG_HELLO)) {
+            client->udp->setRemoteAddr(client->udp->getLastSender());
+            if (!client->udpReady) {
+                flog::info("UDP transport established");
+                client->udpReady = true;
+            }
+        }
+        client->udp->readAsync(sizeof(UDPHeader), client->udpRbuf, _udpHandler, client, false);
+    }
+
+    void setUDP(Client* client, bool enabled, int fecGroup) {
+        std::lock_guard<std::mutex> lck(client->udpMtx);
+        client->udpReady = false;
+        if (client->udp) {
+            client->udp->close();
+            client->udp.reset();
+        }
+        if (!enabled) { return; }
+
+        // The remote address is set by the hellos
+        client->udp = net::openUDP("0.0.0.0", 0, "0.0.0.0", 0, true);
+        client->udpToken = std::random_device()();
+        client->fecGroup = fecGroup;
+        client->parity.assign(SERVER_UDP_MAX_PAYLOAD, 0);
+        client->udp->readAsync(sizeof(UDPHeader), client->udpRbuf, _udpHandler, client, false);
+    }
+
+    void stopSenderWorker(Client* client) {
+        {
+            std::lock_guard<std::mutex> lck(client->queueMtx);
+            client->stopSender = true;
+        }
+        client->queueCnd.notify_all();
+        if (client->sender.joinable()) { client->sender.join(); }
+    }
+
+    void sendSession(Client* client) {
+        uint8_t buf[sizeof(PacketHeader) + sizeof(CommandHeader) + sizeof(uint64_t)];
+        PacketHeader* hdr = (PacketHeader*)buf;
+        hdr->type = PACKET_TYPE_COMMAND;
+        hdr->size = sizeof(buf);
+        ((CommandHeader*)&buf[sizeof(PacketHeader)])->cmd = COMMAND_SET_SESSION;
+        *(uint64_t*)&buf[sizeof(PacketHeader) + sizeof(CommandHeader)] = client->sessionToken;
+        queuePacket(client, buf, sizeof(buf));
+    }
+
+    Client* resumeSession(Client* client, uint64_t token) {
+        // Take the session and the new client out of the lists, unless pruned meanwhile, so that pruneClients can't
+        // see either of them while the connection changes hands
+        Client* session = NULL;
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            auto it = std::find_if(detached.begin(), detached.end(), [=](Client* c) { return c->sessionToken == token; });
+            auto self = std::find(clients.begin(), clients.end(), client);
+            if (it != detached.end() && self != clients.end()) {
+                session = *it;
+                detached.erase(it);
+                clients.erase(self);
+            }
+        }
+        if (!session) {
+            flog::warn("Client asked to resume an unknown or expired session");
+            client->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)] = false;
+            sendCommandAck(client, COMMAND_RESUME, 1);
+            return client;
+        }
+
+        // The session takes the connection over, what was queued for the new client is dropped along with it
+        stopSenderWorker(client);
+        session->conn = std::move(client->conn);
+        session->closed = false;
+        session->established = true;
+        session->stopSender = false;
+        session->sender = std::thread(_senderWorker, session);
+        freeClient(client);
+
+        // Only publish the session once it is open again
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            clients.push_back(session);
+        }
+
+        session->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)] = true;
+        sendCommandAck(session, COMMAND_RESUME, 1);
+        sendSampleRate(session, session->vfo ? session->vfoSamplerate : sampleRate);
+        flog::info("Client resumed its session");
+        return session;
+    }
+
+    void establish(Client* client) {
+        // Sessions waiting to be resumed make room for a new client, the oldest first
+        client->established = true;
+        std::vector<Client*> evicted;
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            while (!detached.empty() && clients.size() + detached.size() > maxClients) {
+                evicted.push_back(detached.front());
+                detached.erase(detached.begin());
+            }
+        }
+        if (evicted.empty()) { return; }
+        for (Client* session : evicted) { freeClient(session); }
+        flog::info("Dropped {0} sessions waiting to be resumed to make room for a new client", evicted.size());
+        updateRunning();
+    }
+
+    void freeClient(Client* client) {
+        if (client->vfo) {
+            delete client->vfo;
+            dsp::buffer::free(client->vfoBuf);
+        }
+        if (client->spectrum) {
+            delete client->spectrum;
+            dsp::buffer::free(client->spectrumBuf);
+        }
+        if (client->cctx) { ZSTD_freeCCtx(client->cctx); }
+        if (client->udp) { client->udp->close(); }
+        delete[] client->rbuf;
+        delete[] client->sbuf;
+        delete client;
+    }
+
+    void pruneClients() {
+        std::vector<Client*> closed;
+        std::vector<Client*> expired;
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            for (Client* client : clients) {
+                if (client->closed || !client->conn->isOpen()) { closed.push_back(client); }
+            }
+            for (Client* client : closed) {
+                clients.erase(std::find(clients.begin(), clients.end(), client));
+            }
+            for (Client* session : detached) {
+                if (now - session->detachedAt >= std::chrono::milliseconds(SERVER_SESSION_TIMEOUT_MS)) { expired.push_back(session); }
+            }
+            for (Client* session : expired) {
+                detached.erase(std::find(detached.begin(), detached.end(), session));
+            }
+        }
+        if (closed.empty() && expired.empty()) { return; }
+
+        // Close the connection outside of its IO threads, which also unblocks a sender stuck on a stalled client. The
+        // rest of the client is kept for it to resume its session
+        for (Client* client : closed) {
+            flog::info("Client disconnected, {0} baseband packets were dropped for it, last zstd level {1}", client->dropped, client->level);
+            stopSenderWorker(client);
+            client->conn->close();
+            client->conn.reset();
+            {
+                std::lock_guard<std::mutex> lck(client->queueMtx);
+                client->queue.clear();
+                client->queuedBaseband = 0;
+            }
+            client->detachedAt = now;
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            detached.push_back(client);
+        }
+        for (Client* session : expired) {
+            flog::info("Session of a disconnected client expired");
+            freeClient(session);
+        }
+
+        // The source keeps running only as long as a client wants it to
+        std::lock_guard<std::mutex> lck(cmdMtx);
+        updateRunning();
+    }
+
+    void updateRunning() {
+        bool wanted = false;
+        {
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            for (Client* client : clients) { wanted |= client->running; }
+            for (Client* session : detached) { wanted |= session->running; }
+        }
+        if (wanted == running) { return; }
+        running = wanted;
+        if (running) {
+            sigpath::sourceManager.start();
+        }
+        else {
+            sigpath::sourceManager.stop();
+        }
     }
 
     void setInput(dsp::stream<dsp::complex_t>* stream) {
-        comp.setInput(stream);
+        hnd.setInput(stream);
     }
 
-    void commandHandler(Command cmd, uint8_t* data, int len) {
+    void commandHandler(Client* client, Command cmd, uint8_t* data, int len) {
         if (cmd == COMMAND_GET_UI) {
-            sendUI(COMMAND_GET_UI, "", dummyElem);
+            sendUI(client, COMMAND_GET_UI, "", dummyElem);
         }
         else if (cmd == COMMAND_UI_ACTION && len >= 3) {
             // Check if sending back data is needed
@@ -259,48 +853,160 @@ namespace server {
             // Load id
             SmGui::DrawListElem diffId;
             int count = SmGui::DrawList::loadItem(diffId, &data[i], len);
-            if (count < 0) { sendError(ERROR_INVALID_ARGUMENT); return; }
-            if (diffId.type != SmGui::DRAW_LIST_ELEM_TYPE_STRING) { sendError(ERROR_INVALID_ARGUMENT); return; } 
+            if (count < 0) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
+            if (diffId.type != SmGui::DRAW_LIST_ELEM_TYPE_STRING) { sendError(client, ERROR_INVALID_ARGUMENT); return; } 
             i += count;
             len -= count;
 
             // Load value
             SmGui::DrawListElem diffValue;
             count = SmGui::DrawList::loadItem(diffValue, &data[i], len);
-            if (count < 0) { sendError(ERROR_INVALID_ARGUMENT); return; }
+            if (count < 0) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
             i += count;
             len -= count;
 
             // Render and send back
             if (sendback) {
-                sendUI(COMMAND_UI_ACTION, diffId.str, diffValue);
+                sendUI(client, COMMAND_UI_ACTION, diffId.str, diffValue);
             }
             else {
                 renderUI(NULL, diffId.str, diffValue);
             }
         }
+        else if (cmd == COMMAND_GET_UI_DELTA && len >= 1) {
+            // The client resets its side when it connects or lost track of the UI
+            if (data[0]) {
+                client->uiCodec.reset();
+                client->actionCodec.reset();
+            }
+            sendUIDelta(client, COMMAND_GET_UI_DELTA, "", dummyElem);
+        }
+        else if (cmd == COMMAND_UI_ACTIONS && len >= 1) {
+            bool sendback = data[0];
+            int i = 1;
+
+            // Load all actions first so that a malformed batch isn't partially applied
+            std::vector<std::pair<std::string, SmGui::DrawListElem>> actions;
+            while (i < len) {
+                SmGui::DrawListElem diffId, diffValue;
+                int count = client->actionCodec.decodeItem(diffId, &data[i], len - i);
+                if (count < 0 || diffId.type != SmGui::DRAW_LIST_ELEM_TYPE_STRING) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
+                i += count;
+                count = client->actionCodec.decodeItem(diffValue, &data[i], len - i);
+                if (count < 0) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
+                i += count;
+                actions.push_back({ diffId.str, diffValue });
+            }
+            if (actions.empty()) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
+
+            // Apply them in order, the last one rendering the UI sent back
+            for (int j = 0; j < actions.size() - 1; j++) {
+                renderUI(NULL, actions[j].first, actions[j].second);
+            }
+            if (sendback) {
+                sendUIDelta(client, COMMAND_UI_ACTIONS, actions.back().first, actions.back().second);
+            }
+            else {
+                renderUI(NULL, actions.back().first, actions.back().second);
+            }
+        }
         else if (cmd == COMMAND_START) {
-            sigpath::sourceManager.start();
-            running = true;
+            client->running = true;
+            updateRunning();
         }
         else if (cmd == COMMAND_STOP) {
-            sigpath::sourceManager.stop();
-            running = false;
+            client->running = false;
+            updateRunning();
         }
         else if (cmd == COMMAND_SET_FREQUENCY && len == 8) {
             sigpath::sourceManager.tune(*(double*)data);
-            sendCommandAck(COMMAND_SET_FREQUENCY, 0);
+            sendCommandAck(client, COMMAND_SET_FREQUENCY, 0);
         }
         else if (cmd == COMMAND_SET_SAMPLE_TYPE && len == 1) {
-            dsp::compression::PCMType type = (dsp::compression::PCMType)*(uint8_t*)data;
-            comp.setPCMType(type);
+            uint8_t type = *(uint8_t*)data;
+            if (type >= dsp::compression::_PCM_TYPE_COUNT) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
+            std::lock_guard<std::mutex> lck(clientsMtx);
+            client->pcmType = (dsp::compression::PCMType)type;
         }
         else if (cmd == COMMAND_SET_COMPRESSION && len == 1) {
-            compression = *(uint8_t*)data;
+            client->compression = *(uint8_t*)data;
+        }
+        else if (cmd == COMMAND_SET_VFO && len == 3 * sizeof(double)) {
+            double offset = ((double*)data)[0];
+            double bandwidth = ((double*)data)[1];
+            double samplerate = ((double*)data)[2];
+            if (samplerate > 0.0 && (samplerate > sampleRate || bandwidth <= 0.0 || bandwidth > samplerate || fabs(offset) > sampleRate / 2.0)) {
+                sendError(client, ERROR_INVALID_ARGUMENT);
+                return;
+            }
+            setVFO(client, offset, bandwidth, samplerate);
+            sendCommandAck(client, COMMAND_SET_VFO, 0);
+        }
+        else if (cmd == COMMAND_SET_UDP && len == 2) {
+            bool enabled = data[0];
+            int fecGroup = data[1];
+            if (fecGroup > SERVER_UDP_MAX_FEC_GROUP) { sendError(client, ERROR_INVALID_ARGUMENT); return; }
+            try {
+                setUDP(client, enabled, fecGroup);
+            }
+            catch (const std::exception& e) {
+                flog::error("Could not open the UDP transport: {0}", e.what());
+                sendError(client, ERROR_INVALID_ARGUMENT);
+                return;
+            }
+
+            // Reply with where to send the hellos
+            uint8_t* resp = &client->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)];
+            *(uint16_t*)resp = client->udp ? client->udp->getLocalPort() : 0;
+            *(uint32_t*)&resp[2] = client->udpToken;
+            sendCommandAck(client, COMMAND_SET_UDP, 6);
+        }
+        else if (cmd == COMMAND_GET_STATS && len == 0) {
+            SourceStats::Values values;
+            sigpath::sourceManager.getStats(values);
+            StatsInfo* info = (StatsInfo*)&client->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)];
+            info->samples = values.samples;
+            info->overflows = values.overflows;
+            info->discontinuities = values.discontinuities;
+            info->lastGapTime = values.lastGapTime;
+            sendCommandAck(client, COMMAND_GET_STATS, sizeof(StatsInfo));
+        }
+        else if (cmd == COMMAND_GET_PROFILE && len == 0) {
+            // The first query only starts the counting
+            dsp::profiler::setEnabled(true);
+            std::vector<dsp::profiler::Values> values = dsp::profiler::getValues();
+            uint8_t* buf = &client->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)];
+            int maxEntries = (SERVER_MAX_PACKET_SIZE - sizeof(PacketHeader) - sizeof(CommandHeader) - sizeof(uint32_t)) / sizeof(ProfileInfo);
+            uint32_t count = std::min<int>(values.size(), maxEntries);
+            *(uint32_t*)buf = count;
+            ProfileInfo* infos = (ProfileInfo*)&buf[sizeof(uint32_t)];
+            for (uint32_t i = 0; i < count; i++) {
+                const auto& v = values[i];
+                ProfileInfo& info = infos[i];
+                memset(info.name, 0, sizeof(info.name));
+                strncpy(info.name, v.name.c_str(), sizeof(info.name) - 1);
+                info.runs = v.runs;
+                info.runTime = v.runTime;
+                info.readWait = v.readWait;
+                info.swapWait = v.swapWait;
+                info.samplesIn = v.samplesIn;
+                info.samplesOut = v.samplesOut;
+            }
+            sendCommandAck(client, COMMAND_GET_PROFILE, sizeof(uint32_t) + count * sizeof(ProfileInfo));
+        }
+        else if (cmd == COMMAND_SET_FFT && len == 2 * sizeof(double)) {
+            int size = ((double*)data)[0];
+            double rate = ((double*)data)[1];
+            if (size && (size < SERVER_MIN_FFT_SIZE || size > SERVER_MAX_FFT_SIZE || rate <= 0.0 || rate > SERVER_MAX_FFT_RATE)) {
+                sendError(client, ERROR_INVALID_ARGUMENT);
+                return;
+            }
+            setFFT(client, size, rate);
+            sendCommandAck(client, COMMAND_SET_FFT, 0);
         }
         else {
             flog::error("Invalid Command: {0} (len = {1})", (int)cmd, len);
-            sendError(ERROR_INVALID_COMMAND);
+            sendError(client, ERROR_INVALID_COMMAND);
         }
     }
 
@@ -312,7 +1018,7 @@ namespace server {
             sigpath::sourceManager.selectSource(sourceList[sourceId]);
             core::configManager.acquire();
             core::configManager.conf["source"] = sourceList.key(sourceId);
-            core::configManager.release(true);
+            core::configManager.release(true, "source");
         }
         if (running) { SmGui::EndDisabled(); }
 
@@ -339,49 +1045,138 @@ namespace server {
         }
     }
 
-    void sendUI(Command originCmd, std::string diffId, SmGui::DrawListElem diffValue) {
+    void sendUI(Client* client, Command originCmd, std::string diffId, SmGui::DrawListElem diffValue) {
         // Render UI
         SmGui::DrawList dl;
         renderUI(&dl, diffId, diffValue);
 
         // Create response
         int size = dl.getSize();
-        dl.store(s_cmd_data, size);
+        dl.store(&client->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)], size);
 
         // Send to network
-        sendCommandAck(originCmd, size);
+        sendCommandAck(client, originCmd, size);
+    }
+
+    void sendUIDelta(Client* client, Command originCmd, std::string diffId, SmGui::DrawListElem diffValue) {
+        SmGui::DrawList dl;
+        renderUI(&dl, diffId, diffValue);
+
+        // Only what changed since the last UI sent to this client goes out
+        int max = SERVER_MAX_PACKET_SIZE - sizeof(PacketHeader) - sizeof(CommandHeader);
+        int size = client->uiCodec.encode(dl, &client->sbuf[sizeof(PacketHeader) + sizeof(CommandHeader)], max);
+        if (size < 0) {
+            flog::error("UI does not fit in a packet");
+            client->uiCodec.reset();
+            size = 0;
+        }
+        sendCommandAck(client, originCmd, size);
     }
 
-    void sendError(Error err) {
-        PacketHeader* hdr = (PacketHeader*)sbuf;
-        s_pkt_data[0] = err;
-        sendPacket(PACKET_TYPE_ERROR, 1);
+    void sendError(Client* client, Error err) {
+        client->sbuf[sizeof(PacketHeader)] = err;
+        sendPacket(client, PACKET_TYPE_ERROR, 1);
+    }
+
+    void sendSampleRate(Client* client, double sampleRate) {
+        // Can be called by the source outside of a command, so the send buffer of the client can't be used
+        uint8_t buf[sizeof(PacketHeader) + sizeof(CommandHeader) + sizeof(double)];
+        PacketHeader* hdr = (PacketHeader*)buf;
+        hdr->type = PACKET_TYPE_COMMAND;
+        hdr->size = sizeof(buf);
+        ((CommandHeader*)&buf[sizeof(PacketHeader)])->cmd = COMMAND_SET_SAMPLERATE;
+        *(double*)&buf[sizeof(PacketHeader) + sizeof(CommandHeader)] = sampleRate;
+        queuePacket(client, buf, sizeof(buf));
+    }
+
+    void setVFO(Client* client, double offset, double bandwidth, double samplerate) {
+        std::lock_guard<std::mutex> lck(clientsMtx);
+        if (samplerate <= 0.0) {
+            if (client->vfo) {
+                delete client->vfo;
+                dsp::buffer::free(client->vfoBuf);
+                client->vfo = NULL;
+                client->vfoBuf = NULL;
+            }
+            client->vfoSamplerate = 0.0;
+            sendSampleRate(client, sampleRate);
+            return;
+        }
+
+        if (client->vfo) {
+            client->vfo->setOutSamplerate(samplerate, bandwidth);
+            client->vfo->setOffset(offset);
+            dsp::buffer::free(client->vfoBuf);
+        }
+        else {
+            client->vfo = new dsp::channel::RxVFO(NULL, sampleRate, samplerate, bandwidth, offset);
+        }
+        client->vfoBuf = dsp::buffer::alloc<dsp::complex_t>(client->vfo->outputBufferSize(STREAM_BUFFER_SIZE));
+        client->vfoSamplerate = samplerate;
+        sendSampleRate(client, samplerate);
     }
 
-    void sendSampleRate(double sampleRate) {
-        *(double*)s_cmd_data = sampleRate;
-        sendCommand(COMMAND_SET_SAMPLERATE, sizeof(double));
+    void setFFT(Client* client, int size, double rate) {
+        std::lock_guard<std::mutex> lck(clientsMtx);
+        if (client->spectrum) {
+            delete client->spectrum;
+            dsp::buffer::free(client->spectrumBuf);
+            client->spectrum = NULL;
+            client->spectrumBuf = NULL;
+        }
+        if (!size) { return; }
+        client->spectrum = new dsp::fft::Spectrum(size, sampleRate, rate);
+        client->spectrumBuf = dsp::buffer::alloc<float>(size);
     }
 
     void setInputSampleRate(double samplerate) {
         sampleRate = samplerate;
-        if (!client || !client->isOpen()) { return; }
-        sendSampleRate(sampleRate);
+        std::lock_guard<std::mutex> lck(clientsMtx);
+
+        // Detached sessions are told the samplerate when resumed
+        std::vector<Client*> all = clients;
+        all.insert(all.end(), detached.begin(), detached.end());
+        for (Client* client : all) {
+            if (client->spectrum) {
+                client->spectrum->init(client->spectrum->getSize(), sampleRate, client->spectrum->getRate());
+            }
+            if (!client->vfo) {
+                if (client->conn) { sendSampleRate(client, sampleRate); }
+                continue;
+            }
+
+            // Clients with a channel keep its samplerate, only its input changes
+            client->vfo->setInSamplerate(sampleRate);
+            dsp::buffer::free(client->vfoBuf);
+            client->vfoBuf = dsp::buffer::alloc<dsp::complex_t>(client->vfo->outputBufferSize(STREAM_BUFFER_SIZE));
+        }
+    }
+
+    void queuePacket(Client* client, const uint8_t* data, int len) {
+        // Packets are queued behind the baseband already waiting so that the client receives everything in order
+        Packet pkt = std::make_shared<PacketData>(len);
+        memcpy(pkt->data(), data, len);
+        {
+            std::lock_guard<std::mutex> lck(client->queueMtx);
+            client->queue.push_back(pkt);
+        }
+        client->queueCnd.notify_one();
     }
 
-    void sendPacket(PacketType type, int len) {
-        s_pkt_hdr->type = type;
-        s_pkt_hdr->size = sizeof(PacketHeader) + len;
-        client->write(s_pkt_hdr->size, sbuf);
+    void sendPacket(Client* client, PacketType type, int len) {
+        PacketHeader* hdr = (PacketHeader*)client->sbuf;
+        hdr->type = type;
+        hdr->size = sizeof(PacketHeader) + len;
+        queuePacket(client, client->sbuf, hdr->size);
     }
 
-    void sendCommand(Command cmd, int len) {
-        s_cmd_hdr->cmd = cmd;
-        sendPacket(PACKET_TYPE_COMMAND, sizeof(CommandHeader) + len);
+    void sendCommand(Client* client, Command cmd, int len) {
+        ((CommandHeader*)&client->sbuf[sizeof(PacketHeader)])->cmd = cmd;
+        sendPacket(client, PACKET_TYPE_COMMAND, sizeof(CommandHeader) + len);
     }
 
-    void sendCommandAck(Command cmd, int len) {
-        s_cmd_hdr->cmd = cmd;
-        sendPacket(PACKET_TYPE_COMMAND_ACK, sizeof(CommandHeader) + len);
+    void sendCommandAck(Client* client, Command cmd, int len) {
+        ((CommandHeader*)&client->sbuf[sizeof(PacketHeader)])->cmd = cmd;
+        sendPacket(client, PACKET_TYPE_COMMAND_ACK, sizeof(CommandHeader) + len);
     }
-}
+}
\ No newline at end of file
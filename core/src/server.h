@@ -5,23 +5,41 @@
 #include <server_protocol.h>
 
 namespace server {
+    struct Client;
+
     void setInput(dsp::stream<dsp::complex_t>* stream);
     int main();
 
     void _clientHandler(net::Conn conn, void* ctx);
     void _packetHandler(int count, uint8_t* buf, void* ctx);
-    void _testServerHandler(uint8_t* data, int count, void* ctx);
+    void _basebandHandler(dsp::complex_t* data, int count, void* ctx);
+    void _senderWorker(Client* client);
+    void _udpHandler(int count, uint8_t* buf, void* ctx);
+    bool sendSamples(Client* client, const net::ConnBuffer* bufs, int bufCount);
+    bool sendUDP(Client* client, const net::ConnBuffer* bufs, int bufCount);
+    void setUDP(Client* client, bool enabled, int fecGroup);
+    void pruneClients();
+    void stopSenderWorker(Client* client);
+    void freeClient(Client* client);
+    Client* resumeSession(Client* client, uint64_t token);
+    void establish(Client* client);
+    void sendSession(Client* client);
+    void updateRunning();
 
     void drawMenu();
 
-    void commandHandler(Command cmd, uint8_t* data, int len);
+    void commandHandler(Client* client, Command cmd, uint8_t* data, int len);
     void renderUI(SmGui::DrawList* dl, std::string diffId, SmGui::DrawListElem diffValue);
-    void sendUI(Command originCmd, std::string diffId, SmGui::DrawListElem diffValue);
-    void sendError(Error err);
-    void sendSampleRate(double sampleRate);
+    void sendUI(Client* client, Command originCmd, std::string diffId, SmGui::DrawListElem diffValue);
+    void sendUIDelta(Client* client, Command originCmd, std::string diffId, SmGui::DrawListElem diffValue);
+    void sendError(Client* client, Error err);
+    void sendSampleRate(Client* client, double sampleRate);
+    void setVFO(Client* client, double offset, double bandwidth, double samplerate);
+    void setFFT(Client* client, int size, double rate);
     void setInputSampleRate(double samplerate);
 
-    void sendPacket(PacketType type, int len);
-    void sendCommand(Command cmd, int len);
-    void sendCommandAck(Command cmd, int len);
+    void queuePacket(Client* client, const uint8_t* data, int len);
+    void sendPacket(Client* client, PacketType type, int len);
+    void sendCommand(Client* client, Command cmd, int len);
+    void sendCommandAck(Client* client, Command cmd, int len);
 }
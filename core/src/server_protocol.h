@@ -5,6 +5,17 @@
 
 #define SERVER_MAX_PACKET_SIZE  (STREAM_BUFFER_SIZE * sizeof(dsp::complex_t) * 2)
 
+// Limits of the spectra computed by the server for a client
+#define SERVER_MIN_FFT_SIZE     128
+#define SERVER_MAX_FFT_SIZE     1048576
+#define SERVER_MAX_FFT_RATE     200.0
+#define SERVER_FFT_FLOOR        -1000.0f
+
+// Sample packets sent over UDP are cut in fragments of at most this many bytes to stay under common path MTUs
+#define SERVER_UDP_MAX_PAYLOAD  1400
+#define SERVER_UDP_MAX_FEC_GROUP    32
+#define SERVER_UDP_HELLO_INTERVAL   1000
+
 namespace server {
     enum PacketType {
         // Client to Server
@@ -27,10 +38,24 @@ namespace server {
         COMMAND_GET_SAMPLERATE,
         COMMAND_SET_SAMPLE_TYPE,
         COMMAND_SET_COMPRESSION,
+        COMMAND_SET_VFO,            // Offset, bandwidth and samplerate as doubles, a samplerate of 0 goes back to the full baseband
+        COMMAND_SET_FFT,            // Size and rate as doubles, a size of 0 stops the spectra
+        COMMAND_SET_UDP,            // Enable and FEC group size as bytes, acked with the UDP port of the server and a token
+        COMMAND_GET_STATS,          // Acked with the StatsInfo of the source of the server
+        COMMAND_GET_PROFILE,        // Enables the DSP profiler, acked with the entry count as a uint32 followed by as many ProfileInfo
+        COMMAND_GET_UI_DELTA,       // Reset flag as a byte, acked with the UI encoded by the SmGui::DrawListCodec of the client
+        COMMAND_UI_ACTIONS,         // Sync flag as a byte followed by pairs of codec encoded IDs and values, acked like COMMAND_GET_UI_DELTA if synced
+        COMMAND_RESUME,             // Session token as a uint64, acked with a byte set if the session was resumed with all its state
 
         // Server to client
         COMMAND_SET_SAMPLERATE = 0x80,
-        COMMAND_DISCONNECT
+        COMMAND_DISCONNECT,
+        COMMAND_SET_SESSION         // Session token as a uint64, to resume the session with if the connection drops
+    };
+
+    enum UDPFlags {
+        UDP_FLAG_PARITY = (1 << 0),
+        UDP_FLAG_HELLO  = (1 << 1)
     };
 
     enum Error {
@@ -49,5 +74,43 @@ namespace server {
     struct CommandHeader {
         uint32_t cmd;
     };
+
+    // Header of the datagrams of the UDP transport. Sample packets, their own header included, are cut in fragments of
+    // SERVER_UDP_MAX_PAYLOAD bytes. With FEC, each group of fecGroup fragments is followed by the XOR of its fragments,
+    // which rebuilds any single fragment lost in the group. The client regularly sends back hello datagrams holding just
+    // this header so that the server knows where to send and NATs keep the path open
+    struct UDPHeader {
+        uint32_t token;
+        uint32_t packet;
+        uint32_t size;
+        uint16_t index;     // Fragment index, or group index for parity
+        uint8_t flags;
+        uint8_t fecGroup;
+    };
+
+    // Sample accounting of the source of the server since it was started
+    struct StatsInfo {
+        uint64_t samples;
+        uint64_t overflows;
+        uint64_t discontinuities;
+        double lastGapTime;     // Unix time, 0 if no gap
+    };
+
+    // Counters of a DSP block since profiling was enabled, times are in nanoseconds
+    struct ProfileInfo {
+        char name[32];
+        uint64_t runs;
+        uint64_t runTime;
+        uint64_t readWait;
+        uint64_t swapWait;
+        uint64_t samplesIn;
+        uint64_t samplesOut;
+    };
+
+    // Followed by one byte per bin, bin i being at min + data[i] * step dB
+    struct FFTHeader {
+        float min;
+        float step;
+    };
 #pragma pack(pop)
 }
\ No newline at end of file
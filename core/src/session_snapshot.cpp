@@ -0,0 +1,141 @@
+#include "session_snapshot.h"
+#include <stdio.h>
+#include <map>
+#include <filesystem>
+#include <version.h>
+#include <utils/flog.h>
+#include <signal_path/signal_path.h>
+#include <dsp/taps/cache.h>
+
+#define SESSION_SNAPSHOT_MAGIC      "SDRPPSNP"
+
+// Written as is, a snapshot from a machine of the other byte order reads it differently
+#define SESSION_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+namespace session_snapshot {
+    static uint32_t checksum(const std::vector<uint8_t>& data) {
+        // FNV-1a, only meant to catch damaged files
+        uint32_t h = 2166136261u;
+        for (uint8_t b : data) { h = (h ^ b) * 16777619u; }
+        return h;
+    }
+
+    static bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) { return false; }
+        uint8_t buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) { data.insert(data.end(), buf, buf + n); }
+        bool ok = !ferror(f);
+        fclose(f);
+        return ok;
+    }
+
+    bool restore(const std::string& path) {
+        std::vector<uint8_t> file;
+        if (!readFile(path, file)) {
+            flog::info("No session snapshot at '{}', starting from the config alone", path);
+            return false;
+        }
+
+        // Header, then the sections and their checksum
+        Reader r(file);
+        char magic[sizeof(SESSION_SNAPSHOT_MAGIC) - 1];
+        uint32_t format = 0, byteOrder = 0;
+        std::string version;
+        r.getRaw(magic, sizeof(magic));
+        r.get(format);
+        r.get(byteOrder);
+        r.getString(version);
+        if (!r.ok() || memcmp(magic, SESSION_SNAPSHOT_MAGIC, sizeof(magic)) || format != SESSION_SNAPSHOT_FORMAT || byteOrder != SESSION_SNAPSHOT_BYTE_ORDER || version != VERSION_STR) {
+            flog::info("Session snapshot '{}' is from another version, starting from the config alone", path);
+            return false;
+        }
+
+        std::vector<uint8_t> body(file.end() - r.remaining(), file.end());
+        uint32_t count = 0;
+        uint32_t sum = 0;
+        if (body.size() < sizeof(sum)) {
+            flog::warn("Session snapshot '{}' is damaged, ignoring it", path);
+            return false;
+        }
+        memcpy(&sum, &body[body.size() - sizeof(sum)], sizeof(sum));
+        body.resize(body.size() - sizeof(sum));
+        if (checksum(body) != sum) {
+            flog::warn("Session snapshot '{}' is damaged, ignoring it", path);
+            return false;
+        }
+
+        std::map<std::string, std::vector<uint8_t>> sections;
+        Reader br(body);
+        bool damaged = false;
+        br.get(count);
+        for (uint32_t i = 0; i < count && br.ok(); i++) {
+            std::string name;
+            uint32_t size = 0;
+            br.getString(name);
+            br.get(size);
+
+            // Checked before allocating, a damaged size could be anything
+            if (size > br.remaining()) {
+                damaged = true;
+                break;
+            }
+            std::vector<uint8_t> content(size);
+            if (br.getRaw(content.data(), size)) { sections[name] = std::move(content); }
+        }
+        if (damaged || !br.ok()) {
+            flog::warn("Session snapshot '{}' is damaged, ignoring it", path);
+            return false;
+        }
+
+        // Sections nobody knows of are from a newer build of the same version and skipped
+        int taps = sections.count("taps") ? dsp::taps::cache::preload(sections["taps"]) : 0;
+        if (sections.count("iq_frontend")) { sigpath::iqFrontEnd.restoreSnapshot(sections["iq_frontend"]); }
+        flog::info("Session snapshot restored, {} filters preloaded", taps);
+        return true;
+    }
+
+    void restoreDone() {
+        dsp::taps::cache::endPreload();
+    }
+
+    bool save(const std::string& path) {
+        std::vector<std::pair<std::string, std::vector<uint8_t>>> sections;
+        sections.push_back({ "taps", dsp::taps::cache::snapshot() });
+        sections.push_back({ "iq_frontend", sigpath::iqFrontEnd.saveSnapshot() });
+
+        Writer body;
+        body.put<uint32_t>(sections.size());
+        for (const auto& [name, content] : sections) {
+            body.putString(name);
+            body.put<uint32_t>(content.size());
+            body.putRaw(content.data(), content.size());
+        }
+
+        Writer w;
+        w.putRaw(SESSION_SNAPSHOT_MAGIC, sizeof(SESSION_SNAPSHOT_MAGIC) - 1);
+        w.put<uint32_t>(SESSION_SNAPSHOT_FORMAT);
+        w.put<uint32_t>(SESSION_SNAPSHOT_BYTE_ORDER);
+        w.putString(VERSION_STR);
+        w.putRaw(body.data.data(), body.data.size());
+        w.put<uint32_t>(checksum(body.data));
+
+        std::string tmpPath = path + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        if (!f) {
+            flog::warn("Could not save the session snapshot to '{}'", path);
+            return false;
+        }
+        bool ok = fwrite(w.data.data(), 1, w.data.size(), f) == w.data.size();
+        ok &= !fclose(f);
+        std::error_code ec;
+        if (ok) { std::filesystem::rename(tmpPath, path, ec); }
+        if (!ok || ec) {
+            flog::warn("Could not save the session snapshot to '{}'", path);
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+        return true;
+    }
+}
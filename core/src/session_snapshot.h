@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <string.h>
+#include <stdint.h>
+
+// Bumped whenever the layout of the file or of a section changes, or the way what they hold is generated does, the
+// snapshots of any other format being ignored
+#define SESSION_SNAPSHOT_FORMAT     1
+
+// Binary state saved at a clean shutdown so that the next startup can skip work whose result only depends on its
+// parameters, such as generating the taps of the filters or the window of the FFT. What is restored is only used
+// when asked for with the very same parameters, so a stale snapshot never changes the behavior, it only costs the
+// memory of what nobody claims. Snapshots of another version or format, or damaged ones, are ignored and everything
+// is computed as usual. The config stays the only source of the settings
+namespace session_snapshot {
+    // Content of a section, in the byte order of the machine that is checked when loading
+    class Writer {
+    public:
+        template <class T>
+        void put(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            putRaw(&value, sizeof(T));
+        }
+
+        void putString(const std::string& str) {
+            put<uint32_t>(str.size());
+            putRaw(str.data(), str.size());
+        }
+
+        void putRaw(const void* src, size_t size) {
+            const uint8_t* p = (const uint8_t*)src;
+            data.insert(data.end(), p, p + size);
+        }
+
+        std::vector<uint8_t> data;
+    };
+
+    // Reads fail instead of going past the end, after which every read fails
+    class Reader {
+    public:
+        Reader(const std::vector<uint8_t>& data) : data(data) {}
+
+        template <class T>
+        bool get(T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return getRaw(&value, sizeof(T));
+        }
+
+        bool getString(std::string& str) {
+            uint32_t len;
+            if (!get(len) || len > remaining()) { return fail(); }
+            str.assign((const char*)&data[pos], len);
+            pos += len;
+            return true;
+        }
+
+        bool getRaw(void* dst, size_t size) {
+            if (failed || size > remaining()) { return fail(); }
+            memcpy(dst, &data[pos], size);
+            pos += size;
+            return true;
+        }
+
+        size_t remaining() { return failed ? 0 : data.size() - pos; }
+
+        bool ok() { return !failed; }
+
+    private:
+        bool fail() {
+            failed = true;
+            return false;
+        }
+
+        const std::vector<uint8_t>& data;
+        size_t pos = 0;
+        bool failed = false;
+    };
+
+    // Load the snapshot and hand its sections to the taps cache and the IQ front end, before either is used
+    bool restore(const std::string& path);
+
+    // Once the module instances are created and post-initialized, let go of what they didn't claim
+    void restoreDone();
+
+    // Snapshot the running session, while the module instances still exist. Written to a temporary file first so that
+    // an interrupted save leaves the previous snapshot in place
+    bool save(const std::string& path);
+}
@@ -1,17 +1,40 @@
 #include "iq_frontend.h"
+#include "signal_path.h"
 #include "../dsp/window/blackman.h"
 #include "../dsp/window/nuttall.h"
+#include "../dsp/accelerate.h"
+#include "../dsp/kernels/kernels.h"
 #include <utils/flog.h>
 #include <gui/gui.h>
 #include <core.h>
+#include <session_snapshot.h>
+
+IQFrontEnd::FFTConfig::~FFTConfig() {
+    welch.destroy();
+    plan.destroy();
+    dsp::buffer::free(window);
+    fftwf_free(in);
+    fftwf_free(out);
+}
 
 IQFrontEnd::~IQFrontEnd() {
     if (!_init) { return; }
+    {
+        std::lock_guard<std::mutex> lck(fftReqMtx);
+        fftReqStop = true;
+    }
+    fftReqCV.notify_all();
+    if (fftThread.joinable()) { fftThread.join(); }
     stop();
-    dsp::buffer::free(fftWindowBuf);
-    fftwf_destroy_plan(fftwPlan);
-    fftwf_free(fftInBuf);
-    fftwf_free(fftOutBuf);
+
+    // The VFOs left must be off the pool before it goes
+    if (vfoScheduler) {
+        std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+        for (auto& [name, vfo] : vfos) { vfo->stop(); }
+        delete vfoScheduler;
+    }
+    delete fftConfig;
+    dsp::buffer::free(restoredWindow);
 }
 
 void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow, float* (*acquireFFTBuffer)(void* ctx), void (*releaseFFTBuffer)(void* ctx), void* fftCtx) {
@@ -23,121 +46,300 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     _acquireFFTBuffer = acquireFFTBuffer;
     _releaseFFTBuffer = releaseFFTBuffer;
     _fftCtx = fftCtx;
+    if (!stats) { stats = &sigpath::spectrumStats; }
 
     effectiveSr = _sampleRate / _decimRatio;
 
     inBuf.init(in);
     inBuf.bypass = !buffering;
+    compactBuf.init(&nullCompact);
+    compactBuf.bypass = !buffering;
+    compactDecim.init(&compactBuf.out, _decimRatio);
+    compactDecim.setCICAllowed(true);
 
+    // The IQ inversion and DC removal are done by the decimators as part of their pass, see updateCorrection()
+    _dcBlocking = dcBlocking;
     decim.init(NULL, _decimRatio);
-    dcBlock.init(NULL, genDCBlockRate(effectiveSr));
-    conjugate.init(NULL);
+    decim.setCICAllowed(true);
+    updateCorrection();
 
-    preproc.init(&inBuf.out);
-    preproc.addBlock(&decim, _decimRatio > 1);
-    preproc.addBlock(&dcBlock, dcBlocking);
-    preproc.addBlock(&conjugate, false); // TODO: Replace by parameter
+    preproc.init(&inBuf.out, true);
+    preproc.addBlock(&decim, decimActive());
 
     split.init(preproc.out);
 
-    // TODO: Do something to avoid basically repeating this code twice
-    int skip;
-    genReshapeParams(effectiveSr, _fftSize, _fftRate, skip, _nzFFTSize);
-    reshape.init(&fftIn, fftSize, skip);
-    fftSink.init(&reshape.out, handler, this);
+    // The channelizer is only bound to the splitter when enabled
+    channelizer.init(&chanIn, effectiveSr, IQFRONTEND_DEFAULT_CHANNELS);
 
-    fftWindowBuf = dsp::buffer::alloc<float>(_nzFFTSize);
-    if (_fftWindow == FFTWindow::RECTANGULAR) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = 0; }
-    }
-    else if (_fftWindow == FFTWindow::BLACKMAN) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::blackman(i, _nzFFTSize); }
-    }
-    else if (_fftWindow == FFTWindow::NUTTALL) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize); }
-    }
+    // The automatic decimation too, its blocks are bypassed until the VFOs fit in part of the band
+    autoXlator.init(NULL, 0.0, effectiveSr);
+    autoDecim.init(NULL, 1);
+    autoDecim.setCICAllowed(true);
+    autoChain.init(&autoIn, true);
+    autoChain.addBlock(&autoXlator, false);
+    autoChain.addBlock(&autoDecim, false);
+    autoSplit.init(autoChain.out);
 
-    fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    vfoGroup.init(&groupIn);
+    autoVFOGroup.init(&autoGroupIn);
 
-    // Clear the rest of the FFT input buffer
-    dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
+    // TODO: Do something to avoid basically repeating this code twice
+    int skip, nzFFTSize;
+    genReshapeParams(effectiveSr, _fftSize, _fftRate, skip, nzFFTSize);
+    reshape.init(&fftIn, nzFFTSize, skip);
+    fftSink.init(&reshape.out, handler, this);
+
+    // Names of the blocks in the DSP performance statistics
+    inBuf.setProfileName("Input buffer");
+    compactBuf.setProfileName("Input buffer (16 bit)");
+    compactDecim.setProfileName("Decimation (16 bit)");
+    preproc.setProfileName("Preprocessing");
+    split.setProfileName("Splitter");
+    channelizer.setProfileName("Channelizer");
+    autoChain.setProfileName("Auto decimation");
+    autoSplit.setProfileName("Auto decimation splitter");
+    vfoGroup.setProfileName("VFO group");
+    autoVFOGroup.setProfileName("Auto decimation VFO group");
+    reshape.setProfileName("FFT reshaper");
+    fftSink.setProfileName("FFT");
+
+    // Everything up to the VFOs runs at the samplerate of the source
+    inBuf.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    compactBuf.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    compactDecim.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    preproc.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    split.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    channelizer.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    autoChain.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    autoSplit.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    vfoGroup.setThreadRole(dsp::THREAD_ROLE_VFO);
+    autoVFOGroup.setThreadRole(dsp::THREAD_ROLE_VFO);
+    reshape.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+    fftSink.setThreadRole(dsp::THREAD_ROLE_WIDEBAND);
+
+    // The first configuration is prepared right away, the later ones by the FFT worker
+    fftConfig = prepareFFTConfig({ effectiveSr, _fftSize, _fftRate, _fftWindow, _fftAveraging, _fftOverlap });
+    reshape.setFrame(fftConfig->keep, fftConfig->skip);
+
+    // A restored window the first configuration didn't use is of no use to the later ones, prepared by the worker
+    dsp::buffer::free(restoredWindow);
+    restoredWindow = NULL;
+    fftThread = std::thread(&IQFrontEnd::fftWorker, this);
 
     split.bindStream(&fftIn);
 
     _init = true;
 }
 
+void IQFrontEnd::setSecondary(SpectrumStats* stats) {
+    this->stats = stats;
+    secondary = true;
+}
+
 void IQFrontEnd::setInput(dsp::stream<dsp::complex_t>* in) {
     inBuf.setInput(in);
+
+    // Go back to the float path if needed
+    if (!compact) { return; }
+    compact = false;
+    compactBuf.setInput(&nullCompact);
+    preproc.setInput(&inBuf.out, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    preproc.setBlockEnabled(&decim, decimActive(), [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+}
+
+void IQFrontEnd::setInput(dsp::stream<dsp::complex_s16_t>* in, float scale) {
+    compactBuf.setInput(in);
+    compactDecim.setScale(scale);
+
+    // Switch to the compact path if needed, its decimator replacing the one of the chain
+    if (compact) { return; }
+    compact = true;
+    preproc.setBlockEnabled(&decim, false, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    preproc.setInput(&compactDecim.out, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
 }
 
 void IQFrontEnd::setSampleRate(double sampleRate) {
-    // Temp stop the necessary blocks
-    dcBlock.tempStop();
-    for (auto& [name, vfo] : vfos) {
-        vfo->tempStop();
-    }
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
 
-    // Update the samplerate
+    // Update the samplerate, the DC blocker and the VFOs take it between two buffers without being stopped
     _sampleRate = sampleRate;
     effectiveSr = _sampleRate / _decimRatio;
-    dcBlock.setRate(genDCBlockRate(effectiveSr));
+    updateCorrection();
+    channelizer.setSamplerate(effectiveSr);
+
+    // The decimation that fits the VFOs depends on the samplerate
+    if (autoActive()) { updateAutoDecimation(true); }
+    autoXlator.setOffset(-autoShift, effectiveSr);
     for (auto& [name, vfo] : vfos) {
-        vfo->setInSamplerate(effectiveSr);
+        vfo->setInSamplerate(effectiveSr / getAutoDecimation());
+        vfo->setOffset(vfoSpans[name].offset - getAutoShift());
     }
 
     // Reconfigure the FFT
     updateFFTPath();
-
-    // Restart blocks
-    dcBlock.tempStart();
-    for (auto& [name, vfo] : vfos) {
-        vfo->tempStart();
-    }
 }
 
 void IQFrontEnd::setBuffering(bool enabled) {
     inBuf.bypass = !enabled;
+    compactBuf.bypass = !enabled;
 }
 
 void IQFrontEnd::setDecimation(int ratio) {
-    // Temp stop the decimator
-    decim.tempStop();
-
-    // Update the decimation ratio
+    // Update the decimation ratio, the decimators swap their stages between two buffers
     _decimRatio = ratio;
-    if (_decimRatio > 1) { decim.setRatio(_decimRatio); }
+    decim.setRatio(_decimRatio);
+    compactDecim.setRatio(_decimRatio);
     setSampleRate(_sampleRate);
 
-    // Restart the decimator if it was running
-    decim.tempStart();
-
-    // Enable or disable in the chain
-    preproc.setBlockEnabled(&decim, _decimRatio > 1, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    // Enable or disable in the chain, the compact path decimates on its own
+    preproc.setBlockEnabled(&decim, decimActive(), [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
 
     // Update the DSP sample rate (TODO: Find a way to get rid of this)
     core::setInputSampleRate(_sampleRate);
 }
 
+void IQFrontEnd::setDecimationThreads(int threads) {
+    decim.setThreads(threads);
+    compactDecim.setThreads(threads);
+    autoDecim.setThreads(threads);
+}
+
 void IQFrontEnd::setDCBlocking(bool enabled) {
-    preproc.setBlockEnabled(&dcBlock, enabled, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    _dcBlocking = enabled;
+    updateCorrection();
+    preproc.setBlockEnabled(&decim, decimActive(), [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
 }
 
 void IQFrontEnd::setInvertIQ(bool enabled) {
-    preproc.setBlockEnabled(&conjugate, enabled, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    _invertIQ = enabled;
+    updateCorrection();
+    preproc.setBlockEnabled(&decim, decimActive(), [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+}
+
+void IQFrontEnd::updateCorrection() {
+    // The DC blocker runs at the output of the decimators
+    float rate = genDCBlockRate(effectiveSr);
+    decim.setCorrection(_invertIQ, _dcBlocking, rate);
+    compactDecim.setCorrection(_invertIQ, _dcBlocking, rate);
+}
+
+void IQFrontEnd::setChannelizer(int channels) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    if (channels == _channels) { return; }
+
+    // Just change the number of channels if it was already in use, the VFOs then need to pick their new channel
+    if (channelized() && channels) {
+        for (auto& [name, vfo] : vfos) { vfo->tempStop(); }
+        channelizer.setChannels(channels);
+        for (auto& [name, vfo] : vfos) { vfo->setChannelizer(&channelizer); }
+        for (auto& [name, vfo] : vfos) { vfo->tempStart(); }
+        _channels = channels;
+        return;
+    }
+
+    // Otherwise move the VFOs between the channelizer and the splitter or the decimated band
+    if (channels) { channelizer.setChannels(channels); }
+    stopAutoPath();
+    _channels = channels;
+    startAutoPath();
+}
+
+void IQFrontEnd::setVFOGrouping(bool enabled) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    if (enabled == _vfoGrouping) { return; }
+
+    // The VFOs move between the groups and their own inputs
+    for (auto& [name, vfo] : vfos) { unbindVFO(name); }
+    _vfoGrouping = enabled;
+    if (enabled) {
+        split.bindStream(&groupIn);
+        autoSplit.bindStream(&autoGroupIn);
+    }
+    else {
+        split.unbindStream(&groupIn);
+        autoSplit.unbindStream(&autoGroupIn);
+    }
+    for (auto& [name, vfo] : vfos) { bindVFO(name); }
+}
+
+void IQFrontEnd::setVFOScheduler(bool enabled) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    if (enabled == (vfoScheduler != NULL)) { return; }
+
+    // The pool is only deleted once every VFO is back on its own thread
+    dsp::Scheduler* old = vfoScheduler;
+    vfoScheduler = enabled ? new dsp::Scheduler(0, dsp::THREAD_ROLE_VFO) : NULL;
+    for (auto& [name, vfo] : vfos) { vfo->setScheduler(vfoScheduler); }
+    delete old;
 }
 
-void IQFrontEnd::bindIQStream(dsp::stream<dsp::complex_t>* stream) {
-    split.bindStream(stream);
+void IQFrontEnd::setAutoDecimation(bool enabled) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    if (enabled == _autoDecim) { return; }
+    stopAutoPath();
+    _autoDecim = enabled;
+    startAutoPath();
+}
+
+void IQFrontEnd::setRemoteDecimation(void (*handler)(int ratio, double shift, void* ctx), int maxRatio, void* ctx) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    stopAutoPath();
+    _remoteDecim = handler;
+    _remoteCtx = ctx;
+    remoteMaxRatio = std::max<int>(maxRatio, 1);
+
+    // The band is picked again from scratch for the new decimator
+    autoRatio = 1;
+    autoShift = 0.0;
+    startAutoPath();
+}
+
+void IQFrontEnd::stopAutoPath() {
+    if (channelized()) {
+        split.unbindStream(&chanIn);
+        channelizer.stop();
+    }
+    else if (autoActive()) {
+        split.unbindStream(&autoIn);
+        autoChain.stop();
+        autoSplit.stop();
+    }
+    for (auto& [name, vfo] : vfos) { unbindVFO(name); }
+}
+
+void IQFrontEnd::startAutoPath() {
+    if (autoActive()) {
+        updateAutoDecimation(true);
+        configureAutoChain();
+    }
+    for (auto& [name, vfo] : vfos) { bindVFO(name); }
+    if (channelized()) {
+        split.bindStream(&chanIn);
+        channelizer.start();
+    }
+    else if (autoActive()) {
+        autoChain.start();
+        autoSplit.start();
+        split.bindStream(&autoIn);
+    }
+    notifyRemoteDecimation();
+}
+
+void IQFrontEnd::bindIQStream(dsp::stream<dsp::complex_t>* stream, dsp::routing::Backpressure policy) {
+    split.bindStream(stream, policy);
 }
 
 void IQFrontEnd::unbindIQStream(dsp::stream<dsp::complex_t>* stream) {
     split.unbindStream(stream);
 }
 
+uint64_t IQFrontEnd::getIQStreamDrops(dsp::stream<dsp::complex_t>* stream) {
+    return split.getDrops(stream);
+}
+
 dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, double bandwidth, double offset) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+
     // Make sure no other VFO with that name already exists
     if (vfos.find(name) != vfos.end()) {
         flog::error("[IQFrontEnd] Tried to add VFO with existing name.");
@@ -145,13 +347,19 @@ dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, dou
     }
 
     // Create VFO and its input stream
-    dsp::stream<dsp::complex_t>* vfoIn = new dsp::stream<dsp::complex_t>;
+    // The VFO only reads its input, it can share the splitter input buffer instead of getting a copy
+    dsp::stream<dsp::complex_t>* vfoIn = new dsp::shared_stream<dsp::complex_t>;
     dsp::channel::RxVFO* vfo = new dsp::channel::RxVFO(vfoIn, effectiveSr, sampleRate, bandwidth, offset);
+    vfo->setProfileName("VFO " + name);
+    vfo->setThreadRole(dsp::THREAD_ROLE_VFO);
+    vfo->setScheduler(vfoScheduler);
 
-    // Register them
+    // Register them, the decimated band may have to be widened to make room for the new VFO
     vfoStreams[name] = vfoIn;
     vfos[name] = vfo;
-    bindIQStream(vfoIn);
+    vfoSpans[name] = { offset, sampleRate };
+    if (autoActive()) { updateAutoDecimation(true); }
+    bindVFO(name);
 
     // Start VFO
     vfo->start();
@@ -160,6 +368,8 @@ dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, dou
 }
 
 void IQFrontEnd::removeVFO(std::string name) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+
     // Make sure that a VFO with that name exists
     if (vfos.find(name) == vfos.end()) {
         flog::error("[IQFrontEnd] Tried to remove a VFO that doesn't exist.");
@@ -173,13 +383,149 @@ void IQFrontEnd::removeVFO(std::string name) {
     // Stop the VFO
     vfo->stop();
 
-    unbindIQStream(vfoIn);
+    unbindVFO(name);
     vfoStreams.erase(name);
     vfos.erase(name);
+    vfoSpans.erase(name);
 
     // Delete the VFO and its input stream
     delete vfo;
     delete vfoIn;
+
+    // The remaining VFOs may fit in a narrower band
+    if (autoActive()) { updateAutoDecimation(true); }
+}
+
+void IQFrontEnd::setVFOOffset(std::string name, double offset) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    auto it = vfos.find(name);
+    if (it == vfos.end()) { return; }
+    vfoSpans[name].offset = offset;
+
+    // Moving the decimated band retunes every VFO, otherwise only this one is
+    if (autoActive() && updateAutoDecimation(false)) { return; }
+    it->second->setOffset(offset - getAutoShift());
+}
+
+void IQFrontEnd::setVFOSampleRate(std::string name, double sampleRate, double bandwidth) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    auto it = vfos.find(name);
+    if (it == vfos.end()) { return; }
+    vfoSpans[name].sampleRate = sampleRate;
+    it->second->setOutSamplerate(sampleRate, bandwidth);
+    if (autoActive()) { updateAutoDecimation(true); }
+}
+
+void IQFrontEnd::bindVFO(const std::string& name) {
+    dsp::stream<dsp::complex_t>* vfoIn = vfoStreams[name];
+    dsp::channel::RxVFO* vfo = vfos[name];
+    vfo->setInSamplerate(effectiveSr / getAutoDecimation());
+    vfo->setOffset(vfoSpans[name].offset - getAutoShift());
+    if (channelized()) {
+        channelizer.bindOutput(vfoIn);
+        vfo->setChannelizer(&channelizer);
+    }
+    else if (_vfoGrouping) {
+        (autoActive() ? autoVFOGroup : vfoGroup).addVFO(vfo);
+    }
+    else if (autoActive()) {
+        autoSplit.bindStream(vfoIn);
+    }
+    else {
+        bindIQStream(vfoIn);
+    }
+}
+
+void IQFrontEnd::unbindVFO(const std::string& name) {
+    dsp::stream<dsp::complex_t>* vfoIn = vfoStreams[name];
+    if (channelized()) {
+        channelizer.unbindOutput(vfoIn);
+        vfos[name]->setChannelizer(NULL);
+    }
+    else if (_vfoGrouping) {
+        (autoActive() ? autoVFOGroup : vfoGroup).removeVFO(vfos[name]);
+    }
+    else if (autoActive()) {
+        autoSplit.unbindStream(vfoIn);
+    }
+    else {
+        unbindIQStream(vfoIn);
+    }
+}
+
+void IQFrontEnd::planAutoDecimation(int& ratio, double& shift) {
+    ratio = 1;
+    shift = 0.0;
+
+    // Nothing needs to be streamed without VFOs, a source decimating on its own then sends as little as it can
+    if (vfoSpans.empty()) {
+        if (remoteActive()) { ratio = remoteMaxRatio; }
+        return;
+    }
+
+    // Part of the band the VFOs need, each resamples a band as wide as its output samplerate
+    double low = INFINITY;
+    double high = -INFINITY;
+    for (auto const& [name, span] : vfoSpans) {
+        low = std::min<double>(low, span.offset - span.sampleRate / 2.0);
+        high = std::max<double>(high, span.offset + span.sampleRate / 2.0);
+    }
+
+    // Largest ratio whose alias free band they fill no more than IQFRONTEND_AUTO_DECIM_FILL of
+    double width = high - low;
+    int maxRatio = remoteActive() ? remoteMaxRatio : dsp::multirate::PowerDecimator<dsp::complex_t>::getMaxRatio();
+    while (ratio < maxRatio && (effectiveSr / (ratio * 2)) * POWER_DECIMATOR_PASSBAND * IQFRONTEND_AUTO_DECIM_FILL >= width) {
+        ratio *= 2;
+    }
+    if (ratio > 1) { shift = (low + high) / 2.0; }
+}
+
+bool IQFrontEnd::autoCoversVFOs() {
+    if (autoRatio == 1) { return true; }
+    double halfBand = (effectiveSr / autoRatio) * POWER_DECIMATOR_PASSBAND / 2.0;
+    for (auto const& [name, span] : vfoSpans) {
+        if (span.offset - span.sampleRate / 2.0 < autoShift - halfBand) { return false; }
+        if (span.offset + span.sampleRate / 2.0 > autoShift + halfBand) { return false; }
+    }
+    return true;
+}
+
+bool IQFrontEnd::updateAutoDecimation(bool replan) {
+    int ratio;
+    double shift;
+    planAutoDecimation(ratio, shift);
+
+    // While the VFOs move, the band is only picked again once one leaves it or they fit in a narrower one, so that
+    // it doesn't follow every step
+    if (!replan && autoCoversVFOs() && ratio <= autoRatio) { return false; }
+    if (ratio == autoRatio && shift == autoShift) { return false; }
+    bool ratioChanged = (ratio != autoRatio);
+    autoRatio = ratio;
+    autoShift = shift;
+    configureAutoChain();
+
+    // Retune the VFOs within the new band, those using the channelizer aren't affected
+    if (!autoActive()) { return true; }
+    notifyRemoteDecimation();
+    for (auto& [name, vfo] : vfos) {
+        if (ratioChanged) { vfo->setInSamplerate(effectiveSr / autoRatio); }
+        vfo->setOffset(vfoSpans[name].offset - autoShift);
+    }
+    if (ratioChanged) { flog::info("[IQFrontEnd] Decimating the band of the VFOs by {0}", autoRatio); }
+    return true;
+}
+
+void IQFrontEnd::configureAutoChain() {
+    // The input is already the decimated band when the source decimates it
+    bool local = (autoRatio > 1) && !remoteActive();
+    autoXlator.setOffset(-autoShift, effectiveSr);
+    if (local) { autoDecim.setRatio(autoRatio); }
+    autoChain.setBlockEnabled(&autoXlator, local, [=](dsp::stream<dsp::complex_t>* out){ autoSplit.setInput(out); });
+    autoChain.setBlockEnabled(&autoDecim, local, [=](dsp::stream<dsp::complex_t>* out){ autoSplit.setInput(out); });
+}
+
+void IQFrontEnd::notifyRemoteDecimation() {
+    if (remoteActive()) { _remoteDecim(getAutoDecimation(), getAutoShift(), _remoteCtx); }
 }
 
 void IQFrontEnd::setFFTSize(int size) {
@@ -197,13 +543,64 @@ void IQFrontEnd::setFFTWindow(FFTWindow fftWindow) {
     updateFFTPath();
 }
 
+void IQFrontEnd::setFFTAveraging(bool enabled) {
+    _fftAveraging = enabled;
+    updateFFTPath();
+}
+
+void IQFrontEnd::setFFTOverlap(double overlap) {
+    _fftOverlap = std::clamp<double>(overlap, 0.0, 0.875);
+    updateFFTPath();
+}
+
+void IQFrontEnd::setFFTFastLog(bool enabled) {
+    _fftFastLog = enabled;
+}
+
+void IQFrontEnd::setFFTVisibleOnly(bool enabled) {
+    _fftVisibleOnly = enabled;
+}
+
+void IQFrontEnd::setFFTEnabled(bool enabled) {
+    if (enabled == _fftEnabled) { return; }
+    _fftEnabled = enabled;
+    stats->reset();
+
+    // The FFT branch just waits for samples while its input isn't bound
+    if (_fftEnabled) {
+        split.bindStream(&fftIn);
+    }
+    else {
+        split.unbindStream(&fftIn);
+    }
+}
+
+void IQFrontEnd::setFFTOffload(bool (*configure)(int fftSize, const float* window, int windowSize, void* ctx), bool (*submit)(const dsp::complex_t* frame, void* ctx), void* ctx) {
+    // Frames go back to FFTW until the new implementation is configured
+    {
+        std::lock_guard<std::mutex> lck(fftMtx);
+        offloadActive = false;
+        _offloadConfigure = configure;
+        _offloadSubmit = submit;
+        _offloadCtx = ctx;
+    }
+    updateFFTPath();
+}
+
 void IQFrontEnd::flushInputBuffer() {
     inBuf.flush();
+    compactBuf.flush();
+}
+
+dsp::buffer::FrameBufferStats IQFrontEnd::getInputBufferStats() {
+    return compact ? compactBuf.getStats() : inBuf.getStats();
 }
 
 void IQFrontEnd::start() {
-    // Start input buffer
+    // Start input buffers
     inBuf.start();
+    compactBuf.start();
+    compactDecim.start();
 
     // Start pre-proc chain (automatically start all bound blocks)
     preproc.start();
@@ -211,7 +608,16 @@ void IQFrontEnd::start() {
     // Start IQ splitter
     split.start();
 
-    // Start all VFOs
+    // Start the channelizer and automatic decimation if used
+    if (channelized()) { channelizer.start(); }
+    if (autoActive()) {
+        autoChain.start();
+        autoSplit.start();
+    }
+
+    // Start all VFOs and the groups processing some of them
+    vfoGroup.start();
+    autoVFOGroup.start();
     for (auto& [name, vfo] : vfos) {
         vfo->start();
     }
@@ -222,8 +628,10 @@ void IQFrontEnd::start() {
 }
 
 void IQFrontEnd::stop() {
-    // Stop input buffer
+    // Stop input buffers
     inBuf.stop();
+    compactBuf.stop();
+    compactDecim.stop();
 
     // Stop pre-proc chain (automatically start all bound blocks)
     preproc.stop();
@@ -231,10 +639,17 @@ void IQFrontEnd::stop() {
     // Stop IQ splitter
     split.stop();
 
+    // Stop the channelizer and automatic decimation
+    channelizer.stop();
+    autoChain.stop();
+    autoSplit.stop();
+
     // Stop all VFOs
     for (auto& [name, vfo] : vfos) {
         vfo->stop();
     }
+    vfoGroup.stop();
+    autoVFOGroup.stop();
 
     // Stop FFT chain
     reshape.stop();
@@ -247,63 +662,196 @@ double IQFrontEnd::getEffectiveSamplerate() {
 
 void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
     IQFrontEnd* _this = (IQFrontEnd*)ctx;
+    dsp::profiler::TraceScope scope("FFT handler");
+    std::lock_guard<std::mutex> lck(_this->fftMtx);
+    FFTConfig* cfg = _this->fftConfig;
+
+    // Frames cut for the previous configuration may still come through after a new one was swapped in
+    if (count != cfg->keep) { return; }
+
+    // When averaging, the frame holds all the segments to average
+    if (cfg->welchActive) {
+        float* fftBuf = _this->_acquireFFTBuffer(_this->_fftCtx);
+        if (fftBuf) {
+            cfg->welch.process(data, count, cfg->window, fftBuf);
+            _this->stats->process(fftBuf, cfg->size, _this->effectiveSr);
+        }
+        _this->_releaseFFTBuffer(_this->_fftCtx);
+        return;
+    }
+
+    // The offloaded FFT windows the frame itself
+    if (_this->offloadActive && _this->_offloadSubmit(data, _this->_offloadCtx)) { return; }
 
     // Apply window
-    volk_32fc_32f_multiply_32fc((lv_32fc_t*)_this->fftInBuf, (lv_32fc_t*)data, _this->fftWindowBuf, _this->_nzFFTSize);
+    volk_32fc_32f_multiply_32fc((lv_32fc_t*)cfg->in, (lv_32fc_t*)data, cfg->window, cfg->nzSize);
 
     // Execute FFT
-    fftwf_execute(_this->fftwPlan);
+    cfg->plan.execute();
 
     // Aquire buffer
     float* fftBuf = _this->_acquireFFTBuffer(_this->_fftCtx);
 
     // Convert the complex output of the FFT to dB amplitude
     if (fftBuf) {
-        volk_32fc_s32f_power_spectrum_32f(fftBuf, (lv_32fc_t*)_this->fftOutBuf, _this->_fftSize, _this->_fftSize);
+        _this->convertSpectrum(cfg, fftBuf);
+        _this->stats->process(fftBuf, cfg->size, _this->effectiveSr);
     }
 
     // Release buffer
     _this->_releaseFFTBuffer(_this->_fftCtx);
 }
 
+void IQFrontEnd::convertSpectrum(FFTConfig* cfg, float* out) {
+    const dsp::complex_t* in = (const dsp::complex_t*)cfg->out;
+    int size = cfg->size;
+
+    // Bins shown by the waterfall with some margin so that small pans don't reveal frozen bins
+    int first = 0;
+    int count = size;
+    if (_fftVisibleOnly && !secondary && effectiveSr > 0.0) {
+        double binWidth = effectiveSr / (double)size;
+        double viewBw = gui::waterfall.getViewBandwidth();
+        double viewOffset = gui::waterfall.getViewOffset();
+        double margin = viewBw * IQFRONTEND_VISIBLE_MARGIN;
+        first = std::clamp<int>(floor((viewOffset - (viewBw / 2.0) - margin) / binWidth) + (size / 2), 0, size);
+        int last = std::clamp<int>(ceil((viewOffset + (viewBw / 2.0) + margin) / binWidth) + (size / 2), first, size);
+        count = last - first;
+    }
+
+    // Whenever the range changes, convert whole spectra into each of the three buffers the waterfall cycles through
+    if (first != convFirst || count != convCount) {
+        convFirst = first;
+        convCount = count;
+        convFullLeft = 3;
+    }
+    if (convFullLeft) {
+        convFullLeft--;
+        first = 0;
+        count = size;
+    }
+
+    if (_fftFastLog) {
+        dsp::kernels::get().powerSpectrum(&out[first], &in[first], size, count);
+    }
+    else {
+        dsp::accelerate::powerSpectrum(&out[first], &in[first], size, count);
+    }
+}
+
 void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
-    // Temp stop branch
-    reshape.tempStop();
-    fftSink.tempStop();
+    {
+        std::lock_guard<std::mutex> lck(fftReqMtx);
+        fftReq = { effectiveSr, _fftSize, _fftRate, _fftWindow, _fftAveraging, _fftOverlap };
+        fftReqPending = true;
+        fftReqWaterfall |= updateWaterfall;
+    }
+    fftReqCV.notify_all();
+}
+
+IQFrontEnd::FFTConfig* IQFrontEnd::prepareFFTConfig(const FFTRequest& req) {
+    FFTConfig* cfg = new FFTConfig;
+    cfg->size = req.size;
 
     // Update reshaper settings
-    int skip;
-    genReshapeParams(effectiveSr, _fftSize, _fftRate, skip, _nzFFTSize);
-    reshape.setKeep(_nzFFTSize);
-    reshape.setSkip(skip);
+    genReshapeParams(req.sampleRate, cfg->size, req.rate, cfg->skip, cfg->nzSize);
+    cfg->keep = cfg->nzSize;
+
+    // Average all the segments that fit between two FFT frames instead of skipping samples, if there's room for at least one
+    int fftInterval = round(req.sampleRate / req.rate);
+    cfg->welchActive = req.averaging && fftInterval >= cfg->size && cfg->size <= RING_BUF_SZ / 2;
+    if (cfg->welchActive) {
+        int threads = std::clamp<int>(std::thread::hardware_concurrency() / 2, 1, IQFRONTEND_WELCH_MAX_THREADS);
+        cfg->welch.init(cfg->size, req.overlap, threads);
+
+        // The whole frame has to fit in the reshaper
+        int segments = std::min<int>(((fftInterval - cfg->size) / cfg->welch.getHop()) + 1, WELCH_MAX_SEGMENTS);
+        while (segments > 1 && cfg->welch.getInputSize(segments) > RING_BUF_SZ / 2) { segments--; }
+        cfg->keep = cfg->welch.getInputSize(segments);
+        cfg->nzSize = cfg->size;
+        cfg->skip = fftInterval - cfg->keep;
+    }
 
-    // Update window
-    dsp::buffer::free(fftWindowBuf);
-    fftWindowBuf = dsp::buffer::alloc<float>(_nzFFTSize);
-    if (_fftWindow == FFTWindow::RECTANGULAR) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = 1.0f * ((i % 2) ? -1.0f : 1.0f); }
+    // Take the window from the session snapshot when it is the same, generate it otherwise
+    cfg->windowType = req.window;
+    if (restoredWindow && restoredWindowType == req.window && restoredWindowSize == cfg->nzSize) {
+        cfg->window = restoredWindow;
+        restoredWindow = NULL;
     }
-    else if (_fftWindow == FFTWindow::BLACKMAN) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::blackman(i, _nzFFTSize) * ((i % 2) ? -1.0f : 1.0f); }
+    else {
+        cfg->window = dsp::buffer::alloc<float>(cfg->nzSize);
+        for (int i = 0; i < cfg->nzSize; i++) {
+            float w = 1.0f;
+            if (req.window == FFTWindow::BLACKMAN) { w = dsp::window::blackman(i, cfg->nzSize); }
+            else if (req.window == FFTWindow::NUTTALL) { w = dsp::window::nuttall(i, cfg->nzSize); }
+            cfg->window[i] = w * ((i % 2) ? -1.0f : 1.0f);
+        }
     }
-    else if (_fftWindow == FFTWindow::NUTTALL) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize) * ((i % 2) ? -1.0f : 1.0f); }
+
+    // Plan the FFT, the rest of its input is zero padding
+    cfg->in = (fftwf_complex*)fftwf_malloc(cfg->size * sizeof(fftwf_complex));
+    cfg->out = (fftwf_complex*)fftwf_malloc(cfg->size * sizeof(fftwf_complex));
+    cfg->plan.create(cfg->size, cfg->in, cfg->out, FFTW_FORWARD);
+    dsp::buffer::clear(cfg->in, cfg->size - cfg->nzSize, cfg->nzSize);
+
+    return cfg;
+}
+
+void IQFrontEnd::applyFFTConfig(FFTConfig* config, bool updateWaterfall) {
+    FFTConfig* old;
+    {
+        std::lock_guard<std::mutex> lck(fftMtx);
+        old = fftConfig;
+        fftConfig = config;
+
+        // Offload the frames if the other implementation can do this size
+        offloadActive = !config->welchActive && _offloadConfigure && _offloadConfigure(config->size, config->window, config->nzSize, _offloadCtx);
+
+        // Update waterfall, the handler can't be using its buffers meanwhile (TODO: This is annoying, it makes this module non testable and will constantly clear the waterfall for any reason)
+        if (updateWaterfall && !secondary) { gui::waterfall.setRawFFTSize(config->size); }
     }
 
-    // Update FFT plan
-    fftwf_free(fftInBuf);
-    fftwf_free(fftOutBuf);
-    fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    // Cut the frames of the new configuration, the frames of the old one are dropped by the handler
+    reshape.setFrame(config->keep, config->skip);
+    delete old;
+}
 
-    // Clear the rest of the FFT input buffer
-    dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
+void IQFrontEnd::fftWorker() {
+    std::unique_lock<std::mutex> lck(fftReqMtx);
+    while (true) {
+        fftReqCV.wait(lck, [this]() { return fftReqPending || fftReqStop; });
+        if (fftReqStop) { return; }
+        FFTRequest req = fftReq;
+        bool updateWaterfall = fftReqWaterfall;
+        fftReqPending = false;
+        fftReqWaterfall = false;
+        lck.unlock();
+
+        // Planning and generating the window of large sizes takes a while, the old spectrum keeps flowing meanwhile
+        FFTConfig* cfg = prepareFFTConfig(req);
+        applyFFTConfig(cfg, updateWaterfall);
+
+        lck.lock();
+    }
+}
 
-    // Update waterfall (TODO: This is annoying, it makes this module non testable and will constantly clear the waterfall for any reason)
-    if (updateWaterfall) { gui::waterfall.setRawFFTSize(_fftSize); }
+std::vector<uint8_t> IQFrontEnd::saveSnapshot() {
+    session_snapshot::Writer w;
+    std::lock_guard<std::mutex> lck(fftMtx);
+    if (!fftConfig) { return w.data; }
+    w.put<int32_t>(fftConfig->windowType);
+    w.put<int32_t>(fftConfig->nzSize);
+    w.putRaw(fftConfig->window, fftConfig->nzSize * sizeof(float));
+    return w.data;
+}
 
-    // Restart branch
-    reshape.tempStart();
-    fftSink.tempStart();
-}
\ No newline at end of file
+void IQFrontEnd::restoreSnapshot(const std::vector<uint8_t>& data) {
+    session_snapshot::Reader r(data);
+    int32_t type, size;
+    if (!r.get(type) || !r.get(size) || type < RECTANGULAR || type > NUTTALL || size <= 0 || size * sizeof(float) != r.remaining()) { return; }
+    dsp::buffer::free(restoredWindow);
+    restoredWindowType = (FFTWindow)type;
+    restoredWindowSize = size;
+    restoredWindow = dsp::buffer::alloc<float>(size);
+    r.getRaw(restoredWindow, size * sizeof(float));
+}
@@ -2,13 +2,33 @@
 #include "../dsp/buffer/frame_buffer.h"
 #include "../dsp/buffer/reshaper.h"
 #include "../dsp/multirate/power_decimator.h"
-#include "../dsp/correction/dc_blocker.h"
+#include "../dsp/multirate/s16_power_decimator.h"
 #include "../dsp/chain.h"
 #include "../dsp/routing/splitter.h"
 #include "../dsp/channel/rx_vfo.h"
+#include "../dsp/channel/vfo_group.h"
+#include "../dsp/channel/frequency_xlator.h"
+#include "../dsp/channel/channelizer.h"
 #include "../dsp/sink/handler_sink.h"
-#include "../dsp/math/conjugate.h"
-#include <fftw3.h>
+#include "../dsp/fft/plan.h"
+#include "../dsp/fft/welch.h"
+#include <thread>
+#include <condition_variable>
+
+// Number of channels the channelizer is configured with until enabled
+#define IQFRONTEND_DEFAULT_CHANNELS     64
+
+// Maximum number of threads used to average large FFTs
+#define IQFRONTEND_WELCH_MAX_THREADS    4
+
+// Fraction of the band kept by the automatic decimation that the VFOs fill when it's picked, leaving them room to move
+// before it must be picked again
+#define IQFRONTEND_AUTO_DECIM_FILL      0.5
+
+// Bins converted on each side of the visible part of the spectrum when only converting that part, as a fraction of it
+#define IQFRONTEND_VISIBLE_MARGIN       0.125
+
+class SpectrumStats;
 
 class IQFrontEnd {
 public:
@@ -22,35 +42,163 @@ public:
 
     void init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow, float* (*acquireFFTBuffer)(void* ctx), void (*releaseFFTBuffer)(void* ctx), void* fftCtx);
 
+    // Use other spectrum statistics than the main ones and never resize the waterfall, for the front ends of additional
+    // receivers (see SignalPath). Must be called before init()
+    void setSecondary(SpectrumStats* stats);
+
     void setInput(dsp::stream<dsp::complex_t>* in);
+
+    // Take 16 bit IQ instead, whose full scale is given by scale. It is buffered and decimated as integers, only being
+    // converted to float by the first stage of decimation. Setting a complex input goes back to the float path
+    void setInput(dsp::stream<dsp::complex_s16_t>* in, float scale = 32768.0f);
     void setSampleRate(double sampleRate);
     inline double getSampleRate() { return _sampleRate / _decimRatio; }
+    inline double getInputSampleRate() { return _sampleRate; }
 
     void setBuffering(bool enabled);
     void setDecimation(int ratio);
+
+    // Threads the decimators running at the samplerate of the source split their stages over, for sources too
+    // fast for a single core, see dsp::multirate::PowerDecimator::setThreads()
+    void setDecimationThreads(int threads);
     void setInvertIQ(bool enabled);
     void setDCBlocking(bool enabled);
+    void setChannelizer(int channels);
+
+    // Process the VFOs fed the full or the decimated band from a single thread, a chunk of the band at a time being
+    // processed by all of them while it's in cache, see dsp::channel::VFOGroup. Saves memory bandwidth with many VFOs
+    // on a wide band, at the cost of running them on a single core. Doesn't affect the VFOs using the channelizer
+    void setVFOGrouping(bool enabled);
+
+    // Run the VFOs that would have a thread each as tasks on a pool of as many threads as there are cores instead,
+    // see dsp::Scheduler. Cuts the number of threads and context switches with many VFOs. Grouped VFOs keep running
+    // from their group
+    void setVFOScheduler(bool enabled);
 
-    void bindIQStream(dsp::stream<dsp::complex_t>* stream);
+    // Decimate the band for the VFOs to the smallest part of it that holds them all, centered on them. The spectrum is
+    // still computed on the whole band. Ignored while the channelizer is enabled
+    void setAutoDecimation(bool enabled);
+
+    // Decimation and center offset of the band the VFOs are fed, 1 and 0 when it's the whole band
+    inline int getAutoDecimation() { return autoActive() ? autoRatio : 1; }
+    inline double getAutoShift() { return autoActive() ? autoShift : 0.0; }
+
+    // Have the source decimate the band for the VFOs instead, such as a server that can stream part of its band. The
+    // part the VFOs need is picked the same way, handler being called with its decimation, at most maxRatio, and the
+    // offset of its center whenever it changes. The input must then only hold that part of the band, so the spectrum
+    // has to come from the source too, and the IQ streams get that part as well. Takes precedence over the automatic
+    // decimation and the channelizer while set, NULL going back to the whole band
+    void setRemoteDecimation(void (*handler)(int ratio, double shift, void* ctx), int maxRatio, void* ctx);
+
+    // Consumers that can afford to lose samples should pick a policy that drops, so that they never hold up the VFOs
+    void bindIQStream(dsp::stream<dsp::complex_t>* stream, dsp::routing::Backpressure policy = dsp::routing::BACKPRESSURE_BLOCK);
     void unbindIQStream(dsp::stream<dsp::complex_t>* stream);
+    uint64_t getIQStreamDrops(dsp::stream<dsp::complex_t>* stream);
 
     dsp::channel::RxVFO* addVFO(std::string name, double sampleRate, double bandwidth, double offset);
     void removeVFO(std::string name);
 
+    // Tune and resample the VFOs through these instead of the VFO itself, so that the decimated band follows them
+    void setVFOOffset(std::string name, double offset);
+    void setVFOSampleRate(std::string name, double sampleRate, double bandwidth);
+
     void setFFTSize(int size);
     void setFFTRate(double rate);
     void setFFTWindow(FFTWindow fftWindow);
+    void setFFTAveraging(bool enabled);
+    void setFFTOverlap(double overlap);
+    inline int getFFTSize() { return _fftSize; }
+    inline double getFFTRate() { return _fftRate; }
+
+    // Convert the spectra to dB with a polynomial approximation of the log, within 0.002dB of the exact one
+    void setFFTFastLog(bool enabled);
+
+    // Only convert the bins shown by the waterfall, the others keeping their last level. Whatever else reads the
+    // spectra, such as the spectrum statistics, sees those bins frozen
+    void setFFTVisibleOnly(bool enabled);
+
+    // Stop computing spectra for the waterfall, for sources that provide their own
+    void setFFTEnabled(bool enabled);
+    inline bool isFFTEnabled() { return _fftEnabled; }
+
+    // Hand the frames over to another FFT implementation such as the GPU instead of transforming them here, NULL to go
+    // back to FFTW. configure is called with the FFT size and the window, which gives the number of samples of each
+    // frame, whenever they change. If it returns false or while averaging, frames are transformed on the CPU
+    void setFFTOffload(bool (*configure)(int fftSize, const float* window, int windowSize, void* ctx), bool (*submit)(const dsp::complex_t* frame, void* ctx), void* ctx);
+    inline bool isFFTOffloaded() { return offloadActive; }
 
     void flushInputBuffer();
 
+    // Section of the session snapshot holding the window of the FFT, so that the first configuration of the next
+    // session of the same window and size doesn't generate it again. Restoring must be done before init()
+    std::vector<uint8_t> saveSnapshot();
+    void restoreSnapshot(const std::vector<uint8_t>& data);
+
+    // Statistics of the input buffer currently in use
+    dsp::buffer::FrameBufferStats getInputBufferStats();
+
     void start();
     void stop();
 
     double getEffectiveSamplerate();
 
 protected:
+    // Everything the FFT handler works with for one configuration of the FFT
+    struct FFTConfig {
+        ~FFTConfig();
+
+        int size;
+        int nzSize;
+        int keep;   // Samples per frame given to the handler
+        int skip;
+        bool welchActive;
+        FFTWindow windowType;
+        float* window = NULL;
+        fftwf_complex* in = NULL;
+        fftwf_complex* out = NULL;
+        dsp::fft::Plan plan;
+        dsp::fft::Welch welch;
+    };
+
+    // Settings a configuration is prepared from
+    struct FFTRequest {
+        double sampleRate;
+        int size;
+        double rate;
+        FFTWindow window;
+        bool averaging;
+        double overlap;
+    };
+
     static void handler(dsp::complex_t* data, int count, void* ctx);
+    void convertSpectrum(FFTConfig* cfg, float* out);
+
+    // Have the FFT worker prepare a configuration for the current settings. The previous one keeps producing
+    // spectra until the new one is swapped in between two frames
     void updateFFTPath(bool updateWaterfall = false);
+    FFTConfig* prepareFFTConfig(const FFTRequest& req);
+    void applyFFTConfig(FFTConfig* config, bool updateWaterfall);
+    void fftWorker();
+
+    // Bind the input of a VFO to the channelizer, the decimated band or the full band and tune it within it
+    void bindVFO(const std::string& name);
+    void unbindVFO(const std::string& name);
+
+    inline bool remoteActive() { return _remoteDecim != NULL; }
+    inline bool channelized() { return _channels && !remoteActive(); }
+    inline bool autoEnabled() { return _autoDecim || remoteActive(); }
+    inline bool autoActive() { return autoEnabled() && !channelized(); }
+    void stopAutoPath();
+    void startAutoPath();
+    void planAutoDecimation(int& ratio, double& shift);
+    bool autoCoversVFOs();
+    bool updateAutoDecimation(bool replan);
+    void configureAutoChain();
+    void notifyRemoteDecimation();
+    void updateCorrection();
+
+    // The decimator of the chain also runs with a ratio of one when it has a correction to do
+    inline bool decimActive() { return !compact && (_decimRatio > 1 || _dcBlocking || _invertIQ); }
 
     static inline double genDCBlockRate(double sampleRate) {
         return 50.0 / sampleRate;
@@ -65,43 +213,109 @@ protected:
     // Input buffer
     dsp::buffer::SampleFrameBuffer<dsp::complex_t> inBuf;
 
+    // Compact input path, feeds the pre-processing chain with the decimator of the chain disabled when in use
+    dsp::stream<dsp::complex_s16_t> nullCompact;
+    dsp::buffer::SampleFrameBuffer<dsp::complex_s16_t> compactBuf;
+    dsp::multirate::S16PowerDecimator compactDecim;
+    bool compact = false;
+
     // Pre-processing chain
     dsp::multirate::PowerDecimator<dsp::complex_t> decim;
-    dsp::math::Conjugate conjugate;
-    dsp::correction::DCBlocker<dsp::complex_t> dcBlock;
+    bool _dcBlocking = false;
+    bool _invertIQ = false;
     dsp::chain<dsp::complex_t> preproc;
 
     // Splitting
     dsp::routing::Splitter<dsp::complex_t> split;
 
+    // Channelizer, VFOs narrow enough to fit in a channel process it instead of the full band
+    dsp::shared_stream<dsp::complex_t> chanIn;
+    dsp::channel::Channelizer channelizer;
+
+    // Automatic decimation, VFOs that aren't using the channelizer are fed the part of the band they're in
+    dsp::shared_stream<dsp::complex_t> autoIn;
+    dsp::channel::FrequencyXlator autoXlator;
+    dsp::multirate::PowerDecimator<dsp::complex_t> autoDecim;
+    dsp::chain<dsp::complex_t> autoChain;
+    dsp::routing::Splitter<dsp::complex_t> autoSplit;
+
+    // VFO groups of the full and the decimated band, their inputs are only bound while grouping is enabled
+    dsp::shared_stream<dsp::complex_t> groupIn;
+    dsp::channel::VFOGroup vfoGroup;
+    dsp::shared_stream<dsp::complex_t> autoGroupIn;
+    dsp::channel::VFOGroup autoVFOGroup;
+
     // FFT
-    dsp::stream<dsp::complex_t> fftIn;
+    dsp::shared_stream<dsp::complex_t> fftIn;
     dsp::buffer::Reshaper<dsp::complex_t> reshape;
     dsp::sink::Handler<dsp::complex_t> fftSink;
 
     // VFOs
+    struct VFOSpan {
+        double offset;
+        double sampleRate;
+    };
     std::map<std::string, dsp::stream<dsp::complex_t>*> vfoStreams;
     std::map<std::string, dsp::channel::RxVFO*> vfos;
+    std::map<std::string, VFOSpan> vfoSpans;
+    std::recursive_mutex vfoMtx;
 
     // Parameters
     double _sampleRate;
     double _decimRatio;
+    int _channels = 0;
+    bool _autoDecim = false;
+    bool _vfoGrouping = false;
+    dsp::Scheduler* vfoScheduler = NULL;
+    int autoRatio = 1;
+    double autoShift = 0.0;
+    void (*_remoteDecim)(int ratio, double shift, void* ctx) = NULL;
+    void* _remoteCtx = NULL;
+    int remoteMaxRatio = 1;
     int _fftSize;
     double _fftRate;
     FFTWindow _fftWindow;
+    bool _fftAveraging = false;
+    double _fftOverlap = 0.5;
+    bool _fftEnabled = true;
+    bool _fftFastLog = false;
+    bool _fftVisibleOnly = false;
     float* (*_acquireFFTBuffer)(void* ctx);
     void (*_releaseFFTBuffer)(void* ctx);
     void* _fftCtx;
+    SpectrumStats* stats = NULL;
+    bool secondary = false;
+    bool (*_offloadConfigure)(int fftSize, const float* window, int windowSize, void* ctx) = NULL;
+    bool (*_offloadSubmit)(const dsp::complex_t* frame, void* ctx) = NULL;
+    void* _offloadCtx = NULL;
+    bool offloadActive = false;
+
+    // Processing data, fftMtx is held by the handler while it processes a frame
+    FFTConfig* fftConfig = NULL;
+    std::mutex fftMtx;
 
-    // Processing data
-    int _nzFFTSize;
-    float* fftWindowBuf;
-    fftwf_complex *fftInBuf, *fftOutBuf;
-    fftwf_plan fftwPlan;
-    float* fftDbOut;
+    // Bins converted by the last spectra and how many more spectra get all of their bins converted, so that every
+    // buffer of the waterfall holds a level for the bins that went out of view
+    int convFirst = 0;
+    int convCount = 0;
+    int convFullLeft = 0;
+
+    // Requests to the FFT worker, only the latest one is prepared
+    std::thread fftThread;
+    std::mutex fftReqMtx;
+    std::condition_variable fftReqCV;
+    FFTRequest fftReq;
+    bool fftReqPending = false;
+    bool fftReqWaterfall = false;
+    bool fftReqStop = false;
 
     double effectiveSr;
 
+    // Window from the session snapshot, handed to the first configuration if it has the same type and size
+    FFTWindow restoredWindowType = NUTTALL;
+    int restoredWindowSize = 0;
+    float* restoredWindow = NULL;
+
     bool _init = false;
 
 };
\ No newline at end of file
@@ -1,8 +1,83 @@
 #include <signal_path/signal_path.h>
+#include <core.h>
+#include <utils/flog.h>
+#include <map>
 
 namespace sigpath {
     IQFrontEnd iqFrontEnd;
     VFOManager vfoManager;
     SourceManager sourceManager;
     SinkManager sinkManager;
-};
\ No newline at end of file
+    StreamClock streamClock;
+    SpectrumStats spectrumStats;
+    Sweeper sweeper;
+
+    SignalPath mainPath;
+    std::map<std::string, std::unique_ptr<SignalPath>> paths;
+};
+
+// Additional receivers compute no spectrum
+static float* acquireNoFFTBuffer(void* ctx) { return NULL; }
+static void releaseNoFFTBuffer(void* ctx) {}
+
+SignalPath::SignalPath() :
+    name("Main"),
+    sourceManager(sigpath::sourceManager),
+    iqFrontEnd(sigpath::iqFrontEnd),
+    vfoManager(sigpath::vfoManager),
+    spectrumStats(sigpath::spectrumStats) {}
+
+SignalPath::SignalPath(std::string name) :
+    name(name),
+    ownedSourceManager(std::make_unique<SourceManager>()),
+    ownedIQFrontEnd(std::make_unique<IQFrontEnd>()),
+    ownedVFOManager(std::make_unique<VFOManager>()),
+    ownedSpectrumStats(std::make_unique<SpectrumStats>()),
+    sourceManager(*ownedSourceManager),
+    iqFrontEnd(*ownedIQFrontEnd),
+    vfoManager(*ownedVFOManager),
+    spectrumStats(*ownedSpectrumStats) {
+    sourceManager.setFrontEnd(&iqFrontEnd);
+    vfoManager.setFrontEnd(&iqFrontEnd, NULL);
+    iqFrontEnd.setSecondary(&spectrumStats);
+    iqFrontEnd.init(&nullStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, acquireNoFFTBuffer, releaseNoFFTBuffer, NULL);
+    iqFrontEnd.setFFTEnabled(false);
+    iqFrontEnd.start();
+}
+
+SignalPath::~SignalPath() {
+    if (ownedIQFrontEnd) { iqFrontEnd.stop(); }
+}
+
+namespace sigpath {
+    SignalPath* getPath(std::string name) {
+        if (name.empty() || name == mainPath.name) { return &mainPath; }
+        auto it = paths.find(name);
+        return (it != paths.end()) ? it->second.get() : NULL;
+    }
+
+    std::vector<std::string> getPathNames() {
+        std::vector<std::string> names = { mainPath.name };
+        for (auto const& [name, path] : paths) { names.push_back(name); }
+        return names;
+    }
+
+    void createPaths() {
+        core::configManager.acquire();
+        std::vector<std::string> names = core::configManager.conf["signalPaths"];
+        core::configManager.release();
+
+        for (auto const& name : names) {
+            if (getPath(name)) {
+                flog::error("Signal path '{0}' already exists", name);
+                continue;
+            }
+            flog::info("Creating signal path '{0}'", name);
+            paths[name] = std::make_unique<SignalPath>(name);
+        }
+    }
+
+    void destroyPaths() {
+        paths.clear();
+    }
+};
@@ -3,11 +3,59 @@
 #include "vfo_manager.h"
 #include "source.h"
 #include "sink.h"
+#include "stream_clock.h"
+#include "spectrum_stats.h"
+#include "sweep.h"
 #include <module.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Sources, front end, VFOs and spectrum statistics of one receiver. The main one wraps the global components that the
+// GUI and existing modules use, additional ones are listed in the "signalPaths" config and own theirs. A source module
+// feeds an additional receiver by registering with its sourceManager and setting the samplerate on its iqFrontEnd,
+// demodulators get a VFO from its vfoManager. Additional receivers have no spectrum or waterfall
+class SignalPath {
+public:
+    // Main receiver
+    SignalPath();
+
+    // Additional receiver, started right away
+    SignalPath(std::string name);
+
+    ~SignalPath();
+
+    std::string name;
+
+private:
+    std::unique_ptr<SourceManager> ownedSourceManager;
+    std::unique_ptr<IQFrontEnd> ownedIQFrontEnd;
+    std::unique_ptr<VFOManager> ownedVFOManager;
+    std::unique_ptr<SpectrumStats> ownedSpectrumStats;
+    dsp::stream<dsp::complex_t> nullStream;
+
+public:
+    SourceManager& sourceManager;
+    IQFrontEnd& iqFrontEnd;
+    VFOManager& vfoManager;
+    SpectrumStats& spectrumStats;
+};
 
 namespace sigpath {
     SDRPP_EXPORT IQFrontEnd iqFrontEnd;
     SDRPP_EXPORT VFOManager vfoManager;
     SDRPP_EXPORT SourceManager sourceManager;
     SDRPP_EXPORT SinkManager sinkManager;
-};
\ No newline at end of file
+    SDRPP_EXPORT StreamClock streamClock;
+    SDRPP_EXPORT SpectrumStats spectrumStats;
+    SDRPP_EXPORT Sweeper sweeper;
+
+    // Receiver of the given name, "" or "Main" being the main one. Returns NULL if it doesn't exist
+    SignalPath* getPath(std::string name);
+    std::vector<std::string> getPathNames();
+
+    // Create the additional receivers listed in the config, before modules are loaded, and destroy them after the
+    // modules were ended
+    void createPaths();
+    void destroyPaths();
+};
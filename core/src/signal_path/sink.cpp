@@ -5,6 +5,7 @@
 #include <gui/icons.h>
 
 #include <core.h>
+#include <signal_path/signal_path.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -26,6 +27,7 @@ void SinkManager::Stream::init(dsp::stream<dsp::stereo_t>* in, EventHandler<floa
     splitter.bindStream(&volumeInput);
     volumeAjust.init(&volumeInput, 1.0f, false);
     sinkOut = &volumeAjust.out;
+    sinkOut->setLatencyProbe(&latency);
 }
 
 void SinkManager::Stream::start() {
@@ -71,12 +73,35 @@ void SinkManager::Stream::setInput(dsp::stream<dsp::stereo_t>* in) {
 dsp::stream<dsp::stereo_t>* SinkManager::Stream::bindStream() {
     dsp::stream<dsp::stereo_t>* stream = new dsp::stream<dsp::stereo_t>;
     splitter.bindStream(stream);
+    boundStreams++;
+    updateConsumed();
     return stream;
 }
 
 void SinkManager::Stream::unbindStream(dsp::stream<dsp::stereo_t>* stream) {
     splitter.unbindStream(stream);
     delete stream;
+    boundStreams--;
+    updateConsumed();
+}
+
+bool SinkManager::Stream::isConsumed() {
+    return consumed;
+}
+
+dsp::LatencyStats SinkManager::Stream::getLatency() {
+    return latency.getStats();
+}
+
+double SinkManager::Stream::getSinkLatency() {
+    return sink ? sink->getLatency() : 0.0;
+}
+
+void SinkManager::Stream::updateConsumed() {
+    bool newConsumed = (providerName != "None") || boundStreams > 0;
+    if (newConsumed == consumed) { return; }
+    consumed = newConsumed;
+    onConsumedChange.emit(consumed);
 }
 
 void SinkManager::Stream::setSampleRate(float sampleRate) {
@@ -151,6 +176,7 @@ void SinkManager::registerStream(std::string name, SinkManager::Stream* stream)
 
     streams[name] = stream;
     streamNames.push_back(name);
+    stream->latency.setName("audio stream " + name);
 
     // Load config
     core::configManager.acquire();
@@ -226,6 +252,12 @@ void SinkManager::setStreamSink(std::string name, std::string providerName) {
         return;
     }
 
+    // In offline mode nothing may pace the DSP to real time, audio is discarded
+    if (core::args["offline"].b() && providerName != "None") {
+        flog::info("Offline mode, stream '{0}' sent to no sink instead of '{1}'", name, providerName);
+        providerName = "None";
+    }
+
     if (stream->running) {
         stream->sink->stop();
     }
@@ -237,6 +269,7 @@ void SinkManager::setStreamSink(std::string name, std::string providerName) {
     if (stream->running) {
         stream->sink->start();
     }
+    stream->updateConsumed();
 }
 
 void SinkManager::showVolumeSlider(std::string name, std::string prefix, float width, float btnHeight, int btnBorder, bool sameLine) {
@@ -366,6 +399,23 @@ void SinkManager::showMenu() {
 
         stream->sink->menuHandler();
 
+        // Latency of the first sample of each buffer, from the source to the output of the device
+        dsp::LatencyStats lat = stream->getLatency();
+        if (lat.valid) {
+            double sinkLatency = stream->getSinkLatency();
+            ImGui::Text("Latency: %.0f ms (avg %.0f, max %.0f)", (lat.current + sinkLatency) * 1e3, (lat.average + sinkLatency) * 1e3, (lat.max + sinkLatency) * 1e3);
+            if (ImGui::IsItemHovered()) {
+                ImGui::BeginTooltip();
+                dsp::LatencyStats vfoLat = sigpath::vfoManager.getLatency(name);
+                if (vfoLat.valid) {
+                    ImGui::Text("Source to VFO: %.1f ms (avg %.1f, max %.1f)", vfoLat.current * 1e3, vfoLat.average * 1e3, vfoLat.max * 1e3);
+                }
+                ImGui::Text("Source to sink: %.1f ms (avg %.1f, max %.1f)", lat.current * 1e3, lat.average * 1e3, lat.max * 1e3);
+                ImGui::Text("Buffered by the sink: %.1f ms", sinkLatency * 1e3);
+                ImGui::EndTooltip();
+            }
+        }
+
         showVolumeSlider(name, "##_sdrpp_sink_menu_vol_", menuWidth);
 
         count++;
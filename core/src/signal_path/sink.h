@@ -20,6 +20,9 @@ public:
         virtual void start() = 0;
         virtual void stop() = 0;
         virtual void menuHandler() = 0;
+
+        // Seconds of audio buffered between the input of the sink and the output of the device, 0 if unknown
+        virtual double getLatency() { return 0.0; }
     };
 
     class Stream {
@@ -43,6 +46,13 @@ public:
         dsp::stream<dsp::stereo_t>* bindStream();
         void unbindStream(dsp::stream<dsp::stereo_t>* stream);
 
+        // Whether the audio goes anywhere, ie. to a sink other than "None" or to a bound stream
+        bool isConsumed();
+
+        // Latency from the source to the input of the sink, and the latency added by the sink itself in seconds
+        dsp::LatencyStats getLatency();
+        double getSinkLatency();
+
         friend SinkManager;
         friend SinkManager::Sink;
 
@@ -50,17 +60,25 @@ public:
 
         Event<float> srChange;
 
+        // Emitted with isConsumed() whenever it changes, so that the producer can stop working for nothing
+        Event<bool> onConsumedChange;
+
     private:
+        void updateConsumed();
+
         dsp::stream<dsp::stereo_t>* _in;
         dsp::routing::Splitter<dsp::stereo_t> splitter;
         SinkManager::Sink* sink;
         dsp::stream<dsp::stereo_t> volumeInput;
         dsp::audio::Volume volumeAjust;
+        dsp::LatencyProbe latency;
         std::mutex ctrlMtx;
         float _sampleRate;
         int providerId = 0;
         std::string providerName = "";
         bool running = false;
+        int boundStreams = 0;
+        bool consumed = false;
 
         float guiVolume = 1.0f;
     };
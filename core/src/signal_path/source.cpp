@@ -3,8 +3,41 @@
 #include <utils/flog.h>
 #include <signal_path/signal_path.h>
 #include <core.h>
+#include <chrono>
+#include <algorithm>
+
+void SourceStats::overflow(uint64_t count) {
+    overflows += count;
+    lastGapTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void SourceStats::discontinuity(uint64_t count) {
+    discontinuities += count;
+    lastGapTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void SourceStats::reset() {
+    samples = 0;
+    overflows = 0;
+    discontinuities = 0;
+    lastGapTime = 0.0;
+}
+
+SourceStats::Values SourceStats::get() {
+    Values values;
+    values.samples = samples;
+    values.overflows = overflows;
+    values.discontinuities = discontinuities;
+    values.lastGapTime = lastGapTime;
+    return values;
+}
 
 SourceManager::SourceManager() {
+    frontEnd = &sigpath::iqFrontEnd;
+}
+
+void SourceManager::setFrontEnd(IQFrontEnd* frontEnd) {
+    this->frontEnd = frontEnd;
 }
 
 void SourceManager::registerSource(std::string name, SourceHandler* handler) {
@@ -22,13 +55,15 @@ void SourceManager::unregisterSource(std::string name) {
         return;
     }
     onSourceUnregister.emit(name);
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
     if (name == selectedName) {
         if (selectedHandler != NULL) {
             sources[selectedName]->deselectHandler(sources[selectedName]->ctx);
         }
-        sigpath::iqFrontEnd.setInput(&nullSource);
+        frontEnd->setInput(&nullSource);
         selectedHandler = NULL;
     }
+    if (sources[name] == sweepingHandler) { sweepingHandler = NULL; }
     sources.erase(name);
     onSourceUnregistered.emit(name);
 }
@@ -39,11 +74,32 @@ std::vector<std::string> SourceManager::getSourceNames() {
     return names;
 }
 
+SourceManager::SourceHandler* SourceManager::getSource(const std::string& name) {
+    auto it = sources.find(name);
+    return (it != sources.end()) ? it->second : NULL;
+}
+
+void SourceManager::beginSampleRateCapture(double* target) {
+    captureThread = std::this_thread::get_id();
+    captureTarget = target;
+}
+
+void SourceManager::endSampleRateCapture() {
+    captureTarget = NULL;
+}
+
+bool SourceManager::captureSampleRate(double samplerate) {
+    if (!captureTarget || std::this_thread::get_id() != captureThread) { return false; }
+    *captureTarget = samplerate;
+    return true;
+}
+
 void SourceManager::selectSource(std::string name) {
     if (sources.find(name) == sources.end()) {
         flog::error("Tried to select non existent source: {0}", name);
         return;
     }
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
     if (selectedHandler != NULL) {
         sources[selectedName]->deselectHandler(sources[selectedName]->ctx);
     }
@@ -53,27 +109,44 @@ void SourceManager::selectSource(std::string name) {
     if (core::args["server"].b()) {
         server::setInput(selectedHandler->stream);
     }
+    else if (selectedHandler->compactStream) {
+        frontEnd->setInput(selectedHandler->compactStream, selectedHandler->compactScale);
+    }
     else {
-        sigpath::iqFrontEnd.setInput(selectedHandler->stream);
+        frontEnd->setInput(selectedHandler->stream);
     }
     // Set server input here
 }
 
 void SourceManager::showSelectedMenu() {
+    // The menu of most sources talks to the hardware, which mustn't be retuned meanwhile
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
     if (selectedHandler == NULL) {
         return;
     }
     selectedHandler->menuHandler(selectedHandler->ctx);
 }
 
+bool SourceManager::getStats(SourceStats::Values& values) {
+    if (selectedHandler == NULL || selectedHandler->stats == NULL) {
+        values = SourceStats::Values();
+        return false;
+    }
+    values = selectedHandler->stats->get();
+    return true;
+}
+
 void SourceManager::start() {
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
     if (selectedHandler == NULL) {
         return;
     }
+    if (selectedHandler->stats) { selectedHandler->stats->reset(); }
     selectedHandler->startHandler(selectedHandler->ctx);
 }
 
 void SourceManager::stop() {
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
     if (selectedHandler == NULL) {
         return;
     }
@@ -85,11 +158,112 @@ void SourceManager::tune(double freq) {
         return;
     }
     // TODO: No need to always retune the hardware in Panadapter mode
-    selectedHandler->tuneHandler(abs(((tuneMode == TuningMode::NORMAL) ? freq : ifFreq) + tuneOffset), selectedHandler->ctx);
+    double hwFreq = abs(((tuneMode == TuningMode::NORMAL) ? freq : ifFreq) + tuneOffset);
+    {
+        std::unique_lock<std::mutex> lck(tuneMtx);
+        tuneStats.requests++;
+        uint64_t seq = ++requestSeq;
+        if (asyncTuning) {
+            pendingFreq = hwFreq;
+            lck.unlock();
+            tuneCV.notify_one();
+        }
+        else {
+            takenSeq = seq;
+            lck.unlock();
+            applyTune(hwFreq, seq);
+        }
+    }
     onRetune.emit(freq);
     currentFreq = freq;
 }
 
+void SourceManager::applyTune(double freq, uint64_t seq) {
+    double settle = 0.0;
+    {
+        std::lock_guard<std::recursive_mutex> lck(handlerMtx);
+        if (selectedHandler != NULL) {
+            auto start = std::chrono::steady_clock::now();
+            selectedHandler->tuneHandler(freq, selectedHandler->ctx);
+            settle = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(tuneMtx);
+        tuneStats.applied++;
+        tuneStats.lastSettle = settle;
+        tuneStats.maxSettle = std::max<double>(tuneStats.maxSettle, settle);
+        appliedSeq = std::max<uint64_t>(appliedSeq, seq);
+    }
+    tunedCV.notify_all();
+}
+
+void SourceManager::tuneWorker() {
+    std::unique_lock<std::mutex> lck(tuneMtx);
+    while (true) {
+        tuneCV.wait(lck, [this] { return takenSeq != requestSeq || stopTuning; });
+
+        // The pending request is applied before stopping
+        if (takenSeq == requestSeq) { return; }
+
+        // Only the latest request matters, those before it were never applied
+        double freq = pendingFreq;
+        uint64_t seq = requestSeq;
+        takenSeq = seq;
+        lck.unlock();
+        applyTune(freq, seq);
+        lck.lock();
+    }
+}
+
+void SourceManager::setAsyncTuning(bool enabled) {
+    std::unique_lock<std::mutex> lck(tuneMtx);
+    if (enabled == asyncTuning) { return; }
+    asyncTuning = enabled;
+    if (enabled) {
+        stopTuning = false;
+        tuneThread = new std::thread(&SourceManager::tuneWorker, this);
+        return;
+    }
+    stopTuning = true;
+    lck.unlock();
+    tuneCV.notify_all();
+    tuneThread->join();
+    delete tuneThread;
+    tuneThread = NULL;
+}
+
+double SourceManager::getTunedFrequency() {
+    return currentFreq;
+}
+
+bool SourceManager::waitTuned(double timeout) {
+    std::unique_lock<std::mutex> lck(tuneMtx);
+    uint64_t target = requestSeq;
+    return tunedCV.wait_for(lck, std::chrono::duration<double>(timeout), [&] { return appliedSeq >= target; });
+}
+
+SourceManager::TuneStats SourceManager::getTuneStats() {
+    std::lock_guard<std::mutex> lck(tuneMtx);
+    return tuneStats;
+}
+
+bool SourceManager::startSweep(double startFreq, double stopFreq, int fftSize) {
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
+    if (selectedHandler == NULL || selectedHandler->sweepHandler == NULL) { return false; }
+    if (!selectedHandler->sweepHandler(true, startFreq, stopFreq, fftSize, selectedHandler->ctx)) { return false; }
+    sweepingHandler = selectedHandler;
+    return true;
+}
+
+void SourceManager::stopSweep() {
+    std::lock_guard<std::recursive_mutex> lck(handlerMtx);
+    if (sweepingHandler == NULL) { return; }
+    sweepingHandler->sweepHandler(false, 0.0, 0.0, 0, sweepingHandler->ctx);
+    sweepingHandler = NULL;
+}
+
 void SourceManager::setTuningOffset(double offset) {
     tuneOffset = offset;
     tune(currentFreq);
@@ -2,14 +2,46 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <dsp/stream.h>
 #include <dsp/types.h>
 #include <utils/event.h>
 
+// Sample accounting of a source. The counters can be updated from the driver threads
+class SourceStats {
+public:
+    struct Values {
+        uint64_t samples = 0;           // Samples delivered to the DSP
+        uint64_t overflows = 0;         // Buffers or samples dropped because the host didn't keep up
+        uint64_t discontinuities = 0;   // Gaps in the sample stream reported by the hardware or the transport
+        double lastGapTime = 0.0;       // Unix time of the last overflow or discontinuity, 0 if none
+    };
+
+    void delivered(uint64_t count) { samples += count; }
+    void overflow(uint64_t count = 1);
+    void discontinuity(uint64_t count = 1);
+    void reset();
+    Values get();
+
+private:
+    std::atomic<uint64_t> samples = 0;
+    std::atomic<uint64_t> overflows = 0;
+    std::atomic<uint64_t> discontinuities = 0;
+    std::atomic<double> lastGapTime = 0.0;
+};
+
+class IQFrontEnd;
+
 class SourceManager {
 public:
     SourceManager();
 
+    // Front end the selected source feeds, the main one unless set. Must be called before selecting a source
+    void setFrontEnd(IQFrontEnd* frontEnd);
+
     struct SourceHandler {
         dsp::stream<dsp::complex_t>* stream;
         void (*menuHandler)(void* ctx);
@@ -19,6 +51,22 @@ public:
         void (*stopHandler)(void* ctx);
         void (*tuneHandler)(double freq, void* ctx);
         void* ctx;
+
+        // Optional, filled in by the source and reset when it is started
+        SourceStats* stats = NULL;
+
+        // Optional, sources producing 16 bit IQ can write it here instead of converting it into stream. The IQ
+        // front end then only converts it after the first stage of decimation, halving the memory traffic at the
+        // full rate. compactScale is the value corresponding to 1.0. Not supported in server mode, where it must
+        // be left NULL
+        dsp::stream<dsp::complex_s16_t>* compactStream = NULL;
+        float compactScale = 32768.0f;
+
+        // Optional, sources able to sweep a band in hardware faster than they are retuned. Called with enabled set
+        // to start sweeping from startFreq to stopFreq, the source then pushing its hops of at least fftSize samples
+        // to sigpath::sweeper instead of writing to stream, and with enabled cleared to go back to streaming. Returns
+        // false if the source can't sweep this band, the core then hopping it in software
+        bool (*sweepHandler)(bool enabled, double startFreq, double stopFreq, int fftSize, void* ctx) = NULL;
     };
 
     enum TuningMode {
@@ -33,24 +81,89 @@ public:
     void start();
     void stop();
     void tune(double freq);
+
+    // Frequency of the last tune(), before the tuning offset is applied
+    double getTunedFrequency();
+
+    // When enabled, tune() only queues the frequency and returns, a thread retuning the hardware to the latest one
+    // queued. The requests made while the hardware is being retuned are coalesced, so that dragging the waterfall
+    // doesn't issue a retune per frame. Disabling applies the pending request first
+    void setAsyncTuning(bool enabled);
+
+    // Wait for the hardware to be retuned for every tune() made before the call, for at most timeout seconds.
+    // Returns false if it wasn't in time
+    bool waitTuned(double timeout);
+
+    struct TuneStats {
+        uint64_t requests = 0;      // Calls to tune()
+        uint64_t applied = 0;       // Retunes of the hardware, fewer than the requests when they were coalesced
+        double lastSettle = 0.0;    // Time the tune handler of the source took for the last retune, in seconds
+        double maxSettle = 0.0;
+    };
+
+    TuneStats getTuneStats();
+
+    // Have the selected source sweep in hardware, see SourceHandler::sweepHandler. Returns false if it can't
+    bool startSweep(double startFreq, double stopFreq, int fftSize);
+    void stopSweep();
+
     void setTuningOffset(double offset);
     void setTuningMode(TuningMode mode);
     void setPanadapterIF(double freq);
 
+    // Sample accounting of the selected source, returns false if it doesn't keep any
+    bool getStats(SourceStats::Values& values);
+
     std::vector<std::string> getSourceNames();
 
+    // Handler of a registered source, NULL if it doesn't exist. Used by sources that drive other sources (see aggregate_source)
+    SourceHandler* getSource(const std::string& name);
+
+    // While capturing, the samplerates set by the calling thread through core::setInputSampleRate() are stored
+    // in target instead of being applied. This lets a source call the handlers of the sources it drives
+    void beginSampleRateCapture(double* target);
+    void endSampleRateCapture();
+
+    // Returns true and stores the samplerate if it is being captured
+    bool captureSampleRate(double samplerate);
+
     Event<std::string> onSourceRegistered;
     Event<std::string> onSourceUnregister;
     Event<std::string> onSourceUnregistered;
     Event<double> onRetune;
 
 private:
+    IQFrontEnd* frontEnd;
     std::map<std::string, SourceHandler*> sources;
     std::string selectedName;
     SourceHandler* selectedHandler = NULL;
     double tuneOffset;
-    double currentFreq;
+    double currentFreq = 0.0;
     double ifFreq = 0.0;
     TuningMode tuneMode = TuningMode::NORMAL;
     dsp::stream<dsp::complex_t> nullSource;
+
+    double* captureTarget = NULL;
+    std::thread::id captureThread;
+
+    void applyTune(double freq, uint64_t seq);
+    void tuneWorker();
+
+    // Held while calling the handlers of the selected source, so that the tuning thread never retunes a source
+    // being started, stopped or deselected
+    std::recursive_mutex handlerMtx;
+
+    std::mutex tuneMtx;
+    std::condition_variable tuneCV;
+    std::condition_variable tunedCV;
+    std::thread* tuneThread = NULL;
+    bool asyncTuning = false;
+    bool stopTuning = false;
+    double pendingFreq = 0.0;
+    uint64_t requestSeq = 0;        // Last request made
+    uint64_t takenSeq = 0;          // Last request handed to the hardware
+    uint64_t appliedSeq = 0;        // Last request the hardware was retuned for
+    TuneStats tuneStats;
+
+    SourceHandler* sweepingHandler = NULL;
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <signal_path/spectrum_stats.h>
+#include <volk/volk.h>
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+void SpectrumStats::process(const float* line, int size, double bandwidth) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (size <= 0) { return; }
+    if (size != bins || bandwidth != _bandwidth) {
+        resize(size);
+        _bandwidth = bandwidth;
+    }
+    memcpy(latest.data(), line, bins * sizeof(float));
+    totalLines++;
+    lineCnd.notify_all();
+
+    // Start over from this spectrum. The noise floor of every bin starts at the median level, so that bins already
+    // occupied don't take their signal for noise
+    if (resetPending) {
+        memcpy(floors.data(), line, bins * sizeof(float));
+        std::nth_element(floors.begin(), floors.begin() + (bins / 2), floors.end());
+        std::fill(floors.begin(), floors.end(), floors[bins / 2]);
+        memcpy(peaks.data(), line, bins * sizeof(float));
+        std::fill(occupied.begin(), occupied.end(), 0.0f);
+        lines = 1;
+        resetPending = false;
+        return;
+    }
+
+    // Peak hold
+    if (_peakDecay > 0.0f) { volk_32f_s32f_add_32f(peaks.data(), peaks.data(), -_peakDecay, bins); }
+    volk_32f_x2_max_32f(peaks.data(), peaks.data(), line, bins);
+
+    // The noise floor only follows bins that aren't occupied. Written without branches so that it gets vectorized
+    float* f = floors.data();
+    float* o = occupied.data();
+    float threshold = _threshold;
+    float speed = _floorSpeed;
+    for (int i = 0; i < bins; i++) {
+        float delta = line[i] - f[i];
+        float occ = (delta >= threshold) ? 1.0f : 0.0f;
+        f[i] += (1.0f - occ) * speed * delta;
+        o[i] += occ;
+    }
+    lines++;
+}
+
+void SpectrumStats::reset() {
+    std::lock_guard<std::mutex> lck(mtx);
+    lines = 0;
+    resetPending = true;
+}
+
+void SpectrumStats::resetPeaks() {
+    std::lock_guard<std::mutex> lck(mtx);
+    peaks = latest;
+}
+
+void SpectrumStats::setThreshold(float threshold) {
+    std::lock_guard<std::mutex> lck(mtx);
+    _threshold = threshold;
+}
+
+void SpectrumStats::setFloorSpeed(float speed) {
+    std::lock_guard<std::mutex> lck(mtx);
+    _floorSpeed = std::clamp<float>(speed, 0.0f, 1.0f);
+}
+
+void SpectrumStats::setPeakDecay(float decay) {
+    std::lock_guard<std::mutex> lck(mtx);
+    _peakDecay = std::max<float>(decay, 0.0f);
+}
+
+bool SpectrumStats::getChannelStats(double offset, double bandwidth, ChannelStats& stats) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (!lines || _bandwidth <= 0.0) { return false; }
+
+    // Bins covered by the channel
+    double binWidth = _bandwidth / (double)bins;
+    int first = std::max<int>(floor((offset - (bandwidth / 2.0) + (_bandwidth / 2.0)) / binWidth), 0);
+    int last = std::min<int>(floor((offset + (bandwidth / 2.0) + (_bandwidth / 2.0)) / binWidth), bins - 1);
+    if (first > last) { return false; }
+
+    stats.level = -INFINITY;
+    stats.peak = -INFINITY;
+    double floorSum = 0.0;
+    double occSum = 0.0;
+    for (int i = first; i <= last; i++) {
+        stats.level = std::max<float>(stats.level, latest[i]);
+        stats.peak = std::max<float>(stats.peak, peaks[i]);
+        floorSum += floors[i];
+        occSum += occupied[i];
+    }
+    int count = last - first + 1;
+    stats.noiseFloor = floorSum / (double)count;
+    stats.occupancy = occSum / ((double)count * (double)lines);
+    return true;
+}
+
+int SpectrumStats::getBins(float* noiseFloor, float* peak, float* occupancy, int maxCount) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (!lines) { return 0; }
+    int count = std::min<int>(bins, maxCount);
+    if (noiseFloor) { memcpy(noiseFloor, floors.data(), count * sizeof(float)); }
+    if (peak) { memcpy(peak, peaks.data(), count * sizeof(float)); }
+    if (occupancy) { volk_32f_s32f_multiply_32f(occupancy, occupied.data(), 1.0f / (float)lines, count); }
+    return count;
+}
+
+uint64_t SpectrumStats::getLineCount() {
+    std::lock_guard<std::mutex> lck(mtx);
+    return lines;
+}
+
+bool SpectrumStats::waitLine(uint64_t& seq, double timeout) {
+    std::unique_lock<std::mutex> lck(mtx);
+    bool got = lineCnd.wait_for(lck, std::chrono::duration<double>(timeout), [&] { return totalLines > seq; });
+    seq = totalLines;
+    return got;
+}
+
+void SpectrumStats::resize(int size) {
+    bins = size;
+    latest.resize(bins);
+    floors.resize(bins);
+    peaks.resize(bins);
+    occupied.resize(bins);
+    resetPending = true;
+}
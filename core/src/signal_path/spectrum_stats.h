@@ -0,0 +1,80 @@
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <stdint.h>
+
+// Level above the noise floor from which a bin counts as occupied, in dB
+#define SPECTRUM_STATS_DEFAULT_THRESHOLD    10.0f
+
+// Fraction of the distance to a quiet bin's level by which its noise floor moves at each spectrum
+#define SPECTRUM_STATS_DEFAULT_FLOOR_SPEED  0.05f
+
+// Statistics of each bin of the spectra computed by the IQ front end: a running noise floor that doesn't follow
+// occupied bins, a peak hold and the fraction of the spectra in which the bin was occupied. They are gathered once
+// for everyone wanting them instead of each module working through the raw spectra, and start over whenever the size
+// or bandwidth of the spectra changes or reset() is called, eg. on retune.
+class SpectrumStats {
+public:
+    struct ChannelStats {
+        // Highest level in the channel of the latest spectrum, in dB
+        float level;
+        // Average noise floor over the channel, in dB
+        float noiseFloor;
+        // Highest level held in the channel, in dB
+        float peak;
+        // Fraction of the spectra in which the bins of the channel were occupied, from 0 to 1
+        float occupancy;
+    };
+
+    // Update with a spectrum in dB of size bins spanning bandwidth, centered on the tuned frequency
+    void process(const float* line, int size, double bandwidth);
+
+    // Discard the statistics, they are unavailable until the next spectrum
+    void reset();
+    void resetPeaks();
+
+    // threshold is in dB above the noise floor
+    void setThreshold(float threshold);
+
+    // Speed at which the noise floor follows quiet bins, from 0 to 1 per spectrum
+    void setFloorSpeed(float speed);
+
+    // dB by which held peaks decay at each spectrum, 0 to hold them forever
+    void setPeakDecay(float decay);
+
+    // Statistics of the bins within bandwidth of the given offset from the tuned frequency. Returns false if no
+    // spectrum was processed yet or the channel is outside of it
+    bool getChannelStats(double offset, double bandwidth, ChannelStats& stats);
+
+    // Copy the statistics of every bin, any of the buffers may be NULL. Returns the number of bins, 0 if unavailable
+    int getBins(float* noiseFloor, float* peak, float* occupancy, int maxCount);
+
+    // Number of spectra processed since the last reset
+    uint64_t getLineCount();
+
+    // Wait for a spectrum to be processed after the one counted by seq, for at most timeout seconds, so that its users
+    // run at the rate of the spectra. seq is set to the count of spectra ever processed, which unlike getLineCount()
+    // isn't reset. Returns false if none came in time
+    bool waitLine(uint64_t& seq, double timeout);
+
+private:
+    void resize(int size);
+
+    std::mutex mtx;
+    int bins = 0;
+    double _bandwidth = 0.0;
+    uint64_t lines = 0;
+    uint64_t totalLines = 0;
+    bool resetPending = true;
+    std::condition_variable lineCnd;
+
+    float _threshold = SPECTRUM_STATS_DEFAULT_THRESHOLD;
+    float _floorSpeed = SPECTRUM_STATS_DEFAULT_FLOOR_SPEED;
+    float _peakDecay = 0.0f;
+
+    std::vector<float> latest;
+    std::vector<float> floors;
+    std::vector<float> peaks;
+    std::vector<float> occupied;
+};
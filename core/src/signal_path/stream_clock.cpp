@@ -0,0 +1,35 @@
+#include <signal_path/stream_clock.h>
+#include <chrono>
+
+void StreamClock::drive(double origin) {
+    std::lock_guard<std::mutex> lck(mtx);
+    this->origin = origin;
+    elapsed = 0.0;
+    driven = true;
+}
+
+void StreamClock::advance(int count, double samplerate) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (!driven || samplerate <= 0.0) { return; }
+    elapsed += (double)count / samplerate;
+}
+
+void StreamClock::release() {
+    std::lock_guard<std::mutex> lck(mtx);
+    driven = false;
+}
+
+bool StreamClock::isDriven() {
+    std::lock_guard<std::mutex> lck(mtx);
+    return driven;
+}
+
+double StreamClock::now() {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (driven) { return origin + elapsed; }
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+time_t StreamClock::nowTime() {
+    return (time_t)now();
+}
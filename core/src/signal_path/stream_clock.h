@@ -0,0 +1,31 @@
+#pragma once
+#include <mutex>
+#include <time.h>
+
+// Time of the samples currently flowing through the signal path. Live sources leave it alone and it follows the wall
+// clock, sources playing a recording drive it so that decoders timestamp their output with the time of the recording,
+// however fast it is being played
+class StreamClock {
+public:
+    // Start driving the clock from the given time, in seconds since the epoch
+    void drive(double origin);
+
+    // Move the driven clock forward by a number of samples
+    void advance(int count, double samplerate);
+
+    // Go back to following the wall clock
+    void release();
+
+    bool isDriven();
+
+    // Current time in seconds since the epoch
+    double now();
+
+    time_t nowTime();
+
+private:
+    std::mutex mtx;
+    bool driven = false;
+    double origin = 0.0;
+    double elapsed = 0.0;
+};
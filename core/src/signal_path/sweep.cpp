@@ -0,0 +1,244 @@
+#include <signal_path/sweep.h>
+#include <signal_path/signal_path.h>
+#include <gui/gui.h>
+#include <dsp/accelerate.h>
+#include <dsp/buffer/buffer.h>
+#include <dsp/window/nuttall.h>
+#include <utils/flog.h>
+#include <volk/volk.h>
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+// Level of the bins no hop wrote yet, in dB
+#define SWEEP_EMPTY_LEVEL   -150.0f
+
+Sweeper::~Sweeper() {
+    // The sweep must have been stopped before exiting
+    if (!window) { return; }
+    plan.destroy();
+    fftwf_free(fftIn);
+    fftwf_free(fftOut);
+    dsp::buffer::free(window);
+    dsp::buffer::free(power);
+}
+
+void Sweeper::start(double startFreq, double stopFreq, int fftSize, double settleTime) {
+    if (isRunning()) { stop(); }
+    if (stopFreq <= startFreq || fftSize <= 0) {
+        flog::error("Invalid sweep from {0} to {1} with {2} bins", startFreq, stopFreq, fftSize);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        _startFreq = startFreq;
+        _stopFreq = stopFreq;
+        _settleTime = settleTime;
+
+        // The window alternates the sign of the samples to center the spectrum
+        if (fftSize != _fftSize) {
+            if (window) {
+                plan.destroy();
+                fftwf_free(fftIn);
+                fftwf_free(fftOut);
+                dsp::buffer::free(window);
+                dsp::buffer::free(power);
+            }
+            _fftSize = fftSize;
+            window = dsp::buffer::alloc<float>(_fftSize);
+            for (int i = 0; i < _fftSize; i++) {
+                window[i] = dsp::window::nuttall(i, _fftSize) * ((i % 2) ? -1.0f : 1.0f);
+            }
+            power = dsp::buffer::alloc<float>(_fftSize);
+            fftIn = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
+            fftOut = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
+            plan.create(_fftSize, fftIn, fftOut, FFTW_FORWARD);
+        }
+
+        lineSamplerate = 0.0;
+        latest.clear();
+        stats = Stats();
+        running = true;
+    }
+
+    // The waterfall spans the whole band while sweeping, its spectra coming from the sweep
+    savedFFTEnabled = sigpath::iqFrontEnd.isFFTEnabled();
+    savedCenter = gui::waterfall.getCenterFrequency();
+    savedViewBandwidth = gui::waterfall.getViewBandwidth();
+    savedViewOffset = gui::waterfall.getViewOffset();
+    sigpath::iqFrontEnd.setFFTEnabled(false);
+    gui::waterfall.setBandwidth(stopFreq - startFreq);
+    gui::waterfall.setViewBandwidth(stopFreq - startFreq);
+    gui::waterfall.setViewOffset(0.0);
+    gui::waterfall.setCenterFrequency((startFreq + stopFreq) / 2.0);
+
+    // Let the source sweep in hardware if it can, otherwise hop it from here
+    native = sigpath::sourceManager.startSweep(startFreq, stopFreq, fftSize);
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        stats.native = native;
+    }
+    if (!native) {
+        sigpath::iqFrontEnd.bindIQStream(&input, dsp::routing::BACKPRESSURE_DROP_OLDEST);
+        workerThread = std::thread(&Sweeper::worker, this);
+    }
+    flog::info("Sweeping from {0} to {1} ({2})", startFreq, stopFreq, native ? "hardware" : "software");
+}
+
+void Sweeper::stop() {
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        if (!running) { return; }
+        running = false;
+    }
+
+    if (native) {
+        sigpath::sourceManager.stopSweep();
+    }
+    else {
+        input.stopReader();
+        if (workerThread.joinable()) { workerThread.join(); }
+        input.clearReadStop();
+        sigpath::iqFrontEnd.unbindIQStream(&input);
+    }
+    native = false;
+
+    gui::waterfall.setBandwidth(sigpath::iqFrontEnd.getEffectiveSamplerate());
+    gui::waterfall.setViewBandwidth(savedViewBandwidth);
+    gui::waterfall.setViewOffset(savedViewOffset);
+    gui::waterfall.setCenterFrequency(savedCenter);
+    sigpath::sourceManager.tune(savedCenter);
+    sigpath::iqFrontEnd.setFFTEnabled(savedFFTEnabled);
+}
+
+bool Sweeper::isRunning() {
+    std::lock_guard<std::mutex> lck(mtx);
+    return running;
+}
+
+void Sweeper::pushHop(double center, double samplerate, const dsp::complex_t* samples, int count, double minOffset, double maxOffset) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (!running || count < _fftSize || samplerate <= 0.0) { return; }
+    if (samplerate != lineSamplerate) { resetLine(samplerate); }
+
+    // The hops of a sweep go up in frequency, going back down means the band was covered
+    if (hopSeen && center <= lastCenter) { publish(); }
+    if (!hopSeen) {
+        hopSeen = true;
+        sweepBegin = std::chrono::steady_clock::now();
+    }
+    lastCenter = center;
+    stats.hops++;
+
+    // Only the last samples are used, the first ones being the closest to the retune
+    samples += count - _fftSize;
+    volk_32fc_32f_multiply_32fc((lv_32fc_t*)fftIn, (const lv_32fc_t*)samples, window, _fftSize);
+    plan.execute();
+    dsp::accelerate::powerSpectrum(power, (dsp::complex_t*)fftOut, _fftSize, _fftSize);
+
+    // Write the usable bins to the stitched spectrum
+    int lineSize = line.size();
+    double fftBinWidth = samplerate / (double)_fftSize;
+    for (int i = 0; i < _fftSize; i++) {
+        double offset = (double)(i - (_fftSize / 2)) * fftBinWidth;
+        double dist = fabs(offset);
+        if (dist < minOffset || dist > maxOffset) { continue; }
+        int id = floor((center + offset - _startFreq) / binWidth);
+        if (id < 0 || id >= lineSize) { continue; }
+        if (lineSweep[id] != sweepId) {
+            line[id] = power[i];
+            lineSweep[id] = sweepId;
+        }
+        else {
+            line[id] = std::max<float>(line[id], power[i]);
+        }
+    }
+}
+
+void Sweeper::endSweep() {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (running && hopSeen) { publish(); }
+}
+
+Sweeper::Stats Sweeper::getStats() {
+    std::lock_guard<std::mutex> lck(mtx);
+    return stats;
+}
+
+int Sweeper::getSpectrum(float* out, int maxCount) {
+    std::lock_guard<std::mutex> lck(mtx);
+    int count = std::min<int>(latest.size(), maxCount);
+    if (count > 0) { memcpy(out, latest.data(), count * sizeof(float)); }
+    return count;
+}
+
+void Sweeper::worker() {
+    double samplerate = sigpath::iqFrontEnd.getEffectiveSamplerate();
+    double hopWidth = samplerate * SWEEP_DEFAULT_USABLE_FRACTION;
+    int hops = std::max<int>(1, ceil((_stopFreq - _startFreq) / hopWidth));
+    int settle = round(_settleTime * samplerate);
+    std::vector<dsp::complex_t> frame(_fftSize);
+
+    for (int hop = 0; isRunning(); hop = (hop + 1) % hops) {
+        double center = _startFreq + ((double)hop + 0.5) * hopWidth;
+        sigpath::sourceManager.tune(center);
+        sigpath::sourceManager.waitTuned(1.0);
+
+        // The buffer kept by the splitter was produced before the retune, and the samples within the settle time
+        // come from hardware still settling
+        if (input.read() < 0) { return; }
+        input.flush();
+        int discard = settle;
+        int filled = 0;
+        while (filled < _fftSize) {
+            int count = input.read();
+            if (count < 0) { return; }
+            int offset = std::min<int>(discard, count);
+            discard -= offset;
+            int n = std::min<int>(count - offset, _fftSize - filled);
+            memcpy(&frame[filled], &input.readBuf[offset], n * sizeof(dsp::complex_t));
+            filled += n;
+            input.flush();
+        }
+
+        // With a single hop, each one ends the sweep of the previous one
+        pushHop(center, samplerate, frame.data(), _fftSize, 0.0, hopWidth / 2.0);
+    }
+}
+
+void Sweeper::resetLine(double samplerate) {
+    // The bins are those of the FFT unless there would be too many of them
+    double span = _stopFreq - _startFreq;
+    lineSamplerate = samplerate;
+    binWidth = std::max<double>(samplerate / (double)_fftSize, span / (double)SWEEP_MAX_BINS);
+    int size = std::max<int>(1, ceil(span / binWidth));
+    line.assign(size, SWEEP_EMPTY_LEVEL);
+    lineSweep.assign(size, 0);
+    sweepId = 1;
+    hopSeen = false;
+}
+
+void Sweeper::publish() {
+    auto now = std::chrono::steady_clock::now();
+    latest = line;
+    stats.sweeps++;
+    stats.sweepTime = std::chrono::duration<double>(now - sweepBegin).count();
+    sweepBegin = now;
+    sweepId++;
+
+    // The waterfall only takes spectra of the size of the FFT of the IQ front end, each of its bins holding the
+    // highest level of the bins of the sweep it covers
+    int size = sigpath::iqFrontEnd.getFFTSize();
+    int lineSize = latest.size();
+    if (size <= 0) { return; }
+    wfLine.resize(size);
+    for (int i = 0; i < size; i++) {
+        int begin = ((int64_t)i * lineSize) / size;
+        int end = std::max<int>(begin + 1, ((int64_t)(i + 1) * lineSize) / size);
+        float level = latest[begin];
+        for (int j = begin + 1; j < end; j++) { level = std::max<float>(level, latest[j]); }
+        wfLine[i] = level;
+    }
+    gui::waterfall.pushFFT(wfLine.data(), size);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+#include <dsp/stream.h>
+#include <dsp/types.h>
+#include <dsp/fft/plan.h>
+
+// Fraction of the band of a hop whose bins are kept when hopping in software, the edges being attenuated by the
+// anti-aliasing filters of the source
+#define SWEEP_DEFAULT_USABLE_FRACTION   0.75
+
+// Time during which the samples are discarded after each retune, in seconds
+#define SWEEP_DEFAULT_SETTLE_TIME       0.002
+
+// Size of the stitched spectrum at most, wider bands get coarser bins
+#define SWEEP_MAX_BINS                  (1 << 20)
+
+// Survey of a band wider than the source by hopping it across the band. The spectrum computed at each hop is written
+// into a spectrum of the whole band, which is pushed to the waterfall once the band is covered, its frequency axis
+// then spanning the band. Sources able to sweep in hardware do the hopping and push the hops with pushHop(), the
+// others are retuned through the source manager, the samples coming from the IQ front end. Only for the main receiver
+class Sweeper {
+public:
+    struct Stats {
+        uint64_t sweeps = 0;
+        uint64_t hops = 0;
+        double sweepTime = 0.0;     // Time the last sweep took, in seconds
+        bool native = false;        // The source is sweeping in hardware
+    };
+
+    ~Sweeper();
+
+    // Start sweeping the band from startFreq to stopFreq with FFTs of fftSize bins, the normal spectrum being suspended
+    // meanwhile. Must be called from the GUI thread with the source running
+    void start(double startFreq, double stopFreq, int fftSize, double settleTime = SWEEP_DEFAULT_SETTLE_TIME);
+
+    // Stop sweeping, retune the source to where it was and put the waterfall back
+    void stop();
+
+    bool isRunning();
+
+    // Spectrum of count samples taken with the hardware tuned to center at samplerate, only the bins between minOffset
+    // and maxOffset of the center on either side being kept. Only the last fftSize samples are used. A hop below the
+    // previous one ends the sweep. Can be called from any thread
+    void pushHop(double center, double samplerate, const dsp::complex_t* samples, int count, double minOffset, double maxOffset);
+
+    // End the sweep early and publish the spectrum
+    void endSweep();
+
+    Stats getStats();
+
+    // Copy the latest stitched spectrum, returns its number of bins or 0 if there's none yet
+    int getSpectrum(float* out, int maxCount);
+
+private:
+    void worker();
+    void resetLine(double samplerate);
+    void publish();
+
+    std::mutex mtx;
+    bool running = false;
+    bool native = false;
+    double _startFreq = 0.0;
+    double _stopFreq = 0.0;
+    int _fftSize = 0;
+    double _settleTime = 0.0;
+
+    // FFT of the hops
+    float* window = NULL;
+    fftwf_complex* fftIn = NULL;
+    fftwf_complex* fftOut = NULL;
+    float* power = NULL;
+    dsp::fft::Plan plan;
+
+    // Stitched spectrum, each bin remembering the sweep that last wrote it so that the FFT bins falling in the same
+    // bin are max-held within a sweep
+    std::vector<float> line;
+    std::vector<uint32_t> lineSweep;
+    std::vector<float> latest;
+    std::vector<float> wfLine;
+    double lineSamplerate = 0.0;
+    double binWidth = 0.0;
+    uint32_t sweepId = 1;
+    double lastCenter = 0.0;
+    bool hopSeen = false;
+    std::chrono::steady_clock::time_point sweepBegin;
+    Stats stats;
+
+    // Software hopping
+    std::thread workerThread;
+    dsp::stream<dsp::complex_t> input;
+
+    // State restored once stopped
+    bool savedFFTEnabled = true;
+    double savedCenter = 0.0;
+    double savedViewBandwidth = 0.0;
+    double savedViewOffset = 0.0;
+};
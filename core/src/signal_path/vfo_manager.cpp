@@ -2,10 +2,13 @@
 #include <signal_path/signal_path.h>
 #include <gui/gui.h>
 
-VFOManager::VFO::VFO(std::string name, int reference, double offset, double bandwidth, double sampleRate, double minBandwidth, double maxBandwidth, bool bandwidthLocked) {
+VFOManager::VFO::VFO(VFOManager* manager, std::string name, int reference, double offset, double bandwidth, double sampleRate, double minBandwidth, double maxBandwidth, bool bandwidthLocked) {
     this->name = name;
+    frontEnd = manager->frontEnd;
+    waterfall = manager->waterfall;
     _bandwidth = bandwidth;
-    dspVFO = sigpath::iqFrontEnd.addVFO(name, sampleRate, bandwidth, offset);
+    _sampleRate = sampleRate;
+    dspVFO = frontEnd->addVFO(name, sampleRate, bandwidth, offset);
     wtfVFO = new ImGui::WaterfallVFO;
     wtfVFO->setReference(reference);
     wtfVFO->setBandwidth(bandwidth);
@@ -14,22 +17,33 @@ VFOManager::VFO::VFO(std::string name, int reference, double offset, double band
     wtfVFO->maxBandwidth = maxBandwidth;
     wtfVFO->bandwidthLocked = bandwidthLocked;
     output = &dspVFO->out;
-    gui::waterfall.vfos[name] = wtfVFO;
+    latency.setName("VFO " + name);
+    output->setLatencyProbe(&latency);
+
+    // VFOs of receivers that aren't displayed still keep their offsets in a waterfall VFO
+    if (waterfall) { waterfall->vfos[name] = wtfVFO; }
 }
 
 VFOManager::VFO::~VFO() {
     dspVFO->stop();
-    gui::waterfall.vfos.erase(name);
-    if (gui::waterfall.selectedVFO == name) {
-        gui::waterfall.selectFirstVFO();
+    if (waterfall) {
+        waterfall->vfos.erase(name);
+        if (waterfall->selectedVFO == name) {
+            waterfall->selectFirstVFO();
+        }
     }
-    sigpath::iqFrontEnd.removeVFO(name);
+    frontEnd->removeVFO(name);
     delete wtfVFO;
+    if (spectrum) { delete spectrum; }
+}
+
+void VFOManager::VFO::setActive(bool active) {
+    dspVFO->setActive(active);
 }
 
 void VFOManager::VFO::setOffset(double offset) {
     wtfVFO->setOffset(offset);
-    dspVFO->setOffset(wtfVFO->centerOffset);
+    frontEnd->setVFOOffset(name, wtfVFO->centerOffset);
 }
 
 double VFOManager::VFO::getOffset() {
@@ -38,7 +52,7 @@ double VFOManager::VFO::getOffset() {
 
 void VFOManager::VFO::setCenterOffset(double offset) {
     wtfVFO->setCenterOffset(offset);
-    dspVFO->setOffset(offset);
+    frontEnd->setVFOOffset(name, offset);
 }
 
 void VFOManager::VFO::setBandwidth(double bandwidth, bool updateWaterfall) {
@@ -49,8 +63,12 @@ void VFOManager::VFO::setBandwidth(double bandwidth, bool updateWaterfall) {
 }
 
 void VFOManager::VFO::setSampleRate(double sampleRate, double bandwidth) {
-    dspVFO->setOutSamplerate(sampleRate, bandwidth);
+    _sampleRate = sampleRate;
+    frontEnd->setVFOSampleRate(name, sampleRate, bandwidth);
     wtfVFO->setBandwidth(bandwidth);
+
+    // The spectrum must follow the samplerate of the output
+    if (spectrum) { setSpectrumSize(spectrum->getSize()); }
 }
 
 void VFOManager::VFO::setReference(int ref) {
@@ -67,6 +85,10 @@ void VFOManager::VFO::setBandwidthLimits(double minBandwidth, double maxBandwidt
     wtfVFO->bandwidthLocked = bandwidthLocked;
 }
 
+void VFOManager::VFO::setFilterEnabled(bool enabled) {
+    dspVFO->setFilterEnabled(enabled);
+}
+
 bool VFOManager::VFO::getBandwidthChanged(bool erase) {
     bool val = wtfVFO->bandwidthChanged;
     if (erase) { wtfVFO->bandwidthChanged = false; }
@@ -89,14 +111,46 @@ std::string VFOManager::VFO::getName() {
     return name;
 }
 
+void VFOManager::VFO::setSpectrumSize(int size) {
+    // Detach the spectrum before changing it
+    dspVFO->setSpectrum(NULL);
+    if (!size) {
+        if (spectrum) { delete spectrum; }
+        spectrum = NULL;
+        return;
+    }
+    if (!spectrum) { spectrum = new dsp::fft::Spectrum; }
+    spectrum->init(size, _sampleRate, VFO_SPECTRUM_RATE);
+    dspVFO->setSpectrum(spectrum);
+}
+
+int VFOManager::VFO::getSpectrumSize() {
+    return spectrum ? spectrum->getSize() : 0;
+}
+
+dsp::fft::Spectrum* VFOManager::VFO::getSpectrum() {
+    return spectrum;
+}
+
+dsp::LatencyStats VFOManager::VFO::getLatency() {
+    return latency.getStats();
+}
+
 VFOManager::VFOManager() {
+    frontEnd = &sigpath::iqFrontEnd;
+    waterfall = &gui::waterfall;
+}
+
+void VFOManager::setFrontEnd(IQFrontEnd* frontEnd, ImGui::WaterFall* waterfall) {
+    this->frontEnd = frontEnd;
+    this->waterfall = waterfall;
 }
 
 VFOManager::VFO* VFOManager::createVFO(std::string name, int reference, double offset, double bandwidth, double sampleRate, double minBandwidth, double maxBandwidth, bool bandwidthLocked) {
     if (vfos.find(name) != vfos.end() || name == "") {
         return NULL;
     }
-    VFOManager::VFO* vfo = new VFO(name, reference, offset, bandwidth, sampleRate, minBandwidth, maxBandwidth, bandwidthLocked);
+    VFOManager::VFO* vfo = new VFO(this, name, reference, offset, bandwidth, sampleRate, minBandwidth, maxBandwidth, bandwidthLocked);
     vfos[name] = vfo;
     onVfoCreated.emit(vfo);
     return vfo;
@@ -196,15 +250,49 @@ void VFOManager::setColor(std::string name, ImU32 color) {
     return vfos[name]->setColor(color);
 }
 
+void VFOManager::setSpectrumSize(std::string name, int size) {
+    if (vfos.find(name) == vfos.end()) {
+        return;
+    }
+    vfos[name]->setSpectrumSize(size);
+}
+
+int VFOManager::getSpectrumSize(std::string name) {
+    if (vfos.find(name) == vfos.end()) {
+        return 0;
+    }
+    return vfos[name]->getSpectrumSize();
+}
+
+dsp::fft::Spectrum* VFOManager::getSpectrum(std::string name) {
+    if (vfos.find(name) == vfos.end()) {
+        return NULL;
+    }
+    return vfos[name]->getSpectrum();
+}
+
+dsp::LatencyStats VFOManager::getLatency(std::string name) {
+    if (vfos.find(name) == vfos.end()) {
+        return dsp::LatencyStats();
+    }
+    return vfos[name]->getLatency();
+}
+
 bool VFOManager::vfoExists(std::string name) {
     return (vfos.find(name) != vfos.end());
 }
 
+std::vector<std::string> VFOManager::getNames() {
+    std::vector<std::string> names;
+    for (auto const& [name, vfo] : vfos) { names.push_back(name); }
+    return names;
+}
+
 void VFOManager::updateFromWaterfall(ImGui::WaterFall* wtf) {
     for (auto const& [name, vfo] : vfos) {
         if (vfo->wtfVFO->centerOffsetChanged) {
             vfo->wtfVFO->centerOffsetChanged = false;
-            vfo->dspVFO->setOffset(vfo->wtfVFO->centerOffset);
+            frontEnd->setVFOOffset(name, vfo->wtfVFO->centerOffset);
         }
     }
 }
\ No newline at end of file
@@ -1,15 +1,25 @@
 #pragma once
 #include "../dsp/channel/rx_vfo.h"
+#include "../dsp/fft/spectrum.h"
 #include <gui/widgets/waterfall.h>
 #include <utils/event.h>
 
+// Number of spectra per second computed on the output of a VFO
+#define VFO_SPECTRUM_RATE   20.0
+
+class IQFrontEnd;
+
 class VFOManager {
 public:
     VFOManager();
 
+    // Front end the VFOs are created on and waterfall they're shown on, the main ones unless set. The waterfall may be
+    // NULL for receivers that aren't displayed. Must be called before creating any VFO
+    void setFrontEnd(IQFrontEnd* frontEnd, ImGui::WaterFall* waterfall);
+
     class VFO {
     public:
-        VFO(std::string name, int reference, double offset, double bandwidth, double sampleRate, double minBandwidth, double maxBandwidth, bool bandwidthLocked);
+        VFO(VFOManager* manager, std::string name, int reference, double offset, double bandwidth, double sampleRate, double minBandwidth, double maxBandwidth, bool bandwidthLocked);
         ~VFO();
 
         void setOffset(double offset);
@@ -20,12 +30,26 @@ public:
         void setReference(int ref);
         void setSnapInterval(double interval);
         void setBandwidthLimits(double minBandwidth, double maxBandwidth, bool bandwidthLocked);
+
+        // Let the user of the output do the filtering, the bandwidth is then only shown on the waterfall
+        void setFilterEnabled(bool enabled);
         bool getBandwidthChanged(bool erase = true);
         double getBandwidth();
         int getReference();
         void setColor(ImU32 color);
         std::string getName();
 
+        // Compute a spectrum of size bins of the output of the VFO, 0 to disable it
+        void setSpectrumSize(int size);
+
+        // Stop processing the VFO while nothing uses its output
+        void setActive(bool active);
+        int getSpectrumSize();
+        dsp::fft::Spectrum* getSpectrum();
+
+        // Latency from the source to the output of the VFO
+        dsp::LatencyStats getLatency();
+
         dsp::stream<dsp::complex_t>* output;
 
         friend class VFOManager;
@@ -34,8 +58,13 @@ public:
         ImGui::WaterfallVFO* wtfVFO;
 
     private:
+        IQFrontEnd* frontEnd;
+        ImGui::WaterFall* waterfall;
         std::string name;
         double _bandwidth;
+        double _sampleRate;
+        dsp::fft::Spectrum* spectrum = NULL;
+        dsp::LatencyProbe latency;
 
     };
 
@@ -52,9 +81,14 @@ public:
     bool getBandwidthChanged(std::string name, bool erase = true);
     double getBandwidth(std::string name);
     void setColor(std::string name, ImU32 color);
+    void setSpectrumSize(std::string name, int size);
+    int getSpectrumSize(std::string name);
+    dsp::fft::Spectrum* getSpectrum(std::string name);
+    dsp::LatencyStats getLatency(std::string name);
     std::string getName();
     int getReference(std::string name);
     bool vfoExists(std::string name);
+    std::vector<std::string> getNames();
 
     void updateFromWaterfall(ImGui::WaterFall* wtf);
 
@@ -63,5 +97,7 @@ public:
     Event<std::string> onVfoDeleted;
 
 private:
+    IQFrontEnd* frontEnd;
+    ImGui::WaterFall* waterfall;
     std::map<std::string, VFO*> vfos;
 };
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Copy-on-write list for the handlers of events. Iterating only takes atomic counters, so emitting never waits for a
+// lock and never contends with bind() or unbind() from other threads. Changes copy the list under a lock and publish
+// the copy, the old one being freed once no thread iterates over any list anymore.
+//
+// Once modify() returns, no thread is still iterating over the list it replaced, unless the calling thread is itself
+// iterating over a list of this type, in which case it doesn't wait since it would be waiting for itself. This way
+// handlers can unbind themselves, and can be freed by whoever unbound them from another thread
+template <class T>
+class CowList {
+public:
+    CowList() {
+        current = new List();
+    }
+
+    ~CowList() {
+        delete current.load();
+        for (auto l : retired) { delete l; }
+    }
+
+    // Call f on each item of the list as it was when the iteration started
+    template <class F>
+    void forEach(F f) {
+        readers++;
+        List* l;
+        while (true) {
+            l = current.load();
+            l->users++;
+
+            // If the list was replaced meanwhile, the thread replacing it may not have seen this one in use
+            if (current.load() == l) { break; }
+            l->users--;
+        }
+
+        // Release the list even if a handler throws
+        struct Hold {
+            List* l;
+            std::atomic<int>& readers;
+            ~Hold() {
+                depth--;
+                l->users--;
+                readers--;
+            }
+        };
+        depth++;
+        Hold hold = { l, readers };
+        for (const auto& item : l->items) { f(item); }
+    }
+
+    // Call f on a copy of the items, which replaces the list if f returns true
+    template <class F>
+    bool modify(F f) {
+        std::lock_guard<std::mutex> lck(mtx);
+        List* next = new List();
+        next->items = current.load()->items;
+        if (!f(next->items)) {
+            delete next;
+            return false;
+        }
+
+        List* old = current.exchange(next);
+        retired.push_back(old);
+
+        // Wait for the threads still iterating over the old list
+        if (!depth) {
+            while (old->users) { std::this_thread::yield(); }
+        }
+
+        // When nobody iterates at all, none of the replaced lists can still be in use
+        if (!readers) {
+            for (auto l : retired) { delete l; }
+            retired.clear();
+        }
+        return true;
+    }
+
+private:
+    struct List {
+        std::vector<T> items;
+        std::atomic<int> users = 0;
+    };
+
+    std::atomic<List*> current;
+    std::atomic<int> readers = 0;
+    std::mutex mtx;
+    std::vector<List*> retired;
+
+    // Iterations the current thread is in, over any list of this type
+    static inline thread_local int depth = 0;
+};
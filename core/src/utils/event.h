@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <utils/flog.h>
+#include <utils/cow_list.h>
 
 template <class T>
 struct EventHandler {
@@ -14,6 +16,7 @@ struct EventHandler {
     void* ctx;
 };
 
+// Emitting is lock free, see CowList
 template <class T>
 class Event {
 public:
@@ -21,23 +24,29 @@ public:
     ~Event() {}
 
     void emit(T value) {
-        for (auto const& handler : handlers) {
+        handlers.forEach([&](EventHandler<T>* handler) {
             handler->handler(value, handler->ctx);
-        }
+        });
     }
 
     void bindHandler(EventHandler<T>* handler) {
-        handlers.push_back(handler);
+        handlers.modify([&](std::vector<EventHandler<T>*>& list) {
+            list.push_back(handler);
+            return true;
+        });
     }
 
     void unbindHandler(EventHandler<T>* handler) {
-        if (std::find(handlers.begin(), handlers.end(), handler) == handlers.end()) {
+        bool found = handlers.modify([&](std::vector<EventHandler<T>*>& list) {
+            if (std::find(list.begin(), list.end(), handler) == list.end()) { return false; }
+            list.erase(std::remove(list.begin(), list.end(), handler), list.end());
+            return true;
+        });
+        if (!found) {
             flog::error("Tried to remove a non-existent event handler");
-            return;
         }
-        handlers.erase(std::remove(handlers.begin(), handlers.end(), handler), handlers.end());
     }
 
 private:
-    std::vector<EventHandler<T>*> handlers;
+    CowList<EventHandler<T>*> handlers;
 };
\ No newline at end of file
@@ -1,7 +1,13 @@
 #include "flog.h"
 #include <mutex>
 #include <chrono>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
+#include <algorithm>
 #include <string.h>
+#include <stdio.h>
 #include <inttypes.h>
 
 #ifdef _WIN32
@@ -19,6 +25,16 @@
 #define FORMAT_BUF_SIZE 16
 #define ESCAPE_CHAR     '\\'
 
+// Number of messages a thread can have waiting for the logger thread in async mode
+#define QUEUE_SIZE      256
+
+// Time the logger thread sleeps when all queues are empty, in milliseconds
+#define LOGGER_POLL_MS  20
+
+// Default rate limit of identical messages
+#define DEFAULT_MAX_REPEATS     10
+#define DEFAULT_REPEAT_INTERVAL 1.0
+
 namespace flog {
     std::mutex outMtx;
 
@@ -56,7 +72,63 @@ namespace flog {
     };
 #endif
 
-    void __log__(Type type, const char* fmt, const std::vector<std::string>& args) {
+    typedef std::chrono::system_clock::time_point Time;
+
+    struct Message {
+        Type type;
+        Time time;
+        std::string fmt;
+        std::vector<std::string> args;
+    };
+
+    // Messages of one thread, written by it and read by the logger thread without locking
+    struct ThreadQueue {
+        Message msgs[QUEUE_SIZE];
+        std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> tail = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<bool> alive = true;
+    };
+
+    // Marks the queue of a thread as dead when it exits, the logger thread then frees it once empty
+    struct QueueOwner {
+        ~QueueOwner() {
+            if (queue) { queue->alive.store(false); }
+            queue = NULL;
+        }
+        ThreadQueue* queue = NULL;
+    };
+
+    struct RateEntry {
+        Type type;
+        double windowStart;
+        int count;
+        int suppressed;
+    };
+
+    // Async mode
+    std::mutex asyncMtx;
+    std::atomic<bool> async = false;
+    std::atomic<bool> loggerRunning = false;
+    std::thread loggerThread;
+    std::mutex loggerMtx;
+    std::condition_variable loggerCnd;
+    std::mutex queuesMtx;
+    std::vector<ThreadQueue*> queues;
+    thread_local QueueOwner owner;
+
+    // Output state, protected by outMtx
+    int maxRepeats = DEFAULT_MAX_REPEATS;
+    double repeatInterval = DEFAULT_REPEAT_INTERVAL;
+    std::unordered_map<std::string, RateEntry> rates;
+    double lastSweep = 0.0;
+    FILE* logFile = NULL;
+    std::string logPath;
+    size_t logMaxSize = 0;
+    int logMaxFiles = 0;
+    size_t logSize = 0;
+
+    std::string format(const char* fmt, const std::vector<std::string>& args) {
         // Reserve a buffer for the final output
         int argCount = args.size();
         int fmtLen = strlen(fmt) + 1;
@@ -64,9 +136,6 @@ namespace flog {
         for (const auto& a : args) { totSize += a.size(); }
         std::string out;
         out.reserve(totSize);
-        
-        // Get output stream depending on type
-        FILE* outStream = (type == TYPE_ERROR) ? stderr : stdout;
 
         // Parse format string
         bool escaped = false;
@@ -91,7 +160,7 @@ namespace flog {
                 if (c == ESCAPE_CHAR) {
                     escaped = true;
                 }
-                else {
+                else if (c) {
                     out += c;
                 }
             }
@@ -141,44 +210,255 @@ namespace flog {
             }
         }
 
-        // Get time
-        auto now = std::chrono::system_clock::now();
-        auto nowt = std::chrono::system_clock::to_time_t(now);
-        auto nowc = std::localtime(&nowt); // TODO: This is not threadsafe
+        return out;
+    }
 
-        // Write to output
-        {
-            std::lock_guard<std::mutex> lck(outMtx);
-#if defined(_WIN32)
-            // Get output handle and return if invalid
-            int wOutStream = (type == TYPE_ERROR) ? STD_ERROR_HANDLE  : STD_OUTPUT_HANDLE;
-            HANDLE conHndl = GetStdHandle(wOutStream);
-            if (!conHndl || conHndl == INVALID_HANDLE_VALUE) { return; }
+    double toSeconds(const Time& time) {
+        return std::chrono::duration<double>(time.time_since_epoch()).count();
+    }
 
+    void rotateLogFile() {
+        fclose(logFile);
+        if (logMaxFiles > 0) {
+            std::remove((logPath + "." + std::to_string(logMaxFiles)).c_str());
+            for (int i = logMaxFiles - 1; i > 0; i--) {
+                std::rename((logPath + "." + std::to_string(i)).c_str(), (logPath + "." + std::to_string(i + 1)).c_str());
+            }
+            std::rename(logPath.c_str(), (logPath + ".1").c_str());
+        }
+        logFile = fopen(logPath.c_str(), "w");
+        logSize = 0;
+    }
+
+    // Write a line to the console and log file, outMtx must be locked
+    void writeLine(Type type, const Time& time, const std::string& out) {
+        // Get time, localtime() is safe since the output is locked
+        auto nowt = std::chrono::system_clock::to_time_t(time);
+        auto nowc = std::localtime(&nowt);
+        int ms = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000);
+
+        // Get output stream depending on type
+        FILE* outStream = (type == TYPE_ERROR) ? stderr : stdout;
+
+#if defined(_WIN32)
+        // Get output handle and skip the console if invalid
+        int wOutStream = (type == TYPE_ERROR) ? STD_ERROR_HANDLE  : STD_OUTPUT_HANDLE;
+        HANDLE conHndl = GetStdHandle(wOutStream);
+        if (conHndl && conHndl != INVALID_HANDLE_VALUE) {
             // Print beginning of log line
             SetConsoleTextAttribute(conHndl, COLOR_WHITE);
-            fprintf(outStream, "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [", nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, 0);
+            fprintf(outStream, "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [", nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms);
 
             // Switch color to the log color, print log type and 
             SetConsoleTextAttribute(conHndl, TYPE_COLORS[type]);
             fputs(TYPE_STR[type], outStream);
-            
 
             // Switch back to default color and print rest of log string
             SetConsoleTextAttribute(conHndl, COLOR_WHITE);
             fprintf(outStream, "] %s\n", out.c_str());
+        }
 #elif defined(__ANDROID__)
-            // Print format string
-            __android_log_print(TYPE_PRIORITIES[type], FLOG_ANDROID_TAG, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s\n",
-                    nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, 0, TYPE_COLORS[type], TYPE_STR[type], out.c_str());
+        // Print format string
+        __android_log_print(TYPE_PRIORITIES[type], FLOG_ANDROID_TAG, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s\n",
+                nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms, TYPE_COLORS[type], TYPE_STR[type], out.c_str());
 #else
-            // Print format string
-            fprintf(outStream, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s\n",
-                    nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, 0, TYPE_COLORS[type], TYPE_STR[type], out.c_str());
+        // Print format string
+        fprintf(outStream, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s\n",
+                nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms, TYPE_COLORS[type], TYPE_STR[type], out.c_str());
 #endif
+
+        // Write the file without colors
+        if (!logFile) { return; }
+        int written = fprintf(logFile, "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s] %s\n",
+                nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms, TYPE_STR[type], out.c_str());
+        if (written > 0) { logSize += written; }
+        if (logMaxSize && logSize >= logMaxSize) { rotateLogFile(); }
+    }
+
+    // Report the messages suppressed during the windows that have ended, outMtx must be locked
+    void sweepRates(double now) {
+        lastSweep = now;
+        for (auto it = rates.begin(); it != rates.end();) {
+            if (now - it->second.windowStart < repeatInterval) {
+                it++;
+                continue;
+            }
+            if (it->second.suppressed) {
+                writeLine(it->second.type, Time(std::chrono::duration_cast<Time::duration>(std::chrono::duration<double>(now))),
+                          it->first.substr(1) + " (repeated " + std::to_string(it->second.suppressed) + " more times)");
+            }
+            it = rates.erase(it);
+        }
+    }
+
+    // Rate limit, format and write a message, outMtx must be locked
+    void output(Type type, const Time& time, const char* fmt, const std::vector<std::string>& args) {
+        std::string out = format(fmt, args);
+        double t = toSeconds(time);
+        if (t - lastSweep >= repeatInterval) { sweepRates(t); }
+
+        if (maxRepeats > 0) {
+            // The key is prefixed with the type so that it's part of the identity of the message
+            std::string key = (char)('0' + type) + out;
+            auto it = rates.find(key);
+            if (it == rates.end()) {
+                rates[key] = RateEntry{ type, t, 1, 0 };
+            }
+            else if (++it->second.count > maxRepeats) {
+                it->second.suppressed++;
+                return;
+            }
+        }
+
+        writeLine(type, time, out);
+    }
+
+    // Output everything queued by the threads, in the order it was logged. Returns false if there was nothing
+    bool drainQueues() {
+        std::vector<Message> batch;
+        std::vector<uint64_t> dropped;
+        {
+            std::lock_guard<std::mutex> lck(queuesMtx);
+            for (auto it = queues.begin(); it != queues.end();) {
+                ThreadQueue* q = *it;
+                bool alive = q->alive.load();
+                uint64_t t = q->tail.load(std::memory_order_relaxed);
+                uint64_t h = q->head.load(std::memory_order_acquire);
+                for (; t < h; t++) { batch.push_back(std::move(q->msgs[t % QUEUE_SIZE])); }
+                q->tail.store(t, std::memory_order_release);
+                uint64_t d = q->dropped.exchange(0);
+                if (d) { dropped.push_back(d); }
+
+                // The thread can't queue anything anymore once it's dead
+                if (!alive) {
+                    delete q;
+                    it = queues.erase(it);
+                    continue;
+                }
+                it++;
+            }
+        }
+
+        std::lock_guard<std::mutex> lck(outMtx);
+        if (!batch.empty()) {
+            std::stable_sort(batch.begin(), batch.end(), [](const Message& a, const Message& b) { return a.time < b.time; });
+            for (const auto& msg : batch) {
+                output(msg.type, msg.time, msg.fmt.c_str(), msg.args);
+            }
+        }
+        for (uint64_t d : dropped) {
+            writeLine(TYPE_WARNING, std::chrono::system_clock::now(), "[flog] " + std::to_string(d) + " log messages dropped, the queue of their thread was full");
+        }
+        sweepRates(toSeconds(std::chrono::system_clock::now()));
+        fflush(stdout);
+        if (logFile) { fflush(logFile); }
+        return !batch.empty();
+    }
+
+    void loggerWorker() {
+        while (loggerRunning.load()) {
+            if (drainQueues()) { continue; }
+            std::unique_lock<std::mutex> lck(loggerMtx);
+            loggerCnd.wait_for(lck, std::chrono::milliseconds(LOGGER_POLL_MS));
         }
     }
 
+    // Queue a message for the logger thread, returns false if the thread has no queue yet and it couldn't be created
+    bool enqueue(Type type, const Time& time, const char* fmt, std::vector<std::string>&& args) {
+        ThreadQueue* q = owner.queue;
+        if (!q) {
+            q = new ThreadQueue;
+            {
+                std::lock_guard<std::mutex> lck(queuesMtx);
+                queues.push_back(q);
+            }
+            owner.queue = q;
+        }
+
+        // Drop the message rather than wait if the queue is full
+        uint64_t h = q->head.load(std::memory_order_relaxed);
+        if (h - q->tail.load(std::memory_order_acquire) >= QUEUE_SIZE) {
+            q->dropped++;
+            return true;
+        }
+        Message& msg = q->msgs[h % QUEUE_SIZE];
+        msg.type = type;
+        msg.time = time;
+        msg.fmt = fmt;
+        msg.args = std::move(args);
+        q->head.store(h + 1, std::memory_order_release);
+
+        // Errors are written out without waiting for the logger to poll
+        if (type == TYPE_ERROR) { loggerCnd.notify_one(); }
+        return true;
+    }
+
+    void __log__(Type type, const char* fmt, std::vector<std::string>&& args) {
+        Time now = std::chrono::system_clock::now();
+        if (async.load(std::memory_order_relaxed) && enqueue(type, now, fmt, std::move(args))) { return; }
+
+        std::lock_guard<std::mutex> lck(outMtx);
+        output(type, now, fmt, args);
+        if (logFile) { fflush(logFile); }
+    }
+
+    void setAsync(bool enabled) {
+        std::lock_guard<std::mutex> lck(asyncMtx);
+        if (enabled == async.load()) { return; }
+        if (enabled) {
+            loggerRunning.store(true);
+            loggerThread = std::thread(loggerWorker);
+            async.store(true);
+            return;
+        }
+
+        // Stop the logger and output what it left behind
+        async.store(false);
+        loggerRunning.store(false);
+        loggerCnd.notify_all();
+        if (loggerThread.joinable()) { loggerThread.join(); }
+        drainQueues();
+    }
+
+    bool isAsync() {
+        return async.load();
+    }
+
+    void setRateLimit(int maxRepeats, double interval) {
+        std::lock_guard<std::mutex> lck(outMtx);
+        sweepRates(toSeconds(std::chrono::system_clock::now()) + repeatInterval);
+        flog::maxRepeats = std::max<int>(maxRepeats, 0);
+        repeatInterval = interval;
+    }
+
+    bool setLogFile(const std::string& path, size_t maxSize, int maxFiles) {
+        std::lock_guard<std::mutex> lck(outMtx);
+        if (logFile) {
+            fclose(logFile);
+            logFile = NULL;
+        }
+        logPath = path;
+        logMaxSize = maxSize;
+        logMaxFiles = std::max<int>(maxFiles, 0);
+        if (path.empty()) { return true; }
+
+        logFile = fopen(path.c_str(), "a");
+        if (!logFile) { return false; }
+        fseek(logFile, 0, SEEK_END);
+        long size = ftell(logFile);
+        logSize = (size > 0) ? size : 0;
+        return true;
+    }
+
+    // Flush the queues and close the file when the program exits without disabling async mode
+    struct ExitFlusher {
+        ~ExitFlusher() {
+            setAsync(false);
+            setLogFile("", 0, 0);
+        }
+    };
+    ExitFlusher exitFlusher;
+
     std::string __toString__(bool value) {
         return value ? "true" : "false";
     }
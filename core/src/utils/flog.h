@@ -1,7 +1,9 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <utility>
 #include <stdint.h>
+#include <stddef.h>
 
 namespace flog {
     enum Type {
@@ -13,7 +15,20 @@ namespace flog {
     };
 
     // IO functions
-    void __log__(Type type, const char* fmt, const std::vector<std::string>& args);
+    void __log__(Type type, const char* fmt, std::vector<std::string>&& args);
+
+    // In async mode, the calling thread only queues the message and its arguments, the formatting and the output being
+    // done by a logger thread. Messages are dropped if the queue of the thread is full. Disabling it flushes the queues
+    void setAsync(bool enabled);
+    bool isAsync();
+
+    // Identical messages logged more than maxRepeats times within the interval (in seconds) are suppressed, their count
+    // being logged at the end of the interval. A maxRepeats of zero disables the limit
+    void setRateLimit(int maxRepeats, double interval);
+
+    // Also write the log to a file. Once it reaches maxSize bytes, it's renamed with a .1 suffix, up to maxFiles old
+    // files being kept. An empty path closes the file. Returns false if the file couldn't be opened
+    bool setLogFile(const std::string& path, size_t maxSize, int maxFiles);
 
     // Conversion functions
     std::string __toString__(bool value);
@@ -52,7 +67,7 @@ namespace flog {
         std::vector<std::string> _args;
         _args.reserve(sizeof...(args));
         __genArgList__(_args, args...);
-        __log__(type, fmt, _args);
+        __log__(type, fmt, std::move(_args));
     }
 
     template <typename... Args>
@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+namespace net {
+    // Puts back in order the datagrams of a stream numbered by the sender. Datagrams in order go through right away,
+    // those following a missing one are held until it comes in. A datagram is given up on once depth datagrams after it
+    // were received, so that the latency added is bounded. Sequences wrap at modulo, which doesn't have to be a power of two
+    class JitterBuffer {
+    public:
+        struct Stats {
+            uint64_t received = 0;
+            uint64_t reordered = 0;     // Received after a later datagram and put back in its place
+            uint64_t lost = 0;          // Given up on
+            uint64_t late = 0;          // Received after being given up on, or duplicates
+        };
+
+        JitterBuffer(int depth, int maxSize, uint64_t modulo = 0x100000000ull) {
+            _depth = depth;
+            _maxSize = maxSize;
+            _modulo = modulo;
+            buffer.resize((size_t)depth * maxSize);
+            sizes.assign(depth, -1);
+        }
+
+        // Queue a datagram. handler(data, size, missing) is called for every datagram that can be released, in order,
+        // missing being the number of datagrams given up on just before it
+        template <class Handler>
+        void push(uint64_t seq, const uint8_t* data, int size, Handler&& handler) {
+            stats.received++;
+            if (!started) {
+                expected = seq;
+                started = true;
+            }
+
+            // Position relative to the next datagram to release, those from before it having been released or given up on
+            uint64_t dist = (seq + _modulo - expected) % _modulo;
+            if (dist >= _modulo / 2) {
+                // A sender that restarted its numbering is followed once it's clear that it's not just late datagrams
+                if (++lateRun <= 2 * _depth) {
+                    stats.late++;
+                    return;
+                }
+                flush(handler);
+                expected = seq;
+                dist = 0;
+            }
+            lateRun = 0;
+
+            // Following a jump larger than the window, release what's held and start over from this datagram
+            if (dist >= 2 * (uint64_t)_depth) {
+                flush(handler);
+                uint64_t gap = (seq + _modulo - expected) % _modulo;
+                stats.lost += gap;
+                missing += gap;
+                expected = seq;
+                dist = 0;
+            }
+
+            // Give up on the oldest datagrams until this one fits in the window
+            while (dist >= (uint64_t)_depth) {
+                release(handler);
+                dist--;
+            }
+
+            int slot = (head + (int)dist) % _depth;
+            if (sizes[slot] >= 0) {
+                stats.late++;
+                return;
+            }
+            if (dist) { stats.reordered++; }
+            size = std::min<int>(size, _maxSize);
+            memcpy(&buffer[(size_t)slot * _maxSize], data, size);
+            sizes[slot] = size;
+
+            // Release the datagrams now in order
+            while (sizes[head] >= 0) { release(handler); }
+        }
+
+        // Release every datagram held, in order, returning their count
+        template <class Handler>
+        int flush(Handler&& handler) {
+            int held = 0;
+            for (int i = 0; i < _depth; i++) {
+                if (sizes[(head + i) % _depth] >= 0) { held++; }
+            }
+            int left = held;
+            while (left) {
+                if (sizes[head] >= 0) { left--; }
+                release(handler);
+            }
+            return held;
+        }
+
+        void reset() {
+            sizes.assign(_depth, -1);
+            head = 0;
+            missing = 0;
+            lateRun = 0;
+            started = false;
+        }
+
+        Stats getStats() { return stats; }
+
+    private:
+        // Release the datagram at the head of the window, or count it as lost if it never came
+        template <class Handler>
+        void release(Handler&& handler) {
+            if (sizes[head] >= 0) {
+                handler(&buffer[(size_t)head * _maxSize], sizes[head], missing);
+                sizes[head] = -1;
+                missing = 0;
+            }
+            else {
+                missing++;
+                stats.lost++;
+            }
+            head = (head + 1) % _depth;
+            expected = (expected + 1) % _modulo;
+        }
+
+        int _depth;
+        int _maxSize;
+        uint64_t _modulo;
+        std::vector<uint8_t> buffer;
+        std::vector<int> sizes;
+        int head = 0;
+        uint64_t expected = 0;
+        uint64_t missing = 0;
+        int lateRun = 0;
+        bool started = false;
+        Stats stats;
+    };
+}
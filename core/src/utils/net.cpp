@@ -109,6 +109,33 @@ namespace net {
         addr.sin_port = htons(port);
     }
 
+    bool Address::isMulticast() const {
+        return (getIP() >> 28) == 0xE;
+    }
+
+    // === DatagramBatch functions ===
+
+    DatagramBatch::DatagramBatch(int count, int maxSize) {
+        _count = count;
+        _maxSize = maxSize;
+        buffer.resize((size_t)count * maxSize);
+        sizes.resize(count);
+        sources.resize(count);
+#ifdef __linux__
+        msgs.resize(count);
+        iovs.resize(count);
+        for (int i = 0; i < count; i++) {
+            iovs[i].iov_base = data(i);
+            iovs[i].iov_len = maxSize;
+            memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &sources[i].addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+#endif
+    }
+
     // === Socket functions ===
 
     Socket::Socket(SockHandle_t sock, const Address* raddr) {
@@ -154,6 +181,34 @@ namespace net {
         return send((const uint8_t*)str.c_str(), str.length(), dest);
     }
 
+    bool Socket::setRecvBufferSize(int size) {
+#ifdef _WIN32
+        return !setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&size, sizeof(int));
+#else
+        return !setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(int));
+#endif
+    }
+
+    bool Socket::setBusyPoll(int usec) {
+#ifdef SO_BUSY_POLL
+        if (setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(int))) { return false; }
+        busyPoll = (usec > 0);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool Socket::setMulticastTTL(int ttl) {
+#ifdef _WIN32
+        DWORD val = ttl;
+        return !setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&val, sizeof(DWORD));
+#else
+        unsigned char val = ttl;
+        return !setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &val, sizeof(unsigned char));
+#endif
+    }
+
     int Socket::recv(uint8_t* data, size_t maxLen, bool forceLen, int timeout, Address* dest) {
         // Create FD set
         fd_set set;
@@ -190,6 +245,51 @@ namespace net {
         return read;
     }
 
+    // Returns false on timeout or error. A timeout of NONBLOCKING only checks for a datagram
+    bool Socket::waitReadable(int timeout) {
+        fd_set set;
+        FD_ZERO(&set);
+        FD_SET(sock, &set);
+        timeval tv;
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout - tv.tv_sec*1000) * 1000;
+        return select(sock+1, &set, NULL, &set, (timeout != NO_TIMEOUT) ? &tv : NULL) > 0;
+    }
+
+    int Socket::recvBatch(DatagramBatch& batch, int timeout) {
+#ifdef __linux__
+        // Busy polling only happens in a receive call, the first datagram is then waited for by recvmmsg itself
+        bool waitInRecv = (busyPoll && timeout == NO_TIMEOUT);
+        if (timeout != NONBLOCKING && !waitInRecv && !waitReadable(timeout)) { return 0; }
+
+        // The address lengths are overwritten by each call
+        for (int i = 0; i < batch._count; i++) { batch.msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in); }
+        int count = ::recvmmsg(sock, batch.msgs.data(), batch._count, waitInRecv ? MSG_WAITFORONE : MSG_DONTWAIT, NULL);
+        if (count < 0) {
+            if (!WOULD_BLOCK) { close(); }
+            return -1;
+        }
+        for (int i = 0; i < count; i++) { batch.sizes[i] = batch.msgs[i].msg_len; }
+        return count;
+#else
+        // Without recvmmsg, receive datagrams one by one for as long as more are queued
+        if (timeout != NONBLOCKING && !waitReadable(timeout)) { return 0; }
+        int count = 0;
+        while (count < batch._count) {
+            if (count && !waitReadable(NONBLOCKING)) { break; }
+            socklen_t addrLen = sizeof(sockaddr_in);
+            int err = ::recvfrom(sock, (char*)batch.data(count), batch._maxSize, 0, (sockaddr*)&batch.sources[count].addr, &addrLen);
+            if (err < 0) {
+                if (count) { break; }
+                if (!WOULD_BLOCK) { close(); }
+                return -1;
+            }
+            batch.sizes[count++] = err;
+        }
+        return count;
+#endif
+    }
+
     int Socket::recvline(std::string& str, int maxLen, int timeout, Address* dest) {
         // Disallow nonblocking mode
         if (!timeout) { return -1; }
@@ -380,6 +480,48 @@ namespace net {
         return std::make_shared<Socket>(s);
     }
 
+    std::shared_ptr<Socket> connect(const Address& addr, int timeout) {
+        // Init library if needed
+        init();
+
+        // Create socket, nonblocking from the start so that the connection can be waited for
+        SockHandle_t s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        setNonblocking(s);
+
+        // Start connecting
+        if (::connect(s, (sockaddr*)&addr.addr, sizeof(sockaddr_in))) {
+#ifdef _WIN32
+            bool pending = (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+            bool pending = (errno == EINPROGRESS);
+#endif
+            if (!pending) {
+                closeSocket(s);
+                throw std::runtime_error("Could not connect");
+            }
+
+            // Wait for the socket to become writable, then check if that's because it connected
+            fd_set wset, eset;
+            FD_ZERO(&wset);
+            FD_ZERO(&eset);
+            FD_SET(s, &wset);
+            FD_SET(s, &eset);
+            timeval tv;
+            tv.tv_sec = timeout / 1000;
+            tv.tv_usec = (timeout - tv.tv_sec*1000) * 1000;
+            int err = select(s+1, NULL, &wset, &eset, &tv);
+            int sockErr = 0;
+            socklen_t len = sizeof(sockErr);
+            if (err <= 0 || getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&sockErr, &len) || sockErr) {
+                closeSocket(s);
+                throw std::runtime_error(err ? "Could not connect" : "Timed out while connecting");
+            }
+        }
+
+        // Return socket class
+        return std::make_shared<Socket>(s);
+    }
+
     std::shared_ptr<Socket> connect(std::string host, int port) {
         return connect(Address(host, port));
     }
@@ -4,6 +4,7 @@
 #include <mutex>
 #include <memory>
 #include <map>
+#include <vector>
 
 #ifdef _WIN32
 #include <WinSock2.h>
@@ -20,8 +21,15 @@
 #include <poll.h>
 #include <fcntl.h>
 #include <ifaddrs.h>
+#include <sys/uio.h>
 #endif
 
+// Largest UDP payload over IPv4
+#define NET_MAX_DATAGRAM_SIZE   65507
+
+// Receive buffer size requested by sources streaming samples over UDP, enough for a few hundred ms at several MS/s
+#define NET_UDP_STREAM_BUFFER_SIZE  (8 * 1024 * 1024)
+
 namespace net {
 #ifdef _WIN32
     typedef SOCKET SockHandle_t;
@@ -33,6 +41,7 @@ namespace net {
 
     class Socket;
     class Listener;
+    class DatagramBatch;
 
     struct InterfaceInfo {
         IP_t address;
@@ -43,6 +52,7 @@ namespace net {
     class Address {
         friend Socket;
         friend Listener;
+        friend DatagramBatch;
     public:
         /**
          * Default constructor. Corresponds to 0.0.0.0:0.
@@ -87,6 +97,12 @@ namespace net {
          */
         int getPort() const;
 
+        /**
+         * Check if the address is an IPv4 multicast address (224.0.0.0/4).
+         * @return True if multicast, false otherwise.
+         */
+        bool isMulticast() const;
+
         /**
          * Set the TCP/UDP port.
          * @param port TCP/UDP port number.
@@ -106,6 +122,53 @@ namespace net {
         SOCKET_TYPE_UDP
     };
 
+    /**
+     * Storage for the datagrams received at once by Socket::recvBatch().
+     */
+    class DatagramBatch {
+        friend Socket;
+    public:
+        /**
+         * @param count Maximum number of datagrams received at once.
+         * @param maxSize Maximum size of a datagram in bytes, longer ones are truncated.
+         */
+        DatagramBatch(int count, int maxSize = NET_MAX_DATAGRAM_SIZE);
+
+        /**
+         * Get the contents of a received datagram.
+         * @param i Index of the datagram, from 0 to the count returned by the last receive.
+         * @return Pointer to its data.
+         */
+        uint8_t* data(int i) { return &buffer[(size_t)i * _maxSize]; }
+
+        /**
+         * Get the size of a received datagram.
+         * @param i Index of the datagram.
+         * @return Size in bytes.
+         */
+        int size(int i) const { return sizes[i]; }
+
+        /**
+         * Get the address a received datagram came from.
+         * @param i Index of the datagram.
+         * @return Source address.
+         */
+        const Address& source(int i) const { return sources[i]; }
+
+        int capacity() const { return _count; }
+
+    private:
+        int _count;
+        int _maxSize;
+        std::vector<uint8_t> buffer;
+        std::vector<int> sizes;
+        std::vector<Address> sources;
+#ifdef __linux__
+        std::vector<mmsghdr> msgs;
+        std::vector<iovec> iovs;
+#endif
+    };
+
     class Socket {
     public:
         /**
@@ -125,6 +188,29 @@ namespace net {
          */
         bool isOpen();
 
+        /**
+         * Set the size of the receive buffer of the socket. The OS may cap it.
+         * @param size Size in bytes.
+         * @return True on success, false otherwise.
+         */
+        bool setRecvBufferSize(int size);
+
+        /**
+         * Have the kernel poll the network device for up to the given time before sleeping when no datagram is
+         * queued, cutting the wakeup latency at the cost of CPU time. Only on Linux, and only used by receptions
+         * without timeout. Raising it above the net.core.busy_read sysctl requires CAP_NET_ADMIN.
+         * @param usec Time to busy poll for in microseconds, 0 to disable.
+         * @return True on success, false otherwise.
+         */
+        bool setBusyPoll(int usec);
+
+        /**
+         * Set the number of hops multicast packets sent on this socket can go through.
+         * @param ttl Time to live, 1 to stay on the local network.
+         * @return True on success, false otherwise.
+         */
+        bool setMulticastTTL(int ttl);
+
         /**
          * Get socket type. Either TCP or UDP.
          * @return Socket type.
@@ -169,10 +255,22 @@ namespace net {
          */
         int recvline(std::string& str, int maxLen = 0, int timeout = NO_TIMEOUT, Address* dest = NULL);
 
+        /**
+         * Receive every datagram already queued on a UDP socket, up to the capacity of the batch, after waiting for
+         * the first one. On Linux this takes a single recvmmsg system call instead of one per datagram.
+         * @param batch Batch to receive the datagrams into.
+         * @param timeout Timeout in milliseconds for the first datagram. Use NO_TIMEOUT or NONBLOCKING here if needed.
+         * @return Number of datagrams received. 0 means timed out or closed. -1 means would block or error.
+         */
+        int recvBatch(DatagramBatch& batch, int timeout = NO_TIMEOUT);
+
     private:
+        bool waitReadable(int timeout);
+
         Address* raddr = NULL;
         SockHandle_t sock;
         bool open = true;
+        bool busyPoll = false;
 
     };
 
@@ -236,6 +334,14 @@ namespace net {
      */
     std::shared_ptr<Socket> connect(const Address& addr);  
 
+    /**
+     * Create TCP connection, giving up if not established in time.
+     * @param addr Remote address.
+     * @param timeout Timeout in milliseconds.
+     * @return Socket instance on success, Throws runtime_error otherwise.
+     */
+    std::shared_ptr<Socket> connect(const Address& addr, int timeout);
+
     /**
      * Create TCP connection.
      * @param host Remote hostname or IP address.
@@ -1,6 +1,7 @@
 #include <utils/networking.h>
 #include <assert.h>
 #include <utils/flog.h>
+#include <dsp/thread_role.h>
 #include <stdexcept>
 
 namespace net {
@@ -64,14 +65,38 @@ namespace net {
         connectionOpenCnd.wait(lck, [this]() { return !connectionOpen; });
     }
 
+    uint16_t ConnClass::getLocalPort() {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        if (getsockname(_sock, (struct sockaddr*)&addr, &len)) { return 0; }
+        return ntohs(addr.sin_port);
+    }
+
+    struct sockaddr_in ConnClass::getLastSender() {
+        std::lock_guard lck(remoteMtx);
+        return lastSender;
+    }
+
+    struct sockaddr_in ConnClass::getRemoteAddr() {
+        std::lock_guard lck(remoteMtx);
+        return remoteAddr;
+    }
+
+    void ConnClass::setRemoteAddr(const struct sockaddr_in& addr) {
+        std::lock_guard lck(remoteMtx);
+        remoteAddr = addr;
+    }
+
     int ConnClass::read(int count, uint8_t* buf, bool enforceSize) {
         if (!connectionOpen) { return -1; }
         std::lock_guard lck(readMtx);
         int ret;
 
         if (_udp) {
-            socklen_t fromLen = sizeof(remoteAddr);
-            ret = recvfrom(_sock, (char*)buf, count, 0, (struct sockaddr*)&remoteAddr, &fromLen);
+            // The sender is only remembered, it's up to the owner to decide whether to send to it
+            struct sockaddr_in from = {};
+            socklen_t fromLen = sizeof(from);
+            ret = recvfrom(_sock, (char*)buf, count, 0, (struct sockaddr*)&from, &fromLen);
             if (ret <= 0) {
                 {
                     std::lock_guard lck(connectionOpenMtx);
@@ -80,7 +105,11 @@ namespace net {
                 connectionOpenCnd.notify_all();
                 return -1;
             }
-            return count;
+            {
+                std::lock_guard lck(remoteMtx);
+                lastSender = from;
+            }
+            return ret;
         }
 
         int beenRead = 0;
@@ -110,7 +139,8 @@ namespace net {
         int ret;
 
         if (_udp) {
-            ret = sendto(_sock, (char*)buf, count, 0, (struct sockaddr*)&remoteAddr, sizeof(remoteAddr));
+            struct sockaddr_in addr = getRemoteAddr();
+            ret = sendto(_sock, (char*)buf, count, 0, (struct sockaddr*)&addr, sizeof(addr));
             if (ret <= 0) {
                 {
                     std::lock_guard lck(connectionOpenMtx);
@@ -123,7 +153,7 @@ namespace net {
 
         int beenWritten = 0;
         while (beenWritten < count) {
-            ret = send(_sock, (char*)buf, count, 0);
+            ret = send(_sock, (char*)&buf[beenWritten], count - beenWritten, 0);
             if (ret <= 0) {
                 {
                     std::lock_guard lck(connectionOpenMtx);
@@ -138,6 +168,72 @@ namespace net {
         return true;
     }
 
+    bool ConnClass::writev(const ConnBuffer* bufs, int bufCount) {
+        if (!connectionOpen) { return false; }
+        std::lock_guard lck(writeMtx);
+
+        // Build the list of buffers
+#ifdef _WIN32
+        std::vector<WSABUF> vecs(bufCount);
+        for (int i = 0; i < bufCount; i++) {
+            vecs[i].buf = (char*)bufs[i].buf;
+            vecs[i].len = bufs[i].count;
+        }
+#else
+        std::vector<iovec> vecs(bufCount);
+        for (int i = 0; i < bufCount; i++) {
+            vecs[i].iov_base = (void*)bufs[i].buf;
+            vecs[i].iov_len = bufs[i].count;
+        }
+#endif
+
+        // Write until all buffers are sent, skipping over what was already written after a partial write
+        struct sockaddr_in addr = {};
+        if (_udp) { addr = getRemoteAddr(); }
+        int first = 0;
+        while (first < bufCount) {
+#ifdef _WIN32
+            DWORD sent = 0;
+            int err = _udp ? WSASendTo(_sock, &vecs[first], bufCount - first, &sent, 0, (struct sockaddr*)&addr, sizeof(addr), NULL, NULL)
+                           : WSASend(_sock, &vecs[first], bufCount - first, &sent, 0, NULL, NULL);
+            int ret = err ? -1 : (int)sent;
+#else
+            msghdr msg = {};
+            msg.msg_name = _udp ? &addr : NULL;
+            msg.msg_namelen = _udp ? sizeof(addr) : 0;
+            msg.msg_iov = &vecs[first];
+            msg.msg_iovlen = bufCount - first;
+            int ret = sendmsg(_sock, &msg, 0);
+#endif
+            if (ret <= 0) {
+                {
+                    std::lock_guard lck(connectionOpenMtx);
+                    connectionOpen = false;
+                }
+                connectionOpenCnd.notify_all();
+                return false;
+            }
+            if (_udp) { return true; }
+
+            // Move past the written data
+#ifdef _WIN32
+            while (first < bufCount && ret >= (int)vecs[first].len) { ret -= vecs[first++].len; }
+            if (first < bufCount) {
+                vecs[first].buf += ret;
+                vecs[first].len -= ret;
+            }
+#else
+            while (first < bufCount && ret >= (int)vecs[first].iov_len) { ret -= vecs[first++].iov_len; }
+            if (first < bufCount) {
+                vecs[first].iov_base = (uint8_t*)vecs[first].iov_base + ret;
+                vecs[first].iov_len -= ret;
+            }
+#endif
+        }
+
+        return true;
+    }
+
     void ConnClass::readAsync(int count, uint8_t* buf, void (*handler)(int count, uint8_t* buf, void* ctx), void* ctx, bool enforceSize) {
         if (!connectionOpen) { return; }
         // Create entry
@@ -158,24 +254,45 @@ namespace net {
         readQueueCnd.notify_all();
     }
 
-    void ConnClass::writeAsync(int count, uint8_t* buf) {
-        if (!connectionOpen) { return; }
+    bool ConnClass::writeAsync(int count, uint8_t* buf) {
+        if (!connectionOpen) { return false; }
         // Create entry
         ConnWriteEntry entry;
         entry.count = count;
         entry.buf = buf;
 
-        // Add entry to queue
+        // Add entry to queue unless it's full
         {
             std::lock_guard lck(writeQueueMtx);
+            if (maxWriteQueue && writeQueue.size() >= maxWriteQueue) {
+                droppedWrites++;
+                return false;
+            }
             writeQueue.push_back(entry);
         }
 
         // Notify write worker
         writeQueueCnd.notify_all();
+        return true;
+    }
+
+    void ConnClass::setMaxWriteQueue(int size) {
+        std::lock_guard lck(writeQueueMtx);
+        maxWriteQueue = size;
+    }
+
+    int ConnClass::getWriteQueueDepth() {
+        std::lock_guard lck(writeQueueMtx);
+        return writeQueue.size();
+    }
+
+    uint64_t ConnClass::getDroppedWrites() {
+        std::lock_guard lck(writeQueueMtx);
+        return droppedWrites;
     }
 
     void ConnClass::readWorker() {
+        dsp::applyThreadRole(dsp::THREAD_ROLE_IO);
         while (true) {
             // Wait for wakeup and exit if it's for terminating the thread
             std::unique_lock lck(readQueueMtx);
@@ -202,6 +319,7 @@ namespace net {
     }
 
     void ConnClass::writeWorker() {
+        dsp::applyThreadRole(dsp::THREAD_ROLE_IO);
         while (true) {
             // Wait for wakeup and exit if it's for terminating the thread
             std::unique_lock lck(writeQueueMtx);
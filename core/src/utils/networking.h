@@ -16,6 +16,7 @@
 #include <strings.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <signal.h>
@@ -41,6 +42,12 @@ namespace net {
         uint8_t* buf;
     };
 
+    // One of the buffers of a vectored write
+    struct ConnBuffer {
+        const uint8_t* buf;
+        int count;
+    };
+
     class ConnClass {
     public:
         ConnClass(Socket sock, struct sockaddr_in raddr = {}, bool udp = false);
@@ -50,10 +57,33 @@ namespace net {
         bool isOpen();
         void waitForEnd();
 
+        // Port the socket is bound to, useful when it was bound to port 0
+        uint16_t getLocalPort();
+
+        // Address the last datagram of a UDP socket came from. Read handlers run on the thread that did the read, so
+        // from one it's the sender of the datagram being handled
+        struct sockaddr_in getLastSender();
+
+        // Address the datagrams of a UDP socket are sent to. Receiving doesn't change it
+        struct sockaddr_in getRemoteAddr();
+        void setRemoteAddr(const struct sockaddr_in& addr);
+
         int read(int count, uint8_t* buf, bool enforceSize = true);
         bool write(int count, uint8_t* buf);
+
+        // Write several buffers back to back with a single system call, so that a header and its payload don't need to
+        // be copied next to each other first. For UDP they are sent as a single datagram
+        bool writev(const ConnBuffer* bufs, int bufCount);
+
         void readAsync(int count, uint8_t* buf, void (*handler)(int count, uint8_t* buf, void* ctx), void* ctx, bool enforceSize = true);
-        void writeAsync(int count, uint8_t* buf);
+
+        // Returns false and drops the write if the queue already holds the maximum number of writes
+        bool writeAsync(int count, uint8_t* buf);
+
+        // Maximum number of queued asynchronous writes, 0 for no limit
+        void setMaxWriteQueue(int size);
+        int getWriteQueueDepth();
+        uint64_t getDroppedWrites();
 
     private:
         void readWorker();
@@ -73,12 +103,16 @@ namespace net {
         std::condition_variable connectionOpenCnd;
         std::vector<ConnReadEntry> readQueue;
         std::vector<ConnWriteEntry> writeQueue;
+        int maxWriteQueue = 0;
+        uint64_t droppedWrites = 0;
         std::thread readWorkerThread;
         std::thread writeWorkerThread;
 
         Socket _sock;
         bool _udp;
+        std::mutex remoteMtx;
         struct sockaddr_in remoteAddr;
+        struct sockaddr_in lastSender = {};
     };
 
     typedef std::unique_ptr<ConnClass> Conn;
@@ -1,20 +1,28 @@
 #pragma once
 #include <functional>
 #include <stdexcept>
-#include <mutex>
-#include <map>
+#include <algorithm>
+#include <utility>
+#include <utils/cow_list.h>
 
 typedef int HandlerID;
 
+// Emitting is lock free, see CowList. Handlers are called in the order of their IDs
 template <typename... Args>
 class NewEvent {
 public:
     using Handler = std::function<void(Args...)>;
 
     HandlerID bind(const Handler& handler) {
-        std::lock_guard<std::mutex> lck(mtx);
-        HandlerID id = genID();
-        handlers[id] = handler;
+        HandlerID id;
+        handlers.modify([&](std::vector<Entry>& list) {
+            // Use the lowest free ID, the list being sorted by ID
+            id = 1;
+            auto it = list.begin();
+            for (; it != list.end() && it->first == id; it++) { id++; }
+            list.insert(it, { id, handler });
+            return true;
+        });
         return id;
     }
 
@@ -26,27 +34,24 @@ public:
     }
 
     void unbind(HandlerID id) {
-        std::lock_guard<std::mutex> lck(mtx);
-        if (handlers.find(id) == handlers.end()) {
+        bool found = handlers.modify([&](std::vector<Entry>& list) {
+            auto it = std::find_if(list.begin(), list.end(), [id](const Entry& e) { return e.first == id; });
+            if (it == list.end()) { return false; }
+            list.erase(it);
+            return true;
+        });
+        if (!found) {
             throw std::runtime_error("Could not unbind handler, unknown ID");
         }
-        handlers.erase(id);
     }
 
     void operator()(Args... args) {
-        std::lock_guard<std::mutex> lck(mtx);
-        for (const auto& [desc, handler] : handlers) {
-            handler(args...);
-        }
+        handlers.forEach([&](const Entry& e) {
+            e.second(args...);
+        });
     }
 
 private:
-    HandlerID genID() {
-        int id;
-        for (id = 1; handlers.find(id) != handlers.end(); id++);
-        return id;
-    }
-
-    std::map<HandlerID, Handler> handlers;
-    std::mutex mtx;
-};
\ No newline at end of file
+    typedef std::pair<HandlerID, Handler> Entry;
+    CowList<Entry> handlers;
+};
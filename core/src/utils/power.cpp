@@ -0,0 +1,135 @@
+#include "power.h"
+#include <dsp/thread_role.h>
+#include <utils/flog.h>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+namespace power {
+    // Kind of cores each role is placed on by the power aware profile
+    static const bool onPerformanceCores[dsp::_THREAD_ROLE_COUNT] = {
+        true,   // Source
+        true,   // Wideband
+        false,  // VFO
+        true,   // Audio, short callbacks that must not be late
+        false,  // GUI
+        false   // IO
+    };
+
+    static const char* profileNames[] = { "default", "power_aware" };
+
+    static std::mutex profileMtx;
+    static Profile currentProfile = PROFILE_DEFAULT;
+    static bool basePoliciesSaved = false;
+    static dsp::ThreadPolicy basePolicies[dsp::_THREAD_ROLE_COUNT];
+
+#if defined(_WIN32) || defined(__APPLE__)
+    void getCoreClasses(std::vector<int>& performance, std::vector<int>& efficiency) {
+        performance.clear();
+        efficiency.clear();
+    }
+#else
+    static long readNumber(const std::string& path) {
+        std::ifstream file(path);
+        long value = -1;
+        if (!(file >> value)) { return -1; }
+        return value;
+    }
+
+    // Cores are told apart by the capacity the scheduler gives them, or by their highest frequency on kernels without it
+    void getCoreClasses(std::vector<int>& performance, std::vector<int>& efficiency) {
+        performance.clear();
+        efficiency.clear();
+        std::vector<std::pair<int, long>> cores;
+        for (int cpu = 0; std::filesystem::exists("/sys/devices/system/cpu/cpu" + std::to_string(cpu)); cpu++) {
+            std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+            long capacity = readNumber(dir + "/cpu_capacity");
+            if (capacity < 0) { capacity = readNumber(dir + "/cpufreq/cpuinfo_max_freq"); }
+            if (capacity < 0) { return; }
+            cores.push_back({ cpu, capacity });
+        }
+        if (cores.empty()) { return; }
+
+        long top = 0;
+        for (const auto& [cpu, capacity] : cores) { top = std::max<long>(top, capacity); }
+        for (const auto& [cpu, capacity] : cores) {
+            (capacity == top ? performance : efficiency).push_back(cpu);
+        }
+        if (efficiency.empty()) { performance.clear(); }
+    }
+#endif
+
+#if defined(_WIN32)
+    bool onBattery() {
+        SYSTEM_POWER_STATUS status;
+        if (!GetSystemPowerStatus(&status)) { return false; }
+        return status.ACLineStatus == 0;
+    }
+#elif defined(__APPLE__)
+    bool onBattery() {
+        return false;
+    }
+#else
+    static std::string readLine(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    // On battery when no external supply is online and a battery is discharging
+    bool onBattery() {
+        std::error_code ec;
+        bool discharging = false;
+        for (const auto& entry : std::filesystem::directory_iterator("/sys/class/power_supply", ec)) {
+            std::string type = readLine(entry.path() / "type");
+            if (type == "Battery") {
+                if (readLine(entry.path() / "status") == "Discharging") { discharging = true; }
+            }
+            else if (readLine(entry.path() / "online") == "1") {
+                return false;
+            }
+        }
+        return discharging;
+    }
+#endif
+
+    void setProfile(Profile profile) {
+        std::lock_guard<std::mutex> lck(profileMtx);
+        if (!basePoliciesSaved) {
+            for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) { basePolicies[i] = dsp::getThreadPolicy((dsp::ThreadRole)i); }
+            basePoliciesSaved = true;
+        }
+        currentProfile = profile;
+
+        std::vector<int> performance, efficiency;
+        if (profile == PROFILE_POWER_AWARE) {
+            getCoreClasses(performance, efficiency);
+            if (performance.empty()) { flog::info("All cores are alike, the power aware profile leaves the threads where they are"); }
+        }
+
+        for (int i = 0; i < dsp::_THREAD_ROLE_COUNT; i++) {
+            dsp::ThreadPolicy policy = basePolicies[i];
+            if (!performance.empty() && policy.cpus.empty() && policy.numaNode < 0) {
+                policy.cpus = onPerformanceCores[i] ? performance : efficiency;
+            }
+            dsp::setThreadPolicy((dsp::ThreadRole)i, policy);
+        }
+    }
+
+    Profile getProfile() {
+        std::lock_guard<std::mutex> lck(profileMtx);
+        return currentProfile;
+    }
+
+    const char* profileName(Profile profile) {
+        if (profile < 0 || profile > PROFILE_POWER_AWARE) { return "default"; }
+        return profileNames[profile];
+    }
+}
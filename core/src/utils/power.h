@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+
+// Power profiles, for devices running from a battery and SoCs with cores of different kinds (big.LITTLE and the like)
+namespace power {
+    enum Profile {
+        PROFILE_DEFAULT,        // Threads placed as the config says, nothing reduced on battery
+        PROFILE_POWER_AWARE
+    };
+
+    // CPUs of the fastest kind of cores and of the others. Both are empty when all cores are alike or they can't be
+    // told apart, which is the case everywhere but on Linux and Android
+    void getCoreClasses(std::vector<int>& performance, std::vector<int>& efficiency);
+
+    // Whether the device runs from its battery, false when it has none or it can't be told
+    bool onBattery();
+
+    // The power aware profile places the threads running at the samplerate of the source and the audio callbacks on
+    // the performance cores, and the decoders, the UI and the I/O on the efficiency cores. Roles given CPUs or a NUMA
+    // node in the config keep them. Must be called once the thread policies of the config are set
+    void setProfile(Profile profile);
+    Profile getProfile();
+
+    // Name of the profile in the config
+    const char* profileName(Profile profile);
+}
@@ -1,5 +1,12 @@
 #include "http.h"
 #include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+// Longest header line and number of header lines accepted, so that a peer can't make a header grow without bounds
+#define HTTP_MAX_LINE_LENGTH    8192
+#define HTTP_MAX_HEADER_LINES   128
 
 namespace net::http {
     std::string MessageHeader::serialize() {
@@ -119,7 +126,30 @@ namespace net::http {
     }
 
     void RequestHeader::deserializeStartLine(const std::string& data) {
-        // TODO
+        // Parse method, unknown ones leaving it unchanged
+        int offset = 0;
+        for (; offset < data.size(); offset++) {
+            if (data[offset] == ' ') { break; }
+        }
+        std::string methodStr = data.substr(0, offset);
+        for (const auto& [m, str] : MethodStrings) {
+            if (str == methodStr) {
+                method = m;
+                break;
+            }
+        }
+
+        // Skip spaces
+        for (; offset < data.size(); offset++) {
+            if (data[offset] != ' ' && data[offset] != '\t') { break; }
+        }
+
+        // Parse URI, the version that follows is ignored
+        int uriOffset = offset;
+        for (; offset < data.size(); offset++) {
+            if (data[offset] == ' ') { break; }
+        }
+        uri = data.substr(uriOffset, offset - uriOffset);
     }
 
     std::string RequestHeader::serializeStartLine() {
@@ -238,6 +268,106 @@ namespace net::http {
         this->length = length;
     }
 
+    ChunkedReader::ChunkedReader(std::shared_ptr<Socket> sock, size_t bufferSize) {
+        this->sock = sock;
+        buffer.resize(std::max<size_t>(bufferSize, HTTP_MAX_LINE_LENGTH));
+    }
+
+    int64_t ChunkedReader::nextChunk(int timeout) {
+        // Skip what's left of the current chunk and its trailing CRLF
+        if (inChunk) {
+            while (chunkLeft) {
+                size_t len = std::min<size_t>(tail - head, chunkLeft);
+                head += len;
+                chunkLeft -= len;
+                if (chunkLeft && fill(timeout) <= 0) { return -1; }
+            }
+            inChunk = false;
+            const char* crlf;
+            int len = line(crlf, 2, timeout);
+            if (len < 0 || len > 1 || (len == 1 && crlf[0] != '\r')) { return -1; }
+        }
+
+        // Parse the length, the extensions being ignored
+        const char* hdr;
+        int len = line(hdr, HTTP_MAX_LINE_LENGTH, timeout);
+        if (len <= 0) { return -1; }
+        int64_t length = 0;
+        int digits = 0;
+        for (; digits < len && digits < 16; digits++) {
+            char c = hdr[digits];
+            int v;
+            if (c >= '0' && c <= '9') { v = c - '0'; }
+            else if (c >= 'a' && c <= 'f') { v = c - 'a' + 10; }
+            else if (c >= 'A' && c <= 'F') { v = c - 'A' + 10; }
+            else { break; }
+            length = (length << 4) | v;
+        }
+        if (!digits) { return -1; }
+
+        chunkLeft = length;
+        inChunk = (length > 0);
+        return length;
+    }
+
+    int ChunkedReader::readLine(const char*& line, int timeout) {
+        int len = this->line(line, std::min<size_t>(chunkLeft, buffer.size()), timeout);
+        if (len < 0) { return -1; }
+        chunkLeft -= len + 1;
+        return len;
+    }
+
+    int ChunkedReader::read(uint8_t* data, size_t len, int timeout) {
+        if (len > chunkLeft) { return -1; }
+
+        // Take what's already buffered, then receive the rest without going through the buffer
+        size_t buffered = std::min<size_t>(tail - head, len);
+        memcpy(data, buffer.data() + head, buffered);
+        head += buffered;
+        if (buffered < len) {
+            int err = sock->recv(&data[buffered], len - buffered, true, timeout);
+            if (err <= 0 || (size_t)err != len - buffered) { return -1; }
+        }
+        chunkLeft -= len;
+        return len;
+    }
+
+    int ChunkedReader::fill(int timeout) {
+        // Make room at the end by moving what's unread to the start
+        if (head == tail) {
+            head = 0;
+            tail = 0;
+        }
+        else if (tail == buffer.size() && head) {
+            memmove(&buffer[0], &buffer[head], tail - head);
+            tail -= head;
+            head = 0;
+        }
+        if (tail == buffer.size()) { return -1; }
+
+        int err = sock->recv(&buffer[tail], buffer.size() - tail, false, timeout);
+        if (err <= 0) { return -1; }
+        tail += err;
+        return err;
+    }
+
+    int ChunkedReader::line(const char*& line, size_t maxLen, int timeout) {
+        // Look for the end of the line in what's buffered, receiving more until it's there
+        size_t searched = 0;
+        while (true) {
+            size_t avail = std::min<size_t>(tail - head, maxLen);
+            const uint8_t* end = (const uint8_t*)memchr(buffer.data() + head + searched, '\n', avail - searched);
+            if (end) {
+                line = (const char*)&buffer[head];
+                int len = end - &buffer[head];
+                head += len + 1;
+                return len;
+            }
+            searched = avail;
+            if (avail == maxLen || fill(timeout) <= 0) { return -1; }
+        }
+    }
+
     Client::Client(std::shared_ptr<Socket> sock) {
         this->sock = sock;
     }
@@ -294,13 +424,13 @@ namespace net::http {
     }
 
     int Client::recvHeader(std::string& data, int timeout) {
-        while (sock->isOpen()) {
+        for (int i = 0; i < HTTP_MAX_HEADER_LINES && sock->isOpen(); i++) {
             std::string line;
-            int ret = sock->recvline(line);
-            if (line == "\r") { break; }
-            if (ret <= 0) { return ret; }
+            int ret = sock->recvline(line, HTTP_MAX_LINE_LENGTH, timeout);
+            if (line == "\r" || (line.empty() && ret > 0)) { return 0; }
+            if (ret <= 0) { return -1; }
             data += line + "\n";
         }
-        return 0;
+        return -1;
     }
 }
\ No newline at end of file
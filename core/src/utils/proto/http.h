@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include <string>
+#include <vector>
 #include "../net.h"
 
 namespace net::http {
@@ -214,7 +215,7 @@ namespace net::http {
         void deserializeStartLine(const std::string& data);
         std::string serializeStartLine();
 
-        Method method;
+        Method method = METHOD_OPTIONS;
         std::string uri;
     };
 
@@ -254,6 +255,63 @@ namespace net::http {
         size_t length;
     };
 
+    /**
+     * Reader of a chunked HTTP body for high rate streams. Data is received with large reads into a buffer that the
+     * chunk headers and lines are parsed from in place, bulk data being received straight into the caller's buffer.
+     */
+    class ChunkedReader {
+    public:
+        ChunkedReader() {}
+
+        /**
+         * Create a reader of the body following a response header received with Client.
+         * @param sock Socket the body is received from.
+         * @param bufferSize Size of the receive buffer, the longest line that can be read.
+         */
+        ChunkedReader(std::shared_ptr<Socket> sock, size_t bufferSize = 64 * 1024);
+
+        /**
+         * Start the next chunk. What was left unread of the current one is skipped.
+         * @param timeout Timeout in milliseconds.
+         * @return Length of the chunk, 0 for the last one, -1 on error, timeout or closed socket.
+         */
+        int64_t nextChunk(int timeout = -1);
+
+        /**
+         * Read a line of the current chunk. The line isn't null terminated and is only valid until the next call.
+         * @param line Set to the start of the line, the '\n' excluded.
+         * @param timeout Timeout in milliseconds.
+         * @return Length of the line, -1 on error, timeout or if the chunk ends before the end of the line.
+         */
+        int readLine(const char*& line, int timeout = -1);
+
+        /**
+         * Read data of the current chunk.
+         * @param data Buffer to read the data into.
+         * @param len Number of bytes to read, no more than what's left of the chunk.
+         * @param timeout Timeout in milliseconds.
+         * @return Number of bytes read, always len, -1 on error or timeout.
+         */
+        int read(uint8_t* data, size_t len, int timeout = -1);
+
+        /**
+         * Get the number of bytes left to read in the current chunk.
+         * @return Number of bytes.
+         */
+        size_t remaining() { return chunkLeft; }
+
+    private:
+        int fill(int timeout);
+        int line(const char*& line, size_t maxLen, int timeout);
+
+        std::shared_ptr<Socket> sock;
+        std::vector<uint8_t> buffer;
+        size_t head = 0;
+        size_t tail = 0;
+        size_t chunkLeft = 0;
+        bool inChunk = false;
+    };
+
     class Client {
     public:
         Client() {}
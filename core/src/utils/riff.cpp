@@ -1,11 +1,21 @@
 #include "riff.h"
 #include <string.h>
 #include <stdexcept>
+#include <utils/flog.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace riff {
     const char* RIFF_SIGNATURE      = "RIFF";
+    const char* RF64_SIGNATURE      = "RF64";
     const char* LIST_SIGNATURE      = "LIST";
+    const char* JUNK_SIGNATURE      = "JUNK";
+    const char* DS64_SIGNATURE      = "ds64";
+    const char* DATA_SIGNATURE      = "data";
     const size_t RIFF_LABEL_SIZE    = 4;
+    const uint32_t RIFF_MAX_SIZE    = 0xFFFFFFFF;
 
     // Writer::Writer(const Writer&& b) {
     //     //file = std::move(b.file);
@@ -15,16 +25,37 @@ namespace riff {
         close();
     }
 
-    bool Writer::open(std::string path, const char form[4]) {
+    bool Writer::open(std::string path, const char form[4], bool rf64) {
         std::lock_guard<std::recursive_mutex> lck(mtx);
 
         // Open file
         file = std::ofstream(path, std::ios::out | std::ios::binary);
         if (!file.is_open()) { return false; }
+        _rf64 = rf64;
+        dataSize = 0;
+        sampleCount = 0;
+        allocated = 0;
+
+#ifdef __linux__
+        // Open a descriptor on the same file to allocate its extents
+        if (_prealloc) {
+            allocFd = ::open(path.c_str(), O_WRONLY);
+            if (allocFd < 0) { flog::warn("Could not open '{}' for preallocation", path); }
+        }
+#endif
 
         // Begin RIFF chunk
         beginRIFF(form);
 
+        // Reserve room for the ds64 chunk
+        if (_rf64) {
+            DS64Body ds64 = {};
+            ds64Pos = file.tellp();
+            beginChunk(JUNK_SIGNATURE);
+            write((uint8_t*)&ds64, sizeof(DS64Body));
+            endChunk();
+        }
+
         return true;
     }
 
@@ -41,6 +72,15 @@ namespace riff {
         // Finalize RIFF chunk
         endRIFF();
 
+#ifdef __linux__
+        // Give back the extents that were allocated past the end of the data
+        if (allocFd >= 0) {
+            if (ftruncate(allocFd, file.tellp())) { flog::warn("Could not trim preallocated file"); }
+            ::close(allocFd);
+            allocFd = -1;
+        }
+#endif
+
         // Close file
         file.close();
     }
@@ -74,6 +114,7 @@ namespace riff {
         desc.pos = file.tellp();
         memcpy(desc.hdr.id, id, sizeof(desc.hdr.id));
         desc.hdr.size = 0;
+        desc.size = 0;
         file.write((char*)&desc.hdr, sizeof(ChunkHeader));
 
         // Save descriptor
@@ -91,6 +132,10 @@ namespace riff {
         ChunkDesc desc = chunks.top();
         chunks.pop();
 
+        // Sizes that don't fit are left to the ds64 chunk
+        desc.hdr.size = (desc.size > RIFF_MAX_SIZE) ? RIFF_MAX_SIZE : desc.size;
+        if (!memcmp(desc.hdr.id, DATA_SIGNATURE, RIFF_LABEL_SIZE)) { dataSize = desc.size; }
+
         // Write size
         auto pos = file.tellp();
         auto npos = desc.pos;
@@ -101,7 +146,7 @@ namespace riff {
 
         // If parent chunk, increment its size by the size of the sub-chunk plus the size of its header)
         if (!chunks.empty()) {
-            chunks.top().hdr.size += desc.hdr.size + sizeof(ChunkHeader);
+            chunks.top().size += desc.size + sizeof(ChunkHeader);
         }
     }
 
@@ -111,8 +156,35 @@ namespace riff {
         if (chunks.empty()) {
             throw std::runtime_error("No chunk to write into");
         }
+#ifdef __linux__
+        // Allocate the next extents before writing into them
+        if (allocFd >= 0) {
+            uint64_t end = (uint64_t)file.tellp() + len;
+            while (allocated < end) {
+                if (fallocate(allocFd, 0, allocated, _prealloc)) {
+                    flog::warn("Preallocation failed, disabling it");
+                    ::close(allocFd);
+                    allocFd = -1;
+                    break;
+                }
+                allocated += _prealloc;
+            }
+        }
+#endif
+
         file.write((char*)data, len);
-        chunks.top().hdr.size += len;
+        chunks.top().size += len;
+    }
+
+    void Writer::setSampleCount(uint64_t count) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        sampleCount = count;
+    }
+
+    void Writer::setPreallocation(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (file.is_open()) { throw std::runtime_error("Cannot change preallocation while file is open"); }
+        _prealloc = bytes;
     }
 
     void Writer::beginRIFF(const char form[4]) {
@@ -137,6 +209,29 @@ namespace riff {
             throw std::runtime_error("Top chunk not RIFF chunk");
         }
 
+        uint64_t riffSize = chunks.top().size;
         endChunk();
+
+        // Turn the file into an RF64 file if it is too large for RIFF
+        if (!_rf64 || (riffSize <= RIFF_MAX_SIZE && dataSize <= RIFF_MAX_SIZE)) { return; }
+        auto pos = file.tellp();
+        ChunkHeader riffHdr;
+        memcpy(riffHdr.id, RF64_SIGNATURE, RIFF_LABEL_SIZE);
+        riffHdr.size = RIFF_MAX_SIZE;
+        file.seekp(0);
+        file.write((char*)&riffHdr, sizeof(ChunkHeader));
+
+        ChunkHeader ds64Hdr;
+        memcpy(ds64Hdr.id, DS64_SIGNATURE, RIFF_LABEL_SIZE);
+        ds64Hdr.size = sizeof(DS64Body);
+        DS64Body ds64;
+        ds64.riffSize = riffSize;
+        ds64.dataSize = dataSize;
+        ds64.sampleCount = sampleCount;
+        ds64.tableLength = 0;
+        file.seekp(ds64Pos);
+        file.write((char*)&ds64Hdr, sizeof(ChunkHeader));
+        file.write((char*)&ds64, sizeof(DS64Body));
+        file.seekp(pos);
     }
 }
\ No newline at end of file
@@ -11,11 +11,19 @@ namespace riff {
         char id[4];
         uint32_t size;
     };
+
+    struct DS64Body {
+        uint64_t riffSize;
+        uint64_t dataSize;
+        uint64_t sampleCount;
+        uint32_t tableLength;
+    };
 #pragma pack(pop)
 
     struct ChunkDesc {
         ChunkHeader hdr;
         std::streampos pos;
+        uint64_t size;
     };
 
     class Writer {
@@ -24,7 +32,9 @@ namespace riff {
         // Writer(const Writer&& b);
         ~Writer();
 
-        bool open(std::string path, const char form[4]);
+        // When rf64 is set, space is reserved for a ds64 chunk and the file is turned into an RF64 file on close
+        // if it grew beyond the 4GB limit of RIFF
+        bool open(std::string path, const char form[4], bool rf64 = false);
         bool isOpen();
         void close();
 
@@ -36,6 +46,13 @@ namespace riff {
 
         void write(const uint8_t* data, size_t len);
 
+        // Sample count stored in the ds64 chunk of an RF64 file
+        void setSampleCount(uint64_t count);
+
+        // Size of the extents allocated ahead of the writes to keep the file contiguous, 0 to disable.
+        // Only supported on Linux
+        void setPreallocation(size_t bytes);
+
     private:
         void beginRIFF(const char form[4]);
         void endRIFF();
@@ -43,6 +60,15 @@ namespace riff {
         std::recursive_mutex mtx;
         std::ofstream file;
         std::stack<ChunkDesc> chunks;
+
+        bool _rf64 = false;
+        std::streampos ds64Pos;
+        uint64_t dataSize = 0;
+        uint64_t sampleCount = 0;
+
+        size_t _prealloc = 0;
+        uint64_t allocated = 0;
+        int allocFd = -1;
     };
 
     // class Reader {
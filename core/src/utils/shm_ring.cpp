@@ -0,0 +1,191 @@
+#include "shm_ring.h"
+#include <utils/flog.h>
+#include <atomic>
+#include <algorithm>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <ctype.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+static_assert(sizeof(ShmRingHeader) == 128, "The layout of the shared memory ring header is published");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "Atomics of the ring header must be lock free to be shared between processes");
+
+namespace shm {
+    template <class T>
+    static inline std::atomic<T>& atomicAt(T& value) { return *(std::atomic<T>*)&value; }
+
+    static bool validName(const std::string& name) {
+        if (name.empty() || name.size() > 200 || name[0] == '.') { return false; }
+        for (char c : name) {
+            if (!isalnum((unsigned char)c) && c != '_' && c != '-' && c != '.') { return false; }
+        }
+        return true;
+    }
+
+    RingWriter::~RingWriter() {
+        close();
+    }
+
+    bool RingWriter::open(const std::string& name, ShmRingFormat format, int channels, int minFrames, double sampleRate, double frequency) {
+        close();
+        if (!validName(name)) {
+            flog::error("[ShmRing] Invalid shared memory name '{0}'", name);
+            return false;
+        }
+
+        int sampleSize = (format == SHM_RING_FORMAT_S8) ? 1 : ((format == SHM_RING_FORMAT_S16) ? 2 : 4);
+        frameSize = sampleSize * channels;
+        capacity = 1;
+        while (capacity < (uint64_t)std::max<int>(minFrames, 1)) { capacity <<= 1; }
+
+        // The frames start on a page, so that readers can map them twice
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        size_t page = info.dwAllocationGranularity;
+#else
+        size_t page = sysconf(_SC_PAGESIZE);
+#endif
+        size_t headerSize = ((sizeof(ShmRingHeader) + page - 1) / page) * page;
+        segmentSize = headerSize + capacity * frameSize;
+
+        void* base = NULL;
+#ifdef _WIN32
+        std::string mapName = "Local\\" + name;
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)segmentSize >> 32), (DWORD)(segmentSize & 0xFFFFFFFF), mapName.c_str());
+        if (mapping) { base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, segmentSize); }
+        if (!base) {
+            flog::error("[ShmRing] Could not create the shared memory '{0}'", name);
+            if (mapping) { CloseHandle(mapping); }
+            mapping = NULL;
+            return false;
+        }
+#elif defined(__ANDROID__)
+        flog::error("[ShmRing] Shared memory rings aren't supported on Android");
+        return false;
+#else
+        // Replace what a previous run may have left, readers still mapping it keep the old one
+#ifdef __linux__
+        segName = "/dev/shm/" + name;
+        unlink(segName.c_str());
+        int fd = ::open(segName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+#else
+        segName = "/" + name;
+        shm_unlink(segName.c_str());
+        int fd = shm_open(segName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+#endif
+        if (fd >= 0 && ftruncate(fd, segmentSize) == 0) {
+            base = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (base == MAP_FAILED) { base = NULL; }
+        }
+        if (fd >= 0) { ::close(fd); }
+        if (!base) {
+            flog::error("[ShmRing] Could not create the shared memory '{0}': {1}", name, strerror(errno));
+#ifdef __linux__
+            unlink(segName.c_str());
+#else
+            shm_unlink(segName.c_str());
+#endif
+            return false;
+        }
+#endif
+
+        // The segment is zeroed by the system, only the parameters need to be set
+        hdr = (ShmRingHeader*)base;
+        ring = (uint8_t*)base + headerSize;
+        hdr->headerSize = headerSize;
+        hdr->format = format;
+        hdr->channels = channels;
+        hdr->frameSize = frameSize;
+        hdr->capacity = capacity;
+        hdr->sampleRate = sampleRate;
+        hdr->frequency = frequency;
+        hdr->state = SHM_RING_STATE_RUNNING;
+        hdr->version = SHM_RING_VERSION;
+        atomicAt(hdr->magic).store(SHM_RING_MAGIC, std::memory_order_release);
+
+        flog::info("[ShmRing] Sharing {0} frames of {1} bytes as '{2}'", (int64_t)capacity, frameSize, name);
+        return true;
+    }
+
+    void RingWriter::close() {
+        if (!hdr) { return; }
+
+        // Readers blocked waiting for frames notice the ring closed once woken up
+        atomicAt(hdr->state).store(SHM_RING_STATE_CLOSED, std::memory_order_release);
+        atomicAt(hdr->wakeup).fetch_add(1);
+#ifdef __linux__
+        syscall(SYS_futex, &hdr->wakeup, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+
+#ifdef _WIN32
+        UnmapViewOfFile(hdr);
+        CloseHandle(mapping);
+        mapping = NULL;
+#else
+        munmap(hdr, segmentSize);
+#ifdef __linux__
+        unlink(segName.c_str());
+#else
+        shm_unlink(segName.c_str());
+#endif
+#endif
+        hdr = NULL;
+        ring = NULL;
+    }
+
+    void RingWriter::setSampleRate(double sampleRate) {
+        if (!hdr || hdr->sampleRate == sampleRate) { return; }
+        std::atomic<uint32_t>& gen = atomicAt(hdr->generation);
+        gen.fetch_add(1);
+        hdr->sampleRate = sampleRate;
+        gen.fetch_add(1);
+    }
+
+    void RingWriter::setFrequency(double frequency) {
+        if (!hdr) { return; }
+        hdr->frequency = frequency;
+    }
+
+    uint8_t* RingWriter::reserve(int maxFrames, int& count) {
+        uint64_t pos = hdr->written & (capacity - 1);
+        count = (int)std::min<uint64_t>(maxFrames, capacity - pos);
+        return &ring[pos * frameSize];
+    }
+
+    void RingWriter::commit(int count) {
+        // Only this writer changes written, so it never needs to be loaded atomically here
+        atomicAt(hdr->written).store(hdr->written + count, std::memory_order_release);
+        atomicAt(hdr->wakeup).fetch_add(1);
+#ifdef __linux__
+        if (atomicAt(hdr->waiters).load()) {
+            syscall(SYS_futex, &hdr->wakeup, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+        }
+#endif
+    }
+
+    void RingWriter::write(const void* frames, int count) {
+        const uint8_t* data = (const uint8_t*)frames;
+        while (count > 0) {
+            int n;
+            uint8_t* dst = reserve(count, n);
+            memcpy(dst, data, n * frameSize);
+            commit(n);
+            data += n * frameSize;
+            count -= n;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+#include "shm_ring_layout.h"
+
+namespace shm {
+    // Writes frames into a shared memory ring (see shm_ring_layout.h) that other programs on the same machine read in
+    // place. Frames can be converted straight into the ring through reserve() and commit(), so that they are never
+    // copied anywhere else. Not thread safe, the owner serializes writing with opening and closing
+    class RingWriter {
+    public:
+        RingWriter() {}
+        ~RingWriter();
+
+        // Create the segment, replacing any left behind by a writer that didn't close it, for channels channels of the
+        // given format and at least minFrames frames. Names may only hold letters, digits, '_', '-' and '.'
+        bool open(const std::string& name, ShmRingFormat format, int channels, int minFrames, double sampleRate, double frequency = 0.0);
+
+        // Mark the ring closed for the readers and remove the segment, the readers keep their mapping
+        void close();
+
+        bool isOpen() { return hdr != NULL; }
+
+        void setSampleRate(double sampleRate);
+        void setFrequency(double frequency);
+
+        // Contiguous room for up to maxFrames frames at the position of the next one, count giving how many fit
+        // before the end of the ring
+        uint8_t* reserve(int maxFrames, int& count);
+
+        // Publish the count frames written to the room given by reserve() and wake the readers up
+        void commit(int count);
+
+        // Copy frames into the ring
+        void write(const void* frames, int count);
+
+        int getFrameSize() { return frameSize; }
+
+    private:
+        ShmRingHeader* hdr = NULL;
+        uint8_t* ring = NULL;
+        size_t segmentSize = 0;
+        uint64_t capacity = 0;
+        int frameSize = 0;
+        std::string segName;
+
+#ifdef _WIN32
+        void* mapping = NULL;
+#endif
+    };
+}
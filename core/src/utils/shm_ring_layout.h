@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+
+// Layout of the shared memory rings SDR++ exports samples through to programs running on the same machine. This header
+// only depends on stdint.h and can be copied into the programs reading them, in C or C++.
+//
+// A ring is a segment named by the user: /dev/shm/<name> on Linux, shm_open("/<name>") on other POSIX systems and the
+// file mapping "Local\<name>" on Windows. It starts with a ShmRingHeader, the frames following at headerSize, which is
+// a multiple of the page size so that readers may map the frames twice in a row to never see them wrap around.
+// A frame holds one sample of every channel, interleaved, the IQ of one sample being two channels.
+//
+// The writer never waits for the readers, so a reader that falls more than capacity frames behind loses samples:
+//   1. Check magic and version, then read generation, the parameters and generation again, until both reads give the
+//      same even value, generation being odd while the writer changes them
+//   2. Start reading at written, loaded with acquire semantics
+//   3. Load written with acquire semantics. If it's unchanged, wait: on Linux, increment waiters, load wakeup, load
+//      written again and if it's still unchanged wait on the futex wakeup (FUTEX_WAIT, not private) for the value
+//      loaded, then decrement waiters, all with sequentially consistent atomics. Elsewhere, sleep a little. If written
+//      is more than capacity ahead, the frames in between were lost
+//   4. Frame n is at headerSize + (n % capacity) * frameSize. Use the frames in place, then check that written isn't
+//      more than capacity ahead of the first of them, otherwise they were overwritten meanwhile
+//   5. Go back to 1 if generation changed, and stop when state is SHM_RING_STATE_CLOSED
+// The writer only makes a system call to wake the readers up when waiters isn't zero.
+
+#define SHM_RING_MAGIC      0x52524453 // "SDRR"
+#define SHM_RING_VERSION    1
+
+enum ShmRingFormat {
+    SHM_RING_FORMAT_F32 = 0, // 32 bit float, full scale of 1.0
+    SHM_RING_FORMAT_S8  = 1, // Signed 8 bit integers
+    SHM_RING_FORMAT_S16 = 2, // Signed 16 bit integers, little endian like every other field
+    SHM_RING_FORMAT_S32 = 3  // Signed 32 bit integers
+};
+
+enum ShmRingState {
+    SHM_RING_STATE_CLOSED = 0,
+    SHM_RING_STATE_RUNNING = 1
+};
+
+struct ShmRingHeader {
+    // Set when the segment is created
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;    // Offset of the frames from the start of the segment
+    uint32_t format;        // ShmRingFormat of every channel
+    uint32_t channels;      // Channels per frame, 2 for IQ
+    uint32_t frameSize;     // Bytes per frame
+    uint64_t capacity;      // Frames in the ring, a power of two
+
+    // Parameters of the samples, generation being incremented before and after the samplerate changes
+    double sampleRate;
+    double frequency;       // Center frequency of IQ in Hz, updated as it's tuned without changing generation, 0 for audio
+    uint32_t generation;
+    uint32_t state;         // ShmRingState
+    uint8_t reserved0[8];
+
+    // Written as frames are added, on their own cache line
+    uint64_t written;       // Frames written since the ring was created, incremented once they are in the ring
+    uint32_t wakeup;        // Futex word, incremented after written
+    uint32_t waiters;       // Readers waiting on wakeup, maintained by themselves
+    uint8_t reserved1[48];
+};
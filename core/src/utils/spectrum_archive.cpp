@@ -0,0 +1,323 @@
+#include "spectrum_archive.h"
+#include <zstd.h>
+#include <string.h>
+#include <math.h>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <utils/flog.h>
+
+namespace spectrum_archive {
+    const char* FILE_MAGIC          = "SPA1";
+    const char* INDEX_MAGIC         = "SPIX";
+    const uint16_t FILE_VERSION     = 1;
+
+    Writer::~Writer() { close(); }
+
+    bool Writer::open(std::string path, int bins, double lineInterval, float minLevel, float levelStep, int chunkLines, int level) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        // Close previous file
+        if (file.is_open()) { close(); }
+
+        FileHeader nhdr = {};
+        memcpy(nhdr.magic, FILE_MAGIC, sizeof(nhdr.magic));
+        nhdr.version = FILE_VERSION;
+        nhdr.bins = bins;
+        nhdr.chunkLines = chunkLines;
+        nhdr.minLevel = minLevel;
+        nhdr.levelStep = levelStep;
+        nhdr.lineInterval = lineInterval;
+
+        // Carry on with an existing archive, dropping its index which is written again when closing. Any other
+        // file is left alone
+        index.clear();
+        bool append = false;
+        if (std::filesystem::exists(path)) {
+            std::ifstream in(path, std::ios::in | std::ios::binary);
+            FileHeader ohdr;
+            in.read((char*)&ohdr, sizeof(FileHeader));
+            if (!in || memcmp(&ohdr, &nhdr, sizeof(FileHeader))) {
+                flog::error("Spectrum archive {0} exists with other settings", path);
+                return false;
+            }
+            in.seekg(0, std::ios::end);
+            uint64_t fileSize = in.tellg();
+            uint64_t dataEnd;
+            loadIndex(in, ohdr, fileSize, index, dataEnd);
+            in.close();
+            std::error_code ec;
+            std::filesystem::resize_file(path, dataEnd, ec);
+            if (ec) { return false; }
+            append = true;
+        }
+
+        // Open file and write the header
+        if (append) {
+            file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(0, std::ios::end);
+        }
+        else {
+            file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write((char*)&nhdr, sizeof(FileHeader));
+        }
+        if (!file.is_open()) { return false; }
+
+        // Reset work values
+        hdr = nhdr;
+        _level = level;
+        chunk = {};
+        times.clear();
+        data.clear();
+        linesWritten = 0;
+        bytesWritten = 0;
+        return true;
+    }
+
+    bool Writer::isOpen() {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        return file.is_open();
+    }
+
+    void Writer::close() {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (!file.is_open()) { return; }
+        flushChunk();
+
+        // Write the index and the footer pointing to it
+        Footer footer = {};
+        footer.indexOffset = file.tellp();
+        footer.chunkCount = index.size();
+        memcpy(footer.magic, INDEX_MAGIC, sizeof(footer.magic));
+        file.write((char*)index.data(), index.size() * sizeof(IndexEntry));
+        file.write((char*)&footer, sizeof(Footer));
+        file.close();
+    }
+
+    void Writer::write(double time, double frequency, double bandwidth, const float* max, const float* mean) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (!file.is_open()) { return; }
+
+        // A chunk only holds lines of the same frequency and bandwidth
+        if (chunk.lines && (frequency != chunk.frequency || bandwidth != chunk.bandwidth)) { flushChunk(); }
+        if (!chunk.lines) {
+            chunk.startTime = time;
+            chunk.frequency = frequency;
+            chunk.bandwidth = bandwidth;
+            prevMax.assign(hdr.bins, 0);
+            prevMean.assign(hdr.bins, 0);
+        }
+
+        // Quantize both planes, storing the difference with the previous line
+        times.push_back(time - chunk.startTime);
+        float scale = 1.0f / hdr.levelStep;
+        for (int p = 0; p < 2; p++) {
+            const float* in = p ? mean : max;
+            std::vector<uint8_t>& prev = p ? prevMean : prevMax;
+            for (int i = 0; i < hdr.bins; i++) {
+                float x = (in[i] - hdr.minLevel) * scale;
+                uint8_t q = (x > 0.0f) ? ((x < 255.0f) ? (uint8_t)(x + 0.5f) : 255) : 0;
+                data.push_back(q - prev[i]);
+                prev[i] = q;
+            }
+        }
+        chunk.endTime = time;
+        chunk.lines++;
+        linesWritten++;
+
+        if (chunk.lines >= hdr.chunkLines) { flushChunk(); }
+    }
+
+    void Writer::flushChunk() {
+        if (!chunk.lines) { return; }
+
+        // The times come first, then the levels line by line
+        std::vector<uint8_t> raw(times.size() * sizeof(float) + data.size());
+        memcpy(raw.data(), times.data(), times.size() * sizeof(float));
+        memcpy(&raw[times.size() * sizeof(float)], data.data(), data.size());
+        comp.resize(ZSTD_compressBound(raw.size()));
+        size_t csize = ZSTD_compress(comp.data(), comp.size(), raw.data(), raw.size(), _level);
+
+        // Chunks that failed to compress are lost
+        if (ZSTD_isError(csize)) {
+            flog::error("Could not compress spectrum chunk: {0}", ZSTD_getErrorName(csize));
+        }
+        else {
+            chunk.size = csize;
+            IndexEntry entry;
+            entry.offset = file.tellp();
+            entry.startTime = chunk.startTime;
+            entry.endTime = chunk.endTime;
+            file.write((char*)&chunk, sizeof(ChunkHeader));
+            file.write((char*)comp.data(), csize);
+
+            // Nothing more than the chunk being filled is lost if the program doesn't exit properly
+            file.flush();
+            index.push_back(entry);
+            bytesWritten += sizeof(ChunkHeader) + csize;
+        }
+
+        chunk.lines = 0;
+        times.clear();
+        data.clear();
+    }
+
+    Reader::Reader(std::string path) {
+        file.open(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) { throw std::runtime_error("Could not open file"); }
+
+        // Check the header
+        file.read((char*)&hdr, sizeof(FileHeader));
+        if (!file || memcmp(hdr.magic, FILE_MAGIC, sizeof(hdr.magic)) || hdr.version != FILE_VERSION || !hdr.bins || !hdr.chunkLines) {
+            throw std::runtime_error("Invalid spectrum archive");
+        }
+        file.seekg(0, std::ios::end);
+        uint64_t fileSize = file.tellg();
+
+        // Load the index, or rebuild it if the archive wasn't closed properly
+        if (!loadIndex(file, hdr, fileSize, index, dataEnd)) {
+            flog::warn("Spectrum archive has no index, rebuilding it");
+        }
+
+        dctx = ZSTD_createDCtx();
+    }
+
+    Reader::~Reader() {
+        if (dctx) { ZSTD_freeDCtx((ZSTD_DCtx*)dctx); }
+    }
+
+    double Reader::getStartTime() {
+        return index.empty() ? 0.0 : index.front().startTime;
+    }
+
+    double Reader::getEndTime() {
+        return index.empty() ? 0.0 : index.back().endTime;
+    }
+
+    int Reader::read(double startTime, double endTime, std::vector<Line>& lines, int maxLines) {
+        std::lock_guard<std::mutex> lck(mtx);
+        lines.clear();
+
+        // The chunks are in order of time, only those overlapping the range are decoded
+        auto it = std::lower_bound(index.begin(), index.end(), startTime, [](const IndexEntry& e, double t) { return e.endTime < t; });
+        std::vector<Line> chunkLines;
+        for (int c = it - index.begin(); c < index.size() && index[c].startTime <= endTime; c++) {
+            if (!decode(c, chunkLines)) {
+                flog::error("Could not decode spectrum chunk {0}", c);
+                continue;
+            }
+            for (auto& line : chunkLines) {
+                if (line.time >= startTime && line.time <= endTime) { lines.push_back(std::move(line)); }
+            }
+        }
+        if (maxLines <= 0 || lines.size() <= maxLines) { return lines.size(); }
+
+        // Merge groups of consecutive lines, a group ending early where the frequency changes
+        int group = (lines.size() + maxLines - 1) / maxLines;
+        std::vector<Line> merged;
+        for (int i = 0; i < lines.size();) {
+            Line m = std::move(lines[i++]);
+            int n = 1;
+            while (n < group && i < lines.size() && lines[i].frequency == m.frequency && lines[i].bandwidth == m.bandwidth) {
+                for (int j = 0; j < hdr.bins; j++) {
+                    m.max[j] = std::max<float>(m.max[j], lines[i].max[j]);
+                    m.mean[j] += lines[i].mean[j];
+                }
+                m.time = lines[i++].time;
+                n++;
+            }
+            for (int j = 0; j < hdr.bins; j++) { m.mean[j] /= (float)n; }
+            merged.push_back(std::move(m));
+        }
+        lines = std::move(merged);
+        return lines.size();
+    }
+
+    bool Reader::decode(int c, std::vector<Line>& out) {
+        // Read the compressed chunk, which can't go past the next one
+        uint64_t end = (c + 1 < index.size()) ? index[c + 1].offset : dataEnd;
+        ChunkHeader chdr;
+        file.seekg(index[c].offset);
+        file.read((char*)&chdr, sizeof(ChunkHeader));
+        if (!file || index[c].offset + sizeof(ChunkHeader) + chdr.size > end) {
+            file.clear();
+            return false;
+        }
+        comp.resize(chdr.size);
+        file.read((char*)comp.data(), chdr.size);
+        if (!file || chdr.lines > hdr.chunkLines) {
+            file.clear();
+            return false;
+        }
+
+        // Decompress it
+        size_t rawSize = chdr.lines * (sizeof(float) + (2 * hdr.bins));
+        data.resize(rawSize);
+        size_t size = ZSTD_decompressDCtx((ZSTD_DCtx*)dctx, data.data(), rawSize, comp.data(), comp.size());
+        if (ZSTD_isError(size) || size != rawSize) { return false; }
+
+        // Undo the differences between lines
+        std::vector<uint8_t> qMax(hdr.bins, 0);
+        std::vector<uint8_t> qMean(hdr.bins, 0);
+        const uint8_t* levels = &data[chdr.lines * sizeof(float)];
+        out.resize(chdr.lines);
+        for (int l = 0; l < chdr.lines; l++) {
+            Line& line = out[l];
+            float offset;
+            memcpy(&offset, &data[l * sizeof(float)], sizeof(float));
+            line.time = chdr.startTime + offset;
+            line.frequency = chdr.frequency;
+            line.bandwidth = chdr.bandwidth;
+            line.max.resize(hdr.bins);
+            line.mean.resize(hdr.bins);
+            for (int i = 0; i < hdr.bins; i++) {
+                qMax[i] += levels[i];
+                line.max[i] = hdr.minLevel + ((float)qMax[i] * hdr.levelStep);
+            }
+            levels += hdr.bins;
+            for (int i = 0; i < hdr.bins; i++) {
+                qMean[i] += levels[i];
+                line.mean[i] = hdr.minLevel + ((float)qMean[i] * hdr.levelStep);
+            }
+            levels += hdr.bins;
+        }
+        return true;
+    }
+
+    bool loadIndex(std::istream& file, const FileHeader& hdr, uint64_t fileSize, std::vector<IndexEntry>& index, uint64_t& dataEnd) {
+        index.clear();
+        Footer footer = {};
+        if (fileSize >= sizeof(FileHeader) + sizeof(Footer)) {
+            file.seekg(fileSize - sizeof(Footer));
+            file.read((char*)&footer, sizeof(Footer));
+        }
+        bool valid = file && !memcmp(footer.magic, INDEX_MAGIC, sizeof(footer.magic)) &&
+                     footer.indexOffset + (footer.chunkCount * sizeof(IndexEntry)) + sizeof(Footer) == fileSize;
+        if (valid) {
+            index.resize(footer.chunkCount);
+            file.seekg(footer.indexOffset);
+            file.read((char*)index.data(), index.size() * sizeof(IndexEntry));
+            dataEnd = footer.indexOffset;
+            return true;
+        }
+
+        // Walk through the chunk headers until the data runs out
+        file.clear();
+        uint64_t offset = sizeof(FileHeader);
+        while (offset + sizeof(ChunkHeader) <= fileSize) {
+            ChunkHeader chdr;
+            file.seekg(offset);
+            file.read((char*)&chdr, sizeof(ChunkHeader));
+            if (!file || !chdr.lines || chdr.lines > hdr.chunkLines) { break; }
+            if (offset + sizeof(ChunkHeader) + chdr.size > fileSize) { break; }
+            IndexEntry entry;
+            entry.offset = offset;
+            entry.startTime = chdr.startTime;
+            entry.endTime = chdr.endTime;
+            index.push_back(entry);
+            offset += sizeof(ChunkHeader) + chdr.size;
+        }
+        file.clear();
+        dataEnd = offset;
+        return false;
+    }
+}
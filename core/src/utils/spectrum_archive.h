@@ -0,0 +1,141 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include <atomic>
+
+// Number of lines in a chunk, the unit of compression and of random access
+#define SPECTRUM_ARCHIVE_DEFAULT_CHUNK_LINES    64
+#define SPECTRUM_ARCHIVE_DEFAULT_LEVEL          9
+
+// Levels are stored in steps of levelStep dB from minLevel, a byte covering 160dB by default
+#define SPECTRUM_ARCHIVE_DEFAULT_MIN_LEVEL      -150.0f
+#define SPECTRUM_ARCHIVE_DEFAULT_LEVEL_STEP     0.625f
+
+// Long term spectrum archives. Each line holds the highest and the mean level of each bin over the time it covers,
+// quantized to a byte. The lines are grouped in chunks, each compressed with zstd after taking the difference of
+// every line with the previous one, so that the bins that don't change compress to almost nothing. A new chunk starts
+// whenever the frequency or the bandwidth change. An index of the chunks at the end of the file gives their time
+// ranges, files that weren't closed properly are indexed by walking through the chunks instead.
+namespace spectrum_archive {
+#pragma pack(push, 1)
+    struct FileHeader {
+        char magic[4];
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t bins;
+        uint32_t chunkLines;
+        float minLevel;
+        float levelStep;
+        double lineInterval;
+    };
+
+    struct ChunkHeader {
+        uint32_t size;          // Bytes of compressed data following the header
+        uint32_t lines;
+        double startTime;       // Times of the first and last lines, in seconds since the epoch
+        double endTime;
+        double frequency;
+        double bandwidth;
+    };
+
+    struct IndexEntry {
+        uint64_t offset;
+        double startTime;
+        double endTime;
+    };
+
+    struct Footer {
+        uint64_t indexOffset;
+        uint64_t chunkCount;
+        char magic[4];
+        uint32_t reserved;
+    };
+#pragma pack(pop)
+
+    struct Line {
+        double time;            // End of the time the line covers, in seconds since the epoch
+        double frequency;
+        double bandwidth;
+        std::vector<float> max;
+        std::vector<float> mean;
+    };
+
+    class Writer {
+    public:
+        Writer() {}
+        ~Writer();
+
+        // Lines have bins levels and cover lineInterval seconds. If the file is an archive with the same settings it is
+        // appended to, so that a restarted logger carries on with the same file
+        bool open(std::string path, int bins, double lineInterval, float minLevel = SPECTRUM_ARCHIVE_DEFAULT_MIN_LEVEL,
+                  float levelStep = SPECTRUM_ARCHIVE_DEFAULT_LEVEL_STEP, int chunkLines = SPECTRUM_ARCHIVE_DEFAULT_CHUNK_LINES,
+                  int level = SPECTRUM_ARCHIVE_DEFAULT_LEVEL);
+        bool isOpen();
+        void close();
+
+        // Append a line of levels in dB, the lines must come in order of time
+        void write(double time, double frequency, double bandwidth, const float* max, const float* mean);
+
+        uint64_t getLinesWritten() { return linesWritten; }
+
+        // Bytes of compressed data written to disk, the lines of the chunk being filled not included
+        uint64_t getBytesWritten() { return bytesWritten; }
+
+    private:
+        void flushChunk();
+
+        std::recursive_mutex mtx;
+        std::fstream file;
+        FileHeader hdr;
+        int _level;
+        std::vector<IndexEntry> index;
+
+        // Chunk being filled
+        ChunkHeader chunk;
+        std::vector<float> times;
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> prevMax;
+        std::vector<uint8_t> prevMean;
+        std::vector<uint8_t> comp;
+
+        std::atomic<uint64_t> linesWritten = 0;
+        std::atomic<uint64_t> bytesWritten = 0;
+    };
+
+    // Random access to an archive by time. Throws runtime_error if the file can't be opened or is invalid
+    class Reader {
+    public:
+        Reader(std::string path);
+        ~Reader();
+
+        int getBins() { return hdr.bins; }
+        double getLineInterval() { return hdr.lineInterval; }
+
+        // Times of the first and last lines, 0 if the archive is empty
+        double getStartTime();
+        double getEndTime();
+
+        // Read the lines from startTime to endTime in order of time. When there are more than maxLines of them,
+        // consecutive lines of the same frequency are merged to fit, keeping the highest and the average of their levels
+        int read(double startTime, double endTime, std::vector<Line>& lines, int maxLines = -1);
+
+    private:
+        bool decode(int chunk, std::vector<Line>& out);
+
+        std::mutex mtx;
+        std::ifstream file;
+        FileHeader hdr;
+        std::vector<IndexEntry> index;
+        uint64_t dataEnd = 0;
+        void* dctx = NULL;
+        std::vector<uint8_t> comp;
+        std::vector<uint8_t> data;
+    };
+
+    // Load the index of an open archive whose header was read, walking through the chunks if it has none, in which
+    // case false is returned. dataEnd is set to the end of the last chunk
+    bool loadIndex(std::istream& file, const FileHeader& hdr, uint64_t fileSize, std::vector<IndexEntry>& index, uint64_t& dataEnd);
+}
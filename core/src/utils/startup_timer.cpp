@@ -0,0 +1,51 @@
+#include <utils/startup_timer.h>
+#include <utils/flog.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+namespace startup_timer {
+    typedef std::chrono::steady_clock Clock;
+
+    std::string current;
+    Clock::time_point phaseStart;
+    Clock::time_point startupStart;
+    bool started = false;
+    std::vector<std::pair<std::string, int>> durations;
+
+    void endPhase(Clock::time_point now) {
+        if (current.empty()) { return; }
+        int ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(now - phaseStart).count();
+        flog::debug("Startup phase '{0}' took {1} ms", current, ms);
+        durations.push_back({ current, ms });
+        current.clear();
+    }
+
+    void begin(const std::string& phase) {
+        auto now = Clock::now();
+        if (!started) {
+            startupStart = now;
+            started = true;
+        }
+        endPhase(now);
+        current = phase;
+        phaseStart = now;
+    }
+
+    void finish() {
+        if (!started) { return; }
+        auto now = Clock::now();
+        endPhase(now);
+        int total = (int)std::chrono::duration_cast<std::chrono::milliseconds>(now - startupStart).count();
+
+        std::sort(durations.begin(), durations.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        std::string slowest;
+        for (int i = 0; i < std::min<int>(durations.size(), STARTUP_TIMER_SLOWEST); i++) {
+            if (i) { slowest += ", "; }
+            slowest += durations[i].first + " (" + std::to_string(durations[i].second) + " ms)";
+        }
+        flog::info("Startup took {0} ms, slowest phases: {1}", total, slowest);
+        durations.clear();
+        started = false;
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+// Number of phases listed in the summary logged by finish()
+#define STARTUP_TIMER_SLOWEST   5
+
+// Durations of the phases of the startup, so that regressions show up in the log. A phase lasts until the next one
+// begins, its duration being logged when it ends. Only to be used from the thread starting the program
+namespace startup_timer {
+    void begin(const std::string& phase);
+
+    // End the last phase and log the total startup time along with the slowest phases
+    void finish();
+}
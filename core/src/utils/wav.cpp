@@ -4,6 +4,8 @@
 #include <dsp/buffer/buffer.h>
 #include <dsp/stream.h>
 #include <map>
+#include <algorithm>
+#include <string.h>
 
 namespace wav {
     const char* WAVE_FILE_TYPE          = "WAVE";
@@ -11,6 +13,7 @@ namespace wav {
     const char* DATA_MARKER             = "data";
     const uint32_t FORMAT_HEADER_LEN    = 16;
     const uint16_t SAMPLE_TYPE_PCM      = 1;
+    const size_t WRITE_BLOCK_SIZE       = 4 * 1024 * 1024;
 
     std::map<SampleType, int> SAMP_BITS = {
         { SAMP_TYPE_UINT8, 8 },
@@ -69,7 +72,7 @@ namespace wav {
         }
 
         // Open file
-        if (!rw.open(path, WAVE_FILE_TYPE)) { return false; }
+        if (!rw.open(path, WAVE_FILE_TYPE, _format == FORMAT_RF64)) { return false; }
 
         // Write format chunk
         rw.beginChunk(FORMAT_MARKER);
@@ -78,6 +81,29 @@ namespace wav {
 
         // Begin data chunk
         rw.beginChunk(DATA_MARKER);
+
+        // Allocate the backlog and start the write-behind thread
+        samplesDropped = 0;
+        if (_backlog) {
+            blockSize = std::max<size_t>(WRITE_BLOCK_SIZE, STREAM_BUFFER_SIZE * bytesPerSamp);
+            int count = std::max<int>(_backlog / blockSize, 2);
+            blocks.resize(count);
+            blockFill.resize(count);
+            freeBlocks.clear();
+            readyBlocks.clear();
+            for (int i = 0; i < count; i++) {
+                blocks[i] = dsp::buffer::alloc<uint8_t>(blockSize);
+                freeBlocks.push_back(i);
+            }
+            current = -1;
+            stopWorker = false;
+            if (_writeQueue) {
+                _writeQueue->add(this);
+            }
+            else {
+                workerThread = std::thread(&Writer::worker, this);
+            }
+        }
         
         return true;
     }
@@ -92,8 +118,29 @@ namespace wav {
         // Do nothing if the file is not open
         if (!rw.isOpen()) { return; }
 
+        // Write out the backlog and stop the write-behind thread, or write what's left after leaving the shared one
+        if (!blocks.empty()) {
+            if (current >= 0) { submitBlock(); }
+            if (workerThread.joinable()) {
+                {
+                    std::lock_guard<std::mutex> qlck(queueMtx);
+                    stopWorker = true;
+                }
+                queueCnd.notify_all();
+                workerThread.join();
+            }
+            else {
+                _writeQueue->remove(this);
+                while (writeBlock());
+            }
+            for (auto& block : blocks) { dsp::buffer::free(block); }
+            blocks.clear();
+            blockFill.clear();
+        }
+
         // Finish data chunk
         rw.endChunk();
+        rw.setSampleCount(samplesWritten);
 
         // Close the file
         rw.close();
@@ -147,6 +194,33 @@ namespace wav {
         _type = type;
     }
 
+    void Writer::setBacklog(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        // Do not allow settings to change while open
+        if (rw.isOpen()) { throw std::runtime_error("Cannot change parameters while file is open"); }
+        _backlog = bytes;
+    }
+
+    void Writer::setPreallocation(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        // Do not allow settings to change while open
+        if (rw.isOpen()) { throw std::runtime_error("Cannot change parameters while file is open"); }
+        rw.setPreallocation(bytes);
+    }
+
+    void Writer::setWriteQueue(WriteQueue* queue) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        // Do not allow settings to change while open
+        if (rw.isOpen()) { throw std::runtime_error("Cannot change parameters while file is open"); }
+        _writeQueue = queue;
+    }
+
+    float Writer::getBacklogFill() {
+        std::lock_guard<std::mutex> lck(queueMtx);
+        if (blocks.empty()) { return 0.0f; }
+        return (float)(blocks.size() - freeBlocks.size()) / (float)blocks.size();
+    }
+
     void Writer::write(float* samples, int count) {
         std::lock_guard<std::recursive_mutex> lck(mtx);
         if (!rw.isOpen()) { return; }
@@ -154,30 +228,149 @@ namespace wav {
         // Select different writer function depending on the chose depth
         int tcount = count * _channels;
         int tbytes = count * bytesPerSamp;
+        const uint8_t* data = NULL;
         switch (_type) {
         case SAMP_TYPE_UINT8:
             // Volk doesn't support unsigned ints yet :/
             for (int i = 0; i < tcount; i++) {
                 bufU8[i] = (samples[i] * 127.0f) + 128.0f;
             }
-            rw.write(bufU8, tbytes);
+            data = bufU8;
             break;
         case SAMP_TYPE_INT16:
             volk_32f_s32f_convert_16i(bufI16, samples, 32767.0f, tcount);
-            rw.write((uint8_t*)bufI16, tbytes);
+            data = (uint8_t*)bufI16;
             break;
         case SAMP_TYPE_INT32:
             volk_32f_s32f_convert_32i(bufI32, samples, 2147483647.0f, tcount);
-            rw.write((uint8_t*)bufI32, tbytes);
+            data = (uint8_t*)bufI32;
             break;
         case SAMP_TYPE_FLOAT32:
-            rw.write((uint8_t*)samples, tbytes);
+            data = (uint8_t*)samples;
             break;
         default:
-            break;
+            return;
+        }
+
+        // Write directly or hand over to the write-behind thread
+        if (!_backlog) {
+            rw.write(data, tbytes);
+        }
+        else if (!queue(data, tbytes)) {
+            samplesDropped += count;
+            return;
         }
 
         // Increment sample counter
         samplesWritten += count;
     }
+
+    bool Writer::queue(const uint8_t* data, size_t len) {
+        // Hand the current block over if the data doesn't fit in it
+        if (current >= 0 && blockFill[current] + len > blockSize) { submitBlock(); }
+
+        // Get a new block, the data is dropped if the whole backlog is waiting on the disk
+        if (current < 0) {
+            std::lock_guard<std::mutex> lck(queueMtx);
+            if (freeBlocks.empty()) { return false; }
+            current = freeBlocks.back();
+            freeBlocks.pop_back();
+            blockFill[current] = 0;
+        }
+
+        memcpy(&blocks[current][blockFill[current]], data, len);
+        blockFill[current] += len;
+        return true;
+    }
+
+    void Writer::submitBlock() {
+        {
+            std::lock_guard<std::mutex> lck(queueMtx);
+            readyBlocks.push_back(current);
+        }
+        queueCnd.notify_one();
+        if (_writeQueue) { _writeQueue->notify(); }
+        current = -1;
+    }
+
+    bool Writer::writeBlock() {
+        int id;
+        {
+            std::lock_guard<std::mutex> lck(queueMtx);
+            if (readyBlocks.empty()) { return false; }
+            id = readyBlocks.front();
+            readyBlocks.pop_front();
+        }
+
+        // Write it to disk and give it back
+        rw.write(blocks[id], blockFill[id]);
+        {
+            std::lock_guard<std::mutex> lck(queueMtx);
+            freeBlocks.push_back(id);
+        }
+        return true;
+    }
+
+    void Writer::worker() {
+        while (true) {
+            // Wait for a block, only exiting once the backlog is empty
+            {
+                std::unique_lock<std::mutex> lck(queueMtx);
+                queueCnd.wait(lck, [=]() { return !readyBlocks.empty() || stopWorker; });
+                if (readyBlocks.empty()) { return; }
+            }
+            writeBlock();
+        }
+    }
+
+    WriteQueue::WriteQueue() {
+        workerThread = std::thread(&WriteQueue::worker, this);
+    }
+
+    WriteQueue::~WriteQueue() {
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            stop = true;
+        }
+        cnd.notify_all();
+        if (workerThread.joinable()) { workerThread.join(); }
+    }
+
+    void WriteQueue::add(Writer* writer) {
+        std::lock_guard<std::mutex> lck(listMtx);
+        writers.push_back(writer);
+    }
+
+    void WriteQueue::remove(Writer* writer) {
+        // Waits for the thread to be done with the current round
+        std::lock_guard<std::mutex> lck(listMtx);
+        writers.erase(std::remove(writers.begin(), writers.end(), writer), writers.end());
+    }
+
+    void WriteQueue::notify() {
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            pending = true;
+        }
+        cnd.notify_one();
+    }
+
+    void WriteQueue::worker() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                cnd.wait(lck, [=]() { return pending || stop; });
+                if (stop) { return; }
+                pending = false;
+            }
+
+            // Write one block of each writer per round until none are left, keeping the writes large and sequential per file
+            std::lock_guard<std::mutex> lck(listMtx);
+            bool written = true;
+            while (written) {
+                written = false;
+                for (auto& writer : writers) { written |= writer->writeBlock(); }
+            }
+        }
+    }
 }
@@ -3,6 +3,11 @@
 #include <fstream>
 #include <stdint.h>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <atomic>
 #include "riff.h"
 
 namespace wav {    
@@ -34,6 +39,35 @@ namespace wav {
         CODEC_FLOAT = 3
     };
 
+    class Writer;
+
+    // Write-behind thread shared by several writers so that a single thread accesses the disk, the writers taking
+    // turns to write their blocks
+    class WriteQueue {
+    public:
+        WriteQueue();
+        ~WriteQueue();
+
+        void add(Writer* writer);
+
+        // Once removed, the writer is not accessed by the thread anymore
+        void remove(Writer* writer);
+
+        // Signal that a writer has a block ready
+        void notify();
+
+    private:
+        void worker();
+
+        std::mutex listMtx;
+        std::vector<Writer*> writers;
+        std::mutex mtx;
+        std::condition_variable cnd;
+        bool pending = false;
+        bool stop = false;
+        std::thread workerThread;
+    };
+
     class Writer {
     public:
         Writer(int channels = 2, uint64_t samplerate = 48000, Format format = FORMAT_WAV, SampleType type = SAMP_TYPE_INT16);
@@ -48,11 +82,33 @@ namespace wav {
         void setFormat(Format format);
         void setSampleType(SampleType type);
 
+        // Size in bytes of the in-RAM backlog written to disk by a dedicated thread, 0 to write synchronously
+        void setBacklog(size_t bytes);
+
+        // Write the backlog from a shared thread instead of one of its own, NULL for its own
+        void setWriteQueue(WriteQueue* queue);
+
+        // Size of the chunks the file is preallocated in, 0 to disable
+        void setPreallocation(size_t bytes);
+
         size_t getSamplesWritten() { return samplesWritten; }
 
+        // Number of samples dropped because the backlog was full
+        size_t getSamplesDropped() { return samplesDropped; }
+
+        // Fraction of the backlog waiting to be written to disk
+        float getBacklogFill();
+
         void write(float* samples, int count);
 
     private:
+        bool queue(const uint8_t* data, size_t len);
+        void submitBlock();
+        bool writeBlock();
+        void worker();
+
+        friend WriteQueue;
+
         std::recursive_mutex mtx;
         FormatHeader hdr;
         riff::Writer rw;
@@ -67,5 +123,20 @@ namespace wav {
         int16_t* bufI16 = NULL;
         int32_t* bufI32 = NULL;
         size_t samplesWritten = 0;
+
+        // Write-behind backlog
+        size_t _backlog = 0;
+        size_t blockSize = 0;
+        std::vector<uint8_t*> blocks;
+        std::vector<size_t> blockFill;
+        std::vector<int> freeBlocks;
+        std::deque<int> readyBlocks;
+        int current = -1;
+        std::atomic<size_t> samplesDropped = 0;
+        std::mutex queueMtx;
+        std::condition_variable queueCnd;
+        std::thread workerThread;
+        bool stopWorker = false;
+        WriteQueue* _writeQueue = NULL;
     };
 }
@@ -0,0 +1,438 @@
+#include "ziq.h"
+#include <zstd.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdexcept>
+#include <algorithm>
+#include <utils/flog.h>
+#include <dsp/compression/sample_stream_compressor.h>
+#include <dsp/compression/sample_stream_decompressor.h>
+
+namespace ziq {
+    const char* FILE_MAGIC          = "ZIQ1";
+    const char* INDEX_MAGIC         = "ZIDX";
+    const uint16_t FILE_VERSION     = 2;
+    const int MAX_THREADS           = 8;
+    const int SLOTS_PER_THREAD      = 4;
+    const int MIN_SLOTS             = 64;
+
+    Writer::~Writer() { close(); }
+
+    bool Writer::open(std::string path, double samplerate, double frequency, double startTime, dsp::compression::PCMType pcmType, int level, int threads) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        // Close previous file
+        if (file.is_open()) { close(); }
+
+        // Open file and write the header
+        file = std::ofstream(path, std::ios::out | std::ios::binary);
+        if (!file.is_open()) { return false; }
+        FileHeader hdr = {};
+        memcpy(hdr.magic, FILE_MAGIC, sizeof(hdr.magic));
+        hdr.version = FILE_VERSION;
+        hdr.pcmType = pcmType;
+        hdr.samplerate = samplerate;
+        hdr.frequency = frequency;
+        hdr.startTime = startTime;
+        hdr.blockSamples = blockSamples;
+        file.write((char*)&hdr, sizeof(FileHeader));
+
+        // Reset work values
+        _pcmType = pcmType;
+        _level = level;
+        head = 0;
+        tail = 0;
+        filling = false;
+        index.clear();
+        queuedSamples = 0;
+        pendingGap = 0;
+        lostSamples = 0;
+        samplesWritten = 0;
+        samplesDropped = 0;
+        bytesWritten = 0;
+        stopWorkers = false;
+
+        // Allocate the blocks, enough for each thread to have a few queued and for the disk to stall for a moment
+        if (threads <= 0) { threads = std::clamp<int>(std::thread::hardware_concurrency() / 2, 1, MAX_THREADS); }
+        slots.resize(std::max<int>(threads * SLOTS_PER_THREAD, MIN_SLOTS));
+        for (auto& slot : slots) {
+            slot.samples.resize(blockSamples);
+            slot.data.resize(ZSTD_compressBound((blockSamples * sizeof(dsp::complex_t)) + 8));
+            slot.state = SLOT_FREE;
+        }
+
+        // Start the workers
+        for (int i = 0; i < threads; i++) {
+            compressThreads.push_back(std::thread(&Writer::compressWorker, this));
+        }
+        diskThread = std::thread(&Writer::diskWorker, this);
+
+        return true;
+    }
+
+    bool Writer::isOpen() {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        return file.is_open();
+    }
+
+    void Writer::close() {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        // Do nothing if the file is not open
+        if (!file.is_open()) { return; }
+
+        // Send out the partial block and wait for everything to be on disk
+        if (filling && slots[head].count) { submit(); }
+        filling = false;
+        {
+            std::lock_guard<std::mutex> slck(slotMtx);
+            stopWorkers = true;
+        }
+        slotCnd.notify_all();
+        for (auto& thread : compressThreads) { thread.join(); }
+        compressThreads.clear();
+        if (diskThread.joinable()) { diskThread.join(); }
+
+        // Write the index and the footer
+        Footer footer = {};
+        footer.indexOffset = file.tellp();
+        footer.blockCount = index.size();
+        footer.sampleCount = queuedSamples + lostSamples + pendingGap;
+        memcpy(footer.magic, INDEX_MAGIC, sizeof(footer.magic));
+        file.write((char*)index.data(), index.size() * sizeof(IndexEntry));
+        file.write((char*)&footer, sizeof(Footer));
+
+        file.close();
+        slots.clear();
+    }
+
+    void Writer::write(const dsp::complex_t* samples, int count) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (!file.is_open()) { return; }
+
+        while (count > 0) {
+            // Start a new block, dropping the samples if all of them are busy. The block then starts after a gap
+            if (!filling) {
+                std::lock_guard<std::mutex> slck(slotMtx);
+                if (slots[head].state != SLOT_FREE) {
+                    samplesDropped += count;
+                    pendingGap += count;
+                    return;
+                }
+                slots[head].count = 0;
+                slots[head].gap = pendingGap;
+                pendingGap = 0;
+                filling = true;
+            }
+
+            // Fill it and submit it when full
+            Slot& slot = slots[head];
+            int n = std::min<int>(count, blockSamples - slot.count);
+            memcpy(&slot.samples[slot.count], samples, n * sizeof(dsp::complex_t));
+            slot.count += n;
+            samplesWritten += n;
+            samples += n;
+            count -= n;
+            if (slot.count == blockSamples) { submit(); }
+        }
+    }
+
+    float Writer::getBacklogFill() {
+        std::lock_guard<std::mutex> lck(slotMtx);
+        if (slots.empty()) { return 0.0f; }
+        int busy = std::count_if(slots.begin(), slots.end(), [](const Slot& s) { return s.state != SLOT_FREE; });
+        return (float)busy / (float)slots.size();
+    }
+
+    void Writer::submit() {
+        {
+            std::lock_guard<std::mutex> lck(slotMtx);
+            slots[head].state = SLOT_PENDING;
+            head = (head + 1) % slots.size();
+        }
+        filling = false;
+        slotCnd.notify_all();
+    }
+
+    void Writer::compressWorker() {
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, _level);
+        std::vector<uint8_t> packed((blockSamples * sizeof(dsp::complex_t)) + 8);
+
+        while (true) {
+            // Take the oldest pending block, only exiting once there are none left
+            Slot* slot = NULL;
+            {
+                std::unique_lock<std::mutex> lck(slotMtx);
+                slotCnd.wait(lck, [&]() {
+                    for (int i = 0; i < slots.size(); i++) {
+                        Slot& s = slots[(tail + i) % slots.size()];
+                        if (s.state == SLOT_PENDING) {
+                            slot = &s;
+                            return true;
+                        }
+                    }
+                    return stopWorkers;
+                });
+                if (!slot) { break; }
+                slot->state = SLOT_COMPRESSING;
+            }
+
+            // Convert to the sample stream block format and compress it
+            int psize = dsp::compression::SampleStreamCompressor::process(slot->count, _pcmType, slot->samples.data(), packed.data());
+            size_t csize = ZSTD_compressCCtx(cctx, slot->data.data(), slot->data.size(), packed.data(), psize, _level);
+            if (ZSTD_isError(csize)) {
+                flog::error("Could not compress IQ block: {0}", ZSTD_getErrorName(csize));
+                csize = 0;
+            }
+            slot->size = csize;
+
+            {
+                std::lock_guard<std::mutex> lck(slotMtx);
+                slot->state = SLOT_DONE;
+            }
+            slotCnd.notify_all();
+        }
+
+        ZSTD_freeCCtx(cctx);
+    }
+
+    void Writer::diskWorker() {
+        while (true) {
+            // Wait for the next block in order, exiting once all were written
+            Slot* slot;
+            {
+                std::unique_lock<std::mutex> lck(slotMtx);
+                slotCnd.wait(lck, [=]() { return slots[tail].state == SLOT_DONE || (stopWorkers && slots[tail].state == SLOT_FREE); });
+                if (slots[tail].state != SLOT_DONE) { return; }
+                slot = &slots[tail];
+            }
+
+            // Write it out and index it, blocks that failed to compress are lost and become part of the next gap
+            if (slot->size) {
+                BlockHeader bhdr;
+                bhdr.size = slot->size;
+                bhdr.samples = slot->count;
+                bhdr.gap = lostSamples + slot->gap;
+                IndexEntry entry;
+                entry.offset = file.tellp();
+                entry.firstSample = queuedSamples + bhdr.gap;
+                file.write((char*)&bhdr, sizeof(BlockHeader));
+                file.write((char*)slot->data.data(), slot->size);
+                index.push_back(entry);
+                queuedSamples += bhdr.gap + slot->count;
+                lostSamples = 0;
+                bytesWritten += sizeof(BlockHeader) + slot->size;
+            }
+            else {
+                samplesDropped += slot->count;
+                lostSamples += slot->gap + slot->count;
+            }
+
+            {
+                std::lock_guard<std::mutex> lck(slotMtx);
+                slot->state = SLOT_FREE;
+                tail = (tail + 1) % slots.size();
+            }
+        }
+    }
+
+    Reader::Reader(std::string path) {
+        file.open(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) { throw std::runtime_error("Could not open file"); }
+
+        // Check the header
+        file.read((char*)&hdr, sizeof(FileHeader));
+        if (!file || memcmp(hdr.magic, FILE_MAGIC, sizeof(hdr.magic)) || !hdr.version || hdr.version > FILE_VERSION) {
+            throw std::runtime_error("Invalid compressed IQ file");
+        }
+
+        // The block headers of version 1 have no gap
+        if (hdr.version < 2) { blockHeaderSize = offsetof(BlockHeader, gap); }
+        if (hdr.pcmType >= dsp::compression::_PCM_TYPE_COUNT) { throw std::runtime_error("Unsupported compressed IQ sample type"); }
+        file.seekg(0, std::ios::end);
+        uint64_t fileSize = file.tellg();
+
+        // Load the index, or rebuild it if the recording wasn't closed properly
+        Footer footer = {};
+        if (fileSize >= sizeof(FileHeader) + sizeof(Footer)) {
+            file.seekg(fileSize - sizeof(Footer));
+            file.read((char*)&footer, sizeof(Footer));
+        }
+        bool valid = file && !memcmp(footer.magic, INDEX_MAGIC, sizeof(footer.magic)) &&
+                     footer.indexOffset + (footer.blockCount * sizeof(IndexEntry)) + sizeof(Footer) == fileSize;
+        if (valid) {
+            index.resize(footer.blockCount);
+            file.seekg(footer.indexOffset);
+            file.read((char*)index.data(), index.size() * sizeof(IndexEntry));
+            sampleCount = footer.sampleCount;
+            dataEnd = footer.indexOffset;
+        }
+        else {
+            flog::warn("Compressed IQ file has no index, rebuilding it");
+            file.clear();
+            rebuildIndex(fileSize);
+        }
+
+        dctx = ZSTD_createDCtx();
+        prefetchThread = std::thread(&Reader::prefetchWorker, this);
+    }
+
+    Reader::~Reader() {
+        {
+            std::lock_guard<std::mutex> lck(prefetchMtx);
+            prefetchStop = true;
+        }
+        prefetchCnd.notify_one();
+        if (prefetchThread.joinable()) { prefetchThread.join(); }
+        if (dctx) { ZSTD_freeDCtx((ZSTD_DCtx*)dctx); }
+    }
+
+    void Reader::read(int64_t sample, int count, dsp::complex_t* out) {
+        std::lock_guard<std::mutex> lck(cacheMtx);
+        while (count > 0) {
+            int64_t block = findBlock(sample);
+            CacheSlot* slot = (block >= 0) ? getBlock(block) : NULL;
+            int64_t offset = (block >= 0) ? sample - (int64_t)index[block].firstSample : 0;
+            int n = slot ? std::min<int64_t>(count, (int64_t)slot->samples.size() - offset) : 0;
+
+            // Outside of the blocks, in a gap left by dropped samples or past the end of the file: zeros until the next block
+            if (n <= 0) {
+                if (block + 1 >= (int64_t)index.size()) {
+                    memset(out, 0, count * sizeof(dsp::complex_t));
+                    return;
+                }
+                n = std::min<int64_t>(count, (int64_t)index[block + 1].firstSample - sample);
+                memset(out, 0, n * sizeof(dsp::complex_t));
+            }
+            else {
+                memcpy(out, &slot->samples[offset], n * sizeof(dsp::complex_t));
+            }
+            out += n;
+            sample += n;
+            count -= n;
+        }
+    }
+
+    void Reader::prefetch(int64_t sample) {
+        if (index.empty()) { return; }
+        int64_t block = findBlock(sample) + 1;
+        {
+            std::lock_guard<std::mutex> lck(prefetchMtx);
+            prefetchBlock = (block < index.size()) ? block : 0;
+        }
+        prefetchCnd.notify_one();
+    }
+
+    bool Reader::readBlockHeader(uint64_t offset, BlockHeader& bhdr) {
+        bhdr = {};
+        file.seekg(offset);
+        file.read((char*)&bhdr, blockHeaderSize);
+        return (bool)file;
+    }
+
+    int64_t Reader::findBlock(int64_t sample) {
+        auto it = std::upper_bound(index.begin(), index.end(), (uint64_t)sample, [](uint64_t s, const IndexEntry& e) { return s < e.firstSample; });
+        return (it - index.begin()) - 1;
+    }
+
+    bool Reader::decode(int64_t block, std::vector<dsp::complex_t>& out, void* ctx, std::vector<uint8_t>& comp, std::vector<uint8_t>& packed) {
+        // Read the compressed block, which can't go past the next one or hold more than a block of samples
+        uint64_t end = (block + 1 < index.size()) ? index[block + 1].offset : dataEnd;
+        BlockHeader bhdr;
+        {
+            std::lock_guard<std::mutex> lck(fileMtx);
+            if (!readBlockHeader(index[block].offset, bhdr) || bhdr.samples > hdr.blockSamples || index[block].offset + blockHeaderSize + bhdr.size > end) {
+                file.clear();
+                return false;
+            }
+            comp.resize(bhdr.size);
+            file.read((char*)comp.data(), bhdr.size);
+            if (!file) {
+                file.clear();
+                return false;
+            }
+        }
+
+        // Decompress it and convert the samples
+        packed.resize((bhdr.samples * sizeof(dsp::complex_t)) + 8);
+        size_t size = ZSTD_decompressDCtx((ZSTD_DCtx*)ctx, packed.data(), packed.size(), comp.data(), comp.size());
+        if (ZSTD_isError(size)) { return false; }
+
+        // The type header of the data decides how many samples it unpacks to, reject any that wouldn't fit
+        if (size < 8 || dsp::compression::SampleStreamDecompressor::sampleCount(size, packed.data()) > bhdr.samples) { return false; }
+        out.resize(bhdr.samples);
+        int count = dsp::compression::SampleStreamDecompressor::process(size, packed.data(), out.data());
+        out.resize(count);
+        return true;
+    }
+
+    Reader::CacheSlot* Reader::getBlock(int64_t block) {
+        for (int i = 0; i < 2; i++) {
+            if (cache[i].block != block) { continue; }
+            nextSlot = !i;
+            return &cache[i];
+        }
+
+        // Not prefetched, decode it in place of the least recently used one
+        CacheSlot* slot = &cache[nextSlot];
+        nextSlot = !nextSlot;
+        slot->block = block;
+        if (block < 0 || !decode(block, slot->samples, dctx, comp, packed)) {
+            flog::error("Could not decode compressed IQ block {0}", block);
+            slot->samples.clear();
+        }
+        return slot;
+    }
+
+    void Reader::rebuildIndex(uint64_t fileSize) {
+        // Walk through the block headers until the data runs out
+        uint64_t offset = sizeof(FileHeader);
+        while (offset + blockHeaderSize <= fileSize) {
+            BlockHeader bhdr;
+            if (!readBlockHeader(offset, bhdr) || !bhdr.samples || bhdr.samples > hdr.blockSamples) { break; }
+            if (offset + blockHeaderSize + bhdr.size > fileSize) { break; }
+            IndexEntry entry;
+            entry.offset = offset;
+            entry.firstSample = sampleCount + bhdr.gap;
+            index.push_back(entry);
+            sampleCount = entry.firstSample + bhdr.samples;
+            offset += blockHeaderSize + bhdr.size;
+        }
+        dataEnd = offset;
+        file.clear();
+    }
+
+    void Reader::prefetchWorker() {
+        ZSTD_DCtx* ctx = ZSTD_createDCtx();
+        std::vector<dsp::complex_t> samples;
+        std::vector<uint8_t> pcomp;
+        std::vector<uint8_t> ppacked;
+
+        while (true) {
+            // Wait for a block to prefetch
+            int64_t block;
+            {
+                std::unique_lock<std::mutex> lck(prefetchMtx);
+                prefetchCnd.wait(lck, [=]() { return prefetchBlock >= 0 || prefetchStop; });
+                if (prefetchStop) { break; }
+                block = prefetchBlock;
+                prefetchBlock = -1;
+            }
+
+            // Skip it if it's already there
+            {
+                std::lock_guard<std::mutex> lck(cacheMtx);
+                if (cache[0].block == block || cache[1].block == block) { continue; }
+            }
+
+            // Decode it outside of the lock and put it in place of the least recently used slot
+            if (!decode(block, samples, ctx, pcomp, ppacked)) { continue; }
+            std::lock_guard<std::mutex> lck(cacheMtx);
+            if (cache[0].block == block || cache[1].block == block) { continue; }
+            CacheSlot& slot = cache[nextSlot];
+            std::swap(slot.samples, samples);
+            slot.block = block;
+        }
+
+        ZSTD_freeDCtx(ctx);
+    }
+}
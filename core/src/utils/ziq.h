@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <stdint.h>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <atomic>
+#include <dsp/types.h>
+#include <dsp/compression/pcm_type.h>
+
+// Number of samples in a block, the unit of compression and of random access
+#define ZIQ_DEFAULT_BLOCK_SAMPLES   131072
+#define ZIQ_DEFAULT_LEVEL           3
+
+// Compressed IQ files. The samples are cut into blocks, each stored in the block format of the
+// SampleStreamCompressor, compressed with zstd. An index of the blocks at the end of the file allows random access,
+// files that weren't closed properly are indexed by walking through the blocks instead. Samples the writer had to drop
+// are recorded as a gap before the next block, which readers fill with zeros to keep the timeline.
+namespace ziq {
+#pragma pack(push, 1)
+    struct FileHeader {
+        char magic[4];
+        uint16_t version;
+        uint16_t pcmType;
+        double samplerate;
+        double frequency;
+        double startTime;
+        uint32_t blockSamples;
+        uint32_t reserved;
+    };
+
+    struct BlockHeader {
+        uint32_t size;
+        uint32_t samples;
+        uint64_t gap;       // Samples dropped right before the block, not present in version 1 files
+    };
+
+    struct IndexEntry {
+        uint64_t offset;
+        uint64_t firstSample;
+    };
+
+    struct Footer {
+        uint64_t indexOffset;
+        uint64_t blockCount;
+        uint64_t sampleCount;
+        char magic[4];
+        uint32_t reserved;
+    };
+#pragma pack(pop)
+
+    // Compresses the blocks on a pool of threads, another thread writing them to disk in order
+    class Writer {
+    public:
+        Writer() {}
+        ~Writer();
+
+        // startTime is in seconds since the epoch, negative if unknown. threads is the number of compression threads, 0 for automatic
+        bool open(std::string path, double samplerate, double frequency, double startTime, dsp::compression::PCMType pcmType, int level = ZIQ_DEFAULT_LEVEL, int threads = 0);
+        bool isOpen();
+        void close();
+
+        void write(const dsp::complex_t* samples, int count);
+
+        size_t getSamplesWritten() { return samplesWritten; }
+
+        // Number of samples dropped because the compression could not keep up
+        size_t getSamplesDropped() { return samplesDropped; }
+
+        // Number of bytes of compressed data written to disk
+        uint64_t getBytesWritten() { return bytesWritten; }
+
+        // Fraction of the blocks waiting to be compressed or written
+        float getBacklogFill();
+
+    private:
+        enum SlotState {
+            SLOT_FREE,
+            SLOT_PENDING,
+            SLOT_COMPRESSING,
+            SLOT_DONE
+        };
+
+        struct Slot {
+            std::vector<dsp::complex_t> samples;
+            int count = 0;
+            uint64_t gap = 0;
+            std::vector<uint8_t> data;
+            size_t size = 0;
+            SlotState state = SLOT_FREE;
+        };
+
+        void submit();
+        void compressWorker();
+        void diskWorker();
+
+        std::recursive_mutex mtx;
+        std::ofstream file;
+        dsp::compression::PCMType _pcmType;
+        int _level;
+        uint32_t blockSamples = ZIQ_DEFAULT_BLOCK_SAMPLES;
+
+        std::vector<Slot> slots;
+        int head = 0;
+        int tail = 0;
+        bool filling = false;
+        std::vector<IndexEntry> index;
+        uint64_t queuedSamples = 0;
+        uint64_t pendingGap = 0;    // Dropped since the last block was started, owned by write()
+        uint64_t lostSamples = 0;   // Lost to compression errors since the last block written, owned by the disk worker
+        std::mutex slotMtx;
+        std::condition_variable slotCnd;
+        std::vector<std::thread> compressThreads;
+        std::thread diskThread;
+        bool stopWorkers = false;
+
+        std::atomic<size_t> samplesWritten = 0;
+        std::atomic<size_t> samplesDropped = 0;
+        std::atomic<uint64_t> bytesWritten = 0;
+    };
+
+    // Random access to a compressed IQ file. The block being read is cached and a thread decompresses the next one
+    // ahead of the position given to prefetch(). Throws runtime_error if the file can't be opened or is invalid
+    class Reader {
+    public:
+        Reader(std::string path);
+        ~Reader();
+
+        double getSampleRate() { return hdr.samplerate; }
+        double getFrequency() { return hdr.frequency; }
+        double getStartTime() { return hdr.startTime; }
+        int64_t getSampleCount() { return sampleCount; }
+
+        // Read count samples starting at the given one
+        void read(int64_t sample, int count, dsp::complex_t* out);
+
+        // Tell the prefetch thread which sample is being read
+        void prefetch(int64_t sample);
+
+    private:
+        struct CacheSlot {
+            int64_t block = -1;
+            std::vector<dsp::complex_t> samples;
+        };
+
+        bool readBlockHeader(uint64_t offset, BlockHeader& bhdr);
+        int64_t findBlock(int64_t sample);
+        bool decode(int64_t block, std::vector<dsp::complex_t>& out, void* dctx, std::vector<uint8_t>& comp, std::vector<uint8_t>& packed);
+        CacheSlot* getBlock(int64_t block);
+        void rebuildIndex(uint64_t fileSize);
+        void prefetchWorker();
+
+        std::ifstream file;
+        std::mutex fileMtx;
+        FileHeader hdr;
+        int blockHeaderSize = sizeof(BlockHeader);
+        std::vector<IndexEntry> index;
+        uint64_t dataEnd = 0;
+        int64_t sampleCount = 0;
+
+        CacheSlot cache[2];
+        int nextSlot = 0;
+        std::mutex cacheMtx;
+        void* dctx = NULL;
+        std::vector<uint8_t> comp;
+        std::vector<uint8_t> packed;
+
+        std::thread prefetchThread;
+        std::mutex prefetchMtx;
+        std::condition_variable prefetchCnd;
+        int64_t prefetchBlock = -1;
+        bool prefetchStop = false;
+    };
+}
@@ -5,6 +5,12 @@
 #include <dsp/multirate/polyphase_bank.h>
 #include <dsp/math/step.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define LINE_SIZE       945
 
 #define SYNC_LEN        70
@@ -111,7 +117,7 @@ public:
             // Process as much of a line as possible
             while (offset < count && pixel < LINE_SIZE) {
                 // Compute the output sample
-                volk_32f_x2_dot_prod_32f(&base_type::out.writeBuf[pixel++], &buffer[offset], interpBank.phases[(phase >> 23) & 0x7F], _interpTapCount);
+                base_type::out.writeBuf[pixel++] = interpolate(&buffer[offset], interpBank.phases[(phase >> 23) & 0x7F]);
                 
                 // Increment the phase
                 phase += period;
@@ -121,21 +127,12 @@ public:
 
             // If the line is done, process it
             if (pixel == LINE_SIZE) {
-                // Compute averages. (TODO: Try faster method)
-                float left = 0.0f, right = 0.0f;
-                int lc = 0, rc = 0;
-                for (int i = SYNC_L_START; i < LINE_SIZE; i++) {
-                    left += base_type::out.writeBuf[i];
-                    lc++;
-                }
-                for (int i = 0; i < SYNC_R_START; i++) {
-                    left += base_type::out.writeBuf[i];
-                    lc++;
-                }
-                for (int i = SYNC_R_START; i < SYNC_R_END; i++) {
-                    right += base_type::out.writeBuf[i];
-                    rc++;
-                }
+                // Compute the sums on each side of the sync
+                float leftEnd, leftStart, right;
+                volk_32f_accumulator_s32f(&leftEnd, &base_type::out.writeBuf[SYNC_L_START], LINE_SIZE - SYNC_L_START);
+                volk_32f_accumulator_s32f(&leftStart, base_type::out.writeBuf, SYNC_R_START);
+                volk_32f_accumulator_s32f(&right, &base_type::out.writeBuf[SYNC_R_START], SYNC_R_END - SYNC_R_START);
+                float left = leftEnd + leftStart;
 
                 // Compute the error
                 float error = (left - right) * (1.0f/((float)SYNC_HALF_LEN));
@@ -174,15 +171,7 @@ public:
                 phase &= 0x3FFFFFFF;
 
                 // Find the lowest value
-                float lowest = INFINITY;
-                int lowestId = -1;
-                for (int i = 0; i < LINE_SIZE; i++) {
-                    float val =  base_type::out.writeBuf[i];
-                    if (val < lowest) {
-                        lowest = val;
-                        lowestId = i;
-                    }
-                }
+                int lowestId = findLowest(base_type::out.writeBuf, LINE_SIZE);
 
                 // Check the the line is in lock
                 bool lineLocked = (lowestId < SYNC_R_END || lowestId >= SYNC_L_START);
@@ -227,6 +216,66 @@ public:
     bool fastLock = true;
 
 protected:
+    // Called for every pixel, the volk call costs more than the dot product itself with the default 8 taps
+    inline float interpolate(const float* in, const float* taps) {
+#if defined(__SSE2__) || defined(_M_X64)
+        if (_interpTapCount == 8) {
+            __m128 acc = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in), _mm_loadu_ps(taps)), _mm_mul_ps(_mm_loadu_ps(&in[4]), _mm_loadu_ps(&taps[4])));
+            acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+            acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+            return _mm_cvtss_f32(acc);
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        if (_interpTapCount == 8) {
+            float32x4_t acc = vmulq_f32(vld1q_f32(in), vld1q_f32(taps));
+            acc = vmlaq_f32(acc, vld1q_f32(&in[4]), vld1q_f32(&taps[4]));
+            return vaddvq_f32(acc);
+        }
+#endif
+        float out;
+        volk_32f_x2_dot_prod_32f(&out, in, taps, _interpTapCount);
+        return out;
+    }
+
+    // Index of the first occurrence of the lowest sample, each lane keeps its own minimum and they are merged at the end
+    static int findLowest(const float* in, int count) {
+        float lowest = INFINITY;
+        int lowestId = -1;
+        int i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        if (count >= 4) {
+            __m128 minVal = _mm_loadu_ps(in);
+            __m128i minIdx = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i idx = minIdx;
+            const __m128i step = _mm_set1_epi32(4);
+            for (i = 4; i + 4 <= count; i += 4) {
+                idx = _mm_add_epi32(idx, step);
+                __m128 val = _mm_loadu_ps(&in[i]);
+                __m128 lt = _mm_cmplt_ps(val, minVal);
+                minVal = _mm_min_ps(val, minVal);
+                minIdx = _mm_or_si128(_mm_and_si128(_mm_castps_si128(lt), idx), _mm_andnot_si128(_mm_castps_si128(lt), minIdx));
+            }
+            alignas(16) float vals[4];
+            alignas(16) int32_t ids[4];
+            _mm_store_ps(vals, minVal);
+            _mm_store_si128((__m128i*)ids, minIdx);
+            for (int l = 0; l < 4; l++) {
+                if (vals[l] < lowest || (vals[l] == lowest && ids[l] < lowestId)) {
+                    lowest = vals[l];
+                    lowestId = ids[l];
+                }
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            if (in[i] < lowest) {
+                lowest = in[i];
+                lowestId = i;
+            }
+        }
+        return lowestId;
+    }
+
     void generateInterpTaps() {
         double bw = 0.5 / (double)_interpPhaseCount;
         dsp::tap<float> lp = dsp::taps::windowedSinc<float>(_interpPhaseCount * _interpTapCount, dsp::math::hzToRads(bw, 1.0), dsp::window::nuttall, _interpPhaseCount);
@@ -12,7 +12,6 @@
 #include <dsp/sink/handler_sink.h>
 #include "linesync.h"
 #include <dsp/loop/pll.h>
-#include <dsp/convert/real_to_complex.h>
 #include <dsp/filter/fir.h>
 #include <dsp/taps/from_array.h>
 
@@ -24,6 +23,10 @@
 #include <dsp/math/normalize_phase.h>
 #include <fstream>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
 SDRPP_MOD_INFO{/* Name:            */ "atv_decoder",
@@ -48,8 +51,6 @@ class ATVDecoderModule : public ModuleManager::Instance {
         sync.init(&demod.out, 1.0f, 1e-6, 1.0, 0.05);
         sink.init(&sync.out, handler, this);
 
-        r2c.init(NULL);
-
         file = std::ofstream("chromasub_diff.bin", std::ios::binary | std::ios::out);
 
         agc.start();
@@ -132,6 +133,54 @@ class ATVDecoderModule : public ModuleManager::Instance {
 
     uint32_t pp = 0;
 
+    // Convert the chroma components to pixels, red being the in phase and green the quadrature component
+    static void chromaToPixels(const dsp::complex_t* in, uint32_t* out, int count) {
+        int i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 gain = _mm_set1_ps(5.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+        for (; i + 4 <= count; i += 4) {
+            __m128 a = _mm_loadu_ps((const float*)&in[i]);
+            __m128 b = _mm_loadu_ps((const float*)&in[i + 2]);
+            a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_and_ps(_mm_mul_ps(a, gain), absMask), scale), zero), scale);
+            b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_and_ps(_mm_mul_ps(b, gain), absMask), scale), zero), scale);
+            __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)), _mm_setzero_si128());
+            _mm_storeu_si128((__m128i*)&out[i], _mm_unpacklo_epi16(bytes, alpha));
+        }
+#endif
+        for (; i < count; i++) {
+            int imval1 = std::clamp<float>(fabsf(in[i].re*5.0f) * 255.0f, 0, 255);
+            int imval2 = std::clamp<float>(fabsf(in[i].im*5.0f) * 255.0f, 0, 255);
+            out[i] = 0xFF000000 | (imval2 << 8) | imval1;
+        }
+    }
+
+    // Convert the luma to grayscale pixels
+    static void lumaToPixels(const float* in, uint32_t* out, int count) {
+        int i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i alpha = _mm_set1_epi8((char)0xFF);
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[i]), scale), zero), scale);
+            __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[i + 4]), scale), zero), scale);
+            __m128i v = _mm_packus_epi16(_mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)), _mm_setzero_si128());
+            __m128i vv = _mm_unpacklo_epi8(v, v);
+            __m128i va = _mm_unpacklo_epi8(v, alpha);
+            _mm_storeu_si128((__m128i*)&out[i], _mm_unpacklo_epi16(vv, va));
+            _mm_storeu_si128((__m128i*)&out[i + 4], _mm_unpackhi_epi16(vv, va));
+        }
+#endif
+        for (; i < count; i++) {
+            int imval = std::clamp<float>(in[i] * 255.0f, 0, 255);
+            out[i] = 0xFF000000 | (imval << 16) | (imval << 8) | imval;
+        }
+    }
+
     static void handler(float *data, int count, void *ctx) {
         ATVDecoderModule *_this = (ATVDecoderModule *)ctx;
 
@@ -168,25 +217,23 @@ class ATVDecoderModule : public ModuleManager::Instance {
         // Save sync type to history
         _this->syncHistory = (_this->syncHistory << 2) | (longSync << 1) | shortSync;
 
-        // If the line has a colorburst, decode it
-        dsp::complex_t* buf1 = _this->r2c.out.readBuf;
-        dsp::complex_t* buf2 = _this->r2c.out.writeBuf;
+        // If the line has a colorburst, decode it. The chroma is only needed for the burst, and for the visible part
+        // of the line in color mode
+        dsp::complex_t* buf2 = _this->chromaBuf;
+        int chromaLen = _this->colorMode ? 768 : COLORBURST_LEN;
         if (true) {
-            // Convert the line into complex
-            _this->r2c.process(count, data, buf1);
-
-            // Extract the chroma subcarrier (TODO: Optimise by running only where needed)
-            for (int i = COLORBURST_START; i < count-(CHROMA_BANDPASS_DELAY+1); i++) {
-                volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&buf2[i], (lv_32fc_t*)&buf1[i - CHROMA_BANDPASS_DELAY], (lv_32fc_t*)CHROMA_BANDPASS, CHROMA_BANDPASS_SIZE);
+            // Extract the chroma subcarrier, the line being real the taps are used as the complex side of the dot product
+            for (int i = COLORBURST_START; i < COLORBURST_START + chromaLen; i++) {
+                volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&buf2[i], (lv_32fc_t*)CHROMA_BANDPASS, &data[i - CHROMA_BANDPASS_DELAY], CHROMA_BANDPASS_SIZE);
             }
 
             // Down convert the chroma subcarrier (TODO: Optimise by running only where needed)
             lv_32fc_t startPhase = { 1.0f, 0.0f };
             lv_32fc_t phaseDelta = { sinf(_this->subcarrierFreq), cosf(_this->subcarrierFreq) };
 #if VOLK_VERSION >= 030100
-            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)&buf2[COLORBURST_START], (lv_32fc_t*)&buf2[COLORBURST_START], &phaseDelta, &startPhase, count - COLORBURST_START);
+            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)&buf2[COLORBURST_START], (lv_32fc_t*)&buf2[COLORBURST_START], &phaseDelta, &startPhase, chromaLen);
 #else
-            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)&buf2[COLORBURST_START], (lv_32fc_t*)&buf2[COLORBURST_START], phaseDelta, &startPhase, count - COLORBURST_START);
+            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)&buf2[COLORBURST_START], (lv_32fc_t*)&buf2[COLORBURST_START], phaseDelta, &startPhase, chromaLen);
 #endif
 
             // Compute the phase of the burst
@@ -199,8 +246,8 @@ class ATVDecoderModule : public ModuleManager::Instance {
             burstAvg *= (1.0f / (burstAmp*burstAmp));
             burstAvg = burstAvg.conj();
 
-            // Normalize the chroma data (TODO: Optimise by running only where needed)
-            volk_32fc_s32fc_multiply_32fc((lv_32fc_t*)&buf2[COLORBURST_START], (lv_32fc_t*)&buf2[COLORBURST_START], *((lv_32fc_t*)&burstAvg), count - COLORBURST_START);
+            // Normalize the chroma data
+            volk_32fc_s32fc_multiply_32fc((lv_32fc_t*)&buf2[COLORBURST_START], (lv_32fc_t*)&buf2[COLORBURST_START], *((lv_32fc_t*)&burstAvg), chromaLen);
 
             // Compute the frequency error of the burst
             float phase = buf2[COLORBURST_START].phase();
@@ -220,17 +267,10 @@ class ATVDecoderModule : public ModuleManager::Instance {
         if (_this->ypos >= 34 && _this->ypos <= 34+576-1) {
             uint32_t* currentLine = &((uint32_t *)_this->img.buffer)[(_this->ypos - 34)*768];
             if (_this->colorMode) {
-                for (int i = 155; i < (155+768); i++) {
-                    int imval1 = std::clamp<float>(fabsf(buf2[i-155+COLORBURST_START].re*5.0f) * 255.0f, 0, 255);
-                    int imval2 = std::clamp<float>(fabsf(buf2[i-155+COLORBURST_START].im*5.0f) * 255.0f, 0, 255);
-                    currentLine[i-155] = 0xFF000000 | (imval2 << 8) | imval1;
-                }
+                chromaToPixels(&buf2[COLORBURST_START], currentLine, 768);
             }
             else {
-                for (int i = 155; i < (155+768); i++) {
-                    int imval = std::clamp<float>(data[i-155+COLORBURST_START] * 255.0f, 0, 255);
-                    currentLine[i-155] = 0xFF000000 | (imval << 16) | (imval << 8) | imval;
-                }
+                lumaToPixels(&data[COLORBURST_START], currentLine, 768);
             }
         }
 
@@ -299,7 +339,7 @@ class ATVDecoderModule : public ModuleManager::Instance {
     //dsp::demod::AM<float> demod;
     LineSync sync;
     dsp::sink::Handler<float> sink;
-    dsp::convert::RealToComplex r2c;
+    dsp::complex_t chromaBuf[LINE_SIZE];
 
     bool colorMode = false;
 
@@ -0,0 +1,310 @@
+#include <imgui.h>
+#include <config.h>
+#include <core.h>
+#include <gui/style.h>
+#include <gui/gui.h>
+#include <signal_path/signal_path.h>
+#include <module.h>
+#include <utils/optionlist.h>
+#include <dsp/demod/multi_nfm.h>
+#include <dsp/multirate/rational_resampler.h>
+
+#define CONCAT(a, b) ((std::string(a) + b).c_str())
+
+// The channels come out of the channelizer at twice their spacing, which is then directly the audio samplerate
+#define MONITOR_CHANNEL_SPACING     24000.0
+#define MONITOR_CHANNEL_COUNT       64
+#define MONITOR_SAMPLERATE          (MONITOR_CHANNEL_SPACING * MONITOR_CHANNEL_COUNT)
+#define MONITOR_BANDWIDTH           (MONITOR_SAMPLERATE - 4.0 * MONITOR_CHANNEL_SPACING)
+#define MONITOR_AUDIO_SAMPLERATE    (2.0 * MONITOR_CHANNEL_SPACING)
+#define MONITOR_MIN_SQUELCH         -100.0f
+#define MONITOR_MAX_SQUELCH         0.0f
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "channel_monitor",
+    /* Description:     */ "NFM receiver for many channels of a band at once"
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ -1
+};
+
+ConfigManager config;
+
+// Receives a list of NFM channels out of a single wideband VFO, the audio of the channels whose squelch is open being
+// mixed together into one sink stream
+class ChannelMonitorModule : public ModuleManager::Instance {
+public:
+    ChannelMonitorModule(std::string name) {
+        this->name = name;
+
+        // Define the options
+        bandwidths.define("6.25KHz", "6.25 KHz", 6250.0);
+        bandwidths.define("12.5KHz", "12.5 KHz", 12500.0);
+        deempModes.define("None", "None", 0.0);
+        deempModes.define("50us", "50us", 50e-6);
+        deempModes.define("75us", "75us", 75e-6);
+
+        // Load config
+        bandwidthId = bandwidths.valueId(12500.0);
+        config.acquire();
+        if (config.conf[name].contains("bandwidth")) {
+            std::string key = config.conf[name]["bandwidth"];
+            if (bandwidths.keyExists(key)) { bandwidthId = bandwidths.keyId(key); }
+        }
+        if (config.conf[name].contains("deemphasis")) {
+            std::string key = config.conf[name]["deemphasis"];
+            if (deempModes.keyExists(key)) { deempId = deempModes.keyId(key); }
+        }
+        if (config.conf[name].contains("squelchLevel")) {
+            squelchLevel = config.conf[name]["squelchLevel"];
+        }
+        if (config.conf[name].contains("channels")) {
+            for (auto& c : config.conf[name]["channels"]) {
+                channels.push_back({ c["frequency"].get<double>(), c["muted"].get<bool>() });
+            }
+        }
+        config.release();
+
+        // Initialize the DSP
+        vfo = createVFO();
+        vfo->setActive(false);
+        dsp.init(vfo->output, MONITOR_SAMPLERATE, MONITOR_CHANNEL_COUNT, bandwidths.value(bandwidthId), squelchLevel, deempModes.value(deempId));
+        rebuildChannels();
+        resamp.init(&dsp.out, MONITOR_AUDIO_SAMPLERATE, audioSampleRate);
+
+        // Initialize the sink
+        srChangeHandler.ctx = this;
+        srChangeHandler.handler = sampleRateChangeHandler;
+        stream.init(&resamp.out, &srChangeHandler, audioSampleRate);
+        consumedChangeHandler.ctx = this;
+        consumedChangeHandler.handler = streamConsumedChangeHandler;
+        stream.onConsumedChange.bindHandler(&consumedChangeHandler);
+        sigpath::sinkManager.registerStream(name, &stream);
+
+        dsp.start();
+        resamp.start();
+        stream.start();
+
+        gui::menu.registerEntry(name, menuHandler, this, this);
+    }
+
+    ~ChannelMonitorModule() {
+        gui::menu.removeEntry(name);
+        stream.stop();
+        if (enabled) {
+            disable();
+        }
+        sigpath::sinkManager.unregisterStream(name);
+    }
+
+    void postInit() {}
+
+    void enable() {
+        vfo = createVFO();
+        vfo->setActive(stream.isConsumed());
+        dsp.setInput(vfo->output);
+        dsp.start();
+        resamp.start();
+        lastCenter = NAN;
+        enabled = true;
+    }
+
+    void disable() {
+        dsp.stop();
+        resamp.stop();
+        sigpath::vfoManager.deleteVFO(vfo);
+        vfo = NULL;
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+private:
+    struct Channel {
+        double frequency;
+        bool muted;
+    };
+
+    VFOManager::VFO* createVFO() {
+        return sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, MONITOR_BANDWIDTH, MONITOR_SAMPLERATE, MONITOR_BANDWIDTH, MONITOR_BANDWIDTH, true);
+    }
+
+    static void menuHandler(void* ctx) {
+        ChannelMonitorModule* _this = (ChannelMonitorModule*)ctx;
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        if (!_this->enabled) { style::beginDisabled(); }
+
+        ImGui::LeftLabel("Bandwidth");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##channel_monitor_bw_", _this->name), &_this->bandwidthId, _this->bandwidths.txt)) {
+            _this->dsp.setBandwidth(_this->bandwidths.value(_this->bandwidthId));
+            config.acquire();
+            config.conf[_this->name]["bandwidth"] = _this->bandwidths.key(_this->bandwidthId);
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("De-emphasis");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##channel_monitor_deemp_", _this->name), &_this->deempId, _this->deempModes.txt)) {
+            _this->dsp.setDeemphasisTau(_this->deempModes.value(_this->deempId));
+            config.acquire();
+            config.conf[_this->name]["deemphasis"] = _this->deempModes.key(_this->deempId);
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("Squelch");
+        ImGui::FillWidth();
+        if (ImGui::SliderFloat(CONCAT("##channel_monitor_sql_", _this->name), &_this->squelchLevel, MONITOR_MIN_SQUELCH, MONITOR_MAX_SQUELCH, "%.3fdB")) {
+            _this->dsp.setSquelchLevel(_this->squelchLevel);
+            config.acquire();
+            config.conf[_this->name]["squelchLevel"] = _this->squelchLevel;
+            config.release(true);
+        }
+
+        if (_this->enabled) { _this->drawChannels(menuWidth); }
+
+        if (!_this->enabled) { style::endDisabled(); }
+    }
+
+    void drawChannels(float menuWidth) {
+        // Follow the tuning, the channels being set in absolute frequency
+        double center = gui::waterfall.getCenterFrequency() + vfo->getOffset();
+        if (center != lastCenter) {
+            for (int i = 0; i < channels.size(); i++) { dsp.setChannelOffset(i, channels[i].frequency - center); }
+            lastCenter = center;
+        }
+
+        // Channel list
+        int removed = -1;
+        bool modified = false;
+        if (!channels.empty() && ImGui::BeginTable(CONCAT("##channel_monitor_chans_", name), 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Frequency");
+            ImGui::TableSetupColumn("Level");
+            ImGui::TableSetupColumn("Mute", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableHeadersRow();
+            for (int i = 0; i < channels.size(); i++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                bool inBand = dsp.inBand(channels[i].frequency - center);
+                if (!inBand) { style::beginDisabled(); }
+                ImGui::Text("%.4lf MHz%s", channels[i].frequency / 1e6, dsp.isOpen(i) ? " *" : "");
+                ImGui::TableSetColumnIndex(1);
+                if (inBand) {
+                    ImGui::Text("%.1f dB", dsp.getLevel(i));
+                }
+                else {
+                    ImGui::TextUnformatted("---");
+                }
+                if (!inBand) { style::endDisabled(); }
+                ImGui::TableSetColumnIndex(2);
+                if (ImGui::Checkbox(CONCAT("##channel_monitor_mute_" + name, std::to_string(i)), &channels[i].muted)) {
+                    dsp.setChannelGain(i, channels[i].muted ? 0.0f : 1.0f);
+                    modified = true;
+                }
+                ImGui::TableSetColumnIndex(3);
+                if (ImGui::SmallButton(CONCAT("X##channel_monitor_rem_" + name, std::to_string(i)))) { removed = i; }
+            }
+            ImGui::EndTable();
+        }
+        if (removed >= 0) {
+            channels.erase(channels.begin() + removed);
+            rebuildChannels();
+            modified = true;
+        }
+
+        // New channel
+        ImGui::LeftLabel("Frequency");
+        ImGui::FillWidth();
+        ImGui::InputDouble(CONCAT("##channel_monitor_freq_", name), &newFreq, 0.0125, 0.1, "%.4f MHz");
+        if (ImGui::Button(CONCAT("Add Channel##channel_monitor_add_", name), ImVec2(menuWidth, 0))) {
+            channels.push_back({ round(newFreq * 1e6), false });
+            rebuildChannels();
+            modified = true;
+        }
+
+        if (modified) { saveChannels(); }
+    }
+
+    // Must be called from the UI thread
+    void rebuildChannels() {
+        double center = gui::waterfall.getCenterFrequency() + (vfo ? vfo->getOffset() : 0.0);
+        std::vector<double> offsets;
+        for (const auto& c : channels) { offsets.push_back(c.frequency - center); }
+        dsp.setChannels(offsets);
+        for (int i = 0; i < channels.size(); i++) {
+            dsp.setChannelGain(i, channels[i].muted ? 0.0f : 1.0f);
+        }
+        lastCenter = center;
+    }
+
+    void saveChannels() {
+        config.acquire();
+        config.conf[name]["channels"] = json::array();
+        for (const auto& c : channels) {
+            json ch;
+            ch["frequency"] = c.frequency;
+            ch["muted"] = c.muted;
+            config.conf[name]["channels"].push_back(ch);
+        }
+        config.release(true);
+    }
+
+    static void sampleRateChangeHandler(float sampleRate, void* ctx) {
+        ChannelMonitorModule* _this = (ChannelMonitorModule*)ctx;
+        _this->audioSampleRate = sampleRate;
+        _this->resamp.setOutSamplerate(sampleRate);
+    }
+
+    // Nothing downstream of the VFO runs while the audio isn't used
+    static void streamConsumedChangeHandler(bool consumed, void* ctx) {
+        ChannelMonitorModule* _this = (ChannelMonitorModule*)ctx;
+        if (_this->vfo) { _this->vfo->setActive(consumed); }
+    }
+
+    std::string name;
+    bool enabled = true;
+
+    OptionList<std::string, double> bandwidths;
+    int bandwidthId = 0;
+    OptionList<std::string, double> deempModes;
+    int deempId = 0;
+    float squelchLevel = -50.0f;
+
+    std::vector<Channel> channels;
+    double newFreq = 0.0;
+    double lastCenter = NAN;
+
+    // DSP Chain
+    VFOManager::VFO* vfo = NULL;
+    dsp::demod::MultiNFM dsp;
+    dsp::multirate::RationalResampler<dsp::stereo_t> resamp;
+    double audioSampleRate = 48000.0;
+
+    EventHandler<float> srChangeHandler;
+    EventHandler<bool> consumedChangeHandler;
+    SinkManager::Stream stream;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    config.setPath(core::args["root"].s() + "/channel_monitor_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new ChannelMonitorModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
+    delete (ChannelMonitorModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
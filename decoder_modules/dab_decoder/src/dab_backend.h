@@ -0,0 +1,384 @@
+#pragma once
+#include "dab_fec.h"
+#include "dab_dsp.h"
+#include <utils/flog.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <string>
+
+#define DAB_FIC_BLOCKS          4
+#define DAB_FIC_BLOCK_BITS      2304
+#define DAB_FIBS_PER_BLOCK      3
+#define DAB_FIB_BYTES           32
+#define DAB_CIFS                4
+#define DAB_CIF_BITS            55296
+#define DAB_CU_BITS             64
+#define DAB_INTERLEAVE_DEPTH    16
+
+// Number of logical frames a subchannel may have waiting for a worker before the oldest get dropped
+#define DAB_MAX_BACKLOG         32
+
+namespace dab {
+    const int TIME_INTERLEAVE_DELAYS[DAB_INTERLEAVE_DEPTH] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+    struct SubchannelInfo {
+        int id;
+        int start;
+        int size;
+        // Protection profile, 'A' or 'B' with a level from 1 to 4
+        char profile;
+        int level;
+        int bitrate;
+        uint64_t decoded;
+        uint64_t dropped;
+    };
+
+    // Channel decoder of a whole ensemble. The FIC is decoded on the calling thread, which also de-interleaves the
+    // MSC of every subchannel in time. The depuncturing and Viterbi decoding of the subchannels, which is where the
+    // time goes, is then run by a pool of workers. Frames of a same subchannel are always decoded one at a time and in
+    // order, different subchannels being decoded in parallel.
+    class Backend {
+    public:
+        // Receives the bytes of each logical frame of a subchannel, from a worker thread
+        typedef std::function<void(int subchId, const uint8_t* data, int len)> Handler;
+
+        Backend() {
+            // The FIC is sent as 21 blocks punctured with PI_16, 3 with PI_15 and the tail
+            ficPunct.init({ { 21, 16 }, { 3, 15 } });
+            ficMother.resize(ficPunct.motherBits());
+            ficBits.resize(ficPunct.dataBits());
+            ficPrbs.resize(ficPunct.dataBits());
+            energyDispersal(ficPrbs.data(), ficPrbs.size());
+        }
+
+        ~Backend() {
+            stop();
+        }
+
+        // threads is the number of workers, 0 to use all but one of the cores
+        void start(int threads = 0, Handler handler = NULL) {
+            if (running) { return; }
+            _handler = handler;
+            if (threads <= 0) { threads = std::max<int>((int)std::thread::hardware_concurrency() - 1, 1); }
+            stopping = false;
+            for (int i = 0; i < threads; i++) {
+                workers.push_back(std::thread(&Backend::worker, this));
+            }
+            running = true;
+        }
+
+        void stop() {
+            if (!running) { return; }
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                stopping = true;
+            }
+            cnd.notify_all();
+            for (auto& w : workers) {
+                if (w.joinable()) { w.join(); }
+            }
+            workers.clear();
+            running = false;
+        }
+
+        // Forget about the current ensemble
+        void reset() {
+            std::lock_guard<std::mutex> lck(mtx);
+            subchannels.clear();
+            ensembleId = -1;
+            ensembleLabel.clear();
+            fibCount = 0;
+            fibErrors = 0;
+        }
+
+        // Decode a transmission frame of DAB_FRAME_BITS soft bits
+        void process(const float* frame) {
+            // Decode the FIC blocks
+            for (int i = 0; i < DAB_FIC_BLOCKS; i++) {
+                decodeFIC(&frame[i * DAB_FIC_BLOCK_BITS]);
+            }
+
+            // De-interleave the subchannels of each CIF and hand them out to the workers
+            const float* msc = &frame[DAB_FIC_SYMBOLS * DAB_SYMBOL_BITS];
+            bool queued = false;
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                for (int i = 0; i < DAB_CIFS; i++) {
+                    const float* cif = &msc[i * DAB_CIF_BITS];
+                    for (auto& [id, sub] : subchannels) {
+                        queued |= deinterleave(sub.get(), &cif[sub->info.start * DAB_CU_BITS]);
+                    }
+                }
+            }
+            if (queued) { cnd.notify_all(); }
+        }
+
+        std::vector<SubchannelInfo> getSubchannels() {
+            std::lock_guard<std::mutex> lck(mtx);
+            std::vector<SubchannelInfo> list;
+            for (const auto& [id, sub] : subchannels) { list.push_back(sub->info); }
+            return list;
+        }
+
+        std::string getEnsembleLabel() {
+            std::lock_guard<std::mutex> lck(mtx);
+            return ensembleLabel;
+        }
+
+        int getEnsembleId() {
+            return ensembleId;
+        }
+
+        // Fraction of the FIBs that failed their CRC
+        float getFIBErrorRate() {
+            uint64_t count = fibCount;
+            return count ? (float)fibErrors / (float)count : 0.0f;
+        }
+
+    private:
+        struct Subchannel {
+            SubchannelInfo info;
+            Puncturing punct;
+            std::vector<uint8_t> prbs;
+
+            // Last CIFs of the subchannel, CIF n being in slot n % DAB_INTERLEAVE_DEPTH
+            std::vector<float> ring;
+            uint64_t cifCount = 0;
+
+            std::deque<std::vector<float>> jobs;
+            bool busy = false;
+        };
+
+        void decodeFIC(const float* in) {
+            ficPunct.depuncture(in, ficMother.data());
+            ficViterbi.decode(ficMother.data(), ficBits.data(), ficBits.size());
+            for (int i = 0; i < ficBits.size(); i++) { ficBits[i] ^= ficPrbs[i]; }
+            uint8_t bytes[DAB_FIBS_PER_BLOCK * DAB_FIB_BYTES];
+            packBits(ficBits.data(), bytes, ficBits.size());
+
+            for (int i = 0; i < DAB_FIBS_PER_BLOCK; i++) {
+                const uint8_t* fib = &bytes[i * DAB_FIB_BYTES];
+                fibCount++;
+                if (!checkCRC16(fib, DAB_FIB_BYTES - 2)) {
+                    fibErrors++;
+                    continue;
+                }
+                parseFIB(fib);
+            }
+        }
+
+        void parseFIB(const uint8_t* fib) {
+            int pos = 0;
+            while (pos < DAB_FIB_BYTES - 2) {
+                // 0xFF marks the end of the FIGs
+                uint8_t header = fib[pos];
+                if (header == 0xFF) { break; }
+                int type = header >> 5;
+                int len = header & 0x1F;
+                if (!len || pos + 1 + len > DAB_FIB_BYTES - 2) { break; }
+                const uint8_t* data = &fib[pos + 1];
+
+                if (type == 0) {
+                    // Only the current configuration of this ensemble is used
+                    bool next = data[0] & 0x80;
+                    bool other = data[0] & 0x40;
+                    int ext = data[0] & 0x1F;
+                    if (!next && !other && ext == 1) { parseSubchannels(&data[1], len - 1); }
+                }
+                else if (type == 1 && len >= 19) {
+                    int ext = data[0] & 0x07;
+                    if (ext == 0) { parseEnsembleLabel(&data[1]); }
+                }
+
+                pos += 1 + len;
+            }
+        }
+
+        // FIG 0/1, organisation of the subchannels
+        void parseSubchannels(const uint8_t* data, int len) {
+            int pos = 0;
+            while (pos + 3 <= len) {
+                int id = data[pos] >> 2;
+                int start = ((data[pos] & 3) << 8) | data[pos + 1];
+                bool longForm = data[pos + 2] & 0x80;
+
+                // The short form refers to the UEP tables, which aren't supported
+                if (!longForm) {
+                    if (!uepWarned) {
+                        flog::warn("DAB: Subchannel {} uses unequal error protection, it won't be decoded", id);
+                        uepWarned = true;
+                    }
+                    pos += 3;
+                    continue;
+                }
+                if (pos + 4 > len) { break; }
+                int option = (data[pos + 2] >> 4) & 7;
+                int level = ((data[pos + 2] >> 2) & 3) + 1;
+                int size = ((data[pos + 2] & 3) << 8) | data[pos + 3];
+                pos += 4;
+
+                updateSubchannel(id, start, size, option, level);
+            }
+        }
+
+        // FIG 1/0, name of the ensemble
+        void parseEnsembleLabel(const uint8_t* data) {
+            ensembleId = (data[0] << 8) | data[1];
+            std::string label((const char*)&data[2], 16);
+            label.erase(label.find_last_not_of(' ') + 1);
+            std::lock_guard<std::mutex> lck(mtx);
+            ensembleLabel = label;
+        }
+
+        void updateSubchannel(int id, int start, int size, int option, int level) {
+            std::lock_guard<std::mutex> lck(mtx);
+
+            // Nothing to do if the subchannel didn't change
+            auto it = subchannels.find(id);
+            char profile = option ? 'B' : 'A';
+            if (it != subchannels.end()) {
+                const SubchannelInfo& info = it->second->info;
+                if (info.start == start && info.size == size && info.profile == profile && info.level == level) { return; }
+            }
+
+            // Compute the puncturing of the EEP profile (EN 300 401 clause 11.3.2)
+            static const int sizesA[4] = { 12, 8, 6, 4 };
+            static const int sizesB[4] = { 27, 21, 18, 15 };
+            int n = size / (option ? sizesB : sizesA)[level - 1];
+            if (option > 1 || start + size > DAB_CIF_BITS / DAB_CU_BITS || n <= 0) {
+                flog::warn("DAB: Subchannel {} has an invalid organisation", id);
+                return;
+            }
+            std::vector<std::pair<int, int>> parts;
+            int bitrate;
+            if (option == 0) {
+                bitrate = 8 * n;
+                switch (level) {
+                case 1: parts = { { 6*n - 3, 24 }, { 3, 23 } }; break;
+                case 2: parts = (n == 1) ? std::vector<std::pair<int, int>>{ { 5, 13 }, { 1, 12 } } : std::vector<std::pair<int, int>>{ { 2*n - 3, 14 }, { 4*n + 3, 13 } }; break;
+                case 3: parts = { { 6*n - 3, 8 }, { 3, 7 } }; break;
+                case 4: parts = { { 4*n - 3, 3 }, { 2*n + 3, 2 } }; break;
+                }
+            }
+            else {
+                static const int pi1[4] = { 10, 6, 4, 2 };
+                static const int pi2[4] = { 9, 5, 3, 1 };
+                bitrate = 32 * n;
+                parts = { { 24*n - 3, pi1[level - 1] }, { 3, pi2[level - 1] } };
+            }
+
+            auto sub = std::make_shared<Subchannel>();
+            sub->punct.init(parts);
+            if (sub->punct.codedBits() != size * DAB_CU_BITS) {
+                flog::warn("DAB: Subchannel {} has an invalid size for its protection", id);
+                return;
+            }
+            sub->info = { id, start, size, profile, level, bitrate, 0, 0 };
+            sub->prbs.resize(sub->punct.dataBits());
+            energyDispersal(sub->prbs.data(), sub->prbs.size());
+            sub->ring.resize(DAB_INTERLEAVE_DEPTH * size * DAB_CU_BITS);
+
+            // A worker still decoding the previous organisation keeps it alive until done
+            subchannels[id] = sub;
+            flog::info("DAB: Subchannel {}: CU {} to {}, EEP {}-{}, {} kbit/s", id, start, start + size - 1, level, profile, bitrate);
+        }
+
+        // Store a CIF of a subchannel and queue the logical frame it completes, if any
+        bool deinterleave(Subchannel* sub, const float* in) {
+            int bits = sub->info.size * DAB_CU_BITS;
+            memcpy(&sub->ring[(sub->cifCount % DAB_INTERLEAVE_DEPTH) * bits], in, bits * sizeof(float));
+            sub->cifCount++;
+            if (sub->cifCount < DAB_INTERLEAVE_DEPTH) { return false; }
+
+            // Bit i of the oldest logical frame was sent TIME_INTERLEAVE_DELAYS[i % 16] CIFs after it
+            uint64_t first = sub->cifCount - DAB_INTERLEAVE_DEPTH;
+            const float* slots[DAB_INTERLEAVE_DEPTH];
+            for (int j = 0; j < DAB_INTERLEAVE_DEPTH; j++) {
+                slots[j] = &sub->ring[((first + TIME_INTERLEAVE_DELAYS[j]) % DAB_INTERLEAVE_DEPTH) * bits];
+            }
+            if (sub->jobs.size() >= DAB_MAX_BACKLOG) {
+                sub->jobs.pop_front();
+                sub->info.dropped++;
+            }
+            sub->jobs.emplace_back(bits);
+            float* job = sub->jobs.back().data();
+            for (int i = 0; i < bits; i++) { job[i] = slots[i % DAB_INTERLEAVE_DEPTH][i]; }
+            return true;
+        }
+
+        // Find a subchannel with a frame waiting and no worker on it, must be called with mtx held
+        std::shared_ptr<Subchannel> nextJob() {
+            for (auto& [id, sub] : subchannels) {
+                if (!sub->busy && !sub->jobs.empty()) { return sub; }
+            }
+            return NULL;
+        }
+
+        void worker() {
+            Viterbi viterbi;
+            std::vector<float> job;
+            std::vector<float> mother;
+            std::vector<uint8_t> bits;
+            std::vector<uint8_t> bytes;
+
+            while (true) {
+                // Wait for a frame to decode
+                std::shared_ptr<Subchannel> sub;
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    cnd.wait(lck, [&]() { return stopping || (sub = nextJob()); });
+                    if (stopping) { return; }
+                    job = std::move(sub->jobs.front());
+                    sub->jobs.pop_front();
+                    sub->busy = true;
+                }
+
+                // Decode it and remove the energy dispersal
+                mother.resize(sub->punct.motherBits());
+                bits.resize(sub->punct.dataBits());
+                bytes.resize(bits.size() / 8);
+                sub->punct.depuncture(job.data(), mother.data());
+                viterbi.decode(mother.data(), bits.data(), bits.size());
+                for (int i = 0; i < bits.size(); i++) { bits[i] ^= sub->prbs[i]; }
+                packBits(bits.data(), bytes.data(), bits.size());
+
+                if (_handler) { _handler(sub->info.id, bytes.data(), bytes.size()); }
+
+                // Let another worker pick up the next frame of this subchannel
+                {
+                    std::lock_guard<std::mutex> lck(mtx);
+                    sub->busy = false;
+                    sub->info.decoded++;
+                }
+                cnd.notify_one();
+            }
+        }
+
+        // FIC decoding, only used by the calling thread
+        Puncturing ficPunct;
+        Viterbi ficViterbi;
+        std::vector<float> ficMother;
+        std::vector<uint8_t> ficBits;
+        std::vector<uint8_t> ficPrbs;
+        std::atomic<uint64_t> fibCount = 0;
+        std::atomic<uint64_t> fibErrors = 0;
+        bool uepWarned = false;
+
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::map<int, std::shared_ptr<Subchannel>> subchannels;
+        std::atomic<int> ensembleId = -1;
+        std::string ensembleLabel;
+
+        Handler _handler;
+        std::vector<std::thread> workers;
+        bool running = false;
+        bool stopping = false;
+    };
+}
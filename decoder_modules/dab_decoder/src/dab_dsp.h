@@ -1,9 +1,16 @@
 #pragma once
 #include <dsp/processor.h>
 #include <utils/flog.h>
-#include <fftw3.h>
+#include <dsp/fft/plan.h>
 #include "dab_phase_sym.h"
 
+// Transmission mode I
+#define DAB_CARRIERS        1536
+#define DAB_SYMBOLS         76
+#define DAB_SYMBOL_BITS     (2*DAB_CARRIERS)
+#define DAB_FIC_SYMBOLS     3
+#define DAB_FRAME_BITS      ((DAB_SYMBOLS - 1) * DAB_SYMBOL_BITS)
+
 namespace dab {
     class CyclicSync : public dsp::Processor<dsp::complex_t, dsp::complex_t> {
         using base_type = dsp::Processor<dsp::complex_t, dsp::complex_t>;
@@ -22,9 +29,11 @@ namespace dab {
             delayBuf = dsp::buffer::alloc<dsp::complex_t>(STREAM_BUFFER_SIZE + 64000);
             dsp::buffer::clear(delayBuf, symbolSamps);
 
-            // Allocate and clear the history buffer
-            histBuf = dsp::buffer::alloc<dsp::complex_t>(prefixSamps);
-            dsp::buffer::clear(histBuf, prefixSamps);
+            // Allocate the product buffer, the products of the previous prefix being kept at its start
+            prodBuf = dsp::buffer::alloc<dsp::complex_t>(prefixSamps + STREAM_BUFFER_SIZE + 64000);
+            dsp::buffer::clear(prodBuf, prefixSamps);
+            corrBuf = dsp::buffer::alloc<dsp::complex_t>(STREAM_BUFFER_SIZE + 64000);
+            ampBuf = dsp::buffer::alloc<float>(STREAM_BUFFER_SIZE + 64000);
 
             // Compute the delay input addresses
             delayBufInput = &delayBuf[symbolSamps];
@@ -54,29 +63,26 @@ namespace dab {
             // Flush the input stream
             base_type::_in->flush();
 
-            // Do cross-correlation
-            for (int i = 0; i < count; i++) {
-                // Get the current history slot
-                dsp::complex_t* slot = &histBuf[histId++];
+            // Product of each sample with the conjugate of the one a symbol earlier
+            dsp::complex_t* prods = &prodBuf[prefixSamps];
+            volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)prods, (lv_32fc_t*)&delayBuf[symbolSamps], (lv_32fc_t*)delayBuf, count);
 
-                // Wrap around the history slot index (TODO: Check that the history buffer's length is correct)
-                histId %= prefixSamps;
+            // The correlation over the prefix moves by the product entering it minus the one leaving it
+            volk_32f_x2_subtract_32f((float*)corrBuf, (float*)prods, (float*)prodBuf, count * 2);
+            for (int i = 0; i < count; i++) {
+                corr += corrBuf[i];
+                corrBuf[i] = corr;
+            }
+            volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)corrBuf, count);
 
-                // Kick out last value from the correlation
-                corr -= *slot;
+            // Keep the products of the last prefix and sum them again so that rounding errors don't build up
+            memmove(prodBuf, &prodBuf[count], prefixSamps * sizeof(dsp::complex_t));
+            volk_32fc_accumulator_s32fc((lv_32fc_t*)&corr, (lv_32fc_t*)prodBuf, prefixSamps);
 
-                // Save input value and compute the new prodct
+            // Find the symbol boundaries
+            for (int i = 0; i < count; i++) {
                 dsp::complex_t val = delayBuf[i];
-                dsp::complex_t prod = val.conj()*delayBuf[i+symbolSamps];
-
-                // Add the new value to the correlation
-                *slot = prod;
-
-                // Add the new value to the history buffer
-                corr += prod;
-
-                // Compute sample amplitude
-                float rcorr = corr.amplitude();
+                float rcorr = ampBuf[i];
 
                 // If a high enough peak is reached, reset the symbol counter
                 if (rcorr > avgCorr && rcorr > peakCorr) { // Note keeping an average level might not be needed
@@ -119,8 +125,9 @@ namespace dab {
         int symbolSamps;
         int prefixSamps;
 
-        int histId = 0;
-        dsp::complex_t* histBuf;
+        dsp::complex_t* prodBuf;
+        dsp::complex_t* corrBuf;
+        float* ampBuf;
 
         dsp::complex_t* delayBuf;
         dsp::complex_t* delayBufInput;
@@ -149,6 +156,8 @@ namespace dab {
         void init(dsp::stream<dsp::complex_t>* in, float agcRate = 0.01f) {
             // Allocate buffers
             amps = dsp::buffer::alloc<float>(2048);
+            prevSym = dsp::buffer::alloc<dsp::complex_t>(2048);
+            diffBuf = dsp::buffer::alloc<dsp::complex_t>(DAB_CARRIERS);
             conjRef = dsp::buffer::alloc<dsp::complex_t>(2048);
             corrIn = (dsp::complex_t*)fftwf_alloc_complex(2048);
             corrOut = (dsp::complex_t*)fftwf_alloc_complex(2048);
@@ -157,13 +166,24 @@ namespace dab {
             memcpy(conjRef, DAB_PHASE_SYM_CONJ, 2048 * sizeof(dsp::complex_t));
 
             // Plan the FFT computation
-            plan = fftwf_plan_dft_1d(2048, (fftwf_complex*)corrIn, (fftwf_complex*)corrOut, FFTW_FORWARD, FFTW_ESTIMATE);
+            plan.create(2048, (fftwf_complex*)corrIn, (fftwf_complex*)corrOut, FFTW_FORWARD);
+
+            // Compute the frequency interleaving table, giving the FFT bin that carries each QPSK symbol
+            int pi = 0;
+            int n = 0;
+            for (int i = 0; i < 2048; i++) {
+                if (i) { pi = (13*pi + 511) % 2048; }
+                if (pi < 256 || pi > 1792 || pi == 1024) { continue; }
+                int k = pi - 1024;
+                carrierBins[n++] = (k >= 0) ? k : 2048 + k;
+            }
 
             // Compute the correlation AGC configuration
             this->agcRate = agcRate;
             agcRateInv = 1.0f - agcRate;
             
             base_type::init(in);
+            base_type::registerOutput(&frames);
         }
 
         void reset() {
@@ -210,11 +230,38 @@ namespace dab {
             // Update the average level
             avgLvl = agcRate*level + agcRateInv*avgLvl;
 
+            // Compute the spectrum of the symbol
+            if (sym >= 1) {
+                memcpy(corrIn, _in->readBuf, 2048 * sizeof(dsp::complex_t));
+                plan.execute();
+            }
+
+            // Demodulate the FIC and MSC symbols against the previous one
+            if (sym >= 2 && sym < DAB_SYMBOLS) {
+                float* bits = &frames.writeBuf[(sym - 2) * DAB_SYMBOL_BITS];
+                for (int i = 0; i < DAB_CARRIERS; i++) {
+                    int bin = carrierBins[i];
+                    diffBuf[i] = corrOut[bin] * prevSym[bin].conj();
+                }
+
+                // Normalize to the average amplitude of the symbol so that the soft bits of all symbols weigh the same
+                float norm = 0.0f;
+                volk_32fc_magnitude_32f(amps, (lv_32fc_t*)diffBuf, DAB_CARRIERS);
+                volk_32f_accumulator_s32f(&norm, amps, DAB_CARRIERS);
+                norm = (norm > 0.0f) ? (float)DAB_CARRIERS / norm : 0.0f;
+                for (int i = 0; i < DAB_CARRIERS; i++) {
+                    bits[i] = diffBuf[i].re * norm;
+                    bits[i + DAB_CARRIERS] = diffBuf[i].im * norm;
+                }
+
+                // Send out the frame once complete
+                if (sym == DAB_SYMBOLS - 1 && !frames.swap(DAB_FRAME_BITS)) { return -1; }
+            }
+            if (sym >= 1) { memcpy(prevSym, corrOut, 2048 * sizeof(dsp::complex_t)); }
+
             // Handle phase reference
             if (sym == 1) {
                 // Output the symbols (DEBUG ONLY)
-                memcpy(corrIn, _in->readBuf, 2048 * sizeof(dsp::complex_t));
-                fftwf_execute(plan);
                 volk_32fc_magnitude_32f(amps, (lv_32fc_t*)corrOut, 2048);
                 int outCount = 0;
                 dsp::complex_t pi4 = { cos(3.1415926535*0.25), sin(3.1415926535*0.25) };
@@ -230,7 +277,7 @@ namespace dab {
                 volk_32fc_x2_multiply_32fc((lv_32fc_t*)corrIn, (lv_32fc_t*)_in->readBuf, (lv_32fc_t*)conjRef, 2048);
             
                 // Compute the FFT of the product
-                fftwf_execute(plan);
+                plan.execute();
 
                 // Compute the amplitude of the bins
                 volk_32fc_magnitude_32f(amps, (lv_32fc_t*)corrOut, 2048);
@@ -255,22 +302,28 @@ namespace dab {
             }
 
             // Increment the symbol counter
-            sym++;
+            if (sym) { sym++; }
 
             // Flush the input stream and return
             base_type::_in->flush();
             return count;
         }
 
+        // Soft bits of each complete transmission frame, the FIC symbols followed by the MSC symbols
+        dsp::stream<float> frames;
+
     protected:
-        fftwf_plan plan;
+        dsp::fft::Plan plan;
 
         float* amps;
+        dsp::complex_t* prevSym;
+        dsp::complex_t* diffBuf;
+        int carrierBins[DAB_CARRIERS];
         dsp::complex_t* conjRef;
         dsp::complex_t* corrIn;
         dsp::complex_t* corrOut;
 
-        int sym;
+        int sym = 0;
         float offset = 0.0f;
 
         float avgLvl = 0.0f;
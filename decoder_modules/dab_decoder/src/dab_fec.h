@@ -0,0 +1,153 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+// Forward error correction of DAB (ETSI EN 300 401 clause 11 and 12). Soft bits are floats, positive for a 0 bit
+namespace dab {
+    // Rate 1/4 mother code, constraint length 7
+    const int CODE_POLYS[4] = { 0133, 0171, 0145, 0133 };
+    const int CODE_STATES = 64;
+    const int CODE_TAIL_BITS = 6;
+
+    // Punctured blocks are 128 coded bits long, plus 24 bits for the tail
+    const int PUNCT_BLOCK_BITS = 128;
+    const int PUNCT_TAIL_BITS = 24;
+
+    // Build the 32 bit puncturing vector PI_index (1 to 24), it keeps index + 8 of the 32 bits
+    inline void puncturingVector(int index, bool* vec) {
+        static const int order[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+        int extra[8] = { 0 };
+        for (int i = 0; i < index; i++) { extra[order[i % 8]]++; }
+        for (int j = 0; j < 8; j++) {
+            for (int k = 0; k < 4; k++) { vec[4*j + k] = (k <= extra[j]); }
+        }
+    }
+
+    // Puncturing of a whole code word: a list of (number of 128 bit blocks, vector index), followed by the tail
+    class Puncturing {
+    public:
+        Puncturing() {}
+
+        Puncturing(const std::vector<std::pair<int, int>>& parts) { init(parts); }
+
+        void init(const std::vector<std::pair<int, int>>& parts) {
+            keep.clear();
+            bool vec[32];
+            for (const auto& [blocks, index] : parts) {
+                puncturingVector(index, vec);
+                for (int i = 0; i < blocks * PUNCT_BLOCK_BITS; i++) { keep.push_back(vec[i % 32]); }
+            }
+
+            // PI_X keeps 1100 of each 4 bits of the tail
+            for (int i = 0; i < PUNCT_TAIL_BITS; i++) { keep.push_back((i % 4) < 2); }
+
+            inputBits = std::count(keep.begin(), keep.end(), true);
+        }
+
+        // Number of coded bits before and after puncturing
+        int motherBits() const { return keep.size(); }
+        int codedBits() const { return inputBits; }
+
+        // Number of bits that the code word decodes to
+        int dataBits() const { return (keep.size() / 4) - CODE_TAIL_BITS; }
+
+        // Fill in the punctured bits as erasures. in holds codedBits() and out motherBits() soft bits
+        void depuncture(const float* in, float* out) const {
+            int n = keep.size();
+            for (int i = 0; i < n; i++) { out[i] = keep[i] ? *(in++) : 0.0f; }
+        }
+
+    private:
+        std::vector<bool> keep;
+        int inputBits = 0;
+    };
+
+    // Soft decision Viterbi decoder of the mother code, the encoder starting and ending in state 0
+    class Viterbi {
+    public:
+        Viterbi() {
+            // Expected sign of the four output bits for each state and input bit
+            for (int s = 0; s < CODE_STATES; s++) {
+                for (int b = 0; b < 2; b++) {
+                    int reg = (b << 6) | s;
+                    for (int p = 0; p < 4; p++) {
+                        int parity = 0;
+                        for (int taps = reg & CODE_POLYS[p]; taps; taps >>= 1) { parity ^= taps & 1; }
+                        signs[(s << 1) | b][p] = parity ? -1.0f : 1.0f;
+                    }
+                }
+            }
+        }
+
+        // Decode count bits from count + 6 groups of 4 soft bits. The output holds one bit per byte
+        void decode(const float* in, uint8_t* out, int count) {
+            int steps = count + CODE_TAIL_BITS;
+            decisions.resize(steps * CODE_STATES);
+            float metrics[CODE_STATES];
+            float next[CODE_STATES];
+            std::fill(metrics, metrics + CODE_STATES, -1e30f);
+            metrics[0] = 0.0f;
+
+            for (int t = 0; t < steps; t++) {
+                const float* sym = &in[t * 4];
+                uint8_t* dec = &decisions[t * CODE_STATES];
+
+                // The new state holds the input bit at its top, its predecessors differ by the bit shifted out
+                for (int ns = 0; ns < CODE_STATES; ns++) {
+                    int b = ns >> 5;
+                    int s0 = (ns & 31) << 1;
+                    int s1 = s0 | 1;
+                    const float* e0 = signs[(s0 << 1) | b];
+                    const float* e1 = signs[(s1 << 1) | b];
+                    float m0 = metrics[s0] + e0[0]*sym[0] + e0[1]*sym[1] + e0[2]*sym[2] + e0[3]*sym[3];
+                    float m1 = metrics[s1] + e1[0]*sym[0] + e1[1]*sym[1] + e1[2]*sym[2] + e1[3]*sym[3];
+                    dec[ns] = (m1 > m0);
+                    next[ns] = (m1 > m0) ? m1 : m0;
+                }
+                memcpy(metrics, next, sizeof(metrics));
+            }
+
+            // Trace back from state 0, the tail bits being dropped
+            int state = 0;
+            for (int t = steps - 1; t >= 0; t--) {
+                if (t < count) { out[t] = state >> 5; }
+                state = ((state & 31) << 1) | decisions[t * CODE_STATES + state];
+            }
+        }
+
+    private:
+        float signs[CODE_STATES * 2][4];
+        std::vector<uint8_t> decisions;
+    };
+
+    // Energy dispersal sequence, x^9 + x^5 + 1 starting with all ones
+    inline void energyDispersal(uint8_t* prbs, int count) {
+        uint16_t reg = 0x1FF;
+        for (int i = 0; i < count; i++) {
+            uint8_t bit = ((reg >> 8) ^ (reg >> 4)) & 1;
+            reg = ((reg << 1) | bit) & 0x1FF;
+            prbs[i] = bit;
+        }
+    }
+
+    // Pack bits MSB first
+    inline void packBits(const uint8_t* bits, uint8_t* bytes, int count) {
+        for (int i = 0; i < count / 8; i++) {
+            uint8_t b = 0;
+            for (int j = 0; j < 8; j++) { b = (b << 1) | bits[i*8 + j]; }
+            bytes[i] = b;
+        }
+    }
+
+    // CRC of the FIBs, CCITT polynomial with an inverted result
+    inline bool checkCRC16(const uint8_t* data, int len) {
+        uint16_t crc = 0xFFFF;
+        for (int i = 0; i < len; i++) {
+            crc ^= (uint16_t)data[i] << 8;
+            for (int j = 0; j < 8; j++) { crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1); }
+        }
+        return (uint16_t)~crc == (((uint16_t)data[len] << 8) | data[len + 1]);
+    }
+}
@@ -13,6 +13,7 @@
 #include <fstream>
 #include <chrono>
 #include "dab_dsp.h"
+#include "dab_backend.h"
 #include <gui/widgets/constellation_diagram.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
@@ -50,11 +51,14 @@ public:
         csync.init(vfo->output, 1e-3, 246e-6, INPUT_SAMPLE_RATE);
         ffsync.init(&csync.out);
         ns.init(&ffsync.out, handler, this);
+        frameSink.init(&ffsync.frames, frameHandler, this);
 
         // Start DSO Here
+        backend.start();
         csync.start();
         ffsync.start();
         ns.start();
+        frameSink.start();
 
         gui::menu.registerEntry(name, menuHandler, this, this);
     }
@@ -66,6 +70,8 @@ public:
             csync.stop();
             ffsync.stop();
             ns.stop();
+            frameSink.stop();
+            backend.stop();
             sigpath::vfoManager.deleteVFO(vfo);
         }
 
@@ -83,9 +89,12 @@ public:
         csync.setInput(vfo->output);
 
         // Start DSP here
+        backend.reset();
+        backend.start();
         csync.start();
         ffsync.start();
         ns.start();
+        frameSink.start();
 
         enabled = true;
     }
@@ -95,6 +104,8 @@ public:
         csync.stop();
         ffsync.stop();
         ns.stop();
+        frameSink.stop();
+        backend.stop();
 
         sigpath::vfoManager.deleteVFO(vfo);
         enabled = false;
@@ -114,6 +125,42 @@ private:
 
         _this->constDiagram.draw();
 
+        // Ensemble
+        std::string label = _this->backend.getEnsembleLabel();
+        ImGui::Text("Ensemble: %s", label.empty() ? "-" : label.c_str());
+        if (_this->backend.getEnsembleId() >= 0) {
+            ImGui::SameLine();
+            ImGui::Text("(%04X)", _this->backend.getEnsembleId());
+        }
+        ImGui::Text("FIB errors: %.1f%%", _this->backend.getFIBErrorRate() * 100.0f);
+
+        // Subchannels
+        auto subchannels = _this->backend.getSubchannels();
+        if (!subchannels.empty() && ImGui::BeginTable(CONCAT("dab_subch_table_", _this->name), 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("SubCh");
+            ImGui::TableSetupColumn("Prot.");
+            ImGui::TableSetupColumn("kbit/s");
+            ImGui::TableSetupColumn("Frames");
+            ImGui::TableHeadersRow();
+            for (const auto& sub : subchannels) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%d", sub.id);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%d-%c", sub.level, sub.profile);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%d", sub.bitrate);
+                ImGui::TableSetColumnIndex(3);
+                if (sub.dropped) {
+                    ImGui::Text("%llu (%llu lost)", (unsigned long long)sub.decoded, (unsigned long long)sub.dropped);
+                }
+                else {
+                    ImGui::Text("%llu", (unsigned long long)sub.decoded);
+                }
+            }
+            ImGui::EndTable();
+        }
+
         if (!_this->enabled) { style::endDisabled(); }
     }
 
@@ -123,9 +170,13 @@ private:
         M17DecoderModule* _this = (M17DecoderModule*)ctx;
         //_this->file.write((char*)data, count * sizeof(dsp::complex_t));
 
-        dsp::complex_t* buf = _this->constDiagram.acquireBuffer();
-        memcpy(buf, data, 1024 * sizeof(dsp::complex_t));
-        _this->constDiagram.releaseBuffer();
+        _this->constDiagram.push(data, count);
+    }
+
+    static void frameHandler(float* data, int count, void* ctx) {
+        M17DecoderModule* _this = (M17DecoderModule*)ctx;
+        if (count != DAB_FRAME_BITS) { return; }
+        _this->backend.process(data);
     }
 
     std::string name;
@@ -134,6 +185,8 @@ private:
     dab::CyclicSync csync;
     dab::FrameFreqSync ffsync;
     dsp::sink::Handler<dsp::complex_t> ns;
+    dsp::sink::Handler<float> frameSink;
+    dab::Backend backend;
 
     ImGui::ConstellationDiagram constDiagram;
 
@@ -1,6 +1,7 @@
 #pragma once
 #include <dsp/block.h>
 #include <inttypes.h>
+#include <dsp/digital/reed_solomon_decoder.h>
 
 // WTF???
 extern "C" {
@@ -68,10 +69,7 @@ namespace dsp {
         void init(stream<uint8_t>* in) {
             _in = in;
 
-            for (int i = 0; i < 5; i++) { memset(buffers[i], 0, 255); }
-            for (int i = 0; i < 5; i++) { memset(outBuffers[i], 0, 255); }
-            rs = correct_reed_solomon_create(correct_rs_primitive_polynomial_ccsds, 120, 11, 16);
-            if (rs == NULL) { printf("Error creating the reed solomon decoder\n"); }
+            rs.init(correct_rs_primitive_polynomial_ccsds, 120, 11, 16);
 
             generic_block<FalconRS>::registerInput(_in);
             generic_block<FalconRS>::registerOutput(&out);
@@ -83,42 +81,22 @@ namespace dsp {
 
             uint8_t* data = _in->readBuf + 4;
 
-            // Deinterleave
+            // Convert from the dual basis, the codewords are decoded straight from the interleaved frame
             for (int i = 0; i < 255 * 5; i++) {
-                buffers[i % 5][i / 5] = fromDB[data[i]];
+                buffer[i] = fromDB[data[i]];
             }
 
             // Reed the solomon :weary:
-            int result = 0;
-            result = correct_reed_solomon_decode(rs, buffers[0], 255, outBuffers[0]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[1], 255, outBuffers[1]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[2], 255, outBuffers[2]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[3], 255, outBuffers[3]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[4], 255, outBuffers[4]);
-            if (result == -1) {
+            if (rs.decodeInterleaved(buffer, 5, messages)) {
                 _in->flush();
                 return count;
             }
 
-            // Reinterleave
+            // Reinterleave, the parity bytes being left zeroed
             for (int i = 0; i < 255 * 5; i++) {
-                out.writeBuf[i] = toDB[outBuffers[i % 5][i / 5]] ^ randVals[i % 255];
+                int id = i / 5;
+                uint8_t val = (id < 239) ? messages[(i % 5) * 239 + id] : 0;
+                out.writeBuf[i] = toDB[val] ^ randVals[i % 255];
             }
 
             out.swap(255 * 5);
@@ -131,9 +109,9 @@ namespace dsp {
 
     private:
         int count;
-        uint8_t buffers[5][255];
-        uint8_t outBuffers[5][255];
-        correct_reed_solomon* rs;
+        uint8_t buffer[255 * 5];
+        uint8_t messages[239 * 5];
+        digital::ReedSolomonDecoder rs;
 
         stream<uint8_t>* _in;
     };
@@ -5,6 +5,7 @@
 #include <dsp/routing.h>
 #include <dsp/demodulator.h>
 #include <dsp/sink.h>
+#include <dsp/digital/viterbi_decoder.h>
 #include <utils/flog.h>
 
 extern "C" {
@@ -119,8 +120,7 @@ namespace kgsstv {
         void init(dsp::stream<float>* in) {
             _in = in;
 
-            // TODO: Destroy
-            conv = correct_convolutional_create(2, 7, kgsstv_polynomial);
+            viterbi.init(7, kgsstv_polynomial);
             memset(convTmp, 0x00, 1024);
 
             dsp::generic_block<Deframer>::registerInput(_in);
@@ -191,7 +191,7 @@ namespace kgsstv {
                         }
 
                         // Decode convolutional code
-                        int convOutCount = correct_convolutional_decode_soft(conv, convTmp, 124, out.writeBuf);
+                        int convOutCount = viterbi.decode(convTmp, 124, out.writeBuf);
 
                         flog::warn("Frames written: {0}, frameBytes: {1}", ++framesWritten, convOutCount);
                         if (!out.swap(7)) {
@@ -211,7 +211,7 @@ namespace kgsstv {
 
     private:
         dsp::stream<float>* _in;
-        correct_convolutional* conv = NULL;
+        dsp::digital::ViterbiDecoder viterbi;
         uint8_t convTmp[1024];
 
         int match = 0;
@@ -0,0 +1,79 @@
+#include "codec2_pool.h"
+#include <dsp/thread_role.h>
+#include <algorithm>
+#include <chrono>
+
+// Threads of the pool at most, there being one per four cores below it. A Codec2 frame takes a few microseconds
+#define M17_CODEC2_MAX_THREADS  2
+
+namespace dsp {
+    void M17Codec2Pool::Channel::deactivate() {
+        active.store(false);
+        while (busy.load()) { std::this_thread::yield(); }
+    }
+
+    M17Codec2Pool::~M17Codec2Pool() {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        stopWorkers();
+    }
+
+    void M17Codec2Pool::add(Channel* channel) {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        channels.modify([&](std::vector<Channel*>& list) {
+            list.push_back(channel);
+            return true;
+        });
+        channelCount++;
+        if (!workers.empty()) { return; }
+
+        stop = false;
+        int count = std::clamp<int>(std::thread::hardware_concurrency() / 4, 1, M17_CODEC2_MAX_THREADS);
+        for (int i = 0; i < count; i++) { workers.emplace_back(&M17Codec2Pool::worker, this); }
+    }
+
+    void M17Codec2Pool::remove(Channel* channel) {
+        // Waits for the threads to be done with the list the channel was in
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        bool removed = channels.modify([&](std::vector<Channel*>& list) {
+            auto it = std::find(list.begin(), list.end(), channel);
+            if (it == list.end()) { return false; }
+            list.erase(it);
+            return true;
+        });
+        if (removed && !--channelCount) { stopWorkers(); }
+    }
+
+    void M17Codec2Pool::notify() {
+        // Not taking the lock, a wakeup missed by a thread about to wait is made up for by the timeout of the wait
+        pending.store(true, std::memory_order_release);
+        cnd.notify_one();
+    }
+
+    void M17Codec2Pool::stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            stop = true;
+        }
+        cnd.notify_all();
+        for (auto& t : workers) { t.join(); }
+        workers.clear();
+    }
+
+    void M17Codec2Pool::worker() {
+        dsp::applyThreadRole(dsp::THREAD_ROLE_VFO);
+        while (true) {
+            // Drain every active channel not already being drained by another thread, until none has anything left
+            bool worked = false;
+            channels.forEach([&](Channel* channel) {
+                if (channel->busy.exchange(true)) { return; }
+                if (channel->active.load()) { worked |= channel->drain(); }
+                channel->busy.store(false, std::memory_order_release);
+            });
+            if (worked) { continue; }
+
+            std::unique_lock<std::mutex> lck(mtx);
+            cnd.wait_for(lck, std::chrono::duration<double>(M17_CODEC2_WAKE_SECONDS), [&]() { return pending.exchange(false, std::memory_order_acquire) || stop; });
+            if (stop) { return; }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utils/cow_list.h>
+
+// Seconds the threads of the pool sleep at most, a missed wakeup delaying the audio by no more than that
+#define M17_CODEC2_WAKE_SECONDS 0.02
+
+namespace dsp {
+    // Threads shared by every M17 channel to decode their voice frames, so that the symbol and FEC chain of a channel
+    // never waits for Codec2. A channel is drained by one thread of the pool at a time, which decodes everything that
+    // was queued since in one batch, so the frames of a channel stay in order while many channels decode in parallel
+    class M17Codec2Pool {
+    public:
+        class Channel {
+        public:
+            virtual ~Channel() {}
+
+        protected:
+            friend M17Codec2Pool;
+
+            // Decode the queued frames, returns false if there were none
+            virtual bool drain() = 0;
+
+            // Once it returns, the pool isn't draining the channel and won't until it's made active again
+            void deactivate();
+
+            std::atomic<bool> active = false;
+
+        private:
+            std::atomic<bool> busy = false;
+        };
+
+        M17Codec2Pool() {}
+        ~M17Codec2Pool();
+
+        // The threads are started along with the first channel and stopped along with the last
+        void add(Channel* channel);
+
+        // Once removed, the channel is not accessed by the pool anymore
+        void remove(Channel* channel);
+
+        // Signal that a channel has frames to decode, never blocks
+        void notify();
+
+    private:
+        void worker();
+        void stopWorkers();
+
+        CowList<Channel*> channels;
+        int channelCount = 0;
+        std::mutex ctrlMtx;
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::atomic<bool> pending = false;
+        bool stop = false;
+        std::vector<std::thread> workers;
+    };
+}
@@ -4,10 +4,15 @@
 #include <dsp/sink/null_sink.h>
 #include <dsp/demod/gfsk.h>
 #include <dsp/routing/doubler.h>
+#include <dsp/digital/viterbi_decoder.h>
 #include <volk/volk.h>
 #include <codec2.h>
 #include <golay24.h>
 #include <lsf_decode.h>
+#include <codec2_pool.h>
+#include <vector>
+#include <atomic>
+#include <algorithm>
 
 extern "C" {
 #include <correct.h>
@@ -31,6 +36,15 @@ extern "C" {
 #define M17_END_FN          0x8000
 #define M17_STREAM_TIMEOUT  500
 
+// Codec2 payload of a stream frame, two 3200bps frames of 8 bytes
+#define M17_CODEC2_PAYLOAD_SIZE 16
+
+// Stream frames queued for the decoding pool at most, 40ms each
+#define M17_CODEC2_QUEUE        64
+
+// Stream frames decoded and written out at once at most
+#define M17_CODEC2_BATCH        16
+
 const uint8_t M17_LSF_SYNC[16] = { 0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1, 1, 0, 1, 1, 1 };
 const uint8_t M17_STF_SYNC[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 1, 1, 0, 1 };
 const uint8_t M17_PKF_SYNC[16] = { 0, 1, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
@@ -284,7 +298,6 @@ namespace dsp {
         ~M17LSFDecoder() {
             if (!block::_block_init) { return; }
             block::stop();
-            correct_convolutional_destroy(conv);
         }
 
         void init(stream<uint8_t>* in, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
@@ -292,7 +305,7 @@ namespace dsp {
             _handler = handler;
             _ctx = ctx;
 
-            conv = correct_convolutional_create(2, 5, correct_conv_m17_polynomial);
+            viterbi.init(5, correct_conv_m17_polynomial);
 
             block::registerInput(_in);
             block::_block_init = true;
@@ -312,26 +325,20 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            // Depuncture the data
+            // Depuncture the data into soft symbols, the punctured bits being erasures
             int inOffset = 0;
             for (int i = 0; i < M17_ENCODED_LSF_SIZE; i++) {
                 if (!M17_PUNCTURING_P1[i % 61]) {
-                    depunctured[i] = 0;
+                    depunctured[i] = 128;
                     continue;
                 }
-                depunctured[i] = _in->readBuf[inOffset++];
+                depunctured[i] = _in->readBuf[inOffset++] ? 255 : 0;
             }
 
             _in->flush();
 
-            // Pack into bytes
-            memset(packed, 0, 61);
-            for (int i = 0; i < M17_ENCODED_LSF_SIZE; i++) {
-                packed[i / 8] |= depunctured[i] << (7 - (i % 8));
-            }
-
             // Run through convolutional decoder
-            correct_convolutional_decode(conv, packed, M17_ENCODED_LSF_SIZE, lsf);
+            viterbi.decode(depunctured, M17_ENCODED_LSF_SIZE, lsf);
 
             // Decode it and call the handler
             M17LSF decLsf = M17DecodeLSF(lsf);
@@ -347,10 +354,9 @@ namespace dsp {
         void* _ctx;
 
         uint8_t depunctured[488];
-        uint8_t packed[61];
         uint8_t lsf[30];
 
-        correct_convolutional* conv;
+        dsp::digital::ViterbiDecoder viterbi;
     };
 
     class M17PayloadFEC : public block {
@@ -362,13 +368,12 @@ namespace dsp {
         ~M17PayloadFEC() {
             if (!block::_block_init) { return; }
             block::stop();
-            correct_convolutional_destroy(conv);
         }
 
         void init(stream<uint8_t>* in) {
             _in = in;
 
-            conv = correct_convolutional_create(2, 5, correct_conv_m17_polynomial);
+            viterbi.init(5, correct_conv_m17_polynomial);
 
             block::registerInput(_in);
             block::registerOutput(&out);
@@ -389,25 +394,18 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            // Depuncture the data
+            // Depuncture the data into soft symbols, the punctured bits being erasures
             int inOffset = 0;
             for (int i = 0; i < M17_ENCODED_PAYLOAD_SIZE; i++) {
                 if (!M17_PUNCTURING_P2[i % 12]) {
-                    depunctured[i] = 0;
+                    depunctured[i] = 128;
                     continue;
                 }
-                depunctured[i] = _in->readBuf[inOffset++];
-            }
-
-            // Pack into bytes
-            memset(packed, 0, 37);
-            for (int i = 0; i < M17_ENCODED_PAYLOAD_SIZE; i++) {
-                if (!(i % 8)) { packed[i / 8] = 0; }
-                packed[i / 8] |= depunctured[i] << (7 - (i % 8));
+                depunctured[i] = _in->readBuf[inOffset++] ? 255 : 0;
             }
 
             // Run through convolutional decoder
-            correct_convolutional_decode(conv, packed, M17_ENCODED_PAYLOAD_SIZE, out.writeBuf);
+            viterbi.decode(depunctured, M17_ENCODED_PAYLOAD_SIZE, out.writeBuf);
 
             _in->flush();
 
@@ -421,38 +419,43 @@ namespace dsp {
         stream<uint8_t>* _in;
 
         uint8_t depunctured[296];
-        uint8_t packed[37];
 
-        correct_convolutional* conv;
+        dsp::digital::ViterbiDecoder viterbi;
     };
 
-    class M17Codec2Decode : public block {
+    // Only follows the frame numbers of the stream, the voice frames being queued for a pool shared by every channel.
+    // The output is written by the threads of the pool
+    class M17Codec2Decode : public block, public M17Codec2Pool::Channel {
     public:
         M17Codec2Decode() {}
 
-        M17Codec2Decode(stream<uint8_t>* in) { init(in); }
+        M17Codec2Decode(stream<uint8_t>* in, M17Codec2Pool* pool) { init(in, pool); }
 
         ~M17Codec2Decode() {
             if (!block::_block_init) { return; }
             block::stop();
+            _pool->remove(this);
             codec2_destroy(codec);
             delete[] int16Audio;
             delete[] floatAudio;
         }
 
-        void init(stream<uint8_t>* in) {
+        void init(stream<uint8_t>* in, M17Codec2Pool* pool) {
             _in = in;
+            _pool = pool;
             lastConseqTime = std::chrono::high_resolution_clock::now();
 
             codec = codec2_create(CODEC2_MODE_3200);
             sampsPerC2Frame = codec2_samples_per_frame(codec);
             sampsPerC2FrameDouble = sampsPerC2Frame * 2;
-            int16Audio = new int16_t[sampsPerC2FrameDouble];
-            floatAudio = new float[sampsPerC2FrameDouble];
+            int16Audio = new int16_t[sampsPerC2FrameDouble * M17_CODEC2_BATCH];
+            floatAudio = new float[sampsPerC2FrameDouble * M17_CODEC2_BATCH];
+            queue.resize(M17_CODEC2_QUEUE * M17_CODEC2_PAYLOAD_SIZE);
 
             block::registerInput(_in);
             block::registerOutput(&out);
             block::_block_init = true;
+            _pool->add(this);
         }
 
         void setInput(stream<uint8_t>* in) {
@@ -476,6 +479,9 @@ namespace dsp {
             return std::chrono::duration_cast<std::chrono::milliseconds>(now - lastConseqTime).count() > M17_STREAM_TIMEOUT;
         }
 
+        // Number of frames dropped because the pool could not keep up
+        uint64_t getFramesDropped() { return framesDropped; }
+
         int run() {
             int count = _in->read();
             if (count < 0) { return -1; }
@@ -505,32 +511,83 @@ namespace dsp {
                 return count;
             }
 
-            // Decode both parts using codec
-            codec2_decode(codec, int16Audio, &_in->readBuf[2]);
-            codec2_decode(codec, &int16Audio[sampsPerC2Frame], &_in->readBuf[2 + 8]);
-
-            // Convert to float
-            volk_16i_s32f_convert_32f(floatAudio, int16Audio, 32768.0f, sampsPerC2FrameDouble);
-
-            // Interleave into stereo samples
-            volk_32f_x2_interleave_32fc((lv_32fc_t*)out.writeBuf, floatAudio, floatAudio, sampsPerC2FrameDouble);
+            // Queue both Codec2 frames, the frame is dropped whole if the queue is full
+            uint64_t w = writePos.load(std::memory_order_relaxed);
+            uint64_t r = readPos.load(std::memory_order_acquire);
+            if (w - r < M17_CODEC2_QUEUE) {
+                memcpy(&queue[(w % M17_CODEC2_QUEUE) * M17_CODEC2_PAYLOAD_SIZE], &_in->readBuf[2], M17_CODEC2_PAYLOAD_SIZE);
+                writePos.store(w + 1, std::memory_order_release);
+                _pool->notify();
+            }
+            else {
+                framesDropped++;
+            }
 
             _in->flush();
-
-            if (!out.swap(sampsPerC2FrameDouble)) { return -1; }
             return count;
         }
 
         stream<stereo_t> out;
 
+    protected:
+        void doStart() {
+            // Frames left from before the stop are stale
+            readPos = writePos.load();
+            active = true;
+            block::doStart();
+        }
+
+        void doStop() {
+            // The pool may be waiting on the output, it must be let go before waiting for it
+            out.stopWriter();
+            deactivate();
+            block::doStop();
+        }
+
+        // Called by one thread of the pool at a time
+        bool drain() {
+            uint64_t w = writePos.load(std::memory_order_acquire);
+            uint64_t r = readPos.load(std::memory_order_relaxed);
+            if (w == r) { return false; }
+
+            while (r < w) {
+                // Decode both parts of every frame of the batch using codec
+                int frames = std::min<uint64_t>(w - r, M17_CODEC2_BATCH);
+                for (int i = 0; i < frames; i++) {
+                    const uint8_t* payload = &queue[((r + i) % M17_CODEC2_QUEUE) * M17_CODEC2_PAYLOAD_SIZE];
+                    int16_t* audio = &int16Audio[i * sampsPerC2FrameDouble];
+                    codec2_decode(codec, audio, payload);
+                    codec2_decode(codec, &audio[sampsPerC2Frame], &payload[8]);
+                }
+                r += frames;
+                readPos.store(r, std::memory_order_release);
+
+                // Convert to float
+                int count = frames * sampsPerC2FrameDouble;
+                volk_16i_s32f_convert_32f(floatAudio, int16Audio, 32768.0f, count);
+
+                // Interleave into stereo samples
+                volk_32f_x2_interleave_32fc((lv_32fc_t*)out.writeBuf, floatAudio, floatAudio, count);
+                if (!out.swap(count)) { break; }
+            }
+            return true;
+        }
+
     private:
         stream<uint8_t>* _in;
+        M17Codec2Pool* _pool;
 
         std::recursive_mutex recvMtx;
         bool receiving = false;
         uint16_t lastFn = 0;
         std::chrono::high_resolution_clock::time_point lastConseqTime;
 
+        // Single producer single consumer queue of the Codec2 payloads, the positions only growing
+        std::vector<uint8_t> queue;
+        std::atomic<uint64_t> writePos = 0;
+        std::atomic<uint64_t> readPos = 0;
+        std::atomic<uint64_t> framesDropped = 0;
+
         int16_t* int16Audio;
         float* floatAudio;
 
@@ -643,11 +700,11 @@ namespace dsp {
     public:
         M17Decoder() {}
 
-        M17Decoder(stream<complex_t>* input, float sampleRate, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
-            init(input, sampleRate, handler, ctx);
+        M17Decoder(stream<complex_t>* input, float sampleRate, M17Codec2Pool* pool, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
+            init(input, sampleRate, pool, handler, ctx);
         }
 
-        void init(stream<complex_t>* input, float sampleRate, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
+        void init(stream<complex_t>* input, float sampleRate, M17Codec2Pool* pool, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
             _sampleRate = sampleRate;
 
             demod.init(input, M17_BAUDRATE, sampleRate, M17_DEVIATION, 31, M17_RRC_ALPHA, 1e-6f, 0.01f, 0.01f);
@@ -657,7 +714,7 @@ namespace dsp {
             lsfFEC.init(&demux.linkSetupOut, handler, ctx);
             payloadFEC.init(&demux.streamOut);
             decodeLICH.init(&demux.lichOut, handler, ctx);
-            decodeAudio.init(&payloadFEC.out);
+            decodeAudio.init(&payloadFEC.out, pool);
 
             ns2.init(&demux.packetOut);
 
@@ -28,6 +28,9 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
+// Shared by every instance, so that the voice of all the M17 channels is decoded by the same few threads
+dsp::M17Codec2Pool codec2Pool;
+
 #define INPUT_SAMPLE_RATE 14400
 
 class M17DecoderModule : public ModuleManager::Instance {
@@ -56,7 +59,7 @@ public:
         vfo->setSnapInterval(250);
 
         // Initialize DSP here
-        decoder.init(vfo->output, INPUT_SAMPLE_RATE, lsfHandler, this);
+        decoder.init(vfo->output, INPUT_SAMPLE_RATE, &codec2Pool, lsfHandler, this);
         resamp.init(decoder.out, 8000, audioSampRate);
         reshape.init(decoder.diagOut, 480, 0);
         diagHandler.init(&reshape.out, _diagHandler, this);
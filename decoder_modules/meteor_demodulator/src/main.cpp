@@ -7,6 +7,7 @@
 #include <module.h>
 #include <filesystem>
 #include "meteor_demod.h"
+#include "symbol_writer.h"
 #include <dsp/routing/splitter.h>
 #include <dsp/buffer/reshaper.h>
 #include <dsp/sink/handler_sink.h>
@@ -29,7 +30,7 @@ SDRPP_MOD_INFO{
 ConfigManager config;
 
 std::string genFileName(std::string prefix, std::string suffix) {
-    time_t now = time(0);
+    time_t now = sigpath::streamClock.nowTime();
     tm* ltm = localtime(&now);
     char buf[1024];
     sprintf(buf, "%s_%02d-%02d-%02d_%02d-%02d-%02d%s", prefix.c_str(), ltm->tm_hour, ltm->tm_min, ltm->tm_sec, ltm->tm_mday, ltm->tm_mon + 1, ltm->tm_year + 1900, suffix.c_str());
@@ -43,8 +44,6 @@ public:
     MeteorDemodulatorModule(std::string name) : folderSelect("%ROOT%/recordings") {
         this->name = name;
 
-        writeBuffer = new int8_t[STREAM_BUFFER_SIZE];
-
         // Load config
         config.acquire();
         // Note: this first one may not be needed but I'm paranoid
@@ -64,6 +63,7 @@ public:
 
         vfo = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, INPUT_SAMPLE_RATE, INPUT_SAMPLE_RATE, INPUT_SAMPLE_RATE, INPUT_SAMPLE_RATE, true);
         demod.init(vfo->output, 72000.0f, INPUT_SAMPLE_RATE, 33, 0.6f, 0.1f, 0.005f, brokenModulation, oqpsk, 1e-6, 0.01);
+        demod.setCostasBlockSize(16);
         split.init(&demod.out);
         split.bindStream(&symSinkStream);
         split.bindStream(&sinkStream);
@@ -85,7 +85,7 @@ public:
         if (recording) {
             std::lock_guard<std::mutex> lck(recMtx);
             recording = false;
-            recFile.close();
+            recWriter.close();
         }
         demod.stop();
         split.stop();
@@ -168,7 +168,7 @@ private:
             if (ImGui::Button(CONCAT("Stop##meteor_rec_", _this->name), ImVec2(menuWidth, 0))) {
                 _this->stopRecording();
             }
-            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Recording %.2fMB", (float)_this->dataWritten / 1000000.0f);
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Recording %.2fMB", (float)_this->recWriter.getBytesWritten() / 1000000.0f);
         }
         else {
             if (ImGui::Button(CONCAT("Record##meteor_rec_", _this->name), ImVec2(menuWidth, 0))) {
@@ -185,29 +185,20 @@ private:
     static void symSinkHandler(dsp::complex_t* data, int count, void* ctx) {
         MeteorDemodulatorModule* _this = (MeteorDemodulatorModule*)ctx;
 
-        dsp::complex_t* buf = _this->constDiagram.acquireBuffer();
-        memcpy(buf, data, 1024 * sizeof(dsp::complex_t));
-        _this->constDiagram.releaseBuffer();
+        _this->constDiagram.push(data, count);
     }
 
     static void sinkHandler(dsp::complex_t* data, int count, void* ctx) {
         MeteorDemodulatorModule* _this = (MeteorDemodulatorModule*)ctx;
         std::lock_guard<std::mutex> lck(_this->recMtx);
         if (!_this->recording) { return; }
-        for (int i = 0; i < count; i++) {
-            _this->writeBuffer[(2 * i)] = std::clamp<int>(data[i].re * 84.0f, -127, 127);
-            _this->writeBuffer[(2 * i) + 1] = std::clamp<int>(data[i].im * 84.0f, -127, 127);
-        }
-        _this->recFile.write((char*)_this->writeBuffer, count * 2);
-        _this->dataWritten += count * 2;
+        _this->recWriter.write(data, count);
     }
 
     void startRecording() {
         std::lock_guard<std::mutex> lck(recMtx);
-        dataWritten = 0;
         std::string filename = genFileName(folderSelect.expandString(folderSelect.path) + "/meteor", ".s");
-        recFile = std::ofstream(filename, std::ios::binary);
-        if (recFile.is_open()) {
+        if (recWriter.open(filename)) {
             flog::info("Recording to '{0}'", filename);
             recording = true;
         }
@@ -219,8 +210,7 @@ private:
     void stopRecording() {
         std::lock_guard<std::mutex> lck(recMtx);
         recording = false;
-        recFile.close();
-        dataWritten = 0;
+        recWriter.close();
     }
 
     static void moduleInterfaceHandler(int code, void* in, void* out, void* ctx) {
@@ -253,11 +243,9 @@ private:
 
     std::mutex recMtx;
     bool recording = false;
-    uint64_t dataWritten = 0;
-    std::ofstream recFile;
+    SymbolWriter recWriter;
     bool brokenModulation = false;
     bool oqpsk = false;
-    int8_t* writeBuffer;
 };
 
 MOD_EXPORT void _INIT_() {
@@ -1,6 +1,11 @@
 #pragma once
 #include <dsp/loop/pll.h>
 #include <dsp/math/step.h>
+#include <dsp/buffer/buffer.h>
+#include <volk/volk.h>
+
+// Largest number of samples derotated with the same loop state when the block mode is enabled
+#define METEOR_COSTAS_MAX_BLOCK_SIZE    64
 
 namespace dsp::loop {
     class MeteorCostas : public PLL {
@@ -8,10 +13,19 @@ namespace dsp::loop {
     public:
         MeteorCostas() {}
 
+        ~MeteorCostas() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(errBuf);
+            buffer::free(ampBuf);
+        }
+
         MeteorCostas(stream<complex_t>* in, double bandwidth, bool brokenModulation, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) { init(in, bandwidth, brokenModulation, initFreq, initPhase, minFreq, maxFreq); }
 
         void init(stream<complex_t>* in, double bandwidth, bool brokenModulation, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
             _broken = brokenModulation;
+            errBuf = buffer::alloc<float>(METEOR_COSTAS_MAX_BLOCK_SIZE);
+            ampBuf = buffer::alloc<float>(METEOR_COSTAS_MAX_BLOCK_SIZE);
             base_type::init(in, bandwidth, initPhase, initFreq, minFreq, maxFreq);
         }
 
@@ -21,10 +35,39 @@ namespace dsp::loop {
             _broken = enabled;
         }
 
+        // Number of samples derotated with the same loop state, 1 updating the loop after every sample. Larger blocks
+        // are derotated by a rotator extrapolating the phase from the frequency and their errors are computed all at
+        // once before being fed to the loop, at the cost of delaying the loop by up to a block
+        void setBlockSize(int blockSize) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _blockSize = std::clamp<int>(blockSize, 1, METEOR_COSTAS_MAX_BLOCK_SIZE);
+        }
+
         inline int process(int count, complex_t* in, complex_t* out) {
-            for (int i = 0; i < count; i++) {
-                out[i] = in[i] * math::phasor(-pcl.phase);
-                pcl.advance(errorFunction(out[i]));
+            if (_blockSize <= 1) {
+                for (int i = 0; i < count; i++) {
+                    out[i] = in[i] * math::phasor(-pcl.phase);
+                    pcl.advance(errorFunction(out[i]));
+                }
+                return count;
+            }
+
+            for (int i = 0; i < count; i += _blockSize) {
+                int n = std::min<int>(_blockSize, count - i);
+
+                // Derotate the block, the rotator starting again from the loop state so that no error accumulates
+                lv_32fc_t phase = lv_cmake(cosf(-pcl.phase), sinf(-pcl.phase));
+                lv_32fc_t delta = lv_cmake(cosf(-pcl.freq), sinf(-pcl.freq));
+#if VOLK_VERSION >= 030100
+                volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&in[i], &delta, &phase, n);
+#else
+                volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&in[i], delta, &phase, n);
+#endif
+
+                // Compute all the errors of the block, then run the loop over them
+                blockErrors(n, &out[i]);
+                for (int j = 0; j < n; j++) { pcl.advance(errBuf[j]); }
             }
             return count;
         }
@@ -55,6 +98,42 @@ namespace dsp::loop {
             return std::clamp<float>(err, -1.0f, 1.0f);
         }
 
+        void blockErrors(int count, const complex_t* in) {
+            if (_broken) {
+                const float PHASE1 = 0.47439988279190737;
+                const float PHASE2 = 2.1777839908413044;
+                const float PHASE3 = 3.8682349942715186;
+                const float PHASE4 = -0.29067248091319986;
+
+                volk_32fc_s32f_atan2_32f(errBuf, (const lv_32fc_t*)in, 1.0f, count);
+                volk_32fc_magnitude_32f(ampBuf, (const lv_32fc_t*)in, count);
+                for (int i = 0; i < count; i++) {
+                    float phase = errBuf[i];
+                    float dp1 = math::normalizePhase(phase - PHASE1);
+                    float dp2 = math::normalizePhase(phase - PHASE2);
+                    float dp3 = math::normalizePhase(phase - PHASE3);
+                    float dp4 = math::normalizePhase(phase - PHASE4);
+                    float lowest = dp1;
+                    if (fabsf(dp2) < fabsf(lowest)) { lowest = dp2; }
+                    if (fabsf(dp3) < fabsf(lowest)) { lowest = dp3; }
+                    if (fabsf(dp4) < fabsf(lowest)) { lowest = dp4; }
+                    errBuf[i] = std::clamp<float>(lowest * ampBuf[i], -1.0f, 1.0f);
+                }
+            }
+            else {
+                // Branchless form of the decision directed error, vectorized by the compiler
+                for (int i = 0; i < count; i++) {
+                    float re = in[i].re;
+                    float im = in[i].im;
+                    float err = ((re > 0.0f) ? im : -im) - ((im > 0.0f) ? re : -re);
+                    errBuf[i] = std::clamp<float>(err, -1.0f, 1.0f);
+                }
+            }
+        }
+
         bool _broken;
+        int _blockSize = 1;
+        float* errBuf = NULL;
+        float* ampBuf = NULL;
     };
 }
\ No newline at end of file
@@ -98,6 +98,13 @@ namespace dsp::demod {
             costas.setBandwidth(bandwidth);
         }
 
+        // See loop::MeteorCostas::setBlockSize()
+        void setCostasBlockSize(int blockSize) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            costas.setBlockSize(blockSize);
+        }
+
         void setMMParams(double omegaGain, double muGain, double omegaRelLimit = 0.01) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -0,0 +1,76 @@
+#pragma once
+#include <dsp/types.h>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <stdint.h>
+
+// Size in bytes of the buffer symbols are accumulated into before being written
+#define METEOR_SYMBOL_WRITER_BUFFER_SIZE    (1 << 20)
+
+// Writes soft symbols to a file as interleaved signed bytes. The symbols are converted straight into a large buffer
+// which is only written out once full, so that a recording costs a buffer copy per block instead of a write.
+class SymbolWriter {
+public:
+    SymbolWriter() {
+        buffer = new int8_t[METEOR_SYMBOL_WRITER_BUFFER_SIZE];
+    }
+
+    ~SymbolWriter() {
+        close();
+        delete[] buffer;
+    }
+
+    bool open(const std::string& path) {
+        close();
+        file = std::ofstream(path, std::ios::binary);
+        written = 0;
+        return file.is_open();
+    }
+
+    void close() {
+        if (!file.is_open()) { return; }
+        flush();
+        file.close();
+    }
+
+    bool isOpen() {
+        return file.is_open();
+    }
+
+    void write(const dsp::complex_t* data, int count) {
+        const float* in = (const float*)data;
+        int total = count * 2;
+        while (total) {
+            int n = std::min<int>(total, METEOR_SYMBOL_WRITER_BUFFER_SIZE - used);
+
+            // Clamping before the conversion gives the same result as the other way around and lets it vectorize
+            int8_t* out = &buffer[used];
+            for (int i = 0; i < n; i++) {
+                out[i] = (int8_t)std::clamp<float>(in[i] * 84.0f, -127.0f, 127.0f);
+            }
+            in += n;
+            total -= n;
+            used += n;
+            written += n;
+            if (used == METEOR_SYMBOL_WRITER_BUFFER_SIZE) { flush(); }
+        }
+    }
+
+    // Number of bytes written since the file was opened, including those still buffered
+    uint64_t getBytesWritten() {
+        return written;
+    }
+
+private:
+    void flush() {
+        if (!used) { return; }
+        file.write((char*)buffer, used);
+        used = 0;
+    }
+
+    std::ofstream file;
+    int8_t* buffer;
+    int used = 0;
+    uint64_t written = 0;
+};
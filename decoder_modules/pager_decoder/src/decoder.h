@@ -1,5 +1,19 @@
 #pragma once
 #include <signal_path/vfo_manager.h>
+#include <dsp/noise_reduction/energy_detector.h>
+
+// Energy detector ahead of the decoder DSP, levels in dB above the noise floor and times in seconds
+#define PAGER_DETECTOR_OPEN_LEVEL   6.0
+#define PAGER_DETECTOR_CLOSE_LEVEL  3.0
+#define PAGER_DETECTOR_HANG         0.5
+#define PAGER_DETECTOR_PRE_ROLL     0.25
+
+enum Protocol {
+    PROTOCOL_INVALID = -1,
+    PROTOCOL_POCSAG,
+    PROTOCOL_FLEX,
+    PROTOCOL_MULTI
+};
 
 class Decoder {
 public:
@@ -5,7 +5,9 @@
 #include <gui/widgets/symbol_diagram.h>
 #include <gui/style.h>
 #include <dsp/sink/handler_sink.h>
-#include "dsp.h"
+#include <dsp/buffer/reshaper.h>
+#include <dsp/demod/fsk.h>
+#include <dsp/taps/from_array.h>
 #include "flex.h"
 
 #define BAUDRATE    1600
@@ -25,7 +27,11 @@ public:
         // Init DSP
         vfo->setBandwidthLimits(12500, 12500, true);
         vfo->setSampleRate(SAMPLERATE, 12500);
-        dsp.init(vfo->output, SAMPLERATE, BAUDRATE);
+        detector.init(vfo->output, PAGER_DETECTOR_OPEN_LEVEL, PAGER_DETECTOR_CLOSE_LEVEL, PAGER_DETECTOR_HANG * SAMPLERATE, PAGER_DETECTOR_PRE_ROLL * SAMPLERATE);
+        float shapeTaps[] = { 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f };
+        dsp::tap<float> shape = dsp::taps::fromArray<float>(10, shapeTaps);
+        dsp.init(&detector.out, BAUDRATE, SAMPLERATE, -4500.0, shape, 1e-4, 1.0, 0.05, true);
+        dsp::taps::free(shape);
         reshape.init(&dsp.soft, BAUDRATE, (BAUDRATE / 30.0) - BAUDRATE);
         dataHandler.init(&dsp.out, _dataHandler, this);
         diagHandler.init(&reshape.out, _diagHandler, this);
@@ -45,6 +51,16 @@ public:
             // TODO: Implement baudrate change
         }
 
+        // The DSP only runs while the detector is open, unless it's turned off
+        if (ImGui::Checkbox(("Sleep when idle##pager_decoder_flex_sleep_" + name).c_str(), &sleepWhenIdle)) {
+            if (sleepWhenIdle) {
+                detector.setLevels(PAGER_DETECTOR_OPEN_LEVEL, PAGER_DETECTOR_CLOSE_LEVEL);
+            }
+            else {
+                detector.setLevels(-INFINITY, -INFINITY);
+            }
+        }
+
         ImGui::FillWidth();
         diag.draw();
     }
@@ -53,10 +69,11 @@ public:
         this->vfo = vfo;
         vfo->setBandwidthLimits(12500, 12500, true);
         vfo->setSampleRate(SAMPLERATE, 12500);
-        dsp.setInput(vfo->output);
+        detector.setInput(vfo->output);
     }
 
     void start() {
+        detector.start();
         dsp.start();
         reshape.start();
         dataHandler.start();
@@ -64,6 +81,7 @@ public:
     }
 
     void stop() {
+        detector.stop();
         dsp.stop();
         reshape.stop();
         dataHandler.stop();
@@ -98,7 +116,8 @@ private:
     std::string name;
     VFOManager::VFO* vfo;
 
-    FLEXDSP dsp;
+    dsp::noise_reduction::EnergyDetector detector;
+    dsp::demod::FSK dsp;
     dsp::buffer::Reshaper<float> reshape;
     dsp::sink::Handler<uint8_t> dataHandler;
     dsp::sink::Handler<float> diagHandler;
@@ -108,6 +127,7 @@ private:
     ImGui::SymbolDiagram diag;
 
     int brId = 0;
+    bool sleepWhenIdle = true;
 
     OptionList<int, int> baudrates;
 };
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "decoder.h"
 #include "pocsag/decoder.h"
 #include "flex/decoder.h"
+#include "multi/decoder.h"
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -23,12 +24,6 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
-enum Protocol {
-    PROTOCOL_INVALID = -1,
-    PROTOCOL_POCSAG,
-    PROTOCOL_FLEX
-};
-
 class PagerDecoderModule : public ModuleManager::Instance {
 public:
     PagerDecoderModule(std::string name) {
@@ -37,6 +32,7 @@ public:
         // Define protocols
         protocols.define("POCSAG", PROTOCOL_POCSAG);
         protocols.define("FLEX", PROTOCOL_FLEX);
+        protocols.define("Multi-channel", PROTOCOL_MULTI);
 
         // Initialize VFO with default values
         vfo = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, 12500, 24000, 12500, 12500, true);
@@ -101,6 +97,9 @@ public:
         case PROTOCOL_FLEX:
             decoder = std::make_unique<FLEXDecoder>(name, vfo);
             break;
+        case PROTOCOL_MULTI:
+            decoder = std::make_unique<MultiChannelDecoder>(name, vfo, &config);
+            break;
         default:
             flog::error("Tried to select unknown pager protocol");
             return;
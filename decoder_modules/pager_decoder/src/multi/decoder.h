@@ -0,0 +1,269 @@
+#pragma once
+#include "../decoder.h"
+#include <signal_path/vfo_manager.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <utils/optionlist.h>
+#include <config.h>
+#include <deque>
+#include <ctime>
+#include <inttypes.h>
+#include "dsp.h"
+#include "../pocsag/pocsag.h"
+#include "../flex/flex.h"
+
+// The wideband VFO is split into 128 channels of 12.5KHz, the outer ones being left to the filter of the VFO
+#define MULTI_CHANNEL_SPACING       12500.0
+#define MULTI_CHANNEL_COUNT         128
+#define MULTI_SAMPLERATE            (MULTI_CHANNEL_SPACING * MULTI_CHANNEL_COUNT)
+#define MULTI_BANDWIDTH             (MULTI_SAMPLERATE - 8.0 * MULTI_CHANNEL_SPACING)
+#define MULTI_POCSAG_BAUDRATE       2400
+#define MULTI_FLEX_BAUDRATE         1600
+#define MULTI_MAX_LOG_SIZE          1000
+
+// Decodes a list of POCSAG and FLEX channels from a single wideband VFO, all the messages going to a single log
+class MultiChannelDecoder : public Decoder {
+public:
+    MultiChannelDecoder(const std::string& name, VFOManager::VFO* vfo, ConfigManager* config) {
+        this->name = name;
+        this->vfo = vfo;
+        this->config = config;
+
+        // Define channel protocols
+        protocols.define("POCSAG", PROTOCOL_POCSAG);
+        protocols.define("FLEX", PROTOCOL_FLEX);
+
+        // Load the channel list
+        config->acquire();
+        if (config->conf[name].contains("channels")) {
+            for (auto& c : config->conf[name]["channels"]) {
+                std::string protoKey = c["protocol"];
+                if (!protocols.keyExists(protoKey)) { continue; }
+                channels.push_back({ c["frequency"].get<double>(), protocols.value(protocols.keyId(protoKey)) });
+            }
+        }
+        config->release();
+
+        // Init DSP
+        vfo->setBandwidthLimits(MULTI_BANDWIDTH, MULTI_BANDWIDTH, true);
+        vfo->setSampleRate(MULTI_SAMPLERATE, MULTI_BANDWIDTH);
+        dsp.init(vfo->output, MULTI_SAMPLERATE, MULTI_CHANNEL_COUNT, _dataHandler, this);
+        rebuildChannels();
+    }
+
+    ~MultiChannelDecoder() {
+        stop();
+    }
+
+    void showMenu() {
+        // Follow the tuning, the channels being set in absolute frequency
+        double center = gui::waterfall.getCenterFrequency() + vfo->getOffset();
+        if (center != lastCenter) {
+            for (int i = 0; i < channels.size(); i++) { dsp.setChannelOffset(i, channels[i].frequency - center); }
+            lastCenter = center;
+        }
+
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        // Channel list
+        int removed = -1;
+        if (!channels.empty() && ImGui::BeginTable(("##pager_decoder_multi_chans_" + name).c_str(), 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Frequency");
+            ImGui::TableSetupColumn("Protocol");
+            ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed);
+            ImGui::TableHeadersRow();
+            for (int i = 0; i < channels.size(); i++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                bool inBand = dsp.inBand(channels[i].frequency - center);
+                if (!inBand) { style::beginDisabled(); }
+                ImGui::Text("%.4lf MHz%s", channels[i].frequency / 1e6, dsp.isOpen(i) ? " *" : "");
+                if (!inBand) { style::endDisabled(); }
+                ImGui::TableSetColumnIndex(1);
+                ImGui::TextUnformatted(protocols.key(protocols.valueId(channels[i].proto)).c_str());
+                ImGui::TableSetColumnIndex(2);
+                if (ImGui::SmallButton(("X##pager_decoder_multi_rem_" + name + std::to_string(i)).c_str())) { removed = i; }
+            }
+            ImGui::EndTable();
+        }
+        if (removed >= 0) {
+            channels.erase(channels.begin() + removed);
+            rebuildChannels();
+            saveChannels();
+        }
+
+        // New channel
+        ImGui::LeftLabel("Frequency");
+        ImGui::FillWidth();
+        ImGui::InputDouble(("##pager_decoder_multi_freq_" + name).c_str(), &newFreq, 0.0125, 0.1, "%.4f MHz");
+        ImGui::LeftLabel("Protocol");
+        ImGui::FillWidth();
+        ImGui::Combo(("##pager_decoder_multi_proto_" + name).c_str(), &newProtoId, protocols.txt);
+        if (ImGui::Button(("Add Channel##pager_decoder_multi_add_" + name).c_str(), ImVec2(menuWidth, 0))) {
+            channels.push_back({ round(newFreq * 1e6), protocols.value(newProtoId) });
+            rebuildChannels();
+            saveChannels();
+        }
+
+        // Merged message log
+        if (ImGui::Button(("Clear Messages##pager_decoder_multi_clear_" + name).c_str(), ImVec2(menuWidth, 0))) {
+            std::lock_guard<std::mutex> lck(logMtx);
+            log.clear();
+        }
+        std::lock_guard<std::mutex> lck(logMtx);
+        if (ImGui::BeginTable(("##pager_decoder_multi_log_" + name).c_str(), 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 300.0f * style::uiScale))) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Time");
+            ImGui::TableSetupColumn("Frequency");
+            ImGui::TableSetupColumn("Address");
+            ImGui::TableSetupColumn("Type");
+            ImGui::TableSetupColumn("Message");
+            ImGui::TableHeadersRow();
+            for (auto it = log.rbegin(); it != log.rend(); it++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(it->time);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.4lf", it->frequency / 1e6);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%" PRIu64, it->address);
+                ImGui::TableSetColumnIndex(3);
+                ImGui::TextUnformatted(it->type);
+                ImGui::TableSetColumnIndex(4);
+                ImGui::TextUnformatted(it->text.c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    void setVFO(VFOManager::VFO* vfo) {
+        this->vfo = vfo;
+        vfo->setBandwidthLimits(MULTI_BANDWIDTH, MULTI_BANDWIDTH, true);
+        vfo->setSampleRate(MULTI_SAMPLERATE, MULTI_BANDWIDTH);
+        dsp.setInput(vfo->output);
+        lastCenter = NAN;
+    }
+
+    void start() {
+        dsp.start();
+        running = true;
+    }
+
+    void stop() {
+        dsp.stop();
+        running = false;
+    }
+
+private:
+    struct Channel {
+        double frequency;
+        Protocol proto;
+    };
+
+    struct Message {
+        char time[16];
+        double frequency;
+        uint64_t address;
+        const char* type;
+        std::string text;
+    };
+
+    static void _dataHandler(int channel, uint8_t* data, int count, void* ctx) {
+        MultiChannelDecoder* _this = (MultiChannelDecoder*)ctx;
+        ChannelDecoder& dec = *_this->decoders[channel];
+        if (dec.pocsag) { dec.pocsag->process(data, count); }
+        if (dec.flex) { dec.flex->process(data, count); }
+    }
+
+    // Recreate the DSP and protocol decoders of all channels. Must be called from the UI thread
+    void rebuildChannels() {
+        double center = gui::waterfall.getCenterFrequency() + vfo->getOffset();
+        std::vector<MultiChannelDSP::Channel> dspChannels;
+        std::vector<std::unique_ptr<ChannelDecoder>> newDecoders;
+        for (const auto& c : channels) {
+            auto dec = std::make_unique<ChannelDecoder>();
+            double freq = c.frequency;
+            if (c.proto == PROTOCOL_FLEX) {
+                dec->flex = std::make_unique<flex::Decoder>();
+                dec->flex->onMessage.bind([this, freq](flex::Address addr, flex::MessageType type, const std::string& msg) {
+                    const char* typeStr = "UNK";
+                    switch (type) {
+                        case flex::MESSAGE_TYPE_ALPHANUMERIC: typeStr = "ALN"; break;
+                        case flex::MESSAGE_TYPE_STANDARD_NUMERIC: typeStr = "NUM"; break;
+                        case flex::MESSAGE_TYPE_TONE: typeStr = "TON"; break;
+                        case flex::MESSAGE_TYPE_BINARY: typeStr = "BIN"; break;
+                        default: break;
+                    }
+                    pushMessage(freq, addr, typeStr, msg);
+                });
+                dspChannels.push_back({ freq - center, MULTI_FLEX_BAUDRATE });
+            }
+            else {
+                dec->pocsag = std::make_unique<pocsag::Decoder>();
+                dec->pocsag->onMessage.bind([this, freq](pocsag::Address addr, pocsag::MessageType type, const std::string& msg) {
+                    pushMessage(freq, addr, (type == pocsag::MESSAGE_TYPE_ALPHANUMERIC) ? "ALN" : "NUM", msg);
+                });
+                dspChannels.push_back({ freq - center, MULTI_POCSAG_BAUDRATE });
+            }
+            newDecoders.push_back(std::move(dec));
+        }
+
+        // The DSP is stopped while swapping the decoders
+        if (running) { dsp.stop(); }
+        decoders = std::move(newDecoders);
+        dsp.setChannels(dspChannels);
+        if (running) { dsp.start(); }
+        lastCenter = center;
+    }
+
+    void saveChannels() {
+        config->acquire();
+        config->conf[name]["channels"] = json::array();
+        for (const auto& c : channels) {
+            json ch;
+            ch["frequency"] = c.frequency;
+            ch["protocol"] = protocols.key(protocols.valueId(c.proto));
+            config->conf[name]["channels"].push_back(ch);
+        }
+        config->release(true);
+    }
+
+    // Called from the DSP thread
+    void pushMessage(double frequency, uint64_t address, const char* type, const std::string& text) {
+        Message m;
+        time_t now = time(NULL);
+        strftime(m.time, sizeof(m.time), "%H:%M:%S", localtime(&now));
+        m.frequency = frequency;
+        m.address = address;
+        m.type = type;
+        m.text = text;
+        flog::debug("[{:.4f}MHz] [{}] {}: '{}'", frequency / 1e6, address, type, text);
+
+        std::lock_guard<std::mutex> lck(logMtx);
+        log.push_back(std::move(m));
+        if (log.size() > MULTI_MAX_LOG_SIZE) { log.pop_front(); }
+    }
+
+    struct ChannelDecoder {
+        std::unique_ptr<pocsag::Decoder> pocsag;
+        std::unique_ptr<flex::Decoder> flex;
+    };
+
+    std::string name;
+    VFOManager::VFO* vfo;
+    ConfigManager* config;
+
+    MultiChannelDSP dsp;
+    std::vector<Channel> channels;
+    std::vector<std::unique_ptr<ChannelDecoder>> decoders;
+    double lastCenter = NAN;
+    bool running = false;
+
+    std::mutex logMtx;
+    std::deque<Message> log;
+
+    double newFreq = 0.0;
+    int newProtoId = 0;
+
+    OptionList<std::string, Protocol> protocols;
+};
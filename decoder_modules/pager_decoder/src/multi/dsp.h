@@ -0,0 +1,269 @@
+#pragma once
+#include <dsp/channel/channelizer.h>
+#include <dsp/clock_recovery/mm.h>
+#include <dsp/digital/binary_slicer.h>
+#include <dsp/math/hz_to_rads.h>
+#include <mutex>
+#include "../decoder.h"
+
+// Demodulates many pager channels out of one wideband stream. The channelizer splits the band into channels of the
+// usual 12.5KHz raster, a rotator per channel removes what is left of its offset and the FM demodulator, symbol filter,
+// clock recovery and slicer of dsp::demod::FSK then run over all the channels of a block in one pass, their state
+// kept in arrays indexed by channel. Channels are gated by an energy detector like the single channel decoders, so
+// that idle channels cost little more than the channelizer itself. There is no pre-roll, the preambles are long
+// enough for the clock recovery and the sync detection to lock on what is left of them.
+class MultiChannelDSP : public dsp::channel::Channelizer {
+    using base_type = dsp::channel::Channelizer;
+public:
+    struct Channel {
+        double offset;
+        double baudrate;
+    };
+
+    MultiChannelDSP() {}
+
+    MultiChannelDSP(dsp::stream<dsp::complex_t>* in, double samplerate, int channels, void (*handler)(int channel, uint8_t* data, int count, void* ctx), void* ctx) { init(in, samplerate, channels, handler, ctx); }
+
+    ~MultiChannelDSP() {
+        if (!base_type::_block_init) { return; }
+        base_type::stop();
+        dsp::buffer::free(powerBuf);
+        dsp::buffer::free(diffBuf);
+        dsp::buffer::free(demodBuf);
+        dsp::buffer::free(softBuf);
+        dsp::buffer::free(bitBuf);
+    }
+
+    void init(dsp::stream<dsp::complex_t>* in, double samplerate, int channels, void (*handler)(int channel, uint8_t* data, int count, void* ctx), void* ctx) {
+        _handler = handler;
+        _ctx = ctx;
+        base_type::init(in, samplerate, channels);
+    }
+
+    // Replace the channels to demodulate, the offsets being relative to the center of the band
+    void setChannels(const std::vector<Channel>& channels) {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        base_type::tempStop();
+
+        // Unbind the previous channels
+        for (auto& s : chanStreams) { base_type::unbindOutput(s.get()); }
+        chanStreams.clear();
+        recov.clear();
+
+        // Reset the state of every channel
+        int n = channels.size();
+        double chanSr = base_type::getChannelSamplerate();
+        rotPhase.assign(n, lv_cmake(1.0f, 0.0f));
+        rotDelta.assign(n, lv_cmake(1.0f, 0.0f));
+        lastSample.assign(n, dsp::complex_t{ 1.0f, 0.0f });
+        noiseFloor.assign(n, 0.0f);
+        floorValid.assign(n, false);
+        open.assign(n, false);
+        hangLeft.assign(n, 0);
+        avgLen.resize(n);
+        avgPos.assign(n, 0);
+        for (int i = 0; i < n; i++) {
+            // The symbol filter averages over one symbol
+            avgLen[i] = std::max<int>(round(chanSr / channels[i].baudrate), 1);
+            recov.push_back(std::make_unique<dsp::clock_recovery::MM<float>>());
+            recov[i]->init(NULL, chanSr / channels[i].baudrate, 1e-4, 1.0, 0.05);
+            recov[i]->out.free();
+        }
+        avgStride = avgLen.empty() ? 0 : *std::max_element(avgLen.begin(), avgLen.end());
+        avgHist.assign(n * avgStride, 0.0f);
+        invDeviation = 1.0f / dsp::math::hzToRads(-4500.0, chanSr);
+        hang = PAGER_DETECTOR_HANG * chanSr;
+
+        // Bind a stream per channel, only used as the buffer the channelizer writes into
+        for (int i = 0; i < n; i++) {
+            chanStreams.push_back(std::make_unique<dsp::stream<dsp::complex_t>>(4096));
+            base_type::bindOutput(chanStreams[i].get(), -1);
+        }
+        for (int i = 0; i < n; i++) { tuneChannel(i, channels[i].offset); }
+
+        base_type::tempStart();
+    }
+
+    // Follow a change of the offset of a channel without interrupting the others
+    void setChannelOffset(int channel, double offset) {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        if (channel < 0 || channel >= chanStreams.size()) { return; }
+        tuneChannel(channel, offset);
+    }
+
+    // Whether an offset can be received, the edges of the band are left to the filter of the VFO
+    bool inBand(double offset) {
+        return fabs(offset) <= (_samplerate - base_type::getChannelSpacing()) / 2.0;
+    }
+
+    // Whether the energy detector of a channel is open, inaccurate but safe to call from any thread
+    bool isOpen(int channel) {
+        std::lock_guard<std::mutex> lck(tuneMtx);
+        return (channel >= 0 && channel < open.size()) ? open[channel] : false;
+    }
+
+    int run() {
+        int count = base_type::_in->read();
+        if (count < 0) { return -1; }
+
+        // Take a consistent view of the tuning for this block
+        bool any = false;
+        {
+            std::lock_guard<std::mutex> lck(tuneMtx);
+            for (int i = 0; i < base_type::outputs.size(); i++) {
+                base_type::channelSnapshot[i] = base_type::outputs[i]->channel;
+                any |= (base_type::channelSnapshot[i] >= 0);
+            }
+            rotDeltaSnapshot = rotDelta;
+        }
+
+        // Extract the channels, the streams are never swapped
+        int frames = 0;
+        if (any) {
+            frames = base_type::process(count, base_type::_in->readBuf);
+        }
+        else {
+            base_type::skip(count, base_type::_in->readBuf);
+        }
+        base_type::_in->flush();
+
+        if (frames) { demodulate(frames); }
+        return count;
+    }
+
+private:
+    void tuneChannel(int channel, double offset) {
+        std::lock_guard<std::mutex> lck(tuneMtx);
+        int ch = inBand(offset) ? base_type::channelFor(offset) : -1;
+        double residual = (ch >= 0) ? (offset - base_type::getChannelOffset(ch)) : 0.0;
+        float delta = dsp::math::hzToRads(-residual, base_type::getChannelSamplerate());
+        rotDelta[channel] = lv_cmake(cosf(delta), sinf(delta));
+        base_type::setOutputChannel(chanStreams[channel].get(), ch);
+    }
+
+    void growBuffers(int count) {
+        dsp::buffer::free(powerBuf);
+        dsp::buffer::free(diffBuf);
+        dsp::buffer::free(demodBuf);
+        dsp::buffer::free(softBuf);
+        dsp::buffer::free(bitBuf);
+        powerBuf = dsp::buffer::alloc<float>(count);
+        diffBuf = dsp::buffer::alloc<dsp::complex_t>(count);
+        demodBuf = dsp::buffer::alloc<float>(count);
+        softBuf = dsp::buffer::alloc<float>(count);
+        bitBuf = dsp::buffer::alloc<uint8_t>(count);
+        workCapacity = count;
+    }
+
+    void demodulate(int frames) {
+        if (frames > workCapacity) { growBuffers(frames); }
+
+        for (int c = 0; c < chanStreams.size(); c++) {
+            if (base_type::channelSnapshot[c] < 0) { continue; }
+            dsp::complex_t* in = chanStreams[c]->writeBuf;
+
+            // Remove the rest of the offset
+#if VOLK_VERSION >= 030100
+            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)in, (lv_32fc_t*)in, &rotDeltaSnapshot[c], &rotPhase[c], frames);
+#else
+            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)in, (lv_32fc_t*)in, rotDeltaSnapshot[c], &rotPhase[c], frames);
+#endif
+
+            // Energy detector, same rules as dsp::noise_reduction::EnergyDetector
+            float sum;
+            volk_32fc_magnitude_squared_32f(powerBuf, (lv_32fc_t*)in, frames);
+            volk_32f_accumulator_s32f(&sum, powerBuf, frames);
+            float level = 10.0f * log10f(std::max<float>(sum / (float)frames, 1e-20f));
+            if (!floorValid[c]) {
+                noiseFloor[c] = level;
+                floorValid[c] = true;
+            }
+            bool wasOpen = open[c];
+            bool isOpen = wasOpen;
+            if (!wasOpen) {
+                if (level - noiseFloor[c] >= PAGER_DETECTOR_OPEN_LEVEL) {
+                    isOpen = true;
+                    hangLeft[c] = hang;
+                }
+                else {
+                    noiseFloor[c] += ((level < noiseFloor[c]) ? 0.5f : 0.01f) * (level - noiseFloor[c]);
+                }
+            }
+            else if (level - noiseFloor[c] >= PAGER_DETECTOR_CLOSE_LEVEL) {
+                hangLeft[c] = hang;
+            }
+            else if ((hangLeft[c] -= frames) <= 0) {
+                isOpen = false;
+            }
+            if (isOpen != wasOpen) {
+                std::lock_guard<std::mutex> lck(tuneMtx);
+                open[c] = isOpen;
+            }
+            if (!isOpen) {
+                lastSample[c] = in[frames - 1];
+                continue;
+            }
+
+            // FM demodulation
+            diffBuf[0] = in[0] * lastSample[c].conj();
+            volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)&diffBuf[1], (lv_32fc_t*)&in[1], (lv_32fc_t*)in, frames - 1);
+            lastSample[c] = in[frames - 1];
+            volk_32fc_s32f_atan2_32f(demodBuf, (lv_32fc_t*)diffBuf, 1.0f / invDeviation, frames);
+
+            // Moving average over a symbol, the sum being recomputed from the history on each block so that it can't drift
+            int len = avgLen[c];
+            float* hist = &avgHist[c * avgStride];
+            int pos = avgPos[c];
+            float acc = 0.0f;
+            for (int i = 0; i < len; i++) { acc += hist[i]; }
+            float norm = 1.0f / (float)len;
+            for (int i = 0; i < frames; i++) {
+                float x = demodBuf[i];
+                acc += x - hist[pos];
+                hist[pos] = x;
+                if (++pos == len) { pos = 0; }
+                demodBuf[i] = acc * norm;
+            }
+            avgPos[c] = pos;
+
+            // Clock recovery and slicing
+            int count = recov[c]->process(frames, demodBuf, softBuf);
+            dsp::digital::BinarySlicer::process(count, softBuf, bitBuf);
+            if (count && _handler) { _handler(c, bitBuf, count, _ctx); }
+        }
+    }
+
+    void (*_handler)(int channel, uint8_t* data, int count, void* ctx) = NULL;
+    void* _ctx = NULL;
+
+    std::vector<std::unique_ptr<dsp::stream<dsp::complex_t>>> chanStreams;
+    std::mutex tuneMtx;
+
+    // Per channel state
+    std::vector<lv_32fc_t> rotPhase;
+    std::vector<lv_32fc_t> rotDelta;
+    std::vector<lv_32fc_t> rotDeltaSnapshot;
+    std::vector<dsp::complex_t> lastSample;
+    std::vector<float> noiseFloor;
+    std::vector<bool> floorValid;
+    std::vector<bool> open;
+    std::vector<int> hangLeft;
+    std::vector<int> avgLen;
+    std::vector<int> avgPos;
+    std::vector<float> avgHist;
+    int avgStride = 0;
+    std::vector<std::unique_ptr<dsp::clock_recovery::MM<float>>> recov;
+
+    float invDeviation = 1.0f;
+    int hang = 0;
+
+    // Work buffers shared by all channels
+    float* powerBuf = NULL;
+    dsp::complex_t* diffBuf = NULL;
+    float* demodBuf = NULL;
+    float* softBuf = NULL;
+    uint8_t* bitBuf = NULL;
+    int workCapacity = 0;
+};
@@ -5,7 +5,10 @@
 #include <gui/widgets/symbol_diagram.h>
 #include <gui/style.h>
 #include <dsp/sink/handler_sink.h>
-#include "dsp.h"
+#include <dsp/buffer/reshaper.h>
+#include <dsp/demod/fsk.h>
+#include <dsp/taps/from_array.h>
+#include <dsp/digital/packed_bits.h>
 #include "pocsag.h"
 
 #define BAUDRATE    2400
@@ -25,9 +28,14 @@ public:
         // Init DSP
         vfo->setBandwidthLimits(12500, 12500, true);
         vfo->setSampleRate(SAMPLERATE, 12500);
-        dsp.init(vfo->output, SAMPLERATE, BAUDRATE);
+        detector.init(vfo->output, PAGER_DETECTOR_OPEN_LEVEL, PAGER_DETECTOR_CLOSE_LEVEL, PAGER_DETECTOR_HANG * SAMPLERATE, PAGER_DETECTOR_PRE_ROLL * SAMPLERATE);
+        float shapeTaps[] = { 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f };
+        dsp::tap<float> shape = dsp::taps::fromArray<float>(10, shapeTaps);
+        dsp.init(&detector.out, BAUDRATE, SAMPLERATE, -4500.0, shape, 1e-4, 1.0, 0.05, true);
+        dsp::taps::free(shape);
         reshape.init(&dsp.soft, BAUDRATE, (BAUDRATE / 30.0) - BAUDRATE);
-        dataHandler.init(&dsp.out, _dataHandler, this);
+        packer.init(&dsp.out);
+        dataHandler.init(&packer.out, _dataHandler, this);
         diagHandler.init(&reshape.out, _diagHandler, this);
 
         // Init decoder
@@ -45,6 +53,16 @@ public:
             // TODO
         }
 
+        // The DSP only runs while the detector is open, unless it's turned off
+        if (ImGui::Checkbox(("Sleep when idle##pager_decoder_pocsag_sleep_" + name).c_str(), &sleepWhenIdle)) {
+            if (sleepWhenIdle) {
+                detector.setLevels(PAGER_DETECTOR_OPEN_LEVEL, PAGER_DETECTOR_CLOSE_LEVEL);
+            }
+            else {
+                detector.setLevels(-INFINITY, -INFINITY);
+            }
+        }
+
         ImGui::FillWidth();
         diag.draw();
     }
@@ -53,27 +71,31 @@ public:
         this->vfo = vfo;
         vfo->setBandwidthLimits(12500, 12500, true);
         vfo->setSampleRate(24000, 12500);
-        dsp.setInput(vfo->output);
+        detector.setInput(vfo->output);
     }
 
     void start() {
+        detector.start();
         dsp.start();
         reshape.start();
+        packer.start();
         dataHandler.start();
         diagHandler.start();
     }
 
     void stop() {
+        detector.stop();
         dsp.stop();
         reshape.stop();
+        packer.stop();
         dataHandler.stop();
         diagHandler.stop();
     }
 
 private:
-    static void _dataHandler(uint8_t* data, int count, void* ctx) {
+    static void _dataHandler(uint64_t* data, int count, void* ctx) {
         POCSAGDecoder* _this = (POCSAGDecoder*)ctx;
-        _this->decoder.process(data, count);
+        _this->decoder.processPacked(data, count);
     }
 
     static void _diagHandler(float* data, int count, void* ctx) {
@@ -90,9 +112,11 @@ private:
     std::string name;
     VFOManager::VFO* vfo;
 
-    POCSAGDSP dsp;
+    dsp::noise_reduction::EnergyDetector detector;
+    dsp::demod::FSK dsp;
     dsp::buffer::Reshaper<float> reshape;
-    dsp::sink::Handler<uint8_t> dataHandler;
+    dsp::digital::BitPacker packer;
+    dsp::sink::Handler<uint64_t> dataHandler;
     dsp::sink::Handler<float> diagHandler;
 
     pocsag::Decoder decoder;
@@ -100,6 +124,7 @@ private:
     ImGui::SymbolDiagram diag;
 
     int brId = 2;
+    bool sleepWhenIdle = true;
 
     OptionList<int, int> baudrates;
 };
\ No newline at end of file
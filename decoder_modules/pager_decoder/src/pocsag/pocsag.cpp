@@ -1,5 +1,6 @@
 #include "pocsag.h"
 #include <string.h>
+#include <algorithm>
 #include <utils/flog.h>
 
 #define POCSAG_FRAME_SYNC_CODEWORD  ((uint32_t)(0b01111100110100100001010111011000))
@@ -32,6 +33,7 @@ namespace pocsag {
     Decoder::Decoder() {
         // Zero out batch
         memset(batch, 0, sizeof(batch));
+        syncCorr.init(POCSAG_FRAME_SYNC_CODEWORD, 32, POCSAG_SYNC_DIST);
     }
 
     void Decoder::process(uint8_t* symbols, int count) {
@@ -67,13 +69,38 @@ namespace pocsag {
         }
     }
 
-    int Decoder::distance(uint32_t a, uint32_t b) {
-        uint32_t diff = a ^ b;
-        int dist = 0;
-        for (int i = 0; i < 32; i++) {
-            dist += (diff >> i ) & 1;
+    void Decoder::processPacked(const uint64_t* words, int count) {
+        int64_t bits = (int64_t)count * 64;
+        int64_t pos = 0;
+        while (pos < bits) {
+            // Search for the sync codeword, the batch starts right after it
+            if (!synced) {
+                int64_t found = syncCorr.find(words, count, pos + 1);
+                if (found < 0) { break; }
+                synced = true;
+                pos = found;
+                continue;
+            }
+
+            // Read up to the end of the current codeword
+            int n = (int)std::min<int64_t>(32 - (batchOffset & 0b11111), bits - pos);
+            batch[batchOffset >> 5] |= (uint32_t)(dsp::digital::readBits(words, pos, n) << (32 - (batchOffset & 0b11111) - n));
+            batchOffset += n;
+            pos += n;
+
+            // On end of batch, decode and reset
+            if (batchOffset >= POCSAG_BATCH_BIT_COUNT) {
+                decodeBatch();
+                batchOffset = 0;
+                synced = false;
+                memset(batch, 0, sizeof(batch));
+            }
         }
-        return dist;
+        syncCorr.next(words, count);
+    }
+
+    int Decoder::distance(uint32_t a, uint32_t b) {
+        return dsp::digital::popcount(a ^ b);
     }
 
     bool Decoder::correctCodeword(Codeword in, Codeword& out) {
@@ -2,6 +2,7 @@
 #include <string>
 #include <stdint.h>
 #include <utils/new_event.h>
+#include <dsp/digital/packed_bits.h>
 
 #define POCSAG_SYNC_DIST            4
 #define POCSAG_BATCH_CODEWORD_COUNT 16
@@ -27,6 +28,10 @@ namespace pocsag {
 
         void process(uint8_t* symbols, int count);
 
+        // Same as process() with a packed bit stream of count words, the sync codeword being searched a word at a
+        // time and the codewords of the batch read 32 bits at a time
+        void processPacked(const uint64_t* words, int count);
+
         NewEvent<Address, MessageType, const std::string&> onMessage;
 
     private:
@@ -37,6 +42,7 @@ namespace pocsag {
 
         uint32_t syncSR = 0;
         bool synced = false;
+        dsp::digital::SyncCorrelator syncCorr;
         int batchOffset = 0;
 
         Codeword batch[POCSAG_BATCH_CODEWORD_COUNT];
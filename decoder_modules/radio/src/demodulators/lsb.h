@@ -1,6 +1,7 @@
 #pragma once
 #include "../demod.h"
 #include <dsp/demod/ssb.h>
+#include <dsp/demod/weaver_ssb.h>
 
 namespace demod {
     class LSB : public Demodulator {
@@ -27,15 +28,29 @@ namespace demod {
             if (config->conf[name][getName()].contains("agcDecay")) {
                 agcDecay = config->conf[name][getName()]["agcDecay"];
             }
+            if (config->conf[name][getName()].contains("weaver")) {
+                weaver = config->conf[name][getName()]["weaver"];
+            }
             config->release();
 
             // Define structure
             demod.init(input, dsp::demod::SSB<dsp::stereo_t>::Mode::LSB, bandwidth, getIFSampleRate(), agcAttack / getIFSampleRate(), agcDecay / getIFSampleRate());
+            weaverDemod.init(input, dsp::demod::SSB<dsp::stereo_t>::Mode::LSB, bandwidth, getIFSampleRate(), agcAttack / getIFSampleRate(), agcDecay / getIFSampleRate());
         }
 
-        void start() { demod.start(); }
+        void start() {
+            if (weaver) {
+                weaverDemod.start();
+            }
+            else {
+                demod.start();
+            }
+        }
 
-        void stop() { demod.stop(); }
+        void stop() {
+            demod.stop();
+            weaverDemod.stop();
+        }
 
         void showMenu() {
             float menuWidth = ImGui::GetContentRegionAvail().x;
@@ -43,6 +58,7 @@ namespace demod {
             ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
             if (ImGui::SliderFloat(("##_radio_lsb_agc_attack_" + name).c_str(), &agcAttack, 1.0f, 200.0f)) {
                 demod.setAGCAttack(agcAttack / getIFSampleRate());
+                weaverDemod.setAGCAttack(agcAttack / getIFSampleRate());
                 _config->acquire();
                 _config->conf[name][getName()]["agcAttack"] = agcAttack;
                 _config->release(true);
@@ -51,15 +67,29 @@ namespace demod {
             ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
             if (ImGui::SliderFloat(("##_radio_lsb_agc_decay_" + name).c_str(), &agcDecay, 1.0f, 20.0f)) {
                 demod.setAGCDecay(agcDecay / getIFSampleRate());
+                weaverDemod.setAGCDecay(agcDecay / getIFSampleRate());
                 _config->acquire();
                 _config->conf[name][getName()]["agcDecay"] = agcDecay;
                 _config->release(true);
             }
+
+            // Filter the sideband at a low intermediate rate instead of the VFO, the radio restarts the demodulator on change
+            if (ImGui::Checkbox(("Weaver Filtering##_radio_lsb_weaver_" + name).c_str(), &weaver)) {
+                _config->acquire();
+                _config->conf[name][getName()]["weaver"] = weaver;
+                _config->release(true);
+            }
         }
 
-        void setBandwidth(double bandwidth) { demod.setBandwidth(bandwidth); }
+        void setBandwidth(double bandwidth) {
+            demod.setBandwidth(bandwidth);
+            weaverDemod.setBandwidth(bandwidth);
+        }
 
-        void setInput(dsp::stream<dsp::complex_t>* input) { demod.setInput(input); }
+        void setInput(dsp::stream<dsp::complex_t>* input) {
+            demod.setInput(input);
+            weaverDemod.setInput(input);
+        }
 
         void AFSampRateChanged(double newSR) {}
 
@@ -79,15 +109,18 @@ namespace demod {
         int getDefaultDeemphasisMode() { return DEEMP_MODE_NONE; }
         bool getFMIFNRAllowed() { return false; }
         bool getNBAllowed() { return true; }
-        dsp::stream<dsp::stereo_t>* getOutput() { return &demod.out; }
+        bool getVFOFilterNeeded() { return !weaver; }
+        dsp::stream<dsp::stereo_t>* getOutput() { return weaver ? &weaverDemod.out : &demod.out; }
 
     private:
         dsp::demod::SSB<dsp::stereo_t> demod;
+        dsp::demod::WeaverSSB<dsp::stereo_t> weaverDemod;
 
         ConfigManager* _config;
 
         float agcAttack = 50.0f;
         float agcDecay = 5.0f;
+        bool weaver = false;
 
         std::string name;
     };
@@ -59,6 +59,7 @@ namespace demod {
         int getDefaultDeemphasisMode() { return DEEMP_MODE_NONE; }
         bool getFMIFNRAllowed() { return false; }
         bool getNBAllowed() { return true; }
+        bool getVFOFilterNeeded() { return true; }
         dsp::stream<dsp::stereo_t>* getOutput() { return &c2s.out; }
 
     private:
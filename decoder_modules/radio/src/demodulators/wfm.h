@@ -89,6 +89,7 @@ namespace demod {
             hs.start();
             reshape.start();
             diagHandler.start();
+            running = true;
         }
 
         void stop() {
@@ -97,6 +98,7 @@ namespace demod {
             hs.stop();
             reshape.stop();
             diagHandler.stop();
+            running = false;
         }
 
         void showMenu() {
@@ -270,6 +272,7 @@ namespace demod {
         int getDefaultDeemphasisMode() { return DEEMP_MODE_50US; }
         bool getFMIFNRAllowed() { return true; }
         bool getNBAllowed() { return false; }
+        bool getVFOFilterNeeded() { return true; }
         dsp::stream<dsp::stereo_t>* getOutput() { return &demod.out; }
 
         // ============= DEDICATED FUNCTIONS =============
@@ -299,7 +302,9 @@ namespace demod {
 
         static void fftRedraw(ImGui::WaterFall::FFTRedrawArgs args, void* ctx) {
             WFM* _this = (WFM*)ctx;
-            if (!_this->_rds) { return; }
+
+            // The demodulator may be kept stopped while another mode is selected
+            if (!_this->_rds || !_this->running) { return; }
 
             // Generate string depending on RDS mode
             char buf[256];
@@ -341,6 +346,7 @@ namespace demod {
         RDSDemod rdsDemod;
         dsp::sink::Handler<uint8_t> hs;
         EventHandler<ImGui::WaterFall::FFTRedrawArgs> fftRedrawHandler;
+        bool running = false;
 
         dsp::buffer::Reshaper<float> reshape;
         dsp::sink::Handler<float> diagHandler;
@@ -9,6 +9,9 @@ enum {
     RADIO_IFACE_CMD_SET_SQUELCH_ENABLED,
     RADIO_IFACE_CMD_GET_SQUELCH_LEVEL,
     RADIO_IFACE_CMD_SET_SQUELCH_LEVEL,
+    RADIO_IFACE_CMD_GET_SQUELCH_OPEN,
+    RADIO_IFACE_CMD_BIND_SQUELCH_HANDLER,
+    RADIO_IFACE_CMD_UNBIND_SQUELCH_HANDLER,
 };
 
 enum {
@@ -14,6 +14,7 @@
 #include <core.h>
 #include <stdint.h>
 #include <utils/optionlist.h>
+#include <memory>
 #include "radio_interface.h"
 #include "demod.h"
 
@@ -64,6 +65,7 @@ public:
         onUserChangedBandwidthHandler.handler = vfoUserChangedBandwidthHandler;
         onUserChangedBandwidthHandler.ctx = this;
         vfo->wtfVFO->onUserChangedBandwidth.bindHandler(&onUserChangedBandwidthHandler);
+        vfo->setActive(false);
 
         // Initialize IF DSP chain
         ifChainOutputChanged.ctx = this;
@@ -73,6 +75,7 @@ public:
         nb.init(NULL, 500.0 / 24000.0, 10.0);
         fmnr.init(NULL, 32);
         squelch.init(NULL, MIN_SQUELCH);
+        squelch.setStateHandler(squelchStateHandler, this);
 
         ifChain.addBlock(&nb, false);
         ifChain.addBlock(&squelch, false);
@@ -91,6 +94,9 @@ public:
         srChangeHandler.ctx = this;
         srChangeHandler.handler = sampleRateChangeHandler;
         stream.init(afChain.out, &srChangeHandler, audioSampleRate);
+        consumedChangeHandler.ctx = this;
+        consumedChangeHandler.handler = streamConsumedChangeHandler;
+        stream.onConsumedChange.bindHandler(&consumedChangeHandler);
         sigpath::sinkManager.registerStream(name, &stream);
 
         // Select the demodulator
@@ -129,6 +135,7 @@ public:
         if (!vfo) {
             vfo = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, 200000, 200000, 50000, 200000, false);
             vfo->wtfVFO->onUserChangedBandwidth.bindHandler(&onUserChangedBandwidthHandler);
+            vfo->setActive(stream.isConsumed());
         }
         ifChain.setInput(vfo->output, [=](dsp::stream<dsp::complex_t>* out){ ifChainOutputChangeHandler(out, this); });
         ifChain.start();
@@ -279,6 +286,11 @@ private:
         // Demodulator specific menu
         _this->selectedDemod->showMenu();
 
+        // Switching to or from filtering the IF in the demodulator changes its output, it must be selected again
+        if (_this->selectedDemod->getVFOFilterNeeded() != _this->vfoFilterNeeded) {
+            _this->selectDemod(_this->selectedDemod);
+        }
+
         if (!_this->enabled) { style::endDisabled(); }
     }
 
@@ -318,9 +330,17 @@ private:
         return demod;
     }
 
+    // Demodulators are only created the first time their mode is selected, they're then kept stopped while another
+    // one is in use so that switching back to them doesn't have to regenerate their taps and buffers
+    demod::Demodulator* getDemod(DemodID id) {
+        if (id < 0 || id >= _RADIO_DEMOD_COUNT) { return NULL; }
+        if (!demods[id]) { demods[id].reset(instantiateDemod(id)); }
+        return demods[id].get();
+    }
+
     void selectDemodByID(DemodID id) {
         auto startTime = std::chrono::high_resolution_clock::now();
-        demod::Demodulator* demod = instantiateDemod(id);
+        demod::Demodulator* demod = getDemod(id);
         if (!demod) {
             flog::error("Demodulator {0} not implemented", (int)id);
             return;
@@ -337,12 +357,9 @@ private:
     }
 
     void selectDemod(demod::Demodulator* demod) {
-        // Stopcurrently selected demodulator and select new
+        // Stop currently selected demodulator and select new, the old one stays in the pool
         afChain.setInput(&dummyAudioStream, [=](dsp::stream<dsp::stereo_t>* out){ stream.setInput(out); });
-        if (selectedDemod) {
-            selectedDemod->stop();
-            delete selectedDemod;
-        }
+        if (selectedDemod) { selectedDemod->stop(); }
         selectedDemod = demod;
 
         // Give the demodulator the most recent audio SR
@@ -420,6 +437,8 @@ private:
             vfo->setSnapInterval(snapInterval);
             vfo->setSampleRate(ifSamplerate, bandwidth);
         }
+        vfoFilterNeeded = selectedDemod->getVFOFilterNeeded();
+        if (vfo) { vfo->setFilterEnabled(vfoFilterNeeded); }
 
         // Configure bandwidth
         setBandwidth(bandwidth);
@@ -534,6 +553,12 @@ private:
         if (!selectedDemod) { return; }
         ifChain.setBlockEnabled(&squelch, squelchEnabled, [=](dsp::stream<dsp::complex_t>* out){ selectedDemod->setInput(out); });
 
+        // A disabled squelch is always open
+        {
+            std::lock_guard<std::mutex> lck(squelchEventMtx);
+            onSquelchChanged.emit(!squelchEnabled || squelch.isOpen());
+        }
+
         // Save config
         config.acquire();
         config.conf[name][selectedDemod->getName()]["squelchEnabled"] = squelchEnabled;
@@ -589,6 +614,12 @@ private:
         _this->setAudioSampleRate(sampleRate);
     }
 
+    // Nothing downstream of the VFO runs while the audio isn't used, the blocks waiting for it to output again
+    static void streamConsumedChangeHandler(bool consumed, void* ctx) {
+        RadioModule* _this = (RadioModule*)ctx;
+        if (_this->vfo) { _this->vfo->setActive(consumed); }
+    }
+
     static void ifChainOutputChangeHandler(dsp::stream<dsp::complex_t>* output, void* ctx) {
         RadioModule* _this = (RadioModule*)ctx;
         if (!_this->selectedDemod) { return; }
@@ -598,6 +629,18 @@ private:
     static void moduleInterfaceHandler(int code, void* in, void* out, void* ctx) {
         RadioModule* _this = (RadioModule*)ctx;
 
+        // Squelch state handlers can be bound at any time, the handler's ctx must stay valid until unbound
+        if (code == RADIO_IFACE_CMD_BIND_SQUELCH_HANDLER && in) {
+            std::lock_guard<std::mutex> lck(_this->squelchEventMtx);
+            _this->onSquelchChanged.bindHandler((EventHandler<bool>*)in);
+            return;
+        }
+        else if (code == RADIO_IFACE_CMD_UNBIND_SQUELCH_HANDLER && in) {
+            std::lock_guard<std::mutex> lck(_this->squelchEventMtx);
+            _this->onSquelchChanged.unbindHandler((EventHandler<bool>*)in);
+            return;
+        }
+
         // If no demod is selected, reject the command
         if (!_this->selectedDemod) { return; }
 
@@ -635,6 +678,10 @@ private:
             float* _in = (float*)in;
             _this->setSquelchLevel(*_in);
         }
+        else if (code == RADIO_IFACE_CMD_GET_SQUELCH_OPEN && out) {
+            bool* _out = (bool*)out;
+            *_out = !_this->squelchEnabled || _this->squelch.isOpen();
+        }
         else {
             return;
         }
@@ -643,9 +690,16 @@ private:
         return;
     }
 
+    static void squelchStateHandler(bool open, void* ctx) {
+        RadioModule* _this = (RadioModule*)ctx;
+        std::lock_guard<std::mutex> lck(_this->squelchEventMtx);
+        _this->onSquelchChanged.emit(open);
+    }
+
     // Handlers
     EventHandler<double> onUserChangedBandwidthHandler;
     EventHandler<float> srChangeHandler;
+    EventHandler<bool> consumedChangeHandler;
     EventHandler<dsp::stream<dsp::complex_t>*> ifChainOutputChanged;
     EventHandler<dsp::stream<dsp::stereo_t>*> afChainOutputChanged;
 
@@ -656,6 +710,8 @@ private:
     dsp::noise_reduction::NoiseBlanker nb;
     dsp::noise_reduction::FMIF fmnr;
     dsp::noise_reduction::Squelch squelch;
+    Event<bool> onSquelchChanged;
+    std::mutex squelchEventMtx;
 
     // Audio chain
     dsp::stream<dsp::stereo_t> dummyAudioStream;
@@ -665,6 +721,7 @@ private:
 
     SinkManager::Stream stream;
 
+    std::unique_ptr<demod::Demodulator> demods[_RADIO_DEMOD_COUNT];
     demod::Demodulator* selectedDemod = NULL;
 
     OptionList<std::string, DeemphasisMode> deempModes;
@@ -678,6 +735,7 @@ private:
     int snapInterval;
     int selectedDemodID = 1;
     bool postProcEnabled;
+    bool vfoFilterNeeded = true;
 
     bool squelchEnabled = false;
     float squelchLevel;
@@ -375,6 +375,7 @@ namespace rds {
     void Decoder::decodeGroup() {
         // Make sure blocks B is available
         if (!blockAvail[BLOCK_TYPE_B]) { return; }
+        groupCount++;
 
         // Decode block B
         decodeBlockB();
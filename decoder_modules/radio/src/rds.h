@@ -236,6 +236,9 @@ namespace rds {
         bool programTypeNameValid() { std::lock_guard<std::mutex> lck(group10Mtx); return group10Valid(); }
         std::string getProgramTypeName() { std::lock_guard<std::mutex> lck(group10Mtx); return programTypeName; }
 
+        // Complete groups decoded so far, to be read from the thread calling process()
+        uint64_t getGroupCount() { return groupCount; }
+
     private:
         static uint16_t calcSyndrome(uint32_t block);
         static uint32_t correctErrors(uint32_t block, BlockType type, bool& recovered);
@@ -263,6 +266,7 @@ namespace rds {
         int contGroup = 0;
         uint32_t blocks[_BLOCK_TYPE_COUNT];
         bool blockAvail[_BLOCK_TYPE_COUNT];
+        uint64_t groupCount = 0;
 
         // Block A (All groups)
         std::mutex blockAMtx;
@@ -14,7 +14,12 @@ class RDSDemod : public dsp::Processor<dsp::complex_t, uint8_t> {
 public:
     RDSDemod() {}
     RDSDemod(dsp::stream<dsp::complex_t>* in, bool enableSoft) { init(in, enableSoft); }
-    ~RDSDemod() {}
+    ~RDSDemod() {
+        if (!base_type::_block_init) { return; }
+        base_type::stop();
+        dsp::buffer::free(work);
+        dsp::buffer::free(bits);
+    }
 
     void init(dsp::stream<dsp::complex_t>* in, bool enableSoft) {
         // Save config
@@ -30,11 +35,13 @@ public:
         recov.init(NULL, 5000.0 / (2375.0 / 2.0), 1e-6, 0.01, 0.01);
         diff.init(NULL, 2);
 
-        // Free useless buffers
+        // Free useless buffers, the stages work in place from a buffer grown as needed
         agc.out.free();
+        costas.out.free();
         fir.out.free();
         costas2.out.free();
         recov.out.free();
+        diff.out.free();
 
         // Init the rest
         base_type::init(in);
@@ -62,14 +69,15 @@ public:
     }
 
     inline int process(int count, dsp::complex_t* in, float* softOut, uint8_t* hardOut) {
-        count = agc.process(count, in, costas.out.readBuf);
-        count = costas.process(count, costas.out.readBuf, costas.out.writeBuf);
-        count = fir.process(count, costas.out.writeBuf, costas.out.writeBuf);
-        count = costas2.process(count, costas.out.writeBuf, costas.out.readBuf);
-        count = dsp::convert::ComplexToReal::process(count, costas.out.readBuf, softOut);
+        if (count > workCapacity) { growBuffers(count); }
+        count = agc.process(count, in, work);
+        count = costas.process(count, work, work);
+        count = fir.process(count, work, work);
+        count = costas2.process(count, work, work);
+        count = dsp::convert::ComplexToReal::process(count, work, softOut);
         count = recov.process(count, softOut, softOut);
-        count = dsp::digital::BinarySlicer::process(count, softOut, diff.out.readBuf);
-        count = diff.process(count, diff.out.readBuf, hardOut);
+        count = dsp::digital::BinarySlicer::process(count, softOut, bits);
+        count = diff.process(count, bits, hardOut);
         return count;
     }
 
@@ -90,6 +98,14 @@ public:
     dsp::stream<float> soft;
 
 private:
+    void growBuffers(int count) {
+        dsp::buffer::free(work);
+        dsp::buffer::free(bits);
+        work = dsp::buffer::alloc<dsp::complex_t>(count);
+        bits = dsp::buffer::alloc<uint8_t>(count);
+        workCapacity = count;
+    }
+
     bool enableSoft = false;
     
     dsp::loop::FastAGC<dsp::complex_t> agc;
@@ -99,4 +115,8 @@ private:
     dsp::loop::Costas<2> costas2;
     dsp::clock_recovery::MM<float> recov;
     dsp::digital::DifferentialDecoder diff;
+
+    dsp::complex_t* work = NULL;
+    uint8_t* bits = NULL;
+    int workCapacity = 0;
 };
\ No newline at end of file
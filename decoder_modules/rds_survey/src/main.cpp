@@ -0,0 +1,219 @@
+#include <imgui.h>
+#include <config.h>
+#include <core.h>
+#include <gui/style.h>
+#include <gui/gui.h>
+#include <signal_path/signal_path.h>
+#include <module.h>
+#include <utils/optionlist.h>
+#include "survey_dsp.h"
+
+#define CONCAT(a, b) ((std::string(a) + b).c_str())
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "rds_survey",
+    /* Description:     */ "RDS decoder for all the stations of a band"
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ -1
+};
+
+ConfigManager config;
+
+enum RDSRegion {
+    RDS_REGION_EUROPE,
+    RDS_REGION_NORTH_AMERICA
+};
+
+class RDSSurveyModule : public ModuleManager::Instance {
+public:
+    RDSSurveyModule(std::string name) {
+        this->name = name;
+
+        // Define the widths of band, the number of stations on the raster must be a power of two
+        bands.define("1.6MHz", "1.6 MHz", 1.6e6);
+        bands.define("3.2MHz", "3.2 MHz", 3.2e6);
+        bands.define("6.4MHz", "6.4 MHz", 6.4e6);
+        bands.define("12.8MHz", "12.8 MHz", 12.8e6);
+
+        // Define RDS regions
+        regions.define("eu", "Europe", RDS_REGION_EUROPE);
+        regions.define("na", "North America", RDS_REGION_NORTH_AMERICA);
+
+        // Load config
+        bandId = bands.valueId(3.2e6);
+        config.acquire();
+        if (config.conf[name].contains("band")) {
+            std::string key = config.conf[name]["band"];
+            if (bands.keyExists(key)) { bandId = bands.keyId(key); }
+        }
+        if (config.conf[name].contains("region")) {
+            std::string key = config.conf[name]["region"];
+            if (regions.keyExists(key)) { regionId = regions.keyId(key); }
+        }
+        config.release();
+        samplerate = bands.value(bandId);
+
+        // Initialize the DSP
+        vfo = createVFO();
+        dsp.init(vfo->output, samplerate);
+        dsp.start();
+
+        gui::menu.registerEntry(name, menuHandler, this, this);
+    }
+
+    ~RDSSurveyModule() {
+        gui::menu.removeEntry(name);
+        if (enabled) {
+            dsp.stop();
+            sigpath::vfoManager.deleteVFO(vfo);
+        }
+    }
+
+    void postInit() {}
+
+    void enable() {
+        vfo = createVFO();
+        dsp.setInput(vfo->output);
+        dsp.resetStations();
+        dsp.start();
+        lastCenter = NAN;
+        enabled = true;
+    }
+
+    void disable() {
+        dsp.stop();
+        sigpath::vfoManager.deleteVFO(vfo);
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+private:
+    VFOManager::VFO* createVFO() {
+        // The VFO is snapped to the raster so that the stations fall at the center of the channels
+        double bw = gui::waterfall.getBandwidth();
+        double vfoBw = samplerate - (2.0 * SURVEY_CHANNEL_SPACING);
+        VFOManager::VFO* v = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, std::clamp<double>(0, -bw / 2.0, bw / 2.0), vfoBw, samplerate, vfoBw, vfoBw, true);
+        v->setSnapInterval(SURVEY_CHANNEL_SPACING);
+        return v;
+    }
+
+    static void menuHandler(void* ctx) {
+        RDSSurveyModule* _this = (RDSSurveyModule*)ctx;
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        if (!_this->enabled) { style::beginDisabled(); }
+
+        ImGui::LeftLabel("Band");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##rds_survey_band_", _this->name), &_this->bandId, _this->bands.txt)) {
+            _this->samplerate = _this->bands.value(_this->bandId);
+            double vfoBw = _this->samplerate - (2.0 * SURVEY_CHANNEL_SPACING);
+            _this->vfo->setBandwidthLimits(vfoBw, vfoBw, true);
+            _this->vfo->setSampleRate(_this->samplerate, vfoBw);
+            _this->dsp.setSamplerate(_this->samplerate);
+            config.acquire();
+            config.conf[_this->name]["band"] = _this->bands.key(_this->bandId);
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("Region");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##rds_survey_region_", _this->name), &_this->regionId, _this->regions.txt)) {
+            config.acquire();
+            config.conf[_this->name]["region"] = _this->regions.key(_this->regionId);
+            config.release(true);
+        }
+
+        // The decoded data is lost when the band is retuned
+        double center = gui::waterfall.getCenterFrequency() + _this->vfo->getOffset();
+        if (_this->enabled && center != _this->lastCenter) {
+            if (!isnan(_this->lastCenter)) { _this->dsp.resetStations(); }
+            _this->lastCenter = center;
+        }
+        if (ImGui::Button(CONCAT("Clear##rds_survey_clear_", _this->name), ImVec2(menuWidth, 0))) {
+            _this->dsp.resetStations();
+        }
+
+        if (_this->enabled) { _this->drawStations(center); }
+
+        if (!_this->enabled) { style::endDisabled(); }
+    }
+
+    void drawStations(double center) {
+        bool na = (regions.value(regionId) == RDS_REGION_NORTH_AMERICA);
+        if (!ImGui::BeginTable(CONCAT("##rds_survey_stations_", name), 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 300.0f * style::uiScale))) { return; }
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Frequency");
+        ImGui::TableSetupColumn("PI");
+        ImGui::TableSetupColumn("PS");
+        ImGui::TableSetupColumn("Type");
+        ImGui::TableSetupColumn("Radio Text");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < dsp.getStationCount(); i++) {
+            // Only list the stations that have recently sent their PI code and name, noise alone can produce a PI code
+            rds::Decoder& dec = dsp.getDecoder(i);
+            if (!dec.piCodeValid() || !dec.PSNameValid()) { continue; }
+
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%.1lf", (center + dsp.getStationOffset(i)) / 1e6);
+            ImGui::TableSetColumnIndex(1);
+            if (na) {
+                ImGui::Text("0x%04X (%s)", dec.getPICode(), dec.getCallsign().c_str());
+            }
+            else {
+                ImGui::Text("0x%04X", dec.getPICode());
+            }
+            ImGui::TableSetColumnIndex(2);
+            ImGui::TextUnformatted(dec.getPSName().c_str());
+            ImGui::TableSetColumnIndex(3);
+            if (dec.programTypeValid()) {
+                ImGui::TextUnformatted(na ? rds::PROGRAM_TYPE_US_TO_STR[dec.getProgramType()] : rds::PROGRAM_TYPE_EU_TO_STR[dec.getProgramType()]);
+            }
+            else {
+                ImGui::TextUnformatted("---");
+            }
+            ImGui::TableSetColumnIndex(4);
+            ImGui::TextUnformatted(dec.radioTextValid() ? dec.getRadioText().c_str() : "");
+        }
+        ImGui::EndTable();
+    }
+
+    std::string name;
+    bool enabled = true;
+
+    OptionList<std::string, double> bands;
+    int bandId = 0;
+    double samplerate;
+    OptionList<std::string, RDSRegion> regions;
+    int regionId = 0;
+    double lastCenter = NAN;
+
+    // DSP Chain
+    VFOManager::VFO* vfo;
+    SurveyDSP dsp;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    config.setPath(core::args["root"].s() + "/rds_survey_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new RDSSurveyModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
+    delete (RDSSurveyModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
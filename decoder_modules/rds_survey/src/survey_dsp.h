@@ -0,0 +1,175 @@
+#pragma once
+#include <dsp/channel/channelizer.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/convert/real_to_complex.h>
+#include <dsp/channel/frequency_xlator.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <rds_demod.h>
+#include <rds.h>
+#include <memory>
+
+// Stations are on a 100KHz raster, the channelizer outputs them at twice that
+#define SURVEY_CHANNEL_SPACING  100000.0
+#define SURVEY_DEVIATION        75000.0
+#define SURVEY_RDS_SAMPLERATE   5000.0
+
+// Decodes the RDS of every station of a wideband stream. The channelizer extracts the stations on the raster and for
+// each of them only what the RDS needs is run: FM demodulation, translation of the 57KHz subcarrier to 0Hz and
+// decimation down to the samplerate of the RDS demodulator, without any stereo decoding or audio processing.
+class SurveyDSP : public dsp::channel::Channelizer {
+    using base_type = dsp::channel::Channelizer;
+public:
+    SurveyDSP() {}
+
+    SurveyDSP(dsp::stream<dsp::complex_t>* in, double samplerate) { init(in, samplerate); }
+
+    ~SurveyDSP() {
+        if (!base_type::_block_init) { return; }
+        base_type::stop();
+        for (auto& s : stations) { base_type::unbindOutput(&s->channel); }
+        dsp::buffer::free(mpxBuf);
+        dsp::buffer::free(subBuf);
+        dsp::buffer::free(rdsBuf);
+        dsp::buffer::free(softBuf);
+        dsp::buffer::free(bitBuf);
+    }
+
+    void init(dsp::stream<dsp::complex_t>* in, double samplerate) {
+        rtoc.init(NULL);
+        rtoc.out.free();
+        base_type::init(in, samplerate, std::max<int>(round(samplerate / SURVEY_CHANNEL_SPACING), 1));
+        createStations();
+    }
+
+    // Change the width of the surveyed band, the samplerate divided by the channel spacing must be a power of two
+    void setSamplerate(double samplerate) {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        base_type::tempStop();
+        base_type::setSamplerate(samplerate);
+        base_type::setChannels(std::max<int>(round(samplerate / SURVEY_CHANNEL_SPACING), 1));
+        createStations();
+        base_type::tempStart();
+    }
+
+    // Forget everything decoded so far, to be called when the band is retuned
+    void resetStations() {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        base_type::tempStop();
+        createStations();
+        base_type::tempStart();
+    }
+
+    int getStationCount() { return stations.size(); }
+
+    // Offset of a station from the center of the band
+    double getStationOffset(int station) { return stations[station]->offset; }
+
+    rds::Decoder& getDecoder(int station) { return stations[station]->decoder; }
+
+    int run() {
+        int count = base_type::_in->read();
+        if (count < 0) { return -1; }
+
+        // Extract the stations, the streams are never swapped
+        for (int i = 0; i < base_type::outputs.size(); i++) {
+            base_type::channelSnapshot[i] = base_type::outputs[i]->channel;
+        }
+        int frames = base_type::process(count, base_type::_in->readBuf);
+        base_type::_in->flush();
+
+        if (frames) { decode(frames); }
+        return count;
+    }
+
+private:
+    struct Station {
+        double offset;
+        dsp::stream<dsp::complex_t> channel{ 4096 };
+        dsp::demod::Quadrature demod;
+        dsp::channel::FrequencyXlator xlator;
+        dsp::multirate::RationalResampler<dsp::complex_t> resamp;
+        RDSDemod rdsDemod;
+        rds::Decoder decoder;
+    };
+
+    // Must be called with the block stopped
+    void createStations() {
+        for (auto& s : stations) { base_type::unbindOutput(&s->channel); }
+        stations.clear();
+
+        // The edges of the band are left to the filter of the VFO, a station needing about 100KHz on each side
+        double chanSr = base_type::getChannelSamplerate();
+        double maxOffset = (_samplerate / 2.0) - (2.0 * SURVEY_CHANNEL_SPACING);
+        for (int i = 0; i < base_type::getChannels(); i++) {
+            double offset = base_type::getChannelOffset(i);
+            if (fabs(offset) > maxOffset) { continue; }
+
+            auto s = std::make_unique<Station>();
+            s->offset = offset;
+            s->demod.init(NULL, SURVEY_DEVIATION, chanSr);
+            s->xlator.init(NULL, -57000.0, chanSr);
+            s->resamp.init(NULL, chanSr, SURVEY_RDS_SAMPLERATE);
+            s->rdsDemod.init(NULL, false);
+
+            // Only the process functions are used, none of the streams are needed
+            s->demod.out.free();
+            s->xlator.out.free();
+            s->resamp.out.free();
+            s->rdsDemod.out.free();
+            s->rdsDemod.soft.free();
+
+            base_type::bindOutput(&s->channel, i);
+            stations.push_back(std::move(s));
+        }
+
+        // Sort by frequency for display
+        std::sort(stations.begin(), stations.end(), [](const std::unique_ptr<Station>& a, const std::unique_ptr<Station>& b) {
+            return a->offset < b->offset;
+        });
+    }
+
+    void growBuffers(int count) {
+        dsp::buffer::free(mpxBuf);
+        dsp::buffer::free(subBuf);
+        dsp::buffer::free(rdsBuf);
+        dsp::buffer::free(softBuf);
+        dsp::buffer::free(bitBuf);
+        mpxBuf = dsp::buffer::alloc<float>(count);
+        subBuf = dsp::buffer::alloc<dsp::complex_t>(count);
+
+        // The RDS samplerate is far lower than the one of the channels
+        rdsBuf = dsp::buffer::alloc<dsp::complex_t>(count);
+        softBuf = dsp::buffer::alloc<float>(count);
+        bitBuf = dsp::buffer::alloc<uint8_t>(count);
+        workCapacity = count;
+    }
+
+    void decode(int frames) {
+        if (frames > workCapacity) { growBuffers(frames); }
+
+        for (auto& s : stations) {
+            // Demodulate and bring the subcarrier to 0Hz
+            s->demod.process(frames, s->channel.writeBuf, mpxBuf);
+            rtoc.process(frames, mpxBuf, subBuf);
+            s->xlator.process(frames, subBuf, subBuf);
+
+            // Decimate to the RDS samplerate and decode
+            int count = s->resamp.process(frames, subBuf, rdsBuf);
+            count = s->rdsDemod.process(count, rdsBuf, softBuf, bitBuf);
+            if (count) { s->decoder.process(bitBuf, count); }
+        }
+    }
+
+    dsp::convert::RealToComplex rtoc;
+    std::vector<std::unique_ptr<Station>> stations;
+
+    // Work buffers shared by all stations
+    float* mpxBuf = NULL;
+    dsp::complex_t* subBuf = NULL;
+    dsp::complex_t* rdsBuf = NULL;
+    float* softBuf = NULL;
+    uint8_t* bitBuf = NULL;
+    int workCapacity = 0;
+};
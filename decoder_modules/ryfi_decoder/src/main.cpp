@@ -105,9 +105,7 @@ private:
     static void symSinkHandler(dsp::complex_t* data, int count, void* ctx) {
         RyFiDecoderModule* _this = (RyFiDecoderModule*)ctx;
 
-        dsp::complex_t* buf = _this->constDiagram.acquireBuffer();
-        memcpy(buf, data, 1024 * sizeof(dsp::complex_t));
-        _this->constDiagram.releaseBuffer();
+        _this->constDiagram.push(data, count);
     }
 
     std::string name;
@@ -31,8 +31,8 @@ namespace ryfi {
     }
 
     ConvDecoder::ConvDecoder(dsp::stream<dsp::complex_t>* in) {
-        // Create the convolutional encoder instance
-        conv = correct_convolutional_create(2, 7, correct_conv_r12_7_polynomial);
+        // Initialize the viterbi decoder
+        viterbi.init(7, correct_conv_r12_7_polynomial);
 
         // Allocate the soft symbol buffer
         soft = dsp::buffer::alloc<uint8_t>(STREAM_BUFFER_SIZE);
@@ -42,9 +42,6 @@ namespace ryfi {
     }
 
     ConvDecoder::~ConvDecoder() {
-        // Destroy the convolutional encoder instance
-        correct_convolutional_destroy(conv);
-
         // Free the soft symbol buffer
         dsp::buffer::free(soft);
     }
@@ -58,7 +55,7 @@ namespace ryfi {
         }
         
         // Run convolutional decoder on the data
-        return correct_convolutional_decode_soft(conv, soft, count, out);
+        return viterbi.decode(soft, count, out);
     }
 
     int ConvDecoder::run() {
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "dsp/processor.h"
+#include "dsp/digital/viterbi_decoder.h"
 
 extern "C" {
     #include "correct.h"
@@ -65,7 +66,7 @@ namespace ryfi {
     private:
         int run();
 
-        correct_convolutional* conv;
+        dsp::digital::ViterbiDecoder viterbi;
         uint8_t* soft = NULL;
     };
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "dsp/processor.h"
+#include "dsp/digital/reed_solomon_decoder.h"
 
 extern "C" {
     #include "correct.h"
@@ -77,6 +78,6 @@ namespace ryfi {
     private:
         int run();
 
-        correct_reed_solomon* rs;
+        dsp::digital::ReedSolomonDecoder rs;
     };
 }
\ No newline at end of file
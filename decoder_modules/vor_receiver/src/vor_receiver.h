@@ -4,14 +4,20 @@
 #include <dsp/demod/quadrature.h>
 #include <dsp/convert/real_to_complex.h>
 #include <dsp/channel/frequency_xlator.h>
-#include <dsp/filter/fir.h>
-#include <dsp/math/delay.h>
+#include <dsp/filter/decimating_fir.h>
 #include <dsp/math/conjugate.h>
 #include <dsp/channel/rx_vfo.h>
-#include "vor_fm_filter.h"
+#include <dsp/taps/low_pass.h>
 #include <utils/wav.h>
 
-#define VOR_IN_SR   25e3
+#define VOR_IN_SR           25e3
+
+// The FM subcarrier only spans +/-480Hz around 9960Hz once mixed down and the AM reference a few tens of Hz, so both
+// are decimated to this samplerate before anything else is done with them
+#define VOR_DECIM           10
+#define VOR_DECIM_SR        (VOR_IN_SR / VOR_DECIM)
+#define VOR_DECIM_CUTOFF    800.0
+#define VOR_DECIM_TRANS     800.0
 
 namespace vor {
     class Receiver : public dsp::Processor<dsp::complex_t, float> {
@@ -24,20 +30,28 @@ namespace vor {
         ~Receiver() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            dsp::taps::free(fmfTaps);
+            dsp::taps::free(decimTaps);
         }
 
         void init(dsp::stream<dsp::complex_t>* in) {
             amd.init(NULL, dsp::demod::AM<float>::CARRIER, VOR_IN_SR, 50.0f / VOR_IN_SR, 5.0f / VOR_IN_SR, 100.0f / VOR_IN_SR, VOR_IN_SR);
             amr2c.init(NULL);
             fmr2c.init(NULL);
+            scr2c.init(NULL);
             fmx.init(NULL, -9960, VOR_IN_SR);
-            fmfTaps = dsp::taps::fromArray(FM_TAPS_COUNT, fm_taps);
-            fmf.init(NULL, fmfTaps);
-            fmd.init(NULL, 600, VOR_IN_SR);
-            amde.init(NULL, FM_TAPS_COUNT / 2);
-            amv.init(NULL, VOR_IN_SR, 1000, 30, 30);
-            fmv.init(NULL, VOR_IN_SR, 1000, 30, 30);
+
+            // Both paths go through the same decimation filter so that they stay aligned without any delay line
+            decimTaps = dsp::taps::lowPass(VOR_DECIM_CUTOFF, VOR_DECIM_TRANS, VOR_IN_SR);
+            amf.init(NULL, decimTaps, VOR_DECIM);
+            fmf.init(NULL, decimTaps, VOR_DECIM);
+            fmd.init(NULL, 600, VOR_DECIM_SR);
+            amv.init(NULL, VOR_DECIM_SR, 1000, 30, 30);
+            fmv.init(NULL, VOR_DECIM_SR, 1000, 30, 30);
+
+            // The quadrature demodulator delays the FM path by half a sample, which at the decimated samplerate is no
+            // longer negligible at 30Hz. It's taken back out of the phase difference, relative to the input samplerate
+            float corr = FL_M_PI * 30.0f * ((1.0f / VOR_IN_SR) - (1.0f / VOR_DECIM_SR));
+            phaseCorr = { cosf(corr), sinf(corr) };
 
             base_type::init(in);
         }
@@ -45,22 +59,23 @@ namespace vor {
         int process(dsp::complex_t* in, float* out, int count) {
             // Demodulate the AM outer modulation
             volk_32fc_magnitude_32f(amd.out.writeBuf, (lv_32fc_t*)in, count);
-            amr2c.process(count, amd.out.writeBuf, amr2c.out.writeBuf);
 
-            // Isolate the FM subcarrier
-            fmx.process(count, amr2c.out.writeBuf, fmx.out.writeBuf);
-            fmf.process(count, fmx.out.writeBuf, fmx.out.writeBuf);
+            // Mix the FM subcarrier down to baseband and decimate it
+            scr2c.process(count, amd.out.writeBuf, scr2c.out.writeBuf);
+            fmx.process(count, scr2c.out.writeBuf, fmx.out.writeBuf);
+            int dcount = fmf.process(count, fmx.out.writeBuf, fmf.out.writeBuf);
 
-            // Demodulate the FM subcarrier
-            fmd.process(count, fmx.out.writeBuf, fmd.out.writeBuf);
-            fmr2c.process(count, fmd.out.writeBuf, fmr2c.out.writeBuf);
+            // Decimate the AM signal the same way, only its 30Hz component is of use
+            amf.process(count, amd.out.writeBuf, amf.out.writeBuf);
+            amr2c.process(dcount, amf.out.writeBuf, amr2c.out.writeBuf);
 
-            // Delay the AM signal by the same amount as the FM one
-            amde.process(count, amr2c.out.writeBuf, amr2c.out.writeBuf);
+            // Demodulate the FM subcarrier
+            fmd.process(dcount, fmf.out.writeBuf, fmd.out.writeBuf);
+            fmr2c.process(dcount, fmd.out.writeBuf, fmr2c.out.writeBuf);
 
             // Isolate the 30Hz component on both the AM and FM channels
-            int rcount = amv.process(count, amr2c.out.writeBuf, amv.out.writeBuf);
-            fmv.process(count, fmr2c.out.writeBuf, fmv.out.writeBuf);
+            int rcount = amv.process(dcount, amr2c.out.writeBuf, amv.out.writeBuf);
+            fmv.process(dcount, fmr2c.out.writeBuf, fmv.out.writeBuf);
 
             // If no data was returned, we're done for this round
             if (!rcount) { return 0; }
@@ -70,6 +85,7 @@ namespace vor {
 
             // Multiply both together
             volk_32fc_x2_multiply_32fc((lv_32fc_t*)amv.out.writeBuf, (lv_32fc_t*)amv.out.writeBuf, (lv_32fc_t*)fmv.out.writeBuf, rcount);
+            volk_32fc_s32fc_multiply_32fc((lv_32fc_t*)amv.out.writeBuf, (lv_32fc_t*)amv.out.writeBuf, *((lv_32fc_t*)&phaseCorr), rcount);
             
             // Compute angle
             volk_32fc_s32f_atan2_32f(out, (lv_32fc_t*)amv.out.writeBuf, 1.0f, rcount);
@@ -95,12 +111,14 @@ namespace vor {
         dsp::demod::AM<float> amd;
         dsp::convert::RealToComplex amr2c;
         dsp::convert::RealToComplex fmr2c;
+        dsp::convert::RealToComplex scr2c;
         dsp::channel::FrequencyXlator fmx;
-        dsp::tap<float> fmfTaps;
-        dsp::filter::FIR<dsp::complex_t, float> fmf;
+        dsp::tap<float> decimTaps;
+        dsp::filter::DecimatingFIR<float, float> amf;
+        dsp::filter::DecimatingFIR<dsp::complex_t, float> fmf;
         dsp::demod::Quadrature fmd;
-        dsp::math::Delay<dsp::complex_t> amde;
         dsp::channel::RxVFO amv;
         dsp::channel::RxVFO fmv;
+        dsp::complex_t phaseCorr;
     };
 }
\ No newline at end of file
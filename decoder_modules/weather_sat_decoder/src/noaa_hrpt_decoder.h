@@ -9,6 +9,12 @@
 #include <gui/widgets/line_push_image.h>
 #include <gui/gui.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define NOAA_HRPT_VFO_SR 3000000.0f
 #define NOAA_HRPT_VFO_BW 2000000.0f
 
@@ -287,6 +293,53 @@ public:
     };
 
 private:
+    // Scale 10 bit AVHRR samples to 8 bit and interleave them into the RGBA pixels of an image line. v * 255 / 1024 is
+    // computed as the high half of v * 16320, which gives the same result as the float division with 16 bit lanes
+    static void avhrrToRGBA(const uint16_t* r, const uint16_t* g, const uint16_t* b, uint8_t* out, int count) {
+        int i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i mask = _mm_set1_epi16(0x3FF);
+        const __m128i scale = _mm_set1_epi16(16320);
+        const __m128i alpha = _mm_set1_epi8((char)0xFF);
+        for (; i + 16 <= count; i += 16) {
+            __m128i r8 = _mm_packus_epi16(_mm_mulhi_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i*)&r[i]), mask), scale),
+                                          _mm_mulhi_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i*)&r[i + 8]), mask), scale));
+            __m128i g8 = _mm_packus_epi16(_mm_mulhi_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i*)&g[i]), mask), scale),
+                                          _mm_mulhi_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i*)&g[i + 8]), mask), scale));
+            __m128i b8 = _mm_packus_epi16(_mm_mulhi_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i*)&b[i]), mask), scale),
+                                          _mm_mulhi_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i*)&b[i + 8]), mask), scale));
+            __m128i rgLo = _mm_unpacklo_epi8(r8, g8);
+            __m128i rgHi = _mm_unpackhi_epi8(r8, g8);
+            __m128i baLo = _mm_unpacklo_epi8(b8, alpha);
+            __m128i baHi = _mm_unpackhi_epi8(b8, alpha);
+            _mm_storeu_si128((__m128i*)&out[i * 4], _mm_unpacklo_epi16(rgLo, baLo));
+            _mm_storeu_si128((__m128i*)&out[i * 4 + 16], _mm_unpackhi_epi16(rgLo, baLo));
+            _mm_storeu_si128((__m128i*)&out[i * 4 + 32], _mm_unpacklo_epi16(rgHi, baHi));
+            _mm_storeu_si128((__m128i*)&out[i * 4 + 48], _mm_unpackhi_epi16(rgHi, baHi));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const uint16x8_t mask = vdupq_n_u16(0x3FF);
+        for (; i + 8 <= count; i += 8) {
+            uint8x8x4_t px;
+            const uint16_t* src[3] = { &r[i], &g[i], &b[i] };
+            for (int c = 0; c < 3; c++) {
+                uint16x8_t v = vandq_u16(vld1q_u16(src[c]), mask);
+                uint16x4_t lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(v), 255), 10);
+                uint16x4_t hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(v), 255), 10);
+                px.val[c] = vmovn_u16(vcombine_u16(lo, hi));
+            }
+            px.val[3] = vdup_n_u8(255);
+            vst4_u8(&out[i * 4], px);
+        }
+#endif
+        for (; i < count; i++) {
+            out[(i * 4)] = ((r[i] & 0x3FF) * 255) >> 10;
+            out[(i * 4) + 1] = ((g[i] & 0x3FF) * 255) >> 10;
+            out[(i * 4) + 2] = ((b[i] & 0x3FF) * 255) >> 10;
+            out[(i * 4) + 3] = 255;
+        }
+    }
+
     // AVHRR Data Handlers
     void avhrrCompositeWorker() {
         compositeIn1.flush();
@@ -296,15 +349,7 @@ private:
             if (compositeIn2.read() < 0) { return; }
 
             uint8_t* buf = avhrrRGBImage.acquireNextLine();
-            float rg, b;
-            for (int i = 0; i < 2048; i++) {
-                b = ((float)compositeIn1.readBuf[i] * 255.0f) / 1024.0f;
-                rg = ((float)compositeIn2.readBuf[i] * 255.0f) / 1024.0f;
-                buf[(i * 4)] = rg;
-                buf[(i * 4) + 1] = rg;
-                buf[(i * 4) + 2] = b;
-                buf[(i * 4) + 3] = 255;
-            }
+            avhrrToRGBA(compositeIn2.readBuf, compositeIn2.readBuf, compositeIn1.readBuf, buf, 2048);
             avhrrRGBImage.releaseNextLine();
 
             compositeIn1.flush();
@@ -315,14 +360,7 @@ private:
     static void avhrr1Handler(uint16_t* data, int count, void* ctx) {
         NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
         uint8_t* buf = _this->avhrr1Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
+        avhrrToRGBA(data, data, data, buf, 2048);
         _this->avhrr1Image.releaseNextLine();
 
         memcpy(_this->compositeIn1.writeBuf, data, count * sizeof(uint16_t));
@@ -332,14 +370,7 @@ private:
     static void avhrr2Handler(uint16_t* data, int count, void* ctx) {
         NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
         uint8_t* buf = _this->avhrr2Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
+        avhrrToRGBA(data, data, data, buf, 2048);
         _this->avhrr2Image.releaseNextLine();
 
         memcpy(_this->compositeIn2.writeBuf, data, count * sizeof(uint16_t));
@@ -349,42 +380,21 @@ private:
     static void avhrr3Handler(uint16_t* data, int count, void* ctx) {
         NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
         uint8_t* buf = _this->avhrr3Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
+        avhrrToRGBA(data, data, data, buf, 2048);
         _this->avhrr3Image.releaseNextLine();
     }
 
     static void avhrr4Handler(uint16_t* data, int count, void* ctx) {
         NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
         uint8_t* buf = _this->avhrr4Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
+        avhrrToRGBA(data, data, data, buf, 2048);
         _this->avhrr4Image.releaseNextLine();
     }
 
     static void avhrr5Handler(uint16_t* data, int count, void* ctx) {
         NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
         uint8_t* buf = _this->avhrr5Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
+        avhrrToRGBA(data, data, data, buf, 2048);
         _this->avhrr5Image.releaseNextLine();
     }
 
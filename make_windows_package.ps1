@@ -36,6 +36,7 @@ cp $build_dir/source_modules/limesdr_source/Release/limesdr_source.dll sdrpp_win
 cp 'C:/Program Files/PothosSDR/bin/LimeSuite.dll' sdrpp_windows_x64/
 
 cp $build_dir/source_modules/network_source/Release/network_source.dll sdrpp_windows_x64/modules/
+cp $build_dir/source_modules/aggregate_source/Release/aggregate_source.dll sdrpp_windows_x64/modules/
 
 cp $build_dir/source_modules/perseus_source/Release/perseus_source.dll sdrpp_windows_x64/modules/
 cp 'C:/Program Files/PothosSDR/bin/perseus-sdr.dll' sdrpp_windows_x64/
@@ -97,6 +98,8 @@ cp $build_dir/misc_modules/rigctl_server/Release/rigctl_server.dll sdrpp_windows
 
 cp $build_dir/misc_modules/scanner/Release/scanner.dll sdrpp_windows_x64/modules/
 
+cp $build_dir/misc_modules/spectrum_logger/Release/spectrum_logger.dll sdrpp_windows_x64/modules/
+
 
 # Copy supporting libs
 cp 'C:/Program Files/PothosSDR/bin/libusb-1.0.dll' sdrpp_windows_x64/
@@ -0,0 +1,317 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <config.h>
+#include <utils/flog.h>
+
+// Version of the list files, bumped whenever the layout changes
+#define BOOKMARK_STORE_VERSION  1
+
+struct FrequencyBookmark {
+    double frequency;
+    double bandwidth;
+    int mode;
+};
+
+// Bookmarks of a list by name
+typedef std::map<std::string, FrequencyBookmark> BookmarkMap;
+
+// Lists are kept out of the module config, each in a file of its own. The file holds a header followed by the
+// frequencies, bandwidths, modes, name lengths and names of all bookmarks as consecutive columns in native byte order,
+// so that loading a list is a handful of reads instead of parsing its JSON
+namespace bookmark_store {
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        uint32_t namesSize;
+        uint32_t byteOrder;     // 0x01020304 as written by the host that saved the file
+    };
+
+    inline void fillHeader(FileHeader& hdr, uint32_t count, uint32_t namesSize) {
+        memcpy(hdr.magic, "SDRPPBKM", 8);
+        hdr.version = BOOKMARK_STORE_VERSION;
+        hdr.count = count;
+        hdr.namesSize = namesSize;
+        hdr.byteOrder = 0x01020304;
+    }
+
+    // Load a list, a missing file being an empty list. The sizes in the header are checked against the size of the
+    // file before anything is allocated from them
+    inline bool load(const std::string& path, BookmarkMap& bookmarks) {
+        bookmarks.clear();
+        if (!std::filesystem::exists(path)) { return true; }
+
+        std::error_code ec;
+        uint64_t fileSize = std::filesystem::file_size(path, ec);
+        std::ifstream file(path, std::ios::binary);
+        FileHeader hdr, ref;
+        fillHeader(ref, 0, 0);
+        file.read((char*)&hdr, sizeof(FileHeader));
+        if (ec || !file || memcmp(hdr.magic, ref.magic, 8) || hdr.version != ref.version || hdr.byteOrder != ref.byteOrder) {
+            flog::error("Bookmark list '{0}' is invalid or was written by another version", path);
+            return false;
+        }
+        uint64_t recordSize = sizeof(double) + sizeof(double) + sizeof(int32_t) + sizeof(uint32_t);
+        if (sizeof(FileHeader) + ((uint64_t)hdr.count * recordSize) + hdr.namesSize > fileSize) {
+            flog::error("Bookmark list '{0}' is truncated", path);
+            return false;
+        }
+
+        std::vector<double> frequencies(hdr.count);
+        std::vector<double> bandwidths(hdr.count);
+        std::vector<int32_t> modes(hdr.count);
+        std::vector<uint32_t> nameLengths(hdr.count);
+        std::string names(hdr.namesSize, '\0');
+        file.read((char*)frequencies.data(), hdr.count * sizeof(double));
+        file.read((char*)bandwidths.data(), hdr.count * sizeof(double));
+        file.read((char*)modes.data(), hdr.count * sizeof(int32_t));
+        file.read((char*)nameLengths.data(), hdr.count * sizeof(uint32_t));
+        file.read(names.data(), hdr.namesSize);
+        if (!file) {
+            flog::error("Bookmark list '{0}' is truncated", path);
+            return false;
+        }
+
+        // Names were written in the order of the map, so every insertion goes at the end
+        size_t offset = 0;
+        for (uint32_t i = 0; i < hdr.count; i++) {
+            if (offset + nameLengths[i] > names.size()) {
+                flog::error("Bookmark list '{0}' is corrupted", path);
+                bookmarks.clear();
+                return false;
+            }
+            FrequencyBookmark bm;
+            bm.frequency = frequencies[i];
+            bm.bandwidth = bandwidths[i];
+            bm.mode = modes[i];
+            bookmarks.emplace_hint(bookmarks.end(), names.substr(offset, nameLengths[i]), bm);
+            offset += nameLengths[i];
+        }
+        return true;
+    }
+
+    // Save a list to a temporary file renamed over the previous one, so that a crash can't leave it truncated
+    inline bool save(const std::string& path, const BookmarkMap& bookmarks) {
+        std::vector<double> frequencies;
+        std::vector<double> bandwidths;
+        std::vector<int32_t> modes;
+        std::vector<uint32_t> nameLengths;
+        std::string names;
+        frequencies.reserve(bookmarks.size());
+        bandwidths.reserve(bookmarks.size());
+        modes.reserve(bookmarks.size());
+        nameLengths.reserve(bookmarks.size());
+        for (auto const& [name, bm] : bookmarks) {
+            frequencies.push_back(bm.frequency);
+            bandwidths.push_back(bm.bandwidth);
+            modes.push_back(bm.mode);
+            nameLengths.push_back(name.size());
+            names += name;
+        }
+
+        FileHeader hdr;
+        fillHeader(hdr, bookmarks.size(), names.size());
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+        std::string tmpPath = path + ".tmp";
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write((char*)&hdr, sizeof(FileHeader));
+        file.write((char*)frequencies.data(), frequencies.size() * sizeof(double));
+        file.write((char*)bandwidths.data(), bandwidths.size() * sizeof(double));
+        file.write((char*)modes.data(), modes.size() * sizeof(int32_t));
+        file.write((char*)nameLengths.data(), nameLengths.size() * sizeof(uint32_t));
+        file.write(names.data(), names.size());
+        file.close();
+        if (file.fail()) {
+            flog::error("Could not write bookmark list '{0}'", tmpPath);
+            return false;
+        }
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            flog::error("Could not replace bookmark list '{0}': {1}", path, ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    // Receives the bookmarks of an imported file one at a time, returns false to stop the import
+    typedef std::function<bool(const std::string& name, const FrequencyBookmark& bm)> ImportHandler;
+
+    // Streams the "bookmarks" object of an exported list without building the document, so that importing a large
+    // channel plan doesn't hold it in memory twice
+    class JSONImporter : public nlohmann::json_sax<json> {
+    public:
+        JSONImporter(ImportHandler handler, int defaultMode) : handler(handler), defaultMode(defaultMode) {}
+
+        bool null() { return true; }
+        bool boolean(bool val) { return true; }
+        bool number_integer(number_integer_t val) { return number((double)val); }
+        bool number_unsigned(number_unsigned_t val) { return number((double)val); }
+        bool number_float(number_float_t val, const string_t& s) { return number(val); }
+        bool string(string_t& val) { return true; }
+        bool binary(binary_t& val) { return true; }
+
+        bool start_object(std::size_t elements) {
+            depth++;
+            if (depth == 2 && key_ == "bookmarks") {
+                inBookmarks = true;
+                foundBookmarks = true;
+            }
+            if (depth == 3 && inBookmarks) {
+                name = key_;
+                bm.frequency = 0.0;
+                bm.bandwidth = 0.0;
+                bm.mode = defaultMode;
+                hasFrequency = false;
+            }
+            key_.clear();
+            return true;
+        }
+
+        bool key(string_t& val) {
+            key_ = val;
+            return true;
+        }
+
+        bool end_object() {
+            bool keepGoing = true;
+            if (depth == 3 && inBookmarks) {
+                if (hasFrequency) { keepGoing = handler(name, bm); }
+                else { flog::warn("Bookmark '{0}' has no frequency, skipping", name); }
+            }
+            if (depth == 2) { inBookmarks = false; }
+            depth--;
+            key_.clear();
+            return keepGoing;
+        }
+
+        bool start_array(std::size_t elements) {
+            depth++;
+            key_.clear();
+            return true;
+        }
+
+        bool end_array() {
+            depth--;
+            key_.clear();
+            return true;
+        }
+
+        bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) {
+            error = ex.what();
+            return false;
+        }
+
+        bool foundBookmarks = false;
+        std::string error;
+
+    private:
+        bool number(double val) {
+            if (depth != 3 || !inBookmarks) { return true; }
+            if (key_ == "frequency") {
+                bm.frequency = val;
+                hasFrequency = true;
+            }
+            else if (key_ == "bandwidth") { bm.bandwidth = val; }
+            else if (key_ == "mode") { bm.mode = (int)val; }
+            return true;
+        }
+
+        ImportHandler handler;
+        int defaultMode;
+
+        int depth = 0;
+        bool inBookmarks = false;
+        std::string key_;
+        std::string name;
+        FrequencyBookmark bm;
+        bool hasFrequency = false;
+    };
+
+    // Split a CSV line, fields may be quoted with doubled quotes inside
+    inline std::vector<std::string> splitCSV(const std::string& line) {
+        std::vector<std::string> fields;
+        std::string field;
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') { field += '"'; i++; }
+                else if (c == '"') { quoted = false; }
+                else { field += c; }
+            }
+            else if (c == '"') { quoted = true; }
+            else if (c == ',') { fields.push_back(field); field.clear(); }
+            else if (c != '\r') { field += c; }
+        }
+        fields.push_back(field);
+        return fields;
+    }
+
+    // Import a file, either exported by the frequency manager as JSON or a channel plan as CSV with one
+    // "name,frequency,bandwidth,mode" line per channel, frequencies and bandwidths in Hz and the mode given by name or
+    // index. CSV files are read line by line, lines that don't start with a name and a frequency such as headers are
+    // skipped. Returns the number of bookmarks given to the handler, -1 on error
+    inline int importFile(const std::string& path, const std::vector<std::string>& modeNames, int defaultMode, ImportHandler handler) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            flog::error("Could not open '{0}'", path);
+            return -1;
+        }
+
+        int count = 0;
+        auto countingHandler = [&count, &handler](const std::string& name, const FrequencyBookmark& bm) {
+            count++;
+            return handler(name, bm);
+        };
+
+        // Anything starting with an object is taken as JSON
+        char first = 0;
+        while (file.get(first) && isspace((unsigned char)first)) {}
+        file.seekg(0);
+        if (first == '{') {
+            JSONImporter importer(countingHandler, defaultMode);
+            json::sax_parse(file, &importer);
+            if (!importer.error.empty()) {
+                flog::error("Could not parse '{0}': {1}", path, importer.error);
+                return -1;
+            }
+            if (!importer.foundBookmarks) {
+                flog::error("File does not contains any bookmarks");
+                return -1;
+            }
+            return count;
+        }
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') { continue; }
+            std::vector<std::string> fields = splitCSV(line);
+            if (fields.size() < 2 || fields[0].empty()) { continue; }
+
+            char* end;
+            FrequencyBookmark bm;
+            bm.frequency = strtod(fields[1].c_str(), &end);
+            if (end == fields[1].c_str()) { continue; }
+            bm.bandwidth = (fields.size() > 2) ? strtod(fields[2].c_str(), NULL) : 0.0;
+            bm.mode = defaultMode;
+            if (fields.size() > 3 && !fields[3].empty()) {
+                auto it = std::find(modeNames.begin(), modeNames.end(), fields[3]);
+                if (it != modeNames.end()) { bm.mode = std::distance(modeNames.begin(), it); }
+                else if (isdigit((unsigned char)fields[3][0])) { bm.mode = atoi(fields[3].c_str()); }
+            }
+            if (!countingHandler(fields[0], bm)) { break; }
+        }
+        return count;
+    }
+}
@@ -13,6 +13,9 @@
 #include <utils/freq_formatting.h>
 #include <gui/dialogs/dialog_box.h>
 #include <fstream>
+#include <algorithm>
+#include <set>
+#include "bookmark_store.h"
 
 SDRPP_MOD_INFO{
     /* Name:            */ "frequency_manager",
@@ -22,19 +25,13 @@ SDRPP_MOD_INFO{
     /* Max instances    */ 1
 };
 
-struct FrequencyBookmark {
-    double frequency;
-    double bandwidth;
-    int mode;
-    bool selected;
-};
-
 struct WaterfallBookmark {
     std::string listName;
     std::string bookmarkName;
     FrequencyBookmark bookmark;
 };
 
+
 ConfigManager config;
 
 const char* demodModeList[] = {
@@ -50,6 +47,37 @@ const char* demodModeList[] = {
 
 const char* demodModeListTxt = "NFM\0WFM\0AM\0DSB\0USB\0CW\0LSB\0RAW\0";
 
+#define DEMOD_MODE_COUNT    8
+#define DEMOD_MODE_RAW      7
+
+// Directory holding the bookmarks of every list, a file each
+std::string listDir;
+
+// Unused file name for a new list. The config must be locked
+std::string newListFile(json& lists) {
+    std::set<std::string> used;
+    for (auto [_name, list] : lists.items()) {
+        if (list.contains("file")) { used.insert((std::string)list["file"]); }
+    }
+    for (int i = 0;; i++) {
+        std::string file = "list_" + std::to_string(i) + ".bin";
+        if (used.find(file) == used.end() && !std::filesystem::exists(listDir + "/" + file)) { return file; }
+    }
+}
+
+// Bookmarks of a list as stored in the config before lists had files of their own
+void loadJSONList(json& list, BookmarkMap& bookmarks) {
+    bookmarks.clear();
+    if (!list.contains("bookmarks")) { return; }
+    for (auto [bmName, bm] : list["bookmarks"].items()) {
+        FrequencyBookmark fbm;
+        fbm.frequency = bm["frequency"];
+        fbm.bandwidth = bm["bandwidth"];
+        fbm.mode = bm["mode"];
+        bookmarks[bmName] = fbm;
+    }
+}
+
 enum {
     BOOKMARK_DISP_MODE_OFF,
     BOOKMARK_DISP_MODE_TOP,
@@ -174,9 +202,10 @@ private:
             if (ImGui::Button("Apply")) {
                 open = false;
 
-                // If editing, delete the original one
+                // If editing, delete the original one, keeping it selected under its new name
                 if (editOpen) {
                     bookmarks.erase(firstEditedBookmarkName);
+                    if (selectedBookmarks.erase(firstEditedBookmarkName)) { selectedBookmarks.insert(editedBookmarkName); }
                 }
                 bookmarks[editedBookmarkName] = editedBookmark;
 
@@ -219,12 +248,19 @@ private:
 
                 config.acquire();
                 if (renameListOpen) {
+                    // The file of the list keeps its name, only the config entry and the cached bookmarks move
                     config.conf["lists"][editedListName] = config.conf["lists"][firstEditedListName];
                     config.conf["lists"].erase(firstEditedListName);
+                    auto it = listCache.find(firstEditedListName);
+                    if (it != listCache.end()) {
+                        listCache[editedListName].swap(it->second);
+                        listCache.erase(firstEditedListName);
+                    }
+                    if (selectedListName == firstEditedListName) { selectedListName = editedListName; }
                 }
                 else {
                     config.conf["lists"][editedListName]["showOnWaterfall"] = true;
-                    config.conf["lists"][editedListName]["bookmarks"] = json::object();
+                    config.conf["lists"][editedListName]["file"] = newListFile(config.conf["lists"]);
                 }
                 refreshWaterfallBookmarks(false);
                 config.release(true);
@@ -291,16 +327,59 @@ private:
             if (!((bool)list["showOnWaterfall"])) { continue; }
             WaterfallBookmark wbm;
             wbm.listName = listName;
-            for (auto [bookmarkName, bm] : config.conf["lists"][listName]["bookmarks"].items()) {
+            for (auto const& [bookmarkName, bm] : getList(listName, list["file"])) {
                 wbm.bookmarkName = bookmarkName;
-                wbm.bookmark.frequency = config.conf["lists"][listName]["bookmarks"][bookmarkName]["frequency"];
-                wbm.bookmark.bandwidth = config.conf["lists"][listName]["bookmarks"][bookmarkName]["bandwidth"];
-                wbm.bookmark.mode = config.conf["lists"][listName]["bookmarks"][bookmarkName]["mode"];
-                wbm.bookmark.selected = false;
+                wbm.bookmark = bm;
                 waterfallBookmarks.push_back(wbm);
             }
         }
         if (lockConfig) { config.release(); }
+
+        // Sort by frequency so that the waterfall only has to look at the bookmarks near the visible span
+        std::stable_sort(waterfallBookmarks.begin(), waterfallBookmarks.end(), [](const WaterfallBookmark& a, const WaterfallBookmark& b) {
+            return a.bookmark.frequency < b.bookmark.frequency;
+        });
+        labelWidthValid = false;
+    }
+
+    // Bookmarks of the waterfall whose label may be visible between two frequencies, as a range of waterfallBookmarks
+    void findVisibleBookmarks(double lowFreq, double highFreq, double freqToPixelRatio, int& first, int& last) {
+        // The widest label gives how far outside of the span a bookmark can be and still have its label visible.
+        // It's measured on the first redraw after a change since it needs the font
+        if (!labelWidthValid) {
+            maxLabelWidth = 0.0f;
+            for (auto const& bm : waterfallBookmarks) {
+                maxLabelWidth = std::max<float>(maxLabelWidth, ImGui::CalcTextSize(bm.bookmarkName.c_str()).x);
+            }
+            labelWidthValid = true;
+        }
+        if (freqToPixelRatio <= 0.0) {
+            first = 0;
+            last = waterfallBookmarks.size();
+            return;
+        }
+        double margin = ((maxLabelWidth / 2.0) + 5.0) / freqToPixelRatio;
+        auto begin = std::lower_bound(waterfallBookmarks.begin(), waterfallBookmarks.end(), lowFreq - margin, [](const WaterfallBookmark& bm, double freq) {
+            return bm.bookmark.frequency < freq;
+        });
+        auto end = std::upper_bound(begin, waterfallBookmarks.end(), highFreq + margin, [](double freq, const WaterfallBookmark& bm) {
+            return freq < bm.bookmark.frequency;
+        });
+        first = std::distance(waterfallBookmarks.begin(), begin);
+        last = std::distance(waterfallBookmarks.begin(), end);
+    }
+
+    // Rows of the bookmark table, rebuilt every time the bookmarks change
+    void refreshBookmarkRows() {
+        bookmarkRows.clear();
+        bookmarkRows.reserve(bookmarks.size());
+        for (auto it = bookmarks.begin(); it != bookmarks.end(); it++) { bookmarkRows.push_back(it); }
+
+        // Forget the selection of bookmarks that no longer exist
+        for (auto it = selectedBookmarks.begin(); it != selectedBookmarks.end();) {
+            if (bookmarks.find(*it) == bookmarks.end()) { it = selectedBookmarks.erase(it); }
+            else { it++; }
+        }
     }
 
     void loadFirst() {
@@ -312,8 +391,27 @@ private:
         selectedListId = 0;
     }
 
+    // Bookmarks of a list, read from its file the first time they're needed and then kept for the next switch.
+    // A file that can't be read falls back to the copy of the list still in the config, if any.
+    // The selected list is moved out of the cache into bookmarks. The config must be locked
+    BookmarkMap& getList(const std::string& listName, const std::string& file) {
+        if (listName == selectedListName) { return bookmarks; }
+        auto it = listCache.find(listName);
+        if (it != listCache.end()) { return it->second; }
+        BookmarkMap& list = listCache[listName];
+        if (!bookmark_store::load(listDir + "/" + file, list)) {
+            loadJSONList(config.conf["lists"][listName], list);
+        }
+        return list;
+    }
+
     void loadByName(std::string listName) {
+        // Give the previous list back to the cache
+        if (selectedListName != "") { listCache[selectedListName].swap(bookmarks); }
+        selectedListName = "";
         bookmarks.clear();
+        bookmarkRows.clear();
+        selectedBookmarks.clear();
         if (std::find(listNames.begin(), listNames.end(), listName) == listNames.end()) {
             selectedListName = "";
             selectedListId = 0;
@@ -321,40 +419,27 @@ private:
             return;
         }
         selectedListId = std::distance(listNames.begin(), std::find(listNames.begin(), listNames.end(), listName));
-        selectedListName = listName;
         config.acquire();
-        for (auto [bmName, bm] : config.conf["lists"][listName]["bookmarks"].items()) {
-            FrequencyBookmark fbm;
-            fbm.frequency = bm["frequency"];
-            fbm.bandwidth = bm["bandwidth"];
-            fbm.mode = bm["mode"];
-            fbm.selected = false;
-            bookmarks[bmName] = fbm;
-        }
+        bookmarks.swap(getList(listName, config.conf["lists"][listName]["file"]));
+        listCache.erase(listName);
         config.release();
+        selectedListName = listName;
+        refreshBookmarkRows();
     }
 
     void saveByName(std::string listName) {
         config.acquire();
-        config.conf["lists"][listName]["bookmarks"] = json::object();
-        for (auto [bmName, bm] : bookmarks) {
-            config.conf["lists"][listName]["bookmarks"][bmName]["frequency"] = bm.frequency;
-            config.conf["lists"][listName]["bookmarks"][bmName]["bandwidth"] = bm.bandwidth;
-            config.conf["lists"][listName]["bookmarks"][bmName]["mode"] = bm.mode;
-        }
+        bookmark_store::save(listDir + "/" + (std::string)config.conf["lists"][listName]["file"], bookmarks);
         refreshWaterfallBookmarks(false);
-        config.release(true);
+        config.release();
+        refreshBookmarkRows();
     }
 
     static void menuHandler(void* ctx) {
         FrequencyManagerModule* _this = (FrequencyManagerModule*)ctx;
         float menuWidth = ImGui::GetContentRegionAvail().x;
 
-        // TODO: Replace with something that won't iterate every frame
-        std::vector<std::string> selectedNames;
-        for (auto& [name, bm] : _this->bookmarks) {
-            if (bm.selected) { selectedNames.push_back(name); }
-        }
+        const std::set<std::string>& selectedNames = _this->selectedBookmarks;
 
         float lineHeight = ImGui::GetTextLineHeightWithSpacing();
 
@@ -364,7 +449,7 @@ private:
             _this->loadByName(_this->listNames[_this->selectedListId]);
             config.acquire();
             config.conf["selectedList"] = _this->selectedListName;
-            config.release(true);
+            config.release(true, "selectedList");
         }
         ImGui::SameLine();
         if (_this->listNames.size() == 0) { style::beginDisabled(); }
@@ -402,7 +487,11 @@ private:
                 ImGui::Text("Deleting list named \"%s\". Are you sure?", _this->selectedListName.c_str());
             }) == GENERIC_DIALOG_BUTTON_YES) {
             config.acquire();
+            std::error_code ec;
+            std::filesystem::remove(listDir + "/" + (std::string)config.conf["lists"][_this->selectedListName]["file"], ec);
             config.conf["lists"].erase(_this->selectedListName);
+            _this->bookmarks.clear();
+            _this->selectedListName = "";
             _this->refreshWaterfallBookmarks(false);
             config.release(true);
             _this->refreshLists();
@@ -439,8 +528,6 @@ private:
                 }
             }
 
-            _this->editedBookmark.selected = false;
-
             _this->createOpen = true;
 
             // Find new unique default name
@@ -467,9 +554,9 @@ private:
         if (selectedNames.size() != 1 && _this->selectedListName != "") { style::beginDisabled(); }
         if (ImGui::Button(("Edit##_freq_mgr_edt_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
             _this->editOpen = true;
-            _this->editedBookmark = _this->bookmarks[selectedNames[0]];
-            _this->editedBookmarkName = selectedNames[0];
-            _this->firstEditedBookmarkName = selectedNames[0];
+            _this->editedBookmark = _this->bookmarks[*selectedNames.begin()];
+            _this->editedBookmarkName = *selectedNames.begin();
+            _this->firstEditedBookmarkName = *selectedNames.begin();
         }
         if (selectedNames.size() != 1 && _this->selectedListName != "") { style::endDisabled(); }
 
@@ -490,27 +577,32 @@ private:
             ImGui::TableSetupColumn("Bookmark");
             ImGui::TableSetupScrollFreeze(2, 1);
             ImGui::TableHeadersRow();
-            for (auto& [name, bm] : _this->bookmarks) {
-                ImGui::TableNextRow();
-                ImGui::TableSetColumnIndex(0);
-                ImVec2 min = ImGui::GetCursorPos();
-
-                if (ImGui::Selectable((name + "##_freq_mgr_bkm_name_" + _this->name).c_str(), &bm.selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_SelectOnClick)) {
-                    // if shift or control isn't pressed, deselect all others
-                    if (!ImGui::GetIO().KeyShift && !ImGui::GetIO().KeyCtrl) {
-                        for (auto& [_name, _bm] : _this->bookmarks) {
-                            if (name == _name) { continue; }
-                            _bm.selected = false;
+
+            // Only the rows that are scrolled into view are drawn
+            ImGuiListClipper clipper;
+            clipper.Begin(_this->bookmarkRows.size());
+            while (clipper.Step()) {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    auto& [name, bm] = *_this->bookmarkRows[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+
+                    bool selected = (selectedNames.find(name) != selectedNames.end());
+                    if (ImGui::Selectable((name + "##_freq_mgr_bkm_name_" + _this->name).c_str(), &selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_SelectOnClick)) {
+                        // if shift or control isn't pressed, deselect all others
+                        if (!ImGui::GetIO().KeyShift && !ImGui::GetIO().KeyCtrl) {
+                            _this->selectedBookmarks.clear();
                         }
+                        if (selected) { _this->selectedBookmarks.insert(name); }
+                        else { _this->selectedBookmarks.erase(name); }
+                    }
+                    if (ImGui::TableGetHoveredColumn() >= 0 && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                        applyBookmark(bm, gui::waterfall.selectedVFO);
                     }
-                }
-                if (ImGui::TableGetHoveredColumn() >= 0 && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
-                    applyBookmark(bm, gui::waterfall.selectedVFO);
-                }
 
-                ImGui::TableSetColumnIndex(1);
-                ImGui::Text("%s %s", utils::formatFreq(bm.frequency).c_str(), demodModeList[bm.mode]);
-                ImVec2 max = ImGui::GetCursorPos();
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%s %s", utils::formatFreq(bm.frequency).c_str(), demodModeList[bm.mode]);
+                }
             }
             ImGui::EndTable();
         }
@@ -518,9 +610,9 @@ private:
 
         if (selectedNames.size() != 1 && _this->selectedListName != "") { style::beginDisabled(); }
         if (ImGui::Button(("Apply##_freq_mgr_apply_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
-            FrequencyBookmark& bm = _this->bookmarks[selectedNames[0]];
-            applyBookmark(bm, gui::waterfall.selectedVFO);
-            bm.selected = false;
+            std::string bmName = *selectedNames.begin();
+            applyBookmark(_this->bookmarks[bmName], gui::waterfall.selectedVFO);
+            _this->selectedBookmarks.erase(bmName);
         }
         if (selectedNames.size() != 1 && _this->selectedListName != "") { style::endDisabled(); }
 
@@ -531,18 +623,19 @@ private:
         ImGui::TableSetColumnIndex(0);
         if (ImGui::Button(("Import##_freq_mgr_imp_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0)) && !_this->importOpen) {
             _this->importOpen = true;
-            _this->importDialog = new pfd::open_file("Import bookmarks", "", { "JSON Files (*.json)", "*.json", "All Files", "*" }, pfd::opt::multiselect);
+            _this->importDialog = new pfd::open_file("Import bookmarks", "", { "Bookmark Files (*.json *.csv)", "*.json *.csv", "All Files", "*" }, pfd::opt::multiselect);
         }
 
         ImGui::TableSetColumnIndex(1);
         if (selectedNames.size() == 0 && _this->selectedListName != "") { style::beginDisabled(); }
         if (ImGui::Button(("Export##_freq_mgr_exp_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0)) && !_this->exportOpen) {
             _this->exportedBookmarks = json::object();
-            config.acquire();
             for (auto& _name : selectedNames) {
-                _this->exportedBookmarks["bookmarks"][_name] = config.conf["lists"][_this->selectedListName]["bookmarks"][_name];
+                FrequencyBookmark& bm = _this->bookmarks[_name];
+                _this->exportedBookmarks["bookmarks"][_name]["frequency"] = bm.frequency;
+                _this->exportedBookmarks["bookmarks"][_name]["bandwidth"] = bm.bandwidth;
+                _this->exportedBookmarks["bookmarks"][_name]["mode"] = bm.mode;
             }
-            config.release();
             _this->exportOpen = true;
             _this->exportDialog = new pfd::save_file("Export bookmarks", "", { "JSON Files (*.json)", "*.json", "All Files", "*" });
         }
@@ -558,7 +651,7 @@ private:
         if (ImGui::Combo(("##_freq_mgr_dms_" + _this->name).c_str(), &_this->bookmarkDisplayMode, bookmarkDisplayModesTxt)) {
             config.acquire();
             config.conf["bookmarkDisplayMode"] = _this->bookmarkDisplayMode;
-            config.release(true);
+            config.release(true, "bookmarkDisplayMode");
         }
 
         if (_this->selectedListName == "") { style::endDisabled(); }
@@ -606,8 +699,12 @@ private:
         FrequencyManagerModule* _this = (FrequencyManagerModule*)ctx;
         if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_OFF) { return; }
 
+        int first, last;
+        _this->findVisibleBookmarks(args.lowFreq, args.highFreq, args.freqToPixelRatio, first, last);
+
         if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_TOP) {
-            for (auto const bm : _this->waterfallBookmarks) {
+            for (int i = first; i < last; i++) {
+                auto const& bm = _this->waterfallBookmarks[i];
                 double centerXpos = args.min.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
 
                 if (bm.bookmark.frequency >= args.lowFreq && bm.bookmark.frequency <= args.highFreq) {
@@ -629,7 +726,8 @@ private:
             }
         }
         else if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) {
-            for (auto const bm : _this->waterfallBookmarks) {
+            for (int i = first; i < last; i++) {
+                auto const& bm = _this->waterfallBookmarks[i];
                 double centerXpos = args.min.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
 
                 if (bm.bookmark.frequency >= args.lowFreq && bm.bookmark.frequency <= args.highFreq) {
@@ -671,9 +769,11 @@ private:
         WaterfallBookmark hoveredBookmark;
         std::string hoveredBookmarkName;
 
+        int first, last;
+        _this->findVisibleBookmarks(args.lowFreq, args.highFreq, args.freqToPixelRatio, first, last);
+
         if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_TOP) {
-            int count = _this->waterfallBookmarks.size();
-            for (int i = count - 1; i >= 0; i--) {
+            for (int i = last - 1; i >= first; i--) {
                 auto& bm = _this->waterfallBookmarks[i];
                 double centerXpos = args.fftRectMin.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
                 ImVec2 nameSize = ImGui::CalcTextSize(bm.bookmarkName.c_str());
@@ -691,8 +791,7 @@ private:
             }
         }
         else if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) {
-            int count = _this->waterfallBookmarks.size();
-            for (int i = count - 1; i >= 0; i--) {
+            for (int i = last - 1; i >= first; i--) {
                 auto& bm = _this->waterfallBookmarks[i];
                 double centerXpos = args.fftRectMin.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
                 ImVec2 nameSize = ImGui::CalcTextSize(bm.bookmarkName.c_str());
@@ -753,36 +852,25 @@ private:
     pfd::save_file* exportDialog;
 
     void importBookmarks(std::string path) {
-        std::ifstream fs(path);
-        json importBookmarks;
-        fs >> importBookmarks;
-
-        if (!importBookmarks.contains("bookmarks")) {
-            flog::error("File does not contains any bookmarks");
-            return;
-        }
-
-        if (!importBookmarks["bookmarks"].is_object()) {
-            flog::error("Bookmark attribute is invalid");
-            return;
-        }
-
-        // Load every bookmark
-        for (auto const [_name, bm] : importBookmarks["bookmarks"].items()) {
+        // Bookmarks are streamed into the list as they're parsed
+        int skipped = 0;
+        std::vector<std::string> modeNames(demodModeList, demodModeList + DEMOD_MODE_COUNT);
+        int count = bookmark_store::importFile(path, modeNames, DEMOD_MODE_RAW, [this, &skipped](const std::string& _name, const FrequencyBookmark& bm) {
             if (bookmarks.find(_name) != bookmarks.end()) {
-                flog::warn("Bookmark with the name '{0}' already exists in list, skipping", _name);
-                continue;
+                skipped++;
+                return true;
             }
-            FrequencyBookmark fbm;
-            fbm.frequency = bm["frequency"];
-            fbm.bandwidth = bm["bandwidth"];
-            fbm.mode = bm["mode"];
-            fbm.selected = false;
+            FrequencyBookmark fbm = bm;
+            if (fbm.mode < 0 || fbm.mode >= DEMOD_MODE_COUNT) { fbm.mode = DEMOD_MODE_RAW; }
             bookmarks[_name] = fbm;
-        }
-        saveByName(selectedListName);
+            return true;
+        });
+        if (count < 0) { return; }
 
-        fs.close();
+        // With large channel plans a warning per duplicate would flood the log
+        if (skipped) { flog::warn("{0} bookmarks already existed in the list and were skipped", skipped); }
+        flog::info("Imported {0} bookmarks from '{1}'", count - skipped, path);
+        saveByName(selectedListName);
     }
 
     void exportBookmarks(std::string path) {
@@ -805,7 +893,10 @@ private:
     EventHandler<ImGui::WaterFall::FFTRedrawArgs> fftRedrawHandler;
     EventHandler<ImGui::WaterFall::InputHandlerArgs> inputHandler;
 
-    std::map<std::string, FrequencyBookmark> bookmarks;
+    BookmarkMap bookmarks;
+    std::vector<BookmarkMap::iterator> bookmarkRows;
+    std::map<std::string, BookmarkMap> listCache;
+    std::set<std::string> selectedBookmarks;
 
     std::string editedBookmarkName = "";
     std::string firstEditedBookmarkName = "";
@@ -820,6 +911,8 @@ private:
     std::string firstEditedListName;
 
     std::vector<WaterfallBookmark> waterfallBookmarks;
+    float maxLabelWidth = 0.0f;
+    bool labelWidthValid = false;
 
     int bookmarkDisplayMode = 0;
 };
@@ -829,8 +922,9 @@ MOD_EXPORT void _INIT_() {
     def["selectedList"] = "General";
     def["bookmarkDisplayMode"] = BOOKMARK_DISP_MODE_TOP;
     def["lists"]["General"]["showOnWaterfall"] = true;
-    def["lists"]["General"]["bookmarks"] = json::object();
+    def["lists"]["General"]["file"] = "list_0.bin";
 
+    listDir = core::args["root"].s() + "/frequency_manager_lists";
     config.setPath(core::args["root"].s() + "/frequency_manager_config.json");
     config.load(def);
     config.enableAutoSave();
@@ -841,13 +935,28 @@ MOD_EXPORT void _INIT_() {
         config.conf["bookmarkDisplayMode"] = BOOKMARK_DISP_MODE_TOP;
     }
     for (auto [listName, list] : config.conf["lists"].items()) {
-        if (list.contains("bookmarks") && list.contains("showOnWaterfall") && list["showOnWaterfall"].is_boolean()) { continue; }
+        if (list.contains("showOnWaterfall") && list["showOnWaterfall"].is_boolean()) { continue; }
         json newList;
         newList = json::object();
         newList["showOnWaterfall"] = true;
         newList["bookmarks"] = list;
         config.conf["lists"][listName] = newList;
     }
+
+    // Move the bookmarks of lists still stored in the config to files of their own
+    for (auto [listName, list] : config.conf["lists"].items()) {
+        if (list.contains("file") && !list.contains("bookmarks")) { continue; }
+        BookmarkMap bookmarks, written;
+        loadJSONList(list, bookmarks);
+        std::string file = list.contains("file") ? (std::string)list["file"] : newListFile(config.conf["lists"]);
+        config.conf["lists"][listName]["file"] = file;
+
+        // Only drop the copy in the config once the file reads back
+        std::string path = listDir + "/" + file;
+        if (bookmark_store::save(path, bookmarks) && bookmark_store::load(path, written) && written.size() == bookmarks.size()) {
+            config.conf["lists"][listName].erase("bookmarks");
+        }
+    }
     config.release(true);
 }
 
@@ -1,4 +1,5 @@
 #include <utils/net.h>
+#include <utils/shm_ring.h>
 #include <imgui.h>
 #include <module.h>
 #include <gui/gui.h>
@@ -11,6 +12,17 @@
 #include <dsp/buffer/reshaper.h>
 #include <gui/dialogs/dialog_box.h>
 #include <core.h>
+#include <metrics.h>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include "vita49.h"
+
+// Fewest frames kept by the shared memory ring, however low the samplerate
+#define SHM_MIN_FRAMES  65536
+
+// Interval at which the context of a VITA-49 stream is repeated for the readers that joined it late, in seconds
+#define VITA49_CONTEXT_INTERVAL 1.0
 
 SDRPP_MOD_INFO{
     /* Name:            */ "iq_exporter",
@@ -31,7 +43,9 @@ enum Mode {
 enum Protocol {
     PROTOCOL_TCP_SERVER,
     PROTOCOL_TCP_CLIENT,
-    PROTOCOL_UDP
+    PROTOCOL_UDP,
+    PROTOCOL_UDP_MULTICAST,
+    PROTOCOL_SHM
 };
 
 enum SampleType {
@@ -41,6 +55,11 @@ enum SampleType {
     SAMPLE_TYPE_FLOAT32
 };
 
+enum Framing {
+    FRAMING_NONE,
+    FRAMING_VITA49
+};
+
 class IQExporterModule : public ModuleManager::Instance {
 public:
     IQExporterModule(std::string name) {
@@ -68,6 +87,8 @@ public:
         protocols.define("TCP (Server)", PROTOCOL_TCP_SERVER);
         protocols.define("TCP (Client)", PROTOCOL_TCP_CLIENT);
         protocols.define("UDP", PROTOCOL_UDP);
+        protocols.define("UDP (Multicast)", PROTOCOL_UDP_MULTICAST);
+        protocols.define("Shared memory", PROTOCOL_SHM);
 
         // Define sample types
         sampleTypes.define("Int8", SAMPLE_TYPE_INT8);
@@ -75,6 +96,10 @@ public:
         sampleTypes.define("Int32", SAMPLE_TYPE_INT32);
         sampleTypes.define("Float32", SAMPLE_TYPE_FLOAT32);
 
+        // Define framings
+        framings.define("None", FRAMING_NONE);
+        framings.define("VITA-49", FRAMING_VITA49);
+
         // Define packet sizes
         for (int i = 8; i <= 32768; i <<= 1) {
             char buf[16];
@@ -106,14 +131,30 @@ public:
             int size = config.conf[name]["packetSize"];
             if (packetSizes.keyExists(size)) { packetSize = packetSizes.value(packetSizes.keyId(size)); }
         }
+        if (config.conf[name].contains("framing")) {
+            std::string framingStr = config.conf[name]["framing"];
+            if (framings.keyExists(framingStr)) { framing = framings.value(framings.keyId(framingStr)); }
+        }
+        if (config.conf[name].contains("streamId")) {
+            int sid = config.conf[name]["streamId"];
+            streamId = std::max<int>(sid, 0);
+        }
         if (config.conf[name].contains("host")) {
             std::string hostStr = config.conf[name]["host"];
             strcpy(hostname, hostStr.c_str());
         }
+        if (config.conf[name].contains("shmName")) {
+            std::string shmStr = config.conf[name]["shmName"];
+            snprintf(shmName, sizeof(shmName), "%s", shmStr.c_str());
+        }
         if (config.conf[name].contains("port")) {
             port = config.conf[name]["port"];
             port = std::clamp<int>(port, 1, 65535);
         }
+        if (config.conf[name].contains("multicastTTL")) {
+            multicastTTL = config.conf[name]["multicastTTL"];
+            multicastTTL = std::clamp<int>(multicastTTL, 1, 255);
+        }
         if (config.conf[name].contains("running")) {
             autoStart = config.conf[name]["running"];
         }
@@ -125,9 +166,10 @@ public:
         protoId = protocols.valueId(proto);
         sampTypeId = sampleTypes.valueId(sampType);
         packetSizeId = packetSizes.valueId(packetSize);
+        framingId = framings.valueId(framing);
 
-        // Allocate buffer
-        buffer = dsp::buffer::alloc<uint8_t>(STREAM_BUFFER_SIZE * sizeof(dsp::complex_t));
+        // Allocate buffer, with room for a VITA-49 header before the samples
+        buffer = dsp::buffer::alloc<uint8_t>(VITA49_MAX_HEADER_SIZE + STREAM_BUFFER_SIZE * sizeof(dsp::complex_t));
 
         // Init DSP
         reshape.init(&iqStream, packetSize/sampleSize(), 0);
@@ -141,9 +183,13 @@ public:
 
         // Register menu entry
         gui::menu.registerEntry(name, menuHandler, this, this);
+        metrics::registerCollector("iq_exporter/" + name, collectMetrics, this);
     }
 
     ~IQExporterModule() {
+        // The collector takes the socket mutex
+        metrics::unregisterCollector("iq_exporter/" + name);
+
         // Un-register menu entry
         gui::menu.removeEntry(name);
 
@@ -207,6 +253,25 @@ public:
                 // Connect to TCP server
                 sock = net::connect(hostname, port);
             }
+            else if (proto == PROTOCOL_SHM) {
+                // Programs on the same machine read the samples in place, a quarter of a second of them being kept
+                int frames = std::max<int>(currentSamplerate() / 4.0, SHM_MIN_FRAMES);
+                if (!ring.open(shmName, shmFormat(), 2, frames, currentSamplerate(), currentFrequency())) {
+                    throw std::runtime_error(std::string("Could not create the shared memory ") + shmName);
+                }
+            }
+            else if (proto == PROTOCOL_UDP_MULTICAST) {
+                // Check that the destination is a multicast group
+                net::Address group(hostname, port);
+                if (!group.isMulticast()) { throw std::runtime_error(std::string(hostname) + " is not a multicast address"); }
+
+                // Open UDP socket and set how far the packets may go
+                sock = net::openudp(group);
+                if (!sock->setMulticastTTL(multicastTTL)) {
+                    sock.reset();
+                    throw std::runtime_error("Could not set multicast TTL");
+                }
+            }
             else {
                 // Open UDP socket
                 sock = net::openudp(hostname, port, "0.0.0.0", 0, true);
@@ -219,6 +284,11 @@ public:
             return;
         }
 
+        // A new stream starts with its context
+        dataCount = 0;
+        contextCount = 0;
+        contextDue = true;
+
         running = true;
     }
 
@@ -241,11 +311,14 @@ public:
             // Free listener
             listener.reset();
 
-            // Close socket and free it
-            if (sock) {
-                sock->close();
-                sock.reset();
+            // Disconnect all subscribers
+            for (auto& client : clients) {
+                client->close();
             }
+            clients.clear();
+        }
+        else if (proto == PROTOCOL_SHM) {
+            ring.close();
         }
         else {
             // Close socket and free it
@@ -344,19 +417,64 @@ private:
             config.release(true);
         }
 
-        // Hostname and port field
-        if (ImGui::InputText(("##iq_exporter_host_" + _this->name).c_str(), _this->hostname, sizeof(_this->hostname))) {
-            config.acquire();
-            config.conf[_this->name]["host"] = _this->hostname;
-            config.release(true);
+        // Packet framing, the shared memory having its own header
+        if (_this->proto != PROTOCOL_SHM) {
+            ImGui::LeftLabel("Framing");
+            ImGui::FillWidth();
+            if (ImGui::Combo(("##iq_exporter_framing_" + _this->name).c_str(), &_this->framingId, _this->framings.txt)) {
+                _this->framing = _this->framings.value(_this->framingId);
+                config.acquire();
+                config.conf[_this->name]["framing"] = _this->framings.key(_this->framingId);
+                config.release(true);
+            }
+            if (_this->framing == FRAMING_VITA49) {
+                ImGui::LeftLabel("Stream ID");
+                ImGui::FillWidth();
+                if (ImGui::InputInt(("##iq_exporter_sid_" + _this->name).c_str(), &_this->streamId)) {
+                    _this->streamId = std::max<int>(_this->streamId, 0);
+                    config.acquire();
+                    config.conf[_this->name]["streamId"] = _this->streamId;
+                    config.release(true);
+                }
+            }
         }
-        ImGui::SameLine();
-        ImGui::FillWidth();
-        if (ImGui::InputInt(("##iq_exporter_port_" + _this->name).c_str(), &_this->port, 0, 0)) {
-            _this->port = std::clamp<int>(_this->port, 1, 65535);
-            config.acquire();
-            config.conf[_this->name]["port"] = _this->port;
-            config.release(true);
+
+        // Hostname and port field, or name of the shared memory
+        if (_this->proto == PROTOCOL_SHM) {
+            ImGui::LeftLabel("Name");
+            ImGui::FillWidth();
+            if (ImGui::InputText(("##iq_exporter_shm_" + _this->name).c_str(), _this->shmName, sizeof(_this->shmName))) {
+                config.acquire();
+                config.conf[_this->name]["shmName"] = _this->shmName;
+                config.release(true);
+            }
+        }
+        else {
+            if (ImGui::InputText(("##iq_exporter_host_" + _this->name).c_str(), _this->hostname, sizeof(_this->hostname))) {
+                config.acquire();
+                config.conf[_this->name]["host"] = _this->hostname;
+                config.release(true);
+            }
+            ImGui::SameLine();
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##iq_exporter_port_" + _this->name).c_str(), &_this->port, 0, 0)) {
+                _this->port = std::clamp<int>(_this->port, 1, 65535);
+                config.acquire();
+                config.conf[_this->name]["port"] = _this->port;
+                config.release(true);
+            }
+        }
+
+        // Multicast TTL
+        if (_this->proto == PROTOCOL_UDP_MULTICAST) {
+            ImGui::LeftLabel("TTL");
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##iq_exporter_ttl_" + _this->name).c_str(), &_this->multicastTTL)) {
+                _this->multicastTTL = std::clamp<int>(_this->multicastTTL, 1, 255);
+                config.acquire();
+                config.conf[_this->name]["multicastTTL"] = _this->multicastTTL;
+                config.release(true);
+            }
         }
 
         if (_this->running) { ImGui::EndDisabled(); }
@@ -379,18 +497,34 @@ private:
             }
         }
 
-        // Check if the socket is open by attempting a read
+        // Check if the socket is open by attempting a read, and count the subscribers still connected in server mode
         bool sockOpen;
-        {
+        int clientCount = 0;
+        if (_this->proto == PROTOCOL_TCP_SERVER) {
+            std::lock_guard lck(_this->sockMtx);
+            for (auto& client : _this->clients) {
+                uint8_t dummy;
+                if (client->isOpen() && client->recv(&dummy, 1, false, net::NONBLOCKING) != 0) { clientCount++; }
+            }
+            sockOpen = clientCount;
+        }
+        else if (_this->proto == PROTOCOL_SHM) {
+            sockOpen = _this->ring.isOpen();
+        }
+        else {
             uint8_t dummy;
-            sockOpen = !(!_this->sock || !_this->sock->isOpen() || (_this->proto != PROTOCOL_UDP && _this->sock->recv(&dummy, 1, false, net::NONBLOCKING) == 0));
+            bool udp = (_this->proto == PROTOCOL_UDP || _this->proto == PROTOCOL_UDP_MULTICAST);
+            sockOpen = !(!_this->sock || !_this->sock->isOpen() || (!udp && _this->sock->recv(&dummy, 1, false, net::NONBLOCKING) == 0));
         }
 
         // Status text
         ImGui::TextUnformatted("Status:");
         ImGui::SameLine();
-        if (sockOpen) {
-            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), (_this->proto == PROTOCOL_TCP_SERVER || _this->proto == PROTOCOL_TCP_CLIENT) ? "Connected" : "Sending");
+        if (sockOpen && _this->proto == PROTOCOL_TCP_SERVER) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "%d client%s connected", clientCount, (clientCount > 1) ? "s" : "");
+        }
+        else if (sockOpen) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), (_this->proto == PROTOCOL_TCP_CLIENT) ? "Connected" : ((_this->proto == PROTOCOL_SHM) ? "Sharing" : "Sending"));
         }
         else if (_this->listener && _this->listener->listening()) {
             ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Listening");
@@ -438,8 +572,8 @@ private:
             reshape.setInput(vfo->output);
         }
         else {
-            // Bind IQ stream
-            sigpath::iqFrontEnd.bindIQStream(&iqStream);
+            // Bind IQ stream, a slow client must only lose samples instead of holding up the whole DSP
+            sigpath::iqFrontEnd.bindIQStream(&iqStream, dsp::routing::BACKPRESSURE_DROP_OLDEST);
             streamBound = true;
 
             // Set its output as the input to the DSP
@@ -461,10 +595,11 @@ private:
             auto newSock = listener->accept();
             if (!newSock) { break; }
 
-            // Update socket
+            // Add it to the subscribers, who need the context of the stream first
             {
                 std::lock_guard lck(sockMtx);
-                sock = newSock;
+                clients.push_back(newSock);
+                contextDue = true;
             }
         }
     }
@@ -484,49 +619,172 @@ private:
         }
     }
 
+    ShmRingFormat shmFormat() {
+        switch (sampType) {
+        case SAMPLE_TYPE_INT8:
+            return SHM_RING_FORMAT_S8;
+        case SAMPLE_TYPE_INT16:
+            return SHM_RING_FORMAT_S16;
+        case SAMPLE_TYPE_INT32:
+            return SHM_RING_FORMAT_S32;
+        default:
+            return SHM_RING_FORMAT_F32;
+        }
+    }
+
+    double currentSamplerate() {
+        return (mode == MODE_VFO) ? samplerate : sigpath::iqFrontEnd.getEffectiveSamplerate();
+    }
+
+    double currentFrequency() {
+        double freq = gui::waterfall.getCenterFrequency();
+        if (mode == MODE_VFO && vfo) { freq += vfo->getOffset(); }
+        return freq;
+    }
+
+    // Convert samples to the selected sample type, there's nothing to do for float32
+    void convert(const dsp::complex_t* in, void* out, int count) {
+        switch (sampType) {
+        case SAMPLE_TYPE_INT8:
+            volk_32f_s32f_convert_8i((int8_t*)out, (float*)in, 128.0f, count*2);
+            break;
+        case SAMPLE_TYPE_INT16:
+            volk_32f_s32f_convert_16i((int16_t*)out, (float*)in, 32768.0f, count*2);
+            break;
+        case SAMPLE_TYPE_INT32:
+            volk_32f_s32f_convert_32i((int32_t*)out, (float*)in, 2147483647.0f, count*2);
+            break;
+        case SAMPLE_TYPE_FLOAT32:
+            if (out != in) { memcpy(out, in, count * sizeof(dsp::complex_t)); }
+            break;
+        }
+    }
+
     static void dataHandler(dsp::complex_t* data, int count, void* ctx) {
         IQExporterModule* _this = (IQExporterModule*)ctx;
 
         // Try to cquire lock on socket
         if (!_this->sockMtx.try_lock()) { return; }
 
+        // Samples are converted straight into the shared memory, where the readers use them in place
+        if (_this->ring.isOpen()) {
+            _this->ring.setSampleRate(_this->currentSamplerate());
+            _this->ring.setFrequency(_this->currentFrequency());
+            while (count > 0) {
+                int n;
+                uint8_t* dst = _this->ring.reserve(count, n);
+                _this->convert(data, dst, n);
+                _this->ring.commit(n);
+                data += n;
+                count -= n;
+            }
+            _this->sockMtx.unlock();
+            return;
+        }
+
+        // Forget the subscribers that disconnected
+        auto& clients = _this->clients;
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const std::shared_ptr<net::Socket>& c) { return !c->isOpen(); }), clients.end());
+
         // If not valid or open, give uo
-        if (!_this->sock || !_this->sock->isOpen()) {
+        if ((!_this->sock || !_this->sock->isOpen()) && clients.empty()) {
             // Unlock socket mutex
             _this->sockMtx.unlock();
             return;
         }
         
-        // Convert the samples or send directory for float32
-        int size;
-        switch (_this->sampType) {
-        case SAMPLE_TYPE_INT8:
-            volk_32f_s32f_convert_8i((int8_t*)_this->buffer, (float*)data, 128.0f, count*2);
-            size = sizeof(int8_t)*2;
-            break;
-        case SAMPLE_TYPE_INT16:
-            volk_32f_s32f_convert_16i((int16_t*)_this->buffer, (float*)data, 32768.0f, count*2);
-            size = sizeof(int16_t)*2;
-            break;
-        case SAMPLE_TYPE_INT32:
-            volk_32f_s32f_convert_32i((int32_t*)_this->buffer, (float*)data, 2147483647.0f, count*2);
-            size = sizeof(int32_t)*2;
-            break;
-        case SAMPLE_TYPE_FLOAT32:
-            _this->sock->send((uint8_t*)data, count*sizeof(dsp::complex_t));
-        default:
-            // Unlock socket mutex
+        // Each buffer from the reshaper is a packet
+        if (_this->framing == FRAMING_VITA49) {
+            _this->sendVITA49(data, count);
             _this->sockMtx.unlock();
             return;
         }
 
+        // Convert the samples once for all destinations, float32 being sent directly
+        int size = _this->sampleSize();
+        const uint8_t* out = (_this->sampType == SAMPLE_TYPE_FLOAT32) ? (uint8_t*)data : _this->buffer;
+        _this->convert(data, (void*)out, count);
+
         // Send converted samples
-        _this->sock->send(_this->buffer, count*size);
+        _this->sendAll(out, count*size);
 
         // Unlock socket mutex
         _this->sockMtx.unlock();
     }
 
+    // sockMtx must be held
+    void sendAll(const uint8_t* data, int len) {
+        int sent = 0;
+        if (sock && sock->isOpen()) { sent += std::max<int>(sock->send(data, len), 0); }
+        for (auto& client : clients) {
+            sent += std::max<int>(client->send(data, len), 0);
+        }
+        bytesSent += sent;
+    }
+
+    // Send the samples as a VITA-49 data packet, preceded by a context packet whenever the samplerate or the frequency
+    // changed, a client joined, or at intervals. sockMtx must be held
+    void sendVITA49(const dsp::complex_t* data, int count) {
+        // The advertised rate is the one the samples are exported at. Should the stream describe another one, its sample
+        // index is brought to the exported rate rather than trusted
+        double sr = currentSamplerate();
+        dsp::stream_meta meta = reshape.out.readMeta;
+        if (meta.samplerate > 0.0 && fabs(meta.samplerate - sr) > 1e-6 * sr) {
+            if (!rateMismatchLogged) {
+                flog::warn("[IQExporter] Stream samplerate {} doesn't match the exported samplerate {}", meta.samplerate, sr);
+                rateMismatchLogged = true;
+            }
+            meta = meta.rescaled(sr / meta.samplerate);
+        }
+        vita49::Timestamp ts = vita49::timestamp(meta.timestamp, meta.sampleIndex, sr);
+
+        double freq = currentFrequency();
+        double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        bool changed = (sr != contextSamplerate || freq != contextFrequency);
+        if (changed || contextDue || now - lastContext >= VITA49_CONTEXT_INTERVAL) {
+            uint8_t ctx[VITA49_MAX_CONTEXT_SIZE];
+            int len = vita49::writeContext(ctx, contextCount++, streamId, ts, changed, freq, sr, sr);
+            sendAll(ctx, len);
+            contextSamplerate = sr;
+            contextFrequency = freq;
+            contextDue = false;
+            lastContext = now;
+        }
+
+        // The samples are converted after the room left for the header, and swapped to big endian
+        uint8_t* payload = &buffer[VITA49_MAX_HEADER_SIZE];
+        convert(data, payload, count);
+        switch (sampType) {
+        case SAMPLE_TYPE_INT16:
+            volk_16u_byteswap((uint16_t*)payload, count*2);
+            break;
+        case SAMPLE_TYPE_INT32:
+        case SAMPLE_TYPE_FLOAT32:
+            volk_32u_byteswap((uint32_t*)payload, count*2);
+            break;
+        default:
+            break;
+        }
+
+        int payloadSize = count * sampleSize();
+        int hdrSize = vita49::headerSize(ts);
+        uint8_t* packet = payload - hdrSize;
+        vita49::writeHeader(packet, vita49::PACKET_TYPE_IF_DATA_SID, dataCount++, hdrSize + payloadSize, streamId, ts);
+        sendAll(packet, hdrSize + payloadSize);
+    }
+
+    static void collectMetrics(metrics::Writer& w, void* ctx) {
+        IQExporterModule* _this = (IQExporterModule*)ctx;
+        std::lock_guard<std::mutex> lck(_this->sockMtx);
+        metrics::Labels labels = { { "instance", _this->name } };
+        w.declare("iq_exporter_running", metrics::TYPE_GAUGE, "Whether the IQ exporter is running");
+        w.declare("iq_exporter_clients", metrics::TYPE_GAUGE, "Subscribers connected to the TCP server of the IQ exporter");
+        w.declare("iq_exporter_sent_bytes_total", metrics::TYPE_COUNTER, "Bytes of samples sent over the network");
+        w.add("iq_exporter_running", _this->running ? 1.0 : 0.0, labels);
+        w.add("iq_exporter_clients", _this->clients.size(), labels);
+        w.add("iq_exporter_sent_bytes_total", _this->bytesSent, labels);
+    }
+
     std::string name;
     bool enabled = true;
 
@@ -540,8 +798,13 @@ private:
     int sampTypeId;
     int packetSize = 1024;
     int packetSizeId;
+    Framing framing = FRAMING_NONE;
+    int framingId;
+    int streamId = 0;
     char hostname[1024] = "localhost";
+    char shmName[256] = "sdrpp_iq";
     int port = 1234;
+    int multicastTTL = 1;
     bool running = false;
     bool wasRunning = false;
 
@@ -553,6 +816,7 @@ private:
     OptionList<std::string, Protocol> protocols;
     OptionList<std::string, SampleType> sampleTypes;
     OptionList<int, int> packetSizes;
+    OptionList<std::string, Framing> framings;
 
     VFOManager::VFO* vfo = NULL;
     bool streamBound = false;
@@ -566,6 +830,20 @@ private:
     std::mutex sockMtx;
     std::shared_ptr<net::Socket> sock;
     std::shared_ptr<net::Listener> listener;
+    shm::RingWriter ring;
+
+    // Subscribers of the TCP server, all sent the same converted buffer
+    std::vector<std::shared_ptr<net::Socket>> clients;
+    std::atomic<uint64_t> bytesSent = 0;
+
+    // State of the VITA-49 stream, only used with sockMtx held
+    uint32_t dataCount = 0;
+    uint32_t contextCount = 0;
+    bool contextDue = true;
+    double contextSamplerate = 0.0;
+    double contextFrequency = 0.0;
+    double lastContext = 0.0;
+    bool rateMismatchLogged = false;
 };
 
 MOD_EXPORT void _INIT_() {
@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// Longest header of a data packet, in bytes: header, stream ID, integer and fractional timestamps
+#define VITA49_MAX_HEADER_SIZE  20
+
+// Longest context packet, in bytes: the longest header, the context indicators and three fields of 8 bytes
+#define VITA49_MAX_CONTEXT_SIZE (VITA49_MAX_HEADER_SIZE + 28)
+
+// Minimal VITA-49.0 framing: IF data packets with a stream ID and IF context packets giving the RF frequency, the
+// bandwidth and the samplerate of that stream. Everything is big endian, the payload included. Packets are timestamped
+// with the UTC second of their first sample and the count of samples since that second when the time of the samples
+// is known, otherwise with a free running count of samples since the start of the stream. Either way readers can tell
+// lost packets from the timestamps, the 4 bit packet count only catching short losses
+namespace vita49 {
+    enum PacketType {
+        PACKET_TYPE_IF_DATA_SID = 0x1,
+        PACKET_TYPE_IF_CONTEXT = 0x4
+    };
+
+    enum TSI {
+        TSI_NONE = 0,
+        TSI_UTC = 1
+    };
+
+    enum TSF {
+        TSF_NONE = 0,
+        TSF_SAMPLE_COUNT = 1
+    };
+
+    // Fields of the first context indicator word
+    enum CIF0 {
+        CIF0_CHANGED = (1u << 31),
+        CIF0_BANDWIDTH = (1u << 29),
+        CIF0_RF_FREQUENCY = (1u << 27),
+        CIF0_SAMPLERATE = (1u << 21)
+    };
+
+    struct Timestamp {
+        TSI tsi = TSI_NONE;
+        uint32_t seconds = 0;
+        TSF tsf = TSF_NONE;
+        uint64_t samples = 0;
+    };
+
+    inline void put32(uint8_t* p, uint32_t v) {
+        p[0] = v >> 24;
+        p[1] = v >> 16;
+        p[2] = v >> 8;
+        p[3] = v;
+    }
+
+    inline void put64(uint8_t* p, uint64_t v) {
+        put32(p, v >> 32);
+        put32(&p[4], v);
+    }
+
+    // Timestamp of a sample from the unix time of the samples if known (0 otherwise), and from its index
+    inline Timestamp timestamp(double unixTime, uint64_t sampleIndex, double samplerate) {
+        Timestamp ts;
+        ts.tsf = TSF_SAMPLE_COUNT;
+        if (unixTime > 0.0 && samplerate > 0.0) {
+            double sec = floor(unixTime);
+            ts.tsi = TSI_UTC;
+            ts.seconds = (uint32_t)sec;
+            ts.samples = (uint64_t)((unixTime - sec) * samplerate);
+        }
+        else {
+            ts.samples = sampleIndex;
+        }
+        return ts;
+    }
+
+    // Write the header of a packet, returns its size in bytes. size is that of the whole packet, in bytes
+    inline int writeHeader(uint8_t* buf, PacketType type, int count, int size, uint32_t streamId, const Timestamp& ts) {
+        uint32_t hdr = ((uint32_t)type << 28) | ((uint32_t)ts.tsi << 22) | ((uint32_t)ts.tsf << 20) | ((uint32_t)(count & 0xF) << 16) | (uint32_t)((size / 4) & 0xFFFF);
+        put32(buf, hdr);
+        put32(&buf[4], streamId);
+        int len = 8;
+        if (ts.tsi != TSI_NONE) {
+            put32(&buf[len], ts.seconds);
+            len += 4;
+        }
+        if (ts.tsf != TSF_NONE) {
+            put64(&buf[len], ts.samples);
+            len += 8;
+        }
+        return len;
+    }
+
+    inline int headerSize(const Timestamp& ts) {
+        return 8 + ((ts.tsi != TSI_NONE) ? 4 : 0) + ((ts.tsf != TSF_NONE) ? 8 : 0);
+    }
+
+    // Frequencies are 64 bit fixed point Hz with 20 fractional bits
+    inline int64_t toFixed(double hz) {
+        return (int64_t)llround(hz * (double)(1 << 20));
+    }
+
+    // Context packet of the stream, the timestamp being that of the sample it applies from. Returns its size in bytes,
+    // buf must hold VITA49_MAX_CONTEXT_SIZE bytes
+    inline int writeContext(uint8_t* buf, int count, uint32_t streamId, const Timestamp& ts, bool changed, double frequency, double bandwidth, double samplerate) {
+        int len = writeHeader(buf, PACKET_TYPE_IF_CONTEXT, count, headerSize(ts) + 28, streamId, ts);
+        put32(&buf[len], CIF0_BANDWIDTH | CIF0_RF_FREQUENCY | CIF0_SAMPLERATE | (changed ? CIF0_CHANGED : 0));
+        len += 4;
+
+        // In the order of their indicator bits, highest first
+        put64(&buf[len], toFixed(bandwidth));
+        put64(&buf[len + 8], toFixed(frequency));
+        put64(&buf[len + 16], toFixed(samplerate));
+        return len + 24;
+    }
+}
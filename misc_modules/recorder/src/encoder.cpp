@@ -0,0 +1,483 @@
+#include "encoder.h"
+#include <dsp/thread_role.h>
+#include <utils/flog.h>
+#include <stdexcept>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+// Threads of the pool at most, there being one per two cores below it
+#define ENCODER_MAX_THREADS     4
+
+namespace encoder {
+    // Frames handed to the encoder at once
+    const size_t ENCODE_BLOCK_FRAMES    = 8192;
+
+    Pool::~Pool() {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        stopWorkers();
+    }
+
+    void Pool::add(Writer* writer) {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        writers.modify([&](std::vector<Writer*>& list) {
+            list.push_back(writer);
+            return true;
+        });
+        writerCount++;
+        if (!workers.empty()) { return; }
+
+        stop = false;
+        int count = std::clamp<int>(std::thread::hardware_concurrency() / 2, 1, ENCODER_MAX_THREADS);
+        for (int i = 0; i < count; i++) { workers.emplace_back(&Pool::worker, this); }
+    }
+
+    void Pool::remove(Writer* writer) {
+        // Waits for the threads to be done with the list the writer was in
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        bool removed = writers.modify([&](std::vector<Writer*>& list) {
+            auto it = std::find(list.begin(), list.end(), writer);
+            if (it == list.end()) { return false; }
+            list.erase(it);
+            return true;
+        });
+        if (removed && !--writerCount) { stopWorkers(); }
+    }
+
+    void Pool::notify() {
+        // Not taking the lock, a wakeup missed by a thread about to wait is made up for by the timeout of the wait
+        pending.store(true, std::memory_order_release);
+        cnd.notify_one();
+    }
+
+    void Pool::stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            stop = true;
+        }
+        cnd.notify_all();
+        for (auto& t : workers) { t.join(); }
+        workers.clear();
+    }
+
+    void Pool::worker() {
+        dsp::applyThreadRole(dsp::THREAD_ROLE_IO);
+        while (true) {
+            // Drain every writer not already being drained by another thread, until none has anything left
+            bool worked = false;
+            writers.forEach([&](Writer* writer) {
+                if (writer->busy.exchange(true, std::memory_order_acquire)) { return; }
+                worked |= writer->drain();
+                writer->busy.store(false, std::memory_order_release);
+            });
+            if (worked) { continue; }
+
+            std::unique_lock<std::mutex> lck(mtx);
+            cnd.wait_for(lck, std::chrono::duration<double>(ENCODER_WAKE_SECONDS), [&]() { return pending.exchange(false, std::memory_order_acquire) || stop; });
+            if (stop) { return; }
+        }
+    }
+
+    Writer::Writer(Pool* pool) {
+        _pool = pool;
+    }
+
+    // The derived writers close the file, end() not being callable from here
+    Writer::~Writer() {}
+
+    bool Writer::open(std::string path) {
+        if (_open) { close(); }
+
+        // Reset work values
+        size_t frames = std::max<size_t>(_samplerate * ENCODER_QUEUE_SECONDS, ENCODE_BLOCK_FRAMES);
+        queue.assign(frames * _channels, 0.0f);
+        wakeFill = std::max<size_t>(_samplerate * ENCODER_WAKE_SECONDS, 1) * _channels;
+        writePos = 0;
+        readPos = 0;
+        samplesWritten = 0;
+        samplesDropped = 0;
+        bytesWritten = 0;
+        failed = false;
+
+        // Open the file with a large buffer and write the headers
+        file = fopen(path.c_str(), "wb");
+        if (!file) { return false; }
+        setvbuf(file, NULL, _IOFBF, ENCODER_FILE_BUFFER);
+        if (!begin()) {
+            if (file) { fclose(file); }
+            file = NULL;
+            return false;
+        }
+
+        _open = true;
+        _pool->add(this);
+        return true;
+    }
+
+    void Writer::close() {
+        if (!_open) { return; }
+        _open = false;
+
+        // Once out of the pool, encode what's left from here
+        _pool->remove(this);
+        drain();
+        if (!end()) { flog::error("Failed to finish the encoded recording"); }
+        if (file) { fclose(file); }
+        file = NULL;
+    }
+
+    void Writer::setChannels(int channels) {
+        // Do not allow settings to change while open
+        if (_open) { throw std::runtime_error("Cannot change parameters while file is open"); }
+
+        // Validate channel count
+        if (channels < 1) { throw std::runtime_error("Channel count must be greater or equal to 1"); }
+        _channels = channels;
+    }
+
+    void Writer::setSamplerate(double samplerate) {
+        // Do not allow settings to change while open
+        if (_open) { throw std::runtime_error("Cannot change parameters while file is open"); }
+
+        // Validate samplerate
+        if (samplerate <= 0.0) { throw std::runtime_error("Samplerate must be non-zero"); }
+        _samplerate = samplerate;
+    }
+
+    float Writer::getBacklogFill() {
+        if (queue.empty()) { return 0.0f; }
+        uint64_t fill = writePos.load(std::memory_order_relaxed) - readPos.load(std::memory_order_relaxed);
+        return (float)fill / (float)queue.size();
+    }
+
+    void Writer::write(const float* samples, int count) {
+        if (!_open) { return; }
+
+        // The samples are dropped whole if they don't fit, the encoder seeing a gap rather than a partial block
+        size_t len = (size_t)count * _channels;
+        size_t size = queue.size();
+        uint64_t w = writePos.load(std::memory_order_relaxed);
+        uint64_t r = readPos.load(std::memory_order_acquire);
+        if (size - (w - r) < len) {
+            samplesDropped += count;
+            return;
+        }
+
+        size_t pos = w % size;
+        size_t first = std::min<size_t>(len, size - pos);
+        memcpy(&queue[pos], samples, first * sizeof(float));
+        memcpy(&queue[0], &samples[first], (len - first) * sizeof(float));
+        writePos.store(w + len, std::memory_order_release);
+        samplesWritten += count;
+
+        // Only wake the pool up once there's enough to be worth encoding
+        if (w + len - r >= wakeFill) { _pool->notify(); }
+    }
+
+    bool Writer::drain() {
+        uint64_t w = writePos.load(std::memory_order_acquire);
+        uint64_t r = readPos.load(std::memory_order_relaxed);
+        if (w == r) { return false; }
+
+        // The queue holds whole frames, so does every contiguous part of it
+        size_t size = queue.size();
+        while (r < w) {
+            size_t pos = r % size;
+            size_t len = std::min<size_t>({ (size_t)(w - r), size - pos, ENCODE_BLOCK_FRAMES * _channels });
+            if (!failed && !encode(&queue[pos], len / _channels)) {
+                flog::error("Failed to encode the recording, the rest of it is discarded");
+                failed = true;
+            }
+            r += len;
+            readPos.store(r, std::memory_order_release);
+        }
+        return true;
+    }
+
+#ifdef RECORDER_FLAC
+    // From 0 for the fastest to 8 for the smallest files, 5 being the default of the flac tool
+    const int FLAC_COMPRESSION_LEVEL    = 5;
+
+    FLACWriter::~FLACWriter() {
+        close();
+    }
+
+    void FLACWriter::setBitDepth(int bits) {
+        // Do not allow settings to change while open
+        if (isOpen()) { throw std::runtime_error("Cannot change parameters while file is open"); }
+        _bits = std::clamp<int>(bits, 8, 24);
+    }
+
+    bool FLACWriter::begin() {
+        flac = FLAC__stream_encoder_new();
+        if (!flac) { return false; }
+        FLAC__stream_encoder_set_channels(flac, _channels);
+        FLAC__stream_encoder_set_bits_per_sample(flac, _bits);
+        FLAC__stream_encoder_set_sample_rate(flac, (uint32_t)round(_samplerate));
+        FLAC__stream_encoder_set_compression_level(flac, FLAC_COMPRESSION_LEVEL);
+        FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_FILE(flac, file, progressCallback, this);
+        if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+            flog::error("Failed to start the FLAC encoder: {}", FLAC__StreamEncoderInitStatusString[status]);
+            FLAC__stream_encoder_delete(flac);
+            flac = NULL;
+            return false;
+        }
+
+        // The encoder closes the file once finished, it also rewrites the header with the sample count
+        file = NULL;
+        return true;
+    }
+
+    bool FLACWriter::encode(const float* samples, int count) {
+        size_t len = (size_t)count * _channels;
+        if (pcm.size() < len) { pcm.resize(len); }
+        float scale = (float)((1 << (_bits - 1)) - 1);
+        for (size_t i = 0; i < len; i++) {
+            pcm[i] = (FLAC__int32)lrintf(std::clamp<float>(samples[i], -1.0f, 1.0f) * scale);
+        }
+        return FLAC__stream_encoder_process_interleaved(flac, pcm.data(), count);
+    }
+
+    bool FLACWriter::end() {
+        bool ok = FLAC__stream_encoder_finish(flac);
+        FLAC__stream_encoder_delete(flac);
+        flac = NULL;
+        pcm.clear();
+        pcm.shrink_to_fit();
+        return ok;
+    }
+
+    void FLACWriter::progressCallback(const FLAC__StreamEncoder* enc, FLAC__uint64 bytes, FLAC__uint64 samples, uint32_t frames, uint32_t totalFrames, void* ctx) {
+        FLACWriter* _this = (FLACWriter*)ctx;
+        _this->bytesWritten = bytes;
+    }
+#endif
+
+#ifdef RECORDER_OPUS
+    // Largest packet advised by the libopus documentation
+    const int OPUS_MAX_PACKET_SIZE      = 4000;
+
+    // Pages are written once they hold this many bytes, each having a header of 27 bytes and a few more per packet
+    const size_t OGG_PAGE_TARGET        = 4096;
+
+    const uint8_t OGG_FLAG_FIRST        = 0x02;
+    const uint8_t OGG_FLAG_LAST         = 0x04;
+
+    static inline void putLE16(uint8_t* p, uint16_t v) {
+        p[0] = v;
+        p[1] = v >> 8;
+    }
+
+    static inline void putLE32(uint8_t* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) { p[i] = v >> (8 * i); }
+    }
+
+    static inline void putLE64(uint8_t* p, uint64_t v) {
+        for (int i = 0; i < 8; i++) { p[i] = v >> (8 * i); }
+    }
+
+    // CRC of the Ogg pages, polynomial 0x04C11DB7 without reflection nor final inversion
+    static uint32_t oggCRC(uint32_t crc, const uint8_t* data, size_t len) {
+        static const auto table = []() {
+            std::vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t r = i << 24;
+                for (int j = 0; j < 8; j++) { r = (r & 0x80000000) ? ((r << 1) ^ 0x04C11DB7) : (r << 1); }
+                t[i] = r;
+            }
+            return t;
+        }();
+        for (size_t i = 0; i < len; i++) { crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xFF]; }
+        return crc;
+    }
+
+    OpusWriter::OpusWriter(Pool* pool) : Writer(pool) {
+        // Only used for processing
+        monoResamp.init(NULL, 48000.0, 48000.0);
+        stereoResamp.init(NULL, 48000.0, 48000.0);
+    }
+
+    OpusWriter::~OpusWriter() {
+        close();
+    }
+
+    void OpusWriter::setBitrate(int bitrate) {
+        // Do not allow settings to change while open
+        if (isOpen()) { throw std::runtime_error("Cannot change parameters while file is open"); }
+        _bitrate = bitrate;
+    }
+
+    bool OpusWriter::begin() {
+        if (_channels > 2) {
+            flog::error("Opus recordings can only be mono or stereo");
+            return false;
+        }
+
+        // Resample to 48KHz if Opus doesn't accept the samplerate
+        int sr = round(_samplerate);
+        resampling = (sr != 8000 && sr != 12000 && sr != 16000 && sr != 24000 && sr != 48000);
+        opusSamplerate = resampling ? 48000 : sr;
+        if (resampling && _channels == 1) {
+            monoResamp.setRates(_samplerate, opusSamplerate);
+            monoResamp.reset();
+        }
+        else if (resampling) {
+            stereoResamp.setRates(_samplerate, opusSamplerate);
+            stereoResamp.reset();
+        }
+
+        int err;
+        opus = opus_encoder_create(opusSamplerate, _channels, OPUS_APPLICATION_AUDIO, &err);
+        if (err != OPUS_OK) {
+            flog::error("Failed to create Opus encoder: {}", opus_strerror(err));
+            opus = NULL;
+            return false;
+        }
+        opus_encoder_ctl(opus, OPUS_SET_BITRATE(_bitrate));
+
+        // The samples the decoder has to skip are counted at 48KHz whatever the samplerate of the encoder
+        int32_t lookahead = 0;
+        opus_encoder_ctl(opus, OPUS_GET_LOOKAHEAD(&lookahead));
+        preSkip = lookahead * (48000 / opusSamplerate);
+
+        // 20ms frames
+        frameSize = opusSamplerate / 50;
+        frame.resize(frameSize * _channels);
+        frameFill = 0;
+        packet.resize(OPUS_MAX_PACKET_SIZE);
+
+        // Start a new logical stream
+        std::random_device rd;
+        serial = rd();
+        pageSeq = 0;
+        granule = 0;
+        pageGranule = 0;
+        framesIn = 0;
+        pageData.clear();
+        lacing.clear();
+
+        // Identification header, alone in the first page
+        uint8_t head[19];
+        memcpy(head, "OpusHead", 8);
+        head[8] = 1;
+        head[9] = _channels;
+        putLE16(&head[10], preSkip);
+        putLE32(&head[12], sr);
+        putLE16(&head[16], 0);
+        head[18] = 0;
+        if (!writePacket(head, sizeof(head)) || !flushPage()) { return false; }
+
+        // Comment header, with no comment but the vendor string
+        const char* vendor = "SDR++";
+        size_t vendorLen = strlen(vendor);
+        std::vector<uint8_t> tags(16 + vendorLen);
+        memcpy(&tags[0], "OpusTags", 8);
+        putLE32(&tags[8], vendorLen);
+        memcpy(&tags[12], vendor, vendorLen);
+        putLE32(&tags[12 + vendorLen], 0);
+        return writePacket(tags.data(), tags.size()) && flushPage();
+    }
+
+    bool OpusWriter::encode(const float* samples, int count) {
+        if (!resampling) { return encodeFrames(samples, count); }
+
+        // Resampled here rather than on the DSP thread
+        size_t need = ((size_t)ceil(count * opusSamplerate / _samplerate) + 64) * _channels;
+        if (resampBuf.size() < need) { resampBuf.resize(need); }
+        int outCount;
+        if (_channels == 1) {
+            outCount = monoResamp.process(count, samples, resampBuf.data());
+        }
+        else {
+            outCount = stereoResamp.process(count, (const dsp::stereo_t*)samples, (dsp::stereo_t*)resampBuf.data());
+        }
+        return encodeFrames(resampBuf.data(), outCount);
+    }
+
+    bool OpusWriter::end() {
+        // Pad with silence until the encoder's delay is flushed out, the end of the last page marking where the real samples end
+        int64_t last = preSkip + (int64_t)framesIn * (48000 / opusSamplerate);
+        bool ok = true;
+        while (ok && (granule < last || frameFill)) {
+            std::fill(frame.begin() + frameFill * _channels, frame.end(), 0.0f);
+            ok = encodeFrame();
+        }
+        pageGranule = last;
+        ok = ok && flushPage(true);
+
+        opus_encoder_destroy(opus);
+        opus = NULL;
+        return ok;
+    }
+
+    bool OpusWriter::encodeFrames(const float* samples, int count) {
+        framesIn += count;
+        while (count) {
+            int n = std::min<int>(count, frameSize - frameFill);
+            memcpy(&frame[frameFill * _channels], samples, n * _channels * sizeof(float));
+            frameFill += n;
+            samples += n * _channels;
+            count -= n;
+            if (frameFill == frameSize && !encodeFrame()) { return false; }
+        }
+        return true;
+    }
+
+    bool OpusWriter::encodeFrame() {
+        frameFill = 0;
+        int len = opus_encode_float(opus, frame.data(), frameSize, packet.data(), packet.size());
+        if (len < 0) {
+            flog::error("Opus encoding failed: {}", opus_strerror(len));
+            return false;
+        }
+        granule += frameSize * (48000 / opusSamplerate);
+        if (!writePacket(packet.data(), len)) { return false; }
+
+        // The granule position of a page is that of the last packet ending in it
+        pageGranule = granule;
+        return (pageData.size() < OGG_PAGE_TARGET) || flushPage();
+    }
+
+    bool OpusWriter::writePacket(const uint8_t* data, int len) {
+        // A packet takes a lacing value per 255 bytes and one more below 255 to end it, a page holding 255 at most
+        int segments = len / 255 + 1;
+        if (lacing.size() + segments > 255 && !flushPage()) { return false; }
+        for (int i = 0; i < segments - 1; i++) { lacing.push_back(255); }
+        lacing.push_back(len % 255);
+        pageData.insert(pageData.end(), data, data + len);
+        return true;
+    }
+
+    bool OpusWriter::flushPage(bool last) {
+        if (lacing.empty() && !last) { return true; }
+
+        uint8_t hdr[27];
+        memcpy(hdr, "OggS", 4);
+        hdr[4] = 0;
+        hdr[5] = (pageSeq ? 0 : OGG_FLAG_FIRST) | (last ? OGG_FLAG_LAST : 0);
+        putLE64(&hdr[6], pageGranule);
+        putLE32(&hdr[14], serial);
+        putLE32(&hdr[18], pageSeq);
+        putLE32(&hdr[22], 0);
+        hdr[26] = lacing.size();
+
+        // The CRC is computed with its own field zeroed
+        uint32_t crc = oggCRC(0, hdr, sizeof(hdr));
+        crc = oggCRC(crc, lacing.data(), lacing.size());
+        crc = oggCRC(crc, pageData.data(), pageData.size());
+        putLE32(&hdr[22], crc);
+
+        bool ok = fwrite(hdr, sizeof(hdr), 1, file) == 1;
+        ok = ok && (lacing.empty() || fwrite(lacing.data(), lacing.size(), 1, file) == 1);
+        ok = ok && (pageData.empty() || fwrite(pageData.data(), pageData.size(), 1, file) == 1);
+        bytesWritten += sizeof(hdr) + lacing.size() + pageData.size();
+
+        pageSeq++;
+        lacing.clear();
+        pageData.clear();
+        return ok;
+    }
+#endif
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utils/cow_list.h>
+#include <dsp/types.h>
+#include <dsp/multirate/rational_resampler.h>
+
+#ifdef RECORDER_FLAC
+#include <FLAC/stream_encoder.h>
+#endif
+#ifdef RECORDER_OPUS
+#include <opus.h>
+#endif
+
+// Seconds of audio the queue of a writer holds before samples are dropped
+#define ENCODER_QUEUE_SECONDS   5.0
+
+// Seconds of audio queued before the pool is woken up, the pool also looking for work at this interval
+#define ENCODER_WAKE_SECONDS    0.05
+
+// Size of the stdio buffer of the files, so that the disk sees few large writes
+#define ENCODER_FILE_BUFFER     (256 * 1024)
+
+// Compressed audio files. The DSP thread only copies the samples into a lock-free queue of the writer, the encoding
+// and the file writes being done by a pool of threads shared by every writer. A writer is drained by one thread of the
+// pool at a time, so that many recordings are encoded in parallel while each file is written in order
+namespace encoder {
+    class Writer;
+
+    class Pool {
+    public:
+        Pool() {}
+        ~Pool();
+
+        // The threads are started along with the first writer and stopped along with the last
+        void add(Writer* writer);
+
+        // Once removed, the writer is not accessed by the pool anymore
+        void remove(Writer* writer);
+
+        // Signal that a writer has samples to encode, never blocks
+        void notify();
+
+    private:
+        void worker();
+        void stopWorkers();
+
+        CowList<Writer*> writers;
+        int writerCount = 0;
+        std::mutex ctrlMtx;
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::atomic<bool> pending = false;
+        bool stop = false;
+        std::vector<std::thread> workers;
+    };
+
+    class Writer {
+    public:
+        Writer(Pool* pool);
+        virtual ~Writer();
+
+        bool open(std::string path);
+        bool isOpen() { return _open; }
+
+        // Encodes what's left in the queue from the calling thread and finishes the file
+        void close();
+
+        void setChannels(int channels);
+        void setSamplerate(double samplerate);
+
+        // Called from a single thread, copies the samples into the queue and never waits for the encoding
+        void write(const float* samples, int count);
+
+        uint64_t getSamplesWritten() { return samplesWritten; }
+
+        // Number of samples dropped because the encoding could not keep up
+        uint64_t getSamplesDropped() { return samplesDropped; }
+
+        // Number of bytes of encoded data written to disk
+        uint64_t getBytesWritten() { return bytesWritten; }
+
+        // Fraction of the queue waiting to be encoded
+        float getBacklogFill();
+
+    protected:
+        // Called with the file open, before any sample and after the last one
+        virtual bool begin() = 0;
+        virtual bool encode(const float* samples, int count) = 0;
+        virtual bool end() = 0;
+
+        FILE* file = NULL;
+        int _channels = 2;
+        double _samplerate = 48000.0;
+        std::atomic<uint64_t> bytesWritten = 0;
+
+    private:
+        friend Pool;
+
+        // Encode what's in the queue, returns false if there was nothing
+        bool drain();
+
+        Pool* _pool;
+        std::atomic<bool> _open = false;
+        bool failed = false;
+
+        // Single producer single consumer queue of interleaved samples, the positions only growing
+        std::vector<float> queue;
+        std::atomic<uint64_t> writePos = 0;
+        std::atomic<uint64_t> readPos = 0;
+        size_t wakeFill = 0;
+
+        std::atomic<bool> busy = false;
+        std::atomic<uint64_t> samplesWritten = 0;
+        std::atomic<uint64_t> samplesDropped = 0;
+    };
+
+#ifdef RECORDER_FLAC
+    class FLACWriter : public Writer {
+    public:
+        FLACWriter(Pool* pool) : Writer(pool) {}
+        ~FLACWriter();
+
+        // 8, 16 or 24 bits
+        void setBitDepth(int bits);
+
+    protected:
+        bool begin();
+        bool encode(const float* samples, int count);
+        bool end();
+
+    private:
+        static void progressCallback(const FLAC__StreamEncoder* enc, FLAC__uint64 bytes, FLAC__uint64 samples, uint32_t frames, uint32_t totalFrames, void* ctx);
+
+        FLAC__StreamEncoder* flac = NULL;
+        int _bits = 16;
+        std::vector<FLAC__int32> pcm;
+    };
+#endif
+
+#ifdef RECORDER_OPUS
+    // Opus in an Ogg container. Opus only accepts a few samplerates, other ones are resampled to 48KHz
+    class OpusWriter : public Writer {
+    public:
+        OpusWriter(Pool* pool);
+        ~OpusWriter();
+
+        void setBitrate(int bitrate);
+
+    protected:
+        bool begin();
+        bool encode(const float* samples, int count);
+        bool end();
+
+    private:
+        bool encodeFrames(const float* samples, int count);
+        bool encodeFrame();
+        bool writePacket(const uint8_t* data, int len);
+        bool flushPage(bool last = false);
+
+        OpusEncoder* opus = NULL;
+        int _bitrate = 64000;
+        int opusSamplerate;
+        int frameSize;
+        bool resampling = false;
+        dsp::multirate::RationalResampler<float> monoResamp;
+        dsp::multirate::RationalResampler<dsp::stereo_t> stereoResamp;
+        std::vector<float> resampBuf;
+
+        // Frame being filled and the last encoded packet
+        std::vector<float> frame;
+        int frameFill = 0;
+        std::vector<uint8_t> packet;
+
+        // Ogg page being filled, granule positions are always counted at 48KHz
+        std::vector<uint8_t> pageData;
+        std::vector<uint8_t> lacing;
+        uint32_t serial;
+        uint32_t pageSeq = 0;
+        int64_t granule = 0;
+        int64_t pageGranule = 0;
+        uint64_t framesIn = 0;
+        int preSkip = 0;
+    };
+#endif
+}
@@ -2,11 +2,12 @@
 #include <module.h>
 #include <dsp/types.h>
 #include <dsp/stream.h>
-#include <dsp/bench/peak_level_meter.h>
+#include <dsp/sink/level_meter.h>
 #include <dsp/sink/handler_sink.h>
 #include <dsp/routing/splitter.h>
 #include <dsp/audio/volume.h>
 #include <dsp/convert/stereo_to_mono.h>
+#include <dsp/channel/rx_vfo.h>
 #include <thread>
 #include <ctime>
 #include <gui/gui.h>
@@ -16,17 +17,32 @@
 #include <gui/style.h>
 #include <gui/widgets/volume_meter.h>
 #include <regex>
+#include <set>
+#include <memory>
 #include <gui/widgets/folder_select.h>
 #include <recorder_interface.h>
+#include "time_shift.h"
+#include "encoder.h"
 #include <core.h>
+#include <metrics.h>
 #include <utils/optionlist.h>
 #include <utils/wav.h>
+#include <utils/ziq.h>
 #include <radio_interface.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
 #define SILENCE_LVL 10e-6
 
+// Smallest backlog of each writer of a multi-stream recording, the writers sharing one thread
+#define RECORDER_MULTI_MIN_BACKLOG  (16 * 1024 * 1024)
+
+// Seconds the squelch has to stay closed before a segment is closed, shorter gaps being kept in the same file
+#define RECORDER_SEGMENT_HANG       2.0
+
+// Entries of the audio level history per second, the meters and the metrics combining those published since they last looked
+#define RECORDER_METER_RATE         100
+
 SDRPP_MOD_INFO{
     /* Name:            */ "recorder",
     /* Description:     */ "Recorder module for SDR++",
@@ -37,6 +53,17 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
+// Encodes the FLAC and Opus recordings of every instance
+encoder::Pool encoderPool;
+
+enum Container {
+    CONTAINER_WAV,
+    CONTAINER_RF64,
+    CONTAINER_ZIQ,
+    CONTAINER_FLAC,
+    CONTAINER_OPUS
+};
+
 class RecorderModule : public ModuleManager::Instance {
 public:
     RecorderModule(std::string name) : folderSelect("%ROOT%/recordings") {
@@ -45,16 +72,40 @@ public:
         strcpy(nameTemplate, "$t_$f_$h-$m-$s_$d-$M-$y");
 
         // Define option lists
-        containers.define("WAV", wav::FORMAT_WAV);
-        // containers.define("RF64", wav::FORMAT_RF64); // Disabled for now
+        containers.define("WAV", CONTAINER_WAV);
+        containers.define("RF64", CONTAINER_RF64);
+        containers.define("ZIQ", "Compressed IQ", CONTAINER_ZIQ);
+#ifdef RECORDER_FLAC
+        containers.define("FLAC", CONTAINER_FLAC);
+#endif
+#ifdef RECORDER_OPUS
+        containers.define("Opus", CONTAINER_OPUS);
+#endif
         sampleTypes.define(wav::SAMP_TYPE_UINT8, "Uint8", wav::SAMP_TYPE_UINT8);
         sampleTypes.define(wav::SAMP_TYPE_INT16, "Int16", wav::SAMP_TYPE_INT16);
         sampleTypes.define(wav::SAMP_TYPE_INT32, "Int32", wav::SAMP_TYPE_INT32);
         sampleTypes.define(wav::SAMP_TYPE_FLOAT32, "Float32", wav::SAMP_TYPE_FLOAT32);
+        backlogs.define(0, "None", 0);
+        backlogs.define(32, "32MB", 32);
+        backlogs.define(128, "128MB", 128);
+        backlogs.define(512, "512MB", 512);
+        backlogs.define(2048, "2GB", 2048);
+        preallocs.define(0, "None", 0);
+        preallocs.define(64, "64MB", 64);
+        preallocs.define(256, "256MB", 256);
+        preallocs.define(1024, "1GB", 1024);
+        bitrates.define(24000, "24 kbps", 24000);
+        bitrates.define(32000, "32 kbps", 32000);
+        bitrates.define(64000, "64 kbps", 64000);
+        bitrates.define(96000, "96 kbps", 96000);
+        bitrates.define(128000, "128 kbps", 128000);
 
         // Load default config for option lists
-        containerId = containers.valueId(wav::FORMAT_WAV);
+        containerId = containers.valueId(CONTAINER_WAV);
         sampleTypeId = sampleTypes.valueId(wav::SAMP_TYPE_INT16);
+        backlogId = backlogs.valueId(128);
+        preallocId = preallocs.valueId(0);
+        bitrateId = bitrates.valueId(64000);
 
         // Load config
         config.acquire();
@@ -70,6 +121,24 @@ public:
         if (config.conf[name].contains("sampleType") && sampleTypes.keyExists(config.conf[name]["sampleType"])) {
             sampleTypeId = sampleTypes.keyId(config.conf[name]["sampleType"]);
         }
+        if (config.conf[name].contains("backlog") && backlogs.keyExists(config.conf[name]["backlog"])) {
+            backlogId = backlogs.keyId(config.conf[name]["backlog"]);
+        }
+        if (config.conf[name].contains("preallocation") && preallocs.keyExists(config.conf[name]["preallocation"])) {
+            preallocId = preallocs.keyId(config.conf[name]["preallocation"]);
+        }
+        if (config.conf[name].contains("opusBitrate") && bitrates.keyExists(config.conf[name]["opusBitrate"])) {
+            bitrateId = bitrates.keyId(config.conf[name]["opusBitrate"]);
+        }
+        if (config.conf[name].contains("multiStreams")) {
+            for (const auto& s : config.conf[name]["multiStreams"]) { multiStreams.insert((std::string)s); }
+        }
+        if (config.conf[name].contains("multiVfos")) {
+            for (const auto& v : config.conf[name]["multiVfos"]) { multiVfos.insert((std::string)v); }
+        }
+        if (config.conf[name].contains("preRecord")) {
+            preRecord = std::clamp<int>(config.conf[name]["preRecord"], 0, 3600);
+        }
         if (config.conf[name].contains("audioStream")) {
             selectedStreamName = config.conf[name]["audioStream"];
         }
@@ -82,6 +151,9 @@ public:
         if (config.conf[name].contains("ignoreSilence")) {
             ignoreSilence = config.conf[name]["ignoreSilence"];
         }
+        if (config.conf[name].contains("squelchSegments")) {
+            squelchSegments = config.conf[name]["squelchSegments"];
+        }
         if (config.conf[name].contains("nameTemplate")) {
             std::string _nameTemplate = config.conf[name]["nameTemplate"];
             if (_nameTemplate.length() > sizeof(nameTemplate)-1) {
@@ -95,23 +167,29 @@ public:
         volume.init(NULL, audioVolume, false);
         splitter.init(&volume.out);
         splitter.bindStream(&meterStream);
-        meter.init(&meterStream);
+        meter.init(&meterStream, 48000 / RECORDER_METER_RATE);
         s2m.init(&stereoStream);
 
         // Init sinks
         basebandSink.init(NULL, complexHandler, this);
         stereoSink.init(&stereoStream, stereoHandler, this);
         monoSink.init(&s2m.out, monoHandler, this);
+        squelchHandler.handler = squelchChangeHandler;
+        squelchHandler.ctx = this;
 
         gui::menu.registerEntry(name, menuHandler, this);
         core::modComManager.registerInterface("recorder", name, moduleInterfaceHandler, this);
+        metrics::registerCollector("recorder/" + name, collectMetrics, this);
     }
 
     ~RecorderModule() {
+        // The collector takes the lock
+        metrics::unregisterCollector("recorder/" + name);
         std::lock_guard<std::recursive_mutex> lck(recMtx);
         core::modComManager.unregisterInterface(name);
         gui::menu.removeEntry(name);
         stop();
+        disarm();
         deselectStream();
         sigpath::sinkManager.onStreamRegistered.unbindHandler(&onStreamRegisteredHandler);
         sigpath::sinkManager.onStreamUnregister.unbindHandler(&onStreamUnregisterHandler);
@@ -136,6 +214,9 @@ public:
 
         // Select the stream
         selectStream(selectedStreamName);
+
+        // Start filling the pre-record buffer
+        arm();
     }
 
     void enable() {
@@ -154,28 +235,244 @@ public:
         std::lock_guard<std::recursive_mutex> lck(recMtx);
         if (recording) { return; }
 
-        // Configure the wav writer
+        // The file was already opened and the input started by prepare()
+        if (prepared) {
+            if (armed) {
+                timeShift.startDrain([=](float* data, int count) { output(data, count); });
+            }
+            prepared = false;
+            recording = true;
+            return;
+        }
+
+        // Multi-stream recordings have a writer per stream
+        if (recMode == RECORDER_MODE_MULTI) {
+            recording = startMulti();
+            return;
+        }
+
+        if (!configureWriter()) { return; }
+
+        // Squelch-gated recordings open a file per transmission from the audio thread
+        if (recMode == RECORDER_MODE_AUDIO && squelchSegments) {
+            recording = startSegmented();
+            return;
+        }
+
+        if (!openFile()) { return; }
+
+        // Write out the pre-record buffer followed by the live samples, or open audio stream or baseband
+        if (armed) {
+            timeShift.startDrain([=](float* data, int count) { output(data, count); });
+        }
+        else {
+            startInput();
+        }
+
+        recording = true;
+    }
+
+    // Open the file and start the input ahead of a start so that it begins writing right away, the samples being
+    // discarded until then. Multi-stream and squelch-gated recordings open their files later and can't be prepared
+    void prepare() {
+        std::lock_guard<std::recursive_mutex> lck(recMtx);
+        if (recording || prepared || recMode == RECORDER_MODE_MULTI) { return; }
+        if (recMode == RECORDER_MODE_AUDIO && squelchSegments) { return; }
+        if (!configureWriter() || !openFile()) { return; }
+        if (!armed) { startInput(); }
+        prepared = true;
+    }
+
+    // Close and delete the file of a prepared start that didn't happen
+    void unprepare() {
+        std::lock_guard<std::recursive_mutex> lck(recMtx);
+        if (!prepared) { return; }
+        if (!armed) { stopInput(); }
+        prepared = false;
+        closeFile();
+        std::error_code ec;
+        std::filesystem::remove(preparedPath, ec);
+    }
+
+    void stop() {
+        std::lock_guard<std::recursive_mutex> lck(recMtx);
+        if (!recording) { return; }
+
+        if (recMode == RECORDER_MODE_MULTI) {
+            stopMulti();
+            recording = false;
+            return;
+        }
+
+        if (segmented) {
+            stopSegmented();
+            recording = false;
+            return;
+        }
+
+        // Keep filling the pre-record buffer, or close audio stream or baseband
+        if (armed) {
+            timeShift.stopDrain();
+        }
+        else {
+            stopInput();
+        }
+
+        // Close file
+        closeFile();
+        
+        recording = false;
+    }
+
+    // Start capturing into the pre-record buffer if enabled
+    void arm() {
+        std::lock_guard<std::recursive_mutex> lck(recMtx);
+        if (armed || recording || !preRecord || recMode == RECORDER_MODE_MULTI) { return; }
+        if (recMode == RECORDER_MODE_AUDIO && squelchSegments) { return; }
+
+        // Size the buffer for the current stream
+        double sr;
         if (recMode == RECORDER_MODE_AUDIO) {
             if (selectedStreamName.empty()) { return; }
+            sr = sigpath::sinkManager.getStreamSampleRate(selectedStreamName);
+        }
+        else {
+            sr = sigpath::iqFrontEnd.getSampleRate();
+        }
+        int channels = (recMode == RECORDER_MODE_AUDIO && !stereo) ? 1 : 2;
+        std::string path = root + "/recorder_" + name + ".tsbuf";
+        if (!timeShift.open(path, preRecord * sr, channels, sr)) {
+            flog::error("Could not create the pre-record buffer: {0}", path);
+            return;
+        }
+
+        startInput();
+        armed = true;
+    }
+
+    void disarm() {
+        std::lock_guard<std::recursive_mutex> lck(recMtx);
+        unprepare();
+        if (!armed) { return; }
+        if (recording) { stop(); }
+        stopInput();
+        timeShift.close();
+        armed = false;
+    }
+
+private:
+    // Apply the recording settings to the writer
+    bool configureWriter() {
+        if (recMode == RECORDER_MODE_AUDIO) {
+            if (selectedStreamName.empty()) { return false; }
             samplerate = sigpath::sinkManager.getStreamSampleRate(selectedStreamName);
         }
         else {
             samplerate = sigpath::iqFrontEnd.getSampleRate();
         }
-        writer.setFormat(containers[containerId]);
-        writer.setChannels((recMode == RECORDER_MODE_AUDIO && !stereo) ? 1 : 2);
+        compressed = (containers[containerId] == CONTAINER_ZIQ);
+        if (compressed && recMode == RECORDER_MODE_AUDIO) {
+            flog::error("Compressed IQ recordings are only available for baseband");
+            return false;
+        }
+        int channels = (recMode == RECORDER_MODE_AUDIO && !stereo) ? 1 : 2;
+
+        // FLAC and Opus recordings go through an encoder instead of the WAV writer
+        encoder.reset();
+        if (isEncoded()) {
+            if (recMode != RECORDER_MODE_AUDIO) {
+                flog::error("FLAC and Opus recordings are only available for audio");
+                return false;
+            }
+            encoder = createEncoder(channels, samplerate);
+            return true;
+        }
+
+        writer.setFormat((containers[containerId] == CONTAINER_RF64) ? wav::FORMAT_RF64 : wav::FORMAT_WAV);
+        writer.setChannels(channels);
         writer.setSampleType(sampleTypes[sampleTypeId]);
         writer.setSamplerate(samplerate);
+        writer.setBacklog((size_t)backlogs[backlogId] * 1024 * 1024);
+        writer.setPreallocation((size_t)preallocs[preallocId] * 1024 * 1024);
+        return true;
+    }
+
+    bool openFile() {
+        // The pre-record buffer can only be used if it holds the same kind of samples
+        int channels = (recMode == RECORDER_MODE_AUDIO && !stereo) ? 1 : 2;
+        if (armed && (timeShift.getSamplerate() != samplerate || timeShift.getChannels() != channels)) {
+            disarm();
+            arm();
+        }
 
-        // Open file
         std::string vfoName = (recMode == RECORDER_MODE_AUDIO) ? selectedStreamName : "";
-        std::string extension = ".wav";
-        std::string expandedPath = expandString(folderSelect.path + "/" + genFileName(nameTemplate, recMode, vfoName) + extension);
-        if (!writer.open(expandedPath)) {
+        std::string expandedPath = expandString(folderSelect.path + "/" + genFileName(nameTemplate, recMode, vfoName) + extension());
+        bool opened;
+        if (encoder) {
+            opened = encoder->open(expandedPath);
+        }
+        else if (compressed) {
+            opened = ziqWriter.open(expandedPath, samplerate, gui::waterfall.getCenterFrequency(), (double)time(NULL) - (armed ? timeShift.getFill() : 0.0), compressedType(sampleTypes[sampleTypeId]));
+        }
+        else {
+            opened = writer.open(expandedPath);
+        }
+        if (!opened) {
             flog::error("Failed to open file for recording: {0}", expandedPath);
-            return;
+            return false;
+        }
+        preparedPath = expandedPath;
+        return true;
+    }
+
+    void closeFile() {
+        writer.close();
+        ziqWriter.close();
+        if (encoder) { encoder->close(); }
+    }
+
+    bool isEncoded() {
+        return containers[containerId] == CONTAINER_FLAC || containers[containerId] == CONTAINER_OPUS;
+    }
+
+    std::string extension() {
+        switch (containers[containerId]) {
+        case CONTAINER_ZIQ:
+            return ".ziq";
+        case CONTAINER_FLAC:
+            return ".flac";
+        case CONTAINER_OPUS:
+            return ".opus";
+        default:
+            return ".wav";
+        }
+    }
+
+    // Encoder of the selected container, FLAC storing the samples with the depth of the selected sample type
+    std::unique_ptr<encoder::Writer> createEncoder(int channels, double samplerate) {
+        std::unique_ptr<encoder::Writer> enc;
+#ifdef RECORDER_FLAC
+        if (containers[containerId] == CONTAINER_FLAC) {
+            auto flac = std::make_unique<encoder::FLACWriter>(&encoderPool);
+            wav::SampleType type = sampleTypes[sampleTypeId];
+            flac->setBitDepth((type == wav::SAMP_TYPE_UINT8) ? 8 : ((type == wav::SAMP_TYPE_INT16) ? 16 : 24));
+            enc = std::move(flac);
         }
+#endif
+#ifdef RECORDER_OPUS
+        if (containers[containerId] == CONTAINER_OPUS) {
+            auto opus = std::make_unique<encoder::OpusWriter>(&encoderPool);
+            opus->setBitrate(bitrates[bitrateId]);
+            enc = std::move(opus);
+        }
+#endif
+        if (!enc) { return NULL; }
+        enc->setChannels(channels);
+        enc->setSamplerate(samplerate);
+        return enc;
+    }
 
+    void startInput() {
         // Open audio stream or baseband
         if (recMode == RECORDER_MODE_AUDIO) {
             // Start correct path depending on 
@@ -195,21 +492,15 @@ public:
             basebandSink.start();
             sigpath::iqFrontEnd.bindIQStream(basebandStream);
         }
-
-        recording = true;
     }
 
-    void stop() {
-        std::lock_guard<std::recursive_mutex> lck(recMtx);
-        if (!recording) { return; }
-
+    void stopInput() {
         // Close audio stream or baseband
         if (recMode == RECORDER_MODE_AUDIO) {
             splitter.unbindStream(&stereoStream);
             monoSink.stop();
             stereoSink.stop();
             s2m.stop();
-            
         }
         else {
             // Unbind and destroy IQ stream
@@ -217,14 +508,231 @@ public:
             basebandSink.stop();
             delete basebandStream;
         }
+    }
 
-        // Close file
-        writer.close();
-        
-        recording = false;
+    void rearm() {
+        disarm();
+        arm();
+    }
+
+    void setMode(int mode) {
+        // The pre-record buffer has to be stopped with the input it was started for
+        disarm();
+        recMode = mode;
+        arm();
+    }
+
+    bool startMulti() {
+        if (containers[containerId] == CONTAINER_ZIQ) {
+            flog::error("Compressed IQ recordings are only available for baseband");
+            return false;
+        }
+
+        // All files share one thread to access the disk, each writer needs a backlog for it
+        writeQueue = std::make_unique<wav::WriteQueue>();
+        size_t backlog = std::max<size_t>((size_t)backlogs[backlogId] * 1024 * 1024, RECORDER_MULTI_MIN_BACKLOG);
+        auto openTrack = [&](Track* track, int mode) {
+            // Audio can be encoded, IQ always being stored as WAV
+            bool encoded = isEncoded() && !track->iq;
+            if (encoded) {
+                track->encoder = createEncoder(2, track->samplerate);
+            }
+            else {
+                track->writer.setFormat((containers[containerId] == CONTAINER_RF64) ? wav::FORMAT_RF64 : wav::FORMAT_WAV);
+                track->writer.setChannels(2);
+                track->writer.setSampleType(sampleTypes[sampleTypeId]);
+                track->writer.setSamplerate(track->samplerate);
+                track->writer.setBacklog(backlog);
+                track->writer.setPreallocation((size_t)preallocs[preallocId] * 1024 * 1024);
+                track->writer.setWriteQueue(writeQueue.get());
+            }
+            std::string path = expandString(folderSelect.path + "/" + genFileName(nameTemplate, mode, track->name) + (encoded ? extension() : ".wav"));
+            if (!(encoded ? track->encoder->open(path) : track->writer.open(path))) {
+                flog::error("Failed to open file for recording: {0}", path);
+                return false;
+            }
+            return true;
+        };
+
+        // Audio streams
+        for (const auto& name : multiStreams) {
+            if (!audioStreams.keyExists(name)) { continue; }
+            auto track = std::make_unique<Track>();
+            track->name = name;
+            track->samplerate = sigpath::sinkManager.getStreamSampleRate(name);
+            if (!openTrack(track.get(), RECORDER_MODE_AUDIO)) { continue; }
+            track->audio = sigpath::sinkManager.bindStream(name);
+            if (!track->audio) { continue; }
+            track->audioSink.init(track->audio, multiAudioHandler, track.get());
+            track->audioSink.start();
+            tracks.push_back(std::move(track));
+        }
+
+        // IQ of VFOs, extracted from the baseband by a VFO of our own
+        for (const auto& name : multiVfos) {
+            if (gui::waterfall.vfos.find(name) == gui::waterfall.vfos.end()) { continue; }
+            auto track = std::make_unique<Track>();
+            track->name = name;
+            track->iq = true;
+            track->samplerate = sigpath::vfoManager.getBandwidth(name);
+            track->offset = gui::waterfall.vfos[name]->centerOffset;
+            if (track->samplerate <= 0 || !openTrack(track.get(), RECORDER_MODE_BASEBAND)) { continue; }
+            track->baseband = new dsp::stream<dsp::complex_t>();
+            track->vfo.init(track->baseband, sigpath::iqFrontEnd.getSampleRate(), track->samplerate, track->samplerate, track->offset);
+            track->iqSink.init(&track->vfo.out, multiIQHandler, track.get());
+            track->vfo.start();
+            track->iqSink.start();
+            sigpath::iqFrontEnd.bindIQStream(track->baseband);
+            tracks.push_back(std::move(track));
+        }
+
+        if (tracks.empty()) {
+            flog::error("No stream to record");
+            writeQueue.reset();
+            return false;
+        }
+        return true;
+    }
+
+    bool startSegmented() {
+        // Without the pre-record buffer, the audio sink is only started while recording
+        disarm();
+
+        // Follow the squelch of the radio the stream comes from, streams of other modules being recorded whole
+        squelchOpen = true;
+        squelchRadio.clear();
+        if (core::modComManager.getModuleName(selectedStreamName) == "radio") {
+            squelchRadio = selectedStreamName;
+            bool open = true;
+            core::modComManager.callInterface(squelchRadio, RADIO_IFACE_CMD_BIND_SQUELCH_HANDLER, &squelchHandler, NULL);
+            core::modComManager.callInterface(squelchRadio, RADIO_IFACE_CMD_GET_SQUELCH_OPEN, NULL, &open);
+            squelchOpen = open;
+        }
+        else {
+            flog::warn("Stream '{0}' has no squelch, recording it as a single segment", selectedStreamName);
+        }
+
+        segmentOpen = false;
+        segmentCount = 0;
+        closedFrames = 0;
+        segmented = true;
+        startInput();
+        return true;
+    }
+
+    void stopSegmented() {
+        // The radio may already be gone along with its stream
+        if (!squelchRadio.empty() && core::modComManager.interfaceExists(squelchRadio)) {
+            core::modComManager.callInterface(squelchRadio, RADIO_IFACE_CMD_UNBIND_SQUELCH_HANDLER, &squelchHandler, NULL);
+        }
+        stopInput();
+        if (segmentOpen) { closeFile(); }
+        segmentOpen = false;
+        segmented = false;
+    }
+
+    // Runs in the audio thread before any processing of the samples, returns false if they are not to be written
+    bool segmentGate(int count) {
+        if (squelchOpen) {
+            closedFrames = 0;
+            if (segmentOpen) { return true; }
+            std::string path = expandString(folderSelect.path + "/" + genFileName(nameTemplate, RECORDER_MODE_AUDIO, selectedStreamName) + extension());
+            if (!(encoder ? encoder->open(path) : writer.open(path))) {
+                flog::error("Failed to open file for recording: {0}", path);
+                return false;
+            }
+            segmentOpen = true;
+            segmentCount++;
+            return true;
+        }
+
+        // Close the segment once the squelch stayed closed long enough
+        if (segmentOpen) {
+            closedFrames += count;
+            if (closedFrames >= samplerate * RECORDER_SEGMENT_HANG) {
+                closeFile();
+                segmentOpen = false;
+            }
+        }
+        return false;
+    }
+
+    static void squelchChangeHandler(bool open, void* ctx) {
+        RecorderModule* _this = (RecorderModule*)ctx;
+        _this->squelchOpen = open;
+    }
+
+    void stopMulti() {
+        while (!tracks.empty()) { stopTrack(tracks.back()->name, tracks.back()->iq); }
+        writeQueue.reset();
+    }
+
+    void stopTrack(const std::string& name, bool iq) {
+        auto it = std::find_if(tracks.begin(), tracks.end(), [&](const std::unique_ptr<Track>& t) { return t->name == name && t->iq == iq; });
+        if (it == tracks.end()) { return; }
+        Track* track = it->get();
+        if (track->iq) {
+            sigpath::iqFrontEnd.unbindIQStream(track->baseband);
+            track->vfo.stop();
+            track->iqSink.stop();
+            delete track->baseband;
+        }
+        else {
+            track->audioSink.stop();
+            sigpath::sinkManager.unbindStream(track->name, track->audio);
+        }
+        track->writer.close();
+        if (track->encoder) { track->encoder->close(); }
+        tracks.erase(it);
+    }
+
+    // Make the IQ recordings follow their VFO
+    void updateTracks() {
+        for (auto& track : tracks) {
+            if (!track->iq || gui::waterfall.vfos.find(track->name) == gui::waterfall.vfos.end()) { continue; }
+            double offset = gui::waterfall.vfos[track->name]->centerOffset;
+            if (offset == track->offset) { continue; }
+            track->offset = offset;
+            track->vfo.setOffset(offset);
+        }
+    }
+
+    static void multiAudioHandler(dsp::stereo_t* data, int count, void* ctx) {
+        Track* track = (Track*)ctx;
+        if (track->encoder) {
+            track->encoder->write((float*)data, count);
+            return;
+        }
+        track->writer.write((float*)data, count);
+    }
+
+    static void multiIQHandler(dsp::complex_t* data, int count, void* ctx) {
+        Track* track = (Track*)ctx;
+        track->writer.write((float*)data, count);
+    }
+
+    void saveMultiConfig() {
+        config.acquire();
+        config.conf[name]["multiStreams"] = json::array();
+        for (const auto& s : multiStreams) { config.conf[name]["multiStreams"].push_back(s); }
+        config.conf[name]["multiVfos"] = json::array();
+        for (const auto& v : multiVfos) { config.conf[name]["multiVfos"].push_back(v); }
+        config.release(true);
+    }
+
+    // Checkbox toggling the membership of a name in a set
+    bool setCheckbox(const char* label, std::set<std::string>& set, const std::string& name) {
+        bool checked = set.count(name);
+        if (!ImGui::Checkbox(label, &checked)) { return false; }
+        if (checked) {
+            set.insert(name);
+        }
+        else {
+            set.erase(name);
+        }
+        return true;
     }
 
-private:
     static void menuHandler(void* ctx) {
         RecorderModule* _this = (RecorderModule*)ctx;
         float menuWidth = ImGui::GetContentRegionAvail().x;
@@ -232,16 +740,23 @@ private:
         // Recording mode
         if (_this->recording) { style::beginDisabled(); }
         ImGui::BeginGroup();
-        ImGui::Columns(2, CONCAT("RecorderModeColumns##_", _this->name), false);
+        ImGui::Columns(3, CONCAT("RecorderModeColumns##_", _this->name), false);
         if (ImGui::RadioButton(CONCAT("Baseband##_recorder_mode_", _this->name), _this->recMode == RECORDER_MODE_BASEBAND)) {
-            _this->recMode = RECORDER_MODE_BASEBAND;
+            _this->setMode(RECORDER_MODE_BASEBAND);
             config.acquire();
             config.conf[_this->name]["mode"] = _this->recMode;
             config.release(true);
         }
         ImGui::NextColumn();
         if (ImGui::RadioButton(CONCAT("Audio##_recorder_mode_", _this->name), _this->recMode == RECORDER_MODE_AUDIO)) {
-            _this->recMode = RECORDER_MODE_AUDIO;
+            _this->setMode(RECORDER_MODE_AUDIO);
+            config.acquire();
+            config.conf[_this->name]["mode"] = _this->recMode;
+            config.release(true);
+        }
+        ImGui::NextColumn();
+        if (ImGui::RadioButton(CONCAT("Multi##_recorder_mode_", _this->name), _this->recMode == RECORDER_MODE_MULTI)) {
+            _this->setMode(RECORDER_MODE_MULTI);
             config.acquire();
             config.conf[_this->name]["mode"] = _this->recMode;
             config.release(true);
@@ -274,16 +789,72 @@ private:
             config.release(true);
         }
 
-        ImGui::LeftLabel("Sample type");
+        // Opus has a bitrate instead of a sample type
+        if (_this->containers[_this->containerId] == CONTAINER_OPUS) {
+            ImGui::LeftLabel("Bitrate");
+            ImGui::FillWidth();
+            if (ImGui::Combo(CONCAT("##_recorder_bitrate_", _this->name), &_this->bitrateId, _this->bitrates.txt)) {
+                config.acquire();
+                config.conf[_this->name]["opusBitrate"] = _this->bitrates.key(_this->bitrateId);
+                config.release(true);
+            }
+        }
+        else {
+            ImGui::LeftLabel("Sample type");
+            ImGui::FillWidth();
+            if (ImGui::Combo(CONCAT("##_recorder_st_", _this->name), &_this->sampleTypeId, _this->sampleTypes.txt)) {
+                config.acquire();
+                config.conf[_this->name]["sampleType"] = _this->sampleTypes.key(_this->sampleTypeId);
+                config.release(true);
+            }
+        }
+
+        ImGui::LeftLabel("Write buffer");
         ImGui::FillWidth();
-        if (ImGui::Combo(CONCAT("##_recorder_st_", _this->name), &_this->sampleTypeId, _this->sampleTypes.txt)) {
+        if (ImGui::Combo(CONCAT("##_recorder_backlog_", _this->name), &_this->backlogId, _this->backlogs.txt)) {
             config.acquire();
-            config.conf[_this->name]["sampleType"] = _this->sampleTypes.key(_this->sampleTypeId);
+            config.conf[_this->name]["backlog"] = _this->backlogs.key(_this->backlogId);
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("Preallocation");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##_recorder_prealloc_", _this->name), &_this->preallocId, _this->preallocs.txt)) {
+            config.acquire();
+            config.conf[_this->name]["preallocation"] = _this->preallocs.key(_this->preallocId);
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("Pre-record (s)");
+        ImGui::FillWidth();
+        if (ImGui::InputInt(CONCAT("##_recorder_prerec_", _this->name), &_this->preRecord, 1, 10)) {
+            _this->preRecord = std::clamp<int>(_this->preRecord, 0, 3600);
+            _this->rearm();
+            config.acquire();
+            config.conf[_this->name]["preRecord"] = _this->preRecord;
             config.release(true);
         }
 
         if (_this->recording) { style::endDisabled(); }
 
+        // Select the streams of multi-stream recordings
+        if (_this->recMode == RECORDER_MODE_MULTI) {
+            if (_this->recording) { style::beginDisabled(); }
+            for (int i = 0; i < _this->audioStreams.size(); i++) {
+                std::string sname = _this->audioStreams.key(i);
+                if (_this->setCheckbox(CONCAT(sname + " audio##_recorder_multi_a_", _this->name + sname), _this->multiStreams, sname)) {
+                    _this->saveMultiConfig();
+                }
+            }
+            for (const auto& [vname, vfo] : gui::waterfall.vfos) {
+                if (_this->setCheckbox(CONCAT(vname + " IQ##_recorder_multi_v_", _this->name + vname), _this->multiVfos, vname)) {
+                    _this->saveMultiConfig();
+                }
+            }
+            if (_this->recording) { style::endDisabled(); }
+            if (_this->recording) { _this->updateTracks(); }
+        }
+
         // Show additional audio options
         if (_this->recMode == RECORDER_MODE_AUDIO) {
             if (_this->recording) { style::beginDisabled(); }
@@ -297,11 +868,11 @@ private:
             }
             if (_this->recording) { style::endDisabled(); }
 
-            _this->updateAudioMeter(_this->audioLvl);
+            _this->updateAudioMeter();
             ImGui::FillWidth();
-            ImGui::VolumeMeter(_this->audioLvl.l, _this->audioLvl.l, -60, 10);
+            ImGui::VolumeMeter(_this->audioRms.l, _this->audioPeak.l, -60, 10);
             ImGui::FillWidth();
-            ImGui::VolumeMeter(_this->audioLvl.r, _this->audioLvl.r, -60, 10);
+            ImGui::VolumeMeter(_this->audioRms.r, _this->audioPeak.r, -60, 10);
 
             ImGui::FillWidth();
             if (ImGui::SliderFloat(CONCAT("##_recorder_vol_", _this->name), &_this->audioVolume, 0, 1, "")) {
@@ -316,6 +887,7 @@ private:
                 config.acquire();
                 config.conf[_this->name]["stereo"] = _this->stereo;
                 config.release(true);
+                _this->rearm();
             }
             if (_this->recording) { style::endDisabled(); }
 
@@ -324,6 +896,15 @@ private:
                 config.conf[_this->name]["ignoreSilence"] = _this->ignoreSilence;
                 config.release(true);
             }
+
+            if (_this->recording) { style::beginDisabled(); }
+            if (ImGui::Checkbox(CONCAT("Segment on squelch##_recorder_squelch_seg_", _this->name), &_this->squelchSegments)) {
+                config.acquire();
+                config.conf[_this->name]["squelchSegments"] = _this->squelchSegments;
+                config.release(true);
+                _this->rearm();
+            }
+            if (_this->recording) { style::endDisabled(); }
         }
 
         // Record button
@@ -333,22 +914,77 @@ private:
             if (ImGui::Button(CONCAT("Record##_recorder_rec_", _this->name), ImVec2(menuWidth, 0))) {
                 _this->start();
             }
-            ImGui::TextColored(ImGui::GetStyleColorVec4(ImGuiCol_Text), "Idle --:--:--");
+            if (_this->armed) {
+                int buffered = _this->timeShift.getFill();
+                ImGui::TextColored(ImGui::GetStyleColorVec4(ImGuiCol_Text), "Idle, %d/%ds buffered", buffered, _this->preRecord);
+            }
+            else {
+                ImGui::TextColored(ImGui::GetStyleColorVec4(ImGuiCol_Text), "Idle --:--:--");
+            }
         }
         else {
             if (ImGui::Button(CONCAT("Stop##_recorder_rec_", _this->name), ImVec2(menuWidth, 0))) {
                 _this->stop();
             }
-            uint64_t seconds = _this->writer.getSamplesWritten() / _this->samplerate;
+            uint64_t seconds;
+            if (_this->recMode == RECORDER_MODE_MULTI) {
+                if (_this->tracks.empty()) {
+                    seconds = 0;
+                }
+                else {
+                    Track* track = _this->tracks[0].get();
+                    seconds = (track->encoder ? track->encoder->getSamplesWritten() : track->writer.getSamplesWritten()) / track->samplerate;
+                }
+            }
+            else if (_this->encoder) {
+                seconds = _this->encoder->getSamplesWritten() / _this->samplerate;
+            }
+            else {
+                seconds = (_this->compressed ? _this->ziqWriter.getSamplesWritten() : _this->writer.getSamplesWritten()) / _this->samplerate;
+            }
             time_t diff = seconds;
             tm* dtm = gmtime(&diff);
 
-            if (_this->ignoreSilence && _this->ignoringSilence) {
+            if (_this->segmented) {
+                if (_this->segmentOpen) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Segment %d %02d:%02d:%02d", _this->segmentCount, dtm->tm_hour, dtm->tm_min, dtm->tm_sec);
+                }
+                else {
+                    ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Waiting for squelch, %d segments", _this->segmentCount);
+                }
+            }
+            else if (_this->ignoreSilence && _this->ignoringSilence) {
                 ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Paused %02d:%02d:%02d", dtm->tm_hour, dtm->tm_min, dtm->tm_sec);
             }
             else {
                 ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Recording %02d:%02d:%02d", dtm->tm_hour, dtm->tm_min, dtm->tm_sec);
             }
+
+            // Show how much of the queue of the encoder is waiting to be encoded
+            if (_this->encoder) {
+                size_t dropped = _this->encoder->getSamplesDropped();
+                std::string overlay = dropped ? "Dropped " + std::to_string(dropped) : "";
+                ImGui::LeftLabel("Encoder queue");
+                ImGui::FillWidth();
+                ImGui::ProgressBar(_this->encoder->getBacklogFill(), ImVec2(0, 0), dropped ? overlay.c_str() : NULL);
+                if (seconds) { ImGui::Text("Bitrate: %.1f kbps", (double)_this->encoder->getBytesWritten() * 8.0 / (1000.0 * seconds)); }
+            }
+
+            // Show how much of the write buffer is waiting on the disk, compressed recordings always being buffered
+            else if (_this->compressed || _this->backlogs[_this->backlogId]) {
+                size_t dropped = _this->compressed ? _this->ziqWriter.getSamplesDropped() : _this->writer.getSamplesDropped();
+                float fill = _this->compressed ? _this->ziqWriter.getBacklogFill() : _this->writer.getBacklogFill();
+                std::string overlay = dropped ? "Dropped " + std::to_string(dropped) : "";
+                ImGui::LeftLabel("Buffer fill");
+                ImGui::FillWidth();
+                ImGui::ProgressBar(fill, ImVec2(0, 0), dropped ? overlay.c_str() : NULL);
+            }
+
+            // Show the compression ratio
+            if (_this->compressed && _this->ziqWriter.getBytesWritten()) {
+                double raw = (double)_this->ziqWriter.getSamplesWritten() * sizeof(dsp::complex_t);
+                ImGui::Text("Compression ratio: %.1f:1", raw / (double)_this->ziqWriter.getBytesWritten());
+            }
         }
     }
 
@@ -370,7 +1006,9 @@ private:
         selectedStreamName = name;
         streamId = audioStreams.keyId(name);
         volume.setInput(audioStream);
+        meter.setDecimation(std::max<int>(sigpath::sinkManager.getStreamSampleRate(name) / RECORDER_METER_RATE, 1));
         startAudioPath();
+        if (recMode == RECORDER_MODE_AUDIO) { arm(); }
     }
 
     void deselectStream() {
@@ -380,6 +1018,7 @@ private:
             return;
         }
         if (recording && recMode == RECORDER_MODE_AUDIO) { stop(); }
+        if (recMode == RECORDER_MODE_AUDIO) { disarm(); }
         stopAudioPath();
         sigpath::sinkManager.unbindStream(selectedStreamName, audioStream);
         selectedStreamName.clear();
@@ -416,8 +1055,9 @@ private:
     static void streamUnregisterHandler(std::string name, void* ctx) {
         RecorderModule* _this = (RecorderModule*)ctx;
 
-        // Remove stream from list
+        // Remove stream from list and stop recording it
         _this->audioStreams.undefineKey(name);
+        _this->stopTrack(name, false);
 
         // If the stream is in used, deselect it and reselect default. Otherwise, update ID.
         if (_this->selectedStreamName == name) {
@@ -428,16 +1068,22 @@ private:
         }
     }
 
-    void updateAudioMeter(dsp::stereo_t& lvl) {
+    static void decayLevel(float& lvl, float raw, double frameTime) {
         // Note: Yes, using the natural log is on purpose, it just gives a more beautiful result.
+        lvl = std::clamp<float>(lvl - (frameTime * 50.0), -90.0f, 10.0f);
+        float db = 10.0f * logf(raw);
+        if (db > lvl) { lvl = db; }
+    }
+
+    void updateAudioMeter() {
+        // Levels of the entries published since the last frame, nothing new leaves them decaying
         double frameTime = 1.0 / ImGui::GetIO().Framerate;
-        lvl.l = std::clamp<float>(lvl.l - (frameTime * 50.0), -90.0f, 10.0f);
-        lvl.r = std::clamp<float>(lvl.r - (frameTime * 50.0), -90.0f, 10.0f);
-        dsp::stereo_t rawLvl = meter.getLevel();
-        meter.resetLevel();
-        dsp::stereo_t dbLvl = { 10.0f * logf(rawLvl.l), 10.0f * logf(rawLvl.r) };
-        if (dbLvl.l > lvl.l) { lvl.l = dbLvl.l; }
-        if (dbLvl.r > lvl.r) { lvl.r = dbLvl.r; }
+        dsp::sink::LevelMeter<dsp::stereo_t>::Level raw = {};
+        meter.read(raw, guiMeterCursor);
+        decayLevel(audioPeak.l, raw.peak[0], frameTime);
+        decayLevel(audioPeak.r, raw.peak[1], frameTime);
+        decayLevel(audioRms.l, raw.rms[0], frameTime);
+        decayLevel(audioRms.r, raw.rms[1], frameTime);
     }
 
     std::map<int, const char*> radioModeToString = {
@@ -453,7 +1099,7 @@ private:
 
     std::string genFileName(std::string templ, int mode, std::string name) {
         // Get data
-        time_t now = time(0);
+        time_t now = sigpath::streamClock.nowTime();
         tm* ltm = localtime(&now);
         char buf[1024];
         double freq = gui::waterfall.getCenterFrequency();
@@ -462,7 +1108,7 @@ private:
         }
 
         // Select the recording type string
-        std::string type = (recMode == RECORDER_MODE_AUDIO) ? "audio" : "baseband";
+        std::string type = (mode == RECORDER_MODE_AUDIO) ? "audio" : "baseband";
 
         // Format to string
         char freqStr[128];
@@ -472,7 +1118,7 @@ private:
         char dayStr[128];
         char monStr[128];
         char yearStr[128];
-        const char* modeStr = (recMode == RECORDER_MODE_AUDIO) ? "Unknown" : "IQ";
+        const char* modeStr = (mode == RECORDER_MODE_AUDIO) ? "Unknown" : "IQ";
         sprintf(freqStr, "%.0lfHz", freq);
         sprintf(hourStr, "%02d", ltm->tm_hour);
         sprintf(minStr, "%02d", ltm->tm_min);
@@ -506,11 +1152,46 @@ private:
 
     static void complexHandler(dsp::complex_t* data, int count, void* ctx) {
         RecorderModule* _this = (RecorderModule*)ctx;
-        _this->writer.write((float*)data, count);
+        _this->push((float*)data, count);
+    }
+
+    // Send the samples through the pre-record buffer when armed
+    void push(float* data, int count) {
+        if (armed) {
+            timeShift.push(data, count);
+            return;
+        }
+        if (prepared) { return; }
+        output(data, count);
+    }
+
+    void output(float* data, int count) {
+        if (encoder) {
+            encoder->write(data, count);
+            return;
+        }
+        if (compressed) {
+            ziqWriter.write((dsp::complex_t*)data, count);
+            return;
+        }
+        writer.write(data, count);
+    }
+
+    // Sample type of compressed recordings, int32 having no equivalent it is stored as float
+    static dsp::compression::PCMType compressedType(wav::SampleType type) {
+        switch (type) {
+        case wav::SAMP_TYPE_UINT8:
+            return dsp::compression::PCM_TYPE_I8;
+        case wav::SAMP_TYPE_INT16:
+            return dsp::compression::PCM_TYPE_I16;
+        default:
+            return dsp::compression::PCM_TYPE_F32;
+        }
     }
 
     static void stereoHandler(dsp::stereo_t* data, int count, void* ctx) {
         RecorderModule* _this = (RecorderModule*)ctx;
+        if (_this->segmented && !_this->segmentGate(count)) { return; }
         if (_this->ignoreSilence) {
             float absMax = 0.0f;
             float* _data = (float*)data;
@@ -522,11 +1203,12 @@ private:
             _this->ignoringSilence = (absMax < SILENCE_LVL);
             if (_this->ignoringSilence) { return; }
         }
-        _this->writer.write((float*)data, count);
+        _this->push((float*)data, count);
     }
 
     static void monoHandler(float* data, int count, void* ctx) {
         RecorderModule* _this = (RecorderModule*)ctx;
+        if (_this->segmented && !_this->segmentGate(count)) { return; }
         if (_this->ignoreSilence) {
             float absMax = 0.0f;
             for (int i = 0; i < count; i++) {
@@ -536,7 +1218,53 @@ private:
             _this->ignoringSilence = (absMax < SILENCE_LVL);
             if (_this->ignoringSilence) { return; }
         }
-        _this->writer.write(data, count);
+        _this->push(data, count);
+    }
+
+    static void collectMetrics(metrics::Writer& w, void* ctx) {
+        RecorderModule* _this = (RecorderModule*)ctx;
+        std::lock_guard lck(_this->recMtx);
+        w.declare("recorder_recording", metrics::TYPE_GAUGE, "Whether the recorder is recording");
+        w.add("recorder_recording", _this->recording ? 1.0 : 0.0, { { "instance", _this->name } });
+
+        // Levels of the audio stream since the last scrape, from the same history as the menu's meters
+        dsp::sink::LevelMeter<dsp::stereo_t>::Level lvl;
+        if (!_this->selectedStreamName.empty() && _this->meter.read(lvl, _this->metricsMeterCursor)) {
+            w.declare("recorder_audio_peak_dbfs", metrics::TYPE_GAUGE, "Peak level of the audio stream since the last scrape");
+            w.declare("recorder_audio_rms_dbfs", metrics::TYPE_GAUGE, "RMS level of the audio stream since the last scrape");
+            const char* channels[] = { "left", "right" };
+            for (int c = 0; c < 2; c++) {
+                metrics::Labels labels = { { "instance", _this->name }, { "stream", _this->selectedStreamName }, { "channel", channels[c] } };
+                w.add("recorder_audio_peak_dbfs", 20.0 * log10(std::max<float>(lvl.peak[c], 1e-10f)), labels);
+                w.add("recorder_audio_rms_dbfs", 20.0 * log10(std::max<float>(lvl.rms[c], 1e-10f)), labels);
+            }
+        }
+        if (!_this->recording) { return; }
+
+        // Each stream of a multi-stream recording has a writer of its own
+        w.declare("recorder_backlog_fill_ratio", metrics::TYPE_GAUGE, "Fraction of the write buffer waiting on the disk, the compression or the encoding");
+        w.declare("recorder_dropped_samples_total", metrics::TYPE_COUNTER, "Samples dropped because the write buffer was full");
+        if (_this->recMode == RECORDER_MODE_MULTI) {
+            for (const auto& track : _this->tracks) {
+                metrics::Labels labels = { { "instance", _this->name }, { "track", track->name }, { "type", track->iq ? "iq" : "audio" } };
+                if (track->encoder) {
+                    w.add("recorder_backlog_fill_ratio", track->encoder->getBacklogFill(), labels);
+                    w.add("recorder_dropped_samples_total", track->encoder->getSamplesDropped(), labels);
+                    continue;
+                }
+                w.add("recorder_backlog_fill_ratio", track->writer.getBacklogFill(), labels);
+                w.add("recorder_dropped_samples_total", track->writer.getSamplesDropped(), labels);
+            }
+            return;
+        }
+        metrics::Labels labels = { { "instance", _this->name } };
+        if (_this->encoder) {
+            w.add("recorder_backlog_fill_ratio", _this->encoder->getBacklogFill(), labels);
+            w.add("recorder_dropped_samples_total", _this->encoder->getSamplesDropped(), labels);
+            return;
+        }
+        w.add("recorder_backlog_fill_ratio", _this->compressed ? _this->ziqWriter.getBacklogFill() : _this->writer.getBacklogFill(), labels);
+        w.add("recorder_dropped_samples_total", _this->compressed ? _this->ziqWriter.getSamplesDropped() : _this->writer.getSamplesDropped(), labels);
     }
 
     static void moduleInterfaceHandler(int code, void* in, void* out, void* ctx) {
@@ -549,7 +1277,7 @@ private:
         else if (code == RECORDER_IFACE_CMD_SET_MODE) {
             if (_this->recording) { return; }
             int* _in = (int*)in;
-            _this->recMode = std::clamp<int>(*_in, 0, 1);
+            _this->setMode(std::clamp<int>(*_in, 0, 2));
         }
         else if (code == RECORDER_IFACE_CMD_START) {
             if (!_this->recording) { _this->start(); }
@@ -557,6 +1285,12 @@ private:
         else if (code == RECORDER_IFACE_CMD_STOP) {
             if (_this->recording) { _this->stop(); }
         }
+        else if (code == RECORDER_IFACE_CMD_PREPARE) {
+            _this->prepare();
+        }
+        else if (code == RECORDER_IFACE_CMD_UNPREPARE) {
+            _this->unprepare();
+        }
     }
 
     std::string name;
@@ -564,22 +1298,68 @@ private:
     std::string root;
     char nameTemplate[1024];
 
-    OptionList<std::string, wav::Format> containers;
+    OptionList<std::string, Container> containers;
     OptionList<int, wav::SampleType> sampleTypes;
+    OptionList<int, int> backlogs;
+    OptionList<int, int> preallocs;
+    OptionList<int, int> bitrates;
     FolderSelect folderSelect;
 
     int recMode = RECORDER_MODE_AUDIO;
     int containerId;
     int sampleTypeId;
+    int backlogId;
+    int preallocId;
+    int bitrateId;
     bool stereo = true;
     std::string selectedStreamName = "";
     float audioVolume = 1.0f;
     bool ignoreSilence = false;
-    dsp::stereo_t audioLvl = { -100.0f, -100.0f };
+    bool squelchSegments = false;
+    dsp::stereo_t audioPeak = { -100.0f, -100.0f };
+    dsp::stereo_t audioRms = { -100.0f, -100.0f };
+    uint64_t guiMeterCursor = 0;
+    uint64_t metricsMeterCursor = 0;
 
     bool recording = false;
     bool ignoringSilence = false;
     wav::Writer writer;
+    ziq::Writer ziqWriter;
+    bool compressed = false;
+    std::unique_ptr<encoder::Writer> encoder;
+    TimeShiftBuffer timeShift;
+
+    // State of a squelch-gated recording
+    bool segmented = false;
+    std::string squelchRadio;
+    std::atomic<bool> squelchOpen = true;
+    bool segmentOpen = false;
+    int segmentCount = 0;
+    uint64_t closedFrames = 0;
+    EventHandler<bool> squelchHandler;
+
+    // A stream of a multi-stream recording
+    struct Track {
+        std::string name;
+        bool iq = false;
+        double samplerate = 48000.0;
+        double offset = 0.0;
+        dsp::stream<dsp::stereo_t>* audio = NULL;
+        dsp::sink::Handler<dsp::stereo_t> audioSink;
+        dsp::stream<dsp::complex_t>* baseband = NULL;
+        dsp::channel::RxVFO vfo;
+        dsp::sink::Handler<dsp::complex_t> iqSink;
+        wav::Writer writer;
+        std::unique_ptr<encoder::Writer> encoder;
+    };
+    std::set<std::string> multiStreams;
+    std::set<std::string> multiVfos;
+    std::vector<std::unique_ptr<Track>> tracks;
+    std::unique_ptr<wav::WriteQueue> writeQueue;
+    int preRecord = 0;
+    bool armed = false;
+    std::atomic<bool> prepared = false;
+    std::string preparedPath;
     std::recursive_mutex recMtx;
     dsp::stream<dsp::complex_t>* basebandStream;
     dsp::stream<dsp::stereo_t> stereoStream;
@@ -593,7 +1373,7 @@ private:
     dsp::audio::Volume volume;
     dsp::routing::Splitter<dsp::stereo_t> splitter;
     dsp::stream<dsp::stereo_t> meterStream;
-    dsp::bench::PeakLevelMeter<dsp::stereo_t> meter;
+    dsp::sink::LevelMeter<dsp::stereo_t> meter;
     dsp::convert::StereoToMono s2m;
 
     uint64_t samplerate = 48000;
@@ -4,10 +4,13 @@ enum {
     RECORDER_IFACE_CMD_GET_MODE,
     RECORDER_IFACE_CMD_SET_MODE,
     RECORDER_IFACE_CMD_START,
-    RECORDER_IFACE_CMD_STOP
+    RECORDER_IFACE_CMD_STOP,
+    RECORDER_IFACE_CMD_PREPARE,     // Open the file and start the input ahead of a START
+    RECORDER_IFACE_CMD_UNPREPARE    // Delete the file of a PREPARE that won't be followed by a START
 };
 
 enum {
     RECORDER_MODE_BASEBAND,
-    RECORDER_MODE_AUDIO
+    RECORDER_MODE_AUDIO,
+    RECORDER_MODE_MULTI
 };
\ No newline at end of file
@@ -0,0 +1,213 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <dsp/stream.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Rolling capture of the last samples of a stream, kept in a memory-mapped file so that the page cache and not the
+// process holds the data. Samples are pushed continuously, and draining hands the buffered past to a handler
+// followed by everything pushed afterwards, from a thread of its own
+class TimeShiftBuffer {
+public:
+    // Receives count frames of interleaved samples
+    typedef std::function<void(float* data, int count)> Handler;
+
+    ~TimeShiftBuffer() {
+        close();
+    }
+
+    // frames is the length of the buffer, channels the number of floats in a frame
+    bool open(std::string path, int64_t frames, int channels, double samplerate) {
+        close();
+        _capacity = std::max<int64_t>(frames, 1);
+        _channels = channels;
+        _samplerate = samplerate;
+        size_t size = _capacity * _channels * sizeof(float);
+
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+        if (file == INVALID_HANDLE_VALUE) { return false; }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+        ring = mapping ? (float*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : NULL;
+        if (!ring) {
+            if (mapping) { CloseHandle(mapping); }
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+            return false;
+        }
+#else
+        // The file is unlinked right away, it only lives as long as the mapping
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) { return false; }
+        unlink(path.c_str());
+        void* ptr = (ftruncate(fd, size) == 0) ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (ptr == MAP_FAILED) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        ring = (float*)ptr;
+#endif
+        mapSize = size;
+        writePos = 0;
+        readPos = 0;
+        overruns = 0;
+        return true;
+    }
+
+    void close() {
+        if (!ring) { return; }
+        stopDrain();
+#ifdef _WIN32
+        UnmapViewOfFile(ring);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        munmap(ring, mapSize);
+        ::close(fd);
+        fd = -1;
+#endif
+        ring = NULL;
+    }
+
+    bool isOpen() {
+        return ring;
+    }
+
+    double getSamplerate() { return _samplerate; }
+
+    int getChannels() { return _channels; }
+
+    // Seconds of samples currently held
+    double getFill() {
+        std::lock_guard<std::mutex> lck(mtx);
+        return (double)std::min<uint64_t>(writePos, _capacity) / _samplerate;
+    }
+
+    // Number of frames lost because the drain fell a whole buffer behind
+    uint64_t getOverruns() {
+        return overruns;
+    }
+
+    void push(const float* data, int count) {
+        if (!ring) { return; }
+
+        // Only the end of a push larger than the buffer is kept
+        uint64_t pos;
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            pos = writePos;
+        }
+        if (count > _capacity) {
+            data += (count - _capacity) * _channels;
+            pos += count - _capacity;
+            count = _capacity;
+        }
+
+        // Copy with wrap around. If the drain is a whole buffer behind, it may read frames as they get overwritten,
+        // those are counted as lost anyway
+        int64_t idx = pos % _capacity;
+        int first = std::min<int64_t>(count, _capacity - idx);
+        memcpy(&ring[idx * _channels], data, first * _channels * sizeof(float));
+        if (first < count) { memcpy(ring, &data[first * _channels], (count - first) * _channels * sizeof(float)); }
+
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            writePos = pos + count;
+            if (draining && writePos - readPos > _capacity) {
+                overruns += (writePos - readPos) - _capacity;
+                readPos = writePos - _capacity;
+            }
+        }
+        if (draining) { cnd.notify_one(); }
+    }
+
+    // Start handing out the buffered samples and those that follow
+    void startDrain(Handler handler) {
+        if (!ring || draining) { return; }
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            readPos = writePos - std::min<uint64_t>(writePos, _capacity);
+            stopping = false;
+            draining = true;
+        }
+        _handler = handler;
+        drainThread = std::thread(&TimeShiftBuffer::drainWorker, this);
+    }
+
+    // Hand out what's left and stop
+    void stopDrain() {
+        if (!draining) { return; }
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            stopping = true;
+        }
+        cnd.notify_one();
+        if (drainThread.joinable()) { drainThread.join(); }
+        draining = false;
+    }
+
+private:
+    void drainWorker() {
+        while (true) {
+            // Wait for samples, only exiting once all were handed out
+            uint64_t start;
+            int64_t idx;
+            int count;
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                cnd.wait(lck, [=]() { return writePos > readPos || stopping; });
+                if (writePos <= readPos) { return; }
+                start = readPos;
+                idx = start % _capacity;
+                count = std::min<int64_t>({ (int64_t)(writePos - readPos), _capacity - idx, STREAM_BUFFER_SIZE });
+            }
+
+            // Hand them out straight from the mapping
+            _handler(&ring[idx * _channels], count);
+
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                readPos = std::max<uint64_t>(readPos, start + count);
+            }
+        }
+    }
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+    float* ring = NULL;
+    size_t mapSize = 0;
+    int64_t _capacity = 1;
+    int _channels = 2;
+    double _samplerate = 1.0;
+
+    std::mutex mtx;
+    std::condition_variable cnd;
+    uint64_t writePos = 0;
+    uint64_t readPos = 0;
+    std::atomic<uint64_t> overruns = 0;
+
+    Handler _handler;
+    std::thread drainThread;
+    std::atomic<bool> draining = false;
+    bool stopping = false;
+};
@@ -10,10 +10,20 @@
 #include <config.h>
 #include <cctype>
 #include <radio_interface.h>
+#include <chrono>
+#include <atomic>
+#include <memory>
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
 #define MAX_COMMAND_LENGTH 8192
 
+// Clients connected at the same time at most, the others being disconnected right away
+#define MAX_CLIENTS 16
+
+// Time during which the answers to frequency and mode queries are reused, in seconds. Clients polling faster than that
+// are answered without going through the VFO and the radio. Any command changing them refreshes them
+#define STATE_CACHE_TIME 0.05
+
 SDRPP_MOD_INFO{
     /* Name:            */ "rigctl_server",
     /* Description:     */ "My fancy new module",
@@ -63,7 +73,7 @@ public:
         sigpath::vfoManager.onVfoDeleted.unbindHandler(&vfoDeletedHandler);
         core::moduleManager.onInstanceCreated.unbindHandler(&modChangedHandler);
         core::moduleManager.onInstanceDeleted.unbindHandler(&modChangedHandler);
-        if (client) { client->close(); }
+        closeClients();
         if (listener) { listener->close(); }
     }
 
@@ -184,9 +194,13 @@ private:
 
         ImGui::TextUnformatted("Status:");
         ImGui::SameLine();
-        if (_this->client && _this->client->isOpen()) {
+        int clientCount = _this->getClientCount();
+        if (clientCount == 1) {
             ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Connected");
         }
+        else if (clientCount) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "%d clients connected", clientCount);
+        }
         else if (listening) {
             ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Listening");
         }
@@ -206,8 +220,24 @@ private:
     }
 
     void stopServer() {
-        if (client) { client->close(); }
+        // The listener is closed first so that no client gets accepted meanwhile
         listener->close();
+        closeClients();
+    }
+
+    void closeClients() {
+        std::lock_guard lck(clientsMtx);
+        for (auto& cl : clients) { cl->conn->close(); }
+        clients.clear();
+    }
+
+    int getClientCount() {
+        std::lock_guard lck(clientsMtx);
+        int count = 0;
+        for (auto& cl : clients) {
+            if (cl->conn->isOpen()) { count++; }
+        }
+        return count;
     }
 
     void refreshModules() {
@@ -253,6 +283,7 @@ private:
             vfoId = std::distance(vfoNames.begin(), vfoIt);
             selectedVfo = _name;
         }
+        invalidateState();
     }
 
     void selectRecorderByName(std::string _name, bool lock = true) {
@@ -304,33 +335,109 @@ private:
         _this->selectRecorderByName(_this->selectedRecorder);
     }
 
+    // Each client is served by the read thread of its connection, the accept thread going straight back to accepting
+    struct Client {
+        SigctlServerModule* server;
+        net::Conn conn;
+        std::string command;
+        std::string responses;
+        uint8_t dataBuf[1024];
+    };
+
     static void clientHandler(net::Conn _client, void* ctx) {
         SigctlServerModule* _this = (SigctlServerModule*)ctx;
-        //flog::info("New client!");
 
-        _this->client = std::move(_client);
-        _this->client->readAsync(1024, _this->dataBuf, dataHandler, _this, false);
-        _this->client->waitForEnd();
-        _this->client->close();
+        {
+            std::lock_guard lck(_this->clientsMtx);
+
+            // Forget the clients that disconnected, their read thread being done
+            for (auto it = _this->clients.begin(); it != _this->clients.end();) {
+                if ((*it)->conn->isOpen()) {
+                    it++;
+                    continue;
+                }
+                (*it)->conn->close();
+                it = _this->clients.erase(it);
+            }
 
-        //flog::info("Client disconnected!");
+            if (_this->clients.size() < MAX_CLIENTS) {
+                auto cl = std::make_unique<Client>();
+                cl->server = _this;
+                cl->conn = std::move(_client);
+                cl->conn->readAsync(sizeof(cl->dataBuf), cl->dataBuf, dataHandler, cl.get(), false);
+                _this->clients.push_back(std::move(cl));
+            }
+            else {
+                flog::warn("Rigctl server refused a client, {0} are already connected", MAX_CLIENTS);
+                _client->close();
+            }
+        }
 
         _this->listener->acceptAsync(clientHandler, _this);
     }
 
     static void dataHandler(int count, uint8_t* data, void* ctx) {
-        SigctlServerModule* _this = (SigctlServerModule*)ctx;
+        Client* cl = (Client*)ctx;
+        SigctlServerModule* _this = cl->server;
 
+        // Run all the commands that arrived together and send their responses at once, so that pipelined commands
+        // don't each cost a round trip through the socket
         for (int i = 0; i < count; i++) {
             if (data[i] == '\n') {
-                _this->commandHandler(_this->command);
-                _this->command.clear();
+                _this->commandHandler(cl->command, cl->responses);
+                cl->command.clear();
                 continue;
             }
-            if (_this->command.size() < MAX_COMMAND_LENGTH) { _this->command += (char)data[i]; }
+            if (cl->command.size() < MAX_COMMAND_LENGTH) { cl->command += (char)data[i]; }
+        }
+        if (!cl->responses.empty()) {
+            cl->conn->write(cl->responses.size(), (uint8_t*)cl->responses.c_str());
+            cl->responses.clear();
         }
 
-        _this->client->readAsync(1024, _this->dataBuf, dataHandler, _this, false);
+        cl->conn->readAsync(sizeof(cl->dataBuf), cl->dataBuf, dataHandler, cl, false);
+    }
+
+    // Answers to the read-only queries, refreshed when they're older than STATE_CACHE_TIME or were invalidated since
+    void getState(std::string& freqResp, std::string& modeResp) {
+        std::lock_guard lck(stateMtx);
+        auto now = std::chrono::steady_clock::now();
+        uint64_t gen = stateGen;
+        if (cachedGen != gen || std::chrono::duration<double>(now - stateTime).count() > STATE_CACHE_TIME) {
+            std::lock_guard lck2(vfoMtx);
+
+            // Get center frequency of the SDR and add the offset of the VFO if it exists
+            double freq = gui::waterfall.getCenterFrequency();
+            if (sigpath::vfoManager.vfoExists(selectedVfo)) {
+                freq += sigpath::vfoManager.getOffset(selectedVfo);
+            }
+            char buf[128];
+            sprintf(buf, "%" PRIu64 "\n", (uint64_t)freq);
+            cachedFreq = buf;
+
+            cachedMode = "RAW\n";
+            if (!selectedVfo.empty() && core::modComManager.getModuleName(selectedVfo) == "radio") {
+                int mode;
+                core::modComManager.callInterface(selectedVfo, RADIO_IFACE_CMD_GET_MODE, NULL, &mode);
+                cachedMode = std::string(radioModeToString[mode]) + "\n";
+            }
+            else if (!selectedVfo.empty()) {
+                cachedMode += std::to_string((int)sigpath::vfoManager.getBandwidth(selectedVfo)) + "\n";
+            }
+            else {
+                cachedMode += "0\n";
+            }
+
+            stateTime = now;
+            cachedGen = gen;
+        }
+        freqResp = cachedFreq;
+        modeResp = cachedMode;
+    }
+
+    // Called with the VFO locked, so it doesn't take the lock of the cached state
+    void invalidateState() {
+        stateGen++;
     }
 
     std::map<int, const char*> radioModeToString = {
@@ -344,7 +451,7 @@ private:
         { RADIO_IFACE_MODE_RAW, "RAW" }
     };
 
-    void commandHandler(std::string cmd) {
+    void commandHandler(std::string cmd, std::string& out) {
         std::string corr = "";
         std::vector<std::string> parts;
         bool lastWasSpace = false;
@@ -377,11 +484,24 @@ private:
             std::string arguments;
             if (parts.size() > 1) { arguments = cmd.substr(parts[0].size()); }
             for (char c : parts[0]) {
-                commandHandler(c + arguments);
+                commandHandler(c + arguments, out);
             }
             return;
         }
 
+        // Read-only queries are answered from the cached state without logging, clients polling them continuously
+        if (parts[0] == "f" || parts[0] == "\\get_freq" || parts[0] == "m" || parts[0] == "\\get_mode") {
+            std::string freqResp, modeResp;
+            getState(freqResp, modeResp);
+            out += (parts[0] == "f" || parts[0] == "\\get_freq") ? freqResp : modeResp;
+            return;
+        }
+        if (parts[0] == "t" || parts[0] == "\\get_ptt") {
+            // Receive only
+            out += "0\n";
+            return;
+        }
+
         flog::info("Rigctl command: '{0}'", cmd);
 
         // Otherwise, execute the command
@@ -391,38 +511,23 @@ private:
             // if number of arguments isn't correct, return error
             if (parts.size() != 2) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
             // If not controlling the VFO, return
             if (!tuningEnabled) {
                 resp = "RPRT 0\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
             // Parse frequency and assign it to the VFO
             long long freq = std::stoll(parts[1]);
             tuner::tune(tuner::TUNER_MODE_NORMAL, selectedVfo, freq);
+            invalidateState();
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
-        }
-        else if (parts[0] == "f" || parts[0] == "\\get_freq") {
-            std::lock_guard lck(vfoMtx);
-
-            // Get center frequency of the SDR
-            double freq = gui::waterfall.getCenterFrequency();
-
-            // Add the offset of the VFO if it exists
-            if (sigpath::vfoManager.vfoExists(selectedVfo)) {
-                freq += sigpath::vfoManager.getOffset(selectedVfo);
-            }
-
-            // Respond with the frequency
-            char buf[128];
-            sprintf(buf, "%" PRIu64 "\n", (uint64_t)freq);
-            client->write(strlen(buf), (uint8_t*)buf);
+            out += resp;
         }
         else if (parts[0] == "M" || parts[0] == "\\set_mode") {
             std::lock_guard lck(vfoMtx);
@@ -431,14 +536,14 @@ private:
             // If client is querying, respond accordingly
             if (parts.size() >= 2 && parts[1] == "?") {
                 resp = "FM WFM AM DSB USB CW LSB RAW\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
             // if number of arguments isn't correct, return error
             if (parts.size() != 3) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
@@ -447,7 +552,7 @@ private:
             for (char c : parts[2]) {
                 if (!std::isdigit(c) && !(c == '-' && !pos)) {
                     resp = "RPRT 1\n";
-                    client->write(resp.size(), (uint8_t*)resp.c_str());
+                    out += resp;
                     return;
                 }
                 pos++;
@@ -461,7 +566,7 @@ private:
             });
             if (it == radioModeToString.end()) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
             int newMode = it->first;
@@ -472,27 +577,10 @@ private:
                 if (newBandwidth > 0) {
                     core::modComManager.callInterface(selectedVfo, RADIO_IFACE_CMD_SET_BANDWIDTH, &newBandwidth, NULL);
                 }
+                invalidateState();
             }
 
-            client->write(resp.size(), (uint8_t*)resp.c_str());
-        }
-        else if (parts[0] == "m" || parts[0] == "\\get_mode") {
-            std::lock_guard lck(vfoMtx);
-            resp = "RAW\n";
-
-            if (!selectedVfo.empty() && core::modComManager.getModuleName(selectedVfo) == "radio") {
-                int mode;
-                core::modComManager.callInterface(selectedVfo, RADIO_IFACE_CMD_GET_MODE, NULL, &mode);
-                resp = std::string(radioModeToString[mode]) + "\n";
-            }
-            else if (!selectedVfo.empty()) {
-                resp += std::to_string((int)sigpath::vfoManager.getBandwidth(selectedVfo)) + "\n";
-            }
-            else {
-                resp += "0\n";
-            }
-
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "V" || parts[0] == "\\set_vfo") {
             std::lock_guard lck(vfoMtx);
@@ -501,7 +589,7 @@ private:
             // if number of arguments isn't correct or the VFO is not "VFO", return error
             if (parts.size() != 2) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
@@ -512,27 +600,27 @@ private:
                 resp = "RPRT 1\n";
             }
 
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "v" || parts[0] == "\\get_vfo") {
             std::lock_guard lck(vfoMtx);
             resp = "VFO\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "\\chk_vfo") {
             std::lock_guard lck(vfoMtx);
             resp = "CHKVFO 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "s") {
             std::lock_guard lck(vfoMtx);
             resp = "0\nVFOA\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "S") {
             std::lock_guard lck(vfoMtx);
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "AOS" || parts[0] == "\\recorder_start") {
             std::lock_guard lck(recorderMtx);
@@ -540,7 +628,7 @@ private:
             // If not controlling the recorder, return
             if (!recordingEnabled) {
                 resp = "RPRT 0\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
@@ -554,7 +642,7 @@ private:
 
             // Respond with a success
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "LOS" || parts[0] == "\\recorder_stop") {
             std::lock_guard lck(recorderMtx);
@@ -562,7 +650,7 @@ private:
             // If not controlling the recorder, return
             if (!recordingEnabled) {
                 resp = "RPRT 0\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                out += resp;
                 return;
             }
 
@@ -576,7 +664,7 @@ private:
 
             // Respond with a success
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else if (parts[0] == "q" || parts[0] == "\\quit") {
             // Will close automatically
@@ -657,18 +745,18 @@ private:
                 "0\n" /* RIG_PARM_NONE */
                 /* Bit field list of set parm */
                 "0\n" /* RIG_PARM_NONE */;
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         // This get_powerstat stuff is a wordaround for WSJT-X 2.7.0
         else if (parts[0] == "\\get_powerstat") {
             resp = "1\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
         }
         else {
             // If command is not recognized, return error
             flog::error("Rigctl client sent invalid command: '{0}'", cmd);
             resp = "RPRT 1\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            out += resp;
             return;
         }
     }
@@ -678,11 +766,16 @@ private:
 
     char hostname[1024];
     int port = 4532;
-    uint8_t dataBuf[1024];
     net::Listener listener;
-    net::Conn client;
-
-    std::string command = "";
+    std::mutex clientsMtx;
+    std::vector<std::unique_ptr<Client>> clients;
+
+    std::mutex stateMtx;
+    std::atomic<uint64_t> stateGen = 1;
+    uint64_t cachedGen = 0;
+    std::chrono::steady_clock::time_point stateTime;
+    std::string cachedFreq;
+    std::string cachedMode;
 
     EventHandler<std::string> modChangedHandler;
     EventHandler<VFOManager::VFO*> vfoCreatedHandler;
@@ -3,20 +3,59 @@
 #include <gui/gui.h>
 #include <gui/style.h>
 #include <signal_path/signal_path.h>
+#include <config.h>
+#include <core.h>
+#include <utils/freq_formatting.h>
 #include <chrono>
+#include <vector>
+#include <set>
+#include <atomic>
+#include <algorithm>
 
 SDRPP_MOD_INFO{
     /* Name:            */ "scanner",
     /* Description:     */ "Frequency scanner for SDR++",
     /* Author:          */ "Ryzerth",
-    /* Version:         */ 0, 1, 0,
+    /* Version:         */ 0, 2, 0,
     /* Max instances    */ 1
 };
 
+ConfigManager config;
+
+enum ScanMode {
+    SCAN_MODE_SEQUENTIAL,
+    SCAN_MODE_WIDEBAND
+};
+
+// Longest wait for a spectrum before checking whether the scanner was stopped
+#define SCANNER_LINE_TIMEOUT    0.5
+
+// The scanner works on the signal path alone: the channel levels come from the spectrum statistics, the VFOs are moved
+// through the VFO manager and the hardware is retuned through the source manager. It wakes up for every spectrum the
+// front end computes, with or without the GUI. Each scanned VFO is a lane that looks for an active channel of its own,
+// skipping those already held by another, so that several signals of the range can be received at once
 class ScannerModule : public ModuleManager::Instance {
 public:
     ScannerModule(std::string name) {
         this->name = name;
+
+        config.acquire();
+        if (config.conf.contains("mode")) { mode = std::clamp<int>(config.conf["mode"], 0, 1); }
+        if (config.conf.contains("startFreq")) { startFreq = config.conf["startFreq"]; }
+        if (config.conf.contains("stopFreq")) { stopFreq = config.conf["stopFreq"]; }
+        if (config.conf.contains("interval")) { interval = config.conf["interval"]; }
+        if (config.conf.contains("passbandRatio")) { passbandRatio = config.conf["passbandRatio"]; }
+        if (config.conf.contains("tuningTime")) { tuningTime = config.conf["tuningTime"]; }
+        if (config.conf.contains("lingerTime")) { lingerTime = config.conf["lingerTime"]; }
+        if (config.conf.contains("level")) { level = config.conf["level"]; }
+        if (config.conf.contains("trigger")) { trigger = config.conf["trigger"]; }
+        if (config.conf.contains("vfos")) {
+            vfoNames.clear();
+            for (auto& vfo : config.conf["vfos"]) { vfoNames.insert((std::string)vfo); }
+        }
+        if (config.conf.contains("scanning")) { autostart = config.conf["scanning"]; }
+        config.release();
+
         gui::menu.registerEntry(name, menuHandler, this, NULL);
     }
 
@@ -25,7 +64,10 @@ public:
         stop();
     }
 
-    void postInit() {}
+    // The VFOs exist once the other modules were created, a scan running when SDR++ was closed is picked up again
+    void postInit() {
+        if (autostart) { start(); }
+    }
 
     void enable() {
         enabled = true;
@@ -40,90 +82,178 @@ public:
     }
 
 private:
+    struct Lane {
+        std::string vfo;
+        double current;
+        bool receiving = false;
+        bool newSpan = true;
+        std::chrono::time_point<std::chrono::high_resolution_clock> lastSignalTime;
+    };
+
     static void menuHandler(void* ctx) {
         ScannerModule* _this = (ScannerModule*)ctx;
         float menuWidth = ImGui::GetContentRegionAvail().x;
-        
+        bool changed = false;
+
         if (_this->running) { ImGui::BeginDisabled(); }
+        ImGui::LeftLabel("Mode");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        changed |= ImGui::Combo("##mode_scanner", &_this->mode, "Sequential\0Wideband\0");
         ImGui::LeftLabel("Start");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputDouble("##start_freq_scanner", &_this->startFreq, 100.0, 100000.0, "%0.0f")) {
             _this->startFreq = round(_this->startFreq);
+            changed = true;
         }
         ImGui::LeftLabel("Stop");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputDouble("##stop_freq_scanner", &_this->stopFreq, 100.0, 100000.0, "%0.0f")) {
             _this->stopFreq = round(_this->stopFreq);
+            changed = true;
         }
         ImGui::LeftLabel("Interval");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputDouble("##interval_scanner", &_this->interval, 100.0, 100000.0, "%0.0f")) {
             _this->interval = round(_this->interval);
+            changed = true;
         }
         ImGui::LeftLabel("Passband Ratio (%)");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputDouble("##pb_ratio_scanner", &_this->passbandRatio, 1.0, 10.0, "%0.0f")) {
             _this->passbandRatio = std::clamp<double>(round(_this->passbandRatio), 1.0, 100.0);
+            changed = true;
         }
         ImGui::LeftLabel("Tuning Time (ms)");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputInt("##tuning_time_scanner", &_this->tuningTime, 100, 1000)) {
             _this->tuningTime = std::clamp<int>(_this->tuningTime, 100, 10000.0);
+            changed = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Longest wait for the source to retune before looking at the new spectrum");
         }
         ImGui::LeftLabel("Linger Time (ms)");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::InputInt("##linger_time_scanner", &_this->lingerTime, 100, 1000)) {
             _this->lingerTime = std::clamp<int>(_this->lingerTime, 100, 10000.0);
+            changed = true;
+        }
+
+        // VFOs to scan with, each receiving a different channel
+        ImGui::TextUnformatted("VFOs");
+        for (auto& vfoName : sigpath::vfoManager.getNames()) {
+            bool checked = _this->vfoNames.count(vfoName);
+            if (ImGui::Checkbox((vfoName + "##scanner_vfo_" + vfoName).c_str(), &checked)) {
+                if (checked) { _this->vfoNames.insert(vfoName); }
+                else { _this->vfoNames.erase(vfoName); }
+                changed = true;
+            }
         }
         if (_this->running) { ImGui::EndDisabled(); }
 
-        ImGui::LeftLabel("Level");
-        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
-        ImGui::SliderFloat("##scanner_level", &_this->level, -150.0, 0.0);
+        // Wideband scans trigger on the level above the noise floor of each channel
+        if (_this->mode == SCAN_MODE_WIDEBAND) {
+            ImGui::LeftLabel("Trigger (dB)");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            changed |= ImGui::SliderFloat("##scanner_trigger", &_this->trigger, 0.0, 50.0);
+        }
+        else {
+            ImGui::LeftLabel("Level");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            changed |= ImGui::SliderFloat("##scanner_level", &_this->level, -150.0, 0.0);
+        }
+
+        if (changed) { _this->saveConfig(); }
 
         ImGui::BeginTable(("scanner_bottom_btn_table" + _this->name).c_str(), 2);
         ImGui::TableNextRow();
         ImGui::TableSetColumnIndex(0);
         if (ImGui::Button(("<<##scanner_back_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
-            std::lock_guard<std::mutex> lck(_this->scanMtx);
-            _this->reverseLock = true;
-            _this->receiving = false;
-            _this->scanUp = false;
+            _this->skip(false);
         }
         ImGui::TableSetColumnIndex(1);
         if (ImGui::Button((">>##scanner_forw_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
-            std::lock_guard<std::mutex> lck(_this->scanMtx);
-            _this->reverseLock = true;
-            _this->receiving = false;
-            _this->scanUp = true;
+            _this->skip(true);
         }
         ImGui::EndTable();
 
         if (!_this->running) {
             if (ImGui::Button("Start##scanner_start", ImVec2(menuWidth, 0))) {
                 _this->start();
+                _this->saveConfig();
             }
             ImGui::Text("Status: Idle");
+            return;
         }
-        else {
-            if (ImGui::Button("Stop##scanner_start", ImVec2(menuWidth, 0))) {
-                _this->stop();
-            }
-            if (_this->receiving) {
-                ImGui::TextColored(ImVec4(0, 1, 0, 1), "Status: Receiving");
+
+        if (ImGui::Button("Stop##scanner_start", ImVec2(menuWidth, 0))) {
+            _this->stop();
+            _this->saveConfig();
+            return;
+        }
+        std::lock_guard<std::mutex> lck(_this->scanMtx);
+        for (auto& lane : _this->lanes) {
+            if (lane.receiving) {
+                ImGui::TextColored(ImVec4(0, 1, 0, 1), "%s: Receiving %s", lane.vfo.c_str(), utils::formatFreq(lane.current).c_str());
             }
             else if (_this->tuning) {
-                ImGui::TextColored(ImVec4(0, 1, 1, 1), "Status: Tuning");
+                ImGui::TextColored(ImVec4(0, 1, 1, 1), "%s: Tuning", lane.vfo.c_str());
             }
             else {
-                ImGui::TextColored(ImVec4(1, 1, 0, 1), "Status: Scanning");
+                ImGui::TextColored(ImVec4(1, 1, 0, 1), "%s: Scanning", lane.vfo.c_str());
             }
         }
     }
 
+    void saveConfig() {
+        config.acquire();
+        config.conf["mode"] = mode;
+        config.conf["startFreq"] = startFreq;
+        config.conf["stopFreq"] = stopFreq;
+        config.conf["interval"] = interval;
+        config.conf["passbandRatio"] = passbandRatio;
+        config.conf["tuningTime"] = tuningTime;
+        config.conf["lingerTime"] = lingerTime;
+        config.conf["level"] = level;
+        config.conf["trigger"] = trigger;
+        config.conf["vfos"] = json::array();
+        for (auto& vfoName : vfoNames) { config.conf["vfos"].push_back(vfoName); }
+        config.conf["scanning"] = (bool)running;
+        config.release(true);
+    }
+
+    // Leave the channels being received and look for the next ones in the given direction
+    void skip(bool up) {
+        std::lock_guard<std::mutex> lck(scanMtx);
+        reverseLock = true;
+        scanUp = up;
+        for (auto& lane : lanes) { lane.receiving = false; }
+    }
+
     void start() {
         if (running) { return; }
-        current = startFreq;
+        if (interval <= 0.0 || stopFreq < startFreq) { return; }
+        channelCount = floor((stopFreq - startFreq) / interval) + 1;
+        active.assign(channelCount, false);
+
+        // Create a lane for each VFO, those that don't exist being skipped
+        lanes.clear();
+        for (auto& vfoName : vfoNames) {
+            if (!sigpath::vfoManager.vfoExists(vfoName)) { continue; }
+            Lane lane;
+            lane.vfo = vfoName;
+            lane.current = startFreq;
+            lanes.push_back(lane);
+        }
+        if (lanes.empty()) {
+            flog::error("Scanner: none of the VFOs to scan with exist");
+            return;
+        }
+
+        // The worker may have stopped by itself when its VFOs were deleted
+        if (workerThread.joinable()) { workerThread.join(); }
+
+        tuning = false;
         running = true;
         workerThread = std::thread(&ScannerModule::worker, this);
     }
@@ -137,161 +267,164 @@ private:
     }
 
     void worker() {
-        // 10Hz scan loop
+        uint64_t seq = 0;
+        sigpath::spectrumStats.waitLine(seq, 0.0);
         while (running) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            {
-                std::lock_guard<std::mutex> lck(scanMtx);
-                auto now = std::chrono::high_resolution_clock::now();
-
-                // Enforce tuning
-                if (gui::waterfall.selectedVFO.empty()) {
-                    running = false;
-                    return;
-                }
-                tuner::normalTuning(gui::waterfall.selectedVFO, current);
-
-                // Check if we are waiting for a tune
-                if (tuning) {
-                    flog::warn("Tuning");
-                    if ((std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTuneTime)).count() > tuningTime) {
-                        tuning = false;
-                    }
-                    continue;
-                }
-
-                // Get FFT data
-                int dataWidth = 0;
-                float* data = gui::waterfall.acquireLatestFFT(dataWidth);
-                if (!data) { continue; }
-
-                // Get gather waterfall data
-                double wfCenter = gui::waterfall.getViewOffset() + gui::waterfall.getCenterFrequency();
-                double wfWidth = gui::waterfall.getViewBandwidth();
-                double wfStart = wfCenter - (wfWidth / 2.0);
-                double wfEnd = wfCenter + (wfWidth / 2.0);
-
-                // Gather VFO data
-                double vfoWidth = sigpath::vfoManager.getBandwidth(gui::waterfall.selectedVFO);
-
-                if (receiving) {
-                    flog::warn("Receiving");
-                
-                    float maxLevel = getMaxLevel(data, current, vfoWidth, dataWidth, wfStart, wfWidth);
-                    if (maxLevel >= level) {
-                        lastSignalTime = now;
-                    }
-                    else if ((std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSignalTime)).count() > lingerTime) {
-                        receiving = false;
-                    }
-                }
-                else {
-                    flog::warn("Seeking signal");
-                    double bottomLimit = current;
-                    double topLimit = current;
-                    
-                    // Search for a signal in scan direction
-                    if (findSignal(scanUp, bottomLimit, topLimit, wfStart, wfEnd, wfWidth, vfoWidth, data, dataWidth)) {
-                        gui::waterfall.releaseLatestFFT();
-                        continue;
-                    }
-                    
-                    // Search for signal in the inverse scan direction if direction isn't enforced
-                    if (!reverseLock) {
-                        if (findSignal(!scanUp, bottomLimit, topLimit, wfStart, wfEnd, wfWidth, vfoWidth, data, dataWidth)) {
-                            gui::waterfall.releaseLatestFFT();
-                            continue;
-                        }
-                    }
-                    else { reverseLock = false; }
-                    
-
-                    // There is no signal on the visible spectrum, tune in scan direction and retry
-                    if (scanUp) {
-                        current = topLimit + interval;
-                        if (current > stopFreq) { current = startFreq; }
-                    }
-                    else {
-                        current = bottomLimit - interval;
-                        if (current < startFreq) { current = stopFreq; }
-                    }
-
-                    // If the new current frequency is outside the visible bandwidth, wait for retune
-                    if (current - (vfoWidth/2.0) < wfStart || current + (vfoWidth/2.0) > wfEnd) {
-                        lastTuneTime = now;
-                        tuning = true;
-                    }
-                }
-
-                // Release FFT Data
-                gui::waterfall.releaseLatestFFT();
+            // Wait for the hardware to be retuned, without holding the lock. The tuning time is the longest it may take.
+            // The first spectrum after that is skipped, it may have been computed from samples of before the retune
+            if (tuning) {
+                sigpath::sourceManager.waitTuned(tuningTime / 1000.0);
+                sigpath::spectrumStats.waitLine(seq, SCANNER_LINE_TIMEOUT);
+                tuning = false;
             }
+
+            // Run once per spectrum
+            if (!sigpath::spectrumStats.waitLine(seq, SCANNER_LINE_TIMEOUT)) { continue; }
+
+            std::lock_guard<std::mutex> lck(scanMtx);
+            scan();
         }
     }
 
-    bool findSignal(bool scanDir, double& bottomLimit, double& topLimit, double wfStart, double wfEnd, double wfWidth, double vfoWidth, float* data, int dataWidth) {
-        bool found = false;
-        double freq = current;
-        for (freq += scanDir ? interval : -interval;
-            scanDir ? (freq <= stopFreq) : (freq >= startFreq);
-            freq += scanDir ? interval : -interval) {
-
-            // Check if signal is within bounds
-            if (freq - (vfoWidth/2.0) < wfStart) { break; }
-            if (freq + (vfoWidth/2.0) > wfEnd) { break; }
-
-            if (freq < bottomLimit) { bottomLimit = freq; }
-            if (freq > topLimit) { topLimit = freq; }
-            
-            // Check signal level
-            float maxLevel = getMaxLevel(data, freq, vfoWidth * (passbandRatio * 0.01f), dataWidth, wfStart, wfWidth);
-            if (maxLevel >= level) {
-                found = true;
-                receiving = true;
-                current = freq;
-                break;
+    void scan() {
+        auto now = std::chrono::high_resolution_clock::now();
+
+        // Drop the lanes whose VFO was deleted
+        lanes.erase(std::remove_if(lanes.begin(), lanes.end(), [](const Lane& l) { return !sigpath::vfoManager.vfoExists(l.vfo); }), lanes.end());
+        if (lanes.empty()) {
+            running = false;
+            return;
+        }
+
+        // Span of the spectrum
+        double center = sigpath::sourceManager.getTunedFrequency();
+        double span = sigpath::iqFrontEnd.getEffectiveSamplerate();
+        double spanStart = center - (span / 2.0);
+        double spanEnd = center + (span / 2.0);
+
+        // Channels fully within it, for the widest of the VFOs
+        double vfoWidth = 0.0;
+        for (auto& lane : lanes) { vfoWidth = std::max<double>(vfoWidth, sigpath::vfoManager.getBandwidth(lane.vfo)); }
+        int first = std::max<int>(ceil((spanStart + (vfoWidth / 2.0) - startFreq) / interval), 0);
+        int last = std::min<int>(floor((spanEnd - (vfoWidth / 2.0) - startFreq) / interval), channelCount - 1);
+
+        // Sequential scans compare the level of the channels to a fixed level, wideband ones to their noise floor
+        double pbWidth = vfoWidth * (passbandRatio * 0.01);
+        SpectrumStats::ChannelStats stats;
+        for (int i = first; i <= last; i++) {
+            if (!sigpath::spectrumStats.getChannelStats(channelFreq(i) - center, pbWidth, stats)) {
+                active[i] = false;
+                continue;
+            }
+            active[i] = (mode == SCAN_MODE_WIDEBAND) ? (stats.level - stats.noiseFloor >= trigger) : (stats.level >= level);
+        }
+
+        // Stay on the channels being received until they have been quiet for the linger time
+        bool anyReceiving = false;
+        for (auto& lane : lanes) {
+            if (!lane.receiving) { continue; }
+            int cur = channelId(lane.current);
+            if (cur >= first && cur <= last && active[cur]) {
+                lane.lastSignalTime = now;
+            }
+            else if ((std::chrono::duration_cast<std::chrono::milliseconds>(now - lane.lastSignalTime)).count() > lingerTime) {
+                lane.receiving = false;
             }
+            anyReceiving |= lane.receiving;
         }
-        return found;
+
+        // The idle lanes look for an active channel not held by another, in the scan direction then in the other one if
+        // it isn't enforced. A new span is searched from its edge, the current channel included
+        bool allIdleFound = true;
+        for (auto& lane : lanes) {
+            if (lane.receiving) { continue; }
+            int cur = channelId(lane.current);
+            int from = cur;
+            if (lane.newSpan || cur < first || cur > last) { from = scanUp ? first - 1 : last + 1; }
+            lane.newSpan = false;
+            int found = findActive(scanUp, from, first, last);
+            if (found < 0 && !reverseLock) { found = findActive(!scanUp, from, first, last); }
+            if (found < 0) {
+                allIdleFound = false;
+                continue;
+            }
+            lane.current = channelFreq(found);
+            lane.receiving = true;
+            lane.lastSignalTime = now;
+            anyReceiving = true;
+            sigpath::vfoManager.setCenterOffset(lane.vfo, lane.current - center);
+        }
+        reverseLock = false;
+
+        // Move the hardware to the next span once nothing is received in this one, unless it covers the whole range
+        if (anyReceiving || allIdleFound || (first == 0 && last == channelCount - 1)) { return; }
+        int next = scanUp ? last + 1 : first - 1;
+        if (next >= channelCount) { next = 0; }
+        if (next < 0) { next = channelCount - 1; }
+        double nextFreq = channelFreq(next);
+        double edge = (span - vfoWidth) / 2.0;
+        double newCenter = scanUp ? (nextFreq + edge) : (nextFreq - edge);
+        sigpath::sourceManager.tune(newCenter);
+        for (auto& lane : lanes) {
+            lane.current = nextFreq;
+            lane.newSpan = true;
+            sigpath::vfoManager.setCenterOffset(lane.vfo, nextFreq - newCenter);
+        }
+        tuning = true;
+    }
+
+    // Next active channel from the given one that no lane is receiving
+    int findActive(bool scanDir, int from, int first, int last) {
+        for (int i = from + (scanDir ? 1 : -1); i >= first && i <= last; i += scanDir ? 1 : -1) {
+            if (active[i] && !isHeld(i)) { return i; }
+        }
+        return -1;
     }
 
-    float getMaxLevel(float* data, double freq, double width, int dataWidth, double wfStart, double wfWidth) {
-        double low = freq - (width/2.0);
-        double high = freq + (width/2.0);
-        int lowId = std::clamp<int>((low - wfStart) * (double)dataWidth / wfWidth, 0, dataWidth - 1);
-        int highId = std::clamp<int>((high - wfStart) * (double)dataWidth / wfWidth, 0, dataWidth - 1);
-        float max = -INFINITY;
-        for (int i = lowId; i <= highId; i++) {
-            if (data[i] > max) { max = data[i]; }
+    bool isHeld(int id) {
+        for (auto& lane : lanes) {
+            if (lane.receiving && channelId(lane.current) == id) { return true; }
         }
-        return max;
+        return false;
+    }
+
+    double channelFreq(int id) {
+        return startFreq + (double)id * interval;
+    }
+
+    int channelId(double freq) {
+        return std::clamp<int>(round((freq - startFreq) / interval), 0, channelCount - 1);
     }
 
     std::string name;
     bool enabled = true;
-    
-    bool running = false;
-    //std::string selectedVFO = "Radio";
+    int mode = SCAN_MODE_SEQUENTIAL;
+    bool autostart = false;
+
+    std::atomic<bool> running = false;
+    std::set<std::string> vfoNames = { "Radio" };
     double startFreq = 88000000.0;
     double stopFreq = 108000000.0;
     double interval = 100000.0;
-    double current = 88000000.0;
     double passbandRatio = 10.0;
     int tuningTime = 250;
     int lingerTime = 1000.0;
     float level = -50.0;
-    bool receiving = true;
-    bool tuning = false;
+    float trigger = 10.0;
+    std::atomic<bool> tuning = false;
     bool scanUp = true;
     bool reverseLock = false;
-    std::chrono::time_point<std::chrono::high_resolution_clock> lastSignalTime;
-    std::chrono::time_point<std::chrono::high_resolution_clock> lastTuneTime;
+    int channelCount = 0;
+    std::vector<bool> active;
+    std::vector<Lane> lanes;
     std::thread workerThread;
     std::mutex scanMtx;
 };
 
 MOD_EXPORT void _INIT_() {
-    // Nothing here
+    config.setPath(core::args["root"].s() + "/scanner_config.json");
+    config.load(json::object());
+    config.enableAutoSave();
 }
 
 MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
@@ -303,5 +436,6 @@ MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
 }
 
 MOD_EXPORT void _END_() {
-    // Nothing here
-}
\ No newline at end of file
+    config.disableAutoSave();
+    config.save();
+}
@@ -1,5 +1,10 @@
 #pragma once
 #include <sched_action.h>
+#include <core.h>
+#include <recorder_interface.h>
+
+// Time by which the recorder's file is opened and its input started before the slot
+#define START_RECORDER_DEFAULT_PREWARM  0.3
 
 namespace sched_action {
     class StartRecorderClass : public ActionClass {
@@ -8,24 +13,78 @@ namespace sched_action {
         ~StartRecorderClass() {}
 
         void trigger() {
+            if (!recorderExists()) { return; }
+            core::modComManager.callInterface(recorderName, RECORDER_IFACE_CMD_START, NULL, NULL);
+        }
+
+        void prepare() {
+            if (!recorderExists()) { return; }
+            core::modComManager.callInterface(recorderName, RECORDER_IFACE_CMD_PREPARE, NULL, NULL);
+        }
+
+        void cancel() {
+            if (!recorderExists()) { return; }
+            core::modComManager.callInterface(recorderName, RECORDER_IFACE_CMD_UNPREPARE, NULL, NULL);
+        }
+
+        double getPrewarmTime() {
+            return prewarm;
         }
 
         void prepareEditMenu() {
+            tmpPrewarm = prewarm;
+
+            // Generate the list of recorders
+            recorderNameId = 0;
+            recorderNames.clear();
+            recorderNamesTxt.clear();
+            for (auto& [_name, inst] : core::moduleManager.instances) {
+                if (!core::modComManager.interfaceExists(_name) || core::modComManager.getModuleName(_name) != "recorder") { continue; }
+                if (_name == recorderName) { recorderNameId = recorderNames.size(); }
+                recorderNames.push_back(_name);
+                recorderNamesTxt += _name;
+                recorderNamesTxt += '\0';
+            }
         }
 
         bool showEditMenu(bool& valid) {
-            valid = false;
-            return false;
+            ImGui::LeftLabel("Recorder");
+            ImGui::SetNextItemWidth(250 - ImGui::GetCursorPosX());
+            ImGui::Combo("##scheduler_action_startrec_edit_rec", &recorderNameId, recorderNamesTxt.c_str());
+
+            ImGui::LeftLabel("Prewarm");
+            ImGui::SetNextItemWidth(250 - ImGui::GetCursorPosX());
+            ImGui::InputDouble("s##scheduler_action_startrec_edit_prewarm", &tmpPrewarm, 0.1, 1.0, "%.1f");
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Open the file and start the recorder's input this long before the slot");
+            }
+
+            if (ImGui::Button("Apply") && !recorderNames.empty()) {
+                recorderName = recorderNames[recorderNameId];
+                prewarm = std::clamp<double>(tmpPrewarm, 0.0, 10.0);
+                name = "Start \"" + recorderName + "\"";
+                valid = true;
+                return false;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel")) {
+                valid = false;
+                return false;
+            }
+
+            return true;
         }
 
         void loadFromConfig(json config) {
             if (config.contains("recorder")) { recorderName = config["recorder"]; }
+            if (config.contains("prewarm")) { prewarm = std::clamp<double>((double)config["prewarm"], 0.0, 10.0); }
             name = "Start \"" + recorderName + "\"";
         }
 
         json saveToConfig() {
             json config;
             config["recorder"] = recorderName;
+            config["prewarm"] = prewarm;
             return config;
         }
 
@@ -34,8 +93,24 @@ namespace sched_action {
             return name;
         }
 
+        std::string getType() {
+            return "start_recorder";
+        }
+
     private:
+        bool recorderExists() {
+            if (core::modComManager.interfaceExists(recorderName) && core::modComManager.getModuleName(recorderName) == "recorder") { return true; }
+            flog::error("Scheduler: no recorder named \"{0}\"", recorderName);
+            return false;
+        }
+
         std::string recorderName;
+        double prewarm = START_RECORDER_DEFAULT_PREWARM;
+
+        std::vector<std::string> recorderNames;
+        std::string recorderNamesTxt;
+        int recorderNameId = 0;
+        double tmpPrewarm;
 
         std::string name = "Start \"\"";
     };
@@ -91,6 +91,7 @@ namespace sched_action {
                 vfoName = vfoNames[vfoNameId];
                 frequency = tmpFrequency;
                 tuningMode = tuningModes[tuningModeId];
+                name = "Tune \"" + vfoName + "\" to " + utils::formatFreq(frequency);
                 valid = true;
                 return false;
             }
@@ -123,6 +124,10 @@ namespace sched_action {
             return name;
         }
 
+        std::string getType() {
+            return "tune_vfo";
+        }
+
     private:
         std::string tuningModesTxt;
         std::vector<std::string> vfoNames;
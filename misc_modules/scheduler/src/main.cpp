@@ -1,58 +1,71 @@
 #include <imgui.h>
 #include <module.h>
 #include <gui/gui.h>
+#include <core.h>
+#include <config.h>
 #include <sched_task.h>
+#include <sched_timer.h>
+#include <scheduler_interface.h>
 #include <map>
+#include <mutex>
 
 SDRPP_MOD_INFO{
     /* Name:            */ "scheduler",
     /* Description:     */ "SDR++ Scheduler",
     /* Author:          */ "Ryzerth",
-    /* Version:         */ 0, 1, 0,
+    /* Version:         */ 0, 2, 0,
     /* Max instances    */ -1
 };
 
-class DemoModule : public ModuleManager::Instance {
+ConfigManager config;
+
+// The tasks are armed on a timer that wakes up when the next action is due rather than polled, so that the module can
+// hold any number of them. Other modules can manage the tasks through the interface, without the GUI
+class SchedulerModule : public ModuleManager::Instance {
 public:
-    DemoModule(std::string name) {
+    SchedulerModule(std::string name) {
         this->name = name;
-        gui::menu.registerEntry(name, menuHandler, this, NULL);
-
-        Task t;
-        t.selected = false;
-
-        json recStartConfig;
-        recStartConfig["recorder"] = "Recorder";
 
-        json tuneVFOConfig;
-        tuneVFOConfig["vfo"] = "Radio";
-        tuneVFOConfig["frequency"] = 103500000.0;
-
-        auto recStart = sched_action::StartRecorder();
-        auto tuneVFO = sched_action::TuneVFO();
-
-        recStart->loadFromConfig(recStartConfig);
-        tuneVFO->loadFromConfig(tuneVFOConfig);
+        // Load the tasks
+        config.acquire();
+        bool created = false;
+        if (!config.conf.contains(name)) {
+            config.conf[name]["tasks"] = json::object();
+            created = true;
+        }
+        for (auto& [taskName, taskConfig] : config.conf[name]["tasks"].items()) {
+            tasks[taskName].loadFromConfig(taskConfig);
+        }
+        config.release(created);
 
-        t.addAction(tuneVFO);
-        t.addAction(recStart);
+        {
+            std::lock_guard<std::mutex> lck(tasksMtx);
+            armAll();
+        }
 
-        tasks["Test"] = t;
-        tasks["Another test"] = t;
+        gui::menu.registerEntry(name, menuHandler, this, NULL);
+        core::modComManager.registerInterface("scheduler", name, moduleInterfaceHandler, this);
     }
 
-    ~DemoModule() {
+    ~SchedulerModule() {
+        core::modComManager.unregisterInterface(name);
         gui::menu.removeEntry(name);
+        std::lock_guard<std::mutex> lck(tasksMtx);
+        disarmAll();
     }
 
     void postInit() {}
 
     void enable() {
+        std::lock_guard<std::mutex> lck(tasksMtx);
         enabled = true;
+        armAll();
     }
 
     void disable() {
+        std::lock_guard<std::mutex> lck(tasksMtx);
         enabled = false;
+        disarmAll();
     }
 
     bool isEnabled() {
@@ -60,8 +73,107 @@ public:
     }
 
 private:
+    // Schedule the first occurrence of the task after the given time, and the preparation of its actions before it.
+    // The handlers are tied to the generation of the task so that they do nothing once it was rearmed. tasksMtx must be held
+    void arm(const std::string& taskName, Task& task, double after) {
+        disarm(task);
+        if (!enabled || !task.enabled || !task.nextOccurrence(after, task.nextTime)) {
+            task.nextTime = 0.0;
+            return;
+        }
+        uint64_t gen = task.generation;
+        double prewarm = task.getPrewarmTime();
+        if (prewarm > 0.0) {
+            task.prepareId = timer.schedule(sched_timer::fromSeconds(task.nextTime - prewarm), [=]() { prepareTask(taskName, gen); });
+        }
+        task.triggerId = timer.schedule(sched_timer::fromSeconds(task.nextTime), [=]() { triggerTask(taskName, gen); });
+    }
+
+    void disarm(Task& task) {
+        if (task.prepareId) { timer.cancel(task.prepareId); }
+        if (task.triggerId) { timer.cancel(task.triggerId); }
+        if (task.prepared) { task.cancel(); }
+        task.prepareId = 0;
+        task.triggerId = 0;
+        task.prepared = false;
+        task.nextTime = 0.0;
+        task.generation++;
+    }
+
+    void armAll() {
+        double now = sched_timer::now();
+        for (auto& [taskName, task] : tasks) {
+            arm(taskName, task, now);
+        }
+    }
+
+    void disarmAll() {
+        for (auto& [taskName, task] : tasks) {
+            disarm(task);
+        }
+    }
+
+    void prepareTask(std::string taskName, uint64_t gen) {
+        std::vector<sched_action::Action> actions;
+        {
+            std::lock_guard<std::mutex> lck(tasksMtx);
+            auto it = tasks.find(taskName);
+            if (it == tasks.end() || it->second.generation != gen) { return; }
+            it->second.prepareId = 0;
+            it->second.prepared = true;
+            actions = it->second.getActions();
+        }
+        flog::info("Scheduler: preparing \"{0}\"", taskName);
+        for (auto& act : actions) {
+            act->prepare();
+        }
+    }
+
+    void triggerTask(std::string taskName, uint64_t gen) {
+        std::vector<sched_action::Action> actions;
+        {
+            std::lock_guard<std::mutex> lck(tasksMtx);
+            auto it = tasks.find(taskName);
+            if (it == tasks.end() || it->second.generation != gen) { return; }
+            Task& task = it->second;
+            actions = task.getActions();
+
+            // Arm the next occurrence, skipping those missed while the timer was late, the actions being run after that
+            task.prepared = false;
+            task.triggerId = 0;
+            arm(taskName, task, std::max<double>(task.nextTime, sched_timer::now()));
+        }
+        flog::info("Scheduler: triggering \"{0}\"", taskName);
+        for (auto& act : actions) {
+            act->trigger();
+        }
+    }
+
+    // tasksMtx must be held
+    void saveTasks() {
+        config.acquire();
+        config.conf[name]["tasks"] = json::object();
+        for (auto& [taskName, task] : tasks) {
+            config.conf[name]["tasks"][taskName] = task.saveToConfig();
+        }
+        config.release(true);
+    }
+
+    static std::string formatCountdown(double left) {
+        char buf[64];
+        int secs = std::max<int>(ceil(left), 0);
+        if (secs >= 86400) {
+            sprintf(buf, "%dd %02d:%02d:%02d", secs / 86400, (secs / 3600) % 24, (secs / 60) % 60, secs % 60);
+        }
+        else {
+            sprintf(buf, "%02d:%02d:%02d", secs / 3600, (secs / 60) % 60, secs % 60);
+        }
+        return buf;
+    }
+
     static void menuHandler(void* ctx) {
-        DemoModule* _this = (DemoModule*)ctx;
+        SchedulerModule* _this = (SchedulerModule*)ctx;
+        std::lock_guard<std::mutex> lck(_this->tasksMtx);
 
         // If editing, show menu
         if (!_this->editedTask.empty()) {
@@ -74,11 +186,20 @@ private:
 
                 // Stop editing of closed
                 if (!open) {
-                    // Rename if name changed and valid
-                    if (valid && strcmp(_this->editedName, _this->editedTask.c_str())) {
-                        Task task = _this->tasks[_this->editedTask];
-                        _this->tasks.erase(_this->editedTask);
-                        _this->tasks[_this->editedName] = task;
+                    if (valid) {
+                        // Rename if name changed, the timer handlers being bound to the name
+                        std::string taskName = _this->editedTask;
+                        if (strcmp(_this->editedName, _this->editedTask.c_str()) && !_this->tasks.count(_this->editedName)) {
+                            _this->disarm(_this->tasks[taskName]);
+                            Task task = _this->tasks[taskName];
+                            _this->tasks.erase(taskName);
+                            taskName = _this->editedName;
+                            _this->tasks[taskName] = task;
+                        }
+
+                        // Apply the new schedule
+                        _this->arm(taskName, _this->tasks[taskName], sched_timer::now());
+                        _this->saveTasks();
                     }
 
                     // Stop showing edit window
@@ -89,57 +210,124 @@ private:
             }
         }
 
-        if (ImGui::BeginTable(("freq_manager_bkm_table" + _this->name).c_str(), 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
+        double now = sched_timer::now();
+        if (ImGui::BeginTable(("scheduler_task_table" + _this->name).c_str(), 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
             ImGui::TableSetupColumn("Name");
             ImGui::TableSetupColumn("Countdown");
             ImGui::TableSetupScrollFreeze(2, 1);
             ImGui::TableHeadersRow();
-            for (auto& [name, bm] : _this->tasks) {
+            for (auto& [name, task] : _this->tasks) {
                 ImGui::TableNextRow();
                 ImGui::TableSetColumnIndex(0);
 
-                if (ImGui::Selectable((name + "##_freq_mgr_bkm_name_" + _this->name).c_str(), &bm.selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_SelectOnClick)) {
+                if (ImGui::Selectable((name + "##_scheduler_task_name_" + _this->name).c_str(), &task.selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_SelectOnClick)) {
                     // if shift or control isn't pressed, deselect all others
                     if (!ImGui::GetIO().KeyShift && !ImGui::GetIO().KeyCtrl) {
-                        for (auto& [_name, _bm] : _this->tasks) {
+                        for (auto& [_name, _task] : _this->tasks) {
                             if (name == _name) { continue; }
-                            _bm.selected = false;
+                            _task.selected = false;
                         }
                     }
                 }
                 if (ImGui::TableGetHoveredColumn() >= 0 && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left) && _this->editedTask.empty()) {
                     _this->editedTask = name;
                     strcpy(_this->editedName, name.c_str());
+                    task.prepareEditMenu();
                 }
 
                 ImGui::TableSetColumnIndex(1);
-                ImGui::TextUnformatted("todo");
+                if (task.nextTime <= 0.0) {
+                    ImGui::TextUnformatted(task.enabled ? "Done" : "Disabled");
+                }
+                else {
+                    ImGui::TextUnformatted(formatCountdown(task.nextTime - now).c_str());
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::SetTooltip("%s", Task::formatTime(task.nextTime).c_str());
+                    }
+                }
             }
             ImGui::EndTable();
         }
     }
 
+    static void moduleInterfaceHandler(int code, void* in, void* out, void* ctx) {
+        SchedulerModule* _this = (SchedulerModule*)ctx;
+        std::lock_guard<std::mutex> lck(_this->tasksMtx);
+        if (code == SCHEDULER_IFACE_CMD_ADD_TASK) {
+            const json& taskConfig = *(const json*)in;
+            if (!taskConfig.contains("name")) { return; }
+            std::string taskName = taskConfig["name"];
+            if (taskName.empty() || taskName == _this->editedTask) { return; }
+            auto it = _this->tasks.find(taskName);
+            if (it != _this->tasks.end()) { _this->disarm(it->second); }
+            Task& task = _this->tasks[taskName];
+            task.loadFromConfig(taskConfig);
+            _this->arm(taskName, task, sched_timer::now());
+            _this->saveTasks();
+        }
+        else if (code == SCHEDULER_IFACE_CMD_REMOVE_TASK) {
+            const std::string& taskName = *(const std::string*)in;
+            auto it = _this->tasks.find(taskName);
+            if (it == _this->tasks.end()) { return; }
+            if (taskName == _this->editedTask) { _this->editedTask.clear(); }
+            _this->disarm(it->second);
+            _this->tasks.erase(it);
+            _this->saveTasks();
+        }
+        else if (code == SCHEDULER_IFACE_CMD_LIST_TASKS) {
+            std::vector<std::string>* _out = (std::vector<std::string>*)out;
+            _out->clear();
+            for (auto& [taskName, task] : _this->tasks) {
+                _out->push_back(taskName);
+            }
+        }
+        else if (code == SCHEDULER_IFACE_CMD_GET_TASK) {
+            const std::string& taskName = *(const std::string*)in;
+            json* _out = (json*)out;
+            auto it = _this->tasks.find(taskName);
+            if (it == _this->tasks.end()) {
+                *_out = nullptr;
+                return;
+            }
+            *_out = it->second.saveToConfig();
+            (*_out)["name"] = taskName;
+        }
+        else if (code == SCHEDULER_IFACE_CMD_GET_NEXT_TIME) {
+            const std::string& taskName = *(const std::string*)in;
+            double* _out = (double*)out;
+            auto it = _this->tasks.find(taskName);
+            *_out = (it == _this->tasks.end()) ? 0.0 : it->second.nextTime;
+        }
+    }
+
     std::string name;
     bool enabled = true;
 
     std::string editedTask = "";
     char editedName[1024];
 
+    std::mutex tasksMtx;
     std::map<std::string, Task> tasks;
+
+    // Last so that its thread is stopped before the tasks are destroyed
+    sched_timer::Timer timer;
 };
 
 MOD_EXPORT void _INIT_() {
-    // Nothing here
+    config.setPath(core::args["root"].s() + "/scheduler_config.json");
+    config.load(json::object());
+    config.enableAutoSave();
 }
 
 MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
-    return new DemoModule(name);
+    return new SchedulerModule(name);
 }
 
 MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
-    delete (DemoModule*)instance;
+    delete (SchedulerModule*)instance;
 }
 
 MOD_EXPORT void _END_() {
-    // Nothing here
-}
\ No newline at end of file
+    config.disableAutoSave();
+    config.save();
+}
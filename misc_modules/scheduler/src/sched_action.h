@@ -10,11 +10,20 @@ namespace sched_action {
     public:
         virtual ~ActionClass(){};
         virtual void trigger() = 0;
+
+        // Called getPrewarmTime() seconds before trigger() for actions that take time to get ready
+        virtual void prepare() {}
+        virtual double getPrewarmTime() { return 0.0; }
+
+        // Called instead of trigger() when the task of a prepared action was cancelled
+        virtual void cancel() {}
+
         virtual void prepareEditMenu() = 0;
         virtual bool showEditMenu(bool& valid) = 0;
         virtual void loadFromConfig(json config) = 0;
         virtual json saveToConfig() = 0;
         virtual std::string getName() = 0;
+        virtual std::string getType() = 0;
 
         virtual bool isValid() {
             return valid;
@@ -30,4 +39,13 @@ namespace sched_action {
 }
 
 #include <actions/start_recorder.h>
-#include <actions/tune_vfo.h>
\ No newline at end of file
+#include <actions/tune_vfo.h>
+
+namespace sched_action {
+    // Create an action from its type as saved in the config, NULL if the type is unknown
+    inline Action create(std::string type) {
+        if (type == "start_recorder") { return StartRecorder(); }
+        if (type == "tune_vfo") { return TuneVFO(); }
+        return NULL;
+    }
+}
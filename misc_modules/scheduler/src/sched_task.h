@@ -1,17 +1,67 @@
 #pragma once
 #include <vector>
+#include <ctime>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
 #include <imgui.h>
 #include <gui/style.h>
+#include <utils/optionlist.h>
 #include <sched_action.h>
 
+#define TASK_TIME_FORMAT    "%Y-%m-%d %H:%M:%S"
+
 class Task {
 public:
+    Task() {
+        repeats.define(0, "Once", 0);
+        repeats.define(3600, "Every hour", 3600);
+        repeats.define(86400, "Every day", 86400);
+        repeats.define(604800, "Every week", 604800);
+    }
+
     void trigger() {
         for (auto& act : actions) {
             act->trigger();
         }
     }
 
+    void prepare() {
+        for (auto& act : actions) {
+            act->prepare();
+        }
+    }
+
+    void cancel() {
+        for (auto& act : actions) {
+            act->cancel();
+        }
+    }
+
+    // Time needed by the slowest action to get ready
+    double getPrewarmTime() {
+        double prewarm = 0.0;
+        for (auto& act : actions) {
+            prewarm = std::max<double>(prewarm, act->getPrewarmTime());
+        }
+        return prewarm;
+    }
+
+    // First occurrence strictly after the given time, false if there is none left
+    bool nextOccurrence(double after, double& next) {
+        if (start > after) {
+            next = start;
+            return true;
+        }
+        if (interval <= 0) { return false; }
+        next = start + (floor((after - start) / (double)interval) + 1.0) * (double)interval;
+        return true;
+    }
+
+    std::vector<sched_action::Action> getActions() {
+        return actions;
+    }
+
     void addAction(sched_action::Action act) {
         actions.push_back(act);
     }
@@ -27,6 +77,64 @@ public:
         for (auto& act : actions) {
             act->selected = false;
         }
+        strcpy(editStart, formatTime(start).c_str());
+        repeatId = repeats.keyExists(interval) ? repeats.keyId(interval) : 0;
+        editEnabled = enabled;
+        startError = false;
+    }
+
+    void loadFromConfig(json config) {
+        if (config.contains("start")) { start = config["start"]; }
+        if (config.contains("interval")) { interval = std::max<int>((int)config["interval"], 0); }
+        if (config.contains("enabled")) { enabled = config["enabled"]; }
+        actions.clear();
+        if (!config.contains("actions")) { return; }
+        for (auto& a : config["actions"]) {
+            if (!a.contains("type")) { continue; }
+            auto act = sched_action::create(a["type"]);
+            if (!act) {
+                flog::error("Scheduler: unknown action type \"{0}\"", (std::string)a["type"]);
+                continue;
+            }
+            if (a.contains("config")) { act->loadFromConfig(a["config"]); }
+            actions.push_back(act);
+        }
+    }
+
+    json saveToConfig() {
+        json config;
+        config["start"] = start;
+        config["interval"] = interval;
+        config["enabled"] = enabled;
+        config["actions"] = json::array();
+        for (auto& act : actions) {
+            json a;
+            a["type"] = act->getType();
+            a["config"] = act->saveToConfig();
+            config["actions"].push_back(a);
+        }
+        return config;
+    }
+
+    // Local time, the format used by the edit menu
+    static std::string formatTime(double t) {
+        time_t _t = (time_t)t;
+        tm* ltm = localtime(&_t);
+        char buf[64];
+        strftime(buf, sizeof(buf), TASK_TIME_FORMAT, ltm);
+        return buf;
+    }
+
+    static bool parseTime(const char* str, double& t) {
+        tm ltm = {};
+        std::istringstream ss(str);
+        ss >> std::get_time(&ltm, TASK_TIME_FORMAT);
+        if (ss.fail()) { return false; }
+        ltm.tm_isdst = -1;
+        time_t _t = mktime(&ltm);
+        if (_t == (time_t)-1) { return false; }
+        t = (double)_t;
+        return true;
     }
 
     bool showEditMenu(char* name, bool& valid) {
@@ -52,17 +160,16 @@ public:
             }
         }
 
-        if (ImGui::BeginTable("scheduler_task_triggers", 1, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 100.0f * style::uiScale))) {
-            ImGui::TableSetupColumn("Triggers");
-            ImGui::TableSetupScrollFreeze(1, 1);
-            ImGui::TableHeadersRow();
-
-            // Fill rows here
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0);
-            ImGui::TextUnformatted("Every day at 00:00:00");
-
-            ImGui::EndTable();
+        ImGui::LeftLabel("Start");
+        ImGui::InputText("##scheduler_task_edit_start", editStart, sizeof(editStart) - 1);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Local time, YYYY-MM-DD HH:MM:SS");
+        }
+        ImGui::LeftLabel("Repeat");
+        ImGui::Combo("##scheduler_task_edit_repeat", &repeatId, repeats.txt);
+        ImGui::Checkbox("Enabled##scheduler_task_edit_enabled", &editEnabled);
+        if (startError) {
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Invalid start time");
         }
 
         if (ImGui::BeginTable("scheduler_task_actions", 1, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 100.0f * style::uiScale))) {
@@ -100,8 +207,15 @@ public:
         }
 
         if (ImGui::Button("Apply")) {
-            valid = true;
-            return false;
+            double t;
+            startError = !parseTime(editStart, t);
+            if (!startError) {
+                start = t;
+                interval = repeats.key(repeatId);
+                enabled = editEnabled;
+                valid = true;
+                return false;
+            }
         }
         ImGui::SameLine();
         if (ImGui::Button("Cancel")) {
@@ -114,8 +228,26 @@ public:
 
     bool selected;
 
+    // Seconds since the epoch of the first occurrence, repeated every interval seconds unless it's 0
+    double start = 0.0;
+    int interval = 0;
+    bool enabled = true;
+
+    // Scheduling state, kept up to date by the module
+    double nextTime = 0.0;
+    uint64_t prepareId = 0;
+    uint64_t triggerId = 0;
+    uint64_t generation = 0;
+    bool prepared = false;
+
 private:
     std::vector<sched_action::Action> actions;
 
     int editedAction = -1;
+
+    OptionList<int, int> repeats;
+    char editStart[64];
+    int repeatId = 0;
+    bool editEnabled = true;
+    bool startError = false;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+#include <functional>
+#include <queue>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <stdint.h>
+
+namespace sched_timer {
+    typedef std::chrono::system_clock::time_point TimePoint;
+
+    // Times in seconds since the epoch, as saved in the config
+    inline TimePoint fromSeconds(double t) {
+        return TimePoint(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(t)));
+    }
+
+    inline double now() {
+        return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Runs handlers at given times from a thread of its own. The pending events are kept in a min-heap ordered by time
+    // and the thread sleeps until the earliest one is due or an earlier one is added, so that any number of events costs
+    // nothing until they are due. Cancelled events are left in the heap and skipped when they come up
+    class Timer {
+    public:
+        Timer() {
+            workerThread = std::thread(&Timer::worker, this);
+        }
+
+        ~Timer() {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                running = false;
+            }
+            cnd.notify_all();
+            if (workerThread.joinable()) { workerThread.join(); }
+        }
+
+        // Events due at the same time run in the order they were scheduled, those in the past run right away.
+        // Returns the id of the event, never 0
+        uint64_t schedule(TimePoint when, std::function<void()> handler) {
+            uint64_t id;
+            bool earliest;
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                id = ++lastId;
+                earliest = (queue.empty() || when < queue.top().time);
+                queue.push({ when, id });
+                handlers[id] = std::move(handler);
+            }
+            if (earliest) { cnd.notify_all(); }
+            return id;
+        }
+
+        // Returns false if the event already ran or doesn't exist
+        bool cancel(uint64_t id) {
+            std::lock_guard<std::mutex> lck(mtx);
+            if (!handlers.erase(id)) { return false; }
+
+            // Rebuild the heap when it's mostly made of cancelled events
+            if (queue.size() > 64 && queue.size() > 2 * handlers.size()) {
+                std::vector<Event> events;
+                events.reserve(handlers.size());
+                while (!queue.empty()) {
+                    if (handlers.count(queue.top().id)) { events.push_back(queue.top()); }
+                    queue.pop();
+                }
+                queue = EventQueue(std::greater<Event>(), std::move(events));
+            }
+            return true;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lck(mtx);
+            queue = EventQueue();
+            handlers.clear();
+        }
+
+        int pending() {
+            std::lock_guard<std::mutex> lck(mtx);
+            return handlers.size();
+        }
+
+    private:
+        struct Event {
+            TimePoint time;
+            uint64_t id;
+
+            bool operator>(const Event& b) const {
+                return (time == b.time) ? (id > b.id) : (time > b.time);
+            }
+        };
+
+        typedef std::priority_queue<Event, std::vector<Event>, std::greater<Event>> EventQueue;
+
+        void worker() {
+            std::unique_lock<std::mutex> lck(mtx);
+            while (running) {
+                // Drop the cancelled events
+                while (!queue.empty() && !handlers.count(queue.top().id)) { queue.pop(); }
+
+                // Sleep until the next event is due, waking up again if an earlier one was added
+                if (queue.empty()) {
+                    cnd.wait(lck);
+                    continue;
+                }
+                TimePoint due = queue.top().time;
+                if (std::chrono::system_clock::now() < due) {
+                    cnd.wait_until(lck, due);
+                    continue;
+                }
+
+                // Run the handler without the lock so that it can schedule other events
+                auto it = handlers.find(queue.top().id);
+                std::function<void()> handler = std::move(it->second);
+                handlers.erase(it);
+                queue.pop();
+                lck.unlock();
+                handler();
+                lck.lock();
+            }
+        }
+
+        std::mutex mtx;
+        std::condition_variable cnd;
+        EventQueue queue;
+        std::unordered_map<uint64_t, std::function<void()>> handlers;
+        uint64_t lastId = 0;
+        bool running = true;
+        std::thread workerThread;
+    };
+}
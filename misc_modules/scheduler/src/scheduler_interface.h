@@ -0,0 +1,11 @@
+#pragma once
+
+// Tasks are passed as json in the format they have in the config:
+// { "name": ..., "start": seconds since the epoch, "interval": seconds or 0 for once, "enabled": ..., "actions": [ { "type": ..., "config": { ... } } ] }
+enum {
+    SCHEDULER_IFACE_CMD_ADD_TASK,       // in: const json*, replaces any task of the same name
+    SCHEDULER_IFACE_CMD_REMOVE_TASK,    // in: const std::string*
+    SCHEDULER_IFACE_CMD_LIST_TASKS,     // out: std::vector<std::string>*
+    SCHEDULER_IFACE_CMD_GET_TASK,       // in: const std::string*, out: json*, null if there's no such task
+    SCHEDULER_IFACE_CMD_GET_NEXT_TIME   // in: const std::string*, out: double*, 0 if the task won't run again
+};
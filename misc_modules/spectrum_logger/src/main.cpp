@@ -0,0 +1,492 @@
+#include <imgui.h>
+#include <module.h>
+#include <config.h>
+#include <core.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <gui/widgets/folder_select.h>
+#include <signal_path/signal_path.h>
+#include <dsp/fft/spectrum.h>
+#include <utils/optionlist.h>
+#include <utils/spectrum_archive.h>
+#include <utils/flog.h>
+#include <filesystem>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <time.h>
+#include <math.h>
+
+#define CONCAT(a, b) ((std::string(a) + b).c_str())
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "spectrum_logger",
+    /* Description:     */ "Long term spectrum logger",
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ 1
+};
+
+ConfigManager config;
+
+class SpectrumLoggerModule : public ModuleManager::Instance {
+public:
+    SpectrumLoggerModule(std::string name) : folderSelect("%ROOT%/spectrum") {
+        this->name = name;
+
+        // Define the sizes
+        for (int i = 1024; i <= 65536; i <<= 1) { fftSizes.define(i, std::to_string(i), i); }
+        for (int i = 256; i <= 8192; i <<= 1) { binCounts.define(i, std::to_string(i), i); }
+
+        // Define the spans shown when browsing
+        spans.define(600, "10 minutes", 600.0);
+        spans.define(3600, "1 hour", 3600.0);
+        spans.define(6 * 3600, "6 hours", 6.0 * 3600.0);
+        spans.define(24 * 3600, "24 hours", 24.0 * 3600.0);
+
+        // Load config
+        bool autoStart = false;
+        fftSizeId = fftSizes.valueId(8192);
+        binsId = binCounts.valueId(1024);
+        spanId = spans.valueId(3600.0);
+        config.acquire();
+        if (config.conf[name].contains("path")) {
+            folderSelect.setPath(config.conf[name]["path"]);
+        }
+        if (config.conf[name].contains("fftSize")) {
+            int size = config.conf[name]["fftSize"];
+            if (fftSizes.keyExists(size)) { fftSizeId = fftSizes.keyId(size); }
+        }
+        if (config.conf[name].contains("bins")) {
+            int bins = config.conf[name]["bins"];
+            if (binCounts.keyExists(bins)) { binsId = binCounts.keyId(bins); }
+        }
+        if (config.conf[name].contains("interval")) {
+            interval = std::clamp<int>(config.conf[name]["interval"], 1, 3600);
+        }
+        if (config.conf[name].contains("fftRate")) {
+            fftRate = std::clamp<int>(config.conf[name]["fftRate"], 1, 100);
+        }
+        if (config.conf[name].contains("logging")) {
+            autoStart = config.conf[name]["logging"];
+        }
+        config.release();
+
+        retuneHandler.handler = onRetune;
+        retuneHandler.ctx = this;
+
+        // Start if needed
+        if (autoStart) { start(); }
+
+        gui::menu.registerEntry(name, menuHandler, this, this);
+    }
+
+    ~SpectrumLoggerModule() {
+        gui::menu.removeEntry(name);
+        stop();
+        if (browsing) { backToLive(); }
+    }
+
+    void postInit() {}
+
+    void enable() {
+        if (wasLogging) { start(); }
+        enabled = true;
+    }
+
+    void disable() {
+        wasLogging = logging;
+        stop();
+        if (browsing) { backToLive(); }
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    void start() {
+        if (logging) { return; }
+        if (!folderSelect.pathIsValid()) {
+            flog::error("[SpectrumLogger] Invalid archive directory");
+            return;
+        }
+
+        // The lines are taken from an IQ stream of the front end, which can drop buffers if the logger is late
+        fftSize = fftSizes.value(fftSizeId);
+        bins = std::min<int>(binCounts.value(binsId), fftSize);
+        frequency = gui::waterfall.getCenterFrequency();
+        sigpath::sourceManager.onRetune.bindHandler(&retuneHandler);
+        sigpath::iqFrontEnd.bindIQStream(&iqStream, dsp::routing::BACKPRESSURE_DROP_OLDEST);
+        logging = true;
+        filesScanned = false;
+        workerThread = std::thread(&SpectrumLoggerModule::worker, this);
+    }
+
+    void stop() {
+        if (!logging) { return; }
+        iqStream.stopReader();
+        if (workerThread.joinable()) { workerThread.join(); }
+        iqStream.clearReadStop();
+        sigpath::iqFrontEnd.unbindIQStream(&iqStream);
+        sigpath::sourceManager.onRetune.unbindHandler(&retuneHandler);
+        writer.close();
+        fileDay = "";
+        logging = false;
+        filesScanned = false;
+    }
+
+private:
+    static void menuHandler(void* ctx) {
+        SpectrumLoggerModule* _this = (SpectrumLoggerModule*)ctx;
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        if (_this->logging) { style::beginDisabled(); }
+        if (_this->folderSelect.render("##_spectrum_logger_fold_" + _this->name)) {
+            if (_this->folderSelect.pathIsValid()) {
+                config.acquire();
+                config.conf[_this->name]["path"] = _this->folderSelect.path;
+                config.release(true);
+                _this->refreshFiles();
+            }
+        }
+
+        ImGui::LeftLabel("FFT Size");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##_spectrum_logger_fft_", _this->name), &_this->fftSizeId, _this->fftSizes.txt)) {
+            config.acquire();
+            config.conf[_this->name]["fftSize"] = _this->fftSizes.key(_this->fftSizeId);
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("Bins");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##_spectrum_logger_bins_", _this->name), &_this->binsId, _this->binCounts.txt)) {
+            config.acquire();
+            config.conf[_this->name]["bins"] = _this->binCounts.key(_this->binsId);
+            config.release(true);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Bins of the logged lines, each keeping the highest and the mean level of the FFT bins it covers");
+        }
+
+        ImGui::LeftLabel("Interval (s)");
+        ImGui::FillWidth();
+        if (ImGui::InputInt(CONCAT("##_spectrum_logger_interval_", _this->name), &_this->interval, 1, 10)) {
+            _this->interval = std::clamp<int>(_this->interval, 1, 3600);
+            config.acquire();
+            config.conf[_this->name]["interval"] = _this->interval;
+            config.release(true);
+        }
+
+        ImGui::LeftLabel("FFT Rate");
+        ImGui::FillWidth();
+        if (ImGui::InputInt(CONCAT("##_spectrum_logger_rate_", _this->name), &_this->fftRate, 1, 10)) {
+            _this->fftRate = std::clamp<int>(_this->fftRate, 1, 100);
+            config.acquire();
+            config.conf[_this->name]["fftRate"] = _this->fftRate;
+            config.release(true);
+        }
+        if (_this->logging) { style::endDisabled(); }
+
+        if (!_this->logging) {
+            if (ImGui::Button(CONCAT("Start##_spectrum_logger_start_", _this->name), ImVec2(menuWidth, 0))) {
+                _this->start();
+                config.acquire();
+                config.conf[_this->name]["logging"] = _this->logging;
+                config.release(true);
+            }
+        }
+        else {
+            if (ImGui::Button(CONCAT("Stop##_spectrum_logger_stop_", _this->name), ImVec2(menuWidth, 0))) {
+                _this->stop();
+                config.acquire();
+                config.conf[_this->name]["logging"] = false;
+                config.release(true);
+            }
+            ImGui::Text("Lines: %llu", (unsigned long long)_this->writer.getLinesWritten());
+            ImGui::Text("Written: %.1f KB", (double)_this->writer.getBytesWritten() / 1024.0);
+        }
+
+        // Browse the archives back into the waterfall
+        ImGui::Spacing();
+        ImGui::TextUnformatted("Archive");
+        if (!_this->filesScanned) { _this->refreshFiles(); }
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##_spectrum_logger_file_", _this->name), &_this->fileId, _this->filesTxt.c_str())) {
+            _this->openArchive();
+        }
+        if (ImGui::Button(CONCAT("Refresh##_spectrum_logger_refresh_", _this->name), ImVec2(menuWidth, 0))) {
+            _this->refreshFiles();
+        }
+        if (!_this->reader) { return; }
+
+        double first = _this->reader->getStartTime();
+        double last = _this->reader->getEndTime();
+        ImGui::Text("From %s", formatTime(first).c_str());
+        ImGui::Text("To   %s", formatTime(last).c_str());
+
+        ImGui::LeftLabel("Span");
+        ImGui::FillWidth();
+        ImGui::Combo(CONCAT("##_spectrum_logger_span_", _this->name), &_this->spanId, _this->spans.txt);
+
+        // Position of the end of the span within the archive
+        ImGui::LeftLabel("End");
+        ImGui::FillWidth();
+        if (ImGui::SliderFloat(CONCAT("##_spectrum_logger_pos_", _this->name), &_this->position, 0.0f, 1.0f, formatTime(first + (last - first) * _this->position).c_str())) {
+            if (_this->browsing) { _this->showArchive(); }
+        }
+
+        if (ImGui::Checkbox(CONCAT("Mean levels##_spectrum_logger_mean_", _this->name), &_this->showMean)) {
+            if (_this->browsing) { _this->showArchive(); }
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Show the mean level of each bin instead of the highest one");
+        }
+
+        if (ImGui::Button(CONCAT("Show##_spectrum_logger_show_", _this->name), ImVec2(menuWidth / 2.0f, 0))) {
+            _this->showArchive();
+        }
+        ImGui::SameLine();
+        if (!_this->browsing) { style::beginDisabled(); }
+        if (ImGui::Button(CONCAT("Live##_spectrum_logger_live_", _this->name), ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
+            _this->backToLive();
+        }
+        if (!_this->browsing) { style::endDisabled(); }
+    }
+
+    static std::string formatTime(double t) {
+        time_t tt = t;
+        char buf[64];
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S UTC", gmtime(&tt));
+        return buf;
+    }
+
+    static void onRetune(double freq, void* ctx) {
+        SpectrumLoggerModule* _this = (SpectrumLoggerModule*)ctx;
+        _this->frequency = freq;
+        _this->retuned = true;
+    }
+
+    void worker() {
+        dsp::fft::Spectrum spectrum;
+        std::vector<float> frame(fftSize);
+        std::vector<float> maxLevels(bins);
+        std::vector<float> meanLevels(bins);
+        std::vector<float> powerSum(bins);
+        int group = fftSize / bins;
+        int frames = 0;
+        double samplerate = 0.0;
+        double lineStart = 0.0;
+
+        while (true) {
+            int count = iqStream.read();
+            if (count < 0) { break; }
+
+            // The line being accumulated is dropped when the band changes
+            double sr = sigpath::iqFrontEnd.getEffectiveSamplerate();
+            if (sr != samplerate || retuned.exchange(false)) {
+                samplerate = sr;
+                spectrum.init(fftSize, samplerate, fftRate);
+                frames = 0;
+            }
+            if (!frames) {
+                std::fill(maxLevels.begin(), maxLevels.end(), -INFINITY);
+                std::fill(powerSum.begin(), powerSum.end(), 0.0f);
+                lineStart = sigpath::streamClock.now();
+            }
+
+            spectrum.feed(iqStream.readBuf, count);
+            iqStream.flush();
+
+            // Reduce the spectrum to the bins of the line, the mean being that of the power
+            if (spectrum.read(frame.data())) {
+                for (int i = 0; i < bins; i++) {
+                    const float* in = &frame[i * group];
+                    float level = in[0];
+                    float power = 0.0f;
+                    for (int j = 0; j < group; j++) {
+                        level = std::max<float>(level, in[j]);
+                        power += powf(10.0f, in[j] * 0.1f);
+                    }
+                    maxLevels[i] = std::max<float>(maxLevels[i], level);
+                    powerSum[i] += power;
+                }
+                frames++;
+            }
+
+            // Write the line once it covers the interval, starting a new file every day
+            double now = sigpath::streamClock.now();
+            if (!frames || now - lineStart < interval) { continue; }
+            float norm = 1.0f / (float)(frames * group);
+            for (int i = 0; i < bins; i++) { meanLevels[i] = 10.0f * log10f(std::max<float>(powerSum[i] * norm, 1e-30f)); }
+            if (openFile(now)) { writer.write(now, frequency, samplerate, maxLevels.data(), meanLevels.data()); }
+            frames = 0;
+        }
+    }
+
+    bool openFile(double now) {
+        char day[32];
+        time_t t = now;
+        strftime(day, sizeof(day), "%Y-%m-%d", gmtime(&t));
+        if (writer.isOpen() && fileDay == day) { return true; }
+
+        // Archives of the same day with other settings are kept, the new lines going to another file
+        std::string base = folderSelect.expandString(folderSelect.path) + "/spectrum_" + day;
+        for (int i = 0; i < 100; i++) {
+            std::string path = base + (i ? "_" + std::to_string(i) : "") + ".spa";
+            if (!writer.open(path, bins, interval)) { continue; }
+            fileDay = day;
+            flog::info("[SpectrumLogger] Logging to {0}", path);
+            return true;
+        }
+        flog::error("[SpectrumLogger] Could not open an archive for {0}", day);
+        fileDay = "";
+        return false;
+    }
+
+    void refreshFiles() {
+        files.clear();
+        filesTxt = "";
+        std::string dir = folderSelect.expandString(folderSelect.path);
+        std::error_code ec;
+        if (folderSelect.pathIsValid()) {
+            for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+                if (entry.path().extension() == ".spa") { files.push_back(entry.path().string()); }
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for (const auto& f : files) {
+            filesTxt += std::filesystem::path(f).filename().string();
+            filesTxt += '\0';
+        }
+        fileId = std::clamp<int>(fileId, 0, std::max<int>((int)files.size() - 1, 0));
+        filesScanned = true;
+        openArchive();
+    }
+
+    void openArchive() {
+        reader.reset();
+        if (fileId >= files.size()) { return; }
+        try {
+            reader = std::make_unique<spectrum_archive::Reader>(files[fileId]);
+        }
+        catch (const std::exception& e) {
+            flog::error("[SpectrumLogger] Could not open {0}: {1}", files[fileId], e.what());
+        }
+    }
+
+    void showArchive() {
+        if (!reader) { return; }
+        int height = gui::waterfall.getHistoryLines();
+        if (!height) { return; }
+
+        // Read the span ending at the selected position, merged to the height of the waterfall
+        double first = reader->getStartTime();
+        double end = first + ((reader->getEndTime() - first) * position);
+        std::vector<spectrum_archive::Line> lines;
+        if (!reader->read(end - spans.value(spanId), end, lines, height)) { return; }
+
+        // The waterfall shows the band of the newest line, its normal spectrum being suspended meanwhile
+        if (!browsing) {
+            savedFFTEnabled = sigpath::iqFrontEnd.isFFTEnabled();
+            savedCenter = gui::waterfall.getCenterFrequency();
+            savedViewBandwidth = gui::waterfall.getViewBandwidth();
+            savedViewOffset = gui::waterfall.getViewOffset();
+            sigpath::iqFrontEnd.setFFTEnabled(false);
+            browsing = true;
+        }
+        const spectrum_archive::Line& newest = lines.back();
+        gui::waterfall.setBandwidth(newest.bandwidth);
+        gui::waterfall.setViewBandwidth(newest.bandwidth);
+        gui::waterfall.setViewOffset(0.0);
+        gui::waterfall.setCenterFrequency(newest.frequency);
+
+        // The waterfall only takes lines of the size of the FFT of the IQ front end, the newest first
+        int size = sigpath::iqFrontEnd.getFFTSize();
+        int lineBins = reader->getBins();
+        std::vector<float> buf((size_t)lines.size() * size);
+        for (int l = 0; l < lines.size(); l++) {
+            const std::vector<float>& levels = showMean ? lines[lines.size() - 1 - l].mean : lines[lines.size() - 1 - l].max;
+            float* out = &buf[(size_t)l * size];
+            for (int i = 0; i < size; i++) {
+                int begin = ((int64_t)i * lineBins) / size;
+                int end = std::max<int>(begin + 1, ((int64_t)(i + 1) * lineBins) / size);
+                float level = levels[begin];
+                for (int j = begin + 1; j < end; j++) { level = std::max<float>(level, levels[j]); }
+                out[i] = level;
+            }
+        }
+        gui::waterfall.loadHistory(buf.data(), lines.size(), size);
+    }
+
+    void backToLive() {
+        browsing = false;
+        gui::waterfall.setBandwidth(sigpath::iqFrontEnd.getEffectiveSamplerate());
+        gui::waterfall.setViewBandwidth(savedViewBandwidth);
+        gui::waterfall.setViewOffset(savedViewOffset);
+        gui::waterfall.setCenterFrequency(savedCenter);
+        sigpath::iqFrontEnd.setFFTEnabled(savedFFTEnabled);
+    }
+
+    std::string name;
+    bool enabled = true;
+    bool wasLogging = false;
+    bool logging = false;
+
+    FolderSelect folderSelect;
+    OptionList<int, int> fftSizes;
+    OptionList<int, int> binCounts;
+    OptionList<int, double> spans;
+    int fftSizeId = 0;
+    int binsId = 0;
+    int spanId = 0;
+    int interval = 10;
+    int fftRate = 10;
+
+    // Logging
+    int fftSize = 8192;
+    int bins = 1024;
+    std::atomic<double> frequency = 0.0;
+    std::atomic<bool> retuned = false;
+    EventHandler<double> retuneHandler;
+    dsp::stream<dsp::complex_t> iqStream;
+    std::thread workerThread;
+    spectrum_archive::Writer writer;
+    std::string fileDay;
+
+    // Browsing
+    std::vector<std::string> files;
+    std::string filesTxt;
+    bool filesScanned = false;
+    int fileId = 0;
+    std::unique_ptr<spectrum_archive::Reader> reader;
+    float position = 1.0f;
+    bool showMean = false;
+    bool browsing = false;
+    bool savedFFTEnabled = true;
+    double savedCenter = 0.0;
+    double savedViewBandwidth = 0.0;
+    double savedViewOffset = 0.0;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    config.setPath(core::args["root"].s() + "/spectrum_logger_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new SpectrumLoggerModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(ModuleManager::Instance* instance) {
+    delete (SpectrumLoggerModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
@@ -3,12 +3,15 @@
 #include <gui/gui.h>
 #include <signal_path/signal_path.h>
 #include <signal_path/sink.h>
-#include <dsp/buffer/packer.h>
+#include <dsp/sink/playout.h>
+#include <dsp/thread_role.h>
 #include <utils/flog.h>
 #include <config.h>
 #include <utils/optionlist.h>
 #include <aaudio/AAudio.h>
 #include <core.h>
+#include <mutex>
+#include <thread>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -22,31 +25,49 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
+// In low latency mode the buffer of the device holds this many bursts, the fewest that don't glitch on most phones
+#define LOW_LATENCY_BURSTS  2
+
+// Bounds between which the playout buffer is adapted
+#define PLAYOUT_MIN_LATENCY 0.002
+#define PLAYOUT_MAX_LATENCY 0.1
+
 class AudioSink : SinkManager::Sink {
 public:
     AudioSink(SinkManager::Stream* stream, std::string streamName) {
         _stream = stream;
         _streamName = streamName;
 
-        packer.init(_stream->sinkOut, 512);
+        playout.init(_stream->sinkOut, sampleRate, PLAYOUT_MIN_LATENCY, PLAYOUT_MAX_LATENCY);
+        playout.setThreadRole(dsp::THREAD_ROLE_AUDIO);
+
+        bool created = false;
+        config.acquire();
+        if (!config.conf.contains(_streamName)) {
+            created = true;
+            config.conf[_streamName]["lowLatency"] = true;
+        }
+        lowLatency = config.conf[_streamName]["lowLatency"];
+        config.release(created);
 
-        // TODO: Add choice? I don't think anyone cares on android...
-        sampleRate = 48000;
+        // Until the stream is opened and gives the native rate of the device
         _stream->setSampleRate(sampleRate);
     }
 
     ~AudioSink() {
+        stop();
     }
 
     void start() {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
         if (running) {
             return;
         }
-        doStart();
-        running = true;
+        running = doStart();
     }
 
     void stop() {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
         if (!running) {
             return;
         }
@@ -55,56 +76,105 @@ public:
     }
 
     void menuHandler() {
-        // Draw menu here
+        if (ImGui::Checkbox(("Low Latency##_audio_sink_ll_" + _streamName).c_str(), &lowLatency)) {
+            std::lock_guard<std::mutex> lck(ctrlMtx);
+            if (running) {
+                doStop();
+                running = doStart();
+            }
+            config.acquire();
+            config.conf[_streamName]["lowLatency"] = lowLatency;
+            config.release(true);
+        }
+        if (running) {
+            ImGui::Text("%d Hz, %s, %s", sampleRate, exclusive ? "exclusive" : "shared", fastPath ? "fast path" : "normal path");
+            ImGui::Text("Latency: %.1f ms, %d underruns", getLatency() * 1e3, playout.getUnderruns());
+        }
+    }
+
+    double getLatency() {
+        if (!running) { return 0.0; }
+        return playout.getLatency() + ((double)deviceBufferSize / (double)sampleRate);
     }
 
 private:
-    void doStart() {
-        // Create stream builder
-        AAudioStreamBuilder *builder;
+    // The stream is opened at the native rate of the device, so that the system doesn't resample it again, and
+    // pulls the samples from the playout buffer through a callback instead of a thread writing into it
+    bool doStart() {
+        if (!openStream(lowLatency) && (!lowLatency || !openStream(false))) { return false; }
+
+        // Follow the rate the device gave, the sink manager resampling the stream to it
+        int sr = AAudioStream_getSampleRate(stream);
+        if (sr > 0 && sr != sampleRate) {
+            sampleRate = sr;
+            _stream->setSampleRate(sampleRate);
+        }
+
+        // Keep as few bursts in the device buffer as possible, its capacity only bounds it
+        int burst = AAudioStream_getFramesPerBurst(stream);
+        if (lowLatency && burst > 0) {
+            AAudioStream_setBufferSizeInFrames(stream, burst * LOW_LATENCY_BURSTS);
+        }
+        deviceBufferSize = AAudioStream_getBufferSizeInFrames(stream);
+        exclusive = (AAudioStream_getSharingMode(stream) == AAUDIO_SHARING_MODE_EXCLUSIVE);
+        fastPath = (AAudioStream_getPerformanceMode(stream) == AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+
+        // The playout buffer is never waited for by the callback, it must be emptied before the stream starts
+        playout.setSamplerate(sampleRate);
+        playout.reset();
+        playout.start();
+        aaudio_result_t result = AAudioStream_requestStart(stream);
+        if (result != AAUDIO_OK) {
+            flog::error("Could not start the audio stream: {0}", AAudio_convertResultToText(result));
+            playout.stop();
+            AAudioStream_close(stream);
+            stream = NULL;
+            return false;
+        }
+
+        flog::info("AAudio stream open at {0} Hz, {1}, buffer of {2} frames", sampleRate, exclusive ? "exclusive" : "shared", deviceBufferSize);
+        return true;
+    }
+
+    // Exclusive mode isn't available on every device and isn't always granted, so it falls back to shared
+    bool openStream(bool ll) {
+        AAudioStreamBuilder* builder;
         aaudio_result_t result = AAudio_createStreamBuilder(&builder);
+        if (result != AAUDIO_OK) {
+            flog::error("Could not create the audio stream builder: {0}", AAudio_convertResultToText(result));
+            return false;
+        }
 
-        // Set stream options
-        bufferSize = round(sampleRate / 60.0);
+        // The sample rate is left unspecified for the device to choose its native one
         AAudioStreamBuilder_setDirection(builder, AAUDIO_DIRECTION_OUTPUT);
-        AAudioStreamBuilder_setSharingMode(builder, AAUDIO_SHARING_MODE_SHARED);
-        AAudioStreamBuilder_setSampleRate(builder, sampleRate);
+        AAudioStreamBuilder_setSharingMode(builder, ll ? AAUDIO_SHARING_MODE_EXCLUSIVE : AAUDIO_SHARING_MODE_SHARED);
+        AAudioStreamBuilder_setPerformanceMode(builder, lowLatency ? AAUDIO_PERFORMANCE_MODE_LOW_LATENCY : AAUDIO_PERFORMANCE_MODE_POWER_SAVING);
         AAudioStreamBuilder_setChannelCount(builder, 2);
         AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_FLOAT);
-        AAudioStreamBuilder_setBufferCapacityInFrames(builder, bufferSize);
+        AAudioStreamBuilder_setDataCallback(builder, dataCallback, this);
         AAudioStreamBuilder_setErrorCallback(builder, errorCallback, this);
-        packer.setSampleCount(bufferSize);
-        
-        // Open the stream
-        AAudioStreamBuilder_openStream(builder, &stream);
-
-        // Stream stream and packer
-        packer.start();
-        AAudioStream_requestStart(stream);
 
-        // We no longer need the builder
+        result = AAudioStreamBuilder_openStream(builder, &stream);
         AAudioStreamBuilder_delete(builder);
-
-        // Start worker thread
-        workerThread = std::thread(&AudioSink::worker, this);
+        if (result != AAUDIO_OK) {
+            flog::warn("Could not open the audio stream in {0} mode: {1}", ll ? "exclusive" : "shared", AAudio_convertResultToText(result));
+            stream = NULL;
+            return false;
+        }
+        return true;
     }
 
     void doStop() {
-        packer.stop();
-        packer.out.stopReader();
         AAudioStream_requestStop(stream);
         AAudioStream_close(stream);
-        if (workerThread.joinable()) { workerThread.join(); }
-        packer.out.clearReadStop();
+        stream = NULL;
+        playout.stop();
     }
 
-    void worker() {
-        while (true) {
-            int count = packer.out.read();
-            if (count < 0) { return; }
-            AAudioStream_write(stream, packer.out.readBuf, count, 100000000);
-            packer.out.flush();
-        }
+    static aaudio_data_callback_result_t dataCallback(AAudioStream* stream, void* userData, void* audioData, int32_t numFrames) {
+        AudioSink* _this = (AudioSink*)userData;
+        _this->playout.read((dsp::stereo_t*)audioData, numFrames);
+        return AAUDIO_CALLBACK_RESULT_CONTINUE;
     }
 
     static void errorCallback(AAudioStream *stream, void *userData, aaudio_result_t error){
@@ -115,21 +185,26 @@ private:
         }
     }
 
+    // The new device may have another native rate, which is picked up on opening
     void restart() {
-        if (running) { doStop(); }
-        if (running) { doStart(); }
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        if (!running) { return; }
+        doStop();
+        running = doStart();
     }
 
-    std::thread workerThread;
-
     AAudioStream *stream = NULL;
     SinkManager::Stream* _stream;
-    dsp::buffer::Packer<dsp::stereo_t> packer;
+    dsp::sink::Playout<dsp::stereo_t> playout;
 
     std::string _streamName;
-    double sampleRate;
-    int bufferSize;
+    int sampleRate = 48000;
+    int deviceBufferSize = 0;
+    bool lowLatency = true;
+    bool exclusive = false;
+    bool fastPath = false;
 
+    std::mutex ctrlMtx;
     bool running = false;
 };
 
@@ -0,0 +1,283 @@
+#pragma once
+#include <dsp/sink/playout.h>
+#include <dsp/profiler.h>
+#include <dsp/thread_role.h>
+#include <utils/event.h>
+#include <utils/flog.h>
+#include <volk/volk.h>
+#include <RtAudio.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// In low latency mode the device is asked for callbacks of 2.5ms, otherwise of a video frame
+#define LOW_LATENCY_CALLBACK_TIME   0.0025
+#define NORMAL_CALLBACK_TIME        (1.0 / 60.0)
+
+// Bounds between which the playout buffer of each input is adapted
+#define MIXER_MIN_LATENCY           0.002
+#define MIXER_MAX_LATENCY           0.1
+
+// Mixes every stream playing on an audio device into a single RtAudio stream. Each stream is an input holding a playout
+// buffer that the callback reads without blocking, so that a stalled stream plays silence instead of stalling the others.
+// The streams are resampled to the rate of the mixer by the sink manager, once each. Mixers are shared by device name
+class AudioMixer {
+public:
+    class Input {
+    public:
+        Input(dsp::stream<dsp::stereo_t>* in) {
+            playout.init(in, 48000, MIXER_MIN_LATENCY, MIXER_MAX_LATENCY);
+            playout.setThreadRole(dsp::THREAD_ROLE_AUDIO);
+        }
+
+        // The gain is linear
+        void setGain(float gain) {
+            _gain = gain;
+            updateGains();
+        }
+
+        // From -1 for left only to 1 for right only, the louder channel keeping the gain
+        void setPan(float pan) {
+            _pan = std::clamp<float>(pan, -1.0f, 1.0f);
+            updateGains();
+        }
+
+        double getLatency() { return playout.getLatency(); }
+
+        int getUnderruns() { return playout.getUnderruns(); }
+
+    private:
+        friend class AudioMixer;
+
+        void updateGains() {
+            leftGain = _gain * std::min<float>(1.0f - _pan, 1.0f);
+            rightGain = _gain * std::min<float>(1.0f + _pan, 1.0f);
+        }
+
+        dsp::sink::Playout<dsp::stereo_t> playout;
+        float _gain = 1.0f;
+        float _pan = 0.0f;
+        std::atomic<float> leftGain = 1.0f;
+        std::atomic<float> rightGain = 1.0f;
+    };
+
+    AudioMixer(std::string name, unsigned int deviceId, unsigned int sampleRate, bool lowLatency) {
+        _name = name;
+        _deviceId = deviceId;
+        _sampleRate = sampleRate;
+        _lowLatency = lowLatency;
+#if RTAUDIO_VERSION_MAJOR >= 6
+        audio.setErrorCallback(&errorCallback);
+#endif
+    }
+
+    ~AudioMixer() {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        closeDevice();
+        if (scratch) { dsp::buffer::free(scratch); }
+    }
+
+    // Get the mixer of a device, creating it with the given settings if no stream is playing on it
+    static std::shared_ptr<AudioMixer> acquire(std::string name, unsigned int deviceId, unsigned int sampleRate, bool lowLatency) {
+        std::lock_guard<std::mutex> lck(registryMtx);
+        std::shared_ptr<AudioMixer> mixer = registry[name].lock();
+        if (!mixer) {
+            mixer = std::make_shared<AudioMixer>(name, deviceId, sampleRate, lowLatency);
+            registry[name] = mixer;
+        }
+        return mixer;
+    }
+
+    // The device is opened along with the first input and closed along with the last
+    void addInput(Input* input) {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        input->playout.setSamplerate(_sampleRate);
+        if (open) {
+            input->playout.reset();
+            input->playout.start();
+        }
+        {
+            std::lock_guard<std::mutex> lck2(inputsMtx);
+            inputs.push_back(input);
+        }
+        if (!open) { openDevice(); }
+    }
+
+    void removeInput(Input* input) {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        {
+            std::lock_guard<std::mutex> lck2(inputsMtx);
+            inputs.erase(std::remove(inputs.begin(), inputs.end(), input), inputs.end());
+        }
+        input->playout.stop();
+        if (inputs.empty()) { closeDevice(); }
+    }
+
+    // Reopen the device at another rate, every stream playing on it follows through onSampleRateChanged
+    void setSampleRate(unsigned int sampleRate) {
+        {
+            std::lock_guard<std::mutex> lck(ctrlMtx);
+            if (sampleRate == _sampleRate) { return; }
+            bool wasOpen = open;
+            closeDevice();
+            _sampleRate = sampleRate;
+            for (auto& in : inputs) { in->playout.setSamplerate(_sampleRate); }
+            if (wasOpen) { openDevice(); }
+        }
+        onSampleRateChanged.emit(sampleRate);
+    }
+
+    void setLowLatency(bool lowLatency) {
+        {
+            std::lock_guard<std::mutex> lck(ctrlMtx);
+            if (lowLatency == _lowLatency) { return; }
+            bool wasOpen = open;
+            closeDevice();
+            _lowLatency = lowLatency;
+            if (wasOpen) { openDevice(); }
+        }
+        onLowLatencyChanged.emit(lowLatency);
+    }
+
+    unsigned int getSampleRate() { return _sampleRate; }
+
+    bool getLowLatency() { return _lowLatency; }
+
+    bool isOpen() { return open; }
+
+    // Latency of the device alone, the inputs adding that of their playout buffer
+    double getDeviceLatency() {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        if (!open) { return 0.0; }
+        return (double)audio.getStreamLatency() / (double)_sampleRate;
+    }
+
+    uint64_t getUnderflows() { return underflows; }
+
+#if RTAUDIO_VERSION_MAJOR >= 6
+    static void errorCallback(RtAudioErrorType type, const std::string& errorText) {
+        switch (type) {
+        case RtAudioErrorType::RTAUDIO_NO_ERROR:
+            return;
+        case RtAudioErrorType::RTAUDIO_WARNING:
+        case RtAudioErrorType::RTAUDIO_NO_DEVICES_FOUND:
+        case RtAudioErrorType::RTAUDIO_DEVICE_DISCONNECT:
+            flog::warn("AudioSinkModule Warning: {} ({})", errorText, (int)type);
+            break;
+        default:
+            throw std::runtime_error(errorText);
+        }
+    }
+#endif
+
+    Event<unsigned int> onSampleRateChanged;
+    Event<bool> onLowLatencyChanged;
+
+private:
+    // ctrlMtx must be held
+    void openDevice() {
+        RtAudio::StreamParameters parameters;
+        parameters.deviceId = _deviceId;
+        parameters.nChannels = 2;
+        unsigned int bufferFrames = _sampleRate * (_lowLatency ? LOW_LATENCY_CALLBACK_TIME : NORMAL_CALLBACK_TIME);
+        RtAudio::StreamOptions opts;
+        opts.flags = RTAUDIO_MINIMIZE_LATENCY;
+        opts.streamName = _name;
+
+        try {
+            audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, _sampleRate, &bufferFrames, &callback, this, &opts);
+
+            // Some backends give callbacks larger than asked for, leave room for those
+            if (bufferFrames * 2 > scratchFrames) {
+                if (scratch) { dsp::buffer::free(scratch); }
+                scratchFrames = bufferFrames * 2;
+                scratch = dsp::buffer::alloc<dsp::stereo_t>(scratchFrames);
+            }
+
+            // The playout buffers are never waited for by the callback, they must be emptied before the stream starts
+            for (auto& in : inputs) {
+                in->playout.reset();
+                in->playout.start();
+            }
+            audio.startStream();
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not open audio device {0}", e.what());
+            if (audio.isStreamOpen()) { audio.closeStream(); }
+            for (auto& in : inputs) { in->playout.stop(); }
+            return;
+        }
+
+        open = true;
+        flog::info("RtAudio stream open on '{0}' at {1} Hz", _name, _sampleRate);
+    }
+
+    // ctrlMtx must be held
+    void closeDevice() {
+        if (!open) { return; }
+        audio.stopStream();
+        audio.closeStream();
+        for (auto& in : inputs) { in->playout.stop(); }
+        open = false;
+    }
+
+    static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
+        AudioMixer* _this = (AudioMixer*)userData;
+        dsp::applyThreadRole(dsp::THREAD_ROLE_AUDIO);
+        dsp::profiler::TraceScope scope("Audio callback");
+        if (status & RTAUDIO_OUTPUT_UNDERFLOW) { _this->underflows++; }
+        dsp::stereo_t* out = (dsp::stereo_t*)outputBuffer;
+
+        // Never wait for an input being added or removed, a callback of silence is better than a late one
+        std::unique_lock<std::mutex> lck(_this->inputsMtx, std::try_to_lock);
+        if (!lck.owns_lock() || _this->inputs.empty() || nBufferFrames > _this->scratchFrames) {
+            memset(out, 0, nBufferFrames * sizeof(dsp::stereo_t));
+            return 0;
+        }
+
+        // The first input is read straight into the output, the others into the scratch buffer and added to it
+        int count = nBufferFrames * 2;
+        for (int i = 0; i < _this->inputs.size(); i++) {
+            Input* in = _this->inputs[i];
+            dsp::stereo_t* buf = i ? _this->scratch : out;
+            in->playout.read(buf, nBufferFrames);
+
+            float left = in->leftGain.load(std::memory_order_relaxed);
+            float right = in->rightGain.load(std::memory_order_relaxed);
+            if (left == right) {
+                if (left != 1.0f) { volk_32f_s32f_multiply_32f((float*)buf, (float*)buf, left, count); }
+            }
+            else {
+                for (int j = 0; j < nBufferFrames; j++) {
+                    buf[j].l *= left;
+                    buf[j].r *= right;
+                }
+            }
+
+            if (i) { volk_32f_x2_add_32f((float*)out, (float*)out, (float*)buf, count); }
+        }
+        return 0;
+    }
+
+    std::string _name;
+    unsigned int _deviceId;
+    unsigned int _sampleRate;
+    bool _lowLatency;
+    bool open = false;
+
+    std::mutex ctrlMtx;
+    std::mutex inputsMtx;
+    std::vector<Input*> inputs;
+
+    dsp::stereo_t* scratch = NULL;
+    unsigned int scratchFrames = 0;
+    std::atomic<uint64_t> underflows = 0;
+
+    RtAudio audio;
+
+    static inline std::mutex registryMtx;
+    static inline std::map<std::string, std::weak_ptr<AudioMixer>> registry;
+};
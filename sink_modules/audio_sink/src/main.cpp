@@ -1,17 +1,22 @@
 #include <imgui.h>
 #include <module.h>
 #include <gui/gui.h>
+#include <gui/style.h>
 #include <signal_path/signal_path.h>
 #include <signal_path/sink.h>
-#include <dsp/buffer/packer.h>
-#include <dsp/convert/stereo_to_mono.h>
 #include <utils/flog.h>
 #include <RtAudio.h>
 #include <config.h>
 #include <core.h>
+#include <metrics.h>
+#include "audio_mixer.h"
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+// Range of the mixer gain of a stream, in dB
+#define MIX_GAIN_MIN    -30.0f
+#define MIX_GAIN_MAX    10.0f
+
 SDRPP_MOD_INFO{
     /* Name:            */ "audio_sink",
     /* Description:     */ "Audio sink module for SDR++",
@@ -24,15 +29,16 @@ ConfigManager config;
 
 class AudioSink : SinkManager::Sink {
 public:
-    AudioSink(SinkManager::Stream* stream, std::string streamName) {
+    AudioSink(SinkManager::Stream* stream, std::string streamName) : input(stream->sinkOut) {
         _stream = stream;
         _streamName = streamName;
-        s2m.init(_stream->sinkOut);
-        monoPacker.init(&s2m.out, 512);
-        stereoPacker.init(_stream->sinkOut, 512);
+        srChangedHandler.handler = sampleRateChangedHandler;
+        srChangedHandler.ctx = this;
+        llChangedHandler.handler = lowLatencyChangedHandler;
+        llChangedHandler.ctx = this;
 
 #if RTAUDIO_VERSION_MAJOR >= 6
-        audio.setErrorCallback(&errorCallback);
+        audio.setErrorCallback(&AudioMixer::errorCallback);
 #endif
 
         bool created = false;
@@ -44,7 +50,18 @@ public:
             config.conf[_streamName]["devices"] = json({});
         }
         device = config.conf[_streamName]["device"];
+        if (config.conf[_streamName].contains("lowLatency")) {
+            lowLatency = config.conf[_streamName]["lowLatency"];
+        }
+        if (config.conf[_streamName].contains("mixGain")) {
+            mixGain = std::clamp<float>(config.conf[_streamName]["mixGain"], MIX_GAIN_MIN, MIX_GAIN_MAX);
+        }
+        if (config.conf[_streamName].contains("pan")) {
+            pan = std::clamp<float>(config.conf[_streamName]["pan"], -1.0f, 1.0f);
+        }
         config.release(created);
+        input.setGain(powf(10.0f, mixGain / 20.0f));
+        input.setPan(pan);
 
         RtAudio::DeviceInfo info;
 #if RTAUDIO_VERSION_MAJOR >= 6
@@ -70,9 +87,11 @@ public:
             }
         }
         selectByName(device);
+        metrics::registerCollector("audio_sink/" + _streamName, collectMetrics, this);
     }
 
     ~AudioSink() {
+        metrics::unregisterCollector("audio_sink/" + _streamName);
         stop();
     }
 
@@ -152,87 +171,124 @@ public:
             config.release(true);
         }
 
+        // The samplerate and latency mode belong to the device, changing them changes them for every stream playing on it
         ImGui::SetNextItemWidth(menuWidth);
         if (ImGui::Combo(("##_audio_sink_sr_" + _streamName).c_str(), &srId, sampleRatesTxt.c_str())) {
-            sampleRate = sampleRates[srId];
-            _stream->setSampleRate(sampleRate);
             if (running) {
-                doStop();
-                doStart();
+                mixer->setSampleRate(sampleRates[srId]);
+            }
+            else {
+                setSampleRate(sampleRates[srId]);
             }
+        }
+
+        if (ImGui::Checkbox(("Low Latency##_audio_sink_ll_" + _streamName).c_str(), &lowLatency)) {
+            if (running) {
+                mixer->setLowLatency(lowLatency);
+            }
+            else {
+                setLowLatency(lowLatency);
+            }
+        }
+
+        ImGui::LeftLabel("Gain");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::SliderFloat(("##_audio_sink_gain_" + _streamName).c_str(), &mixGain, MIX_GAIN_MIN, MIX_GAIN_MAX, "%.1f dB")) {
+            input.setGain(powf(10.0f, mixGain / 20.0f));
             config.acquire();
-            config.conf[_streamName]["devices"][devList[devId].name] = sampleRate;
+            config.conf[_streamName]["mixGain"] = mixGain;
             config.release(true);
         }
-    }
 
-#if RTAUDIO_VERSION_MAJOR >= 6
-    static void errorCallback(RtAudioErrorType type, const std::string& errorText) {
-        switch (type) {
-        case RtAudioErrorType::RTAUDIO_NO_ERROR:
-            return;
-        case RtAudioErrorType::RTAUDIO_WARNING:
-        case RtAudioErrorType::RTAUDIO_NO_DEVICES_FOUND:
-        case RtAudioErrorType::RTAUDIO_DEVICE_DISCONNECT:
-            flog::warn("AudioSinkModule Warning: {} ({})", errorText, (int)type);
-            break;
-        default:
-            throw std::runtime_error(errorText);
+        ImGui::LeftLabel("Pan");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::SliderFloat(("##_audio_sink_pan_" + _streamName).c_str(), &pan, -1.0f, 1.0f, "%.2f")) {
+            input.setPan(pan);
+            config.acquire();
+            config.conf[_streamName]["pan"] = pan;
+            config.release(true);
+        }
+
+        if (running) {
+            ImGui::Text("Latency: %.1f ms, %d underruns", input.getLatency() * 1e3, input.getUnderruns());
         }
     }
-#endif
+
+    double getLatency() {
+        if (!running) { return 0.0; }
+        return input.getLatency() + mixer->getDeviceLatency();
+    }
+
+    static void collectMetrics(metrics::Writer& w, void* ctx) {
+        AudioSink* _this = (AudioSink*)ctx;
+        metrics::Labels labels = { { "stream", _this->_streamName } };
+        if (!_this->running) { return; }
+
+        // The underflows are counted by the device, so they are shared by the streams playing on it
+        w.declare("audio_sink_underflows_total", metrics::TYPE_COUNTER, "Callbacks the audio device reported an output underflow for");
+        w.declare("audio_sink_playout_underruns_total", metrics::TYPE_COUNTER, "Callbacks the playout buffer ran out of samples for");
+        w.declare("audio_sink_playout_latency_seconds", metrics::TYPE_GAUGE, "Average latency of the playout buffer");
+        w.add("audio_sink_underflows_total", _this->mixer->getUnderflows(), labels);
+        w.add("audio_sink_playout_underruns_total", _this->input.getUnderruns(), labels);
+        w.add("audio_sink_playout_latency_seconds", _this->input.getLatency(), labels);
+    }
 
 private:
-    bool doStart() {
-        RtAudio::StreamParameters parameters;
-        parameters.deviceId = deviceIds[devId];
-        parameters.nChannels = 2;
-        unsigned int bufferFrames = sampleRate / 60;
-        RtAudio::StreamOptions opts;
-        opts.flags = RTAUDIO_MINIMIZE_LATENCY;
-        opts.streamName = _streamName;
-
-        try {
-            audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &bufferFrames, &callback, this, &opts);
-            stereoPacker.setSampleCount(bufferFrames);
-            audio.startStream();
-            stereoPacker.start();
-        }
-        catch (const std::exception& e) {
-            flog::error("Could not open audio device {0}", e.what());
-            return false;
+    void setSampleRate(unsigned int sr) {
+        for (int i = 0; i < sampleRates.size(); i++) {
+            if (sampleRates[i] == sr) { srId = i; }
         }
+        sampleRate = sr;
+        _stream->setSampleRate(sampleRate);
+        config.acquire();
+        config.conf[_streamName]["devices"][devList[devId].name] = sampleRate;
+        config.release(true);
+    }
 
-        flog::info("RtAudio stream open");
-        return true;
+    void setLowLatency(bool ll) {
+        lowLatency = ll;
+        config.acquire();
+        config.conf[_streamName]["lowLatency"] = lowLatency;
+        config.release(true);
     }
 
-    void doStop() {
-        s2m.stop();
-        monoPacker.stop();
-        stereoPacker.stop();
-        monoPacker.out.stopReader();
-        stereoPacker.out.stopReader();
-        audio.stopStream();
-        audio.closeStream();
-        monoPacker.out.clearReadStop();
-        stereoPacker.out.clearReadStop();
+    static void sampleRateChangedHandler(unsigned int sr, void* ctx) {
+        AudioSink* _this = (AudioSink*)ctx;
+        _this->setSampleRate(sr);
     }
 
-    static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
-        AudioSink* _this = (AudioSink*)userData;
-        int count = _this->stereoPacker.out.read();
-        if (count < 0) { return 0; }
+    static void lowLatencyChangedHandler(bool ll, void* ctx) {
+        AudioSink* _this = (AudioSink*)ctx;
+        _this->setLowLatency(ll);
+    }
+
+    bool doStart() {
+        // Streams already playing on the device set its samplerate and latency mode
+        mixer = AudioMixer::acquire(devList[devId].name, deviceIds[devId], sampleRate, lowLatency);
+        if (mixer->getSampleRate() != sampleRate) { setSampleRate(mixer->getSampleRate()); }
+        if (mixer->getLowLatency() != lowLatency) { setLowLatency(mixer->getLowLatency()); }
+        mixer->onSampleRateChanged.bindHandler(&srChangedHandler);
+        mixer->onLowLatencyChanged.bindHandler(&llChangedHandler);
+        mixer->addInput(&input);
+        if (!mixer->isOpen()) {
+            doStop();
+            return false;
+        }
+        return true;
+    }
 
-        memcpy(outputBuffer, _this->stereoPacker.out.readBuf, nBufferFrames * sizeof(dsp::stereo_t));
-        _this->stereoPacker.out.flush();
-        return 0;
+    void doStop() {
+        mixer->removeInput(&input);
+        mixer->onSampleRateChanged.unbindHandler(&srChangedHandler);
+        mixer->onLowLatencyChanged.unbindHandler(&llChangedHandler);
+        mixer.reset();
     }
 
     SinkManager::Stream* _stream;
-    dsp::convert::StereoToMono s2m;
-    dsp::buffer::Packer<float> monoPacker;
-    dsp::buffer::Packer<dsp::stereo_t> stereoPacker;
+    AudioMixer::Input input;
+    std::shared_ptr<AudioMixer> mixer;
+    EventHandler<unsigned int> srChangedHandler;
+    EventHandler<bool> llChangedHandler;
 
     std::string _streamName;
 
@@ -240,6 +296,9 @@ private:
     int devCount;
     int devId = 0;
     bool running = false;
+    bool lowLatency = false;
+    float mixGain = 0.0f;
+    float pan = 0.0f;
 
     unsigned int defaultDevId = 0;
 
@@ -251,6 +310,7 @@ private:
     std::string sampleRatesTxt;
     unsigned int sampleRate = 48000;
 
+    // Only used to list the devices, the streams are opened by the mixers
     RtAudio audio;
 };
 
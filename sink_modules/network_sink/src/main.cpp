@@ -1,4 +1,5 @@
 #include <utils/networking.h>
+#include <utils/shm_ring.h>
 #include <imgui.h>
 #include <module.h>
 #include <gui/gui.h>
@@ -11,6 +12,16 @@
 #include <config.h>
 #include <gui/style.h>
 #include <core.h>
+#include <metrics.h>
+#include <utils/optionlist.h>
+#include <deque>
+#include <atomic>
+#include <vector>
+#include <random>
+#include <condition_variable>
+#ifdef NETWORK_SINK_OPUS
+#include <opus.h>
+#endif
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -26,10 +37,29 @@ ConfigManager config;
 
 enum {
     SINK_MODE_TCP,
-    SINK_MODE_UDP
+    SINK_MODE_UDP,
+    SINK_MODE_SHM
 };
 
-const char* sinkModesTxt = "TCP\0UDP\0";
+const char* sinkModesTxt = "TCP\0UDP\0Shared memory\0";
+
+// Seconds of audio kept by the shared memory ring
+#define SHM_RING_SECONDS    2
+
+enum {
+    SINK_FORMAT_PCM,
+    SINK_FORMAT_OPUS
+};
+
+#ifdef NETWORK_SINK_OPUS
+// Opus frames are sent as RTP packets (RFC 7587). Over TCP, each packet is prefixed with its 16 bit big endian length (RFC 4571)
+#define OPUS_FRAME_MS           20
+#define OPUS_MAX_PACKET_SIZE    1276
+#define OPUS_MAX_QUEUED_FRAMES  25
+#define RTP_HEADER_SIZE         12
+#define RTP_PAYLOAD_TYPE_OPUS   111
+#define RTP_CLOCK_RATE          48000
+#endif
 
 class NetworkSink : SinkManager::Sink {
 public:
@@ -47,15 +77,38 @@ public:
             config.conf[_streamName]["stereo"] = false;
             config.conf[_streamName]["listening"] = false;
         }
+        if (!config.conf[_streamName].contains("format")) {
+            config.conf[_streamName]["format"] = SINK_FORMAT_PCM;
+            config.conf[_streamName]["bitrate"] = 64000;
+        }
+        if (!config.conf[_streamName].contains("shmName")) {
+            config.conf[_streamName]["shmName"] = "sdrpp_audio";
+        }
         std::string host = config.conf[_streamName]["hostname"];
         strcpy(hostname, host.c_str());
+        std::string shm = config.conf[_streamName]["shmName"];
+        snprintf(shmName, sizeof(shmName), "%s", shm.c_str());
         port = config.conf[_streamName]["port"];
         modeId = config.conf[_streamName]["protocol"];
         sampleRate = config.conf[_streamName]["sampleRate"];
         stereo = config.conf[_streamName]["stereo"];
         bool startNow = config.conf[_streamName]["listening"];
+        int format = config.conf[_streamName]["format"];
+        int bitrate = config.conf[_streamName]["bitrate"];
         config.release(true);
 
+        // Define the encoded formats and their bitrates
+        formats.define("pcm", "PCM", SINK_FORMAT_PCM);
+#ifdef NETWORK_SINK_OPUS
+        formats.define("opus", "Opus", SINK_FORMAT_OPUS);
+        for (int br : { 16000, 24000, 32000, 48000, 64000, 96000, 128000 }) {
+            bitrates.define(br, std::to_string(br / 1000) + " kbit/s", br);
+        }
+        brId = bitrates.keyExists(bitrate) ? bitrates.keyId(bitrate) : bitrates.valueId(64000);
+        opusBitrate = bitrates.value(brId);
+#endif
+        fmtId = formats.valueExists(format) ? formats.valueId(format) : formats.valueId(SINK_FORMAT_PCM);
+
         netBuf = new int16_t[STREAM_BUFFER_SIZE];
 
         packer.init(_stream->sinkOut, 512);
@@ -99,9 +152,11 @@ public:
 
         // Start if needed
         if (startNow) { startServer(); }
+        metrics::registerCollector("network_sink/" + _streamName, collectMetrics, this);
     }
 
     ~NetworkSink() {
+        metrics::unregisterCollector("network_sink/" + _streamName);
         stopServer();
         delete[] netBuf;
     }
@@ -125,45 +180,100 @@ public:
     void menuHandler() {
         float menuWidth = ImGui::GetContentRegionAvail().x;
 
-        bool listening = (listener && listener->isListening()) || (conn && conn->isOpen());
+        bool listening = (listener && listener->isListening()) || (conn && conn->isOpen()) || ring.isOpen();
 
         if (listening) { style::beginDisabled(); }
-        if (ImGui::InputText(CONCAT("##_network_sink_host_", _streamName), hostname, 1023)) {
-            config.acquire();
-            config.conf[_streamName]["hostname"] = hostname;
-            config.release(true);
+        if (modeId == SINK_MODE_SHM) {
+            ImGui::LeftLabel("Name");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::InputText(CONCAT("##_network_sink_shm_", _streamName), shmName, sizeof(shmName))) {
+                config.acquire();
+                config.conf[_streamName]["shmName"] = shmName;
+                config.release(true);
+            }
         }
-        ImGui::SameLine();
-        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
-        if (ImGui::InputInt(CONCAT("##_network_sink_port_", _streamName), &port, 0, 0)) {
-            config.acquire();
-            config.conf[_streamName]["port"] = port;
-            config.release(true);
+        else {
+            if (ImGui::InputText(CONCAT("##_network_sink_host_", _streamName), hostname, 1023)) {
+                config.acquire();
+                config.conf[_streamName]["hostname"] = hostname;
+                config.release(true);
+            }
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::InputInt(CONCAT("##_network_sink_port_", _streamName), &port, 0, 0)) {
+                config.acquire();
+                config.conf[_streamName]["port"] = port;
+                config.release(true);
+            }
         }
 
         ImGui::LeftLabel("Protocol");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::Combo(CONCAT("##_network_sink_mode_", _streamName), &modeId, sinkModesTxt)) {
+            // The encoder isn't used by the shared memory
+            bool wasRunning = running;
+            stop();
+            if (wasRunning) { start(); }
             config.acquire();
             config.conf[_streamName]["protocol"] = modeId;
             config.release(true);
         }
 
+        // The shared memory always holds 16 bit PCM, its readers being on the same machine
+        if (modeId != SINK_MODE_SHM) {
+            ImGui::LeftLabel("Format");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::Combo(CONCAT("##_network_sink_format_", _streamName), &fmtId, formats.txt)) {
+                bool wasRunning = running;
+                stop();
+                if (formats[fmtId] == SINK_FORMAT_OPUS) { selectOpusSamplerate(); }
+                if (wasRunning) { start(); }
+                config.acquire();
+                config.conf[_streamName]["format"] = formats[fmtId];
+                config.release(true);
+            }
+        }
+
         if (listening) { style::endDisabled(); }
 
         ImGui::LeftLabel("Samplerate");
         ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
         if (ImGui::Combo(CONCAT("##_network_sink_sr_", _streamName), &srId, sampleRatesTxt.c_str())) {
             sampleRate = sampleRates[srId];
+            if (formats[fmtId] == SINK_FORMAT_OPUS) {
+                // The encoder is created for a given samplerate
+                bool wasRunning = running;
+                stop();
+                selectOpusSamplerate();
+                if (wasRunning) { start(); }
+            }
             _stream->setSampleRate(sampleRate);
             packer.setSampleCount(sampleRate / 60);
+            {
+                std::lock_guard lck(connMtx);
+                ring.setSampleRate(sampleRate);
+            }
             config.acquire();
             config.conf[_streamName]["sampleRate"] = sampleRate;
             config.release(true);
         }
 
+#ifdef NETWORK_SINK_OPUS
+        if (formats[fmtId] == SINK_FORMAT_OPUS) {
+            ImGui::LeftLabel("Bitrate");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::Combo(CONCAT("##_network_sink_bitrate_", _streamName), &brId, bitrates.txt)) {
+                opusBitrate = bitrates.value(brId);
+                config.acquire();
+                config.conf[_streamName]["bitrate"] = bitrates.key(brId);
+                config.release(true);
+            }
+        }
+#endif
+
         if (ImGui::Checkbox(CONCAT("Stereo##_network_sink_stereo_", _streamName), &stereo)) {
             stop();
+            if (ring.isOpen()) { openRing(); }
             start();
             config.acquire();
             config.conf[_streamName]["stereo"] = stereo;
@@ -188,16 +298,28 @@ public:
         if (conn && conn->isOpen()) {
             ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), (modeId == SINK_MODE_TCP) ? "Connected" : "Sending");
         }
+        else if (ring.isOpen()) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Sharing");
+        }
         else if (listening) {
             ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Listening");
         }
         else {
             ImGui::TextUnformatted("Idle");
         }
+
+#ifdef NETWORK_SINK_OPUS
+        if (formats[fmtId] == SINK_FORMAT_OPUS && droppedFrames) {
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Encoder overrun, %d frames dropped", (int)droppedFrames);
+        }
+#endif
     }
 
 private:
     void doStart() {
+#ifdef NETWORK_SINK_OPUS
+        if (formats[fmtId] == SINK_FORMAT_OPUS && modeId != SINK_MODE_SHM) { startEncoder(); }
+#endif
         packer.start();
         if (stereo) {
             stereoSink.start();
@@ -214,11 +336,163 @@ private:
         s2m.stop();
         monoSink.stop();
         stereoSink.stop();
+#ifdef NETWORK_SINK_OPUS
+        stopEncoder();
+#endif
+    }
+
+    // Opus only accepts a few samplerates, fall back to 48KHz if the current one isn't one of them
+    void selectOpusSamplerate() {
+        if (sampleRate == 8000 || sampleRate == 12000 || sampleRate == 16000 || sampleRate == 24000 || sampleRate == 48000) { return; }
+        sampleRate = 48000;
+        srId = std::find(sampleRates.begin(), sampleRates.end(), sampleRate) - sampleRates.begin();
+        _stream->setSampleRate(sampleRate);
+        packer.setSampleCount(sampleRate / 60);
+        config.acquire();
+        config.conf[_streamName]["sampleRate"] = sampleRate;
+        config.release(true);
+    }
+
+#ifdef NETWORK_SINK_OPUS
+    void startEncoder() {
+        channels = stereo ? 2 : 1;
+        frameSize = (sampleRate * OPUS_FRAME_MS) / 1000;
+        int err;
+        encoder = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_AUDIO, &err);
+        if (err != OPUS_OK) {
+            flog::error("Failed to create Opus encoder: {}", opus_strerror(err));
+            encoder = NULL;
+            return;
+        }
+        encoderBitrate = -1;
+
+        // Start a new RTP stream
+        std::random_device rd;
+        rtpSSRC = rd();
+        rtpSeq = rd();
+        rtpTimestamp = rd();
+
+        frameFill = 0;
+        frameQueue.clear();
+        droppedFrames = 0;
+        encoderStop = false;
+        encoderThread = std::thread(&NetworkSink::encoderWorker, this);
+    }
+
+    void stopEncoder() {
+        if (!encoder) { return; }
+        {
+            std::lock_guard lck(frameMtx);
+            encoderStop = true;
+        }
+        frameCnd.notify_all();
+        if (encoderThread.joinable()) { encoderThread.join(); }
+        opus_encoder_destroy(encoder);
+        encoder = NULL;
+    }
+
+    // Cut the audio into frames for the encoder thread, called from the DSP thread so that it never waits on the encoder
+    void queueAudio(const float* samples, int count) {
+        int frameValues = frameSize * channels;
+        {
+            std::lock_guard lck(frameMtx);
+            while (count) {
+                if (!frameFill) { frame.resize(frameValues); }
+                int n = std::min<int>(frameValues - frameFill, count);
+                memcpy(&frame[frameFill], samples, n * sizeof(float));
+                frameFill += n;
+                samples += n;
+                count -= n;
+                if (frameFill < frameValues) { break; }
+
+                // Drop the oldest frame if the encoder can't keep up
+                if (frameQueue.size() >= OPUS_MAX_QUEUED_FRAMES) {
+                    frameQueue.pop_front();
+                    droppedFrames++;
+                }
+                frameQueue.push_back(std::move(frame));
+                frameFill = 0;
+            }
+        }
+        frameCnd.notify_one();
+    }
+
+    void encoderWorker() {
+        // Leave room for the RFC 4571 length prefix before the RTP header
+        uint8_t packet[2 + RTP_HEADER_SIZE + OPUS_MAX_PACKET_SIZE];
+        uint8_t* rtp = &packet[2];
+        std::vector<float> pcm;
+
+        while (true) {
+            // Wait for a frame
+            {
+                std::unique_lock lck(frameMtx);
+                frameCnd.wait(lck, [=]() { return !frameQueue.empty() || encoderStop; });
+                if (encoderStop) { break; }
+                pcm = std::move(frameQueue.front());
+                frameQueue.pop_front();
+            }
+
+            // Apply bitrate changes
+            int bitrate = opusBitrate;
+            if (bitrate != encoderBitrate) {
+                opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
+                encoderBitrate = bitrate;
+            }
+
+            // Encode
+            int len = opus_encode_float(encoder, pcm.data(), frameSize, &rtp[RTP_HEADER_SIZE], OPUS_MAX_PACKET_SIZE);
+            if (len < 0) {
+                flog::error("Opus encoding failed: {}", opus_strerror(len));
+                continue;
+            }
+
+            // Write the RTP header, the Opus RTP clock always runs at 48KHz
+            rtp[0] = 0x80;
+            rtp[1] = RTP_PAYLOAD_TYPE_OPUS;
+            writeBE16(&rtp[2], rtpSeq++);
+            writeBE32(&rtp[4], rtpTimestamp);
+            writeBE32(&rtp[8], rtpSSRC);
+            rtpTimestamp += (frameSize * RTP_CLOCK_RATE) / sampleRate;
+
+            // Send
+            std::lock_guard lck(connMtx);
+            if (!conn || !conn->isOpen()) { continue; }
+            if (modeId == SINK_MODE_TCP) {
+                writeBE16(packet, RTP_HEADER_SIZE + len);
+                if (conn->write(2 + RTP_HEADER_SIZE + len, packet)) { bytesSent += 2 + RTP_HEADER_SIZE + len; }
+            }
+            else {
+                if (conn->write(RTP_HEADER_SIZE + len, rtp)) { bytesSent += RTP_HEADER_SIZE + len; }
+            }
+        }
+    }
+
+    static void writeBE16(uint8_t* buf, uint16_t val) {
+        buf[0] = val >> 8;
+        buf[1] = val;
+    }
+
+    static void writeBE32(uint8_t* buf, uint32_t val) {
+        buf[0] = val >> 24;
+        buf[1] = val >> 16;
+        buf[2] = val >> 8;
+        buf[3] = val;
+    }
+#endif
+
+    // The ring is given the audio as it leaves the sink, the readers using it in place
+    void openRing() {
+        std::lock_guard lck(connMtx);
+        ring.open(shmName, SHM_RING_FORMAT_S16, stereo ? 2 : 1, sampleRate * SHM_RING_SECONDS, sampleRate);
     }
 
     void startServer() {
         try {
-            if (modeId == SINK_MODE_TCP) {
+            if (modeId == SINK_MODE_SHM) {
+                openRing();
+            }
+            else if (modeId == SINK_MODE_TCP) {
                 listener = net::listen(hostname, port);
                 if (listener) {
                     listener->acceptAsync(clientHandler, this);
@@ -234,28 +508,76 @@ private:
     }
 
     void stopServer() {
+        {
+            std::lock_guard lck(connMtx);
+            ring.close();
+        }
         if (conn) { conn->close(); }
         if (listener) { listener->close(); }
     }
 
     static void monoHandler(float* samples, int count, void* ctx) {
         NetworkSink* _this = (NetworkSink*)ctx;
+#ifdef NETWORK_SINK_OPUS
+        if (_this->encoder) {
+            _this->queueAudio(samples, count);
+            return;
+        }
+#endif
         std::lock_guard lck(_this->connMtx);
+        if (_this->ring.isOpen()) {
+            _this->shareAudio((float*)samples, count);
+            return;
+        }
         if (!_this->conn || !_this->conn->isOpen()) { return; }
 
         volk_32f_s32f_convert_16i(_this->netBuf, (float*)samples, 32768.0f, count);
 
-        _this->conn->write(count * sizeof(int16_t), (uint8_t*)_this->netBuf);
+        if (_this->conn->write(count * sizeof(int16_t), (uint8_t*)_this->netBuf)) { _this->bytesSent += count * sizeof(int16_t); }
     }
 
     static void stereoHandler(dsp::stereo_t* samples, int count, void* ctx) {
         NetworkSink* _this = (NetworkSink*)ctx;
+#ifdef NETWORK_SINK_OPUS
+        if (_this->encoder) {
+            _this->queueAudio((float*)samples, count * 2);
+            return;
+        }
+#endif
         std::lock_guard lck(_this->connMtx);
+        if (_this->ring.isOpen()) {
+            _this->shareAudio((float*)samples, count);
+            return;
+        }
         if (!_this->conn || !_this->conn->isOpen()) { return; }
 
         volk_32f_s32f_convert_16i(_this->netBuf, (float*)samples, 32768.0f, count * 2);
 
-        _this->conn->write(count * 2 * sizeof(int16_t), (uint8_t*)_this->netBuf);
+        if (_this->conn->write(count * 2 * sizeof(int16_t), (uint8_t*)_this->netBuf)) { _this->bytesSent += count * 2 * sizeof(int16_t); }
+    }
+
+    static void collectMetrics(metrics::Writer& w, void* ctx) {
+        NetworkSink* _this = (NetworkSink*)ctx;
+        metrics::Labels labels = { { "stream", _this->_streamName } };
+        w.declare("network_sink_sent_bytes_total", metrics::TYPE_COUNTER, "Bytes of audio sent over the network");
+        w.add("network_sink_sent_bytes_total", _this->bytesSent, labels);
+#ifdef NETWORK_SINK_OPUS
+        w.declare("network_sink_dropped_frames_total", metrics::TYPE_COUNTER, "Opus frames dropped because the encoder didn't keep up");
+        w.add("network_sink_dropped_frames_total", _this->droppedFrames, labels);
+#endif
+    }
+
+    // Convert frames of audio straight into the shared memory, with connMtx held
+    void shareAudio(const float* samples, int count) {
+        int channels = stereo ? 2 : 1;
+        while (count > 0) {
+            int n;
+            int16_t* dst = (int16_t*)ring.reserve(count, n);
+            volk_32f_s32f_convert_16i(dst, samples, 32768.0f, n * channels);
+            ring.commit(n);
+            samples += n * channels;
+            count -= n;
+        }
     }
 
     static void clientHandler(net::Conn client, void* ctx) {
@@ -288,6 +610,7 @@ private:
     bool running = false;
 
     char hostname[1024];
+    char shmName[256];
     int port = 4242;
 
     int modeId = 1;
@@ -299,9 +622,37 @@ private:
 
     int16_t* netBuf;
 
+    OptionList<std::string, int> formats;
+    int fmtId = 0;
+
+#ifdef NETWORK_SINK_OPUS
+    OptionList<int, int> bitrates;
+    int brId = 0;
+    std::atomic<int> opusBitrate = 64000;
+
+    OpusEncoder* encoder = NULL;
+    int encoderBitrate = -1;
+    int channels = 1;
+    int frameSize = 960;
+    uint16_t rtpSeq = 0;
+    uint32_t rtpTimestamp = 0;
+    uint32_t rtpSSRC = 0;
+
+    std::thread encoderThread;
+    std::mutex frameMtx;
+    std::condition_variable frameCnd;
+    bool encoderStop = false;
+    std::vector<float> frame;
+    int frameFill = 0;
+    std::deque<std::vector<float>> frameQueue;
+    std::atomic<int> droppedFrames = 0;
+#endif
+
     net::Listener listener;
     net::Conn conn;
     std::mutex connMtx;
+    shm::RingWriter ring;
+    std::atomic<uint64_t> bytesSent = 0;
 };
 
 class NetworkSinkModule : public ModuleManager::Instance {
@@ -140,6 +140,12 @@ public:
             }
             // TODO: Save to config
         }
+
+        // The callback plays silence instead of waiting when the buffer runs dry
+        if (running) {
+            uint64_t underruns = (dev->channels == 2) ? stereoRB.data.getUnderruns() : monoRB.data.getUnderruns();
+            ImGui::Text("Underruns: %llu", (unsigned long long)underruns);
+        }
     }
 
 private:
@@ -159,7 +165,8 @@ private:
         int bufferSize = sampleRate / 60.0f;
 
         if (dev->channels == 2) {
-            stereoRB.data.setMaxLatency(bufferSize * 2);
+            stereoRB.setMaxLatency(bufferSize * 2);
+            stereoRB.setDriftCompensation(true, sampleRate);
             stereoRB.start();
             // stereoPacker.setSampleCount(bufferSize);
             // stereoPacker.start();
@@ -167,7 +174,8 @@ private:
             //err = Pa_OpenStream(&stream, NULL, &outputParams, sampleRate, bufferSize, 0, _stereo_cb, this);
         }
         else {
-            monoRB.data.setMaxLatency(bufferSize * 2);
+            monoRB.setMaxLatency(bufferSize * 2);
+            monoRB.setDriftCompensation(true, sampleRate);
             monoRB.start();
             // stereoPacker.setSampleCount(bufferSize);
             // monoPacker.start();
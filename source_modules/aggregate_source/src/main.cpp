@@ -0,0 +1,424 @@
+#include <utils/flog.h>
+#include <module.h>
+#include <gui/gui.h>
+#include <signal_path/signal_path.h>
+#include <core.h>
+#include <gui/style.h>
+#include <config.h>
+#include <gui/smgui.h>
+#include <utils/optionlist.h>
+#include <dsp/filter/fir.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/channel/frequency_xlator.h>
+#include <dsp/routing/combiner.h>
+#include <dsp/taps/low_pass.h>
+#include <memory>
+
+#define CONCAT(a, b) ((std::string(a) + b).c_str())
+
+#define AGGREGATE_SOURCE_NAME   "Aggregate"
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "aggregate_source",
+    /* Description:     */ "Combines several sources into one",
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ 1
+};
+
+ConfigManager config;
+
+enum Mode {
+    MODE_STITCHED,
+    MODE_CHANNELS
+};
+
+// The band of each device is placed in its own slot of the combined baseband, the edges of the band of each
+// device being discarded by the overlap. In stitched mode, the devices are tuned so that their slots follow each
+// other in frequency and the combined baseband is one wide band. In channels mode, each device is tuned to its own
+// frequency and the slots are just laid side by side.
+class AggregateSourceModule : public ModuleManager::Instance {
+public:
+    AggregateSourceModule(std::string name) {
+        this->name = name;
+
+        modes.define("stitched", "Stitched", MODE_STITCHED);
+        modes.define("channels", "Channels", MODE_CHANNELS);
+
+        // Load config
+        config.acquire();
+        if (config.conf.contains("mode")) {
+            std::string mode = config.conf["mode"];
+            if (modes.keyExists(mode)) { modeId = modes.keyId(mode); }
+        }
+        if (config.conf.contains("overlap")) {
+            overlap = std::clamp<float>(config.conf["overlap"], 0.0f, 0.5f);
+        }
+        for (auto& m : config.conf["members"]) {
+            if (!m.contains("source")) { continue; }
+            Member member;
+            member.source = m["source"];
+            if (m.contains("frequency")) { member.frequency = m["frequency"]; }
+            members.push_back(member);
+        }
+        config.release();
+
+        combiner.init({});
+
+        refreshSources();
+        sourceRegHandler.handler = onSourcesChanged;
+        sourceRegHandler.ctx = this;
+        sourceUnregHandler.handler = onSourceUnregister;
+        sourceUnregHandler.ctx = this;
+        sigpath::sourceManager.onSourceRegistered.bindHandler(&sourceRegHandler);
+        sigpath::sourceManager.onSourceUnregister.bindHandler(&sourceUnregHandler);
+
+        handler.ctx = this;
+        handler.selectHandler = menuSelected;
+        handler.deselectHandler = menuDeselected;
+        handler.menuHandler = menuHandler;
+        handler.startHandler = start;
+        handler.stopHandler = stop;
+        handler.tuneHandler = tune;
+        handler.stream = &combiner.out;
+        sigpath::sourceManager.registerSource(AGGREGATE_SOURCE_NAME, &handler);
+    }
+
+    ~AggregateSourceModule() {
+        stop(this);
+        sigpath::sourceManager.onSourceRegistered.unbindHandler(&sourceRegHandler);
+        sigpath::sourceManager.onSourceUnregister.unbindHandler(&sourceUnregHandler);
+        sigpath::sourceManager.unregisterSource(AGGREGATE_SOURCE_NAME);
+    }
+
+    void postInit() {}
+
+    void enable() {
+        enabled = true;
+    }
+
+    void disable() {
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+private:
+    struct Member {
+        std::string source;
+        double frequency = 100000000.0;     // Used in channels mode
+        double samplerate = 0.0;            // Reported by the source when selected
+        double offset = 0.0;                // Center of the slot in the combined baseband
+        SourceManager::SourceHandler* handler = NULL;
+    };
+
+    // Ingress of a device into the combined baseband, each block running on its own thread
+    struct Chain {
+        dsp::tap<float> taps;
+        dsp::filter::FIR<dsp::complex_t, float> filter;
+        dsp::multirate::RationalResampler<dsp::complex_t> resamp;
+        dsp::channel::FrequencyXlator xlator;
+    };
+
+    static void onSourcesChanged(std::string name, void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        _this->refreshSources();
+    }
+
+    static void onSourceUnregister(std::string name, void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        if (name == AGGREGATE_SOURCE_NAME) { return; }
+
+        // Let go of the source before it disappears
+        for (auto& m : _this->members) {
+            if (m.source != name) { continue; }
+            if (_this->running) { _this->stopAll(); }
+            m.handler = NULL;
+        }
+        _this->refreshSources(name);
+    }
+
+    void refreshSources(const std::string& excluded = "") {
+        sources.clear();
+        for (auto& src : sigpath::sourceManager.getSourceNames()) {
+            if (src == AGGREGATE_SOURCE_NAME || src == excluded) { continue; }
+            sources.define(src, src, src);
+        }
+        addId = std::clamp<int>(addId, 0, std::max<int>(sources.size() - 1, 0));
+    }
+
+    // Call a handler of a member, capturing the samplerate it sets
+    template <class F>
+    void callMember(Member& m, F func) {
+        sigpath::sourceManager.beginSampleRateCapture(&m.samplerate);
+        func(m.handler);
+        sigpath::sourceManager.endSampleRateCapture();
+    }
+
+    void selectMembers() {
+        for (auto& m : members) {
+            m.handler = sigpath::sourceManager.getSource(m.source);
+            if (!m.handler) {
+                flog::warn("Aggregate source: '{}' is not available", m.source);
+                continue;
+            }
+            callMember(m, [](SourceManager::SourceHandler* h) { h->selectHandler(h->ctx); });
+        }
+        updateLayout();
+    }
+
+    void deselectMembers() {
+        for (auto& m : members) {
+            if (!m.handler) { continue; }
+            m.handler->deselectHandler(m.handler->ctx);
+            m.handler = NULL;
+        }
+    }
+
+    // Place the slot of each device in the combined baseband and apply its samplerate
+    void updateLayout() {
+        samplerate = 0.0;
+        for (auto& m : members) {
+            if (m.handler) { samplerate += m.samplerate * (1.0 - overlap); }
+        }
+        double pos = -samplerate / 2.0;
+        for (auto& m : members) {
+            if (!m.handler) { continue; }
+            double width = m.samplerate * (1.0 - overlap);
+            m.offset = pos + (width / 2.0);
+            pos += width;
+        }
+        if (selected && samplerate > 0.0) { core::setInputSampleRate(samplerate); }
+    }
+
+    void tuneMembers() {
+        Mode mode = modes.value(modeId);
+        for (auto& m : members) {
+            if (!m.handler) { continue; }
+            double f = (mode == MODE_STITCHED) ? (freq + m.offset) : m.frequency;
+            m.handler->tuneHandler(f, m.handler->ctx);
+        }
+    }
+
+    void stopAll() {
+        // Stop the devices first so that nothing is written anymore, then the ingress chains
+        for (auto& m : members) {
+            if (m.handler) { m.handler->stopHandler(m.handler->ctx); }
+        }
+        for (auto& c : chains) {
+            c->filter.stop();
+            c->resamp.stop();
+            c->xlator.stop();
+        }
+        combiner.stop();
+        combiner.setInputs({});
+        for (auto& c : chains) { dsp::taps::free(c->taps); }
+        chains.clear();
+        running = false;
+    }
+
+    static void menuSelected(void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        _this->selected = true;
+        _this->selectMembers();
+        flog::info("AggregateSourceModule '{0}': Menu Select!", _this->name);
+    }
+
+    static void menuDeselected(void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        _this->selected = false;
+        _this->deselectMembers();
+        flog::info("AggregateSourceModule '{0}': Menu Deselect!", _this->name);
+    }
+
+    static void start(void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        if (_this->running) { return; }
+
+        // Build the ingress chain of every available device
+        std::vector<dsp::stream<dsp::complex_t>*> outs;
+        for (auto& m : _this->members) {
+            if (!m.handler || m.samplerate <= 0.0) { continue; }
+            auto c = std::make_unique<Chain>();
+            double width = m.samplerate * (1.0 - _this->overlap);
+            c->taps = dsp::taps::lowPass(width / 2.0, std::max<double>(m.samplerate - width, m.samplerate * 0.02) / 2.0, m.samplerate);
+            c->filter.init(m.handler->stream, c->taps);
+            c->resamp.init(&c->filter.out, m.samplerate, _this->samplerate);
+            c->xlator.init(&c->resamp.out, m.offset, _this->samplerate);
+            outs.push_back(&c->xlator.out);
+            _this->chains.push_back(std::move(c));
+        }
+        if (outs.empty()) {
+            flog::error("Aggregate source: no source to combine");
+            return;
+        }
+        _this->combiner.setInputs(outs);
+
+        // Start the devices and the chains
+        for (auto& m : _this->members) {
+            if (!m.handler) { continue; }
+            _this->callMember(m, [](SourceManager::SourceHandler* h) { h->startHandler(h->ctx); });
+        }
+        _this->tuneMembers();
+        for (auto& c : _this->chains) {
+            c->filter.start();
+            c->resamp.start();
+            c->xlator.start();
+        }
+        _this->combiner.start();
+
+        _this->running = true;
+        flog::info("AggregateSourceModule '{0}': Start!", _this->name);
+    }
+
+    static void stop(void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        if (!_this->running) { return; }
+        _this->stopAll();
+        flog::info("AggregateSourceModule '{0}': Stop!", _this->name);
+    }
+
+    static void tune(double freq, void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+        _this->freq = freq;
+        if (_this->running) { _this->tuneMembers(); }
+        flog::info("AggregateSourceModule '{0}': Tune: {1}!", _this->name, freq);
+    }
+
+    static void menuHandler(void* ctx) {
+        AggregateSourceModule* _this = (AggregateSourceModule*)ctx;
+
+        if (_this->running) { SmGui::BeginDisabled(); }
+        SmGui::LeftLabel("Mode");
+        SmGui::FillWidth();
+        if (SmGui::Combo(CONCAT("##_aggregate_mode_", _this->name), &_this->modeId, _this->modes.txt)) {
+            _this->saveConfig();
+        }
+
+        SmGui::LeftLabel("Overlap");
+        SmGui::FillWidth();
+        if (SmGui::SliderFloat(CONCAT("##_aggregate_overlap_", _this->name), &_this->overlap, 0.0f, 0.5f, SmGui::FMT_STR_FLOAT_TWO_DECIMAL)) {
+            _this->updateLayout();
+            _this->saveConfig();
+        }
+
+        // Add a source
+        SmGui::FillWidth();
+        SmGui::Combo(CONCAT("##_aggregate_add_sel_", _this->name), &_this->addId, _this->sources.txt);
+        SmGui::SameLine();
+        SmGui::FillWidth();
+        SmGui::ForceSync();
+        if (SmGui::Button(CONCAT("Add##_aggregate_add_", _this->name)) && !_this->sources.empty()) {
+            Member m;
+            m.source = _this->sources.key(_this->addId);
+            m.frequency = _this->freq;
+            if (_this->selected) {
+                m.handler = sigpath::sourceManager.getSource(m.source);
+                if (m.handler) { _this->callMember(m, [](SourceManager::SourceHandler* h) { h->selectHandler(h->ctx); }); }
+            }
+            _this->members.push_back(m);
+            _this->updateLayout();
+            _this->saveConfig();
+        }
+        if (_this->running) { SmGui::EndDisabled(); }
+
+        // Members and their own menus
+        bool changed = false;
+        for (int i = 0; i < _this->members.size(); i++) {
+            Member& m = _this->members[i];
+            std::string id = std::to_string(i) + _this->name;
+            SmGui::Text((m.handler || !_this->selected) ? m.source.c_str() : (m.source + " (not available)").c_str());
+
+            if (_this->running) { SmGui::BeginDisabled(); }
+            SmGui::SameLine();
+            SmGui::ForceSync();
+            if (SmGui::Button(CONCAT("Remove##_aggregate_rem_", id))) {
+                if (m.handler) { m.handler->deselectHandler(m.handler->ctx); }
+                _this->members.erase(_this->members.begin() + i);
+                _this->updateLayout();
+                _this->saveConfig();
+                if (_this->running) { SmGui::EndDisabled(); }
+                break;
+            }
+            if (_this->running) { SmGui::EndDisabled(); }
+
+            if (_this->modes.value(_this->modeId) == MODE_CHANNELS) {
+                int kHz = round(m.frequency / 1000.0);
+                SmGui::LeftLabel("Frequency (kHz)");
+                SmGui::FillWidth();
+                if (SmGui::InputInt(CONCAT("##_aggregate_freq_", id), &kHz, 100, 1000)) {
+                    m.frequency = (double)std::max<int>(kHz, 0) * 1000.0;
+                    if (_this->running && m.handler) { m.handler->tuneHandler(m.frequency, m.handler->ctx); }
+                    _this->saveConfig();
+                }
+            }
+
+            if (!m.handler || !_this->selected) { continue; }
+            double sr = m.samplerate;
+            _this->callMember(m, [](SourceManager::SourceHandler* h) { h->menuHandler(h->ctx); });
+            changed |= (m.samplerate != sr);
+        }
+        if (changed) { _this->updateLayout(); }
+    }
+
+    void saveConfig() {
+        config.acquire();
+        config.conf["mode"] = modes.key(modeId);
+        config.conf["overlap"] = overlap;
+        config.conf["members"] = json::array();
+        for (auto& m : members) {
+            json mconf;
+            mconf["source"] = m.source;
+            mconf["frequency"] = m.frequency;
+            config.conf["members"].push_back(mconf);
+        }
+        config.release(true);
+    }
+
+    std::string name;
+    bool enabled = true;
+    bool selected = false;
+    bool running = false;
+    double freq = 100000000.0;
+    double samplerate = 0.0;
+
+    int modeId = 0;
+    float overlap = 0.1f;
+    int addId = 0;
+
+    std::vector<Member> members;
+    std::vector<std::unique_ptr<Chain>> chains;
+    dsp::routing::Combiner<dsp::complex_t> combiner;
+
+    OptionList<std::string, Mode> modes;
+    OptionList<std::string, std::string> sources;
+
+    EventHandler<std::string> sourceRegHandler;
+    EventHandler<std::string> sourceUnregHandler;
+    SourceManager::SourceHandler handler;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    def["mode"] = "stitched";
+    def["overlap"] = 0.1f;
+    def["members"] = json::array();
+    config.setPath(core::args["root"].s() + "/aggregate_source_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new AggregateSourceModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(ModuleManager::Instance* instance) {
+    delete (AggregateSourceModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
@@ -42,6 +42,13 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.stats = &stats;
+
+        // The server only takes complex samples
+        config.acquire();
+        if (config.conf.contains("int16Samples")) { int16Samples = config.conf["int16Samples"]; }
+        config.release();
+        if (core::args["server"].b()) { int16Samples = false; }
 
         refresh();
         if (sampleRateList.size() > 0) {
@@ -249,6 +256,9 @@ private:
     static void menuSelected(void* ctx) {
         AirspySourceModule* _this = (AirspySourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
+
+        // The source manager picks the stream to read from once the source is selected
+        _this->handler.compactStream = _this->int16Samples ? &_this->compactStream : NULL;
         flog::info("AirspySourceModule '{0}': Menu Select!", _this->name);
     }
 
@@ -310,6 +320,10 @@ private:
 
         airspy_set_rf_bias(_this->openDev, _this->biasT);
 
+        // The 16 bit samples are only converted by the IQ front end, after the first stage of decimation
+        _this->streaming16 = (_this->handler.compactStream != NULL);
+        airspy_set_sample_type(_this->openDev, _this->streaming16 ? AIRSPY_SAMPLE_INT16_IQ : AIRSPY_SAMPLE_FLOAT32_IQ);
+
         airspy_start_rx(_this->openDev, callback, _this);
 
         _this->running = true;
@@ -321,8 +335,10 @@ private:
         if (!_this->running) { return; }
         _this->running = false;
         _this->stream.stopWriter();
+        _this->compactStream.stopWriter();
         airspy_close(_this->openDev);
         _this->stream.clearWriteStop();
+        _this->compactStream.clearWriteStop();
         flog::info("AirspySourceModule '{0}': Stop!", _this->name);
     }
 
@@ -374,6 +390,16 @@ private:
             core::setInputSampleRate(_this->sampleRate);
         }
 
+        if (!core::args["server"].b()) {
+            if (SmGui::Checkbox(CONCAT("16 bit samples##_airspy_int16_", _this->name), &_this->int16Samples)) {
+                // Select the source again for the IQ front end to switch to the matching input
+                sigpath::sourceManager.selectSource("Airspy");
+                config.acquire();
+                config.conf["int16Samples"] = _this->int16Samples;
+                config.release(true);
+            }
+        }
+
         if (_this->running) { SmGui::EndDisabled(); }
 
         SmGui::BeginGroup();
@@ -564,8 +590,19 @@ private:
 
     static int callback(airspy_transfer_t* transfer) {
         AirspySourceModule* _this = (AirspySourceModule*)transfer->ctx;
-        memcpy(_this->stream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex_t));
-        if (!_this->stream.swap(transfer->sample_count)) { return -1; }
+        if (transfer->dropped_samples) { _this->stats.overflow(transfer->dropped_samples); }
+
+        // The buffer of the transfer is reused by libairspy once this returns, so it must be copied. The input
+        // buffer of the IQ front end takes the block over right away instead of copying it again
+        if (_this->streaming16) {
+            memcpy(_this->compactStream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex_s16_t));
+            if (!_this->compactStream.swap(transfer->sample_count)) { return -1; }
+        }
+        else {
+            memcpy(_this->stream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex_t));
+            if (!_this->stream.swap(transfer->sample_count)) { return -1; }
+        }
+        _this->stats.delivered(transfer->sample_count);
         return 0;
     }
 
@@ -573,8 +610,12 @@ private:
     airspy_device* openDev;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
+    dsp::stream<dsp::complex_s16_t> compactStream;
+    bool int16Samples = true;
+    bool streaming16 = false;
     double sampleRate;
     SourceManager::SourceHandler handler;
+    SourceStats stats;
     bool running = false;
     double freq;
     uint64_t selectedSerial = 0;
@@ -609,6 +650,7 @@ MOD_EXPORT void _INIT_() {
     json def = json({});
     def["devices"] = json({});
     def["device"] = "";
+    def["int16Samples"] = true;
     config.setPath(core::args["root"].s() + "/airspy_config.json");
     config.load(def);
     config.enableAutoSave();
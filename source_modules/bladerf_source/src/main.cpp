@@ -11,11 +11,24 @@
 #include <gui/smgui.h>
 #include <algorithm>
 #include <utils/optionlist.h>
+#include <dsp/convert/s16_to_complex.h>
+#include <dsp/convert/s8_to_complex.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
-#define NUM_BUFFERS   128
-#define NUM_TRANSFERS 1
+// Default number of buffers and USB transfers given to the sync interface
+#define DEFAULT_NUM_BUFFERS     16
+#define DEFAULT_NUM_TRANSFERS   8
+#define MAX_NUM_BUFFERS         256
+
+// The 8 bit wire format only exists on the bladeRF 2.0 with libbladeRF 2.4 and up
+#if defined(LIBBLADERF_API_VERSION) && (LIBBLADERF_API_VERSION >= 0x02040000)
+#define BLADERF_HAS_SC8
+#endif
+
+// SC16_Q11 samples span +/-2048 and are scaled by 32768, SC8_Q7 ones span +/-128 and are scaled to the same level
+#define SC16_SCALE  32768.0f
+#define SC8_SCALE   2048.0f
 
 SDRPP_MOD_INFO{
     /* Name:            */ "bladerf_source",
@@ -42,6 +55,12 @@ public:
         clocks.define("onboard", "On-Board", CLOCK_SELECT_ONBOARD);
         clocks.define("external", "External", CLOCK_SELECT_EXTERNAL);
 
+        // Define sample formats
+        formats.define("sc16", "16 bit", BLADERF_FORMAT_SC16_Q11);
+#ifdef BLADERF_HAS_SC8
+        formats.define("sc8", "8 bit", BLADERF_FORMAT_SC8_Q7);
+#endif
+
         sampleRate = 1000000.0;
 
         handler.ctx = this;
@@ -329,6 +348,24 @@ public:
             }
         }
 
+        // Load the sample format, 8 bit only being supported by the bladeRF 2.0
+        formatId = 0;
+        if (selectedBladeType == BLADERF_TYPE_V2 && config.conf["devices"][selectedSerial].contains("sampleFormat")) {
+            std::string fmt = config.conf["devices"][selectedSerial]["sampleFormat"];
+            if (formats.keyExists(fmt)) { formatId = formats.keyId(fmt); }
+        }
+
+        // Load the buffer and transfer counts
+        numBuffers = DEFAULT_NUM_BUFFERS;
+        numTransfers = DEFAULT_NUM_TRANSFERS;
+        if (config.conf["devices"][selectedSerial].contains("buffers")) {
+            numBuffers = config.conf["devices"][selectedSerial]["buffers"];
+        }
+        if (config.conf["devices"][selectedSerial].contains("transfers")) {
+            numTransfers = config.conf["devices"][selectedSerial]["transfers"];
+        }
+        clampBufferCounts();
+
         bladerf_close(openDev);
     }
 
@@ -395,14 +432,27 @@ private:
 
         _this->streamingEnabled = true;
 
-        // Setup synchronous transfer
-        bladerf_sync_config(_this->openDev, BLADERF_RX_X1, BLADERF_FORMAT_SC16_Q11, 16, _this->bufferSize, 8, 3500);
+        // Setup synchronous transfer, falling back to 16 bit if the FPGA doesn't support the 8 bit format
+        _this->format = (_this->selectedBladeType == BLADERF_TYPE_V2) ? _this->formats[_this->formatId] : BLADERF_FORMAT_SC16_Q11;
+        ret = bladerf_sync_config(_this->openDev, BLADERF_RX_X1, _this->format, _this->numBuffers, _this->bufferSize, _this->numTransfers, 3500);
+        if (ret != 0 && _this->format != BLADERF_FORMAT_SC16_Q11) {
+            flog::warn("BladeRFSourceModule '{0}': Could not use the 8 bit format ({1}), using 16 bit instead", _this->name, bladerf_strerror(ret));
+            _this->format = BLADERF_FORMAT_SC16_Q11;
+            ret = bladerf_sync_config(_this->openDev, BLADERF_RX_X1, _this->format, _this->numBuffers, _this->bufferSize, _this->numTransfers, 3500);
+        }
+        if (ret != 0) {
+            flog::error("BladeRFSourceModule '{0}': Could not configure the stream: {1}", _this->name, bladerf_strerror(ret));
+            _this->streamingEnabled = false;
+            bladerf_close(_this->openDev);
+            return;
+        }
 
         // Enable streaming
         bladerf_enable_module(_this->openDev, BLADERF_CHANNEL_RX(_this->chanId), true);
 
         _this->running = true;
         _this->workerThread = std::thread(&BladeRFSourceModule::worker, _this);
+        _this->convertThread = std::thread(&BladeRFSourceModule::converter, _this);
 
         flog::info("BladeRFSourceModule '{0}': Start!", _this->name);
     }
@@ -412,12 +462,19 @@ private:
         if (!_this->running) { return; }
         _this->running = false;
         _this->stream.stopWriter();
+        _this->rawStream.stopWriter();
+        _this->rawStream.stopReader();
 
         _this->streamingEnabled = false;
-        // Wait for read worker to terminate
+        // Wait for read worker and converter to terminate
         if (_this->workerThread.joinable()) {
             _this->workerThread.join();
         }
+        if (_this->convertThread.joinable()) {
+            _this->convertThread.join();
+        }
+        _this->rawStream.clearWriteStop();
+        _this->rawStream.clearReadStop();
 
         // Disable streaming
         bladerf_enable_module(_this->openDev, BLADERF_CHANNEL_RX(_this->chanId), false);
@@ -486,6 +543,31 @@ private:
             }
         }
 
+        // Sample format selection (only show if the 8 bit format is available)
+        if (_this->selectedBladeType == BLADERF_TYPE_V2 && _this->formats.size() > 1) {
+            SmGui::LeftLabel("Sample Format");
+            SmGui::FillWidth();
+            if (SmGui::Combo(CONCAT("##_balderf_fmt_sel_", _this->name), &_this->formatId, _this->formats.txt) && _this->selectedSerial != "") {
+                config.acquire();
+                config.conf["devices"][_this->selectedSerial]["sampleFormat"] = _this->formats.key(_this->formatId);
+                config.release(true);
+            }
+        }
+
+        SmGui::LeftLabel("Buffers");
+        SmGui::FillWidth();
+        if (SmGui::InputInt(CONCAT("##_balderf_bufs_sel_", _this->name), &_this->numBuffers, 1, 8)) {
+            _this->clampBufferCounts();
+            _this->saveBufferCounts();
+        }
+
+        SmGui::LeftLabel("Transfers");
+        SmGui::FillWidth();
+        if (SmGui::InputInt(CONCAT("##_balderf_xfers_sel_", _this->name), &_this->numTransfers, 1, 4)) {
+            _this->clampBufferCounts();
+            _this->saveBufferCounts();
+        }
+
         if (_this->running) { SmGui::EndDisabled(); }
 
         SmGui::LeftLabel("Bandwidth");
@@ -574,27 +656,66 @@ private:
         }
     }
 
+    // There must be at least one buffer more than there are transfers in flight
+    void clampBufferCounts() {
+        numBuffers = std::clamp<int>(numBuffers, 2, MAX_NUM_BUFFERS);
+        numTransfers = std::clamp<int>(numTransfers, 1, numBuffers - 1);
+    }
+
+    void saveBufferCounts() {
+        if (selectedSerial == "") { return; }
+        config.acquire();
+        config.conf["devices"][selectedSerial]["buffers"] = numBuffers;
+        config.conf["devices"][selectedSerial]["transfers"] = numTransfers;
+        config.release(true);
+    }
+
+    int bytesPerSample() {
+        return (format == BLADERF_FORMAT_SC16_Q11) ? 2 * sizeof(int16_t) : 2 * sizeof(int8_t);
+    }
+
+    // Only receives, so that the sync interface gets its buffers back as soon as possible. The conversion
+    // of a buffer happens on the converter thread while the next one is being received
     void worker() {
-        int16_t* buffer = new int16_t[bufferSize * 2];
         bladerf_metadata meta;
+        int bytes = bufferSize * bytesPerSample();
+        rawStream.reserve(bytes);
 
         while (streamingEnabled) {
             // Receive from the stream and break on error
-            int ret = bladerf_sync_rx(openDev, buffer, bufferSize, &meta, 3500);
+            int ret = bladerf_sync_rx(openDev, rawStream.writeBuf, bufferSize, &meta, 3500);
             if (ret != 0) { break; }
+            if (!rawStream.swap(bytes)) { break; }
+        }
+    }
+
+    void converter() {
+        int sampleSize = bytesPerSample();
+        while (true) {
+            int bytes = rawStream.read();
+            if (bytes < 0) { break; }
 
             // Convert to complex float and swap buffers
-            volk_16i_s32f_convert_32f((float*)stream.writeBuf, buffer, 32768.0f, bufferSize * 2);
-            if (!stream.swap(bufferSize)) { break; }
+            int count = bytes / sampleSize;
+#ifdef BLADERF_HAS_SC8
+            if (format == BLADERF_FORMAT_SC8_Q7) {
+                dsp::convert::S8ToComplex::process(count, (const int8_t*)rawStream.readBuf, stream.writeBuf, SC8_SCALE);
+            }
+            else
+#endif
+            {
+                dsp::convert::S16ToComplex::process(count, (const int16_t*)rawStream.readBuf, stream.writeBuf, SC16_SCALE);
+            }
+            rawStream.flush();
+            if (!stream.swap(count)) { break; }
         }
-
-        delete[] buffer;
     }
 
     std::string name;
     bladerf* openDev;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
+    dsp::stream<uint8_t> rawStream;
     double sampleRate;
     SourceManager::SourceHandler handler;
     bool running = false;
@@ -620,13 +741,19 @@ private:
     std::string bandwidthsTxt;
     std::string channelNamesTxt;
     OptionList<std::string, bladerf_clock_select> clocks;
+    OptionList<std::string, bladerf_format> formats;
+    int formatId = 0;
+    bladerf_format format = BLADERF_FORMAT_SC16_Q11;
 
     int bufferSize;
+    int numBuffers = DEFAULT_NUM_BUFFERS;
+    int numTransfers = DEFAULT_NUM_TRANSFERS;
     struct bladerf_stream* rxStream;
 
     int overallGain = 0;
 
     std::thread workerThread;
+    std::thread convertThread;
 
     int devCount = 0;
     bladerf_devinfo* devInfoList = NULL;
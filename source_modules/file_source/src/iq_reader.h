@@ -0,0 +1,409 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include <json.hpp>
+#include <volk/volk.h>
+#include <dsp/types.h>
+#include <dsp/convert/u8_to_complex.h>
+#include <dsp/convert/s8_to_complex.h>
+#include <dsp/convert/s16_to_complex.h>
+#include <utils/ziq.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define WAV_SIGNATURE           "RIFF"
+#define WAV_TYPE                "WAVE"
+#define WAV_FORMAT_MARK         "fmt "
+#define WAV_DATA_MARK           "data"
+#define WAV_SAMPLE_TYPE_PCM     1
+#define WAV_SAMPLE_TYPE_FLOAT   3
+
+// Amount of data ahead of the read position the prefetch thread asks the OS to bring in
+#define WAV_PREFETCH_SIZE       (64 * 1024 * 1024)
+#define WAV_PAGE_SIZE           4096
+
+enum SampleFormat {
+    SAMPLE_FORMAT_CU8,
+    SAMPLE_FORMAT_CI8,
+    SAMPLE_FORMAT_CI16,
+    SAMPLE_FORMAT_CF32,
+    _SAMPLE_FORMAT_COUNT
+};
+
+// SigMF names of the sample formats, also used as the extensions of raw files
+inline const char* sampleFormatNames[_SAMPLE_FORMAT_COUNT] = { "cu8", "ci8", "ci16_le", "cf32_le" };
+
+// IQ recording mapped in memory: a wav file, a SigMF recording (path to its .sigmf-meta or .sigmf-data) or a raw file.
+// The samples are converted directly from the mapping, a prefetch thread reading ahead of the position reported with
+// prefetch() so that playback doesn't stall on disk access. Compressed IQ recordings (.ziq) are not mapped, they are
+// decompressed block by block by a ziq::Reader instead
+class IQReader {
+public:
+    // Raw files have no header, the given format and samplerate are used for them. Wav files may override their
+    // format with forceFormat. Throws runtime_error if the file can't be opened or is invalid
+    IQReader(std::string path, SampleFormat rawFormat = SAMPLE_FORMAT_CI16, double rawSamplerate = 0.0, int forceFormat = -1) {
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+        if (ext == ".ziq") {
+            ziqReader = new ziq::Reader(path);
+            format = SAMPLE_FORMAT_CF32;
+            samplerate = ziqReader->getSampleRate();
+            frequency = ziqReader->getFrequency();
+            startTime = ziqReader->getStartTime();
+            return;
+        }
+        else if (ext == ".sigmf-meta" || ext == ".sigmf-data") {
+            std::filesystem::path base = std::filesystem::path(path).replace_extension("");
+            parseSigMF(base.string() + ".sigmf-meta");
+            map(base.string() + ".sigmf-data");
+            data = mapBase;
+            dataSize = mapSize;
+        }
+        else if (ext == ".wav") {
+            map(path);
+            if (!parseWav()) {
+                unmap();
+                throw std::runtime_error("Invalid wav file");
+            }
+            if (forceFormat >= 0 && forceFormat < _SAMPLE_FORMAT_COUNT) { format = (SampleFormat)forceFormat; }
+        }
+        else {
+            map(path);
+            data = mapBase;
+            dataSize = mapSize;
+            format = rawFormat;
+            samplerate = rawSamplerate;
+        }
+
+        // Start the prefetch thread
+        prefetchThread = std::thread(&IQReader::prefetchWorker, this);
+    }
+
+    ~IQReader() {
+        close();
+    }
+
+    SampleFormat getFormat() {
+        return format;
+    }
+
+    double getSampleRate() {
+        return samplerate;
+    }
+
+    // Center frequency given by the metadata, 0 if unknown
+    double getFrequency() {
+        return frequency;
+    }
+
+    // Start time of the recording given by the metadata in seconds since the epoch, negative if unknown
+    double getStartTime() {
+        return startTime;
+    }
+
+    // Size in bytes of a complex sample
+    int getFrameSize() {
+        switch (format) {
+        case SAMPLE_FORMAT_CU8:
+        case SAMPLE_FORMAT_CI8:
+            return 2 * sizeof(int8_t);
+        case SAMPLE_FORMAT_CI16:
+            return 2 * sizeof(int16_t);
+        default:
+            return sizeof(dsp::complex_t);
+        }
+    }
+
+    int64_t getFrameCount() {
+        if (ziqReader) { return ziqReader->getSampleCount(); }
+        return dataSize / getFrameSize();
+    }
+
+    // Convert count samples starting at the given one
+    void convert(int64_t frame, int count, dsp::complex_t* out) {
+        if (ziqReader) {
+            ziqReader->read(frame, count, out);
+            return;
+        }
+        const uint8_t* in = &data[frame * getFrameSize()];
+        switch (format) {
+        case SAMPLE_FORMAT_CU8:
+            dsp::convert::U8ToComplex::process(count, in, out);
+            break;
+        case SAMPLE_FORMAT_CI8:
+            dsp::convert::S8ToComplex::process(count, (const int8_t*)in, out);
+            break;
+        case SAMPLE_FORMAT_CI16:
+            dsp::convert::S16ToComplex::process(count, (const int16_t*)in, out);
+            break;
+        default:
+            memcpy(out, in, count * sizeof(dsp::complex_t));
+            break;
+        }
+    }
+
+    // Tell the prefetch thread which sample is being read
+    void prefetch(int64_t frame) {
+        if (ziqReader) {
+            ziqReader->prefetch(frame);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lck(prefetchMtx);
+            prefetchOffset = frame * getFrameSize();
+            prefetchPending = true;
+        }
+        prefetchCnd.notify_one();
+    }
+
+    void close() {
+        if (ziqReader) {
+            delete ziqReader;
+            ziqReader = NULL;
+        }
+        if (!mapBase) { return; }
+
+        // Stop the prefetch thread
+        {
+            std::lock_guard<std::mutex> lck(prefetchMtx);
+            prefetchStop = true;
+        }
+        prefetchCnd.notify_one();
+        if (prefetchThread.joinable()) { prefetchThread.join(); }
+
+        unmap();
+    }
+
+private:
+    void map(std::string path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) { throw std::runtime_error("Could not open file"); }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+            CloseHandle(file);
+            throw std::runtime_error("Could not get file size");
+        }
+        mapSize = size.QuadPart;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        mapBase = mapping ? (uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!mapBase) {
+            if (mapping) { CloseHandle(mapping); }
+            CloseHandle(file);
+            throw std::runtime_error("Could not map file");
+        }
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("Could not open file"); }
+        struct stat st;
+        if (fstat(fd, &st) || !st.st_size) {
+            ::close(fd);
+            throw std::runtime_error("Could not get file size");
+        }
+        mapSize = st.st_size;
+        void* ptr = mmap(NULL, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map file");
+        }
+        mapBase = (uint8_t*)ptr;
+        madvise(mapBase, mapSize, MADV_SEQUENTIAL);
+        pageSize = sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    void unmap() {
+        if (!mapBase) { return; }
+#ifdef _WIN32
+        UnmapViewOfFile(mapBase);
+        CloseHandle(mapping);
+        CloseHandle(file);
+#else
+        munmap(mapBase, mapSize);
+        ::close(fd);
+#endif
+        mapBase = NULL;
+        data = NULL;
+    }
+
+#pragma pack(push, 1)
+    struct ChunkHeader_t {
+        char id[4];
+        uint32_t size;
+    };
+
+    struct FormatChunk_t {
+        uint16_t sampleType; // PCM (1) or float (3)
+        uint16_t channelCount;
+        uint32_t sampleRate;
+        uint32_t bytesPerSecond;
+        uint16_t bytesPerSample;
+        uint16_t bitDepth;
+    };
+#pragma pack(pop)
+
+    // Find the format and data chunks, the data chunk not always directly following the format chunk
+    bool parseWav() {
+        if (mapSize < 12) { return false; }
+        if (memcmp(&mapBase[0], WAV_SIGNATURE, 4) || memcmp(&mapBase[8], WAV_TYPE, 4)) { return false; }
+
+        bool fmtFound = false;
+        size_t offset = 12;
+        while (offset + sizeof(ChunkHeader_t) <= mapSize) {
+            ChunkHeader_t chunk;
+            memcpy(&chunk, &mapBase[offset], sizeof(ChunkHeader_t));
+            offset += sizeof(ChunkHeader_t);
+
+            if (!memcmp(chunk.id, WAV_FORMAT_MARK, 4) && chunk.size >= sizeof(FormatChunk_t) && offset + sizeof(FormatChunk_t) <= mapSize) {
+                memcpy(&fmt, &mapBase[offset], sizeof(FormatChunk_t));
+                fmtFound = true;
+            }
+            else if (!memcmp(chunk.id, WAV_DATA_MARK, 4)) {
+                // Recorders that didn't finish writing leave a bogus size, use whatever is in the file
+                data = &mapBase[offset];
+                dataSize = std::min<size_t>(chunk.size ? chunk.size : mapSize, mapSize - offset);
+                if (!fmtFound || fmt.channelCount != 2) { return false; }
+                samplerate = fmt.sampleRate;
+                if (fmt.sampleType == WAV_SAMPLE_TYPE_FLOAT && fmt.bitDepth == 32) {
+                    format = SAMPLE_FORMAT_CF32;
+                }
+                else if (fmt.bitDepth == 8) {
+                    format = SAMPLE_FORMAT_CU8;
+                }
+                else if (fmt.bitDepth == 16) {
+                    format = SAMPLE_FORMAT_CI16;
+                }
+                else {
+                    return false;
+                }
+                return true;
+            }
+
+            // Chunks are padded to an even size
+            offset += chunk.size + (chunk.size & 1);
+        }
+        return false;
+    }
+
+    void parseSigMF(std::string metaPath) {
+        nlohmann::json meta;
+        try {
+            std::ifstream file(metaPath);
+            meta = nlohmann::json::parse(file);
+        }
+        catch (const std::exception& e) {
+            throw std::runtime_error("Could not read SigMF metadata: " + std::string(e.what()));
+        }
+
+        // Datatype and samplerate are required
+        auto& global = meta["global"];
+        if (!global.contains("core:datatype") || !global.contains("core:sample_rate")) {
+            throw std::runtime_error("SigMF metadata is missing the datatype or samplerate");
+        }
+        std::string datatype = global["core:datatype"];
+        auto it = std::find(std::begin(sampleFormatNames), std::end(sampleFormatNames), datatype);
+        if (it == std::end(sampleFormatNames)) {
+            throw std::runtime_error("Unsupported SigMF datatype: " + datatype);
+        }
+        format = (SampleFormat)std::distance(std::begin(sampleFormatNames), it);
+        samplerate = global["core:sample_rate"];
+
+        // Frequency and start time of the first capture, if given
+        if (!meta.contains("captures") || meta["captures"].empty()) { return; }
+        auto& capture = meta["captures"][0];
+        if (capture.contains("core:frequency")) { frequency = capture["core:frequency"]; }
+        if (capture.contains("core:datetime")) { startTime = parseISO8601(capture["core:datetime"]); }
+    }
+
+    // Parse a UTC time as written by SigMF ("YYYY-MM-DDTHH:MM:SS.sssZ"), negative on error
+    static double parseISO8601(std::string str) {
+        tm t = {};
+        double sec = 0.0;
+        if (sscanf(str.c_str(), "%d-%d-%dT%d:%d:%lf", &t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour, &t.tm_min, &sec) != 6) { return -1.0; }
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+#ifdef _WIN32
+        time_t base = _mkgmtime(&t);
+#else
+        time_t base = timegm(&t);
+#endif
+        return (base == -1) ? -1.0 : (double)base + sec;
+    }
+
+    void prefetchWorker() {
+        size_t aheadBegin = 0;
+        size_t aheadEnd = 0;
+        while (true) {
+            // Wait for a new read position
+            size_t offset;
+            {
+                std::unique_lock<std::mutex> lck(prefetchMtx);
+                prefetchCnd.wait(lck, [=]() { return prefetchPending || prefetchStop; });
+                if (prefetchStop) { return; }
+                offset = prefetchOffset;
+                prefetchPending = false;
+            }
+
+            // Only read ahead again once half of the previous window was consumed, or after a seek or loop
+            if (offset >= aheadBegin && offset + (WAV_PREFETCH_SIZE / 2) < aheadEnd) { continue; }
+            if (!data) { continue; }
+            size_t begin = (size_t)(data - mapBase) + std::min<size_t>(offset, dataSize);
+            size_t end = std::min<size_t>(begin + WAV_PREFETCH_SIZE, mapSize);
+            begin -= begin % pageSize;
+            aheadBegin = offset;
+            aheadEnd = offset + WAV_PREFETCH_SIZE;
+
+#ifdef _WIN32
+            // Touch every page of the window so that it's faulted in by this thread
+            volatile uint8_t sink = 0;
+            for (size_t i = begin; i < end; i += pageSize) {
+                sink += mapBase[i];
+            }
+#else
+            madvise(&mapBase[begin], end - begin, MADV_WILLNEED);
+#endif
+        }
+    }
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+    uint8_t* mapBase = NULL;
+    size_t mapSize = 0;
+    ziq::Reader* ziqReader = NULL;
+    size_t pageSize = WAV_PAGE_SIZE;
+
+    FormatChunk_t fmt = {};
+    SampleFormat format = SAMPLE_FORMAT_CI16;
+    double samplerate = 0.0;
+    double frequency = 0.0;
+    double startTime = -1.0;
+    const uint8_t* data = NULL;
+    size_t dataSize = 0;
+
+    std::thread prefetchThread;
+    std::mutex prefetchMtx;
+    std::condition_variable prefetchCnd;
+    size_t prefetchOffset = 0;
+    bool prefetchPending = false;
+    bool prefetchStop = false;
+};
@@ -3,8 +3,9 @@
 #include <utils/flog.h>
 #include <module.h>
 #include <gui/gui.h>
+#include <gui/style.h>
 #include <signal_path/signal_path.h>
-#include <wavreader.h>
+#include <iq_reader.h>
 #include <core.h>
 #include <gui/widgets/file_select.h>
 #include <filesystem>
@@ -12,6 +13,9 @@
 #include <gui/tuner.h>
 #include <algorithm>
 #include <stdexcept>
+#include <chrono>
+#include <atomic>
+#include <utils/optionlist.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -25,16 +29,56 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
+// If playback falls behind the wall clock by more than this, pacing restarts from the current time instead of catching up
+#define FILE_SOURCE_MAX_LAG 0.25
+
 class FileSourceModule : public ModuleManager::Instance {
 public:
-    FileSourceModule(std::string name) : fileSelect("", { "Wav IQ Files (*.wav)", "*.wav", "All Files", "*" }) {
+    FileSourceModule(std::string name) : fileSelect("", { "IQ Files", "*.wav *.ziq *.sigmf-meta *.cu8 *.ci8 *.cs8 *.ci16 *.cs16 *.cf32 *.cfile *.raw", "Wav IQ Files (*.wav)", "*.wav", "Compressed IQ Files (*.ziq)", "*.ziq", "SigMF Recordings (*.sigmf-meta)", "*.sigmf-meta", "All Files", "*" }) {
         this->name = name;
 
         if (core::args["server"].b()) { return; }
 
+        // Define playback speeds, 0 meaning as fast as the DSP can take
+        speeds.define("0.25x", 0.25);
+        speeds.define("0.5x", 0.5);
+        speeds.define("1x", 1.0);
+        speeds.define("2x", 2.0);
+        speeds.define("4x", 4.0);
+        speeds.define("8x", 8.0);
+        speeds.define("Unlimited", 0.0);
+
+        // Define sample formats, auto using the metadata or the extension of raw files
+        formats.define("auto", "Auto", -1);
+        formats.define("cu8", "Unsigned 8 bit (cu8)", SAMPLE_FORMAT_CU8);
+        formats.define("ci8", "Signed 8 bit (ci8)", SAMPLE_FORMAT_CI8);
+        formats.define("ci16_le", "Signed 16 bit (ci16_le)", SAMPLE_FORMAT_CI16);
+        formats.define("cf32_le", "Float 32 bit (cf32_le)", SAMPLE_FORMAT_CF32);
+
         config.acquire();
         fileSelect.setPath(config.conf["path"], true);
+        formatId = 0;
+        if (config.conf.contains("format") && formats.keyExists(config.conf["format"])) {
+            formatId = formats.keyId(config.conf["format"]);
+        }
+        if (config.conf.contains("rawSamplerate")) {
+            rawSamplerate = config.conf["rawSamplerate"];
+        }
+        if (config.conf.contains("speed") && speeds.keyExists(config.conf["speed"])) {
+            speedId = speeds.keyId(config.conf["speed"]);
+        }
+        else {
+            speedId = speeds.valueId(1.0);
+        }
         config.release();
+        speed = speeds.value(speedId);
+
+        // Offline batch mode plays as fast as possible and only once
+        offline = core::args["offline"].b();
+        if (offline) {
+            speedId = speeds.valueId(0.0);
+            speed = 0.0;
+        }
 
         handler.ctx = this;
         handler.selectHandler = menuSelected;
@@ -92,7 +136,8 @@ private:
         if (_this->running) { return; }
         if (_this->reader == NULL) { return; }
         _this->running = true;
-        _this->workerThread = _this->float32Mode ? std::thread(floatWorker, _this) : std::thread(worker, _this);
+        _this->finished = false;
+        _this->workerThread = std::thread(worker, _this);
         flog::info("FileSourceModule '{0}': Start!", _this->name);
     }
 
@@ -104,7 +149,8 @@ private:
         _this->workerThread.join();
         _this->stream.clearWriteStop();
         _this->running = false;
-        _this->reader->rewind();
+        _this->position = 0;
+        sigpath::streamClock.release();
         flog::info("FileSourceModule '{0}': Stop!", _this->name);
     }
 
@@ -118,66 +164,226 @@ private:
 
         if (_this->fileSelect.render("##file_source_" + _this->name)) {
             if (_this->fileSelect.pathIsValid()) {
-                if (_this->reader != NULL) {
-                    _this->reader->close();
-                    delete _this->reader;
-                }
-                try {
-                    _this->reader = new WavReader(_this->fileSelect.path);
-                    if (_this->reader->getSampleRate() == 0) {
-                        _this->reader->close();
-                        delete _this->reader;
-                        _this->reader = NULL;
-                        throw std::runtime_error("Sample rate may not be zero");
-                    }
-                    _this->sampleRate = _this->reader->getSampleRate();
-                    core::setInputSampleRate(_this->sampleRate);
-                    std::string filename = std::filesystem::path(_this->fileSelect.path).filename().string();
-                    _this->centerFreq = _this->getFrequency(filename);
-                    tuner::tune(tuner::TUNER_MODE_IQ_ONLY, "", _this->centerFreq);
-                    //gui::freqSelect.minFreq = _this->centerFreq - (_this->sampleRate/2);
-                    //gui::freqSelect.maxFreq = _this->centerFreq + (_this->sampleRate/2);
-                    //gui::freqSelect.limitFreq = true;
-                }
-                catch (const std::exception& e) {
-                    flog::error("Error: {}", e.what());
-                }
+                _this->openFile();
                 config.acquire();
                 config.conf["path"] = _this->fileSelect.path;
                 config.release(true);
             }
         }
 
-        ImGui::Checkbox("Float32 Mode##_file_source", &_this->float32Mode);
+        // SigMF and compressed recordings describe their format, other files may need it to be set
+        bool sigmf = _this->isSigMF(_this->fileSelect.path) || _this->isZIQ(_this->fileSelect.path);
+        bool raw = !sigmf && !_this->isWav(_this->fileSelect.path);
+        if (_this->running || sigmf) { ImGui::BeginDisabled(); }
+        ImGui::LeftLabel("Format");
+        ImGui::FillWidth();
+        if (ImGui::Combo("##_file_source_format", &_this->formatId, _this->formats.txt)) {
+            if (_this->fileSelect.pathIsValid()) { _this->openFile(); }
+            config.acquire();
+            config.conf["format"] = _this->formats.key(_this->formatId);
+            config.release(true);
+        }
+        if (raw) {
+            ImGui::LeftLabel("Samplerate");
+            ImGui::FillWidth();
+            if (ImGui::InputDouble("##_file_source_sr", &_this->rawSamplerate, 0, 0, "%.0f", ImGuiInputTextFlags_EnterReturnsTrue)) {
+                _this->rawSamplerate = std::max<double>(_this->rawSamplerate, 1.0);
+                if (_this->fileSelect.pathIsValid()) { _this->openFile(); }
+                config.acquire();
+                config.conf["rawSamplerate"] = _this->rawSamplerate;
+                config.release(true);
+            }
+        }
+        if (_this->running || sigmf) { ImGui::EndDisabled(); }
+
+        ImGui::LeftLabel("Speed");
+        ImGui::FillWidth();
+        if (_this->offline) { ImGui::BeginDisabled(); }
+        if (ImGui::Combo("##_file_source_speed", &_this->speedId, _this->speeds.txt)) {
+            _this->speed = _this->speeds.value(_this->speedId);
+            config.acquire();
+            config.conf["speed"] = _this->speeds.key(_this->speedId);
+            config.release(true);
+        }
+        if (_this->offline) { ImGui::EndDisabled(); }
+
+        // Position slider, seeking is done by the worker on its next block
+        if (_this->reader) {
+            int64_t frames = _this->reader->getFrameCount();
+            float duration = (double)frames / _this->sampleRate;
+            float pos = (double)_this->position / _this->sampleRate;
+            char posText[64];
+            int posSec = pos, durSec = duration;
+            sprintf(posText, "%02d:%02d:%02d / %02d:%02d:%02d", posSec / 3600, (posSec / 60) % 60, posSec % 60, durSec / 3600, (durSec / 60) % 60, durSec % 60);
+            ImGui::FillWidth();
+            if (ImGui::SliderFloat("##_file_source_pos", &pos, 0.0f, duration, posText)) {
+                int64_t target = std::clamp<int64_t>(pos * _this->sampleRate, 0, frames ? frames - 1 : 0);
+                if (_this->running) {
+                    _this->seekTarget = target;
+                }
+                else {
+                    _this->position = target;
+                }
+            }
+        }
+
+        if (_this->finished) {
+            ImGui::TextUnformatted("Status:");
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Finished");
+        }
     }
 
-    static void worker(void* ctx) {
-        FileSourceModule* _this = (FileSourceModule*)ctx;
-        double sampleRate = std::max(_this->reader->getSampleRate(), (uint32_t)1);
-        int blockSize = std::min((int)(sampleRate / 200.0f), (int)STREAM_BUFFER_SIZE);
-        int16_t* inBuf = new int16_t[blockSize * 2];
+    static bool hasExtension(const std::string& path, std::initializer_list<const char*> exts) {
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return std::find(exts.begin(), exts.end(), ext) != exts.end();
+    }
 
-        while (true) {
-            _this->reader->readSamples(inBuf, blockSize * 2 * sizeof(int16_t));
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, inBuf, 32768.0f, blockSize * 2);
-            if (!_this->stream.swap(blockSize)) { break; };
+    static bool isWav(const std::string& path) { return hasExtension(path, { ".wav" }); }
+
+    static bool isSigMF(const std::string& path) { return hasExtension(path, { ".sigmf-meta", ".sigmf-data" }); }
+
+    static bool isZIQ(const std::string& path) { return hasExtension(path, { ".ziq" }); }
+
+    // Format of a raw file guessed from its extension, ci16 if unknown
+    static SampleFormat guessRawFormat(const std::string& path) {
+        if (hasExtension(path, { ".cu8" })) { return SAMPLE_FORMAT_CU8; }
+        if (hasExtension(path, { ".ci8", ".cs8" })) { return SAMPLE_FORMAT_CI8; }
+        if (hasExtension(path, { ".cf32", ".cfile", ".fc32" })) { return SAMPLE_FORMAT_CF32; }
+        return SAMPLE_FORMAT_CI16;
+    }
+
+    void openFile() {
+        // The worker reads straight from the mapping, it can't outlive the reader
+        bool wasRunning = running;
+        stop(this);
+        if (reader != NULL) {
+            delete reader;
+            reader = NULL;
+        }
+
+        try {
+            std::string path = fileSelect.path;
+            int format = formats.value(formatId);
+            SampleFormat rawFormat = (format < 0) ? guessRawFormat(path) : (SampleFormat)format;
+            reader = new IQReader(path, rawFormat, rawSamplerate, format);
+            if (!reader->getFrameCount()) { throw std::runtime_error("File contains no samples"); }
+            if (reader->getSampleRate() <= 0) { throw std::runtime_error("Sample rate may not be zero"); }
+
+            position = 0;
+            sampleRate = reader->getSampleRate();
+            core::setInputSampleRate(sampleRate);
+
+            // Prefer the metadata to what the file name says
+            std::string filename = std::filesystem::path(path).filename().string();
+            centerFreq = reader->getFrequency() ? reader->getFrequency() : getFrequency(filename);
+            recordingTime = (reader->getStartTime() >= 0) ? reader->getStartTime() : getRecordingTime(filename);
+            tuner::tune(tuner::TUNER_MODE_IQ_ONLY, "", centerFreq);
+            //gui::freqSelect.minFreq = centerFreq - (sampleRate/2);
+            //gui::freqSelect.maxFreq = centerFreq + (sampleRate/2);
+            //gui::freqSelect.limitFreq = true;
+        }
+        catch (const std::exception& e) {
+            flog::error("Error: {}", e.what());
+            if (reader) {
+                delete reader;
+                reader = NULL;
+            }
+            return;
         }
 
-        delete[] inBuf;
+        if (wasRunning) { start(this); }
     }
 
-    static void floatWorker(void* ctx) {
+    static void worker(void* ctx) {
         FileSourceModule* _this = (FileSourceModule*)ctx;
-        double sampleRate = std::max(_this->reader->getSampleRate(), (uint32_t)1);
-        int blockSize = std::min((int)(sampleRate / 200.0f), (int)STREAM_BUFFER_SIZE);
-        dsp::complex_t* inBuf = new dsp::complex_t[blockSize];
+        IQReader* reader = _this->reader;
+        double sampleRate = std::max<double>(reader->getSampleRate(), 1.0);
+        int blockSize = std::clamp<int>(sampleRate / 200.0, 1, STREAM_BUFFER_SIZE);
+        int64_t frames = reader->getFrameCount();
+        if (!frames) { return; }
+
+        auto pacingStart = std::chrono::steady_clock::now();
+        int64_t pacedSamples = 0;
+        double pacedSpeed = -1.0;
+        int64_t pos = std::min<int64_t>(_this->position, frames - 1);
+        bool offline = _this->offline;
+        sigpath::streamClock.drive(_this->recordingTime + (double)pos / sampleRate);
 
         while (true) {
-            _this->reader->readSamples(_this->stream.writeBuf, blockSize * sizeof(dsp::complex_t));
-            if (!_this->stream.swap(blockSize)) { break; };
+            // Apply pending seeks
+            int64_t seek = _this->seekTarget.exchange(-1);
+            if (seek >= 0) {
+                pos = std::clamp<int64_t>(seek, 0, frames - 1);
+                pacedSpeed = -1.0;
+                sigpath::streamClock.drive(_this->recordingTime + (double)pos / sampleRate);
+            }
+
+            // Restart pacing when the speed changes or after a seek
+            double speed = _this->speed;
+            if (speed != pacedSpeed) {
+                pacingStart = std::chrono::steady_clock::now();
+                pacedSamples = 0;
+                pacedSpeed = speed;
+            }
+
+            // Convert the samples straight from the mapping into the stream, looping at the end of the file unless offline
+            int filled = 0;
+            bool end = false;
+            while (filled < blockSize && !end) {
+                int n = std::min<int64_t>(blockSize - filled, frames - pos);
+                reader->convert(pos, n, &_this->stream.writeBuf[filled]);
+                filled += n;
+                pos += n;
+                if (pos >= frames) {
+                    pos = 0;
+                    end = offline;
+                    if (!offline) { sigpath::streamClock.drive(_this->recordingTime); }
+                }
+            }
+            _this->position = pos;
+            reader->prefetch(pos);
+
+            if (!_this->stream.swap(filled)) { break; };
+            sigpath::streamClock.advance(filled, sampleRate);
+
+            // In offline mode, playback ends with the file
+            if (end) {
+                flog::info("FileSourceModule '{0}': Reached the end of the file", _this->name);
+                _this->finished = true;
+                break;
+            }
+
+            // Wait until the block is due according to the wall clock
+            if (speed <= 0.0) { continue; }
+            pacedSamples += blockSize;
+            auto due = pacingStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(pacedSamples / (sampleRate * speed)));
+            auto now = std::chrono::steady_clock::now();
+            if (now > due + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(FILE_SOURCE_MAX_LAG))) {
+                pacedSpeed = -1.0;
+            }
+            else if (now < due) {
+                std::this_thread::sleep_until(due);
+            }
         }
+    }
 
-        delete[] inBuf;
+    // Start time of a recording named by the recorder ("..._HH-MM-SS_DD-MM-YYYY..."), the current time if it isn't
+    double getRecordingTime(std::string filename) {
+        std::regex expr("([0-9]{2})-([0-9]{2})-([0-9]{2})_([0-9]{2})-([0-9]{2})-([0-9]{4})");
+        std::smatch matches;
+        if (!std::regex_search(filename, matches, expr)) { return (double)time(0); }
+        tm ltm = {};
+        ltm.tm_hour = std::stoi(matches[1].str());
+        ltm.tm_min = std::stoi(matches[2].str());
+        ltm.tm_sec = std::stoi(matches[3].str());
+        ltm.tm_mday = std::stoi(matches[4].str());
+        ltm.tm_mon = std::stoi(matches[5].str()) - 1;
+        ltm.tm_year = std::stoi(matches[6].str()) - 1900;
+        ltm.tm_isdst = -1;
+        time_t t = mktime(&ltm);
+        return (t == -1) ? (double)time(0) : (double)t;
     }
 
     double getFrequency(std::string filename) {
@@ -193,15 +399,28 @@ private:
     std::string name;
     dsp::stream<dsp::complex_t> stream;
     SourceManager::SourceHandler handler;
-    WavReader* reader = NULL;
+    IQReader* reader = NULL;
     bool running = false;
     bool enabled = true;
     float sampleRate = 1000000;
     std::thread workerThread;
 
     double centerFreq = 100000000;
+    double recordingTime = 0.0;
+    bool offline = false;
+    std::atomic<bool> finished = false;
+
+    OptionList<std::string, int> formats;
+    int formatId = 0;
+    double rawSamplerate = 1000000.0;
+
+    OptionList<std::string, double> speeds;
+    int speedId = 0;
+    std::atomic<double> speed = 1.0;
 
-    bool float32Mode = false;
+    // Playback position in samples, and the position the worker must jump to or -1
+    std::atomic<int64_t> position = 0;
+    std::atomic<int64_t> seekTarget = -1;
 };
 
 MOD_EXPORT void _INIT_() {
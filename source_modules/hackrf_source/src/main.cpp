@@ -7,6 +7,23 @@
 #include <config.h>
 #include <gui/widgets/stepped_slider.h>
 #include <gui/smgui.h>
+#include <dsp/convert/s8_to_complex.h>
+#include <dsp/buffer/source_ingress.h>
+
+// Size of the USB transfers of libhackrf
+#define HACKRF_TRANSFER_SIZE    262144
+
+// Native sweeping as done by hackrf_sweep. Each tuning gives a block starting with a header holding its frequency, the
+// LO being offset from it so that the bins kept, away from the DC spike and the edges of the filter, cover a step in
+// two tunings. Needs USB API 1.02 (firmware 2017.02.1)
+#define HACKRF_SWEEP_MIN_API        0x0102
+#define HACKRF_SWEEP_BLOCK_SIZE     16384
+#define HACKRF_SWEEP_HEADER_SIZE    10
+#define HACKRF_SWEEP_SAMPLERATE     20000000
+#define HACKRF_SWEEP_FILTER_BW      15000000
+#define HACKRF_SWEEP_STEP           20000000
+#define HACKRF_SWEEP_OFFSET         7500000
+#define HACKRF_SWEEP_MAX_FREQ_MHZ   7250
 
 #ifndef __ANDROID__
 #include <libhackrf/hackrf.h>
@@ -96,7 +113,13 @@ public:
         handler.startHandler = start;
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
+        handler.sweepHandler = sweep;
         handler.stream = &stream;
+        handler.stats = &stats;
+
+        ingress.init(&stream, [](const int8_t* in, int count, dsp::complex_t* out) {
+            return dsp::convert::S8ToComplex::process(count / 2, in, out);
+        }, HACKRF_TRANSFER_SIZE);
 
         refresh();
 
@@ -267,6 +290,9 @@ private:
         hackrf_set_lna_gain(_this->openDev, _this->lna);
         hackrf_set_vga_gain(_this->openDev, _this->vga);
 
+        // The USB callback only queues the transfers, they are converted on the ingress thread
+        _this->ingress.setSamplerate(_this->sampleRate);
+        _this->ingress.start();
         hackrf_start_rx(_this->openDev, callback, _this);
 
         _this->running = true;
@@ -277,25 +303,79 @@ private:
         HackRFSourceModule* _this = (HackRFSourceModule*)ctx;
         if (!_this->running) { return; }
         _this->running = false;
-        _this->stream.stopWriter();
+        _this->sweeping = false;
         // TODO: Stream stop
         hackrf_error err = (hackrf_error)hackrf_close(_this->openDev);
         if (err != HACKRF_SUCCESS) {
             flog::error("Could not close HackRF {0}: {1}", _this->selectedSerial, hackrf_error_name(err));
         }
-        _this->stream.clearWriteStop();
+        _this->ingress.stop();
         flog::info("HackRFSourceModule '{0}': Stop!", _this->name);
     }
 
     static void tune(double freq, void* ctx) {
         HackRFSourceModule* _this = (HackRFSourceModule*)ctx;
-        if (_this->running) {
+        if (_this->running && !_this->sweeping) {
             hackrf_set_freq(_this->openDev, freq);
         }
         _this->freq = freq;
         flog::info("HackRFSourceModule '{0}': Tune: {1}!", _this->name, freq);
     }
 
+    static bool sweep(bool enabled, double startFreq, double stopFreq, int fftSize, void* ctx) {
+        HackRFSourceModule* _this = (HackRFSourceModule*)ctx;
+        if (!_this->running) { return false; }
+
+        if (!enabled) {
+            if (!_this->sweeping) { return true; }
+            hackrf_stop_rx(_this->openDev);
+            _this->sweeping = false;
+            _this->startStreaming();
+            flog::info("HackRFSourceModule '{0}': Sweep stopped", _this->name);
+            return true;
+        }
+
+        // The FFT must fit in a block after the header
+        if (fftSize > (HACKRF_SWEEP_BLOCK_SIZE - HACKRF_SWEEP_HEADER_SIZE) / 2) { return false; }
+        uint16_t api = 0;
+        if (hackrf_usb_api_version_read(_this->openDev, &api) != HACKRF_SUCCESS || api < HACKRF_SWEEP_MIN_API) {
+            flog::warn("HackRFSourceModule '{0}': Firmware too old to sweep, hopping in software instead", _this->name);
+            return false;
+        }
+
+        // The band is given in MHz and rounded to whole steps
+        int stepMHz = HACKRF_SWEEP_STEP / 1000000;
+        int startMHz = floor(startFreq / 1e6);
+        int steps = std::max<int>(1, ceil((stopFreq / 1e6 - startMHz) / stepMHz));
+        uint16_t freqs[2] = { (uint16_t)startMHz, (uint16_t)(startMHz + (steps * stepMHz)) };
+        if (startMHz < 0 || freqs[1] > HACKRF_SWEEP_MAX_FREQ_MHZ) { return false; }
+
+        hackrf_stop_rx(_this->openDev);
+        hackrf_set_sample_rate(_this->openDev, HACKRF_SWEEP_SAMPLERATE);
+        hackrf_set_baseband_filter_bandwidth(_this->openDev, HACKRF_SWEEP_FILTER_BW);
+        hackrf_error err = (hackrf_error)hackrf_init_sweep(_this->openDev, freqs, 1, HACKRF_SWEEP_BLOCK_SIZE, HACKRF_SWEEP_STEP, HACKRF_SWEEP_OFFSET, INTERLEAVED);
+        if (err != HACKRF_SUCCESS) {
+            flog::error("HackRFSourceModule '{0}': Could not start sweeping: {1}", _this->name, hackrf_error_name(err));
+            _this->startStreaming();
+            return false;
+        }
+
+        _this->sweepFFTSize = fftSize;
+        _this->sweepBuf.resize(fftSize);
+        _this->sweeping = true;
+        hackrf_start_rx_sweep(_this->openDev, sweepCallback, _this);
+        flog::info("HackRFSourceModule '{0}': Sweeping from {1}MHz to {2}MHz", _this->name, freqs[0], freqs[1]);
+        return true;
+    }
+
+    // Go back to streaming with the settings of the menu
+    void startStreaming() {
+        hackrf_set_sample_rate(openDev, sampleRate);
+        hackrf_set_baseband_filter_bandwidth(openDev, bandwidthIdToBw(bwId));
+        hackrf_set_freq(openDev, freq);
+        hackrf_start_rx(openDev, callback, this);
+    }
+
     static void menuHandler(void* ctx) {
         HackRFSourceModule* _this = (HackRFSourceModule*)ctx;
 
@@ -332,7 +412,7 @@ private:
         SmGui::LeftLabel("Bandwidth");
         SmGui::FillWidth();
         if (SmGui::Combo(CONCAT("##_hackrf_bw_sel_", _this->name), &_this->bwId, bandwidthsTxt)) {
-            if (_this->running) {
+            if (_this->running && !_this->sweeping) {
                 hackrf_set_baseband_filter_bandwidth(_this->openDev, _this->bandwidthIdToBw(_this->bwId));
             }
             config.acquire();
@@ -383,8 +463,31 @@ private:
 
     static int callback(hackrf_transfer* transfer) {
         HackRFSourceModule* _this = (HackRFSourceModule*)transfer->rx_ctx;
-        volk_8i_s32f_convert_32f((float*)_this->stream.writeBuf, (int8_t*)transfer->buffer, 128.0f, transfer->valid_length);
-        if (!_this->stream.swap(transfer->valid_length / 2)) { return -1; }
+        if (_this->ingress.push((int8_t*)transfer->buffer, transfer->valid_length)) {
+            _this->stats.delivered(transfer->valid_length / 2);
+        }
+        else {
+            _this->stats.overflow();
+        }
+        return 0;
+    }
+
+    static int sweepCallback(hackrf_transfer* transfer) {
+        HackRFSourceModule* _this = (HackRFSourceModule*)transfer->rx_ctx;
+        int fftSize = _this->sweepFFTSize;
+        for (int i = 0; i + HACKRF_SWEEP_BLOCK_SIZE <= transfer->valid_length; i += HACKRF_SWEEP_BLOCK_SIZE) {
+            const uint8_t* block = &transfer->buffer[i];
+            if (block[0] != 0x7F || block[1] != 0x7F) { continue; }
+            uint64_t freq;
+            memcpy(&freq, &block[2], sizeof(uint64_t));
+
+            // The last samples of the block are the furthest from the retune
+            const int8_t* samples = (const int8_t*)&block[HACKRF_SWEEP_BLOCK_SIZE - (fftSize * 2)];
+            dsp::convert::S8ToComplex::process(fftSize, samples, _this->sweepBuf.data());
+            sigpath::sweeper.pushHop((double)(freq + HACKRF_SWEEP_OFFSET), HACKRF_SWEEP_SAMPLERATE, _this->sweepBuf.data(), fftSize,
+                                     HACKRF_SWEEP_SAMPLERATE / 8, (HACKRF_SWEEP_SAMPLERATE * 3) / 8);
+        }
+        _this->stats.delivered(transfer->valid_length / 2);
         return 0;
     }
 
@@ -394,7 +497,12 @@ private:
     dsp::stream<dsp::complex_t> stream;
     int sampleRate;
     SourceManager::SourceHandler handler;
+    dsp::buffer::SourceIngress<int8_t> ingress;
+    SourceStats stats;
     bool running = false;
+    bool sweeping = false;
+    int sweepFFTSize = 0;
+    std::vector<dsp::complex_t> sweepBuf;
     double freq;
     std::string selectedSerial = "";
     int devId = 0;
@@ -7,6 +7,8 @@
 #include <utils/optionlist.h>
 #include <htra_api.h>
 #include <atomic>
+#include <dsp/convert/s8_to_complex.h>
+#include <dsp/convert/s16_to_complex.h>
 
 SDRPP_MOD_INFO{
     /* Name:            */ "harogic_source",
@@ -442,10 +444,10 @@ private:
 
             // Convert them to floating point
             if (sampsInt8) {
-                volk_8i_s32f_convert_32f((float*)&stream.writeBuf[(count++)*bufferSize], (int8_t*)iqs.AlternIQStream, 128.0f, realSamps);
+                dsp::convert::S8ToComplex::process(realSamps / 2, (int8_t*)iqs.AlternIQStream, &stream.writeBuf[(count++)*bufferSize]);
             }
             else {
-                volk_16i_s32f_convert_32f((float*)&stream.writeBuf[(count++)*bufferSize], (int16_t*)iqs.AlternIQStream, 32768.0f, realSamps);
+                dsp::convert::S16ToComplex::process(realSamps / 2, (int16_t*)iqs.AlternIQStream, &stream.writeBuf[(count++)*bufferSize]);
             }
 
             // Send them off if we have enough
@@ -1,5 +1,17 @@
 #include "hermes.h"
 #include <utils/flog.h>
+#include <algorithm>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define HERMES_UNPACK_SSSE3
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HERMES_UNPACK_NEON
+#endif
+
+// Scale of the 24 bit samples
+#define HERMES_SAMPLE_SCALE     (1.0f / (float)0x1000000)
 
 namespace hermes {
     const int SAMPLERATE_LIST[] = {
@@ -9,6 +21,40 @@ namespace hermes {
         384000
     };
 
+    // Convert count samples of 24 bit big endian IQ spaced stride bytes apart. The I and Q of the device are swapped.
+    // The vector paths take two samples at a time, the three bytes of each value being shuffled into the top of a 32
+    // bit lane so that an arithmetic shift sign extends them. Only the first 8 bytes of each sample are read, which
+    // never goes past the frame since a sample is always followed by at least 2 more bytes
+    static void unpackIQ(const uint8_t* iq, int stride, int count, dsp::complex_t* out) {
+        int i = 0;
+#if defined(HERMES_UNPACK_SSSE3)
+        const __m128i shuf = _mm_setr_epi8(-1, 5, 4, 3, -1, 2, 1, 0, -1, 13, 12, 11, -1, 10, 9, 8);
+        const __m128 scale = _mm_set1_ps(HERMES_SAMPLE_SCALE);
+        for (; i + 2 <= count; i += 2) {
+            __m128i a = _mm_loadl_epi64((const __m128i*)&iq[i * stride]);
+            __m128i b = _mm_loadl_epi64((const __m128i*)&iq[(i + 1) * stride]);
+            __m128i v = _mm_shuffle_epi8(_mm_unpacklo_epi64(a, b), shuf);
+            __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(v, 8)), scale);
+            _mm_storeu_ps((float*)&out[i], f);
+        }
+#elif defined(HERMES_UNPACK_NEON)
+        static const uint8_t shufBytes[16] = { 0xFF, 5, 4, 3, 0xFF, 2, 1, 0, 0xFF, 13, 12, 11, 0xFF, 10, 9, 8 };
+        const uint8x16_t shuf = vld1q_u8(shufBytes);
+        for (; i + 2 <= count; i += 2) {
+            uint8x16_t v = vcombine_u8(vld1_u8(&iq[i * stride]), vld1_u8(&iq[(i + 1) * stride]));
+            int32x4_t s = vshrq_n_s32(vreinterpretq_s32_u8(vqtbl1q_u8(v, shuf)), 8);
+            vst1q_f32((float*)&out[i], vmulq_n_f32(vcvtq_f32_s32(s), HERMES_SAMPLE_SCALE));
+        }
+#endif
+        for (; i < count; i++) {
+            const uint8_t* s = &iq[i * stride];
+            int32_t si = ((uint32_t)s[0] << 24) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 8);
+            int32_t sq = ((uint32_t)s[3] << 24) | ((uint32_t)s[4] << 16) | ((uint32_t)s[5] << 8);
+            out[i].re = (float)(sq >> 8) * HERMES_SAMPLE_SCALE;
+            out[i].im = (float)(si >> 8) * HERMES_SAMPLE_SCALE;
+        }
+    }
+
     Client::Client(std::shared_ptr<net::Socket> sock) {
         this->sock = sock;
 
@@ -20,12 +66,14 @@ namespace hermes {
         sock->close();
 
         // Wait for worker to exit
-        out.stopWriter();
+        for (auto& o : out) { o.stopWriter(); }
         if (workerThread.joinable()) { workerThread.join(); }
-        out.clearWriteStop();
+        for (auto& o : out) { o.clearWriteStop(); }
     }
 
     void Client::start() {
+        restartSeq = true;
+
         // Start metis stream
         for (int i = 0; i < HERMES_METIS_REPEAT; i++) {
             sendMetisControl((MetisControl)(METIS_CTRL_IQ | METIS_CTRL_NO_WD));
@@ -39,11 +87,21 @@ namespace hermes {
     }
 
     void Client::setSamplerate(HermesLiteSamplerate samplerate) {
-        writeReg(0, (uint32_t)samplerate << 24);
+        this->samplerate = samplerate;
         blockSize = SAMPLERATE_LIST[samplerate] / 200;
+        writeConfig();
     }
 
-    void Client::setFrequency(double freq) {
+    void Client::setReceivers(int count) {
+        receivers = std::clamp<int>(count, 1, HERMES_MAX_RECEIVERS);
+        writeConfig();
+    }
+
+    void Client::setFrequency(double freq, int receiver) {
+        if (receiver) {
+            writeReg(HL_REG_RX2_NCO_FREQ + receiver - 1, freq);
+            return;
+        }
         this->freq = freq;
         writeReg(HL_REG_TX1_NCO_FREQ, freq);
         autoFilters(freq);
@@ -162,63 +220,88 @@ namespace hermes {
 #endif
     }
 
+    void Client::writeConfig() {
+        writeReg(0, ((uint32_t)samplerate << 24) | ((uint32_t)(receivers - 1) << 3));
+    }
+
     void Client::worker() {
-        uint8_t rbuf[2048];
-        MetisUSBPacket* pkt = (MetisUSBPacket*)rbuf;
+        // Packets are received in batches and put back in order of sequence number
+        net::DatagramBatch batch(HERMES_UDP_BATCH, 2048);
+        net::JitterBuffer jitter(HERMES_JITTER_DEPTH, HERMES_METIS_PACKET_SIZE);
         int sampleCount = 0;
-
-        while (true) {
-            // Wait for a packet or exit if connection closed
-            int len = sock->recv(rbuf, 2048);
-            if (len <= 0) { break; }
-
-            // Ignore anything that's not a USB packet
-            // TODO: Gotta check the endpoint
-            if (htons(pkt->hdr.signature) != HERMES_METIS_SIGNATURE || pkt->hdr.type != METIS_PKT_USB) {
+        bool running = true;
+        auto handler = [&](const uint8_t* data, int size, uint64_t missing) {
+            running &= processPacket(data, size, sampleCount);
+        };
+
+        while (running) {
+            // Wait for packets or exit if connection closed
+            int count = sock->recvBatch(batch);
+            if (count <= 0) {
+                if (!sock->isOpen()) { break; }
                 continue;
             }
 
-            // Parse frames
-            for (int frn = 0; frn < 2; frn++) {
-                uint8_t* frame = pkt->frame[frn];
-                HPSDRUSBHeader* hdr = (HPSDRUSBHeader*)frame;
+            if (restartSeq.exchange(false)) {
+                jitter.flush(handler);
+                jitter.reset();
+            }
 
-                // Make sure this is a valid frame by checking the sync
-                if (hdr->sync[0] != 0x7F || hdr->sync[1] != 0x7F || hdr->sync[2] != 0x7F) {
+            for (int i = 0; i < count && running; i++) {
+                // Ignore anything that's not a USB packet
+                // TODO: Gotta check the endpoint
+                MetisUSBPacket* pkt = (MetisUSBPacket*)batch.data(i);
+                if (batch.size(i) < HERMES_METIS_PACKET_SIZE || htons(pkt->hdr.signature) != HERMES_METIS_SIGNATURE || pkt->hdr.type != METIS_PKT_USB) {
                     continue;
                 }
+                jitter.push(htonl(pkt->seq), batch.data(i), HERMES_METIS_PACKET_SIZE, handler);
+            }
+        }
 
-                // Check if this is a response
-                if (hdr->c0 & (1 << 7)) {
-                    uint8_t reg = (hdr->c0 >> 1) & 0x3F;
-                    flog::warn("Got response! Reg={0}, Seq={1}", reg, (uint32_t)htonl(pkt->seq));
-                }
+        auto stats = jitter.getStats();
+        if (stats.lost || stats.reordered) {
+            flog::info("Hermes: {} packets lost, {} reordered", stats.lost, stats.reordered);
+        }
+    }
 
-                // Decode and save IQ to buffer
-                uint8_t* iq = &frame[8];
-                dsp::complex_t* writeBuf = &out.writeBuf[sampleCount];
-                for (int i = 0; i < HERMES_SAMPLES_PER_FRAME; i++) {
-                    // Convert to 32bit
-                    int32_t si = ((uint32_t)iq[(i*8) + 0] << 16) | ((uint32_t)iq[(i*8) + 1] << 8) | (uint32_t)iq[(i*8) + 2];
-                    int32_t sq = ((uint32_t)iq[(i*8) + 3] << 16) | ((uint32_t)iq[(i*8) + 4] << 8) | (uint32_t)iq[(i*8) + 5];
-                    
-                    // Sign extend
-                    si = (si << 8) >> 8;
-                    sq = (sq << 8) >> 8;
-
-                    // Convert to float (IQ swapped for some reason)
-                    writeBuf[i].im = (float)si / (float)0x1000000;
-                    writeBuf[i].re = (float)sq / (float)0x1000000;
-                }
-                sampleCount += HERMES_SAMPLES_PER_FRAME;
+    bool Client::processPacket(const uint8_t* rbuf, int len, int& sampleCount) {
+        MetisUSBPacket* pkt = (MetisUSBPacket*)rbuf;
 
-                // If enough samples are in the buffer, send to stream
-                if (sampleCount >= blockSize) {
-                    out.swap(sampleCount);
-                    sampleCount = 0;
+        // Parse frames
+        for (int frn = 0; frn < 2; frn++) {
+            uint8_t* frame = pkt->frame[frn];
+            HPSDRUSBHeader* hdr = (HPSDRUSBHeader*)frame;
+
+            // Make sure this is a valid frame by checking the sync
+            if (hdr->sync[0] != 0x7F || hdr->sync[1] != 0x7F || hdr->sync[2] != 0x7F) {
+                continue;
+            }
+
+            // Check if this is a response
+            if (hdr->c0 & (1 << 7)) {
+                uint8_t reg = (hdr->c0 >> 1) & 0x3F;
+                flog::warn("Got response! Reg={0}, Seq={1}", reg, (uint32_t)htonl(pkt->seq));
+            }
+
+            // Each sample holds the IQ of every receiver followed by two bytes of microphone audio
+            int rxCount = receivers;
+            int stride = (6 * rxCount) + 2;
+            int frameSamples = HERMES_FRAME_IQ_SIZE / stride;
+            uint8_t* iq = &frame[8];
+            for (int rx = 0; rx < rxCount; rx++) {
+                unpackIQ(&iq[6 * rx], stride, frameSamples, &out[rx].writeBuf[sampleCount]);
+            }
+            sampleCount += frameSamples;
+
+            // If enough samples are in the buffer, send to stream
+            if (sampleCount >= blockSize) {
+                for (int rx = 0; rx < rxCount; rx++) {
+                    if (!out[rx].swap(sampleCount)) { return false; }
                 }
-            }            
+                sampleCount = 0;
+            }
         }
+        return true;
     }
 
     std::vector<Info> discover() {
@@ -290,6 +373,7 @@ namespace hermes {
     std::shared_ptr<Client> open(const net::Address& addr) {
         // Open UDP socket
         auto sock = net::openudp(addr);
+        sock->setRecvBufferSize(NET_UDP_STREAM_BUFFER_SIZE);
 
         // TODO: Check if open successful
         return std::make_shared<Client>(sock);
@@ -1,11 +1,13 @@
 #pragma once
 #include <utils/net.h>
+#include <utils/jitter_buffer.h>
 #include <dsp/stream.h>
 #include <dsp/types.h>
 #include <memory>
 #include <vector>
 #include <string>
 #include <thread>
+#include <atomic>
 
 #define HERMES_METIS_REPEAT         5
 #define HERMES_METIS_TIMEOUT        1000
@@ -13,6 +15,13 @@
 #define HERMES_HPSDR_USB_SYNC       0x7F
 #define HERMES_I2C_DELAY            50
 #define HERMES_SAMPLES_PER_FRAME    63
+#define HERMES_FRAME_IQ_SIZE        504
+#define HERMES_MAX_RECEIVERS        4
+#define HERMES_METIS_PACKET_SIZE    1032
+
+// Packets taken per receive call, and held back at most to put them in order
+#define HERMES_UDP_BATCH            64
+#define HERMES_JITTER_DEPTH         32
 
 namespace hermes {
     enum MetisPacketType {
@@ -135,11 +144,17 @@ namespace hermes {
         void stop();
 
         void setSamplerate(HermesLiteSamplerate samplerate);
-        void setFrequency(double freq);
+
+        // Number of DDC receivers of the device that stream samples, each to its own output. Must be called before
+        // starting the stream
+        void setReceivers(int count);
+
+        // The filters follow the first receiver
+        void setFrequency(double freq, int receiver = 0);
         void setGain(int gain);
         void autoFilters(double freq);
 
-        dsp::stream<dsp::complex_t> out;
+        dsp::stream<dsp::complex_t> out[HERMES_MAX_RECEIVERS];
 
     private:
         void sendMetisUSB(uint8_t endpoint, void* frame0, void* frame1 = NULL);
@@ -150,17 +165,26 @@ namespace hermes {
 
         void writeI2C(I2CPort port, uint8_t addr, uint8_t reg, uint8_t data);
 
+        // Samplerate and number of receivers share the first register
+        void writeConfig();
+
         void worker();
+        bool processPacket(const uint8_t* rbuf, int len, int& sampleCount);
 
         double freq = 0;
 
         int blockSize = 63;
+        HermesLiteSamplerate samplerate = HL_SAMP_RATE_384KHZ;
+        std::atomic<int> receivers = 1;
 
         std::thread workerThread;
         std::shared_ptr<net::Socket> sock;
         uint32_t usbSeq = 0;
         uint8_t lastFilt = 0;
 
+        // The device numbers its packets from 0 again when the stream is started
+        std::atomic<bool> restartSeq = true;
+
     };
 
     std::vector<Info> discover();
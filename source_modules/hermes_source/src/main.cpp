@@ -9,6 +9,7 @@
 #include <gui/smgui.h>
 #include <gui/widgets/stepped_slider.h>
 #include <dsp/routing/stream_link.h>
+#include <dsp/sink/null_sink.h>
 #include <utils/optionlist.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
@@ -49,12 +50,44 @@ public:
         handler.tuneHandler = tune;
         handler.stream = &stream;
 
+        // Define the number of receivers
+        for (int i = 1; i <= HERMES_MAX_RECEIVERS; i++) {
+            receiverCounts.define(i, std::to_string(i) + ((i > 1) ? " receivers" : " receiver"), i);
+        }
+
+        // The other receivers of the device feed the signal path of their name if it was created, their samples are
+        // dropped otherwise
+        for (int i = 0; i < HERMES_MAX_RECEIVERS - 1; i++) {
+            ExtraReceiver& rx = extras[i];
+            rx.module = this;
+            rx.receiver = i + 1;
+            rx.name = "Hermes RX" + std::to_string(i + 2);
+            rx.lnk.init(NULL, &rx.stream);
+            rx.nullSink.init(&rx.stream);
+            rx.path = sigpath::getPath(rx.name);
+            if (!rx.path) { continue; }
+
+            rx.handler.ctx = &rx;
+            rx.handler.selectHandler = extraSelected;
+            rx.handler.deselectHandler = extraDeselected;
+            rx.handler.menuHandler = extraMenuHandler;
+            rx.handler.startHandler = extraStart;
+            rx.handler.stopHandler = extraStop;
+            rx.handler.tuneHandler = extraTune;
+            rx.handler.stream = &rx.stream;
+            rx.path->sourceManager.registerSource(rx.name, &rx.handler);
+            rx.path->sourceManager.selectSource(rx.name);
+        }
+
         sigpath::sourceManager.registerSource("Hermes", &handler);
     }
 
     ~HermesSourceModule() {
         stop(this);
         sigpath::sourceManager.unregisterSource("Hermes");
+        for (auto& rx : extras) {
+            if (rx.path) { rx.path->sourceManager.unregisterSource(rx.name); }
+        }
     }
 
     void postInit() {}
@@ -102,6 +135,8 @@ private:
         // Default config
         srId = samplerates.valueId(hermes::HL_SAMP_RATE_384KHZ);
         gain = 0;
+        rxCountId = 0;
+        for (auto& rx : extras) { rx.freq = 7000000; }
 
         // Load config
         devId = devices.keyId(mac);
@@ -114,10 +149,34 @@ private:
         if (config.conf["devices"][selectedMac].contains("gain")) {
             gain = config.conf["devices"][selectedMac]["gain"];
         }
+        if (config.conf["devices"][selectedMac].contains("receivers")) {
+            int count = config.conf["devices"][selectedMac]["receivers"];
+            if (receiverCounts.keyExists(count)) { rxCountId = receiverCounts.keyId(count); }
+        }
+        if (config.conf["devices"][selectedMac].contains("rxFrequencies")) {
+            auto& freqs = config.conf["devices"][selectedMac]["rxFrequencies"];
+            for (int i = 0; i < HERMES_MAX_RECEIVERS - 1 && i < (int)freqs.size(); i++) { extras[i].freq = freqs[i]; }
+        }
         config.release();
 
         // Update host samplerate
         sampleRate = samplerates.key(srId);
+        updateExtraSamplerates();
+    }
+
+    void updateExtraSamplerates() {
+        for (auto& rx : extras) {
+            if (rx.path) { rx.path->iqFrontEnd.setSampleRate(sampleRate); }
+        }
+    }
+
+    void saveExtraFrequencies() {
+        if (selectedMac.empty()) { return; }
+        config.acquire();
+        json freqs = json::array();
+        for (auto& rx : extras) { freqs.push_back(rx.freq); }
+        config.conf["devices"][selectedMac]["rxFrequencies"] = freqs;
+        config.release(true);
     }
 
     static void menuSelected(void* ctx) {
@@ -153,14 +212,26 @@ private:
         _this->dev = hermes::open(_this->devices[_this->devId].addr);
 
         // TODO: STOP USING A LINK, FIND A BETTER WAY
-        _this->lnk.setInput(&_this->dev->out);
+        int receivers = _this->receiverCounts[_this->rxCountId];
+        _this->lnk.setInput(&_this->dev->out[0]);
         _this->lnk.start();
+        for (int i = 0; i < receivers - 1; i++) {
+            ExtraReceiver& rx = _this->extras[i];
+            rx.lnk.setInput(&_this->dev->out[rx.receiver]);
+            rx.lnk.start();
+            if (!rx.path) { rx.nullSink.start(); }
+        }
+        _this->dev->setReceivers(receivers);
         _this->dev->start();
 
         // TODO: Check if the USB commands are accepted before start
         _this->dev->setSamplerate(_this->samplerates[_this->srId]);
         _this->dev->setFrequency(_this->freq);
+        for (int i = 0; i < receivers - 1; i++) {
+            _this->dev->setFrequency(_this->extras[i].freq, _this->extras[i].receiver);
+        }
         _this->dev->setGain(_this->gain);
+        _this->activeReceivers = receivers;
 
         _this->running = true;
         flog::info("HermesSourceModule '{0}': Start!", _this->name);
@@ -175,6 +246,11 @@ private:
         _this->dev->stop();
         _this->dev->close();
         _this->lnk.stop();
+        for (auto& rx : _this->extras) {
+            rx.lnk.stop();
+            rx.nullSink.stop();
+        }
+        _this->activeReceivers = 0;
 
         flog::info("HermesSourceModule '{0}': Stop!", _this->name);
     }
@@ -209,6 +285,7 @@ private:
         if (SmGui::Combo(CONCAT("##_hermes_sr_sel_", _this->name), &_this->srId, _this->samplerates.txt)) {
             _this->sampleRate = _this->samplerates.key(_this->srId);
             core::setInputSampleRate(_this->sampleRate);
+            _this->updateExtraSamplerates();
             if (!_this->selectedMac.empty()) {
                 config.acquire();
                 config.conf["devices"][_this->selectedMac]["samplerate"] = _this->samplerates.key(_this->srId);
@@ -228,8 +305,34 @@ private:
             core::setInputSampleRate(_this->sampleRate);
         }
 
+        SmGui::LeftLabel("Receivers");
+        SmGui::FillWidth();
+        if (SmGui::Combo(CONCAT("##_hermes_rx_count_", _this->name), &_this->rxCountId, _this->receiverCounts.txt)) {
+            if (!_this->selectedMac.empty()) {
+                config.acquire();
+                config.conf["devices"][_this->selectedMac]["receivers"] = _this->receiverCounts.key(_this->rxCountId);
+                config.release(true);
+            }
+        }
+
         if (_this->running) { SmGui::EndDisabled(); }
 
+        // Frequencies of the other receivers, tuned through their signal path when there's one
+        for (int i = 0; i < _this->receiverCounts[_this->rxCountId] - 1; i++) {
+            ExtraReceiver& rx = _this->extras[i];
+            SmGui::LeftLabel(CONCAT("RX", std::to_string(i + 2)));
+            SmGui::FillWidth();
+            if (SmGui::InputInt(CONCAT("##_hermes_rx_freq_", _this->name + std::to_string(i)), &rx.freq, 1000, 100000)) {
+                rx.freq = std::clamp<int>(rx.freq, 0, 38400000);
+                if (rx.path) { rx.path->sourceManager.tune(rx.freq); }
+                else { extraTune(rx.freq, &rx); }
+                _this->saveExtraFrequencies();
+            }
+            if (!rx.path) {
+                SmGui::Text(CONCAT("Not streamed, no signal path named ", rx.name));
+            }
+        }
+
         // TODO: Device parameters
 
         SmGui::LeftLabel("LNA Gain");
@@ -246,6 +349,35 @@ private:
         }
     }
 
+    // Receivers of the device beyond the first one
+    struct ExtraReceiver {
+        HermesSourceModule* module;
+        int receiver;
+        std::string name;
+        SignalPath* path = NULL;
+        dsp::stream<dsp::complex_t> stream;
+        dsp::routing::StreamLink<dsp::complex_t> lnk;
+        dsp::sink::Null<dsp::complex_t> nullSink;
+        SourceManager::SourceHandler handler;
+        int freq = 7000000;
+    };
+
+    // The device is started and stopped with the first receiver, the others only follow it
+    static void extraSelected(void* ctx) {}
+    static void extraDeselected(void* ctx) {}
+    static void extraMenuHandler(void* ctx) {}
+    static void extraStart(void* ctx) {}
+    static void extraStop(void* ctx) {}
+
+    static void extraTune(double freq, void* ctx) {
+        ExtraReceiver* rx = (ExtraReceiver*)ctx;
+        HermesSourceModule* _this = rx->module;
+        rx->freq = freq;
+        if (_this->running && rx->receiver < _this->activeReceivers) {
+            _this->dev->setFrequency(freq, rx->receiver);
+        }
+    }
+
     std::string name;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
@@ -257,6 +389,10 @@ private:
 
     OptionList<std::string, hermes::Info> devices;
     OptionList<int, hermes::HermesLiteSamplerate> samplerates;
+    OptionList<int, int> receiverCounts;
+    ExtraReceiver extras[HERMES_MAX_RECEIVERS - 1];
+    int rxCountId = 0;
+    int activeReceivers = 0;
 
     double freq;
     int devId = 0;
@@ -7,6 +7,7 @@
 #include <utils/optionlist.h>
 #include "kcsdr.h"
 #include <atomic>
+#include <dsp/convert/s16_to_complex.h>
 
 SDRPP_MOD_INFO{
     /* Name:            */ "kcsdr_source",
@@ -273,7 +274,7 @@ private:
             }
 
             // Convert the samples to float
-            volk_16i_s32f_convert_32f((float*)stream.writeBuf, samps, 8192.0f, count*2);
+            dsp::convert::S16ToComplex::process(count, samps, stream.writeBuf, 8192.0f);
 
             // Send out the samples
             if (!stream.swap(count)) { break; }
@@ -7,10 +7,17 @@
 #include <config.h>
 #include <gui/smgui.h>
 #include <lime/LimeSuite.h>
+#include <utils/optionlist.h>
+#include <dsp/convert/s16_to_complex.h>
 
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+// Defaults for the length of the LimeSuite FIFO and of each read from it, in milliseconds of samples
+#define DEFAULT_FIFO_MS     20
+#define DEFAULT_BATCH_MS    5
+#define MAX_FIFO_MS         1000
+
 SDRPP_MOD_INFO{
     /* Name:            */ "limesdr_source",
     /* Description:     */ "LimeSDR source module for SDR++",
@@ -21,11 +28,24 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
+// Format of the samples handed over by LimeSuite. With the integer ones, the samples cross the USB link in that same
+// format and are converted by SDR++, the 12 bit one being packed on the link
+enum LimeSampleFormat {
+    LIME_FORMAT_F32,
+    LIME_FORMAT_I16,
+    LIME_FORMAT_I12
+};
+
 class LimeSDRSourceModule : public ModuleManager::Instance {
 public:
     LimeSDRSourceModule(std::string name) {
         this->name = name;
 
+        // Define sample formats
+        formats.define("f32", "Float (LimeSuite)", LIME_FORMAT_F32);
+        formats.define("i16", "16 bit", LIME_FORMAT_I16);
+        formats.define("i12", "12 bit (packed)", LIME_FORMAT_I12);
+
         // Init limesuite if needed
 
         sampleRate = 10000000.0;
@@ -275,6 +295,24 @@ public:
             gain = 0;
         }
 
+        // Load sample format
+        formatId = formats.valueId(LIME_FORMAT_F32);
+        if (config.conf["devices"][selectedDevName].contains("sampleFormat")) {
+            std::string fmt = config.conf["devices"][selectedDevName]["sampleFormat"];
+            if (formats.keyExists(fmt)) { formatId = formats.keyId(fmt); }
+        }
+
+        // Load FIFO and batch lengths
+        fifoMs = DEFAULT_FIFO_MS;
+        batchMs = DEFAULT_BATCH_MS;
+        if (config.conf["devices"][selectedDevName].contains("fifoMs")) {
+            fifoMs = config.conf["devices"][selectedDevName]["fifoMs"];
+        }
+        if (config.conf["devices"][selectedDevName].contains("batchMs")) {
+            batchMs = config.conf["devices"][selectedDevName]["batchMs"];
+        }
+        clampBufferLengths();
+
         config.release(true);
 
         LMS_Close(dev);
@@ -348,12 +386,25 @@ private:
         LMS_SetLPF(_this->openDev, false, _this->chanId, true);
 
         // Setup and start stream
-        int sampCount = _this->sampleRate / 200;
+        _this->format = _this->formats[_this->formatId];
         _this->devStream.isTx = false;
         _this->devStream.channel = _this->chanId;
-        _this->devStream.fifoSize = sampCount; // TODO: Check what it's actually supposed to be
+        _this->devStream.fifoSize = std::max<int>(_this->sampleRate * _this->fifoMs / 1000.0, _this->getBatchSize());
         _this->devStream.throughputVsLatency = 0.5f;
-        _this->devStream.dataFmt = _this->devStream.LMS_FMT_F32;
+        switch (_this->format) {
+        case LIME_FORMAT_I16:
+            _this->devStream.dataFmt = _this->devStream.LMS_FMT_I16;
+            _this->devStream.linkFmt = _this->devStream.LMS_LINK_FMT_I16;
+            break;
+        case LIME_FORMAT_I12:
+            _this->devStream.dataFmt = _this->devStream.LMS_FMT_I12;
+            _this->devStream.linkFmt = _this->devStream.LMS_LINK_FMT_I12;
+            break;
+        default:
+            _this->devStream.dataFmt = _this->devStream.LMS_FMT_F32;
+            _this->devStream.linkFmt = _this->devStream.LMS_LINK_FMT_DEFAULT;
+            break;
+        }
         LMS_SetupStream(_this->openDev, &_this->devStream);
 
         // Start stream
@@ -437,6 +488,28 @@ private:
             }
         }
 
+        SmGui::LeftLabel("Sample Format");
+        SmGui::FillWidth();
+        if (SmGui::Combo(CONCAT("##_limesdr_fmt_sel_", _this->name), &_this->formatId, _this->formats.txt) && _this->selectedDevName != "") {
+            config.acquire();
+            config.conf["devices"][_this->selectedDevName]["sampleFormat"] = _this->formats.key(_this->formatId);
+            config.release(true);
+        }
+
+        SmGui::LeftLabel("FIFO (ms)");
+        SmGui::FillWidth();
+        if (SmGui::InputInt(CONCAT("##_limesdr_fifo_sel_", _this->name), &_this->fifoMs, 1, 10)) {
+            _this->clampBufferLengths();
+            _this->saveBufferLengths();
+        }
+
+        SmGui::LeftLabel("Batch (ms)");
+        SmGui::FillWidth();
+        if (SmGui::InputInt(CONCAT("##_limesdr_batch_sel_", _this->name), &_this->batchMs, 1, 10)) {
+            _this->clampBufferLengths();
+            _this->saveBufferLengths();
+        }
+
         if (_this->running) { SmGui::EndDisabled(); }
 
         SmGui::LeftLabel("Antenna");
@@ -479,13 +552,49 @@ private:
         }
     }
 
+    // A batch can't hold more than the FIFO
+    void clampBufferLengths() {
+        fifoMs = std::clamp<int>(fifoMs, 1, MAX_FIFO_MS);
+        batchMs = std::clamp<int>(batchMs, 1, fifoMs);
+    }
+
+    void saveBufferLengths() {
+        if (selectedDevName == "") { return; }
+        config.acquire();
+        config.conf["devices"][selectedDevName]["fifoMs"] = fifoMs;
+        config.conf["devices"][selectedDevName]["batchMs"] = batchMs;
+        config.release(true);
+    }
+
+    int getBatchSize() {
+        return std::clamp<int>(sampleRate * batchMs / 1000.0, 1, STREAM_BUFFER_SIZE);
+    }
+
     void worker() {
-        int sampCount = sampleRate / 200;
+        int sampCount = getBatchSize();
         lms_stream_meta_t meta;
+
+        // Float samples are received straight into the stream
+        if (format == LIME_FORMAT_F32) {
+            while (streamRunning) {
+                int ret = LMS_RecvStream(&devStream, stream.writeBuf, sampCount, &meta, 1000);
+                if (ret < 0) { break; }
+                if (ret && !stream.swap(ret)) { break; }
+            }
+            return;
+        }
+
+        // 12 bit samples come sign extended to 16 bit
+        float scale = (format == LIME_FORMAT_I12) ? 2048.0f : 32768.0f;
+        int16_t* samples = dsp::buffer::alloc<int16_t>(sampCount * 2);
         while (streamRunning) {
-            int ret = LMS_RecvStream(&devStream, stream.writeBuf, sampCount, &meta, 1000);
-            if (!stream.swap(sampCount) || ret < 0) { break; }
+            int ret = LMS_RecvStream(&devStream, samples, sampCount, &meta, 1000);
+            if (ret < 0) { break; }
+            if (!ret) { continue; }
+            dsp::convert::S16ToComplex::process(ret, samples, stream.writeBuf, scale);
+            if (!stream.swap(ret)) { break; }
         }
+        dsp::buffer::free(samples);
     }
 
     std::string name;
@@ -527,6 +636,12 @@ private:
     std::vector<std::string> antennaNameList;
     int antennaCount = 0;
 
+    OptionList<std::string, LimeSampleFormat> formats;
+    int formatId = 0;
+    LimeSampleFormat format = LIME_FORMAT_F32;
+    int fifoMs = DEFAULT_FIFO_MS;
+    int batchMs = DEFAULT_BATCH_MS;
+
     std::thread workerThread;
 };
 
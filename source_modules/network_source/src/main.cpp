@@ -9,6 +9,8 @@
 #include <gui/smgui.h>
 #include <gui/widgets/stepped_slider.h>
 #include <utils/optionlist.h>
+#include <dsp/convert/s8_to_complex.h>
+#include <dsp/convert/s16_to_complex.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -35,6 +37,12 @@ enum SampleType {
     SAMPLE_TYPE_FLOAT32
 };
 
+// Datagrams taken per receive call
+#define NETWORK_SOURCE_UDP_BATCH    64
+
+// Time the kernel busy polls for datagrams before sleeping, when enabled
+#define NETWORK_SOURCE_BUSY_POLL_US 50
+
 const size_t SAMPLE_TYPE_SIZE[] {
     2*sizeof(int8_t),
     2*sizeof(int16_t),
@@ -91,6 +99,9 @@ public:
             port = config.conf[name]["port"];
             port = std::clamp<int>(port, 1, 65535);
         }
+        if (config.conf[name].contains("busyPoll")) {
+            busyPoll = config.conf[name]["busyPoll"];
+        }
         config.release();
 
         // Set menu IDs
@@ -165,6 +176,12 @@ private:
             else if (_this->proto == PROTOCOL_UDP) {
                 // Open UDP socket
                 _this->sock = net::openudp("0.0.0.0", _this->port, _this->hostname, _this->port, true);
+                if (!_this->sock->setRecvBufferSize(NET_UDP_STREAM_BUFFER_SIZE)) {
+                    flog::warn("Could not enlarge the receive buffer of the UDP socket");
+                }
+                if (_this->busyPoll && !_this->sock->setBusyPoll(NETWORK_SOURCE_BUSY_POLL_US)) {
+                    flog::warn("Could not enable busy polling on the UDP socket");
+                }
             }
         }
         catch (const std::exception& e) {
@@ -266,6 +283,15 @@ private:
         }
         if (!applyEn) { SmGui::EndDisabled(); }
 
+        // Trade CPU time for wakeup latency at high samplerates
+        if (_this->proto == PROTOCOL_UDP) {
+            if (SmGui::Checkbox(CONCAT("Busy Polling##network_source_busy_poll_", _this->name), &_this->busyPoll)) {
+                config.acquire();
+                config.conf[_this->name]["busyPoll"] = _this->busyPoll;
+                config.release(true);
+            }
+        }
+
         if (_this->tempSamplerate != _this->samplerate) {
             SmGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Warning: Samplerate not applied yet");
         }
@@ -273,14 +299,66 @@ private:
         if (_this->running) { SmGui::EndDisabled(); }
     }
 
+    // Convert a block of samples to CF32 (note: problem if partial sample)
+    void convert(const uint8_t* data, int count, dsp::complex_t* out) {
+        switch (sampType) {
+        case SAMPLE_TYPE_INT8:
+            dsp::convert::S8ToComplex::process(count, (int8_t*)data, out);
+            break;
+        case SAMPLE_TYPE_INT16:
+            dsp::convert::S16ToComplex::process(count, (int16_t*)data, out);
+            break;
+        case SAMPLE_TYPE_INT32:
+            volk_32i_s32f_convert_32f((float*)out, (int32_t*)data, 2147483647.0f, count*2);
+            break;
+        case SAMPLE_TYPE_FLOAT32:
+            memcpy(out, data, count * sizeof(dsp::complex_t));
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Datagrams are received in batches, the samples of a whole batch being sent out at once
+    void udpWorker() {
+        int sampleSize = SAMPLE_TYPE_SIZE[sampType];
+        net::DatagramBatch batch(NETWORK_SOURCE_UDP_BATCH);
+        int inBuffer = 0;
+
+        while (true) {
+            int count = sock->recvBatch(batch);
+            if (count <= 0) { break; }
+
+            for (int i = 0; i < count; i++) {
+                int samples = std::min<int>(batch.size(i) / sampleSize, STREAM_BUFFER_SIZE);
+                if (inBuffer + samples > STREAM_BUFFER_SIZE) {
+                    if (!stream.swap(inBuffer)) { return; }
+                    inBuffer = 0;
+                }
+                convert(batch.data(i), samples, &stream.writeBuf[inBuffer]);
+                inBuffer += samples;
+            }
+
+            if (inBuffer) {
+                if (!stream.swap(inBuffer)) { return; }
+                inBuffer = 0;
+            }
+        }
+    }
+
     void worker() {
+        if (proto == PROTOCOL_UDP) {
+            udpWorker();
+            return;
+        }
+
         // Compute sizes
         int blockSize = samplerate / 200;
         int sampleSize = SAMPLE_TYPE_SIZE[sampType];
 
         // Chose amount of bytes to attempt to read
-        bool forceSize = (proto != PROTOCOL_UDP);
-        int frameSize = sampleSize * (forceSize ? blockSize : STREAM_BUFFER_SIZE);
+        bool forceSize = true;
+        int frameSize = sampleSize * blockSize;
 
         // Allocate receive buffer
         uint8_t* buffer = dsp::buffer::alloc<uint8_t>(frameSize);
@@ -290,24 +368,9 @@ private:
             int bytes = sock->recv(buffer, frameSize, forceSize);
             if (bytes <= 0) { break; }
 
-            // Convert to CF32 (note: problem if partial sample)
+            // Convert to CF32
             int count = bytes / sampleSize;
-            switch (sampType) {
-            case SAMPLE_TYPE_INT8:
-                volk_8i_s32f_convert_32f((float*)stream.writeBuf, (int8_t*)buffer, 128.0f, count*2);
-                break;
-            case SAMPLE_TYPE_INT16:
-                volk_16i_s32f_convert_32f((float*)stream.writeBuf, (int16_t*)buffer, 32768.0f, count*2);
-                break;
-            case SAMPLE_TYPE_INT32:
-                volk_32i_s32f_convert_32f((float*)stream.writeBuf, (int32_t*)buffer, 2147483647.0f, count*2);
-                break;
-            case SAMPLE_TYPE_FLOAT32:
-                memcpy(stream.writeBuf, buffer, bytes);
-                break;
-            default:
-                break;
-            }
+            convert(buffer, count, stream.writeBuf);
 
             // Send out converted samples
             if (!stream.swap(count)) { break; }
@@ -332,6 +395,7 @@ private:
     int sampTypeId;
     char hostname[1024] = "localhost";
     int port = 1234;
+    bool busyPoll = false;
 
     OptionList<std::string, Protocol> protocols;
     OptionList<std::string, SampleType> sampleTypes;
@@ -10,6 +10,9 @@
 #include <utils/optionlist.h>
 #include <algorithm>
 #include <regex>
+#include <errno.h>
+#include <dsp/convert/s16_to_complex.h>
+#include <dsp/buffer/source_ingress.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -46,6 +49,21 @@ public:
             bandwidths.define(bw, getBandwdithScaled(bw), bw);
         }
 
+        // Define kernel buffer counts
+        kernelBufferCounts.define(4, "4", 4);
+        kernelBufferCounts.define(8, "8", 8);
+        kernelBufferCounts.define(16, "16", 16);
+        kernelBufferCounts.define(32, "32", 32);
+        kernelBufferCounts.define(64, "64", 64);
+
+        // Define buffer sizes, auto being 5ms of samples
+        bufferSizes.define(0, "Auto", 0);
+        bufferSizes.define(32768, "32K", 32768);
+        bufferSizes.define(131072, "128K", 131072);
+        bufferSizes.define(262144, "256K", 262144);
+        bufferSizes.define(524288, "512K", 524288);
+        bufferSizes.define(1048576, "1M", 1048576);
+
         // Define gain modes
         gainModes.define("manual", "Manual", "manual");
         gainModes.define("fast_attack", "Fast Attack", "fast_attack");
@@ -70,6 +88,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.stats = &stats;
         sigpath::sourceManager.registerSource("PlutoSDR", &handler);
     }
 
@@ -218,6 +237,8 @@ private:
         bandwidth = 0;
         gmId = 0;
         gain = -1.0f;
+        kbcId = kernelBufferCounts.keyId(4);
+        bsId = 0;
 
         // Load device config
         config.acquire();
@@ -241,6 +262,14 @@ private:
             gain = config.conf["devices"][devDesc]["gain"];
             gain = std::clamp<int>(gain, -1.0f, 73.0f);
         }
+        if (config.conf["devices"][devDesc].contains("kernelBuffers")) {
+            int kbc = config.conf["devices"][devDesc]["kernelBuffers"];
+            if (kernelBufferCounts.keyExists(kbc)) { kbcId = kernelBufferCounts.keyId(kbc); }
+        }
+        if (config.conf["devices"][devDesc].contains("bufferSize")) {
+            int bs = config.conf["devices"][devDesc]["bufferSize"];
+            if (bufferSizes.keyExists(bs)) { bsId = bufferSizes.keyId(bs); }
+        }
         config.release();
 
         // Update samplerate ID
@@ -321,6 +350,17 @@ private:
         // Configure the ADC filters
         ad9361_set_bb_rate(_this->phy, round(_this->samplerate));
 
+        // Start the conversion thread, queuing enough buffers for about 250ms of samples
+        _this->blockSize = _this->bufferSizes.value(_this->bsId);
+        if (!_this->blockSize) { _this->blockSize = _this->samplerate / 200; }
+        int queued = std::max<int>(4, (_this->samplerate / 4) / _this->blockSize);
+        _this->ingress.init(&_this->stream, [](const int16_t* in, int count, dsp::complex_t* out) {
+            return dsp::convert::S16ToComplex::process(count / 2, in, out);
+        }, _this->blockSize * 2, queued);
+        _this->stream.reserve(_this->blockSize);
+        _this->ingress.setSamplerate(_this->samplerate);
+        _this->ingress.start();
+
         // Start worker thread
         _this->running = true;
         _this->workerThread = std::thread(worker, _this);
@@ -331,11 +371,10 @@ private:
         PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
         if (!_this->running) { return; }
 
-        // Stop worker thread
+        // Stop worker thread, then the conversion once the last buffer was queued
         _this->running = false;
-        _this->stream.stopWriter();
         _this->workerThread.join();
-        _this->stream.clearWriteStop();
+        _this->ingress.stop();
 
         // Close device
         if (_this->ctx != NULL) {
@@ -391,6 +430,28 @@ private:
         }
         if (_this->running) { SmGui::EndDisabled(); }
 
+        if (_this->running) { SmGui::BeginDisabled(); }
+        SmGui::LeftLabel("Kernel Buffers");
+        SmGui::FillWidth();
+        if (SmGui::Combo(CONCAT("##_pluto_kbc_", _this->name), &_this->kbcId, _this->kernelBufferCounts.txt)) {
+            if (!_this->devDesc.empty()) {
+                config.acquire();
+                config.conf["devices"][_this->devDesc]["kernelBuffers"] = _this->kernelBufferCounts.key(_this->kbcId);
+                config.release(true);
+            }
+        }
+
+        SmGui::LeftLabel("Buffer Size");
+        SmGui::FillWidth();
+        if (SmGui::Combo(CONCAT("##_pluto_bs_", _this->name), &_this->bsId, _this->bufferSizes.txt)) {
+            if (!_this->devDesc.empty()) {
+                config.acquire();
+                config.conf["devices"][_this->devDesc]["bufferSize"] = _this->bufferSizes.key(_this->bsId);
+                config.release(true);
+            }
+        }
+        if (_this->running) { SmGui::EndDisabled(); }
+
         SmGui::LeftLabel("Bandwidth");
         SmGui::FillWidth();
         if (SmGui::Combo(CONCAT("##_pluto_bw_", _this->name), &_this->bwId, _this->bandwidths.txt)) {
@@ -446,7 +507,7 @@ private:
 
     static void worker(void* ctx) {
         PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
-        int blockSize = _this->samplerate / 200.0f;
+        int blockSize = _this->blockSize;
 
         // Acquire channels
         iio_channel* rx0_i = iio_device_find_channel(_this->dev, "voltage0", 0);
@@ -460,6 +521,12 @@ private:
         iio_channel_enable(rx0_i);
         iio_channel_enable(rx0_q);
 
+        // More kernel buffers let the device keep streaming while the host is late
+        int err = iio_device_set_kernel_buffers_count(_this->dev, _this->kernelBufferCounts.value(_this->kbcId));
+        if (err < 0) {
+            flog::warn("Could not set the kernel buffer count ({})", err);
+        }
+
         // Allocate buffer
         iio_buffer* rxbuf = iio_device_create_buffer(_this->dev, blockSize, false);
         if (!rxbuf) {
@@ -468,19 +535,27 @@ private:
         }
 
         // Receive loop
-        while (true) {
-            // Read samples
-            iio_buffer_refill(rxbuf);
+        while (_this->running) {
+            // Read samples, a failed refill leaves a gap in the samples
+            ssize_t ret = iio_buffer_refill(rxbuf);
+            if (ret < 0) {
+                _this->stats.discontinuity();
+                if (ret == -ETIMEDOUT) { continue; }
+                flog::error("Could not refill the RX buffer ({})", (int)ret);
+                break;
+            }
 
-            // Get buffer pointer
+            // Get buffer pointer, the I/Q pairs are interleaved right from the start of the buffer
             int16_t* buf = (int16_t*)iio_buffer_first(rxbuf, rx0_i);
             if (!buf) { break; }
 
-            // Convert samples to CF32
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, buf, 32768.0f, blockSize * 2);
-
-            // Send out the samples
-            if (!_this->stream.swap(blockSize)) { break; };
+            // Queue the samples for conversion so that the next refill can start right away
+            if (_this->ingress.push(buf, blockSize * 2)) {
+                _this->stats.delivered(blockSize);
+            }
+            else {
+                _this->stats.overflow();
+            }
         }
 
         // Stop streaming
@@ -495,6 +570,9 @@ private:
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
     SourceManager::SourceHandler handler;
+    SourceStats stats;
+    dsp::buffer::SourceIngress<int16_t> ingress;
+    int blockSize = 0;
     std::thread workerThread;
     iio_context* ctx = NULL;
     iio_device* phy = NULL;
@@ -515,11 +593,15 @@ private:
     int srId = 0;
     int bwId = 0;
     int gmId = 0;
+    int kbcId = 0;
+    int bsId = 0;
 
     OptionList<std::string, std::string> devices;
     OptionList<int, double> samplerates;
     OptionList<int, double> bandwidths;
     OptionList<std::string, std::string> gainModes;
+    OptionList<int, int> kernelBufferCounts;
+    OptionList<int, int> bufferSizes;
 };
 
 MOD_EXPORT void _INIT_() {
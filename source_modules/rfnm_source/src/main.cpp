@@ -7,6 +7,7 @@
 #include <core.h>
 #include <utils/optionlist.h>
 #include <atomic>
+#include <dsp/convert/s16_to_complex.h>
 
 SDRPP_MOD_INFO{
     /* Name:            */ "rfnm_source",
@@ -446,7 +447,7 @@ private:
             else if (fail) { break; }
 
             // Convert buffer to CF32
-            volk_16i_s32f_convert_32f((float*)&stream.writeBuf[(count++)*sampCount], (int16_t*)lrxbuf->buf, 32768.0f, sampCount * 2);
+            dsp::convert::S16ToComplex::process(sampCount, (int16_t*)lrxbuf->buf, &stream.writeBuf[(count++)*sampCount]);
 
             // Reque buffer
             openDev->rx_qbuf(lrxbuf);
@@ -2,6 +2,7 @@
 #include <volk/volk.h>
 #include <cstring>
 #include <utils/flog.h>
+#include <dsp/convert/s16_to_complex.h>
 
 using namespace std::chrono_literals;
 
@@ -211,46 +212,63 @@ namespace rfspace {
     }
 
     void Client::udpWorker() {
-        // Allocate receive buffer
-        uint8_t* buffer = new uint8_t[RFSPACE_MAX_SIZE];
-        uint16_t* header = (uint16_t*)&buffer[0];
+        // Datagrams are received in batches and put back in order. The sequence numbers of the data items go from 1 to
+        // 65535, 0 only being used by the first one after the stream was started
+        net::DatagramBatch batch(RFSPACE_UDP_BATCH, RFSPACE_MAX_SIZE);
+        net::JitterBuffer jitter(RFSPACE_JITTER_DEPTH, RFSPACE_MAX_SIZE, 65535);
+        bool running = true;
+        auto handler = [&](const uint8_t* data, int size, uint64_t missing) {
+            // Acquire the buffer variables
+            std::lock_guard<std::mutex> lck(bufferMtx);
+
+            // Convert samples to complex float
+            int16_t* samples = (int16_t*)&data[4];
+            int sampCount = (size - 4) / (2 * sizeof(int16_t));
+            dsp::convert::S16ToComplex::process(sampCount, samples, &output->writeBuf[inBuffer]);
+            inBuffer += sampCount;
+
+            // Send out samples if enough are buffered
+            if (inBuffer >= blockSize) {
+                if (!output->swap(inBuffer)) { running = false; };
+                inBuffer = 0;
+            }
+        };
 
         // Receive loop
-        while (true) {
-            // Receive datagram
-            int rsize = udp->recv(buffer, RFSPACE_MAX_SIZE);
-            if (rsize <= 0) { break; } 
-
-            // Decode header
-            uint8_t type = (*header) >> 13;
-            uint16_t size = (*header) & 0b1111111111111;
-
-            if (rsize != size) {
-                flog::error("Datagram size mismatch: {} vs {}", rsize, size);
-                continue;
-            }
+        while (running) {
+            int count = udp->recvBatch(batch);
+            if (count <= 0) { break; }
+
+            for (int i = 0; i < count && running; i++) {
+                uint8_t* buffer = batch.data(i);
+                int rsize = batch.size(i);
+                if (rsize < 4) { continue; }
+
+                // Decode header
+                uint16_t header = *(uint16_t*)&buffer[0];
+                uint8_t type = header >> 13;
+                uint16_t size = header & 0b1111111111111;
+
+                if (rsize != size) {
+                    flog::error("Datagram size mismatch: {} vs {}", rsize, size);
+                    continue;
+                }
 
-            // Check for a sample packet
-            if (type == RFSPACE_MSG_TYPE_T2H_DATA_ITEM_0) {
-                // Acquire the buffer variables
-                std::lock_guard<std::mutex> lck(bufferMtx);
-
-                // Convert samples to complex float
-                int16_t* samples = (int16_t*)&buffer[4];
-                int sampCount = (size - 4) / (2 * sizeof(int16_t));
-                volk_16i_s32f_convert_32f((float*)&output->writeBuf[inBuffer], samples, 32768.0f, sampCount * 2);
-                inBuffer += sampCount;
-
-                // Send out samples if enough are buffered
-                if (inBuffer >= blockSize) {
-                    if (!output->swap(inBuffer)) { break; };
-                    inBuffer = 0;
+                // Check for a sample packet
+                if (type != RFSPACE_MSG_TYPE_T2H_DATA_ITEM_0) { continue; }
+                uint16_t seq = *(uint16_t*)&buffer[2];
+                if (!seq) {
+                    jitter.flush(handler);
+                    jitter.reset();
                 }
+                jitter.push((seq + 65534) % 65535, buffer, size, handler);
             }
         }
 
-        // Free receive buffer
-        delete[] buffer;
+        auto stats = jitter.getStats();
+        if (stats.lost || stats.reordered) {
+            flog::info("RFspace: {} datagrams lost, {} reordered", stats.lost, stats.reordered);
+        }
     }
 
     void Client::heartBeatWorker() {
@@ -268,6 +286,9 @@ namespace rfspace {
     std::shared_ptr<Client> connect(std::string host, uint16_t port, dsp::stream<dsp::complex_t>* out) {
         auto tcp = net::connect(host, port);
         auto udp = net::openudp(host, port, "0.0.0.0", port);
+        if (!udp->setRecvBufferSize(NET_UDP_STREAM_BUFFER_SIZE)) {
+            flog::warn("Could not enlarge the receive buffer of the UDP socket");
+        }
         return std::make_shared<Client>(tcp, udp, out);
     }
 }
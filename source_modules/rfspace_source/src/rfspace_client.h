@@ -1,5 +1,6 @@
 #pragma once
 #include <utils/net.h>
+#include <utils/jitter_buffer.h>
 #include <dsp/stream.h>
 #include <dsp/types.h>
 #include <thread>
@@ -11,6 +12,10 @@
 #define RFSPACE_HEARTBEAT_INTERVAL_MS   1000
 #define RFSPACE_TIMEOUT_MS              3000
 
+// Datagrams taken per receive call, and held back at most to put them in order
+#define RFSPACE_UDP_BATCH               32
+#define RFSPACE_JITTER_DEPTH            16
+
 namespace rfspace {
     enum H2TMessageType {
         RFSPACE_MSG_TYPE_H2T_SET_CTRL_ITEM,
@@ -7,6 +7,8 @@
 #include <config.h>
 #include <gui/smgui.h>
 #include <rtl-sdr.h>
+#include <dsp/convert/u8_to_complex.h>
+#include <dsp/buffer/source_ingress.h>
 
 #ifdef __ANDROID__
 #include <android_backend.h>
@@ -71,6 +73,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.stats = &stats;
 
         strcpy(dbTxt, "--");
 
@@ -323,6 +326,13 @@ private:
 
         _this->asyncCount = (int)roundf(_this->sampleRate / (200 * 512)) * 512;
 
+        // The USB callback only queues the transfers, they are converted on the ingress thread
+        _this->ingress.init(&_this->stream, [](const uint8_t* in, int count, dsp::complex_t* out) {
+            return dsp::convert::U8ToComplex::process(count / 2, in, out, 127.4f);
+        }, std::max<int>(_this->asyncCount, 512));
+        _this->ingress.setSamplerate(_this->sampleRate);
+        _this->ingress.start();
+
         _this->workerThread = std::thread(&RTLSDRSourceModule::worker, _this);
 
         _this->running = true;
@@ -333,10 +343,9 @@ private:
         RTLSDRSourceModule* _this = (RTLSDRSourceModule*)ctx;
         if (!_this->running) { return; }
         _this->running = false;
-        _this->stream.stopWriter();
         rtlsdr_cancel_async(_this->openDev);
         if (_this->workerThread.joinable()) { _this->workerThread.join(); }
-        _this->stream.clearWriteStop();
+        _this->ingress.stop();
         rtlsdr_close(_this->openDev);
         flog::info("RTLSDRSourceModule '{0}': Stop!", _this->name);
     }
@@ -530,12 +539,12 @@ private:
 
     static void asyncHandler(unsigned char* buf, uint32_t len, void* ctx) {
         RTLSDRSourceModule* _this = (RTLSDRSourceModule*)ctx;
-        int sampCount = len / 2;
-        for (int i = 0; i < sampCount; i++) {
-            _this->stream.writeBuf[i].re = ((float)buf[i * 2] - 127.4) / 128.0f;
-            _this->stream.writeBuf[i].im = ((float)buf[(i * 2) + 1] - 127.4) / 128.0f;
+        if (_this->ingress.push(buf, len)) {
+            _this->stats.delivered(len / 2);
+        }
+        else {
+            _this->stats.overflow();
         }
-        if (!_this->stream.swap(sampCount)) { return; }
     }
 
     void updateGainTxt() {
@@ -555,6 +564,8 @@ private:
     int srId = 0;
     int devCount = 0;
     std::thread workerThread;
+    dsp::buffer::SourceIngress<uint8_t> ingress;
+    SourceStats stats;
     bool serverMode = false;
 
 #ifdef __ANDROID__
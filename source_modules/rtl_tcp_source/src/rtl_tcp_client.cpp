@@ -1,9 +1,11 @@
 #include "rtl_tcp_client.h"
+#include <algorithm>
 
 namespace rtltcp {
     Client::Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* stream) {
         this->sock = sock;
         this->stream = stream;
+        sock->setRecvBufferSize(RTL_TCP_RECV_BUFFER_SIZE);
 
         // Start worker
         workerThread = std::thread(&Client::worker, this);
@@ -73,22 +75,32 @@ namespace rtltcp {
     }
 
     void Client::worker() {
-        uint8_t* buffer = dsp::buffer::alloc<uint8_t>(STREAM_BUFFER_SIZE*2);
+        // Read whatever is available in one go and split it into blocks afterwards, instead of requesting exactly one block
+        int capacity = STREAM_BUFFER_SIZE * 2;
+        uint8_t* buffer = dsp::buffer::alloc<uint8_t>(capacity);
+        int filled = 0;
 
         while (true) {
             // Read data
-            int count = sock->recv(buffer, bufferSize * 2, true);
+            int count = sock->recv(&buffer[filled], capacity - filled);
             if (count <= 0) { break; }
-
-            // Convert to complex float
-            int scount = count/2;
-            for (int i = 0; i < scount; i++) {
-                stream->writeBuf[i].re = ((double)buffer[i * 2] - 128.0) / 128.0;
-                stream->writeBuf[i].im = ((double)buffer[(i * 2) + 1] - 128.0) / 128.0;
+            filled += count;
+
+            // Convert and send all complete blocks
+            int blockSize = std::clamp<int>(bufferSize, 1, STREAM_BUFFER_SIZE / 2) * 2;
+            int used = 0;
+            while (filled - used >= blockSize) {
+                int scount = dsp::convert::U8ToComplex::process(blockSize / 2, &buffer[used], stream->writeBuf, 128.0f);
+                if (!stream->swap(scount)) {
+                    dsp::buffer::free(buffer);
+                    return;
+                }
+                used += blockSize;
             }
 
-            // Swap buffer
-            if (!stream->swap(scount)) { break; }
+            // Keep whatever is left for the next block
+            filled -= used;
+            if (filled && used) { memmove(buffer, &buffer[used], filled); }
         }
 
         dsp::buffer::free(buffer);
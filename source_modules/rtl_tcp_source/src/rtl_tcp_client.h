@@ -2,7 +2,12 @@
 #include <utils/net.h>
 #include <dsp/stream.h>
 #include <dsp/types.h>
+#include <dsp/convert/u8_to_complex.h>
 #include <thread>
+#include <atomic>
+
+// Size of the socket receive buffer, enough to ride out a few hundred milliseconds of network hiccups at 3.2MS/s
+#define RTL_TCP_RECV_BUFFER_SIZE    (4 * 1024 * 1024)
 
 namespace rtltcp {
 #pragma pack(push, 1)
@@ -38,7 +43,7 @@ namespace rtltcp {
         std::shared_ptr<net::Socket> sock;
         std::thread workerThread;
         dsp::stream<dsp::complex_t>* stream;
-        int bufferSize = 2400000 / 200;
+        std::atomic<int> bufferSize = 2400000 / 200;
     };
 
     std::shared_ptr<Client> connect(dsp::stream<dsp::complex_t>* stream, std::string host, int port = 1234);
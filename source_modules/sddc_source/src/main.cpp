@@ -5,6 +5,7 @@
 #include <signal_path/signal_path.h>
 #include <core.h>
 #include <utils/optionlist.h>
+#include <dsp/channel/real_ddc.h>
 #include <atomic>
 #include <sddc.h>
 
@@ -32,7 +33,7 @@ public:
         sampleRate = 128e6;
 
         // Initialize the DDC
-        ddc.init(&ddcIn, 50e6, 50e6, 50e6, 0.0);
+        ddc.init(&ddcIn, 128e6, 0.0);
 
         handler.ctx = this;
         handler.selectHandler = menuSelected;
@@ -247,9 +248,8 @@ private:
         //     _this->ddc.start();
         // }
         // else {
-            // Configure and start the DDC
+            // Configure and start the DDC, it always decimates by two
             _this->ddc.setInSamplerate(_this->sampleRate * 2);
-            _this->ddc.setOutSamplerate(_this->sampleRate, _this->sampleRate);
             _this->ddc.setOffset(_this->freq);
             _this->ddc.start();
         // }
@@ -433,31 +433,16 @@ private:
         //     }
         // }
         // else if (port == PORT_HF2) {
-            // Allocate the sample buffer
-            int16_t* buffer = dsp::buffer::alloc<int16_t>(bufferSize);
-            float* fbuffer = dsp::buffer::alloc<float>(bufferSize);
-            float* nullBuffer = dsp::buffer::alloc<float>(bufferSize);
-
-            // Clear the null buffer
-            dsp::buffer::clear(nullBuffer, bufferSize);
-
+            // The real samples go to the DDC as they are, it converts them itself
             while (run) {
                 // Read samples
-                int err = sddc_rx(openDev, buffer, bufferSize);
+                ddcIn.reserve(bufferSize);
+                int err = sddc_rx(openDev, ddcIn.writeBuf, bufferSize);
                 if (err) { break; }
 
-                // Convert the samples to float
-                volk_16i_s32f_convert_32f(fbuffer, buffer, 32768.0f, bufferSize);
-
-                // Interleave into a complex value
-                volk_32f_x2_interleave_32fc((lv_32fc_t*)ddcIn.writeBuf, fbuffer, nullBuffer, bufferSize);
-                
                 // Send samples to the DDC
                 if (!ddcIn.swap(bufferSize)) { break; }
             }
-
-            // Free the buffer
-            dsp::buffer::free(buffer);
         // }
     }
 
@@ -485,8 +470,8 @@ private:
     std::thread workerThread;
     std::atomic<bool> run = false;
 
-    dsp::stream<dsp::complex_t> ddcIn;
-    dsp::channel::RxVFO ddc;
+    dsp::stream<int16_t> ddcIn;
+    dsp::channel::RealDDC ddc;
 };
 
 MOD_EXPORT void _INIT_() {
@@ -78,8 +78,14 @@ const char* ifModeTxt =
 
 const char* rspduo_antennaPortsTxt = "Tuner 1 (50Ohm)\0Tuner 1 (Hi-Z)\0Tuner 2 (50Ohm)\0";
 
+// In dual tuner mode, tuner 1 keeps its antenna ports and tuner 2 always uses its own
+const char* rspduo_dualAntennaPortsTxt = "Tuner 1 (50Ohm)\0Tuner 1 (Hi-Z)\0";
+
 #define MAX_DEV_COUNT   16
 
+// Signal path fed by the second tuner of an RSPduo in dual tuner mode
+#define RSPDUO_TUNER2_PATH  "SDRplay Tuner 2"
+
 class SDRPlaySourceModule : public ModuleManager::Instance {
 public:
     SDRPlaySourceModule(std::string name) {
@@ -88,7 +94,7 @@ public:
         // Init callbacks
         cbFuncs.EventCbFn = eventCB;
         cbFuncs.StreamACbFn = streamCB;
-        cbFuncs.StreamBCbFn = streamCB;
+        cbFuncs.StreamBCbFn = streamBCB;
 
         sdrplay_api_ErrT err = sdrplay_api_Open();
         if (err != sdrplay_api_Success) {
@@ -120,6 +126,23 @@ public:
 
         sigpath::sourceManager.registerSource("SDRplay", &handler);
 
+        // The second tuner of an RSPduo feeds its own signal path when it was created
+        tuner2.module = this;
+        tuner2.path = sigpath::getPath(RSPDUO_TUNER2_PATH);
+        if (tuner2.path) {
+            tuner2.handler.ctx = &tuner2;
+            tuner2.handler.selectHandler = tuner2Selected;
+            tuner2.handler.deselectHandler = tuner2Deselected;
+            tuner2.handler.menuHandler = tuner2MenuHandler;
+            tuner2.handler.startHandler = tuner2Start;
+            tuner2.handler.stopHandler = tuner2Stop;
+            tuner2.handler.tuneHandler = tuner2Tune;
+            tuner2.handler.stream = &tuner2.stream;
+            tuner2.path->sourceManager.registerSource(RSPDUO_TUNER2_PATH, &tuner2.handler);
+            tuner2.path->sourceManager.selectSource(RSPDUO_TUNER2_PATH);
+            tuner2.path->iqFrontEnd.setSampleRate(sampleRate);
+        }
+
         initOk = true;
     }
 
@@ -127,6 +150,7 @@ public:
         stop(this);
         if (initOk) { sdrplay_api_Close(); }
         sigpath::sourceManager.unregisterSource("SDRplay");
+        if (tuner2.path) { tuner2.path->sourceManager.unregisterSource(RSPDUO_TUNER2_PATH); }
     }
 
     void postInit() {}
@@ -227,6 +251,7 @@ public:
 
     void selectDev(sdrplay_api_DeviceT dev, int id) {
         openDev = dev;
+        availableDuoModes = dev.rspDuoMode;
         sdrplay_api_ErrT err;
 
         openDev.tuner = sdrplay_api_Tuner_A;
@@ -329,6 +354,10 @@ public:
         rsp2_antennaPort = 0;
         rspdx_antennaPort = 0;
         rspduo_antennaPort = 0;
+        dualTuner = false;
+        tuner2.freq = 100000000;
+        tuner2.lnaGain = lnaSteps - 1;
+        tuner2.gain = 59;
 
         config.acquire();
 
@@ -413,6 +442,18 @@ public:
             if (config.conf["devices"][selectedName].contains("biast")) {
                 rspduo_biasT = config.conf["devices"][selectedName]["biast"];
             }
+            if (config.conf["devices"][selectedName].contains("dualTuner")) {
+                dualTuner = config.conf["devices"][selectedName]["dualTuner"];
+            }
+            if (config.conf["devices"][selectedName].contains("tuner2Freq")) {
+                tuner2.freq = config.conf["devices"][selectedName]["tuner2Freq"];
+            }
+            if (config.conf["devices"][selectedName].contains("tuner2LnaGain")) {
+                tuner2.lnaGain = config.conf["devices"][selectedName]["tuner2LnaGain"];
+            }
+            if (config.conf["devices"][selectedName].contains("tuner2IfGain")) {
+                tuner2.gain = config.conf["devices"][selectedName]["tuner2IfGain"];
+            }
         }
         else if (openDev.hwVer == SDRPLAY_RSPdx_ID || openDev.hwVer == SDRPLAY_RSPdxR2_ID) {
             if (config.conf["devices"][selectedName].contains("antenna")) {
@@ -432,6 +473,14 @@ public:
         config.release();
 
         if (lnaGain >= lnaSteps) { lnaGain = lnaSteps - 1; }
+        if (tuner2.lnaGain >= lnaSteps) { tuner2.lnaGain = lnaSteps - 1; }
+
+        // Dual tuner mode needs a low IF mode, the device then running at 6 or 8MHz
+        if (dualTuner) {
+            if (!isDualIfMode(ifModeId)) { ifModeId = 1; }
+            sampleRate = ifModes[ifModeId].effectiveSamplerate;
+        }
+        updateTuner2Samplerate();
 
         // Release device after selecting
         sdrplay_api_Uninit(openDev.dev);
@@ -450,21 +499,52 @@ public:
         // Change the channel params
         channelParams = (tuner == sdrplay_api_Tuner_A) ? openDevParams->rxChannelA : openDevParams->rxChannelB;
         channelParams->rspDuoTunerParams.tuner1AmPortSel = amPort;
-        sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_RspDuo_AmPortSelect, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_RspDuo_AmPortSelect, sdrplay_api_Update_Ext1_None);
 
         // Refresh gains (for some reason they're lost)
         channelParams->tunerParams.gain.LNAstate = lnaGain;
         channelParams->tunerParams.gain.gRdB = gain;
-        sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
     }
 
     void rspDuoSelectAntennaPort(int port) {
+        // Both tuners are running in dual tuner mode, only the port of tuner 1 can be changed
+        if (dualActive) {
+            channelParams->rspDuoTunerParams.tuner1AmPortSel = (port == 1) ? sdrplay_api_RspDuo_AMPORT_1 : sdrplay_api_RspDuo_AMPORT_2;
+            sdrplay_api_Update(openDev.dev, sdrplay_api_Tuner_A, sdrplay_api_Update_RspDuo_AmPortSelect, sdrplay_api_Update_Ext1_None);
+            return;
+        }
         if (port == 0) { rspDuoSelectTuner(sdrplay_api_Tuner_A, sdrplay_api_RspDuo_AMPORT_2); }
         if (port == 1) { rspDuoSelectTuner(sdrplay_api_Tuner_A, sdrplay_api_RspDuo_AMPORT_1); }
         if (port == 2) { rspDuoSelectTuner(sdrplay_api_Tuner_B, sdrplay_api_RspDuo_AMPORT_1); }
     }
 
+    // Apply an update of the RSPduo options, to both tuners in dual tuner mode
+    void rspDuoUpdate(sdrplay_api_ReasonForUpdateT reason) {
+        sdrplay_api_Update(openDev.dev, mainTuner(), reason, sdrplay_api_Update_Ext1_None);
+        if (!dualActive) { return; }
+        openDevParams->rxChannelB->rspDuoTunerParams = channelParams->rspDuoTunerParams;
+        sdrplay_api_Update(openDev.dev, sdrplay_api_Tuner_B, reason, sdrplay_api_Update_Ext1_None);
+    }
+
+    // Tuner the updates of the first tuner's parameters go to, both tuners being selected in dual tuner mode
+    sdrplay_api_TunerSelectT mainTuner() {
+        return (openDev.tuner == sdrplay_api_Tuner_Both) ? sdrplay_api_Tuner_A : openDev.tuner;
+    }
+
+    static bool isDualIfMode(int id) {
+        return id > 0 && (ifModes[id].deviceSamplerate == 6000000 || ifModes[id].deviceSamplerate == 8000000);
+    }
+
+    bool canDualTuner() {
+        return openDev.hwVer == SDRPLAY_RSPduo_ID && (availableDuoModes & sdrplay_api_RspDuoMode_Dual_Tuner);
+    }
+
+    void updateTuner2Samplerate() {
+        if (tuner2.path) { tuner2.path->iqFrontEnd.setSampleRate(sampleRate); }
+    }
+
 private:
     std::string getBandwdithScaled(double bw) {
         char buf[1024];
@@ -498,8 +578,19 @@ private:
         // First, acquire device
         sdrplay_api_ErrT err;
 
-        _this->openDev.tuner = sdrplay_api_Tuner_A;
-        _this->openDev.rspDuoMode = sdrplay_api_RspDuoMode_Single_Tuner;
+        _this->dualActive = _this->dualTuner && _this->canDualTuner() && isDualIfMode(_this->ifModeId);
+        if (_this->dualTuner && !_this->dualActive) {
+            flog::warn("SDRPlaySourceModule '{0}': Dual tuner mode unavailable, using a single tuner", _this->name);
+        }
+        if (_this->dualActive) {
+            _this->openDev.tuner = sdrplay_api_Tuner_Both;
+            _this->openDev.rspDuoMode = sdrplay_api_RspDuoMode_Dual_Tuner;
+            _this->openDev.rspDuoSampleFreq = ifModes[_this->ifModeId].deviceSamplerate;
+        }
+        else {
+            _this->openDev.tuner = sdrplay_api_Tuner_A;
+            _this->openDev.rspDuoMode = sdrplay_api_RspDuoMode_Single_Tuner;
+        }
         err = sdrplay_api_SelectDevice(&_this->openDev);
         if (err != sdrplay_api_Success) {
             const char* errStr = sdrplay_api_GetErrorString(err);
@@ -531,6 +622,7 @@ private:
 
         // Configure device
         _this->bufferIndex = 0;
+        _this->tuner2.bufferIndex = 0;
         _this->bufferSize = (float)_this->sampleRate / 200.0f;
 
         // RSP1A Options
@@ -538,41 +630,42 @@ private:
             _this->openDevParams->devParams->rsp1aParams.rfNotchEnable = _this->rsp1a_fmmwNotch;
             _this->openDevParams->devParams->rsp1aParams.rfDabNotchEnable = _this->rsp1a_dabNotch;
             _this->channelParams->rsp1aTunerParams.biasTEnable = _this->rsp1a_biasT;
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp1a_RfNotchControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp1a_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp1a_BiasTControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp1a_RfNotchControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp1a_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp1a_BiasTControl, sdrplay_api_Update_Ext1_None);
         }
         else if (_this->openDev.hwVer == SDRPLAY_RSP2_ID) {
             _this->channelParams->rsp2TunerParams.rfNotchEnable = _this->rsp2_fmmwNotch;
             _this->channelParams->rsp2TunerParams.biasTEnable = _this->rsp2_biasT;
             _this->channelParams->rsp2TunerParams.antennaSel = rsp2_antennaPorts[_this->rsp2_antennaPort];
             _this->channelParams->rsp2TunerParams.amPortSel = (_this->rsp2_antennaPort == 2) ? sdrplay_api_Rsp2_AMPORT_1 : sdrplay_api_Rsp2_AMPORT_2;
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp2_RfNotchControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp2_BiasTControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp2_AntennaControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Rsp2_AmPortSelect, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp2_RfNotchControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp2_BiasTControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp2_AntennaControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Rsp2_AmPortSelect, sdrplay_api_Update_Ext1_None);
         }
         else if (_this->openDev.hwVer == SDRPLAY_RSPduo_ID) {
             // NOTE: mmight require setting it on both RXA and RXB
+            if (_this->dualActive && _this->rspduo_antennaPort > 1) { _this->rspduo_antennaPort = 0; }
             _this->rspDuoSelectAntennaPort(_this->rspduo_antennaPort);
             _this->channelParams->rspDuoTunerParams.biasTEnable = _this->rspduo_biasT;
             _this->channelParams->rspDuoTunerParams.rfNotchEnable = _this->rspduo_fmmwNotch;
             _this->channelParams->rspDuoTunerParams.rfDabNotchEnable = _this->rspduo_dabNotch;
             _this->channelParams->rspDuoTunerParams.tuner1AmNotchEnable = _this->rspduo_fmmwNotch;
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_RspDuo_BiasTControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_RspDuo_RfNotchControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_RspDuo_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_RspDuo_Tuner1AmNotchControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_RspDuo_BiasTControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_RspDuo_RfNotchControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_RspDuo_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_RspDuo_Tuner1AmNotchControl, sdrplay_api_Update_Ext1_None);
         }
         else if (_this->openDev.hwVer == SDRPLAY_RSPdx_ID || _this->openDev.hwVer == SDRPLAY_RSPdxR2_ID) {
             _this->openDevParams->devParams->rspDxParams.rfNotchEnable = _this->rspdx_fmmwNotch;
             _this->openDevParams->devParams->rspDxParams.rfDabNotchEnable = _this->rspdx_dabNotch;
             _this->openDevParams->devParams->rspDxParams.biasTEnable = _this->rspdx_biasT;
             _this->openDevParams->devParams->rspDxParams.antennaSel = rspdx_antennaPorts[_this->rspdx_antennaPort];
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfNotchControl);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfDabNotchControl);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_BiasTControl);
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_AntennaControl);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfNotchControl);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfDabNotchControl);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_BiasTControl);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_AntennaControl);
         }
 
         // General options
@@ -602,15 +695,43 @@ private:
         _this->channelParams->ctrlParams.agc.setPoint_dBfs = _this->agcSetPoint;
         _this->channelParams->ctrlParams.agc.enable = _this->agc ? sdrplay_api_AGC_CTRL_EN : sdrplay_api_AGC_DISABLE;
 
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Dev_Fs, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_BwType, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_IfType, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_LoMode, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Ctrl_Decimation, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Ctrl_DCoffsetIQimbalance, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
-        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
+        // The samplerate is set when selecting the device in dual tuner mode
+        if (!_this->dualActive) {
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Dev_Fs, sdrplay_api_Update_Ext1_None);
+        }
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_BwType, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_IfType, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_LoMode, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Ctrl_Decimation, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Ctrl_DCoffsetIQimbalance, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
+
+        // The second tuner runs with the same settings as the first except for its frequency and gains
+        if (_this->dualActive) {
+            sdrplay_api_RxChannelParamsT* chB = _this->openDevParams->rxChannelB;
+            *chB = *_this->channelParams;
+            chB->tunerParams.rfFreq.rfHz = _this->tuner2.freq;
+            chB->tunerParams.gain.gRdB = _this->tuner2.gain;
+            chB->tunerParams.gain.LNAstate = _this->tuner2.lnaGain;
+            const sdrplay_api_ReasonForUpdateT reasons[] = {
+                sdrplay_api_Update_RspDuo_BiasTControl,
+                sdrplay_api_Update_RspDuo_RfNotchControl,
+                sdrplay_api_Update_RspDuo_RfDabNotchControl,
+                sdrplay_api_Update_Tuner_BwType,
+                sdrplay_api_Update_Tuner_IfType,
+                sdrplay_api_Update_Tuner_LoMode,
+                sdrplay_api_Update_Ctrl_Decimation,
+                sdrplay_api_Update_Ctrl_DCoffsetIQimbalance,
+                sdrplay_api_Update_Tuner_Frf,
+                sdrplay_api_Update_Tuner_Gr,
+                sdrplay_api_Update_Ctrl_Agc
+            };
+            for (auto reason : reasons) {
+                sdrplay_api_Update(_this->openDev.dev, sdrplay_api_Tuner_B, reason, sdrplay_api_Update_Ext1_None);
+            }
+        }
 
         _this->running = true;
         flog::info("SDRPlaySourceModule '{0}': Start!", _this->name);
@@ -621,12 +742,15 @@ private:
         if (!_this->running) { return; }
         _this->running = false;
         _this->stream.stopWriter();
+        _this->tuner2.stream.stopWriter();
 
         // Release device after stopping
         sdrplay_api_Uninit(_this->openDev.dev);
         sdrplay_api_ReleaseDevice(&_this->openDev);
+        _this->dualActive = false;
 
         _this->stream.clearWriteStop();
+        _this->tuner2.stream.clearWriteStop();
         flog::info("SDRPlaySourceModule '{0}': Stop!", _this->name);
     }
 
@@ -634,7 +758,7 @@ private:
         SDRPlaySourceModule* _this = (SDRPlaySourceModule*)ctx;
         if (_this->running) {
             _this->channelParams->tunerParams.rfFreq.rfHz = freq;
-            sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None);
+            sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None);
         }
         _this->freq = freq;
         flog::info("SDRPlaySourceModule '{0}': Tune: {1}!", _this->name, freq);
@@ -682,7 +806,7 @@ private:
                 _this->bandwidth = (_this->bandwidthId == 8) ? preferedBandwidth[_this->srId] : _this->bandwidths[_this->bandwidthId];
                 if (_this->running) {
                     _this->channelParams->tunerParams.bwType = _this->bandwidth;
-                    sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_BwType, sdrplay_api_Update_Ext1_None);
+                    sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_BwType, sdrplay_api_Update_Ext1_None);
                 }
                 config.acquire();
                 config.conf["devices"][_this->selectedName]["bwMode"] = _this->bandwidthId;
@@ -702,6 +826,7 @@ private:
         SmGui::FillWidth();
         SmGui::ForceSync();
         if (SmGui::Combo(CONCAT("##sdrplay_ifmode", _this->name), &_this->ifModeId, ifModeTxt)) {
+            if (_this->dualTuner && !isDualIfMode(_this->ifModeId)) { _this->ifModeId = 1; }
             if (_this->ifModeId != 0) {
                 _this->bandwidth = ifModes[_this->ifModeId].bw;
                 _this->sampleRate = ifModes[_this->ifModeId].effectiveSamplerate;
@@ -732,6 +857,7 @@ private:
                 _this->bandwidth = (_this->bandwidthId == 8) ? preferedBandwidth[_this->srId] : _this->bandwidths[_this->bandwidthId];
             }
             core::setInputSampleRate(_this->sampleRate);
+            _this->updateTuner2Samplerate();
             config.acquire();
             config.conf["devices"][_this->selectedName]["ifModeId"] = _this->ifModeId;
             config.release(true);
@@ -745,7 +871,7 @@ private:
             if (SmGui::SliderInt(CONCAT("##sdrplay_lna_gain", _this->name), &_this->lnaGain, _this->lnaSteps - 1, 0, SmGui::FMT_STR_NONE)) {
                 if (_this->running) {
                     _this->channelParams->tunerParams.gain.LNAstate = _this->lnaGain;
-                    sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+                    sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
                 }
                 config.acquire();
                 config.conf["devices"][_this->selectedName]["lnaGain"] = _this->lnaGain;
@@ -758,7 +884,7 @@ private:
             if (SmGui::SliderInt(CONCAT("##sdrplay_gain", _this->name), &_this->gain, 59, 20, SmGui::FMT_STR_NONE)) {
                 if (_this->running) {
                     _this->channelParams->tunerParams.gain.gRdB = _this->gain;
-                    sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+                    sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
                 }
                 config.acquire();
                 config.conf["devices"][_this->selectedName]["ifGain"] = _this->gain;
@@ -784,7 +910,7 @@ private:
                         _this->channelParams->ctrlParams.agc.decay_delay_ms = _this->agcDecayDelay;
                         _this->channelParams->ctrlParams.agc.decay_threshold_dB = _this->agcDecayThreshold;
                         _this->channelParams->ctrlParams.agc.setPoint_dBfs = _this->agcSetPoint;
-                        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
+                        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
                     }
                     config.acquire();
                     config.conf["devices"][_this->selectedName]["agcAttack"] = _this->agcAttack;
@@ -806,12 +932,12 @@ private:
                         _this->channelParams->ctrlParams.agc.decay_delay_ms = _this->agcDecayDelay;
                         _this->channelParams->ctrlParams.agc.decay_threshold_dB = _this->agcDecayThreshold;
                         _this->channelParams->ctrlParams.agc.setPoint_dBfs = _this->agcSetPoint;
-                        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
+                        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
                     }
                     else {
-                        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
+                        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Ctrl_Agc, sdrplay_api_Update_Ext1_None);
                         _this->channelParams->tunerParams.gain.gRdB = _this->gain;
-                        sdrplay_api_Update(_this->openDev.dev, _this->openDev.tuner, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+                        sdrplay_api_Update(_this->openDev.dev, _this->mainTuner(), sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
                     }
                 }
                 config.acquire();
@@ -931,7 +1057,7 @@ private:
         if (SmGui::Checkbox(CONCAT("FM/MW Notch##sdrplay_rsp1a_fmmwnotch", name), &rsp1a_fmmwNotch)) {
             if (running) {
                 openDevParams->devParams->rsp1aParams.rfNotchEnable = rsp1a_fmmwNotch;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp1a_RfNotchControl, sdrplay_api_Update_Ext1_None);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp1a_RfNotchControl, sdrplay_api_Update_Ext1_None);
             }
             config.acquire();
             config.conf["devices"][selectedName]["fmmwNotch"] = rsp1a_fmmwNotch;
@@ -940,7 +1066,7 @@ private:
         if (SmGui::Checkbox(CONCAT("DAB Notch##sdrplay_rsp1a_dabnotch", name), &rsp1a_dabNotch)) {
             if (running) {
                 openDevParams->devParams->rsp1aParams.rfDabNotchEnable = rsp1a_dabNotch;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp1a_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp1a_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
             }
             config.acquire();
             config.conf["devices"][selectedName]["dabNotch"] = rsp1a_dabNotch;
@@ -949,7 +1075,7 @@ private:
         if (SmGui::Checkbox(CONCAT("Bias-T##sdrplay_rsp1a_biast", name), &rsp1a_biasT)) {
             if (running) {
                 channelParams->rsp1aTunerParams.biasTEnable = rsp1a_biasT;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp1a_BiasTControl, sdrplay_api_Update_Ext1_None);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp1a_BiasTControl, sdrplay_api_Update_Ext1_None);
             }
             config.acquire();
             config.conf["devices"][selectedName]["biast"] = rsp1a_biasT;
@@ -965,8 +1091,8 @@ private:
             if (running) {
                 channelParams->rsp2TunerParams.antennaSel = rsp2_antennaPorts[rsp2_antennaPort];
                 channelParams->rsp2TunerParams.amPortSel = (rsp2_antennaPort == 2) ? sdrplay_api_Rsp2_AMPORT_1 : sdrplay_api_Rsp2_AMPORT_2;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp2_AntennaControl, sdrplay_api_Update_Ext1_None);
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp2_AmPortSelect, sdrplay_api_Update_Ext1_None);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp2_AntennaControl, sdrplay_api_Update_Ext1_None);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp2_AmPortSelect, sdrplay_api_Update_Ext1_None);
             }
             config.acquire();
             config.conf["devices"][selectedName]["antenna"] = rsp2_antennaPort;
@@ -978,7 +1104,7 @@ private:
             if (SmGui::Checkbox(CONCAT("MW/FM Notch##sdrplay_rsp2_fmmwnotch", name), &rsp2_fmmwNotch)) {
                 if (running) {
                     channelParams->rsp2TunerParams.rfNotchEnable = rsp2_fmmwNotch;
-                    sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp2_RfNotchControl, sdrplay_api_Update_Ext1_None);
+                    sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp2_RfNotchControl, sdrplay_api_Update_Ext1_None);
                 }
                 config.acquire();
                 config.conf["devices"][selectedName]["fmmwNotch"] = rsp2_fmmwNotch;
@@ -995,7 +1121,7 @@ private:
         if (SmGui::Checkbox(CONCAT("Bias-T##sdrplay_rsp2_biast", name), &rsp2_biasT)) {
             if (running) {
                 channelParams->rsp2TunerParams.biasTEnable = rsp2_biasT;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_Rsp2_BiasTControl, sdrplay_api_Update_Ext1_None);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_Rsp2_BiasTControl, sdrplay_api_Update_Ext1_None);
             }
             config.acquire();
             config.conf["devices"][selectedName]["biast"] = rsp2_biasT;
@@ -1004,9 +1130,30 @@ private:
     }
 
     void RSPduoMenu() {
+        if (canDualTuner()) {
+            if (running) { SmGui::BeginDisabled(); }
+            SmGui::ForceSync();
+            if (SmGui::Checkbox(CONCAT("Dual Tuner##sdrplay_rspduo_dual", name), &dualTuner)) {
+                // Dual tuner mode needs a low IF mode
+                if (dualTuner) {
+                    if (!isDualIfMode(ifModeId)) { ifModeId = 1; }
+                    if (rspduo_antennaPort > 1) { rspduo_antennaPort = 0; }
+                    sampleRate = ifModes[ifModeId].effectiveSamplerate;
+                    core::setInputSampleRate(sampleRate);
+                    updateTuner2Samplerate();
+                }
+                config.acquire();
+                config.conf["devices"][selectedName]["dualTuner"] = dualTuner;
+                config.conf["devices"][selectedName]["ifModeId"] = ifModeId;
+                config.conf["devices"][selectedName]["antenna"] = rspduo_antennaPort;
+                config.release(true);
+            }
+            if (running) { SmGui::EndDisabled(); }
+        }
+
         SmGui::LeftLabel("Antenna");
         SmGui::FillWidth();
-        if (SmGui::Combo(CONCAT("##sdrplay_rspduo_ant", name), &rspduo_antennaPort, rspduo_antennaPortsTxt)) {
+        if (SmGui::Combo(CONCAT("##sdrplay_rspduo_ant", name), &rspduo_antennaPort, dualTuner ? rspduo_dualAntennaPortsTxt : rspduo_antennaPortsTxt)) {
             if (running) {
                 rspDuoSelectAntennaPort(rspduo_antennaPort);
             }
@@ -1018,8 +1165,8 @@ private:
             if (running) {
                 channelParams->rspDuoTunerParams.rfNotchEnable = rspduo_fmmwNotch;
                 channelParams->rspDuoTunerParams.tuner1AmNotchEnable = rspduo_fmmwNotch;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_RspDuo_RfNotchControl, sdrplay_api_Update_Ext1_None);
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_RspDuo_Tuner1AmNotchControl, sdrplay_api_Update_Ext1_None);
+                rspDuoUpdate(sdrplay_api_Update_RspDuo_RfNotchControl);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_RspDuo_Tuner1AmNotchControl, sdrplay_api_Update_Ext1_None);
             }
             config.acquire();
             config.conf["devices"][selectedName]["fmmwnotch"] = rspduo_fmmwNotch;
@@ -1028,7 +1175,7 @@ private:
         if (SmGui::Checkbox(CONCAT("DAB Notch##sdrplay_rspduo_dabnotch", name), &rspduo_dabNotch)) {
             if (running) {
                 channelParams->rspDuoTunerParams.rfDabNotchEnable = rspduo_dabNotch;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_RspDuo_RfDabNotchControl, sdrplay_api_Update_Ext1_None);
+                rspDuoUpdate(sdrplay_api_Update_RspDuo_RfDabNotchControl);
             }
             config.acquire();
             config.conf["devices"][selectedName]["dabNotch"] = rspduo_dabNotch;
@@ -1037,12 +1184,55 @@ private:
         if (SmGui::Checkbox(CONCAT("Bias-T##sdrplay_rspduo_biast", name), &rspduo_biasT)) {
             if (running) {
                 channelParams->rspDuoTunerParams.biasTEnable = rspduo_biasT;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_RspDuo_BiasTControl, sdrplay_api_Update_Ext1_None);
+                rspDuoUpdate(sdrplay_api_Update_RspDuo_BiasTControl);
             }
             config.acquire();
             config.conf["devices"][selectedName]["biast"] = rspduo_biasT;
             config.release(true);
         }
+
+        if (dualTuner) { tuner2Menu(); }
+    }
+
+    // Frequency and gains of the second tuner, tuned through its signal path when there's one
+    void tuner2Menu() {
+        SmGui::LeftLabel("Tuner 2");
+        SmGui::FillWidth();
+        if (SmGui::InputInt(CONCAT("##sdrplay_tuner2_freq", name), &tuner2.freq, 1000, 100000)) {
+            tuner2.freq = std::clamp<int>(tuner2.freq, 1000, 2000000000);
+            if (tuner2.path) { tuner2.path->sourceManager.tune(tuner2.freq); }
+            else { tuner2Tune(tuner2.freq, &tuner2); }
+        }
+
+        SmGui::LeftLabel("LNA Gain 2");
+        SmGui::FillWidth();
+        if (SmGui::SliderInt(CONCAT("##sdrplay_tuner2_lna_gain", name), &tuner2.lnaGain, lnaSteps - 1, 0, SmGui::FMT_STR_NONE)) {
+            if (dualActive) {
+                openDevParams->rxChannelB->tunerParams.gain.LNAstate = tuner2.lnaGain;
+                sdrplay_api_Update(openDev.dev, sdrplay_api_Tuner_B, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+            }
+            config.acquire();
+            config.conf["devices"][selectedName]["tuner2LnaGain"] = tuner2.lnaGain;
+            config.release(true);
+        }
+
+        if (agc) { SmGui::BeginDisabled(); }
+        SmGui::LeftLabel("IF Gain 2");
+        SmGui::FillWidth();
+        if (SmGui::SliderInt(CONCAT("##sdrplay_tuner2_gain", name), &tuner2.gain, 59, 20, SmGui::FMT_STR_NONE)) {
+            if (dualActive) {
+                openDevParams->rxChannelB->tunerParams.gain.gRdB = tuner2.gain;
+                sdrplay_api_Update(openDev.dev, sdrplay_api_Tuner_B, sdrplay_api_Update_Tuner_Gr, sdrplay_api_Update_Ext1_None);
+            }
+            config.acquire();
+            config.conf["devices"][selectedName]["tuner2IfGain"] = tuner2.gain;
+            config.release(true);
+        }
+        if (agc) { SmGui::EndDisabled(); }
+
+        if (!tuner2.path) {
+            SmGui::Text("Not streamed, no signal path named " RSPDUO_TUNER2_PATH);
+        }
     }
 
     void RSPdxMenu() {
@@ -1051,7 +1241,7 @@ private:
         if (SmGui::Combo(CONCAT("##sdrplay_rspdx_ant", name), &rspdx_antennaPort, rspdx_antennaPortsTxt)) {
             if (running) {
                 openDevParams->devParams->rspDxParams.antennaSel = rspdx_antennaPorts[rspdx_antennaPort];
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_AntennaControl);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_AntennaControl);
             }
             config.acquire();
             config.conf["devices"][selectedName]["antenna"] = rspdx_antennaPort;
@@ -1061,7 +1251,7 @@ private:
         if (SmGui::Checkbox(CONCAT("FM/MW Notch##sdrplay_rspdx_fmmwnotch", name), &rspdx_fmmwNotch)) {
             if (running) {
                 openDevParams->devParams->rspDxParams.rfNotchEnable = rspdx_fmmwNotch;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfNotchControl);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfNotchControl);
             }
             config.acquire();
             config.conf["devices"][selectedName]["fmmwNotch"] = rspdx_fmmwNotch;
@@ -1070,7 +1260,7 @@ private:
         if (SmGui::Checkbox(CONCAT("DAB Notch##sdrplay_rspdx_dabnotch", name), &rspdx_dabNotch)) {
             if (running) {
                 openDevParams->devParams->rspDxParams.rfDabNotchEnable = rspdx_dabNotch;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfDabNotchControl);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_RfDabNotchControl);
             }
             config.acquire();
             config.conf["devices"][selectedName]["dabNotch"] = rspdx_dabNotch;
@@ -1079,7 +1269,7 @@ private:
         if (SmGui::Checkbox(CONCAT("Bias-T##sdrplay_rspdx_biast", name), &rspdx_biasT)) {
             if (running) {
                 openDevParams->devParams->rspDxParams.biasTEnable = rspdx_biasT;
-                sdrplay_api_Update(openDev.dev, openDev.tuner, sdrplay_api_Update_None, sdrplay_api_Update_RspDx_BiasTControl);
+                sdrplay_api_Update(openDev.dev, mainTuner(), sdrplay_api_Update_None, sdrplay_api_Update_RspDx_BiasTControl);
             }
             config.acquire();
             config.conf["devices"][selectedName]["biast"] = rspdx_biasT;
@@ -1091,20 +1281,70 @@ private:
         SmGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Device currently unsupported");
     }
 
+    void writeSamples(dsp::stream<dsp::complex_t>& out, int& index, short* xi, short* xq, unsigned int numSamples) {
+        // TODO: Optimise using volk and math
+        for (int i = 0; i < numSamples; i++) {
+            int id = index++;
+            out.writeBuf[id].re = (float)xi[i] / 32768.0f;
+            out.writeBuf[id].im = (float)xq[i] / 32768.0f;
+
+            if (index >= bufferSize) {
+                out.swap(bufferSize);
+                index = 0;
+            }
+        }
+    }
+
     static void streamCB(short* xi, short* xq, sdrplay_api_StreamCbParamsT* params,
                          unsigned int numSamples, unsigned int reset, void* cbContext) {
         SDRPlaySourceModule* _this = (SDRPlaySourceModule*)cbContext;
-        // TODO: Optimise using volk and math
         if (!_this->running) { return; }
-        for (int i = 0; i < numSamples; i++) {
-            int id = _this->bufferIndex++;
-            _this->stream.writeBuf[id].re = (float)xi[i] / 32768.0f;
-            _this->stream.writeBuf[id].im = (float)xq[i] / 32768.0f;
+        _this->writeSamples(_this->stream, _this->bufferIndex, xi, xq, numSamples);
+    }
 
-            if (_this->bufferIndex >= _this->bufferSize) {
-                _this->stream.swap(_this->bufferSize);
-                _this->bufferIndex = 0;
-            }
+    // In single tuner mode, tuner 2 of the RSPduo feeds the main stream
+    static void streamBCB(short* xi, short* xq, sdrplay_api_StreamCbParamsT* params,
+                          unsigned int numSamples, unsigned int reset, void* cbContext) {
+        SDRPlaySourceModule* _this = (SDRPlaySourceModule*)cbContext;
+        if (!_this->running) { return; }
+        if (!_this->dualActive) {
+            _this->writeSamples(_this->stream, _this->bufferIndex, xi, xq, numSamples);
+            return;
+        }
+        if (!_this->tuner2.path) { return; }
+        _this->writeSamples(_this->tuner2.stream, _this->tuner2.bufferIndex, xi, xq, numSamples);
+    }
+
+    // Second tuner of the RSPduo. The device is started and stopped with the first tuner, the second only follows it
+    struct SecondTuner {
+        SDRPlaySourceModule* module;
+        SignalPath* path = NULL;
+        dsp::stream<dsp::complex_t> stream;
+        SourceManager::SourceHandler handler;
+        int freq = 100000000;
+        int lnaGain = 9;
+        int gain = 59;
+        int bufferIndex = 0;
+    };
+
+    static void tuner2Selected(void* ctx) {}
+    static void tuner2Deselected(void* ctx) {}
+    static void tuner2MenuHandler(void* ctx) {}
+    static void tuner2Start(void* ctx) {}
+    static void tuner2Stop(void* ctx) {}
+
+    static void tuner2Tune(double freq, void* ctx) {
+        SecondTuner* tuner = (SecondTuner*)ctx;
+        SDRPlaySourceModule* _this = tuner->module;
+        tuner->freq = freq;
+        if (_this->running && _this->dualActive) {
+            _this->openDevParams->rxChannelB->tunerParams.rfFreq.rfHz = freq;
+            sdrplay_api_Update(_this->openDev.dev, sdrplay_api_Tuner_B, sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None);
+        }
+        if (!_this->selectedName.empty()) {
+            config.acquire();
+            config.conf["devices"][_this->selectedName]["tuner2Freq"] = tuner->freq;
+            config.release(true);
         }
     }
 
@@ -1174,6 +1414,11 @@ private:
     bool rspduo_biasT = false;
     int rspduo_antennaPort = 0;
 
+    bool dualTuner = false;
+    bool dualActive = false;
+    int availableDuoModes = 0;
+    SecondTuner tuner2;
+
     // RSPdx Options
     bool rspdx_fmmwNotch = false;
     bool rspdx_dabNotch = false;
@@ -35,7 +35,17 @@ public:
         sampleTypeList.define("Int8", dsp::compression::PCM_TYPE_I8);
         sampleTypeList.define("Int16", dsp::compression::PCM_TYPE_I16);
         sampleTypeList.define("Float32", dsp::compression::PCM_TYPE_F32);
+        sampleTypeList.define("BFP8", dsp::compression::PCM_TYPE_BFP8);
         sampleTypeId = sampleTypeList.valueId(dsp::compression::PCM_TYPE_I16);
+        for (double sr : { 12500.0, 25000.0, 50000.0, 100000.0, 250000.0, 500000.0, 1000000.0 }) {
+            channelRateList.define((int)sr, getBandwdithScaled(sr), sr);
+        }
+        channelRateId = channelRateList.valueId(50000.0);
+        fecList.define(0, "None", 0);
+        fecList.define(4, "1 in 4", 4);
+        fecList.define(8, "1 in 8", 8);
+        fecList.define(16, "1 in 16", 16);
+        fecId = fecList.valueId(8);
 
         handler.ctx = this;
         handler.selectHandler = menuSelected;
@@ -45,6 +55,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.stats = &stats;
 
         // Load config
         config.acquire();
@@ -96,12 +107,18 @@ private:
             core::setInputSampleRate(_this->client->getSampleRate());
         }
         gui::mainWindow.playButtonLocked = !(_this->client && _this->client->isOpen());
+        _this->updateFFT();
         flog::info("SDRPPServerSourceModule '{0}': Menu Select!", _this->name);
     }
 
     static void menuDeselected(void* ctx) {
         SDRPPServerSourceModule* _this = (SDRPPServerSourceModule*)ctx;
         gui::mainWindow.playButtonLocked = false;
+
+        // Give the waterfall back to the local FFT
+        sigpath::iqFrontEnd.setFFTEnabled(true);
+        if (_this->connected() && _this->fftSize) { _this->client->setFFT(0, 0.0); }
+        _this->fftSize = 0;
         flog::info("SDRPPServerSourceModule '{0}': Menu Deselect!", _this->name);
     }
 
@@ -148,6 +165,7 @@ private:
 
         bool connected = _this->connected();
         gui::mainWindow.playButtonLocked = !connected;
+        _this->updateFFT();
 
         ImGui::GenericDialog("##sdrpp_srv_src_err_dialog", _this->serverBusy, GENERIC_DIALOG_BUTTONS_OK, [=](){
             ImGui::TextUnformatted("This server is already in use.");
@@ -199,10 +217,60 @@ private:
                 config.release(true);
             }
 
-            bool dummy = true;
-            style::beginDisabled();
-            ImGui::Checkbox("Full IQ", &dummy);
-            style::endDisabled();
+            if (ImGui::Checkbox("UDP", &_this->udp)) {
+                _this->updateUDP();
+
+                // Save config
+                config.acquire();
+                config.conf["servers"][_this->devConfName]["udp"] = _this->udp;
+                config.release(true);
+            }
+
+            // Parity sent over UDP to recover lost datagrams
+            if (_this->udp) {
+                ImGui::LeftLabel("FEC");
+                ImGui::FillWidth();
+                if (ImGui::Combo("##sdrpp_srv_source_fec", &_this->fecId, _this->fecList.txt)) {
+                    _this->updateUDP();
+
+                    // Save config
+                    config.acquire();
+                    config.conf["servers"][_this->devConfName]["fec"] = _this->fecList.key(_this->fecId);
+                    config.release(true);
+                }
+            }
+
+            if (ImGui::Checkbox("Full IQ", &_this->fullIQ)) {
+                _this->updateVFO();
+
+                // Save config
+                config.acquire();
+                config.conf["servers"][_this->devConfName]["fullIQ"] = _this->fullIQ;
+                config.release(true);
+            }
+
+            // Without the full IQ, the server only sends a channel centered on the tuned frequency
+            if (!_this->fullIQ) {
+                ImGui::LeftLabel("Channel");
+                ImGui::FillWidth();
+                if (ImGui::Combo("##sdrpp_srv_source_chan_rate", &_this->channelRateId, _this->channelRateList.txt)) {
+                    _this->updateVFO();
+
+                    // Save config
+                    config.acquire();
+                    config.conf["servers"][_this->devConfName]["channelRate"] = _this->channelRateList.key(_this->channelRateId);
+                    config.release(true);
+                }
+            }
+
+            if (ImGui::Checkbox("Remote FFT", &_this->remoteFFT)) {
+                _this->updateFFT();
+
+                // Save config
+                config.acquire();
+                config.conf["servers"][_this->devConfName]["remoteFFT"] = _this->remoteFFT;
+                config.release(true);
+            }
 
             // Calculate datarate
             _this->frametimeCounter += ImGui::GetIO().DeltaTime;
@@ -212,9 +280,27 @@ private:
                 _this->client->bytes = 0;
             }
 
+            // Refresh the stats of the remote source once a second
+            _this->statsCounter += ImGui::GetIO().DeltaTime;
+            if (_this->running && _this->statsCounter >= 1.0f) {
+                _this->client->requestStats();
+                _this->statsCounter = 0;
+            }
+
             ImGui::TextUnformatted("Status:");
             ImGui::SameLine();
-            ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Connected (%.3f Mbit/s)", _this->datarate);
+            if (_this->client->isResuming()) {
+                ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Connection lost, resuming...");
+            }
+            else {
+                ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Connected (%.3f Mbit/s)", _this->datarate);
+            }
+            if (_this->udp) {
+                ImGui::Text("UDP packets lost: %llu (%llu fragments recovered)", (unsigned long long)_this->client->udpLost, (unsigned long long)_this->client->udpRecovered);
+            }
+            if (_this->client->haveRemoteStats) {
+                ImGui::Text("Server overflows: %llu, gaps: %llu", (unsigned long long)_this->client->remoteStats.overflows, (unsigned long long)_this->client->remoteStats.discontinuities);
+            }
 
             ImGui::CollapsingHeader("Source [REMOTE]", ImGuiTreeNodeFlags_DefaultOpen);
 
@@ -234,7 +320,9 @@ private:
     void tryConnect() {
         try {
             if (client) { client.reset(); }
+            fftSize = 0;
             client = server::connect(hostname, port, &stream);
+            client->stats = &stats;
             deviceInit();
         }
         catch (const std::exception& e) {
@@ -258,10 +346,56 @@ private:
         if (config.conf["servers"][devConfName].contains("compression")) {
             compression = config.conf["servers"][devConfName]["compression"];
         }
+        fullIQ = true;
+        if (config.conf["servers"][devConfName].contains("fullIQ")) {
+            fullIQ = config.conf["servers"][devConfName]["fullIQ"];
+        }
+        channelRateId = channelRateList.valueId(50000.0);
+        if (config.conf["servers"][devConfName].contains("channelRate")) {
+            int key = config.conf["servers"][devConfName]["channelRate"];
+            if (channelRateList.keyExists(key)) { channelRateId = channelRateList.keyId(key); }
+        }
+
+        udp = false;
+        if (config.conf["servers"][devConfName].contains("udp")) {
+            udp = config.conf["servers"][devConfName]["udp"];
+        }
+        fecId = fecList.valueId(8);
+        if (config.conf["servers"][devConfName].contains("fec")) {
+            int key = config.conf["servers"][devConfName]["fec"];
+            if (fecList.keyExists(key)) { fecId = fecList.keyId(key); }
+        }
+        remoteFFT = false;
+        if (config.conf["servers"][devConfName].contains("remoteFFT")) {
+            remoteFFT = config.conf["servers"][devConfName]["remoteFFT"];
+        }
 
         // Set settings
         client->setSampleType(sampleTypeList[sampleTypeId]);
         client->setCompression(compression);
+        if (!fullIQ) { updateVFO(); }
+        if (udp) { updateUDP(); }
+    }
+
+    void updateUDP() {
+        client->setUDP(udp, fecList[fecId]);
+    }
+
+    // Have the server compute the spectra with the local FFT settings, the local FFT being stopped meanwhile
+    void updateFFT() {
+        bool remote = remoteFFT && connected();
+        sigpath::iqFrontEnd.setFFTEnabled(!remote);
+        int size = remote ? sigpath::iqFrontEnd.getFFTSize() : 0;
+        double rate = sigpath::iqFrontEnd.getFFTRate();
+        if (size == fftSize && (!size || rate == fftRate)) { return; }
+        fftSize = size;
+        fftRate = rate;
+        if (connected()) { client->setFFT(fftSize, fftRate); }
+    }
+
+    void updateVFO() {
+        double samplerate = fullIQ ? 0.0 : channelRateList[channelRateId];
+        client->setVFO(0.0, samplerate, samplerate);
     }
 
     std::string name;
@@ -273,6 +407,7 @@ private:
 
     float datarate = 0;
     float frametimeCounter = 0;
+    float statsCounter = 0;
 
     char hostname[1024];
     int port = 50000;
@@ -280,11 +415,24 @@ private:
 
     dsp::stream<dsp::complex_t> stream;
     SourceManager::SourceHandler handler;
+    SourceStats stats;
 
     OptionList<std::string, dsp::compression::PCMType> sampleTypeList;
     int sampleTypeId;
     bool compression = false;
 
+    OptionList<int, double> channelRateList;
+    int channelRateId;
+    bool fullIQ = true;
+
+    bool udp = false;
+    OptionList<int, int> fecList;
+    int fecId;
+
+    bool remoteFFT = false;
+    int fftSize = 0;
+    double fftRate = 0.0;
+
     std::shared_ptr<server::Client> client;
 };
 
@@ -3,12 +3,15 @@
 #include <cstring>
 #include <utils/flog.h>
 #include <core.h>
+#include <gui/gui.h>
 
 using namespace std::chrono_literals;
 
 namespace server {
-    Client::Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* out) {
+    Client::Client(std::shared_ptr<net::Socket> sock, const std::string& host, uint16_t port, dsp::stream<dsp::complex_t>* out) {
         this->sock = sock;
+        this->host = host;
+        this->port = port;
         output = out;
 
         // Allocate buffers
@@ -66,6 +69,13 @@ namespace server {
     }
 
     void Client::showMenu() {
+        // The last UI sent before the connection dropped may not have made it, so both sides start over after resuming
+        if (uiResyncNeeded && !resuming) {
+            uiResyncNeeded = false;
+            uiResetNeeded = true;
+            getUI();
+        }
+
         std::string diffId = "";
         SmGui::DrawListElem diffValue;
         bool syncRequired = false;
@@ -74,37 +84,98 @@ namespace server {
             dl.draw(diffId, diffValue, syncRequired);
         }
 
+        if (!compactUI) {
+            if (!diffId.empty()) { sendUIAction(diffId, diffValue, syncRequired); }
+            return;
+        }
+
+        // Actions are batched, a widget changing on consecutive frames only keeping its last value. The batch goes out as
+        // soon as an action needs the UI back, when a frame goes by without action or after UI_ACTION_BATCH_MS
+        auto now = std::chrono::steady_clock::now();
         if (!diffId.empty()) {
-            // Save ID
+            if (pendingActions.empty()) { pendingSince = now; }
+            if (!pendingActions.empty() && pendingActions.back().first == diffId) {
+                pendingActions.back().second = diffValue;
+            }
+            else {
+                pendingActions.push_back({ diffId, diffValue });
+            }
+            pendingSync |= syncRequired;
+        }
+        if (pendingActions.empty()) { return; }
+        if (pendingSync || diffId.empty() || now - pendingSince >= std::chrono::milliseconds(UI_ACTION_BATCH_MS)) {
+            flushUIActions();
+        }
+    }
+
+    void Client::flushUIActions() {
+        bool sync = pendingSync;
+        int max = SERVER_MAX_PACKET_SIZE - sizeof(PacketHeader) - sizeof(CommandHeader);
+        int size = 0;
+        s_cmd_data[size++] = sync;
+        for (auto& [id, value] : pendingActions) {
             SmGui::DrawListElem elemId;
             elemId.type = SmGui::DRAW_LIST_ELEM_TYPE_STRING;
-            elemId.str = diffId;
-
-            // Encore packet
-            int size = 0;
-            s_cmd_data[size++] = syncRequired;
-            size += SmGui::DrawList::storeItem(elemId, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
-            size += SmGui::DrawList::storeItem(diffValue, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
-
-            // Send
-            if (syncRequired) {
-                flog::warn("Action requires resync");
-                auto waiter = awaitCommandAck(COMMAND_UI_ACTION);
-                sendCommand(COMMAND_UI_ACTION, size);
-                if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
-                    std::lock_guard lck(dlMtx);
-                    dl.load(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
-                }
-                else {
-                    flog::error("Timeout out after asking for UI");
-                }
-                waiter->handled();
-                flog::warn("Resync done");
+            elemId.str = id;
+            int idSize = actionCodec.encodeItem(elemId, &s_cmd_data[size], max - size);
+            int valueSize = (idSize < 0) ? -1 : actionCodec.encodeItem(value, &s_cmd_data[size + idSize], max - size - idSize);
+            if (valueSize < 0) {
+                // Strings may have been interned without being sent, both sides have to start over
+                flog::error("UI actions do not fit in a packet");
+                pendingActions.clear();
+                pendingSync = false;
+                uiResetNeeded = true;
+                getUI();
+                return;
+            }
+            size += idSize + valueSize;
+        }
+        pendingActions.clear();
+        pendingSync = false;
+
+        if (!sync) {
+            sendCommand(COMMAND_UI_ACTIONS, size);
+            return;
+        }
+        auto waiter = awaitCommandAck(COMMAND_UI_ACTIONS);
+        sendCommand(COMMAND_UI_ACTIONS, size);
+        bool acked = waiter->await(PROTOCOL_TIMEOUT_MS);
+        bool loaded = acked && loadUIDelta();
+        waiter->handled();
+        if (!acked) { flog::error("Timeout out after asking for UI"); }
+        if (acked && !loaded) { getUI(); }
+    }
+
+    void Client::sendUIAction(const std::string& diffId, SmGui::DrawListElem diffValue, bool syncRequired) {
+        // Save ID
+        SmGui::DrawListElem elemId;
+        elemId.type = SmGui::DRAW_LIST_ELEM_TYPE_STRING;
+        elemId.str = diffId;
+
+        // Encore packet
+        int size = 0;
+        s_cmd_data[size++] = syncRequired;
+        size += SmGui::DrawList::storeItem(elemId, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
+        size += SmGui::DrawList::storeItem(diffValue, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
+
+        // Send
+        if (syncRequired) {
+            flog::warn("Action requires resync");
+            auto waiter = awaitCommandAck(COMMAND_UI_ACTION);
+            sendCommand(COMMAND_UI_ACTION, size);
+            if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
+                std::lock_guard lck(dlMtx);
+                dl.load(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
             }
             else {
-                flog::warn("Action does not require resync");
-                sendCommand(COMMAND_UI_ACTION, size);
+                flog::error("Timeout out after asking for UI");
             }
+            waiter->handled();
+            flog::warn("Resync done");
+        }
+        else {
+            flog::warn("Action does not require resync");
+            sendCommand(COMMAND_UI_ACTION, size);
         }
     }
 
@@ -133,6 +204,68 @@ namespace server {
         sendCommand(COMMAND_SET_COMPRESSION, 1);
     }
 
+    void Client::setVFO(double offset, double bandwidth, double samplerate) {
+        if (!isOpen()) { return; }
+        double* args = (double*)s_cmd_data;
+        args[0] = offset;
+        args[1] = bandwidth;
+        args[2] = samplerate;
+        auto waiter = awaitCommandAck(COMMAND_SET_VFO);
+        sendCommand(COMMAND_SET_VFO, 3 * sizeof(double));
+        waiter->await(PROTOCOL_TIMEOUT_MS);
+        waiter->handled();
+    }
+
+    void Client::setFFT(int size, double rate) {
+        if (!isOpen()) { return; }
+        double* args = (double*)s_cmd_data;
+        args[0] = size;
+        args[1] = rate;
+        auto waiter = awaitCommandAck(COMMAND_SET_FFT);
+        sendCommand(COMMAND_SET_FFT, 2 * sizeof(double));
+        waiter->await(PROTOCOL_TIMEOUT_MS);
+        waiter->handled();
+    }
+
+    void Client::setUDP(bool enabled, int fecGroup) {
+        if (!isOpen()) { return; }
+        closeUDP();
+
+        // Ask the server to open the UDP transport
+        s_cmd_data[0] = enabled;
+        s_cmd_data[1] = fecGroup;
+        auto waiter = awaitCommandAck(COMMAND_SET_UDP);
+        sendCommand(COMMAND_SET_UDP, 2);
+        if (!waiter->await(PROTOCOL_TIMEOUT_MS)) {
+            waiter->handled();
+            flog::error("Timed out while setting up the UDP transport");
+            return;
+        }
+        if (r_pkt_hdr->size >= sizeof(PacketHeader) + sizeof(CommandHeader) + 6) {
+            udpPort = *(uint16_t*)r_cmd_data;
+            udpToken = *(uint32_t*)&r_cmd_data[2];
+        }
+        waiter->handled();
+        if (!enabled || !udpPort) { return; }
+
+        // Start receiving, the first hello makes the server switch over
+        try {
+            udpSock = net::openudp(host, udpPort, "0.0.0.0", 0);
+            udpSock->setRecvBufferSize(NET_UDP_STREAM_BUFFER_SIZE);
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not open UDP socket: {0}", e.what());
+            return;
+        }
+        udpHavePacket = false;
+        udpThread = std::thread(&Client::udpWorker, this);
+    }
+
+    void Client::requestStats() {
+        if (!isOpen()) { return; }
+        sendCommand(COMMAND_GET_STATS, 0);
+    }
+
     void Client::start() {
         if (!isOpen()) { return; }
         sendCommand(COMMAND_START, 0);
@@ -146,9 +279,15 @@ namespace server {
     }
 
     void Client::close() {
-        // Stop worker
+        closeUDP();
+
+        // Stop worker, which also gives up on resuming the session
+        closing = true;
         decompIn.stopWriter();
-        if (sock) { sock->close(); }
+        {
+            std::lock_guard<std::mutex> lck(sockMtx);
+            if (sock) { sock->close(); }
+        }
         if (workerThread.joinable()) { workerThread.join(); }
         decompIn.clearWriteStop();
 
@@ -158,18 +297,16 @@ namespace server {
     }
 
     bool Client::isOpen() {
-        return sock && sock->isOpen();
+        std::lock_guard<std::mutex> lck(sockMtx);
+        return resuming || (sock && sock->isOpen());
     }
 
     void Client::worker() {
         while (true) {
-            // Receive header
-            if (sock->recv(rbuffer, sizeof(PacketHeader), true) <= 0) {
-                break;
-            }
-
-            // Receive remaining data
-            if (sock->recv(&rbuffer[sizeof(PacketHeader)], r_pkt_hdr->size - sizeof(PacketHeader), true, PROTOCOL_TIMEOUT_MS) <= 0) {
+            // Receive header and remaining data, carrying on with a new connection if it drops
+            if (sock->recv(rbuffer, sizeof(PacketHeader), true) <= 0 || r_pkt_hdr->size < sizeof(PacketHeader) || r_pkt_hdr->size > SERVER_MAX_PACKET_SIZE ||
+                sock->recv(&rbuffer[sizeof(PacketHeader)], r_pkt_hdr->size - sizeof(PacketHeader), true, PROTOCOL_TIMEOUT_MS) <= 0) {
+                if (resume()) { continue; }
                 break;
             }
 
@@ -186,22 +323,19 @@ namespace server {
                 else if (r_cmd_hdr->cmd == COMMAND_DISCONNECT) {
                     flog::error("Asked to disconnect by the server");
                     serverBusy = true;
-
-                    // Cancel waiters
-                    std::vector<PacketWaiter*> toBeRemoved;
-                    for (auto& [waiter, cmd] : commandAckWaiters) {
-                        waiter->cancel();
-                        toBeRemoved.push_back(waiter);
-                    }
-
-                    // Remove handled waiters
-                    for (auto& waiter : toBeRemoved) {
-                        commandAckWaiters.erase(waiter);
-                        delete waiter;
-                    }
+                    cancelWaiters();
+                }
+                else if (r_cmd_hdr->cmd == COMMAND_SET_SESSION && r_pkt_hdr->size == sizeof(PacketHeader) + sizeof(CommandHeader) + sizeof(uint64_t)) {
+                    sessionToken = *(uint64_t*)r_cmd_data;
                 }
             }
             else if (r_pkt_hdr->type == PACKET_TYPE_COMMAND_ACK) {
+                // Stats are requested without waiting for the answer
+                if (r_cmd_hdr->cmd == COMMAND_GET_STATS && r_pkt_hdr->size == sizeof(PacketHeader) + sizeof(CommandHeader) + sizeof(StatsInfo)) {
+                    remoteStats = *(StatsInfo*)r_cmd_data;
+                    haveRemoteStats = true;
+                }
+
                 // Notify waiters
                 std::vector<PacketWaiter*> toBeRemoved;
                 for (auto& [waiter, cmd] : commandAckWaiters) {
@@ -216,18 +350,34 @@ namespace server {
                     delete waiter;
                 }
             }
-            else if (r_pkt_hdr->type == PACKET_TYPE_BASEBAND) {
-                memcpy(decompIn.writeBuf, &rbuffer[sizeof(PacketHeader)], r_pkt_hdr->size - sizeof(PacketHeader));
-                if (!decompIn.swap(r_pkt_hdr->size - sizeof(PacketHeader))) { break; }
+            else if (r_pkt_hdr->type == PACKET_TYPE_BASEBAND || r_pkt_hdr->type == PACKET_TYPE_VFO || r_pkt_hdr->type == PACKET_TYPE_BASEBAND_COMPRESSED) {
+                if (!handleSamples(r_pkt_hdr->type, r_pkt_data, r_pkt_hdr->size - sizeof(PacketHeader))) { break; }
             }
-            else if (r_pkt_hdr->type == PACKET_TYPE_BASEBAND_COMPRESSED) {
-                size_t outCount = ZSTD_decompressDCtx(dctx, decompIn.writeBuf, STREAM_BUFFER_SIZE*sizeof(dsp::complex_t)+8, r_pkt_data, r_pkt_hdr->size - sizeof(PacketHeader));
-                if (outCount) {
-                    if (!decompIn.swap(outCount)) { break; }
-                };
+            else if (r_pkt_hdr->type == PACKET_TYPE_FFT && r_pkt_hdr->size >= sizeof(PacketHeader) + sizeof(FFTHeader)) {
+                FFTHeader* fhdr = (FFTHeader*)r_pkt_data;
+                uint8_t* levels = &r_pkt_data[sizeof(FFTHeader)];
+                int size = r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(FFTHeader);
+                fftLine.resize(size);
+                for (int i = 0; i < size; i++) { fftLine[i] = fhdr->min + ((float)levels[i] * fhdr->step); }
+                gui::waterfall.pushFFT(fftLine.data(), size);
             }
             else if (r_pkt_hdr->type == PACKET_TYPE_ERROR) {
                 flog::error("SDR++ Server Error: {0}", rbuffer[sizeof(PacketHeader)]);
+
+                // Servers predating the compact UI protocol reject it, the waiters are canceled to fall back right away
+                if (rbuffer[sizeof(PacketHeader)] == ERROR_INVALID_COMMAND && compactUI) {
+                    compactUI = false;
+                    std::vector<PacketWaiter*> toBeRemoved;
+                    for (auto& [waiter, cmd] : commandAckWaiters) {
+                        if (cmd != COMMAND_GET_UI_DELTA && cmd != COMMAND_UI_ACTIONS) { continue; }
+                        waiter->cancel();
+                        toBeRemoved.push_back(waiter);
+                    }
+                    for (auto& waiter : toBeRemoved) {
+                        commandAckWaiters.erase(waiter);
+                        delete waiter;
+                    }
+                }
             }
             else {
                 flog::error("Invalid packet type: {0}", r_pkt_hdr->type);
@@ -235,8 +385,277 @@ namespace server {
         }
     }
 
+    bool Client::resume() {
+        if (closing || serverBusy || !sessionToken) { return false; }
+        flog::warn("Connection to the server lost, resuming the session");
+        resuming = true;
+        cancelWaiters();
+        if (stats) { stats->discontinuity(); }
+
+        // The DSP is left as is, it only waits for samples meanwhile. Tries go on with a growing delay until the session
+        // is back, the server doesn't have it anymore or it's too late
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SESSION_RESUME_TIMEOUT_MS);
+        int delay = 100;
+        while (!closing && std::chrono::steady_clock::now() < deadline) {
+            std::shared_ptr<net::Socket> s;
+            try {
+                s = net::connect(net::Address(host, port), SESSION_RESUME_MAX_RETRY_MS);
+            }
+            catch (const std::exception& e) {
+                flog::debug("Could not reconnect to the server: {0}", e.what());
+            }
+            int res = s ? requestResume(s) : -1;
+            if (res > 0) {
+                std::lock_guard<std::mutex> lck(sockMtx);
+                if (closing) {
+                    s->close();
+                    break;
+                }
+                sock = s;
+                uiResyncNeeded = true;
+                resuming = false;
+                flog::info("Session resumed");
+                return true;
+            }
+            if (s) { s->close(); }
+            if (!res) {
+                flog::error("The server does not have the session anymore, reconnect to start a new one");
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            delay = std::min<int>(delay * 2, SESSION_RESUME_MAX_RETRY_MS);
+        }
+        resuming = false;
+        return false;
+    }
+
+    int Client::requestResume(std::shared_ptr<net::Socket> s) {
+        // The send buffer belongs to the other threads, the request is built on its own
+        uint8_t req[sizeof(PacketHeader) + sizeof(CommandHeader) + sizeof(uint64_t)];
+        PacketHeader* hdr = (PacketHeader*)req;
+        hdr->type = PACKET_TYPE_COMMAND;
+        hdr->size = sizeof(req);
+        ((CommandHeader*)&req[sizeof(PacketHeader)])->cmd = COMMAND_RESUME;
+        *(uint64_t*)&req[sizeof(PacketHeader) + sizeof(CommandHeader)] = sessionToken;
+        if (s->send(req, sizeof(req)) != sizeof(req)) { return -1; }
+
+        // Skip what the server sends any new client until the answer, the session sends it all again once resumed
+        while (true) {
+            if (s->recv(rbuffer, sizeof(PacketHeader), true, PROTOCOL_TIMEOUT_MS) <= 0) { return -1; }
+            if (r_pkt_hdr->size < sizeof(PacketHeader) || r_pkt_hdr->size > SERVER_MAX_PACKET_SIZE) { return -1; }
+            if (r_pkt_hdr->size > sizeof(PacketHeader) && s->recv(&rbuffer[sizeof(PacketHeader)], r_pkt_hdr->size - sizeof(PacketHeader), true, PROTOCOL_TIMEOUT_MS) <= 0) { return -1; }
+            if (r_pkt_hdr->type == PACKET_TYPE_COMMAND && r_cmd_hdr->cmd == COMMAND_DISCONNECT) { return -1; }
+            if (r_pkt_hdr->type == PACKET_TYPE_ERROR) { return 0; }
+            if (r_pkt_hdr->type != PACKET_TYPE_COMMAND_ACK || r_cmd_hdr->cmd != COMMAND_RESUME) { continue; }
+            if (r_pkt_hdr->size != sizeof(PacketHeader) + sizeof(CommandHeader) + 1) { return 0; }
+            return r_cmd_data[0] ? 1 : 0;
+        }
+    }
+
+    void Client::cancelWaiters() {
+        std::vector<PacketWaiter*> toBeRemoved;
+        for (auto& [waiter, cmd] : commandAckWaiters) {
+            waiter->cancel();
+            toBeRemoved.push_back(waiter);
+        }
+
+        // Remove handled waiters
+        for (auto& waiter : toBeRemoved) {
+            commandAckWaiters.erase(waiter);
+            delete waiter;
+        }
+    }
+
+    bool Client::handleSamples(uint32_t type, const uint8_t* data, int len) {
+        std::lock_guard<std::mutex> lck(samplesMtx);
+        int count = len;
+        if (type == PACKET_TYPE_BASEBAND_COMPRESSED) {
+            size_t outCount = ZSTD_decompressDCtx(dctx, decompIn.writeBuf, STREAM_BUFFER_SIZE*sizeof(dsp::complex_t)+8, data, len);
+            if (!outCount || ZSTD_isError(outCount)) { return true; }
+            count = outCount;
+        }
+        else {
+            memcpy(decompIn.writeBuf, data, len);
+        }
+        lastSampleCount = dsp::compression::SampleStreamDecompressor::sampleCount(count, decompIn.writeBuf);
+        if (stats) { stats->delivered(lastSampleCount); }
+        return decompIn.swap(count);
+    }
+
+    bool Client::concealSamples(int packets) {
+        // Replace each lost packet by as many zero samples as the last one held, to keep the timing of the stream
+        std::lock_guard<std::mutex> lck(samplesMtx);
+        int count = std::min<int>(lastSampleCount, STREAM_BUFFER_SIZE);
+        if (!count) { return true; }
+        for (int i = 0; i < packets; i++) {
+            *(uint16_t*)&decompIn.writeBuf[0] = 0;
+            *(uint16_t*)&decompIn.writeBuf[2] = dsp::compression::PCM_TYPE_F32;
+            *(float*)&decompIn.writeBuf[4] = 0.0f;
+            memset(&decompIn.writeBuf[8], 0, count * sizeof(dsp::complex_t));
+            if (!decompIn.swap(8 + (count * sizeof(dsp::complex_t)))) { return false; }
+        }
+        return true;
+    }
+
+    void Client::closeUDP() {
+        if (udpSock) { udpSock->close(); }
+        if (udpThread.joinable()) { udpThread.join(); }
+        udpSock.reset();
+    }
+
+    void Client::udpWorker() {
+        net::DatagramBatch batch(SERVER_UDP_BATCH, sizeof(UDPHeader) + SERVER_UDP_MAX_PAYLOAD);
+        auto lastHello = std::chrono::steady_clock::time_point();
+        while (udpSock->isOpen()) {
+            // Keep telling the server where to send
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastHello >= std::chrono::milliseconds(SERVER_UDP_HELLO_INTERVAL)) {
+                UDPHeader hello = {};
+                hello.token = udpToken;
+                hello.flags = UDP_FLAG_HELLO;
+                udpSock->send((uint8_t*)&hello, sizeof(UDPHeader));
+                lastHello = now;
+            }
+
+            // Take all fragments queued at once, their order being restored by the reassembly
+            int count = udpSock->recvBatch(batch, SERVER_UDP_HELLO_INTERVAL);
+            for (int i = 0; i < count; i++) {
+                int len = batch.size(i);
+                if (len < (int)sizeof(UDPHeader)) { continue; }
+                uint8_t* dgram = batch.data(i);
+                udpFragment((UDPHeader*)dgram, &dgram[sizeof(UDPHeader)], len - sizeof(UDPHeader));
+            }
+        }
+    }
+
+    int Client::udpFragmentSize(int index) {
+        return std::min<int>(SERVER_UDP_MAX_PAYLOAD, udpSize - (index * SERVER_UDP_MAX_PAYLOAD));
+    }
+
+    void Client::udpFragment(const UDPHeader* hdr, const uint8_t* data, int len) {
+        if (hdr->token != udpToken || (hdr->flags & UDP_FLAG_HELLO)) { return; }
+        if (hdr->size < sizeof(PacketHeader) || hdr->size > SERVER_MAX_PACKET_SIZE || hdr->fecGroup > SERVER_UDP_MAX_FEC_GROUP) { return; }
+
+        // Move on to a newer packet, the current one and any skipped entirely are lost unless already complete
+        if (!udpHavePacket || (int32_t)(hdr->packet - udpPacket) > 0) {
+            if (udpHavePacket) {
+                int lost = (hdr->packet - udpPacket - 1) + (udpDelivered ? 0 : 1);
+                udpLost += lost;
+                if (stats) { stats->discontinuity(lost); }
+                if (!concealSamples(std::min<int>(lost, UDP_MAX_CONCEALED_PACKETS))) { return; }
+            }
+            udpHavePacket = true;
+            udpDelivered = false;
+            udpPacket = hdr->packet;
+            udpSize = hdr->size;
+            udpFragments = (udpSize + SERVER_UDP_MAX_PAYLOAD - 1) / SERVER_UDP_MAX_PAYLOAD;
+            udpReceived = 0;
+            udpFecGroup = hdr->fecGroup;
+            int groups = udpFecGroup ? ((udpFragments + udpFecGroup - 1) / udpFecGroup) : 0;
+            udpBuf.resize(udpSize);
+            udpHave.assign(udpFragments, false);
+            udpParity.resize(groups * SERVER_UDP_MAX_PAYLOAD);
+            udpHaveParity.assign(groups, false);
+        }
+        else if (hdr->packet != udpPacket || udpDelivered || hdr->size != udpSize) {
+            return;
+        }
+
+        // Store the fragment or the parity of its group
+        int group;
+        if (hdr->flags & UDP_FLAG_PARITY) {
+            if (hdr->index >= udpHaveParity.size() || len != SERVER_UDP_MAX_PAYLOAD) { return; }
+            memcpy(&udpParity[hdr->index * SERVER_UDP_MAX_PAYLOAD], data, len);
+            udpHaveParity[hdr->index] = true;
+            group = hdr->index;
+        }
+        else {
+            if (hdr->index >= udpFragments || udpHave[hdr->index] || len != udpFragmentSize(hdr->index)) { return; }
+            memcpy(&udpBuf[hdr->index * SERVER_UDP_MAX_PAYLOAD], data, len);
+            udpHave[hdr->index] = true;
+            udpReceived++;
+            group = udpFecGroup ? (hdr->index / udpFecGroup) : -1;
+        }
+        if (group >= 0) { udpRecoverGroup(group); }
+
+        // Hand the packet over once complete
+        if (udpReceived < udpFragments) { return; }
+        udpDelivered = true;
+        PacketHeader* phdr = (PacketHeader*)udpBuf.data();
+        if (phdr->size != udpSize) { return; }
+        bytes += udpSize;
+        handleSamples(phdr->type, &udpBuf[sizeof(PacketHeader)], udpSize - sizeof(PacketHeader));
+    }
+
+    void Client::udpRecoverGroup(int group) {
+        // A single missing fragment is the XOR of the parity and the other fragments of its group
+        if (!udpHaveParity[group]) { return; }
+        int first = group * udpFecGroup;
+        int last = std::min<int>(first + udpFecGroup, udpFragments);
+        int missing = -1;
+        for (int i = first; i < last; i++) {
+            if (udpHave[i]) { continue; }
+            if (missing >= 0) { return; }
+            missing = i;
+        }
+        if (missing < 0) { return; }
+
+        int size = udpFragmentSize(missing);
+        uint8_t* out = &udpBuf[missing * SERVER_UDP_MAX_PAYLOAD];
+        memcpy(out, &udpParity[group * SERVER_UDP_MAX_PAYLOAD], size);
+        for (int i = first; i < last; i++) {
+            if (i == missing) { continue; }
+            const uint8_t* frag = &udpBuf[i * SERVER_UDP_MAX_PAYLOAD];
+            int n = std::min<int>(size, udpFragmentSize(i));
+            for (int j = 0; j < n; j++) { out[j] ^= frag[j]; }
+        }
+        udpHave[missing] = true;
+        udpReceived++;
+        udpRecovered++;
+    }
+
+    bool Client::loadUIDelta() {
+        std::lock_guard lck(dlMtx);
+        if (uiCodec.decode(dl, r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader)) < 0) {
+            flog::error("Could not decode the UI sent by the server, asking for all of it");
+            uiResetNeeded = true;
+            return false;
+        }
+        return true;
+    }
+
     int Client::getUI() {
         if (!isOpen()) { return -1; }
+
+        // Both sides start over from an empty list and string table when connecting or after losing track of the UI. The
+        // codecs are reset before sending, so that anything sent afterwards is encoded against the reset state
+        for (int tries = 0; tries < 2 && compactUI; tries++) {
+            bool reset = uiResetNeeded;
+            if (reset) {
+                uiCodec.reset();
+                actionCodec.reset();
+                uiResetNeeded = false;
+            }
+            s_cmd_data[0] = reset;
+            auto waiter = awaitCommandAck(COMMAND_GET_UI_DELTA);
+            sendCommand(COMMAND_GET_UI_DELTA, 1);
+            if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
+                bool loaded = loadUIDelta();
+                waiter->handled();
+                if (loaded) { return 0; }
+                continue;
+            }
+            waiter->handled();
+
+            // Unless the server rejected the command, in which case it's asked for the full list instead
+            if (compactUI || serverBusy) {
+                if (!serverBusy) { flog::error("Timeout out after asking for UI"); };
+                return serverBusy ? CONN_ERR_BUSY : CONN_ERR_TIMEOUT;
+            }
+            flog::info("Server does not support the compact UI protocol");
+        }
+        if (compactUI) { return CONN_ERR_TIMEOUT; }
+
         auto waiter = awaitCommandAck(COMMAND_GET_UI);
         sendCommand(COMMAND_GET_UI, 0);
         if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
@@ -253,9 +672,16 @@ namespace server {
     }
 
     void Client::sendPacket(PacketType type, int len) {
+        // Dropped while resuming, the session keeps the state the server had
+        std::shared_ptr<net::Socket> s;
+        {
+            std::lock_guard<std::mutex> lck(sockMtx);
+            if (resuming) { return; }
+            s = sock;
+        }
         s_pkt_hdr->type = type;
         s_pkt_hdr->size = sizeof(PacketHeader) + len;
-        sock->send(sbuffer, s_pkt_hdr->size);
+        s->send(sbuffer, s_pkt_hdr->size);
     }
 
     void Client::sendCommand(Command cmd, int len) {
@@ -281,6 +707,6 @@ namespace server {
     }
 
     std::shared_ptr<Client> connect(std::string host, uint16_t port, dsp::stream<dsp::complex_t>* out) {
-        return std::make_shared<Client>(net::connect(host, port), out);
+        return std::make_shared<Client>(net::connect(host, port), host, port, out);
     }
 }
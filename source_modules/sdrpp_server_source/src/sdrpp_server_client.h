@@ -13,9 +13,23 @@
 #include <dsp/routing/stream_link.h>
 #include <zstd.h>
 #include <chrono>
+#include <signal_path/source.h>
 
 #define PROTOCOL_TIMEOUT_MS             10000
 
+// Time spent trying to resume the session after the connection dropped, and the longest wait between two tries
+#define SESSION_RESUME_TIMEOUT_MS       20000
+#define SESSION_RESUME_MAX_RETRY_MS     2000
+
+// Longest time UI actions are held to be sent together while a widget keeps changing
+#define UI_ACTION_BATCH_MS              50
+
+// Maximum number of packets lost in a row over UDP that are replaced by silence
+#define UDP_MAX_CONCEALED_PACKETS       16
+
+// Number of datagrams taken per receive call over UDP
+#define SERVER_UDP_BATCH                64
+
 namespace server {
     class PacketWaiter {
     public:
@@ -79,7 +93,7 @@ namespace server {
 
     class Client {
     public:
-        Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* out);
+        Client(std::shared_ptr<net::Socket> sock, const std::string& host, uint16_t port, dsp::stream<dsp::complex_t>* out);
         ~Client();
 
         void showMenu();
@@ -90,19 +104,59 @@ namespace server {
         void setSampleType(dsp::compression::PCMType type);
         void setCompression(bool enabled);
 
+        // Receive only a channel of the baseband of the given samplerate, worked out by the server. 0 for the full baseband
+        void setVFO(double offset, double bandwidth, double samplerate);
+
+        // Have the server compute the spectra of the baseband and push them to the waterfall. A size of 0 to stop
+        void setFFT(int size, double rate);
+
+        // Receive the samples over UDP instead of TCP, with a parity fragment every fecGroup fragments if not 0
+        void setUDP(bool enabled, int fecGroup);
+
+        // Ask the server for the stats of its source, the answer lands in remoteStats
+        void requestStats();
+
         void start();
         void stop();
 
         void close();
         bool isOpen();
 
+        // True while the connection dropped and the session is being resumed, the stream stays up meanwhile
+        bool isResuming() { return resuming; }
+
         int bytes = 0;
         bool serverBusy = false;
 
+        // Sample packets lost over UDP and those rebuilt from parity
+        uint64_t udpLost = 0;
+        uint64_t udpRecovered = 0;
+
+        // Last stats received from the server and whether any were received
+        StatsInfo remoteStats = {};
+        bool haveRemoteStats = false;
+
+        // Where to count the samples received and the gaps of the UDP transport, if not NULL
+        SourceStats* stats = NULL;
+
     private:
         void worker();
+        bool resume();
+        int requestResume(std::shared_ptr<net::Socket> s);
+        void cancelWaiters();
+        bool handleSamples(uint32_t type, const uint8_t* data, int len);
+        bool concealSamples(int packets);
+
+        void closeUDP();
+        void udpWorker();
+        void udpFragment(const UDPHeader* hdr, const uint8_t* data, int len);
+        void udpRecoverGroup(int group);
+        int udpFragmentSize(int index);
 
         int getUI();
+        bool loadUIDelta();
+        void sendUIAction(const std::string& diffId, SmGui::DrawListElem diffValue, bool syncRequired);
+        void flushUIActions();
 
         void sendPacket(PacketType type, int len);
         void sendCommand(Command cmd, int len);
@@ -114,7 +168,15 @@ namespace server {
 
         static void dHandler(dsp::complex_t *data, int count, void *ctx);
 
+        // Replaced by the worker when resuming, under sockMtx
         std::shared_ptr<net::Socket> sock;
+        std::mutex sockMtx;
+
+        // Session given by the server, 0 if it doesn't know about sessions
+        uint64_t sessionToken = 0;
+        std::atomic<bool> resuming = false;
+        std::atomic<bool> closing = false;
+        uint16_t port;
 
         dsp::stream<uint8_t> decompIn;
         dsp::compression::SampleStreamDecompressor decomp;
@@ -137,8 +199,42 @@ namespace server {
         SmGui::DrawList dl;
         std::mutex dlMtx;
 
+        // Compact UI protocol, turned off when the server doesn't know it
+        std::atomic<bool> compactUI = true;
+        bool uiResetNeeded = true;
+        std::atomic<bool> uiResyncNeeded = false;
+        SmGui::DrawListCodec uiCodec;
+        SmGui::DrawListCodec actionCodec;
+        std::vector<std::pair<std::string, SmGui::DrawListElem>> pendingActions;
+        bool pendingSync = false;
+        std::chrono::steady_clock::time_point pendingSince;
+
         ZSTD_DCtx* dctx;
 
+        std::vector<float> fftLine;
+
+        // Shared by the TCP and UDP workers
+        std::mutex samplesMtx;
+        int lastSampleCount = 0;
+
+        // UDP transport, the packet being reassembled is dropped as soon as a fragment of a newer one arrives
+        std::string host;
+        std::shared_ptr<net::Socket> udpSock;
+        std::thread udpThread;
+        uint16_t udpPort = 0;
+        uint32_t udpToken = 0;
+        bool udpHavePacket = false;
+        bool udpDelivered = false;
+        uint32_t udpPacket = 0;
+        uint32_t udpSize = 0;
+        int udpFragments = 0;
+        int udpReceived = 0;
+        int udpFecGroup = 0;
+        std::vector<uint8_t> udpBuf;
+        std::vector<bool> udpHave;
+        std::vector<uint8_t> udpParity;
+        std::vector<bool> udpHaveParity;
+
         std::thread workerThread;
 
         double currentSampleRate = 1000000.0;
@@ -8,9 +8,13 @@
 #include <SoapySDR/Device.hpp>
 #include <SoapySDR/Modules.hpp>
 #include <SoapySDR/Logger.hpp>
+#include <SoapySDR/Formats.hpp>
 #include <core.h>
 #include <gui/style.h>
 #include <gui/smgui.h>
+#include <dsp/convert/s16_to_complex.h>
+#include <dsp/convert/s8_to_complex.h>
+#include <dsp/convert/u8_to_complex.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -49,6 +53,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.stats = &stats;
         sigpath::sourceManager.registerSource("SoapySDR", &handler);
     }
 
@@ -256,6 +261,12 @@ private:
             else {
                 agc = false;
             }
+            if (config.conf["devices"][name].contains("nativeFormat")) {
+                nativeFormat = config.conf["devices"][name]["nativeFormat"];
+            }
+            else {
+                nativeFormat = true;
+            }
             if (config.conf["devices"][name].contains("sampleRate")) {
                 selectSampleRate(config.conf["devices"][name]["sampleRate"]);
             }
@@ -275,6 +286,7 @@ private:
             if (hasAgc) {
                 agc = false;
             }
+            nativeFormat = true;
             selectSampleRate(sampleRates[0]); // Select default
         }
         config.release();
@@ -294,6 +306,7 @@ private:
         if (hasAgc) {
             conf["agc"] = agc;
         }
+        conf["nativeFormat"] = nativeFormat;
         config.acquire();
         config.conf["devices"][devArgs["label"]] = conf;
         config.release(true);
@@ -352,7 +365,24 @@ private:
 
         _this->dev->setFrequency(SOAPY_SDR_RX, _this->channelId, _this->freq);
 
-        _this->devStream = _this->dev->setupStream(SOAPY_SDR_RX, "CF32");
+        // Receive in the native format of the device if it has one we can convert so that the driver doesn't need to.
+        // If the driver also exposes its buffers, the samples are converted straight out of them
+        _this->format = SOAPY_SDR_CF32;
+        _this->fullScale = 1.0;
+        if (_this->nativeFormat) {
+            double fullScale;
+            std::string native = _this->dev->getNativeStreamFormat(SOAPY_SDR_RX, _this->channelId, fullScale);
+            if (native == SOAPY_SDR_CS16 || native == SOAPY_SDR_CS8 || native == SOAPY_SDR_CU8) {
+                _this->format = native;
+                _this->fullScale = fullScale;
+            }
+        }
+        _this->devStream = _this->dev->setupStream(SOAPY_SDR_RX, _this->format);
+        _this->directAccess = (_this->format != SOAPY_SDR_CF32) && (_this->dev->getNumDirectAccessBuffers(_this->devStream) > 0);
+        if (_this->format != SOAPY_SDR_CF32 && !_this->directAccess) {
+            _this->rawBuffer = dsp::buffer::alloc<uint8_t>(STREAM_BUFFER_SIZE * SoapySDR::formatToSize(_this->format));
+        }
+        flog::info("SoapyModule '{0}': Receiving {1}{2}", _this->name, _this->format, _this->directAccess ? " with direct buffer access" : "");
         _this->dev->activateStream(_this->devStream);
         _this->running = true;
         _this->workerThread = std::thread(_worker, _this);
@@ -369,6 +399,10 @@ private:
         _this->workerThread.join();
         _this->stream.clearWriteStop();
         SoapySDR::Device::unmake(_this->dev);
+        if (_this->rawBuffer) {
+            dsp::buffer::free(_this->rawBuffer);
+            _this->rawBuffer = NULL;
+        }
 
         flog::info("SoapyModule '{0}': Stop!", _this->name);
     }
@@ -443,6 +477,12 @@ private:
         // }
         // gainNameLen += 5.0f;
 
+        if (_this->running) { SmGui::BeginDisabled(); }
+        if (SmGui::Checkbox(CONCAT("Native sample format##_native_", _this->name), &_this->nativeFormat)) {
+            _this->saveCurrent();
+        }
+        if (_this->running) { SmGui::EndDisabled(); }
+
         if (_this->hasAgc) {
             if (SmGui::Checkbox((std::string("AGC##_agc_sel_") + _this->name).c_str(), &_this->agc)) {
                 if (_this->running) { _this->dev->setGainMode(SOAPY_SDR_RX, _this->channelId, _this->agc); }
@@ -503,11 +543,44 @@ private:
         long long timeMs = 0;
 
         while (_this->running) {
-            int res = _this->dev->readStream(_this->devStream, (void**)&_this->stream.writeBuf, blockSize, flags, timeMs);
+            int res;
+            if (_this->directAccess) {
+                // Convert straight out of the buffer of the driver
+                size_t handle;
+                const void* buffs[1];
+                res = _this->dev->acquireReadBuffer(_this->devStream, handle, buffs, flags, timeMs);
+                if (res > 0) {
+                    res = std::min<int>(res, STREAM_BUFFER_SIZE);
+                    _this->convert(buffs[0], res, _this->stream.writeBuf);
+                }
+                if (res >= 0) { _this->dev->releaseReadBuffer(_this->devStream, handle); }
+            }
+            else if (_this->format != SOAPY_SDR_CF32) {
+                void* buffs[1] = { _this->rawBuffer };
+                res = _this->dev->readStream(_this->devStream, buffs, blockSize, flags, timeMs);
+                if (res > 0) { _this->convert(_this->rawBuffer, res, _this->stream.writeBuf); }
+            }
+            else {
+                res = _this->dev->readStream(_this->devStream, (void**)&_this->stream.writeBuf, blockSize, flags, timeMs);
+            }
+            if (res == SOAPY_SDR_OVERFLOW) { _this->stats.overflow(); }
             if (res < 1) {
                 continue;
             }
             if (!_this->stream.swap(res)) { return; }
+            _this->stats.delivered(res);
+        }
+    }
+
+    void convert(const void* in, int count, dsp::complex_t* out) {
+        if (format == SOAPY_SDR_CS16) {
+            dsp::convert::S16ToComplex::process(count, (const int16_t*)in, out, fullScale);
+        }
+        else if (format == SOAPY_SDR_CS8) {
+            dsp::convert::S8ToComplex::process(count, (const int8_t*)in, out, fullScale);
+        }
+        else {
+            dsp::convert::U8ToComplex::process(count, (const uint8_t*)in, out);
         }
     }
 
@@ -516,6 +589,7 @@ private:
     dsp::stream<dsp::complex_t> stream;
     SoapySDR::Stream* devStream;
     SourceManager::SourceHandler handler;
+    SourceStats stats;
     SoapySDR::KwargsList devList;
     SoapySDR::Kwargs devArgs;
     SoapySDR::Device* dev;
@@ -528,6 +602,11 @@ private:
     bool running = false;
     bool hasAgc = false;
     bool agc = false;
+    bool nativeFormat = true;
+    std::string format = SOAPY_SDR_CF32;
+    double fullScale = 1.0;
+    bool directAccess = false;
+    uint8_t* rawBuffer = NULL;
     std::vector<double> sampleRates;
     int srId = -1;
     float* uiGains;
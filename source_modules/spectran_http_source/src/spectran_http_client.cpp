@@ -1,6 +1,11 @@
 #include "spectran_http_client.h"
 #include <utils/flog.h>
 #include <inttypes.h>
+#include <string_view>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
 
 SpectranHTTPClient::SpectranHTTPClient(std::string host, int port, dsp::stream<dsp::complex_t>* stream) {
     this->stream = stream;
@@ -9,6 +14,7 @@ SpectranHTTPClient::SpectranHTTPClient(std::string host, int port, dsp::stream<d
     this->host = host;
     this->port = port;
     sock = net::connect(host, port);
+    sock->setRecvBufferSize(SPECTRAN_HTTP_RECV_BUFFER_SIZE);
     http = net::http::Client(sock);
 
     // Send sttream request
@@ -76,45 +82,42 @@ void SpectranHTTPClient::setCenterFrequency(uint64_t freq) {
     }
 }
 
+// Value of a numeric field of the metadata, only looked up by name (yes, this is hacky, but it must be extremely fast)
+static bool findNumber(const std::string_view& json, const char* name, int64_t& value) {
+    auto pos = json.find(name);
+    if (pos == std::string_view::npos) { return false; }
+    pos += strlen(name);
+
+    // The line is followed by its '\n' in the buffer, parsing stops there at the latest
+    char* end;
+    value = strtoll(json.data() + pos, &end, 10);
+    return end != json.data() + pos;
+}
+
 void SpectranHTTPClient::worker() {
+    net::http::ChunkedReader reader(sock, SPECTRAN_HTTP_READ_BUFFER_SIZE);
+    uint8_t* buf = (uint8_t*)stream->writeBuf;
+    const size_t maxLen = STREAM_BUFFER_SIZE * sizeof(dsp::complex_t);
     while (sock->isOpen()) {
-        // Get chunk header
-        net::http::ChunkHeader chdr;
-        int err = http.recvChunkHeader(chdr, 5000);
-        if (err < 0) { return; }
-
-        // If null length, finish
-        size_t clen = chdr.getLength();
-        if (!clen) { return; }
+        // Get chunk header, if null length, finish
+        int64_t clen = reader.nextChunk(5000);
+        if (clen <= 0) { return; }
 
         // Read JSON
-        std::string jsonData;
-        int jlen = sock->recvline(jsonData, clen, 5000);
-        if (jlen <= 0) {
+        const char* json;
+        int jlen = reader.readLine(json, 5000);
+        if (jlen < 0) {
             flog::error("Couldn't read JSON metadata");
             return;
         }
+        std::string_view jsonData(json, jlen);
+
+        // Decode JSON
+        int64_t startFreq = 0, endFreq = 0, sampleFreq = 0;
+        findNumber(jsonData, "\"startFrequency\":", startFreq);
+        findNumber(jsonData, "\"endFrequency\":", endFreq);
+        bool sampleFreqReceived = findNumber(jsonData, "\"sampleFrequency\":", sampleFreq);
 
-        // Decode JSON (yes, this is hacky, but it must be extremely fast)
-        auto startFreqBegin = jsonData.find("\"startFrequency\":");
-        auto startFreqEnd = jsonData.find(',', startFreqBegin);
-        std::string startFreqStr = jsonData.substr(startFreqBegin + 17, startFreqEnd - startFreqBegin - 17);
-        int64_t startFreq = std::stoll(startFreqStr);
-
-        auto endFreqBegin = jsonData.find("\"endFrequency\":");
-        auto endFreqEnd = jsonData.find(',', endFreqBegin);
-        std::string endFreqStr = jsonData.substr(endFreqBegin + 15, endFreqEnd - endFreqBegin - 15);
-        int64_t endFreq = std::stoll(endFreqStr);
-
-        auto sampleFreqBegin = jsonData.find("\"sampleFrequency\":");
-        bool sampleFreqReceived = (sampleFreqBegin != -1);
-        int64_t sampleFreq;
-        if (sampleFreqReceived) {
-            auto sampleFreqEnd = jsonData.find(',', sampleFreqBegin);
-            std::string sampleFreqStr = jsonData.substr(sampleFreqBegin + 18, sampleFreqEnd - sampleFreqBegin - 18);
-            sampleFreq = std::stoll(sampleFreqStr);
-        }
-        
         // Calculate and update center freq
         int64_t samplerate = sampleFreqReceived ? sampleFreq : (endFreq - startFreq);
         int64_t centerFreq = round(((double)endFreq + (double)startFreq) / 2.0);
@@ -131,37 +134,26 @@ void SpectranHTTPClient::worker() {
 
         // Read (and check for) record separator
         uint8_t rs;
-        int rslen = sock->recv(&rs, 1, true, 5000);
-        if (rslen != 1 || rs != 0x1E) {
+        if (reader.read(&rs, 1, 5000) != 1 || rs != 0x1E) {
             flog::error("Missing record separator");
             return;
         }
 
-        // Read data
-        uint8_t* buf = (uint8_t*)stream->writeBuf;
-        int sampLen = 0;
-        for (int i = jlen + 1; i < clen;) {
-            int read = sock->recv(&buf[sampLen], clen - i, true);
-            if (read <= 0) {
+        // Receive the samples straight into the stream, in as many swaps as the chunk needs
+        while (reader.remaining() >= sizeof(dsp::complex_t)) {
+            size_t len = std::min<size_t>(reader.remaining(), maxLen);
+            len -= len % sizeof(dsp::complex_t);
+            if (reader.read(buf, len, 5000) < 0) {
                 flog::error("Recv failed while reading data");
                 return;
             }
-            i += read;
-            sampLen += read;
-        }
-        int sampCount = sampLen / 8;
 
-        // Swap to stream
-        if (streamingEnabled) {
-            if (!stream->swap(sampCount)) { return; }
-        }
-        
-        // Read trailing CRLF
-        std::string dummy;
-        sock->recvline(dummy, 2);
-        if (dummy != "\r") {
-            flog::error("Missing trailing CRLF");
-            return;
+            // Swap to stream
+            if (streamingEnabled) {
+                if (!stream->swap(len / sizeof(dsp::complex_t))) { return; }
+            }
         }
+
+        // The trailing CRLF and a partial sample if any are skipped by starting the next chunk
     }
-}
\ No newline at end of file
+}
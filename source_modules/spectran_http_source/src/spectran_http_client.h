@@ -7,6 +7,12 @@
 #include <utils/new_event.h>
 #include <stdint.h>
 
+// Size of the kernel receive buffer of the stream connection, so that it absorbs the stalls of the DSP
+#define SPECTRAN_HTTP_RECV_BUFFER_SIZE  (8 * 1024 * 1024)
+
+// Size of the buffer the chunk headers and the metadata are parsed from, the samples bypassing it
+#define SPECTRAN_HTTP_READ_BUFFER_SIZE  (256 * 1024)
+
 class SpectranHTTPClient {
 public:
     SpectranHTTPClient(std::string host, int port, dsp::stream<dsp::complex_t>* stream);
@@ -114,6 +114,9 @@ private:
     static void menuDeselected(void* ctx) {
         SpyServerSourceModule* _this = (SpyServerSourceModule*)ctx;
         gui::mainWindow.playButtonLocked = false;
+
+        // Give the waterfall back to the local FFT
+        sigpath::iqFrontEnd.setFFTEnabled(true);
         flog::info("SpyServerSourceModule '{0}': Menu Deselect!", _this->name);
     }
 
@@ -127,16 +130,15 @@ private:
             if (!_this->client) { return; }
         }
 
-        int srvBits = streamFormatsBitCount[_this->iqType];
+        _this->remoteRatio = 1;
+        _this->remoteShift = 0.0;
         _this->client->setSetting(SPYSERVER_SETTING_IQ_FORMAT, streamFormats[_this->iqType]);
-        _this->client->setSetting(SPYSERVER_SETTING_IQ_DECIMATION, _this->srId + _this->client->devInfo.MinimumIQDecimation);
-        _this->client->setSetting(SPYSERVER_SETTING_IQ_FREQUENCY, _this->freq);
-        _this->client->setSetting(SPYSERVER_SETTING_STREAMING_MODE, SPYSERVER_STREAM_MODE_IQ_ONLY);
         _this->client->setSetting(SPYSERVER_SETTING_GAIN, _this->gain);
-        _this->client->setSetting(SPYSERVER_SETTING_IQ_DIGITAL_GAIN, _this->client->computeDigitalGain(srvBits, _this->gain, _this->srId + _this->client->devInfo.MinimumIQDecimation));
+        _this->updateIQ();
+        _this->running = true;
+        _this->updateRemote();
         _this->client->startStream();
 
-        _this->running = true;
         flog::info("SpyServerSourceModule '{0}': Start!", _this->name);
     }
 
@@ -144,18 +146,20 @@ private:
         SpyServerSourceModule* _this = (SpyServerSourceModule*)ctx;
         if (!_this->running) { return; }
 
+        _this->running = false;
+        _this->updateRemote();
         _this->client->stopStream();
 
-        _this->running = false;
         flog::info("SpyServerSourceModule '{0}': Stop!", _this->name);
     }
 
     static void tune(double freq, void* ctx) {
         SpyServerSourceModule* _this = (SpyServerSourceModule*)ctx;
+        _this->freq = freq;
         if (_this->running) {
-            _this->client->setSetting(SPYSERVER_SETTING_IQ_FREQUENCY, freq);
+            _this->client->setSetting(SPYSERVER_SETTING_IQ_FREQUENCY, _this->freq + _this->remoteShift);
+            if (_this->serverFFT) { _this->client->setSetting(SPYSERVER_SETTING_FFT_FREQUENCY, _this->freq); }
         }
-        _this->freq = freq;
         flog::info("SpyServerSourceModule '{0}': Tune: {1}!", _this->name, freq);
     }
 
@@ -208,9 +212,8 @@ private:
             SmGui::LeftLabel("Sample bit depth");
             SmGui::FillWidth();
             if (SmGui::Combo("##spyserver_source_type", &_this->iqType, streamFormatStr)) {
-                int srvBits = streamFormatsBitCount[_this->iqType];
                 _this->client->setSetting(SPYSERVER_SETTING_IQ_FORMAT, streamFormats[_this->iqType]);
-                _this->client->setSetting(SPYSERVER_SETTING_IQ_DIGITAL_GAIN, _this->client->computeDigitalGain(srvBits, _this->gain, _this->srId + _this->client->devInfo.MinimumIQDecimation));
+                _this->updateDigitalGain();
 
                 config.acquire();
                 config.conf["devices"][_this->devRef]["sampleBitDepthId"] = _this->iqType;
@@ -220,18 +223,40 @@ private:
             if (_this->client->devInfo.MaximumGainIndex) {
                 SmGui::FillWidth();
                 if (SmGui::SliderInt("##spyserver_source_gain", (int*)&_this->gain, 0, _this->client->devInfo.MaximumGainIndex)) {
-                    int srvBits = streamFormatsBitCount[_this->iqType];
                     _this->client->setSetting(SPYSERVER_SETTING_GAIN, _this->gain);
-                    _this->client->setSetting(SPYSERVER_SETTING_IQ_DIGITAL_GAIN, _this->client->computeDigitalGain(srvBits, _this->gain, _this->srId + _this->client->devInfo.MinimumIQDecimation));
+                    _this->updateDigitalGain();
                     config.acquire();
                     config.conf["devices"][_this->devRef]["gainId"] = _this->gain;
                     config.release(true);
                 }
             }
 
+            // Neither can be shown by the waterfall of a server
+            if (!core::args["server"].b()) {
+                if (_this->running) { SmGui::BeginDisabled(); }
+                if (SmGui::Checkbox(CONCAT("Server FFT##_spyserver_fft_", _this->name), &_this->serverFFT)) {
+                    config.acquire();
+                    config.conf["devices"][_this->devRef]["serverFFT"] = _this->serverFFT;
+                    config.release(true);
+                }
+
+                // The band streamed is only narrowed when the waterfall doesn't need all of it
+                if (!_this->serverFFT) { SmGui::BeginDisabled(); }
+                if (SmGui::Checkbox(CONCAT("Auto decimation##_spyserver_auto_decim_", _this->name), &_this->autoDecimation)) {
+                    config.acquire();
+                    config.conf["devices"][_this->devRef]["autoDecimation"] = _this->autoDecimation;
+                    config.release(true);
+                }
+                if (!_this->serverFFT) { SmGui::EndDisabled(); }
+                if (_this->running) { SmGui::EndDisabled(); }
+            }
+
             SmGui::Text("Status:");
             SmGui::SameLine();
             ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Connected (%s)", deviceTypesStr[_this->client->devInfo.DeviceType]);
+            if (_this->running && _this->remoteRatio > 1) {
+                SmGui::Text(("Streaming " + _this->getBandwdithScaled(_this->sampleRate / _this->remoteRatio)).c_str());
+            }
         }
         else {
             SmGui::Text("Status:");
@@ -262,6 +287,14 @@ private:
                 srId = config.conf["devices"][devRef]["sampleRateId"];
                 iqType = config.conf["devices"][devRef]["sampleBitDepthId"];
                 gain = config.conf["devices"][devRef]["gainId"];
+                serverFFT = false;
+                if (config.conf["devices"][devRef].contains("serverFFT")) {
+                    serverFFT = config.conf["devices"][devRef]["serverFFT"];
+                }
+                autoDecimation = false;
+                if (config.conf["devices"][devRef].contains("autoDecimation")) {
+                    autoDecimation = config.conf["devices"][devRef]["autoDecimation"];
+                }
                 config.release(true);
 
                 gain = std::clamp<int>(gain, 0, client->devInfo.MaximumGainIndex);
@@ -288,6 +321,52 @@ private:
         }
     }
 
+    // IQ decimation of the server, the one of the samplerate picked further decimated to the band the VFOs need
+    int iqDecimationId() {
+        int id = srId + client->devInfo.MinimumIQDecimation;
+        for (int r = remoteRatio; r > 1; r >>= 1) { id++; }
+        return id;
+    }
+
+    void updateDigitalGain() {
+        int srvBits = streamFormatsBitCount[iqType];
+        client->setSetting(SPYSERVER_SETTING_IQ_DIGITAL_GAIN, client->computeDigitalGain(srvBits, gain, iqDecimationId()));
+    }
+
+    void updateIQ() {
+        client->setSetting(SPYSERVER_SETTING_IQ_DECIMATION, iqDecimationId());
+        client->setSetting(SPYSERVER_SETTING_IQ_FREQUENCY, freq + remoteShift);
+        updateDigitalGain();
+    }
+
+    // With the server FFT, the waterfall doesn't need the whole band anymore, so the server can also decimate the IQ
+    // down to the part of it the VFOs need, which is much less to stream to a remote client
+    void updateRemote() {
+        bool remote = running && serverFFT && !core::args["server"].b();
+        if (remote) {
+            client->setFFT(sigpath::iqFrontEnd.getFFTSize(), srId + client->devInfo.MinimumIQDecimation, freq);
+        }
+        client->setSetting(SPYSERVER_SETTING_STREAMING_MODE, remote ? SPYSERVER_STREAM_MODE_FFT_IQ : SPYSERVER_STREAM_MODE_IQ_ONLY);
+        sigpath::iqFrontEnd.setFFTEnabled(!remote);
+
+        if (remote && autoDecimation) {
+            int maxRatio = 1 << std::max<int>(client->devInfo.DecimationStageCount - (srId + client->devInfo.MinimumIQDecimation), 0);
+            sigpath::iqFrontEnd.setRemoteDecimation(remoteDecimationHandler, maxRatio, this);
+        }
+        else {
+            sigpath::iqFrontEnd.setRemoteDecimation(NULL, 1, NULL);
+        }
+    }
+
+    static void remoteDecimationHandler(int ratio, double shift, void* ctx) {
+        SpyServerSourceModule* _this = (SpyServerSourceModule*)ctx;
+        if (ratio == _this->remoteRatio && shift == _this->remoteShift) { return; }
+        _this->remoteRatio = ratio;
+        _this->remoteShift = shift;
+        if (_this->client && _this->client->isOpen()) { _this->updateIQ(); }
+        flog::info("SpyServerSourceModule '{0}': Streaming 1/{1} of the band, {2}Hz off center", _this->name, ratio, shift);
+    }
+
     std::string name;
     bool enabled = true;
     bool running = false;
@@ -304,6 +383,11 @@ private:
 
     uint32_t gain = 0;
 
+    bool serverFFT = false;
+    bool autoDecimation = false;
+    int remoteRatio = 1;
+    double remoteShift = 0.0;
+
     std::string devRef = "";
 
     dsp::stream<dsp::complex_t> stream;
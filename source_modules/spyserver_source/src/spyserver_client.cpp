@@ -1,7 +1,12 @@
 #include <spyserver_client.h>
 #include <volk/volk.h>
 #include <cstring>
+#include <algorithm>
 #include <chrono>
+#include <dsp/convert/u8_to_complex.h>
+#include <dsp/convert/s16_to_complex.h>
+#include <signal_path/signal_path.h>
+#include <gui/gui.h>
 
 using namespace std::chrono_literals;
 
@@ -68,6 +73,8 @@ namespace spyserver {
     }
 
     void SpyServerClientClass::sendCommand(uint32_t command, void* data, int len) {
+        // Settings can be changed from the thread moving the VFOs as well as from the GUI
+        std::lock_guard<std::mutex> lck(writeMtx);
         SpyServerCommandHeader* hdr = (SpyServerCommandHeader*)writeBuf;
         hdr->CommandType = command;
         hdr->BodySize = len;
@@ -95,6 +102,28 @@ namespace spyserver {
         sendCommand(SPYSERVER_CMD_SET_SETTING, &target, sizeof(SpyServerSettingTarget));
     }
 
+    void SpyServerClientClass::setFFT(int bins, int decimationId, uint32_t frequency) {
+        setSetting(SPYSERVER_SETTING_FFT_FORMAT, SPYSERVER_STREAM_FORMAT_UINT8);
+        setSetting(SPYSERVER_SETTING_FFT_DISPLAY_PIXELS, std::clamp<int>(bins, SPYSERVER_MIN_DISPLAY_PIXELS, SPYSERVER_MAX_DISPLAY_PIXELS));
+        setSetting(SPYSERVER_SETTING_FFT_DB_OFFSET, SPYSERVER_FFT_DB_OFFSET);
+        setSetting(SPYSERVER_SETTING_FFT_DB_RANGE, SPYSERVER_FFT_DB_RANGE);
+        setSetting(SPYSERVER_SETTING_FFT_DECIMATION, decimationId);
+        setSetting(SPYSERVER_SETTING_FFT_FREQUENCY, frequency);
+    }
+
+    void SpyServerClientClass::pushFFT(const uint8_t* levels, int count) {
+        // The waterfall only takes spectra of the size of the local FFT, the bins of the server are stretched to it
+        int size = sigpath::iqFrontEnd.getFFTSize();
+        if (count <= 0 || size <= 0) { return; }
+        fftLine.resize(size);
+        float min = (float)(SPYSERVER_FFT_DB_OFFSET - SPYSERVER_FFT_DB_RANGE);
+        float step = (float)SPYSERVER_FFT_DB_RANGE / 255.0f;
+        for (int i = 0; i < size; i++) {
+            fftLine[i] = min + ((float)levels[((int64_t)i * count) / size] * step);
+        }
+        gui::waterfall.pushFFT(fftLine.data(), size);
+    }
+
     int SpyServerClientClass::readSize(int count, uint8_t* buffer) {
         int read = 0;
         int len = 0;
@@ -136,17 +165,13 @@ namespace spyserver {
         else if (mtype == SPYSERVER_MSG_TYPE_UINT8_IQ) {
             int sampCount = _this->receivedHeader.BodySize / (sizeof(uint8_t) * 2);
             float gain = pow(10, (double)mflags / 20.0);
-            float scale = 1.0f / (gain * 128.0f);
-            for (int i = 0; i < sampCount; i++) {
-                _this->output->writeBuf[i].re = ((float)_this->readBuf[(2 * i)] - 128.0f) * scale;
-                _this->output->writeBuf[i].im = ((float)_this->readBuf[(2 * i) + 1] - 128.0f) * scale;
-            }
+            dsp::convert::U8ToComplex::process(sampCount, _this->readBuf, _this->output->writeBuf, 128.0f, gain * 128.0f);
             _this->output->swap(sampCount);
         }
         else if (mtype == SPYSERVER_MSG_TYPE_INT16_IQ) {
             int sampCount = _this->receivedHeader.BodySize / (sizeof(int16_t) * 2);
             float gain = pow(10, (double)mflags / 20.0);
-            volk_16i_s32f_convert_32f((float*)_this->output->writeBuf, (int16_t*)_this->readBuf, 32768.0 * gain, sampCount * 2);
+            dsp::convert::S16ToComplex::process(sampCount, (int16_t*)_this->readBuf, _this->output->writeBuf, 32768.0 * gain);
             _this->output->swap(sampCount);
         }
         else if (mtype == SPYSERVER_MSG_TYPE_INT24_IQ) {
@@ -159,6 +184,9 @@ namespace spyserver {
             volk_32f_s32f_multiply_32f((float*)_this->output->writeBuf, (float*)_this->readBuf, gain, sampCount * 2);
             _this->output->swap(sampCount);
         }
+        else if (mtype == SPYSERVER_MSG_TYPE_UINT8_FFT) {
+            _this->pushFFT(_this->readBuf, _this->receivedHeader.BodySize);
+        }
 
         _this->client->readAsync(sizeof(SpyServerMessageHeader), (uint8_t*)&_this->receivedHeader, dataHandler, _this);
     }
@@ -3,6 +3,12 @@
 #include <spyserver_protocol.h>
 #include <dsp/stream.h>
 #include <dsp/types.h>
+#include <vector>
+#include <mutex>
+
+// Levels of the spectrum streamed by the server, its bytes going from the offset minus the range to the offset, in dB
+#define SPYSERVER_FFT_DB_OFFSET 0
+#define SPYSERVER_FFT_DB_RANGE  SPYSERVER_MAX_FFT_DB_RANGE
 
 namespace spyserver {
     class SpyServerClientClass {
@@ -17,6 +23,10 @@ namespace spyserver {
 
         void setSetting(uint32_t setting, uint32_t arg);
 
+        // Have the server compute the spectrum shown by the waterfall with the given number of bins, over the band of
+        // the IQ decimation decimationId centered on frequency. It's sent along with the IQ in the FFT_IQ streaming mode
+        void setFFT(int bins, int decimationId, uint32_t frequency);
+
         void close();
         bool isOpen();
 
@@ -30,12 +40,15 @@ namespace spyserver {
 
         int readSize(int count, uint8_t* buffer);
 
+        void pushFFT(const uint8_t* levels, int count);
+
         static void dataHandler(int count, uint8_t* buf, void* ctx);
 
         net::Conn client;
 
         uint8_t* readBuf;
         uint8_t* writeBuf;
+        std::mutex writeMtx;
 
         bool deviceInfoAvailable = false;
         std::mutex deviceInfoMtx;
@@ -44,6 +57,7 @@ namespace spyserver {
         SpyServerMessageHeader receivedHeader;
 
         dsp::stream<dsp::complex_t>* output;
+        std::vector<float> fftLine;
     };
 
     typedef std::unique_ptr<SpyServerClientClass> SpyServerClient;
@@ -12,9 +12,17 @@
 #include <uhd/usrp/multi_usrp.hpp>
 #include <utils/optionlist.h>
 #include <utils/freq_formatting.h>
+#include <dsp/convert/s16_to_complex.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+// Highest number of channels streamed at once. The channels other than the selected one each feed the signal path
+// named after them if it was created
+#define USRP_MAX_CHANNELS   4
+
+// Delay before a multi-channel stream starts, so that all channels start on the same sample
+#define USRP_MULTI_START_DELAY  0.1
+
 SDRPP_MOD_INFO{
     /* Name:            */ "usrp_source",
     /* Description:     */ "USRP source module for SDR++",
@@ -26,6 +34,8 @@ SDRPP_MOD_INFO{
 ConfigManager config;
 
 class USRPSourceModule : public ModuleManager::Instance {
+    struct ExtraChannel;
+
 public:
     USRPSourceModule(std::string name) {
         this->name = name;
@@ -40,13 +50,39 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.stats = &stats;
 
         sigpath::sourceManager.registerSource("USRP", &handler);
+
+        // The other channels feed the signal path of their name if it was created, they aren't streamed otherwise
+        for (int i = 0; i < USRP_MAX_CHANNELS; i++) {
+            ExtraChannel& ch = extras[i];
+            ch.module = this;
+            ch.index = i;
+            ch.name = "USRP CH" + std::to_string(i);
+            ch.path = sigpath::getPath(ch.name);
+            if (!ch.path) { continue; }
+
+            ch.handler.ctx = &ch;
+            ch.handler.selectHandler = extraSelected;
+            ch.handler.deselectHandler = extraDeselected;
+            ch.handler.menuHandler = extraMenuHandler;
+            ch.handler.startHandler = extraStart;
+            ch.handler.stopHandler = extraStop;
+            ch.handler.tuneHandler = extraTune;
+            ch.handler.stream = &ch.stream;
+            ch.handler.stats = &ch.stats;
+            ch.path->sourceManager.registerSource(ch.name, &ch.handler);
+            ch.path->sourceManager.selectSource(ch.name);
+        }
     }
 
     ~USRPSourceModule() {
         stop(this);
         sigpath::sourceManager.unregisterSource("USRP");
+        for (auto& ch : extras) {
+            if (ch.path) { ch.path->sourceManager.unregisterSource(ch.name); }
+        }
     }
 
     void postInit() {}
@@ -208,10 +244,38 @@ public:
                 gain = std::clamp<float>(gain, gainRange.start(), gainRange.stop());
             }
         }
+
+        // Load the frequencies of the other channels
+        for (auto& ch : extras) { ch.freq = 100e6; }
+        if (config.conf["devices"][selectedSer].contains("extraFrequencies")) {
+            auto& freqs = config.conf["devices"][selectedSer]["extraFrequencies"];
+            for (int i = 0; i < USRP_MAX_CHANNELS && i < (int)freqs.size(); i++) { extras[i].freq = freqs[i]; }
+        }
         config.release();
 
         // Apply samplerate
         sampleRate = samplerates.key(srId);
+        updateExtraSamplerates();
+    }
+
+    // The channels share the samplerate, antenna and gain settings of the selected one
+    void updateExtraSamplerates() {
+        for (auto& ch : extras) {
+            if (ch.path) { ch.path->iqFrontEnd.setSampleRate(sampleRate); }
+        }
+    }
+
+    void saveExtraFrequencies() {
+        if (selectedSer.empty()) { return; }
+        config.acquire();
+        json freqs = json::array();
+        for (auto& ch : extras) { freqs.push_back(ch.freq); }
+        config.conf["devices"][selectedSer]["extraFrequencies"] = freqs;
+        config.release(true);
+    }
+
+    bool isExtraStreamed(const ExtraChannel& ch) {
+        return ch.path && ch.index != chanId && ch.index < channels.size();
     }
 
     void setBandwidth(double bw) {
@@ -271,16 +335,41 @@ private:
         _this->dev->set_rx_freq(_this->freq, _this->chanId);
         _this->dev->set_clock_source(_this->clockSources.key(_this->csId));
         _this->setBandwidth(_this->bandwidths[_this->bwId]);
+
+        // Setup the other channels streamed along with the selected one
+        _this->activeExtras.clear();
+        for (auto& ch : _this->extras) {
+            if (!_this->isExtraStreamed(ch)) { continue; }
+            try {
+                _this->dev->set_rx_rate(_this->sampleRate, ch.index);
+                _this->dev->set_rx_antenna(_this->antennas.key(_this->antId), ch.index);
+                _this->dev->set_rx_gain(_this->gain, ch.index);
+                _this->dev->set_rx_freq(ch.freq, ch.index);
+            }
+            catch (const std::exception& e) {
+                flog::error("USRPSourceModule '{0}': Could not setup channel {1}: {2}", _this->name, ch.index, e.what());
+                continue;
+            }
+            _this->activeExtras.push_back(&ch);
+        }
         
+        // All channels come from a single streamer to be received together and stay coherent
         uhd::stream_args_t sargs;
         sargs.channels.clear();
         sargs.channels.push_back(_this->chanId);
-        sargs.cpu_format = "fc32";
+        for (auto ch : _this->activeExtras) { sargs.channels.push_back(ch->index); }
+        sargs.cpu_format = "sc16";
         sargs.otw_format = "sc16";
         _this->streamer = _this->dev->get_rx_stream(sargs);
-        _this->streamer->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+        uhd::stream_cmd_t cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+        if (!_this->activeExtras.empty()) {
+            cmd.stream_now = false;
+            cmd.time_spec = _this->dev->get_time_now() + uhd::time_spec_t(USRP_MULTI_START_DELAY);
+        }
+        _this->streamer->issue_stream_cmd(cmd);
         
         _this->stream.clearWriteStop();
+        for (auto ch : _this->activeExtras) { ch->stream.clearWriteStop(); }
         _this->workerThread = std::thread(&USRPSourceModule::worker, _this);
 
         _this->running = true;
@@ -293,9 +382,12 @@ private:
         _this->running = false;
         
         _this->stream.stopWriter();
+        for (auto ch : _this->activeExtras) { ch->stream.stopWriter(); }
         _this->streamer->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
         if (_this->workerThread.joinable()) { _this->workerThread.join(); }
         _this->stream.clearWriteStop();
+        for (auto ch : _this->activeExtras) { ch->stream.clearWriteStop(); }
+        _this->activeExtras.clear();
         
         _this->streamer.reset();
         _this->dev.reset();
@@ -332,6 +424,7 @@ private:
         if (SmGui::Combo(CONCAT("##_usrp_sr_sel_", _this->name), &_this->srId, _this->samplerates.txt)) {
             _this->sampleRate = _this->samplerates.key(_this->srId);
             core::setInputSampleRate(_this->sampleRate);
+            _this->updateExtraSamplerates();
             if (!_this->selectedSer.empty()) {
                 config.acquire();
                 config.conf["devices"][_this->selectedSer]["channels"][_this->selectedChan]["samplerate"] = _this->samplerates.key(_this->srId);
@@ -364,12 +457,24 @@ private:
 
         if (_this->running) { SmGui::EndDisabled(); }
 
+        // Frequencies of the other channels, tuned through their signal path
+        for (auto& ch : _this->extras) {
+            if (!_this->isExtraStreamed(ch)) { continue; }
+            int kHz = round(ch.freq / 1000.0);
+            SmGui::LeftLabel(CONCAT(ch.name, " (kHz)"));
+            SmGui::FillWidth();
+            if (SmGui::InputInt(CONCAT("##_usrp_extra_freq_", _this->name + std::to_string(ch.index)), &kHz, 100, 1000)) {
+                ch.path->sourceManager.tune((double)std::max<int>(kHz, 0) * 1000.0);
+            }
+        }
+
         if (_this->antennas.size() > 1) {
             SmGui::LeftLabel("Antenna");
             SmGui::FillWidth();
             if (SmGui::Combo(CONCAT("##_usrp_ant_sel_", _this->name), &_this->antId, _this->antennas.txt)) {
                 if (_this->running) {
                     _this->dev->set_rx_antenna(_this->antennas.key(_this->antId), _this->chanId);
+                    for (auto ch : _this->activeExtras) { _this->dev->set_rx_antenna(_this->antennas.key(_this->antId), ch->index); }
                 }
                 if (!_this->selectedSer.empty() && !_this->selectedChan.empty()) {
                     config.acquire();
@@ -414,6 +519,7 @@ private:
         if (SmGui::SliderFloatWithSteps(CONCAT("##_usrp_gain_", _this->name), &_this->gain, _this->gainRange.start(), _this->gainRange.stop(), _this->gainRange.step(), SmGui::FMT_STR_FLOAT_DB_ONE_DECIMAL)) {
             if (_this->running) {
                 _this->dev->set_rx_gain(_this->gain, _this->chanId);
+                for (auto ch : _this->activeExtras) { _this->dev->set_rx_gain(_this->gain, ch->index); }
             }
             if (!_this->selectedSer.empty() && !_this->selectedChan.empty()) {
                 config.acquire();
@@ -434,20 +540,46 @@ private:
 
     void worker() {
         // TODO: Select a better buffer size that will avoid bad timing
-        int bufferSize = sampleRate / 200;
+        int bufferSize = std::min<int>(sampleRate / 200, STREAM_BUFFER_SIZE);
+
+        // Output of each channel, the selected one first as in the stream args
+        std::vector<dsp::stream<dsp::complex_t>*> outs = { &stream };
+        std::vector<SourceStats*> outStats = { &stats };
+        for (auto ch : activeExtras) {
+            outs.push_back(&ch->stream);
+            outStats.push_back(&ch->stats);
+        }
+        std::vector<void*> raws(outs.size());
+
         try {
             while (true) {
+                // UHD hands the samples as sc16 in the upper half of the stream buffers, they are then expanded in place.
+                // Converting forward, each complex float only overwrites sc16 samples that were already converted.
+                // A single call fills the buffers of all channels with the same samples in time
                 uhd::rx_metadata_t meta;
-                void* ptr[] = { stream.writeBuf };
-                uhd::rx_streamer::buffs_type buffers(ptr, 1);
-                int len = streamer->recv(stream.writeBuf, bufferSize, meta, 1.0);
+                for (int i = 0; i < outs.size(); i++) { raws[i] = (int16_t*)outs[i]->writeBuf + (2 * bufferSize); }
+                int len = streamer->recv(raws, bufferSize, meta, 1.0);
                 if (len < 0) { break; }
-                if (len != bufferSize) {
-                    printf("%d\n", len);
+
+                // An overflow in sequence means the host dropped samples, out of sequence means the transport lost packets
+                if (meta.error_code == uhd::rx_metadata_t::ERROR_CODE_OVERFLOW) {
+                    for (auto st : outStats) {
+                        if (meta.out_of_sequence) {
+                            st->discontinuity();
+                        }
+                        else {
+                            st->overflow();
+                        }
+                    }
                 }
-                if (len) {
-                    if (!stream.swap(len)) { break; }
+                if (!len) { continue; }
+                bool ok = true;
+                for (int i = 0; i < outs.size(); i++) {
+                    dsp::convert::S16ToComplex::process(len, (int16_t*)raws[i], outs[i]->writeBuf);
+                    outStats[i]->delivered(len);
+                    ok &= outs[i]->swap(len);
                 }
+                if (!ok) { break; }
             }
         }
         catch (const std::exception& e) {
@@ -455,11 +587,41 @@ private:
         }
     }
 
+    // Channels beyond the selected one
+    struct ExtraChannel {
+        USRPSourceModule* module;
+        int index;
+        std::string name;
+        SignalPath* path = NULL;
+        dsp::stream<dsp::complex_t> stream;
+        SourceManager::SourceHandler handler;
+        SourceStats stats;
+        double freq = 100e6;
+    };
+
+    // The device is started and stopped with the selected channel, the others only follow it
+    static void extraSelected(void* ctx) {}
+    static void extraDeselected(void* ctx) {}
+    static void extraMenuHandler(void* ctx) {}
+    static void extraStart(void* ctx) {}
+    static void extraStop(void* ctx) {}
+
+    static void extraTune(double freq, void* ctx) {
+        ExtraChannel* ch = (ExtraChannel*)ctx;
+        USRPSourceModule* _this = ch->module;
+        ch->freq = freq;
+        if (_this->running && std::find(_this->activeExtras.begin(), _this->activeExtras.end(), ch) != _this->activeExtras.end()) {
+            _this->dev->set_rx_freq(freq, ch->index);
+        }
+        _this->saveExtraFrequencies();
+    }
+
     std::string name;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
     double sampleRate;
     SourceManager::SourceHandler handler;
+    SourceStats stats;
     bool running = false;
     double freq;
     int devId = 0;
@@ -487,6 +649,8 @@ private:
 
     std::thread workerThread;
 
+    ExtraChannel extras[USRP_MAX_CHANNELS];
+    std::vector<ExtraChannel*> activeExtras;
 };
 
 MOD_EXPORT void _INIT_() {